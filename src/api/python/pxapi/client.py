@@ -30,6 +30,7 @@ from src.api.proto.cloudpb import cloudapi_pb2_grpc
 
 from .data import (
     _TableStream,
+    ColumnBatchGenerator,
     RowGenerator,
     Row,
     ClusterID,
@@ -74,23 +75,39 @@ class TableSub:
         self.table_name = name
         self._table_gen = table_gen
 
-    async def __aiter__(self) -> RowGenerator:
-        table_stream = None
+    async def _table_stream(self) -> Union[_TableStream, None]:
         async for t in self._table_gen:
             if t == QUERY_ERROR:
-                return
+                return None
             table = cast(_TableStream, t)
             if table.name == self.table_name:
-                table_stream = table
-                break
+                return table
+
+        raise ValueError(
+            "Table '{}' not received".format(self.table_name))
 
+    async def __aiter__(self) -> RowGenerator:
+        table_stream = await self._table_stream()
         if table_stream is None:
-            raise ValueError(
-                "Table '{}' not received".format(self.table_name))
+            return
 
         async for row in table_stream:
             yield row
 
+    async def column_batches(self) -> ColumnBatchGenerator:
+        """
+        Yields each row batch of the table as a mapping of column name to values.
+
+        Use it with `ScriptExecutor(arrow_results=True)` to build dataframes without
+        converting each value, for example with `pandas.DataFrame(batch)`.
+        """
+        table_stream = await self._table_stream()
+        if table_stream is None:
+            return
+
+        async for batch in table_stream.column_batches():
+            yield batch
+
 
 TableType = Union[TableOrError, None]
 TableSubGenerator = AsyncGenerator[TableSub, None]
@@ -125,9 +142,9 @@ class Conn:
         # Whether the connection is direct connection or not.
         self._direct = direct
 
-    def prepare_script(self, script_str: str) -> 'ScriptExecutor':
+    def prepare_script(self, script_str: str, arrow_results: bool = False) -> 'ScriptExecutor':
         """ Create a new ScriptExecutor for the script to run on this connection. """
-        return ScriptExecutor(self, script_str)
+        return ScriptExecutor(self, script_str, arrow_results)
 
     def _get_grpc_channel(self) -> grpc.aio.Channel:
         """
@@ -167,11 +184,16 @@ class ScriptExecutor:
     you must create a new `ScriptExecutor` object and setup any data processing
     again. We rely on iterators that must close when a script stops running
     and cannot allow multiple runs per object.
+
+    With `arrow_results`, the numeric and string columns of the results are received as raw
+    arrow buffers, which is much faster for large results, especially with
+    `TableSub.column_batches()`.
     """
 
-    def __init__(self, conn: Conn, pxl: str):
+    def __init__(self, conn: Conn, pxl: str, arrow_results: bool = False):
         self._conn = conn
         self._pxl = pxl
+        self._arrow_results = arrow_results
 
         # A mapping of the table ID to a table. We use this to map incoming data which only
         # has the table ID to the proper table.
@@ -435,6 +457,7 @@ class ScriptExecutor:
         req = vpb.ExecuteScriptRequest()
         req.cluster_id = conn.cluster_id
         req.query_str = self._pxl
+        req.arrow_results = self._arrow_results
 
         async for res in stub.ExecuteScript(req, metadata=[
             ("pixie-api-key", conn.token),
@@ -15,11 +15,12 @@
 # SPDX-License-Identifier: Apache-2.0
 
 import asyncio
+import functools
 import json
 import uuid
 
 from collections import OrderedDict
-from typing import Callable, Any, List, AsyncGenerator, Union
+from typing import Callable, Any, Dict, List, AsyncGenerator, Sequence, Union
 
 from src.api.proto.vizierpb import vizierapi_pb2 as vpb
 
@@ -106,6 +107,23 @@ def _encode_uint128_as_UUID(uint128: vpb.UInt128) -> uuid.UUID:
     return uuid.UUID(bytes=int_to_bytes(uint128.high) + int_to_bytes(uint128.low))
 
 
+def _arrow_column_values(col: vpb.ArrowColumn) -> Sequence[Any]:
+    """
+    Returns the values of an ArrowColumn. Numeric columns are views over the received buffer,
+    which `numpy.frombuffer()` or `pandas.DataFrame()` take without copying.
+    """
+    if col.data_type in (vpb.INT64, vpb.TIME64NS):
+        return memoryview(col.values).cast('q')
+    if col.data_type == vpb.FLOAT64:
+        return memoryview(col.values).cast('d')
+    if col.data_type == vpb.STRING:
+        offsets = memoryview(col.offsets).cast('i')
+        values = col.values
+        return [values[offsets[i]:offsets[i + 1]].decode('utf-8')
+                for i in range(len(offsets) - 1)]
+    raise ValueError("{} type not supported in arrow columns".format(col.data_type))
+
+
 class _UInt128Encoder(json.JSONEncoder):
     def default(self, o: Any) -> str:
         if isinstance(o, vpb.UInt128):
@@ -168,6 +186,7 @@ class Row:
 
 
 RowGenerator = AsyncGenerator[Row, None]
+ColumnBatchGenerator = AsyncGenerator[Dict[str, Sequence[Any]], None]
 
 
 class _Rowbatch:
@@ -210,12 +229,37 @@ class _TableStream:
             if rb.batch.eos:
                 break
 
+    def _column_getters(self, batch: vpb.RowBatchData) -> List[Callable[[int], Any]]:
+        getters: List[Callable[[int], Any]] = []
+        for ci, col in enumerate(batch.cols):
+            if col.HasField("arrow_data"):
+                getters.append(_arrow_column_values(col.arrow_data).__getitem__)
+            else:
+                getters.append(functools.partial(self.relation.get_col_formatter(ci), col))
+        return getters
+
+    async def column_batches(self) -> ColumnBatchGenerator:
+        """
+        Yields the row batches of the table as a mapping of column name to the column's values.
+
+        Only the columns received as ArrowColumns (see `ScriptExecutor(arrow_results=True)`)
+        avoid converting each value.
+        """
+        async for rb in self._row_batches():
+            batch = rb.batch
+            columns: Dict[str, Sequence[Any]] = OrderedDict()
+            for ci, col in enumerate(batch.cols):
+                name = self.relation.get_col_name(ci)
+                if col.HasField("arrow_data"):
+                    columns[name] = _arrow_column_values(col.arrow_data)
+                else:
+                    format_fn = self.relation.get_col_formatter(ci)
+                    columns[name] = [format_fn(col, i) for i in range(batch.num_rows)]
+            yield columns
+
     async def __aiter__(self) -> RowGenerator:
         async for rb in self._row_batches():
             batch = rb.batch
+            getters = self._column_getters(batch)
             for i in range(batch.num_rows):
-                row = []
-                for ci, col in enumerate(batch.cols):
-                    format_fn = self.relation.get_col_formatter(ci)
-                    row.append(format_fn(col, i))
-                yield Row(self, row)
+                yield Row(self, [get(i) for get in getters])
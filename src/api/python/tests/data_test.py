@@ -16,6 +16,7 @@
 
 import asyncio
 import json
+import struct
 import unittest
 from typing import List, Any
 
@@ -97,6 +98,43 @@ class TestData(unittest.TestCase):
         loop = asyncio.get_event_loop()
         loop.run_until_complete(process_rows())
 
+    def test_table_stream_arrow_columns(self) -> None:
+        table = data._TableStream("foo",
+                                  data._Relation(
+                                      self.relation,
+                                  ),
+                                  subscribed=True)
+
+        # The columns of the batch as the query broker sends them with arrow_results.
+        batch = vpb.RowBatchData(table_id=utils.table_id1, num_rows=3, eos=True, eow=True)
+        batch.cols.add().arrow_data.CopyFrom(vpb.ArrowColumn(
+            data_type=vpb.STRING,
+            values=b"foobarbaz",
+            offsets=struct.pack("<4i", 0, 3, 6, 9),
+        ))
+        batch.cols.add().arrow_data.CopyFrom(vpb.ArrowColumn(
+            data_type=vpb.INT64,
+            values=struct.pack("<3q", 200, 500, 301),
+        ))
+        table.add_row_batch(batch)
+
+        async def process_batches() -> None:
+            batches = [b async for b in table.column_batches()]
+            self.assertEqual(len(batches), 1)
+            self.assertEqual(list(batches[0]["http_resp_body"]), ["foo", "bar", "baz"])
+            self.assertEqual(list(batches[0]["http_resp_status"]), [200, 500, 301])
+
+        loop = asyncio.get_event_loop()
+        loop.run_until_complete(process_batches())
+
+        table.add_row_batch(batch)
+
+        async def process_rows() -> None:
+            rows = [(row["http_resp_body"], row["http_resp_status"]) async for row in table]
+            self.assertEqual(rows, [("foo", 200), ("bar", 500), ("baz", 301)])
+
+        loop.run_until_complete(process_rows())
+
     def test_unsubbed_table_stream(self) -> None:
         # Create the table stream, but it should be unsubscribed.
         table = data._TableStream("foo",
@@ -36,6 +36,8 @@
 #include "src/shared/types/column_wrapper.h"
 #include "src/table_store/test_utils.h"
 
+DECLARE_bool(carnot_agg_fixed_size_keys);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -122,6 +124,17 @@ void BM_Query_Int(benchmark::State& state, std::vector<types::DataType> types,
   BM_Query(state, types, distribution_types, query, num_batches, default_params, default_params);
 }
 
+// Same as BM_Query_Int, but the aggregates key their groups by RowTuples, which is what they did
+// before fixed size group keys were stored inline. Used as the baseline for the int group bys.
+// NOLINTNEXTLINE : runtime/references.
+void BM_Query_Int_RowTupleKeys(benchmark::State& state, std::vector<types::DataType> types,
+                               std::vector<datagen::DistributionType> distribution_types,
+                               const std::string& query, int64_t num_batches) {
+  FLAGS_carnot_agg_fixed_size_keys = false;
+  BM_Query_Int(state, types, distribution_types, query, num_batches);
+  FLAGS_carnot_agg_fixed_size_keys = true;
+}
+
 const std::unique_ptr<const datagen::DistributionParams> sample_selection_params =
     std::make_unique<const datagen::ZipfianParams>(2, 2, 999);
 const std::unique_ptr<const datagen::DistributionParams> sample_length_params =
@@ -190,6 +203,29 @@ BENCHMARK_CAPTURE(BM_Query_Int, eval_group_by_one_exponential_int,
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
 
+// Group By Int Tests, RowTuple keyed baseline.
+BENCHMARK_CAPTURE(BM_Query_Int_RowTupleKeys, eval_group_by_one_uniform_int,
+                  {types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kUniform},
+                  kGroupByOneQuery, 20)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_Query_Int_RowTupleKeys, eval_group_by_two_uniform_ints,
+                  {types::DataType::INT64, types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kUniform,
+                   datagen::DistributionType::kUniform},
+                  kGroupByTwoQuery, 20)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_Query_Int_RowTupleKeys, eval_group_by_one_exponential_int,
+                  {types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kExponential, datagen::DistributionType::kUniform},
+                  kGroupByOneQuery, 20)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
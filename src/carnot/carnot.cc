@@ -16,27 +16,65 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
 
 #include "src/carnot/carnot.h"
 #include "src/carnot/engine_state.h"
 #include "src/carnot/exec/exec_graph.h"
+#include "src/carnot/exec/query_admission_controller.h"
+#include "src/carnot/exec/result_cache.h"
 #include "src/carnot/funcs/builtins/builtins.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/plan.h"
+#include "src/carnot/plan/plan_cache.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
+#include "src/carnot/trace/query_trace.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/perf/perf.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int64(carnot_query_memory_budget_bytes, 0,
+             "The memory each query may use for buffered operator state before operators that "
+             "support it (ie. joins) spill to disk. Set to '0' to remove this limit.");
+DEFINE_string(carnot_spill_dir, "",
+              "The directory for operator spill files. Defaults to the system temp directory.");
+DEFINE_int64(carnot_admission_memory_budget_bytes, 0,
+             "The memory all running queries together may allocate. Queries wait for admission "
+             "while it is exceeded, and the largest query is cancelled if others are waiting. "
+             "Set to '0' to remove this limit.");
+DEFINE_int64(carnot_max_concurrent_queries, 0,
+             "The number of queries that may execute at the same time. Set to '0' to remove this "
+             "limit.");
+DEFINE_int64(carnot_admission_timeout_ms, 60 * 1000,
+             "How long a query waits for admission before it fails. Set to '0' to wait forever.");
+DEFINE_int64(carnot_plan_cache_size, 32,
+             "The number of plans kept after their queries finish, so that queries that run the "
+             "same plan with other time bounds don't build it again. Set to '0' to disable.");
+DEFINE_int64(carnot_result_cache_bucket_ms, 0,
+             "The width of the time buckets of the result cache. Fragments that run again over "
+             "the same local tables with time bounds in the same buckets replay the results of the "
+             "first run, which may be up to one bucket old. Set to '0' to disable the cache.");
+DEFINE_int64(carnot_result_cache_bytes, 64 * 1024 * 1024,
+             "The bytes of row batches that the result cache keeps.");
+
 namespace px {
 namespace carnot {
 
 using types::DataType;
 
+// How long a fragment waits for a concurrent run of the same fragment to fill the result cache.
+constexpr std::chrono::milliseconds kResultCacheMaxWait{30 * 1000};
+
 class CarnotImpl final : public Carnot {
  public:
   ~CarnotImpl() override;
@@ -74,6 +112,8 @@ class CarnotImpl final : public Carnot {
 
   Status RegisterUDFsInPlanFragment(exec::ExecState* exec_state, plan::PlanFragment* pf);
   Status WalkExpression(exec::ExecState* exec_state, const plan::ScalarExpression& expr);
+  Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze,
+                     trace::QueryTrace* query_trace);
   /**
    * Returns the Table Store.
    */
@@ -98,6 +138,10 @@ class CarnotImpl final : public Carnot {
   std::unique_ptr<std::thread> grpc_server_thread_;
   std::unique_ptr<grpc::Server> grpc_server_;
   std::unique_ptr<exec::GRPCRouter> grpc_router_;
+  std::unique_ptr<exec::QueryAdmissionController> admission_controller_;
+  std::unique_ptr<plan::PlanCache> plan_cache_;
+  // Null if the result cache is disabled.
+  std::unique_ptr<exec::ResultCache> result_cache_;
   int grpc_server_port_;
 
   // The id of the agent that owns this Carnot instance.
@@ -114,6 +158,15 @@ Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registr
   grpc_server_creds_ = grpc_server_creds;
   grpc_server_port_ = grpc_server_port;
   grpc_router_ = std::make_unique<exec::GRPCRouter>();
+  admission_controller_ = std::make_unique<exec::QueryAdmissionController>(
+      FLAGS_carnot_admission_memory_budget_bytes, FLAGS_carnot_max_concurrent_queries);
+  plan_cache_ = std::make_unique<plan::PlanCache>(
+      static_cast<size_t>(std::max<int64_t>(0, FLAGS_carnot_plan_cache_size)));
+  if (FLAGS_carnot_result_cache_bucket_ms > 0) {
+    result_cache_ = std::make_unique<exec::ResultCache>(
+        std::chrono::milliseconds(FLAGS_carnot_result_cache_bucket_ms),
+        FLAGS_carnot_result_cache_bytes, kResultCacheMaxWait);
+  }
   if (grpc_server_port_ > 0) {
     grpc_server_thread_ = std::make_unique<std::thread>(&CarnotImpl::GRPCServerFunc, this);
   }
@@ -126,6 +179,8 @@ Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registr
 
 Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& query_id,
                                 types::Time64NSValue time_now, bool analyze) {
+  trace::QueryTrace query_trace(query_id, agent_id_.str(), trace::QueryTraceStore::Default());
+  auto compile_span = query_trace.StartSpan("compile");
   // Compile the query.
   auto compiler_state = engine_state_->CreateLocalExecutionCompilerState(time_now);
   PL_ASSIGN_OR_RETURN(auto logical_plan, compiler_.CompileToIR(query, compiler_state.get()));
@@ -135,7 +190,8 @@ Status CarnotImpl::ExecuteQuery(const std::string& query, const sole::uuid& quer
   planner::distributed::AnnotateAbortableSourcesForLimitsRule rule;
   PL_RETURN_IF_ERROR(rule.Execute(logical_plan.get()));
   PL_ASSIGN_OR_RETURN(auto plan_proto, logical_plan->ToProto());
-  return ExecutePlan(plan_proto, query_id, analyze);
+  compile_span.End();
+  return ExecutePlan(plan_proto, query_id, analyze, &query_trace);
 }
 
 /**
@@ -272,14 +328,32 @@ Status SendFinalExecutionStatsToOutgoingConns(
 
 Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
                                bool analyze) {
+  trace::QueryTrace query_trace(query_id, agent_id_.str(), trace::QueryTraceStore::Default());
+  return ExecutePlan(logical_plan, query_id, analyze, &query_trace);
+}
+
+Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
+                               bool analyze, trace::QueryTrace* query_trace) {
+  auto plan_span = query_trace->StartSpan("execute_plan");
   auto timer = ElapsedTimer();
-  plan::Plan plan;
+  PL_ASSIGN_OR_RETURN(auto cached_plan, plan_cache_->Acquire(logical_plan));
+  // Nothing that executes the plan modifies it, so it can be reused even if the query fails.
+  DEFER(plan_cache_->Release(std::move(cached_plan)));
+  plan::Plan& plan = *cached_plan.plan;
 
-  PL_RETURN_IF_ERROR(plan.Init(logical_plan));
+  // The ticket has to outlive the exec state, which allocates from the ticket's pool.
+  PL_ASSIGN_OR_RETURN(auto admission_ticket,
+                      admission_controller_->Admit(
+                          query_id, logical_plan.plan_options().priority(),
+                          std::chrono::milliseconds(FLAGS_carnot_admission_timeout_ms)));
 
   // For each of the plan fragments in the plan, execute the query.
   std::vector<std::string> output_table_strs;
   auto exec_state = engine_state_->CreateExecState(query_id);
+  exec_state->set_admission_ticket(admission_ticket.get());
+  exec_state->set_memory_budget_bytes(FLAGS_carnot_query_memory_budget_bytes);
+  exec_state->set_spill_dir(FLAGS_carnot_spill_dir);
+  exec_state->set_query_trace(query_trace);
 
   // TODO(michellenguyen/zasgar, PP-2579): We should periodically update the metadata state for
   // long-running queries after a certain time duration or number of row batches processed. For now,
@@ -292,24 +366,69 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   PL_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
 
   auto plan_state = engine_state_->CreatePlanState();
+  // More workers than cores would only add contention.
+  int32_t max_parallelism =
+      std::min(logical_plan.plan_options().max_parallelism(),
+               static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency())));
   int64_t bytes_processed = 0;
   int64_t rows_processed = 0;
   queryresultspb::AgentExecutionStats agent_operator_exec_stats;
   ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
+  absl::flat_hash_map<int64_t, const planpb::PlanFragment*> fragment_pbs;
+  for (const auto& fragment_pb : logical_plan.nodes()) {
+    fragment_pbs[fragment_pb.id()] = &fragment_pb;
+  }
   timer.Start();
   auto s =
       plan::PlanWalker()
           .OnPlanFragment([&](auto* pf) {
+            auto fragment_span = query_trace->StartSpan("fragment", plan_span.id());
+            fragment_span.SetAttribute("fragment_id", pf->id());
+            exec_state->set_parent_span_id(fragment_span.id());
             auto exec_graph = exec::ExecutionGraph();
-            PL_RETURN_IF_ERROR(exec_graph.Init(engine_state_->schema(), plan_state.get(),
-                                               exec_state.get(), pf,
-                                               /* collect_exec_node_stats */ analyze));
-            PL_RETURN_IF_ERROR(exec_graph.Execute());
+            PL_RETURN_IF_ERROR(exec_graph.Init(
+                engine_state_->schema(), plan_state.get(), exec_state.get(), pf,
+                /* collect_exec_node_stats */ analyze,
+                exec::kDefaultConsecutiveGenerateCallsPerSource, max_parallelism));
+            // Analyzed queries always execute, since their stats are the point.
+            std::optional<exec::ResultCache::Lookup> lookup;
+            auto fragment_pb = fragment_pbs.find(pf->id());
+            if (result_cache_ != nullptr && !analyze && fragment_pb != fragment_pbs.end()) {
+              auto key = result_cache_->KeyOf(*fragment_pb->second);
+              if (key.has_value()) {
+                lookup.emplace(result_cache_->Acquire(
+                    *key, exec::ResultCache::SourceVersionsOf(*fragment_pb->second,
+                                                               table_store())));
+              }
+            }
+            if (lookup.has_value() && lookup->entry() != nullptr) {
+              fragment_span.SetAttribute("result_cache_hit", "true");
+              PL_RETURN_IF_ERROR(exec_graph.Replay(lookup->entry()->results));
+            } else {
+              if (lookup.has_value()) {
+                exec_graph.RecordSinkResults(result_cache_->max_entry_bytes());
+              }
+              PL_RETURN_IF_ERROR(exec_graph.Execute());
+              if (lookup.has_value() && !exec_state->cancelled()) {
+                auto results = exec_graph.TakeSinkResults();
+                if (results.has_value()) {
+                  lookup->Complete(std::move(*results), exec_graph.recorded_bytes());
+                }
+              }
+            }
+            if (exec_state->cancelled()) {
+              return error::ResourceUnavailable(
+                  "Query $0 was cancelled because Carnot exceeded its memory budget of $1 bytes.",
+                  query_id.str(), FLAGS_carnot_admission_memory_budget_bytes);
+            }
             std::vector<std::string> frag_sinks = exec_graph.OutputTables();
             output_table_strs.insert(output_table_strs.end(), frag_sinks.begin(), frag_sinks.end());
             auto exec_stats = exec_graph.GetStats();
             bytes_processed += exec_stats.bytes_processed;
             rows_processed += exec_stats.rows_processed;
+            fragment_span.SetAttribute("bytes_processed", exec_stats.bytes_processed);
+            fragment_span.SetAttribute("rows_processed", exec_stats.rows_processed);
+            fragment_span.set_peak_memory_bytes(exec_state->peak_memory_bytes());
 
             if (analyze) {
               for (int64_t node_id : pf->dag().TopologicalSort()) {
@@ -333,6 +452,12 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                 stats_pb->set_records_output(stats->rows_output);
                 stats_pb->set_total_execution_time_ns(total_time_ns);
                 stats_pb->set_self_execution_time_ns(self_time_ns);
+                stats_pb->set_operator_name(exec_node->DebugString());
+                for (int64_t parent_id : pf->dag().ParentsOf(node_id)) {
+                  stats_pb->add_parent_node_ids(parent_id);
+                }
+                stats_pb->set_bytes_input(stats->bytes_input);
+                stats_pb->set_records_input(stats->rows_input);
 
                 for (const auto& [k, v] : stats->extra_metrics) {
                   (*stats_pb->mutable_extra_metrics())[k] = v;
@@ -357,6 +482,7 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
 
   std::vector<queryresultspb::AgentExecutionStats> input_agent_stats;
   if (HasGRPCServer() && !incoming_agents.empty()) {
+    auto stats_span = query_trace->StartSpan("wait_for_agent_stats", plan_span.id());
     PL_ASSIGN_OR_RETURN(input_agent_stats,
                         grpc_router_->GetIncomingWorkerExecStats(query_id, incoming_agents));
   }
@@ -381,6 +507,10 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // analyze=true will send per operator stats.
   all_agent_stats.push_back(agent_operator_exec_stats);
 
+  plan_span.SetAttribute("bytes_processed", bytes_processed);
+  plan_span.SetAttribute("rows_processed", rows_processed);
+  plan_span.set_peak_memory_bytes(exec_state->peak_memory_bytes());
+
   return SendFinalExecutionStatsToOutgoingConns(query_id, exec_state->OutgoingServers(),
                                                 engine_state_->add_auth_to_grpc_context_func(),
                                                 agent_operator_exec_stats, all_agent_stats);
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/exec/local_grpc_result_server.h"
+#include "src/common/base/base.h"
+#include "src/common/datagen/datagen.h"
+#include "src/common/testing/test_environment.h"
+#include "src/shared/k8s/metadatapb/test_proto.h"
+#include "src/shared/metadata/metadata_state.h"
+#include "src/shared/metadata/state_manager.h"
+#include "src/shared/metadata/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table_store.h"
+
+// End-to-end benchmarks of PxL scripts from src/pxl_scripts/px, executed by Carnot over synthetic
+// http_events, conn_stats and process_stats tables. The range argument is the number of rows of
+// each table, which span the last 5 minutes.
+//
+// Reported per query: compile_ms (compilation and planning, ie. everything but execution),
+// exec_ms, rows/s processed and the growth of the peak RSS of the process.
+
+namespace px {
+namespace carnot {
+
+using table_store::Table;
+using table_store::schema::Relation;
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+constexpr int64_t kRowsPerBatch = 1024;
+constexpr int64_t kWindowNS = 5LL * 60 * 1000 * 1000 * 1000;
+constexpr uint32_t kASID = 1;
+constexpr int kNumPIDs = 100;
+
+// The scripts, with a call that displays one of their functions for scripts that only define
+// functions. The synthetic processes all belong to pod pl/running_pod of service
+// pl/running_service (see metadatapb::testutils).
+struct Script {
+  const char* name;
+  const char* path;
+  const char* invocation;
+};
+
+constexpr Script kScripts[] = {
+    {"http_request_stats", "src/pxl_scripts/px/http_request_stats/stats.pxl", ""},
+    {"pid_memory_usage", "src/pxl_scripts/px/pid_memory_usage/usage.pxl", ""},
+    {"service_memory_usage", "src/pxl_scripts/px/service_memory_usage/usage.pxl", ""},
+    {"namespace_pods", "src/pxl_scripts/px/namespace/namespace.pxl",
+     "px.display(pods_for_namespace('-5m', 'pl'))"},
+    {"namespace_service_let", "src/pxl_scripts/px/namespace/namespace.pxl",
+     "px.display(inbound_service_let_summary('-5m', 'pl'))"},
+    {"service_let", "src/pxl_scripts/px/service_stats/service_stats.pxl",
+     "px.display(svc_let('-5m', 'pl/running_service'))"},
+    {"http_data", "src/pxl_scripts/px/http_data/data.pxl",
+     "px.display(http_data('-5m', 1000))"},
+    {"net_flow_graph", "src/pxl_scripts/px/net_flow_graph/net_flow_graph.pxl",
+     "px.display(net_flow_graph('-5m', 'pl', '', '', 0.0))"},
+};
+
+int64_t PeakRSSBytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+// Strings drawn from a fixed pool with a zipfian skew, like paths or addresses.
+class StringPool {
+ public:
+  explicit StringPool(std::vector<std::string> values)
+      : values_(std::move(values)),
+        params_(2, 2, static_cast<double>(values_.size() - 1)),
+        index_gen_(&params_) {}
+
+  const std::string& Next() {
+    return values_[std::min<size_t>(index_gen_.Generate(), values_.size() - 1)];
+  }
+
+ private:
+  std::vector<std::string> values_;
+  datagen::ZipfianParams params_;
+  datagen::ZipfianGenerator index_gen_;
+};
+
+// Builds a table one batch at a time, from a generator of each column's values.
+class SyntheticTableBuilder {
+ public:
+  template <typename TValue>
+  using Generator = std::function<TValue()>;
+
+  template <typename TValue>
+  void AddColumn(std::string name, Generator<TValue> gen) {
+    names_.push_back(std::move(name));
+    types_.push_back(types::ValueTypeTraits<TValue>::data_type);
+    column_fns_.push_back([gen = std::move(gen)](int64_t num_rows) {
+      std::vector<TValue> values;
+      values.reserve(num_rows);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        values.push_back(gen());
+      }
+      return types::ToArrow(values, arrow::default_memory_pool());
+    });
+  }
+
+  StatusOr<std::shared_ptr<Table>> Build(int64_t num_rows) {
+    auto table = std::make_shared<Table>(Relation(types_, names_), /* max_table_size */ -1);
+    for (int64_t row = 0; row < num_rows; row += kRowsPerBatch) {
+      int64_t batch_rows = std::min(kRowsPerBatch, num_rows - row);
+      RowBatch rb(RowDescriptor(types_), batch_rows);
+      for (const auto& column_fn : column_fns_) {
+        PL_RETURN_IF_ERROR(rb.AddColumn(column_fn(batch_rows)));
+      }
+      PL_RETURN_IF_ERROR(table->WriteRowBatch(rb));
+    }
+    return table;
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<types::DataType> types_;
+  std::vector<std::function<std::shared_ptr<arrow::Array>(int64_t)>> column_fns_;
+};
+
+std::vector<std::string> RandomStrings(int num_values, int length) {
+  std::vector<std::string> values;
+  for (int i = 0; i < num_values; ++i) {
+    values.push_back(datagen::RandomString(length));
+  }
+  return values;
+}
+
+class TelemetryGenerator {
+ public:
+  TelemetryGenerator(int64_t num_rows, int64_t end_time_ns)
+      : num_rows_(num_rows), start_time_ns_(end_time_ns - kWindowNS) {}
+
+  StatusOr<std::shared_ptr<Table>> HTTPEvents() {
+    auto remote_addrs = std::make_shared<StringPool>(IPs("10.0", 256));
+    auto paths = std::make_shared<StringPool>(Paths(200));
+    auto headers = std::make_shared<StringPool>(RandomStrings(20, 200));
+    auto bodies = std::make_shared<StringPool>(RandomStrings(100, 128));
+    auto status = std::make_shared<int64_t>(200);
+
+    SyntheticTableBuilder builder;
+    AddCommonColumns(&builder);
+    builder.AddColumn<types::StringValue>("remote_addr", [=]() { return remote_addrs->Next(); });
+    builder.AddColumn<types::Int64Value>("remote_port",
+                                         [this]() { return Choice({80, 443, 8080}); });
+    builder.AddColumn<types::Int64Value>("trace_role", [this]() { return Choice({1, 2}); });
+    builder.AddColumn<types::Int64Value>("major_version", []() { return 1; });
+    builder.AddColumn<types::Int64Value>("minor_version", []() { return 1; });
+    builder.AddColumn<types::Int64Value>("content_type", [this]() { return Choice({0, 1}); });
+    builder.AddColumn<types::StringValue>("req_headers", [=]() { return headers->Next(); });
+    builder.AddColumn<types::StringValue>("req_method", [this]() {
+      return std::string(Choice<std::string_view>({"GET", "GET", "GET", "POST", "PUT"}));
+    });
+    builder.AddColumn<types::StringValue>("req_path", [=]() { return paths->Next(); });
+    builder.AddColumn<types::StringValue>("req_body", [=]() { return bodies->Next(); });
+    builder.AddColumn<types::Int64Value>("req_body_size", []() { return 128; });
+    builder.AddColumn<types::Int64Value>("req_body_bytes_skipped", []() { return 0; });
+    builder.AddColumn<types::StringValue>("resp_headers", [=]() { return headers->Next(); });
+    // resp_message is generated right after resp_status, and matches it.
+    builder.AddColumn<types::Int64Value>("resp_status", [this, status]() {
+      *status = Choice({200, 200, 200, 200, 200, 200, 200, 200, 404, 500});
+      return *status;
+    });
+    builder.AddColumn<types::StringValue>("resp_message", [status]() {
+      return std::string(*status == 200 ? "OK" : *status == 404 ? "Not Found" : "Error");
+    });
+    builder.AddColumn<types::StringValue>("resp_body", [=]() { return bodies->Next(); });
+    builder.AddColumn<types::Int64Value>("resp_body_size", []() { return 128; });
+    builder.AddColumn<types::Int64Value>("resp_body_bytes_skipped", []() { return 0; });
+    builder.AddColumn<types::Int64Value>("latency", [this]() {
+      return static_cast<int64_t>(std::exponential_distribution<double>(1e-6)(rng_));
+    });
+    return builder.Build(num_rows_);
+  }
+
+  StatusOr<std::shared_ptr<Table>> ConnStats() {
+    // Loopback addresses, so that px.nslookup() resolves them without DNS.
+    auto remote_addrs = std::make_shared<StringPool>(IPs("127.0", 16));
+    auto bytes = std::make_shared<int64_t>(0);
+
+    SyntheticTableBuilder builder;
+    AddCommonColumns(&builder);
+    builder.AddColumn<types::StringValue>("remote_addr", [=]() { return remote_addrs->Next(); });
+    builder.AddColumn<types::Int64Value>("remote_port",
+                                         [this]() { return Choice({80, 443, 8080}); });
+    builder.AddColumn<types::Int64Value>("trace_role", [this]() { return Choice({1, 2}); });
+    builder.AddColumn<types::Int64Value>("addr_family", []() { return 2; });
+    builder.AddColumn<types::Int64Value>("protocol", [this]() { return Choice({1, 2, 3}); });
+    builder.AddColumn<types::Int64Value>("conn_open", [this]() { return Uniform(1, 100); });
+    builder.AddColumn<types::Int64Value>("conn_close", [this]() { return Uniform(0, 100); });
+    builder.AddColumn<types::Int64Value>("conn_active", [this]() { return Uniform(0, 10); });
+    // The byte counters only grow.
+    builder.AddColumn<types::Int64Value>("bytes_sent", [this, bytes]() {
+      return *bytes += Uniform(0, 1 << 16);
+    });
+    builder.AddColumn<types::Int64Value>("bytes_recv", [bytes]() { return *bytes; });
+    builder.AddColumn<types::Int64Value>("events_suppressed", []() { return 0; });
+    return builder.Build(num_rows_);
+  }
+
+  StatusOr<std::shared_ptr<Table>> ProcessStats() {
+    SyntheticTableBuilder builder;
+    AddCommonColumns(&builder);
+    for (const char* name : {"major_faults", "minor_faults", "cpu_utime_ns", "cpu_ktime_ns"}) {
+      builder.AddColumn<types::Int64Value>(name, [this]() { return Uniform(0, 1000000); });
+    }
+    builder.AddColumn<types::Int64Value>("num_threads", [this]() { return Uniform(1, 64); });
+    builder.AddColumn<types::Int64Value>("vsize_bytes", [this]() { return Uniform(1, 1 << 30); });
+    builder.AddColumn<types::Int64Value>("rss_bytes", [this]() { return Uniform(1, 1 << 28); });
+    for (const char* name : {"rchar_bytes", "wchar_bytes", "read_bytes", "write_bytes"}) {
+      builder.AddColumn<types::Int64Value>(name, [this]() { return Uniform(0, 1 << 20); });
+    }
+    return builder.Build(num_rows_);
+  }
+
+  // The processes that the rows belong to.
+  static md::UPID UPIDOf(int i) { return md::UPID(kASID, 1000 + i, 1); }
+
+ private:
+  // The time_ and upid columns, which start every table.
+  void AddCommonColumns(SyntheticTableBuilder* builder) {
+    auto row = std::make_shared<int64_t>(0);
+    builder->AddColumn<types::Time64NSValue>("time_", [this, row]() {
+      return start_time_ns_ + (*row)++ * kWindowNS / num_rows_;
+    });
+    builder->AddColumn<types::UInt128Value>("upid", [this]() {
+      return types::UInt128Value(UPIDOf(Uniform(0, kNumPIDs - 1)).value());
+    });
+  }
+
+  int64_t Uniform(int64_t min, int64_t max) {
+    return std::uniform_int_distribution<int64_t>(min, max)(rng_);
+  }
+
+  template <typename T>
+  T Choice(std::initializer_list<T> values) {
+    return *(values.begin() + Uniform(0, values.size() - 1));
+  }
+
+  static std::vector<std::string> IPs(std::string_view prefix, int num_addrs) {
+    std::vector<std::string> addrs;
+    for (int i = 0; i < num_addrs; ++i) {
+      addrs.push_back(absl::Substitute("$0.$1.$2", prefix, i / 256, i % 256 + 1));
+    }
+    return addrs;
+  }
+
+  static std::vector<std::string> Paths(int num_paths) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < num_paths; ++i) {
+      paths.push_back(absl::StrCat("/api/v1/", datagen::RandomString(8), "/", i));
+    }
+    return paths;
+  }
+
+  const int64_t num_rows_;
+  const int64_t start_time_ns_;
+  // Seeded, so that the numeric columns are the same across runs. The string pools come from
+  // datagen, which seeds from std::random_device.
+  std::mt19937_64 rng_{42};
+};
+
+std::shared_ptr<md::AgentMetadataState> CreateMetadataState() {
+  auto md = std::make_shared<md::AgentMetadataState>(/* hostname */ "myhost", kASID,
+                                                     sole::uuid4(), "mypod");
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<md::ResourceUpdate>> updates;
+  updates.enqueue(metadatapb::testutils::CreateRunningContainerUpdatePB());
+  updates.enqueue(metadatapb::testutils::CreateRunningPodUpdatePB());
+  updates.enqueue(metadatapb::testutils::CreateRunningServiceUpdatePB());
+  md::TestAgentMetadataFilter md_filter;
+  PL_CHECK_OK(md::ApplyK8sUpdates(10, md.get(), &md_filter, &updates));
+  for (int i = 0; i < kNumPIDs; ++i) {
+    md::UPID upid = TelemetryGenerator::UPIDOf(i);
+    md->AddUPID(upid, std::make_unique<md::PIDInfo>(upid, absl::StrCat("/bin/app --id=", i),
+                                                    "pod1_container_1"));
+  }
+  return md;
+}
+
+// The tables of each size, generated once.
+std::shared_ptr<table_store::TableStore> TableStoreFor(int64_t num_rows) {
+  static auto* const kTableStores =
+      new std::map<int64_t, std::shared_ptr<table_store::TableStore>>();
+  auto& table_store = (*kTableStores)[num_rows];
+  if (table_store == nullptr) {
+    TelemetryGenerator gen(num_rows, CurrentTimeNS());
+    table_store = std::make_shared<table_store::TableStore>();
+    table_store->AddTable("http_events", gen.HTTPEvents().ConsumeValueOrDie());
+    table_store->AddTable("conn_stats", gen.ConnStats().ConsumeValueOrDie());
+    table_store->AddTable("process_stats", gen.ProcessStats().ConsumeValueOrDie());
+  }
+  return table_store;
+}
+
+std::string ReadScript(const Script& script) {
+  std::ifstream in(testing::TestFilePath(script.path));
+  CHECK(in.is_open()) << "Could not read " << script.path;
+  std::string query((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  return absl::StrCat(query, "\n", script.invocation, "\n");
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void BM_Script(benchmark::State& state, const Script& script) {
+  auto table_store = TableStoreFor(state.range(0));
+  exec::LocalGRPCResultSinkServer server;
+  auto carnot = Carnot::Create(sole::uuid4(), table_store,
+                               std::bind(&exec::LocalGRPCResultSinkServer::StubGenerator, &server,
+                                         std::placeholders::_1))
+                    .ConsumeValueOrDie();
+  auto md = CreateMetadataState();
+  carnot->RegisterAgentMetadataCallback([md]() { return md; });
+  std::string query = ReadScript(script);
+
+  int64_t compile_ns = 0;
+  int64_t exec_ns = 0;
+  int64_t rows_processed = 0;
+  const int64_t start_rss = PeakRSSBytes();
+  for (auto _ : state) {
+    server.ResetQueryResults();
+    auto start = std::chrono::steady_clock::now();
+    auto s = carnot->ExecuteQuery(query, sole::uuid4(), CurrentTimeNS());
+    int64_t total_ns = (std::chrono::steady_clock::now() - start).count();
+    if (!s.ok()) {
+      state.SkipWithError(s.msg().c_str());
+      return;
+    }
+    auto stats = server.exec_stats().ConsumeValueOrDie().execution_stats();
+    exec_ns += stats.timing().execution_time_ns();
+    compile_ns += total_ns - stats.timing().execution_time_ns();
+    rows_processed += stats.records_processed();
+  }
+
+  double iterations = state.iterations();
+  state.counters["compile_ms"] = compile_ns / iterations / 1e6;
+  state.counters["exec_ms"] = exec_ns / iterations / 1e6;
+  state.counters["rows/s"] = benchmark::Counter(rows_processed, benchmark::Counter::kIsRate);
+  state.counters["peak_rss_growth_bytes"] = PeakRSSBytes() - start_rss;
+}
+
+int RegisterBenchmarks() {
+  for (const Script& script : kScripts) {
+    benchmark::RegisterBenchmark(script.name, BM_Script, script)
+        ->Unit(benchmark::kMillisecond)
+        ->Arg(10 * 1000)
+        ->Arg(100 * 1000)
+        ->Arg(1000 * 1000);
+  }
+  return 0;
+}
+
+const int kRegistered = RegisterBenchmarks();
+
+}  // namespace
+
+}  // namespace carnot
+}  // namespace px
@@ -29,6 +29,7 @@
 #include "src/carnot/carnot.h"
 #include "src/carnot/exec/local_grpc_result_server.h"
 #include "src/carnot/exec/test_utils.h"
+#include "src/carnot/trace/query_trace.h"
 #include "src/carnot/udf_exporter/udf_exporter.h"
 #include "src/common/testing/testing.h"
 #include "src/table_store/table_store.h"
@@ -104,6 +105,34 @@ TEST_F(CarnotTest, basic) {
   EXPECT_TRUE(rb2.ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST_F(CarnotTest, query_trace_spans) {
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1','col2'])",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  auto query_id = sole::uuid4();
+  ASSERT_OK(carnot_->ExecuteQuery(query, query_id, 0));
+
+  std::map<std::string, trace::QuerySpan> spans;
+  for (const auto& span : trace::QueryTraceStore::Default()->Spans()) {
+    if (span.query_id == query_id) {
+      spans[span.name] = span;
+    }
+  }
+  ASSERT_EQ(1, spans.count("compile"));
+  ASSERT_EQ(1, spans.count("execute_plan"));
+  ASSERT_EQ(1, spans.count("fragment"));
+  ASSERT_EQ(1, spans.count("result_forward"));
+  EXPECT_EQ(spans["execute_plan"].span_id, spans["fragment"].parent_span_id);
+  EXPECT_EQ(spans["fragment"].span_id, spans["result_forward"].parent_span_id);
+  EXPECT_EQ("5", spans["execute_plan"].attributes["rows_processed"]);
+  EXPECT_LE(spans["execute_plan"].start_time_ns, spans["fragment"].start_time_ns);
+  EXPECT_GE(spans["execute_plan"].end_time_ns, spans["fragment"].end_time_ns);
+}
+
 TEST_F(CarnotTest, register_metadata) {
   auto callback_calls = 0;
   carnot_->RegisterAgentMetadataCallback(
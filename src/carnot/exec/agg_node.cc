@@ -22,7 +22,11 @@
 #include <arrow/array/builder_base.h>
 #include <arrow/status.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
 
 #include <magic_enum.hpp>
 
@@ -31,16 +35,25 @@
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/udf/udf_wrapper.h"
 #include "src/common/base/base.h"
+#include "src/common/base/worker_pool.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
+DEFINE_bool(carnot_agg_fixed_size_keys, true,
+            "Whether blocking aggregates grouped only by fixed size columns key their groups by "
+            "an inline hash map instead of RowTuples.");
+DEFINE_bool(carnot_agg_dictionary_encode_strings, true,
+            "Whether blocking aggregates key string groups by their dictionary codes, so that "
+            "they can use the inline hash map of carnot_agg_fixed_size_keys.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
 using SharedArray = std::shared_ptr<arrow::Array>;
-constexpr int64_t kAggCompactionThreshold = 512;
+// The fewest groups that are worth finalizing or merging as a partition on the worker pool.
+constexpr size_t kMinGroupsPerPartition = 16 * 1024;
 
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
@@ -55,27 +68,129 @@ void ExtractIntoGroupArgs(std::vector<GroupArgs>* group_args, arrow::Array* col,
 }
 
 template <types::DataType DT>
-void AppendToBuilder(arrow::ArrayBuilder* builder, RowTuple* rt, size_t rt_idx) {
+void ExtractIntoFixedSizeKeys(std::vector<types::FixedSizeValueUnion>* keys, arrow::Array* col,
+                              size_t key_idx, size_t key_width) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  using ArrowArrayType = typename types::DataTypeTraits<DT>::arrow_array_type;
+  auto* arr = static_cast<ArrowArrayType*>(col);
+  auto num_rows = col->length();
+  for (auto row_idx = 0; row_idx < num_rows; ++row_idx) {
+    types::SetValue<ValueType>(&(*keys)[row_idx * key_width + key_idx],
+                               types::GetValue(arr, row_idx));
+  }
+}
+
+// Reads the times of an INT64 or TIME64NS window column.
+template <types::DataType DT>
+void ReadWindowTimes(arrow::Array* col, std::vector<int64_t>* times) {
+  auto* arr = static_cast<typename types::DataTypeTraits<DT>::arrow_array_type*>(col);
+  for (int64_t row_idx = 0; row_idx < col->length(); ++row_idx) {
+    (*times)[row_idx] = arr->Value(row_idx);
+  }
+}
+
+// Builds an INT64 or TIME64NS column of the window starts, moved back by offset.
+template <types::DataType DT>
+StatusOr<SharedArray> BuildWindowStarts(const std::vector<int64_t>& starts, int64_t offset,
+                                        arrow::MemoryPool* mem_pool) {
+  typename types::DataTypeTraits<DT>::arrow_builder_type builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(starts.size()));
+  for (int64_t start : starts) {
+    builder.UnsafeAppend(start - offset);
+  }
+  SharedArray window_starts;
+  PL_RETURN_IF_ERROR(builder.Finish(&window_starts));
+  return window_starts;
+}
+
+// Writes the dictionary codes of a string column into the keys. Low cardinality columns usually
+// hold runs of the same string, which are only looked up once.
+void ExtractDictionaryEncodedKeys(std::vector<types::FixedSizeValueUnion>* keys, arrow::Array* col,
+                                  size_t key_idx, size_t key_width, StringDictionary* dict) {
+  auto* arr = static_cast<arrow::StringArray*>(col);
+  auto num_rows = col->length();
+  std::string_view prev_value;
+  int64_t prev_code = -1;
+  for (auto row_idx = 0; row_idx < num_rows; ++row_idx) {
+    auto view = arr->GetView(row_idx);
+    std::string_view value(view.data(), view.size());
+    if (prev_code < 0 || value != prev_value) {
+      prev_code = dict->GetOrInsert(value);
+      prev_value = value;
+    }
+    types::SetValue<types::Int64Value>(&(*keys)[row_idx * key_width + key_idx], prev_code);
+  }
+}
+
+void AppendDictionaryEncodedKeyToBuilder(arrow::ArrayBuilder* builder,
+                                         const types::FixedSizeValueUnion& key_val,
+                                         const StringDictionary& dict) {
+  auto status = static_cast<arrow::StringBuilder*>(builder)->Append(
+      dict.Value(types::Get<types::Int64Value>(key_val).val));
+  PL_DCHECK_OK(status);
+  PL_UNUSED(status);
+}
+
+template <types::DataType DT>
+void AppendFixedSizeKeyToBuilder(arrow::ArrayBuilder* builder,
+                                 const types::FixedSizeValueUnion& key_val) {
   using ArrowBuilder = typename types::DataTypeTraits<DT>::arrow_builder_type;
   using ValueType = typename types::DataTypeTraits<DT>::value_type;
   auto status =
-      static_cast<ArrowBuilder*>(builder)->Append(udf::UnWrap(rt->GetValue<ValueType>(rt_idx)));
+      static_cast<ArrowBuilder*>(builder)->Append(udf::UnWrap(types::Get<ValueType>(key_val)));
   PL_DCHECK_OK(status);
   PL_UNUSED(status);
 }
 
+// Only the types accepted by IsFixedSizeKey can be stored in a FixedSizeKeyHashMap.
+#define PL_SWITCH_FOREACH_FIXED_SIZE_KEY_DATATYPE(_dt_, _CASE_MACRO_)                 \
+  do {                                                                                \
+    auto __dt_var__ = (_dt_);                                                         \
+    switch (__dt_var__) {                                                             \
+      PL_SWITCH_FOREACH_DATATYPE_CASE(::px::types::DataType::BOOLEAN, _CASE_MACRO_);  \
+      PL_SWITCH_FOREACH_DATATYPE_CASE(::px::types::DataType::INT64, _CASE_MACRO_);    \
+      PL_SWITCH_FOREACH_DATATYPE_CASE(::px::types::DataType::UINT128, _CASE_MACRO_);  \
+      PL_SWITCH_FOREACH_DATATYPE_CASE(::px::types::DataType::TIME64NS, _CASE_MACRO_); \
+      PL_SWITCH_FOREACH_DATATYPE_DEFAULT_CASE(__dt_var__);                            \
+    }                                                                                 \
+  } while (0)
+
+// Multiplies the finalized values of an aggregate by scale, which turns a count or sum over a
+// sample of the rows into an estimate for all of them. Integers are rounded.
 template <types::DataType DT>
-void ExtractToColumnWrapper(const std::vector<GroupArgs>& group_args,
-                            const table_store::schema::RowBatch& rb, size_t col_idx,
-                            size_t rb_col_idx) {
-  size_t num_rows = rb.num_rows();
-  DCHECK(num_rows <= group_args.size());
-  for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
-    DCHECK(group_args[row_idx].av != nullptr);
-    auto col_wrapper = group_args[row_idx].av->agg_cols[col_idx].get();
-    auto arr = rb.ColumnAt(rb_col_idx).get();
-    types::ExtractValueToColumnWrapper<DT>(col_wrapper, arr, row_idx);
+StatusOr<SharedArray> ScaleValues(const SharedArray& values, double scale,
+                                  arrow::MemoryPool* mem_pool) {
+  using ArrowBuilder = typename types::DataTypeTraits<DT>::arrow_builder_type;
+  using ArrowArray = typename types::DataTypeTraits<DT>::arrow_array_type;
+  using NativeType = typename ArrowArray::value_type;
+  const auto* arr = static_cast<const ArrowArray*>(values.get());
+  ArrowBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(arr->length()));
+  for (int64_t i = 0; i < arr->length(); ++i) {
+    if (arr->IsNull(i)) {
+      builder.UnsafeAppendNull();
+      continue;
+    }
+    double scaled = arr->Value(i) * scale;
+    if constexpr (std::is_integral_v<NativeType>) {
+      builder.UnsafeAppend(static_cast<NativeType>(std::llround(scaled)));
+    } else {
+      builder.UnsafeAppend(scaled);
+    }
   }
+  SharedArray out;
+  PL_RETURN_IF_ERROR(builder.Finish(&out));
+  return out;
+}
+
+template <types::DataType DT>
+void AppendToBuilder(arrow::ArrayBuilder* builder, RowTuple* rt, size_t rt_idx) {
+  using ArrowBuilder = typename types::DataTypeTraits<DT>::arrow_builder_type;
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  auto status =
+      static_cast<ArrowBuilder*>(builder)->Append(udf::UnWrap(rt->GetValue<ValueType>(rt_idx)));
+  PL_DCHECK_OK(status);
+  PL_UNUSED(status);
 }
 
 }  // namespace
@@ -111,6 +226,16 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     return error::InvalidArgument("Output size mismatch in aggregate");
   }
 
+  if (!plan_node_->value_scales().empty() &&
+      plan_node_->value_scales().size() != static_cast<int>(plan_node_->values().size())) {
+    return error::InvalidArgument("Aggregate has $0 value scales for $1 values",
+                                  plan_node_->value_scales().size(), plan_node_->values().size());
+  }
+
+  if (plan_node_->has_time_window()) {
+    PL_RETURN_IF_ERROR(InitTimeWindow());
+  }
+
   if (HasNoGroups()) {
     return Status::OK();
   }
@@ -126,6 +251,14 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
   for (const auto& group : plan_node_->groups()) {
     DCHECK(group.idx < input_descriptor_->size());
     group_data_types_.emplace_back(input_descriptor_->type(group.idx));
+    group_col_idxs_.emplace_back(group.idx);
+  }
+  if (time_windowed_) {
+    // The window group is read from the window start column appended to each input batch.
+    group_col_idxs_[window_group_idx_] = input_descriptor_->size();
+    auto windowed_types = input_descriptor_->types();
+    windowed_types.push_back(group_data_types_[window_group_idx_]);
+    windowed_input_descriptor_ = std::make_unique<RowDescriptor>(std::move(windowed_types));
   }
 
   auto values_size = plan_node_->values().size();
@@ -135,7 +268,55 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     value_data_types_.emplace_back(output_descriptor_->type(values_idx));
   }
 
-  return CreateColumnMapping();
+  // String groups are keyed by their int64 dictionary codes.
+  std::vector<types::DataType> key_types = group_data_types_;
+  if (FLAGS_carnot_agg_dictionary_encode_strings) {
+    std::replace(key_types.begin(), key_types.end(), types::DataType::STRING,
+                 types::DataType::INT64);
+  }
+  use_fixed_size_keys_ = FLAGS_carnot_agg_fixed_size_keys && IsFixedSizeKey(key_types);
+  if (use_fixed_size_keys_) {
+    fixed_size_agg_hash_map_ = std::make_unique<FixedSizeAggHashMap>(group_data_types_.size());
+    group_dictionaries_.resize(group_data_types_.size());
+    for (size_t i = 0; i < group_data_types_.size(); ++i) {
+      if (group_data_types_[i] == types::DataType::STRING) {
+        group_dictionaries_[i] = std::make_unique<StringDictionary>();
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+Status AggNode::InitTimeWindow() {
+  const auto& window = plan_node_->time_window();
+  if (window.size_ns() <= 0) {
+    return error::InvalidArgument("Time window size must be positive, got $0", window.size_ns());
+  }
+  window_size_ns_ = window.size_ns();
+  window_slide_ns_ = window.slide_ns() == 0 ? window_size_ns_ : window.slide_ns();
+  if (window_slide_ns_ < 0 || window_size_ns_ % window_slide_ns_ != 0) {
+    return error::InvalidArgument("Time window slide $0 must evenly divide the window size $1",
+                                  window_slide_ns_, window_size_ns_);
+  }
+  if (window.group_index() < 0 ||
+      window.group_index() >= static_cast<int64_t>(plan_node_->groups().size())) {
+    return error::InvalidArgument("Time window group index $0 is out of range for $1 groups",
+                                  window.group_index(), plan_node_->groups().size());
+  }
+  window_group_idx_ = window.group_index();
+  window_time_col_idx_ = plan_node_->groups()[window_group_idx_].idx;
+  auto time_type = input_descriptor_->type(window_time_col_idx_);
+  if (time_type != types::DataType::INT64 && time_type != types::DataType::TIME64NS) {
+    return error::InvalidArgument(
+        "Time windows must be keyed on an INT64 or TIME64NS column, got $0",
+        magic_enum::enum_name(time_type));
+  }
+  // The partial results merged here come from many agents, each with its own watermark, so a
+  // window can't be closed until all of them have finished.
+  close_windows_at_eos_ = plan_node_->finalize_results() && !plan_node_->partial_agg();
+  time_windowed_ = true;
+  return Status::OK();
 }
 
 Status AggNode::PrepareImpl(ExecState* exec_state) {
@@ -154,12 +335,37 @@ Status AggNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_
   if (HasNoGroups()) {
     return AggregateGroupByNone(exec_state, rb);
   }
-  return AggregateGroupByClause(exec_state, rb);
+  if (time_windowed_) {
+    PL_RETURN_IF_ERROR(AggregateTimeWindows(exec_state, rb));
+  } else {
+    PL_RETURN_IF_ERROR(AggregateGroupByClause(exec_state, rb));
+  }
+  mem_pool()->SetExternalBytes(GroupStateBytes());
+  return Status::OK();
 }
 
 Status AggNode::CloseImpl(ExecState*) {
+  if (!HasNoGroups()) {
+    stats()->AddExtraMetric("num_groups", NumGroups());
+    stats()->AddExtraMetric("hash_table_lookups", hash_table_lookups_);
+    if (use_fixed_size_keys_) {
+      stats()->AddExtraMetric("hash_table_load_factor", fixed_size_agg_hash_map_->load_factor());
+      stats()->AddExtraMetric("hash_table_probes", fixed_size_agg_hash_map_->num_probes());
+    } else {
+      stats()->AddExtraMetric("hash_table_load_factor", agg_hash_map_.load_factor());
+    }
+  }
   udas_no_groups_.clear();
   group_args_chunk_.clear();
+  agg_hash_map_.clear();
+  windowed_group_tuples_.clear();
+  windowed_values_.clear();
+  if (fixed_size_agg_hash_map_ != nullptr) {
+    fixed_size_agg_hash_map_->clear();
+  }
+  ClearGroupDictionaries();
+  batch_keys_.clear();
+  batch_key_hashes_.clear();
   group_args_pool_.Clear();
   udas_pool_.Clear();
 
@@ -176,9 +382,72 @@ Status AggNode::ClearAggState(ExecState* exec_state) {
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
   }
   agg_hash_map_.clear();
+  if (use_fixed_size_keys_) {
+    fixed_size_agg_hash_map_->clear();
+    // No group refers to the dictionary codes anymore.
+    ClearGroupDictionaries();
+  }
   return Status::OK();
 }
 
+Status AggNode::MergeFrom(ExecState* exec_state, AggNode* other) {
+  PL_UNUSED(exec_state);
+  DCHECK(other != nullptr);
+  DCHECK_EQ(plan_node_->id(), other->plan_node_->id());
+  if (HasNoGroups()) {
+    DCHECK_EQ(udas_no_groups_.size(), other->udas_no_groups_.size());
+    for (size_t i = 0; i < udas_no_groups_.size(); ++i) {
+      const auto& uda_info = udas_no_groups_[i];
+      PL_RETURN_IF_ERROR(uda_info.def->Merge(
+          uda_info.uda.get(), other->udas_no_groups_[i].uda.get(), function_ctx_.get()));
+    }
+    return Status::OK();
+  }
+
+  hash_table_lookups_ += other->hash_table_lookups_;
+  // Groups of the other node that are new here are moved over while probing. The UDAs of the
+  // groups found in both are merged afterwards, which can run in parallel.
+  std::vector<std::pair<AggHashValue*, AggHashValue*>> to_merge;
+  if (use_fixed_size_keys_) {
+    DCHECK(other->use_fixed_size_keys_);
+    size_t key_width = group_data_types_.size();
+    // The dictionary codes of the other node's string groups are translated to this node's.
+    std::vector<types::FixedSizeValueUnion> merged_key(key_width);
+    other->fixed_size_agg_hash_map_->ForEach(
+        [&](const types::FixedSizeValueUnion* other_key, AggHashValue** other_val) {
+          std::copy(other_key, other_key + key_width, merged_key.begin());
+          for (size_t i = 0; i < key_width; ++i) {
+            if (group_dictionaries_[i] != nullptr) {
+              const auto& value = other->group_dictionaries_[i]->Value(
+                  types::Get<types::Int64Value>(other_key[i]).val);
+              types::SetValue<types::Int64Value>(&merged_key[i],
+                                                 group_dictionaries_[i]->GetOrInsert(value));
+            }
+          }
+          const auto* key = merged_key.data();
+          bool inserted = false;
+          auto* val = fixed_size_agg_hash_map_->FindOrInsert(key, HashFixedSizeKey(key, key_width),
+                                                             &inserted);
+          if (inserted) {
+            *val = *other_val;
+            return;
+          }
+          to_merge.emplace_back(*val, *other_val);
+        });
+    return MergeAggHashValues(to_merge);
+  }
+
+  for (const auto& [groups_rt, other_val] : other->agg_hash_map_) {
+    auto it = agg_hash_map_.find(groups_rt);
+    if (it == agg_hash_map_.end()) {
+      agg_hash_map_[groups_rt] = other_val;
+      continue;
+    }
+    to_merge.emplace_back(it->second, other_val);
+  }
+  return MergeAggHashValues(to_merge);
+}
+
 Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb) {
   auto values = plan_node_->values();
   for (size_t i = 0; i < values.size(); ++i) {
@@ -190,13 +459,12 @@ Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb)
     RowBatch output_rb(*output_descriptor_, 1);
     for (size_t i = 0; i < values.size(); ++i) {
       const auto& uda_info = udas_no_groups_[i];
-      auto builder = types::MakeArrowBuilder(uda_info.def->finalize_return_type(),
-                                             exec_state->exec_mem_pool());
+      auto builder = types::MakeArrowBuilder(uda_info.def->finalize_return_type(), mem_pool());
       PL_RETURN_IF_ERROR(
           uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builder.get()));
       SharedArray out_col;
       PL_RETURN_IF_ERROR(builder->Finish(&out_col));
-      PL_RETURN_IF_ERROR(output_rb.AddColumn(out_col));
+      PL_RETURN_IF_ERROR(AddValueColumn(i, out_col, &output_rb));
     }
     output_rb.set_eow(rb.eow());
     output_rb.set_eos(rb.eos());
@@ -219,11 +487,9 @@ Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
 
   // Scan through all the group args in column order and extract the entire column.
   for (size_t idx = 0; idx < plan_node_->groups().size(); idx++) {
-    auto grp = plan_node_->groups()[idx];
-    DCHECK(grp.idx < input_descriptor_->size());
     DCHECK(idx < group_data_types_.size());
     auto dt = group_data_types_[idx];
-    auto col = rb.ColumnAt(grp.idx).get();
+    auto col = rb.ColumnAt(group_col_idxs_[idx]).get();
 
 #define TYPE_CASE(_dt_) ExtractIntoGroupArgs<_dt_>(&group_args_chunk_, col, idx);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
@@ -234,6 +500,7 @@ Status AggNode::ExtractRowTupleForBatch(const RowBatch& rb) {
 
 Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
   PL_UNUSED(exec_state);
+  hash_table_lookups_ += rb.num_rows();
   // Loop through all the row and basically store the values into column chunk based on which
   // group they belong to.
   for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
@@ -254,33 +521,54 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
     }
     ga.av = val;
   }
+  return Status::OK();
+}
 
-  auto values = plan_node_->values();
-  // Now extract the values in the agg hash value.
-  for (size_t i = 0; i < stored_cols_data_types_.size(); ++i) {
-    const auto& rb_col_idx = stored_cols_to_plan_idx_[i];
-    const auto& dt = input_descriptor_->type(rb_col_idx);
-
-#define TYPE_CASE(_dt_) ExtractToColumnWrapper<_dt_>(group_args_chunk_, rb, i, rb_col_idx);
+Status AggNode::ExtractFixedSizeKeysForBatch(const RowBatch& rb) {
+  size_t num_rows = rb.num_rows();
+  size_t key_width = group_data_types_.size();
+  // Grow the group_args_chunk_ to be the size of the RowBatch. Only the values are used, so it
+  // doesn't hold RowTuples.
+  if (group_args_chunk_.size() < num_rows) {
+    group_args_chunk_.resize(num_rows, GroupArgs(nullptr));
+  }
+  // Keys are compared bytewise, so they have to be zeroed before the values are written.
+  batch_keys_.resize(num_rows * key_width);
+  memset(batch_keys_.data(), 0, batch_keys_.size() * sizeof(types::FixedSizeValueUnion));
+
+  for (size_t idx = 0; idx < key_width; idx++) {
+    auto col = rb.ColumnAt(group_col_idxs_[idx]).get();
+    if (group_dictionaries_[idx] != nullptr) {
+      ExtractDictionaryEncodedKeys(&batch_keys_, col, idx, key_width,
+                                   group_dictionaries_[idx].get());
+      continue;
+    }
 
-    PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#define TYPE_CASE(_dt_) ExtractIntoFixedSizeKeys<_dt_>(&batch_keys_, col, idx, key_width);
+    PL_SWITCH_FOREACH_FIXED_SIZE_KEY_DATATYPE(group_data_types_[idx], TYPE_CASE);
 #undef TYPE_CASE
   }
-
   return Status::OK();
 }
 
-Status AggNode::EvaluatePartialAggregates(ExecState* exec_state, size_t num_records) {
-  PL_UNUSED(exec_state);
-  // TODO(zasgar): This only needs to run for unique groups. We should find
-  // a way to optimize this.
-  for (size_t i = 0; i < num_records; ++i) {
-    DCHECK(i < group_args_chunk_.size());
-    auto& ga = group_args_chunk_[i];
-    DCHECK(ga.av != nullptr);
-    if (ga.av->agg_cols[0]->Size() > kAggCompactionThreshold) {
-      PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, ga.av));
+Status AggNode::HashFixedSizeKeysForBatch(ExecState* exec_state, const RowBatch& rb) {
+  size_t num_rows = rb.num_rows();
+  size_t key_width = group_data_types_.size();
+  // Hash all of the keys first, then probe, so the hashing loop doesn't stall on the map.
+  hash_table_lookups_ += num_rows;
+  batch_key_hashes_.resize(num_rows);
+  for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    batch_key_hashes_[row_idx] = HashFixedSizeKey(&batch_keys_[row_idx * key_width], key_width);
+  }
+
+  for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    bool inserted = false;
+    auto* val = fixed_size_agg_hash_map_->FindOrInsert(&batch_keys_[row_idx * key_width],
+                                                       batch_key_hashes_[row_idx], &inserted);
+    if (inserted) {
+      *val = CreateAggHashValue(exec_state);
     }
+    group_args_chunk_[row_idx].av = *val;
   }
   return Status::OK();
 }
@@ -291,6 +579,9 @@ Status AggNode::ResetGroupArgs() {
   // agg hash value to nullptr.
   for (size_t i = 0; i < group_args_chunk_.size(); ++i) {
     group_args_chunk_[i].av = nullptr;
+    if (use_fixed_size_keys_) {
+      continue;
+    }
     if (group_args_chunk_[i].rt == nullptr) {
       group_args_chunk_[i].rt = CreateGroupArgsRowTuple();
     } else {
@@ -300,37 +591,78 @@ Status AggNode::ResetGroupArgs() {
   return Status::OK();
 }
 
-Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* output_rb) {
-  PL_UNUSED(exec_state);
+StatusOr<std::vector<std::unique_ptr<RowBatch>>> AggNode::ConvertAggHashMapToRowBatches(
+    ExecState* exec_state) {
+  std::vector<GroupRef> groups;
+  groups.reserve(NumGroups());
+  if (use_fixed_size_keys_) {
+    fixed_size_agg_hash_map_->ForEach(
+        [&](const types::FixedSizeValueUnion* key, AggHashValue** val) {
+          groups.push_back(GroupRef{key, nullptr, *val});
+        });
+  } else {
+    for (const auto& [groups_rt, val] : agg_hash_map_) {
+      groups.push_back(GroupRef{nullptr, groups_rt, val});
+    }
+  }
+
+  // Large maps are split into contiguous partitions of groups, which are finalized on the worker
+  // pool into a batch each.
+  size_t num_partitions = std::clamp<size_t>(groups.size() / kMinGroupsPerPartition, 1,
+                                             WorkerPool::Default()->num_threads() + 1);
+  std::vector<std::unique_ptr<RowBatch>> output_rbs(num_partitions);
+  std::vector<Status> statuses(num_partitions);
+  auto finalize_partition = [&](size_t partition) {
+    size_t begin = groups.size() * partition / num_partitions;
+    size_t end = groups.size() * (partition + 1) / num_partitions;
+    output_rbs[partition] = std::make_unique<RowBatch>(*output_descriptor_, end - begin);
+    statuses[partition] = FinalizeGroups(exec_state, groups.data() + begin, groups.data() + end,
+                                         output_rbs[partition].get());
+  };
+  if (num_partitions == 1) {
+    finalize_partition(0);
+  } else {
+    WorkerPool::Default()->ParallelFor(num_partitions, finalize_partition);
+  }
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  return output_rbs;
+}
+
+Status AggNode::FinalizeGroups(ExecState* exec_state, const GroupRef* begin, const GroupRef* end,
+                               RowBatch* output_rb) {
   DCHECK(output_rb != nullptr);
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> group_builders;
   for (const auto& group_dt : group_data_types_) {
-    group_builders.push_back(types::MakeArrowBuilder(group_dt, exec_state->exec_mem_pool()));
+    group_builders.push_back(types::MakeArrowBuilder(group_dt, mem_pool()));
   }
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> value_builders;
   for (const auto& value_data_type : value_data_types_) {
-    value_builders.push_back(types::MakeArrowBuilder(value_data_type, exec_state->exec_mem_pool()));
+    value_builders.push_back(types::MakeArrowBuilder(value_data_type, mem_pool()));
   }
 
   // Agg into agg values and emit!
-  for (const auto& kv : agg_hash_map_) {
-    auto* groups_rt = kv.first;
-    auto* val = kv.second;
-
+  for (const GroupRef* group = begin; group != end; ++group) {
     for (size_t i = 0; i < group_data_types_.size(); ++i) {
       DCHECK(i < group_builders.size());
+      if (group->rt != nullptr) {
+#define TYPE_CASE(_dt_) AppendToBuilder<_dt_>(group_builders[i].get(), group->rt, i);
+        PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
+#undef TYPE_CASE
+        continue;
+      }
+      if (group_dictionaries_[i] != nullptr) {
+        AppendDictionaryEncodedKeyToBuilder(group_builders[i].get(), group->key[i],
+                                            *group_dictionaries_[i]);
+        continue;
+      }
 
-#define TYPE_CASE(_dt_) AppendToBuilder<_dt_>(group_builders[i].get(), groups_rt, i);
-      PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
+#define TYPE_CASE(_dt_) AppendFixedSizeKeyToBuilder<_dt_>(group_builders[i].get(), group->key[i]);
+      PL_SWITCH_FOREACH_FIXED_SIZE_KEY_DATATYPE(group_data_types_[i], TYPE_CASE);
 #undef TYPE_CASE
     }
-    // Actually Finalize the UDA based on the column wrapper chunks.
-    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
-    for (size_t i = 0; i < val->udas.size(); ++i) {
-      const auto& uda_info = val->udas[i];
-      PL_RETURN_IF_ERROR(uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(),
-                                                     value_builders[i].get()));
-    }
+    PL_RETURN_IF_ERROR(FinalizeAggHashValue(exec_state, group->val, value_builders));
   }
 
   for (const auto& group_builder : group_builders) {
@@ -339,16 +671,95 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
     PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
   }
 
-  for (const auto& value_builder : value_builders) {
+  for (size_t i = 0; i < value_builders.size(); ++i) {
     std::shared_ptr<arrow::Array> arr;
-    PL_RETURN_IF_ERROR(value_builder->Finish(&arr));
-    PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
+    PL_RETURN_IF_ERROR(value_builders[i]->Finish(&arr));
+    PL_RETURN_IF_ERROR(AddValueColumn(i, arr, output_rb));
   }
 
   return Status::OK();
 }
 
-Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
+Status AggNode::AddValueColumn(size_t value_idx, const SharedArray& values,
+                               RowBatch* output_rb) const {
+  const auto& scales = plan_node_->value_scales();
+  if (scales.empty() || scales[value_idx] == 1.0) {
+    return output_rb->AddColumn(values);
+  }
+  double scale = scales[value_idx];
+  SharedArray scaled;
+  switch (values->type_id()) {
+    case arrow::Type::INT64: {
+      PL_ASSIGN_OR_RETURN(scaled, ScaleValues<types::INT64>(values, scale, mem_pool()));
+      break;
+    }
+    case arrow::Type::DOUBLE: {
+      PL_ASSIGN_OR_RETURN(scaled, ScaleValues<types::FLOAT64>(values, scale, mem_pool()));
+      break;
+    }
+    default:
+      return error::InvalidArgument("Only INT64 and FLOAT64 aggregate values can be scaled");
+  }
+  return output_rb->AddColumn(scaled);
+}
+
+Status AggNode::EmitGroups(ExecState* exec_state, const RowBatch& rb) {
+  PL_ASSIGN_OR_RETURN(auto output_rbs, ConvertAggHashMapToRowBatches(exec_state));
+  for (size_t i = 0; i < output_rbs.size(); ++i) {
+    // Only the last batch of the groups ends the window or stream.
+    bool last = i + 1 == output_rbs.size();
+    output_rbs[i]->set_eow(last && rb.eow());
+    output_rbs[i]->set_eos(last && rb.eos());
+    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *output_rbs[i]));
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergeAggHashValues(
+    const std::vector<std::pair<AggHashValue*, AggHashValue*>>& vals) {
+  // Every pair holds distinct UDAs, so the merges of large maps run in parallel partitions.
+  size_t num_partitions = std::clamp<size_t>(vals.size() / kMinGroupsPerPartition, 1,
+                                             WorkerPool::Default()->num_threads() + 1);
+  std::vector<Status> statuses(num_partitions);
+  auto merge_partition = [&](size_t partition) {
+    size_t end = vals.size() * (partition + 1) / num_partitions;
+    for (size_t idx = vals.size() * partition / num_partitions; idx < end; ++idx) {
+      auto [val, other_val] = vals[idx];
+      for (size_t i = 0; i < val->udas.size(); ++i) {
+        const auto& uda_info = val->udas[i];
+        Status s = uda_info.def->Merge(uda_info.uda.get(), other_val->udas[i].uda.get(),
+                                       function_ctx_.get());
+        if (!s.ok()) {
+          statuses[partition] = s;
+          return;
+        }
+      }
+    }
+  };
+  if (num_partitions == 1) {
+    merge_partition(0);
+  } else {
+    WorkerPool::Default()->ParallelFor(num_partitions, merge_partition);
+  }
+  for (const auto& s : statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+Status AggNode::FinalizeAggHashValue(
+    ExecState* exec_state, AggHashValue* val,
+    const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) {
+  PL_UNUSED(exec_state);
+  for (size_t i = 0; i < val->udas.size(); ++i) {
+    const auto& uda_info = val->udas[i];
+    PL_RETURN_IF_ERROR(
+        uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builders[i].get()));
+  }
+  return Status::OK();
+}
+
+Status AggNode::AccumulateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
   // Extracts the row tuples (column wise).
   // TODO(zasgar): PL-455 - Chunk this so we don't create a crazy number of row tuples if the batch
   // is large. The process is as follows:
@@ -357,23 +768,143 @@ Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb
   // 3. If the agg values are large then run aggregate and compact.
   // 4. Reset state to prepare for next row batch.
   // 5. If it's the last batch then emit the values.
-  PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
-  PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
-  if (plan_node_->values().size() > 0) {
-    PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_rows()));
+  // Groups are keyed inline, unless dictionary encoding is disabled and there are string groups,
+  // which then fall back to RowTuples.
+  if (use_fixed_size_keys_) {
+    PL_RETURN_IF_ERROR(ExtractFixedSizeKeysForBatch(rb));
+    PL_RETURN_IF_ERROR(HashFixedSizeKeysForBatch(exec_state, rb));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
+    PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
   }
-  PL_RETURN_IF_ERROR(ResetGroupArgs());
+  PL_RETURN_IF_ERROR(UpdateGroupsForBatch(exec_state, rb));
+  return ResetGroupArgs();
+}
+
+Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb) {
+  PL_RETURN_IF_ERROR(AccumulateGroupByClause(exec_state, rb));
   if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, agg_hash_map_.size());
-    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, &output_rb));
-    output_rb.set_eow(rb.eow());
-    output_rb.set_eos(rb.eos());
-    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+    PL_RETURN_IF_ERROR(EmitGroups(exec_state, rb));
     PL_RETURN_IF_ERROR(ClearAggState(exec_state));
   }
   return Status::OK();
 }
 
+Status AggNode::AggregateTimeWindows(ExecState* exec_state, const RowBatch& rb) {
+  auto num_rows = rb.num_rows();
+  auto window_type = group_data_types_[window_group_idx_];
+  auto* time_col = rb.ColumnAt(window_time_col_idx_).get();
+  // The start of the latest window each row falls in, rounded down to a multiple of the slide.
+  std::vector<int64_t> latest_starts(num_rows);
+  if (window_type == types::DataType::TIME64NS) {
+    ReadWindowTimes<types::DataType::TIME64NS>(time_col, &latest_starts);
+  } else {
+    ReadWindowTimes<types::DataType::INT64>(time_col, &latest_starts);
+  }
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    int64_t time = latest_starts[row_idx];
+    latest_starts[row_idx] =
+        time - (((time % window_slide_ns_) + window_slide_ns_) % window_slide_ns_);
+    watermark_ = std::max(watermark_, time);
+  }
+
+  // A row falls in size / slide overlapping windows, so sliding windows aggregate the batch once
+  // for each of them, with the window group replaced by that window's start. Tumbling windows
+  // only need a single pass.
+  int64_t windows_per_row = window_size_ns_ / window_slide_ns_;
+  for (int64_t window_idx = 0; window_idx < windows_per_row; ++window_idx) {
+    int64_t offset = window_idx * window_slide_ns_;
+    SharedArray window_starts;
+    if (window_type == types::DataType::TIME64NS) {
+      PL_ASSIGN_OR_RETURN(window_starts, BuildWindowStarts<types::DataType::TIME64NS>(
+                                             latest_starts, offset, mem_pool()));
+    } else {
+      PL_ASSIGN_OR_RETURN(window_starts, BuildWindowStarts<types::DataType::INT64>(
+                                             latest_starts, offset, mem_pool()));
+    }
+
+    RowBatch windowed_rb(*windowed_input_descriptor_, num_rows);
+    for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+      PL_RETURN_IF_ERROR(windowed_rb.AddColumn(rb.ColumnAt(col_idx)));
+    }
+    PL_RETURN_IF_ERROR(windowed_rb.AddColumn(window_starts));
+    PL_RETURN_IF_ERROR(AccumulateGroupByClause(exec_state, windowed_rb));
+  }
+  return EmitClosedWindows(exec_state, rb);
+}
+
+int64_t AggNode::WindowStartOfKey(const types::FixedSizeValueUnion* key) const {
+  const auto& start = key[window_group_idx_];
+  return group_data_types_[window_group_idx_] == types::DataType::TIME64NS
+             ? start.time64ns_value.val
+             : start.int64_value.val;
+}
+
+void AggNode::ReleaseWindowedGroup(RowTuple* groups_rt, AggHashValue* val) {
+  if (groups_rt != nullptr) {
+    windowed_group_tuples_.erase(groups_rt);
+  }
+  windowed_values_.erase(val);
+}
+
+Status AggNode::EmitClosedWindows(ExecState* exec_state, const RowBatch& rb) {
+  // Rows that arrive after their window was emitted start a new group for that window, which is
+  // emitted as a delta once the window closes again.
+  auto window_is_open = [&](int64_t window_start) {
+    return !rb.eos() && (close_windows_at_eos_ || window_start + window_size_ns_ > watermark_);
+  };
+
+  // Move the groups of open windows aside, so that only the closed windows are left in the hash
+  // map when it is converted to the output batch.
+  AggHashMap open_groups;
+  std::unique_ptr<FixedSizeAggHashMap> open_fixed_size_groups;
+  if (use_fixed_size_keys_) {
+    size_t key_width = group_data_types_.size();
+    open_fixed_size_groups = std::make_unique<FixedSizeAggHashMap>(key_width);
+    auto closed_groups = std::make_unique<FixedSizeAggHashMap>(key_width);
+    fixed_size_agg_hash_map_->ForEach(
+        [&](const types::FixedSizeValueUnion* key, AggHashValue** val) {
+          auto* groups = window_is_open(WindowStartOfKey(key)) ? open_fixed_size_groups.get()
+                                                               : closed_groups.get();
+          bool inserted = false;
+          *groups->FindOrInsert(key, HashFixedSizeKey(key, key_width), &inserted) = *val;
+        });
+    fixed_size_agg_hash_map_ = std::move(closed_groups);
+  } else {
+    auto window_type = group_data_types_[window_group_idx_];
+    for (auto it = agg_hash_map_.begin(); it != agg_hash_map_.end();) {
+      int64_t window_start =
+          window_type == types::DataType::TIME64NS
+              ? it->first->GetValue<types::Time64NSValue>(window_group_idx_).val
+              : it->first->GetValue<types::Int64Value>(window_group_idx_).val;
+      if (window_is_open(window_start)) {
+        open_groups.emplace(it->first, it->second);
+        agg_hash_map_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  if (NumGroups() > 0 || rb.eos()) {
+    PL_RETURN_IF_ERROR(EmitGroups(exec_state, rb));
+  }
+
+  // Drop the emitted groups and keep aggregating into the open windows.
+  if (use_fixed_size_keys_) {
+    fixed_size_agg_hash_map_->ForEach([&](const types::FixedSizeValueUnion*, AggHashValue** val) {
+      ReleaseWindowedGroup(nullptr, *val);
+    });
+    fixed_size_agg_hash_map_ = std::move(open_fixed_size_groups);
+  } else {
+    for (const auto& [groups_rt, val] : agg_hash_map_) {
+      ReleaseWindowedGroup(groups_rt, val);
+    }
+    agg_hash_map_ = std::move(open_groups);
+  }
+  return Status::OK();
+}
+
 StatusOr<types::DataType> AggNode::GetTypeOfDep(const plan::ScalarExpression& expr) const {
   // Agg exprs can only be of type col, or  const.
   switch (expr.ExpressionType()) {
@@ -392,12 +923,13 @@ StatusOr<types::DataType> AggNode::GetTypeOfDep(const plan::ScalarExpression& ex
 Status AggNode::EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UDAInfo& uda_info,
                                                  plan::AggregateExpression* expr,
                                                  const RowBatch& input_rb) {
+  PL_UNUSED(exec_state);
   plan::ExpressionWalker<StatusOr<SharedArray>> walker;
   walker.OnScalarValue(
       [&](const plan::ScalarValue& val,
           const std::vector<StatusOr<SharedArray>>& children) -> std::shared_ptr<arrow::Array> {
         DCHECK_EQ(children.size(), 0ULL);
-        return EvalScalarToArrow(exec_state, val, input_rb.num_rows());
+        return EvalScalarToArrow(mem_pool(), val, input_rb.num_rows());
       });
 
   walker.OnColumn(
@@ -431,88 +963,113 @@ Status AggNode::EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UD
   return Status::OK();
 }
 
-Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
+Status AggNode::UpdateGroupsForBatch(ExecState* exec_state, const RowBatch& rb) {
+  PL_UNUSED(exec_state);
+  size_t num_rows = rb.num_rows();
+  if (num_rows == 0) {
+    return Status::OK();
+  }
+  // The values are fed straight from the input columns to the UDA of each row's group, instead of
+  // being gathered into per group columns first. With many groups most of them only get a row or
+  // two per batch, and gathering those costs more than the updates.
+  batch_udas_.resize(num_rows);
   size_t values_size = plan_node_->values().size();
   for (size_t i = 0; i < values_size; ++i) {
-    const auto& uda_info = val->udas[i];
-    const auto& expr = *plan_node_->values()[i];
-    size_t num_records = val->agg_cols[0]->Size();
-    plan::ExpressionWalker<StatusOr<types::SharedColumnWrapper>> walker;
-    walker.OnScalarValue([&](const plan::ScalarValue& scalar_val,
-                             const std::vector<StatusOr<types::SharedColumnWrapper>>& children)
-                             -> types::SharedColumnWrapper {
-      DCHECK_EQ(children.size(), 0ULL);
-      return EvalScalarToColumnWrapper(exec_state, scalar_val, num_records);
-    });
+    for (size_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+      DCHECK(group_args_chunk_[row_idx].av != nullptr);
+      batch_udas_[row_idx] = group_args_chunk_[row_idx].av->udas[i].uda.get();
+    }
+    udf::UDADefinition* def = group_args_chunk_[0].av->udas[i].def;
 
-    walker.OnColumn([&](const plan::Column& col,
-                        const std::vector<StatusOr<types::SharedColumnWrapper>>& children)
-                        -> types::SharedColumnWrapper {
-      DCHECK_EQ(children.size(), 0ULL);
-      return val->agg_cols[plan_cols_to_stored_map_[col.Index()]];
-    });
+    plan::ExpressionWalker<StatusOr<SharedArray>> walker;
+    walker.OnScalarValue(
+        [&](const plan::ScalarValue& val,
+            const std::vector<StatusOr<SharedArray>>& children) -> std::shared_ptr<arrow::Array> {
+          DCHECK_EQ(children.size(), 0ULL);
+          return EvalScalarToArrow(mem_pool(), val, num_rows);
+        });
+
+    walker.OnColumn(
+        [&](const plan::Column& col,
+            const std::vector<StatusOr<SharedArray>>& children) -> std::shared_ptr<arrow::Array> {
+          DCHECK_EQ(children.size(), 0ULL);
+          return rb.ColumnAt(col.Index());
+        });
 
     walker.OnAggregateExpression(
         [&](const plan::AggregateExpression& agg,
-            const std::vector<StatusOr<types::SharedColumnWrapper>>& children)
-            -> StatusOr<types::SharedColumnWrapper> {
-          DCHECK(agg.name() == uda_info.def->name());
-          DCHECK(children.size() == uda_info.def->update_arguments().size());
-          // collect the arguments.
-          std::vector<const types::ColumnWrapper*> raw_children;
+            const std::vector<StatusOr<SharedArray>>& children) -> StatusOr<SharedArray> {
+          DCHECK(agg.name() == def->name());
+          DCHECK(children.size() == def->update_arguments().size());
+          std::vector<const arrow::Array*> raw_children;
           raw_children.reserve(children.size());
-          for (auto& child : children) {
+          for (const auto& child : children) {
             PL_RETURN_IF_ERROR(child);
             raw_children.push_back(child.ValueOrDie().get());
           }
           PL_RETURN_IF_ERROR(
-              uda_info.def->ExecBatchUpdate(uda_info.uda.get(), nullptr /* ctx */, raw_children));
+              def->ExecBatchUpdateByGroupArrow(batch_udas_, nullptr /* ctx */, raw_children));
           // Blocking aggregates don't produce results until all data is seen.
           return {};
         });
-    PL_RETURN_IF_ERROR(walker.Walk(expr));
-  }
-
-  for (auto& col : val->agg_cols) {
-    // Clear the values, so we don't aggregate them twice.
-    col->Clear();
+    PL_RETURN_IF_ERROR(walker.Walk(*plan_node_->values()[i]));
   }
   return Status::OK();
 }
 
-Status AggNode::CreateColumnMapping() {
-  for (const auto& expr : plan_node_->values()) {
-    plan::ExpressionWalker<int> walker;
+AggHashValue* AggNode::CreateAggHashValue(ExecState* exec_state) {
+  AggHashValue* val = nullptr;
+  if (time_windowed_) {
+    auto owned_val = std::make_unique<AggHashValue>();
+    val = owned_val.get();
+    windowed_values_.emplace(val, std::move(owned_val));
+  } else {
+    val = udas_pool_.New();
+  }
+  PL_CHECK_OK(CreateUDAInfoValues(&(val->udas), exec_state));
+  if (uda_bytes_per_group_ < 0) {
+    uda_bytes_per_group_ = 0;
+    for (const auto& uda_info : val->udas) {
+      uda_bytes_per_group_ += sizeof(UDAInfo) + uda_info.def->instance_size();
+      udas_have_heap_bytes_ |= uda_info.def->has_heap_bytes();
+    }
+  }
+  return val;
+}
 
-    walker.OnScalarValue(
-        [&](const plan::ScalarValue&, const std::vector<int>&) -> int { return 0; });
-
-    walker.OnColumn([&](const plan::Column& col, const std::vector<int>&) -> int {
-      auto plan_col_idx = col.Index();
-      if (plan_cols_to_stored_map_.find(plan_col_idx) == plan_cols_to_stored_map_.end()) {
-        // We aren't currently capturing this col, so add it to the list of cols to store.
-        plan_cols_to_stored_map_[plan_col_idx] = stored_cols_to_plan_idx_.size();
-        stored_cols_to_plan_idx_.emplace_back(plan_col_idx);
-        stored_cols_data_types_.emplace_back(input_descriptor_->type(plan_col_idx));
+int64_t AggNode::GroupStateBytes() {
+  // Walking the groups takes time linear in their number, so the heap bytes of the UDAs are only
+  // summed every this many batches, and scaled by the number of groups in between.
+  constexpr int64_t kBatchesPerHeapBytesWalk = 16;
+
+  size_t num_groups = NumGroups();
+  if (udas_have_heap_bytes_ && num_groups > 0 &&
+      batches_since_heap_bytes_walk_++ % kBatchesPerHeapBytesWalk == 0) {
+    size_t heap_bytes = 0;
+    auto add_heap_bytes = [&heap_bytes](const AggHashValue* val) {
+      for (const auto& uda_info : val->udas) {
+        heap_bytes += uda_info.def->HeapBytes(uda_info.uda.get());
       }
-      return 0;
-    });
-
-    walker.OnAggregateExpression(
-        [&](const plan::AggregateExpression&, const std::vector<int>&) -> int { return 0; });
-
-    PL_RETURN_IF_ERROR(walker.Walk(*expr));
+    };
+    if (use_fixed_size_keys_) {
+      fixed_size_agg_hash_map_->ForEach(
+          [&](const types::FixedSizeValueUnion*, AggHashValue** val) { add_heap_bytes(*val); });
+    } else {
+      for (const auto& [groups_rt, val] : agg_hash_map_) {
+        add_heap_bytes(val);
+      }
+    }
+    uda_heap_bytes_per_group_ = heap_bytes / num_groups;
   }
-  return Status::OK();
-}
 
-AggHashValue* AggNode::CreateAggHashValue(ExecState* exec_state) {
-  auto* val = udas_pool_.Add(new AggHashValue);
-  PL_CHECK_OK(CreateUDAInfoValues(&(val->udas), exec_state));
-  for (const auto& dt : stored_cols_data_types_) {
-    val->agg_cols.emplace_back(types::ColumnWrapper::Make(dt, 0));
+  size_t bytes_per_group = sizeof(RowTuple) + sizeof(AggHashValue) +
+                           group_data_types_.size() * sizeof(types::FixedSizeValueUnion) +
+                           std::max<int64_t>(uda_bytes_per_group_, 0) + uda_heap_bytes_per_group_;
+  int64_t dictionary_bytes = 0;
+  for (const auto& dict : group_dictionaries_) {
+    dictionary_bytes += dict == nullptr ? 0 : dict->bytes();
   }
-  return val;
+  return static_cast<int64_t>(num_groups * bytes_per_group) + dictionary_bytes;
 }
 
 Status AggNode::CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_state) {
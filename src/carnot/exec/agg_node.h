@@ -17,17 +17,23 @@
  */
 
 #pragma once
+
+#include <arrow/array/builder_base.h>
 #include <cstddef>
-#include <map>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/fixed_size_key_hash_map.h"
 #include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/exec/string_dictionary.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
@@ -54,7 +60,13 @@ struct UDAInfo {
 
 struct AggHashValue {
   std::vector<UDAInfo> udas;
-  std::vector<types::SharedColumnWrapper> agg_cols;
+};
+
+// A group of the hash map, keyed by either a fixed size key or a RowTuple.
+struct GroupRef {
+  const types::FixedSizeValueUnion* key;
+  RowTuple* rt;
+  AggHashValue* val;
 };
 
 struct GroupArgs {
@@ -65,11 +77,23 @@ struct GroupArgs {
 
 class AggNode : public ProcessingNode {
   using AggHashMap = AbslRowTupleHashMap<AggHashValue*>;
+  using FixedSizeAggHashMap = FixedSizeKeyHashMap<AggHashValue*>;
 
  public:
   AggNode() = default;
   virtual ~AggNode() = default;
 
+  /**
+   * Merges the aggregate state accumulated by another AggNode for the same plan operator into this
+   * node. Morsel-driven execution uses this to fold the state of the worker pipelines into the main
+   * pipeline before it emits. Group keys of the other node are reused rather than copied, so it
+   * must not be closed before this node has emitted its results.
+   * @param exec_state The execution state.
+   * @param other The node to merge from.
+   * @return The status of the merge.
+   */
+  Status MergeFrom(ExecState* exec_state, AggNode* other);
+
  protected:
   Status AggregateGroupByNone(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status AggregateGroupByClause(ExecState* exec_state, const table_store::schema::RowBatch& rb);
@@ -92,10 +116,24 @@ class AggNode : public ProcessingNode {
   // When we see a new window, we need to be able to clear the aggregate state.
   Status ClearAggState(ExecState* exec_state);
 
+  Status InitTimeWindow();
+  // Adds the rows of a batch to the group by aggregate state, without emitting anything.
+  Status AccumulateGroupByClause(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Aggregates a batch into every time window that its rows fall in and emits the windows that
+  // the input has moved past.
+  Status AggregateTimeWindows(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Emits and drops the groups of every window that ends at or before the watermark, or of all
+  // windows when the input has reached eos. Aggregates that merge partial results only emit
+  // their windows at eos.
+  Status EmitClosedWindows(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  int64_t WindowStartOfKey(const types::FixedSizeValueUnion* key) const;
+  void ReleaseWindowedGroup(RowTuple* groups_rt, AggHashValue* val);
+
   Status EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UDAInfo& uda_info,
                                           plan::AggregateExpression* expr,
                                           const table_store::schema::RowBatch& rb);
-  Status EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val);
+  // Updates the UDAs of the groups of the rows in group_args_chunk_ with the values of the batch.
+  Status UpdateGroupsForBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   StatusOr<types::DataType> GetTypeOfDep(const plan::ScalarExpression& expr) const;
 
   // Store information about aggregate node from the query planner.
@@ -110,42 +148,109 @@ class AggNode : public ProcessingNode {
 
   // Variables specific to GroupBy Agg.
 
-  // As the row batches come in we insert the correct values into the hash map based
-  // on the group by key. To do this we need to keep track of which input columns we need
-  // to eventually run the agg funcs.
-  // 1. We need to keep a mapping from plan columns to stored columns.
-  std::map<int64_t, int64_t> plan_cols_to_stored_map_;
-  // 2. The reverse mapping from stored_cols to plan cols. This can be a regular vector,
-  // since the stored column indices are contiguous.
-  std::vector<int64_t> stored_cols_to_plan_idx_;
-  // 3. The data type of the stored colums, by the index they are stored at.
-  std::vector<types::DataType> stored_cols_data_types_;
-
-  ObjectPool group_args_pool_{"group_args_pool"};
-  ObjectPool udas_pool_{"udas_pool"};
+  TypedObjectPool<RowTuple> group_args_pool_;
+  TypedObjectPool<AggHashValue> udas_pool_;
 
   std::vector<types::DataType> group_data_types_;
   std::vector<types::DataType> value_data_types_;
+  // The input column that each group is read from. A time windowed aggregate reads its window
+  // group from a column holding the window start, appended after the input columns.
+  std::vector<int64_t> group_col_idxs_;
 
   // We construct row-tuples in a batch, chunked by each column.
   // This vector holds pointers to the row_tuples which are managed by the group_args_pool_.
 
   std::vector<GroupArgs> group_args_chunk_;
+  // The UDA of each row's group for the value being updated, so a value expression updates every
+  // group of a batch from the input columns in a single call.
+  std::vector<udf::UDA*> batch_udas_;
+
+  // When all of the group columns are fixed size, the groups are keyed by FixedSizeAggHashMap
+  // instead of agg_hash_map_. The keys of a batch are extracted column by column into
+  // batch_keys_ (group_data_types_.size() values per row) and hashed in a separate pass, so
+  // no RowTuples are created. In this mode group_args_chunk_ is only used for the values.
+  // String groups are keyed by their codes in group_dictionaries_, which has an entry (null for
+  // the other types) per group.
+  bool use_fixed_size_keys_ = false;
+  std::unique_ptr<FixedSizeAggHashMap> fixed_size_agg_hash_map_;
+  std::vector<std::unique_ptr<StringDictionary>> group_dictionaries_;
+  std::vector<types::FixedSizeValueUnion> batch_keys_;
+  std::vector<uint64_t> batch_key_hashes_;
+  // The number of rows looked up in the group hash map, reported in the exec stats.
+  int64_t hash_table_lookups_ = 0;
+  // The bytes of the UDA instances of a group, and whether any of them allocate memory outside
+  // of the instance. Set when the first group is created.
+  int64_t uda_bytes_per_group_ = -1;
+  bool udas_have_heap_bytes_ = false;
+  // The average memory the UDAs of a group allocate outside of their instances, as of the last
+  // time the groups were walked to sum it up.
+  int64_t uda_heap_bytes_per_group_ = 0;
+  int64_t batches_since_heap_bytes_walk_ = 0;
   // END: Variables specific to GroupBy Agg.
 
-  // Creates a mapping between plan cols and stored cols (see above comment).
-  Status CreateColumnMapping();
+  // Variables specific to time windowed Agg.
+  bool time_windowed_ = false;
+  int64_t window_size_ns_ = 0;
+  int64_t window_slide_ns_ = 0;
+  // The index into groups of the window group, and the input column holding the row times.
+  size_t window_group_idx_ = 0;
+  int64_t window_time_col_idx_ = 0;
+  // The largest row time seen so far. Windows that end at or before it are emitted.
+  int64_t watermark_ = std::numeric_limits<int64_t>::min();
+  // Set when merging partial aggregates, whose windows are only emitted at eos.
+  bool close_windows_at_eos_ = false;
+  // The input descriptor with the window start column appended.
+  std::unique_ptr<table_store::schema::RowDescriptor> windowed_input_descriptor_;
+  // Groups are dropped as their windows close, so unlike the other aggregates their keys and
+  // values are owned here instead of by the pools, which only free anything on Close.
+  absl::flat_hash_map<AggHashValue*, std::unique_ptr<AggHashValue>> windowed_values_;
+  absl::flat_hash_map<RowTuple*, std::unique_ptr<RowTuple>> windowed_group_tuples_;
+  // END: Variables specific to time windowed Agg.
 
   Status ExtractRowTupleForBatch(const table_store::schema::RowBatch& rb);
   Status HashRowBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
-  Status EvaluatePartialAggregates(ExecState* exec_state, size_t num_records);
+  Status ExtractFixedSizeKeysForBatch(const table_store::schema::RowBatch& rb);
+  Status HashFixedSizeKeysForBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status ResetGroupArgs();
-  Status ConvertAggHashMapToRowBatch(ExecState* exec_state,
-                                     table_store::schema::RowBatch* output_rb);
+  // Finalizes the groups into row batches. Large maps are split into a batch per partition of
+  // groups, which are finalized in parallel.
+  StatusOr<std::vector<std::unique_ptr<table_store::schema::RowBatch>>>
+  ConvertAggHashMapToRowBatches(ExecState* exec_state);
+  Status FinalizeGroups(ExecState* exec_state, const GroupRef* begin, const GroupRef* end,
+                        table_store::schema::RowBatch* output_rb);
+  // Adds the finalized column of a value to the output, multiplied by the value's scale if the
+  // plan has one (for estimates over a sample of the rows).
+  Status AddValueColumn(size_t value_idx, const std::shared_ptr<arrow::Array>& values,
+                        table_store::schema::RowBatch* output_rb) const;
+  // Sends the finalized groups to the children, with the eow and eos of rb on the last batch.
+  Status EmitGroups(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Merges the UDAs of the second value of each pair into the first.
+  Status MergeAggHashValues(const std::vector<std::pair<AggHashValue*, AggHashValue*>>& vals);
+  Status FinalizeAggHashValue(ExecState* exec_state, AggHashValue* val,
+                              const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders);
+  size_t NumGroups() const {
+    return use_fixed_size_keys_ ? fixed_size_agg_hash_map_->size() : agg_hash_map_.size();
+  }
+  // Estimate of the memory held by the keys and UDA states of the groups, which are allocated
+  // outside of the node's memory pool.
+  int64_t GroupStateBytes();
+  void ClearGroupDictionaries() {
+    for (auto& dict : group_dictionaries_) {
+      if (dict != nullptr) {
+        dict->Clear();
+      }
+    }
+  }
 
   AggHashValue* CreateAggHashValue(ExecState* exec_state);
   RowTuple* CreateGroupArgsRowTuple() {
-    return group_args_pool_.Add(new RowTuple(&group_data_types_));
+    if (time_windowed_) {
+      auto rt = std::make_unique<RowTuple>(&group_data_types_);
+      RowTuple* rt_ptr = rt.get();
+      windowed_group_tuples_.emplace(rt_ptr, std::move(rt));
+      return rt_ptr;
+    }
+    return group_args_pool_.New(&group_data_types_);
   }
 
   Status CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_state);
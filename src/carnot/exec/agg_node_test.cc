@@ -20,6 +20,7 @@
 
 #include <algorithm>
 
+#include <absl/strings/substitute.h>
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -30,6 +31,9 @@
 #include "src/common/testing/testing.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 
+DECLARE_bool(carnot_agg_fixed_size_keys);
+DECLARE_bool(carnot_agg_dictionary_encode_strings);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -183,6 +187,38 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kTimeWindowAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 2
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "window"
+  value_names: "value1"
+  time_window {
+    group_index: 0
+    size_ns: 10
+    slide_ns: $0
+  }
+  $1
+})";
+
 constexpr char kSingleGroupNoValues[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -303,6 +339,67 @@ TEST_F(AggNodeTest, single_group_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, no_groups_blocking_scaled_values) {
+  std::string pbtxt(kBlockingNoGroupAgg);
+  pbtxt.insert(pbtxt.rfind('}'), "  value_scales: 2.5\n");
+  auto plan_node = PlanNodeFromPbtxt(pbtxt);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // 23 * 2.5, rounded.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({2, 5, 6, 8})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Int64Value>({Int64Value(58)})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_group_blocking_scaled_values) {
+  std::string pbtxt(kBlockingSingleGroupAgg);
+  pbtxt.insert(pbtxt.rfind('}'), "  value_scales: 0.5\n");
+  auto plan_node = PlanNodeFromPbtxt(pbtxt);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // The groups are left as is, only the values are scaled.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({1, 2, 2, 2, 1, 3})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
@@ -334,6 +431,40 @@ TEST_F(AggNodeTest, multiple_groups_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, multiple_groups_blocking_row_tuple_keys) {
+  // Same as multiple_groups_blocking, but with the groups keyed by RowTuples.
+  FLAGS_carnot_agg_fixed_size_keys = false;
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  FLAGS_carnot_agg_fixed_size_keys = true;
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 5, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 1, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Int64Value>({1, 1, 2, 5, 3})
+                          .AddColumn<types::Int64Value>({2, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 3, 1, 2, 6})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_with_string_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
@@ -366,6 +497,42 @@ TEST_F(AggNodeTest, multiple_groups_with_string_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, multiple_groups_with_string_blocking_row_tuple_keys) {
+  // Same as multiple_groups_with_string_blocking, but without dictionary encoding the strings, so
+  // the groups are keyed by RowTuples.
+  FLAGS_carnot_agg_dictionary_encode_strings = false;
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  FLAGS_carnot_agg_dictionary_encode_strings = true;
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({"abc", "def", "abc", "fgh"})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::StringValue>({"ijk", "abc", "abc", "def"})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::StringValue>({"abc", "def", "abc", "fgh", "ijk", "def"})
+                          .AddColumn<types::Int64Value>({2, 1, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 1, 6, 1, 1, 3})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, no_groups_windowed) {
   auto plan_node = PlanNodeFromPbtxt(kWindowedNoGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
@@ -450,6 +617,157 @@ TEST_F(AggNodeTest, single_group_windowed) {
       .Close();
 }
 
+TEST_F(AggNodeTest, tumbling_time_window) {
+  auto plan_node = PlanNodeFromPbtxt(absl::Substitute(kTimeWindowAgg, 0, ""));
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 5, 12, 14})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .AddColumn<types::Int64Value>({3, 1, 3, 8})
+                       .get(),
+                   0)
+      // Only the window starting at 0 has been passed by the input.
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Int64Value>({0})
+                          .AddColumn<types::Int64Value>({3})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({15, 25})
+                       .AddColumn<types::Int64Value>({4, 5})
+                       .AddColumn<types::Int64Value>({4, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({10, 20})
+                          .AddColumn<types::Int64Value>({8, 1})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, sliding_time_window) {
+  auto plan_node = PlanNodeFromPbtxt(absl::Substitute(kTimeWindowAgg, 5, ""));
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 7})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .get(),
+                   0)
+      // Each row falls in two windows. Only the one starting at -5 has closed.
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Int64Value>({-5})
+                          .AddColumn<types::Int64Value>({1})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({8})
+                       .AddColumn<types::Int64Value>({3})
+                       .AddColumn<types::Int64Value>({3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({12})
+                       .AddColumn<types::Int64Value>({4})
+                       .AddColumn<types::Int64Value>({5})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({0, 5, 10})
+                          .AddColumn<types::Int64Value>({6, 9, 4})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, tumbling_time_window_time_column) {
+  auto plan_node = PlanNodeFromPbtxt(absl::Substitute(kTimeWindowAgg, 0, ""));
+  RowDescriptor input_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::TIME64NS, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({1, 5, 12})
+                       .AddColumn<types::Int64Value>({2, 3, 3})
+                       .AddColumn<types::Int64Value>({3, 1, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Time64NSValue>({0})
+                          .AddColumn<types::Int64Value>({3})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Time64NSValue>({15})
+                       .AddColumn<types::Int64Value>({4})
+                       .AddColumn<types::Int64Value>({4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Time64NSValue>({10})
+                          .AddColumn<types::Int64Value>({7})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, merge_time_window_emits_at_eos) {
+  // Partial results from different agents don't share a watermark, so rows of a window can
+  // arrive after rows of later windows.
+  auto plan_node = PlanNodeFromPbtxt(
+      absl::Substitute(kTimeWindowAgg, 0, "partial_agg: false\n  finalize_results: true"));
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 25})
+                       .AddColumn<types::Int64Value>({2, 5})
+                       .AddColumn<types::Int64Value>({3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({5, 12})
+                       .AddColumn<types::Int64Value>({3, 3})
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({2})
+                       .AddColumn<types::Int64Value>({4})
+                       .AddColumn<types::Int64Value>({4})
+                       .get(),
+                   0)
+      // The late row at time 2 is merged into the window starting at 0.
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({0, 10, 20})
+                          .AddColumn<types::Int64Value>({7, 3, 1})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, no_aggregate_expressions) {
   auto plan_node = PlanNodeFromPbtxt(kSingleGroupNoValues);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
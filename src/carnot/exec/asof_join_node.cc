@@ -0,0 +1,312 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/asof_join_node.h"
+
+#include <arrow/array.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <absl/strings/str_join.h>
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/exec/equijoin_node.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/udf_wrapper.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+void ExtractIntoRowTupleForRow(const RowBatch& rb, const std::vector<int64_t>& col_idxs,
+                               const std::vector<types::DataType>& data_types, int64_t row,
+                               RowTuple* rt) {
+  for (size_t i = 0; i < col_idxs.size(); ++i) {
+    auto* col = rb.ColumnAt(col_idxs[i]).get();
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(rt, col, i, row);
+    PL_SWITCH_FOREACH_DATATYPE(data_types[i], TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+template <types::DataType DT>
+Status AppendArrowValue(arrow::ArrayBuilder* builder, arrow::Array* col, int64_t row) {
+  return table_store::schema::CopyValue<DT>(builder, types::GetValueFromArrowArray<DT>(col, row));
+}
+
+template <types::DataType DT>
+Status AppendRowTupleValue(arrow::ArrayBuilder* builder, const RowTuple& rt, size_t idx) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(rt.GetValue<ValueType>(idx)));
+}
+
+template <types::DataType DT>
+Status AppendDefaultValue(arrow::ArrayBuilder* builder) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  ValueType zeroval;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(zeroval));
+}
+
+int64_t TimeAt(const RowBatch& rb, int64_t col_idx, int64_t row) {
+  // INT64 and TIME64NS columns are both stored as int64 arrays.
+  return static_cast<arrow::Int64Array*>(rb.ColumnAt(col_idx).get())->Value(row);
+}
+
+bool IsTimeType(types::DataType type) {
+  return type == types::DataType::INT64 || type == types::DataType::TIME64NS;
+}
+
+}  // namespace
+
+std::string AsofJoinNode::DebugStringImpl() {
+  return absl::Substitute("Exec::AsofJoinNode<$0>",
+                          absl::StrJoin(plan_node_->column_names(), ","));
+}
+
+Status AsofJoinNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::JOIN_OPERATOR);
+  if (input_descriptors_.size() != 2) {
+    return error::InvalidArgument("Join operator expects a two input relations, got $0",
+                                  input_descriptors_.size());
+  }
+  const auto* join_plan_node = static_cast<const plan::JoinOperator*>(&plan_node);
+  plan_node_ = std::make_unique<plan::JoinOperator>(*join_plan_node);
+  DCHECK_EQ(plan_node_->type(), planpb::JoinOperator::ASOF);
+  output_rows_per_batch_ =
+      plan_node_->rows_per_batch() == 0 ? kDefaultJoinRowBatchSize : plan_node_->rows_per_batch();
+
+  const auto& asof_condition = plan_node_->asof_condition();
+  left_time_col_idx_ = asof_condition.left_time_column_index();
+  right_time_col_idx_ = asof_condition.right_time_column_index();
+  tolerance_ns_ = asof_condition.tolerance_ns();
+  if (tolerance_ns_ < 0) {
+    return error::InvalidArgument("ASOF join tolerance must not be negative, got $0",
+                                  tolerance_ns_);
+  }
+  if (left_time_col_idx_ >= static_cast<int64_t>(input_descriptors_[0].size()) ||
+      right_time_col_idx_ >= static_cast<int64_t>(input_descriptors_[1].size())) {
+    return error::InvalidArgument("ASOF join time columns $0 and $1 are out of range",
+                                  left_time_col_idx_, right_time_col_idx_);
+  }
+  if (!IsTimeType(input_descriptors_[0].type(left_time_col_idx_)) ||
+      !IsTimeType(input_descriptors_[1].type(right_time_col_idx_))) {
+    return error::InvalidArgument("ASOF joins must match on INT64 or TIME64NS columns");
+  }
+
+  for (const auto& eq_condition : plan_node_->equality_conditions()) {
+    int64_t left_index = eq_condition.left_column_index();
+    int64_t right_index = eq_condition.right_column_index();
+    if (input_descriptors_[0].type(left_index) != input_descriptors_[1].type(right_index)) {
+      return error::InvalidArgument("ASOF join keys $0 and $1 have different types", left_index,
+                                    right_index);
+    }
+    key_data_types_.push_back(input_descriptors_[0].type(left_index));
+    left_key_col_idxs_.push_back(left_index);
+    right_key_col_idxs_.push_back(right_index);
+  }
+
+  for (const auto& output_col : plan_node_->output_columns()) {
+    OutputColumn col{static_cast<int64_t>(output_col.parent_index()),
+                     static_cast<int64_t>(output_col.column_index()), -1};
+    if (col.parent_index == 1) {
+      col.value_index = right_value_col_idxs_.size();
+      right_value_col_idxs_.push_back(col.input_index);
+      right_value_data_types_.push_back(input_descriptors_[1].type(col.input_index));
+    }
+    output_columns_.push_back(col);
+  }
+  return Status::OK();
+}
+
+Status AsofJoinNode::InitializeColumnBuilders() {
+  for (size_t i = 0; i < output_descriptor_->size(); ++i) {
+    column_builders_[i] = types::MakeArrowBuilder(output_descriptor_->type(i), mem_pool());
+    PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
+  }
+  return Status::OK();
+}
+
+Status AsofJoinNode::PrepareImpl(ExecState*) {
+  column_builders_.resize(output_descriptor_->size());
+  lookup_key_ = std::make_unique<RowTuple>(&key_data_types_);
+  return InitializeColumnBuilders();
+}
+
+Status AsofJoinNode::OpenImpl(ExecState*) { return Status::OK(); }
+
+Status AsofJoinNode::CloseImpl(ExecState*) {
+  stats()->AddExtraMetric("right_keys", latest_right_rows_.size());
+  stats()->AddExtraMetric("matched_rows", matched_rows_);
+  left_batches_.clear();
+  right_batches_.clear();
+  latest_right_rows_.clear();
+  row_tuple_pool_.Clear();
+  return Status::OK();
+}
+
+Status AsofJoinNode::CheckTimeOrder(const RowBatch& rb, size_t parent_index) {
+  int64_t time_col_idx = parent_index == 0 ? left_time_col_idx_ : right_time_col_idx_;
+  int64_t* watermark = parent_index == 0 ? &left_watermark_ : &right_watermark_;
+  for (int64_t row = 0; row < rb.num_rows(); ++row) {
+    int64_t time = TimeAt(rb, time_col_idx, row);
+    if (time < *watermark) {
+      // Inputs that merge several streams, like the results of many agents, aren't ordered.
+      return error::InvalidArgument(
+          "ASOF join requires its $0 input to be ordered by time, got $1 after $2",
+          parent_index == 0 ? "left" : "right", time, *watermark);
+    }
+    *watermark = time;
+  }
+  return Status::OK();
+}
+
+Status AsofJoinNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb,
+                                     size_t parent_index) {
+  PL_RETURN_IF_ERROR(CheckTimeOrder(rb, parent_index));
+  if (parent_index == 0) {
+    if (rb.num_rows() > 0) {
+      left_batches_.push_back(PendingBatch{rb, 0});
+    }
+    left_eos_ = rb.eos();
+  } else {
+    // The right rows are no longer needed once every left row is joined.
+    if (rb.num_rows() > 0 && !(left_eos_ && left_batches_.empty())) {
+      right_batches_.push_back(PendingBatch{rb, 0});
+    }
+    right_eos_ = rb.eos();
+  }
+
+  PL_RETURN_IF_ERROR(JoinReadyRows(exec_state));
+  if (left_eos_ && left_batches_.empty()) {
+    right_batches_.clear();
+    if (right_eos_) {
+      return FlushOutput(exec_state, /*eos*/ true);
+    }
+  }
+  return Status::OK();
+}
+
+Status AsofJoinNode::JoinReadyRows(ExecState* exec_state) {
+  while (!left_batches_.empty()) {
+    auto& left = left_batches_.front();
+    for (; left.next_row < left.rb.num_rows(); ++left.next_row) {
+      int64_t time = TimeAt(left.rb, left_time_col_idx_, left.next_row);
+      // Right rows at this time may still arrive until the right parent has moved past it.
+      if (!right_eos_ && right_watermark_ <= time) {
+        return Status::OK();
+      }
+      ApplyRightRowsUpTo(time);
+      PL_RETURN_IF_ERROR(AppendLeftRow(left.rb, left.next_row));
+      if (output_rows_ == output_rows_per_batch_) {
+        PL_RETURN_IF_ERROR(FlushOutput(exec_state, /*eos*/ false));
+      }
+    }
+    left_batches_.pop_front();
+  }
+  return Status::OK();
+}
+
+void AsofJoinNode::ApplyRightRowsUpTo(int64_t time) {
+  while (!right_batches_.empty()) {
+    auto& right = right_batches_.front();
+    for (; right.next_row < right.rb.num_rows(); ++right.next_row) {
+      if (TimeAt(right.rb, right_time_col_idx_, right.next_row) > time) {
+        return;
+      }
+      ApplyRightRow(right.rb, right.next_row);
+    }
+    right_batches_.pop_front();
+  }
+}
+
+void AsofJoinNode::ApplyRightRow(const RowBatch& rb, int64_t row) {
+  lookup_key_->Reset();
+  ExtractIntoRowTupleForRow(rb, right_key_col_idxs_, key_data_types_, row, lookup_key_.get());
+  RightRow* right_row = nullptr;
+  auto it = latest_right_rows_.find(lookup_key_.get());
+  if (it == latest_right_rows_.end()) {
+    RowTuple* key = row_tuple_pool_.New(&key_data_types_);
+    ExtractIntoRowTupleForRow(rb, right_key_col_idxs_, key_data_types_, row, key);
+    RowTuple* values = row_tuple_pool_.New(&right_value_data_types_);
+    right_row = &latest_right_rows_.emplace(key, RightRow{values, 0}).first->second;
+  } else {
+    right_row = &it->second;
+    right_row->values->Reset();
+  }
+  right_row->time = TimeAt(rb, right_time_col_idx_, row);
+  ExtractIntoRowTupleForRow(rb, right_value_col_idxs_, right_value_data_types_, row,
+                            right_row->values);
+}
+
+Status AsofJoinNode::AppendLeftRow(const RowBatch& rb, int64_t row) {
+  lookup_key_->Reset();
+  ExtractIntoRowTupleForRow(rb, left_key_col_idxs_, key_data_types_, row, lookup_key_.get());
+  auto it = latest_right_rows_.find(lookup_key_.get());
+  const RowTuple* right_values = nullptr;
+  if (it != latest_right_rows_.end() &&
+      (tolerance_ns_ == 0 ||
+       TimeAt(rb, left_time_col_idx_, row) - it->second.time <= tolerance_ns_)) {
+    right_values = it->second.values;
+  }
+  if (right_values != nullptr) {
+    ++matched_rows_;
+  }
+
+  for (size_t i = 0; i < output_columns_.size(); ++i) {
+    const auto& col = output_columns_[i];
+    auto* builder = column_builders_[i].get();
+    if (col.parent_index == 0) {
+      auto* input_col = rb.ColumnAt(col.input_index).get();
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendArrowValue<_dt_>(builder, input_col, row))
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
+#undef TYPE_CASE
+    } else if (right_values != nullptr) {
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendRowTupleValue<_dt_>(builder, *right_values, col.value_index))
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
+#undef TYPE_CASE
+    } else {
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendDefaultValue<_dt_>(builder))
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+  ++output_rows_;
+  return Status::OK();
+}
+
+Status AsofJoinNode::FlushOutput(ExecState* exec_state, bool eos) {
+  PL_ASSIGN_OR_RETURN(auto output_rb, RowBatch::FromColumnBuilders(*output_descriptor_,
+                                                                   /*eow*/ eos, eos,
+                                                                   &column_builders_));
+  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *output_rb));
+  output_rows_ = 0;
+  return InitializeColumnBuilders();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
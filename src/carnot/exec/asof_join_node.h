@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array/builder_base.h>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/common/memory/memory.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * AsofJoinNode runs ASOF joins: every row of the left parent is joined with the latest row of the
+ * right parent that has equal keys and whose time is at or before the left row's, and no more
+ * than the tolerance before it if there is one. Both parents must arrive in time order, so they
+ * are merged as they stream in, and an input that goes back in time fails the query instead of
+ * silently missing matches. Only the latest right row of each key is held, along with the
+ * batches of whichever parent is ahead of the other.
+ */
+class AsofJoinNode : public ProcessingNode {
+ public:
+  AsofJoinNode() = default;
+  virtual ~AsofJoinNode() = default;
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  // A buffered input batch, and the first of its rows that hasn't been joined or applied yet.
+  struct PendingBatch {
+    table_store::schema::RowBatch rb;
+    int64_t next_row;
+  };
+
+  // The output columns and the time of the latest right row of a key.
+  struct RightRow {
+    RowTuple* values;
+    int64_t time;
+  };
+
+  struct OutputColumn {
+    int64_t parent_index;
+    int64_t input_index;
+    // For right columns, the index of the column in the stored right rows.
+    int64_t value_index;
+  };
+
+  Status InitializeColumnBuilders();
+  // Returns an error if the rows of the batch go back in time, from the last row of the parent.
+  Status CheckTimeOrder(const table_store::schema::RowBatch& rb, size_t parent_index);
+  // Joins the left rows whose right rows have all arrived.
+  Status JoinReadyRows(ExecState* exec_state);
+  // Records the right rows at or before the given time as the latest of their keys.
+  void ApplyRightRowsUpTo(int64_t time);
+  void ApplyRightRow(const table_store::schema::RowBatch& rb, int64_t row);
+  Status AppendLeftRow(const table_store::schema::RowBatch& rb, int64_t row);
+  Status FlushOutput(ExecState* exec_state, bool eos);
+
+  std::unique_ptr<plan::JoinOperator> plan_node_;
+  int64_t output_rows_per_batch_;
+
+  int64_t left_time_col_idx_;
+  int64_t right_time_col_idx_;
+  // When positive, right rows further than this before a left row don't match it.
+  int64_t tolerance_ns_ = 0;
+  std::vector<int64_t> left_key_col_idxs_;
+  std::vector<int64_t> right_key_col_idxs_;
+  std::vector<types::DataType> key_data_types_;
+  // The right columns that are output, which are stored for the latest row of each key.
+  std::vector<int64_t> right_value_col_idxs_;
+  std::vector<types::DataType> right_value_data_types_;
+  std::vector<OutputColumn> output_columns_;
+
+  std::deque<PendingBatch> left_batches_;
+  std::deque<PendingBatch> right_batches_;
+  bool left_eos_ = false;
+  bool right_eos_ = false;
+  // The time of the last row received from each parent. Left rows up to the right parent's time
+  // can't get a later match.
+  int64_t left_watermark_ = std::numeric_limits<int64_t>::min();
+  int64_t right_watermark_ = std::numeric_limits<int64_t>::min();
+
+  AbslRowTupleHashMap<RightRow> latest_right_rows_;
+  TypedObjectPool<RowTuple> row_tuple_pool_;
+  // Holds the keys of the row that is being looked up.
+  std::unique_ptr<RowTuple> lookup_key_;
+
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
+  int64_t output_rows_ = 0;
+  // The number of left rows that found a right row, reported in the exec stats.
+  int64_t matched_rows_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/asof_join_node.h"
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+class AsofJoinNodeTest : public ::testing::Test {
+ public:
+  AsofJoinNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& pbtxt) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(planpb::testutils::kOperatorProtoTmpl, "JOIN_OPERATOR", "join_op", pbtxt),
+        &op_pb));
+    return plan::JoinOperator::FromProto(op_pb, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(AsofJoinNodeTest, latest_preceding_row_by_key) {
+  // Left: [time_:Time64Ns, upid:Int], right: [time_:Time64Ns, upid:Int, cpu:Float].
+  // Output: [time_, upid, cpu], joined on upid and the latest right time_ <= the left time_.
+  const char* proto = R"(
+    type: ASOF
+    equality_conditions {
+      left_column_index: 1
+      right_column_index: 1
+    }
+    asof_condition {
+      left_time_column_index: 0
+      right_time_column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 2
+    }
+    column_names: "time_"
+    column_names: "upid"
+    column_names: "cpu"
+    rows_per_batch: 10
+  )";
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  RowDescriptor left_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor right_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::FLOAT64});
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::FLOAT64});
+  auto tester = exec::ExecNodeTester<AsofJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {left_rd, right_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(right_rd, 3, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 20, 30})
+                       .AddColumn<types::Int64Value>({1, 2, 1})
+                       .AddColumn<types::Float64Value>({0.1, 0.2, 0.3})
+                       .get(),
+                   1, 0)
+      // The row at 35 waits for the right rows up to 35.
+      .ConsumeNext(RowBatchBuilder(left_rd, 3, false, false)
+                       .AddColumn<types::Time64NSValue>({15, 25, 35})
+                       .AddColumn<types::Int64Value>({1, 2, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(right_rd, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({35, 40})
+                       .AddColumn<types::Int64Value>({1, 1})
+                       .AddColumn<types::Float64Value>({0.35, 0.4})
+                       .get(),
+                   1, 0)
+      // upid 3 has no right rows, so it gets the default value.
+      .ConsumeNext(RowBatchBuilder(left_rd, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({50, 60})
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Time64NSValue>({15, 25, 35, 50, 60})
+                          .AddColumn<types::Int64Value>({1, 2, 1, 2, 3})
+                          .AddColumn<types::Float64Value>({0.1, 0.2, 0.35, 0.2, 0.0})
+                          .get())
+      .Close();
+}
+
+TEST_F(AsofJoinNodeTest, no_keys_and_full_batches) {
+  // Left: [time_:Time64Ns, val:Int], right: [time_:Time64Ns, rval:Int].
+  // Output: [time_, val, rval], joined on the latest right time_ <= the left time_.
+  const char* proto = R"(
+    type: ASOF
+    asof_condition {
+      left_time_column_index: 0
+      right_time_column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 1
+    }
+    column_names: "time_"
+    column_names: "val"
+    column_names: "rval"
+    rows_per_batch: 2
+  )";
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  RowDescriptor left_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor right_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<AsofJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {left_rd, right_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(left_rd, 3, true, true)
+                       .AddColumn<types::Time64NSValue>({5, 10, 20})
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(right_rd, 1, false, false)
+                       .AddColumn<types::Time64NSValue>({10})
+                       .AddColumn<types::Int64Value>({100})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(right_rd, 1, true, true)
+                       .AddColumn<types::Time64NSValue>({30})
+                       .AddColumn<types::Int64Value>({300})
+                       .get(),
+                   1, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Time64NSValue>({5, 10})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({0, 100})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Time64NSValue>({20})
+                          .AddColumn<types::Int64Value>({3})
+                          .AddColumn<types::Int64Value>({100})
+                          .get())
+      .Close();
+}
+
+constexpr char kNoKeysAsofJoin[] = R"(
+  type: ASOF
+  asof_condition {
+    left_time_column_index: 0
+    right_time_column_index: 0
+    tolerance_ns: $0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 0
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  column_names: "time_"
+  column_names: "rval"
+  rows_per_batch: 10
+)";
+
+TEST_F(AsofJoinNodeTest, tolerance) {
+  auto plan_node = PlanNodeFromPbtxt(absl::Substitute(kNoKeysAsofJoin, 5));
+  RowDescriptor left_rd({types::DataType::TIME64NS});
+  RowDescriptor right_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<AsofJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {left_rd, right_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(right_rd, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({10, 20})
+                       .AddColumn<types::Int64Value>({100, 200})
+                       .get(),
+                   1, 0)
+      // 17 is more than 5 after the right row at 10, so it doesn't match.
+      .ConsumeNext(RowBatchBuilder(left_rd, 4, true, true)
+                       .AddColumn<types::Time64NSValue>({12, 15, 17, 22})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Time64NSValue>({12, 15, 17, 22})
+                          .AddColumn<types::Int64Value>({100, 100, 0, 200})
+                          .get())
+      .Close();
+}
+
+TEST_F(AsofJoinNodeTest, interleaved_sources) {
+  // The right input merges two sources, as a union of the results of two agents would.
+  auto plan_node = PlanNodeFromPbtxt(absl::Substitute(kNoKeysAsofJoin, 0));
+  RowDescriptor left_rd({types::DataType::TIME64NS});
+  RowDescriptor right_rd({types::DataType::TIME64NS, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::TIME64NS, types::DataType::INT64});
+
+  {
+    // Merged in time order, every left row gets the latest row of either source.
+    auto tester = exec::ExecNodeTester<AsofJoinNode, plan::JoinOperator>(
+        *plan_node, output_rd, {left_rd, right_rd}, exec_state_.get());
+    tester
+        .ConsumeNext(RowBatchBuilder(right_rd, 2, false, false)
+                         .AddColumn<types::Time64NSValue>({10, 20})
+                         .AddColumn<types::Int64Value>({1, 2})
+                         .get(),
+                     1, 0)
+        .ConsumeNext(RowBatchBuilder(right_rd, 2, false, false)
+                         .AddColumn<types::Time64NSValue>({20, 30})
+                         .AddColumn<types::Int64Value>({102, 103})
+                         .get(),
+                     1, 0)
+        .ConsumeNext(RowBatchBuilder(left_rd, 3, true, true)
+                         .AddColumn<types::Time64NSValue>({15, 25, 35})
+                         .get(),
+                     0, 0)
+        .ConsumeNext(RowBatchBuilder(right_rd, 1, true, true)
+                         .AddColumn<types::Time64NSValue>({40})
+                         .AddColumn<types::Int64Value>({4})
+                         .get(),
+                     1, 1)
+        .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                            .AddColumn<types::Time64NSValue>({15, 25, 35})
+                            .AddColumn<types::Int64Value>({1, 102, 103})
+                            .get())
+        .Close();
+  }
+
+  // Batches of the second source that go back in time fail the join, instead of silently
+  // joining left rows before their matches arrive.
+  auto tester = exec::ExecNodeTester<AsofJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {left_rd, right_rd}, exec_state_.get());
+  tester.ConsumeNext(RowBatchBuilder(right_rd, 2, false, false)
+                         .AddColumn<types::Time64NSValue>({10, 30})
+                         .AddColumn<types::Int64Value>({1, 3})
+                         .get(),
+                     1, 0);
+  auto status = tester.node()->ConsumeNext(exec_state_.get(),
+                                           RowBatchBuilder(right_rd, 1, false, false)
+                                               .AddColumn<types::Time64NSValue>({20})
+                                               .AddColumn<types::Int64Value>({102})
+                                               .get(),
+                                           1);
+  ASSERT_NOT_OK(status);
+  EXPECT_THAT(status.msg(), ::testing::HasSubstr("right input to be ordered by time"));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
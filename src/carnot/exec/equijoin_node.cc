@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include <absl/strings/str_join.h>
@@ -61,9 +62,12 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
   output_rows_per_batch_ =
       plan_node_->rows_per_batch() == 0 ? kDefaultJoinRowBatchSize : plan_node_->rows_per_batch();
 
-  if (plan_node_->order_by_time() && plan_node_->time_column().parent_index() == 0) {
-    // Make the probe table the left table when we need to preserve the order of the left table in
-    // the output.
+  if (plan_node_->order_by_time()) {
+    // Make the probe table the table whose time order we need to preserve in the output.
+    probe_table_ = plan_node_->time_column().parent_index() == 0
+                       ? EquijoinNode::JoinInputTable::kLeftTable
+                       : EquijoinNode::JoinInputTable::kRightTable;
+  } else if (plan_node_->build_parent_index() == 1) {
     probe_table_ = EquijoinNode::JoinInputTable::kLeftTable;
   } else {
     probe_table_ = EquijoinNode::JoinInputTable::kRightTable;
@@ -118,7 +122,7 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
 Status EquijoinNode::InitializeColumnBuilders() {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     column_builders_[i] =
-        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+        MakeArrowBuilder(output_descriptor_->type(i), mem_pool());
     PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
   }
   return Status::OK();
@@ -133,11 +137,19 @@ Status EquijoinNode::PrepareImpl(ExecState* /*exec_state*/) {
 
 Status EquijoinNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
-Status EquijoinNode::CloseImpl(ExecState* /*exec_state*/) {
+Status EquijoinNode::CloseImpl(ExecState* exec_state) {
+  stats()->AddExtraMetric("build_keys", build_buffer_.size());
+  stats()->AddExtraMetric("build_load_factor", build_buffer_.load_factor());
+  stats()->AddExtraMetric("probe_lookups", probe_lookups_);
+  stats()->AddExtraMetric("probe_rows_filtered", probe_rows_filtered_);
   join_keys_chunk_.clear();
   build_buffer_.clear();
   probed_keys_.clear();
   key_values_pool_.Clear();
+  build_spill_files_.clear();
+  probe_spill_files_.clear();
+  exec_state->ReleaseMemory(reserved_bytes_);
+  reserved_bytes_ = 0;
   return Status::OK();
 }
 
@@ -155,7 +167,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   // Reset the row tuples
   for (auto& rt : join_keys_chunk_) {
     if (rt == nullptr) {
-      rt = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      rt = key_values_pool_.New(&key_data_types_);
     } else {
       rt->Reset();
     }
@@ -167,7 +179,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
     int prev_size = join_keys_chunk_.size();
     join_keys_chunk_.reserve(num_rows);
     for (size_t idx = prev_size; idx < num_rows; ++idx) {
-      auto tuple_ptr = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      auto tuple_ptr = key_values_pool_.New(&key_data_types_);
       join_keys_chunk_.emplace_back(tuple_ptr);
     }
   }
@@ -188,9 +200,10 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   return Status::OK();
 }
 
-std::vector<types::SharedColumnWrapper>* CreateWrapper(ObjectPool* pool,
-                                                       const std::vector<types::DataType>& types) {
-  auto ptr = pool->Add(new std::vector<types::SharedColumnWrapper>(types.size()));
+std::vector<types::SharedColumnWrapper>* CreateWrapper(
+    TypedObjectPool<std::vector<types::SharedColumnWrapper>>* pool,
+    const std::vector<types::DataType>& types) {
+  auto ptr = pool->New(types.size());
   for (size_t col_idx = 0; col_idx < types.size(); ++col_idx) {
     (*ptr)[col_idx] = types::ColumnWrapper::Make(types[col_idx], 0);
   }
@@ -235,6 +248,9 @@ Status EquijoinNode::HashRowBatch(const table_store::schema::RowBatch& rb) {
     }
   }
 
+  // The build buffer holds a copy of the batch's values, plus the key tuple of every row.
+  build_state_bytes_ += rb.NumBytes() + rb.num_rows() * static_cast<int64_t>(sizeof(RowTuple));
+  mem_pool()->SetExternalBytes(build_state_bytes_);
   return Status::OK();
 }
 
@@ -260,6 +276,24 @@ Status AppendColumnDefaultValue(arrow::ArrayBuilder* output_builder, size_t num_
   return Status::OK();
 }
 
+template <types::DataType DT>
+Status AppendRowsFromArrow(arrow::ArrayBuilder* output_builder, arrow::Array* input_col,
+                           const std::vector<int64_t>& rows) {
+  for (auto row_idx : rows) {
+    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<DT>(
+        output_builder, types::GetValueFromArrowArray<DT>(input_col, row_idx)));
+  }
+  return Status::OK();
+}
+
+template <types::DataType DT>
+Status AppendRowTupleValueRepeated(arrow::ArrayBuilder* output_builder, RowTuple* rt,
+                                   size_t rt_idx, size_t num_times) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  return table_store::schema::CopyValueRepeated<DT>(
+      output_builder, udf::UnWrap(rt->GetValue<ValueType>(rt_idx)), num_times);
+}
+
 // Create a new output row batch from the column builders, and flush the pending row batch.
 // We hold on to a pending row batch because it is difficult to know a priori whether a given
 // output batch will be eos/eow.
@@ -276,6 +310,11 @@ Status EquijoinNode::NextOutputBatch(ExecState* exec_state) {
 }
 
 Status EquijoinNode::FlushChunkedRows(ExecState* exec_state) {
+  PL_RETURN_IF_ERROR(AppendChunkedRows());
+  return NextOutputBatch(exec_state);
+}
+
+Status EquijoinNode::AppendChunkedRows() {
   for (size_t col = 0; col < build_spec_.output_col_indices.size(); ++col) {
     for (const auto& chunk : chunks_) {
       auto output_idx = build_spec_.output_col_indices[col];
@@ -321,7 +360,7 @@ Status EquijoinNode::FlushChunkedRows(ExecState* exec_state) {
   std::vector<EquijoinNode::OutputChunk> new_chunks(0);
   std::swap(chunks_, new_chunks);
   queued_rows_ = 0;
-  return NextOutputBatch(exec_state);
+  return Status::OK();
 }
 
 Status EquijoinNode::MatchBuildValuesAndFlush(ExecState* exec_state,
@@ -357,7 +396,13 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
     probe_wrappers_chunk_.resize(rb.num_rows());
   }
 
+  probe_lookups_ += rb.num_rows();
   for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    if (!BuildKeyFilterMayContain(*join_keys_chunk_[row_idx])) {
+      ++probe_rows_filtered_;
+      probe_wrappers_chunk_[row_idx] = nullptr;
+      continue;
+    }
     auto it = build_buffer_.find(join_keys_chunk_[row_idx]);
     if (it != build_buffer_.end()) {
       probe_wrappers_chunk_[row_idx] = it->second;
@@ -395,7 +440,7 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
   return Status::OK();
 }
 
-Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
+Status EquijoinNode::QueueUnmatchedBuildRows(ExecState* exec_state) {
   for (auto it = build_buffer_.begin(); it != build_buffer_.end(); ++it) {
     if (probed_keys_.find(it->first) != probed_keys_.end()) {
       continue;
@@ -403,6 +448,11 @@ Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
     PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, it->second, nullptr, 0,
                                                 build_buffer_rows_[it->first]));
   }
+  return Status::OK();
+}
+
+Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
+  PL_RETURN_IF_ERROR(QueueUnmatchedBuildRows(exec_state));
 
   if (queued_rows_ > 0) {
     PL_RETURN_IF_ERROR(FlushChunkedRows(exec_state));
@@ -416,10 +466,20 @@ Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
     build_eos_ = true;
   }
 
+  if (!spilling_ && !ReserveMemory(exec_state, rb.NumBytes())) {
+    PL_RETURN_IF_ERROR(StartSpilling(exec_state));
+  }
+  if (spilling_) {
+    PL_RETURN_IF_ERROR(SpillBatch(rb, /* is_probe */ false));
+    filter_probe_spills_ = build_eos_ && !probe_spec_.emit_unmatched_rows;
+    return Status::OK();
+  }
+
   PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, false));
   PL_RETURN_IF_ERROR(HashRowBatch(rb));
 
   if (build_eos_) {
+    PL_RETURN_IF_ERROR(FilterBuildKeys());
     while (probe_batches_.size()) {
       PL_RETURN_IF_ERROR(DoProbe(exec_state, probe_batches_.front()));
       probe_batches_.pop();
@@ -430,6 +490,15 @@ Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
 
 Status EquijoinNode::ConsumeProbeBatch(ExecState* exec_state,
                                        const table_store::schema::RowBatch& rb) {
+  if (!spilling_ && !build_eos_ && !ReserveMemory(exec_state, rb.NumBytes())) {
+    PL_RETURN_IF_ERROR(StartSpilling(exec_state));
+  }
+  if (spilling_) {
+    if (rb.eos()) {
+      probe_eos_ = true;
+    }
+    return SpillBatch(rb, /* is_probe */ true);
+  }
   if (!build_eos_) {
     probe_batches_.push(rb);
     return Status::OK();
@@ -437,6 +506,264 @@ Status EquijoinNode::ConsumeProbeBatch(ExecState* exec_state,
   return DoProbe(exec_state, rb);
 }
 
+bool EquijoinNode::ReserveMemory(ExecState* exec_state, int64_t bytes) {
+  // Partitioning the inputs would lose the time order of the probe table, so ordered joins
+  // always stay in memory.
+  if (plan_node_->order_by_time()) {
+    return true;
+  }
+  if (!exec_state->TryReserveMemory(bytes)) {
+    return false;
+  }
+  reserved_bytes_ += bytes;
+  return true;
+}
+
+namespace {
+
+std::unique_ptr<RowDescriptor> SpillDescriptor(const std::vector<types::DataType>& key_types,
+                                               const std::vector<types::DataType>& col_types) {
+  std::vector<types::DataType> types(key_types);
+  types.insert(types.end(), col_types.begin(), col_types.end());
+  return std::make_unique<RowDescriptor>(types);
+}
+
+StatusOr<std::vector<std::unique_ptr<arrow::ArrayBuilder>>> MakeSpillBuilders(
+    const RowDescriptor& desc, int64_t num_rows) {
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  for (size_t i = 0; i < desc.size(); ++i) {
+    builders.push_back(MakeArrowBuilder(desc.type(i), arrow::default_memory_pool()));
+    PL_RETURN_IF_ERROR(builders.back()->Reserve(num_rows));
+  }
+  return builders;
+}
+
+size_t SpillPartition(RowTuple* rt) { return rt->Hash() % kNumJoinSpillPartitions; }
+
+// The bloom filter is keyed on the bytes of the RowTuple hash, which covers every key type.
+std::string_view HashBytes(const size_t& hash) {
+  return std::string_view(reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+}  // namespace
+
+Status EquijoinNode::StartSpilling(ExecState* exec_state) {
+  DCHECK(!spilling_);
+  VLOG(1) << absl::Substitute("$0 exceeded the memory budget, spilling to disk.", DebugString());
+  build_spill_descriptor_ = SpillDescriptor(key_data_types_, build_spec_.input_col_types);
+  probe_spill_descriptor_ = SpillDescriptor(key_data_types_, probe_spec_.input_col_types);
+  for (size_t i = 0; i < kNumJoinSpillPartitions; ++i) {
+    PL_ASSIGN_OR_RETURN(auto build_file, RowBatchSpillFile::Create(exec_state->spill_dir()));
+    build_spill_files_.push_back(std::move(build_file));
+    PL_ASSIGN_OR_RETURN(auto probe_file, RowBatchSpillFile::Create(exec_state->spill_dir()));
+    probe_spill_files_.push_back(std::move(probe_file));
+  }
+  PL_ASSIGN_OR_RETURN(build_key_filter_, bloomfilter::XXHash64BloomFilter::Create(
+                                              kJoinKeyFilterMaxEntries, kJoinKeyFilterErrorRate));
+  spilling_ = true;
+
+  PL_RETURN_IF_ERROR(SpillBuildBuffer());
+  while (probe_batches_.size()) {
+    PL_RETURN_IF_ERROR(SpillBatch(probe_batches_.front(), /* is_probe */ true));
+    probe_batches_.pop();
+  }
+  ResetBuildState();
+  exec_state->ReleaseMemory(reserved_bytes_);
+  reserved_bytes_ = 0;
+  return Status::OK();
+}
+
+Status EquijoinNode::SpillBuildBuffer() {
+  size_t num_keys = key_data_types_.size();
+  std::vector<std::vector<std::unique_ptr<arrow::ArrayBuilder>>> builders(
+      kNumJoinSpillPartitions);
+  for (auto& partition_builders : builders) {
+    PL_ASSIGN_OR_RETURN(partition_builders,
+                        MakeSpillBuilders(*build_spill_descriptor_, output_rows_per_batch_));
+  }
+  auto write_partition = [&](size_t partition) -> Status {
+    PL_ASSIGN_OR_RETURN(auto rb, RowBatch::FromColumnBuilders(*build_spill_descriptor_, false,
+                                                              false, &builders[partition]));
+    PL_RETURN_IF_ERROR(build_spill_files_[partition]->Write(*rb));
+    PL_ASSIGN_OR_RETURN(builders[partition],
+                        MakeSpillBuilders(*build_spill_descriptor_, output_rows_per_batch_));
+    return Status::OK();
+  };
+
+  for (const auto& [rt, wrappers] : build_buffer_) {
+    auto num_rows = build_buffer_rows_[rt];
+    auto partition = SpillPartition(rt);
+    AddBuildKeyToFilter(*rt);
+    auto& partition_builders = builders[partition];
+    for (size_t i = 0; i < num_keys; ++i) {
+      auto builder = partition_builders[i].get();
+      PL_RETURN_IF_ERROR(builder->Reserve(num_rows));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendRowTupleValueRepeated<_dt_>(builder, rt, i, num_rows))
+      PL_SWITCH_FOREACH_DATATYPE(key_data_types_[i], TYPE_CASE);
+#undef TYPE_CASE
+    }
+    for (size_t i = 0; i < build_spec_.input_col_types.size(); ++i) {
+      auto builder = partition_builders[num_keys + i].get();
+      PL_RETURN_IF_ERROR(builder->Reserve(num_rows));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendValuesFromWrapper<_dt_>(builder, wrappers->at(i), 0, num_rows))
+      PL_SWITCH_FOREACH_DATATYPE(build_spec_.input_col_types[i], TYPE_CASE);
+#undef TYPE_CASE
+    }
+    if (partition_builders[0]->length() >= output_rows_per_batch_) {
+      PL_RETURN_IF_ERROR(write_partition(partition));
+    }
+  }
+
+  for (size_t partition = 0; partition < kNumJoinSpillPartitions; ++partition) {
+    if (builders[partition][0]->length() > 0) {
+      PL_RETURN_IF_ERROR(write_partition(partition));
+    }
+  }
+  return Status::OK();
+}
+
+Status EquijoinNode::SpillBatch(const RowBatch& rb, bool is_probe) {
+  if (rb.num_rows() == 0) {
+    return Status::OK();
+  }
+  PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, is_probe));
+
+  std::vector<std::vector<int64_t>> partition_rows(kNumJoinSpillPartitions);
+  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    const auto& rt = join_keys_chunk_[row_idx];
+    if (!is_probe) {
+      AddBuildKeyToFilter(*rt);
+    } else if (filter_probe_spills_ && !BuildKeyFilterMayContain(*rt)) {
+      ++probe_rows_filtered_;
+      continue;
+    }
+    partition_rows[SpillPartition(rt)].push_back(row_idx);
+  }
+
+  const TableSpec& spec = is_probe ? probe_spec_ : build_spec_;
+  const RowDescriptor& spill_desc = is_probe ? *probe_spill_descriptor_ : *build_spill_descriptor_;
+  auto& spill_files = is_probe ? probe_spill_files_ : build_spill_files_;
+  // The spilled columns are the key columns followed by the input columns of the spec.
+  std::vector<int64_t> spill_col_indices(spec.key_indices);
+  spill_col_indices.insert(spill_col_indices.end(), spec.input_col_indices.begin(),
+                           spec.input_col_indices.end());
+
+  for (size_t partition = 0; partition < kNumJoinSpillPartitions; ++partition) {
+    const auto& rows = partition_rows[partition];
+    if (rows.empty()) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(auto builders, MakeSpillBuilders(spill_desc, rows.size()));
+    for (size_t i = 0; i < spill_col_indices.size(); ++i) {
+      auto input_col = rb.ColumnAt(spill_col_indices[i]).get();
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendRowsFromArrow<_dt_>(builders[i].get(), input_col, rows))
+      PL_SWITCH_FOREACH_DATATYPE(spill_desc.type(i), TYPE_CASE);
+#undef TYPE_CASE
+    }
+    PL_ASSIGN_OR_RETURN(auto spill_rb,
+                        RowBatch::FromColumnBuilders(spill_desc, false, false, &builders));
+    PL_RETURN_IF_ERROR(spill_files[partition]->Write(*spill_rb));
+  }
+  return Status::OK();
+}
+
+void EquijoinNode::AddBuildKeyToFilter(const RowTuple& rt) {
+  build_key_filter_->Insert(HashBytes(rt.Hash()));
+}
+
+bool EquijoinNode::BuildKeyFilterMayContain(const RowTuple& rt) const {
+  return build_key_filter_ == nullptr || build_key_filter_->Contains(HashBytes(rt.Hash()));
+}
+
+Status EquijoinNode::FilterBuildKeys() {
+  PL_ASSIGN_OR_RETURN(build_key_filter_,
+                      bloomfilter::XXHash64BloomFilter::Create(
+                          std::max<int64_t>(build_buffer_.size(), 1), kJoinKeyFilterErrorRate));
+  for (const auto& [rt, wrappers] : build_buffer_) {
+    AddBuildKeyToFilter(*rt);
+  }
+  return Status::OK();
+}
+
+void EquijoinNode::ResetBuildState() {
+  join_keys_chunk_.clear();
+  build_wrappers_chunk_.clear();
+  probe_wrappers_chunk_.clear();
+  build_buffer_.clear();
+  build_buffer_rows_.clear();
+  probed_keys_.clear();
+  key_values_pool_.Clear();
+  column_values_pool_.Clear();
+  build_state_bytes_ = 0;
+  mem_pool()->SetExternalBytes(0);
+}
+
+Status EquijoinNode::JoinSpilledPartitions(ExecState* exec_state) {
+  int64_t bytes_spilled = 0;
+  for (size_t partition = 0; partition < kNumJoinSpillPartitions; ++partition) {
+    bytes_spilled += build_spill_files_[partition]->bytes_written();
+    bytes_spilled += probe_spill_files_[partition]->bytes_written();
+  }
+  stats()->AddExtraMetric("bytes_spilled", bytes_spilled);
+  stats()->AddExtraMetric("spill_partitions", kNumJoinSpillPartitions);
+
+  // From here on the inputs are the spilled batches, so switch the specs to the spill layout.
+  auto to_spill_spec = [&](TableSpec* spec) {
+    size_t num_keys = spec->key_indices.size();
+    for (size_t i = 0; i < num_keys; ++i) {
+      spec->key_indices[i] = i;
+    }
+    for (size_t i = 0; i < spec->input_col_indices.size(); ++i) {
+      spec->input_col_indices[i] = num_keys + i;
+    }
+  };
+  to_spill_spec(&build_spec_);
+  to_spill_spec(&probe_spec_);
+
+  // DoProbe flushes partial output batches once the probe is done, which isn't the case until
+  // the last partition has been joined.
+  probe_eos_ = false;
+  for (size_t partition = 0; partition < kNumJoinSpillPartitions; ++partition) {
+    ResetBuildState();
+    auto build_file = build_spill_files_[partition].get();
+    PL_RETURN_IF_ERROR(build_file->StartReading());
+    while (true) {
+      PL_ASSIGN_OR_RETURN(auto rb, build_file->ReadNext());
+      if (rb == nullptr) {
+        break;
+      }
+      PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(*rb, false));
+      PL_RETURN_IF_ERROR(HashRowBatch(*rb));
+    }
+    PL_RETURN_IF_ERROR(FilterBuildKeys());
+
+    auto probe_file = probe_spill_files_[partition].get();
+    PL_RETURN_IF_ERROR(probe_file->StartReading());
+    while (true) {
+      PL_ASSIGN_OR_RETURN(auto rb, probe_file->ReadNext());
+      if (rb == nullptr) {
+        break;
+      }
+      PL_RETURN_IF_ERROR(DoProbe(exec_state, *rb));
+    }
+
+    if (build_spec_.emit_unmatched_rows) {
+      PL_RETURN_IF_ERROR(QueueUnmatchedBuildRows(exec_state));
+    }
+    // The queued rows point into this partition's build buffer, so copy them out before it is
+    // reset. They stay in the column builders, so output batches still fill up across partitions.
+    PL_RETURN_IF_ERROR(AppendChunkedRows());
+    build_spill_files_[partition].reset();
+    probe_spill_files_[partition].reset();
+  }
+  probe_eos_ = true;
+  ResetBuildState();
+  return Status::OK();
+}
+
 Status EquijoinNode::ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
                                      size_t parent_index) {
   if (IsProbeTable(parent_index)) {
@@ -448,7 +775,9 @@ Status EquijoinNode::ConsumeNextImpl(ExecState* exec_state, const table_store::s
   }
 
   if (build_eos_ && probe_eos_) {
-    if (build_spec_.emit_unmatched_rows) {
+    if (spilling_) {
+      PL_RETURN_IF_ERROR(JoinSpilledPartitions(exec_state));
+    } else if (build_spec_.emit_unmatched_rows) {
       PL_RETURN_IF_ERROR(EmitUnmatchedBuildRows(exec_state));
     }
 
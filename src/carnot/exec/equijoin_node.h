@@ -31,10 +31,12 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/exec/spill_file.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/common/memory/memory.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
@@ -44,6 +46,12 @@ namespace carnot {
 namespace exec {
 
 constexpr size_t kDefaultJoinRowBatchSize = 1024;
+// The number of partitions the inputs are split into once a join has to spill.
+constexpr size_t kNumJoinSpillPartitions = 16;
+// Sizing of the bloom filter over the build keys of a spilling join. Past this many distinct keys
+// the false positive rate goes up, which only means fewer probe rows get filtered.
+constexpr int64_t kJoinKeyFilterMaxEntries = 1 << 20;
+constexpr double kJoinKeyFilterErrorRate = 0.01;
 
 class EquijoinNode : public ProcessingNode {
   enum class JoinInputTable { kLeftTable, kRightTable };
@@ -77,6 +85,7 @@ class EquijoinNode : public ProcessingNode {
   Status InitializeColumnBuilders();
   bool IsProbeTable(size_t parent_index);
   Status FlushChunkedRows(ExecState* exec_state);
+  Status AppendChunkedRows();
   Status ExtractJoinKeysForBatch(const table_store::schema::RowBatch& rb, bool is_probe);
   Status HashRowBatch(const table_store::schema::RowBatch& rb);
 
@@ -86,10 +95,26 @@ class EquijoinNode : public ProcessingNode {
                                   std::shared_ptr<table_store::schema::RowBatch> probe_rb,
                                   int64_t probe_rb_row_idx, int64_t matching_bb_rows);
   Status EmitUnmatchedBuildRows(ExecState* exec_state);
+  Status QueueUnmatchedBuildRows(ExecState* exec_state);
   Status NextOutputBatch(ExecState* exec_state);
   Status ConsumeBuildBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status ConsumeProbeBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
 
+  // Grace hash join: once the query's memory budget is exhausted, the build rows seen so far and
+  // every input row after that are partitioned on the hash of their join keys and written to
+  // spill files. When both inputs are done, the partitions are joined one at a time.
+  bool ReserveMemory(ExecState* exec_state, int64_t bytes);
+  Status StartSpilling(ExecState* exec_state);
+  Status SpillBuildBuffer();
+  Status SpillBatch(const table_store::schema::RowBatch& rb, bool is_probe);
+  Status JoinSpilledPartitions(ExecState* exec_state);
+  void ResetBuildState();
+  void AddBuildKeyToFilter(const RowTuple& rt);
+  bool BuildKeyFilterMayContain(const RowTuple& rt) const;
+  // Replaces the bloom filter with one over the keys of the build buffer, once it holds the whole
+  // build input (or spill partition).
+  Status FilterBuildKeys();
+
   bool build_eos_ = false;
   bool probe_eos_ = false;
   // Note whether the left or the right table is the probe table.
@@ -130,8 +155,8 @@ class EquijoinNode : public ProcessingNode {
   // Column builders will flush a batch once they hit output_rows_per_batch_ rows.
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
   // Manages the RowTuples containing the keys for the join.
-  ObjectPool key_values_pool_{"equijoin_kv_pool"};
-  ObjectPool column_values_pool_{"equijoin_col_vals_pool"};
+  TypedObjectPool<RowTuple> key_values_pool_;
+  TypedObjectPool<std::vector<types::SharedColumnWrapper>> column_values_pool_;
 
   // Chunk of data to use when extracting join keys.
   std::vector<RowTuple*> join_keys_chunk_;
@@ -150,11 +175,31 @@ class EquijoinNode : public ProcessingNode {
   // For joins where the build_buffer_ needs to emit any non-probed rows at the end of the join,
   // keep track of which ones they were.
   AbslRowTupleHashSet probed_keys_;
+  // Estimate of the memory held by the build buffer, accounted to the node's memory pool.
+  int64_t build_state_bytes_ = 0;
+  // The number of probe rows looked up in the build buffer, reported in the exec stats.
+  int64_t probe_lookups_ = 0;
 
   // Handle on the most recent RowBatch (in case it's the final one).
   std::unique_ptr<table_store::schema::RowBatch> pending_output_batch_;
 
   std::unique_ptr<plan::JoinOperator> plan_node_;
+
+  // Grace hash join members.
+  // Bytes of buffered build/probe data reserved with the ExecState.
+  int64_t reserved_bytes_ = 0;
+  bool spilling_ = false;
+  // Spilled rows are stored as [keys..., input_col_indices columns...] of their table spec.
+  std::unique_ptr<table_store::schema::RowDescriptor> build_spill_descriptor_;
+  std::unique_ptr<table_store::schema::RowDescriptor> probe_spill_descriptor_;
+  std::vector<std::unique_ptr<RowBatchSpillFile>> build_spill_files_;
+  std::vector<std::unique_ptr<RowBatchSpillFile>> probe_spill_files_;
+  // Bloom filter over the join keys of every build row. Once the whole build input has been
+  // added, probe rows that can't match skip the lookup in the build buffer. While spilling, they
+  // are dropped instead of being spilled, unless the probe side has to emit its unmatched rows.
+  std::unique_ptr<bloomfilter::XXHash64BloomFilter> build_key_filter_;
+  bool filter_probe_spills_ = false;
+  int64_t probe_rows_filtered_ = 0;
 };
 
 }  // namespace exec
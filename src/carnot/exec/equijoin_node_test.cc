@@ -319,6 +319,277 @@ TEST_F(JoinNodeTest, unordered_full_outer_join) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, unordered_full_outer_join_spilled) {
+  // Same as unordered_full_outer_join, but with a memory budget that forces the join to spill.
+  const char* proto = R"(
+  type: FULL_OUTER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+  exec_state_->set_memory_budget_bytes(1);
+
+  // Left
+  RowDescriptor input_rd_0({types::DataType::TIME64NS, types::DataType::INT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::TIME64NS});
+  // Left[1], Right[1], Right[0]
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::TIME64NS, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({101, 200, 101, 200, 101})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({200, 200, 200, 300, 300})
+                       .AddColumn<types::Int64Value>({6, 8, 10, 12, 14})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Time64NSValue>({400, 500})
+                       .AddColumn<types::Int64Value>({16, 18})
+                       .get(),
+                   0, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, true, true)
+                       .AddColumn<types::Int64Value>({-10, -20, -30})
+                       .AddColumn<types::Time64NSValue>({110, 120, 101})
+                       .get(),
+                   1, 3)
+      // The partitions are joined one after the other, so the matched and unmatched rows are
+      // mixed together, but the output batches are still full.
+      .ExpectRowBatchesData(
+          RowBatchBuilder(output_rd, 14, true, true)
+              .AddColumn<types::Int64Value>({0, 0, 1, 3, 5, 2, 4, 6, 8, 10, 12, 14, 16, 18})
+              .AddColumn<types::Time64NSValue>({110, 120, 101, 101, 101, 0, 0, 0, 0, 0, 0, 0, 0, 0})
+              .AddColumn<types::Int64Value>({-10, -20, -30, -30, -30, 0, 0, 0, 0, 0, 0, 0, 0, 0})
+              .get(),
+          3)
+      .Close();
+  EXPECT_EQ(0, exec_state_->reserved_memory_bytes());
+}
+
+TEST_F(JoinNodeTest, unordered_inner_join_spilled_filters_probe_rows) {
+  // Left table input: [left_0:Int64, left_1:Float64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Float64, right_0:Int64]
+  // Inner join on left_0=right_1. The probe rows that come after the build is done are checked
+  // against the bloom filter of the build keys before being spilled.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+  exec_state_->set_memory_budget_bytes(1);
+
+  // Left
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::FLOAT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  // Left[1], Right[0]
+  RowDescriptor output_rd({types::DataType::FLOAT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Probe table, spilled before the build is done.
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .AddColumn<types::Int64Value>({1, 4, 2})
+                       .get(),
+                   1, 0)
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .AddColumn<types::Float64Value>({1.0, 2.0, 3.0})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({5})
+                       .AddColumn<types::Float64Value>({5.0})
+                       .get(),
+                   0, 0)
+      // Probe table, filtered before being spilled.
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 5, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({10, 20, 30, 40, 50})
+                       .AddColumn<types::Int64Value>({7, 3, 8, 5, 9})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatchesData(RowBatchBuilder(output_rd, 4, true, true)
+                                .AddColumn<types::Float64Value>({1.0, 2.0, 3.0, 5.0})
+                                .AddColumn<types::Int64Value>({1, 3, 20, 40})
+                                .get(),
+                            1)
+      .Close();
+  EXPECT_EQ(0, exec_state_->reserved_memory_bytes());
+}
+
+TEST_F(JoinNodeTest, unordered_inner_join_filters_probe_rows) {
+  // Left table input: [left_0:Int64, left_1:Float64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Float64, right_0:Int64]
+  // Inner join on left_0=right_1. The probe rows are checked against the bloom filter of the
+  // build keys before they are looked up, both when they were queued and when they come after the
+  // build is done.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+  // Left
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::FLOAT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  // Left[1], Right[0]
+  RowDescriptor output_rd({types::DataType::FLOAT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Probe table, queued until the build is done.
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .AddColumn<types::Int64Value>({1, 4, 2})
+                       .get(),
+                   1, 0)
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .AddColumn<types::Float64Value>({1.0, 2.0, 3.0})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({5})
+                       .AddColumn<types::Float64Value>({5.0})
+                       .get(),
+                   0, 0)
+      // Probe table, filtered as it is probed.
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 5, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({10, 20, 30, 40, 50})
+                       .AddColumn<types::Int64Value>({7, 3, 8, 5, 9})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatchesData(RowBatchBuilder(output_rd, 4, true, true)
+                                .AddColumn<types::Float64Value>({1.0, 2.0, 3.0, 5.0})
+                                .AddColumn<types::Int64Value>({1, 3, 20, 40})
+                                .get(),
+                            1)
+      .Close();
+  EXPECT_EQ(0, exec_state_->reserved_memory_bytes());
+}
+
+TEST_F(JoinNodeTest, unordered_inner_join_build_on_right) {
+  // Left table input: [left_0:Int64, left_1:Float64]
+  // Right table input: [right_0:Int64, right_1:Int64]
+  // Output table: [left_1:Float64, right_0:Int64]
+  // Inner join on left_0=right_1, with the right table buffered into the hash table.
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 1
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+  build_parent_index: 1
+)";
+
+  // Left
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::FLOAT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::INT64, types::DataType::INT64});
+  // Left[1], Right[0]
+  RowDescriptor output_rd({types::DataType::FLOAT64, types::DataType::INT64});
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      // Build table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({10, 20})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .get(),
+                   1, 0)
+      // Probe table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({2, 3, 1})
+                       .AddColumn<types::Float64Value>({2.0, 3.0, 1.0})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Float64Value>({2.0, 1.0})
+                          .AddColumn<types::Int64Value>({20, 10})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(JoinNodeTest, unordered_no_left_columns) {
   // All batches from build first
   // Left table input: [left_0:String, left_1:Int64]
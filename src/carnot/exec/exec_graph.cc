@@ -20,10 +20,14 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/asof_join_node.h"
 #include "src/carnot/exec/empty_source_node.h"
 #include "src/carnot/exec/equijoin_node.h"
 #include "src/carnot/exec/exec_node.h"
@@ -35,6 +39,7 @@
 #include "src/carnot/exec/map_node.h"
 #include "src/carnot/exec/memory_sink_node.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/top_k_node.h"
 #include "src/carnot/exec/udtf_source_node.h"
 #include "src/carnot/exec/union_node.h"
 #include "src/carnot/plan/operators.h"
@@ -46,18 +51,21 @@ namespace px {
 namespace carnot {
 namespace exec {
 
+using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
 Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
                             plan::PlanState* plan_state, ExecState* exec_state,
                             plan::PlanFragment* pf, bool collect_exec_node_stats,
-                            int32_t consecutive_generate_calls_per_source) {
+                            int32_t consecutive_generate_calls_per_source,
+                            int32_t max_parallelism) {
   plan_state_ = plan_state;
   schema_ = schema;
   pf_ = pf;
   exec_state_ = exec_state;
   collect_exec_node_stats_ = collect_exec_node_stats;
   consecutive_generate_calls_per_source_ = consecutive_generate_calls_per_source;
+  max_parallelism_ = max_parallelism;
 
   std::unordered_map<int64_t, ExecNode*> nodes;
   std::unordered_map<int64_t, RowDescriptor> descriptors;
@@ -81,10 +89,16 @@ Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
       .OnLimit([&](auto& node) {
         return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors);
       })
+      .OnTopK([&](auto& node) {
+        return OnOperatorImpl<plan::TopKOperator, TopKNode>(node, &descriptors);
+      })
       .OnUnion([&](auto& node) {
         return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors);
       })
       .OnJoin([&](auto& node) {
+        if (node.type() == planpb::JoinOperator::ASOF) {
+          return OnOperatorImpl<plan::JoinOperator, AsofJoinNode>(node, &descriptors);
+        }
         return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors);
       })
       .OnGRPCSource([&](auto& node) {
@@ -93,7 +107,7 @@ Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
         grpc_sources_.insert(node.id());
         return exec_state->grpc_router()->AddGRPCSourceNode(
             exec_state->query_id(), node.id(), static_cast<GRPCSourceNode*>(nodes_[node.id()]),
-            std::bind(&ExecutionGraph::Continue, this));
+            std::bind(&ExecutionGraph::ContinueSource, this, node.id()));
       })
       .OnGRPCSink([&](auto& node) {
         grpc_sinks_.insert(node.id());
@@ -108,6 +122,253 @@ Status ExecutionGraph::Init(std::shared_ptr<table_store::schema::Schema> schema,
       .Walk(pf_);
 }
 
+std::vector<int64_t> ExecutionGraph::OpsToBlockingAgg(int64_t op_id) {
+  const auto& ops = pf_->nodes();
+  std::vector<int64_t> pipeline;
+  while (true) {
+    // Only linear pipelines are split, so that each clone sees the whole input of every operator.
+    auto children = pf_->dag().DependenciesOf(op_id);
+    if (children.size() != 1) {
+      return {};
+    }
+    op_id = children[0];
+    if (pf_->dag().ParentsOf(op_id).size() != 1) {
+      return {};
+    }
+    pipeline.push_back(op_id);
+
+    const plan::Operator* op = ops.at(op_id).get();
+    switch (op->op_type()) {
+      case planpb::MAP_OPERATOR:
+      case planpb::FILTER_OPERATOR:
+        continue;
+      case planpb::AGGREGATE_OPERATOR: {
+        // Windowed aggregates emit on every window, which the merge can't preserve. Time windowed
+        // aggregates emit the windows they close, which clones have no children to send to.
+        const auto* agg_op = static_cast<const plan::AggregateOperator*>(op);
+        if (agg_op->windowed() || agg_op->has_time_window()) {
+          return {};
+        }
+        return pipeline;
+      }
+      default:
+        return {};
+    }
+  }
+}
+
+std::vector<int64_t> ExecutionGraph::MorselPipelineOps(int64_t source_id) {
+  const plan::Operator* src_op = pf_->nodes().at(source_id).get();
+  if (src_op->op_type() != planpb::MEMORY_SOURCE_OPERATOR ||
+      static_cast<const plan::MemorySourceOperator*>(src_op)->infinite_stream()) {
+    return {};
+  }
+  return OpsToBlockingAgg(source_id);
+}
+
+std::vector<int64_t> ExecutionGraph::TabletSources(int64_t union_id) {
+  const auto& ops = pf_->nodes();
+  const plan::Operator* op = ops.at(union_id).get();
+  if (op->op_type() != planpb::UNION_OPERATOR) {
+    return {};
+  }
+  const auto* union_op = static_cast<const plan::UnionOperator*>(op);
+  std::vector<int64_t> source_ids = pf_->dag().ParentsOf(union_id);
+  if (source_ids.size() < 2) {
+    return {};
+  }
+  for (size_t i = 0; i < source_ids.size(); ++i) {
+    const plan::Operator* src_op = ops.at(source_ids[i]).get();
+    if (src_op->op_type() != planpb::MEMORY_SOURCE_OPERATOR ||
+        pf_->dag().DependenciesOf(source_ids[i]).size() != 1) {
+      return {};
+    }
+    const auto* mem_src_op = static_cast<const plan::MemorySourceOperator*>(src_op);
+    if (mem_src_op->infinite_stream() || mem_src_op->Tablet().empty()) {
+      return {};
+    }
+    // The sources feed the operators after the union directly in the clones, so the union must
+    // pass their columns through unchanged.
+    const auto& mapping = union_op->column_mapping(i);
+    if (mapping.size() != union_op->column_names().size()) {
+      return {};
+    }
+    for (size_t col = 0; col < mapping.size(); ++col) {
+      if (mapping[col] != static_cast<int64_t>(col)) {
+        return {};
+      }
+    }
+  }
+  return source_ids;
+}
+
+StatusOr<ExecNode*> ExecutionGraph::CreateMorselClone(const plan::Operator& op) {
+  ExecNode* node = nullptr;
+  switch (op.op_type()) {
+    case planpb::MEMORY_SOURCE_OPERATOR:
+      node = pool_.Add(new MemorySourceNode());
+      break;
+    case planpb::MAP_OPERATOR:
+      node = pool_.Add(new MapNode());
+      break;
+    case planpb::FILTER_OPERATOR:
+      node = pool_.Add(new FilterNode());
+      break;
+    case planpb::AGGREGATE_OPERATOR:
+      node = pool_.Add(new AggNode());
+      break;
+    default:
+      return error::Internal("Operator $0 can't be cloned for morsel-driven execution.",
+                             op.DebugString());
+  }
+
+  // The relations of all operators were added to the schema when the graph was initialized.
+  std::vector<RowDescriptor> input_descriptors;
+  for (int64_t parent_id : pf_->dag().ParentsOf(op.id())) {
+    PL_ASSIGN_OR_RETURN(auto input_rel, schema_->GetRelation(parent_id));
+    input_descriptors.emplace_back(input_rel.col_types());
+  }
+  PL_ASSIGN_OR_RETURN(auto output_rel, schema_->GetRelation(op.id()));
+  PL_RETURN_IF_ERROR(node->Init(op, RowDescriptor(output_rel.col_types()), input_descriptors,
+                                collect_exec_node_stats_));
+  return node;
+}
+
+Status ExecutionGraph::AddMorselPipeline(const std::vector<int64_t>& source_ids,
+                                         const std::vector<int64_t>& op_ids) {
+  auto pipeline = std::make_unique<MorselPipeline>();
+  for (int64_t source_id : source_ids) {
+    pipeline->sources.push_back(static_cast<MemorySourceNode*>(nodes_.at(source_id)));
+  }
+  pipeline->agg = static_cast<AggNode*>(nodes_.at(op_ids.back()));
+
+  // The original pipeline is run by the main execution loop, so it counts towards parallelism.
+  int32_t num_workers = max_parallelism_ - 1;
+  for (int32_t worker = 0; worker < num_workers; ++worker) {
+    MorselPipeline::Clone clone;
+    for (size_t i = 0; i < source_ids.size(); ++i) {
+      // Every worker shares the range of a single source, but the tablets of a union are spread
+      // over the workers.
+      if (source_ids.size() > 1 && static_cast<int32_t>(i % num_workers) != worker) {
+        continue;
+      }
+      PL_ASSIGN_OR_RETURN(auto node, CreateMorselClone(*pf_->nodes().at(source_ids[i])));
+      clone.sources.emplace_back(i, static_cast<MemorySourceNode*>(node));
+    }
+    // There are more workers than tablets.
+    if (clone.sources.empty()) {
+      break;
+    }
+    for (int64_t op_id : op_ids) {
+      PL_ASSIGN_OR_RETURN(auto node, CreateMorselClone(*pf_->nodes().at(op_id)));
+      if (!clone.ops.empty()) {
+        clone.ops.back()->AddChild(node, 0);
+      }
+      clone.ops.push_back(node);
+    }
+    for (const auto& [i, source] : clone.sources) {
+      source->AddChild(clone.ops.front(), 0);
+    }
+    pipeline->clones.push_back(std::move(clone));
+  }
+  morsel_pipelines_.push_back(std::move(pipeline));
+  return Status::OK();
+}
+
+Status ExecutionGraph::PlanMorselPipelines() {
+  std::vector<int64_t> union_ids;
+  for (int64_t source_id : sources_) {
+    std::vector<int64_t> ops = MorselPipelineOps(source_id);
+    if (!ops.empty()) {
+      PL_RETURN_IF_ERROR(AddMorselPipeline({source_id}, ops));
+      continue;
+    }
+    auto children = pf_->dag().DependenciesOf(source_id);
+    if (children.size() == 1 &&
+        std::find(union_ids.begin(), union_ids.end(), children[0]) == union_ids.end()) {
+      union_ids.push_back(children[0]);
+    }
+  }
+
+  for (int64_t union_id : union_ids) {
+    std::vector<int64_t> source_ids = TabletSources(union_id);
+    if (source_ids.empty()) {
+      continue;
+    }
+    std::vector<int64_t> ops = OpsToBlockingAgg(union_id);
+    if (ops.empty()) {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(AddMorselPipeline(source_ids, ops));
+  }
+  return Status::OK();
+}
+
+void ExecutionGraph::StartMorselPipelines() {
+  for (auto& pipeline : morsel_pipelines_) {
+    MorselPipeline* p = pipeline.get();
+    for (MemorySourceNode* source : p->sources) {
+      p->queues.push_back(source->ShareBatchRange());
+      source->SetMorselsDrainedHook([this, p]() { return FinishMorselPipeline(p); });
+    }
+    p->worker_statuses.resize(p->clones.size());
+
+    for (size_t i = 0; i < p->clones.size(); ++i) {
+      for (const auto& [source_idx, source] : p->clones[i].sources) {
+        source->SetMorselQueue(p->queues[source_idx], /* sends_eos */ false);
+      }
+      p->workers.emplace_back([this, p, i]() {
+        for (const auto& [source_idx, source] : p->clones[i].sources) {
+          while (source->NextBatchReady()) {
+            auto s = source->GenerateNext(exec_state_);
+            if (!s.ok()) {
+              p->worker_statuses[i] = s;
+              // No point in finishing the scan if the query is going to fail.
+              for (const auto& queue : p->queues) {
+                queue->Cancel();
+              }
+              return;
+            }
+          }
+        }
+      });
+    }
+  }
+}
+
+Status ExecutionGraph::FinishMorselPipeline(MorselPipeline* pipeline) {
+  // The tablet sources of a union each drain their own range, the last one merges.
+  if (++pipeline->num_sources_drained < pipeline->sources.size()) {
+    return Status::OK();
+  }
+  for (auto& worker : pipeline->workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  for (const auto& s : pipeline->worker_statuses) {
+    PL_RETURN_IF_ERROR(s);
+  }
+  for (const auto& clone : pipeline->clones) {
+    PL_RETURN_IF_ERROR(
+        pipeline->agg->MergeFrom(exec_state_, static_cast<AggNode*>(clone.ops.back())));
+  }
+  return Status::OK();
+}
+
+void ExecutionGraph::StopMorselPipelines() {
+  for (auto& pipeline : morsel_pipelines_) {
+    for (const auto& queue : pipeline->queues) {
+      queue->Cancel();
+    }
+    for (auto& worker : pipeline->workers) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+}
+
 bool ExecutionGraph::YieldWithTimeout() {
   std::unique_lock<std::mutex> lock(execution_mutex_);
   if (continue_) {
@@ -126,6 +387,22 @@ void ExecutionGraph::Continue() {
   execution_cv_.notify_one();
 }
 
+void ExecutionGraph::ContinueSource(int64_t source_id) {
+  {
+    std::lock_guard<std::mutex> lock(execution_mutex_);
+    continue_ = true;
+    signalled_sources_.insert(source_id);
+  }
+  execution_cv_.notify_one();
+}
+
+absl::flat_hash_set<int64_t> ExecutionGraph::TakeSignalledSources() {
+  absl::flat_hash_set<int64_t> signalled_sources;
+  std::lock_guard<std::mutex> lock(execution_mutex_);
+  signalled_sources.swap(signalled_sources_);
+  return signalled_sources;
+}
+
 Status ExecutionGraph::CheckUpstreamGRPCConnectionHealth(GRPCSourceNode* source_node) {
   // Note: for the following logic, HasBatchesRemaining is equivalent to whether or not
   // the source node has sent a final end of stream row batch already or not.
@@ -171,10 +448,47 @@ Status ExecutionGraph::CheckDownstreamGRPCConnectionsHealth() {
   return Status::OK();
 }
 
+std::vector<int64_t> ExecutionGraph::DownstreamGRPCSinks(int64_t source_id) {
+  std::vector<int64_t> sink_ids;
+  absl::flat_hash_set<int64_t> visited;
+  std::vector<int64_t> to_visit{source_id};
+  while (!to_visit.empty()) {
+    int64_t op_id = to_visit.back();
+    to_visit.pop_back();
+    if (!visited.insert(op_id).second) {
+      continue;
+    }
+    auto children = pf_->dag().DependenciesOf(op_id);
+    if (!children.empty()) {
+      to_visit.insert(to_visit.end(), children.begin(), children.end());
+      continue;
+    }
+    if (!grpc_sinks_.contains(op_id)) {
+      return {};
+    }
+    sink_ids.push_back(op_id);
+  }
+  return sink_ids;
+}
+
+bool ExecutionGraph::GRPCSinksStopped(const std::vector<int64_t>& sink_ids) {
+  if (sink_ids.empty()) {
+    return false;
+  }
+  for (int64_t sink_id : sink_ids) {
+    if (!static_cast<GRPCSinkNode*>(nodes_.at(sink_id))->stopped_by_destination()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status ExecutionGraph::ExecuteSources() {
   absl::flat_hash_set<SourceNode*> running_sources;
 
   absl::flat_hash_map<SourceNode*, int64_t> source_to_id;
+  // The GRPC sinks fed by each source, used to stop the source once their destinations are done.
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> source_grpc_sinks;
   for (auto node_id : sources_) {
     auto node = nodes_.find(node_id);
     if (node == nodes_.end()) {
@@ -183,6 +497,7 @@ Status ExecutionGraph::ExecuteSources() {
     SourceNode* n = static_cast<SourceNode*>(node->second);
     running_sources.insert(n);
     source_to_id[n] = node_id;
+    source_grpc_sinks[node_id] = DownstreamGRPCSinks(node_id);
   }
 
   // Run all sources to completion, or exit if the query encounters an error.
@@ -203,23 +518,34 @@ Status ExecutionGraph::ExecuteSources() {
         }
       }
 
-      exec_state_->SetCurrentSource(source_to_id[source]);
+      int64_t source_id = source_to_id[source];
+      exec_state_->SetCurrentSource(source_id);
 
       for (auto i = 0; i < consecutive_generate_calls_per_source_; ++i) {
         if (!source->NextBatchReady() || !exec_state_->keep_running()) {
           break;
         }
         PL_RETURN_IF_ERROR(source->GenerateNext(exec_state_));
+        // The remote destinations (eg. a limit on Kelvin) may not need the rest of our results.
+        if (GRPCSinksStopped(source_grpc_sinks[source_id])) {
+          exec_state_->StopSource(source_id);
+        }
       }
 
       // keep_running will be set to false when a downstream limit for this particular
       // source (set in exec_state) has been reached.
       if (!source->HasBatchesRemaining() || !exec_state_->keep_running()) {
+        // Let the upstream sinks of a stopped GRPC source end their streams early.
+        if (!exec_state_->keep_running() && grpc_sources_.contains(source_id) &&
+            exec_state_->grpc_router() != nullptr) {
+          exec_state_->grpc_router()->StopGRPCSource(exec_state_->query_id(), source_id);
+        }
         completed_sources_execute_loop.insert(source);
         break;
       }
     }
     PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+    exec_state_->CheckMemoryBudget();
 
     // Flush all of the completed sources.
     for (SourceNode* source : completed_sources_execute_loop) {
@@ -244,20 +570,28 @@ Status ExecutionGraph::ExecuteSources() {
     while (wait_for_more_data) {
       auto timer = ElapsedTimer();
       timer.Start();
-      YieldWithTimeout();
+      bool timed_out = YieldWithTimeout();
       timer.Stop();
+      absl::flat_hash_set<int64_t> signalled_sources = TakeSignalledSources();
 
       absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
 
-      // This check is used for Memory sources that are waiting on data, because we don't currently
-      // have a mechanism to call Yield() on them while they are waiting.
-      // Once we introduce Carnot ETL, we can have the ingest phase of Carnot ETL call yield.
       for (SourceNode* source : running_sources) {
+        bool is_grpc_source = grpc_sources_.contains(source_to_id.at(source));
+        // GRPC sources are woken up by the router for every batch or closed connection, so when
+        // we were woken up only the signalled ones can have changed. With hundreds of upstream
+        // agents this keeps each wake up from scanning every source.
+        if (is_grpc_source && !timed_out && !signalled_sources.contains(source_to_id.at(source))) {
+          continue;
+        }
+        // This check is used for Memory sources that are waiting on data, because we don't
+        // currently have a mechanism to call Yield() on them while they are waiting.
+        // Once we introduce Carnot ETL, we can have the ingest phase of Carnot ETL call yield.
         if (source->NextBatchReady()) {
           wait_for_more_data = false;
         }
-        // Check the upstream connection health of all running GRPC sources after each yield.
-        if (grpc_sources_.contains(source_to_id.at(source))) {
+        // Check the upstream connection health of the GRPC sources after each yield.
+        if (is_grpc_source) {
           auto s = CheckUpstreamGRPCConnectionHealth(static_cast<GRPCSourceNode*>(source));
           if (!s.ok()) {
             LOG(ERROR) << absl::Substitute(
@@ -292,10 +626,24 @@ Status ExecutionGraph::ExecuteSources() {
 Status ExecutionGraph::Execute() {
   query_start_time_ = std::chrono::system_clock::now();
 
+  if (max_parallelism_ > 1) {
+    PL_RETURN_IF_ERROR(PlanMorselPipelines());
+  }
+
   // Get vector of nodes.
   std::vector<ExecNode*> nodes(nodes_.size());
   transform(nodes_.begin(), nodes_.end(), nodes.begin(), [](auto pair) { return pair.second; });
 
+  // The clones of morsel pipelines go through the same lifecycle as the nodes of the graph.
+  for (const auto& pipeline : morsel_pipelines_) {
+    for (const auto& clone : pipeline->clones) {
+      for (const auto& [source_idx, source] : clone.sources) {
+        nodes.push_back(source);
+      }
+      nodes.insert(nodes.end(), clone.ops.begin(), clone.ops.end());
+    }
+  }
+
   for (auto node : nodes) {
     PL_RETURN_IF_ERROR(node->Prepare(exec_state_));
   }
@@ -304,9 +652,13 @@ Status ExecutionGraph::Execute() {
     PL_RETURN_IF_ERROR(node->Open(exec_state_));
   }
 
+  StartMorselPipelines();
+
   // We don't PL_RETURN_IF_ERROR here because we want to make sure we close all of our
   // nodes, even if there was an error during execution.
   Status source_status = ExecuteSources();
+  // If execution stopped early, the workers may still be running.
+  StopMorselPipelines();
   Status close_status = Status::OK();
 
   for (auto node : nodes) {
@@ -327,6 +679,82 @@ Status ExecutionGraph::Execute() {
   return close_status;
 }
 
+void ExecutionGraph::RecordSinkResults(int64_t max_bytes) {
+  max_recorded_bytes_ = max_bytes;
+  for (const auto& [id, node] : nodes_) {
+    if (!node->IsSink()) {
+      continue;
+    }
+    recorded_results_[id];
+    // The batches are serialized right away, since their arrays belong to the pools of the query.
+    node->SetConsumeHook([this, id = id](const RowBatch& rb) {
+      if (recorded_bytes_ > max_recorded_bytes_) {
+        return;
+      }
+      table_store::schemapb::RowBatchData rb_pb;
+      Status s = rb.ToProto(&rb_pb, /* arrow_buffers */ true);
+      recorded_bytes_ += s.ok() ? rb_pb.ByteSizeLong() : max_recorded_bytes_ + 1;
+      if (recorded_bytes_ > max_recorded_bytes_) {
+        recorded_results_.clear();
+        return;
+      }
+      recorded_results_[id].push_back(std::move(rb_pb));
+    });
+  }
+}
+
+std::optional<ResultCache::SinkResults> ExecutionGraph::TakeSinkResults() {
+  if (recorded_bytes_ > max_recorded_bytes_) {
+    return std::nullopt;
+  }
+  return std::move(recorded_results_);
+}
+
+Status ExecutionGraph::Replay(const ResultCache::SinkResults& results) {
+  std::vector<std::pair<int64_t, ExecNode*>> sinks;
+  for (const auto& [id, node] : nodes_) {
+    if (node->IsSink()) {
+      sinks.emplace_back(id, node);
+    }
+  }
+  for (const auto& [id, sink] : sinks) {
+    PL_RETURN_IF_ERROR(sink->Prepare(exec_state_));
+  }
+  for (const auto& [id, sink] : sinks) {
+    PL_RETURN_IF_ERROR(sink->Open(exec_state_));
+  }
+
+  auto replay = [&]() -> Status {
+    for (const auto& [id, sink] : sinks) {
+      auto it = results.find(id);
+      if (it == results.end()) {
+        return error::Internal("Cached results have no batches for sink $0", id);
+      }
+      for (const auto& rb_pb : it->second) {
+        PL_ASSIGN_OR_RETURN(auto rb, RowBatch::FromProto(rb_pb));
+        PL_RETURN_IF_ERROR(sink->ConsumeNext(exec_state_, *rb, 0));
+      }
+    }
+    return Status::OK();
+  };
+  Status replay_status = replay();
+
+  Status close_status = Status::OK();
+  for (const auto& [id, sink] : sinks) {
+    auto s = sink->Close(exec_state_);
+    if (!s.ok()) {
+      LOG(ERROR) << absl::Substitute(
+          "Error in ExecutionGraph::Replay() for query $0, could not close sink $1: $2",
+          exec_state_->query_id().str(), id, s.msg());
+      close_status = s;
+    }
+  }
+  if (!replay_status.ok()) {
+    return replay_status;
+  }
+  return close_status;
+}
+
 std::vector<std::string> ExecutionGraph::OutputTables() const {
   std::vector<std::string> output_tables;
   // Go through the sinks.
@@ -356,6 +784,14 @@ ExecutionStats ExecutionGraph::GetStats() const {
     bytes_processed += source_node->BytesProcessed();
     rows_processed += source_node->RowsProcessed();
   }
+  for (const auto& pipeline : morsel_pipelines_) {
+    for (const auto& clone : pipeline->clones) {
+      for (const auto& [source_idx, source_node] : clone.sources) {
+        bytes_processed += source_node->BytesProcessed();
+        rows_processed += source_node->RowsProcessed();
+      }
+    }
+  }
   return ExecutionStats({bytes_processed, rows_processed});
 }
 
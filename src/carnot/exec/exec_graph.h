@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -32,6 +33,8 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/morsel_queue.h"
+#include "src/carnot/exec/result_cache.h"
 #include "src/carnot/plan/plan_fragment.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/common/base/base.h"
@@ -51,11 +54,15 @@ struct ExecutionStats {
 constexpr std::chrono::milliseconds kDefaultYieldTimeoutMS{1000};
 constexpr std::chrono::milliseconds kDefaultUpstreamResultConnectionTimeout{5000};
 constexpr int32_t kDefaultConsecutiveGenerateCallsPerSource = 10;
+// By default, a plan fragment executes on a single thread.
+constexpr int32_t kDefaultMaxParallelism = 1;
 using SystemTimePoint = std::chrono::time_point<std::chrono::system_clock>;
 
 /**
  * An Execution Graph defines the structure of execution nodes for a given plan fragment.
  */
+class AggNode;
+
 class ExecutionGraph {
  public:
   /**
@@ -83,11 +90,21 @@ class ExecutionGraph {
    * @param collect_exec_node_stats Whether or not to collect exec node stats.
    * @param consecutive_generate_calls_per_source how many times in a row to call GenerateNext
    * before switching to another available source.
+   * @param max_parallelism The max number of threads that may execute a single pipeline of this
+   * graph. When greater than 1, pipelines from a MemorySource (or the tablet sources of a Union) to
+   * a blocking Aggregate are split into morsels that are executed by that many workers.
    * @return The status of whether initialization succeeded.
    */
   Status Init(std::shared_ptr<table_store::schema::Schema> schema, plan::PlanState* plan_state,
               ExecState* exec_state, plan::PlanFragment* pf, bool collect_exec_node_stats,
-              int32_t consecutive_generate_calls_per_source);
+              int32_t consecutive_generate_calls_per_source, int32_t max_parallelism);
+
+  Status Init(std::shared_ptr<table_store::schema::Schema> schema, plan::PlanState* plan_state,
+              ExecState* exec_state, plan::PlanFragment* pf, bool collect_exec_node_stats,
+              int32_t consecutive_generate_calls_per_source) {
+    return Init(schema, plan_state, exec_state, pf, collect_exec_node_stats,
+                consecutive_generate_calls_per_source, kDefaultMaxParallelism);
+  }
 
   Status Init(std::shared_ptr<table_store::schema::Schema> schema, plan::PlanState* plan_state,
               ExecState* exec_state, plan::PlanFragment* pf, bool collect_exec_node_stats) {
@@ -96,6 +113,9 @@ class ExecutionGraph {
   }
 
   ~ExecutionGraph() {
+    // Worker threads hold pointers into this graph, make sure none of them outlive it.
+    StopMorselPipelines();
+
     // We need to remove these GRPC source nodes from the GRPC router because the exec graph
     // gets destructed so that the GRPC router doesn't have stale pointers to those nodes.
     if (exec_state_->grpc_router() != nullptr) {
@@ -131,12 +151,36 @@ class ExecutionGraph {
    */
   void Continue();
 
+  /**
+   * Re-awakens Execute() because the given source has new work, ie. a GRPC source received a row
+   * batch or its upstream connection closed.
+   */
+  void ContinueSource(int64_t source_id);
+
   /**
    * Yields the execution of the current graph until Continue() is called or the timeout is reached.
    * @return true if the yield timed out, false if Continue() was called.
    */
   bool YieldWithTimeout();
 
+  /**
+   * Makes Execute() record the row batches that the sinks consume, for the result cache.
+   * Recording stops (and TakeSinkResults() returns nullopt) once they add up to max_bytes.
+   */
+  void RecordSinkResults(int64_t max_bytes);
+
+  /**
+   * @return the results recorded by Execute(), or nullopt if they didn't fit.
+   */
+  std::optional<ResultCache::SinkResults> TakeSinkResults();
+  int64_t recorded_bytes() const { return recorded_bytes_; }
+
+  /**
+   * Executes the graph from cached results: the recorded row batches are sent to the sinks, and
+   * the other nodes are never opened.
+   */
+  Status Replay(const ResultCache::SinkResults& results);
+
   std::vector<std::string> OutputTables() const;
   ExecutionStats GetStats() const;
 
@@ -210,6 +254,65 @@ class ExecutionGraph {
 
   Status ExecuteSources();
 
+  // A pipeline from a MemorySource through Maps and Filters to a blocking Aggregate that is
+  // executed by several workers at once. Each worker runs its own clone of the pipeline on morsels
+  // (batches) claimed from the source's batch range. The original pipeline is run by the main
+  // execution loop, and the state of the cloned aggregates is merged into the original one before
+  // it emits its results.
+  //
+  // The tablets of a tabletized table are read by one MemorySource each, all feeding the same
+  // Union. Those sources form a single pipeline with the operators after the Union, in which every
+  // tablet is scanned by one of the workers (and the main loop, which takes the batches the
+  // worker hasn't got to yet).
+  struct MorselPipeline {
+    // Unowned pointers to the original sources and aggregate of the pipeline.
+    std::vector<MemorySourceNode*> sources;
+    AggNode* agg = nullptr;
+    struct Clone {
+      // The cloned sources, each with the index of the original source it shares its range with.
+      std::vector<std::pair<size_t, MemorySourceNode*>> sources;
+      // The operators after the sources, in pipeline order (the aggregate last).
+      std::vector<ExecNode*> ops;
+    };
+    std::vector<Clone> clones;
+    // The batch ranges of the original sources.
+    std::vector<std::shared_ptr<MorselQueue>> queues;
+    std::vector<std::thread> workers;
+    std::vector<Status> worker_statuses;
+    // The number of original sources whose ranges are drained, only used by the main loop.
+    size_t num_sources_drained = 0;
+  };
+
+  // Returns the ids of the Maps and Filters after the given operator up to and including the first
+  // blocking Aggregate, or an empty vector if they don't form a linear pipeline.
+  std::vector<int64_t> OpsToBlockingAgg(int64_t op_id);
+  // Returns the ids of the operators after the given source, up to and including the aggregate
+  // of its pipeline, if it can be executed in morsel-driven mode, or an empty vector otherwise.
+  std::vector<int64_t> MorselPipelineOps(int64_t source_id);
+  // Returns the ids of the tablet sources that are the parents of the given Union, if it only
+  // merges tablets of one table, or an empty vector otherwise.
+  std::vector<int64_t> TabletSources(int64_t union_id);
+  StatusOr<ExecNode*> CreateMorselClone(const plan::Operator& op);
+  // Clones the operators of a pipeline and the sources that each of its workers scans.
+  Status AddMorselPipeline(const std::vector<int64_t>& source_ids,
+                           const std::vector<int64_t>& op_ids);
+  // Clones the pipelines that can be executed in morsel-driven mode.
+  Status PlanMorselPipelines();
+  // Starts the workers of all morsel pipelines. Must be called after the nodes are opened.
+  void StartMorselPipelines();
+  // Once the ranges of all the sources of the pipeline are drained, waits for its workers and
+  // merges their state into the original aggregate.
+  Status FinishMorselPipeline(MorselPipeline* pipeline);
+  // Cancels and joins any outstanding workers. Safe to call multiple times.
+  void StopMorselPipelines();
+
+  // Returns the GRPC sinks that the source feeds into, or an empty vector if it also feeds any
+  // other sink.
+  std::vector<int64_t> DownstreamGRPCSinks(int64_t source_id);
+  // Returns whether the destinations of all of the given GRPC sinks stopped their streams, in
+  // which case the sources feeding them don't need to produce any more batches.
+  bool GRPCSinksStopped(const std::vector<int64_t>& sink_ids);
+
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
   std::shared_ptr<table_store::schema::Schema> schema_;
@@ -221,6 +324,10 @@ class ExecutionGraph {
   absl::flat_hash_set<int64_t> grpc_sinks_;
   std::unordered_map<int64_t, ExecNode*> nodes_;
 
+  ResultCache::SinkResults recorded_results_;
+  int64_t recorded_bytes_ = 0;
+  int64_t max_recorded_bytes_ = 0;
+
   SystemTimePoint query_start_time_;
 
   // How long to wait for any upstream result to make the initial connection to this query.
@@ -236,8 +343,17 @@ class ExecutionGraph {
   // (Doesn't apply if there is only one active source.)
   int32_t consecutive_generate_calls_per_source_ = kDefaultConsecutiveGenerateCallsPerSource;
 
+  // The max number of workers that may execute a single pipeline at once.
+  int32_t max_parallelism_ = kDefaultMaxParallelism;
+  std::vector<std::unique_ptr<MorselPipeline>> morsel_pipelines_;
+
+  // Returns the sources passed to ContinueSource since the last call, and clears them.
+  absl::flat_hash_set<int64_t> TakeSignalledSources();
+
   // Whether or not the graph should continue executing or wait for more work to do.
   bool continue_ = false;
+  // The sources that were signalled through ContinueSource, guarded by execution_mutex_.
+  absl::flat_hash_set<int64_t> signalled_sources_;
   std::mutex execution_mutex_;
   std::condition_variable execution_cv_;
   // Whether to collect stats on exec nodes.
@@ -25,6 +25,9 @@
 #include <tuple>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -554,6 +557,524 @@ TEST_F(ExecGraphTest, execute_with_two_limits) {
           ->Equals(types::ToArrow(out_in1, arrow::default_memory_pool())));
 }
 
+// Sums its int64 argument.
+class SumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg) { sum_ = sum_.val + arg.val; }
+  void Merge(udf::FunctionContext*, const SumUDA& other) { sum_ = sum_.val + other.sum_.val; }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
+constexpr char kSourceFilterAggPlanFragment[] = R"proto(
+  id: 1,
+  dag {
+    nodes {
+      id: 1
+      sorted_children: 2
+    }
+    nodes {
+      id: 2
+      sorted_children: 3
+      sorted_parents: 1
+    }
+    nodes {
+      id: 3
+      sorted_children: 4
+      sorted_parents: 2
+    }
+    nodes {
+      id: 4
+      sorted_parents: 3
+    }
+  }
+  nodes {
+    id: 1
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "numbers"
+        column_idxs: 0
+        column_types: INT64
+        column_names: "a"
+        column_idxs: 1
+        column_types: BOOLEAN
+        column_names: "b"
+      }
+    }
+  }
+  nodes {
+    id: 2
+    op {
+      op_type: FILTER_OPERATOR
+      filter_op {
+        expression {
+          func {
+            id: 0
+            name: "gt"
+            args {
+              column {
+                node: 1
+                index: 0
+              }
+            }
+            args {
+              constant {
+                data_type: INT64
+                int64_value: 10
+              }
+            }
+            args_data_types: INT64
+            args_data_types: INT64
+          }
+        }
+        columns {
+          node: 1
+          index: 0
+        }
+        columns {
+          node: 1
+          index: 1
+        }
+      }
+    }
+  }
+  nodes {
+    id: 3
+    op {
+      op_type: AGGREGATE_OPERATOR
+      agg_op {
+        windowed: false
+        values {
+          name: "sum"
+          id: 0
+          args {
+            column {
+              node: 2
+              index: 0
+            }
+          }
+          args_data_types: INT64
+        }
+        groups {
+          node: 2
+          index: 1
+        }
+        group_names: "b"
+        value_names: "sum_a"
+      }
+    }
+  }
+  nodes {
+    id: 4
+    op {
+      op_type: MEMORY_SINK_OPERATOR
+      mem_sink_op {
+        name: "output"
+        column_types: BOOLEAN
+        column_types: INT64
+        column_names: "b"
+        column_names: "sum_a"
+      }
+    }
+  }
+)proto";
+
+class GreaterThanUDF : public udf::ScalarUDF {
+ public:
+  types::BoolValue Exec(udf::FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val > v2.val;
+  }
+};
+
+class MorselExecGraphTest : public BaseExecGraphTest,
+                            public ::testing::WithParamInterface<int32_t> {};
+
+TEST_P(MorselExecGraphTest, source_filter_agg) {
+  int32_t max_parallelism = GetParam();
+  SetUpExecState();
+  func_registry_->RegisterOrDie<GreaterThanUDF>("gt");
+  func_registry_->RegisterOrDie<SumUDA>("sum");
+
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(kSourceFilterAggPlanFragment, &pf_pb));
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  auto plan_state = std::make_unique<plan::PlanState>(func_registry_.get());
+  auto schema = std::make_shared<table_store::schema::Schema>();
+
+  table_store::schema::Relation rel({types::DataType::INT64, types::DataType::BOOLEAN},
+                                    {"a", "b"});
+  auto table = Table::Create(rel);
+  int64_t expected_even_sum = 0;
+  int64_t expected_odd_sum = 0;
+  // Use many small batches, so that every worker gets to claim some of them.
+  for (int64_t batch = 0; batch < 64; ++batch) {
+    std::vector<types::Int64Value> a;
+    std::vector<types::BoolValue> b;
+    for (int64_t i = batch * 8; i < (batch + 1) * 8; ++i) {
+      a.push_back(i);
+      b.push_back(i % 2 == 0);
+      if (i > 10) {
+        (i % 2 == 0 ? expected_even_sum : expected_odd_sum) += i;
+      }
+    }
+    EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(a, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(b, arrow::default_memory_pool())));
+  }
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  table_store->AddTable("numbers", table);
+  auto exec_state = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                                MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  EXPECT_OK(exec_state->AddScalarUDF(
+      0, "gt", std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
+  EXPECT_OK(exec_state->AddUDA(0, "sum", std::vector<types::DataType>({types::DataType::INT64})));
+
+  ExecutionGraph e;
+  ASSERT_OK(e.Init(schema, plan_state.get(), exec_state.get(), plan_fragment_.get(),
+                   /* collect_exec_node_stats */ false, kDefaultConsecutiveGenerateCallsPerSource,
+                   max_parallelism));
+  EXPECT_OK(e.Execute());
+
+  auto stats = e.GetStats();
+  EXPECT_EQ(64 * 8, stats.rows_processed);
+
+  auto output_table = exec_state->table_store()->GetTable("output");
+  ASSERT_EQ(1, output_table->NumBatches());
+  auto out_rb =
+      output_table->GetRowBatch(0, std::vector<int64_t>({0, 1}), arrow::default_memory_pool())
+          .ConsumeValueOrDie();
+  ASSERT_EQ(2, out_rb->num_rows());
+  // The order of the groups isn't deterministic.
+  auto groups = std::static_pointer_cast<arrow::BooleanArray>(out_rb->ColumnAt(0));
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(1));
+  for (int64_t i = 0; i < out_rb->num_rows(); ++i) {
+    EXPECT_EQ(groups->Value(i) ? expected_even_sum : expected_odd_sum, sums->Value(i));
+  }
+}
+
+constexpr int64_t kNumTablets = 6;
+
+// The tablet sources (ids 1 to kNumTablets) of "numbers" feed a union, followed by the filter and
+// aggregate of kSourceFilterAggPlanFragment.
+std::string TabletUnionFilterAggPlanFragment() {
+  constexpr int64_t kUnionID = kNumTablets + 1;
+  std::string dag;
+  std::string sources;
+  std::string union_parents;
+  std::string union_mappings;
+  for (int64_t id = 1; id <= kNumTablets; ++id) {
+    absl::StrAppend(&dag, absl::Substitute("nodes { id: $0 sorted_children: $1 }\n", id, kUnionID));
+    absl::StrAppend(&union_parents, absl::Substitute("sorted_parents: $0 ", id));
+    absl::StrAppend(&union_mappings, "column_mappings { column_indexes: 0 column_indexes: 1 }\n");
+    absl::StrAppend(&sources, absl::Substitute(R"proto(
+      nodes {
+        id: $0
+        op {
+          op_type: MEMORY_SOURCE_OPERATOR
+          mem_source_op {
+            name: "numbers"
+            tablet: "$0"
+            column_idxs: 0
+            column_types: INT64
+            column_names: "a"
+            column_idxs: 1
+            column_types: BOOLEAN
+            column_names: "b"
+          }
+        }
+      })proto",
+                                               id));
+  }
+  return absl::Substitute(R"proto(
+    id: 1
+    dag {
+      $0
+      nodes { id: $3 sorted_children: $4 $1 }
+      nodes { id: $4 sorted_children: $5 sorted_parents: $3 }
+      nodes { id: $5 sorted_children: $6 sorted_parents: $4 }
+      nodes { id: $6 sorted_parents: $5 }
+    }
+    $2
+    nodes {
+      id: $3
+      op {
+        op_type: UNION_OPERATOR
+        union_op {
+          column_names: "a"
+          column_names: "b"
+          $7
+        }
+      }
+    }
+    nodes {
+      id: $4
+      op {
+        op_type: FILTER_OPERATOR
+        filter_op {
+          expression {
+            func {
+              id: 0
+              name: "gt"
+              args { column { node: $3 index: 0 } }
+              args { constant { data_type: INT64 int64_value: 10 } }
+              args_data_types: INT64
+              args_data_types: INT64
+            }
+          }
+          columns { node: $3 index: 0 }
+          columns { node: $3 index: 1 }
+        }
+      }
+    }
+    nodes {
+      id: $5
+      op {
+        op_type: AGGREGATE_OPERATOR
+        agg_op {
+          windowed: false
+          values {
+            name: "sum"
+            id: 0
+            args { column { node: $4 index: 0 } }
+            args_data_types: INT64
+          }
+          groups { node: $4 index: 1 }
+          group_names: "b"
+          value_names: "sum_a"
+        }
+      }
+    }
+    nodes {
+      id: $6
+      op {
+        op_type: MEMORY_SINK_OPERATOR
+        mem_sink_op {
+          name: "output"
+          column_types: BOOLEAN
+          column_types: INT64
+          column_names: "b"
+          column_names: "sum_a"
+        }
+      }
+    }
+  )proto",
+                          dag, union_parents, sources, kUnionID, kUnionID + 1, kUnionID + 2,
+                          kUnionID + 3, union_mappings);
+}
+
+TEST_P(MorselExecGraphTest, tablet_union_filter_agg) {
+  int32_t max_parallelism = GetParam();
+  SetUpExecState();
+  func_registry_->RegisterOrDie<GreaterThanUDF>("gt");
+  func_registry_->RegisterOrDie<SumUDA>("sum");
+
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(TabletUnionFilterAggPlanFragment(), &pf_pb));
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  auto plan_state = std::make_unique<plan::PlanState>(func_registry_.get());
+  auto schema = std::make_shared<table_store::schema::Schema>();
+
+  table_store::schema::Relation rel({types::DataType::INT64, types::DataType::BOOLEAN},
+                                    {"a", "b"});
+  auto table_store = std::make_shared<table_store::TableStore>();
+  int64_t expected_even_sum = 0;
+  int64_t expected_odd_sum = 0;
+  int64_t num_rows = 0;
+  for (int64_t tablet = 1; tablet <= kNumTablets; ++tablet) {
+    auto table = Table::Create(rel);
+    // The tablets have different sizes, so that the workers finish them at different times.
+    for (int64_t batch = 0; batch < 4 * tablet; ++batch) {
+      std::vector<types::Int64Value> a;
+      std::vector<types::BoolValue> b;
+      for (int64_t i = 0; i < 8; ++i) {
+        int64_t value = tablet * 1000 + batch * 8 + i;
+        a.push_back(value);
+        b.push_back(value % 2 == 0);
+        (value % 2 == 0 ? expected_even_sum : expected_odd_sum) += value;
+        ++num_rows;
+      }
+      EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(a, arrow::default_memory_pool())));
+      EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(b, arrow::default_memory_pool())));
+    }
+    table_store->AddTable(table, "numbers", /* table_id */ 1, absl::StrCat(tablet));
+  }
+  auto exec_state = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                                MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  EXPECT_OK(exec_state->AddScalarUDF(
+      0, "gt", std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
+  EXPECT_OK(exec_state->AddUDA(0, "sum", std::vector<types::DataType>({types::DataType::INT64})));
+
+  ExecutionGraph e;
+  ASSERT_OK(e.Init(schema, plan_state.get(), exec_state.get(), plan_fragment_.get(),
+                   /* collect_exec_node_stats */ false, kDefaultConsecutiveGenerateCallsPerSource,
+                   max_parallelism));
+  EXPECT_OK(e.Execute());
+
+  EXPECT_EQ(num_rows, e.GetStats().rows_processed);
+
+  auto output_table = exec_state->table_store()->GetTable("output");
+  ASSERT_EQ(1, output_table->NumBatches());
+  auto out_rb =
+      output_table->GetRowBatch(0, std::vector<int64_t>({0, 1}), arrow::default_memory_pool())
+          .ConsumeValueOrDie();
+  ASSERT_EQ(2, out_rb->num_rows());
+  auto groups = std::static_pointer_cast<arrow::BooleanArray>(out_rb->ColumnAt(0));
+  auto sums = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(1));
+  for (int64_t i = 0; i < out_rb->num_rows(); ++i) {
+    EXPECT_EQ(groups->Value(i) ? expected_even_sum : expected_odd_sum, sums->Value(i));
+  }
+}
+
+// Sums "a" over tumbling windows of 64 on "a", after the filter of kSourceFilterAggPlanFragment.
+constexpr char kSourceFilterTimeWindowAggPlanFragment[] = R"proto(
+  id: 1,
+  dag {
+    nodes { id: 1 sorted_children: 2 }
+    nodes { id: 2 sorted_children: 3 sorted_parents: 1 }
+    nodes { id: 3 sorted_children: 4 sorted_parents: 2 }
+    nodes { id: 4 sorted_parents: 3 }
+  }
+  nodes {
+    id: 1
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "numbers"
+        column_idxs: 0
+        column_types: INT64
+        column_names: "a"
+        column_idxs: 1
+        column_types: BOOLEAN
+        column_names: "b"
+      }
+    }
+  }
+  nodes {
+    id: 2
+    op {
+      op_type: FILTER_OPERATOR
+      filter_op {
+        expression {
+          func {
+            id: 0
+            name: "gt"
+            args { column { node: 1 index: 0 } }
+            args { constant { data_type: INT64 int64_value: 10 } }
+            args_data_types: INT64
+            args_data_types: INT64
+          }
+        }
+        columns { node: 1 index: 0 }
+        columns { node: 1 index: 1 }
+      }
+    }
+  }
+  nodes {
+    id: 3
+    op {
+      op_type: AGGREGATE_OPERATOR
+      agg_op {
+        windowed: false
+        values {
+          name: "sum"
+          id: 0
+          args { column { node: 2 index: 0 } }
+          args_data_types: INT64
+        }
+        groups { node: 2 index: 0 }
+        group_names: "window"
+        value_names: "sum_a"
+        time_window { group_index: 0 size_ns: 64 }
+      }
+    }
+  }
+  nodes {
+    id: 4
+    op {
+      op_type: MEMORY_SINK_OPERATOR
+      mem_sink_op {
+        name: "output"
+        column_types: INT64
+        column_types: INT64
+        column_names: "window"
+        column_names: "sum_a"
+      }
+    }
+  }
+)proto";
+
+TEST_P(MorselExecGraphTest, source_filter_time_window_agg) {
+  int32_t max_parallelism = GetParam();
+  SetUpExecState();
+  func_registry_->RegisterOrDie<GreaterThanUDF>("gt");
+  func_registry_->RegisterOrDie<SumUDA>("sum");
+
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(kSourceFilterTimeWindowAggPlanFragment, &pf_pb));
+  ASSERT_OK(plan_fragment_->Init(pf_pb));
+
+  auto plan_state = std::make_unique<plan::PlanState>(func_registry_.get());
+  auto schema = std::make_shared<table_store::schema::Schema>();
+
+  table_store::schema::Relation rel({types::DataType::INT64, types::DataType::BOOLEAN},
+                                    {"a", "b"});
+  auto table = Table::Create(rel);
+  absl::flat_hash_map<int64_t, int64_t> expected_window_sums;
+  for (int64_t batch = 0; batch < 64; ++batch) {
+    std::vector<types::Int64Value> a;
+    std::vector<types::BoolValue> b;
+    for (int64_t i = batch * 8; i < (batch + 1) * 8; ++i) {
+      a.push_back(i);
+      b.push_back(i % 2 == 0);
+      if (i > 10) {
+        expected_window_sums[i - i % 64] += i;
+      }
+    }
+    EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(a, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(b, arrow::default_memory_pool())));
+  }
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  table_store->AddTable("numbers", table);
+  auto exec_state = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                                MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  EXPECT_OK(exec_state->AddScalarUDF(
+      0, "gt", std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
+  EXPECT_OK(exec_state->AddUDA(0, "sum", std::vector<types::DataType>({types::DataType::INT64})));
+
+  ExecutionGraph e;
+  ASSERT_OK(e.Init(schema, plan_state.get(), exec_state.get(), plan_fragment_.get(),
+                   /* collect_exec_node_stats */ false, kDefaultConsecutiveGenerateCallsPerSource,
+                   max_parallelism));
+  EXPECT_OK(e.Execute());
+
+  // Windows are emitted as they close, so the pipeline isn't split into morsels, whose clones
+  // would drop the windows they close.
+  absl::flat_hash_map<int64_t, int64_t> window_sums;
+  auto output_table = exec_state->table_store()->GetTable("output");
+  for (int64_t batch = 0; batch < output_table->NumBatches(); ++batch) {
+    auto out_rb = output_table
+                      ->GetRowBatch(batch, std::vector<int64_t>({0, 1}),
+                                    arrow::default_memory_pool())
+                      .ConsumeValueOrDie();
+    auto windows = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(0));
+    auto sums = std::static_pointer_cast<arrow::Int64Array>(out_rb->ColumnAt(1));
+    for (int64_t i = 0; i < out_rb->num_rows(); ++i) {
+      EXPECT_FALSE(window_sums.contains(windows->Value(i)));
+      window_sums[windows->Value(i)] = sums->Value(i);
+    }
+  }
+  EXPECT_EQ(expected_window_sums, window_sums);
+}
+
+INSTANTIATE_TEST_SUITE_P(MorselExecGraphTestSuite, MorselExecGraphTest,
+                         ::testing::Values(1, 2, 4, 8));
+
 class YieldingExecGraphTest : public BaseExecGraphTest {
  protected:
   void SetUp() { SetUpExecState(); }
@@ -655,6 +1176,21 @@ TEST_F(YieldingExecGraphTest, continue_yield) {
 #endif
 }
 
+TEST_F(YieldingExecGraphTest, continue_source_yield) {
+#if !__has_feature(thread_sanitizer)
+  ExecutionGraph e;
+  e.testing_set_exec_state(exec_state_.get());
+
+  // Signalling a single source wakes up the execution just like Continue.
+  e.ContinueSource(/* source_id */ 1);
+  std::thread exec_thread([&] {
+    bool timed_out = e.YieldWithTimeout();
+    ASSERT_FALSE(timed_out);
+  });
+  exec_thread.join();
+#endif
+}
+
 TEST_F(YieldingExecGraphTest, yield_timeout) {
   ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1)};
   e.testing_set_exec_state(exec_state_.get());
@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/exec/exec_state.h"
@@ -160,6 +162,7 @@ class ExecNode {
    */
   Status Prepare(ExecState* exec_state) {
     DCHECK(is_initialized_);
+    mem_pool_ = exec_state->CreateNodeMemoryPool();
     return PrepareImpl(exec_state);
   }
 
@@ -170,7 +173,11 @@ class ExecNode {
    */
   Status Open(ExecState* exec_state) {
     DCHECK(is_initialized_);
-    return OpenImpl(exec_state);
+    ElapsedTimer timer;
+    timer.Start();
+    PL_RETURN_IF_ERROR(OpenImpl(exec_state));
+    stats_->AddExtraMetric("open_time_ns", timer.ElapsedTime_us() * 1000);
+    return Status::OK();
   }
 
   /**
@@ -182,7 +189,15 @@ class ExecNode {
    */
   Status Close(ExecState* exec_state) {
     DCHECK(is_initialized_);
-    return CloseImpl(exec_state);
+    if (mem_pool_ != nullptr) {
+      stats_->AddExtraMetric("memory_bytes", mem_pool_->current_bytes());
+      stats_->AddExtraMetric("peak_memory_bytes", mem_pool_->peak_bytes());
+    }
+    ElapsedTimer timer;
+    timer.Start();
+    PL_RETURN_IF_ERROR(CloseImpl(exec_state));
+    stats_->AddExtraMetric("close_time_ns", timer.ElapsedTime_us() * 1000);
+    return Status::OK();
   }
 
   /**
@@ -218,6 +233,9 @@ class ExecNode {
       return error::Internal(
           "ConsumeNext received row batch with end of stream set but not end of window.");
     }
+    if (consume_hook_) {
+      consume_hook_(rb);
+    }
     stats_->AddInputStats(rb);
     stats_->ResumeTotalTimer();
     PL_RETURN_IF_ERROR(ConsumeNextImpl(exec_state, rb, parent_index));
@@ -225,6 +243,14 @@ class ExecNode {
     return Status::OK();
   }
 
+  /**
+   * Registers a function that is called with every row batch the node consumes, before the node
+   * handles it. Used to record the results that reach the sinks of a fragment.
+   */
+  void SetConsumeHook(std::function<void(const table_store::schema::RowBatch&)> hook) {
+    consume_hook_ = std::move(hook);
+  }
+
   /**
    * Check if it's a source node.
    */
@@ -275,6 +301,11 @@ class ExecNode {
 
   ExecNodeStats* stats() const { return stats_.get(); }
 
+  /**
+   * The pool this node allocates its batches and state from. Only valid after Prepare().
+   */
+  TrackingMemoryPool* mem_pool() const { return mem_pool_; }
+
  protected:
   /**
    * Send data to children row batches.
@@ -323,6 +354,9 @@ class ExecNode {
  private:
   // The stats of this exec node.
   std::unique_ptr<ExecNodeStats> stats_;
+  std::function<void(const table_store::schema::RowBatch&)> consume_hook_;
+  // Owned by the ExecState.
+  TrackingMemoryPool* mem_pool_ = nullptr;
   // Unowned reference to the children. Must remain valid for the duration of query.
   std::vector<ExecNode*> children_;
   // For each of the children (which may have multiple parents) which parent is this node?
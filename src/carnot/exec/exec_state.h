@@ -20,20 +20,28 @@
 
 #include <arrow/memory_pool.h>
 
+#include <atomic>
+#include <filesystem>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/types/span.h>
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/grpc_router.h"
 #include "src/carnot/exec/ml/model_pool.h"
+#include "src/carnot/exec/query_admission_controller.h"
+#include "src/carnot/exec/tracking_memory_pool.h"
+#include "src/carnot/trace/query_trace.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
+#include "src/shared/types/huge_page_memory_pool.h"
 #include "src/table_store/table/table_store.h"
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
@@ -73,10 +81,95 @@ class ExecState {
     if (grpc_router_ != nullptr) {
       grpc_router_->DeleteQuery(query_id_);
     }
+    for (auto& pool : node_mem_pools_) {
+      TrackingMemoryPool::RetainUntilFreed(std::move(pool));
+    }
   }
   arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
-    return arrow::default_memory_pool();
+    if (admission_ticket_ != nullptr) {
+      return admission_ticket_->mem_pool();
+    }
+    return types::DataMemoryPool();
+  }
+
+  /**
+   * Creates the pool for an ExecNode of the query to allocate from. Allocations are forwarded to
+   * exec_mem_pool(). The pool is valid for the lifetime of the ExecState.
+   */
+  TrackingMemoryPool* CreateNodeMemoryPool() {
+    node_mem_pools_.push_back(std::make_shared<TrackingMemoryPool>(exec_mem_pool()));
+    return node_mem_pools_.back().get();
+  }
+
+  /**
+   * Sets the ticket the query was admitted with. Allocations from exec_mem_pool() are then
+   * accounted to the query, and the query stops running once the ticket is cancelled.
+   * The ticket must outlive the ExecState.
+   */
+  void set_admission_ticket(QueryAdmissionController::Ticket* ticket) {
+    admission_ticket_ = ticket;
+  }
+
+  bool cancelled() const { return admission_ticket_ != nullptr && admission_ticket_->cancelled(); }
+
+  // Lets the admission controller cancel a query if all queries together are over the budget.
+  void CheckMemoryBudget() {
+    if (admission_ticket_ != nullptr) {
+      admission_ticket_->CheckMemoryBudget();
+    }
+  }
+
+  /**
+   * Reserves memory against the query's memory budget. Operators that buffer an unbounded amount
+   * of data use this to decide when to move that data out of memory.
+   * @param bytes The number of bytes to reserve.
+   * @return false if the reservation would exceed the budget, in which case nothing is reserved.
+   */
+  bool TryReserveMemory(int64_t bytes) {
+    int64_t reserved = reserved_memory_bytes_.load();
+    do {
+      if (memory_budget_bytes_ > 0 && reserved + bytes > memory_budget_bytes_) {
+        return false;
+      }
+    } while (!reserved_memory_bytes_.compare_exchange_weak(reserved, reserved + bytes));
+    return true;
+  }
+
+  void ReleaseMemory(int64_t bytes) { reserved_memory_bytes_ -= bytes; }
+
+  int64_t reserved_memory_bytes() const { return reserved_memory_bytes_.load(); }
+
+  // A budget of 0 means the query's memory is unlimited.
+  int64_t memory_budget_bytes() const { return memory_budget_bytes_; }
+  void set_memory_budget_bytes(int64_t memory_budget_bytes) {
+    memory_budget_bytes_ = memory_budget_bytes;
+  }
+
+  // Directory for the scratch files of operators that spill. Empty means the system temp dir.
+  const std::filesystem::path& spill_dir() const { return spill_dir_; }
+  void set_spill_dir(const std::filesystem::path& spill_dir) { spill_dir_ = spill_dir; }
+
+  /**
+   * Sets the trace that the spans of the query go to. The trace must outlive the ExecState.
+   */
+  void set_query_trace(trace::QueryTrace* query_trace) { query_trace_ = query_trace; }
+
+  // The span that the spans started by the operators are children of, ie. the current fragment's.
+  void set_parent_span_id(uint64_t parent_span_id) { parent_span_id_ = parent_span_id; }
+
+  /**
+   * Starts a span of the query. If the query isn't traced, the span is inactive and dropped.
+   */
+  trace::QueryTrace::Span StartSpan(std::string name) {
+    if (query_trace_ == nullptr) {
+      return {};
+    }
+    return query_trace_->StartSpan(std::move(name), parent_span_id_);
+  }
+
+  // The peak memory of the query so far, or -1 if the query's memory isn't accounted separately.
+  int64_t peak_memory_bytes() {
+    return admission_ticket_ != nullptr ? admission_ticket_->mem_pool()->max_memory() : -1;
   }
 
   udf::Registry* func_registry() { return func_registry_; }
@@ -87,14 +180,23 @@ class ExecState {
 
   ml::ModelPool* model_pool() { return model_pool_; }
 
-  Status AddScalarUDF(int64_t id, const std::string& name,
-                      const std::vector<types::DataType> arg_types) {
+  // Resolves the definition of the UDF that the plan refers to by id. The planner gives every
+  // (name, arg types) its own id, so an id that is already resolved isn't looked up again when a
+  // plan uses the same function in several expressions.
+  Status AddScalarUDF(int64_t id, std::string_view name,
+                      absl::Span<const types::DataType> arg_types) {
+    if (id_to_scalar_udf_map_.find(id) != id_to_scalar_udf_map_.end()) {
+      return Status::OK();
+    }
     PL_ASSIGN_OR_RETURN(auto def, func_registry_->GetScalarUDFDefinition(name, arg_types));
     id_to_scalar_udf_map_[id] = def;
     return Status::OK();
   }
 
-  Status AddUDA(int64_t id, const std::string& name, const std::vector<types::DataType> arg_types) {
+  Status AddUDA(int64_t id, std::string_view name, absl::Span<const types::DataType> arg_types) {
+    if (id_to_uda_map_.find(id) != id_to_uda_map_.end()) {
+      return Status::OK();
+    }
     PL_ASSIGN_OR_RETURN(auto def, func_registry_->GetUDADefinition(name, arg_types));
     id_to_uda_map_[id] = def;
     return Status::OK();
@@ -118,7 +220,7 @@ class ExecState {
 
   udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) { return id_to_scalar_udf_map_[id]; }
 
-  std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map() {
+  const std::map<int64_t, udf::ScalarUDFDefinition*>& id_to_scalar_udf_map() const {
     return id_to_scalar_udf_map_;
   }
 
@@ -135,7 +237,7 @@ class ExecState {
 
   bool keep_running() {
     DCHECK(current_source_set_);
-    return source_id_to_keep_running_map_[current_source_];
+    return !cancelled() && source_id_to_keep_running_map_[current_source_];
   }
 
   void SetCurrentSource(int64_t source_id) {
@@ -150,6 +252,7 @@ class ExecState {
   void set_metadata_state(std::shared_ptr<const md::AgentMetadataState> metadata_state) {
     metadata_state_ = metadata_state;
   }
+  const md::AgentMetadataState* metadata_state() const { return metadata_state_.get(); }
 
   GRPCRouter* grpc_router() { return grpc_router_; }
 
@@ -173,12 +276,20 @@ class ExecState {
   const sole::uuid query_id_;
   ml::ModelPool* model_pool_;
   GRPCRouter* grpc_router_ = nullptr;
+  QueryAdmissionController::Ticket* admission_ticket_ = nullptr;
+  trace::QueryTrace* query_trace_ = nullptr;
+  uint64_t parent_span_id_ = 0;
+  std::vector<std::shared_ptr<TrackingMemoryPool>> node_mem_pools_;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_client_context_func_;
 
   int64_t current_source_ = 0;
   bool current_source_set_ = false;
   std::map<int64_t, bool> source_id_to_keep_running_map_;
 
+  int64_t memory_budget_bytes_ = 0;
+  std::atomic<int64_t> reserved_memory_bytes_ = 0;
+  std::filesystem::path spill_dir_;
+
   std::vector<std::unique_ptr<carnotpb::ResultSinkService::StubInterface>> result_sink_stubs_pool_;
   // Mapping of remote address to stub that serves that address.
   absl::flat_hash_map<std::string, carnotpb::ResultSinkService::StubInterface*>
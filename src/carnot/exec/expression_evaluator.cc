@@ -24,16 +24,20 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <cstring>
 #include <memory>
 #include <ostream>
+#include <string>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/udf/udf_definition.h"
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 
@@ -57,6 +61,88 @@ using types::SharedColumnWrapper;
 using types::StringValueColumnWrapper;
 using types::Time64NSValueColumnWrapper;
 
+namespace {
+
+// Returns a key that is the same for two ScalarValues only if they have the same value.
+// PL_CARNOT_UPDATE_FOR_NEW_TYPES.
+std::string ScalarValueKey(const plan::ScalarValue& val) {
+  if (val.IsNull()) {
+    return absl::StrCat("null:", val.DataType());
+  }
+  switch (val.DataType()) {
+    case types::BOOLEAN:
+      return val.BoolValue() ? "bool:true" : "bool:false";
+    case types::INT64:
+      return absl::StrCat("int64:", val.Int64Value());
+    case types::FLOAT64: {
+      // The bits of the double, since printing it could round away differences.
+      double value = val.Float64Value();
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return absl::StrCat("float64:", bits);
+    }
+    case types::STRING:
+      return absl::StrCat("string:", val.StringValue());
+    case types::TIME64NS:
+      return absl::StrCat("time64ns:", val.Time64NSValue());
+    case types::UINT128:
+      return absl::StrCat("uint128:", absl::Uint128High64(val.UInt128Value()), ":",
+                          absl::Uint128Low64(val.UInt128Value()));
+    default:
+      return absl::StrCat("unknown:", val.DebugString());
+  }
+}
+
+}  // namespace
+
+ScalarExpressionDAG::ScalarExpressionDAG(const plan::ConstScalarExpressionVector& expressions) {
+  for (const auto& expr : expressions) {
+    AddExpression(*expr);
+  }
+}
+
+size_t ScalarExpressionDAG::AddExpression(const plan::ScalarExpression& expr) {
+  Node node{&expr, {}};
+  std::string key;
+  switch (expr.ExpressionType()) {
+    case plan::Expression::kColumn:
+      key = absl::StrCat("col:", static_cast<const plan::Column&>(expr).Index());
+      break;
+    case plan::Expression::kConstant:
+      key = ScalarValueKey(static_cast<const plan::ScalarValue&>(expr));
+      break;
+    case plan::Expression::kFunc: {
+      const auto& fn = static_cast<const plan::ScalarFunc&>(expr);
+      for (const auto& arg : fn.arg_deps()) {
+        node.args.push_back(AddExpression(*arg));
+      }
+      // The args are identified by their nodes, which already merged identical args.
+      key = absl::StrCat("fn:", fn.name(), ":", fn.udf_id(), "(", absl::StrJoin(node.args, ","),
+                         ")");
+      break;
+    }
+    default:
+      // Anything else gets its own node.
+      key = absl::StrCat("expr:", reinterpret_cast<uintptr_t>(&expr));
+      break;
+  }
+
+  auto [it, inserted] = node_by_key_.try_emplace(key, nodes_.size());
+  if (inserted) {
+    nodes_.push_back(std::move(node));
+  }
+  node_by_expr_[&expr] = it->second;
+  return it->second;
+}
+
+std::optional<size_t> ScalarExpressionDAG::NodeFor(const plan::ScalarExpression& expr) const {
+  auto it = node_by_expr_.find(&expr);
+  if (it == node_by_expr_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
 std::unique_ptr<ScalarExpressionEvaluator> ScalarExpressionEvaluator::Create(
     const plan::ConstScalarExpressionVector& expressions, const ScalarExpressionEvaluatorType& type,
     udf::FunctionContext* function_ctx) {
@@ -65,6 +151,8 @@ std::unique_ptr<ScalarExpressionEvaluator> ScalarExpressionEvaluator::Create(
       return std::make_unique<VectorNativeScalarExpressionEvaluator>(expressions, function_ctx);
     case ScalarExpressionEvaluatorType::kArrowNative:
       return std::make_unique<ArrowNativeScalarExpressionEvaluator>(expressions, function_ctx);
+    case ScalarExpressionEvaluatorType::kCompiled:
+      return std::make_unique<CompiledScalarExpressionEvaluator>(expressions, function_ctx);
     default:
       CHECK(0) << "Unknown expression type";
   }
@@ -89,9 +177,8 @@ std::shared_ptr<arrow::Array> EvalScalar(
 
 // Evaluate Scalar to arrow.
 // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
-std::shared_ptr<arrow::Array> EvalScalarToArrow(ExecState* exec_state, const plan::ScalarValue& val,
-                                                size_t count) {
-  auto mem_pool = exec_state->exec_mem_pool();
+std::shared_ptr<arrow::Array> EvalScalarToArrow(arrow::MemoryPool* mem_pool,
+                                                const plan::ScalarValue& val, size_t count) {
   switch (val.DataType()) {
     case types::BOOLEAN:
       return EvalScalar<DataType::BOOLEAN>(mem_pool, val.BoolValue(), count);
@@ -139,6 +226,7 @@ Status ScalarExpressionEvaluator::Evaluate(ExecState* exec_state, const RowBatch
   CHECK(output != nullptr);
   CHECK_EQ(static_cast<size_t>(output->num_columns()), expressions_.size());
 
+  ResetNodeResults();
   for (const auto& expression : expressions_) {
     PL_RETURN_IF_ERROR(EvaluateSingleExpression(exec_state, input, *expression, output));
   }
@@ -164,56 +252,98 @@ Status VectorNativeScalarExpressionEvaluator::Close(ExecState*) {
   return Status();
 }
 
-StatusOr<types::SharedColumnWrapper>
-VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
-    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
-  CHECK(exec_state != nullptr);
-  CHECK_GT(input.num_columns(), 0);
-
+StatusOr<types::SharedColumnWrapper> VectorNativeScalarExpressionEvaluator::EvaluateNode(
+    ExecState* exec_state, const RowBatch& input, size_t node_idx) {
+  if (node_evaluated_[node_idx]) {
+    return node_results_[node_idx];
+  }
+  const auto& node = dag_.nodes()[node_idx];
   size_t num_rows = input.num_rows();
 
-  // Path for scalar funcs an their dependencies to get evaluated.
-  // The Arrow arrays are converted to type erased column wrappers
-  // and then evaluated.
-  plan::ExpressionWalker<types::SharedColumnWrapper> walker;
-  walker.OnScalarValue(
-      [&](const plan::ScalarValue& val,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        DCHECK_EQ(children.size(), 0ULL);
-        return EvalScalarToColumnWrapper(exec_state, val, num_rows);
+  // The Arrow arrays are converted to type erased column wrappers and then evaluated.
+  types::SharedColumnWrapper result;
+  switch (node.expr->ExpressionType()) {
+    case plan::Expression::kConstant:
+      result = EvalScalarToColumnWrapper(
+          exec_state, static_cast<const plan::ScalarValue&>(*node.expr), num_rows);
+      break;
+    case plan::Expression::kColumn:
+      result = ColumnWrapper::FromArrow(
+          input.ColumnAt(static_cast<const plan::Column&>(*node.expr).Index()));
+      break;
+    case plan::Expression::kFunc: {
+      const auto& fn = static_cast<const plan::ScalarFunc&>(*node.expr);
+      auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+      auto udf = id_to_udf_map_[fn.udf_id()].get();
+
+      // A UDF with an ExecBatch runs on the input's arrow arrays when all of its arguments are
+      // columns, so the columns aren't copied into column wrappers first. Filters on string
+      // columns, like px.contains(df.req_path, ...), take this path.
+      bool args_are_columns = std::all_of(node.args.begin(), node.args.end(), [&](size_t arg) {
+        return dag_.nodes()[arg].expr->ExpressionType() == plan::Expression::kColumn;
       });
-
-  walker.OnColumn(
-      [&](const plan::Column& col,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        DCHECK_EQ(children.size(), 0ULL);
-        return ColumnWrapper::FromArrow(input.ColumnAt(col.Index()));
-      });
-
-  walker.OnScalarFunc(
-      [&](const plan::ScalarFunc& fn,
-          const std::vector<types::SharedColumnWrapper>& children) -> types::SharedColumnWrapper {
-        std::vector<types::DataType> arg_types;
-        arg_types.reserve(children.size());
-        for (const auto& child : children) {
-          arg_types.emplace_back(child->data_type());
+      if (def->has_exec_batch() && args_are_columns) {
+        std::vector<arrow::Array*> raw_children;
+        raw_children.reserve(node.args.size());
+        for (size_t arg : node.args) {
+          const auto& col = static_cast<const plan::Column&>(*dag_.nodes()[arg].expr);
+          raw_children.push_back(input.ColumnAt(col.Index()).get());
         }
+        auto output = MakeArrowBuilder(def->exec_return_type(), mem_pool(exec_state));
+        auto start = StartUDFTimer();
+        PL_RETURN_IF_ERROR(
+            def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows));
+        StopUDFTimer(fn.name(), start);
+        std::shared_ptr<arrow::Array> arr;
+        PL_RETURN_IF_ERROR(output->Finish(&arr));
+        result = ColumnWrapper::FromArrow(arr);
+        break;
+      }
+
+      std::vector<types::SharedColumnWrapper> children;
+      std::vector<const types::ColumnWrapper*> raw_children;
+      children.reserve(node.args.size());
+      raw_children.reserve(node.args.size());
+      for (size_t arg : node.args) {
+        PL_ASSIGN_OR_RETURN(auto child, EvaluateNode(exec_state, input, arg));
+        raw_children.emplace_back(child.get());
+        children.push_back(std::move(child));
+      }
+
+      // Reuse the output of the last batch, unless it's still referenced outside the evaluator.
+      result = node_results_[node_idx];
+      if (result != nullptr && result.use_count() == 2) {
+        result->Resize(num_rows);
+      } else {
+        result = types::ColumnWrapper::Make(def->exec_return_type(), num_rows);
+      }
+      auto start = StartUDFTimer();
+      PL_RETURN_IF_ERROR(def->ExecBatch(udf, function_ctx_, raw_children, result.get(), num_rows));
+      StopUDFTimer(fn.name(), start);
+      break;
+    }
+    default:
+      return error::Internal("Unexpected expression in scalar expression: $0",
+                             node.expr->DebugString());
+  }
+  node_results_[node_idx] = result;
+  node_evaluated_[node_idx] = true;
+  return result;
+}
 
-        auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
-        auto udf = id_to_udf_map_[fn.udf_id()].get();
-
-        std::vector<const types::ColumnWrapper*> raw_children;
-        raw_children.reserve(children.size());
-        for (const auto& child : children) {
-          raw_children.emplace_back(child.get());
-        }
-        auto output = types::ColumnWrapper::Make(def->exec_return_type(), num_rows);
-        // TODO(zasgar): need a better way to handle errors.
-        PL_CHECK_OK(def->ExecBatch(udf, function_ctx_, raw_children, output.get(), num_rows));
-        return output;
-      });
+StatusOr<types::SharedColumnWrapper>
+VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
+    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr) {
+  CHECK(exec_state != nullptr);
+  CHECK_GT(input.num_columns(), 0);
 
-  return walker.Walk(expr);
+  auto node_idx = dag_.NodeFor(expr);
+  if (!node_idx.has_value()) {
+    return error::InvalidArgument("Expression $0 is not one of the evaluator's expressions",
+                                  expr.DebugString());
+  }
+  ResetNodeResults();
+  return EvaluateNode(exec_state, input, node_idx.value());
 }
 
 Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
@@ -227,11 +357,11 @@ Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
 
   // Since this evaluator uses vectors internally and the inputs/outputs
   // always have to be arrow::arrays, we just evaluate the case where the
-  // expression is a constant/column without using the expression walker.
+  // expression is a constant/column without going through the expression DAG.
   // Fast path for just having a constant.
   if (expr.ExpressionType() == plan::Expression::kConstant) {
     auto scalar_expr = static_cast<const plan::ScalarValue&>(expr);
-    auto arr = EvalScalarToArrow(exec_state, scalar_expr, num_rows);
+    auto arr = EvalScalarToArrow(mem_pool(exec_state), scalar_expr, num_rows);
     PL_RETURN_IF_ERROR(output->AddColumn(arr));
     return Status::OK();
   }
@@ -244,9 +374,13 @@ Status VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
     return Status::OK();
   }
 
-  PL_ASSIGN_OR_RETURN(auto result, VectorNativeScalarExpressionEvaluator::EvaluateSingleExpression(
-                                       exec_state, input, expr));
-  PL_RETURN_IF_ERROR(output->AddColumn(result->ConvertToArrow(exec_state->exec_mem_pool())));
+  auto node_idx = dag_.NodeFor(expr);
+  if (!node_idx.has_value()) {
+    return error::InvalidArgument("Expression $0 is not one of the evaluator's expressions",
+                                  expr.DebugString());
+  }
+  PL_ASSIGN_OR_RETURN(auto result, EvaluateNode(exec_state, input, node_idx.value()));
+  PL_RETURN_IF_ERROR(output->AddColumn(result->ConvertToArrow(mem_pool(exec_state))));
   return Status::OK();
 }
 
@@ -262,54 +396,344 @@ Status ArrowNativeScalarExpressionEvaluator::Close(ExecState*) {
   return Status();
 }
 
-Status exec::ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
-    exec::ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr,
-    RowBatch* output) {
+StatusOr<std::shared_ptr<arrow::Array>> ArrowNativeScalarExpressionEvaluator::EvaluateNode(
+    ExecState* exec_state, const RowBatch& input, size_t node_idx) {
+  if (node_evaluated_[node_idx]) {
+    return node_results_[node_idx];
+  }
+  const auto& node = dag_.nodes()[node_idx];
   size_t num_rows = input.num_rows();
-  plan::ExpressionWalker<std::shared_ptr<arrow::Array>> walker;
-  walker.OnScalarValue(
-      [&](const plan::ScalarValue& val, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
-        DCHECK_EQ(children.size(), 0ULL);
-        return EvalScalarToArrow(exec_state, val, num_rows);
-      });
 
-  walker.OnColumn(
-      [&](const plan::Column& col, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
-        DCHECK_EQ(children.size(), 0ULL);
-        return input.ColumnAt(col.Index());
-      });
+  std::shared_ptr<arrow::Array> result;
+  switch (node.expr->ExpressionType()) {
+    case plan::Expression::kConstant:
+      result = EvalScalarToArrow(mem_pool(exec_state),
+                                 static_cast<const plan::ScalarValue&>(*node.expr), num_rows);
+      break;
+    case plan::Expression::kColumn:
+      result = input.ColumnAt(static_cast<const plan::Column&>(*node.expr).Index());
+      break;
+    case plan::Expression::kFunc: {
+      const auto& fn = static_cast<const plan::ScalarFunc&>(*node.expr);
+      std::vector<std::shared_ptr<arrow::Array>> children;
+      std::vector<arrow::Array*> raw_children;
+      children.reserve(node.args.size());
+      raw_children.reserve(node.args.size());
+      for (size_t arg : node.args) {
+        PL_ASSIGN_OR_RETURN(auto child, EvaluateNode(exec_state, input, arg));
+        raw_children.push_back(child.get());
+        children.push_back(std::move(child));
+      }
+
+      auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+      auto udf = id_to_udf_map_[fn.udf_id()].get();
+      auto output = MakeArrowBuilder(def->exec_return_type(), mem_pool(exec_state));
+      auto start = StartUDFTimer();
+      PL_RETURN_IF_ERROR(
+          def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows));
+      StopUDFTimer(fn.name(), start);
+      PL_RETURN_IF_ERROR(output->Finish(&result));
+      break;
+    }
+    default:
+      return error::Internal("Unexpected expression in scalar expression: $0",
+                             node.expr->DebugString());
+  }
+  node_results_[node_idx] = result;
+  node_evaluated_[node_idx] = true;
+  return result;
+}
 
-  walker.OnScalarFunc(
-      [&](const plan::ScalarFunc& fn, const std::vector<std::shared_ptr<arrow::Array>>& children)
-          -> std::shared_ptr<arrow::Array> {
-        std::vector<types::DataType> arg_types;
-        arg_types.reserve(children.size());
-        for (const auto& child : children) {
-          arg_types.emplace_back(ArrowToDataType(child->type_id()));
-        }
+Status ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(
+    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr,
+    RowBatch* output) {
+  auto node_idx = dag_.NodeFor(expr);
+  if (!node_idx.has_value()) {
+    return error::InvalidArgument("Expression $0 is not one of the evaluator's expressions",
+                                  expr.DebugString());
+  }
+  PL_ASSIGN_OR_RETURN(auto result, EvaluateNode(exec_state, input, node_idx.value()));
+  PL_RETURN_IF_ERROR(output->AddColumn(result));
+  return Status::OK();
+}
 
-        auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
-        auto udf = id_to_udf_map_[fn.udf_id()].get();
+namespace {
+
+// Stores a constant the way the kernels store its type, returns false if there is no kernel type
+// for it.
+bool StoreScalarValue(const plan::ScalarValue& val, std::vector<uint64_t>* values) {
+  values->resize(1);
+  uint64_t* out = values->data();
+  switch (val.DataType()) {
+    case types::BOOLEAN: {
+      uint8_t value = val.BoolValue();
+      std::memcpy(out, &value, sizeof(value));
+      return true;
+    }
+    case types::INT64: {
+      int64_t value = val.Int64Value();
+      std::memcpy(out, &value, sizeof(value));
+      return true;
+    }
+    case types::TIME64NS: {
+      int64_t value = val.Time64NSValue();
+      std::memcpy(out, &value, sizeof(value));
+      return true;
+    }
+    case types::FLOAT64: {
+      double value = val.Float64Value();
+      std::memcpy(out, &value, sizeof(value));
+      return true;
+    }
+    case types::UINT128: {
+      // Split into its high and low halves, see scalar_kernels.h.
+      values->resize(2);
+      (*values)[0] = absl::Uint128High64(val.UInt128Value());
+      (*values)[1] = absl::Uint128Low64(val.UInt128Value());
+      return true;
+    }
+    default:
+      return false;
+  }
+}
 
-        auto output = MakeArrowBuilder(def->exec_return_type(), arrow::default_memory_pool());
+bool HasKernelType(DataType type) {
+  return type == types::BOOLEAN || type == types::INT64 || type == types::TIME64NS ||
+         type == types::FLOAT64 || type == types::UINT128;
+}
 
-        std::vector<arrow::Array*> raw_children;
-        raw_children.reserve(children.size());
-        for (const auto& child : children) {
-          raw_children.push_back(child.get());
-        }
+// valid is the validity of the values, or nullptr if they are all valid.
+template <typename TBuilder, typename TValue>
+StatusOr<std::shared_ptr<arrow::Array>> KernelValuesToArrow(arrow::MemoryPool* mem_pool,
+                                                            const void* data, const uint8_t* valid,
+                                                            bool scalar, int64_t count) {
+  const auto* values = static_cast<const TValue*>(data);
+  TBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(count));
+  if (scalar) {
+    for (int64_t i = 0; i < count; ++i) {
+      builder.UnsafeAppend(values[0]);
+    }
+  } else {
+    PL_RETURN_IF_ERROR(builder.AppendValues(values, count, valid));
+  }
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
 
-        PL_CHECK_OK(def->ExecBatchArrow(udf, function_ctx_, raw_children, output.get(), num_rows));
+}  // namespace
 
-        std::shared_ptr<arrow::Array> output_array;
-        PL_CHECK_OK(output->Finish(&output_array));
-        return output_array;
-      });
+Status CompiledScalarExpressionEvaluator::Open(ExecState* exec_state) {
+  PL_RETURN_IF_ERROR(ArrowNativeScalarExpressionEvaluator::Open(exec_state));
+  num_compiled_expressions_ = 0;
+  for (const auto& expr : expressions_) {
+    // Columns and constants are already evaluated without any UDF calls.
+    if (expr->ExpressionType() != plan::Expression::kFunc) {
+      continue;
+    }
+    if (CompileNode(exec_state, dag_.NodeFor(*expr).value(), types::DATA_TYPE_UNKNOWN)) {
+      ++num_compiled_expressions_;
+    }
+  }
+  return Status::OK();
+}
 
-  PL_ASSIGN_OR_RETURN(auto result, walker.Walk(expr));
+bool CompiledScalarExpressionEvaluator::CompileNode(ExecState* exec_state, size_t node_idx,
+                                                    DataType type) {
+  auto& compiled = compiled_nodes_[node_idx];
+  if (compiled.state != CompiledNode::State::kNotCompiled) {
+    return compiled.state == CompiledNode::State::kCompiled &&
+           (type == types::DATA_TYPE_UNKNOWN || type == compiled.type);
+  }
+  compiled.state = CompiledNode::State::kUnsupported;
+  const auto& node = dag_.nodes()[node_idx];
+  switch (node.expr->ExpressionType()) {
+    case plan::Expression::kConstant: {
+      const auto& val = static_cast<const plan::ScalarValue&>(*node.expr);
+      if (val.IsNull() || val.DataType() != type) {
+        return false;
+      }
+      if (!StoreScalarValue(val, &compiled.values)) {
+        return false;
+      }
+      compiled.scalar = true;
+      compiled.data = compiled.values.data();
+      break;
+    }
+    case plan::Expression::kColumn:
+      if (!HasKernelType(type)) {
+        return false;
+      }
+      compiled.column_idx = static_cast<const plan::Column&>(*node.expr).Index();
+      break;
+    case plan::Expression::kFunc: {
+      const auto& fn = static_cast<const plan::ScalarFunc&>(*node.expr);
+      auto def = exec_state->GetScalarUDFDefinition(fn.udf_id());
+      if (def == nullptr || (type != types::DATA_TYPE_UNKNOWN && type != def->exec_return_type())) {
+        return false;
+      }
+      const ScalarKernel* kernel = LookupScalarKernel(*def);
+      if (kernel == nullptr || kernel->arity != node.args.size()) {
+        return false;
+      }
+      bool all_scalar = true;
+      for (size_t i = 0; i < node.args.size(); ++i) {
+        if (!CompileNode(exec_state, node.args[i], def->exec_arguments()[i])) {
+          return false;
+        }
+        all_scalar = all_scalar && compiled_nodes_[node.args[i]].scalar;
+      }
+      const auto& a = compiled_nodes_[node.args[0]];
+      const auto* b = node.args.size() > 1 ? &compiled_nodes_[node.args[1]] : nullptr;
+      if (all_scalar) {
+        // Fold the call, its args are already known.
+        compiled.values.resize(1);
+        kernel->vector_vector(a.data, b != nullptr ? b->data : nullptr, compiled.values.data(), 1);
+        compiled.scalar = true;
+        compiled.data = compiled.values.data();
+      } else if (b != nullptr && b->scalar) {
+        compiled.kernel = kernel->vector_scalar;
+      } else if (a.scalar && b != nullptr) {
+        compiled.kernel = kernel->scalar_vector;
+      } else {
+        compiled.kernel = kernel->vector_vector;
+      }
+      type = def->exec_return_type();
+      break;
+    }
+    default:
+      return false;
+  }
+  compiled.type = type;
+  compiled.state = CompiledNode::State::kCompiled;
+  return true;
+}
+
+Status CompiledScalarExpressionEvaluator::Evaluate(ExecState* exec_state, const RowBatch& input,
+                                                   RowBatch* output) {
+  for (auto& compiled : compiled_nodes_) {
+    compiled.evaluated = compiled.scalar;
+  }
+  return ArrowNativeScalarExpressionEvaluator::Evaluate(exec_state, input, output);
+}
+
+Status CompiledScalarExpressionEvaluator::EvaluateCompiledNode(const RowBatch& input,
+                                                               size_t node_idx) {
+  auto& compiled = compiled_nodes_[node_idx];
+  if (compiled.evaluated) {
+    return Status::OK();
+  }
+  size_t num_rows = input.num_rows();
+  if (compiled.column_idx.has_value()) {
+    const arrow::Array* col = input.ColumnAt(compiled.column_idx.value()).get();
+    if (col->type_id() != types::ToArrowType(compiled.type)) {
+      return error::Internal("Column $0 is a $1, expected a $2", compiled.column_idx.value(),
+                             col->type()->ToString(), types::ToString(compiled.type));
+    }
+    compiled.has_nulls = col->null_count() != 0;
+    if (compiled.has_nulls) {
+      compiled.valid.resize(num_rows);
+      for (size_t i = 0; i < num_rows; ++i) {
+        compiled.valid[i] = col->IsValid(i);
+      }
+    }
+    switch (compiled.type) {
+      case types::BOOLEAN: {
+        // Booleans are bitmaps in arrow, the kernels use one byte per value.
+        const auto* bools = static_cast<const arrow::BooleanArray*>(col);
+        if (compiled.values.size() < num_rows) {
+          compiled.values.resize(num_rows);
+        }
+        auto* values = reinterpret_cast<uint8_t*>(compiled.values.data());
+        for (size_t i = 0; i < num_rows; ++i) {
+          values[i] = bools->Value(i);
+        }
+        compiled.data = values;
+        break;
+      }
+      case types::INT64:
+      case types::TIME64NS:
+        compiled.data = static_cast<const arrow::Int64Array*>(col)->raw_values();
+        break;
+      case types::FLOAT64:
+        compiled.data = static_cast<const arrow::DoubleArray*>(col)->raw_values();
+        break;
+      case types::UINT128:
+        // Split into their high and low halves, see scalar_kernels.h.
+        if (compiled.values.size() < 2 * num_rows) {
+          compiled.values.resize(2 * num_rows);
+        }
+        SplitUInt128Values(*col, compiled.values.data());
+        compiled.data = compiled.values.data();
+        break;
+      default:
+        return error::Internal("Unexpected column type: $0", types::ToString(compiled.type));
+    }
+  } else {
+    const auto& node = dag_.nodes()[node_idx];
+    compiled.has_nulls = false;
+    for (size_t arg : node.args) {
+      PL_RETURN_IF_ERROR(EvaluateCompiledNode(input, arg));
+      const auto& arg_node = compiled_nodes_[arg];
+      if (!arg_node.has_nulls) {
+        continue;
+      }
+      // The kernels run over the null rows too, which costs less than branching on each row, and
+      // the validity is and'ed in a separate pass.
+      if (!compiled.has_nulls) {
+        compiled.valid.assign(arg_node.valid.begin(), arg_node.valid.begin() + num_rows);
+        compiled.has_nulls = true;
+      } else {
+        for (size_t i = 0; i < num_rows; ++i) {
+          compiled.valid[i] &= arg_node.valid[i];
+        }
+      }
+    }
+    if (compiled.values.size() < num_rows) {
+      compiled.values.resize(num_rows);
+    }
+    const void* b = node.args.size() > 1 ? compiled_nodes_[node.args[1]].data : nullptr;
+    compiled.kernel(compiled_nodes_[node.args[0]].data, b, compiled.values.data(), num_rows);
+    compiled.data = compiled.values.data();
+  }
+  compiled.evaluated = true;
+  return Status::OK();
+}
 
+Status CompiledScalarExpressionEvaluator::EvaluateSingleExpression(
+    ExecState* exec_state, const RowBatch& input, const plan::ScalarExpression& expr,
+    RowBatch* output) {
+  auto node_idx = dag_.NodeFor(expr);
+  if (expr.ExpressionType() != plan::Expression::kFunc || !node_idx.has_value() ||
+      compiled_nodes_[node_idx.value()].state != CompiledNode::State::kCompiled) {
+    return ArrowNativeScalarExpressionEvaluator::EvaluateSingleExpression(exec_state, input, expr,
+                                                                          output);
+  }
+  PL_RETURN_IF_ERROR(EvaluateCompiledNode(input, node_idx.value()));
+  const auto& compiled = compiled_nodes_[node_idx.value()];
+  auto pool = mem_pool(exec_state);
+  int64_t num_rows = input.num_rows();
+  const uint8_t* valid = compiled.has_nulls ? compiled.valid.data() : nullptr;
+  std::shared_ptr<arrow::Array> result;
+  switch (compiled.type) {
+    case types::BOOLEAN:
+      PL_ASSIGN_OR_RETURN(result, (KernelValuesToArrow<arrow::BooleanBuilder, uint8_t>(
+                                      pool, compiled.data, valid, compiled.scalar, num_rows)));
+      break;
+    case types::INT64:
+    case types::TIME64NS:
+      PL_ASSIGN_OR_RETURN(result, (KernelValuesToArrow<arrow::Int64Builder, int64_t>(
+                                      pool, compiled.data, valid, compiled.scalar, num_rows)));
+      break;
+    case types::FLOAT64:
+      PL_ASSIGN_OR_RETURN(result, (KernelValuesToArrow<arrow::DoubleBuilder, double>(
+                                      pool, compiled.data, valid, compiled.scalar, num_rows)));
+      break;
+    default:
+      return error::Internal("Unexpected compiled expression type: $0",
+                             types::ToString(compiled.type));
+  }
   PL_RETURN_IF_ERROR(output->AddColumn(result));
   return Status::OK();
 }
@@ -19,14 +19,19 @@
 #pragma once
 
 #include <arrow/array.h>
+#include <chrono>
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/scalar_kernels.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/udf/base.h"
 #include "src/carnot/udf/udf.h"
@@ -38,13 +43,46 @@ namespace px {
 namespace carnot {
 namespace exec {
 
-std::shared_ptr<arrow::Array> EvalScalarToArrow(ExecState* exec_state, const plan::ScalarValue& val,
-                                                size_t count);
+std::shared_ptr<arrow::Array> EvalScalarToArrow(arrow::MemoryPool* mem_pool,
+                                                const plan::ScalarValue& val, size_t count);
 
 std::shared_ptr<types::ColumnWrapper> EvalScalarToColumnWrapper(ExecState*,
                                                                 const plan::ScalarValue& val,
                                                                 size_t count);
 
+/**
+ * ScalarExpressionDAG merges the identical subexpressions of a set of expressions into a single
+ * node, so that evaluators only compute them once per batch. For example, two map expressions
+ * that both call px.upid_to_pod_name(df.upid) share the node of that call.
+ */
+class ScalarExpressionDAG {
+ public:
+  struct Node {
+    const plan::ScalarExpression* expr;
+    // The nodes of the args, if expr is a ScalarFunc.
+    std::vector<size_t> args;
+  };
+
+  explicit ScalarExpressionDAG(const plan::ConstScalarExpressionVector& expressions);
+
+  // The nodes of the DAG, the args of a node always come before it.
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+  /**
+   * Returns the node of an expression, or nullopt if it isn't one of the expressions (or
+   * subexpressions) the DAG was built from.
+   */
+  std::optional<size_t> NodeFor(const plan::ScalarExpression& expr) const;
+
+ private:
+  size_t AddExpression(const plan::ScalarExpression& expr);
+
+  std::vector<Node> nodes_;
+  // Maps the key of an expression, which identifies it by its contents, to its node.
+  absl::flat_hash_map<std::string, size_t> node_by_key_;
+  absl::flat_hash_map<const plan::ScalarExpression*, size_t> node_by_expr_;
+};
+
 /**
  * Base expression evaluator class.
  */
@@ -89,6 +127,9 @@ class ExpressionEvaluator {
 enum class ScalarExpressionEvaluatorType : uint8_t {
   kVectorNative = 0,
   kArrowNative = 1,
+  // Evaluates the expressions that only use builtins with native kernels as vectorized loops,
+  // and falls back to kArrowNative for the others.
+  kCompiled = 2,
 };
 
 /**
@@ -98,7 +139,7 @@ class ScalarExpressionEvaluator : public ExpressionEvaluator {
  public:
   explicit ScalarExpressionEvaluator(plan::ConstScalarExpressionVector expressions,
                                      udf::FunctionContext* function_ctx)
-      : expressions_(std::move(expressions)), function_ctx_(function_ctx) {}
+      : expressions_(std::move(expressions)), function_ctx_(function_ctx), dag_(expressions_) {}
 
   /**
    * Creates a new Scalar expression evaluator.
@@ -114,16 +155,53 @@ class ScalarExpressionEvaluator : public ExpressionEvaluator {
                   table_store::schema::RowBatch* output) override;
   std::string DebugString() override;
 
+  // Sets the pool that results are allocated from, ie. the pool of the node that owns the
+  // evaluator. Defaults to the ExecState's pool.
+  void set_mem_pool(arrow::MemoryPool* mem_pool) { mem_pool_ = mem_pool; }
+
+  // Enables timing the batch execution of every UDF, which is reported by udf_exec_time_ns().
+  void set_collect_udf_stats(bool collect_udf_stats) { collect_udf_stats_ = collect_udf_stats; }
+  // The total time spent executing each UDF, keyed by the name of the UDF.
+  const absl::flat_hash_map<std::string, int64_t>& udf_exec_time_ns() const {
+    return udf_exec_time_ns_;
+  }
+
  protected:
+  std::chrono::steady_clock::time_point StartUDFTimer() const {
+    return collect_udf_stats_ ? std::chrono::steady_clock::now()
+                              : std::chrono::steady_clock::time_point();
+  }
+  void StopUDFTimer(const std::string& udf_name, std::chrono::steady_clock::time_point start) {
+    if (!collect_udf_stats_) {
+      return;
+    }
+    udf_exec_time_ns_[udf_name] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       std::chrono::steady_clock::now() - start)
+                                       .count();
+  }
+
+  arrow::MemoryPool* mem_pool(ExecState* exec_state) const {
+    return mem_pool_ != nullptr ? mem_pool_ : exec_state->exec_mem_pool();
+  }
+
   // Function called for each individual expression in expressions_.
   // Implement in derived class.
   virtual Status EvaluateSingleExpression(ExecState* exec_state,
                                           const table_store::schema::RowBatch& input,
                                           const plan::ScalarExpression& expr,
                                           table_store::schema::RowBatch* output) = 0;
+  // Marks the results of all the DAG nodes as stale, called before every batch.
+  void ResetNodeResults() { node_evaluated_.assign(dag_.nodes().size(), false); }
+
   plan::ConstScalarExpressionVector expressions_;
   udf::FunctionContext* function_ctx_ = nullptr;
   std::map<int64_t, std::unique_ptr<udf::ScalarUDF>> id_to_udf_map_;
+  ScalarExpressionDAG dag_;
+  // Whether the result of each DAG node has been computed for the current batch.
+  std::vector<bool> node_evaluated_;
+  arrow::MemoryPool* mem_pool_ = nullptr;
+  bool collect_udf_stats_ = false;
+  absl::flat_hash_map<std::string, int64_t> udf_exec_time_ns_;
 };
 
 /**
@@ -134,11 +212,15 @@ class VectorNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
  public:
   explicit VectorNativeScalarExpressionEvaluator(
       const plan::ConstScalarExpressionVector& expressions, udf::FunctionContext* function_ctx)
-      : ScalarExpressionEvaluator(expressions, function_ctx) {}
+      : ScalarExpressionEvaluator(expressions, function_ctx),
+        node_results_(dag_.nodes().size()) {}
 
   Status Open(ExecState* exec_state) override;
   Status Close(ExecState* exec_state) override;
 
+  /**
+   * Evaluates one of the expressions of the evaluator on its own.
+   */
   StatusOr<types::SharedColumnWrapper> EvaluateSingleExpression(
       ExecState* exec_state, const table_store::schema::RowBatch& input,
       const plan::ScalarExpression& expr);
@@ -147,6 +229,15 @@ class VectorNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
   Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
                                   const plan::ScalarExpression& expr,
                                   table_store::schema::RowBatch* output) override;
+
+ private:
+  StatusOr<types::SharedColumnWrapper> EvaluateNode(ExecState* exec_state,
+                                                    const table_store::schema::RowBatch& input,
+                                                    size_t node_idx);
+
+  // The result of each DAG node. The results of functions are written into the same column
+  // wrapper every batch, so they are only allocated once.
+  std::vector<types::SharedColumnWrapper> node_results_;
 };
 
 /**
@@ -156,7 +247,8 @@ class ArrowNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
  public:
   explicit ArrowNativeScalarExpressionEvaluator(
       const plan::ConstScalarExpressionVector& expressions, udf::FunctionContext* function_ctx)
-      : ScalarExpressionEvaluator(expressions, function_ctx) {}
+      : ScalarExpressionEvaluator(expressions, function_ctx),
+        node_results_(dag_.nodes().size()) {}
 
   Status Open(ExecState* exec_state) override;
   Status Close(ExecState* exec_state) override;
@@ -165,6 +257,69 @@ class ArrowNativeScalarExpressionEvaluator : public ScalarExpressionEvaluator {
   Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
                                   const plan::ScalarExpression& expr,
                                   table_store::schema::RowBatch* output) override;
+
+ private:
+  StatusOr<std::shared_ptr<arrow::Array>> EvaluateNode(ExecState* exec_state,
+                                                       const table_store::schema::RowBatch& input,
+                                                       size_t node_idx);
+
+  std::vector<std::shared_ptr<arrow::Array>> node_results_;
+};
+
+/**
+ * A scalar expression evaluator that compiles the expressions that are made up only of columns,
+ * constants and UDFs with a native kernel (see scalar_kernels.h) into the kernels of their
+ * nodes. Those run directly over the values of the input columns, without the UDF wrappers or
+ * intermediate arrow arrays, and constant subexpressions are folded when compiling. Every other
+ * expression is evaluated by the arrow native evaluator.
+ */
+class CompiledScalarExpressionEvaluator : public ArrowNativeScalarExpressionEvaluator {
+ public:
+  explicit CompiledScalarExpressionEvaluator(const plan::ConstScalarExpressionVector& expressions,
+                                             udf::FunctionContext* function_ctx)
+      : ArrowNativeScalarExpressionEvaluator(expressions, function_ctx),
+        compiled_nodes_(dag_.nodes().size()) {}
+
+  Status Open(ExecState* exec_state) override;
+  Status Evaluate(ExecState* exec_state, const table_store::schema::RowBatch& input,
+                  table_store::schema::RowBatch* output) override;
+
+  // The number of expressions that are evaluated by kernels, known after Open.
+  size_t num_compiled_expressions() const { return num_compiled_expressions_; }
+
+ protected:
+  Status EvaluateSingleExpression(ExecState* exec_state, const table_store::schema::RowBatch& input,
+                                  const plan::ScalarExpression& expr,
+                                  table_store::schema::RowBatch* output) override;
+
+ private:
+  struct CompiledNode {
+    enum class State : uint8_t { kNotCompiled, kCompiled, kUnsupported };
+    State state = State::kNotCompiled;
+    types::DataType type = types::DATA_TYPE_UNKNOWN;
+    // Whether the node has the same value for every row, ie. it's a constant or it was folded.
+    bool scalar = false;
+    std::optional<int64_t> column_idx;
+    ScalarKernelFn kernel = nullptr;
+    // The values the kernel writes, the unpacked values of a boolean column or the value of a
+    // scalar, as the kernels store them.
+    std::vector<uint64_t> values;
+    // The values of the node for the current batch.
+    const void* data = nullptr;
+    // The validity of the values for the current batch, as one byte per value (0 for a null), if
+    // any of them is null. A call is null where any of its args is.
+    std::vector<uint8_t> valid;
+    bool has_nulls = false;
+    bool evaluated = false;
+  };
+
+  // Compiles the node, whose values must have the given type unless it's unknown. Returns
+  // whether it could be compiled.
+  bool CompileNode(ExecState* exec_state, size_t node_idx, types::DataType type);
+  Status EvaluateCompiledNode(const table_store::schema::RowBatch& input, size_t node_idx);
+
+  std::vector<CompiledNode> compiled_nodes_;
+  size_t num_compiled_expressions_ = 0;
 };
 
 }  // namespace exec
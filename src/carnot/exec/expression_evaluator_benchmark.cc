@@ -29,6 +29,7 @@
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
 #include "src/carnot/exec/test_utils.h"
+#include "src/carnot/funcs/builtins/math_ops.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
@@ -53,19 +54,15 @@ using px::carnot::planpb::testutils::kAddScalarFuncNestedPbtxt;
 using px::carnot::planpb::testutils::kAddScalarFuncPbtxt;
 using px::carnot::planpb::testutils::kColumnReferencePbtxt;
 using px::carnot::planpb::testutils::kScalarInt64ValuePbtxt;
-using px::carnot::udf::FunctionContext;
 using px::carnot::udf::Registry;
-using px::carnot::udf::ScalarUDF;
 using px::table_store::schema::RowBatch;
 using px::table_store::schema::RowDescriptor;
 using px::types::DataType;
 using px::types::Int64Value;
 using px::types::ToArrow;
 
-class AddUDF : public ScalarUDF {
- public:
-  Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
-};
+// The builtin add, which the compiled evaluator has a kernel for.
+using AddUDF = px::carnot::builtins::AddUDF<Int64Value, Int64Value, Int64Value>;
 
 // NOLINTNEXTLINE : runtime/references.
 void BM_ScalarExpressionTwoCols(benchmark::State& state,
@@ -83,6 +80,7 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
   PL_CHECK_OK(func_registry->Register<AddUDF>("add"));
   auto exec_state = std::make_unique<ExecState>(
       func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "add", {DataType::INT64, DataType::INT64}));
 
   auto in1 = px::datagen::CreateLargeData<Int64Value>(data_size);
   auto in2 = px::datagen::CreateLargeData<Int64Value>(data_size);
@@ -108,6 +106,50 @@ void BM_ScalarExpressionTwoCols(benchmark::State& state,
   state.SetBytesProcessed(int64_t(state.iterations()) * 2 * in1.size() * sizeof(int64_t));
 }
 
+// Evaluates num_exprs copies of the expression on every batch with the same evaluator, like a map
+// that computes several columns off the same subexpression.
+// NOLINTNEXTLINE : runtime/references.
+void BM_ScalarExpressionsShared(benchmark::State& state,
+                                const ScalarExpressionEvaluatorType& eval_type, const char* pbtxt,
+                                size_t num_exprs) {
+  px::carnot::planpb::ScalarExpression se_pb;
+  size_t data_size = state.range(0);
+  google::protobuf::TextFormat::MergeFromString(pbtxt, &se_pb);
+  px::carnot::plan::ConstScalarExpressionVector exprs;
+  for (size_t i = 0; i < num_exprs; ++i) {
+    auto s_or_se = px::carnot::plan::ScalarExpression::FromProto(se_pb);
+    CHECK(s_or_se.ok());
+    exprs.push_back(s_or_se.ConsumeValueOrDie());
+  }
+
+  auto func_registry = std::make_unique<Registry>("test_registry");
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  PL_CHECK_OK(func_registry->Register<AddUDF>("add"));
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "add", {DataType::INT64, DataType::INT64}));
+
+  auto in1 = px::datagen::CreateLargeData<Int64Value>(data_size);
+  auto in2 = px::datagen::CreateLargeData<Int64Value>(data_size);
+  RowDescriptor rd({DataType::INT64, DataType::INT64});
+  auto input_rb = std::make_unique<RowBatch>(rd, in1.size());
+  PL_CHECK_OK(input_rb->AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+  PL_CHECK_OK(input_rb->AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+
+  auto function_ctx = std::make_unique<px::carnot::udf::FunctionContext>(nullptr, nullptr);
+  auto evaluator = ScalarExpressionEvaluator::Create(exprs, eval_type, function_ctx.get());
+  PL_CHECK_OK(evaluator->Open(exec_state.get()));
+  RowDescriptor rd_output(std::vector<DataType>(num_exprs, DataType::INT64));
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    RowBatch output_rb(rd_output, input_rb->num_rows());
+    PL_CHECK_OK(evaluator->Evaluate(exec_state.get(), *input_rb, &output_rb));
+    benchmark::DoNotOptimize(output_rb);
+  }
+  PL_CHECK_OK(evaluator->Close(exec_state.get()));
+  state.SetBytesProcessed(int64_t(state.iterations()) * 2 * in1.size() * sizeof(int64_t));
+}
+
 BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, eval_col_arrow,
                   ScalarExpressionEvaluatorType::kArrowNative, kColumnReferencePbtxt)
     ->RangeMultiplier(2)
@@ -143,3 +185,21 @@ BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_simple_add_vector,
                   ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt)
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionsShared, four_shared_add_nested_arrow,
+                  ScalarExpressionEvaluatorType::kArrowNative, kAddScalarFuncNestedPbtxt, 4)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionsShared, four_shared_add_nested_native,
+                  ScalarExpressionEvaluatorType::kVectorNative, kAddScalarFuncNestedPbtxt, 4)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_ScalarExpressionTwoCols, two_cols_add_nested_compiled,
+                  ScalarExpressionEvaluatorType::kCompiled, kAddScalarFuncNestedPbtxt)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_CAPTURE(BM_ScalarExpressionsShared, four_shared_add_nested_compiled,
+                  ScalarExpressionEvaluatorType::kCompiled, kAddScalarFuncNestedPbtxt, 4)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
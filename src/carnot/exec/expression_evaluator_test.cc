@@ -18,6 +18,8 @@
 
 #include "src/carnot/exec/expression_evaluator.h"
 
+#include <arrow/array.h>
+#include <arrow/builder.h>
 #include <arrow/memory_pool.h>
 #include <arrow/type_fwd.h>
 #include <memory>
@@ -30,6 +32,8 @@
 
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/test_utils.h"
+#include "src/carnot/funcs/builtins/math_ops.h"
+#include "src/carnot/funcs/metadata/metadata_ops.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/planpb/test_proto.h"
@@ -56,8 +60,32 @@ using udf::FunctionContext;
 class AddUDF : public udf::ScalarUDF {
  public:
   types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    ++num_calls;
     return v1.val + v2.val;
   }
+
+  static inline int64_t num_calls = 0;
+};
+
+class AddBatchUDF : public udf::ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    ++num_exec_calls;
+    return v1.val + v2.val;
+  }
+
+  Status ExecBatch(FunctionContext*, const arrow::Int64Array& v1, const arrow::Int64Array& v2,
+                   arrow::Int64Builder* out, size_t count) {
+    ++num_batch_calls;
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(v1.Value(idx) + v2.Value(idx));
+    }
+    return Status::OK();
+  }
+
+  static inline int64_t num_exec_calls = 0;
+  static inline int64_t num_batch_calls = 0;
 };
 
 std::shared_ptr<plan::ScalarExpression> AddScalarExpr() {
@@ -99,10 +127,14 @@ class ScalarExpressionTest : public ::testing::TestWithParam<ScalarExpressionEva
     auto table_store = std::make_shared<table_store::TableStore>();
 
     EXPECT_TRUE(func_registry_->Register<AddUDF>("add").ok());
+    EXPECT_TRUE(func_registry_->Register<AddBatchUDF>("add_batch").ok());
     exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
                                               MockResultSinkStubGenerator, sole::uuid4(), nullptr);
     EXPECT_OK(exec_state_->AddScalarUDF(
         0, "add", std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
+    EXPECT_OK(exec_state_->AddScalarUDF(
+        1, "add_batch",
+        std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
 
     std::vector<types::Int64Value> in1 = {1, 2, 3};
     std::vector<types::Int64Value> in2 = {3, 4, 5};
@@ -135,7 +167,8 @@ class ScalarExpressionTest : public ::testing::TestWithParam<ScalarExpressionEva
 
 INSTANTIATE_TEST_SUITE_P(TestVecAndArrow, ScalarExpressionTest,
                          ::testing::Values(ScalarExpressionEvaluatorType::kVectorNative,
-                                           ScalarExpressionEvaluatorType::kArrowNative));
+                                           ScalarExpressionEvaluatorType::kArrowNative,
+                                           ScalarExpressionEvaluatorType::kCompiled));
 
 TEST_P(ScalarExpressionTest, basic_tests) {
   RowDescriptor rd_output({types::DataType::INT64});
@@ -210,6 +243,339 @@ TEST_P(ScalarExpressionTest, eval_uint128_constant) {
   EXPECT_EQ(types::UInt128Value(123, 456), casted->Value(2));
 }
 
+TEST_P(ScalarExpressionTest, shared_subexpressions_evaluated_once) {
+  RowDescriptor rd_output({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+  RowBatch output_rb(rd_output, input_rb_->num_rows());
+
+  // Both nested expressions are the same. The third one only shares the column and the constant
+  // with them.
+  auto se1 = ScalarExpressionOf(kAddScalarFuncNestedPbtxt);
+  auto se2 = ScalarExpressionOf(kAddScalarFuncNestedPbtxt);
+  auto se3 = ScalarExpressionOf(kAddScalarFuncConstPbtxt);
+  AddUDF::num_calls = 0;
+  RunEvaluator({se1, se2, se3}, &output_rb);
+  // The inner and outer add of the nested expression and the add of the third one, for 3 rows.
+  EXPECT_EQ(9, AddUDF::num_calls);
+
+  for (int64_t col = 0; col < 2; ++col) {
+    auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(col).get());
+    EXPECT_EQ(1341, casted->Value(0));
+    EXPECT_EQ(1343, casted->Value(1));
+    EXPECT_EQ(1345, casted->Value(2));
+  }
+  auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(2).get());
+  EXPECT_EQ(1338, casted->Value(0));
+  EXPECT_EQ(1339, casted->Value(1));
+  EXPECT_EQ(1340, casted->Value(2));
+}
+
+TEST_P(ScalarExpressionTest, multiple_batches) {
+  auto se = ScalarExpressionOf(kAddScalarFuncNestedPbtxt);
+  function_ctx_ = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  auto evaluator = ScalarExpressionEvaluator::Create({se}, GetParam(), function_ctx_.get());
+  ASSERT_OK(evaluator->Open(exec_state_.get()));
+
+  RowDescriptor rd_output({types::DataType::INT64});
+  RowBatch output_rb1(rd_output, input_rb_->num_rows());
+  ASSERT_OK(evaluator->Evaluate(exec_state_.get(), *input_rb_, &output_rb1));
+
+  // The second batch is smaller, and nothing of the first batch should be reused.
+  std::vector<types::Int64Value> in1 = {10};
+  std::vector<types::Int64Value> in2 = {20};
+  RowBatch input_rb2(RowDescriptor({types::DataType::INT64, types::DataType::INT64}), 1);
+  ASSERT_OK(input_rb2.AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+  ASSERT_OK(input_rb2.AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+  RowBatch output_rb2(rd_output, input_rb2.num_rows());
+  ASSERT_OK(evaluator->Evaluate(exec_state_.get(), input_rb2, &output_rb2));
+  ASSERT_OK(evaluator->Close(exec_state_.get()));
+
+  auto casted1 = static_cast<arrow::Int64Array*>(output_rb1.ColumnAt(0).get());
+  EXPECT_EQ(3, casted1->length());
+  EXPECT_EQ(1341, casted1->Value(0));
+  EXPECT_EQ(1345, casted1->Value(2));
+  auto casted2 = static_cast<arrow::Int64Array*>(output_rb2.ColumnAt(0).get());
+  EXPECT_EQ(1, casted2->length());
+  EXPECT_EQ(1367, casted2->Value(0));
+}
+
+// add_batch(col0, col1)
+constexpr char kAddBatchColumnsPbtxt[] = R"(
+func {
+  name: "add_batch"
+  id: 1
+  args {
+    column {
+      node: 0
+      index: 0
+    }
+  }
+  args {
+    column {
+      node: 0
+      index: 1
+    }
+  }
+  args_data_types: INT64
+  args_data_types: INT64
+})";
+
+TEST_P(ScalarExpressionTest, exec_batch_on_columns) {
+  RowDescriptor rd_output({types::DataType::INT64});
+  RowBatch output_rb(rd_output, input_rb_->num_rows());
+
+  auto se = ScalarExpressionOf(kAddBatchColumnsPbtxt);
+  AddBatchUDF::num_exec_calls = 0;
+  AddBatchUDF::num_batch_calls = 0;
+  RunEvaluator({se}, &output_rb);
+
+  // Every evaluator runs the UDF on the arrow arrays of the columns, once for the batch.
+  EXPECT_EQ(0, AddBatchUDF::num_exec_calls);
+  EXPECT_EQ(1, AddBatchUDF::num_batch_calls);
+  auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(0).get());
+  EXPECT_EQ(4, casted->Value(0));
+  EXPECT_EQ(6, casted->Value(1));
+  EXPECT_EQ(8, casted->Value(2));
+}
+
+TEST_F(ScalarExpressionTest, compiled_skips_udfs_named_like_builtins) {
+  RowDescriptor rd_output({types::DataType::INT64});
+  RowBatch output_rb(rd_output, input_rb_->num_rows());
+
+  auto se = AddScalarExpr();
+  function_ctx_ = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  CompiledScalarExpressionEvaluator evaluator({se}, function_ctx_.get());
+  ASSERT_OK(evaluator.Open(exec_state_.get()));
+  AddUDF::num_calls = 0;
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), *input_rb_, &output_rb));
+  ASSERT_OK(evaluator.Close(exec_state_.get()));
+
+  // The test add UDF isn't the builtin one, so it's still called.
+  EXPECT_EQ(0, evaluator.num_compiled_expressions());
+  EXPECT_EQ(3, AddUDF::num_calls);
+  auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(0).get());
+  EXPECT_EQ(4, casted->Value(0));
+  EXPECT_EQ(8, casted->Value(2));
+}
+
+// add(multiply(col0, 2), col1)
+constexpr char kMultiplyAddPbtxt[] = R"(
+func {
+  name: "add"
+  id: 1
+  args {
+    func {
+      name: "multiply"
+      id: 0
+      args { column { index: 0 } }
+      args { constant { data_type: INT64, int64_value: 2 } }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args { column { index: 1 } }
+  args_data_types: INT64
+  args_data_types: INT64
+})";
+
+// greaterThan(col0, add(1, 1))
+constexpr char kGreaterThanFoldedPbtxt[] = R"(
+func {
+  name: "greaterThan"
+  id: 2
+  args { column { index: 0 } }
+  args {
+    func {
+      name: "add"
+      id: 1
+      args { constant { data_type: INT64, int64_value: 1 } }
+      args { constant { data_type: INT64, int64_value: 1 } }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: INT64
+  args_data_types: INT64
+})";
+
+// abs(col0)
+constexpr char kAbsPbtxt[] = R"(
+func {
+  name: "abs"
+  id: 3
+  args { column { index: 0 } }
+  args_data_types: INT64
+})";
+
+// equal(col0, UInt128(123, 456))
+constexpr char kUInt128EqualPbtxt[] = R"(
+func {
+  name: "equal"
+  id: 4
+  args { column { index: 0 } }
+  args { constant { data_type: UINT128, uint128_value { high: 123, low: 456 } } }
+  args_data_types: UINT128
+  args_data_types: UINT128
+})";
+
+// upid_to_asid(col0)
+constexpr char kUPIDToASIDPbtxt[] = R"(
+func {
+  name: "upid_to_asid"
+  id: 5
+  args { column { index: 0 } }
+  args_data_types: UINT128
+})";
+
+class CompiledScalarExpressionTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    builtins::RegisterMathOpsOrDie(func_registry_.get());
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(),
+                                              std::make_shared<table_store::TableStore>(),
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+    std::vector<types::DataType> int64_args({types::DataType::INT64, types::DataType::INT64});
+    EXPECT_OK(exec_state_->AddScalarUDF(0, "multiply", int64_args));
+    EXPECT_OK(exec_state_->AddScalarUDF(1, "add", int64_args));
+    EXPECT_OK(exec_state_->AddScalarUDF(2, "greaterThan", int64_args));
+    EXPECT_OK(exec_state_->AddScalarUDF(3, "abs", {types::DataType::INT64}));
+    func_registry_->RegisterOrDie<funcs::metadata::UPIDToASIDUDF>("upid_to_asid");
+    std::vector<types::DataType> uint128_args({types::DataType::UINT128, types::DataType::UINT128});
+    EXPECT_OK(exec_state_->AddScalarUDF(4, "equal", uint128_args));
+    EXPECT_OK(exec_state_->AddScalarUDF(5, "upid_to_asid", {types::DataType::UINT128}));
+
+    std::vector<types::Int64Value> in1 = {1, 2, 3};
+    std::vector<types::Int64Value> in2 = {3, 4, 5};
+    input_rb_ = std::make_unique<RowBatch>(
+        RowDescriptor({types::DataType::INT64, types::DataType::INT64}), in1.size());
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+    EXPECT_OK(input_rb_->AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+    function_ctx_ = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  }
+
+ protected:
+  std::unique_ptr<udf::Registry> func_registry_;
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<RowBatch> input_rb_;
+  std::unique_ptr<udf::FunctionContext> function_ctx_;
+};
+
+TEST_F(CompiledScalarExpressionTest, compiled_and_fallback_expressions) {
+  CompiledScalarExpressionEvaluator evaluator(
+      {ScalarExpressionOf(kMultiplyAddPbtxt), ScalarExpressionOf(kGreaterThanFoldedPbtxt),
+       ScalarExpressionOf(kAbsPbtxt)},
+      function_ctx_.get());
+  ASSERT_OK(evaluator.Open(exec_state_.get()));
+  // abs has no kernel, so it's evaluated by calling its UDF.
+  EXPECT_EQ(2, evaluator.num_compiled_expressions());
+
+  RowBatch output_rb(
+      RowDescriptor({types::DataType::INT64, types::DataType::BOOLEAN, types::DataType::INT64}),
+      input_rb_->num_rows());
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), *input_rb_, &output_rb));
+  ASSERT_OK(evaluator.Close(exec_state_.get()));
+
+  auto sums = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(0).get());
+  ASSERT_EQ(3, sums->length());
+  EXPECT_EQ(5, sums->Value(0));
+  EXPECT_EQ(8, sums->Value(1));
+  EXPECT_EQ(11, sums->Value(2));
+  auto greater = static_cast<arrow::BooleanArray*>(output_rb.ColumnAt(1).get());
+  ASSERT_EQ(3, greater->length());
+  EXPECT_FALSE(greater->Value(0));
+  EXPECT_FALSE(greater->Value(1));
+  EXPECT_TRUE(greater->Value(2));
+  auto abs = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(2).get());
+  ASSERT_EQ(3, abs->length());
+  EXPECT_EQ(1, abs->Value(0));
+  EXPECT_EQ(3, abs->Value(2));
+}
+
+TEST_F(CompiledScalarExpressionTest, multiple_batches) {
+  CompiledScalarExpressionEvaluator evaluator({ScalarExpressionOf(kMultiplyAddPbtxt)},
+                                              function_ctx_.get());
+  ASSERT_OK(evaluator.Open(exec_state_.get()));
+  RowDescriptor rd_output({types::DataType::INT64});
+  RowBatch output_rb1(rd_output, input_rb_->num_rows());
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), *input_rb_, &output_rb1));
+
+  std::vector<types::Int64Value> in1 = {10};
+  std::vector<types::Int64Value> in2 = {20};
+  RowBatch input_rb2(RowDescriptor({types::DataType::INT64, types::DataType::INT64}), 1);
+  ASSERT_OK(input_rb2.AddColumn(ToArrow(in1, arrow::default_memory_pool())));
+  ASSERT_OK(input_rb2.AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+  RowBatch output_rb2(rd_output, input_rb2.num_rows());
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), input_rb2, &output_rb2));
+  ASSERT_OK(evaluator.Close(exec_state_.get()));
+
+  // The first output must not be overwritten by the second batch.
+  auto casted1 = static_cast<arrow::Int64Array*>(output_rb1.ColumnAt(0).get());
+  EXPECT_EQ(3, casted1->length());
+  EXPECT_EQ(5, casted1->Value(0));
+  auto casted2 = static_cast<arrow::Int64Array*>(output_rb2.ColumnAt(0).get());
+  EXPECT_EQ(1, casted2->length());
+  EXPECT_EQ(40, casted2->Value(0));
+}
+
+TEST_F(CompiledScalarExpressionTest, uint128_expressions) {
+  CompiledScalarExpressionEvaluator evaluator(
+      {ScalarExpressionOf(kUInt128EqualPbtxt), ScalarExpressionOf(kUPIDToASIDPbtxt)},
+      function_ctx_.get());
+  ASSERT_OK(evaluator.Open(exec_state_.get()));
+  EXPECT_EQ(2, evaluator.num_compiled_expressions());
+
+  // The values differ from the constant in either half.
+  std::vector<types::UInt128Value> upids = {types::UInt128Value(123, 456),
+                                            types::UInt128Value(123, 457),
+                                            types::UInt128Value(124, 456),
+                                            types::UInt128Value(7ULL << 32 | 1, 456)};
+  RowBatch input_rb(RowDescriptor({types::DataType::UINT128}), upids.size());
+  ASSERT_OK(input_rb.AddColumn(ToArrow(upids, arrow::default_memory_pool())));
+  RowBatch output_rb(RowDescriptor({types::DataType::BOOLEAN, types::DataType::INT64}),
+                     input_rb.num_rows());
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), input_rb, &output_rb));
+  ASSERT_OK(evaluator.Close(exec_state_.get()));
+
+  auto equal = static_cast<arrow::BooleanArray*>(output_rb.ColumnAt(0).get());
+  ASSERT_EQ(4, equal->length());
+  EXPECT_TRUE(equal->Value(0));
+  EXPECT_FALSE(equal->Value(1));
+  EXPECT_FALSE(equal->Value(2));
+  EXPECT_FALSE(equal->Value(3));
+  auto asids = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(1).get());
+  ASSERT_EQ(4, asids->length());
+  EXPECT_EQ(0, asids->Value(0));
+  EXPECT_EQ(7, asids->Value(3));
+}
+
+TEST_F(CompiledScalarExpressionTest, nulls) {
+  CompiledScalarExpressionEvaluator evaluator({ScalarExpressionOf(kMultiplyAddPbtxt)},
+                                              function_ctx_.get());
+  ASSERT_OK(evaluator.Open(exec_state_.get()));
+
+  arrow::Int64Builder builder;
+  ASSERT_TRUE(builder.Append(1).ok());
+  ASSERT_TRUE(builder.AppendNull().ok());
+  ASSERT_TRUE(builder.Append(3).ok());
+  std::shared_ptr<arrow::Array> in1;
+  ASSERT_TRUE(builder.Finish(&in1).ok());
+  std::vector<types::Int64Value> in2 = {3, 4, 5};
+  RowBatch input_rb(RowDescriptor({types::DataType::INT64, types::DataType::INT64}), 3);
+  ASSERT_OK(input_rb.AddColumn(in1));
+  ASSERT_OK(input_rb.AddColumn(ToArrow(in2, arrow::default_memory_pool())));
+  RowBatch output_rb(RowDescriptor({types::DataType::INT64}), input_rb.num_rows());
+  ASSERT_OK(evaluator.Evaluate(exec_state_.get(), input_rb, &output_rb));
+  ASSERT_OK(evaluator.Close(exec_state_.get()));
+
+  // The null of the column is carried through both calls.
+  auto casted = static_cast<arrow::Int64Array*>(output_rb.ColumnAt(0).get());
+  ASSERT_EQ(3, casted->length());
+  EXPECT_EQ(1, casted->null_count());
+  EXPECT_EQ(5, casted->Value(0));
+  EXPECT_TRUE(casted->IsNull(1));
+  EXPECT_EQ(11, casted->Value(2));
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
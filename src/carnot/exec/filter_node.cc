@@ -27,8 +27,10 @@
 #include <utility>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/gather_values.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/udf/udf_wrapper.h"
@@ -62,6 +64,8 @@ Status FilterNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
   evaluator_ = std::make_unique<VectorNativeScalarExpressionEvaluator>(
       plan::ConstScalarExpressionVector{plan_node_->expression()}, function_ctx_.get());
+  evaluator_->set_mem_pool(mem_pool());
+  evaluator_->set_collect_udf_stats(stats()->collect_exec_stats);
   return Status::OK();
 }
 
@@ -71,61 +75,10 @@ Status FilterNode::OpenImpl(ExecState* exec_state) {
 }
 
 Status FilterNode::CloseImpl(ExecState* exec_state) {
-  PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
-  return Status::OK();
-}
-
-template <types::DataType T>
-Status PredicateCopyValues(const types::BoolValueColumnWrapper& pred, const arrow::Array* input_col,
-                           RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  auto output_col_builder_generic = MakeArrowBuilder(T, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-  PL_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      output_col_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, idx));
-    }
-  }
-  std::shared_ptr<arrow::Array> output_array;
-  PL_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PL_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
-  return Status::OK();
-}
-
-template <>
-Status PredicateCopyValues<types::STRING>(const types::BoolValueColumnWrapper& pred,
-                                          const arrow::Array* input_col, RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  size_t reserved =
-      100;  // This can be an arbritrary number, since we do exponential doubling below.
-  size_t total_size = 0;
-
-  auto output_col_builder_generic = MakeArrowBuilder(types::STRING, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<types::DataTypeTraits<types::STRING>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-
-  PL_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  PL_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      auto res = types::GetValueFromArrowArray<types::STRING>(input_col, idx);
-      total_size += res.size();
-      while (total_size >= reserved) {
-        reserved *= 2;
-      }
-      PL_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-      output_col_builder->UnsafeAppend(std::move(res));
-    }
+  for (const auto& [udf_name, time_ns] : evaluator_->udf_exec_time_ns()) {
+    stats()->AddExtraMetric(absl::StrCat("udf_time_ns.", udf_name), time_ns);
   }
-  std::shared_ptr<arrow::Array> output_array;
-  PL_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PL_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
+  PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
   return Status::OK();
 }
 
@@ -144,22 +97,38 @@ Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, si
 
   DCHECK_EQ(static_cast<size_t>(rb.num_rows()), num_pred);
 
-  // Find out how many of them returned true;
+  // Build the selection vector: the indices of the rows that passed. The loop writes every index
+  // and only advances past the ones that passed, so it has no data dependent branch.
+  selection_.resize(num_pred);
   size_t num_output_records = 0;
   for (size_t i = 0; i < num_pred; ++i) {
-    if (pred_col_wrapper[i].val) {
-      ++num_output_records;
-    }
+    selection_[num_output_records] = i;
+    num_output_records += pred_col_wrapper[i].val;
   }
+  // When the selected rows are a single run (which includes all or none of the rows), the output
+  // columns are slices of the input columns, which share their buffers instead of copying them.
+  bool contiguous = num_output_records == 0 ||
+                    selection_[num_output_records - 1] - selection_[0] + 1 ==
+                        static_cast<int64_t>(num_output_records);
+  int64_t slice_offset = num_output_records == 0 ? 0 : selection_[0];
 
   RowBatch output_rb(*output_descriptor_, num_output_records);
   DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
 
   for (const auto& [output_col_idx, input_col_idx] : Enumerate(plan_node_->selected_cols())) {
     auto input_col = rb.ColumnAt(input_col_idx);
+    if (num_output_records == num_pred) {
+      PL_RETURN_IF_ERROR(output_rb.AddColumn(input_col));
+      continue;
+    }
+    if (contiguous) {
+      PL_RETURN_IF_ERROR(output_rb.AddColumn(input_col->Slice(slice_offset, num_output_records)));
+      continue;
+    }
     auto col_type = output_descriptor_->type(output_col_idx);
-#define TYPE_CASE(_dt_) \
-  PL_RETURN_IF_ERROR(PredicateCopyValues<_dt_>(pred_col_wrapper, input_col.get(), &output_rb));
+#define TYPE_CASE(_dt_)                                                                   \
+  PL_RETURN_IF_ERROR(                                                                     \
+      GatherValues<_dt_>(selection_, num_output_records, input_col.get(), &output_rb));
     PL_SWITCH_FOREACH_DATATYPE(col_type, TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -54,6 +54,9 @@ class FilterNode : public ProcessingNode {
   std::unique_ptr<VectorNativeScalarExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::FilterOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
+  // The indices of the rows of the current batch that pass the filter. Kept across batches to
+  // reuse the allocation.
+  std::vector<int64_t> selection_;
 };
 
 }  // namespace exec
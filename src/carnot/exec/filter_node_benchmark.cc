@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/memory_pool.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/filter_node.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+#include "src/carnot/udf/udf.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+using px::carnot::exec::ExecState;
+using px::carnot::exec::FilterNode;
+using px::carnot::exec::MockResultSinkStubGenerator;
+using px::carnot::udf::FunctionContext;
+using px::carnot::udf::Registry;
+using px::carnot::udf::ScalarUDF;
+using px::table_store::schema::RowBatch;
+using px::table_store::schema::RowDescriptor;
+using px::types::DataType;
+using px::types::ToArrow;
+
+class EqUDF : public ScalarUDF {
+ public:
+  px::types::BoolValue Exec(FunctionContext*, px::types::Int64Value v1, px::types::Int64Value v2) {
+    return v1.val == v2.val;
+  }
+};
+
+// Filters batches of state.range(0) rows on col0 == 1, where state.range(1) percent of the rows
+// pass. The rows that pass are scattered, so every batch goes through the gather path.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_FilterSelectivity(benchmark::State& state) {
+  int64_t num_rows = state.range(0);
+  int64_t selectivity_pct = state.range(1);
+
+  auto func_registry = std::make_unique<Registry>("test_registry");
+  PL_CHECK_OK(func_registry->Register<EqUDF>("eq"));
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  PL_CHECK_OK(exec_state->AddScalarUDF(0, "eq", {DataType::INT64, DataType::INT64}));
+  exec_state->SetCurrentSource(1);
+
+  auto op_proto = px::carnot::planpb::testutils::CreateTestFilterTwoCols();
+  auto plan_node = px::carnot::plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
+  RowDescriptor rd({DataType::INT64, DataType::INT64, DataType::STRING});
+
+  std::mt19937 rng(37);
+  std::uniform_int_distribution<int64_t> pct_dist(0, 99);
+  std::vector<px::types::Int64Value> col0(num_rows);
+  std::vector<px::types::Int64Value> col1(num_rows);
+  std::vector<px::types::StringValue> col2(num_rows);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    col0[i] = pct_dist(rng) < selectivity_pct ? 1 : 0;
+    col1[i] = i;
+    col2[i] = absl::StrCat("value_", i);
+  }
+  RowBatch input_rb(rd, num_rows);
+  PL_CHECK_OK(input_rb.AddColumn(ToArrow(col0, arrow::default_memory_pool())));
+  PL_CHECK_OK(input_rb.AddColumn(ToArrow(col1, arrow::default_memory_pool())));
+  PL_CHECK_OK(input_rb.AddColumn(ToArrow(col2, arrow::default_memory_pool())));
+
+  FilterNode node;
+  PL_CHECK_OK(node.Init(*plan_node, rd, {rd}));
+  PL_CHECK_OK(node.Prepare(exec_state.get()));
+  PL_CHECK_OK(node.Open(exec_state.get()));
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    PL_CHECK_OK(node.ConsumeNext(exec_state.get(), input_rb, 0));
+  }
+  PL_CHECK_OK(node.Close(exec_state.get()));
+  state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void SelectivityArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t num_rows : {1024, 1 << 16}) {
+    for (int64_t selectivity_pct : {1, 10, 50, 90, 99}) {
+      b->Args({num_rows, selectivity_pct});
+    }
+  }
+}
+
+BENCHMARK(BM_FilterSelectivity)->Apply(SelectivityArgs)->ArgNames({"rows", "selectivity_pct"});
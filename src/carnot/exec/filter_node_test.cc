@@ -110,6 +110,56 @@ TEST_F(FilterNodeTest, basic) {
       .Close();
 }
 
+TEST_F(FilterNodeTest, contiguous_and_scattered_selections) {
+  auto op_proto = planpb::testutils::CreateTestFilterTwoCols();
+  plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<FilterNode, plan::FilterOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  tester
+      // All of the rows pass, the input columns are passed through.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1})
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .AddColumn<types::StringValue>({"ABC", "DEF"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({1, 1})
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .AddColumn<types::StringValue>({"ABC", "DEF"})
+                          .get())
+      // A run in the middle of the batch is sliced.
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({2, 1, 1, 3})
+                       .AddColumn<types::Int64Value>({1, 4, 6, 7})
+                       .AddColumn<types::StringValue>({"a", "b", "c", "d"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Int64Value>({1, 1})
+                          .AddColumn<types::Int64Value>({4, 6})
+                          .AddColumn<types::StringValue>({"b", "c"})
+                          .get())
+      // Scattered rows are copied.
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 1})
+                       .AddColumn<types::Int64Value>({1, 4, 6, 7})
+                       .AddColumn<types::StringValue>({"a", "b", "c", "d"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 1})
+                          .AddColumn<types::Int64Value>({1, 7})
+                          .AddColumn<types::StringValue>({"a", "d"})
+                          .get())
+      .Close();
+}
+
 TEST_F(FilterNodeTest, column_selection) {
   auto op_proto = planpb::testutils::CreateTestFilterTwoColsColumnSelection();
   plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/hash_utils.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Returns true if keys made up of the given types can be stored in a FixedSizeKeyHashMap.
+ */
+inline bool IsFixedSizeKey(const std::vector<types::DataType>& key_types) {
+  if (key_types.empty()) {
+    return false;
+  }
+  for (const auto& dt : key_types) {
+    switch (dt) {
+      case types::BOOLEAN:
+      case types::INT64:
+      case types::UINT128:
+      case types::TIME64NS:
+        continue;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Hashes a key of key_width values. Same as RowTuple::Hash() for fixed size tuples.
+ */
+inline uint64_t HashFixedSizeKey(const types::FixedSizeValueUnion* key, size_t key_width) {
+  return types::utils::HashFixedSizeValues(key, key_width);
+}
+
+/**
+ * FixedSizeKeyHashMap is an open-addressing (linear probing) hash map for keys that are tuples of
+ * fixed size values. Unlike a map keyed by RowTuple pointers, the keys are stored inline in one
+ * contiguous buffer, so inserting a key doesn't allocate and probing compares memory directly.
+ *
+ * Keys are compared with memcmp, so callers must zero each key before writing values into it
+ * (values narrower than FixedSizeValueUnion would otherwise leave garbage bytes behind).
+ *
+ * @tparam TValue The value type; must be cheap to copy (usually a pointer).
+ */
+template <typename TValue>
+class FixedSizeKeyHashMap : public NotCopyable {
+ public:
+  static constexpr size_t kDefaultInitialCapacity = 1024;
+
+  /**
+   * @param key_width The number of values in each key.
+   * @param initial_capacity The initial number of slots, rounded up to a power of 2.
+   */
+  explicit FixedSizeKeyHashMap(size_t key_width,
+                               size_t initial_capacity = kDefaultInitialCapacity)
+      : key_width_(key_width) {
+    DCHECK_GT(key_width_, 0U);
+    size_t capacity = 1;
+    while (capacity < initial_capacity) {
+      capacity <<= 1;
+    }
+    Allocate(capacity);
+  }
+
+  /**
+   * Finds the value for the given key, inserting a default constructed value if it is not present.
+   * @param key Pointer to key_width values.
+   * @param hash The hash of the key, as computed by HashFixedSizeKey.
+   * @param inserted Set to true if the key was not in the map before.
+   * @return A pointer to the value of the key. Only valid until the next insertion.
+   */
+  TValue* FindOrInsert(const types::FixedSizeValueUnion* key, uint64_t hash, bool* inserted) {
+    // Keep the load factor below 3/4.
+    if (4 * (size_ + 1) > 3 * capacity_) {
+      Grow();
+    }
+    size_t slot = FindSlot(key, hash);
+    *inserted = !occupied_[slot];
+    if (*inserted) {
+      occupied_[slot] = 1;
+      hashes_[slot] = hash;
+      memcpy(KeyAt(slot), key, KeyBytes());
+      values_[slot] = TValue();
+      ++size_;
+    }
+    return &values_[slot];
+  }
+
+  /**
+   * Finds the value for the given key.
+   * @return A pointer to the value, or nullptr if the key is not present.
+   */
+  TValue* Find(const types::FixedSizeValueUnion* key, uint64_t hash) {
+    size_t slot = FindSlot(key, hash);
+    return occupied_[slot] ? &values_[slot] : nullptr;
+  }
+
+  /**
+   * Calls fn(const types::FixedSizeValueUnion* key, TValue* value) for every entry of the map.
+   */
+  template <typename TFn>
+  void ForEach(TFn fn) {
+    for (size_t slot = 0; slot < capacity_; ++slot) {
+      if (occupied_[slot]) {
+        fn(KeyAt(slot), &values_[slot]);
+      }
+    }
+  }
+
+  size_t size() const { return size_; }
+  size_t key_width() const { return key_width_; }
+  size_t capacity() const { return capacity_; }
+  double load_factor() const { return static_cast<double>(size_) / capacity_; }
+  // The number of slots inspected by lookups so far. Lookups inspect a single slot unless their
+  // key collides with other keys.
+  int64_t num_probes() const { return num_probes_; }
+
+  void clear() {
+    std::fill(occupied_.begin(), occupied_.end(), 0);
+    size_ = 0;
+  }
+
+ private:
+  size_t KeyBytes() const { return sizeof(types::FixedSizeValueUnion) * key_width_; }
+  types::FixedSizeValueUnion* KeyAt(size_t slot) { return &keys_[slot * key_width_]; }
+
+  // Returns the slot holding the key, or the empty slot where it should be inserted.
+  size_t FindSlot(const types::FixedSizeValueUnion* key, uint64_t hash) {
+    size_t mask = capacity_ - 1;
+    size_t slot = hash & mask;
+    ++num_probes_;
+    while (occupied_[slot]) {
+      if (hashes_[slot] == hash && memcmp(KeyAt(slot), key, KeyBytes()) == 0) {
+        return slot;
+      }
+      slot = (slot + 1) & mask;
+      ++num_probes_;
+    }
+    return slot;
+  }
+
+  void Allocate(size_t capacity) {
+    capacity_ = capacity;
+    keys_.resize(capacity_ * key_width_);
+    hashes_.assign(capacity_, 0);
+    occupied_.assign(capacity_, 0);
+    values_.assign(capacity_, TValue());
+  }
+
+  void Grow() {
+    std::vector<types::FixedSizeValueUnion> old_keys = std::move(keys_);
+    std::vector<uint64_t> old_hashes = std::move(hashes_);
+    std::vector<uint8_t> old_occupied = std::move(occupied_);
+    std::vector<TValue> old_values = std::move(values_);
+    size_t old_capacity = capacity_;
+
+    keys_.clear();
+    Allocate(2 * old_capacity);
+    for (size_t old_slot = 0; old_slot < old_capacity; ++old_slot) {
+      if (!old_occupied[old_slot]) {
+        continue;
+      }
+      const types::FixedSizeValueUnion* key = &old_keys[old_slot * key_width_];
+      size_t slot = FindSlot(key, old_hashes[old_slot]);
+      occupied_[slot] = 1;
+      hashes_[slot] = old_hashes[old_slot];
+      memcpy(KeyAt(slot), key, KeyBytes());
+      values_[slot] = old_values[old_slot];
+    }
+  }
+
+  const size_t key_width_;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  int64_t num_probes_ = 0;
+  // Keys are stored inline, key_width_ values per slot.
+  std::vector<types::FixedSizeValueUnion> keys_;
+  std::vector<uint64_t> hashes_;
+  std::vector<uint8_t> occupied_;
+  std::vector<TValue> values_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/carnot/exec/fixed_size_key_hash_map.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+// Builds a zeroed (int64, bool) key.
+std::vector<types::FixedSizeValueUnion> MakeKey(int64_t a, bool b) {
+  std::vector<types::FixedSizeValueUnion> key(2);
+  memset(key.data(), 0, key.size() * sizeof(types::FixedSizeValueUnion));
+  types::SetValue<types::Int64Value>(&key[0], a);
+  types::SetValue<types::BoolValue>(&key[1], b);
+  return key;
+}
+}  // namespace
+
+TEST(FixedSizeKeyHashMapTest, is_fixed_size_key) {
+  EXPECT_TRUE(IsFixedSizeKey({types::DataType::INT64, types::DataType::BOOLEAN}));
+  EXPECT_TRUE(IsFixedSizeKey({types::DataType::UINT128, types::DataType::TIME64NS}));
+  EXPECT_FALSE(IsFixedSizeKey({types::DataType::INT64, types::DataType::STRING}));
+  EXPECT_FALSE(IsFixedSizeKey({types::DataType::FLOAT64}));
+  EXPECT_FALSE(IsFixedSizeKey({}));
+}
+
+TEST(FixedSizeKeyHashMapTest, find_or_insert) {
+  FixedSizeKeyHashMap<int64_t> map(2);
+  auto k1 = MakeKey(1, true);
+  auto k2 = MakeKey(1, false);
+
+  bool inserted = false;
+  *map.FindOrInsert(k1.data(), HashFixedSizeKey(k1.data(), 2), &inserted) = 10;
+  EXPECT_TRUE(inserted);
+  *map.FindOrInsert(k2.data(), HashFixedSizeKey(k2.data(), 2), &inserted) = 20;
+  EXPECT_TRUE(inserted);
+
+  auto* val = map.FindOrInsert(k1.data(), HashFixedSizeKey(k1.data(), 2), &inserted);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(10, *val);
+  EXPECT_EQ(2, map.size());
+
+  auto k3 = MakeKey(2, true);
+  EXPECT_EQ(nullptr, map.Find(k3.data(), HashFixedSizeKey(k3.data(), 2)));
+
+  map.clear();
+  EXPECT_EQ(0, map.size());
+  EXPECT_EQ(nullptr, map.Find(k1.data(), HashFixedSizeKey(k1.data(), 2)));
+}
+
+TEST(FixedSizeKeyHashMapTest, grow) {
+  FixedSizeKeyHashMap<int64_t> map(2, /* initial_capacity */ 4);
+  constexpr int64_t kNumKeys = 1000;
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    auto key = MakeKey(i, i % 2 == 0);
+    bool inserted = false;
+    *map.FindOrInsert(key.data(), HashFixedSizeKey(key.data(), 2), &inserted) = i * 10;
+    EXPECT_TRUE(inserted);
+  }
+  EXPECT_EQ(kNumKeys, map.size());
+
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    auto key = MakeKey(i, i % 2 == 0);
+    auto* val = map.Find(key.data(), HashFixedSizeKey(key.data(), 2));
+    ASSERT_NE(nullptr, val);
+    EXPECT_EQ(i * 10, *val);
+  }
+
+  int64_t sum = 0;
+  size_t count = 0;
+  map.ForEach([&](const types::FixedSizeValueUnion* key, int64_t* val) {
+    EXPECT_EQ(types::Get<types::Int64Value>(key[0]).val * 10, *val);
+    sum += *val;
+    ++count;
+  });
+  EXPECT_EQ(kNumKeys, count);
+  EXPECT_EQ(10 * kNumKeys * (kNumKeys - 1) / 2, sum);
+}
+
+TEST(FixedSizeKeyHashMapTest, probe_stats) {
+  FixedSizeKeyHashMap<int64_t> map(2, /* initial_capacity */ 8);
+  auto k1 = MakeKey(1, true);
+  auto k2 = MakeKey(2, true);
+  bool inserted = false;
+  // Give both keys the same hash so that the second lookup has to probe past the first key.
+  map.FindOrInsert(k1.data(), 0, &inserted);
+  EXPECT_EQ(1, map.num_probes());
+  map.FindOrInsert(k2.data(), 0, &inserted);
+  EXPECT_EQ(3, map.num_probes());
+
+  EXPECT_EQ(8UL, map.capacity());
+  EXPECT_DOUBLE_EQ(0.25, map.load_factor());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
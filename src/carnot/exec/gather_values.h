@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+// Copies the selected rows of the input column into a new output column.
+template <types::DataType T>
+Status GatherValues(const std::vector<int64_t>& selection, size_t num_selected,
+                    const arrow::Array* input_col, table_store::schema::RowBatch* output_rb) {
+  using ArrowBuilder = typename types::DataTypeTraits<T>::arrow_builder_type;
+  auto output_col_builder_generic = types::MakeArrowBuilder(T, arrow::default_memory_pool());
+  auto* output_col_builder = static_cast<ArrowBuilder*>(output_col_builder_generic.get());
+
+  if constexpr (T == types::INT64 || T == types::FLOAT64 || T == types::TIME64NS) {
+    // Fixed width values are gathered straight from the input buffer into a plain array, so that
+    // the loop has no builder bookkeeping and can be vectorized, and then appended at once.
+    using ArrowArray = typename types::DataTypeTraits<T>::arrow_array_type;
+    using NativeType = typename ArrowArray::value_type;
+    const NativeType* input_values = static_cast<const ArrowArray*>(input_col)->raw_values();
+    std::vector<NativeType> output_values(num_selected);
+    for (size_t i = 0; i < num_selected; ++i) {
+      output_values[i] = input_values[selection[i]];
+    }
+    PL_RETURN_IF_ERROR(output_col_builder->AppendValues(output_values.data(), num_selected));
+  } else {
+    PL_RETURN_IF_ERROR(output_col_builder->Reserve(num_selected));
+    if constexpr (T == types::STRING) {
+      // Reserve the exact amount of string data up front.
+      int64_t total_size = 0;
+      const auto* input_strings = static_cast<const arrow::StringArray*>(input_col);
+      for (size_t i = 0; i < num_selected; ++i) {
+        total_size += input_strings->value_length(selection[i]);
+      }
+      PL_RETURN_IF_ERROR(output_col_builder->ReserveData(total_size));
+    }
+    for (size_t i = 0; i < num_selected; ++i) {
+      output_col_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, selection[i]));
+    }
+  }
+
+  std::shared_ptr<arrow::Array> output_array;
+  PL_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
+  PL_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
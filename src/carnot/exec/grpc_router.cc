@@ -34,12 +34,24 @@ namespace px {
 namespace carnot {
 namespace exec {
 
+namespace {
+// Row batches arrive either as protobuf or gzip compressed, the GRPCSourceNode decodes both.
+bool HasRowBatch(const carnotpb::TransferResultChunkRequest::SinkResult& result) {
+  return result.has_row_batch() ||
+         result.result_contents_case() ==
+             carnotpb::TransferResultChunkRequest_SinkResult::kCompressedRowBatch;
+}
+// How often a stream that waits for credits checks whether it was cancelled. Cancellation isn't
+// signaled on credits_cv_.
+constexpr absl::Duration kCreditWaitCancelCheckInterval = absl::Milliseconds(100);
+}  // namespace
+
 Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id,
                                    std::unique_ptr<carnotpb::TransferResultChunkRequest> req) {
   absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
   auto& query_map = query_node_map_[query_id];
 
-  if (!req->has_query_result() || !req->query_result().has_row_batch() ||
+  if (!req->has_query_result() || !HasRowBatch(req->query_result()) ||
       req->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
     return error::Internal(
@@ -49,6 +61,11 @@ Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id,
 
   SourceNodeTracker& snt = query_map.source_node_trackers[req->query_result().grpc_source_id()];
   absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+  // Batches that were already in flight when the source was stopped aren't needed anymore.
+  if (snt.stopped) {
+    snt.dropped_bytes += req->ByteSizeLong();
+    return Status::OK();
+  }
   // It's possible that we see row batches before we have gotten information about the query. To
   // solve this race, We store a backlog of all the pending batches.
   if (snt.source_node == nullptr) {
@@ -56,10 +73,93 @@ Status GRPCRouter::EnqueueRowBatch(sole::uuid query_id,
     return Status::OK();
   }
   PL_RETURN_IF_ERROR(snt.source_node->EnqueueRowBatch(std::move(req)));
-  query_map.restart_execution_func_();
+  snt.restart_execution();
   return Status::OK();
 }
 
+bool GRPCRouter::SourceHasCredits(sole::uuid query_id, int64_t source_id) {
+  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+  auto query_it = query_node_map_.find(query_id);
+  if (query_it == query_node_map_.end()) {
+    return true;
+  }
+  auto snt_it = query_it->second.source_node_trackers.find(source_id);
+  if (snt_it == query_it->second.source_node_trackers.end()) {
+    return true;
+  }
+  SourceNodeTracker& snt = snt_it->second;
+  absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+  return snt.stopped || snt.source_node == nullptr || snt.source_node->HasCredits();
+}
+
+bool GRPCRouter::SourceStopped(sole::uuid query_id, int64_t source_id) {
+  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+  auto query_it = query_node_map_.find(query_id);
+  if (query_it == query_node_map_.end()) {
+    return false;
+  }
+  auto snt_it = query_it->second.source_node_trackers.find(source_id);
+  if (snt_it == query_it->second.source_node_trackers.end()) {
+    return false;
+  }
+  SourceNodeTracker& snt = snt_it->second;
+  absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+  return snt.stopped;
+}
+
+void GRPCRouter::StopGRPCSource(sole::uuid query_id, int64_t source_id) {
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    auto query_it = query_node_map_.find(query_id);
+    if (query_it == query_node_map_.end()) {
+      return;
+    }
+    auto snt_it = query_it->second.source_node_trackers.find(source_id);
+    if (snt_it == query_it->second.source_node_trackers.end()) {
+      return;
+    }
+    SourceNodeTracker& snt = snt_it->second;
+    absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+    snt.stopped = true;
+    for (const auto& req : snt.response_backlog) {
+      snt.dropped_bytes += req->ByteSizeLong();
+    }
+    snt.response_backlog.clear();
+  }
+  // Stopped sources always have credits, so their streams can end.
+  NotifyCreditsChanged();
+}
+
+StatusOr<int64_t> GRPCRouter::GetDroppedBytes(const sole::uuid& query_id) {
+  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+  auto it = query_node_map_.find(query_id);
+  if (it == query_node_map_.end()) {
+    return error::Internal("No query ID $0 found in the GRPCRouter", query_id.str());
+  }
+  int64_t dropped_bytes = 0;
+  for (auto& entry : it->second.source_node_trackers) {
+    SourceNodeTracker& snt = entry.second;
+    absl::base_internal::SpinLockHolder snt_lock(&snt.node_lock);
+    dropped_bytes += snt.dropped_bytes;
+  }
+  return dropped_bytes;
+}
+
+void GRPCRouter::WaitForCredits(::grpc::ServerContext* context, sole::uuid query_id,
+                                int64_t source_id) {
+  // While we wait, the unread requests fill up the HTTP/2 flow control window, which blocks the
+  // Write calls on the sink side.
+  absl::MutexLock lock(&credits_lock_);
+  while (!SourceHasCredits(query_id, source_id) && !context->IsCancelled()) {
+    credits_cv_.WaitWithTimeout(&credits_lock_, kCreditWaitCancelCheckInterval);
+  }
+}
+
+void GRPCRouter::NotifyCreditsChanged() {
+  absl::MutexLock lock(&credits_lock_);
+  credits_cv_.SignalAll();
+}
+
 Status GRPCRouter::MarkResultStreamInitiated(sole::uuid query_id, int64_t source_id) {
   absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
   auto& query_map = query_node_map_[query_id];
@@ -93,6 +193,8 @@ Status GRPCRouter::MarkResultStreamClosed(sole::uuid query_id, int64_t source_id
   }
   DCHECK(!snt.source_node->upstream_closed_connection());
   snt.source_node->set_upstream_closed_connection();
+  // Wake up the execution so that a connection closed before EOS is noticed right away.
+  snt.restart_execution();
   return Status::OK();
 }
 
@@ -133,6 +235,8 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
 
   ::grpc::Status result_status = ::grpc::Status::OK;
   bool registered_server_context = false;
+  // Set when the destination source was stopped, which ends the stream early.
+  bool source_stopped = false;
 
   while (reader->Read(rb.get())) {
     query_id = px::ParseUUID(rb->query_id()).ConsumeValueOrDie();
@@ -153,12 +257,19 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
                            absl::Substitute("Failed to record stats w/ err: $0", s.msg()));
         break;
       }
-    } else if (rb->has_query_result() && rb->query_result().has_row_batch()) {
+    } else if (rb->has_query_result() && HasRowBatch(rb->query_result())) {
+      int64_t source_id = rb->query_result().grpc_source_id();
       auto s = EnqueueRowBatch(query_id, std::move(rb));
       if (!s.ok()) {
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, "failed to enqueue batch");
         break;
       }
+      // Don't read the next batch until the source node grants more credits.
+      WaitForCredits(context, query_id, source_id);
+      if (SourceStopped(query_id, source_id)) {
+        source_stopped = true;
+        break;
+      }
     } else if (rb->has_query_result() && rb->query_result().initiate_result_stream()) {
       if (rb->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
@@ -174,6 +285,10 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, s.msg());
         break;
       }
+      if (SourceStopped(query_id, source_node_id)) {
+        source_stopped = true;
+        break;
+      }
 
     } else {
       result_status =
@@ -191,6 +306,15 @@ void GRPCRouter::MarkResultStreamContextAsComplete(sole::uuid query_id,
     return result_status;
   }
 
+  // Returning before the sink is done closes the stream, which fails its next write. The
+  // response then tells it that it can stop sending (and scanning) instead of failing the query.
+  if (source_stopped) {
+    MarkResultStreamContextAsComplete(query_id, context);
+    response->set_success(true);
+    response->set_source_stopped(true);
+    return ::grpc::Status::OK;
+  }
+
   if (stream_has_query_results) {
     auto s = MarkResultStreamClosed(query_id, source_node_id);
     if (!s.ok()) {
@@ -231,10 +355,11 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
   {
     absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
     snt = &(query_node_map_[query_id].source_node_trackers[source_id]);
-    query_node_map_[query_id].restart_execution_func_ = restart_execution;
   }
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
   snt->source_node = source_node;
+  snt->restart_execution = restart_execution;
+  source_node->set_credits_available_callback([this] { NotifyCreditsChanged(); });
   if (snt->connection_initiated_by_sink) {
     source_node->set_upstream_initiated_connection();
   }
@@ -271,35 +396,42 @@ StatusOr<std::vector<queryresultspb::AgentExecutionStats>> GRPCRouter::GetIncomi
 }
 
 Status GRPCRouter::DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id) {
-  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-  if (!query_node_map_.contains(query_id)) {
-    return error::Internal("Query map does not contain query ID $0 when deleting GRPC source $1",
-                           query_id.str(), source_id);
-  }
-  auto& query_map = query_node_map_[query_id];
-  auto it = query_map.source_node_trackers.find(source_id);
-  if (it == query_map.source_node_trackers.end()) {
-    return error::Internal("Query map for query ID $0 does not contain GRPC source $1",
-                           query_id.str(), source_id);
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    if (!query_node_map_.contains(query_id)) {
+      return error::Internal("Query map does not contain query ID $0 when deleting GRPC source $1",
+                             query_id.str(), source_id);
+    }
+    auto& query_map = query_node_map_[query_id];
+    auto it = query_map.source_node_trackers.find(source_id);
+    if (it == query_map.source_node_trackers.end()) {
+      return error::Internal("Query map for query ID $0 does not contain GRPC source $1",
+                             query_id.str(), source_id);
+    }
+    query_map.source_node_trackers.erase(it);
   }
-  query_map.source_node_trackers.erase(it);
+  // Streams waiting on the deleted source don't need to wait anymore.
+  NotifyCreditsChanged();
   return Status::OK();
 }
 
 void GRPCRouter::DeleteQuery(sole::uuid query_id) {
-  absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
-  VLOG(1) << "Deleting query ID from GRPC Router: " << query_id.str();
-  auto it = query_node_map_.find(query_id);
-  if (it == query_node_map_.end()) {
-    VLOG(1) << "No such query when deleting: " << query_id.str()
-            << "(this is expected if no grpc sources are present)";
-    return;
-  }
-  // For any active input streams for this query, mark their context as cancelled.
-  for (auto ctx : query_node_map_[query_id].active_agent_contexts) {
-    ctx->TryCancel();
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    VLOG(1) << "Deleting query ID from GRPC Router: " << query_id.str();
+    auto it = query_node_map_.find(query_id);
+    if (it == query_node_map_.end()) {
+      VLOG(1) << "No such query when deleting: " << query_id.str()
+              << "(this is expected if no grpc sources are present)";
+      return;
+    }
+    // For any active input streams for this query, mark their context as cancelled.
+    for (auto ctx : query_node_map_[query_id].active_agent_contexts) {
+      ctx->TryCancel();
+    }
+    query_node_map_.erase(it);
   }
-  query_node_map_.erase(it);
+  NotifyCreditsChanged();
 }
 
 }  // namespace exec
@@ -30,6 +30,7 @@
 #include <absl/container/flat_hash_set.h>
 #include <absl/container/node_hash_map.h>
 #include <absl/hash/hash.h>
+#include <absl/synchronization/mutex.h>
 #include <grpcpp/grpcpp.h>
 #include <sole.hpp>
 
@@ -98,10 +99,32 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
   Status RecordStats(const sole::uuid& query_id,
                      const std::vector<queryresultspb::AgentExecutionStats>& stats);
 
+  /**
+   * @brief Marks the source as no longer needing data, eg. because a downstream limit was reached.
+   * The result streams for the source are ended with a response that tells the sinks to stop
+   * sending, and any batches that still arrive for it are dropped.
+   */
+  void StopGRPCSource(sole::uuid query_id, int64_t source_id);
+
+  /**
+   * @brief Returns the serialized bytes of the row batches dropped for the query's stopped
+   * sources.
+   */
+  StatusOr<int64_t> GetDroppedBytes(const sole::uuid& query_id);
+
  private:
   Status EnqueueRowBatch(sole::uuid query_id,
                          std::unique_ptr<carnotpb::TransferResultChunkRequest> req);
 
+  // Returns whether the source node has credits left for more row batches. Sources that are not
+  // registered (yet or anymore) or that are stopped always have credits.
+  bool SourceHasCredits(sole::uuid query_id, int64_t source_id);
+  bool SourceStopped(sole::uuid query_id, int64_t source_id);
+  // Blocks the stream until the source has credits again or the stream is cancelled.
+  void WaitForCredits(::grpc::ServerContext* context, sole::uuid query_id, int64_t source_id);
+  // Wakes up the streams waiting for credits, to check their sources again.
+  void NotifyCreditsChanged();
+
   Status MarkResultStreamInitiated(sole::uuid query_id, int64_t source_id);
   Status MarkResultStreamClosed(sole::uuid query_id, int64_t source_id);
   void RegisterResultStreamContext(sole::uuid query_id, ::grpc::ServerContext* context);
@@ -116,6 +139,11 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     GRPCSourceNode* source_node GUARDED_BY(node_lock) = nullptr;
     bool connection_initiated_by_sink GUARDED_BY(node_lock) = false;
     bool connection_closed_by_sink GUARDED_BY(node_lock) = false;
+    // Set once the source doesn't need any more data.
+    bool stopped GUARDED_BY(node_lock) = false;
+    int64_t dropped_bytes GUARDED_BY(node_lock) = 0;
+    // Wakes up the query's execution to process this source.
+    std::function<void()> restart_execution GUARDED_BY(node_lock);
     std::vector<std::unique_ptr<::px::carnotpb::TransferResultChunkRequest>> response_backlog
         GUARDED_BY(node_lock);
     absl::base_internal::SpinLock node_lock;
@@ -128,7 +156,6 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     QueryTracker() : create_time(std::chrono::steady_clock::now()) {}
     absl::node_hash_map<int64_t, SourceNodeTracker> source_node_trackers;
     std::chrono::steady_clock::time_point create_time;
-    std::function<void()> restart_execution_func_;
     // The set of agents we've seen for the query.
     absl::flat_hash_set<sole::uuid> seen_agents;
     absl::flat_hash_set<::grpc::ServerContext*> active_agent_contexts;
@@ -138,6 +165,11 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
 
   absl::node_hash_map<sole::uuid, QueryTracker> query_node_map_ GUARDED_BY(query_node_map_lock_);
   absl::base_internal::SpinLock query_node_map_lock_;
+
+  // Streams that ran out of credits wait on credits_cv_, and are signaled when a source pops a
+  // row batch, is stopped, or its query is deleted.
+  absl::Mutex credits_lock_;
+  absl::CondVar credits_cv_;
 };
 
 }  // namespace exec
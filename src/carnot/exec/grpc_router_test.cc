@@ -220,7 +220,8 @@ TEST_F(GRPCRouterTest, basic_router_test) {
             source_node.row_batches.at(0)->query_result().row_batch().cols(0).int64_data().data(0));
   EXPECT_EQ(4,
             source_node.row_batches.at(1)->query_result().row_batch().cols(0).int64_data().data(0));
-  EXPECT_EQ(2, num_continues);
+  // One continue per row batch, and one for the closed connection.
+  EXPECT_EQ(3, num_continues);
   EXPECT_TRUE(source_node.upstream_closed_connection());
 }
 
@@ -307,7 +308,7 @@ TEST_F(GRPCRouterTest, router_and_stats_test) {
   EXPECT_EQ(1, source_node.row_batches.size());
   EXPECT_EQ(1,
             source_node.row_batches.at(0)->query_result().row_batch().cols(0).int64_data().data(0));
-  EXPECT_EQ(1, num_continues);
+  EXPECT_EQ(2, num_continues);
   EXPECT_TRUE(source_node.upstream_closed_connection());
 
   uuidpb::UUID agent_uuid_pb;
@@ -353,6 +354,138 @@ TEST_F(GRPCRouterTest, done_query_test) {
   service_->DeleteQuery(query_uuid);
 }
 
+TEST_F(GRPCRouterTest, stopped_source_ends_streams) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  initiate_stream_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  initiate_stream_req.mutable_query_result()->set_initiate_result_stream(true);
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto rb = RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  carnotpb::TransferResultChunkRequest rb_req;
+  EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+  rb_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  query_id = rb_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+
+  // The batch is held in the backlog, because the source node isn't registered yet.
+  {
+    carnotpb::TransferResultChunkResponse response;
+    grpc::ClientContext context;
+    auto writer = stub_->TransferResultChunk(&context, &response);
+    writer->Write(initiate_stream_req);
+    writer->Write(rb_req);
+    writer->WritesDone();
+    EXPECT_TRUE(writer->Finish().ok());
+    EXPECT_FALSE(response.source_stopped());
+  }
+
+  service_->StopGRPCSource(query_uuid, grpc_source_node_id);
+  auto dropped_bytes_or_s = service_->GetDroppedBytes(query_uuid);
+  ASSERT_OK(dropped_bytes_or_s);
+  EXPECT_EQ(static_cast<int64_t>(rb_req.ByteSizeLong()), dropped_bytes_or_s.ConsumeValueOrDie());
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node, [] {}));
+  EXPECT_EQ(0, source_node.row_batches.size());
+
+  // New streams for the stopped source are ended right after they are initiated.
+  carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  writer->Write(initiate_stream_req);
+  writer->WritesDone();
+  EXPECT_TRUE(writer->Finish().ok());
+  EXPECT_TRUE(response.success());
+  EXPECT_TRUE(response.source_stopped());
+  EXPECT_EQ(0, source_node.row_batches.size());
+}
+
+TEST_F(GRPCRouterTest, exhausted_credits_block_stream) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  auto func_registry = std::make_unique<udf::Registry>("test_registry");
+  auto table_store = std::make_shared<table_store::TableStore>();
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, input_rd, std::vector<RowDescriptor>({}), exec_state.get());
+  // Every queued batch uses up the credits.
+  tester.node()->testing_set_credit_window_bytes(1);
+  ASSERT_OK(
+      service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, tester.node(), [] {}));
+
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  initiate_stream_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  initiate_stream_req.mutable_query_result()->set_initiate_result_stream(true);
+
+  std::vector<table_store::schema::RowBatch> rbs;
+  std::vector<carnotpb::TransferResultChunkRequest> rb_reqs(2);
+  for (int64_t i = 0; i < 2; ++i) {
+    rbs.push_back(RowBatchBuilder(input_rd, 2, /*eow*/ i == 1, /*eos*/ i == 1)
+                      .AddColumn<types::Int64Value>({i, i})
+                      .get());
+    EXPECT_OK(rbs[i].ToProto(rb_reqs[i].mutable_query_result()->mutable_row_batch()));
+    rb_reqs[i].mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+    *rb_reqs[i].mutable_query_id() = initiate_stream_req.query_id();
+  }
+
+  carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  std::thread write_thread([&] {
+    writer->Write(initiate_stream_req);
+    writer->Write(rb_reqs[0]);
+    writer->Write(rb_reqs[1]);
+    writer->WritesDone();
+    EXPECT_TRUE(writer->Finish().ok());
+  });
+
+  auto wait_for_batch = [&] {
+    for (int i = 0; i < 1000 && !tester.node()->NextBatchReady(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(tester.node()->NextBatchReady());
+  };
+
+  // The stream waits for credits after the first batch, so the second one isn't read.
+  wait_for_batch();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ(tester.node()->queued_bytes(), static_cast<int64_t>(rb_reqs[0].ByteSizeLong()));
+
+  // Popping the batch gives credits back, which wakes up the stream.
+  tester.GenerateNextResult().ExpectRowBatch(rbs[0]);
+  wait_for_batch();
+  tester.GenerateNextResult().ExpectRowBatch(rbs[1]);
+
+  write_thread.join();
+  EXPECT_TRUE(response.success());
+  EXPECT_EQ(tester.node()->queued_bytes(), 0);
+}
+
 // This test is a TSAN test. IT should be run enough times so that all possible
 // race conditions will be met.
 TEST_F(GRPCRouterTest, threaded_router_test) {
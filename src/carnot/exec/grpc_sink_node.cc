@@ -26,6 +26,7 @@
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/macros.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/table_store/table_store.h"
 
 namespace px {
@@ -65,7 +66,7 @@ StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(
 }
 
 Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
-  if (sent_eos_) {
+  if (sent_eos_ || stopped_by_destination_) {
     return Status::OK();
   }
 
@@ -83,10 +84,7 @@ Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
   PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
 
   if (!writer_->Write(req)) {
-    return error::Cancelled(
-        "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
-        "server",
-        exec_state->query_id().str(), plan_node_->id(), plan_node_->address());
+    return HandleClosedStream(exec_state);
   }
 
   last_send_time_ = time_now;
@@ -117,6 +115,15 @@ Status GRPCSinkNode::OpenImpl(ExecState* exec_state) {
     exec_state->AddAuthToGRPCClientContext(&context_);
   }
 
+  // Streams with a table name forward the query's results, the others go to another agent.
+  stream_span_ =
+      exec_state->StartSpan(plan_node_->has_table_name() ? "result_forward" : "grpc_sink");
+  stream_span_.SetAttribute("address", plan_node_->address());
+  stream_span_.SetAttribute("node_id", plan_node_->id());
+  if (plan_node_->has_grpc_source_id()) {
+    stream_span_.SetAttribute("grpc_source_id", plan_node_->grpc_source_id());
+  }
+
   writer_ = stub_->TransferResultChunk(&context_, &response_);
 
   PL_ASSIGN_OR_RETURN(auto initial_request, RequestWithMetadata(plan_node_.get(), exec_state));
@@ -145,10 +152,49 @@ Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
         "GRPCSinkNode $0 in query $1: Error calling Finish on stream, message: $2",
         plan_node_->id(), exec_state->query_id().str(), s.error_message());
   }
+  EndStreamSpan(exec_state);
   return Status::OK();
 }
 
+void GRPCSinkNode::EndStreamSpan(ExecState* exec_state) {
+  if (!stream_span_.active()) {
+    return;
+  }
+  stream_span_.SetAttribute("write_time_ns", write_timer_.ElapsedTime_us() * 1000);
+  stream_span_.set_peak_memory_bytes(exec_state->peak_memory_bytes());
+  stream_span_.End();
+}
+
+Status GRPCSinkNode::HandleClosedStream(ExecState* exec_state) {
+  cancelled_ = true;
+  writer_->WritesDone();
+  auto s = writer_->Finish();
+  EndStreamSpan(exec_state);
+  if (s.ok() && response_.source_stopped()) {
+    VLOG(1) << absl::Substitute("GRPCSinkNode $0 in query $1 was stopped by its destination",
+                                plan_node_->id(), exec_state->query_id().str());
+    stopped_by_destination_ = true;
+    return Status::OK();
+  }
+  return error::Cancelled(
+      "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
+      "server",
+      plan_node_->id(), exec_state->query_id().str(), plan_node_->address());
+}
+
 Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
+  // Set by the planner on the sinks of the PEM to Kelvin bridges.
+  if (plan_node_->estimated_query_row_bytes_after_pushdown() > 0) {
+    stats()->AddExtraMetric("estimated_query_row_bytes_before_pushdown",
+                            plan_node_->estimated_query_row_bytes_before_pushdown());
+    stats()->AddExtraMetric("estimated_query_row_bytes_after_pushdown",
+                            plan_node_->estimated_query_row_bytes_after_pushdown());
+  }
+  if (stopped_by_destination_) {
+    stats()->AddExtraInfo("stopped_by_destination", "true");
+    stats()->AddExtraMetric("rows_dropped", rows_dropped_);
+    stats()->AddExtraMetric("bytes_dropped", bytes_dropped_);
+  }
   if (sent_eos_) {
     return Status::OK();
   }
@@ -162,6 +208,43 @@ Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
   return Status::OK();
 }
 
+Status GRPCSinkNode::CompressRowBatch(carnotpb::TransferResultChunkRequest* req) {
+  auto result = req->mutable_query_result();
+  compression_timer_.Resume();
+  std::string serialized = result->row_batch().SerializeAsString();
+  auto compressed_or_s = zlib::Deflate(serialized);
+  compression_timer_.Stop();
+  PL_ASSIGN_OR_RETURN(std::string compressed, compressed_or_s);
+
+  uncompressed_bytes_ += serialized.size();
+  compressed_bytes_ += compressed.size();
+  stats()->AddExtraMetric("compression_ratio",
+                          static_cast<double>(uncompressed_bytes_) / compressed_bytes_);
+  stats()->AddExtraMetric("compression_time_ns", compression_timer_.ElapsedTime_us() * 1000);
+
+  // Setting the other case of the oneof clears the uncompressed row batch.
+  result->set_compressed_row_batch(std::move(compressed));
+  return Status::OK();
+}
+
+namespace {
+// Protobuf adds a length prefix to every string value and the raw arrow buffers carry an int32
+// offset per value, so we budget for the larger of the two on top of the string payload.
+constexpr int64_t kStringValueOverheadBytes = sizeof(int32_t);
+
+// Estimates the serialized size of the row batch from the lengths of its arrow buffers, which
+// lets us split oversized batches before paying for a serialization we would throw away.
+int64_t EstimateSerializedBytes(const RowBatch& rb) {
+  int64_t num_bytes = rb.NumBytes();
+  for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+    if (rb.desc().type(col_idx) == types::DataType::STRING) {
+      num_bytes += rb.num_rows() * kStringValueOverheadBytes;
+    }
+  }
+  return num_bytes;
+}
+}  // namespace
+
 Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb, size_t parent_idx,
                                        size_t request_size_bytes) {
   // We split this batch into many batches depending on the desired batch_size.
@@ -193,21 +276,44 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
 }
 
 Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
+  if (stopped_by_destination_) {
+    rows_dropped_ += rb.num_rows();
+    bytes_dropped_ += rb.NumBytes();
+    return Status::OK();
+  }
+
+  // Split on the estimate so that oversized batches are only serialized once, slice by slice.
+  size_t estimated_size = EstimateSerializedBytes(rb);
+  if (estimated_size > kMaxBatchSize && rb.num_rows() > 1) {
+    return SplitAndSendBatch(exec_state, rb, parent_idx, estimated_size);
+  }
+
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
 
-  // Serialize the RowBatch.
-  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+  // Serialize the RowBatch. The estimate can undershoot the encoded size (eg. varints of large
+  // values), so we still check the actual size and fall back to splitting on it.
+  serialization_timer_.Resume();
+  auto s = rb.ToProto(req.mutable_query_result()->mutable_row_batch(),
+                      plan_node_->arrow_row_batches());
   size_t request_size = req.ByteSizeLong();
+  serialization_timer_.Stop();
+  PL_RETURN_IF_ERROR(s);
+  stats()->AddExtraMetric("serialization_time_ns", serialization_timer_.ElapsedTime_us() * 1000);
   if (request_size > kMaxBatchSize) {
     return SplitAndSendBatch(exec_state, rb, parent_idx, request_size);
   }
 
-  if (!writer_->Write(req)) {
-    cancelled_ = true;
-    return error::Cancelled(
-        "GRPCSinkNode $0 of query $1 could not write result to address: $2, stream closed by "
-        "server",
-        exec_state->query_id().str(), plan_node_->id(), plan_node_->address());
+  // Batches are sized on their uncompressed form, so compressing can only shrink the request.
+  if (plan_node_->compress_row_batches()) {
+    PL_RETURN_IF_ERROR(CompressRowBatch(&req));
+  }
+
+  write_timer_.Resume();
+  bool written = writer_->Write(req);
+  write_timer_.Stop();
+  stats()->AddExtraMetric("write_time_ns", write_timer_.ElapsedTime_us() * 1000);
+  if (!written) {
+    return HandleClosedStream(exec_state);
   }
   last_send_time_ = std::chrono::system_clock::now();
 
@@ -29,7 +29,9 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
+#include "src/carnot/trace/query_trace.h"
 #include "src/common/base/base.h"
+#include "src/common/perf/elapsed_timer.h"
 #include "src/table_store/table_store.h"
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
@@ -59,6 +61,10 @@ class GRPCSinkNode : public SinkNode {
   // Used to check the downstream connection after connection_check_timeout_ has elapsed.
   Status OptionallyCheckConnection(ExecState* exec_state);
 
+  // Whether the destination ended the stream because it doesn't need any more results, eg. when a
+  // limit downstream of it was reached. Incoming batches are dropped from then on.
+  bool stopped_by_destination() const { return stopped_by_destination_; }
+
   void testing_set_connection_check_timeout(const std::chrono::milliseconds& timeout) {
     connection_check_timeout_ = timeout;
   }
@@ -79,19 +85,39 @@ class GRPCSinkNode : public SinkNode {
 
  private:
   Status CloseWriter(ExecState* exec_state);
+  void EndStreamSpan(ExecState* exec_state);
+  // Called when a write fails because the server closed the stream. Returns OK if the server
+  // closed it because its source was stopped.
+  Status HandleClosedStream(ExecState* exec_state);
+  // Replaces the serialized row batch in the request with its gzip compressed form.
+  Status CompressRowBatch(carnotpb::TransferResultChunkRequest* req);
 
   bool cancelled_ = true;
+  bool stopped_by_destination_ = false;
+  // The batches received after the destination stopped the stream, which we didn't have to send.
+  int64_t rows_dropped_ = 0;
+  int64_t bytes_dropped_ = 0;
 
   grpc::ClientContext context_;
   carnotpb::TransferResultChunkResponse response_;
 
   carnotpb::ResultSinkService::StubInterface* stub_;
   std::unique_ptr<grpc::ClientWriterInterface<carnotpb::TransferResultChunkRequest>> writer_;
+  // Open from when the stream is opened until it is closed.
+  trace::QueryTrace::Span stream_span_;
 
   std::unique_ptr<plan::GRPCSinkOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
 
   std::chrono::milliseconds connection_check_timeout_ = kDefaultConnectionCheckTimeoutMS;
+
+  // Time spent encoding the row batches and writing them to the stream, for the exec stats.
+  ElapsedTimer serialization_timer_;
+  ElapsedTimer write_timer_;
+  // Totals over the compressed row batches, reported in the exec stats.
+  ElapsedTimer compression_timer_;
+  int64_t uncompressed_bytes_ = 0;
+  int64_t compressed_bytes_ = 0;
   std::chrono::time_point<std::chrono::system_clock> last_send_time_ =
       std::chrono::system_clock::now();
 };
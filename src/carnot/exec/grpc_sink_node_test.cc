@@ -32,6 +32,7 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/testing/testing.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/shared/types/types.h"
 
 namespace px {
@@ -46,6 +47,7 @@ using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::SaveArg;
 using ::testing::SetArgPointee;
@@ -212,6 +214,63 @@ TEST_F(GRPCSinkNodeTest, internal_result) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, internal_result_compressed) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  op_proto.mutable_grpc_sink_op()->set_compress_row_batches(true);
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(2);
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)));
+
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  std::vector<types::Int64Value> data(2, 2);
+  auto rb = RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>(data)
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  tester.Close();
+
+  // The initiation message is never compressed.
+  EXPECT_TRUE(actual_protos[0].query_result().initiate_result_stream());
+
+  const auto& result = actual_protos[1].query_result();
+  EXPECT_FALSE(result.has_row_batch());
+  ASSERT_OK_AND_ASSIGN(std::string serialized,
+                       px::zlib::Inflate(result.compressed_row_batch()));
+  table_store::schemapb::RowBatchData row_batch;
+  ASSERT_TRUE(row_batch.ParseFromString(serialized));
+  EXPECT_THAT(row_batch, EqualsProto(R"proto(
+    cols {
+      int64_data {
+        data: 2
+        data: 2
+      }
+    }
+    num_rows: 2
+    eow: true
+    eos: true
+  )proto"));
+}
+
 constexpr char kExpectedExternalInitialization[] = R"proto(
 address: "localhost:1234"
 query_id {
@@ -377,6 +436,46 @@ TEST_F(GRPCSinkNodeTest, check_connection) {
   tester.Close();
 }
 
+TEST_F(GRPCSinkNodeTest, stopped_by_destination) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  // The server ends the stream early once its source doesn't need the results anymore.
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+  resp.set_source_stopped(true);
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(3)
+      .WillOnce(Return(true))    // Initiate result sink
+      .WillOnce(Return(true))    // First batch
+      .WillOnce(Return(false));  // Stream closed by the server
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  for (auto i = 0; i < 4; ++i) {
+    auto rb = RowBatchBuilder(output_rd, 2, /*eow*/ i == 3, /*eos*/ i == 3)
+                  .AddColumn<types::Int64Value>({i, i})
+                  .get();
+    // The batches after the failed write are dropped without writing them.
+    tester.ConsumeNext(rb, 5, 0);
+    EXPECT_EQ(i >= 1, tester.node()->stopped_by_destination());
+  }
+  // Stopped sinks don't need to check the connection anymore.
+  EXPECT_OK(tester.node()->OptionallyCheckConnection(exec_state_.get()));
+
+  tester.Close();
+}
+
 TEST_F(GRPCSinkNodeTest, update_connection_time) {
   auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
   auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
@@ -426,18 +525,15 @@ TEST_F(GRPCSinkNodeTest, break_up_batch_no_leftover) {
   TransferResultChunkResponse resp;
   resp.set_success(true);
 
-  std::vector<TransferResultChunkRequest> actual_protos(6);
+  std::vector<TransferResultChunkRequest> actual_protos;
 
   auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
 
   EXPECT_CALL(*writer, Write(_, _))
-      .Times(6)
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[3]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[4]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[5]), Return(true)));
+      .WillRepeatedly(Invoke([&actual_protos](const TransferResultChunkRequest& req, auto) {
+        actual_protos.push_back(req);
+        return true;
+      }));
 
   EXPECT_CALL(*writer, WritesDone());
   EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
@@ -454,7 +550,9 @@ TEST_F(GRPCSinkNodeTest, break_up_batch_no_leftover) {
                 .get();
   tester.ConsumeNext(rb, 5, 0);
 
-  int64_t num_main_batches = 4;
+  // The 2Mi int64 values take up 32.5 times kMaxBatchSize * kBatchSizeFactor bytes.
+  int64_t num_main_batches = 32;
+  ASSERT_EQ(actual_protos.size(), 34UL);
   int64_t row_size = num_rows / num_main_batches;
   // i = 0 batch is a init batch. We have num_main_batches + 1 batches. + 1 => the leftover batch.
   for (int64_t i = 1; i < num_main_batches + 1; ++i) {
@@ -482,17 +580,15 @@ TEST_F(GRPCSinkNodeTest, break_up_batch_with_leftover) {
 
   google::protobuf::util::MessageDifferencer differ;
 
-  std::vector<TransferResultChunkRequest> actual_protos(5);
+  std::vector<TransferResultChunkRequest> actual_protos;
 
   auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
 
   EXPECT_CALL(*writer, Write(_, _))
-      .Times(5)
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[3]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[4]), Return(true)));
+      .WillRepeatedly(Invoke([&actual_protos](const TransferResultChunkRequest& req, auto) {
+        actual_protos.push_back(req);
+        return true;
+      }));
 
   EXPECT_CALL(*writer, WritesDone());
   EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
@@ -511,7 +607,9 @@ TEST_F(GRPCSinkNodeTest, break_up_batch_with_leftover) {
                 .get();
   tester.ConsumeNext(rb, 5, 0);
 
-  int64_t num_main_batches = num_rows / static_cast<int64_t>(kMaxBatchSize * kBatchSizeFactor);
+  // The 1548296 int64 values take up 24 times kMaxBatchSize * kBatchSizeFactor bytes, plus 64.
+  int64_t num_main_batches = 24;
+  ASSERT_EQ(actual_protos.size(), 26UL);
   int64_t row_size = num_rows / num_main_batches;
   // i = 0 batch is a init batch. We have num_main_batches + 1 batches. + 1 => the leftover batch.
   for (int64_t i = 1; i < num_main_batches + 1; ++i) {
@@ -541,17 +639,15 @@ TEST_F(GRPCSinkNodeTest, break_up_row_batch_that_isnt_eow_eos) {
 
   google::protobuf::util::MessageDifferencer differ;
 
-  std::vector<TransferResultChunkRequest> actual_protos(5);
+  std::vector<TransferResultChunkRequest> actual_protos;
 
   auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
 
   EXPECT_CALL(*writer, Write(_, _))
-      .Times(5)
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[3]), Return(true)))
-      .WillOnce(DoAll(SaveArg<0>(&actual_protos[4]), Return(true)));
+      .WillRepeatedly(Invoke([&actual_protos](const TransferResultChunkRequest& req, auto) {
+        actual_protos.push_back(req);
+        return true;
+      }));
 
   EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _)).WillOnce(Return(writer));
 
@@ -565,7 +661,9 @@ TEST_F(GRPCSinkNodeTest, break_up_row_batch_that_isnt_eow_eos) {
                 .get();
   tester.ConsumeNext(rb, 5, 0);
 
-  int64_t num_main_batches = num_rows / static_cast<int64_t>(kMaxBatchSize * kBatchSizeFactor);
+  // The 1548296 int64 values take up 24 times kMaxBatchSize * kBatchSizeFactor bytes, plus 64.
+  int64_t num_main_batches = 24;
+  ASSERT_EQ(actual_protos.size(), 26UL);
   EXPECT_EQ(actual_protos[num_main_batches + 1].query_result().row_batch().eow(), false);
   EXPECT_EQ(actual_protos[num_main_batches + 1].query_result().row_batch().eos(), false);
 
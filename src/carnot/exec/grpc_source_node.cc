@@ -25,6 +25,7 @@
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
+#include "src/common/zlib/zlib_wrapper.h"
 
 namespace px {
 namespace carnot {
@@ -45,9 +46,20 @@ Status GRPCSourceNode::InitImpl(const plan::Operator& plan_node) {
 }
 Status GRPCSourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
-Status GRPCSourceNode::OpenImpl(ExecState*) { return Status::OK(); }
+Status GRPCSourceNode::OpenImpl(ExecState* exec_state) {
+  stream_span_ = exec_state->StartSpan("grpc_source");
+  stream_span_.SetAttribute("node_id", plan_node_->id());
+  return Status::OK();
+}
 
-Status GRPCSourceNode::CloseImpl(ExecState*) { return Status::OK(); }
+Status GRPCSourceNode::CloseImpl(ExecState* exec_state) {
+  if (stream_span_.active()) {
+    stream_span_.SetAttribute("max_queued_bytes", max_queued_bytes_.load());
+    stream_span_.set_peak_memory_bytes(exec_state->peak_memory_bytes());
+    stream_span_.End();
+  }
+  return Status::OK();
+}
 
 Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
   PL_RETURN_IF_ERROR(PopRowBatch());
@@ -57,9 +69,16 @@ Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
 
 Status GRPCSourceNode::EnqueueRowBatch(
     std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
+  // ByteSizeLong caches the size in the message, PopRowBatch reads it back with GetCachedSize.
+  int64_t num_bytes = row_batch->ByteSizeLong();
   if (!row_batch_queue_.enqueue(std::move(row_batch))) {
     return error::Internal("Failed to enqueue RowBatch");
   }
+  int64_t queued_bytes = queued_bytes_ += num_bytes;
+  int64_t max_queued_bytes = max_queued_bytes_;
+  while (queued_bytes > max_queued_bytes &&
+         !max_queued_bytes_.compare_exchange_weak(max_queued_bytes, queued_bytes)) {
+  }
   return Status::OK();
 }
 
@@ -72,13 +91,41 @@ Status GRPCSourceNode::PopRowBatch() {
         "Called GRPCSourceNode::OptionallyPopRowBatch but there was no available row batch in the "
         "queue.");
   }
-  if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
+  int64_t num_bytes = rb_request->GetCachedSize();
+  int64_t prev_queued_bytes = queued_bytes_.fetch_sub(num_bytes);
+  if (prev_queued_bytes >= credit_window_bytes_ &&
+      prev_queued_bytes - num_bytes < credit_window_bytes_ && credits_available_callback_) {
+    credits_available_callback_();
+  }
+  stats()->AddExtraMetric("max_queued_bytes", max_queued_bytes_);
+  if (!rb_request->has_query_result()) {
+    return error::Internal(
+        "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
+        "message.");
+  }
+
+  auto result = rb_request->mutable_query_result();
+  if (result->result_contents_case() ==
+      carnotpb::TransferResultChunkRequest_SinkResult::kCompressedRowBatch) {
+    decompression_timer_.Resume();
+    auto serialized_or_s = zlib::Inflate(result->compressed_row_batch());
+    decompression_timer_.Stop();
+    PL_ASSIGN_OR_RETURN(std::string serialized, serialized_or_s);
+    if (!result->mutable_row_batch()->ParseFromString(serialized)) {
+      return error::Internal("GRPCSourceNode::PopRowBatch failed to parse compressed RowBatch.");
+    }
+    stats()->AddExtraMetric("decompression_time_ns",
+                            decompression_timer_.ElapsedTime_us() * 1000);
+  }
+
+  if (!result->has_row_batch()) {
     return error::Internal(
         "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
         "message.");
   }
 
-  PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromProto(rb_request->query_result().row_batch()));
+  // The request is owned here, so the arrays can take its buffers instead of copying them.
+  PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromMutableProto(result->mutable_row_batch()));
   return Status::OK();
 }
 
@@ -18,16 +18,21 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/plan/operators.h"
+#include "src/carnot/trace/query_trace.h"
 #include "src/common/base/base.h"
+#include "src/common/perf/elapsed_timer.h"
 #include "src/table_store/table_store.h"
 
 #include "blockingconcurrentqueue.h"
@@ -36,6 +41,10 @@ namespace px {
 namespace carnot {
 namespace exec {
 
+// The number of serialized bytes a GRPCSourceNode lets its upstream sinks queue up before the
+// router stops reading from their streams.
+constexpr int64_t kDefaultCreditWindowBytes = 64 * 1024 * 1024;
+
 class GRPCSourceNode : public SourceNode {
  public:
   GRPCSourceNode() = default;
@@ -56,6 +65,20 @@ class GRPCSourceNode : public SourceNode {
   void set_upstream_closed_connection() { upstream_closed_connection_ = true; }
   bool upstream_closed_connection() const { return upstream_closed_connection_; }
 
+  // Credits are the bytes left in the window granted to the upstream sinks. Once they run out,
+  // the router leaves further row batches in the GRPC stream, whose flow control then blocks
+  // the sending GRPCSinkNode until this node has drained its queue.
+  bool HasCredits() const { return queued_bytes_ < credit_window_bytes_; }
+  int64_t queued_bytes() const { return queued_bytes_; }
+  // Called from the exec thread whenever popping a row batch gives the sinks credits again.
+  void set_credits_available_callback(std::function<void()> callback) {
+    credits_available_callback_ = std::move(callback);
+  }
+
+  void testing_set_credit_window_bytes(int64_t window_bytes) {
+    credit_window_bytes_ = window_bytes;
+  }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -74,6 +97,16 @@ class GRPCSourceNode : public SourceNode {
   std::unique_ptr<plan::GRPCSourceOperator> plan_node_;
   bool upstream_initiated_connection_ = false;
   bool upstream_closed_connection_ = false;
+
+  ElapsedTimer decompression_timer_;
+  // Open from when the node is opened until it is closed, which includes waiting for the stream.
+  trace::QueryTrace::Span stream_span_;
+
+  int64_t credit_window_bytes_ = kDefaultCreditWindowBytes;
+  // Updated by the router threads on enqueue and the exec thread on pop.
+  std::atomic<int64_t> queued_bytes_{0};
+  std::atomic<int64_t> max_queued_bytes_{0};
+  std::function<void()> credits_available_callback_;
 };
 
 }  // namespace exec
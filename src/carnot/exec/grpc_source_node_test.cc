@@ -86,6 +86,40 @@ TEST_F(GRPCSourceNodeTest, basic) {
   EXPECT_FALSE(tester.node()->HasBatchesRemaining());
 }
 
+TEST_F(GRPCSourceNodeTest, credits) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  std::vector<types::Int64Value> data(10, 1);
+  auto rb = RowBatchBuilder(output_rd, 10, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>(data)
+                .get();
+  auto rb_wrapper = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  EXPECT_OK(rb.ToProto(rb_wrapper->mutable_query_result()->mutable_row_batch()));
+  int64_t batch_bytes = rb_wrapper->ByteSizeLong();
+
+  // The window fits one batch, so the second one uses up the credits.
+  tester.node()->testing_set_credit_window_bytes(batch_bytes + 1);
+  EXPECT_TRUE(tester.node()->HasCredits());
+  EXPECT_OK(tester.node()->EnqueueRowBatch(
+      std::make_unique<carnotpb::TransferResultChunkRequest>(*rb_wrapper)));
+  EXPECT_TRUE(tester.node()->HasCredits());
+  EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+  EXPECT_FALSE(tester.node()->HasCredits());
+  EXPECT_EQ(tester.node()->queued_bytes(), 2 * batch_bytes);
+
+  // Popping a batch gives its bytes back.
+  tester.GenerateNextResult().ExpectRowBatch(rb);
+  EXPECT_TRUE(tester.node()->HasCredits());
+  EXPECT_EQ(tester.node()->queued_bytes(), batch_bytes);
+  tester.GenerateNextResult().ExpectRowBatch(rb);
+  EXPECT_EQ(tester.node()->queued_bytes(), 0);
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
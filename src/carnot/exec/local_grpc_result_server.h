@@ -46,6 +46,11 @@ class LocalResultSinkServer final : public carnotpb::ResultSinkService::Service
     return query_results_;
   }
 
+  void ResetQueryResults() {
+    const std::lock_guard<std::mutex> lock(result_mutex_);
+    query_results_.clear();
+  }
+
   // Implements the TransferResultChunkAPI of ResultSinkService.
   ::grpc::Status TransferResultChunk(
       ::grpc::ServerContext*,
@@ -91,6 +96,9 @@ class LocalGRPCResultSinkServer {
     return result_sink_server_.query_results();
   }
 
+  // Drops the results received so far, so that the server can be reused by the next query.
+  void ResetQueryResults() { result_sink_server_.ResetQueryResults(); }
+
   StatusOr<QueryExecStats> exec_stats() {
     bool got_exec_stats = false;
     QueryExecStats output;
@@ -21,11 +21,16 @@
 #include <string>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
+DEFINE_bool(carnot_map_compiled_expressions, true,
+            "Whether maps evaluate the expressions that only use builtin math, logical and "
+            "comparison UDFs with native kernels instead of calling the UDFs.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -46,8 +51,13 @@ Status MapNode::InitImpl(const plan::Operator& plan_node) {
 }
 Status MapNode::PrepareImpl(ExecState* exec_state) {
   function_ctx_ = exec_state->CreateFunctionContext();
-  evaluator_ = ScalarExpressionEvaluator::Create(
-      plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative, function_ctx_.get());
+  auto evaluator_type = FLAGS_carnot_map_compiled_expressions
+                            ? ScalarExpressionEvaluatorType::kCompiled
+                            : ScalarExpressionEvaluatorType::kArrowNative;
+  evaluator_ = ScalarExpressionEvaluator::Create(plan_node_->expressions(), evaluator_type,
+                                                 function_ctx_.get());
+  evaluator_->set_mem_pool(mem_pool());
+  evaluator_->set_collect_udf_stats(stats()->collect_exec_stats);
   return Status::OK();
 }
 
@@ -58,6 +68,9 @@ Status MapNode::OpenImpl(ExecState* exec_state) {
 
 Status MapNode::CloseImpl(ExecState* exec_state) {
   stats()->AddExtraInfo("expressions", DebugString());
+  for (const auto& [udf_name, time_ns] : evaluator_->udf_exec_time_ns()) {
+    stats()->AddExtraMetric(absl::StrCat("udf_time_ns.", udf_name), time_ns);
+  }
   PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
   return Status::OK();
 }
@@ -18,12 +18,16 @@
 
 #include "src/carnot/exec/memory_source_node.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <string>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/gather_values.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
@@ -31,6 +35,19 @@ namespace px {
 namespace carnot {
 namespace exec {
 
+namespace {
+
+// The splitmix64 finalizer over the seed and the position of a batch or row, so that a sample
+// only depends on the data and the seed, and is the same on every agent and every run.
+uint64_t SampleHash(uint64_t seed, uint64_t batch_key, uint64_t row) {
+  uint64_t x = seed ^ (batch_key * 0x9e3779b97f4a7c15ULL) ^ (row * 0xc2b2ae3d27d4eb4fULL);
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
 std::string MemorySourceNode::DebugStringImpl() {
   return absl::Substitute("Exec::MemorySourceNode: <name: $0, output: $1>", plan_node_->TableName(),
                           output_descriptor_->DebugString());
@@ -42,6 +59,88 @@ Status MemorySourceNode::InitImpl(const plan::Operator& plan_node) {
   // copy the plan node to local object;
   plan_node_ = std::make_unique<plan::MemorySourceOperator>(*source_plan_node);
 
+  for (const auto& predicate_pb : plan_node_->predicates()) {
+    table_store::ZoneMapPredicate predicate;
+    predicate.column_idx = predicate_pb.column_idx();
+    switch (predicate_pb.op()) {
+      case planpb::ZoneMapPredicate::EQUAL:
+        predicate.op = table_store::ZoneMapPredicate::Op::kEqual;
+        break;
+      case planpb::ZoneMapPredicate::LESS_THAN:
+        predicate.op = table_store::ZoneMapPredicate::Op::kLessThan;
+        break;
+      case planpb::ZoneMapPredicate::LESS_THAN_EQUAL:
+        predicate.op = table_store::ZoneMapPredicate::Op::kLessThanEqual;
+        break;
+      case planpb::ZoneMapPredicate::GREATER_THAN:
+        predicate.op = table_store::ZoneMapPredicate::Op::kGreaterThan;
+        break;
+      case planpb::ZoneMapPredicate::GREATER_THAN_EQUAL:
+        predicate.op = table_store::ZoneMapPredicate::Op::kGreaterThanEqual;
+        break;
+      case planpb::ZoneMapPredicate::IN:
+        predicate.op = table_store::ZoneMapPredicate::Op::kIn;
+        break;
+      default:
+        return error::InvalidArgument("Unknown zone map predicate op $0", predicate_pb.op());
+    }
+    if (predicate.op == table_store::ZoneMapPredicate::Op::kIn) {
+      for (const auto& value : predicate_pb.values()) {
+        if (value.value_case() != planpb::ScalarValue::kUint128Value) {
+          return error::InvalidArgument(
+              "IN zone map predicates only support UINT128 values, got $0", value.DebugString());
+        }
+        predicate.uint128_values.push_back(
+            absl::MakeUint128(value.uint128_value().high(), value.uint128_value().low()));
+      }
+      if (predicate_pb.pod_names_size() > 0 || predicate_pb.service_names_size() > 0) {
+        metadata_names_.push_back(
+            {predicates_.size(),
+             {predicate_pb.pod_names().begin(), predicate_pb.pod_names().end()},
+             {predicate_pb.service_names().begin(), predicate_pb.service_names().end()}});
+      }
+      std::sort(predicate.uint128_values.begin(), predicate.uint128_values.end());
+      predicates_.push_back(predicate);
+      continue;
+    }
+    const auto& value = predicate_pb.value();
+    switch (value.value_case()) {
+      case planpb::ScalarValue::kInt64Value:
+        predicate.int_value = value.int64_value();
+        break;
+      case planpb::ScalarValue::kTime64NsValue:
+        predicate.int_value = value.time64_ns_value();
+        break;
+      case planpb::ScalarValue::kFloat64Value:
+        predicate.is_float = true;
+        predicate.float_value = value.float64_value();
+        break;
+      default:
+        return error::InvalidArgument("Zone map predicates only support numeric values, got $0",
+                                      value.DebugString());
+    }
+    predicates_.push_back(predicate);
+  }
+
+  if (plan_node_->HasSample()) {
+    const auto& sample = plan_node_->sample();
+    if (!(sample.rate() > 0 && sample.rate() <= 1)) {
+      return error::InvalidArgument("Sample rate must be in (0, 1], got $0", sample.rate());
+    }
+    switch (sample.unit()) {
+      case planpb::Sample::BATCH:
+        sample_batches_ = sample.rate() < 1;
+        break;
+      case planpb::Sample::ROW:
+        sample_rows_ = sample.rate() < 1;
+        break;
+      default:
+        return error::InvalidArgument("Unknown sample unit $0", sample.unit());
+    }
+    sample_seed_ = sample.seed();
+    sample_threshold_ = static_cast<uint64_t>(std::ldexp(sample.rate(), 64));
+  }
+
   return Status::OK();
 }
 
@@ -60,9 +159,12 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
   // because Stirling may be pushing to the table
   num_batches_ = table_->NumBatches();
 
+  if (!metadata_names_.empty()) {
+    ResolveMetadataPredicates(exec_state->metadata_state());
+  }
+
   if (plan_node_->HasStartTime()) {
-    start_batch_info_ = table_->FindBatchPositionGreaterThanOrEqual(plan_node_->start_time(),
-                                                                    exec_state->exec_mem_pool());
+    start_batch_info_ = table_->FindBatchPositionGreaterThanOrEqual(plan_node_->start_time());
 
     // TODO(philkuz) might have a race condition where the data hasn't loaded yet for the
     // start_time.
@@ -73,57 +175,311 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
                                                             : start_batch_info_.batch_idx;
   }
 
+  if (plan_node_->HasStopTime() && !infinite_stream_) {
+    // The stop time is exclusive, so the scan ends at the first row at or after it.
+    stop_batch_info_ = table_->FindBatchPositionGreaterThanOrEqual(plan_node_->stop_time());
+    if (stop_batch_info_.FoundValidBatches()) {
+      end_batch_ = stop_batch_info_.row_idx == 0 ? stop_batch_info_.batch_idx
+                                                 : stop_batch_info_.batch_idx + 1;
+    }
+    if (plan_node_->HasStartTime() && plan_node_->stop_time() <= plan_node_->start_time()) {
+      current_batch_ = std::numeric_limits<int64_t>::max();
+    }
+    disk_stop_time_ = plan_node_->stop_time();
+  }
+
+  // The batches that were expired to disk are all older than the ones in memory, so only the
+  // batches up to the start time have to be looked up.
+  disk_tier_ = table_->disk_tier();
+  if (disk_tier_ != nullptr && plan_node_->HasStartTime() &&
+      plan_node_->start_time() < disk_stop_time_) {
+    disk_batches_ = disk_tier_->BatchesInRange(plan_node_->start_time(), disk_stop_time_);
+  }
+  if (sample_batches_) {
+    // Disk batches are keyed by their negative position, apart from the batches in memory.
+    std::vector<std::shared_ptr<const table_store::DiskTier::Batch>> sampled_disk_batches;
+    for (size_t i = 0; i < disk_batches_.size(); ++i) {
+      if (InSample(-1 - static_cast<int64_t>(i), -1)) {
+        sampled_disk_batches.push_back(std::move(disk_batches_[i]));
+      } else {
+        ++batches_sampled_out_;
+      }
+    }
+    disk_batches_ = std::move(sampled_disk_batches);
+  }
+
   return Status::OK();
 }
 
+void MemorySourceNode::ResolveMetadataPredicates(const md::AgentMetadataState* metadata_state) {
+  if (metadata_state == nullptr) {
+    // No batch can be ruled out by names that can't be resolved.
+    for (auto it = metadata_names_.rbegin(); it != metadata_names_.rend(); ++it) {
+      predicates_.erase(predicates_.begin() + it->predicate_idx);
+    }
+    metadata_names_.clear();
+    return;
+  }
+
+  // The names are matched the way upid_to_pod_name() and upid_to_service_name() compute them, so
+  // that the batches skipped are exactly those the filter would drop all the rows of.
+  const auto& k8s_state = metadata_state->k8s_metadata_state();
+  for (const auto& [upid, pid_info] : metadata_state->pids_by_upid()) {
+    if (pid_info == nullptr) {
+      continue;
+    }
+    const auto* container_info = k8s_state.ContainerInfoByID(pid_info->cid());
+    if (container_info == nullptr) {
+      continue;
+    }
+    const auto* pod_info = k8s_state.PodInfoByID(container_info->pod_id());
+    if (pod_info == nullptr) {
+      continue;
+    }
+    std::string pod_name = absl::Substitute("$0/$1", pod_info->ns(), pod_info->name());
+    // Pods with several running services get a list of them as their service name, which never
+    // equals a single name.
+    std::string service_name;
+    int num_running_services = 0;
+    for (const auto& service_id : pod_info->services()) {
+      const auto* service_info = k8s_state.ServiceInfoByID(service_id);
+      if (service_info == nullptr || service_info->stop_time_ns() != 0) {
+        continue;
+      }
+      ++num_running_services;
+      service_name = absl::Substitute("$0/$1", service_info->ns(), service_info->name());
+    }
+    if (num_running_services != 1) {
+      service_name.clear();
+    }
+
+    for (const auto& names : metadata_names_) {
+      if (names.pod_names.contains(pod_name) ||
+          (!service_name.empty() && names.service_names.contains(service_name))) {
+        predicates_[names.predicate_idx].uint128_values.push_back(upid.value());
+      }
+    }
+  }
+  for (const auto& names : metadata_names_) {
+    auto& values = predicates_[names.predicate_idx].uint128_values;
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+  }
+}
+
 Status MemorySourceNode::CloseImpl(ExecState*) {
   stats()->AddExtraInfo("infinite_stream", infinite_stream_ ? "true" : "false");
+  if (!predicates_.empty()) {
+    stats()->AddExtraInfo("batches_skipped", absl::StrCat(batches_skipped_));
+  }
+  if (!disk_batches_.empty()) {
+    stats()->AddExtraInfo("disk_batches_scanned", absl::StrCat(current_disk_batch_));
+  }
+  // The results computed from a sample are approximate, which the stats make explicit.
+  if (sample_batches_ || sample_rows_) {
+    stats()->AddExtraInfo("sample_rate", absl::StrCat(plan_node_->sample().rate()));
+    stats()->AddExtraInfo(sample_batches_ ? "batches_sampled_out" : "rows_sampled_out",
+                          absl::StrCat(sample_batches_ ? batches_sampled_out_ : rows_sampled_out_));
+  }
+  // The source is closed before its end of stream when a limit (locally or on the remote
+  // destination of the results) stopped it, so the rest of the range never had to be read.
+  if (table_ != nullptr && morsel_queue_ == nullptr && !infinite_stream_ &&
+      HasBatchesRemaining() && current_batch_ < EndBatch()) {
+    stats()->AddExtraInfo("batches_not_scanned", absl::StrCat(EndBatch() - current_batch_));
+  }
   return Status::OK();
 }
 
-StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState* exec_state) {
-  DCHECK(table_ != nullptr);
-
-  if (current_batch_ >= table_->NumBatches()) {
-    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ true, /* eos */ true);
-  }
-
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetRowBatch(int64_t batch_idx) {
   auto offset = 0;
   auto end = -1;
-  if (plan_node_->HasStartTime() && current_batch_ == start_batch_info_.batch_idx) {
+  if (plan_node_->HasStartTime() && batch_idx == start_batch_info_.batch_idx) {
     offset = start_batch_info_.row_idx;
   }
+  if (end_batch_ != -1 && batch_idx == stop_batch_info_.batch_idx) {
+    end = stop_batch_info_.row_idx;
+  }
 
-  // TODO(michellenguyen, PL-388): Fix our table store to correctly support hot/cold data. For now,
-  // do not support StopTime.
-  PL_ASSIGN_OR_RETURN(auto row_batch,
-                      table_->GetRowBatchSlice(current_batch_, plan_node_->Columns(),
-                                               exec_state->exec_mem_pool(), offset, end));
+  PL_ASSIGN_OR_RETURN(auto row_batch, table_->GetRowBatchSlice(batch_idx, plan_node_->Columns(),
+                                                                mem_pool(), offset, end));
+
+  rows_processed_ += row_batch->num_rows();
+  bytes_processed_ += row_batch->NumBytes();
+  if (sample_rows_) {
+    return SampleRows(batch_idx, offset, std::move(row_batch));
+  }
+  return row_batch;
+}
 
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextDiskBatch() {
+  // The reference is dropped once the batch is read, so that the tier can remove its file.
+  int64_t disk_batch_idx = current_disk_batch_++;
+  auto batch = std::move(disk_batches_[disk_batch_idx]);
+  PL_ASSIGN_OR_RETURN(auto row_batch,
+                      disk_tier_->ReadBatch(*batch, plan_node_->Columns(),
+                                            plan_node_->start_time(), disk_stop_time_));
   rows_processed_ += row_batch->num_rows();
   bytes_processed_ += row_batch->NumBytes();
+  if (sample_rows_) {
+    return SampleRows(-1 - disk_batch_idx, 0, std::move(row_batch));
+  }
+  return row_batch;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::SampleRows(
+    int64_t batch_key, int64_t first_row, std::unique_ptr<RowBatch> row_batch) {
+  int64_t num_rows = row_batch->num_rows();
+  // Same branch-free selection as the filter node's.
+  sample_selection_.resize(num_rows);
+  int64_t num_selected = 0;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    sample_selection_[num_selected] = i;
+    num_selected += InSample(batch_key, first_row + i);
+  }
+  rows_sampled_out_ += num_rows - num_selected;
+  if (num_selected == num_rows) {
+    return row_batch;
+  }
+
+  auto sampled_batch = std::make_unique<RowBatch>(row_batch->desc(), num_selected);
+  for (int64_t col_idx = 0; col_idx < row_batch->num_columns(); ++col_idx) {
+    auto input_col = row_batch->ColumnAt(col_idx);
+#define TYPE_CASE(_dt_)                                                                  \
+  PL_RETURN_IF_ERROR(GatherValues<_dt_>(sample_selection_, num_selected, input_col.get(), \
+                                        sampled_batch.get()));
+    PL_SWITCH_FOREACH_DATATYPE(row_batch->desc().type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+  sampled_batch->set_eow(row_batch->eow());
+  sampled_batch->set_eos(row_batch->eos());
+  return sampled_batch;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch() {
+  DCHECK(table_ != nullptr);
+
+  if (HasDiskBatchesRemaining()) {
+    PL_ASSIGN_OR_RETURN(auto row_batch, GetNextDiskBatch());
+    if (!HasDiskBatchesRemaining() && current_batch_ >= EndBatch() && !infinite_stream_) {
+      row_batch->set_eow(true);
+      row_batch->set_eos(true);
+    }
+    return row_batch;
+  }
+
+  while (current_batch_ < EndBatch() && !ShouldReadBatch(current_batch_)) {
+    current_batch_++;
+  }
+  if (current_batch_ >= EndBatch()) {
+    // Infinite streams only get here when the rest of the batches were skipped.
+    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ !infinite_stream_,
+                                  /* eos */ !infinite_stream_);
+  }
+
+  PL_ASSIGN_OR_RETURN(auto row_batch, GetRowBatch(current_batch_));
   current_batch_++;
 
   // If infinite stream is set, we don't send Eow or Eos. Infinite streams therefore never cause
   // HasBatchesRemaining to be false. Instead the outer loop that calls GenerateNext() is
   // responsible for managing whether we continue the stream or end it.
-  if (current_batch_ >= table_->NumBatches() && !infinite_stream_) {
+  if (current_batch_ >= EndBatch() && !infinite_stream_) {
     row_batch->set_eow(true);
     row_batch->set_eos(true);
   }
   return row_batch;
 }
 
+Status MemorySourceNode::GenerateNextMorsel(ExecState* exec_state) {
+  // Only the source that shares its range reads the disk batches, before claiming morsels.
+  if (HasDiskBatchesRemaining()) {
+    PL_ASSIGN_OR_RETURN(auto row_batch, GetNextDiskBatch());
+    return SendRowBatchToChildren(exec_state, *row_batch);
+  }
+  int64_t batch_idx = morsel_queue_->Next();
+  while (batch_idx != MorselQueue::kDrained && batch_idx < EndBatch() &&
+         !ShouldReadBatch(batch_idx)) {
+    batch_idx = morsel_queue_->Next();
+  }
+  if (batch_idx != MorselQueue::kDrained && batch_idx < EndBatch()) {
+    PL_ASSIGN_OR_RETURN(auto row_batch, GetRowBatch(batch_idx));
+    return SendRowBatchToChildren(exec_state, *row_batch);
+  }
+
+  morsels_drained_ = true;
+  if (!morsel_sends_eos_) {
+    return Status::OK();
+  }
+  // The other sources sharing the queue may still be working on their last morsels, so they
+  // need to finish before the end of stream reaches the pipeline breaker.
+  if (morsels_drained_hook_) {
+    PL_RETURN_IF_ERROR(morsels_drained_hook_());
+  }
+  PL_ASSIGN_OR_RETURN(auto eos_batch, RowBatch::WithZeroRows(*output_descriptor_, /* eow */ true,
+                                                             /* eos */ true));
+  return SendRowBatchToChildren(exec_state, *eos_batch);
+}
+
 Status MemorySourceNode::GenerateNextImpl(ExecState* exec_state) {
-  PL_ASSIGN_OR_RETURN(auto row_batch, GetNextRowBatch(exec_state));
+  if (morsel_queue_ != nullptr) {
+    return GenerateNextMorsel(exec_state);
+  }
+  PL_ASSIGN_OR_RETURN(auto row_batch, GetNextRowBatch());
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *row_batch));
   return Status::OK();
 }
 
+int64_t MemorySourceNode::EndBatch() const {
+  int64_t num_batches = table_->NumBatches();
+  return end_batch_ == -1 ? num_batches : std::min(end_batch_, num_batches);
+}
+
+bool MemorySourceNode::BatchMayMatch(int64_t batch_idx) {
+  if (predicates_.empty() || table_->BatchMayMatch(batch_idx, predicates_)) {
+    return true;
+  }
+  ++batches_skipped_;
+  return false;
+}
+
+bool MemorySourceNode::BatchInSample(int64_t batch_idx) {
+  if (!sample_batches_ || InSample(batch_idx, -1)) {
+    return true;
+  }
+  ++batches_sampled_out_;
+  return false;
+}
+
+bool MemorySourceNode::InSample(int64_t batch_key, int64_t row) const {
+  return SampleHash(sample_seed_, batch_key, row) < sample_threshold_;
+}
+
+std::shared_ptr<MorselQueue> MemorySourceNode::ShareBatchRange() {
+  DCHECK(table_ != nullptr);
+  DCHECK(!infinite_stream_) << "Streaming sources can't be split into morsels.";
+  // current_batch_ is past the end of the table when no batch matches the start time.
+  int64_t num_batches = EndBatch();
+  auto queue = std::make_shared<MorselQueue>(std::min(current_batch_, num_batches), num_batches);
+  SetMorselQueue(queue, /* sends_eos */ true);
+  return queue;
+}
+
+void MemorySourceNode::SetMorselQueue(std::shared_ptr<MorselQueue> queue, bool sends_eos) {
+  morsel_queue_ = std::move(queue);
+  morsel_sends_eos_ = sends_eos;
+  if (!sends_eos) {
+    disk_batches_.clear();
+  }
+  morsels_drained_ = false;
+}
+
 bool MemorySourceNode::NextBatchReady() {
+  if (morsel_queue_ != nullptr) {
+    return HasBatchesRemaining() && !morsels_drained_;
+  }
   // Next batch is ready if we haven't seen an eow and if it's an infinite_stream that has batches
   // to push.
-  return HasBatchesRemaining() && (!infinite_stream_ || (current_batch_ < table_->NumBatches()));
+  return HasBatchesRemaining() &&
+         (!infinite_stream_ || HasDiskBatchesRemaining() || (current_batch_ < EndBatch()));
 }
 
 }  // namespace exec
@@ -19,12 +19,18 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/morsel_queue.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
@@ -44,6 +50,32 @@ class MemorySourceNode : public SourceNode {
 
   bool NextBatchReady() override;
 
+  /**
+   * Switches this source to morsel-driven mode and returns the queue holding the rest of its
+   * batch range, so that other sources scanning the same table can share the scan.
+   * Must be called after Open().
+   */
+  std::shared_ptr<MorselQueue> ShareBatchRange();
+
+  /**
+   * Makes this source pull its batches from the given queue instead of scanning the table in
+   * order. Must be called after Open().
+   * @param queue The queue to claim batches from.
+   * @param sends_eos Whether this source is responsible for sending end of stream to its children
+   * once the queue is drained. Worker clones of a pipeline don't send eos, their state is merged
+   * into the main pipeline instead.
+   */
+  void SetMorselQueue(std::shared_ptr<MorselQueue> queue, bool sends_eos);
+
+  /**
+   * Registers a function that is called once the morsel queue is drained, right before this
+   * source sends end of stream. Used to wait for (and merge the state of) the other sources
+   * sharing the queue.
+   */
+  void SetMorselsDrainedHook(std::function<Status()> hook) {
+    morsels_drained_hook_ = std::move(hook);
+  }
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -53,7 +85,29 @@ class MemorySourceNode : public SourceNode {
   Status GenerateNextImpl(ExecState* exec_state) override;
 
  private:
-  StatusOr<std::unique_ptr<RowBatch>> GetNextRowBatch(ExecState* exec_state);
+  // Adds the UPIDs of the processes of the pods and services named by the predicates to their
+  // values, or drops those predicates when there's no metadata to resolve the names with.
+  void ResolveMetadataPredicates(const md::AgentMetadataState* metadata_state);
+  StatusOr<std::unique_ptr<RowBatch>> GetNextRowBatch();
+  StatusOr<std::unique_ptr<RowBatch>> GetRowBatch(int64_t batch_idx);
+  StatusOr<std::unique_ptr<RowBatch>> GetNextDiskBatch();
+  bool HasDiskBatchesRemaining() const { return current_disk_batch_ < disk_batches_.size(); }
+  Status GenerateNextMorsel(ExecState* exec_state);
+  // One past the last batch to scan.
+  int64_t EndBatch() const;
+  // Returns false if the zone maps of the batch show that it can be skipped.
+  bool BatchMayMatch(int64_t batch_idx);
+  // Returns false if the batch isn't part of the sample, when sampling batches.
+  bool BatchInSample(int64_t batch_idx);
+  bool ShouldReadBatch(int64_t batch_idx) {
+    return BatchInSample(batch_idx) && BatchMayMatch(batch_idx);
+  }
+  // Whether the row (or the whole batch, for row -1) is part of the sample.
+  bool InSample(int64_t batch_key, int64_t row) const;
+  // Keeps the rows of the batch that are part of the sample, when sampling rows. The rows are
+  // keyed by the batch and their index in it, first_row being the index of the first one.
+  StatusOr<std::unique_ptr<RowBatch>> SampleRows(int64_t batch_key, int64_t first_row,
+                                                 std::unique_ptr<RowBatch> row_batch);
 
   int64_t num_batches_;
   int64_t current_batch_ = 0;
@@ -61,6 +115,43 @@ class MemorySourceNode : public SourceNode {
   // exec_state_->keep_running() call in exec_graph.
   bool infinite_stream_ = false;
   table_store::BatchPosition start_batch_info_;
+  table_store::BatchPosition stop_batch_info_;
+  // One past the last batch that holds rows before the stop time, or -1 to scan to the end.
+  int64_t end_batch_ = -1;
+
+  // Predicates pushed down from the filter that consumes this source.
+  std::vector<table_store::ZoneMapPredicate> predicates_;
+  int64_t batches_skipped_ = 0;
+  // The pod and service names of the IN predicates, resolved into UPIDs on Open().
+  struct MetadataNames {
+    size_t predicate_idx;
+    absl::flat_hash_set<std::string> pod_names;
+    absl::flat_hash_set<std::string> service_names;
+  };
+  std::vector<MetadataNames> metadata_names_;
+
+  // Set when the source reads a sample of the table instead of all of it.
+  bool sample_batches_ = false;
+  bool sample_rows_ = false;
+  uint64_t sample_seed_ = 0;
+  // A batch or row is part of the sample when its hash is below the threshold.
+  uint64_t sample_threshold_ = 0;
+  int64_t batches_sampled_out_ = 0;
+  int64_t rows_sampled_out_ = 0;
+  std::vector<int64_t> sample_selection_;
+
+  // Set when this source shares its scan with other sources (morsel-driven execution).
+  std::shared_ptr<MorselQueue> morsel_queue_;
+  bool morsel_sends_eos_ = true;
+  bool morsels_drained_ = false;
+  std::function<Status()> morsels_drained_hook_;
+
+  // The batches of the table's disk tier in the time range, which are scanned before the batches
+  // in memory. Empty unless the start time reaches back past the data in memory.
+  std::shared_ptr<const table_store::DiskTier> disk_tier_;
+  std::vector<std::shared_ptr<const table_store::DiskTier::Batch>> disk_batches_;
+  size_t current_disk_batch_ = 0;
+  int64_t disk_stop_time_ = std::numeric_limits<int64_t>::max();
 
   std::unique_ptr<plan::MemorySourceOperator> plan_node_;
   table_store::Table* table_ = nullptr;
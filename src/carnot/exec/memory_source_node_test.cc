@@ -19,6 +19,7 @@
 #include "src/carnot/exec/memory_source_node.h"
 
 #include <arrow/memory_pool.h>
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -31,6 +32,10 @@
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/planpb/test_proto.h"
 #include "src/carnot/udf/registry.h"
+#include "src/common/testing/temp_dir.h"
+#include "src/shared/k8s/metadatapb/test_proto.h"
+#include "src/shared/metadata/state_manager.h"
+#include "src/shared/metadata/test_utils.h"
 #include "src/common/base/test_utils.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/column_wrapper.h"
@@ -43,6 +48,7 @@ using table_store::Column;
 using table_store::Table;
 using table_store::schema::RowDescriptor;
 using ::testing::_;
+using ResourceUpdate = px::shared::k8s::metadatapb::ResourceUpdate;
 
 class MemorySourceNodeTest : public ::testing::Test {
  protected:
@@ -217,6 +223,279 @@ TEST_F(MemorySourceNodeTest, all_range) {
   tester.Close();
 }
 
+TEST_F(MemorySourceNodeTest, range_reaches_into_disk_tier) {
+  table_store::schema::Relation rel({types::DataType::BOOLEAN, types::DataType::TIME64NS},
+                                    {"col1", "time_"});
+  auto table = std::make_shared<Table>(rel, -1);
+  testing::TempDir temp_dir;
+  ASSERT_OK(table->EnableDiskTier(temp_dir.path() / "cpu", 1024 * 1024));
+  for (const auto& times : std::vector<std::vector<types::Time64NSValue>>{{1, 2, 3}, {5, 6}}) {
+    table_store::schema::RowBatch rb(RowDescriptor(rel.col_types()), times.size());
+    std::vector<types::BoolValue> bools(times.size(), true);
+    ASSERT_OK(rb.AddColumn(types::ToArrow(bools, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    ASSERT_OK(table->WriteRowBatch(rb));
+  }
+  // Expire the first batch to disk. The source reads the "cpu" table, so this one replaces it.
+  ASSERT_OK(table->SetMaxTableSize(table->NumBytes() - 1));
+  ASSERT_EQ(1, table->NumBatches());
+  exec_state_->table_store()->AddTable("cpu", table);
+
+  auto op_proto = planpb::testutils::CreateTestSourceAllRangePB();
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 1, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({3})
+          .get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(3, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, zone_map_predicate_skips_batches) {
+  // The first batch holds times {1, 2, 3}, so none of its rows are greater than 4.
+  auto op_proto = planpb::testutils::CreateTestSourceGreaterThanPredicatePB(4);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(2, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, zone_map_predicate_skips_all_batches) {
+  auto op_proto = planpb::testutils::CreateTestSourceGreaterThanPredicatePB(10);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 0, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(0, tester.node()->RowsProcessed());
+}
+
+class MemorySourceNodeSampleTest : public ::testing::Test {
+ protected:
+  static constexpr int64_t kNumBatches = 200;
+  static constexpr int64_t kBatchSize = 50;
+
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+
+    table_store::schema::Relation rel({types::DataType::BOOLEAN, types::DataType::TIME64NS},
+                                      {"col1", "time_"});
+    auto table = Table::Create(rel);
+    exec_state_->table_store()->AddTable("events", table);
+    for (int64_t batch = 0; batch < kNumBatches; ++batch) {
+      std::vector<types::BoolValue> col1(kBatchSize, true);
+      std::vector<types::Int64Value> times;
+      for (int64_t i = 0; i < kBatchSize; ++i) {
+        times.push_back(batch * kBatchSize + i);
+      }
+      EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(col1, arrow::default_memory_pool())));
+      EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(times, arrow::default_memory_pool())));
+    }
+  }
+
+  // Reads the sample of the table and returns the times of its rows.
+  std::vector<int64_t> ReadSample(planpb::Sample::Unit unit, double rate) {
+    auto op_proto = planpb::testutils::CreateTestSource1PB("events");
+    auto sample = op_proto.mutable_mem_source_op()->mutable_sample();
+    sample->set_unit(unit);
+    sample->set_rate(rate);
+    sample->set_seed(7);
+    std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+    RowDescriptor output_rd({types::DataType::TIME64NS});
+
+    auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+        *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+    std::vector<int64_t> times;
+    while (tester.node()->HasBatchesRemaining()) {
+      auto rb = tester.GenerateNextResult().PopRowBatch();
+      for (int64_t i = 0; i < rb->num_rows(); ++i) {
+        times.push_back(types::GetValueFromArrowArray<types::TIME64NS>(rb->ColumnAt(0).get(), i));
+      }
+    }
+    tester.Close();
+    rows_processed_ = tester.node()->RowsProcessed();
+    return times;
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+  int64_t rows_processed_ = 0;
+};
+
+TEST_F(MemorySourceNodeSampleTest, batch_sample_skips_whole_batches) {
+  auto times = ReadSample(planpb::Sample::BATCH, 0.25);
+  // A quarter of the batches is expected, the bounds are more than 3 standard deviations wide.
+  int64_t num_rows = times.size();
+  int64_t num_batches = num_rows / kBatchSize;
+  EXPECT_EQ(num_rows % kBatchSize, 0);
+  EXPECT_GT(num_batches, 30);
+  EXPECT_LT(num_batches, 70);
+  for (int64_t i = 0; i < num_rows; i += kBatchSize) {
+    EXPECT_EQ(times[i] % kBatchSize, 0);
+    EXPECT_EQ(times[i + kBatchSize - 1], times[i] + kBatchSize - 1);
+  }
+  // The batches that aren't in the sample are never read.
+  EXPECT_EQ(rows_processed_, num_rows);
+}
+
+TEST_F(MemorySourceNodeSampleTest, row_sample) {
+  auto times = ReadSample(planpb::Sample::ROW, 0.1);
+  EXPECT_GT(times.size(), 850UL);
+  EXPECT_LT(times.size(), 1150UL);
+  EXPECT_TRUE(std::is_sorted(times.begin(), times.end()));
+  EXPECT_EQ(rows_processed_, kNumBatches * kBatchSize);
+}
+
+TEST_F(MemorySourceNodeSampleTest, sample_is_deterministic) {
+  EXPECT_EQ(ReadSample(planpb::Sample::BATCH, 0.3), ReadSample(planpb::Sample::BATCH, 0.3));
+  EXPECT_EQ(ReadSample(planpb::Sample::ROW, 0.3), ReadSample(planpb::Sample::ROW, 0.3));
+}
+
+TEST_F(MemorySourceNodeSampleTest, full_rate_reads_everything) {
+  const size_t num_rows = kNumBatches * kBatchSize;
+  EXPECT_EQ(ReadSample(planpb::Sample::BATCH, 1.0).size(), num_rows);
+  EXPECT_EQ(ReadSample(planpb::Sample::ROW, 1.0).size(), num_rows);
+}
+
+class MemorySourceNodeUPIDTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+
+    table_store::schema::Relation rel({types::DataType::UINT128, types::DataType::TIME64NS},
+                                      {"upid", "time_"});
+    auto table = Table::Create(rel);
+    exec_state_->table_store()->AddTable("events", table);
+    // The first batch has the processes of pl/running_pod and pl/terminating_pod, the second one
+    // only an unknown process.
+    std::vector<types::UInt128Value> upids1 = {kRunningPodUPID, kTerminatingPodUPID};
+    std::vector<types::UInt128Value> upids2 = {kUnknownUPID};
+    std::vector<types::Int64Value> times1 = {1, 2};
+    std::vector<types::Int64Value> times2 = {3};
+    EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(upids1, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(0)->AddBatch(types::ToArrow(upids2, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(times1, arrow::default_memory_pool())));
+    EXPECT_OK(table->GetColumn(1)->AddBatch(types::ToArrow(times2, arrow::default_memory_pool())));
+  }
+
+  void SetUpMetadata() {
+    auto metadata_state = std::make_shared<md::AgentMetadataState>(
+        /* hostname */ "myhost", /* asid */ 123, sole::uuid4(), "mypod");
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+    updates.enqueue(metadatapb::testutils::CreateRunningContainerUpdatePB());
+    updates.enqueue(metadatapb::testutils::CreateRunningPodUpdatePB());
+    updates.enqueue(metadatapb::testutils::CreateRunningServiceUpdatePB());
+    updates.enqueue(metadatapb::testutils::CreateTerminatingContainerUpdatePB());
+    updates.enqueue(metadatapb::testutils::CreateTerminatingPodUpdatePB());
+    updates.enqueue(metadatapb::testutils::CreateTerminatingServiceUpdatePB());
+    md::TestAgentMetadataFilter md_filter;
+    ASSERT_OK(md::ApplyK8sUpdates(10, metadata_state.get(), &md_filter, &updates));
+
+    auto upid1 = md::UPID(123, 567, 89101);
+    metadata_state->AddUPID(upid1,
+                            std::make_unique<md::PIDInfo>(upid1, "test", "pod1_container_1"));
+    auto upid2 = md::UPID(123, 567, 468);
+    metadata_state->AddUPID(upid2,
+                            std::make_unique<md::PIDInfo>(upid2, "cmdline", "pod2_container_1"));
+    exec_state_->set_metadata_state(metadata_state);
+  }
+
+  // Reads the table with the predicate on its upid column, and returns the times of the rows.
+  std::vector<int64_t> Read(const planpb::ZoneMapPredicate& predicate) {
+    auto op_proto = planpb::testutils::CreateTestSource1PB("events");
+    auto predicate_pb = op_proto.mutable_mem_source_op()->add_predicates();
+    *predicate_pb = predicate;
+    predicate_pb->set_column_idx(0);
+    predicate_pb->set_op(planpb::ZoneMapPredicate::IN);
+    std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+    RowDescriptor output_rd({types::DataType::TIME64NS});
+
+    auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+        *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+    std::vector<int64_t> times;
+    while (tester.node()->HasBatchesRemaining()) {
+      auto rb = tester.GenerateNextResult().PopRowBatch();
+      for (int64_t i = 0; i < rb->num_rows(); ++i) {
+        times.push_back(types::GetValueFromArrowArray<types::TIME64NS>(rb->ColumnAt(0).get(), i));
+      }
+    }
+    tester.Close();
+    return times;
+  }
+
+  // md::UPID(123, 567, 89101) and md::UPID(123, 567, 468).
+  const types::UInt128Value kRunningPodUPID{528280977975, 89101};
+  const types::UInt128Value kTerminatingPodUPID{528280977975, 468};
+  const types::UInt128Value kUnknownUPID{528280977975, 1};
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(MemorySourceNodeUPIDTest, in_predicate_skips_batches) {
+  planpb::ZoneMapPredicate predicate;
+  auto value = predicate.add_values();
+  value->mutable_uint128_value()->set_high(kUnknownUPID.High64());
+  value->mutable_uint128_value()->set_low(kUnknownUPID.Low64());
+  EXPECT_THAT(Read(predicate), ::testing::ElementsAre(3));
+}
+
+TEST_F(MemorySourceNodeUPIDTest, pod_names_resolved_from_metadata) {
+  SetUpMetadata();
+  planpb::ZoneMapPredicate predicate;
+  predicate.add_pod_names("pl/terminating_pod");
+  EXPECT_THAT(Read(predicate), ::testing::ElementsAre(1, 2));
+
+  predicate.Clear();
+  predicate.add_pod_names("pl/no_such_pod");
+  EXPECT_THAT(Read(predicate), ::testing::ElementsAre());
+}
+
+TEST_F(MemorySourceNodeUPIDTest, service_names_resolved_from_metadata) {
+  SetUpMetadata();
+  planpb::ZoneMapPredicate predicate;
+  predicate.add_service_names("pl/terminating_service");
+  EXPECT_THAT(Read(predicate), ::testing::ElementsAre(1, 2));
+}
+
+TEST_F(MemorySourceNodeUPIDTest, names_without_metadata_read_everything) {
+  planpb::ZoneMapPredicate predicate;
+  predicate.add_pod_names("pl/no_such_pod");
+  EXPECT_THAT(Read(predicate), ::testing::ElementsAre(1, 2, 3));
+}
+
 class MemorySourceNodeTabletTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -26,7 +26,8 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
-void KMeansCoreset::Construct(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+void KMeansCoreset::Construct(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights,
+                              std::mt19937* gen) {
   auto weight_sum = weights.sum();
   auto weighted_mean = ((weights.transpose() * points) / weight_sum).eval();
   auto dists = (points.rowwise() - weighted_mean).rowwise().squaredNorm().eval();
@@ -38,7 +39,11 @@ void KMeansCoreset::Construct(const Eigen::MatrixXf& points, const Eigen::Vector
       ((0.5 * weights / weight_sum).array() + 0.5 * (weighted_dists / weighted_dists_sum).array())
           .eval();
   Eigen::ArrayXi sample_inds;
-  sample_from_probs(probs, &sample_inds, size_);
+  if (gen == nullptr) {
+    sample_from_probs(probs, &sample_inds, size_);
+  } else {
+    sample_from_probs(probs, &sample_inds, size_, gen);
+  }
   points_ = points(sample_inds, Eigen::all);
   // u(x)
   weights_ =
@@ -46,9 +51,9 @@ void KMeansCoreset::Construct(const Eigen::MatrixXf& points, const Eigen::Vector
 }
 
 std::shared_ptr<KMeansCoreset> KMeansCoreset::FromWeightedPointSet(
-    std::shared_ptr<WeightedPointSet> set, size_t coreset_size) {
+    std::shared_ptr<WeightedPointSet> set, size_t coreset_size, std::mt19937* gen) {
   auto coreset = std::make_shared<KMeansCoreset>(coreset_size, set->point_size());
-  coreset->Construct(set->points(), set->weights());
+  coreset->Construct(set->points(), set->weights(), gen);
   return coreset;
 }
 
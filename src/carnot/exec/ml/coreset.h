@@ -22,7 +22,9 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <memory>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -140,8 +142,13 @@ class WeightedPointSet {
 class KMeansCoreset : public WeightedPointSet {
  public:
   KMeansCoreset(int coreset_size, int d) : WeightedPointSet(coreset_size, d) {}
+  /**
+   * Samples a coreset of the set. The samples are drawn from gen if it's given, and are otherwise
+   * random.
+   **/
   static std::shared_ptr<KMeansCoreset> FromWeightedPointSet(std::shared_ptr<WeightedPointSet> set,
-                                                             size_t coreset_size);
+                                                             size_t coreset_size,
+                                                             std::mt19937* gen = nullptr);
 
  private:
   /**
@@ -150,7 +157,7 @@ class KMeansCoreset : public WeightedPointSet {
    * Modifies the algorithm slightly to allow for weighted point set input rather than just point
    * set input.
    **/
-  void Construct(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  void Construct(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights, std::mt19937* gen);
 };
 
 template <typename TCoreset>
@@ -159,9 +166,11 @@ class CoresetTree {
 
  public:
   /**
-   * r-way Coreset Tree.
+   * r-way Coreset Tree. The coresets are sampled with a generator seeded with seed, so that the
+   * tree built from the same sequence of updates is always the same.
    **/
-  CoresetTree(size_t r, size_t coreset_size) : coreset_size_(coreset_size), r_(r) {}
+  CoresetTree(size_t r, size_t coreset_size, unsigned int seed = 42)
+      : coreset_size_(coreset_size), r_(r), random_gen_(seed) {}
 
   void Update(std::shared_ptr<WeightedPointSet> set) {
     if (levels_.size() == 0) {
@@ -170,8 +179,8 @@ class CoresetTree {
     levels_[0].push_back(set);
     auto i = 0UL;
     while (levels_[i].size() >= r_) {
-      auto merged =
-          TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
+      auto merged = TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]),
+                                                   coreset_size_, &random_gen_);
       levels_[i].clear();
       if (levels_.size() <= i + 1) {
         levels_.emplace_back();
@@ -210,8 +219,8 @@ class CoresetTree {
     // Fix the r-way tree by coresetting any levels that have r or more buckets after merge.
     for (auto i = 0UL; i < levels_.size(); i++) {
       if (levels_[i].size() >= r_) {
-        auto merged =
-            TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
+        auto merged = TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]),
+                                                     coreset_size_, &random_gen_);
         levels_[i].clear();
         if (i == levels_.size() - 1) {
           levels_.emplace_back();
@@ -277,6 +286,7 @@ class CoresetTree {
   size_t coreset_size_;
   size_t r_;
   std::vector<Level> levels_;
+  std::mt19937 random_gen_;
 };
 
 template <typename TCoresetStructure>
@@ -310,12 +320,19 @@ class CoresetDriver {
 
   void Merge(const CoresetDriver<TCoresetStructure>& other) {
     coreset_data_.Merge(other.coreset_data_);
-    auto new_set = WeightedPointSet::Union({CurrentSet(), other.CurrentSet()});
-    if (new_set->size() >= m_) {
-      coreset_data_.Update(new_set);
-      size_ = 0;
-    } else {
-      GatherPointsFromSet(new_set);
+    // Stream the other driver's buffered points into this one's buffer, which is flushed into the
+    // coreset structure whenever it fills up, instead of building a union of both buffers.
+    int offset = 0;
+    while (offset < other.size_) {
+      int n = std::min(m_ - size_, other.size_ - offset);
+      points_.middleRows(size_, n) = other.points_.middleRows(offset, n);
+      weights_.segment(size_, n) = other.weights_.segment(offset, n);
+      size_ += n;
+      offset += n;
+      if (size_ == m_) {
+        coreset_data_.Update(std::make_shared<WeightedPointSet>(points_, weights_));
+        size_ = 0;
+      }
     }
   }
 
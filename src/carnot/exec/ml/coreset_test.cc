@@ -81,6 +81,35 @@ TEST(CoresetDriver, merge) {
   EXPECT_EQ(192, driver1.Query()->size());
 }
 
+TEST(CoresetDriver, merge_partial_buckets) {
+  int d = 8;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver1(64, d, 4, 64);
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver2(64, d, 4, 64);
+  Eigen::VectorXf point = Eigen::VectorXf::Random(d);
+  for (int i = 0; i < 40; i++) {
+    driver1.Update(point);
+    driver2.Update(point);
+  }
+  // The 80 buffered points fill one bucket, and 16 points stay buffered.
+  driver1.Merge(driver2);
+  EXPECT_EQ(80, driver1.Query()->size());
+}
+
+TEST(CoresetDriver, reproducible) {
+  int d = 8;
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver1(64, d, 4, 64);
+  CoresetDriver<CoresetTree<KMeansCoreset>> driver2(64, d, 4, 64);
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(64 * 10, d);
+  for (int i = 0; i < points.rows(); i++) {
+    driver1.Update(points.row(i).transpose());
+    driver2.Update(points.row(i).transpose());
+  }
+  auto set1 = driver1.Query();
+  auto set2 = driver2.Query();
+  EXPECT_EQ(set1->points(), set2->points());
+  EXPECT_EQ(set1->weights(), set2->weights());
+}
+
 TEST(CoresetDriver, serialization) {
   // Create a coreset driver using the Coreset R-way tree data structure, and kmeans coresets.
   // Uses base buckets of size 64, points of size 64, 4-way tree, and coresets of size 64.
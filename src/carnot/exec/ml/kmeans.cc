@@ -17,9 +17,15 @@
  */
 
 #include "src/carnot/exec/ml/kmeans.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <random>
+#include <vector>
 
 #include "src/carnot/exec/ml/sampling.h"
+#include "src/common/base/worker_pool.h"
 
 namespace px {
 namespace carnot {
@@ -48,18 +54,57 @@ void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
   }
 }
 
+void KMeans::ForEachChunk(int num_rows, const std::function<void(int, int, int)>& fn) const {
+  int num_chunks = (num_rows + kChunkSize - 1) / kChunkSize;
+  WorkerPool* pool = WorkerPool::Default();
+  int num_threads = num_threads_;
+  if (num_threads <= 0) {
+    num_threads = std::min<int>(kMaxThreads, pool->num_threads() + 1);
+  }
+  num_threads = std::min(num_threads, num_chunks);
+
+  std::atomic<int> next_chunk{0};
+  auto run_chunks = [&]() {
+    for (int chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+      int first_row = chunk * kChunkSize;
+      fn(chunk, first_row, std::min(kChunkSize, num_rows - first_row));
+    }
+  };
+  // Each of the num_threads runners takes chunks until none are left, so at most num_threads
+  // chunks are processed at once.
+  pool->ParallelFor(num_threads, [&](size_t) { run_chunks(); });
+}
+
 bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
+  int num_chunks = (points.rows() + kChunkSize - 1) / kChunkSize;
+  std::vector<Eigen::MatrixXf> chunk_centroids(num_chunks);
+  std::vector<Eigen::ArrayXf> chunk_weights(num_chunks);
+  // The distance to a centroid is |p|^2 - 2 p.c + |c|^2. |p|^2 doesn't change which centroid is
+  // closest, and the p.c terms of a whole chunk are a single (vectorized) matrix product.
+  Eigen::VectorXf centroid_norms = centroids_.rowwise().squaredNorm();
+
+  ForEachChunk(points.rows(), [&](int chunk, int first_row, int num_rows) {
+    auto chunk_points = points.middleRows(first_row, num_rows);
+    Eigen::MatrixXf dots = chunk_points * centroids_.transpose();
+    Eigen::MatrixXf& sums = chunk_centroids[chunk];
+    Eigen::ArrayXf& sum_weights = chunk_weights[chunk];
+    sums = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
+    sum_weights = Eigen::ArrayXf::Zero(centroids_.rows());
+
+    for (int i = 0; i < num_rows; i++) {
+      Eigen::VectorXf::Index closest_centroid;
+      (centroid_norms - 2 * dots.row(i).transpose()).minCoeff(&closest_centroid);
+      float weight = weights(first_row + i);
+      sums.row(closest_centroid) += weight * chunk_points.row(i);
+      sum_weights(closest_centroid) += weight;
+    }
+  });
+
   Eigen::MatrixXf new_centroids = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
   Eigen::ArrayXf centroid_weights = Eigen::ArrayXf::Zero(centroids_.rows());
-
-  for (int i = 0; i < points.rows(); i++) {
-    Eigen::VectorXf::Index closest_centroid;
-    (centroids_.rowwise() - points(i, Eigen::all))
-        .rowwise()
-        .squaredNorm()
-        .minCoeff(&closest_centroid);
-    new_centroids(closest_centroid, Eigen::all) += weights(i) * points(i, Eigen::all);
-    centroid_weights(closest_centroid) += weights(i);
+  for (int chunk = 0; chunk < num_chunks; ++chunk) {
+    new_centroids += chunk_centroids[chunk];
+    centroid_weights += chunk_weights[chunk];
   }
 
   for (int i = 0; i < k_; i++) {
@@ -82,17 +127,20 @@ void KMeans::KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::Vect
   auto firstCentroid = dist(random_gen_);
   centroids_(0, Eigen::all) = points(firstCentroid, Eigen::all);
 
+  // The distance of every point to its closest centroid so far. Only the distance to the newest
+  // centroid has to be computed in each round.
+  Eigen::VectorXf minDist(points.rows());
+  minDist.setConstant(std::numeric_limits<float>::infinity());
   Eigen::VectorXf probDist(points.rows());
   for (auto i = 1; i < k_; i++) {
-    for (auto j = 0; j < probDist.rows(); j++) {
-      auto point = points(j, Eigen::all);
-      Eigen::VectorXf::Index closestCentroid;
-      auto dist = (centroids_(Eigen::seq(0, i - 1), Eigen::all).rowwise() - point)
-                      .rowwise()
-                      .squaredNorm()
-                      .minCoeff(&closestCentroid);
-      probDist(j) = weights(j) * dist;
-    }
+    auto centroid = centroids_.row(i - 1);
+    ForEachChunk(points.rows(), [&](int, int first_row, int num_rows) {
+      auto chunkMinDist = minDist.segment(first_row, num_rows);
+      chunkMinDist = chunkMinDist.cwiseMin(
+          (points.middleRows(first_row, num_rows).rowwise() - centroid).rowwise().squaredNorm());
+      probDist.segment(first_row, num_rows) =
+          weights.segment(first_row, num_rows).cwiseProduct(chunkMinDist);
+    });
     std::discrete_distribution<> pointDist(probDist.begin(), probDist.end());
     auto ind = pointDist(random_gen_);
     centroids_(i, Eigen::all) = points(ind, Eigen::all);
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <random>
 #include <string>
@@ -34,9 +35,24 @@ class KMeans {
   enum KMeansInitType {
     kKMeansPlusPlus = 0,
   };
+  // Points are processed in fixed size chunks, which are spread across up to num_threads threads
+  // of the default WorkerPool.
+  // The chunks are always combined in the same order, so the result for a given seed doesn't
+  // depend on the number of threads.
+  static constexpr int kChunkSize = 1024;
+  static constexpr int kMaxThreads = 4;
+
+  /**
+   * @param num_threads the number of threads used by Fit, or 0 to use up to kMaxThreads depending
+   * on the size of the default WorkerPool.
+   */
   explicit KMeans(int k, int max_iters = 10, KMeansInitType init_type = kKMeansPlusPlus,
-                  unsigned int seed = 42)
-      : k_(k), max_iters_(max_iters), init_type_(init_type), random_gen_(seed) {}
+                  unsigned int seed = 42, int num_threads = 0)
+      : k_(k),
+        max_iters_(max_iters),
+        init_type_(init_type),
+        random_gen_(seed),
+        num_threads_(num_threads) {}
 
   /**
    * Run kmeans on a weighted set of points.
@@ -59,12 +75,15 @@ class KMeans {
  private:
   bool LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
   void KMeansPlusPlusInit(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights);
+  // Calls fn(chunk_index, first_row, num_rows) for every chunk of num_rows rows.
+  void ForEachChunk(int num_rows, const std::function<void(int, int, int)>& fn) const;
 
   int k_;
   int max_iters_;
   KMeansInitType init_type_;
   Eigen::MatrixXf centroids_;
   std::mt19937 random_gen_;
+  int num_threads_;
 };
 
 }  // namespace ml
@@ -58,5 +58,23 @@ static void BM_KMeansTransform(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_KMeansFitLarge(benchmark::State& state) {
+  int k = 10;
+  int d = 64;
+  KMeans kmeans(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42,
+                /*num_threads*/ state.range(0));
+
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(50000, d);
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(50000);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  for (auto _ : state) {
+    kmeans.Fit(set);
+  }
+  state.SetItemsProcessed(state.iterations() * points.rows());
+}
+
 BENCHMARK(BM_KMeansFit);
+BENCHMARK(BM_KMeansFitLarge)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_KMeansTransform);
@@ -96,6 +96,23 @@ TEST(KMeans, trimodal_normal_dist) {
   }
 }
 
+TEST(KMeans, same_result_for_any_num_threads) {
+  int k = 8;
+  // Enough points for several chunks.
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(3 * KMeans::kChunkSize + 17, 16);
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(points.rows());
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  KMeans single_threaded(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 7,
+                         /*num_threads*/ 1);
+  single_threaded.Fit(set);
+  KMeans multi_threaded(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 7,
+                        /*num_threads*/ 4);
+  multi_threaded.Fit(set);
+
+  EXPECT_EQ(single_threaded.centroids(), multi_threaded.centroids());
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <random>
+
 #include "src/common/base/base.h"
 #include "third_party/eigen3/Eigen/Core"
 
@@ -27,6 +29,9 @@ namespace exec {
 namespace ml {
 
 void sample_from_probs(const Eigen::ArrayXf& probs, Eigen::ArrayXi* inds, size_t sample_size);
+// Same as above, but draws the samples from the given generator so that they are reproducible.
+void sample_from_probs(const Eigen::ArrayXf& probs, Eigen::ArrayXi* inds, size_t sample_size,
+                       std::mt19937* gen);
 
 size_t randint(size_t high);
 
@@ -18,14 +18,19 @@
 
 #include "src/carnot/exec/ml/transformer_executor.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
-static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
+static constexpr int kEmbeddingSize = 256;
+
+static int load_ints_from_json(std::string_view in, int32_t* arr, int max_num) {
   rapidjson::Document d;
-  rapidjson::ParseResult ok = d.Parse(in.data());
+  rapidjson::ParseResult ok = d.Parse(in.data(), in.size());
   // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
   if (ok == nullptr) {
     return 0;
@@ -50,56 +55,95 @@ static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
 }
 
 void TransformerExecutor::Execute(std::string doc, std::string* out) {
-  // LOG(INFO) << "inputs: " << tf_interpreter_->inputs().size() << "\n";
-  // LOG(INFO) << "input(0) name: " << tf_interpreter_->GetInputName(0) << "\n";
+  std::vector<std::string> outs;
+  ExecuteBatch({doc}, &outs);
+  *out = std::move(outs[0]);
+}
 
-  // int t_size = tf_interpreter_->tensors_size();
-  // for (int i = 0; i < t_size; i++) {
-  //   if (tf_interpreter_->tensor(i)->name) {
-  //     LOG(INFO) << i << ": " << tf_interpreter_->tensor(i)->name << ", "
-  //               << tf_interpreter_->tensor(i)->bytes << ", "
-  //               << tf_interpreter_->tensor(i)->type;
-  //   }
-  // }
-  auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
-  if (input == nullptr) {
-    LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
-    *out = "";
-    return;
+bool TransformerExecutor::ResizeBatch(int batch_size) {
+  if (batch_size == batch_size_) {
+    return true;
   }
-
-  auto count = load_ints_from_json(doc, input, max_length_);
-  if (count == 0) {
-    // Either input array was empty or there was an error parsing the json, either way don't
-    // continue.
-    *out = "";
-    return;
+  tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {batch_size, max_length_});
+  if (tf_interpreter_->AllocateTensors() == kTfLiteOk) {
+    batch_size_ = batch_size;
+    return true;
   }
-
-  // Add 1 to each token to account for pad token.
-  for (int i = 0; i < count; i++) {
-    input[i] = input[i] + 1;
+  if (batch_size == 1) {
+    return false;
   }
+  LOG(INFO) << "Transformer model doesn't support batches, running docs one at a time";
+  batching_supported_ = false;
+  return ResizeBatch(1);
+}
 
-  for (int i = count; i < max_length_; i++) {
-    input[i] = 0;
-  }
+void TransformerExecutor::ExecuteBatch(const std::vector<std::string_view>& docs,
+                                       std::vector<std::string>* outs) {
+  outs->assign(docs.size(), "");
+  const size_t max_batch_size = batching_supported_ ? kMaxBatchSize : 1;
+  std::vector<bool> valid;
 
-  const int embedding_size = 256;
+  for (size_t start = 0; start < docs.size(); start += max_batch_size) {
+    int batch_size = static_cast<int>(std::min(max_batch_size, docs.size() - start));
+    if (!ResizeBatch(batch_size)) {
+      LOG(INFO) << "Failed to allocate tensors";
+      return;
+    }
+    if (!batching_supported_ && batch_size > 1) {
+      // Batching was disabled by the resize, redo this batch one doc at a time.
+      std::vector<std::string> batch_outs;
+      ExecuteBatch({docs.begin() + start, docs.end()}, &batch_outs);
+      std::move(batch_outs.begin(), batch_outs.end(), outs->begin() + start);
+      return;
+    }
 
-  tf_interpreter_->Invoke();
+    auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
+    if (input == nullptr) {
+      LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
+      return;
+    }
 
-  auto output = tf_interpreter_->typed_output_tensor<float>(0);
+    valid.assign(batch_size, false);
+    bool any_valid = false;
+    for (int b = 0; b < batch_size; ++b) {
+      int32_t* row = input + b * max_length_;
+      auto count = load_ints_from_json(docs[start + b], row, max_length_);
+      // Either the input array was empty or there was an error parsing the json, either way the
+      // row is left as padding and its output is ignored.
+      if (count > 0) {
+        valid[b] = true;
+        any_valid = true;
+      }
+      // Add 1 to each token to account for pad token.
+      for (int i = 0; i < count; i++) {
+        row[i] = row[i] + 1;
+      }
+      for (int i = count; i < max_length_; i++) {
+        row[i] = 0;
+      }
+    }
+    if (!any_valid) {
+      continue;
+    }
+
+    tf_interpreter_->Invoke();
 
-  // Copy output to json array.
-  rapidjson::StringBuffer sb;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-  writer.StartArray();
-  for (int i = 0; i < embedding_size; i++) {
-    writer.Double(output[i]);
+    auto output = tf_interpreter_->typed_output_tensor<float>(0);
+    for (int b = 0; b < batch_size; ++b) {
+      if (!valid[b]) {
+        continue;
+      }
+      // Copy output to json array.
+      rapidjson::StringBuffer sb;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+      writer.StartArray();
+      for (int i = 0; i < kEmbeddingSize; i++) {
+        writer.Double(output[b * kEmbeddingSize + i]);
+      }
+      writer.EndArray();
+      (*outs)[start + b] = sb.GetString();
+    }
   }
-  writer.EndArray();
-  *out = sb.GetString();
 }
 
 }  // namespace ml
@@ -26,6 +26,8 @@
 #include <tensorflow/lite/model.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "src/carnot/exec/ml/model_executor.h"
 #include "src/common/base/utils.h"
 
@@ -41,12 +43,14 @@ class TransformerExecutor : public ModelExecutor {
 
   static constexpr ModelType Type() { return kTransformer; }
 
+  // The maximum number of docs that are run through the model in a single invocation.
+  static constexpr size_t kMaxBatchSize = 32;
+
   void Init(std::string model_proto_path) {
     model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
     tflite::ops::builtin::BuiltinOpResolver resolver;
     tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
-    tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {1, max_length_});
-    if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    if (!ResizeBatch(1)) {
       LOG(INFO) << "Failed to allocate tensors";
     } else {
       LOG(INFO) << "Init Transformer model";
@@ -55,10 +59,23 @@ class TransformerExecutor : public ModelExecutor {
 
   void Execute(std::string doc, std::string* out);
 
+  /**
+   * Computes the embeddings of a batch of docs, where each doc is a JSON array of token ids.
+   * Docs are padded into batches of up to kMaxBatchSize, which are run through the model with a
+   * single invocation each. The embedding of a doc that can't be parsed is an empty string.
+   */
+  void ExecuteBatch(const std::vector<std::string_view>& docs, std::vector<std::string>* outs);
+
  private:
+  // Resizes the input tensor to hold batch_size docs. If the model doesn't support batches,
+  // batching is disabled and docs are run one at a time.
+  bool ResizeBatch(int batch_size);
+
   std::unique_ptr<tflite::Interpreter> tf_interpreter_;
   std::unique_ptr<tflite::FlatBufferModel> model_;
   int max_length_ = 64;
+  int batch_size_ = 0;
+  bool batching_supported_ = true;
 };
 
 }  // namespace ml
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * MorselQueue hands out the batch indices of a table scan one at a time, so that several
+ * MemorySourceNodes scanning the same table can split the work between them. A batch is a
+ * "morsel": whichever source claims it next owns it, so faster workers naturally take more of
+ * the range.
+ *
+ * This class is thread-safe.
+ */
+class MorselQueue : public NotCopyable {
+ public:
+  static constexpr int64_t kDrained = -1;
+
+  /**
+   * @param start_batch The first batch index to hand out.
+   * @param end_batch One past the last batch index to hand out.
+   */
+  MorselQueue(int64_t start_batch, int64_t end_batch) : next_(start_batch), end_(end_batch) {}
+
+  /**
+   * Claims the next batch index.
+   * @return the claimed batch index, or kDrained if the range has been exhausted or cancelled.
+   */
+  int64_t Next() {
+    if (cancelled_.load()) {
+      return kDrained;
+    }
+    int64_t batch = next_.fetch_add(1);
+    return batch < end_ ? batch : kDrained;
+  }
+
+  /**
+   * Stops handing out batches. Any subsequent call to Next() returns kDrained.
+   */
+  void Cancel() { cancelled_ = true; }
+
+ private:
+  std::atomic<int64_t> next_;
+  const int64_t end_;
+  std::atomic<bool> cancelled_ = false;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/query_admission_controller.h"
+
+#include <algorithm>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+// Waiting queries re-check their admission at this interval, since memory is freed by running
+// queries without notifying the controller.
+constexpr std::chrono::milliseconds kAdmissionPollInterval{10};
+}  // namespace
+
+QueryAdmissionController::Ticket::~Ticket() { controller_->Release(this); }
+
+void QueryAdmissionController::Ticket::CheckMemoryBudget() {
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_budget_check_ < kBudgetCheckInterval) {
+    return;
+  }
+  last_budget_check_ = now;
+  controller_->EnforceMemoryBudget();
+}
+
+StatusOr<std::unique_ptr<QueryAdmissionController::Ticket>> QueryAdmissionController::Admit(
+    const sole::uuid& query_id, int64_t priority, std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::unique_lock<std::mutex> lock(mu_);
+  Waiter self{query_id, priority, next_seq_++};
+  waiting_.push_back(self);
+  auto remove_self = [&]() {
+    waiting_.erase(std::find_if(waiting_.begin(), waiting_.end(),
+                                [&](const Waiter& w) { return w.seq == self.seq; }));
+  };
+
+  while (!CanAdmit(self)) {
+    if (timeout.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+      remove_self();
+      // The next waiter in line may be admissible now that this one is gone.
+      cv_.notify_all();
+      return error::ResourceUnavailable(
+          "Query $0 was not admitted within $1ms: $2 queries running, $3 bytes allocated.",
+          query_id.str(), timeout.count(), running_.size(), BytesAllocatedLocked());
+    }
+    EnforceMemoryBudgetLocked();
+    cv_.wait_for(lock, kAdmissionPollInterval);
+  }
+  remove_self();
+
+  auto ticket = std::unique_ptr<Ticket>(new Ticket(this, query_id, priority));
+  running_.insert(ticket.get());
+  cv_.notify_all();
+  return ticket;
+}
+
+bool QueryAdmissionController::CanAdmit(const Waiter& waiter) {
+  // Only the highest priority waiter may be admitted, so that lower priority queries can't
+  // take the slots freed for it.
+  for (const auto& w : waiting_) {
+    if (w.priority > waiter.priority || (w.priority == waiter.priority && w.seq < waiter.seq)) {
+      return false;
+    }
+  }
+  if (max_concurrent_queries_ > 0 &&
+      static_cast<int64_t>(running_.size()) >= max_concurrent_queries_) {
+    return false;
+  }
+  // Always admit when nothing is running, otherwise results that are kept alive after their
+  // query finished could block every query.
+  if (memory_budget_bytes_ > 0 && !running_.empty() &&
+      BytesAllocatedLocked() >= memory_budget_bytes_) {
+    return false;
+  }
+  return true;
+}
+
+void QueryAdmissionController::Release(Ticket* ticket) {
+  std::lock_guard<std::mutex> lock(mu_);
+  running_.erase(ticket);
+  if (ticket->mem_pool_->bytes_allocated() > 0) {
+    retired_pools_.push_back(ticket->mem_pool_);
+  }
+  cv_.notify_all();
+}
+
+void QueryAdmissionController::EnforceMemoryBudget() {
+  std::lock_guard<std::mutex> lock(mu_);
+  EnforceMemoryBudgetLocked();
+}
+
+void QueryAdmissionController::EnforceMemoryBudgetLocked() {
+  // Running queries may use more than the budget as long as no other query needs the memory.
+  if (memory_budget_bytes_ <= 0 || waiting_.empty()) {
+    return;
+  }
+  int64_t bytes_allocated = BytesAllocatedLocked();
+  if (bytes_allocated <= memory_budget_bytes_) {
+    return;
+  }
+  Ticket* largest = nullptr;
+  for (Ticket* ticket : running_) {
+    // Give a cancellation time to take effect before cancelling another query.
+    if (ticket->cancelled()) {
+      return;
+    }
+    if (largest == nullptr || ticket->bytes_allocated() > largest->bytes_allocated()) {
+      largest = ticket;
+    }
+  }
+  // The memory is held by finished queries, cancelling a running one wouldn't free it.
+  if (largest == nullptr || largest->bytes_allocated() == 0) {
+    return;
+  }
+  LOG(WARNING) << absl::Substitute(
+      "Cancelling query $0 which allocated $1 bytes, queries allocated $2 bytes of the $3 byte "
+      "budget.",
+      largest->query_id().str(), largest->bytes_allocated(), bytes_allocated,
+      memory_budget_bytes_);
+  largest->cancelled_ = true;
+}
+
+int64_t QueryAdmissionController::bytes_allocated() {
+  std::lock_guard<std::mutex> lock(mu_);
+  return BytesAllocatedLocked();
+}
+
+int64_t QueryAdmissionController::BytesAllocatedLocked() {
+  auto freed = [](const auto& pool) { return pool->bytes_allocated() == 0; };
+  retired_pools_.erase(std::remove_if(retired_pools_.begin(), retired_pools_.end(), freed),
+                       retired_pools_.end());
+  int64_t bytes = 0;
+  for (const auto& pool : retired_pools_) {
+    bytes += pool->bytes_allocated();
+  }
+  for (const Ticket* ticket : running_) {
+    bytes += ticket->bytes_allocated();
+  }
+  return bytes;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+#include <sole.hpp>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/huge_page_memory_pool.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * QueryAdmissionController bounds the resources used by all of the queries running in a Carnot
+ * instance. Queries have to be admitted before they execute: a query waits while the maximum
+ * number of queries are already running or while the memory in use by queries is over the budget,
+ * and waiting queries are admitted highest priority first (FIFO within a priority).
+ *
+ * Each admitted query gets its own arrow memory pool so that the bytes allocated by its operators
+ * can be accounted for. When the memory in use exceeds the budget while queries are waiting, the
+ * running query that has allocated the most is cancelled.
+ */
+class QueryAdmissionController : public NotCopyable {
+ public:
+  /**
+   * Ticket is held by an admitted query for as long as it executes. The query's slot is returned
+   * when the ticket is destroyed.
+   */
+  class Ticket : public NotCopyable {
+   public:
+    ~Ticket();
+
+    const sole::uuid& query_id() const { return query_id_; }
+    int64_t priority() const { return priority_; }
+
+    // The pool that the operators of this query allocate from.
+    arrow::MemoryPool* mem_pool() { return mem_pool_.get(); }
+    int64_t bytes_allocated() const { return mem_pool_->bytes_allocated(); }
+
+    // Set when the controller cancelled this query to bring memory use back under the budget.
+    bool cancelled() const { return cancelled_.load(); }
+
+    /**
+     * Cancels the largest query if memory use is over the budget while queries are waiting for
+     * admission. Called from the execution loop of the query, so it only takes the controller's
+     * lock once per kBudgetCheckInterval.
+     */
+    void CheckMemoryBudget();
+
+   private:
+    friend class QueryAdmissionController;
+    Ticket(QueryAdmissionController* controller, const sole::uuid& query_id, int64_t priority)
+        : controller_(controller),
+          query_id_(query_id),
+          priority_(priority),
+          mem_pool_(std::make_shared<arrow::ProxyMemoryPool>(types::DataMemoryPool())) {}
+
+    QueryAdmissionController* controller_;
+    const sole::uuid query_id_;
+    const int64_t priority_;
+    // Shared so that the pool can outlive the query while buffers it allocated are still alive.
+    std::shared_ptr<arrow::ProxyMemoryPool> mem_pool_;
+    std::atomic<bool> cancelled_{false};
+    std::chrono::steady_clock::time_point last_budget_check_;
+  };
+
+  static constexpr std::chrono::milliseconds kBudgetCheckInterval{10};
+
+  /**
+   * @param memory_budget_bytes The memory all queries together may allocate. 0 means unlimited.
+   * @param max_concurrent_queries The number of queries that may execute at the same time.
+   * 0 means unlimited.
+   */
+  QueryAdmissionController(int64_t memory_budget_bytes, int64_t max_concurrent_queries)
+      : memory_budget_bytes_(memory_budget_bytes),
+        max_concurrent_queries_(max_concurrent_queries) {}
+
+  /**
+   * Blocks until the query can be admitted.
+   * @param priority Queries with a higher priority are admitted first.
+   * @param timeout How long to wait for admission. A timeout of 0 waits forever.
+   * @return the ticket of the admitted query, or ResourceUnavailable if it timed out.
+   */
+  StatusOr<std::unique_ptr<Ticket>> Admit(const sole::uuid& query_id, int64_t priority,
+                                          std::chrono::milliseconds timeout);
+
+  // Cancels the running query with the largest allocation if memory is over the budget and
+  // queries are waiting for admission.
+  void EnforceMemoryBudget();
+
+  // The bytes allocated by all queries, including finished queries whose results are still alive.
+  int64_t bytes_allocated();
+  int64_t num_running() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return running_.size();
+  }
+  int64_t num_waiting() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return waiting_.size();
+  }
+
+ private:
+  struct Waiter {
+    sole::uuid query_id;
+    int64_t priority;
+    int64_t seq;
+  };
+
+  void Release(Ticket* ticket);
+  bool CanAdmit(const Waiter& waiter);
+  void EnforceMemoryBudgetLocked();
+  int64_t BytesAllocatedLocked();
+
+  const int64_t memory_budget_bytes_;
+  const int64_t max_concurrent_queries_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  int64_t next_seq_ = 0;
+  std::vector<Waiter> waiting_;
+  absl::flat_hash_set<Ticket*> running_;
+  // Pools of finished queries that still have live allocations, ie. result batches.
+  std::vector<std::shared_ptr<arrow::ProxyMemoryPool>> retired_pools_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/carnot/exec/query_admission_controller.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+constexpr std::chrono::milliseconds kWaitForever{0};
+constexpr std::chrono::milliseconds kShortTimeout{20};
+
+TEST(QueryAdmissionControllerTest, times_out_at_max_concurrent_queries) {
+  QueryAdmissionController controller(/* memory_budget_bytes */ 0,
+                                      /* max_concurrent_queries */ 1);
+  ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit(sole::uuid4(), 0, kWaitForever));
+  EXPECT_EQ(1, controller.num_running());
+
+  auto s = controller.Admit(sole::uuid4(), 0, kShortTimeout);
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(error::IsResourceUnavailable(s.status()));
+  EXPECT_EQ(0, controller.num_waiting());
+
+  ticket.reset();
+  EXPECT_EQ(0, controller.num_running());
+  EXPECT_OK(controller.Admit(sole::uuid4(), 0, kShortTimeout));
+}
+
+TEST(QueryAdmissionControllerTest, admits_highest_priority_first) {
+  QueryAdmissionController controller(/* memory_budget_bytes */ 0,
+                                      /* max_concurrent_queries */ 1);
+  ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit(sole::uuid4(), 0, kWaitForever));
+
+  std::mutex mu;
+  std::vector<int64_t> admitted;
+  auto run_query = [&](int64_t priority) {
+    auto t = controller.Admit(sole::uuid4(), priority, kWaitForever).ConsumeValueOrDie();
+    std::lock_guard<std::mutex> lock(mu);
+    admitted.push_back(t->priority());
+  };
+  std::thread low(run_query, 1);
+  while (controller.num_waiting() < 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::thread high(run_query, 2);
+  while (controller.num_waiting() < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  ticket.reset();
+  low.join();
+  high.join();
+  EXPECT_EQ(std::vector<int64_t>({2, 1}), admitted);
+}
+
+TEST(QueryAdmissionControllerTest, cancels_largest_query_over_budget) {
+  QueryAdmissionController controller(/* memory_budget_bytes */ 1000,
+                                      /* max_concurrent_queries */ 0);
+  ASSERT_OK_AND_ASSIGN(auto small, controller.Admit(sole::uuid4(), 0, kWaitForever));
+  ASSERT_OK_AND_ASSIGN(auto large, controller.Admit(sole::uuid4(), 0, kWaitForever));
+
+  uint8_t* small_buf;
+  uint8_t* large_buf;
+  ASSERT_TRUE(small->mem_pool()->Allocate(200, &small_buf).ok());
+  ASSERT_TRUE(large->mem_pool()->Allocate(2000, &large_buf).ok());
+  EXPECT_EQ(200, small->bytes_allocated());
+  EXPECT_EQ(2200, controller.bytes_allocated());
+
+  // Running queries over the budget hold off new queries.
+  EXPECT_FALSE(controller.Admit(sole::uuid4(), 0, kShortTimeout).ok());
+  EXPECT_TRUE(large->cancelled());
+  EXPECT_FALSE(small->cancelled());
+
+  large->mem_pool()->Free(large_buf, 2000);
+  large.reset();
+  EXPECT_OK(controller.Admit(sole::uuid4(), 0, kShortTimeout));
+  small->mem_pool()->Free(small_buf, 200);
+}
+
+TEST(QueryAdmissionControllerTest, no_cancellation_without_waiting_queries) {
+  QueryAdmissionController controller(/* memory_budget_bytes */ 1000,
+                                      /* max_concurrent_queries */ 0);
+  ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit(sole::uuid4(), 0, kWaitForever));
+
+  uint8_t* buf;
+  ASSERT_TRUE(ticket->mem_pool()->Allocate(2000, &buf).ok());
+  controller.EnforceMemoryBudget();
+  EXPECT_FALSE(ticket->cancelled());
+
+  ticket->mem_pool()->Free(buf, 2000);
+}
+
+TEST(QueryAdmissionControllerTest, accounts_allocations_that_outlive_the_query) {
+  QueryAdmissionController controller(/* memory_budget_bytes */ 1000,
+                                      /* max_concurrent_queries */ 0);
+  ASSERT_OK_AND_ASSIGN(auto ticket, controller.Admit(sole::uuid4(), 0, kWaitForever));
+  arrow::MemoryPool* pool = ticket->mem_pool();
+  uint8_t* buf;
+  ASSERT_TRUE(pool->Allocate(100, &buf).ok());
+  ticket.reset();
+
+  EXPECT_EQ(100, controller.bytes_allocated());
+  pool->Free(buf, 100);
+  EXPECT_EQ(0, controller.bytes_allocated());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/result_cache.h"
+
+#include <limits>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+#include <absl/time/time.h>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+ResultCache::Lookup::Lookup(Lookup&& other) noexcept
+    : cache_(other.cache_),
+      key_(std::move(other.key_)),
+      versions_(std::move(other.versions_)),
+      entry_(std::move(other.entry_)),
+      done_(other.done_) {
+  other.cache_ = nullptr;
+}
+
+ResultCache::Lookup::~Lookup() {
+  if (cache_ != nullptr && !done_) {
+    cache_->FinishRun(key_);
+  }
+}
+
+void ResultCache::Lookup::Complete(SinkResults results, int64_t bytes) {
+  DCHECK(entry_ == nullptr) << "Complete() called on a cache hit";
+  if (cache_ == nullptr || done_) {
+    return;
+  }
+  done_ = true;
+  if (bytes <= cache_->max_entry_bytes()) {
+    auto entry = std::make_shared<Entry>();
+    entry->results = std::move(results);
+    entry->versions = std::move(versions_);
+    entry->bytes = bytes;
+    entry->inserted_at = std::chrono::steady_clock::now();
+    cache_->Insert(key_, std::move(entry));
+  }
+  cache_->FinishRun(key_);
+}
+
+std::optional<std::string> ResultCache::KeyOf(const planpb::PlanFragment& pf) const {
+  auto bucket = [this](const auto& time) {
+    return absl::StrCat(time.value() / bucket_width_.count());
+  };
+  planpb::PlanFragment key_pb = pf;
+  std::string buckets;
+  for (auto& node : *key_pb.mutable_nodes()) {
+    switch (node.op().op_type()) {
+      case planpb::GRPC_SOURCE_OPERATOR:
+      case planpb::UDTF_SOURCE_OPERATOR:
+        return std::nullopt;
+      case planpb::MEMORY_SOURCE_OPERATOR: {
+        auto* mem_source = node.mutable_op()->mutable_mem_source_op();
+        if (mem_source->streaming()) {
+          return std::nullopt;
+        }
+        absl::StrAppend(&buckets, "/", node.id(), ":",
+                        mem_source->has_start_time() ? bucket(mem_source->start_time()) : "-", ":",
+                        mem_source->has_stop_time() ? bucket(mem_source->stop_time()) : "-");
+        mem_source->clear_start_time();
+        mem_source->clear_stop_time();
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return absl::StrCat(key_pb.SerializeAsString(), buckets);
+}
+
+std::vector<ResultCache::SourceVersion> ResultCache::SourceVersionsOf(
+    const planpb::PlanFragment& pf, table_store::TableStore* table_store) {
+  std::vector<SourceVersion> versions;
+  for (const auto& node : pf.nodes()) {
+    if (node.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+      continue;
+    }
+    const auto& mem_source = node.op().mem_source_op();
+    SourceVersion version;
+    version.stop_time = mem_source.has_stop_time() ? mem_source.stop_time().value()
+                                                   : std::numeric_limits<int64_t>::max();
+    table_store::Table* table = table_store->GetTable(mem_source.name(), mem_source.tablet());
+    if (table != nullptr) {
+      auto stats = table->GetTableStats();
+      version.batches_added = stats.batches_added;
+      version.max_time = stats.max_time;
+    }
+    versions.push_back(version);
+  }
+  return versions;
+}
+
+bool ResultCache::IsValid(const Entry& entry, const std::vector<SourceVersion>& versions) const {
+  if (std::chrono::steady_clock::now() - entry.inserted_at >= bucket_width_ ||
+      entry.versions.size() != versions.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < versions.size(); ++i) {
+    const SourceVersion& cached = entry.versions[i];
+    // Data added after the end of the window doesn't change the results. Tables are written in
+    // time order, so that's all the data added once the table reached the end of the window.
+    if (versions[i].batches_added != cached.batches_added && cached.max_time < cached.stop_time) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ResultCache::Lookup ResultCache::Acquire(const std::string& key,
+                                         std::vector<SourceVersion> versions) {
+  absl::MutexLock lock(&mu_);
+  auto not_running = [this, &key]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !running_.contains(key);
+  };
+  mu_.AwaitWithTimeout(absl::Condition(&not_running), absl::FromChrono(max_wait_));
+
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    if (IsValid(*it->second.entry, versions)) {
+      ++hits_;
+      lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+      Lookup lookup(this, key, std::move(versions), it->second.entry);
+      lookup.done_ = true;
+      return lookup;
+    }
+    bytes_ -= it->second.entry->bytes;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+
+  // If the other run of the key is still going, this one executes the fragment as well, but
+  // leaves storing the results to the other run.
+  Lookup lookup(this, key, std::move(versions), nullptr);
+  lookup.done_ = !running_.insert(key).second;
+  return lookup;
+}
+
+void ResultCache::Insert(const std::string& key, std::shared_ptr<Entry> entry) {
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    bytes_ -= it->second.entry->bytes;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+  bytes_ += entry->bytes;
+  lru_.push_front(key);
+  entries_[key] = Slot{std::move(entry), lru_.begin()};
+  while (bytes_ > max_bytes_ && !lru_.empty()) {
+    auto oldest = entries_.find(lru_.back());
+    bytes_ -= oldest->second.entry->bytes;
+    entries_.erase(oldest);
+    lru_.pop_back();
+  }
+}
+
+void ResultCache::FinishRun(const std::string& key) {
+  absl::MutexLock lock(&mu_);
+  running_.erase(key);
+}
+
+int64_t ResultCache::bytes() const {
+  absl::MutexLock lock(&mu_);
+  return bytes_;
+}
+
+int64_t ResultCache::hits() const {
+  absl::MutexLock lock(&mu_);
+  return hits_;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/table_store/schemapb/schema.pb.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ResultCache keeps the row batches that reached the sinks of plan fragments, so that the same
+ * fragment run again over the same time window (ie. many people opening the same live view)
+ * replays them instead of scanning and aggregating the tables again.
+ *
+ * Fragments are keyed by their proto, with the time bounds of the memory sources rounded down to
+ * buckets of the given width: runs whose windows fall in the same buckets share their results,
+ * which may therefore be up to one bucket old. Entries also expire after one bucket. Only
+ * fragments whose results depend on nothing but the local tables are cached, see KeyOf().
+ *
+ * An entry is invalidated when one of its tables received data that could be in the window,
+ * i.e. when data was added to a table whose newest row was older than the end of the window.
+ *
+ * Concurrent runs of the same fragment are coalesced: the first one executes the fragment, and
+ * the others wait for its results.
+ */
+class ResultCache : public NotCopyable {
+ public:
+  // The state of a table read by a fragment, when the fragment started.
+  struct SourceVersion {
+    int64_t batches_added = 0;
+    int64_t max_time = -1;
+    // The stop time of the memory source that reads the table, or max if it has none.
+    int64_t stop_time = 0;
+
+    bool operator==(const SourceVersion& other) const {
+      return batches_added == other.batches_added && max_time == other.max_time &&
+             stop_time == other.stop_time;
+    }
+  };
+
+  // The row batches that each sink of the fragment consumed, by node id.
+  using SinkResults =
+      absl::flat_hash_map<int64_t, std::vector<table_store::schemapb::RowBatchData>>;
+
+  struct Entry {
+    SinkResults results;
+    std::vector<SourceVersion> versions;
+    int64_t bytes = 0;
+    std::chrono::steady_clock::time_point inserted_at;
+  };
+
+  /**
+   * The outcome of Acquire. Either holds a valid entry, or makes its owner the run that computes
+   * the results of the key: the other runs of the key wait until it calls Complete() or is
+   * destroyed.
+   */
+  class Lookup : public NotCopyable {
+   public:
+    Lookup(Lookup&& other) noexcept;
+    ~Lookup();
+
+    // The cached results, or nullptr if the owner has to execute the fragment.
+    const Entry* entry() const { return entry_.get(); }
+
+    /**
+     * Stores the results of the fragment. Only valid if there was no cached entry.
+     */
+    void Complete(SinkResults results, int64_t bytes);
+
+   private:
+    friend class ResultCache;
+    Lookup(ResultCache* cache, std::string key, std::vector<SourceVersion> versions,
+           std::shared_ptr<const Entry> entry)
+        : cache_(cache),
+          key_(std::move(key)),
+          versions_(std::move(versions)),
+          entry_(std::move(entry)) {}
+
+    ResultCache* cache_;
+    std::string key_;
+    std::vector<SourceVersion> versions_;
+    std::shared_ptr<const Entry> entry_;
+    bool done_ = false;
+  };
+
+  /**
+   * @param bucket_width the width of the time buckets, which is also the lifetime of an entry.
+   * @param max_bytes the bytes of row batches the cache keeps, the least recently used entries
+   * are dropped first.
+   * @param max_wait how long a run waits for a concurrent run of the same fragment.
+   */
+  ResultCache(std::chrono::nanoseconds bucket_width, int64_t max_bytes,
+              std::chrono::milliseconds max_wait)
+      : bucket_width_(bucket_width), max_bytes_(max_bytes), max_wait_(max_wait) {}
+
+  /**
+   * Returns the key of the fragment, or nullopt if its results can't be cached: it reads from
+   * GRPC sources or UDTFs, or streams its memory sources.
+   */
+  std::optional<std::string> KeyOf(const planpb::PlanFragment& pf) const;
+
+  /**
+   * Returns the versions of the tables that the memory sources of the fragment read, in order.
+   */
+  static std::vector<SourceVersion> SourceVersionsOf(const planpb::PlanFragment& pf,
+                                                   table_store::TableStore* table_store);
+
+  /**
+   * Looks up the key. If another run of the key is executing, waits for it (up to max_wait).
+   */
+  Lookup Acquire(const std::string& key, std::vector<SourceVersion> versions);
+
+  // Entries bigger than this aren't cached, so recording can stop early.
+  int64_t max_entry_bytes() const { return max_bytes_ / 4; }
+
+  int64_t bytes() const;
+  int64_t hits() const;
+
+ private:
+  bool IsValid(const Entry& entry, const std::vector<SourceVersion>& versions) const;
+  void Insert(const std::string& key, std::shared_ptr<Entry> entry);
+  void FinishRun(const std::string& key);
+
+  const std::chrono::nanoseconds bucket_width_;
+  const int64_t max_bytes_;
+  const std::chrono::milliseconds max_wait_;
+
+  mutable absl::Mutex mu_;
+  // The keys, the most recently used first.
+  std::list<std::string> lru_ ABSL_GUARDED_BY(mu_);
+  struct Slot {
+    std::shared_ptr<const Entry> entry;
+    std::list<std::string>::iterator lru_it;
+  };
+  absl::flat_hash_map<std::string, Slot> entries_ ABSL_GUARDED_BY(mu_);
+  // The keys that a run is computing the results of.
+  absl::flat_hash_set<std::string> running_ ABSL_GUARDED_BY(mu_);
+  int64_t bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t hits_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
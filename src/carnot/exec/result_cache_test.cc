@@ -0,0 +1,204 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/result_cache.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::Table;
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+// A fragment that only reads a table, $0 and $1 are the time bounds.
+constexpr char kMemSourceFragmentTmpl[] = R"(
+id: 1
+dag { nodes { id: 1 } }
+nodes {
+  id: 1
+  op {
+    op_type: MEMORY_SOURCE_OPERATOR
+    mem_source_op {
+      name: "numbers"
+      column_idxs: 0
+      column_idxs: 1
+      column_names: "time_"
+      column_names: "a"
+      column_types: TIME64NS
+      column_types: INT64
+      start_time { value: $0 }
+      stop_time { value: $1 }
+    }
+  }
+})";
+
+planpb::PlanFragment MemSourceFragment(int64_t start_time, int64_t stop_time) {
+  planpb::PlanFragment pb;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      absl::Substitute(kMemSourceFragmentTmpl, start_time, stop_time), &pb));
+  return pb;
+}
+
+ResultCache::SinkResults Results(int64_t num_rows) {
+  ResultCache::SinkResults results;
+  results[2].emplace_back().set_num_rows(num_rows);
+  return results;
+}
+
+class ResultCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    table_store::schema::Relation rel({types::DataType::TIME64NS, types::DataType::INT64},
+                                      {"time_", "a"});
+    table_ = Table::Create(rel);
+    table_store_.AddTable("numbers", table_);
+  }
+
+  void Write(std::vector<types::Time64NSValue> times) {
+    RowBatch rb(RowDescriptor(table_->GetRelation().col_types()), times.size());
+    std::vector<types::Int64Value> values(times.size(), 1);
+    ASSERT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(values, arrow::default_memory_pool())));
+    ASSERT_OK(table_->WriteRowBatch(rb));
+  }
+
+  std::vector<ResultCache::SourceVersion> Versions(const planpb::PlanFragment& pf) {
+    return ResultCache::SourceVersionsOf(pf, &table_store_);
+  }
+
+  table_store::TableStore table_store_;
+  std::shared_ptr<Table> table_;
+};
+
+TEST_F(ResultCacheTest, key_rounds_time_bounds_to_buckets) {
+  ResultCache cache(std::chrono::nanoseconds(100), 1024, std::chrono::milliseconds(0));
+  auto key = cache.KeyOf(MemSourceFragment(110, 250));
+  ASSERT_TRUE(key.has_value());
+  EXPECT_EQ(key, cache.KeyOf(MemSourceFragment(150, 299)));
+  EXPECT_NE(key, cache.KeyOf(MemSourceFragment(150, 300)));
+  EXPECT_NE(key, cache.KeyOf(MemSourceFragment(90, 250)));
+
+  auto streaming = MemSourceFragment(110, 250);
+  streaming.mutable_nodes(0)->mutable_op()->mutable_mem_source_op()->set_streaming(true);
+  EXPECT_FALSE(cache.KeyOf(streaming).has_value());
+}
+
+TEST_F(ResultCacheTest, replays_results_until_data_lands_in_window) {
+  ResultCache cache(std::chrono::hours(1), 1024, std::chrono::milliseconds(0));
+  Write({1, 2, 3});
+  auto pf = MemSourceFragment(0, 10);
+  std::string key = cache.KeyOf(pf).value();
+  {
+    auto lookup = cache.Acquire(key, Versions(pf));
+    ASSERT_EQ(nullptr, lookup.entry());
+    lookup.Complete(Results(3), 8);
+  }
+  EXPECT_EQ(8, cache.bytes());
+  {
+    auto lookup = cache.Acquire(key, Versions(pf));
+    ASSERT_NE(nullptr, lookup.entry());
+    EXPECT_EQ(3, lookup.entry()->results.at(2)[0].num_rows());
+  }
+  EXPECT_EQ(1, cache.hits());
+
+  // The table hadn't reached the end of the window, so the new rows may belong to it.
+  Write({4});
+  {
+    auto lookup = cache.Acquire(key, Versions(pf));
+    ASSERT_EQ(nullptr, lookup.entry());
+    lookup.Complete(Results(4), 8);
+  }
+  EXPECT_EQ(1, cache.hits());
+}
+
+TEST_F(ResultCacheTest, data_after_window_keeps_entry) {
+  ResultCache cache(std::chrono::hours(1), 1024, std::chrono::milliseconds(0));
+  Write({1, 2, 11});
+  auto pf = MemSourceFragment(0, 10);
+  std::string key = cache.KeyOf(pf).value();
+  cache.Acquire(key, Versions(pf)).Complete(Results(2), 8);
+
+  Write({12, 13});
+  auto lookup = cache.Acquire(key, Versions(pf));
+  ASSERT_NE(nullptr, lookup.entry());
+  EXPECT_EQ(2, lookup.entry()->results.at(2)[0].num_rows());
+}
+
+TEST_F(ResultCacheTest, drops_least_recently_used) {
+  ResultCache cache(std::chrono::hours(1), 100, std::chrono::milliseconds(0));
+  std::vector<planpb::PlanFragment> fragments;
+  for (int64_t i = 1; i <= 5; ++i) {
+    fragments.push_back(MemSourceFragment(0, i * 1000000000));
+  }
+  auto acquire = [&](int i) {
+    return cache.Acquire(cache.KeyOf(fragments[i]).value(), Versions(fragments[i]));
+  };
+  for (int i = 0; i < 3; ++i) {
+    acquire(i).Complete(Results(i), 25);
+  }
+  // Bigger than a quarter of the cache.
+  acquire(3).Complete(Results(3), 26);
+  EXPECT_EQ(75, cache.bytes());
+
+  // Use the first entry, so that the second one is dropped to make room.
+  EXPECT_NE(nullptr, acquire(0).entry());
+  acquire(3).Complete(Results(3), 25);
+  acquire(4).Complete(Results(4), 25);
+  EXPECT_EQ(100, cache.bytes());
+  EXPECT_NE(nullptr, acquire(0).entry());
+  EXPECT_EQ(nullptr, acquire(1).entry());
+}
+
+TEST_F(ResultCacheTest, concurrent_run_waits_for_leader) {
+  ResultCache cache(std::chrono::hours(1), 1024, std::chrono::seconds(10));
+  auto pf = MemSourceFragment(0, 10);
+  std::string key = cache.KeyOf(pf).value();
+  auto leader = cache.Acquire(key, Versions(pf));
+  ASSERT_EQ(nullptr, leader.entry());
+
+  std::thread follower([&]() {
+    auto lookup = cache.Acquire(key, Versions(pf));
+    ASSERT_NE(nullptr, lookup.entry());
+    EXPECT_EQ(5, lookup.entry()->results.at(2)[0].num_rows());
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  leader.Complete(Results(5), 8);
+  follower.join();
+  EXPECT_EQ(1, cache.hits());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
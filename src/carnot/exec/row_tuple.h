@@ -27,12 +27,13 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
-#include <variant>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/container/inlined_vector.h>
 #include <absl/strings/substitute.h>
 
 #include "src/common/base/base.h"
@@ -47,8 +48,6 @@ namespace px {
 namespace carnot {
 namespace exec {
 
-using VariableSizeValueTypeVariant = std::variant<types::StringValue>;
-
 struct RowTuple;
 
 namespace internal {
@@ -60,27 +59,33 @@ inline void SetValueHelper<types::StringValue>(RowTuple* rt, size_t idx,
 
 template <typename T>
 inline const T& GetValueHelper(const RowTuple& rt, size_t idx);
-template <>
-inline const types::StringValue& GetValueHelper<types::StringValue>(const RowTuple& rt, size_t idx);
+inline types::StringValue GetStringValueHelper(const RowTuple& rt, size_t idx);
 
 }  // namespace internal
 
 /**
  * RowTuple stores a tuple of values corresponding to ValueTypes.
+ *
+ * The values are packed into one contiguous buffer, which is stored inline for small tuples, so
+ * hashing a tuple is a single hash of its bytes and comparing two tuples is a single memcmp.
  */
 struct RowTuple : public NotCopyable {
+  // The number of values that fit in the tuple without a heap allocation, including the units
+  // that hold the bytes of the strings.
+  static constexpr size_t kInlineValues = 4;
+
   explicit RowTuple(const std::vector<types::DataType>* types) : types(types) {
     Reset();
     // We set the values to zero since not all fixed size values are the same size.
     // Without this when we write values we might leave gaps that introduce mismatches during
     // comparisons, etc.
-    memset(reinterpret_cast<uint8_t*>(fixed_values.data()), 0,
-           sizeof(types::FixedSizeValueUnion) * fixed_values.size());
+    memset(reinterpret_cast<uint8_t*>(values.data()), 0,
+           sizeof(types::FixedSizeValueUnion) * values.size());
   }
 
   void Reset() {
-    fixed_values.resize(types->size());
-    variable_values.clear();
+    values.resize(types->size());
+    variable_bytes = 0;
   }
 
   /**
@@ -99,11 +104,15 @@ struct RowTuple : public NotCopyable {
    * Will die in debug mode if wrong type is specified.
    * @tparam T The type to read as.
    * @param idx The index to read.
-   * @return The return value (as reference).
+   * @return The return value (as reference for fixed size values, as a copy for strings).
    */
   template <typename T>
-  const T& GetValue(size_t idx) const {
-    return internal::GetValueHelper<T>(*this, idx);
+  decltype(auto) GetValue(size_t idx) const {
+    if constexpr (std::is_same_v<T, types::StringValue>) {
+      return internal::GetStringValueHelper(*this, idx);
+    } else {
+      return internal::GetValueHelper<T>(*this, idx);
+    }
   }
 
   bool operator==(const RowTuple& other) const {
@@ -112,24 +121,13 @@ struct RowTuple : public NotCopyable {
     // This should actually be part of the check, but we assume that row-tuples
     // are consistently using the same types when they are being compared.
     DCHECK(*types == *(other.types));
-    DCHECK(fixed_values.size() == other.fixed_values.size());
-    DCHECK(types->size() == fixed_values.size());
+    DCHECK(types->size() <= values.size());
     DCHECK(CheckSequentialWriteOrder()) << "Variable sized write ordering mismatch";
     DCHECK(other.CheckSequentialWriteOrder()) << "Variable sized write ordering mismatch";
 
-    if (memcmp(fixed_values.data(), other.fixed_values.data(),
-               sizeof(types::FixedSizeValueUnion) * fixed_values.size()) != 0) {
-      // Early exit for failed comparisons.
-      return false;
-    }
-    // Do  deep compare of the variable sized values;
-    for (size_t idx = 0; idx < variable_values.size(); ++idx) {
-      // This will invoke the correct operator on the variant.
-      if (variable_values[idx] != other.variable_values[idx]) {
-        return false;
-      }
-    }
-    return true;
+    // Strings are written in order, so equal tuples have the same bytes.
+    return variable_bytes == other.variable_bytes &&
+           memcmp(values.data(), other.values.data(), NumBytes()) == 0;
   }
 
   /**
@@ -139,17 +137,10 @@ struct RowTuple : public NotCopyable {
    */
   size_t Hash() const {
     DCHECK(CheckSequentialWriteOrder()) << "Variable sized write ordering mismatch";
-    // For fixed sized data we just hash the stored array.
-    size_t hash = ::util::Hash64(reinterpret_cast<const char*>(fixed_values.data()),
-                                 sizeof(types::FixedSizeValueUnion) * fixed_values.size());
-    // For variable sized data we run the appropriate hash function.
-    for (const auto& val : variable_values) {
-      // This should be edited when we add support for new variable sized types.
-      DCHECK(std::holds_alternative<types::StringValue>(val));
-      hash = ::px::HashCombine(
-          hash, types::utils::hash<types::StringValue>()(std::get<types::StringValue>(val)));
+    if (variable_bytes == 0) {
+      return types::utils::HashFixedSizeValues(values.data(), types->size());
     }
-    return hash;
+    return ::util::Hash64(reinterpret_cast<const char*>(values.data()), NumBytes());
   }
 
   /**
@@ -159,47 +150,73 @@ struct RowTuple : public NotCopyable {
    */
   bool CheckSequentialWriteOrder() const {
     DCHECK(types != nullptr);
-    DCHECK(types->size() >= fixed_values.size());
-    int64_t expected_seq_id = 0;
-    for (size_t idx = 0; idx < fixed_values.size(); ++idx) {
+    DCHECK(values.size() >= types->size());
+    int64_t expected_offset = 0;
+    for (size_t idx = 0; idx < types->size(); ++idx) {
       // TODO(zasgar): Replace with IsVariableSizedType().
       if (types->at(idx) == types::STRING) {
-        auto actual_seq_id = types::Get<types::Int64Value>(fixed_values[idx]).val;
-        if (actual_seq_id != expected_seq_id) {
-          LOG(ERROR) << absl::Substitute("Expected seq_id: $0, got $1", expected_seq_id,
-                                         actual_seq_id);
+        auto actual_offset = types::Get<types::Int64Value>(values[idx]).val;
+        if (actual_offset != expected_offset) {
+          LOG(ERROR) << absl::Substitute("Expected offset: $0, got $1", expected_offset,
+                                         actual_offset);
+          return false;
+        }
+        uint32_t len;
+        if (actual_offset + sizeof(len) > variable_bytes) {
+          LOG(ERROR) << absl::Substitute("String at index $0 was not set", idx);
           return false;
         }
-        ++expected_seq_id;
+        memcpy(&len, VariableData() + actual_offset, sizeof(len));
+        expected_offset += sizeof(len) + len;
       }
     }
     return true;
   }
 
+  // The bytes of the tuple that hold values, as opposed to unused space at the end of the buffer.
+  size_t NumBytes() const {
+    return sizeof(types::FixedSizeValueUnion) * types->size() + variable_bytes;
+  }
+
+  // The strings are stored after the fixed size values.
+  const char* VariableData() const {
+    return reinterpret_cast<const char*>(values.data() + types->size());
+  }
+  char* VariableData() { return reinterpret_cast<char*>(values.data() + types->size()); }
+
   // We store a pointer to the types, since they are likely to be shared across different RowTuples.
   // This pointer needs to be valid for the lifetime of this object.
   const std::vector<types::DataType>* types;
 
-  // We store data in two chunks. The first being fixed size values which store values of fixed size
-  // values in line, and for variable size data stores the index into the variables_values array.
-  // This index is stored as a Int64Value.
-  std::vector<types::FixedSizeValueUnion> fixed_values;
-  std::vector<VariableSizeValueTypeVariant> variable_values;
+  // The first types->size() values are the fixed size values of the tuple, in line. For strings,
+  // they hold the offset of the string in the variable data that follows, as an Int64Value. Each
+  // string is stored there as its 32-bit length followed by its bytes.
+  absl::InlinedVector<types::FixedSizeValueUnion, kInlineValues> values;
+  // The number of bytes of variable data.
+  size_t variable_bytes = 0;
 };
 
 namespace internal {
 template <typename T>
 inline void SetValueHelper(RowTuple* rt, size_t idx, const T& val) {
   static_assert(types::ValueTypeTraits<T>::is_fixed_size, "Only fixed size values allowed");
-  types::SetValue<T>(&rt->fixed_values[idx], val);
+  types::SetValue<T>(&rt->values[idx], val);
 }
 
 template <>
 inline void SetValueHelper<types::StringValue>(RowTuple* rt, size_t idx,
                                                const types::StringValue& val) {
-  DCHECK_LT(idx, rt->fixed_values.size());
-  rt->SetValue(idx, types::Int64Value(rt->variable_values.size()));
-  rt->variable_values.emplace_back(val);
+  DCHECK_LT(idx, rt->types->size());
+  uint32_t len = static_cast<uint32_t>(val.size());
+  size_t offset = rt->variable_bytes;
+  rt->variable_bytes += sizeof(len) + len;
+  size_t num_units = (rt->variable_bytes + sizeof(types::FixedSizeValueUnion) - 1) /
+                     sizeof(types::FixedSizeValueUnion);
+  rt->values.resize(rt->types->size() + num_units);
+  char* dst = rt->VariableData() + offset;
+  memcpy(dst, &len, sizeof(len));
+  memcpy(dst + sizeof(len), val.data(), len);
+  rt->SetValue(idx, types::Int64Value(offset));
 }
 
 template <typename T>
@@ -207,17 +224,18 @@ inline const T& GetValueHelper(const RowTuple& rt, size_t idx) {
   static_assert(types::ValueTypeTraits<T>::is_fixed_size, "Only fixed size values allowed");
   DCHECK_LT(idx, rt.types->size());
   DCHECK_EQ(types::ValueTypeTraits<T>::data_type, rt.types->at(idx));
-  return types::Get<T>(rt.fixed_values[idx]);
+  return types::Get<T>(rt.values[idx]);
 }
 
-template <>
-inline const types::StringValue& GetValueHelper<types::StringValue>(const RowTuple& rt,
-                                                                    size_t idx) {
+inline types::StringValue GetStringValueHelper(const RowTuple& rt, size_t idx) {
   DCHECK_LT(idx, rt.types->size());
   DCHECK_EQ(types::ValueTypeTraits<types::StringValue>::data_type, rt.types->at(idx));
-  size_t v_offset = types::Get<types::Int64Value>(rt.fixed_values[idx]).val;
-  DCHECK_LT(v_offset, rt.variable_values.size());
-  return std::get<types::StringValue>(rt.variable_values[v_offset]);
+  size_t offset = types::Get<types::Int64Value>(rt.values[idx]).val;
+  DCHECK_LT(offset, rt.variable_bytes);
+  const char* src = rt.VariableData() + offset;
+  uint32_t len;
+  memcpy(&len, src, sizeof(len));
+  return types::StringValue(src + sizeof(len), len);
 }
 }  // namespace internal
 
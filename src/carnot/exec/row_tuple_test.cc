@@ -97,6 +97,29 @@ TEST_F(RowTupleTest, check_equality_func_with_same_types_different_after_reset)
   EXPECT_NE(rt1_.Hash(), rt2_.Hash());
 }
 
+TEST_F(RowTupleTest, check_equality_func_with_strings_split_differently) {
+  rt3_.SetValue(0, types::Int64Value(1));
+  rt3_.SetValue(1, types::StringValue("a long string that does not fit inline"));
+  rt3_.SetValue(2, types::Int64Value(1));
+  rt3_.SetValue(3, types::StringValue("b"));
+
+  rt4_.SetValue(0, types::Int64Value(1));
+  rt4_.SetValue(1, types::StringValue("a long string that does not fit inlin"));
+  rt4_.SetValue(2, types::Int64Value(1));
+  rt4_.SetValue(3, types::StringValue("eb"));
+  EXPECT_FALSE(rt3_ == rt4_);
+
+  rt4_.Reset();
+  rt4_.SetValue(0, types::Int64Value(1));
+  rt4_.SetValue(1, types::StringValue("a long string that does not fit inline"));
+  rt4_.SetValue(2, types::Int64Value(1));
+  rt4_.SetValue(3, types::StringValue("b"));
+  EXPECT_TRUE(rt3_ == rt4_);
+  EXPECT_EQ(rt3_.Hash(), rt4_.Hash());
+  EXPECT_EQ("a long string that does not fit inline", rt4_.GetValue<types::StringValue>(1));
+  EXPECT_EQ("b", rt4_.GetValue<types::StringValue>(3));
+}
+
 using RowTupleDeathTest = RowTupleTest;
 
 TEST_F(RowTupleDeathTest, read_wrong_type) {
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/scalar_kernels.h"
+
+#include <type_traits>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/funcs/builtins/math_ops.h"
+#include "src/carnot/funcs/metadata/metadata_ops.h"
+#include "src/carnot/udf/udf_wrapper.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+
+using types::BoolValue;
+using types::Float64Value;
+using types::Int64Value;
+using types::Time64NSValue;
+using types::UInt128Value;
+
+using ExecBatchFn = Status (*)(udf::ScalarUDF*, udf::FunctionContext*,
+                               const std::vector<const types::ColumnWrapper*>&,
+                               types::ColumnWrapper*, int);
+using KernelMap = absl::flat_hash_map<ExecBatchFn, ScalarKernel>;
+
+// The type of the values of a ValueType in the arrays of the kernels.
+template <typename TValue>
+using KernelValue =
+    std::conditional_t<std::is_same_v<typename types::ValueTypeTraits<TValue>::native_type, bool>,
+                       uint8_t, typename types::ValueTypeTraits<TValue>::native_type>;
+
+// The ops compute the same as the Exec of their UDFs in math_ops.h, on the native values.
+struct AddOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a + b;
+  }
+};
+struct SubtractOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a - b;
+  }
+};
+struct MultiplyOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a * b;
+  }
+};
+struct DivideOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return static_cast<TOut>(a) / static_cast<TOut>(b);
+  }
+};
+struct ModuloOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a % b;
+  }
+};
+struct LogicalAndOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a && b;
+  }
+};
+struct LogicalOrOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a || b;
+  }
+};
+struct EqualOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a == b;
+  }
+};
+struct NotEqualOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a != b;
+  }
+};
+struct GreaterThanOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a > b;
+  }
+};
+struct GreaterThanEqualOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a >= b;
+  }
+};
+struct LessThanOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a < b;
+  }
+};
+struct LessThanEqualOp {
+  template <typename TOut, typename TA, typename TB>
+  static TOut Apply(TA a, TB b) {
+    return a <= b;
+  }
+};
+struct LogicalNotOp {
+  template <typename TOut, typename TA>
+  static TOut Apply(TA a) {
+    return !a;
+  }
+};
+struct NegateOp {
+  template <typename TOut, typename TA>
+  static TOut Apply(TA a) {
+    return -a;
+  }
+};
+
+// The loops index the scalar args with a constant, which leaves the compiler free to vectorize
+// them.
+template <typename TOp, typename TOut, typename TA, typename TB, bool kScalarA, bool kScalarB>
+void BinaryKernel(const void* a, const void* b, void* out, int64_t count) {
+  const auto* a_values = static_cast<const TA*>(a);
+  const auto* b_values = static_cast<const TB*>(b);
+  auto* out_values = static_cast<TOut*>(out);
+  for (int64_t i = 0; i < count; ++i) {
+    out_values[i] = TOp::template Apply<TOut, TA, TB>(a_values[kScalarA ? 0 : i],
+                                                      b_values[kScalarB ? 0 : i]);
+  }
+}
+
+template <typename TOp, typename TOut, typename TA>
+void UnaryKernel(const void* a, const void*, void* out, int64_t count) {
+  const auto* a_values = static_cast<const TA*>(a);
+  auto* out_values = static_cast<TOut*>(out);
+  for (int64_t i = 0; i < count; ++i) {
+    out_values[i] = TOp::template Apply<TOut, TA>(a_values[i]);
+  }
+}
+
+// The halves of the UINT128 values are compared separately and and'ed without a branch, so that
+// the loop vectorizes like the one of BinaryKernel.
+template <bool kScalarA, bool kScalarB>
+void UInt128EqualKernel(const void* a, const void* b, void* out, int64_t count) {
+  const auto* a_high = static_cast<const uint64_t*>(a);
+  const auto* a_low = a_high + (kScalarA ? 1 : count);
+  const auto* b_high = static_cast<const uint64_t*>(b);
+  const auto* b_low = b_high + (kScalarB ? 1 : count);
+  auto* out_values = static_cast<uint8_t*>(out);
+  for (int64_t i = 0; i < count; ++i) {
+    const int64_t a_idx = kScalarA ? 0 : i;
+    const int64_t b_idx = kScalarB ? 0 : i;
+    out_values[i] = static_cast<uint8_t>(a_high[a_idx] == b_high[b_idx]) &
+                    static_cast<uint8_t>(a_low[a_idx] == b_low[b_idx]);
+  }
+}
+
+// The ASID is in the upper 32 bits of the high half of a UPID, see UPIDToASIDUDF, so only the high
+// halves are read.
+void UPIDToASIDKernel(const void* a, const void*, void* out, int64_t count) {
+  const auto* high = static_cast<const uint64_t*>(a);
+  auto* out_values = static_cast<int64_t*>(out);
+  for (int64_t i = 0; i < count; ++i) {
+    out_values[i] = static_cast<int64_t>(high[i] >> 32);
+  }
+}
+
+template <typename TUDF>
+ExecBatchFn ExecBatchOf() {
+  return &udf::ScalarUDFWrapper<TUDF>::ExecBatch;
+}
+
+template <typename TUDF, typename TOp, typename TOut, typename TA, typename TB>
+void AddBinaryKernel(KernelMap* kernels) {
+  using Out = KernelValue<TOut>;
+  using A = KernelValue<TA>;
+  using B = KernelValue<TB>;
+  kernels->emplace(ExecBatchOf<TUDF>(), ScalarKernel{2, &BinaryKernel<TOp, Out, A, B, false, false>,
+                                                     &BinaryKernel<TOp, Out, A, B, false, true>,
+                                                     &BinaryKernel<TOp, Out, A, B, true, false>});
+}
+
+// For the UDFs templated on their return and arg types.
+template <template <typename, typename, typename> class TUDF, typename TOp, typename TOut,
+          typename TA, typename TB>
+void AddArithmeticKernel(KernelMap* kernels) {
+  AddBinaryKernel<TUDF<TOut, TA, TB>, TOp, TOut, TA, TB>(kernels);
+}
+
+// For the UDFs templated on their arg types, that return a boolean.
+template <template <typename, typename> class TUDF, typename TOp, typename TA, typename TB>
+void AddBooleanKernel(KernelMap* kernels) {
+  AddBinaryKernel<TUDF<TA, TB>, TOp, BoolValue, TA, TB>(kernels);
+}
+
+template <typename TUDF, typename TOp, typename TOut, typename TA>
+void AddUnaryKernel(KernelMap* kernels) {
+  kernels->emplace(ExecBatchOf<TUDF>(),
+                   ScalarKernel{1, &UnaryKernel<TOp, KernelValue<TOut>, KernelValue<TA>>,
+                                nullptr, nullptr});
+}
+
+KernelMap MakeKernels() {
+  using builtins::AddUDF;
+  using builtins::DivideUDF;
+  using builtins::EqualUDF;
+  using builtins::GreaterThanEqualUDF;
+  using builtins::GreaterThanUDF;
+  using builtins::LessThanEqualUDF;
+  using builtins::LessThanUDF;
+  using builtins::LogicalAndUDF;
+  using builtins::LogicalNotUDF;
+  using builtins::LogicalOrUDF;
+  using builtins::ModuloUDF;
+  using builtins::MultiplyUDF;
+  using builtins::NegateUDF;
+  using builtins::NotEqualUDF;
+  using builtins::SubtractUDF;
+
+  KernelMap kernels;
+  AddArithmeticKernel<AddUDF, AddOp, Int64Value, Int64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<AddUDF, AddOp, Float64Value, Float64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<AddUDF, AddOp, Float64Value, Int64Value, Float64Value>(&kernels);
+  AddArithmeticKernel<AddUDF, AddOp, Float64Value, Float64Value, Float64Value>(&kernels);
+  AddArithmeticKernel<AddUDF, AddOp, Time64NSValue, Time64NSValue, Int64Value>(&kernels);
+  AddArithmeticKernel<AddUDF, AddOp, Time64NSValue, Int64Value, Time64NSValue>(&kernels);
+
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Int64Value, Int64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Float64Value, Float64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Float64Value, Int64Value, Float64Value>(&kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Float64Value, Float64Value, Float64Value>(
+      &kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Int64Value, Time64NSValue, Int64Value>(&kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Int64Value, Time64NSValue, Time64NSValue>(
+      &kernels);
+  AddArithmeticKernel<SubtractUDF, SubtractOp, Int64Value, Int64Value, Time64NSValue>(&kernels);
+
+  AddArithmeticKernel<MultiplyUDF, MultiplyOp, Int64Value, Int64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<MultiplyUDF, MultiplyOp, Float64Value, Float64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<MultiplyUDF, MultiplyOp, Float64Value, Int64Value, Float64Value>(&kernels);
+  AddArithmeticKernel<MultiplyUDF, MultiplyOp, Float64Value, Float64Value, Float64Value>(
+      &kernels);
+
+  AddArithmeticKernel<DivideUDF, DivideOp, Float64Value, Int64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<DivideUDF, DivideOp, Float64Value, Float64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<DivideUDF, DivideOp, Float64Value, Int64Value, Float64Value>(&kernels);
+  AddArithmeticKernel<DivideUDF, DivideOp, Float64Value, Float64Value, Float64Value>(&kernels);
+
+  AddArithmeticKernel<ModuloUDF, ModuloOp, Int64Value, Int64Value, Int64Value>(&kernels);
+  AddArithmeticKernel<ModuloUDF, ModuloOp, Int64Value, Time64NSValue, Int64Value>(&kernels);
+  AddArithmeticKernel<ModuloUDF, ModuloOp, Int64Value, Time64NSValue, Time64NSValue>(&kernels);
+  AddArithmeticKernel<ModuloUDF, ModuloOp, Int64Value, Int64Value, Time64NSValue>(&kernels);
+
+  AddBooleanKernel<LogicalAndUDF, LogicalAndOp, BoolValue, BoolValue>(&kernels);
+  AddBooleanKernel<LogicalAndUDF, LogicalAndOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<LogicalOrUDF, LogicalOrOp, BoolValue, BoolValue>(&kernels);
+  AddBooleanKernel<LogicalOrUDF, LogicalOrOp, Int64Value, Int64Value>(&kernels);
+  AddUnaryKernel<LogicalNotUDF<BoolValue>, LogicalNotOp, BoolValue, BoolValue>(&kernels);
+  AddUnaryKernel<LogicalNotUDF<Int64Value>, LogicalNotOp, BoolValue, Int64Value>(&kernels);
+  AddUnaryKernel<NegateUDF<Int64Value>, NegateOp, Int64Value, Int64Value>(&kernels);
+  AddUnaryKernel<NegateUDF<Float64Value>, NegateOp, Float64Value, Float64Value>(&kernels);
+
+  // The float equality UDFs are approximate, so they don't get a kernel.
+  AddBooleanKernel<EqualUDF, EqualOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<EqualUDF, EqualOp, BoolValue, BoolValue>(&kernels);
+  AddBooleanKernel<EqualUDF, EqualOp, Time64NSValue, Time64NSValue>(&kernels);
+  AddBooleanKernel<NotEqualUDF, NotEqualOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<NotEqualUDF, NotEqualOp, BoolValue, BoolValue>(&kernels);
+  AddBooleanKernel<NotEqualUDF, NotEqualOp, Time64NSValue, Time64NSValue>(&kernels);
+  kernels.emplace(ExecBatchOf<EqualUDF<UInt128Value, UInt128Value>>(),
+                  ScalarKernel{2, &UInt128EqualKernel<false, false>,
+                               &UInt128EqualKernel<false, true>, &UInt128EqualKernel<true, false>});
+
+  AddBooleanKernel<GreaterThanUDF, GreaterThanOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<GreaterThanUDF, GreaterThanOp, Float64Value, Float64Value>(&kernels);
+  AddBooleanKernel<GreaterThanUDF, GreaterThanOp, Time64NSValue, Time64NSValue>(&kernels);
+  AddBooleanKernel<GreaterThanEqualUDF, GreaterThanEqualOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<GreaterThanEqualUDF, GreaterThanEqualOp, Float64Value, Float64Value>(
+      &kernels);
+  AddBooleanKernel<LessThanUDF, LessThanOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<LessThanUDF, LessThanOp, Float64Value, Float64Value>(&kernels);
+  AddBooleanKernel<LessThanEqualUDF, LessThanEqualOp, Int64Value, Int64Value>(&kernels);
+  AddBooleanKernel<LessThanEqualUDF, LessThanEqualOp, Float64Value, Float64Value>(&kernels);
+  AddBooleanKernel<LessThanEqualUDF, LessThanEqualOp, Time64NSValue, Time64NSValue>(&kernels);
+
+  kernels.emplace(ExecBatchOf<funcs::metadata::UPIDToASIDUDF>(),
+                  ScalarKernel{1, &UPIDToASIDKernel, nullptr, nullptr});
+  return kernels;
+}
+
+}  // namespace
+
+void SplitUInt128Values(const arrow::Array& arr, uint64_t* out) {
+  const int64_t count = arr.length();
+  for (int64_t i = 0; i < count; ++i) {
+    UInt128Value value = types::GetValueFromArrowArray<types::DataType::UINT128>(&arr, i);
+    out[i] = value.High64();
+    out[count + i] = value.Low64();
+  }
+}
+
+const ScalarKernel* LookupScalarKernel(const udf::ScalarUDFDefinition& def) {
+  static const KernelMap* kernels = new KernelMap(MakeKernels());
+  const auto* exec_batch = def.exec_wrapper().target<ExecBatchFn>();
+  if (exec_batch == nullptr) {
+    return nullptr;
+  }
+  auto it = kernels->find(*exec_batch);
+  if (it == kernels->end() || it->second.arity != def.Arity()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
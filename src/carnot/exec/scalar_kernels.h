@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arrow/array.h>
+
+#include "src/carnot/udf/udf_definition.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * A vectorized kernel computes count values of a builtin UDF from the values of its args. The
+ * values are the native values of their types, stored in plain arrays, with booleans as one byte
+ * per value. b is ignored by the kernels of unary UDFs.
+ *
+ * UINT128 values are split into their 64-bit halves: count values are stored as their count high
+ * halves followed by their count low halves, and a single value as its high half followed by its
+ * low half. The kernels then compare (or read the ASID from) plain uint64 arrays, which vectorizes,
+ * rather than going through the 128-bit values one at a time.
+ */
+using ScalarKernelFn = void (*)(const void* a, const void* b, void* out, int64_t count);
+
+struct ScalarKernel {
+  size_t arity;
+  // The kernels for an arg that is a vector of values or a single value used for every row. A
+  // call where all the args are single values is made with the vector kernel and a count of 1.
+  ScalarKernelFn vector_vector;
+  ScalarKernelFn vector_scalar;
+  ScalarKernelFn scalar_vector;
+};
+
+/**
+ * Splits the UINT128 values of the arrow array into the layout of the kernels, in out, which must
+ * hold 2 * arr.length() values.
+ */
+void SplitUInt128Values(const arrow::Array& arr, uint64_t* out);
+
+/**
+ * Returns the kernel that computes the same values as the UDF, or nullptr if the UDF (and its
+ * arg types) has none. Kernels exist for the builtin arithmetic, logical and comparison UDFs of
+ * fixed size types, and they are matched by the UDF class rather than its name, so a UDF that
+ * happens to have the name of a builtin is never replaced.
+ */
+const ScalarKernel* LookupScalarKernel(const udf::ScalarUDFDefinition& def);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/spill_file.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "src/common/fs/fs_wrapper.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+StatusOr<std::unique_ptr<RowBatchSpillFile>> RowBatchSpillFile::Create(
+    const std::filesystem::path& dir) {
+  std::filesystem::path spill_dir = dir.empty() ? fs::TempDirectoryPath() : dir;
+  std::string path_template = (spill_dir / "carnot_spill_XXXXXX").string();
+  int fd = mkstemp(path_template.data());
+  if (fd < 0) {
+    return error::System("Failed to create spill file in $0: $1", spill_dir.string(),
+                         std::strerror(errno));
+  }
+  // The file stays accessible through the descriptor until it is closed.
+  unlink(path_template.c_str());
+  std::FILE* f = fdopen(fd, "w+b");
+  if (f == nullptr) {
+    close(fd);
+    return error::System("Failed to open spill file: $0", std::strerror(errno));
+  }
+  return std::unique_ptr<RowBatchSpillFile>(new RowBatchSpillFile(f));
+}
+
+RowBatchSpillFile::~RowBatchSpillFile() { fclose(f_); }
+
+Status RowBatchSpillFile::Write(const RowBatch& rb) {
+  DCHECK(!reading_);
+  table_store::schemapb::RowBatchData rb_data;
+  PL_RETURN_IF_ERROR(rb.ToProto(&rb_data));
+  if (!rb_data.SerializeToString(&buf_)) {
+    return error::Internal("Failed to serialize spilled row batch");
+  }
+  // Each batch is stored as its size followed by the serialized RowBatchData.
+  uint64_t size = buf_.size();
+  if (fwrite(&size, sizeof(size), 1, f_) != 1 || fwrite(buf_.data(), 1, size, f_) != size) {
+    return error::System("Failed to write to spill file: $0", std::strerror(errno));
+  }
+  bytes_written_ += sizeof(size) + size;
+  ++num_batches_;
+  return Status::OK();
+}
+
+Status RowBatchSpillFile::StartReading() {
+  if (fflush(f_) != 0 || fseek(f_, 0, SEEK_SET) != 0) {
+    return error::System("Failed to rewind spill file: $0", std::strerror(errno));
+  }
+  reading_ = true;
+  batches_read_ = 0;
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatchSpillFile::ReadNext() {
+  DCHECK(reading_);
+  if (batches_read_ == num_batches_) {
+    return std::unique_ptr<RowBatch>();
+  }
+  uint64_t size = 0;
+  if (fread(&size, sizeof(size), 1, f_) != 1) {
+    return error::System("Failed to read from spill file: $0", std::strerror(errno));
+  }
+  buf_.resize(size);
+  if (fread(buf_.data(), 1, size, f_) != size) {
+    return error::System("Failed to read from spill file: $0", std::strerror(errno));
+  }
+  table_store::schemapb::RowBatchData rb_data;
+  if (!rb_data.ParseFromString(buf_)) {
+    return error::Internal("Failed to parse spilled row batch");
+  }
+  ++batches_read_;
+  return RowBatch::FromProto(rb_data);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
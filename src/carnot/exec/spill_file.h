@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * RowBatchSpillFile is an append-only scratch file of RowBatches, used by operators that have to
+ * move state out of memory. Batches are written one after the other and read back in the same
+ * order once writing is done. The file is unlinked as soon as it is created so that it is cleaned
+ * up when the RowBatchSpillFile is destroyed, even if the process dies.
+ */
+class RowBatchSpillFile : public NotCopyable {
+ public:
+  /**
+   * Creates a new spill file.
+   * @param dir The directory to create the file in. Uses the system temp directory when empty.
+   */
+  static StatusOr<std::unique_ptr<RowBatchSpillFile>> Create(const std::filesystem::path& dir);
+
+  ~RowBatchSpillFile();
+
+  /**
+   * Appends a RowBatch to the file. Only valid before StartReading() is called.
+   */
+  Status Write(const table_store::schema::RowBatch& rb);
+
+  /**
+   * Rewinds the file so that the batches can be read back with ReadNext().
+   */
+  Status StartReading();
+
+  /**
+   * Reads the next RowBatch.
+   * @return the next batch, or nullptr once all of the written batches have been read.
+   */
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> ReadNext();
+
+  int64_t bytes_written() const { return bytes_written_; }
+  int64_t num_batches() const { return num_batches_; }
+
+ private:
+  explicit RowBatchSpillFile(std::FILE* f) : f_(f) {}
+
+  std::FILE* f_;
+  bool reading_ = false;
+  int64_t bytes_written_ = 0;
+  int64_t num_batches_ = 0;
+  int64_t batches_read_ = 0;
+  // Scratch space for the serialized batches.
+  std::string buf_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/spill_file.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+TEST(RowBatchSpillFileTest, write_and_read) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING});
+  auto rb1 = RowBatchBuilder(rd, 3, false, false)
+                 .AddColumn<types::Int64Value>({1, 2, 3})
+                 .AddColumn<types::StringValue>({"a", "bb", "ccc"})
+                 .get();
+  auto rb2 = RowBatchBuilder(rd, 1, false, false)
+                 .AddColumn<types::Int64Value>({4})
+                 .AddColumn<types::StringValue>({"dddd"})
+                 .get();
+
+  ASSERT_OK_AND_ASSIGN(auto file, RowBatchSpillFile::Create(""));
+  ASSERT_OK(file->Write(rb1));
+  ASSERT_OK(file->Write(rb2));
+  EXPECT_EQ(2, file->num_batches());
+  EXPECT_GT(file->bytes_written(), 0);
+
+  ASSERT_OK(file->StartReading());
+  ASSERT_OK_AND_ASSIGN(auto out1, file->ReadNext());
+  ASSERT_NE(nullptr, out1);
+  ASSERT_EQ(3, out1->num_rows());
+  EXPECT_TRUE(out1->ColumnAt(0)->Equals(rb1.ColumnAt(0)));
+  EXPECT_TRUE(out1->ColumnAt(1)->Equals(rb1.ColumnAt(1)));
+
+  ASSERT_OK_AND_ASSIGN(auto out2, file->ReadNext());
+  ASSERT_NE(nullptr, out2);
+  EXPECT_TRUE(out2->ColumnAt(1)->Equals(rb2.ColumnAt(1)));
+
+  ASSERT_OK_AND_ASSIGN(auto out3, file->ReadNext());
+  EXPECT_EQ(nullptr, out3);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * Assigns dense int64 codes to distinct strings, so that string columns can be processed by their
+ * codes (e.g. as fixed size hash keys) and only decoded when they are output. Codes are assigned
+ * in insertion order starting at 0, and stay valid until Clear is called.
+ */
+class StringDictionary {
+ public:
+  /**
+   * Returns the code of the string, assigning the next code to it if it isn't in the dictionary.
+   */
+  int64_t GetOrInsert(std::string_view value) {
+    auto it = codes_.find(value);
+    if (it != codes_.end()) {
+      return it->second;
+    }
+    int64_t code = values_.size();
+    // The deque never moves its elements, so the map can key on views of them.
+    const std::string& stored = values_.emplace_back(value);
+    codes_.emplace(stored, code);
+    value_bytes_ += stored.size();
+    return code;
+  }
+
+  const std::string& Value(int64_t code) const { return values_[code]; }
+
+  size_t size() const { return values_.size(); }
+
+  // Estimate of the memory held by the dictionary.
+  int64_t bytes() const {
+    size_t bytes_per_value = sizeof(std::string) + sizeof(std::string_view) + sizeof(int64_t);
+    return value_bytes_ + static_cast<int64_t>(size() * bytes_per_value);
+  }
+
+  void Clear() {
+    codes_.clear();
+    values_.clear();
+    value_bytes_ = 0;
+  }
+
+ private:
+  std::deque<std::string> values_;
+  absl::flat_hash_map<std::string_view, int64_t> codes_;
+  int64_t value_bytes_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
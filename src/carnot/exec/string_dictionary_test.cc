@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/carnot/exec/string_dictionary.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(StringDictionaryTest, assigns_dense_codes) {
+  StringDictionary dict;
+  EXPECT_EQ(0, dict.GetOrInsert("abc"));
+  EXPECT_EQ(1, dict.GetOrInsert("def"));
+  EXPECT_EQ(0, dict.GetOrInsert("abc"));
+  EXPECT_EQ(2, dict.GetOrInsert(""));
+  EXPECT_EQ(3UL, dict.size());
+
+  EXPECT_EQ("abc", dict.Value(0));
+  EXPECT_EQ("def", dict.Value(1));
+  EXPECT_EQ("", dict.Value(2));
+}
+
+TEST(StringDictionaryTest, codes_survive_growth) {
+  // Short strings are stored inline in std::string, so this checks the lookups don't reference
+  // storage that moves as the dictionary grows.
+  StringDictionary dict;
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i, dict.GetOrInsert(std::to_string(i)));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i, dict.GetOrInsert(std::to_string(i)));
+    EXPECT_EQ(std::to_string(i), dict.Value(i));
+  }
+}
+
+TEST(StringDictionaryTest, clear) {
+  StringDictionary dict;
+  dict.GetOrInsert("abc");
+  dict.GetOrInsert("def");
+  EXPECT_GT(dict.bytes(), 0);
+  dict.Clear();
+  EXPECT_EQ(0UL, dict.size());
+  EXPECT_EQ(0, dict.bytes());
+  EXPECT_EQ(0, dict.GetOrInsert("def"));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -356,6 +356,17 @@ class ExecNodeTester {
     return *this;
   }
 
+  /**
+   * Removes and returns the oldest rowbatch output by ConsumeNext/GenerateNext, for tests whose
+   * expected output isn't known up front.
+   */
+  std::unique_ptr<table_store::schema::RowBatch> PopRowBatch() {
+    DCHECK(current_row_batches_.size());
+    auto rb = std::move(current_row_batches_.front());
+    current_row_batches_.pop();
+    return rb;
+  }
+
   /**
    * Checks that the row batch matches the last rowbatch output by ConsumeNext/GenerateNext.
    * @param expected_rb Row batch that should match the last rowbatch output by
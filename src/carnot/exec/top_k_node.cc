@@ -0,0 +1,175 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/top_k_node.h"
+
+#include <arrow/array.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+template <types::DataType T>
+int CompareArrowValues(const arrow::Array* lhs, int64_t lhs_idx, const arrow::Array* rhs,
+                       int64_t rhs_idx) {
+  if constexpr (T == types::DataType::STRING) {
+    // Compare views to avoid copying the strings.
+    auto lhs_val = static_cast<const arrow::StringArray*>(lhs)->GetView(lhs_idx);
+    auto rhs_val = static_cast<const arrow::StringArray*>(rhs)->GetView(rhs_idx);
+    return lhs_val.compare(rhs_val);
+  } else {
+    auto lhs_val = types::GetValueFromArrowArray<T>(lhs, lhs_idx);
+    auto rhs_val = types::GetValueFromArrowArray<T>(rhs, rhs_idx);
+    if (lhs_val < rhs_val) {
+      return -1;
+    }
+    if (rhs_val < lhs_val) {
+      return 1;
+    }
+    return 0;
+  }
+}
+
+template <types::DataType T>
+Status AppendEntryValue(arrow::ArrayBuilder* builder, const arrow::Array* arr, int64_t row_idx) {
+  return table_store::schema::CopyValue<T>(builder, types::GetValueFromArrowArray<T>(arr, row_idx));
+}
+
+}  // namespace
+
+std::string TopKNode::DebugStringImpl() {
+  return absl::Substitute("Exec::TopKNode<$0>", plan_node_->DebugString());
+}
+
+Status TopKNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::TOP_K_OPERATOR);
+  const auto* top_k_plan_node = static_cast<const plan::TopKOperator*>(&plan_node);
+  // copy the plan node to local object;
+  plan_node_ = std::make_unique<plan::TopKOperator>(*top_k_plan_node);
+
+  if (input_descriptors_.size() != 1) {
+    return error::InvalidArgument("TopK operator expects a single input relation, got $0",
+                                  input_descriptors_.size());
+  }
+  const auto& input_descriptor = input_descriptors_[0];
+  for (int64_t sort_col_idx : plan_node_->sort_cols()) {
+    if (sort_col_idx >= static_cast<int64_t>(input_descriptor.size())) {
+      return error::InvalidArgument("Sort column index $0 is out of bounds", sort_col_idx);
+    }
+#define TYPE_CASE(_dt_) compare_fns_.push_back(&CompareArrowValues<_dt_>);
+    PL_SWITCH_FOREACH_DATATYPE(input_descriptor.type(sort_col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+  return Status::OK();
+}
+
+Status TopKNode::PrepareImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status TopKNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status TopKNode::CloseImpl(ExecState* /*exec_state*/) {
+  heap_ = decltype(heap_)(EntryCompare{this});
+  return Status::OK();
+}
+
+bool TopKNode::EntryLess(const TopKEntry& lhs, const TopKEntry& rhs) const {
+  const auto& sort_cols = plan_node_->sort_cols();
+  const auto& descending = plan_node_->descending();
+  for (size_t i = 0; i < sort_cols.size(); ++i) {
+    int cmp = compare_fns_[i](lhs.rb->ColumnAt(sort_cols[i]).get(), lhs.row_idx,
+                              rhs.rb->ColumnAt(sort_cols[i]).get(), rhs.row_idx);
+    if (cmp != 0) {
+      return descending[i] ? cmp > 0 : cmp < 0;
+    }
+  }
+  return lhs.seq < rhs.seq;
+}
+
+Status TopKNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  auto limit = static_cast<size_t>(plan_node_->record_limit());
+  if (limit > 0 && rb.num_rows() > 0) {
+    auto rb_ptr = std::make_shared<RowBatch>(rb);
+    for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+      TopKEntry entry{rb_ptr, row_idx, rows_seen_++};
+      if (heap_.size() < limit) {
+        heap_.push(std::move(entry));
+      } else if (EntryLess(entry, heap_.top())) {
+        heap_.pop();
+        heap_.push(std::move(entry));
+      }
+    }
+  }
+
+  if (rb.eos()) {
+    return EmitTopK(exec_state);
+  }
+  return Status::OK();
+}
+
+Status TopKNode::EmitTopK(ExecState* exec_state) {
+  // Drain the heap back to front, it pops the last row of the output first.
+  std::vector<TopKEntry> entries(heap_.size());
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    *it = heap_.top();
+    heap_.pop();
+  }
+
+  const auto& selected_cols = plan_node_->selected_cols();
+  DCHECK_EQ(output_descriptor_->size(), selected_cols.size());
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  builders.reserve(selected_cols.size());
+  for (size_t i = 0; i < selected_cols.size(); ++i) {
+    builders.push_back(
+        types::MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool()));
+    PL_RETURN_IF_ERROR(builders.back()->Reserve(entries.size()));
+  }
+
+  for (const auto& entry : entries) {
+    for (size_t i = 0; i < selected_cols.size(); ++i) {
+      const arrow::Array* arr = entry.rb->ColumnAt(selected_cols[i]).get();
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendEntryValue<_dt_>(builders[i].get(), arr, entry.row_idx));
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(auto output_rb,
+                      RowBatch::FromColumnBuilders(*output_descriptor_, /*eow*/ true,
+                                                   /*eos*/ true, &builders));
+  return SendRowBatchToChildren(exec_state, *output_rb);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
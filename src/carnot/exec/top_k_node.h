@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <stddef.h>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/common/base/status.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * TopKNode emits the first record_limit rows of its input when ordered by the sort columns.
+ *
+ * The node keeps a bounded max-heap of the best rows seen so far, keyed by the sort order, so
+ * each input row costs at most O(log k) and only the batches that still hold a retained row are
+ * kept alive. The result is emitted, sorted, once the input reaches eos.
+ */
+class TopKNode : public ProcessingNode {
+  // Compares the values at the given rows of two arrays of the same type.
+  // Returns a negative number, zero or a positive number like strcmp.
+  using ValueCompareFn = int (*)(const arrow::Array* lhs, int64_t lhs_idx,
+                                 const arrow::Array* rhs, int64_t rhs_idx);
+
+  struct TopKEntry {
+    std::shared_ptr<table_store::schema::RowBatch> rb;
+    int64_t row_idx;
+    // The arrival order of the row, used to break ties deterministically.
+    int64_t seq;
+  };
+
+ public:
+  TopKNode() = default;
+  virtual ~TopKNode() = default;
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  // Returns true if lhs comes before rhs in the output.
+  bool EntryLess(const TopKEntry& lhs, const TopKEntry& rhs) const;
+  Status EmitTopK(ExecState* exec_state);
+
+  std::unique_ptr<plan::TopKOperator> plan_node_;
+  std::vector<ValueCompareFn> compare_fns_;
+  int64_t rows_seen_ = 0;
+
+  struct EntryCompare {
+    const TopKNode* node;
+    bool operator()(const TopKEntry& lhs, const TopKEntry& rhs) const {
+      return node->EntryLess(lhs, rhs);
+    }
+  };
+  // The top of the heap is the retained row that comes last in the output.
+  std::priority_queue<TopKEntry, std::vector<TopKEntry>, EntryCompare> heap_{EntryCompare{this}};
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/top_k_node.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/base.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+class TopKNodeTest : public ::testing::Test {
+ public:
+  TopKNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+
+    auto table_store = std::make_shared<table_store::TableStore>();
+
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  // Creates a TopK operator over [col0, col1] that sorts by the given columns.
+  std::unique_ptr<plan::Operator> MakeTopK(int64_t limit, const std::vector<int64_t>& sort_cols,
+                                           const std::vector<bool>& descending) {
+    auto op_proto = planpb::testutils::CreateTestTopK1PB();
+    auto* top_k_pb = op_proto.mutable_top_k_op();
+    top_k_pb->set_limit(limit);
+    top_k_pb->clear_sort_columns();
+    top_k_pb->clear_descending();
+    for (size_t i = 0; i < sort_cols.size(); ++i) {
+      auto* col = top_k_pb->add_sort_columns();
+      col->set_node(1);
+      col->set_index(sort_cols[i]);
+      top_k_pb->add_descending(descending[i]);
+    }
+    return plan::TopKOperator::FromProto(op_proto, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(TopKNodeTest, single_batch_descending) {
+  auto plan_node = MakeTopK(3, {1}, {true});
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(*plan_node, output_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 6, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                       .AddColumn<types::Int64Value>({5, 9, 1, 12, 3, 7})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({4, 2, 6})
+                          .AddColumn<types::Int64Value>({12, 9, 7})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, multiple_batches_ascending) {
+  auto plan_node = MakeTopK(4, {1}, {false});
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(*plan_node, output_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .AddColumn<types::Int64Value>({8, 6, 10})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({4, 5, 6})
+                       .AddColumn<types::Int64Value>({2, 11, 7})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({7, 8})
+                       .AddColumn<types::Int64Value>({1, 9})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Int64Value>({7, 4, 2, 6})
+                          .AddColumn<types::Int64Value>({1, 2, 6, 7})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, multiple_sort_columns_with_ties) {
+  auto plan_node = MakeTopK(4, {0, 1}, {false, true});
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(*plan_node, output_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 6, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({2, 1, 2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({4, 3, 5, 8, 1, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Int64Value>({1, 1, 1, 2})
+                          .AddColumn<types::Int64Value>({8, 3, 3, 5})
+                          .get())
+      .Close();
+}
+
+TEST_F(TopKNodeTest, fewer_rows_than_limit) {
+  auto plan_node = MakeTopK(10, {1}, {true});
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<TopKNode, plan::TopKOperator>(*plan_node, output_rd,
+                                                                   {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({3, 4})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 0, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Int64Value>({})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({2, 1})
+                          .AddColumn<types::Int64Value>({4, 3})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
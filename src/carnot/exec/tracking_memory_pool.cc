@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/exec/tracking_memory_pool.h"
+
+#include <absl/base/internal/spinlock.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+arrow::Status TrackingMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  auto s = parent_->Allocate(size, out);
+  if (s.ok()) {
+    bytes_allocated_ += size;
+    UpdatePeak();
+  }
+  return s;
+}
+
+arrow::Status TrackingMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  auto s = parent_->Reallocate(old_size, new_size, ptr);
+  if (s.ok()) {
+    bytes_allocated_ += new_size - old_size;
+    UpdatePeak();
+  }
+  return s;
+}
+
+void TrackingMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  parent_->Free(buffer, size);
+  bytes_allocated_ -= size;
+}
+
+void TrackingMemoryPool::SetExternalBytes(int64_t bytes) {
+  external_bytes_ = bytes;
+  UpdatePeak();
+}
+
+void TrackingMemoryPool::UpdatePeak() {
+  int64_t current = current_bytes();
+  int64_t peak = peak_bytes_.load();
+  while (current > peak && !peak_bytes_.compare_exchange_weak(peak, current)) {
+  }
+}
+
+void TrackingMemoryPool::RetainUntilFreed(std::shared_ptr<TrackingMemoryPool> pool) {
+  static absl::base_internal::SpinLock lock;
+  static auto* retained = new std::vector<std::shared_ptr<TrackingMemoryPool>>();
+
+  absl::base_internal::SpinLockHolder holder(&lock);
+  auto freed = [](const auto& p) { return p->bytes_allocated() == 0; };
+  retained->erase(std::remove_if(retained->begin(), retained->end(), freed), retained->end());
+  if (pool->bytes_allocated() > 0) {
+    retained->push_back(std::move(pool));
+  }
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <atomic>
+#include <memory>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * TrackingMemoryPool forwards allocations to a parent pool and keeps track of the current and peak
+ * bytes allocated through it. Each ExecNode allocates from its own TrackingMemoryPool, the parent
+ * of which is the query's pool, so that the memory of a query can be broken down per operator.
+ *
+ * Operators can also account memory that isn't allocated from the pool, ie. their hash maps and
+ * object pools, with SetExternalBytes().
+ */
+class TrackingMemoryPool : public arrow::MemoryPool {
+ public:
+  explicit TrackingMemoryPool(arrow::MemoryPool* parent) : parent_(parent) {}
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  // The bytes allocated through the pool, not including the external bytes.
+  int64_t bytes_allocated() const override { return bytes_allocated_.load(); }
+  // The peak of current_bytes().
+  int64_t max_memory() const override { return peak_bytes_.load(); }
+
+  /**
+   * Sets the memory held by structures of the operator that are not allocated from this pool.
+   * @param bytes The current size of those structures, replacing the previous value.
+   */
+  void SetExternalBytes(int64_t bytes);
+
+  int64_t current_bytes() const { return bytes_allocated_.load() + external_bytes_.load(); }
+  int64_t peak_bytes() const { return peak_bytes_.load(); }
+
+  /**
+   * Keeps a pool alive until every buffer allocated from it has been freed. Buffers only hold a
+   * raw pointer to their pool, so pools whose buffers outlive their owner (ie. batches written to
+   * the table store) are handed over here instead of being destroyed.
+   */
+  static void RetainUntilFreed(std::shared_ptr<TrackingMemoryPool> pool);
+
+ private:
+  void UpdatePeak();
+
+  arrow::MemoryPool* parent_;
+  std::atomic<int64_t> bytes_allocated_{0};
+  std::atomic<int64_t> external_bytes_{0};
+  std::atomic<int64_t> peak_bytes_{0};
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
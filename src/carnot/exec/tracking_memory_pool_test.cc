@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/carnot/exec/tracking_memory_pool.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(TrackingMemoryPoolTest, tracks_current_and_peak_bytes) {
+  arrow::ProxyMemoryPool parent(arrow::default_memory_pool());
+  TrackingMemoryPool pool(&parent);
+
+  uint8_t* buf;
+  ASSERT_TRUE(pool.Allocate(100, &buf).ok());
+  ASSERT_TRUE(pool.Reallocate(100, 300, &buf).ok());
+  EXPECT_EQ(300, pool.bytes_allocated());
+  EXPECT_EQ(300, parent.bytes_allocated());
+
+  pool.SetExternalBytes(50);
+  EXPECT_EQ(350, pool.current_bytes());
+  EXPECT_EQ(350, pool.peak_bytes());
+
+  pool.Free(buf, 300);
+  pool.SetExternalBytes(0);
+  EXPECT_EQ(0, pool.current_bytes());
+  EXPECT_EQ(0, parent.bytes_allocated());
+  EXPECT_EQ(350, pool.peak_bytes());
+}
+
+TEST(TrackingMemoryPoolTest, retain_until_freed) {
+  auto pool = std::make_shared<TrackingMemoryPool>(arrow::default_memory_pool());
+  std::weak_ptr<TrackingMemoryPool> weak_pool = pool;
+  uint8_t* buf;
+  ASSERT_TRUE(pool->Allocate(64, &buf).ok());
+
+  TrackingMemoryPool* raw_pool = pool.get();
+  TrackingMemoryPool::RetainUntilFreed(std::move(pool));
+  EXPECT_FALSE(weak_pool.expired());
+
+  raw_pool->Free(buf, 64);
+  // Freed pools are dropped the next time a pool is handed over.
+  TrackingMemoryPool::RetainUntilFreed(
+      std::make_shared<TrackingMemoryPool>(arrow::default_memory_pool()));
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
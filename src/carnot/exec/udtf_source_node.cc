@@ -101,8 +101,10 @@ Status UDTFSourceNode::CloseImpl(ExecState* /*exec_state*/) { return Status::OK(
 Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> outputs;
 
+  // Each call only pulls the next bounded batch from the UDTF, which is accounted to the query's
+  // memory budget. Streaming UDTFs don't advance their cursor until the batch was consumed.
   for (const auto& r : udtf_def_->output_relation()) {
-    outputs.emplace_back(types::MakeArrowBuilder(r.type(), arrow::default_memory_pool()));
+    outputs.emplace_back(types::MakeArrowBuilder(r.type(), mem_pool()));
   }
 
   // TODO(zasgar): Change Exec to take in unique_ptrs.
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_join.h>
@@ -41,6 +42,20 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+namespace {
+
+template <types::DataType TDataType>
+Status CopyValues(arrow::Array* input_col, size_t start, size_t num_rows,
+                  arrow::ArrayBuilder* output_col_builder) {
+  for (size_t row = start; row < start + num_rows; ++row) {
+    PL_RETURN_IF_ERROR(table_store::schema::CopyValue<TDataType>(
+        output_col_builder, types::GetValueFromArrowArray<TDataType>(input_col, row)));
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 std::string UnionNode::DebugStringImpl() {
   return absl::Substitute("Exec::UnionNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
 }
@@ -76,6 +91,7 @@ Status UnionNode::PrepareImpl(ExecState*) {
     row_cursors_.resize(num_parents_);
     time_columns_.resize(num_parents_);
     data_columns_.resize(num_parents_, std::vector<arrow::Array*>(num_output_cols));
+    merge_tree_.resize(num_parents_);
 
     column_builders_.resize(num_output_cols);
     PL_RETURN_IF_ERROR(InitializeColumnBuilders());
@@ -111,19 +127,131 @@ types::Time64NSValue UnionNode::GetTimeAtParentCursor(size_t parent_index) const
                                                         row_cursors_[parent_index]);
 }
 
-Status UnionNode::AppendRow(size_t parent) {
-  auto row = row_cursors_[parent];
+// Parents that reached end of stream sort last. Ties in time go to the lower parent index, so
+// rows are always stable with respect to input parent index.
+bool UnionNode::MergeLess(size_t parent_a, size_t parent_b) const {
+  if (flushed_parent_eoses_[parent_a]) {
+    return false;
+  }
+  if (flushed_parent_eoses_[parent_b]) {
+    return true;
+  }
+  auto time_a = GetTimeAtParentCursor(parent_a);
+  auto time_b = GetTimeAtParentCursor(parent_b);
+  return time_a < time_b || (time_a == time_b && parent_a < parent_b);
+}
+
+void UnionNode::BuildMergeTree() { merge_tree_[0] = BuildMergeTree(1); }
+
+// Plays the matches below node, and returns the winner.
+size_t UnionNode::BuildMergeTree(size_t node) {
+  if (node >= num_parents_) {
+    return node - num_parents_;
+  }
+  size_t left = BuildMergeTree(2 * node);
+  size_t right = BuildMergeTree(2 * node + 1);
+  bool left_wins = MergeLess(left, right);
+  merge_tree_[node] = left_wins ? right : left;
+  return left_wins ? left : right;
+}
+
+// Replays the matches on the path from the parent's leaf to the root, after its cursor moved.
+void UnionNode::ReplayMergeTree(size_t parent) {
+  size_t winner = parent;
+  for (size_t node = (num_parents_ + parent) / 2; node > 0; node /= 2) {
+    if (MergeLess(merge_tree_[node], winner)) {
+      std::swap(merge_tree_[node], winner);
+    }
+  }
+  merge_tree_[0] = winner;
+}
+
+// Returns the number of rows, starting at the cursor of the winning parent, that come before the
+// next row of every other parent. These can be output as one run.
+size_t UnionNode::MergeRunLength(size_t parent) const {
+  DCHECK_EQ(merge_tree_[0], parent);
+
+  // The runner-up is the best of the parents that lost directly to the winner, all of which are
+  // on the winner's path to the root.
+  bool has_runner_up = false;
+  size_t runner_up = 0;
+  for (size_t node = (num_parents_ + parent) / 2; node > 0; node /= 2) {
+    if (!has_runner_up || MergeLess(merge_tree_[node], runner_up)) {
+      runner_up = merge_tree_[node];
+      has_runner_up = true;
+    }
+  }
+
+  size_t start = row_cursors_[parent];
+  size_t end = parent_row_batches_[parent][0].num_rows();
+  if (!has_runner_up || flushed_parent_eoses_[runner_up]) {
+    return end - start;
+  }
+
+  auto limit = GetTimeAtParentCursor(runner_up);
+  // The row at the cursor already won, so the search starts after it.
+  for (size_t row = start + 1; row < end; ++row) {
+    types::Time64NSValue time =
+        types::GetValueFromArrowArray<types::TIME64NS>(time_columns_[parent], row);
+    if (time > limit || (time == limit && parent > runner_up)) {
+      return row - start;
+    }
+  }
+  return end - start;
+}
+
+Status UnionNode::AppendRun(size_t parent, size_t num_rows) {
+  size_t start = row_cursors_[parent];
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     auto input_col = data_columns_[parent][i];
-#define TYPE_CASE(_dt_)                                    \
-  PL_RETURN_IF_ERROR(table_store::schema::CopyValue<_dt_>( \
-      column_builders_[i].get(), types::GetValueFromArrowArray<_dt_>(input_col, row)));
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(CopyValues<_dt_>(input_col, start, num_rows, column_builders_[i].get()));
     PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
 #undef TYPE_CASE
   }
+  AdvanceParentCursor(parent, num_rows);
   return Status::OK();
 }
 
+// Sends a run that fills a whole output row batch as slices of the input columns, without
+// copying. The column builders must be empty.
+Status UnionNode::SendRunAsSlice(ExecState* exec_state, size_t parent, size_t num_rows) {
+  DCHECK_EQ(column_builders_[0]->length(), 0);
+  DCHECK(!sent_eos_);
+
+  RowBatch output_rb(*output_descriptor_, num_rows);
+  size_t start = row_cursors_[parent];
+  for (size_t i = 0; i < output_descriptor_->size(); ++i) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(data_columns_[parent][i]->Slice(start, num_rows)));
+  }
+  AdvanceParentCursor(parent, num_rows);
+
+  bool eos = InputsComplete();
+  output_rb.set_eow(eos);
+  output_rb.set_eos(eos);
+  last_data_flush_time_ = std::chrono::system_clock::now();
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+void UnionNode::AdvanceParentCursor(size_t parent, size_t num_rows) {
+  // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
+  // popped.
+  const auto& rb = parent_row_batches_[parent][0];
+  row_cursors_[parent] += num_rows;
+  DCHECK_LE(row_cursors_[parent], static_cast<size_t>(rb.num_rows()));
+  if (row_cursors_[parent] < static_cast<size_t>(rb.num_rows())) {
+    return;
+  }
+  if (rb.eos()) {
+    flushed_parent_eoses_[parent] = true;
+  }
+
+  // Delete the top row batch from our buffer and update the cursor.
+  parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
+  row_cursors_[parent] = 0;
+  CacheNextRowBatch(parent);
+}
+
 // Flush the row batch if we have waited too long between row batches.
 Status UnionNode::OptionallyFlushRowBatchIfTimeout(ExecState* exec_state) {
   if (!enable_data_flush_timeout_) {
@@ -169,71 +297,41 @@ Status UnionNode::FlushBatch(ExecState* exec_state) {
   return SendRowBatchToChildren(exec_state, *rb);
 }
 
+// Merges the parents with a loser tree, which finds the parent with the next row in O(log(n))
+// comparisons for n parents. Consecutive rows from the same parent are then copied as one run.
 Status UnionNode::MergeData(ExecState* exec_state) {
-  while (!sent_eos_) {
-    // Get the smallest time out of all of the current streams.
-    std::vector<size_t> parent_streams;
-    parent_streams.reserve(row_cursors_.size());
-
-    for (size_t parent = 0; parent < row_cursors_.size(); ++parent) {
-      if (flushed_parent_eoses_[parent]) {
-        continue;
-      }
-      // If we lack necessary data, we can't merge anymore.
-      if (!parent_row_batches_[parent].size()) {
-        return Status::OK();
-      }
-      parent_streams.push_back(parent);
+  // If we lack necessary data, we can't merge anymore.
+  for (size_t parent = 0; parent < num_parents_; ++parent) {
+    if (!flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty()) {
+      return Status::OK();
     }
+  }
+
+  BuildMergeTree();
+
+  while (!sent_eos_) {
+    size_t parent = merge_tree_[0];
 
     // If we have reached end of stream for all of our inputs, flush the queue.
-    if (!parent_streams.size()) {
+    if (flushed_parent_eoses_[parent]) {
       return OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state);
     }
 
-    std::sort(parent_streams.begin(), parent_streams.end(),
-              [this](size_t parent_a, size_t parent_b) {
-                auto time_a = GetTimeAtParentCursor(parent_a);
-                auto time_b = GetTimeAtParentCursor(parent_b);
-                return time_a < time_b || (time_a == time_b && parent_a < parent_b);
-              });
-
-    bool has_limit = parent_streams.size() > 1;
-    size_t parent = parent_streams[0];
-
-    while (parent_row_batches_[parent].size()) {
-      if (has_limit) {
-        size_t next_parent = parent_streams[1];
-        // If this time is greater than another parent stream's earliest time,
-        // or if they are the same but the first parent is at a smaller index, stop merging.
-        // This way rows are always stable with respect to input parent index.
-        if (GetTimeAtParentCursor(parent) > GetTimeAtParentCursor(next_parent) ||
-            (GetTimeAtParentCursor(parent) == GetTimeAtParentCursor(next_parent) &&
-             parent > next_parent)) {
-          break;
-        }
-      }
-
-      PL_RETURN_IF_ERROR(AppendRow(parent));
-
-      // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
-      // popped.
-      const auto& rb = parent_row_batches_[parent][0];
-      bool pop_row_batch = ++row_cursors_[parent] == static_cast<size_t>(rb.num_rows());
-      if (pop_row_batch && rb.eos()) {
-        flushed_parent_eoses_[parent] = true;
-      }
-
-      if (pop_row_batch) {
-        // Delete the top row batch from our buffer and update the cursor.
-        parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
-        row_cursors_[parent] = 0;
-        CacheNextRowBatch(parent);
-      }
-
+    size_t output_rows = column_builders_[0]->length();
+    size_t num_rows = std::min(MergeRunLength(parent), output_rows_per_batch_ - output_rows);
+    if (output_rows == 0 && num_rows == output_rows_per_batch_) {
+      PL_RETURN_IF_ERROR(SendRunAsSlice(exec_state, parent, num_rows));
+    } else {
+      PL_RETURN_IF_ERROR(AppendRun(parent, num_rows));
       // Flush the current RowBatch if necessary.
       PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
     }
+
+    // Wait for more data if the parent's buffered row batches ran out.
+    if (!flushed_parent_eoses_[parent] && parent_row_batches_[parent].empty()) {
+      return Status::OK();
+    }
+    ReplayMergeTree(parent);
   }
   return Status::OK();
 }
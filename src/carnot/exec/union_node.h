@@ -91,7 +91,14 @@ class UnionNode : public ProcessingNode {
   void CacheNextRowBatch(size_t parent);
   Status InitializeColumnBuilders();
   types::Time64NSValue GetTimeAtParentCursor(size_t parent_index) const;
-  Status AppendRow(size_t parent);
+  bool MergeLess(size_t parent_a, size_t parent_b) const;
+  void BuildMergeTree();
+  size_t BuildMergeTree(size_t node);
+  void ReplayMergeTree(size_t parent);
+  size_t MergeRunLength(size_t parent) const;
+  Status AppendRun(size_t parent, size_t num_rows);
+  Status SendRunAsSlice(ExecState* exec_state, size_t parent, size_t num_rows);
+  void AdvanceParentCursor(size_t parent, size_t num_rows);
   Status OptionallyFlushRowBatchIfMaxRowsOrEOS(ExecState* exec_state);
   Status OptionallyFlushRowBatchIfTimeout(ExecState* exec_state);
   Status FlushBatch(ExecState* exec_state);
@@ -112,6 +119,10 @@ class UnionNode : public ProcessingNode {
   // Cache current working time and data columns for performance reasons.
   std::vector<arrow::Array*> time_columns_;
   std::vector<std::vector<arrow::Array*>> data_columns_;
+  // Loser tree over the parents, which picks the parent with the next row to output.
+  // Parent p is the leaf at node num_parents_ + p, and node n (for 0 < n < num_parents_) holds
+  // the parent that lost the match at that node. merge_tree_[0] holds the overall winner.
+  std::vector<size_t> merge_tree_;
 
   bool enable_data_flush_timeout_ = true;
   // When enable_data_flush_timeout_ is set to true, use this time to decide if we should
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <arrow/memory_pool.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include <sole.hpp>
+
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/exec/union_node.h"
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+using px::carnot::exec::ExecState;
+using px::carnot::exec::MockResultSinkStubGenerator;
+using px::carnot::exec::UnionNode;
+using px::carnot::udf::Registry;
+using px::table_store::schema::RowBatch;
+using px::table_store::schema::RowDescriptor;
+using px::types::DataType;
+using px::types::ToArrow;
+
+// Time-ordered union of state.range(0) parents, which each send row batches of 1024 rows.
+// The parents take turns in time, so the output is made of runs of state.range(1) consecutive
+// rows from the same parent.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_UnionOrdered(benchmark::State& state) {
+  constexpr int64_t kNumRows = 1024;
+  int64_t num_parents = state.range(0);
+  int64_t run_length = state.range(1);
+
+  auto func_registry = std::make_unique<Registry>("test_registry");
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  auto exec_state = std::make_unique<ExecState>(
+      func_registry.get(), table_store, MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+
+  px::carnot::planpb::Operator op_proto;
+  op_proto.set_op_type(px::carnot::planpb::UNION_OPERATOR);
+  auto* union_op = op_proto.mutable_union_op();
+  union_op->add_column_names("time_");
+  union_op->add_column_names("value");
+  for (int64_t parent = 0; parent < num_parents; ++parent) {
+    auto* column_mapping = union_op->add_column_mappings();
+    column_mapping->add_column_indexes(0);
+    column_mapping->add_column_indexes(1);
+  }
+  auto plan_node = px::carnot::plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
+  RowDescriptor rd({DataType::TIME64NS, DataType::INT64});
+
+  // Every parent sends the same row batch each iteration. The times restart with every batch,
+  // which doesn't matter to the union, since it only compares the rows at the parents' cursors.
+  std::vector<RowBatch> input_rbs;
+  for (int64_t parent = 0; parent < num_parents; ++parent) {
+    std::vector<px::types::Time64NSValue> times(kNumRows);
+    std::vector<px::types::Int64Value> values(kNumRows);
+    for (int64_t i = 0; i < kNumRows; ++i) {
+      int64_t run = i / run_length;
+      times[i] = (run * num_parents + parent) * run_length + i % run_length;
+      values[i] = i;
+    }
+    RowBatch rb(rd, kNumRows);
+    PL_CHECK_OK(rb.AddColumn(ToArrow(times, arrow::default_memory_pool())));
+    PL_CHECK_OK(rb.AddColumn(ToArrow(values, arrow::default_memory_pool())));
+    input_rbs.push_back(rb);
+  }
+
+  UnionNode node;
+  node.disable_data_flush_timeout();
+  PL_CHECK_OK(node.Init(*plan_node, rd, std::vector<RowDescriptor>(num_parents, rd)));
+  PL_CHECK_OK(node.Prepare(exec_state.get()));
+  PL_CHECK_OK(node.Open(exec_state.get()));
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    for (int64_t parent = 0; parent < num_parents; ++parent) {
+      PL_CHECK_OK(node.ConsumeNext(exec_state.get(), input_rbs[parent], parent));
+    }
+  }
+  PL_CHECK_OK(node.Close(exec_state.get()));
+  state.SetItemsProcessed(state.iterations() * num_parents * kNumRows);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void UnionArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t num_parents : {2, 10, 100, 300}) {
+    for (int64_t run_length : {1, 64, 1024}) {
+      b->Args({num_parents, run_length});
+    }
+  }
+}
+
+BENCHMARK(BM_UnionOrdered)->Apply(UnionArgs)->ArgNames({"parents", "run_length"});
@@ -275,6 +275,69 @@ TEST_F(UnionNodeTest, ordered_full_overlap) {
       .Close();
 }
 
+// More than two parents, with ties in time across parents.
+TEST_F(UnionNodeTest, ordered_three_parents) {
+  auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
+  auto* column_mapping = op_proto.mutable_union_op()->add_column_mappings();
+  column_mapping->add_column_indexes(0);
+  column_mapping->add_column_indexes(1);
+  plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd_0({types::DataType::STRING, types::DataType::TIME64NS});
+  RowDescriptor input_rd_1({types::DataType::TIME64NS, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::STRING, types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<UnionNode, plan::UnionOperator>(
+      *plan_node_, output_rd, {input_rd_0, input_rd_1, input_rd_0}, exec_state_.get());
+  tester.node()->disable_data_flush_timeout();
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({"A", "B", "C"})
+                       .AddColumn<types::Time64NSValue>({0, 3, 6})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, false, false)
+                       .AddColumn<types::Time64NSValue>({1, 2, 7})
+                       .AddColumn<types::StringValue>({"a", "b", "c"})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, false, false)
+                       .AddColumn<types::StringValue>({"X", "Y", "Z"})
+                       .AddColumn<types::Time64NSValue>({3, 4, 5})
+                       .get(),
+                   2, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::StringValue>({"A", "a", "b", "B", "X"})
+                          .AddColumn<types::Time64NSValue>({0, 1, 2, 3, 3})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, true, true)
+                       .AddColumn<types::StringValue>({"W"})
+                       .AddColumn<types::Time64NSValue>({6})
+                       .get(),
+                   2, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, true, true)
+                       .AddColumn<types::StringValue>({"D"})
+                       .AddColumn<types::Time64NSValue>({8})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, false, false)
+                          .AddColumn<types::StringValue>({"Y", "Z", "C", "W", "c"})
+                          .AddColumn<types::Time64NSValue>({4, 5, 6, 6, 7})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 1, true, true)
+                       .AddColumn<types::Time64NSValue>({9})
+                       .AddColumn<types::StringValue>({"d"})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::StringValue>({"D", "d"})
+                          .AddColumn<types::Time64NSValue>({8, 9})
+                          .get())
+      .Close();
+}
+
 TEST_F(UnionNodeTest, no_rows_parent) {
   auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
   plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
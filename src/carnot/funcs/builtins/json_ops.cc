@@ -18,6 +18,11 @@
 
 #include "src/carnot/funcs/builtins/json_ops.h"
 
+#include <cstring>
+#include <limits>
+
+#include <rapidjson/reader.h>
+
 #include "src/carnot/udf/registry.h"
 
 namespace px {
@@ -26,6 +31,156 @@ namespace builtins {
 
 using types::StringValue;
 
+namespace {
+
+// SAX handler that waits for `key` at the top level of an object and captures the value that
+// follows it. Returning false from a callback makes the reader stop, which is how the scan
+// terminates early once the value has been read (or once the input is known not to be an object).
+class TopLevelMemberHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, TopLevelMemberHandler> {
+ public:
+  explicit TopLevelMemberHandler(const std::string& key) : key_(key), writer_(buffer_) {}
+
+  bool Null() {
+    return Scalar(JSONMember::Kind::kNull, [this] { writer_.Null(); });
+  }
+  bool Bool(bool b) {
+    return Scalar(JSONMember::Kind::kOther, [this, b] { writer_.Bool(b); });
+  }
+  bool Int(int i) { return Int64(i); }
+  bool Uint(unsigned u) { return Int64(u); }
+  bool Int64(int64_t i) {
+    if (capturing_ && depth_ == 1) {
+      member_.int64_value = i;
+      member_.double_value = static_cast<double>(i);
+    }
+    return Scalar(JSONMember::Kind::kInt64, [this, i] { writer_.Int64(i); });
+  }
+  bool Uint64(uint64_t u) {
+    if (u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      return Int64(static_cast<int64_t>(u));
+    }
+    if (capturing_ && depth_ == 1) {
+      member_.double_value = static_cast<double>(u);
+    }
+    return Scalar(JSONMember::Kind::kDouble, [this, u] { writer_.Uint64(u); });
+  }
+  bool Double(double d) {
+    if (capturing_ && depth_ == 1) {
+      member_.double_value = d;
+    }
+    return Scalar(JSONMember::Kind::kDouble, [this, d] { writer_.Double(d); });
+  }
+  bool String(const char* str, rapidjson::SizeType len, bool copy) {
+    if (capturing_ && depth_ == 1) {
+      // Top-level strings are returned unescaped rather than serialized.
+      member_.text.assign(str, len);
+      return Finish(JSONMember::Kind::kString);
+    }
+    return Scalar(JSONMember::Kind::kString, [this, str, len, copy] {
+      writer_.String(str, len, copy);
+    });
+  }
+
+  bool StartObject() {
+    if (capturing_) {
+      writer_.StartObject();
+    }
+    ++depth_;
+    return true;
+  }
+  bool Key(const char* str, rapidjson::SizeType len, bool copy) {
+    if (capturing_) {
+      return writer_.Key(str, len, copy);
+    }
+    if (depth_ == 1 && len == key_.size() && std::memcmp(str, key_.data(), len) == 0) {
+      capturing_ = true;
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType member_count) {
+    if (capturing_) {
+      writer_.EndObject(member_count);
+    }
+    return EndContainer();
+  }
+  bool StartArray() {
+    if (depth_ == 0) {
+      // Arrays have no keys to look up.
+      return false;
+    }
+    if (capturing_) {
+      writer_.StartArray();
+    }
+    ++depth_;
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType element_count) {
+    if (capturing_) {
+      writer_.EndArray(element_count);
+    }
+    return EndContainer();
+  }
+
+  bool done() const { return done_; }
+  JSONMember ConsumeMember() { return std::move(member_); }
+
+ private:
+  template <typename TWriteFn>
+  bool Scalar(JSONMember::Kind kind, TWriteFn write) {
+    if (depth_ == 0) {
+      // The root is a scalar, so there are no keys to look up.
+      return false;
+    }
+    if (!capturing_) {
+      return true;
+    }
+    write();
+    if (depth_ == 1) {
+      return Finish(kind);
+    }
+    return true;
+  }
+
+  bool EndContainer() {
+    --depth_;
+    if (capturing_ && depth_ == 1) {
+      return Finish(JSONMember::Kind::kOther);
+    }
+    return true;
+  }
+
+  bool Finish(JSONMember::Kind kind) {
+    member_.kind = kind;
+    if (kind != JSONMember::Kind::kString) {
+      member_.text.assign(buffer_.GetString(), buffer_.GetSize());
+    }
+    done_ = true;
+    return false;
+  }
+
+  const std::string& key_;
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+  JSONMember member_;
+  int depth_ = 0;
+  bool capturing_ = false;
+  bool done_ = false;
+};
+
+}  // namespace
+
+JSONMember FindTopLevelJSONMember(const std::string& json, const std::string& key) {
+  TopLevelMemberHandler handler(key);
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(json.c_str());
+  reader.Parse(stream, handler);
+  if (!handler.done()) {
+    return JSONMember{};
+  }
+  return handler.ConsumeMember();
+}
+
 void RegisterJSONOpsOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<PluckUDF>("pluck");
   registry->RegisterOrDie<PluckAsInt64UDF>("pluck_int64");
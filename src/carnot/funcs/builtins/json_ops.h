@@ -35,34 +35,39 @@ namespace builtins {
 
 // TODO(zasgar): PL-419 To have proper support for JSON we need structs and nullable types.
 // Revisit when we have them.
+
+/**
+ * The value found for a top-level key of a serialized JSON object.
+ */
+struct JSONMember {
+  enum class Kind { kMissing, kNull, kString, kInt64, kDouble, kOther };
+  Kind kind = Kind::kMissing;
+  // The unescaped string for kString, the compact serialized value for every other present kind.
+  std::string text;
+  // Set for kInt64 (both fields) and kDouble (double_value only).
+  int64_t int64_value = 0;
+  double double_value = 0.0;
+};
+
+/**
+ * Finds the value of a top-level key in a serialized JSON object. This runs rapidjson's SAX reader
+ * and stops as soon as the value for the key has been read, so no DOM is built and the remainder
+ * of the document is never scanned. Only the first occurrence of the key is considered.
+ *
+ * Returns kMissing if the input is not an object, does not contain the key, or is malformed before
+ * the value for the key ends.
+ */
+JSONMember FindTopLevelJSONMember(const std::string& json, const std::string& key);
 class PluckUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    JSONMember member = FindTopLevelJSONMember(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return "";
-    }
-    if (!d.IsObject()) {
-      return "";
-    }
-    if (!d.HasMember(key.data())) {
+    if (member.kind == JSONMember::Kind::kMissing || member.kind == JSONMember::Kind::kNull) {
       return "";
     }
-    const auto& plucked_value = d[key.data()];
-    if (plucked_value.IsNull()) {
-      return "";
-    }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
-    }
-
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+    // Nested values come back serialized, so this is robust to nested JSON.
+    return std::move(member.text);
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -87,17 +92,12 @@ class PluckUDF : public udf::ScalarUDF {
 class PluckAsInt64UDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    JSONMember member = FindTopLevelJSONMember(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0;
-    }
-    if (!d.IsObject()) {
+    if (member.kind != JSONMember::Kind::kInt64) {
       return 0;
     }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetInt64();
+    return member.int64_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -122,17 +122,12 @@ class PluckAsInt64UDF : public udf::ScalarUDF {
 class PluckAsFloat64UDF : public udf::ScalarUDF {
  public:
   Float64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    JSONMember member = FindTopLevelJSONMember(in, key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return 0.0;
-    }
-    if (!d.IsObject()) {
+    if (member.kind != JSONMember::Kind::kInt64 && member.kind != JSONMember::Kind::kDouble) {
       return 0.0;
     }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetDouble();
+    return member.double_value;
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
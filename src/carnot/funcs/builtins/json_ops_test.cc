@@ -90,6 +90,66 @@ TEST(JSONOps, PluckAsFloatUDF_non_object_input_return_empty) {
   udf_tester.ForInput("[\"asdad\"]", "float64_key").Expect(0.0);
 }
 
+TEST(JSONOps, PluckAsFloat64UDF_int_value) {
+  auto udf_tester = udf::UDFTester<PluckAsFloat64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "int64_key").Expect(34243242341.0);
+}
+
+TEST(JSONOps, PluckAsInt64UDF_non_int_value_return_empty) {
+  auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "str_plain").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "blah").Expect(0);
+}
+
+TEST(JSONOps, FindTopLevelJSONMember_kinds) {
+  constexpr char kJSON[] =
+      R"({"s": "a\"b", "i": -3, "d": 2.5, "n": null, "b": true, "a": [1, {"x": 2}]})";
+  JSONMember member = FindTopLevelJSONMember(kJSON, "s");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kString);
+  EXPECT_EQ(member.text, R"(a"b)");
+
+  member = FindTopLevelJSONMember(kJSON, "i");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kInt64);
+  EXPECT_EQ(member.int64_value, -3);
+  EXPECT_EQ(member.text, "-3");
+
+  member = FindTopLevelJSONMember(kJSON, "d");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kDouble);
+  EXPECT_DOUBLE_EQ(member.double_value, 2.5);
+
+  EXPECT_EQ(FindTopLevelJSONMember(kJSON, "n").kind, JSONMember::Kind::kNull);
+
+  member = FindTopLevelJSONMember(kJSON, "b");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kOther);
+  EXPECT_EQ(member.text, "true");
+
+  member = FindTopLevelJSONMember(kJSON, "a");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kOther);
+  EXPECT_EQ(member.text, R"([1,{"x":2}])");
+}
+
+TEST(JSONOps, FindTopLevelJSONMember_ignores_nested_keys) {
+  JSONMember member = FindTopLevelJSONMember(R"({"outer": {"k": 1}, "k": 2})", "k");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kInt64);
+  EXPECT_EQ(member.int64_value, 2);
+
+  EXPECT_EQ(FindTopLevelJSONMember(R"({"outer": {"k": 1}})", "k").kind,
+            JSONMember::Kind::kMissing);
+  EXPECT_EQ(FindTopLevelJSONMember(R"([{"k": 1}])", "k").kind, JSONMember::Kind::kMissing);
+  EXPECT_EQ(FindTopLevelJSONMember(R"("k")", "k").kind, JSONMember::Kind::kMissing);
+}
+
+TEST(JSONOps, FindTopLevelJSONMember_stops_after_value) {
+  // The scan stops once the value has been read, so input after it is never looked at.
+  JSONMember member = FindTopLevelJSONMember(R"({"p50": 5, "p90": [not json)", "p50");
+  EXPECT_EQ(member.kind, JSONMember::Kind::kInt64);
+  EXPECT_EQ(member.int64_value, 5);
+
+  EXPECT_EQ(FindTopLevelJSONMember(R"({"p50": 5, "p90": [not json)", "p90").kind,
+            JSONMember::Kind::kMissing);
+}
+
 TEST(JSONOps, ScriptReferenceUDF_no_args) {
   auto udf_tester = udf::UDFTester<ScriptReferenceUDF<>>();
   auto res = udf_tester.ForInput("text", "px/script").Result();
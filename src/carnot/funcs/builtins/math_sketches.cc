@@ -18,13 +18,209 @@
 
 #include "src/carnot/funcs/builtins/math_sketches.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 namespace px {
 namespace carnot {
 namespace builtins {
 
+namespace {
+
+template <typename T>
+void AppendRaw(T val, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <typename T>
+T ReadRaw(const char* pos) {
+  T val;
+  std::memcpy(&val, pos, sizeof(val));
+  return val;
+}
+
+}  // namespace
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  for (size_t i = 0; i < kNumRegisters; ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+int64_t HyperLogLog::Estimate() const {
+  constexpr double kNumRegistersD = kNumRegisters;
+  constexpr double kAlpha = 0.7213 / (1 + 1.079 / kNumRegistersD);
+
+  double inverse_sum = 0;
+  size_t num_zeros = 0;
+  for (uint8_t reg : registers_) {
+    inverse_sum += std::ldexp(1.0, -reg);
+    num_zeros += reg == 0;
+  }
+  double estimate = kAlpha * kNumRegistersD * kNumRegistersD / inverse_sum;
+  // Small cardinalities are estimated more accurately by linear counting over empty registers.
+  if (estimate <= 2.5 * kNumRegistersD && num_zeros > 0) {
+    estimate = kNumRegistersD * std::log(kNumRegistersD / num_zeros);
+  }
+  return std::llround(estimate);
+}
+
+std::string HyperLogLog::Serialize() const {
+  return std::string(reinterpret_cast<const char*>(registers_.data()), registers_.size());
+}
+
+Status HyperLogLog::Deserialize(const std::string& data) {
+  if (data.size() != kNumRegisters) {
+    return error::InvalidArgument("HyperLogLog sketch has $0 registers, expected $1", data.size(),
+                                  kNumRegisters);
+  }
+  std::memcpy(registers_.data(), data.data(), kNumRegisters);
+  return Status::OK();
+}
+
+int64_t SpaceSavingSummary::MinCount() const {
+  int64_t min_count = std::numeric_limits<int64_t>::max();
+  for (const auto& [value, counter] : counters_) {
+    min_count = std::min(min_count, counter.count);
+  }
+  return min_count;
+}
+
+void SpaceSavingSummary::Add(const std::string& value) {
+  auto it = counters_.find(value);
+  if (it != counters_.end()) {
+    ++it->second.count;
+    return;
+  }
+  if (counters_.size() < capacity_) {
+    counters_[value].count = 1;
+    return;
+  }
+  // Replace the value with the smallest count. Its count becomes the error of the new value.
+  auto min_it = std::min_element(counters_.begin(), counters_.end(), [](auto& a, auto& b) {
+    return a.second.count < b.second.count;
+  });
+  Counter counter{min_it->second.count + 1, min_it->second.count};
+  counters_.erase(min_it);
+  counters_[value] = counter;
+}
+
+void SpaceSavingSummary::Merge(const SpaceSavingSummary& other) {
+  // A value missing from a full summary may still have occurred up to its min count times.
+  int64_t this_missing = counters_.size() < capacity_ ? 0 : MinCount();
+  int64_t other_missing = other.counters_.size() < other.capacity_ ? 0 : other.MinCount();
+
+  for (auto& [value, counter] : counters_) {
+    if (!other.counters_.contains(value)) {
+      counter.count += other_missing;
+      counter.error += other_missing;
+    }
+  }
+  for (const auto& [value, other_counter] : other.counters_) {
+    auto it = counters_.find(value);
+    if (it != counters_.end()) {
+      it->second.count += other_counter.count;
+      it->second.error += other_counter.error;
+    } else {
+      counters_[value] = Counter{other_counter.count + this_missing,
+                                 other_counter.error + this_missing};
+    }
+  }
+
+  if (counters_.size() > capacity_) {
+    auto top = TopK(capacity_);
+    counters_.clear();
+    for (auto& [value, counter] : top) {
+      counters_.emplace(std::move(value), counter);
+    }
+  }
+}
+
+std::vector<std::pair<std::string, SpaceSavingSummary::Counter>> SpaceSavingSummary::TopK(
+    size_t k) const {
+  std::vector<std::pair<std::string, Counter>> top(counters_.begin(), counters_.end());
+  k = std::min(k, top.size());
+  // Ties are broken by value so that the result is deterministic.
+  std::partial_sort(top.begin(), top.begin() + k, top.end(), [](auto& a, auto& b) {
+    if (a.second.count != b.second.count) {
+      return a.second.count > b.second.count;
+    }
+    return a.first < b.first;
+  });
+  top.resize(k);
+  return top;
+}
+
+size_t SpaceSavingSummary::HeapBytes() const {
+  size_t bytes = counters_.capacity() * (sizeof(std::string) + sizeof(Counter));
+  for (const auto& [value, counter] : counters_) {
+    bytes += value.capacity();
+  }
+  return bytes;
+}
+
+std::string SpaceSavingSummary::Serialize() const {
+  std::string out;
+  AppendRaw(static_cast<uint32_t>(counters_.size()), &out);
+  for (const auto& [value, counter] : counters_) {
+    AppendRaw(static_cast<uint32_t>(value.size()), &out);
+    out.append(value);
+    AppendRaw(counter.count, &out);
+    AppendRaw(counter.error, &out);
+  }
+  return out;
+}
+
+Status SpaceSavingSummary::Deserialize(const std::string& data) {
+  const char* pos = data.data();
+  const char* end = data.data() + data.size();
+  auto remaining = [&]() { return static_cast<size_t>(end - pos); };
+
+  if (remaining() < sizeof(uint32_t)) {
+    return error::InvalidArgument("Top-k summary is too short: $0 bytes", data.size());
+  }
+  auto num_counters = ReadRaw<uint32_t>(pos);
+  pos += sizeof(uint32_t);
+
+  counters_.clear();
+  for (uint32_t i = 0; i < num_counters; ++i) {
+    if (remaining() < sizeof(uint32_t)) {
+      return error::InvalidArgument("Top-k summary is truncated");
+    }
+    auto len = ReadRaw<uint32_t>(pos);
+    pos += sizeof(uint32_t);
+    if (remaining() < len + 2 * sizeof(int64_t)) {
+      return error::InvalidArgument("Top-k summary is truncated");
+    }
+    std::string value(pos, len);
+    pos += len;
+    Counter counter{ReadRaw<int64_t>(pos), ReadRaw<int64_t>(pos + sizeof(int64_t))};
+    pos += 2 * sizeof(int64_t);
+    counters_[std::move(value)] = counter;
+  }
+  if (remaining() != 0) {
+    return error::InvalidArgument("Top-k summary has $0 trailing bytes", remaining());
+  }
+  return Status::OK();
+}
+
 void RegisterMathSketchesOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<QuantilesUDA<types::Int64Value>>("quantiles");
   registry->RegisterOrDie<QuantilesUDA<types::Float64Value>>("quantiles");
+
+  registry->RegisterOrDie<QuantilesSketchUDA<types::Int64Value>>("quantiles_sketch");
+  registry->RegisterOrDie<QuantilesSketchUDA<types::Float64Value>>("quantiles_sketch");
+  registry->RegisterOrDie<MergeQuantilesSketchUDA>("merge_quantiles_sketch");
+  registry->RegisterOrDie<QuantileUDF>("quantile");
+
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Int64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Float64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::StringValue>>("approx_count_distinct");
+
+  registry->RegisterOrDie<ApproxTopKUDA<types::Int64Value>>("approx_top_k");
+  registry->RegisterOrDie<ApproxTopKUDA<types::StringValue>>("approx_top_k");
 }
 
 }  // namespace builtins
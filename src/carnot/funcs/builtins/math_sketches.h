@@ -21,7 +21,17 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_cat.h>
+
 #include "src/carnot/udf/registry.h"
+#include "src/shared/sketches/tdigest_sketch.h"
+#include "src/shared/types/hash_utils.h"
 #include "src/shared/types/types.h"
 #include "tdigest/tdigest.h"
 
@@ -29,14 +39,26 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+// All digests built by the quantile UDAs use the same compression, so it is not serialized.
+constexpr double kTDigestCompression = 1000;
+
+using sketches::MergeSerializedTDigest;
+using sketches::SerializeTDigest;
+
 // TODO(zasgar): PL-419 Replace this when we add support for structs.
 template <typename TArg>
 class QuantilesUDA : public udf::UDA {
  public:
-  QuantilesUDA() : digest_(1000) {}
+  QuantilesUDA() : digest_(kTDigestCompression) {}
   void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
   void Merge(FunctionContext*, const QuantilesUDA& other) { digest_.merge(&other.digest_); }
 
+  StringValue Serialize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return MergeSerializedTDigest(data, &digest_);
+  }
+
   StringValue Finalize(FunctionContext*) {
     rapidjson::Document d;
     d.SetObject();
@@ -81,6 +103,287 @@ class QuantilesUDA : public udf::UDA {
   tdigest::TDigest digest_;
 };
 
+template <typename TArg>
+class QuantilesSketchUDA : public udf::UDA {
+ public:
+  QuantilesSketchUDA() : digest_(kTDigestCompression) {}
+  void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
+  void Merge(FunctionContext*, const QuantilesSketchUDA& other) { digest_.merge(&other.digest_); }
+
+  StringValue Serialize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return MergeSerializedTDigest(data, &digest_);
+  }
+
+  StringValue Finalize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  static udf::InfRuleVec SemanticInferenceRules() {
+    return {
+        udf::ExplicitRule::Create<QuantilesSketchUDA>(types::ST_QUANTILES_SKETCH, {types::ST_NONE}),
+        udf::ExplicitRule::Create<QuantilesSketchUDA>(types::ST_DURATION_NS_QUANTILES_SKETCH,
+                                                      {types::ST_DURATION_NS})};
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Builds a quantile sketch of the aggregated data.")
+        .Details(
+            "Summarizes the distribution of the aggregated data as a binary "
+            "[tdigest](https://github.com/tdunning/t-digest) sketch. Unlike `px.quantiles`, any "
+            "quantile can be read from the sketch with `px.quantile` without parsing JSON.")
+        .Example(R"doc(
+        | # Build the sketch.
+        | df = df.agg(latency_sketch=('latency_ms', px.quantiles_sketch))
+        | # Read p99 from the sketch.
+        | df.p99 = px.quantile(df.latency_sketch, 0.99)
+        )doc")
+        .Arg("val", "The data to summarize.")
+        .Returns("The serialized quantile sketch.");
+  }
+
+ protected:
+  tdigest::TDigest digest_;
+};
+
+class MergeQuantilesSketchUDA : public udf::UDA {
+ public:
+  MergeQuantilesSketchUDA() : digest_(kTDigestCompression) {}
+  void Update(FunctionContext*, StringValue sketch) {
+    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available. Until then sketches
+    // that can't be decoded are skipped.
+    PL_UNUSED(MergeSerializedTDigest(sketch, &digest_));
+  }
+  void Merge(FunctionContext*, const MergeQuantilesSketchUDA& other) {
+    digest_.merge(&other.digest_);
+  }
+
+  StringValue Serialize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return MergeSerializedTDigest(data, &digest_);
+  }
+
+  StringValue Finalize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  static udf::InfRuleVec SemanticInferenceRules() {
+    return {udf::ExplicitRule::Create<MergeQuantilesSketchUDA>(types::ST_QUANTILES_SKETCH,
+                                                               {types::ST_QUANTILES_SKETCH}),
+            udf::ExplicitRule::Create<MergeQuantilesSketchUDA>(
+                types::ST_DURATION_NS_QUANTILES_SKETCH, {types::ST_DURATION_NS_QUANTILES_SKETCH})};
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Merges quantile sketches.")
+        .Details(
+            "Combines the quantile sketches built by `px.quantiles_sketch`, or exported by "
+            "Stirling (e.g. the per-window `latency_sketch` of `http_stats`), into one sketch of "
+            "all of their data. Sketches that cannot be decoded are skipped.")
+        .Example(R"doc(
+        | df = px.DataFrame('http_stats', start_time='-5m')
+        | df = df.groupby('req_path').agg(
+        |     latency_sketch=('latency_sketch', px.merge_quantiles_sketch))
+        | df.p99 = px.quantile(df.latency_sketch, 0.99)
+        )doc")
+        .Arg("sketch", "The serialized quantile sketches to merge.")
+        .Returns("The merged quantile sketch.");
+  }
+
+ protected:
+  tdigest::TDigest digest_;
+};
+
+class QuantileUDF : public udf::ScalarUDF {
+ public:
+  Float64Value Exec(FunctionContext*, StringValue sketch, Float64Value q) {
+    tdigest::TDigest digest(kTDigestCompression);
+    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
+    if (!MergeSerializedTDigest(sketch, &digest).ok()) {
+      return 0.0;
+    }
+    return digest.quantile(q.val);
+  }
+
+  static udf::InfRuleVec SemanticInferenceRules() {
+    return {udf::ExplicitRule::Create<QuantileUDF>(types::ST_NONE,
+                                                   {types::ST_QUANTILES_SKETCH, types::ST_NONE}),
+            udf::ExplicitRule::Create<QuantileUDF>(
+                types::ST_DURATION_NS, {types::ST_DURATION_NS_QUANTILES_SKETCH, types::ST_NONE})};
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Reads a quantile from a quantile sketch.")
+        .Details(
+            "Estimates the value at the requested quantile of a sketch built by "
+            "`px.quantiles_sketch`. Returns 0.0 if the sketch cannot be decoded.")
+        .Example(R"doc(
+        | df = df.agg(latency_sketch=('latency_ms', px.quantiles_sketch))
+        | df.p99 = px.quantile(df.latency_sketch, 0.99)
+        )doc")
+        .Arg("sketch", "The serialized quantile sketch.")
+        .Arg("q", "The quantile to read, between 0 and 1.")
+        .Returns("The estimated value at the quantile.");
+  }
+};
+
+/**
+ * HyperLogLog cardinality sketch over 64-bit hashes. The sketch is 2^kPrecision one-byte registers
+ * (4KiB), for a standard error of about 1.6% no matter how many distinct values are added.
+ */
+class HyperLogLog {
+ public:
+  static constexpr int kPrecision = 12;
+  static constexpr size_t kNumRegisters = 1UL << kPrecision;
+
+  HyperLogLog() : registers_(kNumRegisters, 0) {}
+
+  void Add(uint64_t hash) {
+    size_t idx = hash >> (64 - kPrecision);
+    uint64_t rest = hash << kPrecision;
+    // Position of the first set bit in the remaining bits, counting from 1.
+    uint8_t rank = rest == 0 ? 64 - kPrecision + 1 : __builtin_clzll(rest) + 1;
+    if (rank > registers_[idx]) {
+      registers_[idx] = rank;
+    }
+  }
+
+  void Merge(const HyperLogLog& other);
+  int64_t Estimate() const;
+  size_t HeapBytes() const { return registers_.capacity(); }
+
+  std::string Serialize() const;
+  Status Deserialize(const std::string& data);
+
+ private:
+  std::vector<uint8_t> registers_;
+};
+
+/**
+ * Space-saving heavy-hitters summary (Metwally et al.), which tracks at most `capacity` values.
+ * The count of a tracked value overestimates its true count by at most its error.
+ */
+class SpaceSavingSummary {
+ public:
+  struct Counter {
+    int64_t count = 0;
+    int64_t error = 0;
+  };
+
+  explicit SpaceSavingSummary(size_t capacity) : capacity_(capacity) {}
+
+  void Add(const std::string& value);
+  void Merge(const SpaceSavingSummary& other);
+
+  /**
+   * Returns up to k tracked values with the highest counts, in descending order of count.
+   */
+  std::vector<std::pair<std::string, Counter>> TopK(size_t k) const;
+
+  // The bytes allocated for the tracked values and their counters.
+  size_t HeapBytes() const;
+
+  std::string Serialize() const;
+  Status Deserialize(const std::string& data);
+
+ private:
+  int64_t MinCount() const;
+
+  size_t capacity_;
+  absl::flat_hash_map<std::string, Counter> counters_;
+};
+
+template <typename TArg>
+class ApproxCountDistinctUDA : public udf::UDA {
+ public:
+  void Update(FunctionContext*, TArg val) { hll_.Add(types::utils::hash<TArg>()(val)); }
+  void Merge(FunctionContext*, const ApproxCountDistinctUDA& other) { hll_.Merge(other.hll_); }
+  Int64Value Finalize(FunctionContext*) { return hll_.Estimate(); }
+  size_t HeapBytes() const { return hll_.HeapBytes(); }
+
+  StringValue Serialize(FunctionContext*) { return hll_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    HyperLogLog other;
+    PL_RETURN_IF_ERROR(other.Deserialize(data));
+    hll_.Merge(other);
+    return Status::OK();
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the number of distinct values in the group.")
+        .Details(
+            "Estimates the number of distinct values with a HyperLogLog sketch. The sketch has a "
+            "fixed size of 4KiB per group, so unlike grouping by the values and counting the "
+            "groups, memory does not grow with the number of distinct values. The estimate has "
+            "a standard error of about 1.6%.")
+        .Example("df = df.agg(num_paths=('req_path', px.approx_count_distinct))")
+        .Arg("val", "The values to count.")
+        .Returns("The approximate number of distinct values.");
+  }
+
+ protected:
+  HyperLogLog hll_;
+};
+
+template <typename TArg>
+class ApproxTopKUDA : public udf::UDA {
+ public:
+  // Number of values reported, and number of values tracked to report them accurately.
+  static constexpr size_t kNumReported = 10;
+  static constexpr size_t kCapacity = 100;
+
+  ApproxTopKUDA() : summary_(kCapacity) {}
+  void Update(FunctionContext*, TArg val) {
+    if constexpr (std::is_same_v<TArg, StringValue>) {
+      summary_.Add(val);
+    } else {
+      summary_.Add(absl::StrCat(val.val));
+    }
+  }
+  void Merge(FunctionContext*, const ApproxTopKUDA& other) { summary_.Merge(other.summary_); }
+  size_t HeapBytes() const { return summary_.HeapBytes(); }
+
+  StringValue Finalize(FunctionContext*) {
+    rapidjson::Document d;
+    d.SetObject();
+    for (const auto& [value, counter] : summary_.TopK(kNumReported)) {
+      d.AddMember(rapidjson::Value().SetString(value.c_str(), d.GetAllocator()).Move(),
+                  counter.count, d.GetAllocator());
+    }
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    d.Accept(writer);
+    return sb.GetString();
+  }
+
+  StringValue Serialize(FunctionContext*) { return summary_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    SpaceSavingSummary other(kCapacity);
+    PL_RETURN_IF_ERROR(other.Deserialize(data));
+    summary_.Merge(other);
+    return Status::OK();
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the most frequent values in the group.")
+        .Details(
+            "Finds the 10 most frequent values with a space-saving summary that tracks at most "
+            "100 values per group, so memory does not grow with the number of distinct values. "
+            "Returns a serialized JSON object from each value to its approximate count, ordered "
+            "by count. Counts may be overestimated for values that are not much more frequent "
+            "than the rest.")
+        .Example(R"doc(
+        | df = df.agg(top_paths=('req_path', px.approx_top_k))
+        | df.top_path_count = px.pluck_int64(df.top_paths, '/healthz')
+        )doc")
+        .Arg("val", "The values to count.")
+        .Returns("The most frequent values and their counts, serialized as a JSON dictionary.");
+  }
+
+ protected:
+  SpaceSavingSummary summary_;
+};
+
 void RegisterMathSketchesOrDie(udf::Registry* registry);
 
 }  // namespace builtins
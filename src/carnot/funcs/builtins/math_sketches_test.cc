@@ -19,9 +19,12 @@
 #include <gtest/gtest.h>
 #include <rapidjson/document.h>
 
+#include <string>
+
 #include "src/carnot/funcs/builtins/math_sketches.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
+#include "src/common/testing/testing.h"
 
 namespace px {
 namespace carnot {
@@ -69,6 +72,150 @@ TEST(MathSketches, quantiles_int64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6);
 }
 
+TEST(MathSketches, quantiles_partial_roundtrip) {
+  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  uda_tester.ForInput(1.0).ForInput(2.0).ForInput(3.0).ForInput(4.0);
+  auto other_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  other_tester.ForInput(5.0).ForInput(6.0);
+  ASSERT_OK(uda_tester.Deserialize(other_tester.Serialize()));
+
+  rapidjson::Document d;
+  d.Parse(uda_tester.Result().data());
+  EXPECT_DOUBLE_EQ(d["p01"].GetDouble(), 1.0);
+  EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6.0);
+}
+
+TEST(MathSketches, quantiles_sketch) {
+  auto uda_tester = udf::UDATester<QuantilesSketchUDA<types::Int64Value>>();
+  auto sketch =
+      uda_tester.ForInput(1).ForInput(2).ForInput(2).ForInput(1).ForInput(1).ForInput(5).Result();
+
+  auto udf_tester = udf::UDFTester<QuantileUDF>();
+  udf_tester.ForInput(sketch, 0.01).Expect(1.0);
+  udf_tester.ForInput(sketch, 0.99).Expect(5.0);
+}
+
+TEST(MathSketches, quantiles_sketch_merge) {
+  auto uda_tester = udf::UDATester<QuantilesSketchUDA<types::Float64Value>>();
+  uda_tester.ForInput(1.0).ForInput(2.0);
+  auto other_tester = udf::UDATester<QuantilesSketchUDA<types::Float64Value>>();
+  other_tester.ForInput(3.0).ForInput(10.0);
+  ASSERT_OK(uda_tester.Deserialize(other_tester.Serialize()));
+
+  auto udf_tester = udf::UDFTester<QuantileUDF>();
+  udf_tester.ForInput(uda_tester.Result(), 0.01).Expect(1.0);
+  udf_tester.ForInput(uda_tester.Result(), 0.99).Expect(10.0);
+}
+
+TEST(MathSketches, merge_quantiles_sketch) {
+  auto sketch_1 = udf::UDATester<QuantilesSketchUDA<types::Int64Value>>()
+                      .ForInput(1)
+                      .ForInput(2)
+                      .Result();
+  auto sketch_2 = udf::UDATester<QuantilesSketchUDA<types::Int64Value>>()
+                      .ForInput(3)
+                      .ForInput(10)
+                      .Result();
+
+  auto uda_tester = udf::UDATester<MergeQuantilesSketchUDA>();
+  uda_tester.ForInput(sketch_1).ForInput("not a sketch").ForInput(sketch_2);
+
+  auto udf_tester = udf::UDFTester<QuantileUDF>();
+  udf_tester.ForInput(uda_tester.Result(), 0.01).Expect(1.0);
+  udf_tester.ForInput(uda_tester.Result(), 0.99).Expect(10.0);
+}
+
+TEST(MathSketches, quantile_bad_sketch) {
+  tdigest::TDigest digest(kTDigestCompression);
+  EXPECT_NOT_OK(MergeSerializedTDigest("", &digest));
+  EXPECT_NOT_OK(MergeSerializedTDigest(std::string("\x02\0\0\0\0", 5), &digest));
+  EXPECT_NOT_OK(MergeSerializedTDigest(std::string("\x01\x01\0\0\0", 5), &digest));
+
+  auto udf_tester = udf::UDFTester<QuantileUDF>();
+  udf_tester.ForInput("not a sketch", 0.5).Expect(0.0);
+}
+
+TEST(MathSketches, approx_count_distinct_small) {
+  auto uda_tester = udf::UDATester<ApproxCountDistinctUDA<types::StringValue>>();
+  uda_tester.ForInput("a").ForInput("b").ForInput("a").ForInput("c").Expect(3);
+}
+
+TEST(MathSketches, approx_count_distinct_merge) {
+  auto uda_tester = udf::UDATester<ApproxCountDistinctUDA<types::Int64Value>>();
+  auto other_tester = udf::UDATester<ApproxCountDistinctUDA<types::Int64Value>>();
+  for (int64_t i = 0; i < 5000; ++i) {
+    uda_tester.ForInput(i);
+    // Overlaps with the first half of the values above.
+    other_tester.ForInput(i / 2);
+  }
+  ASSERT_OK(uda_tester.Deserialize(other_tester.Serialize()));
+  EXPECT_NEAR(uda_tester.Result().val, 5000, 5000 * 0.05);
+}
+
+TEST(MathSketches, approx_count_distinct_bad_sketch) {
+  HyperLogLog hll;
+  EXPECT_NOT_OK(hll.Deserialize("abc"));
+}
+
+TEST(MathSketches, approx_top_k) {
+  auto uda_tester = udf::UDATester<ApproxTopKUDA<types::StringValue>>();
+  for (int i = 0; i < 5; ++i) {
+    uda_tester.ForInput("a");
+  }
+  uda_tester.ForInput("b").ForInput("c").ForInput("b").Expect(R"({"a":5,"b":2,"c":1})");
+}
+
+TEST(MathSketches, approx_top_k_int64) {
+  auto uda_tester = udf::UDATester<ApproxTopKUDA<types::Int64Value>>();
+  uda_tester.ForInput(200).ForInput(404).ForInput(200).Expect(R"({"200":2,"404":1})");
+}
+
+TEST(MathSketches, space_saving_over_capacity) {
+  SpaceSavingSummary summary(2);
+  for (int i = 0; i < 10; ++i) {
+    summary.Add("heavy");
+    summary.Add(absl::StrCat("light", i));
+  }
+  auto top = summary.TopK(1);
+  ASSERT_EQ(top.size(), 1UL);
+  EXPECT_EQ(top[0].first, "heavy");
+  EXPECT_GE(top[0].second.count, 10);
+
+  SpaceSavingSummary other(2);
+  for (int i = 0; i < 5; ++i) {
+    other.Add("heavy");
+  }
+  SpaceSavingSummary roundtrip(2);
+  ASSERT_OK(roundtrip.Deserialize(other.Serialize()));
+  summary.Merge(roundtrip);
+  top = summary.TopK(1);
+  EXPECT_EQ(top[0].first, "heavy");
+  EXPECT_GE(top[0].second.count, 15);
+}
+
+TEST(MathSketches, heap_bytes) {
+  udf::UDADefinition top_k_def("approx_top_k");
+  ASSERT_OK(top_k_def.Init<ApproxTopKUDA<types::StringValue>>());
+  EXPECT_TRUE(top_k_def.has_heap_bytes());
+  auto top_k = top_k_def.Make();
+  size_t empty_bytes = top_k_def.HeapBytes(top_k.get());
+  static_cast<ApproxTopKUDA<types::StringValue>*>(top_k.get())
+      ->Update(nullptr, types::StringValue(std::string(64, 'a')));
+  EXPECT_GE(top_k_def.HeapBytes(top_k.get()), empty_bytes + 64);
+
+  udf::UDADefinition count_distinct_def("approx_count_distinct");
+  ASSERT_OK(count_distinct_def.Init<ApproxCountDistinctUDA<types::Int64Value>>());
+  auto count_distinct = count_distinct_def.Make();
+  EXPECT_GE(count_distinct_def.HeapBytes(count_distinct.get()), HyperLogLog::kNumRegisters);
+
+  // UDAs without a HeapBytes function only count their instance.
+  udf::UDADefinition quantiles_def("quantiles");
+  ASSERT_OK(quantiles_def.Init<QuantilesUDA<types::Float64Value>>());
+  EXPECT_FALSE(quantiles_def.has_heap_bytes());
+  EXPECT_EQ(quantiles_def.instance_size(), sizeof(QuantilesUDA<types::Float64Value>));
+  EXPECT_EQ(quantiles_def.HeapBytes(quantiles_def.Make().get()), 0UL);
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -26,6 +26,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "src/carnot/exec/ml/coreset.h"
@@ -61,8 +62,38 @@ class TransformerUDF : public udf::ScalarUDF {
     return output;
   }
 
+  // Borrows the model once per batch, and runs the docs through it in padded batches instead of
+  // one inference call per row.
+  Status ExecBatch(FunctionContext* ctx, const arrow::StringArray& docs, arrow::StringBuilder* out,
+                   size_t count) {
+    docs_.clear();
+    docs_.reserve(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto view = docs.GetView(idx);
+      docs_.emplace_back(view.data(), view.size());
+    }
+    {
+      auto executor =
+          ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
+      executor->ExecuteBatch(docs_, &outputs_);
+    }
+    int64_t data_bytes = 0;
+    for (const auto& output : outputs_) {
+      data_bytes += output.size();
+    }
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    PL_RETURN_IF_ERROR(out->ReserveData(data_bytes));
+    for (const auto& output : outputs_) {
+      out->UnsafeAppend(output);
+    }
+    return Status::OK();
+  }
+
  private:
   std::string model_proto_path_;
+  // Scratch space of ExecBatch, kept to reuse the allocations across batches.
+  std::vector<std::string_view> docs_;
+  std::vector<std::string> outputs_;
 };
 
 class SentencePieceUDF : public udf::ScalarUDF {
@@ -81,8 +112,33 @@ class SentencePieceUDF : public udf::ScalarUDF {
     return write_ints_to_json(ids.data(), ids.size());
   }
 
+  // Reuses the token id and JSON buffers across the rows of the batch.
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& in, arrow::StringBuilder* out,
+                   size_t count) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto view = in.GetView(idx);
+      doc_.assign(view.data(), view.size());
+      processor_.Encode(doc_, &ids_);
+
+      json_.Clear();
+      rapidjson::Writer<rapidjson::StringBuffer> writer(json_);
+      writer.StartArray();
+      for (int id : ids_) {
+        writer.Int(id);
+      }
+      writer.EndArray();
+      PL_RETURN_IF_ERROR(out->Append(json_.GetString(), json_.GetSize()));
+    }
+    return Status::OK();
+  }
+
  private:
   sentencepiece::SentencePieceProcessor processor_;
+  // Scratch space of ExecBatch.
+  std::string doc_;
+  std::vector<int> ids_;
+  rapidjson::StringBuffer json_;
 };
 
 class KMeansUDA : public udf::UDA {
@@ -18,6 +18,7 @@
 
 #include <gflags/gflags.h>
 
+#include <arrow/builder.h>
 #include <benchmark/benchmark.h>
 #include "src/carnot/exec/ml/model_pool.h"
 #include "src/carnot/exec/ml/transformer_executor.h"
@@ -73,6 +74,36 @@ static void BM_TransformerModel(benchmark::State& state) {
   }
 }
 
+std::shared_ptr<arrow::StringArray> repeated_string_array(const std::string& value, int64_t n) {
+  arrow::StringBuilder builder;
+  for (int64_t i = 0; i < n; ++i) {
+    PL_CHECK_OK(builder.Append(value));
+  }
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder.Finish(&arr));
+  return std::static_pointer_cast<arrow::StringArray>(arr);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TransformerModelBatch(benchmark::State& state) {
+  px::carnot::builtins::TransformerUDF udf(FLAGS_embedding_dir);
+  auto ints = random_ints(64);
+  auto json = px::carnot::builtins::write_ints_to_json(ints.data(), 64);
+  auto docs = repeated_string_array(json, state.range(0));
+  auto model_pool = px::carnot::exec::ml::ModelPool::Create();
+  auto model =
+      model_pool->GetModelExecutor<px::carnot::exec::ml::TransformerExecutor>(FLAGS_embedding_dir);
+  model.reset();
+  auto ctx = px::carnot::udf::FunctionContext(nullptr, model_pool.get());
+
+  for (auto _ : state) {
+    arrow::StringBuilder out;
+    PL_CHECK_OK(udf.ExecBatch(&ctx, *docs, &out, docs->length()));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * docs->length());
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_SentencePiece(benchmark::State& state) {
   auto udf = px::carnot::builtins::SentencePieceUDF(FLAGS_sentencepiece_dir);
@@ -83,5 +114,20 @@ static void BM_SentencePiece(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_SentencePieceBatch(benchmark::State& state) {
+  auto udf = px::carnot::builtins::SentencePieceUDF(FLAGS_sentencepiece_dir);
+  auto docs = repeated_string_array(random_string(1024), state.range(0));
+
+  for (auto _ : state) {
+    arrow::StringBuilder out;
+    PL_CHECK_OK(udf.ExecBatch(nullptr, *docs, &out, docs->length()));
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * docs->length());
+}
+
 BENCHMARK(BM_SentencePiece)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SentencePieceBatch)->Arg(1024)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_TransformerModel)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TransformerModelBatch)->Arg(1)->Arg(32)->Arg(1024)->Unit(benchmark::kMillisecond);
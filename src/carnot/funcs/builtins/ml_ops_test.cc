@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <absl/strings/substitute.h>
 #include <gflags/gflags.h>
 #include <gmock/gmock.h>
 #include <memory>
@@ -26,6 +27,7 @@
 #include <vector>
 
 #include "src/carnot/funcs/builtins/ml_ops.h"
+#include "src/shared/types/arrow_adapter.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
 
@@ -150,6 +152,56 @@ TEST(Transformer, basic) {
       "15099024772644044,-0.10007300972938538,1.1897741556167603]");
 }
 
+TEST(SentencePiece, exec_batch_matches_exec) {
+  SentencePieceUDF udf(FLAGS_sentencepiece_dir);
+  std::vector<types::StringValue> docs = {"Test 123!", "", "another doc", "Test 123!"};
+  auto arr = types::ToArrow(docs, arrow::default_memory_pool());
+
+  arrow::StringBuilder builder;
+  ASSERT_OK(udf.ExecBatch(nullptr, static_cast<const arrow::StringArray&>(*arr), &builder,
+                          docs.size()));
+  std::shared_ptr<arrow::Array> out;
+  ASSERT_TRUE(builder.Finish(&out).ok());
+  auto out_strs = std::static_pointer_cast<arrow::StringArray>(out);
+  ASSERT_EQ(static_cast<int64_t>(docs.size()), out_strs->length());
+  for (const auto& [i, doc] : Enumerate(docs)) {
+    EXPECT_EQ(udf.Exec(nullptr, doc), out_strs->GetString(i));
+  }
+}
+
+TEST(Transformer, exec_batch_matches_exec) {
+  auto pool = exec::ml::ModelPool::Create();
+  FunctionContext ctx(nullptr, pool.get());
+  TransformerUDF udf(FLAGS_embedding_dir);
+
+  // More docs than fit in a single inference call, with a doc that can't be parsed.
+  std::vector<types::StringValue> docs;
+  for (size_t i = 0; i < exec::ml::TransformerExecutor::kMaxBatchSize + 8; ++i) {
+    docs.push_back(absl::Substitute("[4,197,$0,195,16,5001]", i));
+  }
+  docs[3] = "not json";
+  auto arr = types::ToArrow(docs, arrow::default_memory_pool());
+
+  arrow::StringBuilder builder;
+  ASSERT_OK(udf.ExecBatch(&ctx, static_cast<const arrow::StringArray&>(*arr), &builder,
+                          docs.size()));
+  std::shared_ptr<arrow::Array> out;
+  ASSERT_TRUE(builder.Finish(&out).ok());
+  auto out_strs = std::static_pointer_cast<arrow::StringArray>(out);
+  ASSERT_EQ(static_cast<int64_t>(docs.size()), out_strs->length());
+  EXPECT_EQ("", out_strs->GetString(3));
+
+  for (const auto& [i, doc] : Enumerate(docs)) {
+    Eigen::VectorXf expected(256);
+    Eigen::VectorXf actual(256);
+    int expected_size = load_floats_from_json(udf.Exec(&ctx, doc), &expected, 256);
+    ASSERT_EQ(expected_size, load_floats_from_json(out_strs->GetString(i), &actual, 256)) << i;
+    for (int j = 0; j < expected_size; ++j) {
+      EXPECT_NEAR(expected(j), actual(j), 1e-3) << "doc " << i << ", dim " << j;
+    }
+  }
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -18,6 +18,7 @@
 
 
 #include "src/carnot/funcs/builtins/request_path_ops.h"
+#include <algorithm>
 #include <string_view>
 #include <vector>
 #include "src/carnot/udf/registry.h"
@@ -210,36 +211,97 @@ void RequestPathCluster::ToJSON(rapidjson::Writer<rapidjson::StringBuffer>* writ
   writer->EndObject();
 }
 
-double RequestPathClustering::MaxSimilarity(const RequestPath& request_path,
-                                            int64_t* max_index) const {
-  auto it = depth_to_centroid_indices_.find(request_path.depth());
+void RequestPathClusterIndex::Add(int64_t cluster_index, const RequestPath& centroid) {
+  DepthIndex& depth_index = depths_[centroid.depth()];
+  DCHECK(depth_index.cluster_indices.empty() ||
+         depth_index.cluster_indices.back() < cluster_index);
+  int32_t offset = depth_index.cluster_indices.size();
+  depth_index.cluster_indices.push_back(cluster_index);
+  depth_index.components.resize(centroid.depth());
+  for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    depth_index.components[i][path_component].push_back(offset);
+  }
+}
+
+void RequestPathClusterIndex::Remove(int64_t cluster_index, const RequestPath& centroid,
+                                     size_t i) {
+  const auto& path_component = centroid.path_components()[i];
+  if (path_component == RequestPath::kAnyToken) {
+    return;
+  }
+  auto depth_it = depths_.find(centroid.depth());
+  if (depth_it == depths_.end()) {
+    return;
+  }
+  DepthIndex& depth_index = depth_it->second;
+  const auto& indices = depth_index.cluster_indices;
+  auto index_it = std::lower_bound(indices.begin(), indices.end(), cluster_index);
+  if (index_it == indices.end() || *index_it != cluster_index) {
+    return;
+  }
+  int32_t offset = index_it - indices.begin();
+  auto component_it = depth_index.components[i].find(path_component);
+  if (component_it == depth_index.components[i].end()) {
+    return;
+  }
+  auto& offsets = component_it->second;
+  offsets.erase(std::remove(offsets.begin(), offsets.end(), offset), offsets.end());
+  if (offsets.empty()) {
+    depth_index.components[i].erase(component_it);
+  }
+}
+
+double RequestPathClusterIndex::MaxSimilarity(const RequestPath& request_path,
+                                              int64_t* max_index) const {
   *max_index = -1;
-  if (it == depth_to_centroid_indices_.end()) {
+  auto depth_it = depths_.find(request_path.depth());
+  if (depth_it == depths_.end()) {
     return 0.0;
   }
-  auto max_similarity = 0.0;
-  for (auto index : it->second) {
-    auto similarity = clusters_[index].Similarity(request_path);
-    if (similarity > max_similarity) {
-      *max_index = index;
-      max_similarity = similarity;
+  const DepthIndex& depth_index = depth_it->second;
+  std::vector<int32_t> num_agree(depth_index.cluster_indices.size(), 0);
+  for (const auto& [i, path_component] : Enumerate(request_path.path_components())) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto it = depth_index.components[i].find(path_component);
+    if (it == depth_index.components[i].end()) {
+      continue;
+    }
+    for (auto offset : it->second) {
+      ++num_agree[offset];
+    }
+  }
+  // Ties go to the first cluster, like a linear scan over the clusters would.
+  int32_t max_agree = 0;
+  for (const auto& [offset, agree] : Enumerate(num_agree)) {
+    if (agree > max_agree) {
+      max_agree = agree;
+      *max_index = depth_index.cluster_indices[offset];
     }
   }
-  return max_similarity;
+  return static_cast<double>(max_agree) / request_path.depth();
 }
 
 void RequestPathClustering::AddNewCluster(const RequestPathCluster& cluster) {
-  auto centroid = cluster.centroid();
-  if (depth_to_centroid_indices_.find(centroid.depth()) == depth_to_centroid_indices_.end()) {
-    depth_to_centroid_indices_.emplace(centroid.depth(), std::vector<int64_t>());
-  }
-  depth_to_centroid_indices_[centroid.depth()].push_back(clusters_.size());
+  index_.Add(clusters_.size(), cluster.centroid());
   clusters_.push_back(cluster);
 }
 
 void RequestPathClustering::MergeCluster(int64_t cluster_index,
                                          const RequestPathCluster& other_cluster) {
+  RequestPath old_centroid = clusters_[cluster_index].centroid();
   clusters_[cluster_index].Merge(other_cluster);
+  // Merging only ever replaces centroid components with kAnyToken.
+  const auto& new_components = clusters_[cluster_index].centroid().path_components();
+  for (const auto& [i, path_component] : Enumerate(old_centroid.path_components())) {
+    if (path_component != new_components[i]) {
+      index_.Remove(cluster_index, old_centroid, i);
+    }
+  }
 }
 
 StatusOr<RequestPathClustering> RequestPathClustering::FromJSON(const std::string& json) {
@@ -272,9 +334,9 @@ std::string RequestPathClustering::ToJSON() const {
   return sb.GetString();
 }
 
-const RequestPath& RequestPathClustering::Predict(const RequestPath& request_path) {
+const RequestPath& RequestPathClustering::Predict(const RequestPath& request_path) const {
   int64_t closest_cluster_index;
-  MaxSimilarity(request_path, &closest_cluster_index);
+  index_.MaxSimilarity(request_path, &closest_cluster_index);
   if (closest_cluster_index == -1) {
     DCHECK(false) << absl::Substitute("Failed to find cluster close to request path $0",
                                       request_path.ToString());
@@ -285,7 +347,7 @@ const RequestPath& RequestPathClustering::Predict(const RequestPath& request_pat
 
 void RequestPathClustering::Update(const RequestPathCluster& new_cluster) {
   int64_t closest_cluster_index;
-  auto similarity = MaxSimilarity(new_cluster.centroid(), &closest_cluster_index);
+  auto similarity = index_.MaxSimilarity(new_cluster.centroid(), &closest_cluster_index);
   if (closest_cluster_index == -1 || similarity < thresh_) {
     AddNewCluster(new_cluster);
   } else {
@@ -306,15 +368,11 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
     }
   }
 
-  clusters_ = new_clusters;
-  // Rebuild depth_to_cluster_indices mapping.
-  depth_to_centroid_indices_.clear();
-  for (const auto& [cluster_idx, cluster] : Enumerate(clusters_)) {
-    auto depth = cluster.centroid().depth();
-    if (depth_to_centroid_indices_.find(depth) == depth_to_centroid_indices_.end()) {
-      depth_to_centroid_indices_.emplace(depth, std::vector<int64_t>());
-    }
-    depth_to_centroid_indices_[depth].push_back(cluster_idx);
+  clusters_.clear();
+  // Rebuild the index.
+  index_.Clear();
+  for (const auto& cluster : new_clusters) {
+    AddNewCluster(cluster);
   }
 
   for (const auto& cluster : other_clustering.clusters_) {
@@ -333,6 +391,32 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
   }
 }
 
+RequestPathClusteringCache& RequestPathClusteringCache::GetInstance() {
+  static RequestPathClusteringCache* cache = new RequestPathClusteringCache();
+  return *cache;
+}
+
+StatusOr<std::shared_ptr<const RequestPathClustering>> RequestPathClusteringCache::Get(
+    const std::string& serialized_clustering) {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = clusterings_.find(serialized_clustering);
+    if (it != clusterings_.end()) {
+      return it->second;
+    }
+  }
+  // Parse outside of the lock, a concurrent parse of the same clustering is harmless.
+  PL_ASSIGN_OR_RETURN(auto clustering, RequestPathClustering::FromJSON(serialized_clustering));
+  auto shared_clustering = std::make_shared<const RequestPathClustering>(std::move(clustering));
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (clusterings_.size() >= max_size_ && !clusterings_.contains(serialized_clustering)) {
+    clusterings_.erase(clusterings_.begin());
+  }
+  return clusterings_.try_emplace(serialized_clustering, std::move(shared_clustering))
+      .first->second;
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
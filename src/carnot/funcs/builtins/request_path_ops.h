@@ -20,6 +20,8 @@
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -174,6 +176,46 @@ class RequestPathCluster {
   absl::flat_hash_set<RequestPath> members_;
 };
 
+/**
+ * Indexes cluster centroids by their path components, so that the cluster most similar to a
+ * request path is found with one hash lookup per path component, instead of comparing the request
+ * path to every centroid of the same depth. kAnyToken components aren't indexed, since they never
+ * count towards similarity.
+ */
+class RequestPathClusterIndex {
+ public:
+  /**
+   * Adds a cluster to the index. Clusters must be added in increasing order of cluster_index.
+   */
+  void Add(int64_t cluster_index, const RequestPath& centroid);
+
+  /**
+   * Removes the i-th path component of a cluster's centroid from the index. Called when that
+   * component of the centroid is replaced by kAnyToken.
+   */
+  void Remove(int64_t cluster_index, const RequestPath& centroid, size_t i);
+
+  /**
+   * Same as comparing the request path to every indexed centroid with RequestPath::Similarity, and
+   * keeping the first cluster with the highest non-zero similarity.
+   * @param max_index set to the index of that cluster, or -1 if there is none.
+   * @return the similarity of that cluster.
+   */
+  double MaxSimilarity(const RequestPath& request_path, int64_t* max_index) const;
+
+  void Clear() { depths_.clear(); }
+
+ private:
+  struct DepthIndex {
+    // The clusters of this depth, in increasing order.
+    std::vector<int64_t> cluster_indices;
+    // For every path component position, maps the component to the offsets into cluster_indices
+    // of the clusters whose centroid has that component.
+    std::vector<absl::flat_hash_map<std::string, std::vector<int32_t>>> components;
+  };
+  absl::flat_hash_map<int64_t, DepthIndex> depths_;
+};
+
 class RequestPathClustering {
  public:
   static StatusOr<RequestPathClustering> FromJSON(const std::string& json);
@@ -184,7 +226,7 @@ class RequestPathClustering {
    * @param request_path request path to get prediction for.
    * @return the centroid of the cluster closest to the given request path.
    */
-  const RequestPath& Predict(const RequestPath& request_path);
+  const RequestPath& Predict(const RequestPath& request_path) const;
 
   /**
    * Updates the clustering given a new cluster to be added.
@@ -198,33 +240,59 @@ class RequestPathClustering {
   const std::vector<RequestPathCluster>& clusters() const { return clusters_; }
 
  private:
-  double MaxSimilarity(const RequestPath& request_path, int64_t* max_index) const;
   void AddNewCluster(const RequestPathCluster& cluster);
   void MergeCluster(int64_t cluster_index, const RequestPathCluster& other_cluster);
-  // We currently only allow request path's with the same depth to be clustered together.
-  absl::flat_hash_map<int64_t, std::vector<int64_t>> depth_to_centroid_indices_;
+  // We currently only allow request path's with the same depth to be clustered together, which
+  // the index takes care of.
+  RequestPathClusterIndex index_;
   std::vector<RequestPathCluster> clusters_;
   double thresh_ = 0.5;
 };
 
+/**
+ * Caches deserialized clusterings by their serialized form. Scripts that are rerun periodically
+ * pass the same clustering to _predict_request_path_cluster in every query and every UDF instance,
+ * so this avoids parsing and indexing it each time.
+ */
+class RequestPathClusteringCache {
+ public:
+  static constexpr size_t kDefaultMaxSize = 64;
+
+  static RequestPathClusteringCache& GetInstance();
+
+  explicit RequestPathClusteringCache(size_t max_size = kDefaultMaxSize) : max_size_(max_size) {}
+
+  StatusOr<std::shared_ptr<const RequestPathClustering>> Get(
+      const std::string& serialized_clustering);
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return clusterings_.size();
+  }
+
+ private:
+  const size_t max_size_;
+  std::mutex mu_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const RequestPathClustering>> clusterings_;
+};
+
 class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue request_path_str,
                    StringValue serialized_clustering) {
-    if (!clustering_init_) {
-      auto clustering_or_s = RequestPathClustering::FromJSON(serialized_clustering);
+    if (clustering_ == nullptr) {
+      auto clustering_or_s = RequestPathClusteringCache::GetInstance().Get(serialized_clustering);
       if (!clustering_or_s.ok()) {
         return clustering_or_s.msg();
       }
       clustering_ = clustering_or_s.ConsumeValueOrDie();
-      clustering_init_ = true;
     }
     auto request_path = RequestPath(request_path_str);
-    return clustering_.Predict(request_path).ToString();
+    return clustering_->Predict(request_path).ToString();
   }
 
-  RequestPathClustering clustering_;
-  bool clustering_init_ = false;
+ private:
+  std::shared_ptr<const RequestPathClustering> clustering_;
 };
 
 class RequestPathClusteringFitUDA : public udf::UDA {
@@ -19,6 +19,7 @@
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include <absl/strings/substitute.h>
 #include <algorithm>
 #include <vector>
 
@@ -93,6 +94,54 @@ TEST(RequestPathClusteringPredict, basic_low_cardinality) {
   udf_tester.ForInput("/a/b/c", serialized_clustering).Expect("/a/b/c");
 }
 
+TEST(RequestPathClusteringPredict, index_matches_linear_scan) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  for (int i = 0; i < 10; ++i) {
+    uda_tester.ForInput(absl::Substitute("/users/$0/orders", i))
+        .ForInput(absl::Substitute("/items/$0/reviews/$1", i, i % 3))
+        .ForInput(absl::Substitute("/svc$0/health", i % 4));
+  }
+  ASSERT_OK_AND_ASSIGN(auto clustering, RequestPathClustering::FromJSON(uda_tester.Result()));
+
+  for (const auto& path : {"/users/42/orders", "/items/7/reviews/2", "/svc1/health",
+                           "/svc9/health", "/users/3/carts", "/a/b/c/d/e"}) {
+    RequestPath request_path(path);
+    const RequestPath* expected = &request_path;
+    double max_similarity = 0.0;
+    for (const auto& cluster : clustering.clusters()) {
+      if (cluster.centroid().depth() != request_path.depth()) {
+        continue;
+      }
+      auto similarity = cluster.Similarity(request_path);
+      if (similarity > max_similarity) {
+        max_similarity = similarity;
+        expected = &cluster.Predict(request_path);
+      }
+    }
+    if (max_similarity == 0.0) {
+      continue;
+    }
+    EXPECT_EQ(expected->ToString(), clustering.Predict(request_path).ToString()) << path;
+  }
+}
+
+TEST(RequestPathClusteringPredict, cache_reuses_clustering) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  auto serialized_clustering = uda_tester.ForInput("/a/b/d").ForInput("/a/b/c").Result();
+
+  RequestPathClusteringCache cache(/*max_size*/ 1);
+  ASSERT_OK_AND_ASSIGN(auto clustering1, cache.Get(serialized_clustering));
+  ASSERT_OK_AND_ASSIGN(auto clustering2, cache.Get(serialized_clustering));
+  EXPECT_EQ(clustering1, clustering2);
+  EXPECT_EQ("/a/b/c", clustering1->Predict(RequestPath("/a/b/c")).ToString());
+  EXPECT_NOT_OK(cache.Get("not json"));
+  EXPECT_EQ(1UL, cache.size());
+
+  auto other_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  ASSERT_OK(cache.Get(other_tester.ForInput("/x/y").Result()));
+  EXPECT_EQ(1UL, cache.size());
+}
+
 TEST(RequestPathEndpointMatcher, basic) {
   auto udf_tester = udf::UDFTester<RequestPathEndpointMatcherUDF>();
   udf_tester.ForInput("/a/b/c", "/a/b/*").Expect(true);
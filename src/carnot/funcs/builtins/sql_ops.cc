@@ -75,7 +75,8 @@ types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue s
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_pgsql(query, param_values);
+  auto result_or_s = param_values.empty() ? cache_.Normalize(query)
+                                          : sql_parsing::normalize_pgsql(query, param_values);
   if (!result_or_s.ok()) {
     sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
@@ -105,7 +106,8 @@ types::StringValue NormalizeMySQLUDF::Exec(FunctionContext*, StringValue sql_str
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_mysql(query, param_values);
+  auto result_or_s = param_values.empty() ? cache_.Normalize(query)
+                                          : sql_parsing::normalize_mysql(query, param_values);
   if (!result_or_s.ok()) {
     sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
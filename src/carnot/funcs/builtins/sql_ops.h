@@ -22,6 +22,7 @@
 #include <regex>
 #include <string>
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/status.h"
 #include "src/common/base/utils.h"
@@ -59,6 +60,12 @@ class NormalizePostgresSQLUDF : public udf::ScalarUDF {
             "The normalized query with the values of the parameters in the query "
             "as JSON.");
   }
+
+ private:
+  // Query commands are normalized through a per-instance template cache, keyed by the query with
+  // its literals stripped out.
+  sql_parsing::NormalizationCache cache_{&sql_parsing::normalize_pgsql,
+                                         /*double_quoted_strings*/ false};
 };
 
 class NormalizeMySQLUDF : public udf::ScalarUDF {
@@ -84,6 +91,12 @@ class NormalizeMySQLUDF : public udf::ScalarUDF {
             "The normalized query with the values of the parameters in the query "
             "as JSON.");
   }
+
+ private:
+  // Query commands are normalized through a per-instance template cache, keyed by the query with
+  // its literals stripped out.
+  sql_parsing::NormalizationCache cache_{&sql_parsing::normalize_mysql,
+                                         /*double_quoted_strings*/ true};
 };
 
 void RegisterSQLOpsOrDie(udf::Registry* registry);
@@ -20,6 +20,7 @@
 
 #include <benchmark/benchmark.h>
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
 #include "src/common/perf/perf.h"
 
 // NOLINTNEXTLINE : runtime/references.
@@ -36,6 +37,15 @@ static void BM_NormalizeMySQL(benchmark::State& state, std::string query) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizePgSQLCached(benchmark::State& state, std::string query) {
+  px::carnot::builtins::sql_parsing::NormalizationCache cache(
+      &px::carnot::builtins::sql_parsing::normalize_pgsql, /*double_quoted_strings*/ false);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.Normalize(query));
+  }
+}
+
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select,
                   "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
 BENCHMARK_CAPTURE(BM_NormalizePgSQL, select_1, "SELECT 1");
@@ -72,3 +82,10 @@ BENCHMARK_CAPTURE(BM_NormalizeMySQL, sock_shop,
                   "JOIN sock_tag ON sock.sock_id=sock_tag.sock_id JOIN tag ON "
                   "sock_tag.tag_id=tag.tag_id "
                   "WHERE sock.sock_id =abcde GROUP BY sock.sock_id;");
+
+BENCHMARK_CAPTURE(BM_NormalizePgSQLCached, select,
+                  "SELECT * FROM test WHERE property=1234 AND property2='abcd'");
+BENCHMARK_CAPTURE(BM_NormalizePgSQLCached, update, "UPDATE test SET age=10 where name='abcd'");
+BENCHMARK_CAPTURE(
+    BM_NormalizePgSQLCached, insert_into,
+    R"(INSERT INTO test (a, b, c, d, e) VALUES (1, 'abcd', 1.23, true, E'\\xDEADBEEF'))");
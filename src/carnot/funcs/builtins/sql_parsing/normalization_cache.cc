@@ -0,0 +1,148 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
+
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+namespace {
+
+bool IsIdentifierChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+         c == '$';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Returns the end of the quoted string starting at pos, where a doubled quote is an escaped quote.
+size_t QuotedEnd(std::string_view query, size_t pos) {
+  char quote = query[pos];
+  size_t i = pos + 1;
+  while (i < query.size()) {
+    if (query[i] == quote) {
+      if (i + 1 < query.size() && query[i + 1] == quote) {
+        i += 2;
+        continue;
+      }
+      return i + 1;
+    }
+    ++i;
+  }
+  // Unterminated, the rest of the query is the literal.
+  return query.size();
+}
+
+// Returns the end of the number starting at pos: digits with an optional fraction and exponent.
+size_t NumberEnd(std::string_view query, size_t pos) {
+  size_t i = pos;
+  while (i < query.size() && (IsDigit(query[i]) || query[i] == '.')) {
+    ++i;
+  }
+  if (i < query.size() && (query[i] == 'e' || query[i] == 'E')) {
+    size_t exp = i + 1;
+    if (exp < query.size() && (query[exp] == '+' || query[exp] == '-')) {
+      ++exp;
+    }
+    if (exp < query.size() && IsDigit(query[exp])) {
+      i = exp;
+      while (i < query.size() && IsDigit(query[i])) {
+        ++i;
+      }
+    }
+  }
+  return i;
+}
+
+}  // namespace
+
+bool FingerprintQuery(std::string_view query, bool double_quoted_strings,
+                      QueryFingerprint* fingerprint) {
+  fingerprint->stripped.clear();
+  fingerprint->literals.clear();
+  fingerprint->stripped.reserve(query.size());
+
+  size_t pos = 0;
+  while (pos < query.size()) {
+    char c = query[pos];
+    size_t end = pos;
+    if (c == '\'' || (c == '"' && double_quoted_strings)) {
+      end = QuotedEnd(query, pos);
+    } else if (IsDigit(c) && (pos == 0 || !IsIdentifierChar(query[pos - 1]))) {
+      end = NumberEnd(query, pos);
+    } else if (c == QueryFingerprint::kLiteralMarker) {
+      return false;
+    }
+
+    if (end == pos) {
+      fingerprint->stripped.push_back(c);
+      ++pos;
+      continue;
+    }
+    fingerprint->literals.emplace_back(query.substr(pos, end - pos));
+    fingerprint->stripped.push_back(QueryFingerprint::kLiteralMarker);
+    pos = end;
+  }
+  return true;
+}
+
+StatusOr<NormalizeResult> NormalizationCache::Normalize(const std::string& query) {
+  if (!FingerprintQuery(query, double_quoted_strings_, &fingerprint_)) {
+    return normalize_fn_(query, {});
+  }
+
+  auto it = templates_.find(fingerprint_.stripped);
+  if (it != templates_.end()) {
+    if (!it->second.cacheable) {
+      return normalize_fn_(query, {});
+    }
+    ++hits_;
+    NormalizeResult result;
+    result.normalized_query = it->second.normalized_query;
+    result.params = fingerprint_.literals;
+    return result;
+  }
+
+  ++misses_;
+  auto result_or_s = normalize_fn_(query, {});
+  if (!result_or_s.ok() || !result_or_s.ValueOrDie().errmsg.empty()) {
+    // Errors aren't cached, they may depend on more than the fingerprint.
+    return result_or_s;
+  }
+  // The cache is reset when full, so that it follows the statements that are currently seen.
+  if (templates_.size() >= max_size_) {
+    templates_.clear();
+  }
+  const auto& result = result_or_s.ValueOrDie();
+  Template tmpl;
+  tmpl.cacheable = result.params == fingerprint_.literals;
+  if (tmpl.cacheable) {
+    tmpl.normalized_query = result.normalized_query;
+  }
+  templates_.emplace(std::move(fingerprint_.stripped), std::move(tmpl));
+  return result_or_s;
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/common/base/statusor.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+/**
+ * The result of a quick lexical pass over a query, which cuts every string and numeric literal
+ * out of it. Queries that only differ in their literals have the same stripped text.
+ */
+struct QueryFingerprint {
+  // The query with every literal replaced by kLiteralMarker.
+  std::string stripped;
+  // The text of the literals, in the order they appear in the query.
+  std::vector<std::string> literals;
+
+  static constexpr char kLiteralMarker = '\x01';
+};
+
+/**
+ * Fingerprints the query. Single quoted strings (with '' escapes) and numbers that don't start
+ * inside an identifier are treated as literals. Double quoted strings are treated as literals
+ * too if double_quoted_strings is set (MySQL), and are otherwise part of the text (Postgres quoted
+ * identifiers). Returns false if the query contains kLiteralMarker itself.
+ */
+bool FingerprintQuery(std::string_view query, bool double_quoted_strings,
+                      QueryFingerprint* fingerprint);
+
+/**
+ * Caches normalized query templates by query fingerprint, so that the full parser only runs the
+ * first time a statement is seen. For a cached statement, the template is reused and the params
+ * are the literals found by the fingerprint.
+ *
+ * A template is only cached if the parser replaced exactly the literals found by the fingerprint.
+ * Otherwise (e.g. for constants like TRUE or negative numbers, or numbers that aren't constants)
+ * the statement is marked as uncacheable and always goes through the parser.
+ */
+class NormalizationCache {
+ public:
+  using NormalizeFn = StatusOr<NormalizeResult> (*)(std::string,
+                                                    const std::vector<std::string>&);
+  static constexpr size_t kDefaultMaxSize = 1024;
+
+  NormalizationCache(NormalizeFn normalize_fn, bool double_quoted_strings,
+                     size_t max_size = kDefaultMaxSize)
+      : normalize_fn_(normalize_fn),
+        double_quoted_strings_(double_quoted_strings),
+        max_size_(max_size) {}
+
+  /**
+   * Normalizes a query that has no parameter values.
+   */
+  StatusOr<NormalizeResult> Normalize(const std::string& query);
+
+  size_t size() const { return templates_.size(); }
+  int64_t hits() const { return hits_; }
+  int64_t misses() const { return misses_; }
+
+ private:
+  struct Template {
+    bool cacheable = false;
+    std::string normalized_query;
+  };
+
+  NormalizeFn normalize_fn_;
+  bool double_quoted_strings_;
+  size_t max_size_;
+  absl::flat_hash_map<std::string, Template> templates_;
+  // Reused across calls to avoid reallocating.
+  QueryFingerprint fingerprint_;
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+};
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
+#include "src/common/base/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+using ::testing::ElementsAre;
+
+TEST(FingerprintQueryTest, strips_literals) {
+  QueryFingerprint fingerprint;
+  ASSERT_TRUE(FingerprintQuery("SELECT a1 FROM t2 WHERE x=12.5e3 AND y='it''s' AND z=\"q\"",
+                               /*double_quoted_strings*/ false, &fingerprint));
+  EXPECT_EQ(fingerprint.stripped, "SELECT a1 FROM t2 WHERE x=\x01 AND y=\x01 AND z=\"q\"");
+  EXPECT_THAT(fingerprint.literals, ElementsAre("12.5e3", "'it''s'"));
+
+  ASSERT_TRUE(FingerprintQuery("SELECT * FROM t WHERE z=\"q\"", /*double_quoted_strings*/ true,
+                               &fingerprint));
+  EXPECT_EQ(fingerprint.stripped, "SELECT * FROM t WHERE z=\x01");
+  EXPECT_THAT(fingerprint.literals, ElementsAre("\"q\""));
+
+  EXPECT_FALSE(FingerprintQuery("SELECT \x01", /*double_quoted_strings*/ false, &fingerprint));
+}
+
+TEST(NormalizationCacheTest, pgsql_reuses_template) {
+  NormalizationCache cache(&normalize_pgsql, /*double_quoted_strings*/ false);
+
+  for (const auto& [query, params] : std::vector<std::pair<std::string, std::vector<std::string>>>{
+           {"SELECT * FROM test WHERE prop=1234 AND prop2='abcd'", {"1234", "'abcd'"}},
+           {"SELECT * FROM test WHERE prop=5 AND prop2='efgh'", {"5", "'efgh'"}},
+       }) {
+    ASSERT_OK_AND_ASSIGN(auto result, cache.Normalize(query));
+    EXPECT_EQ(result.normalized_query, "SELECT * FROM test WHERE prop=$1 AND prop2=$2");
+    EXPECT_EQ(result.params, params);
+    EXPECT_EQ(result.errmsg, "");
+
+    ASSERT_OK_AND_ASSIGN(auto expected, normalize_pgsql(query, {}));
+    EXPECT_EQ(result.normalized_query, expected.normalized_query);
+    EXPECT_EQ(result.params, expected.params);
+  }
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_EQ(cache.hits(), 1);
+}
+
+TEST(NormalizationCacheTest, mysql_reuses_template) {
+  NormalizationCache cache(&normalize_mysql, /*double_quoted_strings*/ true);
+
+  for (const auto& query : {"SELECT * FROM test WHERE prop=1234 AND prop2=\"abcd\"",
+                            "SELECT * FROM test WHERE prop=98 AND prop2=\"x\""}) {
+    ASSERT_OK_AND_ASSIGN(auto result, cache.Normalize(query));
+    ASSERT_OK_AND_ASSIGN(auto expected, normalize_mysql(query, {}));
+    EXPECT_EQ(result.normalized_query, expected.normalized_query);
+    EXPECT_EQ(result.params, expected.params);
+  }
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_EQ(cache.hits(), 1);
+}
+
+TEST(NormalizationCacheTest, uncacheable_statement_uses_parser) {
+  NormalizationCache cache(&normalize_pgsql, /*double_quoted_strings*/ false);
+
+  // The parser's params (true) don't match the literals found by the fingerprint.
+  for (const auto& query : {"SELECT * FROM test WHERE prop=true AND id=1",
+                            "SELECT * FROM test WHERE prop=true AND id=2"}) {
+    ASSERT_OK_AND_ASSIGN(auto result, cache.Normalize(query));
+    ASSERT_OK_AND_ASSIGN(auto expected, normalize_pgsql(query, {}));
+    EXPECT_EQ(result.normalized_query, expected.normalized_query);
+    EXPECT_EQ(result.params, expected.params);
+  }
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(NormalizationCacheTest, resets_when_full) {
+  NormalizationCache cache(&normalize_pgsql, /*double_quoted_strings*/ false, /*max_size*/ 2);
+  for (const auto& query : {"SELECT a FROM t WHERE x=1", "SELECT b FROM t WHERE x=1",
+                            "SELECT c FROM t WHERE x=1"}) {
+    ASSERT_OK(cache.Normalize(query));
+  }
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.misses(), 3);
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
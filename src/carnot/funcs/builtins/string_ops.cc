@@ -16,6 +16,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <cstring>
+#include <string>
+
 #include "src/carnot/funcs/builtins/string_ops.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
@@ -24,6 +27,57 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+size_t FindSubstring(std::string_view haystack, std::string_view needle) {
+  if (needle.empty()) {
+    return 0;
+  }
+  if (needle.size() > haystack.size()) {
+    return std::string_view::npos;
+  }
+  const char first = needle.front();
+  const char last = needle.back();
+  const char* begin = haystack.data();
+  // The last position the needle can start at.
+  const char* end = begin + (haystack.size() - needle.size());
+  const char* pos = begin;
+  while (pos <= end) {
+    pos = static_cast<const char*>(std::memchr(pos, first, end - pos + 1));
+    if (pos == nullptr) {
+      return std::string_view::npos;
+    }
+    if (pos[needle.size() - 1] == last &&
+        std::memcmp(pos + 1, needle.data() + 1, needle.size() - 1) == 0) {
+      return pos - begin;
+    }
+    ++pos;
+  }
+  return std::string_view::npos;
+}
+
+Status AppendAsciiCaseConverted(const arrow::StringArray& input, size_t count, bool to_upper,
+                                arrow::StringBuilder* out) {
+  int64_t data_bytes = StringDataBytes(input, count);
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  PL_RETURN_IF_ERROR(out->ReserveData(data_bytes));
+  if (count == 0) {
+    return Status::OK();
+  }
+
+  // Converting the whole data buffer at once keeps the loop free of branches, so the compiler
+  // can vectorize it.
+  const int64_t data_start = input.value_offset(0);
+  std::string converted(StringViewAt(input, 0).data(), data_bytes);
+  const char range_start = to_upper ? 'a' : 'A';
+  for (char& c : converted) {
+    c ^= static_cast<char>((static_cast<unsigned char>(c - range_start) < 26) << 5);
+  }
+  for (size_t idx = 0; idx < count; ++idx) {
+    out->UnsafeAppend(converted.data() + input.value_offset(idx) - data_start,
+                      input.value_length(idx));
+  }
+  return Status::OK();
+}
+
 void RegisterStringOpsOrDie(udf::Registry* registry) {
   CHECK(registry != nullptr);
   /*****************************************
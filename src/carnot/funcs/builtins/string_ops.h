@@ -18,9 +18,13 @@
 
 #pragma once
 
+#include <absl/strings/ascii.h>
 #include <absl/strings/strip.h>
+#include <arrow/array.h>
+#include <arrow/builder.h>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
@@ -29,12 +33,71 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+/*
+ * Helpers for the ExecBatch functions of the string UDFs, which work directly on the
+ * offsets and data of the arrow string arrays instead of copying every value into a
+ * StringValue.
+ */
+
+inline std::string_view StringViewAt(const arrow::StringArray& arr, int64_t idx) {
+  auto view = arr.GetView(idx);
+  return std::string_view(view.data(), view.size());
+}
+
+/**
+ * Returns the position of the first occurrence of needle in haystack, or npos. Candidate
+ * positions are found by scanning for the first byte of the needle with memchr (which libc
+ * vectorizes), and the last byte is checked before the rest of the needle is compared.
+ */
+size_t FindSubstring(std::string_view haystack, std::string_view needle);
+
+/**
+ * Appends the first count strings of the input to the output, with every ascii letter converted
+ * to lower (or upper) case. The conversion runs on the data buffer of the array as a whole.
+ */
+Status AppendAsciiCaseConverted(const arrow::StringArray& input, size_t count, bool to_upper,
+                                arrow::StringBuilder* out);
+
+/**
+ * Appends view_fn(idx) for the first count rows to the output. The views must add up to at most
+ * max_data_bytes, which are reserved up front.
+ */
+template <typename TViewFn>
+Status AppendStringViews(size_t count, int64_t max_data_bytes, arrow::StringBuilder* out,
+                         TViewFn view_fn) {
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  PL_RETURN_IF_ERROR(out->ReserveData(max_data_bytes));
+  for (size_t idx = 0; idx < count; ++idx) {
+    std::string_view view = view_fn(idx);
+    out->UnsafeAppend(view.data(), static_cast<int32_t>(view.size()));
+  }
+  return Status::OK();
+}
+
+// The number of data bytes of the first count strings of the array.
+inline int64_t StringDataBytes(const arrow::StringArray& arr, size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  return arr.value_offset(count - 1) + arr.value_length(count - 1) - arr.value_offset(0);
+}
+
 class ContainsUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, StringValue b1, StringValue b2) {
     return absl::StrContains(b1, b2);
   }
 
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& b1, const arrow::StringArray& b2,
+                   arrow::BooleanBuilder* out, size_t count) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(FindSubstring(StringViewAt(b1, idx), StringViewAt(b2, idx)) !=
+                        std::string_view::npos);
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the first string contains the second string.")
         .Example("matching_df = matching_df[px.contains(matching_df.svc_names, 'my_svc')]")
@@ -47,6 +110,14 @@ class ContainsUDF : public udf::ScalarUDF {
 class LengthUDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue b1) { return b1.length(); }
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& b1, arrow::Int64Builder* out,
+                   size_t count) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(b1.value_length(idx));
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns the length of the string")
         .Example(R"doc(df.service = 'checkout'
@@ -63,6 +134,17 @@ class FindUDF : public udf::ScalarUDF {
     return src.find(substr);
   }
 
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& src,
+                   const arrow::StringArray& substr, arrow::Int64Builder* out, size_t count) {
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (size_t idx = 0; idx < count; ++idx) {
+      // npos wraps around to -1, same as in Exec.
+      out->UnsafeAppend(
+          static_cast<int64_t>(FindSubstring(StringViewAt(src, idx), StringViewAt(substr, idx))));
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Find the index of the first occurrence of the substring.")
         .Details(
@@ -108,6 +190,10 @@ class ToLowerUDF : public udf::ScalarUDF {
     transform(b1.begin(), b1.end(), b1.begin(), ::tolower);
     return b1;
   }
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& b1, arrow::StringBuilder* out,
+                   size_t count) {
+    return AppendAsciiCaseConverted(b1, count, /* to_upper */ false, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all uppercase ascii characters in the string to lowercase.")
@@ -125,6 +211,10 @@ class ToUpperUDF : public udf::ScalarUDF {
     transform(b1.begin(), b1.end(), b1.begin(), ::toupper);
     return b1;
   }
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& b1, arrow::StringBuilder* out,
+                   size_t count) {
+    return AppendAsciiCaseConverted(b1, count, /* to_upper */ true, out);
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Transforms all lowercase ascii characters in the string to uppercase.")
@@ -143,6 +233,12 @@ class TrimUDF : public udf::ScalarUDF {
     absl::StripAsciiWhitespace(&val);
     return val;
   }
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& s, arrow::StringBuilder* out,
+                   size_t count) {
+    return AppendStringViews(count, StringDataBytes(s, count), out, [&](size_t idx) {
+      return absl::StripAsciiWhitespace(StringViewAt(s, idx));
+    });
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Trim ascii whitespace from before and after the string content.")
@@ -162,6 +258,12 @@ class StripPrefixUDF : public udf::ScalarUDF {
   StringValue Exec(FunctionContext*, StringValue prefix, StringValue s) {
     return StringValue(absl::StripPrefix(s, prefix));
   }
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& prefix, const arrow::StringArray& s,
+                   arrow::StringBuilder* out, size_t count) {
+    return AppendStringViews(count, StringDataBytes(s, count), out, [&](size_t idx) {
+      return absl::StripPrefix(StringViewAt(s, idx), StringViewAt(prefix, idx));
+    });
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Strips the specified prefix from the string.")
         .Details(
@@ -17,13 +17,17 @@
  */
 
 #include <gtest/gtest.h>
+#include <memory>
 #include <numeric>
 #include <type_traits>
 #include <vector>
 
 #include "src/carnot/funcs/builtins/string_ops.h"
 #include "src/carnot/udf/test_utils.h"
+#include "src/carnot/udf/udf_wrapper.h"
 #include "src/common/base/base.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
 
 namespace px {
 namespace carnot {
@@ -103,6 +107,70 @@ TEST(StringOps, BytesToHex) {
   udf_tester.ForInput("abc").Expect(R"(\x61\x62\x63)");
 }
 
+// Runs the ExecBatch of the UDF on the arrays and checks that every row matches Exec.
+template <typename TUDF, typename... TArgs>
+void ExpectExecBatchMatchesExec(const std::vector<std::shared_ptr<arrow::Array>>& inputs,
+                                const std::vector<TArgs>&... args) {
+  static_assert(udf::ScalarUDFTraits<TUDF>::HasExecBatch());
+  constexpr auto return_type = udf::ScalarUDFTraits<TUDF>::ReturnType();
+  int64_t count = inputs[0]->length();
+  std::vector<arrow::Array*> raw_inputs;
+  for (const auto& input : inputs) {
+    raw_inputs.push_back(input.get());
+  }
+
+  TUDF u;
+  auto builder = types::MakeArrowBuilder(return_type, arrow::default_memory_pool());
+  ASSERT_OK(udf::ScalarUDFWrapper<TUDF>::ExecBatchArrow(&u, nullptr, raw_inputs, builder.get(),
+                                                        count));
+  std::shared_ptr<arrow::Array> out;
+  ASSERT_TRUE(builder->Finish(&out).ok());
+  ASSERT_EQ(count, out->length());
+
+  // The inputs may be slices of the argument vectors.
+  int64_t offset = inputs[0]->offset();
+  for (int64_t idx = 0; idx < count; ++idx) {
+    EXPECT_EQ(udf::UnWrap(u.Exec(nullptr, args[offset + idx]...)),
+              types::GetValueFromArrowArray<return_type>(out.get(), idx))
+        << "row " << idx;
+  }
+}
+
+TEST(StringOps, exec_batch_matches_exec) {
+  std::vector<types::StringValue> strs = {"apple",    "",          "pixielabs", "aab",
+                                          "  PiXiE ", "abcabcabd", "\xc3\x84x", "Zz@[`{"};
+  std::vector<types::StringValue> substrs = {"pl", "", "labs", "ab", "PiX", "abd", "x", "zz"};
+  auto strs_arr = types::ToArrow(strs, arrow::default_memory_pool());
+  auto substrs_arr = types::ToArrow(substrs, arrow::default_memory_pool());
+
+  for (int64_t offset : {0, 3}) {
+    std::vector<std::shared_ptr<arrow::Array>> one_arg = {strs_arr->Slice(offset)};
+    ExpectExecBatchMatchesExec<LengthUDF>(one_arg, strs);
+    ExpectExecBatchMatchesExec<ToLowerUDF>(one_arg, strs);
+    ExpectExecBatchMatchesExec<ToUpperUDF>(one_arg, strs);
+    ExpectExecBatchMatchesExec<TrimUDF>(one_arg, strs);
+
+    std::vector<std::shared_ptr<arrow::Array>> two_args = {strs_arr->Slice(offset),
+                                                           substrs_arr->Slice(offset)};
+    ExpectExecBatchMatchesExec<ContainsUDF>(two_args, strs, substrs);
+    ExpectExecBatchMatchesExec<FindUDF>(two_args, strs, substrs);
+    std::vector<std::shared_ptr<arrow::Array>> prefix_args = {substrs_arr->Slice(offset),
+                                                              strs_arr->Slice(offset)};
+    ExpectExecBatchMatchesExec<StripPrefixUDF>(prefix_args, substrs, strs);
+  }
+}
+
+TEST(StringOps, find_substring) {
+  EXPECT_EQ(0, FindSubstring("abc", ""));
+  EXPECT_EQ(0, FindSubstring("", ""));
+  EXPECT_EQ(std::string_view::npos, FindSubstring("", "a"));
+  EXPECT_EQ(std::string_view::npos, FindSubstring("ab", "abc"));
+  EXPECT_EQ(2, FindSubstring("aaab", "ab"));
+  EXPECT_EQ(3, FindSubstring("abaabb", "abb"));
+  EXPECT_EQ(4, FindSubstring("xxxxa", "a"));
+  EXPECT_EQ(std::string_view::npos, FindSubstring("axxxb", "ab"));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -33,6 +33,7 @@ void RegisterHTTPOpsOrDie(px::carnot::udf::Registry* registry) {
    * Scalar UDFs.
    *****************************************/
   registry->RegisterOrDie<HTTPRespMessageUDF>("http_resp_message");
+  registry->RegisterOrDie<GRPCBodyToTextUDF>("grpc_body_to_text");
 
   /*****************************************
    * Aggregate UDFs.
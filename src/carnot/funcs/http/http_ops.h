@@ -20,9 +20,12 @@
 
 #include <string>
 
+#include <absl/strings/escaping.h>
+
 #include "src/carnot/funcs/http/http.h"
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/type_inference.h"
+#include "src/common/grpcutils/pb_text.h"
 #include "src/shared/types/types.h"
 
 namespace px {
@@ -45,6 +48,35 @@ class HTTPRespMessageUDF : public px::carnot::udf::ScalarUDF {
   }
 };
 
+class GRPCBodyToTextUDF : public px::carnot::udf::ScalarUDF {
+ public:
+  // String and bytes fields are truncated to this length in the text format.
+  static constexpr int kMaxPBStringLen = 64;
+
+  StringValue Exec(FunctionContext*, StringValue body) {
+    std::string pb;
+    if (!absl::Base64Unescape(body, &pb)) {
+      return "<Failed to decode base64>";
+    }
+    return px::grpc::ParsePB(pb, kMaxPBStringLen);
+  }
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Convert a gRPC message body to text format protobuf.")
+        .Details(
+            "The req_body_raw and resp_body_raw columns hold gRPC bodies as base64 of the "
+            "serialized protobuf. This UDF decodes the length-prefixed messages of such a body "
+            "into text format protobuf. The message types are not known, so fields are printed by "
+            "their field numbers, and string fields longer than 64 characters are truncated. "
+            "Bodies that are truncated are decoded as far as possible.")
+        .Arg("body", "The base64 of a serialized gRPC body, e.g. the req_body_raw column.")
+        .Example(
+            "df = df[df.req_body_raw != '']\n"
+            "df.req_body = px.grpc_body_to_text(df.req_body_raw)")
+        .Returns("The body in text format protobuf, or an error message if it can't be parsed.");
+  }
+};
+
 void RegisterHTTPOpsOrDie(px::carnot::udf::Registry* registry);
 
 }  // namespace http
@@ -33,6 +33,17 @@ TEST(HTTPOps, basic) {
   udf_tester.ForInput(0).Expect("Unassigned");
 }
 
+TEST(HTTPOps, grpc_body_to_text) {
+  auto udf_tester = udf::UDFTester<GRPCBodyToTextUDF>();
+  // Two length-prefixed messages, each with field 1 set to "Hello world".
+  std::string body = absl::StrCat(
+      std::string_view("\x00\x00\x00\x00\x0D\x0A\x0BHello world", 18),
+      std::string_view("\x00\x00\x00\x00\x0D\x0A\x0BHello world", 18));
+  udf_tester.ForInput(absl::Base64Escape(body)).Expect("1: \"Hello world\"\n1: \"Hello world\"");
+  udf_tester.ForInput(absl::Base64Escape("abc")).Expect("<Failed to parse protobuf>");
+  udf_tester.ForInput("not base64!").Expect("<Failed to decode base64>");
+}
+
 }  // namespace http
 }  // namespace funcs
 }  // namespace carnot
@@ -24,12 +24,16 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/type_inference.h"
 #include "src/shared/metadata/metadata_state.h"
+#include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/types.h"
 
 namespace px {
@@ -62,6 +66,89 @@ inline const px::md::AgentMetadataState* GetMetadataState(px::carnot::udf::Funct
   return md;
 }
 
+/**
+ * Base class of the UDFs that map a UPID to a string. UPID columns usually hold a few dozen
+ * distinct processes repeated across the whole batch, so the batch version runs the Exec of the
+ * UDF once per distinct UPID of the batch and reuses the result for the other rows. Results are
+ * not kept across batches, since the metadata state may be updated between them.
+ */
+template <typename TUDF>
+class MemoizedUPIDUDF : public ScalarUDF {
+ public:
+  Status ExecBatch(FunctionContext* ctx, const arrow::UInt128Array& upids,
+                   arrow::StringBuilder* out, size_t count) {
+    distinct_idx_.clear();
+    distinct_results_.clear();
+    row_results_.resize(count);
+
+    int64_t data_bytes = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+      UInt128Value upid = types::GetValueFromArrowArray<types::DataType::UINT128>(&upids, idx);
+      auto [it, inserted] = distinct_idx_.try_emplace(upid.val, distinct_results_.size());
+      if (inserted) {
+        distinct_results_.push_back(static_cast<TUDF*>(this)->Exec(ctx, upid));
+      }
+      row_results_[idx] = it->second;
+      data_bytes += distinct_results_[it->second].size();
+    }
+
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    PL_RETURN_IF_ERROR(out->ReserveData(data_bytes));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(distinct_results_[row_results_[idx]]);
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Scratch space of ExecBatch, kept to reuse the allocations across batches.
+  absl::flat_hash_map<absl::uint128, size_t> distinct_idx_;
+  std::vector<std::string> distinct_results_;
+  std::vector<size_t> row_results_;
+};
+
+/**
+ * Base class of the UDFs that map an IP address to a string. Address columns such as remote_addr
+ * hold the same few pod IPs over and over, so like MemoizedUPIDUDF, the batch version looks up each
+ * distinct address of the batch once. The keys point into the input array, so they are only valid
+ * during a call.
+ */
+template <typename TUDF>
+class MemoizedIPUDF : public ScalarUDF {
+ public:
+  Status ExecBatch(FunctionContext* ctx, const arrow::StringArray& addrs,
+                   arrow::StringBuilder* out, size_t count) {
+    distinct_idx_.clear();
+    distinct_results_.clear();
+    row_results_.resize(count);
+
+    int64_t data_bytes = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto addr = addrs.GetView(idx);
+      std::string_view key(addr.data(), addr.size());
+      auto [it, inserted] = distinct_idx_.try_emplace(key, distinct_results_.size());
+      if (inserted) {
+        distinct_results_.push_back(static_cast<TUDF*>(this)->Exec(ctx, std::string(key)));
+      }
+      row_results_[idx] = it->second;
+      data_bytes += distinct_results_[it->second].size();
+    }
+
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    PL_RETURN_IF_ERROR(out->ReserveData(data_bytes));
+    for (size_t idx = 0; idx < count; ++idx) {
+      out->UnsafeAppend(distinct_results_[row_results_[idx]]);
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Scratch space of ExecBatch, kept to reuse the allocations across batches.
+  absl::flat_hash_map<std::string_view, size_t> distinct_idx_;
+  std::vector<std::string> distinct_results_;
+  std::vector<size_t> row_results_;
+};
+
 class ASIDUDF : public ScalarUDF {
  public:
   Int64Value Exec(FunctionContext* ctx) {
@@ -211,7 +298,7 @@ class PodNameToNamespaceUDF : public ScalarUDF {
   }
 };
 
-class UPIDToContainerIDUDF : public ScalarUDF {
+class UPIDToContainerIDUDF : public MemoizedUPIDUDF<UPIDToContainerIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -252,7 +339,7 @@ inline const md::ContainerInfo* UPIDToContainer(const px::md::AgentMetadataState
   return md->k8s_metadata_state().ContainerInfoByID(pid->cid());
 }
 
-class UPIDToContainerNameUDF : public ScalarUDF {
+class UPIDToContainerNameUDF : public MemoizedUPIDUDF<UPIDToContainerNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -311,7 +398,7 @@ inline types::StringValue StringifyVector(const std::vector<std::string>& vec) {
   return "";
 }
 
-class UPIDToNamespaceUDF : public ScalarUDF {
+class UPIDToNamespaceUDF : public MemoizedUPIDUDF<UPIDToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -343,7 +430,7 @@ class UPIDToNamespaceUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodIDUDF : public ScalarUDF {
+class UPIDToPodIDUDF : public MemoizedUPIDUDF<UPIDToPodIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -370,7 +457,7 @@ class UPIDToPodIDUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodNameUDF : public ScalarUDF {
+class UPIDToPodNameUDF : public MemoizedUPIDUDF<UPIDToPodNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -481,7 +568,7 @@ class ServiceNameToNamespaceUDF : public ScalarUDF {
 /**
  * @brief Returns the service ids for services that are currently running.
  */
-class UPIDToServiceIDUDF : public ScalarUDF {
+class UPIDToServiceIDUDF : public MemoizedUPIDUDF<UPIDToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -523,7 +610,7 @@ class UPIDToServiceIDUDF : public ScalarUDF {
 /**
  * @brief Returns the service names for services that are currently running.
  */
-class UPIDToServiceNameUDF : public ScalarUDF {
+class UPIDToServiceNameUDF : public MemoizedUPIDUDF<UPIDToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -569,7 +656,7 @@ class UPIDToServiceNameUDF : public ScalarUDF {
 /**
  * @brief Returns the node name for the pod associated with the input upid.
  */
-class UPIDToNodeNameUDF : public ScalarUDF {
+class UPIDToNodeNameUDF : public MemoizedUPIDUDF<UPIDToNodeNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -601,7 +688,7 @@ class UPIDToNodeNameUDF : public ScalarUDF {
 /**
  * @brief Returns the hostname for the pod associated with the input upid.
  */
-class UPIDToHostnameUDF : public ScalarUDF {
+class UPIDToHostnameUDF : public MemoizedUPIDUDF<UPIDToHostnameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -819,7 +906,7 @@ class PodNameToServiceIDUDF : public ScalarUDF {
   }
 };
 
-class UPIDToStringUDF : public ScalarUDF {
+class UPIDToStringUDF : public MemoizedUPIDUDF<UPIDToStringUDF> {
  public:
   StringValue Exec(FunctionContext*, UInt128Value upid_value) {
     auto upid_uint128 = absl::MakeUint128(upid_value.High64(), upid_value.Low64());
@@ -1261,7 +1348,7 @@ class ContainerIDToContainerStatusUDF : public ScalarUDF {
   }
 };
 
-class UPIDToPodStatusUDF : public ScalarUDF {
+class UPIDToPodStatusUDF : public MemoizedUPIDUDF<UPIDToPodStatusUDF> {
  public:
   /**
    * @brief Gets the Pod status for a passed in UPID.
@@ -1300,7 +1387,7 @@ class UPIDToPodStatusUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToCmdLineUDF : public ScalarUDF {
+class UPIDToCmdLineUDF : public MemoizedUPIDUDF<UPIDToCmdLineUDF> {
  public:
   /**
    * @brief Gets the cmdline for the upid.
@@ -1341,7 +1428,7 @@ inline std::string PodInfoToPodQoS(const px::md::PodInfo* pod_info) {
   return std::string(magic_enum::enum_name(pod_info->qos_class()));
 }
 
-class UPIDToPodQoSUDF : public ScalarUDF {
+class UPIDToPodQoSUDF : public MemoizedUPIDUDF<UPIDToPodQoSUDF> {
  public:
   /**
    * @brief Gets the qos for the upid's pod.
@@ -1408,7 +1495,7 @@ class HostNumCPUsUDF : public ScalarUDF {
   }
 };
 
-class PodIPToPodIDUDF : public ScalarUDF {
+class PodIPToPodIDUDF : public MemoizedIPUDF<PodIPToPodIDUDF> {
  public:
   /**
    * @brief Gets the pod id of pod with given pod_ip
@@ -1441,7 +1528,7 @@ class PodIPToPodIDUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_KELVIN; }
 };
 
-class PodIPToServiceIDUDF : public ScalarUDF {
+class PodIPToServiceIDUDF : public MemoizedIPUDF<PodIPToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, StringValue pod_ip) {
     auto md = GetMetadataState(ctx);
@@ -32,6 +32,7 @@
 #include "src/shared/metadata/pids.h"
 #include "src/shared/metadata/state_manager.h"
 #include "src/shared/metadata/test_utils.h"
+#include "src/shared/types/arrow_adapter.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
@@ -131,6 +132,31 @@ TEST_F(MetadataOpsTest, upid_to_pod_name_test) {
   udf_tester.ForInput(upid3).Expect("");
 }
 
+TEST_F(MetadataOpsTest, upid_exec_batch_matches_exec) {
+  auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
+  auto upid1 = types::UInt128Value(528280977975, 89101);
+  auto upid2 = types::UInt128Value(528280977975, 468);
+  auto missing = types::UInt128Value(528280977975, 123);
+  std::vector<types::UInt128Value> upids = {upid1, upid2, upid1, missing, upid2, upid1};
+  auto upids_arr = types::ToArrow(upids, arrow::default_memory_pool());
+
+  UPIDToPodNameUDF udf;
+  arrow::StringBuilder builder;
+  // Run twice to check that no results are carried over from the previous batch.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK(udf.ExecBatch(function_ctx.get(),
+                            *static_cast<arrow::UInt128Array*>(upids_arr.get()), &builder,
+                            upids.size()));
+    std::shared_ptr<arrow::Array> out;
+    ASSERT_TRUE(builder.Finish(&out).ok());
+    ASSERT_EQ(out->length(), static_cast<int64_t>(upids.size()));
+    auto out_strs = static_cast<arrow::StringArray*>(out.get());
+    for (size_t idx = 0; idx < upids.size(); ++idx) {
+      EXPECT_EQ(out_strs->GetString(idx), udf.Exec(function_ctx.get(), upids[idx]));
+    }
+  }
+}
+
 TEST_F(MetadataOpsTest, upid_to_namespace_test) {
   auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
   auto udf_tester = px::carnot::udf::UDFTester<UPIDToNamespaceUDF>(std::move(function_ctx));
@@ -543,6 +569,28 @@ TEST_F(MetadataOpsTest, pod_ip_to_service_id_test) {
   EXPECT_EQ(udf.Exec(function_ctx.get(), "1.2.1.2"), "");
 }
 
+TEST_F(MetadataOpsTest, pod_ip_exec_batch_matches_exec) {
+  auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
+  std::vector<types::StringValue> ips = {"1.1.1.1", "1.2.1.2", "1.1.1.1", "", "1.1.1.10",
+                                         "1.1.1.1"};
+  auto ips_arr = types::ToArrow(ips, arrow::default_memory_pool());
+
+  PodIPToServiceIDUDF udf;
+  arrow::StringBuilder builder;
+  // Run twice to check that no results are carried over from the previous batch.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK(udf.ExecBatch(function_ctx.get(), *static_cast<arrow::StringArray*>(ips_arr.get()),
+                            &builder, ips.size()));
+    std::shared_ptr<arrow::Array> out;
+    ASSERT_TRUE(builder.Finish(&out).ok());
+    ASSERT_EQ(out->length(), static_cast<int64_t>(ips.size()));
+    auto out_strs = static_cast<arrow::StringArray*>(out.get());
+    for (size_t idx = 0; idx < ips.size(); ++idx) {
+      EXPECT_EQ(out_strs->GetString(idx), udf.Exec(function_ctx.get(), ips[idx]));
+    }
+  }
+}
+
 TEST_F(MetadataOpsTest, upid_to_qos) {
   auto function_ctx = std::make_unique<FunctionContext>(metadata_state_, nullptr);
   auto udf_tester = px::carnot::udf::UDFTester<UPIDToPodQoSUDF>(std::move(function_ctx));
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/net/dns.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include <cstring>
+#include <thread>
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+std::optional<std::string> DNSLookup(const std::string& addr) {
+  struct sockaddr_in sa;
+
+  char node[kMaxHostnameSize];
+
+  memset(&sa, 0, sizeof sa);
+  sa.sin_family = AF_INET;
+
+  if (inet_pton(AF_INET, addr.c_str(), &sa.sin_addr) != 1) {
+    return std::nullopt;
+  }
+
+  int res =
+      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+  if (res) {
+    return std::nullopt;
+  }
+  return node;
+}
+
+DNSCache& DNSCache::GetInstance() {
+  // Leaked, so that lookups that are still running at exit don't use a destroyed cache.
+  static DNSCache* cache = new DNSCache(DNSLookup);
+  return *cache;
+}
+
+DNSCache::~DNSCache() {
+  std::unique_lock<std::mutex> lock(mu_);
+  queue_.clear();
+  cv_.wait(lock, [this]() { return num_workers_ == 0; });
+}
+
+absl::flat_hash_map<std::string, std::string> DNSCache::LookupBatch(
+    const std::vector<std::string>& addrs, std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  absl::flat_hash_map<std::string, std::string> hostnames;
+  std::vector<std::string> misses;
+
+  std::unique_lock<std::mutex> lock(mu_);
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& addr : addrs) {
+    if (hostnames.contains(addr)) {
+      continue;
+    }
+    const std::string* hostname = FindLocked(addr, now);
+    if (hostname != nullptr) {
+      hostnames[addr] = *hostname;
+      continue;
+    }
+    // Fall back to the address, unless it's resolved before the timeout.
+    hostnames[addr] = addr;
+    misses.push_back(addr);
+    if (in_flight_.insert(addr).second) {
+      queue_.push_back(addr);
+    }
+  }
+  if (misses.empty()) {
+    return hostnames;
+  }
+
+  while (num_workers_ < kMaxConcurrentDNSLookups && num_workers_ < queue_.size()) {
+    ++num_workers_;
+    std::thread(&DNSCache::ResolveQueuedAddrs, this).detach();
+  }
+
+  // Resolved misses never become unresolved again, so the scan resumes where it stopped.
+  size_t first_unresolved = 0;
+  cv_.wait_until(lock, deadline, [&]() {
+    while (first_unresolved < misses.size() && !in_flight_.contains(misses[first_unresolved])) {
+      ++first_unresolved;
+    }
+    return first_unresolved == misses.size();
+  });
+
+  now = std::chrono::steady_clock::now();
+  for (const auto& addr : misses) {
+    const std::string* hostname = FindLocked(addr, now);
+    if (hostname != nullptr) {
+      hostnames[addr] = *hostname;
+    }
+  }
+  return hostnames;
+}
+
+const std::string* DNSCache::FindLocked(const std::string& addr,
+                                        std::chrono::steady_clock::time_point now) {
+  auto it = entries_.find(addr);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  if (it->second.expiry <= now) {
+    entries_.erase(it);
+    return nullptr;
+  }
+  return &it->second.hostname;
+}
+
+void DNSCache::InsertLocked(const std::string& addr, const std::optional<std::string>& hostname,
+                            std::chrono::steady_clock::time_point now) {
+  if (entries_.size() >= max_size_ && !entries_.contains(addr)) {
+    // Expired entries are only dropped when they are looked up, so make room with an arbitrary
+    // entry instead of scanning for them.
+    entries_.erase(entries_.begin());
+  }
+  Entry& entry = entries_[addr];
+  entry.hostname = hostname.value_or(addr);
+  entry.expiry = now + (hostname.has_value() ? kDNSCacheTTL : kDNSNegativeCacheTTL);
+}
+
+void DNSCache::ResolveQueuedAddrs() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!queue_.empty()) {
+    std::string addr = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    std::optional<std::string> hostname = resolve_(addr);
+    lock.lock();
+    InsertLocked(addr, hostname, std::chrono::steady_clock::now());
+    in_flight_.erase(addr);
+    cv_.notify_all();
+  }
+  --num_workers_;
+  cv_.notify_all();
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
@@ -18,10 +18,17 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
-#define TBB_PREVIEW_CONCURRENT_LRU_CACHE 1
-#include "tbb/concurrent_lru_cache.h"
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 namespace px {
 namespace carnot {
@@ -30,41 +37,74 @@ namespace net {
 namespace internal {
 
 constexpr size_t kMaxHostnameSize = 512;
-constexpr size_t kLRUCacheSize = 1024;
-
-inline std::string DNSLookup(const std::string& addr) {
-  struct sockaddr_in sa;
-
-  char node[kMaxHostnameSize];
-
-  memset(&sa, 0, sizeof sa);
-  sa.sin_family = AF_INET;
-
-  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
-
-  int res =
-      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
-
-  if (res) {
-    return res == EAI_NONAME ? addr : gai_strerror(res);
-  }
-  return node;
-}
+constexpr size_t kDNSCacheSize = 16384;
+// How long resolved and unresolved addresses are cached for.
+constexpr std::chrono::seconds kDNSCacheTTL{300};
+constexpr std::chrono::seconds kDNSNegativeCacheTTL{30};
+// How long a batch waits for the lookups of the addresses that aren't cached.
+constexpr std::chrono::milliseconds kDNSLookupTimeout{200};
+constexpr size_t kMaxConcurrentDNSLookups = 16;
+
+/**
+ * Performs a reverse DNS lookup of an IPv4 address.
+ * @return the hostname, or std::nullopt if the address has no name or the lookup failed.
+ */
+std::optional<std::string> DNSLookup(const std::string& addr);
 
+/**
+ * DNSCache caches the hostnames of addresses. Lookups of addresses that aren't cached run
+ * concurrently on up to kMaxConcurrentDNSLookups worker threads, and callers only wait for them
+ * up to a timeout. Addresses that couldn't be resolved (yet) map to themselves. Lookups that time
+ * out keep running, so that their result is cached for later batches.
+ */
 class DNSCache {
  public:
-  static DNSCache& GetInstance() {
-    static DNSCache cache;
-    return cache;
+  using ResolveFn = std::function<std::optional<std::string>(const std::string& addr)>;
+
+  static DNSCache& GetInstance();
+
+  explicit DNSCache(ResolveFn resolve, size_t max_size = kDNSCacheSize)
+      : resolve_(std::move(resolve)), max_size_(max_size) {}
+  // Waits for the running lookups to finish.
+  ~DNSCache();
+
+  /**
+   * Looks up the hostnames of a batch of addresses.
+   * @param addrs The addresses to look up, which may contain duplicates.
+   * @param timeout How long to wait for the lookups of addresses that aren't cached.
+   * @return the hostname of every distinct address, or the address itself if it isn't resolved.
+   */
+  absl::flat_hash_map<std::string, std::string> LookupBatch(const std::vector<std::string>& addrs,
+                                                            std::chrono::milliseconds timeout);
+
+  std::string Lookup(const std::string& addr,
+                     std::chrono::milliseconds timeout = kDNSLookupTimeout) {
+    return LookupBatch({addr}, timeout).at(addr);
   }
 
-  std::string Lookup(std::string addr) { return cache_[addr].value(); }
-
  private:
-  DNSCache()
-      : cache_([](std::string addr) -> std::string { return DNSLookup(addr); }, kLRUCacheSize) {}
-
-  tbb::concurrent_lru_cache<std::string, std::string> cache_;
+  struct Entry {
+    std::string hostname;
+    std::chrono::steady_clock::time_point expiry;
+  };
+
+  // Returns the cached hostname of the address, or nullptr if it isn't cached.
+  const std::string* FindLocked(const std::string& addr, std::chrono::steady_clock::time_point now);
+  void InsertLocked(const std::string& addr, const std::optional<std::string>& hostname,
+                    std::chrono::steady_clock::time_point now);
+  void ResolveQueuedAddrs();
+
+  const ResolveFn resolve_;
+  const size_t max_size_;
+
+  std::mutex mu_;
+  // Signalled whenever a lookup finishes or a worker exits.
+  std::condition_variable cv_;
+  absl::flat_hash_map<std::string, Entry> entries_;
+  // Addresses that are queued or being resolved.
+  absl::flat_hash_set<std::string> in_flight_;
+  std::deque<std::string> queue_;
+  size_t num_workers_ = 0;
 };
 
 }  // namespace internal
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "src/carnot/funcs/net/dns.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+TEST(DNSCacheTest, resolves_distinct_addrs_once) {
+  std::atomic<int> num_lookups = 0;
+  DNSCache cache([&](const std::string& addr) -> std::optional<std::string> {
+    ++num_lookups;
+    if (addr == "10.0.0.3") {
+      return std::nullopt;
+    }
+    return "host-" + addr;
+  });
+
+  auto hostnames = cache.LookupBatch({"10.0.0.1", "10.0.0.2", "10.0.0.1", "10.0.0.3"},
+                                     std::chrono::seconds(10));
+  EXPECT_EQ(3UL, hostnames.size());
+  EXPECT_EQ("host-10.0.0.1", hostnames["10.0.0.1"]);
+  EXPECT_EQ("host-10.0.0.2", hostnames["10.0.0.2"]);
+  // Addresses without a name fall back to the address.
+  EXPECT_EQ("10.0.0.3", hostnames["10.0.0.3"]);
+  EXPECT_EQ(3, num_lookups.load());
+
+  // Both the resolved and unresolved addresses are cached.
+  EXPECT_EQ("host-10.0.0.2", cache.Lookup("10.0.0.2"));
+  EXPECT_EQ("10.0.0.3", cache.Lookup("10.0.0.3"));
+  EXPECT_EQ(3, num_lookups.load());
+}
+
+TEST(DNSCacheTest, slow_lookups_fall_back_to_addr) {
+  std::atomic<bool> release = false;
+  DNSCache cache([&](const std::string& addr) -> std::optional<std::string> {
+    while (!release) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return "host-" + addr;
+  });
+
+  EXPECT_EQ("10.0.0.1", cache.Lookup("10.0.0.1", std::chrono::milliseconds(10)));
+
+  // The lookup keeps running after the timeout, so a later query gets the hostname.
+  release = true;
+  EXPECT_EQ("host-10.0.0.1", cache.Lookup("10.0.0.1", std::chrono::seconds(10)));
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
@@ -44,9 +44,29 @@ class NSLookupUDF : public ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue addr) { return cache_.Lookup(addr); }
 
+  // Resolves the distinct addresses of the batch together, so that the lookups that aren't
+  // cached run concurrently instead of one row at a time.
+  Status ExecBatch(FunctionContext*, const arrow::StringArray& addrs, arrow::StringBuilder* out,
+                   size_t count) {
+    std::vector<std::string> batch_addrs;
+    batch_addrs.reserve(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+      auto view = addrs.GetView(idx);
+      batch_addrs.emplace_back(view.data(), view.size());
+    }
+    auto hostnames = cache_.LookupBatch(batch_addrs, internal::kDNSLookupTimeout);
+    PL_RETURN_IF_ERROR(out->Reserve(count));
+    for (const auto& addr : batch_addrs) {
+      PL_RETURN_IF_ERROR(out->Append(hostnames.at(addr)));
+    }
+    return Status::OK();
+  }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Perform a DNS lookup for the value (experimental).")
-        .Details("Experimental UDF to perform a DNS lookup for a given value.")
+        .Details(
+            "Experimental UDF to perform a DNS lookup for a given value. Lookups that don't "
+            "finish in time return the address itself, and are retried by later queries.")
         .Arg("addr", "An IP address")
         .Example("df.hostname = px.nslookup(df.ip_addr)")
         .Returns("The hostname.");
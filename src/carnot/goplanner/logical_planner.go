@@ -95,6 +95,57 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return plan, nil
 }
 
+// SetDistributedState replaces the distributed state kept by the planner, and returns its version.
+func (cm GoPlanner) SetDistributedState(state *distributedpb.DistributedState) (int64, error) {
+	stateBytes, err := proto.Marshal(state)
+	if err != nil {
+		return 0, err
+	}
+	stateData := C.CBytes(stateBytes)
+	defer C.free(stateData)
+
+	version := int64(C.PlannerSetDistributedState(cm.planner, (*C.char)(stateData), C.int(len(stateBytes))))
+	if version < 0 {
+		return 0, errors.New("failed to set the distributed state")
+	}
+	return version, nil
+}
+
+// PlanWithStateVersion is the same as Plan, but plans against the distributed state kept by the
+// planner at the given version, instead of the one in planState.
+func (cm GoPlanner) PlanWithStateVersion(stateVersion int64, planState *distributedpb.LogicalPlannerState, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	var resultLen C.int
+	// The kept state is used instead, so don't marshal it.
+	stateWithoutDistributedState := *planState
+	stateWithoutDistributedState.DistributedState = nil
+	stateBytes, err := proto.Marshal(&stateWithoutDistributedState)
+	if err != nil {
+		return nil, err
+	}
+	stateData := C.CBytes(stateBytes)
+	defer C.free(stateData)
+
+	queryRequestBytes, err := proto.Marshal(queryRequest)
+	if err != nil {
+		return nil, err
+	}
+	queryRequestData := C.CBytes(queryRequestBytes)
+	defer C.free(queryRequestData)
+
+	res := C.PlannerPlanWithStateVersion(cm.planner, C.int64_t(stateVersion), (*C.char)(stateData), C.int(len(stateBytes)), (*C.char)(queryRequestData), C.int(len(queryRequestBytes)), &resultLen)
+	defer C.StrFree(res)
+	lp := C.GoBytes(unsafe.Pointer(res), resultLen)
+	if resultLen == 0 {
+		return nil, errors.New("no result returned")
+	}
+
+	plan := &distributedpb.LogicalPlannerResult{}
+	if err := proto.Unmarshal(lp, plan); err != nil {
+		return plan, fmt.Errorf("error: '%s'; string: '%s'", err, string(lp))
+	}
+	return plan, nil
+}
+
 // GetMainFuncArgsSpec returns the FuncArgSpec of the main function if it exists, otherwise throws a Compiler Error.
 func (cm GoPlanner) GetMainFuncArgsSpec(queryRequest *plannerpb.QueryRequest) (*scriptspb.MainFuncSpecResult, error) {
 	var resultLen C.int
@@ -47,6 +47,17 @@ func (cm GoPlanner) Plan(planState *distributedpb.LogicalPlannerState, queryRequ
 	return nil, errorUnimplemented
 }
 
+// SetDistributedState replaces the distributed state kept by the planner, and returns its version.
+func (cm GoPlanner) SetDistributedState(state *distributedpb.DistributedState) (int64, error) {
+	return 0, errorUnimplemented
+}
+
+// PlanWithStateVersion is the same as Plan, but plans against the distributed state kept by the
+// planner at the given version, instead of the one in planState.
+func (cm GoPlanner) PlanWithStateVersion(stateVersion int64, planState *distributedpb.LogicalPlannerState, queryRequest *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	return nil, errorUnimplemented
+}
+
 // GetMainFuncArgsSpec returns the FuncArgSpec of the main function if it exists, otherwise throws a Compiler Error.
 func (cm GoPlanner) GetMainFuncArgsSpec(queryRequest *plannerpb.QueryRequest) (*scriptspb.MainFuncSpecResult, error) {
 	return nil, errorUnimplemented
@@ -74,6 +74,8 @@ std::unique_ptr<Operator> Operator::FromProto(const planpb::Operator& pb, int64_
       return CreateOperator<FilterOperator>(id, pb.filter_op());
     case planpb::LIMIT_OPERATOR:
       return CreateOperator<LimitOperator>(id, pb.limit_op());
+    case planpb::TOP_K_OPERATOR:
+      return CreateOperator<TopKOperator>(id, pb.top_k_op());
     case planpb::UNION_OPERATOR:
       return CreateOperator<UnionOperator>(id, pb.union_op());
     case planpb::JOIN_OPERATOR:
@@ -104,6 +106,20 @@ Status MemorySourceOperator::Init(const planpb::MemorySourceOperator& pb) {
   return Status::OK();
 }
 
+void MemorySourceOperator::SetParameters(const planpb::MemorySourceOperator& pb) {
+  if (pb.has_start_time()) {
+    *pb_.mutable_start_time() = pb.start_time();
+  } else {
+    pb_.clear_start_time();
+  }
+  if (pb.has_stop_time()) {
+    *pb_.mutable_stop_time() = pb.stop_time();
+  } else {
+    pb_.clear_stop_time();
+  }
+  pb_.set_tablet(pb.tablet());
+}
+
 StatusOr<table_store::schema::Relation> MemorySourceOperator::OutputRelation(
     const table_store::schema::Schema&, const PlanState&,
     const std::vector<int64_t>& input_ids) const {
@@ -450,6 +466,81 @@ StatusOr<table_store::schema::Relation> LimitOperator::OutputRelation(
   return output_relation;
 }
 
+/**
+ * TopK Operator Implementation.
+ */
+std::string TopKOperator::DebugString() const {
+  std::string debug_string =
+      absl::Substitute("($0, sort: [$1], cols: [$2])", record_limit_,
+                       absl::StrJoin(sort_cols_, ","), absl::StrJoin(selected_cols_, ","));
+  return "Op:TopK" + debug_string;
+}
+
+Status TopKOperator::Init(const planpb::TopKOperator& pb) {
+  pb_ = pb;
+  record_limit_ = pb_.limit();
+  if (record_limit_ < 0) {
+    return error::InvalidArgument("TopK limit must be non-negative, got $0", record_limit_);
+  }
+
+  selected_cols_.reserve(pb_.columns_size());
+  for (auto i = 0; i < pb_.columns_size(); ++i) {
+    selected_cols_.push_back(pb_.columns(i).index());
+  }
+
+  if (pb_.sort_columns_size() == 0) {
+    return error::InvalidArgument("TopK operator requires at least one sort column");
+  }
+  if (pb_.descending_size() != pb_.sort_columns_size()) {
+    return error::InvalidArgument("TopK operator has $0 sort columns but $1 sort directions",
+                                  pb_.sort_columns_size(), pb_.descending_size());
+  }
+  sort_cols_.reserve(pb_.sort_columns_size());
+  descending_.reserve(pb_.descending_size());
+  for (auto i = 0; i < pb_.sort_columns_size(); ++i) {
+    sort_cols_.push_back(pb_.sort_columns(i).index());
+    descending_.push_back(pb_.descending(i));
+  }
+
+  is_initialized_ = true;
+  return Status::OK();
+}
+
+StatusOr<table_store::schema::Relation> TopKOperator::OutputRelation(
+    const table_store::schema::Schema& schema, const PlanState& /*state*/,
+    const std::vector<int64_t>& input_ids) const {
+  DCHECK(is_initialized_) << "Not initialized";
+
+  if (input_ids.size() != 1) {
+    return error::InvalidArgument("TopK operator must have exactly one input");
+  }
+  if (!schema.HasRelation(input_ids[0])) {
+    return error::NotFound("Missing relation ($0) for input of TopKOperator", input_ids[0]);
+  }
+
+  PL_ASSIGN_OR_RETURN(const table_store::schema::Relation& input_relation,
+                      schema.GetRelation(input_ids[0]));
+  for (auto sort_col_idx : sort_cols_) {
+    if (sort_col_idx >= static_cast<int64_t>(input_relation.NumColumns())) {
+      return error::InvalidArgument(
+          "Sort column index $0 is out of bounds, number of columns is $1", sort_col_idx,
+          input_relation.NumColumns());
+    }
+  }
+
+  table_store::schema::Relation output_relation;
+  for (auto selected_col_idx : selected_cols_) {
+    CHECK_LT(selected_col_idx, static_cast<int64_t>(input_relation.NumColumns()))
+        << absl::Substitute("Column index $0 is out of bounds, number of columns is $1",
+                            selected_col_idx, input_relation.NumColumns());
+
+    output_relation.AddColumn(input_relation.GetColumnType(selected_col_idx),
+                              input_relation.GetColumnName(selected_col_idx),
+                              input_relation.GetColumnDesc(selected_col_idx));
+  }
+  return output_relation;
+}
+
 /**
  * Zip Operator Implementation.
  */
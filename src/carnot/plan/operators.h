@@ -96,6 +96,14 @@ class MemorySourceOperator : public Operator {
   std::vector<int64_t> Columns() const { return column_idxs_; }
   const types::TabletID& Tablet() const { return pb_.tablet(); }
   bool infinite_stream() const { return pb_.streaming(); }
+  const google::protobuf::RepeatedPtrField<planpb::ZoneMapPredicate>& predicates() const {
+    return pb_.predicates();
+  }
+  bool HasSample() const { return pb_.has_sample(); }
+  const planpb::Sample& sample() const { return pb_.sample(); }
+  // Replaces the time bounds and the tablet with the ones of pb, which can change between runs
+  // of the same plan (see PlanCache).
+  void SetParameters(const planpb::MemorySourceOperator& pb);
 
  private:
   planpb::MemorySourceOperator pb_;
@@ -143,6 +151,11 @@ class AggregateOperator : public Operator {
   const std::vector<GroupInfo>& groups() const { return groups_; }
   const std::vector<std::shared_ptr<AggregateExpression>>& values() const { return values_; }
   bool windowed() const { return pb_.windowed(); }
+  bool has_time_window() const { return pb_.has_time_window(); }
+  const planpb::AggregateOperator::TimeWindow& time_window() const { return pb_.time_window(); }
+  const google::protobuf::RepeatedField<double>& value_scales() const {
+    return pb_.value_scales();
+  }
 
  private:
   std::vector<std::shared_ptr<AggregateExpression>> values_;
@@ -213,6 +226,14 @@ class GRPCSinkOperator : public Operator {
     return pb_.destination_case() == planpb::GRPCSinkOperator::kOutputTable;
   }
   std::string table_name() const { return pb_.output_table().table_name(); }
+  bool arrow_row_batches() const { return pb_.arrow_row_batches(); }
+  bool compress_row_batches() const { return pb_.compress_row_batches(); }
+  int64_t estimated_query_row_bytes_before_pushdown() const {
+    return pb_.estimated_query_row_bytes_before_pushdown();
+  }
+  int64_t estimated_query_row_bytes_after_pushdown() const {
+    return pb_.estimated_query_row_bytes_after_pushdown();
+  }
 
  private:
   planpb::GRPCSinkOperator pb_;
@@ -261,6 +282,31 @@ class LimitOperator : public Operator {
   planpb::LimitOperator pb_;
 };
 
+class TopKOperator : public Operator {
+ public:
+  explicit TopKOperator(int64_t id) : Operator(id, planpb::TOP_K_OPERATOR) {}
+  ~TopKOperator() override = default;
+
+  StatusOr<table_store::schema::Relation> OutputRelation(
+      const table_store::schema::Schema& schema, const PlanState& state,
+      const std::vector<int64_t>& input_ids) const override;
+  Status Init(const planpb::TopKOperator& pb);
+  std::string DebugString() const override;
+  const std::vector<int64_t>& selected_cols() const { return selected_cols_; }
+
+  int64_t record_limit() const { return record_limit_; }
+  // Indices of the sort columns in the input relation, in order of precedence.
+  const std::vector<int64_t>& sort_cols() const { return sort_cols_; }
+  const std::vector<bool>& descending() const { return descending_; }
+
+ private:
+  int64_t record_limit_ = 0;
+  std::vector<int64_t> selected_cols_;
+  std::vector<int64_t> sort_cols_;
+  std::vector<bool> descending_;
+  planpb::TopKOperator pb_;
+};
+
 class UnionOperator : public Operator {
  public:
   explicit UnionOperator(int64_t id) : Operator(id, planpb::UNION_OPERATOR) {}
@@ -312,6 +358,10 @@ class JoinOperator : public Operator {
   }
   std::vector<planpb::JoinOperator::ParentColumn> output_columns() const { return output_columns_; }
   size_t rows_per_batch() const { return pb_.rows_per_batch(); }
+  uint64_t build_parent_index() const { return pb_.build_parent_index(); }
+  const planpb::JoinOperator::AsofCondition& asof_condition() const {
+    return pb_.asof_condition();
+  }
 
   bool order_by_time() const;
   planpb::JoinOperator::ParentColumn time_column() const;
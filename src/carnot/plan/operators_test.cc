@@ -230,6 +230,19 @@ TEST_F(OperatorTest, from_proto_limit) {
   EXPECT_EQ(planpb::OperatorType::LIMIT_OPERATOR, limit_op->op_type());
 }
 
+TEST_F(OperatorTest, from_proto_top_k) {
+  auto top_k_pb = planpb::testutils::CreateTestTopK1PB();
+  auto top_k_op = Operator::FromProto(top_k_pb, 1);
+  EXPECT_EQ(1, top_k_op->id());
+  EXPECT_TRUE(top_k_op->is_initialized());
+  EXPECT_EQ(planpb::OperatorType::TOP_K_OPERATOR, top_k_op->op_type());
+  auto top_k_typed_op = static_cast<TopKOperator*>(top_k_op.get());
+  EXPECT_EQ(10, top_k_typed_op->record_limit());
+  EXPECT_THAT(top_k_typed_op->selected_cols(), ElementsAre(0, 1));
+  EXPECT_THAT(top_k_typed_op->sort_cols(), ElementsAre(1));
+  EXPECT_THAT(top_k_typed_op->descending(), ElementsAre(true));
+}
+
 TEST_F(OperatorTest, from_proto_drop_limit) {
   auto limit_pb = planpb::testutils::CreateTestDropLimit1PB();
   auto limit_op = Operator::FromProto(limit_pb, 1);
@@ -415,6 +428,18 @@ TEST_F(OperatorTest, output_relation_drop_limit) {
   EXPECT_EQ(expected_relation, rel);
 }
 
+TEST_F(OperatorTest, output_relation_top_k) {
+  auto top_k_pb = planpb::testutils::CreateTestTopK1PB();
+  auto top_k_op = Operator::FromProto(top_k_pb, 1);
+
+  auto rel =
+      top_k_op->OutputRelation(schema_, *state_, std::vector<int64_t>({0})).ConsumeValueOrDie();
+  Relation expected_relation;
+  expected_relation.AddColumn(types::DataType::INT64, "col0");
+  expected_relation.AddColumn(types::DataType::FLOAT64, "col1");
+  EXPECT_EQ(expected_relation, rel);
+}
+
 TEST_F(OperatorTest, output_relation_union) {
   auto union_pb = planpb::testutils::CreateTestUnionOrderedPB();
   auto union_op = Operator::FromProto(union_pb, 4);
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/plan/plan_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/plan/plan_fragment.h"
+
+namespace px {
+namespace carnot {
+namespace plan {
+
+std::string PlanCache::KeyOf(const planpb::Plan& pb) {
+  // Only the DAG and the fragments are used to build the plan, the options and incoming agents
+  // are read from the proto of every run.
+  planpb::Plan key_pb;
+  *key_pb.mutable_dag() = pb.dag();
+  *key_pb.mutable_nodes() = pb.nodes();
+  for (auto& fragment : *key_pb.mutable_nodes()) {
+    for (auto& node : *fragment.mutable_nodes()) {
+      if (node.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto* mem_source = node.mutable_op()->mutable_mem_source_op();
+      mem_source->clear_start_time();
+      mem_source->clear_stop_time();
+      mem_source->clear_tablet();
+    }
+  }
+  return key_pb.SerializeAsString();
+}
+
+Status PlanCache::SetParameters(const planpb::Plan& pb, Plan* plan) {
+  for (const auto& fragment_pb : pb.nodes()) {
+    auto fragment_it = plan->nodes().find(fragment_pb.id());
+    if (fragment_it == plan->nodes().end() || fragment_it->second == nullptr) {
+      return error::Internal("Cached plan has no fragment $0", fragment_pb.id());
+    }
+    PlanFragment* fragment = fragment_it->second.get();
+    for (const auto& node_pb : fragment_pb.nodes()) {
+      if (node_pb.op().op_type() != planpb::MEMORY_SOURCE_OPERATOR) {
+        continue;
+      }
+      auto node_it = fragment->nodes().find(node_pb.id());
+      if (node_it == fragment->nodes().end() || node_it->second == nullptr) {
+        return error::Internal("Cached plan fragment $0 has no node $1", fragment_pb.id(),
+                               node_pb.id());
+      }
+      static_cast<MemorySourceOperator*>(node_it->second.get())
+          ->SetParameters(node_pb.op().mem_source_op());
+    }
+  }
+  return Status::OK();
+}
+
+StatusOr<PlanCache::CachedPlan> PlanCache::Acquire(const planpb::Plan& pb) {
+  CachedPlan cached_plan{KeyOf(pb), nullptr};
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = plans_by_key_.find(cached_plan.key);
+    if (it != plans_by_key_.end()) {
+      cached_plan.plan = std::move(it->second->plan);
+      plans_.erase(it->second);
+      plans_by_key_.erase(it);
+      ++hits_;
+    }
+  }
+  if (cached_plan.plan != nullptr) {
+    PL_RETURN_IF_ERROR(SetParameters(pb, cached_plan.plan.get()));
+    return cached_plan;
+  }
+  cached_plan.plan = std::make_unique<Plan>();
+  PL_RETURN_IF_ERROR(cached_plan.plan->Init(pb));
+  return cached_plan;
+}
+
+void PlanCache::Release(CachedPlan cached_plan) {
+  if (capacity_ == 0 || cached_plan.plan == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mu_);
+  // Another run of the same plan already put its plan back.
+  if (plans_by_key_.contains(cached_plan.key)) {
+    return;
+  }
+  plans_.push_front(std::move(cached_plan));
+  plans_by_key_[plans_.front().key] = plans_.begin();
+  if (plans_.size() > capacity_) {
+    plans_by_key_.erase(plans_.back().key);
+    plans_.pop_back();
+  }
+}
+
+size_t PlanCache::size() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return plans_.size();
+}
+
+int64_t PlanCache::hits() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return hits_;
+}
+
+}  // namespace plan
+}  // namespace carnot
+}  // namespace px
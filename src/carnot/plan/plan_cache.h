@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/plan/plan.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace plan {
+
+/**
+ * PlanCache keeps the plans of the queries that finished, so that running the same plan again
+ * (ie. refreshing a live view) doesn't build its fragments, operators and expressions from the
+ * proto again. Plans are keyed by their proto without the parameters that change between runs
+ * of the same query, the time bounds and tablets of the memory sources, and a plan taken from
+ * the cache gets the parameters of the proto it's taken for.
+ *
+ * A plan is used by one query at a time: Acquire takes it out of the cache and Release puts it
+ * back once the query is done with it.
+ */
+class PlanCache : public NotCopyable {
+ public:
+  struct CachedPlan {
+    std::string key;
+    std::unique_ptr<Plan> plan;
+  };
+
+  // Keeps up to capacity plans, the least recently released ones are dropped first.
+  explicit PlanCache(size_t capacity) : capacity_(capacity) {}
+
+  /**
+   * Returns a plan for the proto, which is the cached one if there is one.
+   */
+  StatusOr<CachedPlan> Acquire(const planpb::Plan& pb);
+
+  /**
+   * Puts a plan returned by Acquire back into the cache.
+   */
+  void Release(CachedPlan cached_plan);
+
+  size_t size() const;
+  // The number of plans that Acquire returned from the cache.
+  int64_t hits() const;
+
+ private:
+  static std::string KeyOf(const planpb::Plan& pb);
+  static Status SetParameters(const planpb::Plan& pb, Plan* plan);
+
+  const size_t capacity_;
+  mutable std::mutex mu_;
+  // The cached plans, the most recently released first.
+  std::list<CachedPlan> plans_;
+  absl::flat_hash_map<std::string, std::list<CachedPlan>::iterator> plans_by_key_;
+  int64_t hits_ = 0;
+};
+
+}  // namespace plan
+}  // namespace carnot
+}  // namespace px
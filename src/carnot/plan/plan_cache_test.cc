@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/plan/plan_cache.h"
+
+#include <string>
+
+#include <absl/strings/substitute.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/plan/operators.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace plan {
+
+// A plan with one fragment that only reads a table, $0 is the column name.
+constexpr char kMemSourcePlanTmpl[] = R"(
+dag { nodes { id: 1 } }
+nodes {
+  id: 1
+  dag { nodes { id: 1 } }
+  nodes {
+    id: 1
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "numbers"
+        column_idxs: 0
+        column_names: "$0"
+        column_types: INT64
+        start_time { value: $1 }
+        stop_time { value: $2 }
+        tablet: "$3"
+      }
+    }
+  }
+})";
+
+planpb::Plan MemSourcePlan(const std::string& column, int64_t start_time, int64_t stop_time,
+                           const std::string& tablet) {
+  planpb::Plan pb;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      absl::Substitute(kMemSourcePlanTmpl, column, start_time, stop_time, tablet), &pb));
+  return pb;
+}
+
+const MemorySourceOperator* MemSource(Plan* plan) {
+  return static_cast<const MemorySourceOperator*>(plan->nodes().at(1)->nodes().at(1).get());
+}
+
+TEST(PlanCache, reuses_plan_with_new_parameters) {
+  PlanCache cache(4);
+  ASSERT_OK_AND_ASSIGN(auto first, cache.Acquire(MemSourcePlan("a", 10, 20, "1")));
+  const Plan* first_plan = first.plan.get();
+  EXPECT_EQ(10, MemSource(first.plan.get())->start_time());
+  cache.Release(std::move(first));
+  EXPECT_EQ(1, cache.size());
+
+  ASSERT_OK_AND_ASSIGN(auto second, cache.Acquire(MemSourcePlan("a", 30, 40, "2")));
+  EXPECT_EQ(first_plan, second.plan.get());
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(30, MemSource(second.plan.get())->start_time());
+  EXPECT_EQ(40, MemSource(second.plan.get())->stop_time());
+  EXPECT_EQ("2", MemSource(second.plan.get())->Tablet());
+}
+
+TEST(PlanCache, different_plans_are_not_shared) {
+  PlanCache cache(4);
+  ASSERT_OK_AND_ASSIGN(auto first, cache.Acquire(MemSourcePlan("a", 10, 20, "1")));
+  cache.Release(std::move(first));
+
+  ASSERT_OK_AND_ASSIGN(auto second, cache.Acquire(MemSourcePlan("b", 10, 20, "1")));
+  EXPECT_NE(nullptr, second.plan);
+  EXPECT_EQ(0, cache.hits());
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(PlanCache, concurrent_runs_build_their_own_plans) {
+  PlanCache cache(4);
+  ASSERT_OK_AND_ASSIGN(auto first, cache.Acquire(MemSourcePlan("a", 10, 20, "1")));
+  ASSERT_OK_AND_ASSIGN(auto second, cache.Acquire(MemSourcePlan("a", 30, 40, "1")));
+  EXPECT_NE(first.plan.get(), second.plan.get());
+  EXPECT_EQ(30, MemSource(second.plan.get())->start_time());
+  cache.Release(std::move(first));
+  cache.Release(std::move(second));
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(PlanCache, evicts_least_recently_released) {
+  PlanCache cache(1);
+  ASSERT_OK_AND_ASSIGN(auto a, cache.Acquire(MemSourcePlan("a", 10, 20, "1")));
+  ASSERT_OK_AND_ASSIGN(auto b, cache.Acquire(MemSourcePlan("b", 10, 20, "1")));
+  cache.Release(std::move(a));
+  cache.Release(std::move(b));
+  EXPECT_EQ(1, cache.size());
+
+  ASSERT_OK_AND_ASSIGN(auto b_again, cache.Acquire(MemSourcePlan("b", 10, 20, "1")));
+  EXPECT_EQ(1, cache.hits());
+  // a was dropped to make room for b.
+  ASSERT_OK_AND_ASSIGN(auto a_again, cache.Acquire(MemSourcePlan("a", 10, 20, "1")));
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_NE(b_again.plan.get(), a_again.plan.get());
+}
+
+}  // namespace plan
+}  // namespace carnot
+}  // namespace px
@@ -69,6 +69,7 @@ class PlanFragmentWalker {
   using MemorySinkWalkFn = std::function<Status(const MemorySinkOperator&)>;
   using FilterWalkFn = std::function<Status(const FilterOperator&)>;
   using LimitWalkFn = std::function<Status(const LimitOperator&)>;
+  using TopKWalkFn = std::function<Status(const TopKOperator&)>;
   using UnionWalkFn = std::function<Status(const UnionOperator&)>;
   using JoinWalkFn = std::function<Status(const JoinOperator&)>;
   using GRPCSinkWalkFn = std::function<Status(const GRPCSinkOperator&)>;
@@ -136,6 +137,16 @@ class PlanFragmentWalker {
     return *this;
   }
 
+  /**
+   * Register callback for when a top-k operator is encountered.
+   * @param fn The function to call when a TopKOperator is encountered.
+   * @return self to allow chaining
+   */
+  PlanFragmentWalker& OnTopK(const TopKWalkFn& fn) {
+    on_top_k_walk_fn_ = fn;
+    return *this;
+  }
+
   /**
    * Register callback for when a union operator is encountered.
    * @param fn The function to call when a UnionOperator is encountered.
@@ -194,6 +205,7 @@ class PlanFragmentWalker {
   MemorySinkWalkFn on_memory_sink_walk_fn_;
   FilterWalkFn on_filter_walk_fn_;
   LimitWalkFn on_limit_walk_fn_;
+  TopKWalkFn on_top_k_walk_fn_;
   UnionWalkFn on_union_walk_fn_;
   JoinWalkFn on_join_walk_fn_;
   GRPCSinkWalkFn on_grpc_sink_walk_fn_;
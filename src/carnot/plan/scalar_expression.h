@@ -178,10 +178,10 @@ class ScalarFunc : public ScalarExpression {
   Expression ExpressionType() const override;
   std::string DebugString() const override;
 
-  std::string name() const { return name_; }
+  const std::string& name() const { return name_; }
   int64_t udf_id() const { return udf_id_; }
   const ScalarExpressionPtrVector& arg_deps() const { return arg_deps_; }
-  const std::vector<types::DataType> args_types() const { return args_types_; }
+  const std::vector<types::DataType>& args_types() const { return args_types_; }
 
  private:
   std::string name_;
@@ -204,10 +204,10 @@ class AggregateExpression : public ScalarExpression {
   Expression ExpressionType() const override;
   std::string DebugString() const override;
 
-  std::string name() const { return name_; }
+  const std::string& name() const { return name_; }
   int64_t uda_id() const { return uda_id_; }
   const ScalarExpressionPtrVector& arg_deps() const { return arg_deps_; }
-  const std::vector<types::DataType> args_types() const { return args_types_; }
+  const std::vector<types::DataType>& args_types() const { return args_types_; }
 
  private:
   std::string name_;
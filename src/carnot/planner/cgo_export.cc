@@ -98,29 +98,65 @@ char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
 
   auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
 
-  auto distributed_plan_status = planner->Plan(planner_state_pb, query_request_pb);
-  if (!distributed_plan_status.ok()) {
-    return ExitEarly<LogicalPlannerResult>(distributed_plan_status.status(), resultLen);
+  auto plan_pb_status = planner->PlanProto(planner_state_pb, query_request_pb);
+  if (!plan_pb_status.ok()) {
+    return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
-  std::unique_ptr<px::carnot::planner::distributed::DistributedPlan> distributed_plan =
-      distributed_plan_status.ConsumeValueOrDie();
 
   // If the response is ok, then we can go ahead and set this up.
   LogicalPlannerResult planner_result_pb;
-  WrapStatus(&planner_result_pb, distributed_plan_status.status());
-  // In the future, if we actually have plan options that will actually determine how the plan is
-  // constructed, we may want to pass the planOptions to planner.Plan. However, this
-  // will need to go through many more layers (such as the coordinator), so this is fine for now.
-  distributed_plan->SetPlanOptions(planner_state_pb.plan_options());
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
+  *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
+
+  // Serialize the logical plan into bytes.
+  return PrepareResult(&planner_result_pb, resultLen);
+}
+
+int64_t PlannerSetDistributedState(PlannerPtr planner_ptr, const char* distributed_state_str_c,
+                                   int distributed_state_str_len) {
+  px::carnot::planner::distributedpb::DistributedState distributed_state_pb;
+  if (!distributed_state_pb.ParseFromArray(distributed_state_str_c, distributed_state_str_len)) {
+    LOG(ERROR) << "Failed to process the distributed state";
+    return -1;
+  }
+
+  auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+  return planner->SetDistributedState(std::move(distributed_state_pb));
+}
+
+char* PlannerPlanWithStateVersion(PlannerPtr planner_ptr, int64_t state_version,
+                                  const char* planner_state_str_c, int planner_state_str_len,
+                                  const char* query_request_str_c, int query_request_str_len,
+                                  int* resultLen) {
+  std::string planner_state_pb_str(planner_state_str_c,
+                                   planner_state_str_c + planner_state_str_len);
+  std::string query_request_pb_str(query_request_str_c,
+                                   query_request_str_c + query_request_str_len);
+
+  // Load in the planner state protobuf, which is small without the distributed state.
+  px::carnot::planner::distributedpb::LogicalPlannerState planner_state_pb;
+  PLANNER_RETURN_IF_ERROR(LogicalPlannerResult, resultLen,
+                          LoadProto(planner_state_pb_str, &planner_state_pb,
+                                    "Failed to process the logical planner state"));
+
+  // Load in the query request protobuf.
+  px::carnot::planner::plannerpb::QueryRequest query_request_pb;
+  PLANNER_RETURN_IF_ERROR(
+      LogicalPlannerResult, resultLen,
+      LoadProto(query_request_pb_str, &query_request_pb, "Failed to process the query request"));
 
-  auto plan_pb_status = distributed_plan->ToProto();
+  auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
+
+  auto plan_pb_status = planner->PlanProtoWithStoredState(
+      state_version, std::move(planner_state_pb), query_request_pb);
   if (!plan_pb_status.ok()) {
     return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
 
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
   *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
 
-  // Serialize the logical plan into bytes.
   return PrepareResult(&planner_result_pb, resultLen);
 }
 
@@ -22,6 +22,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef void* PlannerPtr;
 
@@ -45,6 +46,35 @@ PlannerPtr PlannerNew(const char* udf_info_str_data, int udf_info_str_len);
 char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
                   int planner_state_str_len, const char* query, int query_len, int* resultLen);
 
+/**
+ * @brief Replaces the distributed state kept by the planner, for PlannerPlanWithStateVersion().
+ *
+ * @param planner                     Pointer to the Planner.
+ * @param distributed_state_str_c     The distributedpb.DistributedState, serialized as a string.
+ * @param distributed_state_str_len   Length of the serialized DistributedState.
+ * @return int64_t                    The version of the new state, or -1 if it failed to parse.
+ */
+int64_t PlannerSetDistributedState(PlannerPtr planner_ptr, const char* distributed_state_str_c,
+                                   int distributed_state_str_len);
+
+/**
+ * @brief Same as PlannerPlan(), but plans against the distributed state kept by the planner,
+ * rather than parsing it with every query.
+ *
+ * @param planner                 Pointer to the Planner.
+ * @param state_version           The version of the kept state to plan against. The result holds
+ *                                a FailedPrecondition error if the state is at another version.
+ * @param planner_state_str_c     The planner state proto, seralized as a string. Its
+ *                                distributed_state is ignored, and should be left empty.
+ * @param planner_state_str_len   Length of the planner state proto serialized string.
+ * @param query_request_str_c     The query request proto to plan, seralized as a string.
+ * @param query_request_str_len   The length of the query request serialized string.
+ * @return char*                  The distributed plan proto, serialized as a string.
+ */
+char* PlannerPlanWithStateVersion(PlannerPtr planner_ptr, int64_t state_version,
+                                  const char* planner_state_str_c, int planner_state_str_len,
+                                  const char* query, int query_len, int* resultLen);
+
 /**
  * @brief Returns the Main Function argument's Specification. Fails if the main function doesn't
  * exist in the query argument.
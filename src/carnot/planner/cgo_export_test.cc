@@ -94,6 +94,58 @@ TEST_F(PlannerExportTest, one_pem_one_kelvin_query_test) {
               Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
 }
 
+TEST_F(PlannerExportTest, plan_with_state_version) {
+  planner_ = MakePlanner();
+  distributedpb::LogicalPlannerState planner_state_pb =
+      testutils::CreateOnePEMOneKelvinPlannerState();
+
+  std::string distributed_state;
+  ASSERT_TRUE(planner_state_pb.distributed_state().SerializeToString(&distributed_state));
+  int64_t version =
+      PlannerSetDistributedState(planner_, distributed_state.c_str(), distributed_state.length());
+  ASSERT_GT(version, 0);
+
+  // The distributed state is left out of the per query planner state.
+  planner_state_pb.clear_distributed_state();
+  std::string logical_planner_state;
+  ASSERT_TRUE(planner_state_pb.SerializeToString(&logical_planner_state));
+  std::string query_request;
+  ASSERT_TRUE(MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')")
+                  .SerializeToString(&query_request));
+
+  auto plan = [&](int64_t state_version) {
+    int result_len;
+    auto interface_result = PlannerPlanWithStateVersion(
+        planner_, state_version, logical_planner_state.c_str(), logical_planner_state.length(),
+        query_request.c_str(), query_request.length(), &result_len);
+    distributedpb::LogicalPlannerResult planner_result;
+    EXPECT_TRUE(planner_result.ParseFromString(
+        std::string(interface_result, interface_result + result_len)));
+    delete[] interface_result;
+    return planner_result;
+  };
+
+  distributedpb::LogicalPlannerResult planner_result = plan(version);
+  ASSERT_OK(planner_result.status());
+  EXPECT_THAT(planner_result.plan(),
+              Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+
+  // A stale version is rejected.
+  EXPECT_NOT_OK(plan(version + 1).status());
+
+  // Replace the state with one without the table.
+  planner_state_pb = testutils::CreateOnePEMOneKelvinPlannerState();
+  planner_state_pb.mutable_distributed_state()->clear_schema_info();
+  ASSERT_TRUE(planner_state_pb.distributed_state().SerializeToString(&distributed_state));
+  int64_t new_version =
+      PlannerSetDistributedState(planner_, distributed_state.c_str(), distributed_state.length());
+  ASSERT_EQ(new_version, version + 1);
+
+  EXPECT_NOT_OK(plan(version).status());
+  planner_result = plan(new_version);
+  EXPECT_THAT(planner_result.status(), HasCompilerError("Table 'table1' not found."));
+}
+
 TEST_F(PlannerExportTest, bad_queries) {
   planner_ = MakePlanner();
   int result_len;
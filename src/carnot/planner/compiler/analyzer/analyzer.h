@@ -30,6 +30,7 @@
 #include "src/carnot/planner/compiler/analyzer/data_type_rule.h"
 #include "src/carnot/planner/compiler/analyzer/drop_to_map_rule.h"
 #include "src/carnot/planner/compiler/analyzer/merge_group_by_into_group_acceptor_rule.h"
+#include "src/carnot/planner/compiler/analyzer/merge_rolling_into_blocking_agg_rule.h"
 #include "src/carnot/planner/compiler/analyzer/nested_blocking_agg_fn_check_rule.h"
 #include "src/carnot/planner/compiler/analyzer/operator_relation_rule.h"
 #include "src/carnot/planner/compiler/analyzer/propagate_expression_annotations_rule.h"
@@ -76,6 +77,7 @@ class Analyzer : public RuleExecutor<IR> {
     source_and_metadata_resolution_batch->AddRule<MergeGroupByIntoGroupAcceptorRule>(
         IRNodeType::kRolling);
     source_and_metadata_resolution_batch->AddRule<ConvertStringTimesRule>(compiler_state_);
+    source_and_metadata_resolution_batch->AddRule<MergeRollingIntoBlockingAggRule>();
     source_and_metadata_resolution_batch->AddRule<NestedBlockingAggFnCheckRule>();
     source_and_metadata_resolution_batch->AddRule<ResolveStreamRule>();
   }
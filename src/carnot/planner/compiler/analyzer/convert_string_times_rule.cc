@@ -52,10 +52,10 @@ StatusOr<bool> ConvertStringTimesRule::HandleMemSrc(MemorySourceIR* mem_src) {
   ExpressionIR* end_time = mem_src->end_time_expr();
 
   if (start_has_string_time) {
-    PL_ASSIGN_OR_RETURN(start_time, ConvertStringTimes(start_time, /* relative_time */ true));
+    PL_ASSIGN_OR_RETURN(start_time, ConvertMemSrcTime(start_time));
   }
   if (end_has_string_time) {
-    PL_ASSIGN_OR_RETURN(end_time, ConvertStringTimes(end_time, /* relative_time */ true));
+    PL_ASSIGN_OR_RETURN(end_time, ConvertMemSrcTime(end_time));
   }
 
   PL_RETURN_IF_ERROR(mem_src->SetTimeExpressions(start_time, end_time));
@@ -72,6 +72,25 @@ StatusOr<bool> ConvertStringTimesRule::HandleRolling(RollingIR* rolling) {
   return true;
 }
 
+// A memory source time that is just a relative time string (e.g. '-5m') is converted with
+// CompilerState::RelativeTime(), so that it doesn't keep the plan from being reused. The times
+// computed from expressions read the time now directly.
+StatusOr<ExpressionIR*> ConvertStringTimesRule::ConvertMemSrcTime(ExpressionIR* node) {
+  if (!Match(node, String())) {
+    return ConvertStringTimes(node, /* relative_time */ true);
+  }
+  auto str_node = static_cast<StringIR*>(node);
+  auto offset_or_s = StringToTimeInt(str_node->str());
+  int64_t time;
+  if (offset_or_s.ok()) {
+    time = compiler_state_->RelativeTime(offset_or_s.ConsumeValueOrDie());
+  } else {
+    // Not a relative time, so the time now isn't used.
+    PL_ASSIGN_OR_RETURN(time, ParseStringToTime(str_node, /* time_now */ 0));
+  }
+  return node->graph()->CreateNode<IntIR>(node->ast(), time);
+}
+
 bool ConvertStringTimesRule::HasStringTime(const ExpressionIR* node) {
   if (Match(node, String())) {
     return true;
@@ -41,6 +41,7 @@ class ConvertStringTimesRule : public Rule {
   StatusOr<bool> HandleRolling(RollingIR* rolling);
   bool HasStringTime(const ExpressionIR* expr);
   StatusOr<ExpressionIR*> ConvertStringTimes(ExpressionIR* expr, bool relative_time);
+  StatusOr<ExpressionIR*> ConvertMemSrcTime(ExpressionIR* expr);
 };
 
 }  // namespace compiler
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/carnot/planner/compiler/analyzer/merge_rolling_into_blocking_agg_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+StatusOr<bool> MergeRollingIntoBlockingAggRule::Apply(IRNode* ir_node) {
+  if (Match(ir_node, OperatorWithParent(BlockingAgg(), Rolling()))) {
+    return MergeRolling(static_cast<BlockingAggIR*>(ir_node));
+  }
+  return false;
+}
+
+StatusOr<int64_t> MergeRollingIntoBlockingAggRule::WindowSizeNS(RollingIR* rolling) {
+  ExpressionIR* window_size = rolling->window_size();
+  int64_t size_ns = 0;
+  if (Match(window_size, Int())) {
+    size_ns = static_cast<IntIR*>(window_size)->val();
+  } else if (window_size->type() == IRNodeType::kTime) {
+    size_ns = static_cast<TimeIR*>(window_size)->val();
+  } else {
+    return window_size->CreateIRNodeError("Expected the rolling window size to be a time, got a $0",
+                                          window_size->type_string());
+  }
+  if (size_ns <= 0) {
+    return window_size->CreateIRNodeError("Rolling window size must be positive, got $0",
+                                          size_ns);
+  }
+  return size_ns;
+}
+
+StatusOr<bool> MergeRollingIntoBlockingAggRule::MergeRolling(BlockingAggIR* agg) {
+  DCHECK_EQ(agg->parents().size(), 1UL);
+  RollingIR* rolling = static_cast<RollingIR*>(agg->parents()[0]);
+  PL_ASSIGN_OR_RETURN(int64_t size_ns, WindowSizeNS(rolling));
+
+  auto graph = agg->graph();
+  absl::flat_hash_set<std::string> agg_group_names;
+  for (ColumnIR* g : agg->groups()) {
+    agg_group_names.insert(g->col_name());
+  }
+  // The window column comes first so that it is the window's group in the agg.
+  std::vector<ColumnIR*> new_groups;
+  std::vector<ColumnIR*> rolling_groups{rolling->window_col()};
+  for (ColumnIR* g : rolling->groups()) {
+    rolling_groups.push_back(g);
+  }
+  for (ColumnIR* g : rolling_groups) {
+    if (!agg_group_names.insert(g->col_name()).second) {
+      if (g == rolling->window_col()) {
+        return agg->CreateIRNodeError("Cannot group the rolling window on its window column '$0'",
+                                      g->col_name());
+      }
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(ColumnIR * col, graph->CopyNode(g));
+    new_groups.push_back(col);
+  }
+  PL_RETURN_IF_ERROR(agg->PrependGroups(new_groups));
+  agg->SetTimeWindow(/*group_index*/ 0, size_ns);
+
+  DCHECK_EQ(rolling->parents().size(), 1UL);
+  PL_RETURN_IF_ERROR(agg->ReplaceParent(rolling, rolling->parents()[0]));
+  if (rolling->Children().size() != 0) {
+    return true;
+  }
+
+  auto rolling_id = rolling->id();
+  auto rolling_children = graph->dag().DependenciesOf(rolling_id);
+  PL_RETURN_IF_ERROR(graph->DeleteNode(rolling_id));
+  for (const auto& child_id : rolling_children) {
+    PL_RETURN_IF_ERROR(graph->DeleteOrphansInSubtree(child_id));
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief This rule merges every rolling window that is followed by an agg into the agg.
+ *
+ * The window column and the groups of the rolling window go in front of the groups of the agg, and
+ * the agg is marked to aggregate over tumbling windows of the window size on the window column.
+ * The rolling window is removed once none of its children remain.
+ *
+ */
+class MergeRollingIntoBlockingAggRule : public Rule {
+ public:
+  MergeRollingIntoBlockingAggRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  StatusOr<bool> MergeRolling(BlockingAggIR* agg);
+  StatusOr<int64_t> WindowSizeNS(RollingIR* rolling);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -56,7 +56,7 @@ StatusOr<bool> OperatorRelationRule::Apply(IRNode* ir_node) {
   }
   if (Match(ir_node, UnresolvedReadyOp(Limit())) || Match(ir_node, UnresolvedReadyOp(Filter())) ||
       Match(ir_node, UnresolvedReadyOp(GroupBy())) ||
-      Match(ir_node, UnresolvedReadyOp(Rolling()))) {
+      Match(ir_node, UnresolvedReadyOp(Rolling())) || Match(ir_node, UnresolvedReadyOp(TopK()))) {
     // Explicitly match because the general matcher keeps causing problems.
     return SetOther(static_cast<OperatorIR*>(ir_node));
   }
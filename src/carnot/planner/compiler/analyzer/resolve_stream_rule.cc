@@ -43,7 +43,10 @@ StatusOr<bool> ResolveStreamRule::Apply(IRNode* ir_node) {
     auto node = nodes.front();
     nodes.pop();
 
-    if (node->IsBlocking()) {
+    // Aggregates over time windows emit each window once it closes, so they can stream.
+    bool time_windowed_agg =
+        Match(node, BlockingAgg()) && static_cast<BlockingAggIR*>(node)->has_time_window();
+    if (node->IsBlocking() && !time_windowed_agg) {
       return error::Unimplemented("df.stream() not yet supported with blocking operator %s",
                                   node->DebugString());
     }
@@ -2732,6 +2732,71 @@ TEST_F(CompilerTest, RollingNonTimeUnsupported) {
               HasCompilerError("Windowing is only supported on time_ at the moment"));
 }
 
+constexpr char kRollingAggQuery[] = R"pxl(
+import px
+t1 = px.DataFrame(table='http_events', select=['time_', 'remote_addr', 'remote_port'])
+t1 = t1.rolling('3s').groupby('remote_port').agg(count=('remote_addr', px.count))
+px.display(t1)
+)pxl";
+TEST_F(CompilerTest, RollingAggQuery) {
+  auto graph_or_s = compiler_.CompileToIR(kRollingAggQuery, compiler_state_.get());
+  ASSERT_OK(graph_or_s);
+  auto graph = graph_or_s.ConsumeValueOrDie();
+
+  // The rolling window is merged into the agg that follows it.
+  EXPECT_EQ(0, graph->FindNodesOfType(IRNodeType::kRolling).size());
+  std::vector<IRNode*> agg_nodes = graph->FindNodesOfType(IRNodeType::kBlockingAgg);
+  ASSERT_EQ(agg_nodes.size(), 1);
+  auto agg = static_cast<BlockingAggIR*>(agg_nodes[0]);
+  ASSERT_MATCH(agg->parents()[0], MemorySource());
+
+  std::vector<std::string> group_names;
+  for (ColumnIR* g : agg->groups()) {
+    group_names.push_back(g->col_name());
+  }
+  EXPECT_THAT(group_names, ElementsAre("time_", "remote_port"));
+  Relation agg_relation({types::TIME64NS, types::INT64, types::INT64},
+                        {"time_", "remote_port", "count"});
+  EXPECT_EQ(agg_relation, agg->relation());
+
+  planpb::Operator op;
+  ASSERT_OK(agg->ToProto(&op));
+  ASSERT_TRUE(op.agg_op().has_time_window());
+  EXPECT_EQ(0, op.agg_op().time_window().group_index());
+  EXPECT_EQ(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(3)).count(),
+            op.agg_op().time_window().size_ns());
+  EXPECT_EQ(0, op.agg_op().time_window().slide_ns());
+}
+
+constexpr char kStreamRollingAggQuery[] = R"pxl(
+import px
+t1 = px.DataFrame(table='http_events', select=['time_', 'remote_addr', 'remote_port'])
+t1 = t1.rolling('3s').groupby('remote_port').agg(count=('remote_addr', px.count))
+px.display(t1.stream())
+)pxl";
+TEST_F(CompilerTest, StreamRollingAggQuery) {
+  auto graph_or_s = compiler_.CompileToIR(kStreamRollingAggQuery, compiler_state_.get());
+  ASSERT_OK(graph_or_s);
+  auto graph = graph_or_s.ConsumeValueOrDie();
+
+  std::vector<IRNode*> mem_srcs = graph->FindNodesOfType(IRNodeType::kMemorySource);
+  ASSERT_EQ(mem_srcs.size(), 1);
+  EXPECT_TRUE(static_cast<MemorySourceIR*>(mem_srcs[0])->streaming());
+}
+
+constexpr char kStreamAggQuery[] = R"pxl(
+import px
+t1 = px.DataFrame(table='http_events', select=['time_', 'remote_addr', 'remote_port'])
+t1 = t1.groupby('remote_port').agg(count=('remote_addr', px.count))
+px.display(t1.stream())
+)pxl";
+TEST_F(CompilerTest, StreamAggWithoutRollingUnsupported) {
+  auto graph_or_s = compiler_.CompileToIR(kStreamAggQuery, compiler_state_.get());
+  ASSERT_NOT_OK(graph_or_s);
+  EXPECT_THAT(graph_or_s.status().msg(),
+              ContainsRegex("df.stream\\(\\) not yet supported with blocking operator"));
+}
+
 const char* kFunctionOptimizationQuery = R"pxl(
 import px
 bytes_per_mb = 1024.0 * 1024.0
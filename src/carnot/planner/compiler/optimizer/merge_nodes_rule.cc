@@ -115,6 +115,33 @@ bool CompareExpressionLists(const ColExpressionVector& exprs_a,
   return true;
 }
 
+/**
+ * @brief Returns true if the maps compute some of the same function expressions, under the same
+ * names, and none of their names clash with a different expression.
+ *
+ * Such maps are merged into one map that computes the expressions of both once, and the children
+ * of each read their own columns out of it through a projection.
+ */
+bool ShareExpressions(const ColExpressionVector& exprs_a, const ColExpressionVector& exprs_b) {
+  absl::flat_hash_map<std::string, ExpressionIR*> expr_map;
+  for (const auto& e : exprs_a) {
+    expr_map[e.name] = e.node;
+  }
+  bool shares_func = false;
+  for (const auto& e : exprs_b) {
+    auto it = expr_map.find(e.name);
+    if (it == expr_map.end()) {
+      continue;
+    }
+    if (!e.node->Equals(it->second)) {
+      return false;
+    }
+    // Column expressions are copies, so only sharing a function saves any work.
+    shares_func |= Match(e.node, Func());
+  }
+  return shares_func;
+}
+
 bool DoTimeIntervalsMerge(MemorySourceIR* src_a, MemorySourceIR* src_b) {
   if (src_a->IsTimeSet() != src_b->IsTimeSet()) {
     return false;
@@ -160,12 +187,26 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     if (!DoTimeIntervalsMerge(src_a, src_b)) {
       return false;
     }
+    // Sources only share their reads if they read the same sample.
+    if (src_a->HasSample() != src_b->HasSample() ||
+        (src_a->HasSample() &&
+         src_a->sample().SerializeAsString() != src_b->sample().SerializeAsString())) {
+      return false;
+    }
 
     return src_a->table_name() == src_b->table_name();
   } else if (Match(a, Map())) {
     auto map_a = static_cast<MapIR*>(a);
     auto map_b = static_cast<MapIR*>(b);
-    return CompareExpressionLists(map_a->col_exprs(), map_b->col_exprs());
+    if (CompareExpressionLists(map_a->col_exprs(), map_b->col_exprs())) {
+      return true;
+    }
+    // Maps that diverge after a shared prefix of expressions, e.g. the maps of the different
+    // outputs of a script over the same source.
+    DCHECK_EQ(a->parents().size(), 1UL);
+    DCHECK_EQ(b->parents().size(), 1UL);
+    return a->parents()[0] == b->parents()[0] && !map_a->keep_input_columns() &&
+           !map_b->keep_input_columns() && ShareExpressions(map_a->col_exprs(), map_b->col_exprs());
   } else if (Match(a, BlockingAgg())) {
     auto agg_a = static_cast<BlockingAggIR*>(a);
     auto agg_b = static_cast<BlockingAggIR*>(b);
@@ -198,8 +239,8 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     auto filter_b = static_cast<FilterIR*>(b);
     // Filter's output relation mirrors its input parent relation, so two filters can only be
     // merged if they share the same output relation.
-    DCHECK_EQ(1, a->parents().size());
-    DCHECK_EQ(1, b->parents().size());
+    DCHECK_EQ(a->parents().size(), 1UL);
+    DCHECK_EQ(b->parents().size(), 1UL);
     return filter_a->filter_expr()->Equals(filter_b->filter_expr()) &&
            a->parents()[0]->relation() == b->parents()[0]->relation();
   } else if (Match(a, Limit())) {
@@ -207,8 +248,8 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     auto limit_b = static_cast<LimitIR*>(b);
     // Limit's output relation mirrors its input parent relation, so two limits can only be
     // merged if they share the same output relation.
-    DCHECK_EQ(1, a->parents().size());
-    DCHECK_EQ(1, b->parents().size());
+    DCHECK_EQ(a->parents().size(), 1UL);
+    DCHECK_EQ(b->parents().size(), 1UL);
     return limit_a->limit_value() == limit_b->limit_value() &&
            a->parents()[0]->relation() == b->parents()[0]->relation();
   }
@@ -246,9 +287,12 @@ std::vector<MatchingSet> MergeNodesRule::FindMatchingSets(
       if (has_matching_set.contains(comparison_op)) {
         continue;
       }
-      // Check whether the operators are merge-able. CanMerge must be transitive across all
-      // operators.
-      if (CanMerge(base_op, comparison_op)) {
+      // Check whether the operator can merge with every operator of the set. CanMerge isn't
+      // transitive for maps that share only some of their expressions.
+      bool can_merge = std::all_of(
+          current_set.operators.begin(), current_set.operators.end(),
+          [&](OperatorIR* set_op) { return CanMerge(set_op, comparison_op); });
+      if (can_merge) {
         has_matching_set.insert(comparison_op);
         current_set.operators.push_back(comparison_op);
       }
@@ -379,9 +423,11 @@ StatusOr<OperatorIR*> MergeNodesRule::MergeOps(IR* graph,
       PL_RETURN_IF_ERROR(MergeExprs(&expr_list, &exprs, other_agg->aggregate_expressions()));
     }
 
-    PL_ASSIGN_OR_RETURN(merged_op,
+    PL_ASSIGN_OR_RETURN(BlockingAggIR * merged_agg,
                         graph->CreateNode<BlockingAggIR>(base_agg->ast(), base_agg->parents()[0],
                                                          base_agg->groups(), expr_list));
+    merged_agg->set_sample_rate(base_agg->sample_rate());
+    merged_op = merged_agg;
 
   } else if (Match(base_op, Join())) {
     auto join = static_cast<JoinIR*>(base_op);
@@ -420,8 +466,57 @@ StatusOr<MapIR*> MakeNoOpMap(IR* graph, CompilerState* compiler_state, OperatorI
   return map;
 }
 
-Status ReplaceOpsWithMerged(CompilerState* compiler_state, OperatorIR* merged,
-                            const std::vector<OperatorIR*>& operators_to_merge) {
+// Returns a map that selects the columns of the relation out of the merged operator.
+StatusOr<MapIR*> MakeProjectionMap(IR* graph, CompilerState* compiler_state, OperatorIR* merged,
+                                   const table_store::schema::Relation& relation) {
+  ColExpressionVector exprs;
+  for (const auto& col_name : relation.col_names()) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col, graph->CreateNode<ColumnIR>(merged->ast(), col_name,
+                                                                    /* parent_op_idx */ 0));
+    col->ResolveColumnType(merged->relation());
+    exprs.emplace_back(col_name, col);
+  }
+  PL_ASSIGN_OR_RETURN(MapIR * map, graph->CreateNode<MapIR>(merged->ast(), merged, exprs,
+                                                            /* keep_input_columns */ false));
+
+  OperatorRelationRule rule(compiler_state);
+  PL_ASSIGN_OR_RETURN(bool did_change, rule.Apply(map));
+  DCHECK(did_change);
+  return map;
+}
+
+/**
+ * @brief Replaces the operators with the merged one, as the parent of their children.
+ *
+ * @return the projections that the children of the merged maps read their own columns through,
+ * when the merged map has more columns than they did.
+ */
+StatusOr<std::vector<OperatorIR*>> ReplaceOpsWithMerged(
+    CompilerState* compiler_state, OperatorIR* merged,
+    const std::vector<OperatorIR*>& operators_to_merge) {
+  // The operator that the children of each merged operator read.
+  absl::flat_hash_map<OperatorIR*, OperatorIR*> replacements;
+  std::vector<OperatorIR*> projections;
+  for (OperatorIR* o : operators_to_merge) {
+    replacements[o] = merged;
+    if (!Match(merged, Map()) || o->relation() == merged->relation()) {
+      continue;
+    }
+    // Operators with the same columns share a projection.
+    for (OperatorIR* projection : projections) {
+      if (projection->relation() == o->relation()) {
+        replacements[o] = projection;
+        break;
+      }
+    }
+    if (replacements[o] == merged) {
+      PL_ASSIGN_OR_RETURN(MapIR * projection, MakeProjectionMap(merged->graph(), compiler_state,
+                                                                merged, o->relation()));
+      projections.push_back(projection);
+      replacements[o] = projection;
+    }
+  }
+
   absl::flat_hash_map<OperatorIR*, std::vector<OperatorIR*>> child_to_parent_map;
   for (OperatorIR* o : operators_to_merge) {
     for (OperatorIR* c : o->Children()) {
@@ -430,17 +525,15 @@ Status ReplaceOpsWithMerged(CompilerState* compiler_state, OperatorIR* merged,
   }
   for (const auto& [child, parents] : child_to_parent_map) {
     DCHECK_GE(parents.size(), 1UL);
-    // TODO(philkuz) (PP-1812) need to figure out how we would propagate information about
-    // renamed output columns to the children. We'll need to add some data structure
-    // that describes the transformation of o -> merged.
-    PL_RETURN_IF_ERROR(child->ReplaceParent(parents[0], merged));
+    PL_RETURN_IF_ERROR(child->ReplaceParent(parents[0], replacements[parents[0]]));
     // Insert a no-op map for each following parent that is repeated.
     for (int64_t i = 1; i < static_cast<int64_t>(parents.size()); ++i) {
-      PL_ASSIGN_OR_RETURN(MapIR * map, MakeNoOpMap(parents[i]->graph(), compiler_state, merged));
+      PL_ASSIGN_OR_RETURN(MapIR * map, MakeNoOpMap(parents[i]->graph(), compiler_state,
+                                                   replacements[parents[i]]));
       PL_RETURN_IF_ERROR(child->ReplaceParent(parents[i], map));
     }
   }
-  return Status::OK();
+  return projections;
 }
 
 Status RemoveMergedOps(IR* graph, const std::vector<OperatorIR*>& ops_to_merge) {
@@ -512,18 +605,41 @@ StatusOr<bool> MergeNodesRule::Execute(IR* graph) {
     }
 
     // Merge the operators together. If there's only one operator then we don't need to merge it.
+    std::vector<OperatorIR*> projections;
     if (ms.operators.size() > 1) {
       did_merge = true;
       PL_ASSIGN_OR_RETURN(OperatorIR * merged_op, MergeOps(graph, ms.operators));
-      PL_RETURN_IF_ERROR(ReplaceOpsWithMerged(compiler_state_, merged_op, ms.operators));
+      PL_ASSIGN_OR_RETURN(projections,
+                          ReplaceOpsWithMerged(compiler_state_, merged_op, ms.operators));
       PL_RETURN_IF_ERROR(RemoveMergedOps(graph, ms.operators));
       observed_ops.insert(merged_op->id());
+      for (OperatorIR* projection : projections) {
+        observed_ops.insert(projection->id());
+      }
     }
 
-    // Take the children, find the matching sets and then insert them back into the queue.
-    for (const auto& s : FindMatchingSets(all_children)) {
+    // Take the children, find the matching sets and then insert them back into the queue. The
+    // children that read different projections of a merged map belong to different branches, so
+    // they are only matched with the children that read the same projection.
+    absl::flat_hash_map<OperatorIR*, std::vector<OperatorIR*>> children_by_projection;
+    std::vector<OperatorIR*> other_children;
+    for (OperatorIR* c : all_children) {
+      auto projection = std::find_first_of(c->parents().begin(), c->parents().end(),
+                                           projections.begin(), projections.end());
+      if (projection == c->parents().end()) {
+        other_children.push_back(c);
+      } else {
+        children_by_projection[*projection].push_back(c);
+      }
+    }
+    for (const auto& s : FindMatchingSets(other_children)) {
       matching_set_q.push(s);
     }
+    for (OperatorIR* projection : projections) {
+      for (const auto& s : FindMatchingSets(children_by_projection[projection])) {
+        matching_set_q.push(s);
+      }
+    }
   }
   return did_merge;
 }
@@ -66,6 +66,10 @@ class MergeNodesRule : public Rule {
   /**
    * @brief CanMerge returns whether two Operators can merge in line with our merging criteria.
    *
+   * Maps of the same parent that only share some of their function expressions can merge too: the
+   * merged map computes the expressions of both, and the children of each read their columns out
+   * of it through a projection.
+   *
    * @param a operator to compare
    * @param b operator to compare
    * @return true: the operators can merge into one.
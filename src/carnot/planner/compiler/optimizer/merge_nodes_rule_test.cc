@@ -270,6 +270,73 @@ TEST_F(MergeNodesTest, limit_merge_different_relations_shouldnt_merge) {
   EXPECT_FALSE(rule.CanMerge(limit1, limit2));
 }
 
+TEST_F(MergeNodesTest, maps_sharing_expressions_can_merge) {
+  auto mem_src = MakeMemSource("cpu", {"upid", "cpu0", "cpu1"});
+  auto map1 = MakeMap(mem_src, {{"cpu0_mo", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(2))},
+                                {"cpu1_mo", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(2))}});
+  auto map2 = MakeMap(mem_src, {{"cpu0_mo", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(2))},
+                                {"cpu1_po", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(3))}});
+  // Same name as in map1, different expression.
+  auto map3 = MakeMap(mem_src, {{"cpu0_mo", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(2))},
+                                {"cpu1_mo", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(3))}});
+  // Shares only a column.
+  auto map4 = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu0", 0)},
+                                {"cpu1_mo", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(4))}});
+  auto map5 = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu0", 0)}});
+  for (auto map : {map1, map2, map3, map4, map5}) {
+    MakeMemSink(map, "");
+  }
+
+  EXPECT_OK(Analyze(graph));
+
+  MergeNodesRule rule(compiler_state_.get());
+  EXPECT_TRUE(rule.CanMerge(map1, map2));
+  EXPECT_TRUE(rule.CanMerge(map2, map3));
+  EXPECT_FALSE(rule.CanMerge(map1, map3));
+  EXPECT_FALSE(rule.CanMerge(map4, map5));
+
+  // map3 can merge with map2, but not with map1 which is in the same set.
+  auto matching_sets = rule.FindMatchingSets({map1, map2, map3});
+  ASSERT_EQ(matching_sets.size(), 2);
+  EXPECT_THAT(matching_sets[0].operators, ElementsAre(map1, map2));
+  EXPECT_THAT(matching_sets[1].operators, ElementsAre(map3));
+}
+
+TEST_F(MergeNodesTest, merge_maps_sharing_expressions) {
+  auto mem_src = MakeMemSource("cpu", {"upid", "cpu0", "cpu1"});
+  mem_src->SetTimeValuesNS(10, 100);
+  auto map1 = MakeMap(mem_src, {{"cpu0_mo", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(2))},
+                                {"cpu1_mo", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(2))}});
+  auto map2 = MakeMap(mem_src, {{"cpu0_mo", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(2))},
+                                {"cpu1_po", MakeAddFunc(MakeColumn("cpu1", 0), MakeInt(3))}});
+  auto sink1 = MakeMemSink(map1, "1");
+  auto sink2 = MakeMemSink(map2, "2");
+
+  EXPECT_OK(Analyze(graph));
+
+  MergeNodesRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  // The shared expression is computed once, by a map that computes the columns of both.
+  ASSERT_EQ(mem_src->Children().size(), 1UL);
+  ASSERT_MATCH(mem_src->Children()[0], Map());
+  auto merged_map = static_cast<MapIR*>(mem_src->Children()[0]);
+  EXPECT_THAT(merged_map->relation().col_names(), ElementsAre("cpu0_mo", "cpu1_mo", "cpu1_po"));
+
+  // Each sink reads its own columns out of the merged map.
+  ASSERT_EQ(sink1->parents().size(), 1UL);
+  ASSERT_MATCH(sink1->parents()[0], Map());
+  EXPECT_EQ(sink1->parents()[0]->parents()[0], merged_map);
+  EXPECT_THAT(sink1->parents()[0]->relation().col_names(), ElementsAre("cpu0_mo", "cpu1_mo"));
+
+  ASSERT_EQ(sink2->parents().size(), 1UL);
+  ASSERT_MATCH(sink2->parents()[0], Map());
+  EXPECT_EQ(sink2->parents()[0]->parents()[0], merged_map);
+  EXPECT_THAT(sink2->parents()[0]->relation().col_names(), ElementsAre("cpu0_mo", "cpu1_po"));
+}
+
 }  // namespace compiler
 }  // namespace planner
 }  // namespace carnot
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/optimizer/push_zone_map_predicates_rule.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// Returns the predicate op of a comparison, flipped if the column is on the right hand side.
+std::optional<planpb::ZoneMapPredicate::Op> ComparisonOp(FuncIR::Opcode opcode,
+                                                         bool column_on_left) {
+  switch (opcode) {
+    case FuncIR::Opcode::eq:
+      return planpb::ZoneMapPredicate::EQUAL;
+    case FuncIR::Opcode::lt:
+      return column_on_left ? planpb::ZoneMapPredicate::LESS_THAN
+                            : planpb::ZoneMapPredicate::GREATER_THAN;
+    case FuncIR::Opcode::lteq:
+      return column_on_left ? planpb::ZoneMapPredicate::LESS_THAN_EQUAL
+                            : planpb::ZoneMapPredicate::GREATER_THAN_EQUAL;
+    case FuncIR::Opcode::gt:
+      return column_on_left ? planpb::ZoneMapPredicate::GREATER_THAN
+                            : planpb::ZoneMapPredicate::LESS_THAN;
+    case FuncIR::Opcode::gteq:
+      return column_on_left ? planpb::ZoneMapPredicate::GREATER_THAN_EQUAL
+                            : planpb::ZoneMapPredicate::LESS_THAN_EQUAL;
+    default:
+      return std::nullopt;
+  }
+}
+
+bool IsNumericConstant(const ExpressionIR* expr) {
+  return expr->type() == IRNodeType::kInt || expr->type() == IRNodeType::kFloat ||
+         expr->type() == IRNodeType::kTime;
+}
+
+bool HasZoneMap(types::DataType data_type) {
+  return data_type == types::DataType::INT64 || data_type == types::DataType::FLOAT64 ||
+         data_type == types::DataType::TIME64NS;
+}
+
+// Matches `upid == <UINT128>`, `upid_to_pod_name(upid) == "<pod>"` and
+// `upid_to_service_name(upid) == "<service>"`, either way around, which is what filters on
+// ctx['pod'] and ctx['service'] compile to. They become an IN predicate on the UPID column, whose
+// names the PEM resolves into the UPIDs of the matching processes.
+std::optional<MemorySourceIR::ZoneMapPredicate> UPIDPredicate(FuncIR* func,
+                                                              MemorySourceIR* mem_src) {
+  for (size_t i = 0; i < 2; ++i) {
+    ExpressionIR* lhs = func->args()[i];
+    ExpressionIR* rhs = func->args()[1 - i];
+    MemorySourceIR::ZoneMapPredicate predicate;
+    predicate.op = planpb::ZoneMapPredicate::IN;
+    ExpressionIR* column_expr = lhs;
+    if (Match(lhs, Func()) && Match(rhs, String())) {
+      auto name_func = static_cast<FuncIR*>(lhs);
+      std::string name = static_cast<StringIR*>(rhs)->str();
+      // Processes without metadata have an empty name, and pods with several services have a
+      // list of them, neither of which the PEM resolves.
+      if (name_func->args().size() != 1 || name.empty() || name[0] == '[') {
+        continue;
+      }
+      if (name_func->func_name() == "upid_to_pod_name") {
+        predicate.pod_names.push_back(name);
+      } else if (name_func->func_name() == "upid_to_service_name") {
+        predicate.service_names.push_back(name);
+      } else {
+        continue;
+      }
+      column_expr = name_func->args()[0];
+    } else if (Match(rhs, UInt128Value())) {
+      planpb::ScalarValue value;
+      if (!static_cast<DataIR*>(rhs)->ToProto(&value).ok()) {
+        continue;
+      }
+      predicate.values.push_back(std::move(value));
+    } else {
+      continue;
+    }
+    if (!Match(column_expr, ColumnNode())) {
+      continue;
+    }
+    auto column = static_cast<ColumnIR*>(column_expr);
+    const auto& relation = mem_src->relation();
+    if (!relation.HasColumn(column->col_name()) ||
+        relation.GetColumnType(column->col_name()) != types::DataType::UINT128) {
+      continue;
+    }
+    predicate.column_name = column->col_name();
+    return predicate;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+void PushZoneMapPredicatesRule::CollectPredicates(
+    ExpressionIR* expr, MemorySourceIR* mem_src,
+    std::vector<MemorySourceIR::ZoneMapPredicate>* predicates) {
+  if (!Match(expr, Func())) {
+    return;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  if (func->args().size() != 2) {
+    return;
+  }
+  if (func->opcode() == FuncIR::Opcode::logand) {
+    CollectPredicates(func->args()[0], mem_src, predicates);
+    CollectPredicates(func->args()[1], mem_src, predicates);
+    return;
+  }
+  if (func->opcode() == FuncIR::Opcode::eq) {
+    auto upid_predicate = UPIDPredicate(func, mem_src);
+    if (upid_predicate.has_value()) {
+      predicates->push_back(std::move(upid_predicate.value()));
+      return;
+    }
+  }
+
+  bool column_on_left = Match(func->args()[0], ColumnNode());
+  ExpressionIR* column_expr = column_on_left ? func->args()[0] : func->args()[1];
+  ExpressionIR* value_expr = column_on_left ? func->args()[1] : func->args()[0];
+  if (!Match(column_expr, ColumnNode()) || !IsNumericConstant(value_expr)) {
+    return;
+  }
+  auto op = ComparisonOp(func->opcode(), column_on_left);
+  if (!op.has_value()) {
+    return;
+  }
+  auto column = static_cast<ColumnIR*>(column_expr);
+  const auto& relation = mem_src->relation();
+  if (!relation.HasColumn(column->col_name()) ||
+      !HasZoneMap(relation.GetColumnType(column->col_name()))) {
+    return;
+  }
+
+  MemorySourceIR::ZoneMapPredicate predicate;
+  predicate.column_name = column->col_name();
+  predicate.op = op.value();
+  if (!static_cast<DataIR*>(value_expr)->ToProto(&predicate.value).ok()) {
+    return;
+  }
+  predicates->push_back(std::move(predicate));
+}
+
+StatusOr<bool> PushZoneMapPredicatesRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Filter())) {
+    return false;
+  }
+  auto filter = static_cast<FilterIR*>(ir_node);
+  if (!Match(filter->parents()[0], MemorySource())) {
+    return false;
+  }
+  auto mem_src = static_cast<MemorySourceIR*>(filter->parents()[0]);
+  // Skipped batches don't reach any of the source's children, so the filter has to be the only
+  // one. A source only takes the predicates of one filter, which also keeps this rule idempotent.
+  if (mem_src->Children().size() != 1 || !mem_src->zone_map_predicates().empty() ||
+      !mem_src->IsRelationInit()) {
+    return false;
+  }
+
+  std::vector<MemorySourceIR::ZoneMapPredicate> predicates;
+  CollectPredicates(filter->filter_expr(), mem_src, &predicates);
+  for (const auto& predicate : predicates) {
+    mem_src->AddZoneMapPredicate(predicate);
+  }
+  return !predicates.empty();
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
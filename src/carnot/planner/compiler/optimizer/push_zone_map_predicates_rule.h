@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Pushes the comparisons between numeric columns and constants of a filter that reads
+ * directly from a memory source into the source as zone map predicates, so that the source can
+ * skip the batches that the filter would drop entirely. The filter itself is kept: the source
+ * doesn't filter the rows of the batches it reads.
+ *
+ * Equality filters on a UPID column, including those on the pod or service name of the UPID
+ * (i.e. ctx['pod'] and ctx['service']), are pushed down as IN predicates, which the source checks
+ * against the distinct UPIDs of each batch.
+ *
+ * Only the conjuncts of the filter expression are pushed down, and only when the filter is the
+ * source's only child.
+ */
+class PushZoneMapPredicatesRule : public Rule {
+ public:
+  PushZoneMapPredicatesRule()
+      : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  static void CollectPredicates(ExpressionIR* expr, MemorySourceIR* mem_src,
+                                std::vector<MemorySourceIR::ZoneMapPredicate>* predicates);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/optimizer/push_zone_map_predicates_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using PushZoneMapPredicatesRuleTest = RulesTest;
+
+TEST_F(PushZoneMapPredicatesRuleTest, conjunction) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto count_gt = graph
+                      ->CreateNode<FuncIR>(ast, FuncIR::op_map.find(">")->second,
+                                           std::vector<ExpressionIR*>{MakeColumn("count", 0),
+                                                                      MakeInt(10)})
+                      .ConsumeValueOrDie();
+  // The column is on the right hand side, so the op is flipped.
+  auto cpu0_lteq = graph
+                       ->CreateNode<FuncIR>(ast, FuncIR::op_map.find(">=")->second,
+                                            std::vector<ExpressionIR*>{MakeFloat(0.5),
+                                                                       MakeColumn("cpu0", 0)})
+                       .ConsumeValueOrDie();
+  // Comparisons between columns can't be checked against zone maps.
+  auto cpu1_eq = MakeEqualsFunc(MakeColumn("cpu1", 0), MakeColumn("cpu2", 0));
+  auto filter = MakeFilter(mem_src, MakeAndFunc(MakeAndFunc(count_gt, cpu0_lteq), cpu1_eq));
+  MakeMemSink(filter, "abc");
+
+  PushZoneMapPredicatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  const auto& predicates = mem_src->zone_map_predicates();
+  ASSERT_EQ(2, predicates.size());
+  EXPECT_EQ("count", predicates[0].column_name);
+  EXPECT_EQ(planpb::ZoneMapPredicate::GREATER_THAN, predicates[0].op);
+  EXPECT_EQ(10, predicates[0].value.int64_value());
+  EXPECT_EQ("cpu0", predicates[1].column_name);
+  EXPECT_EQ(planpb::ZoneMapPredicate::LESS_THAN_EQUAL, predicates[1].op);
+  EXPECT_EQ(0.5, predicates[1].value.float64_value());
+
+  planpb::Operator op;
+  ASSERT_OK(mem_src->ToProto(&op));
+  ASSERT_EQ(2, op.mem_source_op().predicates_size());
+  EXPECT_EQ(0, op.mem_source_op().predicates(0).column_idx());
+  EXPECT_EQ(1, op.mem_source_op().predicates(1).column_idx());
+
+  // The source already has the predicates of the filter.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(PushZoneMapPredicatesRuleTest, disjunction_not_pushed) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto filter = MakeFilter(mem_src, MakeOrFunc(MakeEqualsFunc(MakeColumn("count", 0), MakeInt(1)),
+                                               MakeEqualsFunc(MakeColumn("count", 0), MakeInt(2))));
+  MakeMemSink(filter, "abc");
+
+  PushZoneMapPredicatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(mem_src->zone_map_predicates().empty());
+}
+
+TEST_F(PushZoneMapPredicatesRuleTest, source_with_other_children) {
+  MemorySourceIR* mem_src = MakeMemSource(MakeRelation());
+  auto filter = MakeFilter(mem_src, MakeEqualsFunc(MakeColumn("count", 0), MakeInt(1)));
+  MakeMemSink(filter, "abc");
+  // The rows of the skipped batches would be missing from this sink.
+  MakeMemSink(mem_src, "def");
+
+  PushZoneMapPredicatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_TRUE(mem_src->zone_map_predicates().empty());
+}
+
+TEST_F(PushZoneMapPredicatesRuleTest, upid_predicates) {
+  table_store::schema::Relation relation({types::DataType::TIME64NS, types::DataType::UINT128},
+                                         {"time_", "upid"});
+  MemorySourceIR* mem_src = MakeMemSource(relation);
+  // What df.ctx['pod'] == 'pl/pod' compiles to.
+  auto pod_eq = MakeEqualsFunc(MakeFunc("upid_to_pod_name", {MakeColumn("upid", 0)}),
+                               MakeString("pl/pod"));
+  auto service_eq = MakeEqualsFunc(MakeString("pl/service"),
+                                   MakeFunc("upid_to_service_name", {MakeColumn("upid", 0)}));
+  auto upid_eq =
+      MakeEqualsFunc(MakeColumn("upid", 0), MakeUInt128("11285cdd-1de9-4ab1-ae6a-0ba08c8c676c"));
+  // Other metadata can't be resolved into UPIDs by the PEM.
+  auto node_eq = MakeEqualsFunc(MakeFunc("upid_to_node_name", {MakeColumn("upid", 0)}),
+                                MakeString("node"));
+  auto filter = MakeFilter(
+      mem_src, MakeAndFunc(MakeAndFunc(pod_eq, service_eq), MakeAndFunc(upid_eq, node_eq)));
+  MakeMemSink(filter, "abc");
+
+  PushZoneMapPredicatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  const auto& predicates = mem_src->zone_map_predicates();
+  ASSERT_EQ(3, predicates.size());
+  for (const auto& predicate : predicates) {
+    EXPECT_EQ("upid", predicate.column_name);
+    EXPECT_EQ(planpb::ZoneMapPredicate::IN, predicate.op);
+  }
+  EXPECT_THAT(predicates[0].pod_names, ::testing::ElementsAre("pl/pod"));
+  EXPECT_THAT(predicates[1].service_names, ::testing::ElementsAre("pl/service"));
+  ASSERT_EQ(1, predicates[2].values.size());
+  EXPECT_TRUE(predicates[2].values[0].has_uint128_value());
+
+  planpb::Operator op;
+  ASSERT_OK(mem_src->ToProto(&op));
+  ASSERT_EQ(3, op.mem_source_op().predicates_size());
+  EXPECT_EQ(1, op.mem_source_op().predicates(0).column_idx());
+  EXPECT_EQ("pl/pod", op.mem_source_op().predicates(0).pod_names(0));
+}
+
+TEST_F(PushZoneMapPredicatesRuleTest, empty_pod_name_not_pushed) {
+  table_store::schema::Relation relation({types::DataType::TIME64NS, types::DataType::UINT128},
+                                         {"time_", "upid"});
+  MemorySourceIR* mem_src = MakeMemSource(relation);
+  // Processes without metadata have an empty pod name, so no UPIDs can be resolved for it.
+  auto pod_eq =
+      MakeEqualsFunc(MakeFunc("upid_to_pod_name", {MakeColumn("upid", 0)}), MakeString(""));
+  auto filter = MakeFilter(mem_src, pod_eq);
+  MakeMemSink(filter, "abc");
+
+  PushZoneMapPredicatesRule rule;
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
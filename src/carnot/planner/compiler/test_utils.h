@@ -558,6 +558,13 @@ class OperatorTests : public ::testing::Test {
     return limit;
   }
 
+  TopKIR* MakeTopK(OperatorIR* parent, const std::vector<std::string>& sort_cols,
+                   const std::vector<bool>& descending, int64_t limit_value) {
+    TopKIR* top_k = graph->CreateNode<TopKIR>(ast, parent, sort_cols, descending, limit_value)
+                        .ConsumeValueOrDie();
+    return top_k;
+  }
+
   BlockingAggIR* MakeBlockingAgg(OperatorIR* parent, const std::vector<ColumnIR*>& columns,
                                  const ColExpressionVector& col_agg) {
     BlockingAggIR* agg =
@@ -1359,6 +1366,13 @@ void CompareCloneNode(LimitIR* new_ir, LimitIR* old_ir, const std::string& err_s
   EXPECT_EQ(new_ir->limit_value_set(), old_ir->limit_value_set()) << err_string;
 }
 
+template <>
+void CompareCloneNode(TopKIR* new_ir, TopKIR* old_ir, const std::string& err_string) {
+  EXPECT_EQ(new_ir->limit_value(), old_ir->limit_value()) << err_string;
+  EXPECT_EQ(new_ir->sort_cols(), old_ir->sort_cols()) << err_string;
+  EXPECT_EQ(new_ir->descending(), old_ir->descending()) << err_string;
+}
+
 template <>
 void CompareCloneNode(FuncIR* new_ir, FuncIR* old_ir, const std::string& err_string) {
   EXPECT_EQ(new_ir->func_name(), old_ir->func_name()) << err_string;
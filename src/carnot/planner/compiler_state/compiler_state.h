@@ -24,6 +24,8 @@
 #include <unordered_map>
 #include <utility>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/planner/compiler_state/registry_info.h"
 
 #include "src/common/base/base.h"
@@ -60,7 +62,21 @@ class CompilerState : public NotCopyable {
 
   RelationMap* relation_map() const { return relation_map_.get(); }
   RegistryInfo* registry_info() const { return registry_info_; }
-  types::Time64NSValue time_now() const { return time_now_; }
+  types::Time64NSValue time_now() const {
+    time_now_used_ = true;
+    return time_now_;
+  }
+  // Whether time_now() was read, i.e. whether the compiled plan depends on the compile time.
+  bool time_now_used() const { return time_now_used_; }
+  // Returns the time offset_ns from now, for the relative start and stop times of memory sources
+  // (e.g. start_time='-5m'). Unlike time_now(), it keeps the plan reusable: the returned times are
+  // recorded, so that they can be moved to the time of a later query.
+  int64_t RelativeTime(int64_t offset_ns) {
+    int64_t time = time_now_.val + offset_ns;
+    relative_times_.insert(time);
+    return time;
+  }
+  const absl::flat_hash_set<int64_t>& relative_times() const { return relative_times_; }
   const std::string& result_address() const { return result_address_; }
   const std::string& result_ssl_targetname() const { return result_ssl_targetname_; }
 
@@ -94,6 +110,8 @@ class CompilerState : public NotCopyable {
   std::unique_ptr<RelationMap> relation_map_;
   RegistryInfo* registry_info_;
   types::Time64NSValue time_now_;
+  mutable bool time_now_used_ = false;
+  absl::flat_hash_set<int64_t> relative_times_;
   std::map<RegistryKey, int64_t> udf_to_id_map_;
   std::map<RegistryKey, int64_t> uda_to_id_map_;
 
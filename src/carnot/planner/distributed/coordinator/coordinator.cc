@@ -31,6 +31,7 @@
 #include "src/carnot/planner/distributed/splitter/splitter.h"
 #include "src/carnot/planner/rules/rules.h"
 #include "src/carnot/udfspb/udfs.pb.h"
+#include "src/common/base/worker_pool.h"
 #include "src/common/uuid/uuid.h"
 #include "src/shared/upid/upid.h"
 
@@ -161,6 +162,8 @@ Status CoordinatorImpl::RemoveSourcesAndDependentOperators(
 const distributedpb::CarnotInfo& CoordinatorImpl::GetRemoteProcessor() const {
   // TODO(philkuz) update this with a more sophisticated strategy in the future.
   DCHECK_GT(remote_processor_nodes_.size(), 0UL);
+  // The plans are always made for the first Kelvin, so that they don't depend on the Kelvin and
+  // can be cached. LogicalPlanner::PlanProto() moves each query to its own Kelvin.
   return remote_processor_nodes_[0];
 }
 
@@ -173,6 +176,29 @@ struct AgentToPlanMap {
   absl::flat_hash_map<IR*, absl::flat_hash_set<int64_t>> plan_to_agents;
 };
 
+/**
+ * @brief Creates the plan of every cluster. The clusters only read the query while they clone
+ * it, so the plans are created concurrently on the worker pool.
+ */
+StatusOr<std::vector<std::unique_ptr<IR>>> CreateClusterPlans(
+    const std::vector<PlanCluster>& clusters, const IR* query) {
+  std::vector<std::unique_ptr<IR>> cluster_plans(clusters.size());
+  std::vector<Status> statuses(clusters.size());
+  WorkerPool::Default()->ParallelFor(clusters.size(), [&](size_t i) {
+    auto plan_or_s = clusters[i].CreatePlan(query);
+    if (!plan_or_s.ok()) {
+      statuses[i] = plan_or_s.status();
+      return;
+    }
+    cluster_plans[i] = plan_or_s.ConsumeValueOrDie();
+  });
+
+  for (const auto& status : statuses) {
+    PL_RETURN_IF_ERROR(status);
+  }
+  return cluster_plans;
+}
+
 StatusOr<AgentToPlanMap> GetUniquePEMPlans(IR* query, DistributedPlan* plan,
                                            const std::vector<int64_t>& carnot_instances,
                                            const SchemaToAgentsMap& schema_map) {
@@ -199,8 +225,9 @@ StatusOr<AgentToPlanMap> GetUniquePEMPlans(IR* query, DistributedPlan* plan,
   if (!remaining_agents.empty()) {
     clusters.emplace_back(remaining_agents, absl::flat_hash_set<OperatorIR*>{});
   }
-  for (const auto& c : clusters) {
-    PL_ASSIGN_OR_RETURN(auto cluster_plan_uptr, c.CreatePlan(query));
+  PL_ASSIGN_OR_RETURN(auto cluster_plans, CreateClusterPlans(clusters, query));
+  for (const auto& [i, c] : Enumerate(clusters)) {
+    auto& cluster_plan_uptr = cluster_plans[i];
     auto cluster_plan = cluster_plan_uptr.get();
     if (cluster_plan->FindNodesThatMatch(Operator()).empty()) {
       continue;
@@ -271,6 +271,30 @@ TEST_F(CoordinatorTest, prune_agents_simple) {
   EXPECT_EQ(2, kelvin_sources.size());
 }
 
+// The plans of the clusters are created concurrently, but each agent always gets its own.
+TEST_F(CoordinatorTest, concurrent_cluster_plans) {
+  for (int i = 0; i < 10; ++i) {
+    auto physical_plan = ThreeAgentOneKelvinCoordinateQuery(kPruneAgentsSimple);
+    absl::flat_hash_map<std::string, IR*> plan_by_qb_addr;
+    for (int64_t carnot_id : physical_plan->dag().nodes()) {
+      auto carnot = physical_plan->Get(carnot_id);
+      plan_by_qb_addr[carnot->QueryBrokerAddress()] = carnot->plan();
+    }
+    ASSERT_THAT(plan_by_qb_addr, UnorderedElementsAre(Key("pem1"), Key("pem2"), Key("kelvin")));
+    EXPECT_NE(plan_by_qb_addr["pem1"], plan_by_qb_addr["pem2"]);
+
+    auto agent1_sinks = plan_by_qb_addr["pem1"]->FindNodesThatMatch(GRPCSink());
+    ASSERT_EQ(1, agent1_sinks.size());
+    EXPECT_MATCH(static_cast<OperatorIR*>(agent1_sinks[0])->parents()[0],
+                 Filter(Equals(MetadataExpression(MetadataType::POD_ID), String("agent1_pod"))));
+    auto agent2_sinks = plan_by_qb_addr["pem2"]->FindNodesThatMatch(GRPCSink());
+    ASSERT_EQ(1, agent2_sinks.size());
+    EXPECT_MATCH(static_cast<OperatorIR*>(agent2_sinks[0])->parents()[0],
+                 Filter(Equals(MetadataExpression(MetadataType::SERVICE_ID),
+                               String("agent2_service"))));
+  }
+}
+
 constexpr char kPruneAgentsDoesNotExist[] = R"pxl(
 import px
 
@@ -65,6 +65,11 @@ StatusOr<bool> PruneUnavailableSourcesRule::MaybePruneMemorySource(MemorySourceI
     PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
     return true;
   }
+
+  if (!AgentHasDataInTimeRange(mem_src)) {
+    PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
+    return true;
+  }
   return false;
 }
 
@@ -78,6 +83,21 @@ bool PruneUnavailableSourcesRule::AgentHasTable(std::string table_name) {
   return schema_iter != schema_map_.end() && schema_iter->second.contains(agent_id_);
 }
 
+bool PruneUnavailableSourcesRule::AgentHasDataInTimeRange(MemorySourceIR* mem_src) {
+  if (!mem_src->IsTimeSet()) {
+    return true;
+  }
+  for (const auto& table_info : carnot_info_.table_info()) {
+    if (table_info.table() != mem_src->table_name()) {
+      continue;
+    }
+    // Only the oldest row is used, because it can only move forward as data expires. The newest
+    // row reported by the agent is already stale when the query runs.
+    return table_info.min_time() == 0 || table_info.min_time() <= mem_src->time_stop_ns();
+  }
+  return true;
+}
+
 StatusOr<bool> PruneUnavailableSourcesRule::MaybePruneUDTFSource(UDTFSourceIR* udtf_src) {
   // If the Agent does execute UDTF and the the UDTF Matches features, then we do not prune.
   if (AgentExecutesUDTF(udtf_src, carnot_info_) && UDTFMatchesFilters(udtf_src, carnot_info_)) {
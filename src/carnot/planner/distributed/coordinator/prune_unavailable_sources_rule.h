@@ -51,6 +51,7 @@ class PruneUnavailableSourcesRule : public Rule {
 
   bool AgentSupportsMemorySources();
   bool AgentHasTable(std::string table_name);
+  bool AgentHasDataInTimeRange(MemorySourceIR* mem_src);
 
   bool IsKelvin(const distributedpb::CarnotInfo& carnot_info);
   bool IsPEM(const distributedpb::CarnotInfo& carnot_info);
@@ -422,6 +422,50 @@ TEST_F(PruneUnavailableSourcesRuleTest, UDTFOnAllAgentsFilterOutNonMatchingAgent
   EXPECT_TRUE(graph->HasNode(union_node_id));
 }
 
+TEST_F(PruneUnavailableSourcesRuleTest, MemorySourceBeforeAgentRetentionIsRemoved) {
+  auto mem_src = MakeMemSource("http_events");
+  mem_src->SetTimeValuesNS(0, 500);
+  auto grpc_sink = MakeGRPCSink(mem_src, 123);
+  auto mem_src_id = mem_src->id();
+  auto grpc_sink_id = grpc_sink->id();
+
+  auto carnot_info = logical_state_.distributed_state().carnot_info()[0];
+  ASSERT_TRUE(IsPEM(carnot_info));
+  auto table_info = carnot_info.add_table_info();
+  table_info->set_table("http_events");
+  table_info->set_min_time(1000);
+  ASSERT_OK_AND_ASSIGN(sole::uuid uuid, ParseUUID(carnot_info.agent_id()));
+  auto agent_id = uuid_to_id_map_[uuid];
+  PruneUnavailableSourcesRule rule(agent_id, carnot_info, {{"http_events", {agent_id}}});
+  auto rule_or_s = rule.Execute(graph.get());
+  ASSERT_OK(rule_or_s);
+  ASSERT_TRUE(rule_or_s.ConsumeValueOrDie());
+
+  EXPECT_FALSE(graph->HasNode(mem_src_id));
+  EXPECT_FALSE(graph->HasNode(grpc_sink_id));
+}
+
+TEST_F(PruneUnavailableSourcesRuleTest, MemorySourceWithinAgentRetentionIsKept) {
+  auto mem_src = MakeMemSource("http_events");
+  mem_src->SetTimeValuesNS(0, 2000);
+  MakeGRPCSink(mem_src, 123);
+  auto mem_src_id = mem_src->id();
+
+  auto carnot_info = logical_state_.distributed_state().carnot_info()[0];
+  ASSERT_TRUE(IsPEM(carnot_info));
+  auto table_info = carnot_info.add_table_info();
+  table_info->set_table("http_events");
+  table_info->set_min_time(1000);
+  ASSERT_OK_AND_ASSIGN(sole::uuid uuid, ParseUUID(carnot_info.agent_id()));
+  auto agent_id = uuid_to_id_map_[uuid];
+  PruneUnavailableSourcesRule rule(agent_id, carnot_info, {{"http_events", {agent_id}}});
+  auto rule_or_s = rule.Execute(graph.get());
+  ASSERT_OK(rule_or_s);
+  EXPECT_FALSE(rule_or_s.ConsumeValueOrDie());
+
+  EXPECT_TRUE(graph->HasNode(mem_src_id));
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -29,21 +29,30 @@ StatusOr<distributedpb::DistributedPlan> DistributedPlan::ToProto() const {
   auto qb_address_to_plan_pb = physical_plan_pb.mutable_qb_address_to_plan();
   auto qb_address_to_dag_id_pb = physical_plan_pb.mutable_qb_address_to_dag_id();
 
+  // Many agents (e.g. all the PEMs of a cluster, see AddPlanToAgentMap()) share the same IR, so
+  // each IR is converted once, and the plans of the other agents are instantiated from it.
+  absl::flat_hash_map<const IR*, planpb::Plan> plan_templates;
+
   for (int64_t i : dag_.TopologicalSort()) {
     CarnotInstance* carnot = Get(i);
     CHECK_EQ(carnot->id(), i) << absl::Substitute("Index in node ($1) and DAG ($0) don't agree.", i,
                                                   carnot->id());
     DCHECK(carnot->plan()) << absl::Substitute("$0 doesn't have a plan set.",
                                                carnot->DebugString());
-    PL_ASSIGN_OR_RETURN(auto plan_proto, carnot->PlanProto());
+    planpb::Plan plan_proto;
+    auto template_iter = plan_templates.find(carnot->plan());
+    if (template_iter == plan_templates.end()) {
+      PL_ASSIGN_OR_RETURN(plan_proto, carnot->PlanProto());
+      plan_templates.emplace(carnot->plan(), plan_proto);
+    } else {
+      PL_ASSIGN_OR_RETURN(plan_proto, carnot->plan()->InstantiateProto(template_iter->second, i));
+    }
     for (int64_t parent_i : dag_.ParentsOf(i)) {
       *(plan_proto.add_incoming_agent_ids()) = Get(parent_i)->carnot_info().agent_id();
     }
-    (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()] = plan_proto;
+    plan_proto.mutable_plan_options()->CopyFrom(plan_options_);
+    (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()] = std::move(plan_proto);
     (*qb_address_to_dag_id_pb)[carnot->QueryBrokerAddress()] = i;
-
-    auto plan_opts = (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()].mutable_plan_options();
-    plan_opts->CopyFrom(plan_options_);
   }
   dag_.ToProto(physical_plan_dag);
   return physical_plan_pb;
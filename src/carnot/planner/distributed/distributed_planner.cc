@@ -27,6 +27,7 @@
 #include "src/carnot/planner/distributed/distributed_rules.h"
 #include "src/carnot/planner/distributed/distributed_stitcher_rules.h"
 #include "src/carnot/planner/distributed/grpc_source_conversion.h"
+#include "src/carnot/planner/distributed/join_build_side_rule.h"
 #include "src/carnot/planner/rules/rules.h"
 
 namespace px {
@@ -75,6 +76,16 @@ StatusOr<std::unique_ptr<DistributedPlan>> DistributedPlanner::Plan(
   PL_ASSIGN_OR_RETURN(std::unique_ptr<Coordinator> coordinator,
                       Coordinator::Create(compiler_state, distributed_state));
 
+  // The build sides are picked before the plan is split, while the join inputs can still be
+  // traced back to the tables they read.
+  std::unique_ptr<IR> join_plan;
+  if (!logical_plan->FindNodesThatMatch(Join()).empty()) {
+    PL_ASSIGN_OR_RETURN(join_plan, logical_plan->Clone());
+    JoinBuildSideRule join_build_side_rule(distributed_state);
+    PL_RETURN_IF_ERROR(join_build_side_rule.Execute(join_plan.get()));
+    logical_plan = join_plan.get();
+  }
+
   PL_ASSIGN_OR_RETURN(std::unique_ptr<DistributedPlan> distributed_plan,
                       coordinator->Coordinate(logical_plan));
 
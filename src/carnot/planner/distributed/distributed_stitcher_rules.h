@@ -41,15 +41,21 @@ using distributedpb::CarnotInfo;
  */
 class SetSourceGroupGRPCAddressRule : public Rule {
  public:
-  SetSourceGroupGRPCAddressRule(const std::string& grpc_address, const std::string& ssl_targetname)
+  SetSourceGroupGRPCAddressRule(const std::string& grpc_address, const std::string& ssl_targetname,
+                                bool accepts_arrow_row_batches = false,
+                                bool accepts_compressed_row_batches = false)
       : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false),
         grpc_address_(grpc_address),
-        ssl_targetname_(ssl_targetname) {}
+        ssl_targetname_(ssl_targetname),
+        accepts_arrow_row_batches_(accepts_arrow_row_batches),
+        accepts_compressed_row_batches_(accepts_compressed_row_batches) {}
 
  private:
   StatusOr<bool> Apply(IRNode* node) override;
   std::string grpc_address_;
   std::string ssl_targetname_;
+  bool accepts_arrow_row_batches_;
+  bool accepts_compressed_row_batches_;
 };
 
 /**
@@ -62,8 +68,10 @@ class DistributedSetSourceGroupGRPCAddressRule : public DistributedRule {
       : DistributedRule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {}
 
   StatusOr<bool> Apply(CarnotInstance* carnot_instance) override {
-    SetSourceGroupGRPCAddressRule rule(carnot_instance->carnot_info().grpc_address(),
-                                       carnot_instance->carnot_info().ssl_targetname());
+    const auto& carnot_info = carnot_instance->carnot_info();
+    SetSourceGroupGRPCAddressRule rule(carnot_info.grpc_address(), carnot_info.ssl_targetname(),
+                                       carnot_info.accepts_arrow_row_batches(),
+                                       carnot_info.accepts_compressed_row_batches());
     return rule.Execute(carnot_instance->plan());
   }
 };
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <queue>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/carnot/planner/distributed/join_build_side_rule.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+JoinBuildSideRule::JoinBuildSideRule(const distributedpb::DistributedState& distributed_state)
+    : Rule(nullptr, /*use_topo*/ false, /*reverse_topological_execution*/ false) {
+  for (const auto& carnot_info : distributed_state.carnot_info()) {
+    for (const auto& table_info : carnot_info.table_info()) {
+      table_bytes_[table_info.table()] += table_info.size_bytes();
+    }
+  }
+}
+
+std::optional<int64_t> JoinBuildSideRule::EstimateInputBytes(OperatorIR* op) const {
+  int64_t bytes = 0;
+  absl::flat_hash_set<int64_t> visited;
+  std::queue<OperatorIR*> to_visit;
+  to_visit.push(op);
+  while (!to_visit.empty()) {
+    OperatorIR* current = to_visit.front();
+    to_visit.pop();
+    if (!visited.insert(current->id()).second) {
+      continue;
+    }
+    if (Match(current, MemorySource())) {
+      auto it = table_bytes_.find(static_cast<MemorySourceIR*>(current)->table_name());
+      // Agents that don't report table sizes leave them at 0.
+      if (it == table_bytes_.end() || it->second == 0) {
+        return std::nullopt;
+      }
+      bytes += it->second;
+      continue;
+    }
+    if (Match(current, SourceOperator()) || Match(current, BlockingAgg()) ||
+        Match(current, Join())) {
+      return std::nullopt;
+    }
+    for (OperatorIR* parent : current->parents()) {
+      to_visit.push(parent);
+    }
+  }
+  return bytes;
+}
+
+StatusOr<bool> JoinBuildSideRule::Apply(IRNode* node) {
+  if (!Match(node, Join())) {
+    return false;
+  }
+  auto join = static_cast<JoinIR*>(node);
+  DCHECK_EQ(join->parents().size(), 2UL);
+  auto left_bytes = EstimateInputBytes(join->parents()[0]);
+  auto right_bytes = EstimateInputBytes(join->parents()[1]);
+  if (!left_bytes.has_value() || !right_bytes.has_value()) {
+    return false;
+  }
+  int64_t build_parent_index = right_bytes.value() < left_bytes.value() ? 1 : 0;
+  if (build_parent_index == join->build_parent_index()) {
+    return false;
+  }
+  join->SetBuildParentIndex(build_parent_index);
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
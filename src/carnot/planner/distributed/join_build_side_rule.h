@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+/**
+ * @brief Picks the build side of each join from the table sizes that the agents report in the
+ * distributed state. The smaller input is buffered into the join's hash table, and the larger one
+ * is streamed through it.
+ *
+ * The size of a join input is estimated as the total size of the tables read by the memory
+ * sources it depends on, which is an upper bound for maps, filters and limits. Inputs that
+ * depend on anything else, such as an aggregate or a UDTF, have no estimate, and joins without
+ * estimates for both inputs are left as they are.
+ */
+class JoinBuildSideRule : public Rule {
+ public:
+  explicit JoinBuildSideRule(const distributedpb::DistributedState& distributed_state);
+
+ protected:
+  StatusOr<bool> Apply(IRNode* node) override;
+
+ private:
+  std::optional<int64_t> EstimateInputBytes(OperatorIR* op) const;
+
+  // The total size of each table across all of the agents.
+  absl::flat_hash_map<std::string, int64_t> table_bytes_;
+};
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/test_utils.h"
+#include "src/carnot/planner/distributed/join_build_side_rule.h"
+#include "src/carnot/planner/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace distributed {
+
+constexpr char kTableSizesDistributedState[] = R"proto(
+carnot_info {
+  table_info {
+    table: "big"
+    size_bytes: 1000
+  }
+  table_info {
+    table: "small"
+    size_bytes: 10
+  }
+}
+carnot_info {
+  table_info {
+    table: "big"
+    size_bytes: 2000
+  }
+  table_info {
+    table: "small"
+    size_bytes: 20
+  }
+  table_info {
+    table: "unreported"
+  }
+}
+)proto";
+
+class JoinBuildSideRuleTest : public testutils::DistributedRulesTest {
+ protected:
+  void SetUpImpl() override {
+    DistributedRulesTest::SetUpImpl();
+    ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kTableSizesDistributedState,
+                                                              &distributed_state_));
+  }
+
+  JoinIR* MakeInnerJoin(OperatorIR* left, OperatorIR* right) {
+    auto join = MakeJoin({left, right}, "inner", {MakeColumn("upid", 0)}, {MakeColumn("upid", 1)});
+    MakeMemSink(join, "output");
+    return join;
+  }
+
+  distributedpb::DistributedState distributed_state_;
+};
+
+TEST_F(JoinBuildSideRuleTest, builds_on_smaller_right_input) {
+  auto join = MakeInnerJoin(MakeMemSource("big"), MakeFilter(MakeMemSource("small")));
+
+  JoinBuildSideRule rule(distributed_state_);
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(1, join->build_parent_index());
+}
+
+TEST_F(JoinBuildSideRuleTest, keeps_smaller_left_input) {
+  auto join = MakeInnerJoin(MakeMemSource("small"), MakeMemSource("big"));
+
+  JoinBuildSideRule rule(distributed_state_);
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, join->build_parent_index());
+}
+
+TEST_F(JoinBuildSideRuleTest, no_estimate_without_table_sizes) {
+  auto join = MakeInnerJoin(MakeMemSource("big"), MakeMemSource("unreported"));
+
+  JoinBuildSideRule rule(distributed_state_);
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(0, join->build_parent_index());
+}
+
+}  // namespace distributed
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -44,6 +44,36 @@ StatusOr<OperatorIR*> LimitOperatorMgr::CreateMergeOperator(IR* plan, OperatorIR
   return new_limit;
 }
 
+StatusOr<OperatorIR*> TopKOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR* op) const {
+  DCHECK(Matches(op));
+  TopKIR* top_k = static_cast<TopKIR*>(op);
+  PL_ASSIGN_OR_RETURN(TopKIR * new_top_k, plan->CopyNode(top_k));
+  PL_RETURN_IF_ERROR(new_top_k->CopyParentsFrom(top_k));
+
+  // Output the columns of the original TopK and any sort columns it drops, in parent order.
+  absl::flat_hash_set<std::string> output_cols(top_k->relation().col_names().begin(),
+                                               top_k->relation().col_names().end());
+  output_cols.insert(top_k->sort_cols().begin(), top_k->sort_cols().end());
+  const auto& parent_relation = top_k->parents()[0]->relation();
+  table_store::schema::Relation relation;
+  for (const auto& [idx, col_name] : Enumerate(parent_relation.col_names())) {
+    if (output_cols.contains(col_name)) {
+      relation.AddColumn(parent_relation.col_types()[idx], col_name);
+    }
+  }
+  PL_RETURN_IF_ERROR(new_top_k->SetRelation(relation));
+  return new_top_k;
+}
+
+StatusOr<OperatorIR*> TopKOperatorMgr::CreateMergeOperator(IR* plan, OperatorIR* new_parent,
+                                                           OperatorIR* op) const {
+  DCHECK(Matches(op));
+  TopKIR* top_k = static_cast<TopKIR*>(op);
+  PL_ASSIGN_OR_RETURN(TopKIR * new_top_k, plan->CopyNode(top_k));
+  PL_RETURN_IF_ERROR(new_top_k->AddParent(new_parent));
+  return new_top_k;
+}
+
 StatusOr<OperatorIR*> AggOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR* op) const {
   DCHECK(Matches(op));
   BlockingAggIR* agg = static_cast<BlockingAggIR*>(op);
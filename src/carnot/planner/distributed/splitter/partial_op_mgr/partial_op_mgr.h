@@ -87,6 +87,19 @@ class LimitOperatorMgr : public PartialOperatorMgr {
                                             OperatorIR* op) const override;
 };
 
+/**
+ * @brief TopKOperatorMgr splits a TopK into a local TopK on each data source and a TopK over the
+ * merged local results. The prepare TopK keeps the sort columns in its output, even if the
+ * original TopK drops them, so that the merge TopK can sort on them.
+ */
+class TopKOperatorMgr : public PartialOperatorMgr {
+ public:
+  bool Matches(OperatorIR* op) const override { return Match(op, TopK()); }
+  StatusOr<OperatorIR*> CreatePrepareOperator(IR* plan, OperatorIR* op) const override;
+  StatusOr<OperatorIR*> CreateMergeOperator(IR* plan, OperatorIR* new_parent,
+                                            OperatorIR* op) const override;
+};
+
 /**
  * @brief AggOperatorMgr manages splitting aggregates into partial aggregate and the merging node
  * over a network boundary.
@@ -98,6 +111,11 @@ class AggOperatorMgr : public PartialOperatorMgr {
       return false;
     }
     BlockingAggIR* agg = static_cast<BlockingAggIR*>(op);
+    // Time windows are closed on the watermark of the agg's input, which the partial aggs on
+    // different agents don't share.
+    if (agg->has_time_window()) {
+      return false;
+    }
     for (const auto& col_expr : agg->aggregate_expressions()) {
       if (!Match(col_expr.node, PartialUDA())) {
         return false;
@@ -67,6 +67,41 @@ TEST_F(PartialOpMgrTest, limit_test) {
   EXPECT_NE(merge_limit, limit);
 }
 
+TEST_F(PartialOpMgrTest, top_k_test) {
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto top_k = MakeTopK(mem_src, {"cpu1"}, {true}, 10);
+  // The TopK only outputs count, so the prepare TopK has to keep cpu1 for the merge.
+  ASSERT_OK(top_k->SetRelation(table_store::schema::Relation({types::INT64}, {"count"})));
+  MakeMemSink(top_k, "out");
+
+  TopKOperatorMgr mgr;
+  EXPECT_TRUE(mgr.Matches(top_k));
+  EXPECT_FALSE(mgr.Matches(mem_src));
+  auto prepare_top_k_or_s = mgr.CreatePrepareOperator(graph.get(), top_k);
+  ASSERT_OK(prepare_top_k_or_s);
+  OperatorIR* prepare_top_k_uncasted = prepare_top_k_or_s.ConsumeValueOrDie();
+  ASSERT_MATCH(prepare_top_k_uncasted, TopK());
+  TopKIR* prepare_top_k = static_cast<TopKIR*>(prepare_top_k_uncasted);
+  EXPECT_EQ(prepare_top_k->limit_value(), top_k->limit_value());
+  EXPECT_EQ(prepare_top_k->sort_cols(), top_k->sort_cols());
+  EXPECT_EQ(prepare_top_k->descending(), top_k->descending());
+  EXPECT_EQ(prepare_top_k->parents(), top_k->parents());
+  EXPECT_THAT(prepare_top_k->relation().col_names(), ElementsAre("count", "cpu1"));
+  EXPECT_NE(prepare_top_k, top_k);
+
+  auto mem_src2 = MakeMemSource(prepare_top_k->relation());
+  auto merge_top_k_or_s = mgr.CreateMergeOperator(graph.get(), mem_src2, top_k);
+  ASSERT_OK(merge_top_k_or_s);
+  OperatorIR* merge_top_k_uncasted = merge_top_k_or_s.ConsumeValueOrDie();
+  ASSERT_MATCH(merge_top_k_uncasted, TopK());
+  TopKIR* merge_top_k = static_cast<TopKIR*>(merge_top_k_uncasted);
+  EXPECT_EQ(merge_top_k->limit_value(), top_k->limit_value());
+  EXPECT_EQ(merge_top_k->sort_cols(), top_k->sort_cols());
+  EXPECT_EQ(merge_top_k->parents()[0], mem_src2);
+  EXPECT_THAT(merge_top_k->relation().col_names(), ElementsAre("count"));
+  EXPECT_NE(merge_top_k, top_k);
+}
+
 TEST_F(PartialOpMgrTest, agg_test) {
   auto relation = MakeRelation();
   relation.AddColumn(types::STRING, "service");
@@ -148,6 +183,22 @@ TEST_F(PartialOpMgrTest, agg_where_fn_cant_partial) {
   AggOperatorMgr mgr;
   EXPECT_FALSE(mgr.Matches(agg));
 }
+
+TEST_F(PartialOpMgrTest, time_window_agg_not_split) {
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto time_col = MakeColumn("time_", 0);
+  time_col->ResolveColumnType(types::TIME64NS);
+  auto mean_func = MakeMeanFunc(MakeColumn("count", 0));
+  mean_func->SetSupportsPartial(true);
+  auto agg = MakeBlockingAgg(mem_src, {time_col}, {{"mean", mean_func}});
+  agg->SetTimeWindow(/*group_index*/ 0, /*size_ns*/ 1000);
+  MakeMemSink(agg, "out");
+
+  // The windows of partial aggregates close on each agent's own watermark, so merging them
+  // would emit a window more than once.
+  AggOperatorMgr mgr;
+  EXPECT_FALSE(mgr.Matches(agg));
+}
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <queue>
+#include <vector>
 
 namespace px {
 namespace carnot {
@@ -129,6 +130,63 @@ Status FilterPushdownRule::UpdateFilter(FilterIR* filter,
   return filter->SetFilterExpr(new_expr);
 }
 
+StatusOr<bool> FilterPushdownRule::HandleUnionPushdown(FilterIR* filter) {
+  DCHECK_EQ(1, filter->parents().size());
+  if (!Match(filter->parents()[0], Union())) {
+    return false;
+  }
+  UnionIR* union_op = static_cast<UnionIR*>(filter->parents()[0]);
+  // If any other operator reads from the union, it still needs the unfiltered rows.
+  if (union_op->Children().size() > 1) {
+    return false;
+  }
+
+  IR* graph = filter->graph();
+  std::vector<FilterIR*> new_filters;
+  // Copy the parents, since replacing them below mutates the union's parent list.
+  std::vector<OperatorIR*> union_parents = union_op->parents();
+  for (size_t parent_idx = 0; parent_idx < union_parents.size(); ++parent_idx) {
+    OperatorIR* parent = union_parents[parent_idx];
+    // Unions may rename the columns of each of their inputs, so translate the filter's
+    // columns into the names used by this particular parent.
+    ColumnNameMapping column_name_mapping;
+    PL_ASSIGN_OR_RETURN(auto involved_cols, filter->filter_expr()->InputColumnNames());
+    for (const auto& col : involved_cols) {
+      column_name_mapping[col] = col;
+    }
+    if (union_op->HasColumnMappings()) {
+      const auto& input_columns = union_op->column_mappings()[parent_idx];
+      for (size_t col_idx = 0; col_idx < input_columns.size(); ++col_idx) {
+        auto output_name = union_op->relation().GetColumnName(col_idx);
+        if (column_name_mapping.contains(output_name)) {
+          column_name_mapping[output_name] = input_columns[col_idx]->col_name();
+        }
+      }
+    }
+
+    PL_ASSIGN_OR_RETURN(FilterIR * new_filter, graph->CopyNode(filter));
+    PL_RETURN_IF_ERROR(UpdateFilter(new_filter, column_name_mapping));
+    PL_RETURN_IF_ERROR(new_filter->AddParent(parent));
+    PL_RETURN_IF_ERROR(union_op->ReplaceParent(parent, new_filter));
+    PL_RETURN_IF_ERROR(new_filter->SetRelation(parent->relation()));
+    new_filters.push_back(new_filter);
+  }
+
+  // Remove the original filter now that every branch of the union is filtered.
+  for (OperatorIR* child : filter->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(filter, union_op));
+  }
+  PL_RETURN_IF_ERROR(filter->RemoveParent(union_op));
+  PL_RETURN_IF_ERROR(graph->DeleteNode(filter->id()));
+
+  // The copies were created after this rule computed its traversal order, so push them as far
+  // up their own branches as they can go now.
+  for (FilterIR* new_filter : new_filters) {
+    PL_RETURN_IF_ERROR(Apply(new_filter).status());
+  }
+  return true;
+}
+
 StatusOr<bool> FilterPushdownRule::Apply(IRNode* ir_node) {
   if (!Match(ir_node, Filter())) {
     return false;
@@ -160,9 +218,9 @@ StatusOr<bool> FilterPushdownRule::Apply(IRNode* ir_node) {
     current_node = next_parent;
   }
   // If the current_node is filter, that means we could not find a better filter location and will
-  // not change.
+  // not change, unless the filter sits directly below a Union.
   if (current_node == filter) {
-    return false;
+    return HandleUnionPushdown(filter);
   }
 
   PL_RETURN_IF_ERROR(UpdateFilter(filter, column_name_mapping));
@@ -181,6 +239,7 @@ StatusOr<bool> FilterPushdownRule::Apply(IRNode* ir_node) {
   PL_RETURN_IF_ERROR(filter->AddParent(new_filter_parent));
   PL_RETURN_IF_ERROR(current_node->ReplaceParent(new_filter_parent, filter));
   PL_RETURN_IF_ERROR(filter->SetRelation(new_filter_parent->relation()));
+  PL_RETURN_IF_ERROR(HandleUnionPushdown(filter).status());
   return true;
 }
 
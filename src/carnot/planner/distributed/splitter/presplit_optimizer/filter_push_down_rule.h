@@ -30,6 +30,10 @@ namespace distributed {
  * It must run after OperatorRelationRule so that it has full context on all of the column
  * names that exist in the IR.
  *
+ * When a filter reaches a Union, it is copied onto each of the Union's inputs so that the
+ * filter can run on the PEM side of the GRPC bridge rather than after every row has been sent
+ * to Kelvin.
+ *
  */
 class FilterPushdownRule : public Rule {
  public:
@@ -46,6 +50,7 @@ class FilterPushdownRule : public Rule {
   StatusOr<OperatorIR*> NextFilterLocation(OperatorIR* current_node, bool kelvin_only_filter,
                                            ColumnNameMapping* column_name_mapping);
   Status UpdateFilter(FilterIR* expr, const ColumnNameMapping& column_name_mapping);
+  StatusOr<bool> HandleUnionPushdown(FilterIR* filter);
 };
 
 }  // namespace distributed
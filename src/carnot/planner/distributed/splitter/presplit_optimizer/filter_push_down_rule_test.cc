@@ -391,6 +391,69 @@ TEST_F(FilterPushDownTest, kelvin_only_filter) {
   EXPECT_THAT(map2->parents()[0]->parents(), ElementsAre(map1));
 }
 
+TEST_F(FilterPushDownTest, union_branches) {
+  Relation relation1({types::DataType::INT64, types::DataType::INT64}, {"abc", "xyz"});
+  Relation relation2({types::DataType::INT64}, {"abc"});
+
+  MemorySourceIR* src1 = MakeMemSource(relation1);
+  MapIR* map1 = MakeMap(src1, {{"abc", MakeColumn("abc", 0)}}, false);
+  ASSERT_OK(map1->SetRelation(relation2));
+  MemorySourceIR* src2 = MakeMemSource(relation2);
+
+  UnionIR* union_node = MakeUnion({map1, src2});
+  ASSERT_OK(union_node->SetRelation(relation2));
+
+  auto col = MakeColumn("abc", 0);
+  col->ResolveColumnType(types::DataType::INT64);
+  FilterIR* filter = MakeFilter(union_node, MakeEqualsFunc(col, MakeInt(2)));
+  MemorySinkIR* sink = MakeMemSink(filter, "foo", {});
+
+  FilterPushdownRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ValueOrDie());
+
+  // The original filter is replaced by one copy on each branch of the union.
+  EXPECT_FALSE(graph->HasNode(filter->id()));
+  EXPECT_THAT(sink->parents(), ElementsAre(union_node));
+  EXPECT_EQ(2, union_node->parents().size());
+
+  // The first branch's copy keeps moving up past the map.
+  EXPECT_EQ(map1, union_node->parents()[0]);
+  EXPECT_EQ(1, map1->parents().size());
+  auto filter1 = map1->parents()[0];
+  EXPECT_MATCH(filter1, Filter());
+  EXPECT_THAT(filter1->parents(), ElementsAre(src1));
+  EXPECT_EQ(filter1->relation(), relation1);
+  EXPECT_MATCH(static_cast<FilterIR*>(filter1)->filter_expr(), Equals(ColumnNode("abc"), Int(2)));
+
+  auto filter2 = union_node->parents()[1];
+  EXPECT_MATCH(filter2, Filter());
+  EXPECT_THAT(filter2->parents(), ElementsAre(src2));
+  EXPECT_EQ(filter2->relation(), relation2);
+}
+
+TEST_F(FilterPushDownTest, union_multiple_children_dont_push) {
+  Relation relation({types::DataType::INT64}, {"abc"});
+  MemorySourceIR* src1 = MakeMemSource(relation);
+  MemorySourceIR* src2 = MakeMemSource(relation);
+  UnionIR* union_node = MakeUnion({src1, src2});
+  ASSERT_OK(union_node->SetRelation(relation));
+
+  auto col = MakeColumn("abc", 0);
+  col->ResolveColumnType(types::DataType::INT64);
+  FilterIR* filter = MakeFilter(union_node, MakeEqualsFunc(col, MakeInt(2)));
+  MakeMemSink(filter, "foo", {});
+  MakeMemSink(union_node, "bar", {});
+
+  FilterPushdownRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ValueOrDie());
+  EXPECT_THAT(filter->parents(), ElementsAre(union_node));
+  EXPECT_THAT(union_node->parents(), ElementsAre(src1, src2));
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
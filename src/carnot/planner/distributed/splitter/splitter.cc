@@ -116,6 +116,69 @@ StatusOr<absl::flat_hash_map<int64_t, bool>> Splitter::GetKelvinNodes(
   return on_kelvin;
 }
 
+namespace {
+// Strings vary in length, so assume a typical short value such as a pod or service name.
+constexpr int64_t kEstimatedStringBytes = 64;
+
+int64_t EstimatedRowBytes(const table_store::schema::Relation& relation) {
+  int64_t bytes = 0;
+  for (const auto& col_type : relation.col_types()) {
+    switch (col_type) {
+      case types::DataType::BOOLEAN:
+        bytes += sizeof(bool);
+        break;
+      case types::DataType::UINT128:
+        bytes += sizeof(absl::uint128);
+        break;
+      case types::DataType::STRING:
+        bytes += kEstimatedStringBytes;
+        break;
+      default:
+        bytes += sizeof(int64_t);
+        break;
+    }
+  }
+  return bytes;
+}
+
+// Returns true if a Filter runs anywhere between the sources and the given PEM operator.
+bool FilteredBeforeOp(OperatorIR* op) {
+  std::queue<OperatorIR*> parent_q;
+  parent_q.push(op);
+  while (!parent_q.empty()) {
+    OperatorIR* cur = parent_q.front();
+    parent_q.pop();
+    if (Match(cur, Filter())) {
+      return true;
+    }
+    for (OperatorIR* parent : cur->parents()) {
+      parent_q.push(parent);
+    }
+  }
+  return false;
+}
+}  // namespace
+
+StatusOr<GRPCTransferEstimate> Splitter::EstimateGRPCTransfer(const IR* logical_plan) {
+  std::vector<int64_t> source_ids;
+  for (OperatorIR* src : logical_plan->GetSources()) {
+    source_ids.push_back(src->id());
+  }
+  PL_ASSIGN_OR_RETURN(auto on_kelvin, GetKelvinNodes(logical_plan, source_ids));
+
+  GRPCTransferEstimate estimate;
+  for (const auto& [parent, children] : GetEdgesToBreak(logical_plan, on_kelvin, source_ids)) {
+    ++estimate.num_bridges;
+    if (parent->IsRelationInit()) {
+      estimate.bytes_per_row += EstimatedRowBytes(parent->relation());
+    }
+    if (FilteredBeforeOp(parent)) {
+      ++estimate.num_filtered_bridges;
+    }
+  }
+  return estimate;
+}
+
 StatusOr<std::unique_ptr<BlockingSplitPlan>> Splitter::SplitKelvinAndAgents(const IR* input_plan) {
   PL_ASSIGN_OR_RETURN(auto logical_plan, input_plan->Clone());
 
@@ -126,7 +189,11 @@ StatusOr<std::unique_ptr<BlockingSplitPlan>> Splitter::SplitKelvinAndAgents(cons
   // Run the pre-split optimization step.
   PL_ASSIGN_OR_RETURN(std::unique_ptr<PreSplitOptimizer> optimizer,
                       PreSplitOptimizer::Create(compiler_state_));
+  PL_ASSIGN_OR_RETURN(auto estimate_before, EstimateGRPCTransfer(logical_plan.get()));
+  VLOG(1) << "GRPC transfer before pre-split optimization: " << estimate_before.DebugString();
   PL_RETURN_IF_ERROR(optimizer->Execute(logical_plan.get()));
+  PL_ASSIGN_OR_RETURN(auto estimate_after, EstimateGRPCTransfer(logical_plan.get()));
+  VLOG(1) << "GRPC transfer after pre-split optimization: " << estimate_after.DebugString();
 
   // Source_ids are necessary because we will make a clone of the plan at which point we will no
   // longer be able to use IRNode pointers and only IDs will be valid.
@@ -138,6 +205,11 @@ StatusOr<std::unique_ptr<BlockingSplitPlan>> Splitter::SplitKelvinAndAgents(cons
   PL_ASSIGN_OR_RETURN(auto on_kelvin, GetKelvinNodes(logical_plan.get(), source_ids));
   PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> grpc_bridge_plan,
                       CreateGRPCBridgePlan(logical_plan.get(), on_kelvin, source_ids));
+  // The bridges' sinks report the estimates in the query's exec stats.
+  for (IRNode* node : grpc_bridge_plan->FindNodesThatMatch(InternalGRPCSink())) {
+    static_cast<GRPCSinkIR*>(node)->SetEstimatedQueryRowBytes(estimate_before.bytes_per_row,
+                                                              estimate_after.bytes_per_row);
+  }
 
   PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> pem_plan, grpc_bridge_plan->Clone());
   PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> kelvin_plan, grpc_bridge_plan->Clone());
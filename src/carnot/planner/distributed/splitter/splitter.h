@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/strings/substitute.h>
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
@@ -65,6 +66,24 @@ struct BlockingSplitNodeIDGroups {
   absl::flat_hash_set<int64_t> after_blocking_nodes;
 };
 
+/**
+ * @brief A rough estimate of the data a plan sends from PEMs to Kelvin over GRPC bridges. Used to
+ * report the effect of the pre-split optimizer on each query.
+ */
+struct GRPCTransferEstimate {
+  // The number of PEM-side operators whose output is sent to Kelvin.
+  int64_t num_bridges = 0;
+  // The estimated size of a single row, summed across all of the bridges.
+  int64_t bytes_per_row = 0;
+  // The number of bridges whose rows are filtered on the PEM before they are sent.
+  int64_t num_filtered_bridges = 0;
+
+  std::string DebugString() const {
+    return absl::Substitute("GRPCTransferEstimate(bridges=$0, bytes_per_row=$1, filtered=$2)",
+                            num_bridges, bytes_per_row, num_filtered_bridges);
+  }
+};
+
 /**
  * @brief The Splitter splits apart the graph along Blocking Node lines. The result is
  * two new IR graphs -> one that is run on Carnot instances that pull up data from Stirling and the
@@ -108,6 +127,14 @@ class Splitter : public NotCopyable {
    */
   StatusOr<std::unique_ptr<BlockingSplitPlan>> SplitKelvinAndAgents(const IR* logical_plan);
 
+  /**
+   * @brief Estimates how much data the plan would send over GRPC if it were split as is.
+   *
+   * @param logical_plan: the input logical_plan
+   * @return StatusOr<GRPCTransferEstimate>: the estimate for the plan.
+   */
+  StatusOr<GRPCTransferEstimate> EstimateGRPCTransfer(const IR* logical_plan);
+
   static StatusOr<std::unique_ptr<Splitter>> Create(CompilerState* compiler_state,
                                                     bool support_partial_agg) {
     std::unique_ptr<Splitter> splitter = std::unique_ptr<Splitter>(new Splitter(compiler_state));
@@ -122,6 +149,7 @@ class Splitter : public NotCopyable {
       partial_operator_mgrs_.push_back(std::make_unique<AggOperatorMgr>());
     }
     partial_operator_mgrs_.push_back(std::make_unique<LimitOperatorMgr>());
+    partial_operator_mgrs_.push_back(std::make_unique<TopKOperatorMgr>());
     return Status::OK();
   }
   /**
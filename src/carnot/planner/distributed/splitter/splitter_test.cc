@@ -122,11 +122,42 @@ TEST_F(SplitterTest, blocking_agg_test) {
   GRPCSourceGroupIR* grpc_source_group = static_cast<GRPCSourceGroupIR*>(agg_parent);
 
   EXPECT_EQ(grpc_sink->destination_id(), grpc_source_group->source_id());
+  // The bridge's sink carries the query's GRPC transfer estimates, which nothing here changes.
+  EXPECT_GT(grpc_sink->estimated_query_row_bytes_after_pushdown(), 0);
+  EXPECT_EQ(grpc_sink->estimated_query_row_bytes_before_pushdown(),
+            grpc_sink->estimated_query_row_bytes_after_pushdown());
 
   OperatorIR* sink_parent = GetEquivalentInNewPlan(after_blocking, sink)->parents()[0];
   EXPECT_MATCH(sink_parent, BlockingAgg());
 }
 
+TEST_F(SplitterTest, estimate_grpc_transfer) {
+  table_store::schema::Relation relation({types::DataType::INT64, types::DataType::BOOLEAN},
+                                         {"count", "keep"});
+  auto mem_src = MakeMemSource(relation);
+  FilterIR* filter = graph
+                         ->CreateNode<FilterIR>(ast, mem_src,
+                                                MakeColumn("keep", 0, types::DataType::BOOLEAN))
+                         .ConsumeValueOrDie();
+  ASSERT_OK(filter->SetRelation(relation));
+  auto agg = MakeBlockingAgg(
+      filter, {MakeColumn("count", 0, types::DataType::INT64)},
+      {{"mean", MakeMeanFuncWithFloatType(MakeColumn("count", 0, types::DataType::INT64))}});
+  MakeMemSink(agg, "out");
+
+  auto splitter_or_s = Splitter::Create(compiler_state_.get(), /* perform_partial_agg */ false);
+  ASSERT_OK(splitter_or_s);
+  std::unique_ptr<Splitter> splitter = splitter_or_s.ConsumeValueOrDie();
+  auto estimate_or_s = splitter->EstimateGRPCTransfer(graph.get());
+  ASSERT_OK(estimate_or_s);
+  auto estimate = estimate_or_s.ConsumeValueOrDie();
+
+  // Only the filter's output crosses to Kelvin, and it has an int64 and a bool column.
+  EXPECT_EQ(1, estimate.num_bridges);
+  EXPECT_EQ(9, estimate.bytes_per_row);
+  EXPECT_EQ(1, estimate.num_filtered_bridges);
+}
+
 TEST_F(SplitterTest, partial_agg_test) {
   auto mem_src = MakeMemSource(MakeRelation());
   auto count_col = MakeColumn("count", 0, types::DataType::INT64);
@@ -354,6 +354,31 @@ Status MemorySourceIR::ToProto(planpb::Operator* op) const {
   }
 
   pb->set_streaming(streaming());
+
+  for (const auto& predicate : zone_map_predicates_) {
+    // The predicate only lets the source skip batches, so it's dropped if its column was pruned.
+    if (!relation().HasColumn(predicate.column_name)) {
+      continue;
+    }
+    auto predicate_pb = pb->add_predicates();
+    predicate_pb->set_column_idx(
+        column_index_map_[relation().GetColumnIndex(predicate.column_name)]);
+    predicate_pb->set_op(predicate.op);
+    *predicate_pb->mutable_value() = predicate.value;
+    for (const auto& value : predicate.values) {
+      *predicate_pb->add_values() = value;
+    }
+    for (const auto& pod_name : predicate.pod_names) {
+      predicate_pb->add_pod_names(pod_name);
+    }
+    for (const auto& service_name : predicate.service_names) {
+      predicate_pb->add_service_names(service_name);
+    }
+  }
+
+  if (has_sample_) {
+    *pb->mutable_sample() = sample_;
+  }
   return Status::OK();
 }
 
@@ -673,6 +698,58 @@ Status LimitIR::ToProto(planpb::Operator* op) const {
   return Status::OK();
 }
 
+Status TopKIR::Init(OperatorIR* parent, const std::vector<std::string>& sort_cols,
+                    const std::vector<bool>& descending, int64_t limit_value) {
+  PL_RETURN_IF_ERROR(AddParent(parent));
+  if (sort_cols.empty()) {
+    return CreateIRNodeError("TopK requires at least one column to sort by.");
+  }
+  if (sort_cols.size() != descending.size()) {
+    return CreateIRNodeError("Expected $0 sort directions, received $1.", sort_cols.size(),
+                             descending.size());
+  }
+  if (limit_value < 0) {
+    return CreateIRNodeError("TopK value must be non-negative, received $0.", limit_value);
+  }
+  sort_cols_ = sort_cols;
+  descending_ = descending;
+  limit_value_ = limit_value;
+  return Status::OK();
+}
+
+StatusOr<std::vector<absl::flat_hash_set<std::string>>> TopKIR::RequiredInputColumns() const {
+  DCHECK(IsRelationInit());
+  auto required_cols = ColumnsFromRelation(relation());
+  required_cols.insert(sort_cols_.begin(), sort_cols_.end());
+  return std::vector<absl::flat_hash_set<std::string>>{required_cols};
+}
+
+Status TopKIR::ToProto(planpb::Operator* op) const {
+  auto pb = op->mutable_top_k_op();
+  op->set_op_type(planpb::TOP_K_OPERATOR);
+  DCHECK_EQ(parents().size(), 1UL);
+
+  auto parent_rel = parents()[0]->relation();
+  auto parent_id = parents()[0]->id();
+
+  for (const std::string& col_name : relation().col_names()) {
+    planpb::Column* col_pb = pb->add_columns();
+    col_pb->set_node(parent_id);
+    col_pb->set_index(parent_rel.GetColumnIndex(col_name));
+  }
+  for (const auto& [i, col_name] : Enumerate(sort_cols_)) {
+    if (!parent_rel.HasColumn(col_name)) {
+      return CreateIRNodeError("Column '$0' not found in parent dataframe", col_name);
+    }
+    planpb::Column* col_pb = pb->add_sort_columns();
+    col_pb->set_node(parent_id);
+    col_pb->set_index(parent_rel.GetColumnIndex(col_name));
+    pb->add_descending(descending_[i]);
+  }
+  pb->set_limit(limit_value_);
+  return Status::OK();
+}
+
 Status BlockingAggIR::Init(OperatorIR* parent, const std::vector<ColumnIR*>& groups,
                            const ColExpressionVector& agg_expr) {
   PL_RETURN_IF_ERROR(AddParent(parent));
@@ -801,6 +878,19 @@ Status BlockingAggIR::ToProto(planpb::Operator* op) const {
   pb->set_windowed(false);
   pb->set_partial_agg(partial_agg_);
   pb->set_finalize_results(finalize_results_);
+  if (has_time_window()) {
+    pb->mutable_time_window()->set_group_index(time_window_group_index_);
+    pb->mutable_time_window()->set_size_ns(time_window_size_ns_);
+  }
+
+  // Counts and sums over a sample are scaled up when they're finalized. The other aggregates,
+  // like means and quantiles, estimate the same value over the sample as over all the rows.
+  if (finalize_results_ && sample_rate_ < 1.0) {
+    for (const auto& value : pb->values()) {
+      bool scaled = value.name() == "count" || value.name() == "sum";
+      pb->add_value_scales(scaled ? 1.0 / sample_rate_ : 1.0);
+    }
+  }
 
   op->set_op_type(planpb::AGGREGATE_OPERATOR);
   return Status::OK();
@@ -1324,6 +1414,9 @@ Status MemorySourceIR::CopyFromNodeImpl(
   column_index_map_ = source_ir->column_index_map_;
   has_time_expressions_ = source_ir->has_time_expressions_;
   streaming_ = source_ir->streaming_;
+  zone_map_predicates_ = source_ir->zone_map_predicates_;
+  has_sample_ = source_ir->has_sample_;
+  sample_ = source_ir->sample_;
 
   if (has_time_expressions_) {
     PL_ASSIGN_OR_RETURN(ExpressionIR * new_start_expr,
@@ -1385,6 +1478,9 @@ Status BlockingAggIR::CopyFromNodeImpl(
   finalize_results_ = blocking_agg->finalize_results_;
   partial_agg_ = blocking_agg->partial_agg_;
   pre_split_proto_ = blocking_agg->pre_split_proto_;
+  sample_rate_ = blocking_agg->sample_rate_;
+  time_window_group_index_ = blocking_agg->time_window_group_index_;
+  time_window_size_ns_ = blocking_agg->time_window_size_ns_;
 
   return Status::OK();
 }
@@ -1406,6 +1502,14 @@ Status LimitIR::CopyFromNodeImpl(const IRNode* node, absl::flat_hash_map<const I
   return Status::OK();
 }
 
+Status TopKIR::CopyFromNodeImpl(const IRNode* node, absl::flat_hash_map<const IRNode*, IRNode*>*) {
+  const TopKIR* top_k = static_cast<const TopKIR*>(node);
+  limit_value_ = top_k->limit_value_;
+  sort_cols_ = top_k->sort_cols_;
+  descending_ = top_k->descending_;
+  return Status::OK();
+}
+
 Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
                                     absl::flat_hash_map<const IRNode*, IRNode*>*) {
   const GRPCSinkIR* grpc_sink = static_cast<const GRPCSinkIR*>(node);
@@ -1413,6 +1517,11 @@ Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
   destination_id_ = grpc_sink->destination_id_;
   destination_address_ = grpc_sink->destination_address_;
   destination_ssl_targetname_ = grpc_sink->destination_ssl_targetname_;
+  arrow_row_batches_ = grpc_sink->arrow_row_batches_;
+  compress_row_batches_ = grpc_sink->compress_row_batches_;
+  estimated_query_row_bytes_before_pushdown_ =
+      grpc_sink->estimated_query_row_bytes_before_pushdown_;
+  estimated_query_row_bytes_after_pushdown_ = grpc_sink->estimated_query_row_bytes_after_pushdown_;
   name_ = grpc_sink->name_;
   out_columns_ = grpc_sink->out_columns_;
   return Status::OK();
@@ -1423,6 +1532,8 @@ Status GRPCSourceGroupIR::CopyFromNodeImpl(const IRNode* node,
   const GRPCSourceGroupIR* grpc_source_group = static_cast<const GRPCSourceGroupIR*>(node);
   source_id_ = grpc_source_group->source_id_;
   grpc_address_ = grpc_source_group->grpc_address_;
+  accepts_arrow_row_batches_ = grpc_source_group->accepts_arrow_row_batches_;
+  accepts_compressed_row_batches_ = grpc_source_group->accepts_compressed_row_batches_;
   if (grpc_source_group->dependent_sinks_.size()) {
     return error::Unimplemented("Cannot clone GRPCSourceGroupIR with dependent_sinks_");
   }
@@ -1474,6 +1585,8 @@ Status JoinIR::CopyFromNodeImpl(const IRNode* node,
 
   PL_RETURN_IF_ERROR(SetJoinColumns(new_left_columns, new_right_columns));
   suffix_strs_ = join_node->suffix_strs_;
+  build_parent_index_ = join_node->build_parent_index_;
+  asof_tolerance_ns_ = join_node->asof_tolerance_ns_;
   return Status::OK();
 }
 
@@ -1499,6 +1612,7 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op) const {
   pb->mutable_output_table()->set_table_name(name());
   pb->set_address(destination_address());
   pb->mutable_connection_options()->set_ssl_targetname(destination_ssl_targetname());
+  pb->set_arrow_row_batches(arrow_row_batches_);
 
   auto types = relation().col_types();
   auto names = relation().col_names();
@@ -1533,6 +1647,10 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op, int64_t agent_id) const {
     return CreateIRNodeError("No agent ID '$0' found in grpc sink '$1'", agent_id, DebugString());
   }
   pb->set_grpc_source_id(agent_id_to_destination_id_.find(agent_id)->second);
+  pb->set_arrow_row_batches(arrow_row_batches_);
+  pb->set_compress_row_batches(compress_row_batches_);
+  pb->set_estimated_query_row_bytes_before_pushdown(estimated_query_row_bytes_before_pushdown_);
+  pb->set_estimated_query_row_bytes_after_pushdown(estimated_query_row_bytes_after_pushdown_);
   return Status::OK();
 }
 
@@ -1556,7 +1674,7 @@ IRNode* IR::Get(int64_t id) const {
   if (iterator == id_node_map_.end()) {
     return nullptr;
   }
-  return iterator->second.get();
+  return iterator->second;
 }
 
 StatusOr<planpb::Plan> IR::ToProto(int64_t agent_id) const {
@@ -1583,6 +1701,27 @@ StatusOr<planpb::Plan> IR::ToProto(int64_t agent_id) const {
   return plan;
 }
 
+StatusOr<planpb::Plan> IR::InstantiateProto(const planpb::Plan& template_plan,
+                                            int64_t agent_id) const {
+  planpb::Plan plan = template_plan;
+  for (auto& plan_fragment : *plan.mutable_nodes()) {
+    for (auto& plan_node : *plan_fragment.mutable_nodes()) {
+      if (plan_node.op().op_type() != planpb::GRPC_SINK_OPERATOR) {
+        continue;
+      }
+      IRNode* node = Get(plan_node.id());
+      if (node == nullptr || !Match(node, GRPCSink())) {
+        return error::Internal("Plan node $0 is not a GRPC sink of this plan.", plan_node.id());
+      }
+      const GRPCSinkIR* grpc_sink = static_cast<const GRPCSinkIR*>(node);
+      if (!grpc_sink->has_output_table()) {
+        PL_RETURN_IF_ERROR(grpc_sink->ToProto(plan_node.mutable_op(), agent_id));
+      }
+    }
+  }
+  return plan;
+}
+
 Status IR::OutputProto(planpb::PlanFragment* pf, const OperatorIR* op_node,
                        int64_t agent_id) const {
   // Check to make sure that the relation is set for this op_node, otherwise it's not connected to
@@ -1653,6 +1792,8 @@ Status GRPCSourceGroupIR::AddGRPCSink(GRPCSinkIR* sink_op,
   }
   sink_op->SetDestinationAddress(grpc_address_);
   sink_op->SetDestinationSSLTargetName(ssl_targetname_);
+  sink_op->SetArrowRowBatches(accepts_arrow_row_batches_);
+  sink_op->SetCompressRowBatches(accepts_compressed_row_batches_);
   dependent_sinks_.emplace_back(sink_op, agents);
   return Status::OK();
 }
@@ -1816,7 +1957,8 @@ StatusOr<JoinIR::JoinType> JoinIR::GetJoinEnum(const std::string& join_type_str)
   absl::flat_hash_map<std::string, JoinType> join_key_mapping = {{"inner", JoinType::kInner},
                                                                  {"left", JoinType::kLeft},
                                                                  {"outer", JoinType::kOuter},
-                                                                 {"right", JoinType::kRight}};
+                                                                 {"right", JoinType::kRight},
+                                                                 {"asof", JoinType::kAsof}};
   auto iter = join_key_mapping.find(join_type_str);
 
   // If the join type is not found, then return an error.
@@ -1835,7 +1977,8 @@ planpb::JoinOperator::JoinType JoinIR::GetPbJoinEnum(JoinType join_type) {
   absl::flat_hash_map<JoinType, planpb::JoinOperator::JoinType> join_key_mapping = {
       {JoinType::kInner, planpb::JoinOperator_JoinType_INNER},
       {JoinType::kLeft, planpb::JoinOperator_JoinType_LEFT_OUTER},
-      {JoinType::kOuter, planpb::JoinOperator_JoinType_FULL_OUTER}};
+      {JoinType::kOuter, planpb::JoinOperator_JoinType_FULL_OUTER},
+      {JoinType::kAsof, planpb::JoinOperator_JoinType_ASOF}};
   auto join_key_iter = join_key_mapping.find(join_type);
   CHECK(join_key_iter != join_key_mapping.end()) << "Received an unexpected enum value.";
   return join_key_iter->second;
@@ -1847,7 +1990,20 @@ Status JoinIR::ToProto(planpb::Operator* op) const {
   auto pb = op->mutable_join_op();
   op->set_op_type(planpb::JOIN_OPERATOR);
   pb->set_type(join_enum_type);
-  for (int64_t i = 0; i < static_cast<int64_t>(left_on_columns_.size()); i++) {
+  int64_t num_equality_conditions = left_on_columns_.size();
+  // ASOF joins match on the last pair of columns by time, the rest are equality keys.
+  if (join_type_ == JoinType::kAsof) {
+    DCHECK_GT(num_equality_conditions, 0);
+    num_equality_conditions--;
+    PL_ASSIGN_OR_RETURN(auto left_index,
+                        left_on_columns_[num_equality_conditions]->GetColumnIndex());
+    PL_ASSIGN_OR_RETURN(auto right_index,
+                        right_on_columns_[num_equality_conditions]->GetColumnIndex());
+    pb->mutable_asof_condition()->set_left_time_column_index(left_index);
+    pb->mutable_asof_condition()->set_right_time_column_index(right_index);
+    pb->mutable_asof_condition()->set_tolerance_ns(asof_tolerance_ns_);
+  }
+  for (int64_t i = 0; i < num_equality_conditions; i++) {
     auto eq_condition = pb->add_equality_conditions();
     PL_ASSIGN_OR_RETURN(auto left_index, left_on_columns_[i]->GetColumnIndex());
     PL_ASSIGN_OR_RETURN(auto right_index, right_on_columns_[i]->GetColumnIndex());
@@ -1868,6 +2024,7 @@ Status JoinIR::ToProto(planpb::Operator* op) const {
   for (const auto& col_name : column_names_) {
     *(pb->add_column_names()) = col_name;
   }
+  pb->set_build_parent_index(build_parent_index_);
   // NOTE: not setting value as this is set in the execution engine. Keeping this here in case it
   // needs to be modified in the future.
   // pb->set_rows_per_batch(1024);
@@ -1892,7 +2049,12 @@ Status JoinIR::Init(const std::vector<OperatorIR*>& parents, const std::string&
   PL_RETURN_IF_ERROR(SetJoinColumns(left_on_cols, right_on_cols));
 
   suffix_strs_ = suffix_strs;
-  return SetJoinType(how_type);
+  PL_RETURN_IF_ERROR(SetJoinType(how_type));
+  if (join_type_ == JoinType::kAsof && left_on_cols.empty()) {
+    return CreateIRNodeError(
+        "ASOF joins need the time columns as the last of 'left_on' and 'right_on'.");
+  }
+  return Status::OK();
 }
 
 Status JoinIR::SetJoinColumns(const std::vector<ColumnIR*>& left_columns,
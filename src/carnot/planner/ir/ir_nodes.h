@@ -38,6 +38,7 @@
 #include "src/carnot/planner/types/types.h"
 #include "src/carnot/udfspb/udfs.pb.h"
 #include "src/common/base/base.h"
+#include "src/common/memory/memory.h"
 #include "src/shared/metadatapb/metadata.pb.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
@@ -48,7 +49,6 @@ namespace planner {
 
 class IR;
 class IRNode;
-using IRNodePtr = std::unique_ptr<IRNode>;
 
 enum class IRNodeType {
   kAny = -1,
@@ -226,15 +226,14 @@ class IR {
   template <typename TOperator>
   StatusOr<TOperator*> MakeNode(int64_t id, const pypa::AstPtr& ast) {
     id_node_counter = std::max(id + 1, id_node_counter);
-    auto node = std::make_unique<TOperator>(id);
+    TOperator* node = arena_.New<TOperator>(id);
     dag_.AddNode(node->id());
     node->set_graph(this);
     if (ast != nullptr) {
       node->SetLineCol(ast);
     }
-    TOperator* raw = node.get();
-    id_node_map_.emplace(node->id(), std::move(node));
-    return raw;
+    id_node_map_.emplace(node->id(), node);
+    return node;
   }
   StatusOr<IRNode*> MakeNodeWithType(IRNodeType node_type, int64_t new_node_id);
 
@@ -358,6 +357,16 @@ class IR {
   StatusOr<planpb::Plan> ToProto() const;
   StatusOr<planpb::Plan> ToProto(int64_t agent_id) const;
 
+  /**
+   * @brief Outputs the proto representation of this plan for the agent, from the output of
+   * ToProto() for another agent. The plans of the agents that share an IR only differ in the
+   * destination IDs of the GRPC sinks, so only those are converted again.
+   *
+   * @return StatusOr<planpb::Plan>
+   */
+  StatusOr<planpb::Plan> InstantiateProto(const planpb::Plan& template_plan,
+                                          int64_t agent_id) const;
+
   /**
    * @brief Removes the nodes and edges listed in the following set.
    *
@@ -416,8 +425,11 @@ class IR {
   // Helper function for Clone and CopySelectedOperators.
   Status CopySelectedNodesAndDeps(const IR* src, const absl::flat_hash_set<int64_t>& selected_ids);
 
+  // Owns every node of the graph. Rules create and delete many short-lived nodes, so deleted
+  // nodes are only removed from the graph and all of them are freed together with the IR.
+  Arena arena_;
   plan::DAG dag_;
-  std::unordered_map<int64_t, IRNodePtr> id_node_map_;
+  std::unordered_map<int64_t, IRNode*> id_node_map_;
   int64_t id_node_counter = 0;
 };
 
@@ -1267,6 +1279,18 @@ class MetadataIR : public ColumnIR {
  */
 class MemorySourceIR : public OperatorIR {
  public:
+  // A comparison between a column and a constant that the rows read from the source have to
+  // satisfy. The source uses it to skip batches, see planpb::ZoneMapPredicate.
+  struct ZoneMapPredicate {
+    std::string column_name;
+    planpb::ZoneMapPredicate::Op op;
+    planpb::ScalarValue value;
+    // The values and the pod and service names of IN predicates on UPIDs.
+    std::vector<planpb::ScalarValue> values;
+    std::vector<std::string> pod_names;
+    std::vector<std::string> service_names;
+  };
+
   MemorySourceIR() = delete;
   explicit MemorySourceIR(int64_t id) : OperatorIR(id, IRNodeType::kMemorySource) {}
 
@@ -1346,6 +1370,23 @@ class MemorySourceIR : public OperatorIR {
 
   Status ResolveType(CompilerState* compiler_state);
 
+  const std::vector<ZoneMapPredicate>& zone_map_predicates() const {
+    return zone_map_predicates_;
+  }
+  void AddZoneMapPredicate(const ZoneMapPredicate& predicate) {
+    zone_map_predicates_.push_back(predicate);
+  }
+
+  // Makes the source read a random sample of the table's batches or rows, for approximate
+  // queries. See planpb::Sample.
+  void SetSample(planpb::Sample::Unit unit, double rate) {
+    sample_.set_unit(unit);
+    sample_.set_rate(rate);
+    has_sample_ = true;
+  }
+  bool HasSample() const { return has_sample_; }
+  const planpb::Sample& sample() const { return sample_; }
+
  protected:
   StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
       const absl::flat_hash_set<std::string>& output_colnames) override;
@@ -1371,6 +1412,11 @@ class MemorySourceIR : public OperatorIR {
 
   types::TabletID tablet_value_;
   bool has_tablet_value_ = false;
+
+  std::vector<ZoneMapPredicate> zone_map_predicates_;
+
+  bool has_sample_ = false;
+  planpb::Sample sample_;
 };
 
 /**
@@ -1560,6 +1606,17 @@ class GroupAcceptorIR : public OperatorIR {
     return Status::OK();
   }
 
+  // Adds the columns in front of the current groups.
+  Status PrependGroups(const std::vector<ColumnIR*>& new_groups) {
+    std::vector<ColumnIR*> groups(new_groups.size());
+    for (size_t i = 0; i < new_groups.size(); ++i) {
+      PL_ASSIGN_OR_RETURN(groups[i], graph()->OptionallyCloneWithEdge(this, new_groups[i]));
+    }
+    groups.insert(groups.end(), groups_.begin(), groups_.end());
+    groups_ = std::move(groups);
+    return Status::OK();
+  }
+
  private:
   std::vector<ColumnIR*> groups_;
 };
@@ -1603,6 +1660,21 @@ class BlockingAggIR : public GroupAcceptorIR {
     pre_split_proto_ = pre_split_proto;
   }
 
+  // The share of the input rows that the aggregate sees when its input is read from a sampled
+  // memory source. The finalized counts and sums are scaled up by its inverse.
+  double sample_rate() const { return sample_rate_; }
+  void set_sample_rate(double sample_rate) { sample_rate_ = sample_rate; }
+
+  // Aggregates the input incrementally over tumbling windows of the given group, which holds the
+  // start of each window in the output. Set for the aggregates of rolling windows.
+  void SetTimeWindow(int64_t group_index, int64_t size_ns) {
+    time_window_group_index_ = group_index;
+    time_window_size_ns_ = size_ns;
+  }
+  bool has_time_window() const { return time_window_size_ns_ > 0; }
+  int64_t time_window_group_index() const { return time_window_group_index_; }
+  int64_t time_window_size_ns() const { return time_window_size_ns_; }
+
  protected:
   StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
       const absl::flat_hash_set<std::string>& output_colnames) override;
@@ -1615,6 +1687,10 @@ class BlockingAggIR : public GroupAcceptorIR {
   // Whether this finalizes the result of a partial aggregate.
   bool finalize_results_ = true;
   planpb::AggregateOperator pre_split_proto_;
+  double sample_rate_ = 1.0;
+  int64_t time_window_group_index_ = 0;
+  // Zero when the aggregate isn't over time windows.
+  int64_t time_window_size_ns_ = 0;
 };
 
 class GroupByIR : public OperatorIR {
@@ -1713,6 +1789,45 @@ class LimitIR : public OperatorIR {
   std::unordered_set<int64_t> abortable_srcs_;
 };
 
+/**
+ * @brief IR for the TopK operator, which outputs the first limit_value rows of its parent when
+ * ordered by the sort columns. Like Limit, a TopK can run on each PEM and again after the merge,
+ * because the top k of the union is contained in the union of the local top k results.
+ */
+class TopKIR : public OperatorIR {
+ public:
+  TopKIR() = delete;
+  explicit TopKIR(int64_t id) : OperatorIR(id, IRNodeType::kTopK) {}
+
+  Status Init(OperatorIR* parent, const std::vector<std::string>& sort_cols,
+              const std::vector<bool>& descending, int64_t limit_value);
+  Status ToProto(planpb::Operator*) const override;
+
+  int64_t limit_value() const { return limit_value_; }
+  const std::vector<std::string>& sort_cols() const { return sort_cols_; }
+  const std::vector<bool>& descending() const { return descending_; }
+
+  Status CopyFromNodeImpl(const IRNode* node,
+                          absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
+  inline bool IsBlocking() const override { return true; }
+
+  StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
+
+  Status ResolveType(CompilerState* compiler_state);
+
+ protected:
+  StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
+      const absl::flat_hash_set<std::string>& output_cols) override {
+    return output_cols;
+  }
+
+ private:
+  int64_t limit_value_ = 0;
+  // Names of the columns to sort by, in order of precedence.
+  std::vector<std::string> sort_cols_;
+  std::vector<bool> descending_;
+};
+
 /**
  * @brief IR for the network sink operator that passes batches over GRPC to the destination.
  *
@@ -1791,6 +1906,26 @@ class GRPCSinkIR : public OperatorIR {
   const std::string& destination_address() const { return destination_address_; }
   bool DestinationAddressSet() const { return destination_address_ != ""; }
   const std::string& destination_ssl_targetname() const { return destination_ssl_targetname_; }
+  // Whether the destination accepts row batches whose columns are raw arrow buffers.
+  void SetArrowRowBatches(bool arrow_row_batches) { arrow_row_batches_ = arrow_row_batches; }
+  bool arrow_row_batches() const { return arrow_row_batches_; }
+  // Whether the destination accepts gzip compressed row batches.
+  void SetCompressRowBatches(bool compress_row_batches) {
+    compress_row_batches_ = compress_row_batches;
+  }
+  bool compress_row_batches() const { return compress_row_batches_; }
+  // The planner's estimate of the bytes per row the query sends over its GRPC bridges, before and
+  // after the pre-split optimizer ran. The sink reports them in its exec stats.
+  void SetEstimatedQueryRowBytes(int64_t before_pushdown, int64_t after_pushdown) {
+    estimated_query_row_bytes_before_pushdown_ = before_pushdown;
+    estimated_query_row_bytes_after_pushdown_ = after_pushdown;
+  }
+  int64_t estimated_query_row_bytes_before_pushdown() const {
+    return estimated_query_row_bytes_before_pushdown_;
+  }
+  int64_t estimated_query_row_bytes_after_pushdown() const {
+    return estimated_query_row_bytes_after_pushdown_;
+  }
 
   bool has_output_table() const { return sink_type_ == GRPCSinkType::kExternal; }
   std::string name() const { return name_; }
@@ -1827,6 +1962,10 @@ class GRPCSinkIR : public OperatorIR {
  private:
   std::string destination_address_ = "";
   std::string destination_ssl_targetname_ = "";
+  bool arrow_row_batches_ = false;
+  bool compress_row_batches_ = false;
+  int64_t estimated_query_row_bytes_before_pushdown_ = 0;
+  int64_t estimated_query_row_bytes_after_pushdown_ = 0;
   GRPCSinkType sink_type_ = GRPCSinkType::kTypeNotSet;
   // Used when GRPCSinkType = kInternal.
   int64_t destination_id_ = -1;
@@ -1897,6 +2036,12 @@ class GRPCSourceGroupIR : public OperatorIR {
 
   void SetGRPCAddress(const std::string& grpc_address) { grpc_address_ = grpc_address; }
   void SetSSLTargetName(const std::string& ssl_targetname) { ssl_targetname_ = ssl_targetname; }
+  void SetAcceptsArrowRowBatches(bool accepts_arrow_row_batches) {
+    accepts_arrow_row_batches_ = accepts_arrow_row_batches;
+  }
+  void SetAcceptsCompressedRowBatches(bool accepts_compressed_row_batches) {
+    accepts_compressed_row_batches_ = accepts_compressed_row_batches;
+  }
 
   /**
    * @brief Associate the passed in GRPCSinkOperator with this Source Group. The sink_op passed in
@@ -1935,6 +2080,8 @@ class GRPCSourceGroupIR : public OperatorIR {
   int64_t source_id_ = -1;
   std::string grpc_address_ = "";
   std::string ssl_targetname_ = "";
+  bool accepts_arrow_row_batches_ = false;
+  bool accepts_compressed_row_batches_ = false;
   std::vector<std::pair<GRPCSinkIR*, absl::flat_hash_set<int64_t>>> dependent_sinks_;
 };
 
@@ -2007,7 +2154,7 @@ class UnionIR : public OperatorIR {
  */
 class JoinIR : public OperatorIR {
  public:
-  enum class JoinType { kLeft, kRight, kOuter, kInner };
+  enum class JoinType { kLeft, kRight, kOuter, kInner, kAsof };
 
   JoinIR() = delete;
   explicit JoinIR(int64_t id) : OperatorIR(id, IRNodeType::kJoin) {}
@@ -2055,6 +2202,10 @@ class JoinIR : public OperatorIR {
   Status SetOutputColumns(const std::vector<std::string>& column_names,
                           const std::vector<ColumnIR*>& columns);
   bool specified_as_right() const { return specified_as_right_; }
+  int64_t build_parent_index() const { return build_parent_index_; }
+  void SetBuildParentIndex(int64_t build_parent_index) { build_parent_index_ = build_parent_index; }
+  int64_t asof_tolerance_ns() const { return asof_tolerance_ns_; }
+  void SetAsofToleranceNS(int64_t tolerance_ns) { asof_tolerance_ns_ = tolerance_ns; }
 
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
 
@@ -2125,6 +2276,10 @@ class JoinIR : public OperatorIR {
   // Whether this join was originally specified as a right join.
   // Used because we transform left joins into right joins but need to do some back transform.
   bool specified_as_right_ = false;
+  // The parent that the executor buffers into its hash table.
+  int64_t build_parent_index_ = 0;
+  // How far back an ASOF join looks for right rows, or zero for no limit.
+  int64_t asof_tolerance_ns_ = 0;
 };
 
 /*
@@ -812,6 +812,29 @@ TEST_F(OperatorTests, internal_grpc_ops) {
   EXPECT_EQ(grpc_src_group->source_id(), grpc_id);
 }
 
+TEST_F(OperatorTests, internal_grpc_sink_arrow_row_batches) {
+  int64_t grpc_id = 123;
+  MemorySourceIR* mem_src = MakeMemSource();
+  GRPCSinkIR* grpc_sink = MakeGRPCSink(mem_src, grpc_id);
+  grpc_sink->AddDestinationIDMap(grpc_id, /* agent_id */ 0);
+
+  std::shared_ptr<IR> new_graph = std::make_shared<IR>();
+  std::shared_ptr<IR> old_graph = SwapGraphBeingBuilt(new_graph);
+  GRPCSourceGroupIR* grpc_src_group = MakeGRPCSourceGroup(grpc_id, MakeRelation());
+  MakeMemSink(grpc_src_group, "out");
+  grpc_src_group->SetGRPCAddress("1111");
+
+  // The sink only sends arrow buffers when the destination has said it accepts them.
+  EXPECT_FALSE(grpc_sink->arrow_row_batches());
+  grpc_src_group->SetAcceptsArrowRowBatches(true);
+  EXPECT_OK(grpc_src_group->AddGRPCSink(grpc_sink, {0}));
+  EXPECT_TRUE(grpc_sink->arrow_row_batches());
+
+  planpb::Operator pb;
+  EXPECT_OK(grpc_sink->ToProto(&pb, /* agent_id */ 0));
+  EXPECT_TRUE(pb.grpc_sink_op().arrow_row_batches());
+}
+
 TEST_F(OperatorTests, external_grpc) {
   MemorySourceIR* mem_src = MakeMemSource();
   GRPCSinkIR* grpc_sink = MakeGRPCSink(mem_src, "output_table", std::vector<std::string>{"outcol"});
@@ -1245,6 +1268,23 @@ TEST_F(ToProtoTests, ir) {
   EXPECT_THAT(pb, EqualsProto(kIRProto));
 }
 
+TEST_F(ToProtoTests, instantiate_proto) {
+  int64_t destination_id = 123;
+  auto mem_src = MakeMemSource(MakeRelation());
+  auto grpc_sink = MakeGRPCSink(mem_src, destination_id);
+  EXPECT_OK(grpc_sink->SetRelation(MakeRelation()));
+  grpc_sink->SetDestinationAddress("1111");
+  grpc_sink->AddDestinationIDMap(destination_id + 1, /* agent_id */ 0);
+  grpc_sink->AddDestinationIDMap(destination_id + 2, /* agent_id */ 1);
+
+  planpb::Plan template_pb = graph->ToProto(0).ConsumeValueOrDie();
+  planpb::Plan pb = graph->InstantiateProto(template_pb, 1).ConsumeValueOrDie();
+
+  EXPECT_THAT(pb, EqualsProto(graph->ToProto(1).ConsumeValueOrDie().DebugString()));
+  EXPECT_EQ(pb.nodes(0).nodes(1).op().grpc_sink_op().grpc_source_id(), destination_id + 2);
+  EXPECT_NOT_OK(graph->InstantiateProto(template_pb, 2));
+}
+
 constexpr char kExpectedUnionOpPb[] = R"proto(
 op_type: UNION_OPERATOR
 union_op {
@@ -1449,6 +1489,58 @@ TEST_F(ToProtoTests, left_join) {
   EXPECT_THAT(pb, EqualsProto(kExpectedLeftJoinOpPb));
 }
 
+constexpr char kExpectedAsofJoinOpPb[] = R"proto(
+op_type: JOIN_OPERATOR
+join_op {
+  type: ASOF
+  equality_conditions {
+    left_column_index: 1
+    right_column_index: 2
+  }
+  asof_condition {
+    left_time_column_index: 3
+    right_time_column_index: 4
+    tolerance_ns: 1000
+  }
+  output_columns {
+    parent_index: 0
+    column_index: 0
+  }
+  output_columns {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_only"
+  column_names: "right_only"
+}
+)proto";
+
+TEST_F(ToProtoTests, asof_join) {
+  Relation relation0({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64,
+                      types::DataType::INT64},
+                     {"left_only", "col1", "col2", "col3"});
+  auto mem_src1 = MakeMemSource(relation0);
+
+  Relation relation1({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64,
+                      types::DataType::INT64, types::DataType::INT64},
+                     {"right_only", "col1", "col2", "col3", "col4"});
+  auto mem_src2 = MakeMemSource(relation1);
+
+  auto join_op =
+      MakeJoin({mem_src1, mem_src2}, "asof", relation0, relation1,
+               std::vector<std::string>{"col1", "col3"}, std::vector<std::string>{"col2", "col4"});
+  std::vector<std::string> col_names{"left_only", "right_only"};
+  std::vector<ColumnIR*> cols{MakeColumn("left_only", 0, relation0),
+                              MakeColumn("right_only", 1, relation1)};
+  EXPECT_OK(join_op->SetOutputColumns(col_names, cols));
+  join_op->SetAsofToleranceNS(1000);
+
+  planpb::Operator pb;
+  EXPECT_OK(join_op->ToProto(&pb));
+
+  EXPECT_THAT(pb, EqualsProto(kExpectedAsofJoinOpPb));
+}
+
 constexpr char kExpectedOuterJoinOpPb[] = R"proto(
 op_type: JOIN_OPERATOR
 join_op {
@@ -141,6 +141,7 @@ inline ClassMatch<IRNodeType::kEmptySource> EmptySource() {
   return ClassMatch<IRNodeType::kEmptySource>();
 }
 inline ClassMatch<IRNodeType::kLimit> Limit() { return ClassMatch<IRNodeType::kLimit>(); }
+inline ClassMatch<IRNodeType::kTopK> TopK() { return ClassMatch<IRNodeType::kTopK>(); }
 
 inline ClassMatch<IRNodeType::kGRPCSource> GRPCSource() {
   return ClassMatch<IRNodeType::kGRPCSource>();
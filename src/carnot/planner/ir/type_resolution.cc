@@ -83,6 +83,17 @@ Status DropIR::ResolveType(CompilerState* /* compiler_state */) {
   return SetResolvedType(new_table);
 }
 
+Status TopKIR::ResolveType(CompilerState* /* compiler_state */) {
+  DCHECK_EQ(1, parent_types().size());
+  auto parent_table = std::static_pointer_cast<TableType>(parent_types()[0]);
+  for (const auto& col_name : sort_cols_) {
+    if (!parent_table->HasColumn(col_name)) {
+      return CreateIRNodeError("Column '$0' not found in parent dataframe", col_name);
+    }
+  }
+  return SetResolvedType(parent_table->Copy());
+}
+
 Status BlockingAggIR::ResolveType(CompilerState* compiler_state) {
   DCHECK_EQ(1, parent_types().size());
   auto new_table = TableType::Create();
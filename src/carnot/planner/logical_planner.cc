@@ -18,8 +18,15 @@
 
 #include "src/carnot/planner/logical_planner.h"
 
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "src/carnot/planner/ir/pattern_match.h"
 #include "src/shared/scriptspb/scripts.pb.h"
 
 namespace px {
@@ -52,16 +59,119 @@ StatusOr<std::unique_ptr<RelationMap>> MakeRelationMapFromDistributedState(
 
 StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
     const distributedpb::LogicalPlannerState& logical_state, RegistryInfo* registry_info,
-    int64_t max_output_rows_per_table) {
+    int64_t max_output_rows_per_table, int64_t time_now = px::CurrentTimeNS()) {
   PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
                       MakeRelationMapFromDistributedState(logical_state.distributed_state()));
   // Create a CompilerState obj using the relation map and grabbing the current time.
 
   return std::make_unique<planner::CompilerState>(
-      std::move(rel_map), registry_info, px::CurrentTimeNS(), max_output_rows_per_table,
+      std::move(rel_map), registry_info, time_now, max_output_rows_per_table,
       logical_state.result_address(), logical_state.result_ssl_targetname());
 }
 
+namespace {
+
+// Clears the table stats of the state. They change with every update of the state, but only tune
+// the plan (e.g. the build side of joins), so a plan made with older stats is still good to reuse.
+void ClearTableStats(distributedpb::DistributedState* state) {
+  for (auto& carnot_info : *state->mutable_carnot_info()) {
+    for (auto& table_info : *carnot_info.mutable_table_info()) {
+      table_info.clear_size_bytes();
+      table_info.clear_min_time();
+    }
+  }
+}
+
+// Serializes a query for the plan cache key, which covers everything the plan is derived from:
+// the script and its arguments, the schemas, the agents and the plan options.
+std::string SerializeQuery(distributedpb::LogicalPlannerState logical_state,
+                           const plannerpb::QueryRequest& query_request) {
+  ClearTableStats(logical_state.mutable_distributed_state());
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&key);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    // Map fields (e.g. in the schemas) would otherwise be serialized in an arbitrary order.
+    coded_stream.SetSerializationDeterministic(true);
+    // The size prefix separates the two messages unambiguously.
+    coded_stream.WriteVarint64(logical_state.ByteSizeLong());
+    logical_state.SerializeToCodedStream(&coded_stream);
+    query_request.SerializeToCodedStream(&coded_stream);
+  }
+  return key;
+}
+
+// Moves the relative start and stop times of the memory sources of a reused plan (see
+// CompilerState::RelativeTime()) by shift_ns, to the time of the query that reuses it.
+void ShiftRelativeTimes(const absl::flat_hash_set<int64_t>& relative_times, int64_t shift_ns,
+                        distributedpb::DistributedPlan* plan_pb) {
+  if (relative_times.empty() || shift_ns == 0) {
+    return;
+  }
+  for (auto& [qb_address, plan] : *plan_pb->mutable_qb_address_to_plan()) {
+    for (auto& fragment : *plan.mutable_nodes()) {
+      for (auto& node : *fragment.mutable_nodes()) {
+        if (!node.op().has_mem_source_op()) {
+          continue;
+        }
+        auto mem_src = node.mutable_op()->mutable_mem_source_op();
+        if (mem_src->has_start_time() && relative_times.contains(mem_src->start_time().value())) {
+          mem_src->mutable_start_time()->set_value(mem_src->start_time().value() + shift_ns);
+        }
+        if (mem_src->has_stop_time() && relative_times.contains(mem_src->stop_time().value())) {
+          mem_src->mutable_stop_time()->set_value(mem_src->stop_time().value() + shift_ns);
+        }
+      }
+    }
+  }
+}
+
+// Makes the result sinks of the plan send their batches as ArrowColumns.
+void SetArrowResults(distributed::DistributedPlan* distributed_plan) {
+  for (IR* agent_plan : distributed_plan->UniquePlans()) {
+    for (IRNode* node : agent_plan->FindNodesThatMatch(GRPCSink())) {
+      auto grpc_sink = static_cast<GRPCSinkIR*>(node);
+      if (grpc_sink->has_output_table()) {
+        grpc_sink->SetArrowRowBatches(true);
+      }
+    }
+  }
+}
+
+// Whether a Kelvin can merge the queries that the coordinator plans for the remote processor
+// (see CoordinatorImpl::ProcessConfigImpl()).
+bool IsRemoteProcessor(const distributedpb::CarnotInfo& carnot_info) {
+  return carnot_info.processes_data() && carnot_info.accepts_remote_sources();
+}
+
+// Moves the part of the plan that runs on the from Kelvin to the to Kelvin: the plan of the from
+// Kelvin is given to the to Kelvin, and the GRPC sinks that sent to it send to the to Kelvin.
+void MoveKelvinPlan(const distributedpb::CarnotInfo& from, const distributedpb::CarnotInfo& to,
+                    distributedpb::DistributedPlan* plan_pb) {
+  auto plans = plan_pb->mutable_qb_address_to_plan();
+  auto dag_ids = plan_pb->mutable_qb_address_to_dag_id();
+  (*plans)[to.query_broker_address()] = std::move((*plans)[from.query_broker_address()]);
+  plans->erase(from.query_broker_address());
+  (*dag_ids)[to.query_broker_address()] = (*dag_ids)[from.query_broker_address()];
+  dag_ids->erase(from.query_broker_address());
+
+  for (auto& [qb_address, plan] : *plans) {
+    for (auto& fragment : *plan.mutable_nodes()) {
+      for (auto& node : *fragment.mutable_nodes()) {
+        if (!node.op().has_grpc_sink_op() ||
+            node.op().grpc_sink_op().address() != from.grpc_address()) {
+          continue;
+        }
+        auto grpc_sink = node.mutable_op()->mutable_grpc_sink_op();
+        grpc_sink->set_address(to.grpc_address());
+        grpc_sink->mutable_connection_options()->set_ssl_targetname(to.ssl_targetname());
+      }
+    }
+  }
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<LogicalPlanner>> LogicalPlanner::Create(const udfspb::UDFInfo& udf_info) {
   auto planner = std::unique_ptr<LogicalPlanner>(new LogicalPlanner());
   PL_RETURN_IF_ERROR(planner->Init(udf_info));
@@ -80,11 +190,141 @@ Status LogicalPlanner::Init(const udfspb::UDFInfo& udf_info) {
 StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
     const distributedpb::LogicalPlannerState& logical_state,
     const plannerpb::QueryRequest& query_request) {
+  PlanTimes times;
+  return PlanImpl(logical_state, query_request, &times);
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanProto(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  return PlanProtoWithCacheKey({0, SerializeQuery(logical_state, query_request)}, logical_state,
+                               query_request);
+}
+
+int64_t LogicalPlanner::SetDistributedState(distributedpb::DistributedState state) {
+  // The plans made against the previous state stay in the cache if the state only has new table
+  // stats.
+  distributedpb::DistributedState state_without_stats = state;
+  ClearTableStats(&state_without_stats);
+  std::string serialized_state;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&serialized_state);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    coded_stream.SetSerializationDeterministic(true);
+    state_without_stats.SerializeToCodedStream(&coded_stream);
+  }
+
+  absl::MutexLock lock(&distributed_state_lock_);
+  distributed_state_ = std::move(state);
+  if (distributed_state_version_ == 0 || serialized_state != serialized_state_without_stats_) {
+    serialized_state_without_stats_ = std::move(serialized_state);
+    ++plan_cache_state_version_;
+  }
+  return ++distributed_state_version_;
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanProtoWithStoredState(
+    int64_t state_version, distributedpb::LogicalPlannerState logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  absl::ReaderMutexLock lock(&distributed_state_lock_);
+  if (distributed_state_version_ == 0 || state_version != distributed_state_version_) {
+    return error::FailedPrecondition("The planner state is at version $0, but $1 was expected.",
+                                     distributed_state_version_, state_version);
+  }
+
+  // The state is part of the cache key through its version, rather than through its contents.
+  logical_state.clear_distributed_state();
+  PlanCacheKey key{plan_cache_state_version_, SerializeQuery(logical_state, query_request)};
+
+  // Lend the kept state to logical_state rather than copying it. It is only read while planning,
+  // which the reader lock allows to happen concurrently.
+  logical_state.set_allocated_distributed_state(&distributed_state_);
+  auto plan_or_s = PlanProtoWithCacheKey(std::move(key), logical_state, query_request);
+  logical_state.release_distributed_state();
+  return plan_or_s;
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanProtoWithCacheKey(
+    PlanCacheKey key, const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request) {
+  std::optional<CachedPlan> cached_plan;
+  {
+    absl::MutexLock lock(&plan_cache_lock_);
+    auto iter = plan_cache_.find(key);
+    if (iter != plan_cache_.end()) {
+      cached_plan = iter->second;
+    }
+  }
+  if (cached_plan.has_value()) {
+    ShiftRelativeTimes(cached_plan->times.relative_times,
+                       px::CurrentTimeNS() - cached_plan->times.time_now, &cached_plan->plan_pb);
+    SpreadAcrossKelvins(logical_state.distributed_state(), &cached_plan->plan_pb);
+    return std::move(cached_plan->plan_pb);
+  }
+
+  PlanTimes times;
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<distributed::DistributedPlan> distributed_plan,
+                      PlanImpl(logical_state, query_request, &times));
+  // In the future, if we actually have plan options that will actually determine how the plan is
+  // constructed, we may want to pass the planOptions to planner.Plan. However, this
+  // will need to go through many more layers (such as the coordinator), so this is fine for now.
+  distributed_plan->SetPlanOptions(logical_state.plan_options());
+  PL_ASSIGN_OR_RETURN(distributedpb::DistributedPlan plan_pb, distributed_plan->ToProto());
+
+  // The times computed from the time now (e.g. with px.now()) would be stale when the plan is
+  // reused. The relative memory source times are moved to the time of the later queries instead.
+  if (!times.time_now_used) {
+    absl::MutexLock lock(&plan_cache_lock_);
+    if (plan_cache_.size() >= kMaxCachedPlans) {
+      plan_cache_.clear();
+    }
+    plan_cache_.emplace(std::move(key), CachedPlan{plan_pb, std::move(times)});
+  }
+  SpreadAcrossKelvins(logical_state.distributed_state(), &plan_pb);
+  return plan_pb;
+}
+
+void LogicalPlanner::SpreadAcrossKelvins(const distributedpb::DistributedState& state,
+                                         distributedpb::DistributedPlan* plan_pb) {
+  // The coordinator makes the plans for the first remote processor. The queries can move to the
+  // Kelvins that receive row batches the same way, since the sinks that send to them are made
+  // for that.
+  const distributedpb::CarnotInfo* planned_kelvin = nullptr;
+  std::vector<const distributedpb::CarnotInfo*> kelvins;
+  for (const auto& carnot_info : state.carnot_info()) {
+    if (!IsRemoteProcessor(carnot_info)) {
+      continue;
+    }
+    if (planned_kelvin == nullptr) {
+      planned_kelvin = &carnot_info;
+    }
+    if (!carnot_info.has_data_store() &&
+        carnot_info.accepts_arrow_row_batches() == planned_kelvin->accepts_arrow_row_batches() &&
+        carnot_info.accepts_compressed_row_batches() ==
+            planned_kelvin->accepts_compressed_row_batches()) {
+      kelvins.push_back(&carnot_info);
+    }
+  }
+  if (kelvins.size() <= 1 || planned_kelvin->has_data_store() ||
+      plan_pb->qb_address_to_plan().count(planned_kelvin->query_broker_address()) == 0) {
+    return;
+  }
+  const distributedpb::CarnotInfo* kelvin = kelvins[next_kelvin_++ % kelvins.size()];
+  if (kelvin != planned_kelvin) {
+    MoveKelvinPlan(*planned_kelvin, *kelvin, plan_pb);
+  }
+}
+
+StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::PlanImpl(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request, PlanTimes* times) {
   // Compile into the IR.
   auto ms = logical_state.plan_options().max_output_rows_per_table();
   VLOG(1) << "Max output rows: " << ms;
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+  times->time_now = px::CurrentTimeNS();
+  PL_ASSIGN_OR_RETURN(
+      std::unique_ptr<CompilerState> compiler_state,
+      CreateCompilerState(logical_state, registry_info_.get(), ms, times->time_now));
 
   std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
                                                    query_request.exec_funcs().end());
@@ -92,8 +332,15 @@ StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
       std::shared_ptr<IR> single_node_plan,
       compiler_.CompileToIR(query_request.query_str(), compiler_state.get(), exec_funcs));
   // Create the distributed plan.
-  return distributed_planner_->Plan(logical_state.distributed_state(), compiler_state.get(),
-                                    single_node_plan.get());
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<distributed::DistributedPlan> distributed_plan,
+                      distributed_planner_->Plan(logical_state.distributed_state(),
+                                                 compiler_state.get(), single_node_plan.get()));
+  times->time_now_used = compiler_state->time_now_used();
+  times->relative_times = compiler_state->relative_times();
+  if (logical_state.plan_options().arrow_results()) {
+    SetArrowResults(distributed_plan.get());
+  }
+  return distributed_plan;
 }
 
 StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
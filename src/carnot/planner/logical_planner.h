@@ -17,14 +17,21 @@
  */
 
 #pragma once
+#include <atomic>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
 #include "src/carnot/planner/plannerpb/func_args.pb.h"
 #include "src/carnot/planner/probes/probes.h"
 #include "src/shared/scriptspb/scripts.pb.h"
@@ -58,6 +65,51 @@ class LogicalPlanner : public NotCopyable {
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::QueryRequest& query);
 
+  /**
+   * @brief Same as Plan(), but outputs the distributed plan as a proto, with the plan options of
+   * the logical state set. The plans that don't read the time now through px.now() are cached,
+   * keyed by the logical state without its table stats and the query, so the repeated requests
+   * for them skip compilation. The relative memory source times (e.g. start_time='-5m') of a
+   * cached plan are moved to the time of the request that reuses it. The queries, cached or not,
+   * take turns across the Kelvins of the state to merge on.
+   *
+   * @param logical_state: the distributed layout of the vizier instance.
+   * @param query: QueryRequest
+   * @return distributedpb::DistributedPlan or error if one occurs during compilation.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanProto(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query);
+
+  /**
+   * @brief Replaces the distributed state kept by the planner, which PlanProtoWithStoredState()
+   * plans against, so that callers don't have to pass (and the planner parse) the whole state
+   * with every query.
+   *
+   * @return the version of the new state.
+   */
+  int64_t SetDistributedState(distributedpb::DistributedState state);
+
+  /**
+   * @brief Same as PlanProto(), but plans against the kept distributed state instead of the one in
+   * logical_state, which is ignored.
+   *
+   * @param state_version: the version of the kept state the caller expects. Planning fails with
+   * FailedPrecondition if the state changed since, e.g. because the caller missed an update, in
+   * which case it should set the state again.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanProtoWithStoredState(
+      int64_t state_version, distributedpb::LogicalPlannerState logical_state,
+      const plannerpb::QueryRequest& query);
+
+  // The maximum number of plans in the plan cache. The cache is cleared when it is full.
+  static constexpr size_t kMaxCachedPlans = 64;
+
+  size_t num_cached_plans() {
+    absl::MutexLock lock(&plan_cache_lock_);
+    return plan_cache_.size();
+  }
+
   StatusOr<std::unique_ptr<compiler::MutationsIR>> CompileTrace(
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::CompileMutationsRequest& mutations_req);
@@ -87,9 +139,58 @@ class LogicalPlanner : public NotCopyable {
   LogicalPlanner() {}
 
  private:
+  // The times a plan was made with, which decide whether and how it can be reused.
+  struct PlanTimes {
+    int64_t time_now = 0;
+    // Whether the plan read the time now, e.g. through px.now(), so that it can't be reused.
+    bool time_now_used = false;
+    // The relative memory source times of the plan. See CompilerState::RelativeTime().
+    absl::flat_hash_set<int64_t> relative_times;
+  };
+
+  struct CachedPlan {
+    distributedpb::DistributedPlan plan_pb;
+    PlanTimes times;
+  };
+
+  // Plans the query, and fills in the times the plan was made with.
+  StatusOr<std::unique_ptr<distributed::DistributedPlan>> PlanImpl(
+      const distributedpb::LogicalPlannerState& logical_state, const plannerpb::QueryRequest& query,
+      PlanTimes* times);
+
+  // The key of a cached plan: the version of the kept distributed state, without its table stats,
+  // the plan was made against, and the serialized query. PlanProto() plans are keyed with version
+  // 0, which no kept state has, and have the distributed state serialized in the query instead.
+  using PlanCacheKey = std::pair<int64_t, std::string>;
+
+  // Implements PlanProto(), with the plan cache key of the query.
+  StatusOr<distributedpb::DistributedPlan> PlanProtoWithCacheKey(
+      PlanCacheKey key, const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query);
+
+  // Moves the Kelvin part of the plan from the Kelvin it was planned for to the next Kelvin in
+  // turn, so that the queries are spread across all of them.
+  void SpreadAcrossKelvins(const distributedpb::DistributedState& state,
+                           distributedpb::DistributedPlan* plan_pb);
+
   compiler::Compiler compiler_;
   std::unique_ptr<distributed::Planner> distributed_planner_;
   std::unique_ptr<planner::RegistryInfo> registry_info_;
+
+  absl::Mutex distributed_state_lock_;
+  distributedpb::DistributedState distributed_state_ ABSL_GUARDED_BY(distributed_state_lock_);
+  // Zero until a state is set.
+  int64_t distributed_state_version_ ABSL_GUARDED_BY(distributed_state_lock_) = 0;
+  // Only changes when the kept state changes other than in its table stats, so that the cached
+  // plans outlive the updates of the stats.
+  int64_t plan_cache_state_version_ ABSL_GUARDED_BY(distributed_state_lock_) = 0;
+  std::string serialized_state_without_stats_ ABSL_GUARDED_BY(distributed_state_lock_);
+
+  absl::Mutex plan_cache_lock_;
+  absl::flat_hash_map<PlanCacheKey, CachedPlan> plan_cache_
+      ABSL_GUARDED_BY(plan_cache_lock_);
+
+  std::atomic<uint64_t> next_kelvin_ = 0;
 };
 
 }  // namespace planner
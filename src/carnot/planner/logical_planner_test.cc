@@ -20,6 +20,9 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -39,6 +42,7 @@ namespace px {
 namespace carnot {
 namespace planner {
 using px::testing::proto::EqualsProto;
+using ::testing::ElementsAre;
 
 class LogicalPlannerTest : public ::testing::Test {
  protected:
@@ -77,6 +81,96 @@ t1 = px.DataFrame(table='http_events', start_time='-120s', select=['time_'])
 px.display(t1)
 )pxl";
 
+TEST_F(LogicalPlannerTest, plan_cache) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState();
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+
+  auto plan_pb = planner->PlanProto(state, query).ConsumeValueOrDie();
+  EXPECT_THAT(plan_pb, Partially(EqualsProto(testutils::kExpectedPlanOnePEMOneKelvin)));
+  EXPECT_EQ(planner->num_cached_plans(), 1UL);
+  EXPECT_THAT(planner->PlanProto(state, query).ConsumeValueOrDie(),
+              EqualsProto(plan_pb.DebugString()));
+  EXPECT_EQ(planner->num_cached_plans(), 1UL);
+
+  // New table stats don't change the key.
+  auto table_info = state.mutable_distributed_state()->mutable_carnot_info(0)->add_table_info();
+  table_info->set_table("table1");
+  table_info->set_size_bytes(1000);
+  table_info->set_min_time(10);
+  EXPECT_OK(planner->PlanProto(state, query));
+  EXPECT_EQ(planner->num_cached_plans(), 1UL);
+
+  // px.now() makes the plan depend on the compile time, so it is not cached.
+  EXPECT_OK(planner->PlanProto(
+      state, MakeQueryRequest("import px\n"
+                              "df = px.DataFrame('table1', start_time=px.now() - 10)\n"
+                              "px.display(df, 'out')")));
+  EXPECT_EQ(planner->num_cached_plans(), 1UL);
+}
+
+// Returns the start times of the memory sources of the plan.
+std::vector<int64_t> MemSrcStartTimes(const distributedpb::DistributedPlan& plan_pb) {
+  std::vector<int64_t> start_times;
+  for (const auto& [qb_address, plan] : plan_pb.qb_address_to_plan()) {
+    for (const auto& fragment : plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        if (node.op().has_mem_source_op()) {
+          start_times.push_back(node.op().mem_source_op().start_time().value());
+        }
+      }
+    }
+  }
+  return start_times;
+}
+
+TEST_F(LogicalPlannerTest, plan_cache_relative_times) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateOnePEMOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  auto query = MakeQueryRequest(kSimpleQueryDefaultLimit);
+  int64_t window_ns = std::chrono::nanoseconds(std::chrono::seconds(120)).count();
+
+  for (int i = 0; i < 2; ++i) {
+    int64_t start = px::CurrentTimeNS() - window_ns;
+    auto plan_pb = planner->PlanProto(state, query).ConsumeValueOrDie();
+    int64_t stop = px::CurrentTimeNS() - window_ns;
+    // The cached plan reads from 120s before the time of the second query, not of the first.
+    EXPECT_THAT(MemSrcStartTimes(plan_pb),
+                ElementsAre(::testing::AllOf(::testing::Ge(start), ::testing::Le(stop))));
+    EXPECT_EQ(planner->num_cached_plans(), 1UL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+TEST_F(LogicalPlannerTest, queries_spread_across_kelvins) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::LoadLogicalPlannerStatePB(testutils::kOnePEMThreeKelvinsDistributedState,
+                                                    testutils::kSchema);
+  auto query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+
+  std::vector<std::string> kelvins;
+  std::vector<std::string> pem_sink_addresses;
+  for (int i = 0; i < 4; ++i) {
+    auto plan_pb = planner->PlanProto(state, query).ConsumeValueOrDie();
+    ASSERT_EQ(plan_pb.qb_address_to_plan_size(), 2);
+    for (const auto& [qb_address, plan] : plan_pb.qb_address_to_plan()) {
+      if (qb_address != "pem") {
+        kelvins.push_back(qb_address);
+        continue;
+      }
+      for (const auto& node : plan.nodes(0).nodes()) {
+        if (node.op().has_grpc_sink_op()) {
+          pem_sink_addresses.push_back(node.op().grpc_sink_op().address());
+        }
+      }
+    }
+  }
+  // Only the first query is compiled, the others move the cached plan to their Kelvin.
+  EXPECT_EQ(planner->num_cached_plans(), 1UL);
+  EXPECT_THAT(kelvins, ElementsAre("kelvin1", "kelvin2", "kelvin3", "kelvin1"));
+  EXPECT_THAT(pem_sink_addresses, ElementsAre("1111", "1112", "1113", "1111"));
+}
+
 TEST_F(LogicalPlannerTest, max_output_rows) {
   auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
   auto state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
@@ -95,6 +189,29 @@ TEST_F(LogicalPlannerTest, max_output_rows) {
   EXPECT_OK(plan->ToProto());
 }
 
+TEST_F(LogicalPlannerTest, arrow_results) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  state.mutable_plan_options()->set_arrow_results(true);
+  auto plan_pb = planner->PlanProto(state, MakeQueryRequest(kSimpleQueryDefaultLimit))
+                     .ConsumeValueOrDie();
+
+  int64_t num_result_sinks = 0;
+  for (const auto& [address, agent_plan] : plan_pb.qb_address_to_plan()) {
+    for (const auto& fragment : agent_plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        if (node.op().op_type() != planpb::GRPC_SINK_OPERATOR ||
+            !node.op().grpc_sink_op().has_output_table()) {
+          continue;
+        }
+        EXPECT_TRUE(node.op().grpc_sink_op().arrow_row_batches());
+        ++num_result_sinks;
+      }
+    }
+  }
+  EXPECT_EQ(1, num_result_sinks);
+}
+
 constexpr char kCompileTimeQuery[] = R"pxl(
 import px
 
@@ -74,11 +74,14 @@ StatusOr<std::vector<std::string>> ParseAsListOfStrings(QLObjectPtr obj,
 Status Dataframe::Init() {
   PL_ASSIGN_OR_RETURN(
       std::shared_ptr<FuncObject> constructor_fn,
-      FuncObject::Create(name(), {"table", "select", "start_time", "end_time"},
+      FuncObject::Create(name(),
+                         {"table", "select", "start_time", "end_time", "sample", "sample_by"},
                          {{"select", "[]"},
                           {"start_time", "0"},
                           {"end_time", absl::Substitute("$0.$1()", PixieModule::kPixieModuleObjName,
-                                                        PixieModule::kNowOpID)}},
+                                                        PixieModule::kNowOpID)},
+                          {"sample", "1.0"},
+                          {"sample_by", "'batch'"}},
                          /* has_variable_len_args */ false,
                          /* has_variable_len_kwargs */ false,
                          std::bind(&DataFrameHandler::Eval, graph(), std::placeholders::_1,
@@ -93,13 +96,14 @@ Status Dataframe::Init() {
 
   /**
    * # Equivalent to the python method method syntax:
-   * def merge(self, right, how, left_on, right_on, suffixes=['_x', '_y']):
+   * def merge(self, right, how, left_on, right_on, suffixes=['_x', '_y'], tolerance=0):
    *     ...
    */
   PL_ASSIGN_OR_RETURN(
       std::shared_ptr<FuncObject> mergefn,
-      FuncObject::Create(kMergeOpID, {"right", "how", "left_on", "right_on", "suffixes"},
-                         {{"suffixes", "['_x', '_y']"}},
+      FuncObject::Create(kMergeOpID,
+                         {"right", "how", "left_on", "right_on", "suffixes", "tolerance"},
+                         {{"suffixes", "['_x', '_y']"}, {"tolerance", "0"}},
                          /* has_variable_len_args */ false,
                          /* has_variable_len_kwargs */ false,
                          std::bind(&JoinHandler::Eval, graph(), op(), std::placeholders::_1,
@@ -172,6 +176,22 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(limitfn->SetDocString(kLimitOpDocstring));
   AddMethod(kLimitOpID, limitfn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def top_k(self, by, n=5, descending=True):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> top_k_fn,
+      FuncObject::Create(kTopKOpID, {"by", "n", "descending"}, {{"n", "5"}, {"descending", "True"}},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&TopKHandler::Eval, graph(), op(), std::placeholders::_1,
+                                   std::placeholders::_2, std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(top_k_fn->SetDocString(kTopKOpDocstring));
+  AddMethod(kTopKOpID, top_k_fn);
+
   /**
    *
    * # Equivalent to the python method method syntax:
@@ -314,9 +334,30 @@ StatusOr<QLObjectPtr> JoinHandler::Eval(IR* graph, OperatorIR* op, const pypa::A
                                       suffix_strs.size());
   }
 
+  PL_ASSIGN_OR_RETURN(ExpressionIR * tolerance, GetArgAs<ExpressionIR>(ast, args, "tolerance"));
+  int64_t tolerance_ns = 0;
+  if (Match(tolerance, String())) {
+    auto tolerance_str = static_cast<StringIR*>(tolerance)->str();
+    PL_ASSIGN_OR_RETURN(tolerance_ns,
+                        WrapError(tolerance->ast(), StringToTimeInt(tolerance_str)));
+  } else if (Match(tolerance, Int())) {
+    tolerance_ns = static_cast<IntIR*>(tolerance)->val();
+  } else {
+    return tolerance->CreateIRNodeError(
+        "'tolerance' must be a duration string or an int of nanoseconds, received $0",
+        tolerance->type_string());
+  }
+  if (tolerance_ns < 0) {
+    return tolerance->CreateIRNodeError("'tolerance' must not be negative");
+  }
+  if (tolerance_ns > 0 && how_type != "asof") {
+    return tolerance->CreateIRNodeError("'tolerance' is only supported by asof merges");
+  }
+
   PL_ASSIGN_OR_RETURN(JoinIR * join_op,
                       graph->CreateNode<JoinIR>(ast, std::vector<OperatorIR*>{op, right}, how_type,
                                                 left_on_cols, right_on_cols, suffix_strs));
+  join_op->SetAsofToleranceNS(tolerance_ns);
   return Dataframe::Create(join_op, visitor);
 }
 
@@ -335,6 +376,24 @@ StatusOr<std::vector<ColumnIR*>> JoinHandler::ProcessCols(IR* graph, const pypa:
   return columns;
 }
 
+namespace {
+
+// The share of the rows of a sampled memory source that reach op, through operators with a
+// single parent. Rows that went through a join, union or another aggregate aren't a simple sample
+// of the source anymore, so they count as unsampled.
+double InputSampleRate(OperatorIR* op) {
+  while (!Match(op, MemorySource())) {
+    if (op->parents().size() != 1 || Match(op, BlockingAgg())) {
+      return 1.0;
+    }
+    op = op->parents()[0];
+  }
+  auto src = static_cast<MemorySourceIR*>(op);
+  return src->HasSample() ? src->sample().rate() : 1.0;
+}
+
+}  // namespace
+
 StatusOr<QLObjectPtr> AggHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                        const ParsedArgs& args, ASTVisitor* visitor) {
   // converts the mapping of args.kwargs into ColExpressionvector
@@ -353,6 +412,7 @@ StatusOr<QLObjectPtr> AggHandler::Eval(IR* graph, OperatorIR* op, const pypa::As
   PL_ASSIGN_OR_RETURN(
       BlockingAggIR * agg_op,
       graph->CreateNode<BlockingAggIR>(ast, op, std::vector<ColumnIR*>{}, aggregate_expressions));
+  agg_op->set_sample_rate(InputSampleRate(op));
   return Dataframe::Create(agg_op, visitor);
 }
 
@@ -418,6 +478,19 @@ StatusOr<QLObjectPtr> LimitHandler::Eval(IR* graph, OperatorIR* op, const pypa::
   return Dataframe::Create(limit_op, visitor);
 }
 
+StatusOr<QLObjectPtr> TopKHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                        const ParsedArgs& args, ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> sort_cols,
+                      ParseAsListOfStrings(args.GetArg("by"), "by"));
+  PL_ASSIGN_OR_RETURN(IntIR * rows_node, GetArgAs<IntIR>(ast, args, "n"));
+  PL_ASSIGN_OR_RETURN(BoolIR * descending_node, GetArgAs<BoolIR>(ast, args, "descending"));
+  std::vector<bool> descending(sort_cols.size(), descending_node->val());
+
+  PL_ASSIGN_OR_RETURN(TopKIR * top_k_op, graph->CreateNode<TopKIR>(ast, op, sort_cols, descending,
+                                                                   rows_node->val()));
+  return Dataframe::Create(top_k_op, visitor);
+}
+
 StatusOr<QLObjectPtr> SubscriptHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                              const ParsedArgs& args, ASTVisitor* visitor) {
   QLObjectPtr key = args.GetArg("key");
@@ -542,9 +615,42 @@ StatusOr<QLObjectPtr> DataFrameHandler::Eval(IR* graph, const pypa::AstPtr& ast,
         args.default_subbed_args().contains("end_time"))) {
     PL_RETURN_IF_ERROR(mem_source_op->SetTimeExpressions(start_time, end_time));
   }
+  if (!args.default_subbed_args().contains("sample")) {
+    PL_RETURN_IF_ERROR(SetSample(ast, args, mem_source_op));
+  }
   return Dataframe::Create(mem_source_op, visitor);
 }
 
+Status DataFrameHandler::SetSample(const pypa::AstPtr& ast, const ParsedArgs& args,
+                                   MemorySourceIR* mem_source_op) {
+  PL_ASSIGN_OR_RETURN(ExpressionIR * sample, GetArgAs<ExpressionIR>(ast, args, "sample"));
+  PL_ASSIGN_OR_RETURN(StringIR * sample_by, GetArgAs<StringIR>(ast, args, "sample_by"));
+  double rate;
+  if (sample->type() == IRNodeType::kFloat) {
+    rate = static_cast<FloatIR*>(sample)->val();
+  } else if (Match(sample, Int())) {
+    rate = static_cast<IntIR*>(sample)->val();
+  } else {
+    return sample->CreateIRNodeError("'sample' must be a number, received $0",
+                                     sample->type_string());
+  }
+  if (!(rate > 0 && rate <= 1)) {
+    return sample->CreateIRNodeError("'sample' must be in (0, 1], received $0", rate);
+  }
+
+  planpb::Sample::Unit unit;
+  if (sample_by->str() == "batch") {
+    unit = planpb::Sample::BATCH;
+  } else if (sample_by->str() == "row") {
+    unit = planpb::Sample::ROW;
+  } else {
+    return sample_by->CreateIRNodeError("'sample_by' must be 'batch' or 'row', received '$0'",
+                                        sample_by->str());
+  }
+  mem_source_op->SetSample(unit, rate);
+  return Status::OK();
+}
+
 }  // namespace compiler
 }  // namespace planner
 }  // namespace carnot
@@ -85,6 +85,9 @@ class Dataframe : public QLObject {
   Examples:
     # Absolute time specification.
     df = px.DataFrame('http_events', start_time='2020-07-13 18:02:5.00 -0700')
+  Examples:
+    # Approximate the request counts of the last hour from a tenth of the data.
+    df = px.DataFrame('http_events', start_time='-1h', sample=0.1)
 
   Args:
     table (string): The table name to load.
@@ -94,6 +97,12 @@ class Dataframe : public QLObject {
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
     end_time (px.Time): The last timestamp of data to load. Can be a relative time
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
+    sample (float): The share of the data to load, in (0, 1]. The same data always gives the
+      same sample. Counts and sums aggregated from the sample are scaled up to estimate
+      the totals. Defaults to loading all the data.
+    sample_by (string): 'batch' to sample whole batches of rows, which skips reading the rest,
+      or 'row' to sample each row on its own, which reads every batch but gives a sample that
+      is less clustered in time.
 
   Returns:
     px.DataFrame: DataFrame loaded from the table with the specified columns and time period.
@@ -266,6 +275,39 @@ class Dataframe : public QLObject {
     px.DataFrame: DataFrame with the first n rows.
   )doc";
 
+  inline static constexpr char kTopKOpID[] = "top_k";
+  inline static constexpr char kTopKOpDocstring[] = R"doc(
+  Return the first n rows when ordered by the given columns.
+
+  Returns a DataFrame with the n rows of data that sort first when ordered by the `by`
+  columns. Sorting is descending by default, which returns the n largest rows. The result is
+  sorted. When the query runs across several data sources, each source computes its own
+  top n before the results are merged, so much less data is sent over the network than with
+  a full sort.
+
+  :topic: dataframe_ops
+  :opname: TopK
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Keep the 10 slowest http requests.
+    df = df.top_k('latency', 10)
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Keep the 10 earliest http requests, breaking ties by latency.
+    df = df.top_k(['time_', 'latency'], 10, descending=False)
+
+  Args:
+    by (Union[string, List[string]]): The column or columns to sort by, in order of precedence.
+    n (int): The number of rows to return. If not set, default is 5.
+    descending (bool): Whether to sort the columns in descending order. If not set, default
+      is True.
+
+  Returns:
+    px.DataFrame: DataFrame with the first n rows in sorted order.
+  )doc";
+
   inline static constexpr char kMergeOpID[] = "merge";
   inline static constexpr char kMergeOpDocstring[] = R"doc(
   Merges the input DataFrame with this one using a database-style join.
@@ -290,14 +332,18 @@ class Dataframe : public QLObject {
 
   Args:
     right (px.DataFrame): The DataFrame to join with this DataFrame.
-    how (['inner', 'outer', 'left', 'right'], default 'inner'): the Type of merge to perform.
+    how (['inner', 'outer', 'left', 'right', 'asof'], default 'inner'): the Type of merge to perform.
       * inner: use the intersection of the left and right keys.
       * outer: use the union of the left and right keys.
       * left: use the keys from the left DataFrame.
       * right: use the keys from the right DataFrame.
+      * asof: match each left row with the latest right row at or before its time. The last
+        `left_on`/`right_on` pair are the time columns, any others must match exactly.
     left_on (string): Column name from this DataFrame.
     right_on (string): Column name from the right DataFarme to join on. Must be the same type as the `left_on` column.
     suffixes (Tuple[string, string], default ['_x', '_y']): The suffixes to apply to duplicate columns.
+    tolerance (px.Duration, default 0): asof merges only. How far before a left row a right
+      row can be to match it, like '5s'. 0 matches right rows of any age.
 
   Returns:
     px.DataFrame: Merged DataFrame with the relation
@@ -480,6 +526,24 @@ class DropHandler {
                                     const ParsedArgs& args, ASTVisitor* visitor);
 };
 
+/**
+ * @brief Implements the top_k operator logic.
+ *
+ */
+class TopKHandler {
+ public:
+  /**
+   * @brief Evaluates the top_k method.
+   *
+   * @param df the dataframe that's a parent to the top_k method.
+   * @param ast the ast node that signifies where the query was written
+   * @param args the arguments for top_k()
+   * @return StatusOr<QLObjectPtr>
+   */
+  static StatusOr<QLObjectPtr> Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                    const ParsedArgs& args, ASTVisitor* visitor);
+};
+
 /**
  * @brief Implements the limit operator logic.
  *
@@ -595,6 +659,10 @@ class DataFrameHandler {
  public:
   static StatusOr<QLObjectPtr> Eval(IR* graph, const pypa::AstPtr& ast, const ParsedArgs& args,
                                     ASTVisitor* visitor);
+
+ private:
+  static Status SetSample(const pypa::AstPtr& ast, const ParsedArgs& args,
+                          MemorySourceIR* mem_source_op);
 };
 
 class MapAssignHandler {
@@ -89,6 +89,7 @@ TEST_F(JoinHandlerTest, MergeTest) {
   args.AddArg("how", ToQLObject(MakeString("inner")));
   args.AddArg("left_on", MakeListObj(MakeString("a"), MakeString("b")));
   args.AddArg("right_on", MakeListObj(MakeString("b"), MakeString("c")));
+  args.AddArg("tolerance", ToQLObject(MakeInt(0)));
 
   auto status = JoinHandler::Eval(graph.get(), left, ast, args, ast_visitor.get());
   ASSERT_OK(status);
@@ -126,6 +127,7 @@ TEST_F(JoinHandlerTest, NonListKeysMergeTest) {
   args.AddArg("how", ToQLObject(MakeString("inner")));
   args.AddArg("left_on", ToQLObject(MakeString("a")));
   args.AddArg("right_on", ToQLObject(MakeString("b")));
+  args.AddArg("tolerance", ToQLObject(MakeInt(0)));
 
   auto status = JoinHandler::Eval(graph.get(), left, ast, args, ast_visitor.get());
   ASSERT_OK(status);
@@ -150,6 +152,44 @@ TEST_F(JoinHandlerTest, NonListKeysMergeTest) {
   EXPECT_THAT(join->suffix_strs(), ElementsAre("_x", "_y"));
 }
 
+TEST_F(JoinHandlerTest, AsofMergeWithToleranceTest) {
+  MemorySourceIR* left = MakeMemSource();
+  MemorySourceIR* right = MakeMemSource();
+
+  ParsedArgs args;
+  args.AddArg("suffixes", MakeListObj(MakeString("_x"), MakeString("_y")));
+  args.AddArg("right", ToQLObject(right));
+  args.AddArg("how", ToQLObject(MakeString("asof")));
+  args.AddArg("left_on", MakeListObj(MakeString("upid"), MakeString("time_")));
+  args.AddArg("right_on", MakeListObj(MakeString("upid"), MakeString("time_")));
+  args.AddArg("tolerance", ToQLObject(MakeString("5s")));
+
+  auto status = JoinHandler::Eval(graph.get(), left, ast, args, ast_visitor.get());
+  ASSERT_OK(status);
+  std::shared_ptr<QLObject> obj = status.ConsumeValueOrDie();
+  auto df_obj = static_cast<Dataframe*>(obj.get());
+  ASSERT_MATCH(df_obj->op(), Join());
+  JoinIR* join = static_cast<JoinIR*>(df_obj->op());
+  EXPECT_EQ(join->join_type(), JoinIR::JoinType::kAsof);
+  EXPECT_EQ(5000000000, join->asof_tolerance_ns());
+}
+
+TEST_F(JoinHandlerTest, ToleranceOnlyForAsofMergeTest) {
+  MemorySourceIR* left = MakeMemSource();
+  MemorySourceIR* right = MakeMemSource();
+
+  ParsedArgs args;
+  args.AddArg("suffixes", MakeListObj(MakeString("_x"), MakeString("_y")));
+  args.AddArg("right", ToQLObject(right));
+  args.AddArg("how", ToQLObject(MakeString("inner")));
+  args.AddArg("left_on", ToQLObject(MakeString("a")));
+  args.AddArg("right_on", ToQLObject(MakeString("b")));
+  args.AddArg("tolerance", ToQLObject(MakeInt(10)));
+
+  auto status = JoinHandler::Eval(graph.get(), left, ast, args, ast_visitor.get());
+  EXPECT_THAT(status.status(), HasCompilerError("'tolerance' is only supported by asof merges"));
+}
+
 using DropHandlerTest = DataframeTest;
 TEST_F(DropHandlerTest, DropTest) {
   MemorySourceIR* src = MakeMemSource();
@@ -694,6 +734,69 @@ TEST_F(DataframeTest, ConstructorTest) {
   EXPECT_EQ(mem_src->table_name(), "http_events");
 }
 
+TEST_F(DataframeTest, ConstructorSampleTest) {
+  auto df_or_s = Dataframe::Create(graph.get(), ast_visitor.get());
+  ASSERT_OK(df_or_s);
+  std::shared_ptr<QLObject> srcdf = df_or_s.ConsumeValueOrDie();
+
+  auto get_method_status = srcdf->GetCallMethod();
+  ASSERT_OK(get_method_status);
+  FuncObject* func_obj = static_cast<FuncObject*>(get_method_status.ConsumeValueOrDie().get());
+  ArgMap args = MakeArgMap({{"sample", MakeFloat(0.1)}, {"sample_by", MakeString("row")}},
+                           {MakeString("http_events")});
+
+  std::shared_ptr<QLObject> obj = func_obj->Call(args, ast).ConsumeValueOrDie();
+  auto df_obj = static_cast<Dataframe*>(obj.get());
+  ASSERT_MATCH(df_obj->op(), MemorySource());
+  MemorySourceIR* mem_src = static_cast<MemorySourceIR*>(df_obj->op());
+  ASSERT_TRUE(mem_src->HasSample());
+  EXPECT_EQ(mem_src->sample().unit(), planpb::Sample::ROW);
+  EXPECT_EQ(mem_src->sample().rate(), 0.1);
+}
+
+TEST_F(DataframeTest, ConstructorSampleOutOfRange) {
+  auto df_or_s = Dataframe::Create(graph.get(), ast_visitor.get());
+  ASSERT_OK(df_or_s);
+  std::shared_ptr<QLObject> srcdf = df_or_s.ConsumeValueOrDie();
+
+  auto get_method_status = srcdf->GetCallMethod();
+  ASSERT_OK(get_method_status);
+  FuncObject* func_obj = static_cast<FuncObject*>(get_method_status.ConsumeValueOrDie().get());
+  ArgMap args = MakeArgMap({{"sample", MakeFloat(1.5)}}, {MakeString("http_events")});
+
+  auto obj_or_s = func_obj->Call(args, ast);
+  ASSERT_NOT_OK(obj_or_s);
+  EXPECT_THAT(obj_or_s.status(), HasCompilerError("'sample' must be in \\(0, 1\\]"));
+}
+
+TEST_F(DataframeTest, AggOverSampledSource) {
+  MemorySourceIR* src = MakeMemSource();
+  src->SetSample(planpb::Sample::BATCH, 0.25);
+  FilterIR* filter = MakeFilter(src, MakeEqualsFunc(MakeInt(1), MakeInt(1)));
+
+  auto df_or_s = Dataframe::Create(filter, ast_visitor.get());
+  ASSERT_OK(df_or_s);
+  std::shared_ptr<QLObject> srcdf = df_or_s.ConsumeValueOrDie();
+
+  auto get_method_status = srcdf->GetMethod("agg");
+  ASSERT_OK(get_method_status);
+  FuncObject* func_obj = static_cast<FuncObject*>(get_method_status.ConsumeValueOrDie().get());
+
+  std::vector<QLObjectPtr> tup_args{
+      ToQLObject(MakeString("col1")),
+      MakeUDFFunc(ast_visitor.get(), src->graph(), "mean").ConsumeValueOrDie()};
+  std::vector<NameToNode> kwargs;
+  kwargs.push_back(
+      {"out_col1", TupleObject::Create(tup_args, ast_visitor.get()).ConsumeValueOrDie()});
+  ArgMap args{kwargs, {}};
+
+  // The rows reach the aggregate through the filter, so they're still a sample of the source.
+  std::shared_ptr<QLObject> obj = func_obj->Call(args, ast).ConsumeValueOrDie();
+  auto df_obj = static_cast<Dataframe*>(obj.get());
+  ASSERT_MATCH(df_obj->op(), BlockingAgg());
+  EXPECT_EQ(static_cast<BlockingAggIR*>(df_obj->op())->sample_rate(), 0.25);
+}
+
 TEST_F(LimitTest, StreamTest) {
   MemorySourceIR* src = MakeMemSource();
   ParsedArgs args;
@@ -17,12 +17,16 @@
  */
 
 #pragma once
+#include <chrono>
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/ir/ir_nodes.h"
 #include "src/carnot/planner/rules/rules.h"
@@ -116,6 +120,22 @@ class BaseRuleBatch {
 
 using RuleBatch = BaseRuleBatch<Rule>;
 
+/**
+ * @brief Execution statistics of a rule, for profiling the compiler.
+ */
+struct RuleExecutionStats {
+  std::string rule_batch;
+  // The type of the rule, as given by typeid.
+  std::string rule_type;
+  int64_t num_executions = 0;
+  // The number of times the rule changed the graph.
+  int64_t num_changes = 0;
+  // The number of times the rule wasn't executed, because the graph hadn't changed since the
+  // rule last ran without changing it.
+  int64_t num_skipped = 0;
+  std::chrono::nanoseconds total_time{0};
+};
+
 template <typename TPlan>
 class RuleExecutor {
   using TRule = BaseRule<TPlan>;
@@ -123,17 +143,37 @@ class RuleExecutor {
 
  public:
   virtual ~RuleExecutor() = default;
-  // TODO(philkuz) figure out how to collect stats on the execution.
   Status Execute(TPlan* ir_graph) {
     for (const auto& rb : rule_batches) {
       bool can_continue = true;
       int64_t iteration = 0;
+      // The number of times any rule of the batch changed the graph, and the value it had when
+      // each rule last ran without changing the graph. A rule that didn't change the graph would
+      // do nothing again until another rule changes it, so it is skipped until then.
+      int64_t graph_version = 0;
+      absl::flat_hash_map<const TRule*, int64_t> unchanged_at_version;
       // We continue executing a batch until a stop condition is met.
       while (can_continue) {
         iteration += 1;
         bool graph_is_updated = false;
         for (const auto& rule : rb->rules()) {
+          RuleExecutionStats* stats = GetStats(rb->name(), rule.get());
+          auto unchanged_it = unchanged_at_version.find(rule.get());
+          if (unchanged_it != unchanged_at_version.end() && unchanged_it->second == graph_version) {
+            ++stats->num_skipped;
+            continue;
+          }
+          auto start = std::chrono::steady_clock::now();
           PL_ASSIGN_OR_RETURN(bool rule_updates_graph, rule->Execute(ir_graph));
+          stats->total_time += std::chrono::steady_clock::now() - start;
+          ++stats->num_executions;
+          if (rule_updates_graph) {
+            ++stats->num_changes;
+            ++graph_version;
+            unchanged_at_version.erase(rule.get());
+          } else {
+            unchanged_at_version[rule.get()] = graph_version;
+          }
           graph_is_updated = graph_is_updated || rule_updates_graph;
         }
         if (iteration >= rb->max_iterations() && graph_is_updated) {
@@ -141,15 +181,20 @@ class RuleExecutor {
           // TODO(philkuz) Reviewer: should this be a failure somehow?
           can_continue = false;
         }
-        // TODO(philkuz) in the future we might have a fast way to check whether the graph has
-        // changed. For now let's be lazy and leave it up to the user to make sure rules properly
-        // update.
         // (graph_is_updated == false) => the graph has reached a fixed point and is done
         if (!graph_is_updated) {
           can_continue = false;
         }
       }
     }
+    for (const auto& stats : rule_stats_) {
+      VLOG(2) << absl::Substitute("Rule $0/$1: $2 executions, $3 changes, $4 skipped, $5us",
+                                  stats.rule_batch, stats.rule_type, stats.num_executions,
+                                  stats.num_changes, stats.num_skipped,
+                                  std::chrono::duration_cast<std::chrono::microseconds>(
+                                      stats.total_time)
+                                      .count());
+    }
     return Status::OK();
   }
   template <typename S, typename... Args>
@@ -160,8 +205,26 @@ class RuleExecutor {
     return out_ptr;
   }
 
+  /**
+   * @brief The execution statistics of every rule that has run, in the order they first ran.
+   */
+  const std::vector<RuleExecutionStats>& rule_stats() const { return rule_stats_; }
+
  private:
+  RuleExecutionStats* GetStats(const std::string& rule_batch, const TRule* rule) {
+    auto [it, inserted] = rule_stats_idx_.try_emplace(rule, rule_stats_.size());
+    if (inserted) {
+      RuleExecutionStats stats;
+      stats.rule_batch = rule_batch;
+      stats.rule_type = typeid(*rule).name();
+      rule_stats_.push_back(std::move(stats));
+    }
+    return &rule_stats_[it->second];
+  }
+
   std::vector<std::unique_ptr<TRuleBatch>> rule_batches;
+  std::vector<RuleExecutionStats> rule_stats_;
+  absl::flat_hash_map<const TRule*, size_t> rule_stats_idx_;
 };
 
 }  // namespace planner
@@ -162,8 +162,33 @@ TEST_F(RuleExecutorTest, rules_in_batch_correspond) {
       .WillOnce(Return(true))
       .WillOnce(Return(false));
 
+  // The last iteration skips rule1_2, because rule1_1 didn't change the graph since rule1_2 last
+  // ran without changing it.
   MockRule* rule1_2 = rule_batch1->AddRule<MockRule>(compiler_state_.get());
-  EXPECT_CALL(*rule1_2, Execute(_)).Times(3).WillOnce(Return(true)).WillRepeatedly(Return(false));
+  EXPECT_CALL(*rule1_2, Execute(_)).Times(2).WillOnce(Return(true)).WillRepeatedly(Return(false));
+
+  EXPECT_OK(executor->Execute(graph.get()));
+  ASSERT_EQ(2UL, executor->rule_stats().size());
+  EXPECT_EQ(3, executor->rule_stats()[0].num_executions);
+  EXPECT_EQ(1, executor->rule_stats()[0].num_changes);
+  EXPECT_EQ(0, executor->rule_stats()[0].num_skipped);
+  EXPECT_EQ(2, executor->rule_stats()[1].num_executions);
+  EXPECT_EQ(1, executor->rule_stats()[1].num_changes);
+  EXPECT_EQ(1, executor->rule_stats()[1].num_skipped);
+}
+
+// Tests that a rule that didn't change the graph runs again once another rule changes it.
+TEST_F(RuleExecutorTest, unchanged_rule_reruns_after_graph_changes) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch1 = executor->CreateRuleBatch<FailOnMax>("resolve", 10);
+  MockRule* rule1_1 = rule_batch1->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule1_1, Execute(_)).Times(3).WillRepeatedly(Return(false));
+  MockRule* rule1_2 = rule_batch1->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule1_2, Execute(_))
+      .Times(3)
+      .WillOnce(Return(true))
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
 
   EXPECT_OK(executor->Execute(graph.get()));
 }
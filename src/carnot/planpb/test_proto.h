@@ -177,6 +177,22 @@ column_names: "usage"
 streaming: false
 )";
 
+constexpr char kMemSourceOperatorGreaterThanPredicate[] = R"(
+name: "cpu"
+column_idxs: 1
+column_types: TIME64NS
+column_names: "time_"
+streaming: false
+predicates {
+  column_idx: 1
+  op: GREATER_THAN
+  value {
+    data_type: INT64
+    int64_value: $0
+  }
+}
+)";
+
 constexpr char kMemSourceOperatorAllRange[] = R"(
 name: "cpu"
 start_time: {
@@ -331,6 +347,23 @@ columns {
   index: 2
 }
 )";
+constexpr char kTopKOperator1[] = R"(
+limit: 10
+columns {
+  node: 1
+  index: 0
+}
+columns {
+  node: 1
+  index: 1
+}
+sort_columns {
+  node: 1
+  index: 1
+}
+descending: true
+)";
+
 // relation 1: [abc, time_]
 // relation 2: [time_, abc]
 // maps to output relation:
@@ -1354,6 +1387,15 @@ planpb::Operator CreateTestSourceEmptyRangePB() {
   return op;
 }
 
+planpb::Operator CreateTestSourceGreaterThanPredicatePB(int64_t value) {
+  planpb::Operator op;
+  auto mem_proto = absl::Substitute(kMemSourceOperatorGreaterThanPredicate, value);
+  auto op_proto =
+      absl::Substitute(kOperatorProtoTmpl, "MEMORY_SOURCE_OPERATOR", "mem_source_op", mem_proto);
+  CHECK(google::protobuf::TextFormat::MergeFromString(op_proto, &op)) << "Failed to parse proto";
+  return op;
+}
+
 planpb::Operator CreateTestSourceAllRangePB() {
   planpb::Operator op;
   auto op_proto = absl::Substitute(kOperatorProtoTmpl, "MEMORY_SOURCE_OPERATOR", "mem_source_op",
@@ -1474,6 +1516,14 @@ planpb::Operator CreateTestDropLimit1PB() {
   return op;
 }
 
+planpb::Operator CreateTestTopK1PB() {
+  planpb::Operator op;
+  auto op_proto =
+      absl::Substitute(kOperatorProtoTmpl, "TOP_K_OPERATOR", "top_k_op", kTopKOperator1);
+  CHECK(google::protobuf::TextFormat::MergeFromString(op_proto, &op)) << "Failed to parse proto";
+  return op;
+}
+
 planpb::Operator CreateTestJoinWithTimePB() {
   planpb::Operator op;
   auto op_proto = absl::Substitute(kOperatorProtoTmpl, "JOIN_OPERATOR", "join_op", kJoinOperator1);
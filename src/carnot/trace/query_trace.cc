@@ -0,0 +1,266 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/trace/query_trace.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <time.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#include <absl/strings/str_format.h>
+
+DEFINE_int64(carnot_query_trace_max_spans, 10000,
+             "The number of query trace spans that Carnot keeps in memory for _QuerySpans.");
+DEFINE_string(carnot_query_trace_otlp_file, "",
+              "If set, Carnot appends the spans of every query to this file as OTLP JSON.");
+
+namespace px {
+namespace carnot {
+namespace trace {
+
+namespace {
+
+int64_t ThreadCPUTimeNS() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 * 1000 + ts.tv_nsec;
+}
+
+uint64_t NewSpanID() {
+  thread_local std::mt19937_64 rng{std::random_device{}()};
+  uint64_t id = 0;
+  // 0 is reserved for spans without a parent.
+  while (id == 0) {
+    id = rng();
+  }
+  return id;
+}
+
+std::string SpanIDHex(uint64_t id) { return absl::StrFormat("%016x", id); }
+
+std::string TraceIDHex(const sole::uuid& id) { return absl::StrFormat("%016x%016x", id.ab, id.cd); }
+
+using JSONWriter = rapidjson::Writer<rapidjson::StringBuffer>;
+
+void WriteString(JSONWriter* writer, std::string_view s) { writer->String(s.data(), s.size()); }
+
+void WriteAttribute(JSONWriter* writer, std::string_view key, std::string_view value) {
+  writer->StartObject();
+  WriteString(writer, "key");
+  WriteString(writer, key);
+  WriteString(writer, "value");
+  writer->StartObject();
+  WriteString(writer, "stringValue");
+  WriteString(writer, value);
+  writer->EndObject();
+  writer->EndObject();
+}
+
+// OTLP JSON encodes 64 bit integers as strings.
+void WriteIntAttribute(JSONWriter* writer, std::string_view key, int64_t value) {
+  writer->StartObject();
+  WriteString(writer, "key");
+  WriteString(writer, key);
+  WriteString(writer, "value");
+  writer->StartObject();
+  WriteString(writer, "intValue");
+  WriteString(writer, std::to_string(value));
+  writer->EndObject();
+  writer->EndObject();
+}
+
+void WriteSpan(JSONWriter* writer, const QuerySpan& span) {
+  // SPAN_KIND_INTERNAL.
+  constexpr int kSpanKindInternal = 1;
+  writer->StartObject();
+  WriteString(writer, "traceId");
+  WriteString(writer, TraceIDHex(span.query_id));
+  WriteString(writer, "spanId");
+  WriteString(writer, SpanIDHex(span.span_id));
+  if (span.parent_span_id != 0) {
+    WriteString(writer, "parentSpanId");
+    WriteString(writer, SpanIDHex(span.parent_span_id));
+  }
+  WriteString(writer, "name");
+  WriteString(writer, span.name);
+  WriteString(writer, "kind");
+  writer->Int(kSpanKindInternal);
+  WriteString(writer, "startTimeUnixNano");
+  WriteString(writer, std::to_string(span.start_time_ns));
+  WriteString(writer, "endTimeUnixNano");
+  WriteString(writer, std::to_string(span.end_time_ns));
+  WriteString(writer, "attributes");
+  writer->StartArray();
+  for (const auto& [k, v] : span.attributes) {
+    WriteAttribute(writer, k, v);
+  }
+  if (span.cpu_time_ns >= 0) {
+    WriteIntAttribute(writer, "px.cpu_time_ns", span.cpu_time_ns);
+  }
+  if (span.peak_memory_bytes >= 0) {
+    WriteIntAttribute(writer, "px.peak_memory_bytes", span.peak_memory_bytes);
+  }
+  writer->EndArray();
+  writer->EndObject();
+}
+
+}  // namespace
+
+QueryTraceStore::QueryTraceStore(size_t max_spans, std::string otlp_file)
+    : max_spans_(max_spans), otlp_file_(std::move(otlp_file)) {}
+
+QueryTraceStore* QueryTraceStore::Default() {
+  static auto* store = new QueryTraceStore(
+      static_cast<size_t>(std::max<int64_t>(0, FLAGS_carnot_query_trace_max_spans)),
+      FLAGS_carnot_query_trace_otlp_file);
+  return store;
+}
+
+void QueryTraceStore::Add(std::vector<QuerySpan> spans) {
+  if (spans.empty()) {
+    return;
+  }
+  std::string otlp_json = otlp_file_.empty() ? "" : ToOTLPJSON(spans);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  if (!otlp_json.empty()) {
+    std::ofstream out(otlp_file_, std::ios::app);
+    out << otlp_json << "\n";
+    if (!out) {
+      LOG_FIRST_N(WARNING, 1) << absl::Substitute("Failed to write query spans to $0", otlp_file_);
+    }
+  }
+  for (auto& span : spans) {
+    spans_.push_back(std::move(span));
+  }
+  while (spans_.size() > max_spans_) {
+    spans_.pop_front();
+  }
+}
+
+std::vector<QuerySpan> QueryTraceStore::Spans() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return {spans_.begin(), spans_.end()};
+}
+
+QueryTrace::Span::Span(QueryTrace* trace, QuerySpan span, int64_t start_cpu_time_ns)
+    : trace_(trace),
+      span_(std::move(span)),
+      thread_id_(std::this_thread::get_id()),
+      start_cpu_time_ns_(start_cpu_time_ns) {}
+
+QueryTrace::Span& QueryTrace::Span::operator=(Span&& other) noexcept {
+  if (this != &other) {
+    End();
+    trace_ = other.trace_;
+    span_ = std::move(other.span_);
+    thread_id_ = other.thread_id_;
+    start_cpu_time_ns_ = other.start_cpu_time_ns_;
+    other.trace_ = nullptr;
+  }
+  return *this;
+}
+
+void QueryTrace::Span::End() {
+  if (trace_ == nullptr) {
+    return;
+  }
+  span_.end_time_ns = CurrentTimeNS();
+  if (thread_id_ == std::this_thread::get_id()) {
+    span_.cpu_time_ns = ThreadCPUTimeNS() - start_cpu_time_ns_;
+  }
+  trace_->Finish(std::move(span_));
+  trace_ = nullptr;
+}
+
+QueryTrace::QueryTrace(const sole::uuid& query_id, std::string agent, QueryTraceStore* store)
+    : query_id_(query_id), agent_(std::move(agent)), store_(store) {}
+
+QueryTrace::~QueryTrace() {
+  if (store_ != nullptr) {
+    store_->Add(std::move(finished_spans_));
+  }
+}
+
+QueryTrace::Span QueryTrace::StartSpan(std::string name, uint64_t parent_span_id) {
+  QuerySpan span;
+  span.query_id = query_id_;
+  span.span_id = NewSpanID();
+  span.parent_span_id = parent_span_id;
+  span.name = std::move(name);
+  span.attributes["px.agent"] = agent_;
+  span.start_time_ns = CurrentTimeNS();
+  return Span(this, std::move(span), ThreadCPUTimeNS());
+}
+
+std::vector<QuerySpan> QueryTrace::finished_spans() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return finished_spans_;
+}
+
+void QueryTrace::Finish(QuerySpan span) {
+  std::lock_guard<std::mutex> lock(mu_);
+  finished_spans_.push_back(std::move(span));
+}
+
+std::string ToOTLPJSON(const std::vector<QuerySpan>& spans) {
+  rapidjson::StringBuffer sb;
+  JSONWriter writer(sb);
+  writer.StartObject();
+  WriteString(&writer, "resourceSpans");
+  writer.StartArray();
+  writer.StartObject();
+  WriteString(&writer, "resource");
+  writer.StartObject();
+  WriteString(&writer, "attributes");
+  writer.StartArray();
+  WriteAttribute(&writer, "service.name", "carnot");
+  writer.EndArray();
+  writer.EndObject();
+  WriteString(&writer, "scopeSpans");
+  writer.StartArray();
+  writer.StartObject();
+  WriteString(&writer, "scope");
+  writer.StartObject();
+  WriteString(&writer, "name");
+  WriteString(&writer, "px.carnot.query_trace");
+  writer.EndObject();
+  WriteString(&writer, "spans");
+  writer.StartArray();
+  for (const auto& span : spans) {
+    WriteSpan(&writer, span);
+  }
+  writer.EndArray();
+  writer.EndObject();
+  writer.EndArray();
+  writer.EndObject();
+  writer.EndArray();
+  writer.EndObject();
+  return sb.GetString();
+}
+
+}  // namespace trace
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sole.hpp>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace trace {
+
+/**
+ * A finished span of a query trace. Spans recorded on different agents for the same query share
+ * the query ID, which is used as the trace ID when exporting them.
+ */
+struct QuerySpan {
+  sole::uuid query_id;
+  uint64_t span_id = 0;
+  // 0 for the root spans of an agent.
+  uint64_t parent_span_id = 0;
+  std::string name;
+  int64_t start_time_ns = 0;
+  int64_t end_time_ns = 0;
+  // CPU time of the thread that started the span, or -1 if the span ended on another thread.
+  int64_t cpu_time_ns = -1;
+  // Peak memory of the query while the span was open, or -1 if it wasn't measured.
+  int64_t peak_memory_bytes = -1;
+  std::map<std::string, std::string> attributes;
+
+  int64_t duration_ns() const { return end_time_ns - start_time_ns; }
+};
+
+/**
+ * QueryTraceStore keeps the most recent spans of all queries run in this process, and optionally
+ * appends every finished trace to a file as OTLP JSON, which an OpenTelemetry collector can tail.
+ */
+class QueryTraceStore : public NotCopyable {
+ public:
+  /**
+   * @param max_spans The number of spans kept in memory. The oldest spans are dropped first.
+   * @param otlp_file The file to append OTLP JSON to, one ExportTraceServiceRequest per line.
+   * Empty to not export spans.
+   */
+  QueryTraceStore(size_t max_spans, std::string otlp_file);
+
+  // The store that all of Carnot's queries record to, sized by flags.
+  static QueryTraceStore* Default();
+
+  void Add(std::vector<QuerySpan> spans);
+
+  std::vector<QuerySpan> Spans() const;
+
+ private:
+  const size_t max_spans_;
+  const std::string otlp_file_;
+
+  mutable std::mutex mu_;
+  std::deque<QuerySpan> spans_;
+};
+
+/**
+ * QueryTrace collects the spans of a query on one agent, and adds them to a QueryTraceStore once
+ * the query is done.
+ *
+ * Spans are opened with StartSpan and end when the returned object goes out of scope or End() is
+ * called on it. QueryTrace is thread-safe, but a single Span is not.
+ */
+class QueryTrace : public NotCopyable {
+ public:
+  class Span {
+   public:
+    Span() = default;
+    Span(Span&& other) noexcept { *this = std::move(other); }
+    Span& operator=(Span&& other) noexcept;
+    ~Span() { End(); }
+
+    uint64_t id() const { return span_.span_id; }
+    bool active() const { return trace_ != nullptr; }
+
+    void SetAttribute(const std::string& key, std::string value) {
+      span_.attributes[key] = std::move(value);
+    }
+    void SetAttribute(const std::string& key, int64_t value) {
+      span_.attributes[key] = std::to_string(value);
+    }
+    void set_peak_memory_bytes(int64_t bytes) { span_.peak_memory_bytes = bytes; }
+
+    void End();
+
+   private:
+    friend class QueryTrace;
+    Span(QueryTrace* trace, QuerySpan span, int64_t start_cpu_time_ns);
+
+    QueryTrace* trace_ = nullptr;
+    QuerySpan span_;
+    std::thread::id thread_id_;
+    int64_t start_cpu_time_ns_ = 0;
+  };
+
+  /**
+   * @param query_id The ID of the query, shared by all agents that run it.
+   * @param agent The name of the agent, attached to every span.
+   * @param store Where the spans go when the trace is destroyed. Null to drop them.
+   */
+  QueryTrace(const sole::uuid& query_id, std::string agent, QueryTraceStore* store);
+  ~QueryTrace();
+
+  Span StartSpan(std::string name, uint64_t parent_span_id = 0);
+
+  const sole::uuid& query_id() const { return query_id_; }
+
+  // The finished spans that haven't been added to the store yet.
+  std::vector<QuerySpan> finished_spans() const;
+
+ private:
+  void Finish(QuerySpan span);
+
+  const sole::uuid query_id_;
+  const std::string agent_;
+  QueryTraceStore* store_;
+
+  mutable std::mutex mu_;
+  std::vector<QuerySpan> finished_spans_;
+};
+
+/**
+ * Converts the spans to an OTLP ExportTraceServiceRequest in the protobuf JSON encoding.
+ */
+std::string ToOTLPJSON(const std::vector<QuerySpan>& spans);
+
+}  // namespace trace
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/trace/query_trace.h"
+
+#include <rapidjson/document.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace trace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+
+TEST(QueryTraceTest, spans_added_to_store_when_trace_is_done) {
+  QueryTraceStore store(/* max_spans */ 10, /* otlp_file */ "");
+  auto query_id = sole::uuid4();
+  {
+    QueryTrace trace(query_id, "kelvin", &store);
+    auto root = trace.StartSpan("execute_plan");
+    {
+      auto fragment = trace.StartSpan("fragment", root.id());
+      fragment.SetAttribute("fragment_id", 1);
+      fragment.set_peak_memory_bytes(1024);
+    }
+    EXPECT_EQ(1, trace.finished_spans().size());
+    EXPECT_TRUE(store.Spans().empty());
+  }
+
+  auto spans = store.Spans();
+  ASSERT_EQ(2, spans.size());
+  EXPECT_EQ("fragment", spans[0].name);
+  EXPECT_EQ("execute_plan", spans[1].name);
+  EXPECT_EQ(spans[1].span_id, spans[0].parent_span_id);
+  EXPECT_EQ(0, spans[1].parent_span_id);
+  for (const auto& span : spans) {
+    EXPECT_EQ(query_id, span.query_id);
+    EXPECT_EQ("kelvin", span.attributes.at("px.agent"));
+    EXPECT_LE(span.start_time_ns, span.end_time_ns);
+    EXPECT_GE(span.cpu_time_ns, 0);
+  }
+  EXPECT_EQ("1", spans[0].attributes.at("fragment_id"));
+  EXPECT_EQ(1024, spans[0].peak_memory_bytes);
+  EXPECT_EQ(-1, spans[1].peak_memory_bytes);
+}
+
+TEST(QueryTraceTest, moved_span_ends_once) {
+  QueryTraceStore store(10, "");
+  {
+    QueryTrace trace(sole::uuid4(), "pem", &store);
+    QueryTrace::Span span;
+    EXPECT_FALSE(span.active());
+    span = trace.StartSpan("grpc_sink");
+    QueryTrace::Span moved = std::move(span);
+    EXPECT_TRUE(moved.active());
+    moved.End();
+    moved.End();
+  }
+  EXPECT_THAT(store.Spans(), ElementsAre(Field(&QuerySpan::name, "grpc_sink")));
+}
+
+TEST(QueryTraceTest, store_drops_oldest_spans) {
+  QueryTraceStore store(2, "");
+  {
+    QueryTrace trace(sole::uuid4(), "pem", &store);
+    trace.StartSpan("a").End();
+    trace.StartSpan("b").End();
+    trace.StartSpan("c").End();
+  }
+  EXPECT_THAT(store.Spans(), ElementsAre(Field(&QuerySpan::name, "b"),
+                                         Field(&QuerySpan::name, "c")));
+}
+
+TEST(QueryTraceTest, otlp_json) {
+  QuerySpan parent;
+  parent.query_id = sole::rebuild("00000000-0000-0001-0000-000000000002");
+  parent.span_id = 0xabc;
+  parent.name = "execute_plan";
+  parent.start_time_ns = 100;
+  parent.end_time_ns = 200;
+  parent.cpu_time_ns = 50;
+  QuerySpan child = parent;
+  child.span_id = 0xdef;
+  child.parent_span_id = 0xabc;
+  child.name = "fragment";
+  child.attributes["px.agent"] = "pem";
+
+  rapidjson::Document doc;
+  doc.Parse(ToOTLPJSON({parent, child}).c_str());
+  ASSERT_FALSE(doc.HasParseError());
+  const auto& spans = doc["resourceSpans"][0]["scopeSpans"][0]["spans"];
+  ASSERT_EQ(2, spans.Size());
+  EXPECT_STREQ("00000000000000010000000000000002", spans[0]["traceId"].GetString());
+  EXPECT_STREQ("0000000000000abc", spans[0]["spanId"].GetString());
+  EXPECT_FALSE(spans[0].HasMember("parentSpanId"));
+  EXPECT_STREQ("100", spans[0]["startTimeUnixNano"].GetString());
+  EXPECT_STREQ("200", spans[0]["endTimeUnixNano"].GetString());
+  EXPECT_STREQ("px.cpu_time_ns", spans[0]["attributes"][0]["key"].GetString());
+  EXPECT_STREQ("50", spans[0]["attributes"][0]["value"]["intValue"].GetString());
+
+  EXPECT_STREQ("0000000000000abc", spans[1]["parentSpanId"].GetString());
+  EXPECT_STREQ("px.agent", spans[1]["attributes"][0]["key"].GetString());
+  EXPECT_STREQ("pem", spans[1]["attributes"][0]["value"]["stringValue"].GetString());
+}
+
+TEST(QueryTraceTest, otlp_file) {
+  auto otlp_file = std::filesystem::temp_directory_path() / "query_trace_test_otlp.json";
+  std::filesystem::remove(otlp_file);
+  QueryTraceStore store(10, otlp_file.string());
+  for (int i = 0; i < 2; ++i) {
+    QueryTrace trace(sole::uuid4(), "pem", &store);
+    trace.StartSpan("execute_plan").End();
+  }
+
+  std::ifstream in(otlp_file);
+  std::string line;
+  int num_lines = 0;
+  while (std::getline(in, line)) {
+    rapidjson::Document doc;
+    doc.Parse(line.c_str());
+    EXPECT_FALSE(doc.HasParseError());
+    ++num_lines;
+  }
+  EXPECT_EQ(2, num_lines);
+  std::filesystem::remove(otlp_file);
+}
+
+}  // namespace trace
+}  // namespace carnot
+}  // namespace px
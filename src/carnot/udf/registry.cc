@@ -157,7 +157,7 @@ std::string Registry::DebugString() const {
 }
 
 StatusOr<UDTFDefinition*> Registry::GetUDTFDefinition(
-    const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
+    std::string_view name, absl::Span<const types::DataType> registry_arg_types) const {
   PL_ASSIGN_OR_RETURN(auto def, GetDefinition(name, registry_arg_types));
   if (def->kind() != UDFDefinitionKind::kUDTF) {
     return error::NotFound("'$0' is not a UDTF", name);
@@ -166,7 +166,7 @@ StatusOr<UDTFDefinition*> Registry::GetUDTFDefinition(
 }
 
 StatusOr<UDADefinition*> Registry::GetUDADefinition(
-    const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
+    std::string_view name, absl::Span<const types::DataType> registry_arg_types) const {
   PL_ASSIGN_OR_RETURN(auto def, GetDefinition(name, registry_arg_types));
   if (def->kind() != UDFDefinitionKind::kUDA) {
     return error::NotFound("'$0' is not a UDA", name);
@@ -175,7 +175,7 @@ StatusOr<UDADefinition*> Registry::GetUDADefinition(
 }
 
 StatusOr<ScalarUDFDefinition*> Registry::GetScalarUDFDefinition(
-    const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
+    std::string_view name, absl::Span<const types::DataType> registry_arg_types) const {
   PL_ASSIGN_OR_RETURN(auto def, GetDefinition(name, registry_arg_types));
   if (def->kind() != UDFDefinitionKind::kScalarUDF) {
     return error::NotFound("'$0' is not a ScalarUDF", name);
@@ -184,13 +184,14 @@ StatusOr<ScalarUDFDefinition*> Registry::GetScalarUDFDefinition(
 }
 
 StatusOr<UDFDefinition*> Registry::GetDefinition(
-    const std::string& name, const std::vector<types::DataType>& registry_arg_types) const {
-  auto key = RegistryKey(name, registry_arg_types);
-  auto it = map_.find(key);
-  if (it == map_.end()) {
+    std::string_view name, absl::Span<const types::DataType> registry_arg_types) const {
+  auto it = definitions_by_key_.find(RegistryKeyRef{name, registry_arg_types});
+  if (it == definitions_by_key_.end()) {
+    auto key = RegistryKey(std::string(name),
+                           {registry_arg_types.begin(), registry_arg_types.end()});
     return error::NotFound("No UDF matching $0 found.", key.DebugString());
   }
-  return it->second.get();
+  return it->second;
 }
 
 }  // namespace udf
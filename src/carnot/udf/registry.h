@@ -21,10 +21,13 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
+#include <absl/types/span.h>
 
 #include "src/carnot/udf/doc.h"
 #include "src/carnot/udf/type_inference.h"
@@ -62,6 +65,8 @@ class RegistryKey {
 
   const std::vector<types::DataType> registry_arg_types() { return registry_arg_types_; }
 
+  RegistryKeyRef ref() const { return {name_, registry_arg_types_}; }
+
   /**
    * LessThan operator overload so we can use this in maps.
    * @param lhs is the other RegistryKey.
@@ -74,6 +79,24 @@ class RegistryKey {
   std::vector<types::DataType> registry_arg_types_;
 };
 
+/**
+ * RegistryKeyRef refers to the name and arg types of a RegistryKey (or of a lookup) without
+ * owning them, so that the registry can be searched without building a key.
+ */
+struct RegistryKeyRef {
+  std::string_view name;
+  absl::Span<const types::DataType> registry_arg_types;
+
+  bool operator==(const RegistryKeyRef& other) const {
+    return name == other.name && registry_arg_types == other.registry_arg_types;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RegistryKeyRef& key) {
+    return H::combine(std::move(h), key.name, key.registry_arg_types);
+  }
+};
+
 template <typename T, typename = void>
 struct RegistryTraits {
   static_assert(sizeof(T) == 0, "Invalid UDF type");
@@ -121,7 +144,7 @@ class Registry {
           "The UDF with name \"$0\" already exists with same exec args \"$1\".", name,
           key.DebugString());
     }
-    map_[key] = std::move(udf_def);
+    AddDefinition(std::move(key), std::move(udf_def));
     RegisterSemanticTypes<T>(name);
 
     if constexpr (has_valid_doc_fn<T>()) {
@@ -192,7 +215,7 @@ class Registry {
           "The UDTF with name \"$0\" already exists with same exec args \"$1\".", name,
           key.DebugString());
     }
-    map_[key] = std::move(udf_def);
+    AddDefinition(std::move(key), std::move(udf_def));
     return Status::OK();
   }
 
@@ -206,13 +229,13 @@ class Registry {
   }
 
   StatusOr<ScalarUDFDefinition*> GetScalarUDFDefinition(
-      const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
+      std::string_view name, absl::Span<const types::DataType> registry_arg_types = {}) const;
 
   StatusOr<UDADefinition*> GetUDADefinition(
-      const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
+      std::string_view name, absl::Span<const types::DataType> registry_arg_types = {}) const;
 
   StatusOr<UDTFDefinition*> GetUDTFDefinition(
-      const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
+      std::string_view name, absl::Span<const types::DataType> registry_arg_types = {}) const;
 
   std::string DebugString() const;
   udfspb::UDFInfo ToProto();
@@ -231,7 +254,14 @@ class Registry {
    * @return
    */
   StatusOr<UDFDefinition*> GetDefinition(
-      const std::string& name, const std::vector<types::DataType>& registry_arg_types = {}) const;
+      std::string_view name, absl::Span<const types::DataType> registry_arg_types = {}) const;
+
+  void AddDefinition(RegistryKey key, std::unique_ptr<UDFDefinition> def) {
+    auto [it, inserted] = map_.emplace(std::move(key), std::move(def));
+    DCHECK(inserted);
+    // The keys of the map don't move, so the index can refer to them.
+    definitions_by_key_[it->first.ref()] = it->second.get();
+  }
 
   void ToProto(const ScalarUDFDefinition& def, udfspb::ScalarUDFSpec* spec);
   void ToProto(const UDADefinition& def, udfspb::UDASpec* spec);
@@ -239,6 +269,8 @@ class Registry {
 
   std::string name_;
   RegistryMap map_;
+  // Indexes the definitions of map_ for lookups, which are made for every function of every plan.
+  absl::flat_hash_map<RegistryKeyRef, UDFDefinition*> definitions_by_key_;
   std::map<std::string, ExplicitRuleSet> semantic_type_rules_;
   udfspb::Docs docs_pb_;
 };
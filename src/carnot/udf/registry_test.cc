@@ -132,6 +132,24 @@ TEST(Registry, no_such_udf) {
   EXPECT_NOT_OK(statusor);
 }
 
+TEST(Registry, lookup_without_owned_key) {
+  auto registry = Registry("test registry");
+  registry.RegisterOrDie<AddUDF<types::Int64Value, types::Int64Value, types::Int64Value>>("add");
+  registry.RegisterOrDie<ScalarUDF1>("scalar1");
+
+  // The registry indexes its own keys, the ones a lookup is made with don't have to outlive it.
+  std::string name = "add";
+  types::DataType arg_types[] = {types::DataType::INT64, types::DataType::INT64};
+  auto statusor = registry.GetScalarUDFDefinition(std::string_view(name), arg_types);
+  ASSERT_OK(statusor);
+  EXPECT_EQ("add", statusor.ConsumeValueOrDie()->name());
+
+  name = "scalar1";
+  auto not_found = registry.GetScalarUDFDefinition(name, arg_types);
+  EXPECT_TRUE(error::IsNotFound(not_found.status()));
+  EXPECT_TRUE(absl::StrContains(not_found.msg(), "scalar1(INT64,INT64)"));
+}
+
 TEST(RegistryDeathTest, double_register) {
   auto registry = Registry("test registry");
   registry.RegisterOrDie<ScalarUDF1>("scalar1");
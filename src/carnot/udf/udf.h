@@ -74,6 +74,13 @@ class AnyUDA : public BaseFunc {
  *      Status Init(FunctionContext *ctx, UDFValue... init_args) {}
  *  This function is called once during initialization of each instance (many instances
  *  may exists in a given query). The arguments are as provided by the query.
+ *
+ * The ScalarUDF can also _optionally_ implement a batch version of Exec:
+ *      Status ExecBatch(FunctionContext *ctx, const ArrowArray&... values,
+ *                       ArrowBuilder* out, size_t count) {}
+ *  where the arrow array and builder types are those of the Exec argument and return types.
+ *  When it exists, it is used instead of Exec when the UDF runs on arrow arrays, which lets
+ *  UDFs work directly on the arrow buffers instead of copying every value in and out.
  */
 class ScalarUDF : public AnyUDF {
  public:
@@ -99,6 +106,10 @@ class ScalarUDF : public AnyUDF {
  *     StringValue Serialize(FunctionContext*) {}
  *     Status DeSerialize(FunctionContext*, const StringValue& data) {}
  *
+ * UDAs that allocate memory outside of the instance (e.g. sketches) should also implement:
+ *     size_t HeapBytes() const {}
+ * which returns the number of bytes allocated, so the memory of a query can be accounted for.
+ *
  * All argument types must me valid UDFValueTypes.
  */
 class UDA : public AnyUDA {
@@ -191,6 +202,30 @@ static constexpr types::DataType ReturnTypeHelper(ReturnType (TUDF::*)(Types...)
 template <typename T, typename = void>
 struct check_init_fn {};
 
+/**
+ * Checks to see if a valid looking ExecBatch function exists.
+ */
+template <typename ReturnType, typename TUDF, typename... Types>
+static constexpr bool IsValidExecBatchFn(ReturnType (TUDF::*)(Types...)) {
+  return false;
+}
+
+template <typename TUDF, typename... Types>
+static constexpr bool IsValidExecBatchFn(Status (TUDF::*)(FunctionContext*, Types...)) {
+  return true;
+}
+
+// SFINAE test for ExecBatch fn.
+template <typename T, typename = void>
+struct has_udf_exec_batch_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_batch_fn<T, std::void_t<decltype(&T::ExecBatch)>> : std::true_type {
+  static_assert(IsValidExecBatchFn(&T::ExecBatch),
+                "If an exec batch function exists, it must have the form: Status "
+                "ExecBatch(FunctionContext*, ...)");
+};
+
 template <typename T>
 struct check_init_fn<T, typename std::enable_if_t<has_udf_init_fn<T>::value>> {
   static_assert(IsValidInitFn(&T::Init),
@@ -228,6 +263,12 @@ class ScalarUDFTraits {
    */
   static constexpr bool HasExecutor() { return has_udf_executor_fn<T>::value; }
 
+  /**
+   * Checks if the UDF has an ExecBatch function that runs on arrow arrays.
+   * @return true if it has an ExecBatch function.
+   */
+  static constexpr bool HasExecBatch() { return has_udf_exec_batch_fn<T>::value; }
+
  private:
   struct check_valid_udf {
     static_assert(std::is_base_of_v<ScalarUDF, T>, "UDF must be derived from ScalarUDF");
@@ -333,6 +374,13 @@ struct has_uda_deserialize_fn<T, std::void_t<decltype(&T::Deserialize)>> : std::
                 "Deserialize(FunctionContext*, const StringValue&)");
 };
 
+// SFINAE test for heap bytes fn.
+template <typename T, typename = void>
+struct has_uda_heap_bytes_fn : std::false_type {};
+
+template <typename T>
+struct has_uda_heap_bytes_fn<T, std::void_t<decltype(&T::HeapBytes)>> : std::true_type {};
+
 /**
  * ScalarUDFTraits allows access to compile time traits of a given UDA.
  * @tparam T A class that derives from UDA.
@@ -358,6 +406,12 @@ class UDATraits {
     return has_uda_serialize_fn<T>() && has_uda_deserialize_fn<T>();
   }
 
+  /**
+   * Checks if the UDA reports the memory it allocates outside of the instance.
+   * @return true if it has a HeapBytes function.
+   */
+  static constexpr bool HasHeapBytes() { return has_uda_heap_bytes_fn<T>::value; }
+
  private:
   /**
    * Static asserts to validate that the UDA is well formed.
@@ -95,6 +95,7 @@ class ScalarUDFDefinition : public UDFDefinition {
     exec_arguments_ = {begin(exec_arguments_array), end(exec_arguments_array)};
     exec_wrapper_fn_ = ScalarUDFWrapper<TUDF>::ExecBatch;
     exec_wrapper_arrow_fn_ = ScalarUDFWrapper<TUDF>::ExecBatchArrow;
+    has_exec_batch_ = ScalarUDFTraits<TUDF>::HasExecBatch();
 
     make_fn_ = ScalarUDFWrapper<TUDF>::Make;
 
@@ -130,6 +131,8 @@ class ScalarUDFDefinition : public UDFDefinition {
   types::DataType exec_return_type() const { return exec_return_type_; }
   const std::vector<types::DataType>& exec_arguments() const { return exec_arguments_; }
   udfspb::UDFSourceExecutor executor() const { return executor_; }
+  // Whether the UDF implements ExecBatch, which ExecBatchArrow runs on the arrow arrays directly.
+  bool has_exec_batch() const { return has_exec_batch_; }
 
   const std::vector<types::DataType>& RegistryArgTypes() override { return exec_arguments_; }
   size_t Arity() const { return exec_arguments_.size(); }
@@ -139,6 +142,7 @@ class ScalarUDFDefinition : public UDFDefinition {
   std::vector<types::DataType> exec_arguments_;
   types::DataType exec_return_type_;
   udfspb::UDFSourceExecutor executor_;
+  bool has_exec_batch_ = false;
   std::function<std::unique_ptr<ScalarUDF>()> make_fn_;
   std::function<Status(ScalarUDF*, FunctionContext* ctx,
                        const std::vector<const types::ColumnWrapper*>& inputs,
@@ -176,12 +180,16 @@ class UDADefinition : public UDFDefinition {
     make_fn_ = UDAWrapper<T>::Make;
     exec_batch_update_fn_ = UDAWrapper<T>::ExecBatchUpdate;
     exec_batch_update_arrow_fn_ = UDAWrapper<T>::ExecBatchUpdateArrow;
+    exec_batch_update_by_group_arrow_fn_ = UDAWrapper<T>::ExecBatchUpdateByGroupArrow;
 
     merge_fn_ = UDAWrapper<T>::Merge;
     finalize_arrow_fn_ = UDAWrapper<T>::FinalizeArrow;
     finalize_value_fn = UDAWrapper<T>::FinalizeValue;
 
     supports_partial_ = UDAWrapper<T>::SupportsPartial;
+    instance_size_ = sizeof(T);
+    has_heap_bytes_ = UDAWrapper<T>::HasHeapBytes;
+    heap_bytes_fn_ = UDAWrapper<T>::HeapBytes;
     return Status::OK();
   }
 
@@ -194,6 +202,12 @@ class UDADefinition : public UDFDefinition {
 
   bool supports_partial() const { return supports_partial_; }
 
+  // The size of an instance of the UDA.
+  size_t instance_size() const { return instance_size_; }
+  // Whether the UDA reports the memory it allocates outside of the instance, see HeapBytes().
+  bool has_heap_bytes() const { return has_heap_bytes_; }
+  size_t HeapBytes(const UDA* uda) const { return heap_bytes_fn_(uda); }
+
   std::unique_ptr<UDA> Make() { return make_fn_(); }
 
   Status ExecBatchUpdate(UDA* uda, FunctionContext* ctx,
@@ -204,6 +218,11 @@ class UDADefinition : public UDFDefinition {
                               const std::vector<const arrow::Array*>& inputs) {
     return exec_batch_update_arrow_fn_(uda, ctx, inputs);
   }
+  // Updates udas[i] with record i of the inputs, for aggregates that keep a UDA per group.
+  Status ExecBatchUpdateByGroupArrow(const std::vector<UDA*>& udas, FunctionContext* ctx,
+                                     const std::vector<const arrow::Array*>& inputs) {
+    return exec_batch_update_by_group_arrow_fn_(udas, ctx, inputs);
+  }
 
   Status Merge(UDA* uda1, UDA* uda2, FunctionContext* ctx) { return merge_fn_(uda1, uda2, ctx); }
   Status FinalizeValue(UDA* uda, FunctionContext* ctx, types::BaseValueType* output) {
@@ -217,6 +236,8 @@ class UDADefinition : public UDFDefinition {
   std::vector<types::DataType> update_arguments_;
   types::DataType finalize_return_type_;
   bool supports_partial_;
+  size_t instance_size_;
+  bool has_heap_bytes_;
 
   std::function<std::unique_ptr<UDA>()> make_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx,
@@ -227,11 +248,16 @@ class UDADefinition : public UDFDefinition {
                        const std::vector<const arrow::Array*>& inputs)>
       exec_batch_update_arrow_fn_;
 
+  std::function<Status(const std::vector<UDA*>& udas, FunctionContext* ctx,
+                       const std::vector<const arrow::Array*>& inputs)>
+      exec_batch_update_by_group_arrow_fn_;
+
   std::function<Status(UDA* uda, FunctionContext* ctx, arrow::ArrayBuilder* output)>
       finalize_arrow_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx, types::BaseValueType* output)>
       finalize_value_fn;
   std::function<Status(UDA* uda1, UDA* uda2, FunctionContext* ctx)> merge_fn_;
+  std::function<size_t(const UDA* uda)> heap_bytes_fn_;
 };
 
 class UDTFDefinition : public UDFDefinition {
@@ -186,6 +186,29 @@ TEST(UDADefinition, arrow_output) {
   EXPECT_EQ(5, casted->Value(0));
 }
 
+TEST(UDADefinition, update_by_group) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  UDADefinition def("minsum");
+  EXPECT_OK(def.Init<MinSumUDA>());
+
+  std::vector<types::Int64Value> v1 = {1, 2, 3, 4};
+  std::vector<types::Int64Value> v2 = {5, 1, 3, 2};
+  auto v1a = ToArrow(v1, arrow::default_memory_pool());
+  auto v2a = ToArrow(v2, arrow::default_memory_pool());
+
+  // Rows 0 and 2 go to the first UDA, rows 1 and 3 to the second.
+  auto u1 = def.Make();
+  auto u2 = def.Make();
+  EXPECT_OK(def.ExecBatchUpdateByGroupArrow({u1.get(), u2.get(), u1.get(), u2.get()}, &ctx,
+                                            {v1a.get(), v2a.get()}));
+
+  types::Int64Value out;
+  EXPECT_OK(def.FinalizeValue(u1.get(), &ctx, &out));
+  EXPECT_EQ(4, out.val);
+  EXPECT_OK(def.FinalizeValue(u2.get(), &ctx, &out));
+  EXPECT_EQ(3, out.val);
+}
+
 }  // namespace udf
 }  // namespace carnot
 }  // namespace px
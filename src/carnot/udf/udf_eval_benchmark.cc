@@ -18,9 +18,13 @@
 
 #include <benchmark/benchmark.h>
 
+#include <absl/strings/match.h>
+#include <algorithm>
+#include <memory>
 #include <random>
 #include <vector>
 
+#include "src/carnot/funcs/builtins/string_ops.h"
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf_wrapper.h"
 #include "src/common/base/base.h"
@@ -36,6 +40,7 @@ using px::carnot::udf::ScalarUDF;
 using px::carnot::udf::ScalarUDFDefinition;
 using px::carnot::udf::ScalarUDFWrapper;
 using px::types::BaseValueType;
+using px::types::BoolValue;
 using px::types::Int64Value;
 using px::types::Int64ValueColumnWrapper;
 using px::types::StringValue;
@@ -62,6 +67,22 @@ class SubStrUDF : public ScalarUDF {
   StringValue Exec(FunctionContext*, StringValue v1) { return v1.substr(1, 2); }
 };
 
+// The builtin string UDFs without their ExecBatch, which run once per row.
+class RowContainsUDF : public ScalarUDF {
+ public:
+  BoolValue Exec(FunctionContext*, StringValue b1, StringValue b2) {
+    return absl::StrContains(b1, b2);
+  }
+};
+
+class RowToLowerUDF : public ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue b1) {
+    std::transform(b1.begin(), b1.end(), b1.begin(), ::tolower);
+    return b1;
+  }
+};
+
 // This benchmark add two columns using Int64ValueVectors.
 // NOLINTNEXTLINE : runtime/references.
 static void BM_AddInt64Values(benchmark::State& state) {
@@ -244,6 +265,56 @@ static void BM_SubStrArrow(benchmark::State& state) {
   state.SetBytesProcessed(int64_t(state.iterations()) * width * data.size());
 }
 
+// Benchmark a string UDF on arrow arrays. Runs the ExecBatch of the UDF if it has one.
+template <typename TUDF, typename TOutputBuilder>
+void BenchmarkStringUDFArrow(benchmark::State& state,  // NOLINT : runtime/references.
+                             const std::vector<std::shared_ptr<arrow::Array>>& inputs,
+                             size_t data_bytes) {
+  size_t size = inputs[0]->length();
+  std::vector<arrow::Array*> raw_inputs;
+  for (const auto& input : inputs) {
+    raw_inputs.push_back(input.get());
+  }
+  auto u = std::make_shared<TUDF>();
+  std::shared_ptr<arrow::Array> out;
+  // NOLINTNEXTLINE : clang-analyzer-deadcode.DeadStores.
+  for (auto _ : state) {
+    if (out) {
+      out.reset();
+    }
+    auto output_builder = std::make_shared<TOutputBuilder>();
+    auto res = ScalarUDFWrapper<TUDF>::ExecBatchArrow(u.get(), nullptr, raw_inputs,
+                                                      output_builder.get(), size);
+    CHECK(res.ok());
+    CHECK(output_builder->Finish(&out).ok());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * data_bytes);
+}
+
+// Benchmark contains on 64 char wide strings, looking for a 4 char substring in every row.
+template <typename TUDF>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ContainsArrow(benchmark::State& state) {
+  int width = 64;
+  auto data = GenerateStringValueVector(state.range(0), width);
+  std::vector<StringValue> substrs(data.size(), "abcd");
+  auto in_arr = ToArrow(data, arrow::default_memory_pool());
+  auto substr_arr = ToArrow(substrs, arrow::default_memory_pool());
+  BenchmarkStringUDFArrow<TUDF, arrow::BooleanBuilder>(state, {in_arr, substr_arr},
+                                                       width * data.size());
+}
+
+// Benchmark tolower on 64 char wide strings.
+template <typename TUDF>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ToLowerArrow(benchmark::State& state) {
+  int width = 64;
+  auto data = GenerateStringValueVector(state.range(0), width);
+  auto in_arr = ToArrow(data, arrow::default_memory_pool());
+  BenchmarkStringUDFArrow<TUDF, arrow::StringBuilder>(state, {in_arr}, width * data.size());
+}
+
 BENCHMARK(BM_AddInt64ValueToArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_AddTwoInt64sArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_AddInt64Values)->RangeMultiplier(2)->Range(1, 1 << 16);
@@ -253,3 +324,12 @@ BENCHMARK(BM_ConvertToArrowInt64)->RangeMultiplier(2)->Range(1, 1 << 16);
 
 BENCHMARK(BM_SubStrArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_SubStr)->RangeMultiplier(2)->Range(1, 1 << 16);
+
+BENCHMARK_TEMPLATE(BM_ContainsArrow, RowContainsUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ContainsArrow, px::carnot::builtins::ContainsUDF)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ToLowerArrow, RowToLowerUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ToLowerArrow, px::carnot::builtins::ToLowerUDF)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
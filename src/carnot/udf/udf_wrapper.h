@@ -48,6 +48,12 @@ constexpr auto CastToUDFValueType(const types::BaseValueType* arg) {
   // return static_cast<types::Int64Value*>(arg);
   return static_cast<const typename types::DataTypeTraits<TExecArgType>::value_type*>(arg);
 }
+
+// Same as CastToUDFValueType, but for arrow arrays of the given type.
+template <types::DataType TExecArgType>
+constexpr auto CastToArrowArrayType(const arrow::Array* arg) {
+  return static_cast<const typename types::DataTypeTraits<TExecArgType>::arrow_array_type*>(arg);
+}
 /**
  * This is the inner wrapper which expands the arguments an performs type casts
  * based on the type and arity of the input arguments.
@@ -88,6 +94,11 @@ Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput*
                         const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
   [[maybe_unused]] static constexpr auto exec_argument_types =
       ScalarUDFTraits<TUDF>::ExecArguments();
+  if constexpr (ScalarUDFTraits<TUDF>::HasExecBatch()) {
+    // The UDF handles the whole batch (and the reservation of the output) itself.
+    return udf->ExecBatch(ctx, *CastToArrowArrayType<exec_argument_types[I]>(args[I])..., out,
+                          count);
+  }
   CHECK(out->Reserve(count).ok());
   size_t reserved = count * kStringAssumedSizeHeuristic;
   size_t total_size = 0;
@@ -260,6 +271,22 @@ Status UpdateWrapperArrow(TUDA* uda, FunctionContext* ctx, size_t count,
   return Status::OK();
 }
 
+/**
+ * Performs an update of a batch of records (arrow), where every record updates its own UDA.
+ * This lets grouped aggregates update the state of each group straight from the input arrays.
+ */
+template <typename TUDA, std::size_t... I>
+Status UpdateByGroupWrapperArrow(const std::vector<UDA*>& udas, FunctionContext* ctx,
+                                 const std::vector<const arrow::Array*>& args,
+                                 std::index_sequence<I...>) {
+  constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+  for (size_t idx = 0; idx < udas.size(); ++idx) {
+    static_cast<TUDA*>(udas[idx])
+        ->Update(ctx, types::GetValueFromArrowArray<update_argument_types[I]>(args[I], idx)...);
+  }
+  return Status::OK();
+}
+
 /**
  * Provides a set of static methods that wrap UDAs and allow vectorized execution (for update).
  * @tparam TUDA The UDA class.
@@ -268,6 +295,7 @@ template <typename TUDA>
 struct UDAWrapper {
   static constexpr types::DataType return_type = UDATraits<TUDA>::FinalizeReturnType();
   static constexpr bool SupportsPartial = UDATraits<TUDA>::SupportsPartial();
+  static constexpr bool HasHeapBytes = UDATraits<TUDA>::HasHeapBytes();
 
   /**
    * Create a new UDA.
@@ -275,6 +303,19 @@ struct UDAWrapper {
    */
   static std::unique_ptr<UDA> Make() { return std::make_unique<TUDA>(); }
 
+  /**
+   * The number of bytes the UDA allocated outside of the instance, 0 if it doesn't report them.
+   * @param uda The UDA instance.
+   * @return The number of bytes.
+   */
+  static size_t HeapBytes(const UDA* uda) {
+    if constexpr (HasHeapBytes) {
+      return static_cast<const TUDA*>(uda)->HeapBytes();
+    } else {
+      return 0;
+    }
+  }
+
   /**
    * Perform a batch update of the passed in UDA based in the inputs.
    * @param uda The UDA instances.
@@ -312,6 +353,25 @@ struct UDAWrapper {
                                     std::make_index_sequence<update_argument_types.size()>{});
   }
 
+  /**
+   * Perform an update of a batch of records, where record i updates udas[i].
+   * @param udas The UDA instance to update for every record. All have to be of type TUDA.
+   * @param ctx The function context.
+   * @param inputs A vector of pointers to arrow arrays with udas.size() records each.
+   * @return Status of update.
+   */
+  static Status ExecBatchUpdateByGroupArrow(const std::vector<UDA*>& udas, FunctionContext* ctx,
+                                            const std::vector<const arrow::Array*>& inputs) {
+    constexpr auto update_argument_types = UDATraits<TUDA>::UpdateArgumentTypes();
+    DCHECK(inputs.size() == update_argument_types.size());
+    for (const auto* input : inputs) {
+      DCHECK_GE(static_cast<size_t>(input->length()), udas.size());
+      PL_UNUSED(input);
+    }
+    return UpdateByGroupWrapperArrow<TUDA>(
+        udas, ctx, inputs, std::make_index_sequence<update_argument_types.size()>{});
+  }
+
   /**
    * Merges uda2 into uda1 based on the UDA merge function.
    * Both UDAs must be the same time, undefined behavior (or crash) if they are different types
@@ -397,14 +457,18 @@ struct UDTFWrapper {
     }
 
     auto* u = static_cast<TUDTF*>(udtf);
-    int count = 0;
-    bool more = true;
     RecordWriterProxy<TUDTF> rw(outputs);
-    while (count < max_gen_records && more) {
-      more = u->NextRecord(ctx, &rw);
-      ++count;
+    if constexpr (UDTFTraits<TUDTF>::HasNextBatchFn()) {
+      return u->NextBatch(ctx, max_gen_records, &rw);
+    } else {
+      int count = 0;
+      bool more = true;
+      while (count < max_gen_records && more) {
+        more = u->NextRecord(ctx, &rw);
+        ++count;
+      }
+      return more;
     }
-    return more;
   }
 
  private:
@@ -254,6 +254,12 @@ class UDTFTraits {
    */
   static constexpr bool HasNextRecordFn() { return NextRecordFnHelper<TUDTF>::value; }
 
+  /**
+   * Checks to see if NextBatch() exists, which makes the UDTF a streaming UDTF.
+   * @return
+   */
+  static constexpr bool HasNextBatchFn() { return NextBatchFnHelper<TUDTF>::value; }
+
   template <typename Q = TUDTF, std::enable_if_t<UDTFTraits<Q>::HasInitArgsFn(), void>* = nullptr>
   static constexpr auto InitArguments() {
     return Q::InitArgs();
@@ -373,6 +379,14 @@ class UDTFTraits {
   struct NextRecordFnHelper<
       T, std::void_t<decltype (&T::NextRecord)(FunctionContext*, typename T::RecordWriter*)>>
       : std::true_type {};
+
+  template <typename T, typename = void>
+  struct NextBatchFnHelper : std::false_type {};
+
+  template <typename T>
+  struct NextBatchFnHelper<
+      T, std::void_t<decltype (&T::NextBatch)(FunctionContext*, int, typename T::RecordWriter*)>>
+      : std::true_type {};
 };
 
 /**
@@ -483,10 +497,11 @@ struct UDTFChecker {
   // Check that Executor exists and returns the executor type.
   static_assert(TR::HasExecutorFn(), "UDTF must have an Executor() func");
   static_assert(TR::HasCorrectExectorFnReturnType(), "Executor() must return UDTFSourceExecutor");
-  // Check that NextRecord exists and is well formed.
-  static_assert(
-      TR::HasNextRecordFn(),
-      "UDTF must have NextRecord func of form NextRecord(FunctionContext, RecordWriterProxy*)");
+  // Check that NextRecord (or NextBatch for streaming UDTFs) exists and is well formed.
+  static_assert(TR::HasNextRecordFn() || TR::HasNextBatchFn(),
+                "UDTF must have NextRecord func of form NextRecord(FunctionContext, "
+                "RecordWriterProxy*) or NextBatch func of form NextBatch(FunctionContext, int, "
+                "RecordWriterProxy*)");
 };
 
 /**
@@ -531,6 +546,20 @@ struct UDTFChecker {
  *     int64_t count_ = 0;
  *   }
  *
+ * Streaming UDTFs define NextBatch instead of NextRecord. They keep a cursor into their source
+ * (eg. an iterator over a cached metadata response) instead of materializing the full result in
+ * Init, and the source node pulls one bounded batch at a time:
+ *
+ *     bool NextBatch(FunctionContext *, int max_records, RecordWriter *rw) {
+ *       for (int i = 0; i < max_records && count_ < max_count_; ++i, ++count_) {
+ *         rw->Append<IndexOf("out")>(outstr_);
+ *       }
+ *       return count_ < max_count_; // more records
+ *     }
+ *
+ * NextBatch must write at most max_records records, and is only called again once the previous
+ * batch was consumed.
+ *
  * @tparam Derived The name of the derived class.
  */
 template <typename Derived>
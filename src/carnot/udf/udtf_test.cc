@@ -261,6 +261,55 @@ TEST(ValidOneColUDTFEmptyInit, empty_init_is_valid) {
   EXPECT_EQ(init_args.size(), 0);
 }
 
+class StreamingUDTF : public UDTF<StreamingUDTF> {
+ public:
+  static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("out_int", types::DataType::INT64, types::PatternType::GENERAL, "int result"));
+  }
+
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    for (int i = 0; i < max_records && idx_ < kNumRecords; ++i, ++idx_) {
+      rw->Append<IndexOf("out_int")>(idx_);
+    }
+    return idx_ < kNumRecords;
+  }
+
+ private:
+  static constexpr int64_t kNumRecords = 5;
+  int64_t idx_ = 0;
+};
+
+TEST(StreamingUDTF, generates_bounded_batches) {
+  using TR = UDTFTraits<StreamingUDTF>;
+  constexpr StreamingUDTF::Checker check;
+  PL_UNUSED(check);
+
+  EXPECT_FALSE(TR::HasNextRecordFn());
+  EXPECT_TRUE(TR::HasNextBatchFn());
+
+  UDTFWrapper<StreamingUDTF> wrapper;
+  auto u = wrapper.Make();
+  ASSERT_NE(u, nullptr);
+  EXPECT_OK(wrapper.Init(u.get(), nullptr, {}));
+
+  std::vector<std::vector<int64_t>> batches;
+  bool more = true;
+  while (more) {
+    arrow::Int64Builder int_builder;
+    std::vector<arrow::ArrayBuilder*> outs{&int_builder};
+    more = wrapper.ExecBatchUpdate(u.get(), nullptr, 2, &outs);
+
+    std::shared_ptr<arrow::Int64Array> out;
+    ASSERT_TRUE(int_builder.Finish(&out).ok());
+    batches.emplace_back(out->raw_values(), out->raw_values() + out->length());
+  }
+
+  EXPECT_THAT(batches, ElementsAre(ElementsAre(0, 1), ElementsAre(2, 3), ElementsAre(4)));
+}
+
 }  // namespace udf
 }  // namespace carnot
 }  // namespace px
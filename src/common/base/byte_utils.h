@@ -18,8 +18,11 @@
 
 #pragma once
 
+#include <endian.h>
+
 #include <cstring>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "src/common/base/logging.h"
@@ -53,6 +56,23 @@ T ReverseBytes(const T* x) {
   return y;
 }
 
+namespace internal {
+
+// Whether the N bytes of an integer of type T can be converted with a single load and byte swap.
+template <typename T, size_t N>
+constexpr bool kIsFullWidthInt = std::is_integral_v<T> && N == sizeof(T) &&
+                                 (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// Loads an integer of type T from an unaligned buffer, in the byte order of the host.
+template <typename T>
+T LoadUnaligned(const char* buf) {
+  std::make_unsigned_t<T> x;
+  std::memcpy(&x, buf, sizeof(T));
+  return static_cast<T>(x);
+}
+
+}  // namespace internal
+
 /**
  * Convert a little-endian string of bytes to an integer.
  *
@@ -71,11 +91,23 @@ T LEndianBytesToInt(std::string_view buf) {
   // Source buffer must have enough bytes.
   DCHECK_GE(buf.size(), N);
 
-  T result = 0;
-  for (size_t i = 0; i < N; i++) {
-    result = static_cast<uint8_t>(buf[N - 1 - i]) | (result << 8);
+  if constexpr (internal::kIsFullWidthInt<T, N>) {
+    using U = std::make_unsigned_t<T>;
+    const U x = internal::LoadUnaligned<U>(buf.data());
+    if constexpr (sizeof(T) == 8) {
+      return static_cast<T>(le64toh(x));
+    } else if constexpr (sizeof(T) == 4) {
+      return static_cast<T>(le32toh(x));
+    } else {
+      return static_cast<T>(le16toh(x));
+    }
+  } else {
+    T result = 0;
+    for (size_t i = 0; i < N; i++) {
+      result = static_cast<uint8_t>(buf[N - 1 - i]) | (result << 8);
+    }
+    return result;
   }
-  return result;
 }
 
 /**
@@ -128,11 +160,23 @@ T BEndianBytesToInt(std::string_view buf) {
   // Source buffer must have enough bytes.
   DCHECK_GE(buf.size(), N);
 
-  T result = 0;
-  for (size_t i = 0; i < N; i++) {
-    result = static_cast<uint8_t>(buf[i]) | (result << 8);
+  if constexpr (internal::kIsFullWidthInt<T, N>) {
+    using U = std::make_unsigned_t<T>;
+    const U x = internal::LoadUnaligned<U>(buf.data());
+    if constexpr (sizeof(T) == 8) {
+      return static_cast<T>(be64toh(x));
+    } else if constexpr (sizeof(T) == 4) {
+      return static_cast<T>(be32toh(x));
+    } else {
+      return static_cast<T>(be16toh(x));
+    }
+  } else {
+    T result = 0;
+    for (size_t i = 0; i < N; i++) {
+      result = static_cast<uint8_t>(buf[i]) | (result << 8);
+    }
+    return result;
   }
-  return result;
 }
 
 /**
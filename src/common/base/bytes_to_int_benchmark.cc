@@ -125,6 +125,63 @@ T ByteLoopN(std::string_view buf) {
   return result;
 }
 
+// BEByteLoopN is the big-endian counterpart of ByteLoopN, and the reference for the
+// BEndianBytesToInt() of byte_utils.h.
+template <typename T, int N = sizeof(T)>
+T BEByteLoopN(std::string_view buf) {
+  static_assert(N <= sizeof(T));
+  DCHECK_GE(buf.size(), N);
+
+  T result = 0;
+  for (size_t i = 0; i < N; i++) {
+    result = static_cast<uint8_t>(buf[i]) | (result << 8);
+  }
+  return result;
+}
+
+// A 12-byte header of big-endian fields, like the headers of Kafka and DNS messages.
+struct Header {
+  int16_t a;
+  int16_t b;
+  int32_t c;
+  int32_t d;
+};
+constexpr size_t kHeaderSize = 12;
+
+// DecodeHeaderCheckEachField checks the size of the buffer before each field, as the
+// StatusOr-returning functions of BinaryDecoder do.
+bool DecodeHeaderCheckEachField(std::string_view buf, Header* header) {
+  auto extract = [&buf](auto* field) {
+    using T = std::remove_pointer_t<decltype(field)>;
+    if (buf.size() < sizeof(T)) {
+      return false;
+    }
+    *field = px::utils::BEndianBytesToInt<T>(buf);
+    buf.remove_prefix(sizeof(T));
+    return true;
+  };
+  return extract(&header->a) && extract(&header->b) && extract(&header->c) &&
+         extract(&header->d);
+}
+
+// DecodeHeaderCheckOnce checks the size of the whole header once, as with BinaryDecoder's
+// HasBytes() and the Unchecked functions.
+bool DecodeHeaderCheckOnce(std::string_view buf, Header* header) {
+  if (buf.size() < kHeaderSize) {
+    return false;
+  }
+  auto extract = [&buf](auto* field) {
+    using T = std::remove_pointer_t<decltype(field)>;
+    *field = px::utils::BEndianBytesToInt<T>(buf);
+    buf.remove_prefix(sizeof(T));
+  };
+  extract(&header->a);
+  extract(&header->b);
+  extract(&header->c);
+  extract(&header->d);
+  return true;
+}
+
 std::string InitBytes(int size) {
   std::string buf;
   buf.resize(size);
@@ -184,6 +241,51 @@ static void BM_ByteLoopN(benchmark::State& state) {
   }
 }
 
+template <typename T, int N = sizeof(T)>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_BEByteLoopN(benchmark::State& state) {
+  for (auto _ : state) {
+    auto result = BEByteLoopN<T, N>(kBuf);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+template <typename T, int N = sizeof(T)>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_BEndianBytesToInt(benchmark::State& state) {
+  for (auto _ : state) {
+    auto result = px::utils::BEndianBytesToInt<T, N>(kBuf);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+template <typename T, int N = sizeof(T)>
+// NOLINTNEXTLINE : runtime/references.
+static void BM_LEndianBytesToInt(benchmark::State& state) {
+  for (auto _ : state) {
+    auto result = px::utils::LEndianBytesToInt<T, N>(kBuf);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_DecodeHeaderCheckEachField(benchmark::State& state) {
+  Header header;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(DecodeHeaderCheckEachField(kBuf, &header));
+    benchmark::DoNotOptimize(header);
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_DecodeHeaderCheckOnce(benchmark::State& state) {
+  Header header;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(DecodeHeaderCheckOnce(kBuf, &header));
+    benchmark::DoNotOptimize(header);
+  }
+}
+
 // BM_MemCopy is provided as a reference as an upper bound.
 // It is not functionally correct on big-endian machines.
 BENCHMARK_TEMPLATE(BM_MemCopy, uint64_t);
@@ -220,3 +322,24 @@ BENCHMARK_TEMPLATE(BM_ByteLoop, uint32_t);
 BENCHMARK_TEMPLATE(BM_ByteLoop, uint32_t, 3);
 BENCHMARK_TEMPLATE(BM_ByteLoop, uint16_t);
 BENCHMARK_TEMPLATE(BM_ByteLoop, uint8_t);
+
+BENCHMARK_TEMPLATE(BM_BEByteLoopN, uint64_t);
+BENCHMARK_TEMPLATE(BM_BEByteLoopN, uint64_t, 6);
+BENCHMARK_TEMPLATE(BM_BEByteLoopN, uint32_t);
+BENCHMARK_TEMPLATE(BM_BEByteLoopN, uint32_t, 3);
+BENCHMARK_TEMPLATE(BM_BEByteLoopN, uint16_t);
+
+BENCHMARK_TEMPLATE(BM_BEndianBytesToInt, uint64_t);
+BENCHMARK_TEMPLATE(BM_BEndianBytesToInt, uint64_t, 6);
+BENCHMARK_TEMPLATE(BM_BEndianBytesToInt, uint32_t);
+BENCHMARK_TEMPLATE(BM_BEndianBytesToInt, uint32_t, 3);
+BENCHMARK_TEMPLATE(BM_BEndianBytesToInt, uint16_t);
+
+BENCHMARK_TEMPLATE(BM_LEndianBytesToInt, uint64_t);
+BENCHMARK_TEMPLATE(BM_LEndianBytesToInt, uint64_t, 6);
+BENCHMARK_TEMPLATE(BM_LEndianBytesToInt, uint32_t);
+BENCHMARK_TEMPLATE(BM_LEndianBytesToInt, uint32_t, 3);
+BENCHMARK_TEMPLATE(BM_LEndianBytesToInt, uint16_t);
+
+BENCHMARK(BM_DecodeHeaderCheckEachField);
+BENCHMARK(BM_DecodeHeaderCheckOnce);
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+#include <utility>
+
+#include "src/common/base/error.h"
+
+namespace px {
+
+StatusOr<std::vector<int>> ParseCPUList(std::string_view cpu_list) {
+  std::vector<int> cpus;
+  for (std::string_view range : absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    range = absl::StripAsciiWhitespace(range);
+    std::pair<std::string_view, std::string_view> bounds = absl::StrSplit(range, '-');
+    int first;
+    if (!absl::SimpleAtoi(bounds.first, &first)) {
+      return error::InvalidArgument("Invalid CPU list '$0'.", cpu_list);
+    }
+    int last = first;
+    if (!bounds.second.empty() && !absl::SimpleAtoi(bounds.second, &last)) {
+      return error::InvalidArgument("Invalid CPU list '$0'.", cpu_list);
+    }
+    if (first < 0 || last < first || last >= CPU_SETSIZE) {
+      return error::InvalidArgument("Invalid CPU range '$0' in CPU list '$1'.", range, cpu_list);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+Status SetCurrentThreadCPUs(std::string_view cpu_list) {
+  PL_ASSIGN_OR_RETURN(std::vector<int> cpus, ParseCPUList(cpu_list));
+  if (cpus.empty()) {
+    return Status::OK();
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (err != 0) {
+    return error::Internal("Failed to set the CPU affinity to '$0', errno=$1", cpu_list, err);
+  }
+  return Status::OK();
+}
+
+}  // namespace px
@@ -18,8 +18,14 @@
 
 #pragma once
 
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
+
+#include "src/common/base/status.h"
+#include "src/common/base/statusor.h"
 
 namespace px {
 
@@ -29,4 +35,16 @@ inline std::string CurrentThreadIDAsString() {
   return ss.str();
 }
 
+/**
+ * Parses a list of CPUs in the kernel's cpulist format, ie. "0-3,8,10-11", as found in
+ * /sys/devices/system/node/node<N>/cpulist.
+ */
+StatusOr<std::vector<int>> ParseCPUList(std::string_view cpu_list);
+
+/**
+ * Restricts the calling thread to the CPUs in cpu_list (see ParseCPUList()). Threads that it
+ * starts afterwards inherit the restriction. Does nothing if cpu_list is empty.
+ */
+Status SetCurrentThreadCPUs(std::string_view cpu_list);
+
 }  // namespace px
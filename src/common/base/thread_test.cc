@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/thread.h"
+
+#include <sched.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/base/test_utils.h"
+
+namespace px {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(ParseCPUListTest, Basic) {
+  ASSERT_OK_AND_THAT(ParseCPUList("0-3,8,10-11"), ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  ASSERT_OK_AND_THAT(ParseCPUList(" 5 "), ElementsAre(5));
+  ASSERT_OK_AND_THAT(ParseCPUList(""), IsEmpty());
+}
+
+TEST(ParseCPUListTest, Invalid) {
+  EXPECT_NOT_OK(ParseCPUList("a-b"));
+  EXPECT_NOT_OK(ParseCPUList("3-1"));
+  EXPECT_NOT_OK(ParseCPUList("-1"));
+  EXPECT_NOT_OK(ParseCPUList("1,,x"));
+}
+
+TEST(SetCurrentThreadCPUsTest, PinsThread) {
+  std::thread thread([]() {
+    ASSERT_OK(SetCurrentThreadCPUs("0"));
+    EXPECT_EQ(sched_getcpu(), 0);
+  });
+  thread.join();
+}
+
+}  // namespace px
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/worker_pool.h"
+
+#include <algorithm>
+
+namespace px {
+
+WorkerPool::WorkerPool(size_t num_threads) {
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkerPool::RunWorker, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    absl::MutexLock lock(&lock_);
+    stop_ = true;
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+WorkerPool* WorkerPool::Default() {
+  static WorkerPool* pool =
+      new WorkerPool(std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, 8));
+  return pool;
+}
+
+void WorkerPool::RunIterations(Job* job) {
+  for (size_t i = job->next++; i < job->n; i = job->next++) {
+    (*job->fn)(i);
+  }
+}
+
+void WorkerPool::RemoveJob(Job* job) {
+  auto it = std::find(jobs_.begin(), jobs_.end(), job);
+  if (it != jobs_.end()) {
+    jobs_.erase(it);
+  }
+}
+
+void WorkerPool::ParallelFor(size_t n, const std::function<void(size_t)>& fn) {
+  if (n <= 1 || threads_.empty()) {
+    for (size_t i = 0; i < n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  Job job;
+  job.n = n;
+  job.fn = &fn;
+  {
+    absl::MutexLock lock(&lock_);
+    jobs_.push_back(&job);
+  }
+  RunIterations(&job);
+
+  // All of the iterations have been handed out, so no new worker may pick the job up. Wait for
+  // the workers that are still running iterations of it.
+  absl::MutexLock lock(&lock_);
+  RemoveJob(&job);
+  lock_.Await(absl::Condition(+[](Job* job) { return job->active == 0; }, &job));
+}
+
+void WorkerPool::RunWorker() {
+  absl::MutexLock lock(&lock_);
+  while (true) {
+    lock_.Await(absl::Condition(this, &WorkerPool::HasJobOrStopped));
+    if (jobs_.empty()) {
+      // Stopped, and nothing left to help with.
+      return;
+    }
+    Job* job = jobs_.front();
+    ++job->active;
+
+    lock_.Unlock();
+    RunIterations(job);
+    lock_.Lock();
+
+    RemoveJob(job);
+    --job->active;
+  }
+}
+
+}  // namespace px
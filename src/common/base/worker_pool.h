@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/mixins.h"
+
+namespace px {
+
+/**
+ * A fixed set of threads that run the iterations of ParallelFor() calls. The threads are started
+ * once, so unlike starting threads per call, spreading a few short tasks over them is cheap.
+ *
+ * ParallelFor() can be called from any number of threads at once, including from the worker
+ * threads themselves. The calling thread always takes part, so a call makes progress even when
+ * all of the workers are busy.
+ */
+class WorkerPool : public NotCopyable {
+ public:
+  explicit WorkerPool(size_t num_threads);
+  ~WorkerPool();
+
+  /**
+   * The pool shared by the callers that don't need one of their own. It has one thread per two
+   * cores, between 1 and 8, and is never destroyed.
+   */
+  static WorkerPool* Default();
+
+  /**
+   * Calls fn(i) for every i in [0, n), on the calling thread and the worker threads, and returns
+   * once all of the calls are done. The order of the calls is unspecified.
+   */
+  void ParallelFor(size_t n, const std::function<void(size_t)>& fn);
+
+  size_t num_threads() const { return threads_.size(); }
+
+ private:
+  struct Job {
+    size_t n;
+    const std::function<void(size_t)>* fn;
+    // The next iteration to run.
+    std::atomic<size_t> next = 0;
+    // The number of worker threads that are running iterations of the job.
+    int active = 0;
+  };
+
+  static void RunIterations(Job* job);
+  void RemoveJob(Job* job) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void RunWorker();
+  bool HasJobOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return stop_ || !jobs_.empty();
+  }
+
+  absl::Mutex lock_;
+  // The jobs that still have iterations to hand out, oldest first. The jobs live on the stack of
+  // their ParallelFor() call, which waits until no worker uses them anymore.
+  std::deque<Job*> jobs_ ABSL_GUARDED_BY(lock_);
+  bool stop_ ABSL_GUARDED_BY(lock_) = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace px
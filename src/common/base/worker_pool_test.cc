@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+namespace px {
+
+TEST(WorkerPoolTest, runs_every_iteration_once) {
+  WorkerPool pool(4);
+  std::vector<std::atomic<int>> counts(1000);
+  pool.ParallelFor(counts.size(), [&counts](size_t i) { ++counts[i]; });
+  for (const auto& count : counts) {
+    EXPECT_EQ(1, count);
+  }
+}
+
+TEST(WorkerPoolTest, no_threads) {
+  WorkerPool pool(0);
+  std::vector<int> out(10);
+  pool.ParallelFor(out.size(), [&out](size_t i) { out[i] = i; });
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_EQ(i, static_cast<size_t>(out[i]));
+  }
+}
+
+TEST(WorkerPoolTest, concurrent_and_nested_calls) {
+  WorkerPool pool(2);
+  std::atomic<int> total = 0;
+  std::vector<std::thread> callers;
+  for (int c = 0; c < 4; ++c) {
+    callers.emplace_back([&pool, &total]() {
+      for (int round = 0; round < 50; ++round) {
+        pool.ParallelFor(8, [&pool, &total](size_t) {
+          pool.ParallelFor(4, [&total](size_t) { ++total; });
+        });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(4 * 50 * 8 * 4, total);
+}
+
+}  // namespace px
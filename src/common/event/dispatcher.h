@@ -24,6 +24,7 @@
 
 #include "src/common/event/deferred_delete.h"
 #include "src/common/event/task.h"
+#include "src/common/event/thread_pool.h"
 #include "src/common/event/time_system.h"
 #include "src/common/event/timer.h"
 
@@ -104,6 +105,11 @@ class Dispatcher {
    */
   virtual RunnableAsyncTaskUPtr CreateAsyncTask(std::unique_ptr<AsyncTask> task) = 0;
 
+  /**
+   * Returns how long the async tasks of the priority class waited for a thread.
+   */
+  virtual TaskQueueTimeStats GetTaskQueueTimeStats(TaskPriority priority) const = 0;
+
   /**
    * Returns a recently cached MonotonicTime value. Updates on every iteration of the event loop.
    */
@@ -27,41 +27,34 @@
 #include "src/common/base/base.h"
 #include "src/common/event/api.h"
 
+DEFINE_int32(dispatcher_thread_pool_size,
+             gflags::Int32FromEnv("PL_DISPATCHER_THREAD_POOL_SIZE", 4),
+             "The number of threads that run the async tasks (eg. queries) of a dispatcher");
+
 namespace px {
 namespace event {
 
 namespace {
 /**
- * LibuvRunnableAsyncTask is a wrapper that contains Libuv specific run loop.
+ * LibuvRunnableAsyncTask is a wrapper that runs the task on the scheduler's thread pool.
  */
 class LibuvRunnableAsyncTask : public RunnableAsyncTask {
  public:
-  LibuvRunnableAsyncTask(uv_loop_t* loop, std::unique_ptr<AsyncTask> task)
-      : RunnableAsyncTask(std::move(task)), loop_(loop) {
-    work_.data = this;
-  }
+  LibuvRunnableAsyncTask(LibuvScheduler* scheduler, std::unique_ptr<AsyncTask> task)
+      : RunnableAsyncTask(std::move(task)), scheduler_(scheduler) {}
 
   virtual ~LibuvRunnableAsyncTask() = default;
 
   /**
-   * Run queues work on the event queue to run on the threadpool.
+   * Run queues work to run on the threadpool, with the priority of the task.
    */
-  void Run() override { ECHECK(uv_queue_work(loop_, &work_, WorkCB, AfterWorkCB) == 0); }
-
- private:
-  static void inline WorkCB(uv_work_t* req) {
-    auto self = static_cast<LibuvRunnableAsyncTask*>(req->data);
-    self->task_->Work();
-  }
-
-  static void inline AfterWorkCB(uv_work_t* req, int status) {
-    PL_UNUSED(status);
-    auto self = static_cast<LibuvRunnableAsyncTask*>(req->data);
-    self->task_->Done();
+  void Run() override {
+    scheduler_->ScheduleWork(
+        task_->priority(), [this] { task_->Work(); }, [this] { task_->Done(); });
   }
 
-  uv_loop_t* loop_;
-  uv_work_t work_;
+ private:
+  LibuvScheduler* scheduler_;
 };
 
 void OnUVWalkClose(uv_handle_t* handle, void* /*arg*/) { uv_close(handle, nullptr); }
@@ -127,7 +120,8 @@ void LibuvScheduler::Run(Dispatcher::RunType type) {
   uv_run(&uv_loop_, mode);
 }
 
-LibuvScheduler::LibuvScheduler(std::string_view name) : name_(std::string(name)) {
+LibuvScheduler::LibuvScheduler(std::string_view name)
+    : name_(std::string(name)), thread_pool_(FLAGS_dispatcher_thread_pool_size) {
   int rc = uv_loop_init(&uv_loop_);
   CHECK(rc == 0) << "Failed to init Libuv loop";
   stop_handler_.data = this;
@@ -139,6 +133,13 @@ LibuvScheduler::LibuvScheduler(std::string_view name) : name_(std::string(name))
       LOG(INFO) << s->LogEntry("Stop finished");
     });
   });
+
+  done_handler_.data = this;
+  uv_async_init(&uv_loop_, &done_handler_, [](uv_async_t* h) {
+    reinterpret_cast<LibuvScheduler*>(h->data)->RunDoneCallbacks();
+  });
+  // Only keep the loop alive while tasks are running on the thread pool.
+  uv_unref(reinterpret_cast<uv_handle_t*>(&done_handler_));
 }
 
 void LibuvScheduler::LoopExit() {
@@ -165,7 +166,37 @@ void LibuvScheduler::Stop() {
 }
 
 RunnableAsyncTaskUPtr LibuvScheduler::CreateAsyncTask(std::unique_ptr<AsyncTask> task) {
-  return std::make_unique<LibuvRunnableAsyncTask>(&uv_loop_, std::move(task));
+  return std::make_unique<LibuvRunnableAsyncTask>(this, std::move(task));
+}
+
+void LibuvScheduler::ScheduleWork(TaskPriority priority, std::function<void()> work,
+                                  std::function<void()> done) {
+  if (num_pending_tasks_++ == 0) {
+    uv_ref(reinterpret_cast<uv_handle_t*>(&done_handler_));
+  }
+  thread_pool_.Schedule(priority, [this, work = std::move(work), done = std::move(done)]() {
+    work();
+    {
+      absl::MutexLock lock(&done_lock_);
+      done_callbacks_.push_back(std::move(done));
+    }
+    int rc = uv_async_send(&done_handler_);
+    CHECK(rc == 0) << "Failed to schedule done callback";
+  });
+}
+
+void LibuvScheduler::RunDoneCallbacks() {
+  std::vector<std::function<void()>> done_callbacks;
+  {
+    absl::MutexLock lock(&done_lock_);
+    done_callbacks.swap(done_callbacks_);
+  }
+  for (auto& done : done_callbacks) {
+    done();
+    if (--num_pending_tasks_ == 0) {
+      uv_unref(reinterpret_cast<uv_handle_t*>(&done_handler_));
+    }
+  }
 }
 
 std::string LibuvScheduler::LogEntry(std::string_view entry) {
@@ -265,6 +296,10 @@ RunnableAsyncTaskUPtr LibuvDispatcher::CreateAsyncTask(std::unique_ptr<AsyncTask
   return base_scheduler_.CreateAsyncTask(std::move(task));
 }
 
+TaskQueueTimeStats LibuvDispatcher::GetTaskQueueTimeStats(TaskPriority priority) const {
+  return base_scheduler_.GetTaskQueueTimeStats(priority);
+}
+
 std::string LibuvDispatcher::LogEntry(std::string_view entry) {
   return base_scheduler_.LogEntry(entry);
 }
@@ -34,6 +34,7 @@
 #include <absl/synchronization/mutex.h>
 #include "src/common/event/dispatcher.h"
 #include "src/common/event/event.h"
+#include "src/common/event/thread_pool.h"
 
 namespace px {
 namespace event {
@@ -67,6 +68,15 @@ class LibuvScheduler : public Scheduler {
   RunnableAsyncTaskUPtr CreateAsyncTask(std::unique_ptr<AsyncTask> task);
   uv_loop_t* uv_loop() { return &uv_loop_; }
 
+  /**
+   * Runs work on the thread pool and then done on the event thread, like uv_queue_work. Must be
+   * called on the event thread.
+   */
+  void ScheduleWork(TaskPriority priority, std::function<void()> work, std::function<void()> done);
+  TaskQueueTimeStats GetTaskQueueTimeStats(TaskPriority priority) const {
+    return thread_pool_.GetQueueTimeStats(priority);
+  }
+
   /**
    * Exits the libuv loop.
    */
@@ -74,9 +84,21 @@ class LibuvScheduler : public Scheduler {
   std::string LogEntry(std::string_view entry);
 
  private:
+  void RunDoneCallbacks();
+
   const std::string name_;
   uv_loop_t uv_loop_;
   uv_async_t stop_handler_;
+
+  // Wakes up the event thread to run the done callbacks of the tasks that finished their work.
+  uv_async_t done_handler_;
+  absl::Mutex done_lock_;
+  std::vector<std::function<void()>> done_callbacks_ ABSL_GUARDED_BY(done_lock_);
+  // The tasks whose done callback didn't run yet, only accessed on the event thread.
+  int64_t num_pending_tasks_ = 0;
+
+  // Declared last, so that the threads are joined before the rest of the scheduler is destroyed.
+  WorkStealingThreadPool thread_pool_;
 };
 
 class LibuvDispatcher : public Dispatcher {
@@ -90,6 +112,7 @@ class LibuvDispatcher : public Dispatcher {
   void DeferredDelete(DeferredDeletableUPtr&& to_delete) override;
   void Run(RunType type) override;
   RunnableAsyncTaskUPtr CreateAsyncTask(std::unique_ptr<AsyncTask> task) override;
+  TaskQueueTimeStats GetTaskQueueTimeStats(TaskPriority priority) const override;
   MonotonicTimePoint ApproximateMonotonicTime() const override;
   void UpdateMonotonicTime() override;
   std::string LogEntry(std::string_view entry);
@@ -87,7 +87,8 @@ class NATSConnector : public NATSConnectorBase {
   /**
    * Handle incoming message from NATS. This function is used by the C callback function. It can
    * also be used by Fakes/tests to inject new messages.
-   * @param msg The natsMessage.
+   * @param msg The natsMessage. Ownership is taken: the message is parsed straight out of the NATS
+   * buffer, which is destroyed once parsing is done.
    */
   void NATSMessageHandler(natsConnection* /*nc*/, natsSubscription* /*sub*/, natsMsg* msg) {
     int len = natsMsg_GetDataLength(msg);
@@ -95,6 +96,7 @@ class NATSConnector : public NATSConnectorBase {
     auto parsed_msg = std::make_unique<TMsg>();
 
     bool ok = parsed_msg->ParseFromArray(data, len);
+    natsMsg_Destroy(msg);
     if (!ok) {
       LOG(ERROR) << "Failed to parse message";
       return;
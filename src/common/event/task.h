@@ -29,12 +29,30 @@
 namespace px {
 namespace event {
 
+/**
+ * TaskPriority is the class of an AsyncTask. The threadpool runs queued tasks of a higher class
+ * (lower value) before any task of a lower class.
+ */
+enum class TaskPriority : int {
+  // Tasks that a user is waiting on, eg. a one-off query.
+  kInteractive = 0,
+  // Long running tasks, eg. streaming queries.
+  kBackground = 1,
+  // Maintenance work that can wait until the pool is idle.
+  kHousekeeping = 2,
+};
+constexpr int kNumTaskPriorities = 3;
+
 /**
  * AsyncTask is an interface for tasks that we can run on the threadpool.
  */
 class AsyncTask {
  public:
   virtual ~AsyncTask() = default;
+  /**
+   * The priority class that the task is queued with.
+   */
+  virtual TaskPriority priority() const { return TaskPriority::kBackground; }
   /**
    * Work is run on a threadpool.
    */
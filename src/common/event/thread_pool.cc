@@ -0,0 +1,170 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/event/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace px {
+namespace event {
+
+namespace {
+// The pool and worker index of the current thread, so that tasks scheduled from a task stay on
+// the thread's own deque.
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local int current_worker_idx = -1;
+}  // namespace
+
+void WorkStealingThreadPool::QueueTimeHistogram::Record(std::chrono::microseconds wait) {
+  int64_t wait_us = std::max<int64_t>(wait.count(), 0);
+  int bucket = 0;
+  while (bucket < kNumBuckets - 1 && (int64_t{1} << bucket) <= wait_us) {
+    ++bucket;
+  }
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  num_tasks.fetch_add(1, std::memory_order_relaxed);
+  total_us.fetch_add(wait_us, std::memory_order_relaxed);
+  int64_t prev_max = max_us.load(std::memory_order_relaxed);
+  while (prev_max < wait_us && !max_us.compare_exchange_weak(prev_max, wait_us)) {
+  }
+}
+
+std::chrono::microseconds WorkStealingThreadPool::QueueTimeHistogram::Percentile(
+    double percentile, int64_t num_tasks) const {
+  // The index of the task at the percentile, in the order of their queue times.
+  int64_t rank = std::max<int64_t>(static_cast<int64_t>(std::ceil(percentile * num_tasks)) - 1, 0);
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < kNumBuckets; ++bucket) {
+    seen += buckets[bucket].load(std::memory_order_relaxed);
+    if (seen > rank) {
+      return std::chrono::microseconds(int64_t{1} << bucket);
+    }
+  }
+  return std::chrono::microseconds(max_us.load(std::memory_order_relaxed));
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(int num_threads) {
+  CHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Only start the threads once all workers exist, since they steal from each other.
+  for (int i = 0; i < num_threads; ++i) {
+    workers_[i]->thread = std::thread([this, i] { WorkerLoop(i); });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    absl::MutexLock lock(&idle_lock_);
+    stopping_ = true;
+  }
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void WorkStealingThreadPool::Schedule(TaskPriority priority, Task task) {
+  int worker_idx = current_pool == this
+                       ? current_worker_idx
+                       : static_cast<int>(next_worker_++ % workers_.size());
+  Worker* worker = workers_[worker_idx].get();
+  {
+    absl::MutexLock lock(&worker->lock);
+    worker->queues[static_cast<int>(priority)].push_back(
+        {std::move(task), static_cast<int>(priority), std::chrono::steady_clock::now()});
+  }
+  absl::MutexLock lock(&idle_lock_);
+  ++num_queued_;
+}
+
+bool WorkStealingThreadPool::TryPop(int worker_idx, QueuedTask* task) {
+  for (int priority = 0; priority < kNumTaskPriorities; ++priority) {
+    // The owner takes the oldest task from the front, thieves take the newest from the back so
+    // that they rarely contend with the owner.
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      Worker* worker = workers_[(worker_idx + i) % workers_.size()].get();
+      absl::MutexLock lock(&worker->lock);
+      auto& queue = worker->queues[priority];
+      if (queue.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        *task = std::move(queue.front());
+        queue.pop_front();
+      } else {
+        *task = std::move(queue.back());
+        queue.pop_back();
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::WorkerLoop(int worker_idx) {
+  current_pool = this;
+  current_worker_idx = worker_idx;
+
+  auto has_work_or_stopping = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(idle_lock_) {
+    return stopping_ || num_queued_ > 0;
+  };
+
+  while (true) {
+    {
+      absl::MutexLock lock(&idle_lock_);
+      idle_lock_.Await(absl::Condition(&has_work_or_stopping));
+      if (stopping_) {
+        return;
+      }
+    }
+
+    QueuedTask task;
+    // Another thread may have taken the task that woke us up.
+    if (!TryPop(worker_idx, &task)) {
+      std::this_thread::yield();
+      continue;
+    }
+    {
+      absl::MutexLock lock(&idle_lock_);
+      --num_queued_;
+    }
+
+    queue_times_[task.priority].Record(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - task.enqueue_time));
+    task.fn();
+  }
+}
+
+TaskQueueTimeStats WorkStealingThreadPool::GetQueueTimeStats(TaskPriority priority) const {
+  const QueueTimeHistogram& histogram = queue_times_[static_cast<int>(priority)];
+  TaskQueueTimeStats stats;
+  stats.num_tasks = histogram.num_tasks.load(std::memory_order_relaxed);
+  stats.total = std::chrono::microseconds(histogram.total_us.load(std::memory_order_relaxed));
+  stats.max = std::chrono::microseconds(histogram.max_us.load(std::memory_order_relaxed));
+  if (stats.num_tasks > 0) {
+    stats.p50 = histogram.Percentile(0.5, stats.num_tasks);
+    stats.p99 = histogram.Percentile(0.99, stats.num_tasks);
+  }
+  return stats;
+}
+
+}  // namespace event
+}  // namespace px
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <absl/base/thread_annotations.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+#include "src/common/event/task.h"
+
+namespace px {
+namespace event {
+
+/**
+ * TaskQueueTimeStats summarizes how long the tasks of a priority class waited in the queue before
+ * a thread picked them up. Percentiles are the upper bounds of power of two buckets.
+ */
+struct TaskQueueTimeStats {
+  int64_t num_tasks = 0;
+  std::chrono::microseconds total{0};
+  std::chrono::microseconds max{0};
+  std::chrono::microseconds p50{0};
+  std::chrono::microseconds p99{0};
+};
+
+/**
+ * WorkStealingThreadPool runs tasks on a fixed set of threads. Every thread has its own deque per
+ * priority class, and threads that run out of work steal from the others, so one long running
+ * task only holds up the tasks queued behind it until another thread is free.
+ *
+ * Threads always pick the highest priority task they can find, first from their own deques and
+ * then from the others, so interactive tasks don't wait behind queued background work.
+ */
+class WorkStealingThreadPool : public NotCopyable {
+ public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingThreadPool(int num_threads);
+  /**
+   * Waits for the running tasks to finish. Tasks that are still queued are dropped.
+   */
+  ~WorkStealingThreadPool();
+
+  /**
+   * Queues a task. Tasks scheduled from one of the pool's threads go to that thread's deque,
+   * others are spread over the threads round robin.
+   */
+  void Schedule(TaskPriority priority, Task task);
+
+  TaskQueueTimeStats GetQueueTimeStats(TaskPriority priority) const;
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  struct QueuedTask {
+    Task fn;
+    int priority = 0;
+    std::chrono::steady_clock::time_point enqueue_time;
+  };
+
+  struct Worker {
+    absl::Mutex lock;
+    std::array<std::deque<QueuedTask>, kNumTaskPriorities> queues ABSL_GUARDED_BY(lock);
+    std::thread thread;
+  };
+
+  // Histogram of the queue times of a priority class, bucket i counts waits below 2^i us.
+  struct QueueTimeHistogram {
+    static constexpr int kNumBuckets = 40;
+    std::array<std::atomic<int64_t>, kNumBuckets> buckets{};
+    std::atomic<int64_t> num_tasks = 0;
+    std::atomic<int64_t> total_us = 0;
+    std::atomic<int64_t> max_us = 0;
+
+    void Record(std::chrono::microseconds wait);
+    std::chrono::microseconds Percentile(double percentile, int64_t num_tasks) const;
+  };
+
+  void WorkerLoop(int worker_idx);
+  // Pops the highest priority task, from the worker's own deques first and then from the others.
+  bool TryPop(int worker_idx, QueuedTask* task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::array<QueueTimeHistogram, kNumTaskPriorities> queue_times_;
+  std::atomic<uint64_t> next_worker_ = 0;
+
+  // Idle threads sleep until a task is queued.
+  absl::Mutex idle_lock_;
+  int64_t num_queued_ ABSL_GUARDED_BY(idle_lock_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(idle_lock_) = false;
+};
+
+}  // namespace event
+}  // namespace px
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/event/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include <absl/synchronization/notification.h>
+
+namespace px {
+namespace event {
+
+TEST(WorkStealingThreadPoolTest, runs_all_tasks) {
+  std::atomic<int> num_run = 0;
+  {
+    WorkStealingThreadPool pool(4);
+    absl::Notification done;
+    constexpr int kNumTasks = 1000;
+    for (int i = 0; i < kNumTasks; ++i) {
+      pool.Schedule(TaskPriority::kInteractive, [&] {
+        if (++num_run == kNumTasks) {
+          done.Notify();
+        }
+      });
+    }
+    done.WaitForNotification();
+    EXPECT_EQ(kNumTasks, pool.GetQueueTimeStats(TaskPriority::kInteractive).num_tasks);
+    EXPECT_EQ(0, pool.GetQueueTimeStats(TaskPriority::kBackground).num_tasks);
+  }
+  EXPECT_EQ(1000, num_run);
+}
+
+TEST(WorkStealingThreadPoolTest, idle_threads_steal_from_busy_ones) {
+  WorkStealingThreadPool pool(2);
+  absl::Notification release;
+  absl::Notification stolen;
+  // Both tasks are queued on the first thread, which is blocked by the first one.
+  pool.Schedule(TaskPriority::kBackground, [&] {
+    pool.Schedule(TaskPriority::kInteractive, [&] { stolen.Notify(); });
+    release.WaitForNotification();
+  });
+  stolen.WaitForNotification();
+  release.Notify();
+}
+
+TEST(WorkStealingThreadPoolTest, runs_higher_priority_first) {
+  WorkStealingThreadPool pool(1);
+  absl::Notification release;
+  absl::Notification done;
+  std::vector<TaskPriority> order;
+
+  // Block the only thread so that the other tasks are all queued.
+  pool.Schedule(TaskPriority::kInteractive, [&] { release.WaitForNotification(); });
+  pool.Schedule(TaskPriority::kHousekeeping, [&] {
+    order.push_back(TaskPriority::kHousekeeping);
+    done.Notify();
+  });
+  pool.Schedule(TaskPriority::kBackground, [&] { order.push_back(TaskPriority::kBackground); });
+  pool.Schedule(TaskPriority::kInteractive, [&] { order.push_back(TaskPriority::kInteractive); });
+  release.Notify();
+  done.WaitForNotification();
+
+  EXPECT_EQ(order, (std::vector<TaskPriority>{TaskPriority::kInteractive,
+                                               TaskPriority::kBackground,
+                                               TaskPriority::kHousekeeping}));
+  auto stats = pool.GetQueueTimeStats(TaskPriority::kHousekeeping);
+  EXPECT_EQ(1, stats.num_tasks);
+  EXPECT_LE(stats.p50, stats.p99);
+  EXPECT_LE(stats.max, stats.p99);
+}
+
+}  // namespace event
+}  // namespace px
@@ -16,22 +16,20 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
+#include "src/common/grpcutils/pb_text.h"
 
-#include <utility>
+#include <algorithm>
 
 #include <google/protobuf/empty.pb.h>
 #include <google/protobuf/text_format.h>
 
 #include "src/common/base/base.h"
-#include "src/stirling/utils/binary_decoder.h"
+#include "src/common/base/byte_utils.h"
 
 namespace px {
-namespace stirling {
 namespace grpc {
 
 using ::google::protobuf::Empty;
-using ::google::protobuf::Message;
 using ::google::protobuf::TextFormat;
 
 namespace {
@@ -65,22 +63,24 @@ Status GRPCPBWireToText(std::string_view message, std::string* text,
         "E.g.: calling unimplemented method");
   }
 
-  BinaryDecoder decoder(message);
-
   TextFormat::Printer pb_printer;
   pb_printer.SetTruncateStringFieldLongerThan(str_truncation_len.value_or(0));
 
   Status status;
 
-  while (!decoder.eof()) {
-    PL_ASSIGN_OR_RETURN(uint8_t compressed_flag, decoder.ExtractInt<uint8_t>());
+  while (!message.empty()) {
+    if (message.size() < kGRPCMessageHeaderSizeInBytes) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    const uint8_t compressed_flag = message[0];
     if (compressed_flag == 1) {
       return error::Unimplemented("Compressed data is not implemented");
     }
-    PL_ASSIGN_OR_RETURN(uint32_t len, decoder.ExtractInt<uint32_t>());
+    const auto len = utils::BEndianBytesToInt<uint32_t>(message.substr(1));
+    message.remove_prefix(kGRPCMessageHeaderSizeInBytes);
     // Only extract remaining data if the data is truncated.
-    PL_ASSIGN_OR_RETURN(std::string_view data, decoder.ExtractString<char>(std::min(
-                                                   static_cast<size_t>(len), decoder.BufSize())));
+    std::string_view data = message.substr(0, std::min<size_t>(len, message.size()));
+    message.remove_prefix(data.size());
 
     std::string pb_str;
     // Include the most recent status.
@@ -105,5 +105,4 @@ std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len)
 }
 
 }  // namespace grpc
-}  // namespace stirling
 }  // namespace px
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace px {
+namespace grpc {
+
+constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
+
+/**
+ * Converts a gRPC payload, i.e. one or more length-prefixed serialized protobuf messages, into
+ * text format protobuf. The message types are unknown, so fields are printed by their numbers.
+ *
+ * @param str The raw payload as a string.
+ * @param str_truncation_len The string length of any string/bytes fields beyond which truncation
+ *        applies, if specified.
+ * @return The text format of the messages, or a placeholder if nothing could be parsed.
+ */
+std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len = std::nullopt);
+
+}  // namespace grpc
+}  // namespace px
@@ -149,14 +149,9 @@ class JSONObjectBuilder {
   }
 
   // Writes a key and array value pair.
-  void WriteKV(std::string_view key, VectorView<std::string> value) {
-    DCHECK(!object_ended_);
-    writer_.String(key.data(), key.size());
-    writer_.StartArray();
-    for (auto v : value) {
-      writer_.String(v.data(), v.size());
-    }
-    writer_.EndArray();
+  void WriteKV(std::string_view key, VectorView<std::string> value) { WriteArrayKV(key, value); }
+  void WriteKV(std::string_view key, VectorView<std::string_view> value) {
+    WriteArrayKV(key, value);
   }
 
   // Writes all values that are assigned to the keys sequentially.
@@ -167,6 +162,28 @@ class JSONObjectBuilder {
   // Returns: "foo": [{"a":"1","b":"2"}, {"a":"3","b":"4"}]
   void WriteRepeatedKVs(std::string_view key, const std::vector<std::string_view>& keys,
                         VectorView<std::string> values) {
+    WriteRepeatedKVsImpl(key, keys, values);
+  }
+  void WriteRepeatedKVs(std::string_view key, const std::vector<std::string_view>& keys,
+                        VectorView<std::string_view> values) {
+    WriteRepeatedKVsImpl(key, keys, values);
+  }
+
+ private:
+  template <typename TStringType>
+  void WriteArrayKV(std::string_view key, VectorView<TStringType> value) {
+    DCHECK(!object_ended_);
+    writer_.String(key.data(), key.size());
+    writer_.StartArray();
+    for (const auto& v : value) {
+      writer_.String(v.data(), v.size());
+    }
+    writer_.EndArray();
+  }
+
+  template <typename TStringType>
+  void WriteRepeatedKVsImpl(std::string_view key, const std::vector<std::string_view>& keys,
+                            VectorView<TStringType> values) {
     DCHECK(!object_ended_);
     DCHECK_EQ(values.size() % keys.size(), 0);
 
@@ -180,7 +197,6 @@ class JSONObjectBuilder {
     writer_.EndArray();
   }
 
- private:
   bool object_ended_;
   rapidjson::StringBuffer buffer_;
   rapidjson::Writer<rapidjson::StringBuffer> writer_;
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+
+/**
+ * Arena allocates objects from large blocks and destroys all of them at once when it is cleared
+ * or destroyed. Objects can't be freed individually, so the arena is meant for graphs of objects
+ * that share a lifetime. Not thread-safe.
+ */
+class Arena final : public px::NotCopyable {
+ public:
+  static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize) : block_size_(block_size) {}
+  ~Arena() { Clear(); }
+
+  /**
+   * Constructs an object in the arena. The arena runs its destructor when it is cleared.
+   */
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    T* obj = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors_.push_back(Destructor{obj, [](void* o) { static_cast<T*>(o)->~T(); }});
+    }
+    return obj;
+  }
+
+  /**
+   * Allocates uninitialized memory that stays valid until the arena is cleared.
+   */
+  void* Allocate(size_t size, size_t alignment) {
+    DCHECK_LE(alignment, alignof(std::max_align_t));
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(ptr_) % alignment) % alignment;
+    if (ptr_ == nullptr || padding + size > remaining_) {
+      // Large allocations get a block of their own, so they don't waste the current block.
+      if (size > block_size_ / 4) {
+        return AddBlock(size);
+      }
+      ptr_ = AddBlock(block_size_);
+      remaining_ = block_size_;
+      padding = 0;
+    }
+    void* mem = ptr_ + padding;
+    ptr_ += padding + size;
+    remaining_ -= padding + size;
+    return mem;
+  }
+
+  /**
+   * Destroys all of the objects in the arena, in the reverse order of their construction, and
+   * frees its memory.
+   */
+  void Clear() {
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+      it->destroy_fn(it->obj);
+    }
+    destructors_.clear();
+    blocks_.clear();
+    ptr_ = nullptr;
+    remaining_ = 0;
+    bytes_allocated_ = 0;
+  }
+
+  /**
+   * The number of bytes of the blocks that the arena holds.
+   */
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+ private:
+  char* AddBlock(size_t size) {
+    blocks_.emplace_back(new char[size]);
+    bytes_allocated_ += size;
+    return blocks_.back().get();
+  }
+
+  using DestroyFn = void (*)(void*);
+  struct Destructor {
+    void* obj;
+    DestroyFn destroy_fn;
+  };
+
+  const size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  // The unused part of the current block.
+  char* ptr_ = nullptr;
+  size_t remaining_ = 0;
+  size_t bytes_allocated_ = 0;
+  std::vector<Destructor> destructors_;
+};
+
+}  // namespace px
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/memory/arena.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace px {
+
+class DestroyCounter {
+ public:
+  explicit DestroyCounter(int* destroy_count) : destroy_count_(destroy_count) {}
+  ~DestroyCounter() { (*destroy_count_)++; }
+
+ private:
+  int* destroy_count_;
+};
+
+TEST(ArenaTest, destroys_objects_on_destruction) {
+  int count = 0;
+  {
+    Arena arena;
+    arena.New<DestroyCounter>(&count);
+    arena.New<DestroyCounter>(&count);
+    EXPECT_EQ(0, count);
+  }
+  EXPECT_EQ(2, count);
+}
+
+TEST(ArenaTest, clear) {
+  int count = 0;
+  Arena arena;
+  arena.New<DestroyCounter>(&count);
+  EXPECT_GT(arena.bytes_allocated(), 0U);
+  arena.Clear();
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(0U, arena.bytes_allocated());
+
+  auto str = arena.New<std::string>("reused after clear");
+  EXPECT_EQ("reused after clear", *str);
+}
+
+TEST(ArenaTest, allocations_are_aligned) {
+  Arena arena(/*block_size*/ 64);
+  arena.New<char>('a');
+  auto val = arena.New<int64_t>(1);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(val) % alignof(int64_t));
+  arena.New<char>('b');
+  auto dbl = arena.New<double>(2.0);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(dbl) % alignof(double));
+  EXPECT_EQ(1, *val);
+  EXPECT_EQ(2.0, *dbl);
+}
+
+TEST(ArenaTest, large_allocations_get_their_own_block) {
+  Arena arena(/*block_size*/ 64);
+  arena.New<char>('a');
+  EXPECT_EQ(64U, arena.bytes_allocated());
+  arena.Allocate(100, 1);
+  EXPECT_EQ(164U, arena.bytes_allocated());
+  // The rest of the first block is still used for small allocations.
+  arena.New<char>('b');
+  EXPECT_EQ(164U, arena.bytes_allocated());
+}
+
+}  // namespace px
@@ -22,4 +22,6 @@
  * importing them everywhere.
  */
 
-#include "src/common/memory/object_pool.h"  // IWYU pragma: export
+#include "src/common/memory/arena.h"              // IWYU pragma: export
+#include "src/common/memory/object_pool.h"        // IWYU pragma: export
+#include "src/common/memory/typed_object_pool.h"  // IWYU pragma: export
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "src/common/memory/memory.h"
+
+namespace px {
+
+// Stands in for the row tuples of the exec nodes: small, with a heap allocated member.
+struct BenchObject {
+  explicit BenchObject(int64_t v) : values(4, v) {}
+  std::vector<int64_t> values;
+};
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ObjectPoolAdd(benchmark::State& state) {
+  for (auto _ : state) {
+    ObjectPool pool;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(pool.Add(new BenchObject(i)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TypedObjectPoolNew(benchmark::State& state) {
+  for (auto _ : state) {
+    TypedObjectPool<BenchObject> pool;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(pool.New(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ArenaNew(benchmark::State& state) {
+  for (auto _ : state) {
+    Arena arena;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      benchmark::DoNotOptimize(arena.New<BenchObject>(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ObjectPoolAdd)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_TypedObjectPoolNew)->RangeMultiplier(8)->Range(8, 1 << 15);
+BENCHMARK(BM_ArenaNew)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+}  // namespace px
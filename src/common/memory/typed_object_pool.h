@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+
+/**
+ * A pool of objects of a single type, allocated in slabs and destroyed together.
+ *
+ * Unlike ObjectPool, the objects are constructed in place in the slabs, so that creating one is a
+ * bump of the slab size instead of a heap allocation plus a vector push. The pool is not
+ * synchronized: it is meant for state owned by a single thread, e.g. the groups of an exec node.
+ */
+template <typename T>
+class TypedObjectPool final : public px::NotCopyable {
+ public:
+  static constexpr size_t kFirstSlabSize = 64;
+  static constexpr size_t kMaxSlabSize = 4096;
+
+  TypedObjectPool() = default;
+  ~TypedObjectPool() { Clear(); }
+
+  /**
+   * Constructs an object in the pool. The object stays valid until the pool is cleared.
+   */
+  template <typename... Args>
+  T* New(Args&&... args) {
+    if (slabs_.empty() || slabs_.back().size == slabs_.back().capacity) {
+      AddSlab();
+    }
+    Slab& slab = slabs_.back();
+    T* obj = new (&slab.storage[slab.size]) T(std::forward<Args>(args)...);
+    ++slab.size;
+    ++size_;
+    return obj;
+  }
+
+  /**
+   * Destroys all of the objects, in the reverse order of their construction, and frees the slabs.
+   */
+  void Clear() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (auto slab = slabs_.rbegin(); slab != slabs_.rend(); ++slab) {
+        for (size_t i = slab->size; i > 0; --i) {
+          std::launder(reinterpret_cast<T*>(&slab->storage[i - 1]))->~T();
+        }
+      }
+    }
+    slabs_.clear();
+    size_ = 0;
+  }
+
+  /**
+   * The number of objects in the pool.
+   */
+  size_t size() const { return size_; }
+
+ private:
+  using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+  struct Slab {
+    std::unique_ptr<Storage[]> storage;
+    size_t size;
+    size_t capacity;
+  };
+
+  void AddSlab() {
+    // Slabs grow geometrically, so small pools stay small and large ones need few slabs.
+    size_t capacity =
+        slabs_.empty() ? kFirstSlabSize : std::min(2 * slabs_.back().capacity, kMaxSlabSize);
+    slabs_.push_back(Slab{std::make_unique<Storage[]>(capacity), 0, capacity});
+  }
+
+  std::vector<Slab> slabs_;
+  size_t size_ = 0;
+};
+
+}  // namespace px
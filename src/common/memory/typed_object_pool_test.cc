@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/memory/typed_object_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace px {
+
+class CountedObject {
+ public:
+  CountedObject(std::vector<int>* destroyed, int id) : destroyed_(destroyed), id_(id) {}
+  ~CountedObject() { destroyed_->push_back(id_); }
+
+  int id() const { return id_; }
+
+ private:
+  std::vector<int>* destroyed_;
+  int id_;
+};
+
+TEST(TypedObjectPoolTest, destroy) {
+  std::vector<int> destroyed;
+  {
+    TypedObjectPool<CountedObject> pool;
+    pool.New(&destroyed, 0);
+    pool.New(&destroyed, 1);
+    EXPECT_EQ(2U, pool.size());
+    EXPECT_TRUE(destroyed.empty());
+  }
+  EXPECT_EQ(std::vector<int>({1, 0}), destroyed);
+}
+
+TEST(TypedObjectPoolTest, clear_across_slabs) {
+  constexpr int kNumObjects = 3 * TypedObjectPool<CountedObject>::kFirstSlabSize + 1;
+  std::vector<int> destroyed;
+  TypedObjectPool<CountedObject> pool;
+  std::vector<CountedObject*> objs;
+  for (int i = 0; i < kNumObjects; ++i) {
+    objs.push_back(pool.New(&destroyed, i));
+  }
+  // Later slabs don't move the objects of the earlier ones.
+  for (int i = 0; i < kNumObjects; ++i) {
+    EXPECT_EQ(i, objs[i]->id());
+  }
+
+  pool.Clear();
+  EXPECT_EQ(0U, pool.size());
+  ASSERT_EQ(kNumObjects, static_cast<int>(destroyed.size()));
+  for (int i = 0; i < kNumObjects; ++i) {
+    EXPECT_EQ(kNumObjects - 1 - i, destroyed[i]);
+  }
+
+  // The pool can be reused after a clear.
+  destroyed.clear();
+  pool.New(&destroyed, 7);
+  pool.Clear();
+  EXPECT_EQ(std::vector<int>({7}), destroyed);
+}
+
+TEST(TypedObjectPoolTest, alignment) {
+  struct alignas(32) Aligned {
+    char c;
+  };
+  TypedObjectPool<Aligned> pool;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(pool.New()) % 32);
+  }
+}
+
+}  // namespace px
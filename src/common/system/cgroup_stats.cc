@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/cgroup_stats.h"
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+namespace px {
+namespace system {
+
+namespace {
+
+constexpr int64_t kNanosPerMicro = 1000;
+
+// Parses the "<key> <value>" lines of a flat keyed file, such as cpu.stat and memory.stat.
+// Only the keys in fields are parsed, each into the field paired with it.
+Status ParseFlatKeyedFile(std::string_view contents,
+                          std::initializer_list<std::pair<std::string_view, int64_t*>> fields) {
+  bool ok = true;
+  for (std::string_view line : absl::StrSplit(contents, '\n', absl::SkipEmpty())) {
+    std::pair<std::string_view, std::string_view> kv = absl::StrSplit(line, ' ');
+    for (const auto& [key, field] : fields) {
+      if (kv.first == key) {
+        ok &= absl::SimpleAtoi(kv.second, field);
+        break;
+      }
+    }
+  }
+  if (!ok) {
+    return error::Internal("Failed to parse cgroup stat file. ATOI failed.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status ParseCGroupCPUStat(std::string_view contents, CGroupStats* out) {
+  PL_RETURN_IF_ERROR(ParseFlatKeyedFile(contents, {{"user_usec", &out->utime_ns},
+                                                   {"system_usec", &out->ktime_ns}}));
+  out->utime_ns *= kNanosPerMicro;
+  out->ktime_ns *= kNanosPerMicro;
+  return Status::OK();
+}
+
+Status ParseCGroupMemoryStat(std::string_view contents, CGroupStats* out) {
+  return ParseFlatKeyedFile(contents, {{"anon", &out->anon_bytes},
+                                       {"file", &out->file_bytes},
+                                       {"pgfault", &out->minor_faults},
+                                       {"pgmajfault", &out->major_faults}});
+}
+
+Status ParseCGroupIOStat(std::string_view contents, CGroupStats* out) {
+  // Each line is "<major>:<minor> rbytes=<n> wbytes=<n> rios=<n> wios=<n> ...".
+  bool ok = true;
+  for (std::string_view line : absl::StrSplit(contents, '\n', absl::SkipEmpty())) {
+    for (std::string_view field : absl::StrSplit(line, ' ', absl::SkipEmpty())) {
+      std::pair<std::string_view, std::string_view> kv = absl::StrSplit(field, '=');
+      int64_t* total = nullptr;
+      if (kv.first == "rbytes") {
+        total = &out->read_bytes;
+      } else if (kv.first == "wbytes") {
+        total = &out->write_bytes;
+      }
+      if (total != nullptr) {
+        int64_t value = 0;
+        ok &= absl::SimpleAtoi(kv.second, &value);
+        *total += value;
+      }
+    }
+  }
+  if (!ok) {
+    return error::Internal("Failed to parse io.stat file. ATOI failed.");
+  }
+  return Status::OK();
+}
+
+StatusOr<std::filesystem::path> CGroupV2PathForPID(const system::Config& cfg, pid_t pid) {
+  const std::filesystem::path cgroup_file = cfg.proc_path() / std::to_string(pid) / "cgroup";
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(cgroup_file));
+
+  // The entry of the unified hierarchy is "0::<path>".
+  constexpr std::string_view kUnifiedPrefix = "0::";
+  for (std::string_view line : absl::StrSplit(contents, '\n')) {
+    if (!absl::StartsWith(line, kUnifiedPrefix)) {
+      continue;
+    }
+    line.remove_prefix(kUnifiedPrefix.size());
+    return cfg.sysfs_path() / "fs/cgroup" / std::filesystem::path(line).relative_path();
+  }
+  return error::NotFound("No cgroup v2 entry in $0", cgroup_file.string());
+}
+
+Status ReadCGroupStats(const std::filesystem::path& cgroup_path, CGroupStats* out) {
+  DCHECK(out != nullptr);
+  out->Clear();
+
+  PL_ASSIGN_OR_RETURN(std::string cpu_stat, ReadFileToString(cgroup_path / "cpu.stat"));
+  PL_RETURN_IF_ERROR(ParseCGroupCPUStat(cpu_stat, out));
+
+  // The memory and io controllers may not be enabled for the cgroup, in which case the files
+  // don't exist.
+  StatusOr<std::string> memory_stat = ReadFileToString(cgroup_path / "memory.stat");
+  if (memory_stat.ok()) {
+    PL_RETURN_IF_ERROR(ParseCGroupMemoryStat(memory_stat.ValueOrDie(), out));
+  }
+  StatusOr<std::string> io_stat = ReadFileToString(cgroup_path / "io.stat");
+  if (io_stat.ok()) {
+    PL_RETURN_IF_ERROR(ParseCGroupIOStat(io_stat.ValueOrDie(), out));
+  }
+  return Status::OK();
+}
+
+}  // namespace system
+}  // namespace px
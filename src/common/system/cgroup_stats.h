@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "src/common/base/base.h"
+#include "src/common/system/config.h"
+
+namespace px {
+namespace system {
+
+/**
+ * CGroupStats are the CPU, memory and IO totals of all the processes of a cgroup v2, as
+ * accounted by the kernel in cpu.stat, memory.stat and io.stat.
+ */
+struct CGroupStats {
+  // cpu.stat
+  int64_t utime_ns = 0;
+  int64_t ktime_ns = 0;
+
+  // memory.stat
+  int64_t anon_bytes = 0;
+  int64_t file_bytes = 0;
+  int64_t minor_faults = 0;
+  int64_t major_faults = 0;
+
+  // io.stat, summed over all devices.
+  int64_t read_bytes = 0;
+  int64_t write_bytes = 0;
+
+  void Clear() { *this = CGroupStats(); }
+};
+
+/**
+ * Returns the directory of the cgroup v2 of the process under <sysfs>/fs/cgroup, from the "0::"
+ * entry of /proc/<pid>/cgroup. Returns NotFound if the process is not in a cgroup v2 hierarchy.
+ */
+StatusOr<std::filesystem::path> CGroupV2PathForPID(const system::Config& cfg, pid_t pid);
+
+/**
+ * Reads cpu.stat, memory.stat and io.stat of the cgroup v2 directory. A controller that is not
+ * enabled for the cgroup leaves its fields at 0, except for cpu.stat, which always exists.
+ */
+Status ReadCGroupStats(const std::filesystem::path& cgroup_path, CGroupStats* out);
+
+/**
+ * Parses the contents of a cpu.stat file.
+ */
+Status ParseCGroupCPUStat(std::string_view contents, CGroupStats* out);
+
+/**
+ * Parses the contents of a memory.stat file.
+ */
+Status ParseCGroupMemoryStat(std::string_view contents, CGroupStats* out);
+
+/**
+ * Parses the contents of an io.stat file.
+ */
+Status ParseCGroupIOStat(std::string_view contents, CGroupStats* out);
+
+}  // namespace system
+}  // namespace px
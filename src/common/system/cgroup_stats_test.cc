@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/cgroup_stats.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/system/config_mock.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+using ::testing::ReturnRef;
+
+constexpr char kTestDataBasePath[] = "src/common/system/testdata";
+constexpr char kContainerCGroup[] =
+    "fs/cgroup/kubepods.slice/kubepods-pod1234.slice/cri-containerd-abcd.scope";
+
+class CGroupStatsTest : public ::testing::Test {
+ protected:
+  CGroupStatsTest()
+      : proc_path_(testing::TestFilePath(std::filesystem::path(kTestDataBasePath) / "proc")),
+        sysfs_path_(testing::TestFilePath(std::filesystem::path(kTestDataBasePath) / "sys")) {
+    EXPECT_CALL(sysconfig_, proc_path()).WillRepeatedly(ReturnRef(proc_path_));
+    EXPECT_CALL(sysconfig_, sysfs_path()).WillRepeatedly(ReturnRef(sysfs_path_));
+  }
+
+  std::filesystem::path proc_path_;
+  std::filesystem::path sysfs_path_;
+  system::MockConfig sysconfig_;
+};
+
+TEST_F(CGroupStatsTest, CGroupV2PathForPID) {
+  ASSERT_OK_AND_EQ(CGroupV2PathForPID(sysconfig_, 123), sysfs_path_ / kContainerCGroup);
+
+  // 456 only has cgroup v1 entries.
+  EXPECT_NOT_OK(CGroupV2PathForPID(sysconfig_, 456));
+  // 789 has no cgroup file.
+  EXPECT_NOT_OK(CGroupV2PathForPID(sysconfig_, 789));
+}
+
+TEST_F(CGroupStatsTest, ReadCGroupStats) {
+  CGroupStats stats;
+  ASSERT_OK(ReadCGroupStats(sysfs_path_ / kContainerCGroup, &stats));
+
+  EXPECT_EQ(stats.utime_ns, 2012345000);
+  EXPECT_EQ(stats.ktime_ns, 1044444000);
+  EXPECT_EQ(stats.anon_bytes, 52588544);
+  EXPECT_EQ(stats.file_bytes, 10276864);
+  EXPECT_EQ(stats.minor_faults, 31779);
+  EXPECT_EQ(stats.major_faults, 33);
+  // Summed over both devices.
+  EXPECT_EQ(stats.read_bytes, 1048576 + 2048);
+  EXPECT_EQ(stats.write_bytes, 4096 + 8192);
+}
+
+TEST_F(CGroupStatsTest, ReadCGroupStatsMissingCGroup) {
+  CGroupStats stats;
+  EXPECT_NOT_OK(ReadCGroupStats(sysfs_path_ / "fs/cgroup/does-not-exist", &stats));
+}
+
+TEST(ParseCGroupStatTest, MissingControllerFilesLeaveZeros) {
+  CGroupStats stats;
+  ASSERT_OK(ParseCGroupCPUStat("usage_usec 30\nuser_usec 10\nsystem_usec 20\n", &stats));
+  EXPECT_EQ(stats.utime_ns, 10000);
+  EXPECT_EQ(stats.ktime_ns, 20000);
+  EXPECT_EQ(stats.anon_bytes, 0);
+  EXPECT_EQ(stats.read_bytes, 0);
+}
+
+TEST(ParseCGroupStatTest, MalformedValue) {
+  CGroupStats stats;
+  EXPECT_NOT_OK(ParseCGroupMemoryStat("anon abc\n", &stats));
+  EXPECT_NOT_OK(ParseCGroupIOStat("8:0 rbytes=x wbytes=1\n", &stats));
+}
+
+}  // namespace system
+}  // namespace px
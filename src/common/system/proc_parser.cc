@@ -16,6 +16,14 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <limits>
 #include <string>
@@ -95,6 +103,128 @@ constexpr int kProcStatStartTimeField = 21;
 constexpr int kProcStatVSizeField = 22;
 constexpr int kProcStatRSSField = 23;
 
+namespace {
+
+// Separators of the fields, including the line breaks, for scanning whole files.
+constexpr char kFieldAndLineSeparators[] = "\t \n";
+
+// Returns the next field of *str, and advances *str past it.
+// Returns an empty string_view if there are no more fields.
+std::string_view NextField(std::string_view* str) {
+  size_t start = str->find_first_not_of(kFieldAndLineSeparators);
+  if (start == std::string_view::npos) {
+    *str = {};
+    return {};
+  }
+  size_t end = std::min(str->find_first_of(kFieldAndLineSeparators, start), str->size());
+  std::string_view field = str->substr(start, end - start);
+  str->remove_prefix(end);
+  return field;
+}
+
+// Parses the contents of a /proc/<pid>/stat file in place.
+Status ParseProcPIDStatContents(std::string_view contents, int64_t ns_per_kernel_tick,
+                                int32_t bytes_per_page, ProcParser::ProcessStats* out) {
+  // The name is surrounded by (). Since the name itself may contain spaces and parentheses,
+  // it ends at the last ')'.
+  size_t name_start = contents.find('(');
+  size_t name_end = contents.rfind(')');
+  if (name_start == std::string_view::npos || name_end == std::string_view::npos ||
+      name_end < name_start) {
+    return error::Unknown("Could not find the process name in stat file");
+  }
+
+  static_assert(kProcStatProcessNameField == kProcStatPIDField + 1);
+  std::string_view pid_field = contents.substr(0, name_start);
+  bool ok = absl::SimpleAtoi(NextField(&pid_field), &out->pid);
+  if (name_end - name_start > 1) {
+    out->process_name.assign(contents.data() + name_start + 1, name_end - name_start - 1);
+  } else {
+    ok = false;
+  }
+
+  std::string_view fields = contents.substr(name_end + 1);
+  int field_idx = kProcStatProcessNameField + 1;
+  for (std::string_view field = NextField(&fields); !field.empty();
+       field = NextField(&fields), ++field_idx) {
+    switch (field_idx) {
+      case kProcStatMinorFaultsField:
+        ok &= absl::SimpleAtoi(field, &out->minor_faults);
+        break;
+      case kProcStatMajorFaultsField:
+        ok &= absl::SimpleAtoi(field, &out->major_faults);
+        break;
+      case kProcStatUTimeField:
+        ok &= absl::SimpleAtoi(field, &out->utime_ns);
+        break;
+      case kProcStatKTimeField:
+        ok &= absl::SimpleAtoi(field, &out->ktime_ns);
+        break;
+      case kProcStatNumThreadsField:
+        ok &= absl::SimpleAtoi(field, &out->num_threads);
+        break;
+      case kProcStatVSizeField:
+        ok &= absl::SimpleAtoi(field, &out->vsize_bytes);
+        break;
+      case kProcStatRSSField:
+        ok &= absl::SimpleAtoi(field, &out->rss_bytes);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // We check less than in case more fields are added later.
+  if (field_idx < kProcStatNumFields) {
+    return error::Unknown("Incorrect number of fields in stat file");
+  }
+
+  if (!ok) {
+    // This should never happen since it requires the file to be ill-formed
+    // by the kernel.
+    return error::Internal("Failed to parse stat file. ATOI failed.");
+  }
+
+  // The kernel tracks utime and ktime in kernel ticks.
+  out->utime_ns *= ns_per_kernel_tick;
+  out->ktime_ns *= ns_per_kernel_tick;
+
+  // RSS is in pages.
+  out->rss_bytes *= bytes_per_page;
+
+  return Status::OK();
+}
+
+// Parses the contents of a /proc/<pid>/io file in place.
+Status ParseProcPIDIOContents(std::string_view contents, ProcParser::ProcessStats* out) {
+  bool ok = true;
+  for (std::string_view key = NextField(&contents); !key.empty(); key = NextField(&contents)) {
+    std::string_view value = NextField(&contents);
+
+    int64_t* field = nullptr;
+    if (key == "rchar:") {
+      field = &out->rchar_bytes;
+    } else if (key == "wchar:") {
+      field = &out->wchar_bytes;
+    } else if (key == "read_bytes:") {
+      field = &out->read_bytes;
+    } else if (key == "write_bytes:") {
+      field = &out->write_bytes;
+    }
+
+    if (field != nullptr) {
+      ok &= absl::SimpleAtoi(value, field);
+    }
+  }
+
+  if (!ok) {
+    return error::Internal("Failed to parse io file. ATOI failed.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 std::filesystem::path ProcParser::ProcPidPath(pid_t pid) const {
   return std::filesystem::path(proc_base_path_) / std::to_string(pid);
 }
@@ -225,45 +355,13 @@ Status ProcParser::ParseProcPIDStat(int32_t pid, ProcessStats* out) const {
   }
 
   std::string line;
-  bool ok = true;
-  if (std::getline(ifs, line)) {
-    std::vector<std::string_view> split = absl::StrSplit(line, " ", absl::SkipWhitespace());
-    // We check less than in case more fields are added later.
-    if (split.size() < kProcStatNumFields) {
-      return error::Unknown("Incorrect number of fields in stat file: $0", fpath);
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatPIDField], &out->pid);
-    // The name is surrounded by () we remove it here.
-    const std::string_view& name_field = split[kProcStatProcessNameField];
-    if (name_field.length() > 2) {
-      out->process_name = std::string(name_field.substr(1, name_field.size() - 2));
-    } else {
-      ok = false;
-    }
-    ok &= absl::SimpleAtoi(split[kProcStatMinorFaultsField], &out->minor_faults);
-    ok &= absl::SimpleAtoi(split[kProcStatMajorFaultsField], &out->major_faults);
-
-    ok &= absl::SimpleAtoi(split[kProcStatUTimeField], &out->utime_ns);
-    ok &= absl::SimpleAtoi(split[kProcStatKTimeField], &out->ktime_ns);
-    // The kernel tracks utime and ktime in kernel ticks.
-    out->utime_ns *= ns_per_kernel_tick_;
-    out->ktime_ns *= ns_per_kernel_tick_;
-
-    ok &= absl::SimpleAtoi(split[kProcStatNumThreadsField], &out->num_threads);
-    ok &= absl::SimpleAtoi(split[kProcStatVSizeField], &out->vsize_bytes);
-    ok &= absl::SimpleAtoi(std::string(split[kProcStatRSSField]), &out->rss_bytes);
-
-    // RSS is in pages.
-    out->rss_bytes *= bytes_per_page_;
-
-  } else {
+  if (!std::getline(ifs, line)) {
     return error::Internal("Failed to read proc stat file: $0", fpath);
   }
 
-  if (!ok) {
-    // This should never happen since it requires the file to be ill-formed
-    // by the kernel.
-    return error::Internal("failed to parse stat file ($0). ATOI failed.", fpath);
+  Status s = ParseProcPIDStatContents(line, ns_per_kernel_tick_, bytes_per_page_, out);
+  if (!s.ok()) {
+    return error::Internal("$0: $1", s.msg(), fpath);
   }
   return Status::OK();
 }
@@ -463,6 +561,31 @@ Status ProcParser::ReadProcPIDFDLink(int32_t pid, int32_t fd, std::string* out)
   return Status::OK();
 }
 
+Status ProcParser::ReadProcPIDFDLinks(int32_t pid,
+                                      absl::flat_hash_map<int32_t, std::string>* out) const {
+  const std::filesystem::path fd_dir = absl::Substitute("$0/$1/fd", proc_base_path_, pid);
+  std::error_code ec;
+  std::filesystem::directory_iterator iter(fd_dir, ec);
+  if (ec) {
+    return error::Internal("Failed to list $0: $1", fd_dir.string(), ec.message());
+  }
+  for (; iter != std::filesystem::directory_iterator(); iter.increment(ec)) {
+    int32_t fd;
+    if (!absl::SimpleAtoi(iter->path().filename().string(), &fd)) {
+      continue;
+    }
+    std::filesystem::path link = std::filesystem::read_symlink(iter->path(), ec);
+    if (ec) {
+      continue;
+    }
+    (*out)[fd] = std::move(link);
+  }
+  if (ec) {
+    return error::Internal("Failed to list $0: $1", fd_dir.string(), ec.message());
+  }
+  return Status::OK();
+}
+
 std::string_view LineWithPrefix(std::string_view content, std::string_view prefix) {
   const std::vector<std::string_view> lines = absl::StrSplit(content, "\n");
   for (const auto& line : lines) {
@@ -601,6 +724,45 @@ Status ParseMountInfo(std::string_view str, ProcParser::MountInfo* mount_info) {
   return Status::OK();
 }
 
+Status ParseHex(std::string_view str, uint64_t* value) {
+  const std::string s(str);
+  char* end = nullptr;
+  errno = 0;
+  *value = std::strtoull(s.c_str(), &end, 16);
+  if (s.empty() || errno != 0 || end != s.c_str() + s.size()) {
+    return error::InvalidArgument("Failed to parse hex value: $0", str);
+  }
+  return Status::OK();
+}
+
+Status ParseProcessMap(std::string_view str, ProcParser::ProcessMap* process_map) {
+  static constexpr int kProcMapNumFields = 6;
+  std::vector<std::string_view> fields =
+      absl::StrSplit(str, absl::MaxSplits(' ', kProcMapNumFields - 1), absl::SkipWhitespace());
+  if (fields.size() < kProcMapNumFields - 1) {
+    return error::InvalidArgument("Maps record should have at least 5 fields, got: $0",
+                                  fields.size());
+  }
+
+  std::vector<std::string_view> vmem_range = absl::StrSplit(fields[0], '-');
+  if (vmem_range.size() != 2) {
+    return error::InvalidArgument("Malformed address range in maps record: $0", fields[0]);
+  }
+  PL_RETURN_IF_ERROR(ParseHex(vmem_range[0], &process_map->vmem_start));
+  PL_RETURN_IF_ERROR(ParseHex(vmem_range[1], &process_map->vmem_end));
+  process_map->permissions = fields[1];
+  PL_RETURN_IF_ERROR(ParseHex(fields[2], &process_map->file_offset));
+  process_map->dev = fields[3];
+  if (!absl::SimpleAtoi(fields[4], &process_map->inode)) {
+    return error::InvalidArgument("Malformed inode in maps record: $0", fields[4]);
+  }
+  if (fields.size() == kProcMapNumFields) {
+    process_map->pathname = absl::StripAsciiWhitespace(fields[kProcMapNumFields - 1]);
+  }
+
+  return Status::OK();
+}
+
 }  // namespace
 
 Status ProcParser::ReadMountInfos(pid_t pid,
@@ -615,6 +777,18 @@ Status ProcParser::ReadMountInfos(pid_t pid,
   return Status::OK();
 }
 
+Status ProcParser::ReadProcessMaps(pid_t pid,
+                                   std::vector<ProcParser::ProcessMap>* process_maps) const {
+  const std::filesystem::path proc_pid_maps_path = ProcPidPath(pid) / "maps";
+  PL_ASSIGN_OR_RETURN(std::string content, px::ReadFileToString(proc_pid_maps_path));
+  std::vector<std::string_view> lines = absl::StrSplit(content, "\n", absl::SkipWhitespace());
+  for (const auto line : lines) {
+    ProcParser::ProcessMap& process_map = process_maps->emplace_back();
+    PL_RETURN_IF_ERROR(ParseProcessMap(line, &process_map));
+  }
+  return Status::OK();
+}
+
 StatusOr<absl::flat_hash_set<std::string>> ProcParser::GetMapPaths(pid_t pid) {
   static constexpr int kProcMapNumFields = 6;
   absl::flat_hash_set<std::string> map_paths;
@@ -635,5 +809,173 @@ StatusOr<absl::flat_hash_set<std::string>> ProcParser::GetMapPaths(pid_t pid) {
   return map_paths;
 }
 
+/*************************************************
+ * ProcessStatsReader
+ *************************************************/
+
+namespace {
+
+// The number of files the reader may keep open. Most of the process's file descriptors are left
+// to the rest of the process, which also needs them for sockets, BPF maps and perf buffers.
+size_t OpenFilesBudget() {
+  struct rlimit rlim = {};
+  if (getrlimit(RLIMIT_NOFILE, &rlim) != 0 || rlim.rlim_cur == RLIM_INFINITY) {
+    return std::numeric_limits<size_t>::max();
+  }
+  return rlim.rlim_cur / 4;
+}
+
+}  // namespace
+
+ProcessStatsReader::ProcessStatsReader(const system::Config& cfg, size_t max_open_files)
+    : ns_per_kernel_tick_(static_cast<int64_t>(1E9 / cfg.KernelTicksPerSecond())),
+      bytes_per_page_(cfg.PageSize()),
+      proc_base_path_(cfg.proc_path()),
+      max_open_files_(std::min(max_open_files, OpenFilesBudget())) {
+  CHECK(cfg.HasConfig()) << "System config is required for the ProcessStatsReader";
+}
+
+ProcessStatsReader::~ProcessStatsReader() {
+  for (auto& [pid, files] : pid_files_) {
+    ClosePIDFiles(&files);
+  }
+}
+
+void ProcessStatsReader::ClosePIDFiles(PIDFiles* files) {
+  for (int* fd : {&files->stat_fd, &files->io_fd}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+size_t ProcessStatsReader::num_open_files() const {
+  size_t num_open_files = 0;
+  for (const auto& [pid, files] : pid_files_) {
+    num_open_files += (files.stat_fd >= 0) + (files.io_fd >= 0);
+  }
+  return num_open_files;
+}
+
+StatusOr<std::string_view> ProcessStatsReader::ReadFile(pid_t pid, std::string_view name,
+                                                        int* fd) {
+  // A cached file fails to read once its process exits. By then the PID may have been reused by
+  // a new process, so the file is re-opened once.
+  bool reopened = false;
+  while (true) {
+    if (*fd < 0) {
+      std::string fpath = absl::StrCat(proc_base_path_, "/", pid, "/", name);
+      *fd = open(fpath.c_str(), O_RDONLY | O_CLOEXEC);
+      if (*fd < 0) {
+        out_of_fds_ = errno == EMFILE || errno == ENFILE;
+        return error::Internal("Failed to open file $0: $1", fpath, std::strerror(errno));
+      }
+      reopened = true;
+    }
+
+    ssize_t bytes_read = pread(*fd, buf_.data(), buf_.size(), 0);
+    if (bytes_read >= 0) {
+      if (static_cast<size_t>(bytes_read) == buf_.size()) {
+        return error::Internal("File $0/$1/$2 is larger than the read buffer", proc_base_path_,
+                               pid, name);
+      }
+      return std::string_view(buf_.data(), bytes_read);
+    }
+
+    int read_errno = errno;
+    close(*fd);
+    *fd = -1;
+    if (reopened) {
+      return error::Internal("Failed to read file $0/$1/$2: $3", proc_base_path_, pid, name,
+                             std::strerror(read_errno));
+    }
+  }
+}
+
+Status ProcessStatsReader::ReadProcessStats(pid_t pid, PIDFiles* files,
+                                            ProcParser::ProcessStats* out) {
+  PL_ASSIGN_OR_RETURN(std::string_view stat_contents, ReadFile(pid, "stat", &files->stat_fd));
+  PL_RETURN_IF_ERROR(
+      ParseProcPIDStatContents(stat_contents, ns_per_kernel_tick_, bytes_per_page_, out));
+
+  // Reading the io file reuses buf_, so the stat file must already have been parsed.
+  PL_ASSIGN_OR_RETURN(std::string_view io_contents, ReadFile(pid, "io", &files->io_fd));
+  return ParseProcPIDIOContents(io_contents, out);
+}
+
+Status ProcessStatsReader::ReadProcessStats(pid_t pid, ProcParser::ProcessStats* out) {
+  DCHECK(out != nullptr);
+
+  Status s = ReadProcessStatsWithCachedFiles(pid, out);
+  if (s.ok() || !out_of_fds_) {
+    return s;
+  }
+
+  // The limit on file descriptors was reached, possibly by the rest of the process. Keep half as
+  // many files open from now on, and close the cached ones to make room for this read.
+  max_open_files_ = num_open_files() / 2;
+  for (auto& entry : pid_files_) {
+    ClosePIDFiles(&entry.second);
+  }
+  pid_files_.clear();
+
+  PIDFiles files;
+  s = ReadProcessStats(pid, &files, out);
+  ClosePIDFiles(&files);
+  out_of_fds_ = false;
+  return s;
+}
+
+Status ProcessStatsReader::ReadProcessStatsWithCachedFiles(pid_t pid,
+                                                           ProcParser::ProcessStats* out) {
+  auto iter = pid_files_.find(pid);
+  if (iter == pid_files_.end()) {
+    if (2 * (pid_files_.size() + 1) > max_open_files_) {
+      // Too many files are open already, so read without keeping the files open.
+      PIDFiles files;
+      Status s = ReadProcessStats(pid, &files, out);
+      ClosePIDFiles(&files);
+      return s;
+    }
+    iter = pid_files_.try_emplace(pid).first;
+  }
+
+  PIDFiles& files = iter->second;
+  files.generation = generation_;
+  Status s = ReadProcessStats(pid, &files, out);
+  if (!s.ok()) {
+    ClosePIDFiles(&files);
+    pid_files_.erase(iter);
+  }
+  return s;
+}
+
+void ProcessStatsReader::ReadProcessStatsBatch(const std::vector<pid_t>& pids,
+                                               std::vector<ProcParser::ProcessStats>* stats,
+                                               std::vector<Status>* statuses) {
+  DCHECK(stats != nullptr);
+  DCHECK(statuses != nullptr);
+
+  ++generation_;
+
+  stats->resize(pids.size());
+  statuses->resize(pids.size());
+  for (size_t i = 0; i < pids.size(); ++i) {
+    (*stats)[i].Clear();
+    (*statuses)[i] = ReadProcessStats(pids[i], &(*stats)[i]);
+  }
+
+  // Close the files of the processes that are no longer of interest.
+  for (auto iter = pid_files_.begin(); iter != pid_files_.end();) {
+    if (iter->second.generation != generation_) {
+      ClosePIDFiles(&iter->second);
+      pid_files_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
 }  // namespace system
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <array>
 #include <filesystem>
 #include <istream>
 #include <map>
@@ -94,7 +95,13 @@ class ProcParser {
     int64_t read_bytes = 0;
     int64_t write_bytes = 0;
 
-    void Clear() { *this = ProcessStats(); }
+    // Keeps the buffer of process_name, so that clearing stats for reuse doesn't allocate.
+    void Clear() {
+      std::string name = std::move(process_name);
+      name.clear();
+      *this = ProcessStats();
+      process_name = std::move(name);
+    }
   };
 
   /**
@@ -196,6 +203,16 @@ class ProcParser {
    */
   Status ReadProcPIDFDLink(int32_t pid, int32_t fd, std::string* out) const;
 
+  /**
+   * Reads the links of all the FDs of the process, with one scan of /proc/<pid>/fd.
+   * FDs that close during the scan are left out.
+   *
+   * @param pid is the pid for which we want the FD links.
+   * @param out A valid pointer to the output map from FD to its link.
+   * @return Status of the parsing.
+   */
+  Status ReadProcPIDFDLinks(int32_t pid, absl::flat_hash_map<int32_t, std::string>* out) const;
+
   /**
    * UIDs associated with a process.
    */
@@ -243,6 +260,39 @@ class ProcParser {
 
   Status ReadMountInfos(pid_t pid, std::vector<MountInfo>* mount_infos) const;
 
+  /**
+   * Represents a record of the proc maps file, like /proc/[pid]/maps.
+   * See http://man7.org/linux/man-pages/man5/proc.5.html for more details.
+   */
+  struct ProcessMap {
+    uint64_t vmem_start = 0;
+    uint64_t vmem_end = 0;
+    // Permissions, e.g. "r-xp".
+    std::string permissions;
+    // Offset into the mapped file.
+    uint64_t file_offset = 0;
+    // The device (major:minor) holding the mapped file.
+    std::string dev;
+    // The inode of the mapped file; 0 for anonymous mappings.
+    uint64_t inode = 0;
+    // Empty for anonymous mappings.
+    std::string pathname;
+
+    bool executable() const { return permissions.size() > 2 && permissions[2] == 'x'; }
+
+    std::string ToString() const {
+      return absl::Substitute("vmem=[$0,$1) perms=$2 offset=$3 dev=$4 inode=$5 path=$6",
+                              vmem_start, vmem_end, permissions, file_offset, dev, inode,
+                              pathname);
+    }
+  };
+
+  /**
+   * Reads all records in /proc/<pid>/maps, in the order listed by the kernel
+   * (i.e. sorted by vmem_start).
+   */
+  Status ReadProcessMaps(pid_t pid, std::vector<ProcessMap>* process_maps) const;
+
   /**
    * Returns all mapped paths found in /proc/<pid>/maps.
    *
@@ -278,6 +328,82 @@ class ProcParser {
   std::string proc_base_path_;
 };
 
+/**
+ * ProcessStatsReader reads the per-process stats (/proc/<pid>/stat and /proc/<pid>/io) of many
+ * processes repeatedly, as done on every sampling period.
+ *
+ * Unlike ProcParser, the files are kept open across reads, re-read with pread() into a reusable
+ * buffer, and parsed in place. In steady state, a read costs one syscall per file and does not
+ * allocate. This class is not thread-safe.
+ */
+class ProcessStatsReader {
+ public:
+  // Each cached process holds two open files.
+  static constexpr size_t kDefaultMaxOpenFiles = 1024;
+
+  /**
+   * ProcessStatsReader constructor.
+   * @param cfg a reference to the system config. Only needs to be valid for the
+   * duration of the constructor call.
+   * @param max_open_files Upper bound on the files kept open. Processes beyond the bound are
+   * still read, but their files are closed after each read. The bound is lowered to a quarter of
+   * the RLIMIT_NOFILE soft limit, and lowered again if the process runs out of file descriptors.
+   */
+  explicit ProcessStatsReader(const system::Config& cfg,
+                              size_t max_open_files = kDefaultMaxOpenFiles);
+  ~ProcessStatsReader();
+
+  /**
+   * Reads the stat and io files of the process.
+   * @param pid is the pid for which we want the stats.
+   * @param out A valid pointer to the output.
+   * @return Status of the reading and parsing.
+   */
+  Status ReadProcessStats(pid_t pid, ProcParser::ProcessStats* out);
+
+  /**
+   * Reads the stats of all the processes in one pass. Afterwards, the files of processes that
+   * were not in pids are closed, so pids should be the full set of processes of interest.
+   * @param pids The processes to read.
+   * @param stats Resized to pids.size(); stats[i] receives the stats of pids[i].
+   * @param statuses Resized to pids.size(); statuses[i] is the status of reading pids[i].
+   */
+  void ReadProcessStatsBatch(const std::vector<pid_t>& pids,
+                             std::vector<ProcParser::ProcessStats>* stats,
+                             std::vector<Status>* statuses);
+
+  size_t num_open_files() const;
+
+ private:
+  struct PIDFiles {
+    int stat_fd = -1;
+    int io_fd = -1;
+    // The batch in which the process was last read.
+    uint64_t generation = 0;
+  };
+
+  Status ReadProcessStats(pid_t pid, PIDFiles* files, ProcParser::ProcessStats* out);
+  Status ReadProcessStatsWithCachedFiles(pid_t pid, ProcParser::ProcessStats* out);
+
+  // Reads the file /proc/<pid>/<name> into buf_, opening it if *fd is -1.
+  StatusOr<std::string_view> ReadFile(pid_t pid, std::string_view name, int* fd);
+
+  static void ClosePIDFiles(PIDFiles* files);
+
+  const int64_t ns_per_kernel_tick_;
+  const int32_t bytes_per_page_;
+  const std::string proc_base_path_;
+  size_t max_open_files_;
+
+  absl::flat_hash_map<pid_t, PIDFiles> pid_files_;
+  uint64_t generation_ = 0;
+  // Set when a file failed to open because the process or the system is out of file descriptors.
+  bool out_of_fds_ = false;
+
+  // Holds the contents of the file being parsed. Both files are well under a page in size.
+  std::array<char, 4096> buf_;
+};
+
 StatusOr<int64_t> GetPIDStartTimeTicks(const std::filesystem::path& proc_pid_path);
 
 }  // namespace system
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/common/system/config_mock.h"
+#include "src/common/system/proc_parser.h"
+#include "src/common/testing/temp_dir.h"
+
+namespace px {
+namespace system {
+
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+namespace {
+
+constexpr std::string_view kStatContents =
+    "4602 (ibazel) S 3260 4602 3260 34818 4602 1077936128 1799 174589 55 68 8 23 106 72 20 0 13 0 "
+    "14329 114384896 2577 18446744073709551615 4194304 7917379 140730842479232 0 0 0 1006254592 0 "
+    "2143420159 0 0 0 17 3 0 0 3 0 0 12193792 12432192 34951168 140730842488151 140730842488200 "
+    "140730842488200 140730842492896 0\n";
+
+constexpr std::string_view kIOContents =
+    "rchar: 5405203\nwchar: 1239158\nsyscr: 10608\nsyscw: 3141\nread_bytes: 17838080\n"
+    "write_bytes: 634880\ncancelled_write_bytes: 192512\n";
+
+// A synthetic procfs with the stat and io files of num_pids processes.
+class SyntheticProcFS {
+ public:
+  explicit SyntheticProcFS(int num_pids) : proc_path_(temp_dir_.path()) {
+    for (int pid = 1; pid <= num_pids; ++pid) {
+      std::filesystem::path pid_path = proc_path_ / std::to_string(pid);
+      PL_CHECK_OK(fs::CreateDirectories(pid_path));
+      PL_CHECK_OK(WriteFileFromString((pid_path / "stat").string(), kStatContents));
+      PL_CHECK_OK(WriteFileFromString((pid_path / "io").string(), kIOContents));
+      pids_.push_back(pid);
+    }
+
+    ON_CALL(sysconfig_, HasConfig()).WillByDefault(Return(true));
+    ON_CALL(sysconfig_, PageSize()).WillByDefault(Return(4096));
+    ON_CALL(sysconfig_, KernelTicksPerSecond()).WillByDefault(Return(100));
+    ON_CALL(sysconfig_, proc_path()).WillByDefault(ReturnRef(proc_path_));
+  }
+
+  const Config& sysconfig() const { return sysconfig_; }
+  const std::vector<pid_t>& pids() const { return pids_; }
+
+ private:
+  testing::TempDir temp_dir_;
+  std::filesystem::path proc_path_;
+  ::testing::NiceMock<MockConfig> sysconfig_;
+  std::vector<pid_t> pids_;
+};
+
+}  // namespace
+
+// Reads the stats of all processes with ProcParser, as the process_stats connector used to.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ProcParser(benchmark::State& state) {
+  SyntheticProcFS procfs(state.range(0));
+  ProcParser parser(procfs.sysconfig());
+
+  for (auto _ : state) {
+    for (pid_t pid : procfs.pids()) {
+      ProcParser::ProcessStats stats;
+      PL_CHECK_OK(parser.ParseProcPIDStat(pid, &stats));
+      PL_CHECK_OK(parser.ParseProcPIDStatIO(pid, &stats));
+      benchmark::DoNotOptimize(stats);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * procfs.pids().size());
+}
+
+// Reads the stats of all processes in one batch with ProcessStatsReader.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ProcessStatsReaderBatch(benchmark::State& state) {
+  SyntheticProcFS procfs(state.range(0));
+  ProcessStatsReader stats_reader(procfs.sysconfig(), /* max_open_files */ 4 * state.range(0));
+
+  std::vector<ProcParser::ProcessStats> stats;
+  std::vector<Status> statuses;
+  for (auto _ : state) {
+    stats_reader.ReadProcessStatsBatch(procfs.pids(), &stats, &statuses);
+    benchmark::DoNotOptimize(stats);
+  }
+  state.SetItemsProcessed(state.iterations() * procfs.pids().size());
+}
+
+BENCHMARK(BM_ProcParser)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK(BM_ProcessStatsReaderBatch)->RangeMultiplier(4)->Range(16, 256);
+
+}  // namespace system
+}  // namespace px
@@ -27,6 +27,7 @@
 
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/config_mock.h"
+#include "src/common/testing/temp_dir.h"
 #include "src/common/testing/test_environment.h"
 #include "src/common/testing/testing.h"
 
@@ -35,6 +36,7 @@ namespace system {
 
 using ::testing::ElementsAre;
 using ::testing::IsEmpty;
+using ::testing::Pair;
 using ::testing::Return;
 using ::testing::ReturnRef;
 using ::testing::UnorderedElementsAre;
@@ -60,11 +62,13 @@ class ProcParserTest : public ::testing::Test {
     EXPECT_CALL(sysconfig, ClockRealTimeOffset()).WillRepeatedly(Return(128));
     EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path_));
     parser_ = std::make_unique<ProcParser>(sysconfig);
+    stats_reader_ = std::make_unique<ProcessStatsReader>(sysconfig);
     bytes_per_page_ = sysconfig.PageSize();
   }
 
   std::filesystem::path proc_path_;
   std::unique_ptr<ProcParser> parser_;
+  std::unique_ptr<ProcessStatsReader> stats_reader_;
   int bytes_per_page_ = 0;
 };
 
@@ -113,6 +117,97 @@ TEST_F(ProcParserTest, ParsePidStat) {
   EXPECT_EQ(2577 * bytes_per_page_, stats.rss_bytes);
 }
 
+TEST_F(ProcParserTest, ProcessStatsReader) {
+  ProcParser::ProcessStats expected;
+  ASSERT_OK(parser_->ParseProcPIDStat(123, &expected));
+  ASSERT_OK(parser_->ParseProcPIDStatIO(123, &expected));
+
+  // Read twice, so that the second read goes through the cached files.
+  for (int i = 0; i < 2; ++i) {
+    ProcParser::ProcessStats stats;
+    ASSERT_OK(stats_reader_->ReadProcessStats(123, &stats));
+    EXPECT_EQ(stats.pid, expected.pid);
+    EXPECT_EQ(stats.process_name, expected.process_name);
+    EXPECT_EQ(stats.minor_faults, expected.minor_faults);
+    EXPECT_EQ(stats.major_faults, expected.major_faults);
+    EXPECT_EQ(stats.utime_ns, expected.utime_ns);
+    EXPECT_EQ(stats.ktime_ns, expected.ktime_ns);
+    EXPECT_EQ(stats.num_threads, expected.num_threads);
+    EXPECT_EQ(stats.vsize_bytes, expected.vsize_bytes);
+    EXPECT_EQ(stats.rss_bytes, expected.rss_bytes);
+    EXPECT_EQ(stats.rchar_bytes, expected.rchar_bytes);
+    EXPECT_EQ(stats.wchar_bytes, expected.wchar_bytes);
+    EXPECT_EQ(stats.read_bytes, expected.read_bytes);
+    EXPECT_EQ(stats.write_bytes, expected.write_bytes);
+  }
+  EXPECT_EQ(stats_reader_->num_open_files(), 2);
+}
+
+TEST(ProcessStatsReaderTest, ReadBatch) {
+  testing::TempDir proc_dir;
+  const std::filesystem::path proc_path = proc_dir.path();
+
+  // The process name contains spaces and parentheses.
+  ASSERT_OK(fs::CreateDirectories(proc_path / "42"));
+  ASSERT_OK(WriteFileFromString(
+      (proc_path / "42/stat").string(),
+      "42 (my (odd) proc) S 1 42 42 0 -1 4194560 100 0 5 0 7 3 0 0 20 0 4 0 1000 1048576 16 "
+      "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"));
+  ASSERT_OK(WriteFileFromString((proc_path / "42/io").string(),
+                                "rchar: 1\nwchar: 2\nsyscr: 3\nsyscw: 4\nread_bytes: 5\n"
+                                "write_bytes: 6\ncancelled_write_bytes: 7\n"));
+
+  system::MockConfig sysconfig;
+  EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+  EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(100));
+  EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path));
+  ProcessStatsReader stats_reader(sysconfig);
+
+  std::vector<ProcParser::ProcessStats> stats;
+  std::vector<Status> statuses;
+  stats_reader.ReadProcessStatsBatch({42, 43}, &stats, &statuses);
+  ASSERT_EQ(stats.size(), 2);
+  ASSERT_EQ(statuses.size(), 2);
+
+  ASSERT_OK(statuses[0]);
+  EXPECT_EQ(stats[0].pid, 42);
+  EXPECT_EQ(stats[0].process_name, "my (odd) proc");
+  EXPECT_EQ(stats[0].minor_faults, 100);
+  EXPECT_EQ(stats[0].major_faults, 5);
+  EXPECT_EQ(stats[0].utime_ns, 70000000);
+  EXPECT_EQ(stats[0].ktime_ns, 30000000);
+  EXPECT_EQ(stats[0].num_threads, 4);
+  EXPECT_EQ(stats[0].vsize_bytes, 1048576);
+  EXPECT_EQ(stats[0].rss_bytes, 16 * 4096);
+  EXPECT_EQ(stats[0].rchar_bytes, 1);
+  EXPECT_EQ(stats[0].wchar_bytes, 2);
+  EXPECT_EQ(stats[0].read_bytes, 5);
+  EXPECT_EQ(stats[0].write_bytes, 6);
+
+  // PID 43 does not exist.
+  EXPECT_NOT_OK(statuses[1]);
+  EXPECT_EQ(stats_reader.num_open_files(), 2);
+
+  // The files of processes that are not in the batch are closed.
+  stats_reader.ReadProcessStatsBatch({43}, &stats, &statuses);
+  ASSERT_EQ(statuses.size(), 1);
+  EXPECT_NOT_OK(statuses[0]);
+  EXPECT_EQ(stats_reader.num_open_files(), 0);
+}
+
+TEST(ProcessStatsReaderTest, ClearKeepsNameBuffer) {
+  ProcParser::ProcessStats stats;
+  stats.pid = 42;
+  stats.process_name = "a process name that does not fit in the inline buffer";
+  const size_t capacity = stats.process_name.capacity();
+
+  stats.Clear();
+  EXPECT_EQ(stats.pid, -1);
+  EXPECT_TRUE(stats.process_name.empty());
+  EXPECT_EQ(stats.process_name.capacity(), capacity);
+}
+
 TEST_F(ProcParserTest, ParseStat) {
   ProcParser::SystemStats stats;
   PL_CHECK_OK(parser_->ParseProcStat(&stats));
@@ -187,6 +282,22 @@ TEST_F(ProcParserTest, read_proc_fd_link) {
   EXPECT_NOT_OK(s);
 }
 
+TEST_F(ProcParserTest, read_proc_fd_links) {
+  ASSERT_OK(
+      fs::CreateSymlinkIfNotExists("/dev/null", GetPathToTestDataFile("testdata/proc/123/fd/0")));
+  ASSERT_OK(
+      fs::CreateSymlinkIfNotExists("/foobar", GetPathToTestDataFile("testdata/proc/123/fd/1")));
+  ASSERT_OK(fs::CreateSymlinkIfNotExists("socket:[12345]",
+                                         GetPathToTestDataFile("testdata/proc/123/fd/2")));
+
+  absl::flat_hash_map<int32_t, std::string> links;
+  ASSERT_OK(parser_->ReadProcPIDFDLinks(123, &links));
+  EXPECT_THAT(links, UnorderedElementsAre(Pair(0, "/dev/null"), Pair(1, "/foobar"),
+                                          Pair(2, "socket:[12345]")));
+
+  EXPECT_NOT_OK(parser_->ReadProcPIDFDLinks(999, &links));
+}
+
 TEST_F(ProcParserTest, ReadUIDs) {
   ProcParser::ProcUIDs uids;
   ASSERT_OK(parser_->ReadUIDs(123, &uids));
@@ -226,6 +337,31 @@ TEST_F(ProcParserTest, ReadMountInfos) {
   }
 }
 
+TEST_F(ProcParserTest, ReadProcessMaps) {
+  std::vector<ProcParser::ProcessMap> process_maps;
+  ASSERT_OK(parser_->ReadProcessMaps(123, &process_maps));
+  ASSERT_GE(process_maps.size(), 12);
+
+  const ProcParser::ProcessMap& nginx_text = process_maps[1];
+  EXPECT_EQ(nginx_text.vmem_start, 0x565078f8c000);
+  EXPECT_EQ(nginx_text.vmem_end, 0x565079054000);
+  EXPECT_EQ(nginx_text.permissions, "r-xp");
+  EXPECT_TRUE(nginx_text.executable());
+  EXPECT_EQ(nginx_text.file_offset, 0x28000);
+  EXPECT_EQ(nginx_text.dev, "103:02");
+  EXPECT_EQ(nginx_text.inode, 27147818);
+  EXPECT_EQ(nginx_text.pathname, "/usr/sbin/nginx");
+
+  const ProcParser::ProcessMap& anonymous = process_maps[5];
+  EXPECT_FALSE(anonymous.executable());
+  EXPECT_EQ(anonymous.inode, 0);
+  EXPECT_EQ(anonymous.pathname, "");
+
+  EXPECT_EQ(process_maps[6].pathname, "[heap]");
+  EXPECT_EQ(process_maps[11].pathname, "/lib/x86_64-linux-gnu/libc-2.28.so");
+  EXPECT_EQ(process_maps[11].file_offset, 0x22000);
+}
+
 TEST_F(ProcParserTest, GetMapPaths) {
   {
     EXPECT_OK_AND_THAT(
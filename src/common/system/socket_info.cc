@@ -461,58 +461,91 @@ void SocketProberManager::Update() {
 //-----------------------------------------------------------------------------
 
 StatusOr<std::unique_ptr<SocketInfoManager>> SocketInfoManager::Create(
-    std::filesystem::path proc_path, int conn_states) {
+    std::filesystem::path proc_path, int conn_states, std::chrono::milliseconds snapshot_ttl) {
   std::unique_ptr<SocketInfoManager> socket_info_db_ptr(
-      new SocketInfoManager(proc_path, conn_states));
+      new SocketInfoManager(proc_path, conn_states, snapshot_ttl));
   PL_ASSIGN_OR_RETURN(socket_info_db_ptr->socket_probers_, SocketProberManager::Create());
   return socket_info_db_ptr;
 }
 
-StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
+StatusOr<uint32_t> SocketInfoManager::PIDNetNamespace(uint32_t pid) {
+  auto iter = pid_net_ns_.find(pid);
+  if (iter != pid_net_ns_.end()) {
+    return iter->second;
+  }
+
   PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
+  pid_net_ns_[pid] = net_ns;
+  return net_ns;
+}
 
-  // Step 1: Get the map of connections for this network namespace.
-  // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
+Status SocketInfoManager::ProbeNamespace(uint32_t pid, uint32_t net_ns,
+                                         NamespaceConns* ns_conns) {
+  PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
+                      socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
+  DCHECK(socket_prober != nullptr);
 
-  auto ns_iter = connections_.find(net_ns);
-  if (ns_iter != connections_.end()) {
-    // Found a map of connections for this network namespace, so use it.
-    namespace_conns = &ns_iter->second;
-  } else {
-    // No map of connections for this network namespace, so use a socker prober to populate one.
-    PL_ASSIGN_OR_RETURN(NetlinkSocketProber * socket_prober,
-                        socket_probers_->GetOrCreateSocketProber(net_ns, {static_cast<int>(pid)}));
-    DCHECK(socket_prober != nullptr);
+  std::map<int, SocketInfo> conns;
+
+  Status s;
+
+  s = socket_prober->InetConnections(&conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    ns_iter = connections_.insert(ns_iter, {net_ns, {}});
-    namespace_conns = &ns_iter->second;
+  s = socket_prober->UnixConnections(&conns, cfg_conn_states_);
+  LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
+                                             net_ns, s.msg());
 
-    Status s;
+  ++num_socket_prober_calls_;
 
-    s = socket_prober->InetConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe InetConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+  // Existing entries are kept: the endpoints of a socket do not change during its lifetime.
+  ns_conns->conns.merge(conns);
+  ns_conns->probed_since_flush = true;
 
-    s = socket_prober->UnixConnections(namespace_conns, cfg_conn_states_);
-    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to probe UnixConnections [net_ns=$0 msg=$1]",
-                                               net_ns, s.msg());
+  return Status::OK();
+}
 
-    ++num_socket_prober_calls_;
+StatusOr<SocketInfoManager::NamespaceConns*> SocketInfoManager::GetOrProbeNamespace(
+    uint32_t pid, uint32_t net_ns) {
+  auto ns_iter = connections_.find(net_ns);
+  if (ns_iter != connections_.end()) {
+    // Found a snapshot of connections for this network namespace, so use it.
+    return &ns_iter->second;
   }
 
-  return namespace_conns;
+  // No snapshot for this network namespace, so use a socket prober to populate one.
+  NamespaceConns ns_conns;
+  ns_conns.snapshot_time = px::chrono::coarse_steady_clock::now();
+  PL_RETURN_IF_ERROR(ProbeNamespace(pid, net_ns, &ns_conns));
+
+  ns_iter = connections_.insert(ns_iter, {net_ns, std::move(ns_conns)});
+  return &ns_iter->second;
+}
+
+StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(uint32_t net_ns, PIDNetNamespace(pid));
+  PL_ASSIGN_OR_RETURN(NamespaceConns * ns_conns, GetOrProbeNamespace(pid, net_ns));
+  return &ns_conns->conns;
 }
 
 StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num) {
-  // Step 1: Get the map of connections for this network namespace.
-  // Create the map if it doesn't already exist.
-  std::map<int, SocketInfo>* namespace_conns;
-  PL_ASSIGN_OR_RETURN(namespace_conns, GetNamespaceConns(pid));
+  // Step 1: Get the snapshot of connections for this network namespace.
+  // Create the snapshot if it doesn't already exist.
+  PL_ASSIGN_OR_RETURN(uint32_t net_ns, PIDNetNamespace(pid));
+  PL_ASSIGN_OR_RETURN(NamespaceConns * ns_conns, GetOrProbeNamespace(pid, net_ns));
 
   // Step 2: Lookup the inode.
-  auto iter = namespace_conns->find(inode_num);
-  if (iter == namespace_conns->end()) {
+  auto iter = ns_conns->conns.find(inode_num);
+
+  // The connection may be newer than a snapshot from a previous iteration. Probe again, but only
+  // once per iteration, so that all the other lookups in the namespace share that probe.
+  if (iter == ns_conns->conns.end() && !ns_conns->probed_since_flush) {
+    PL_RETURN_IF_ERROR(ProbeNamespace(pid, net_ns, ns_conns));
+    iter = ns_conns->conns.find(inode_num);
+  }
+
+  if (iter == ns_conns->conns.end()) {
     return error::NotFound(
         "Likely not a TCP/Unix connection (might be some other socket type). Alternatively, might "
         "be looking in the wrong net namespace, which can happen if the target PID has connections "
@@ -524,7 +557,18 @@ StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num
 
 void SocketInfoManager::Flush() {
   socket_probers_->Update();
-  connections_.clear();
+
+  const auto now = px::chrono::coarse_steady_clock::now();
+  for (auto iter = connections_.begin(); iter != connections_.end();) {
+    if (now - iter->second.snapshot_time >= cfg_snapshot_ttl_) {
+      iter = connections_.erase(iter);
+    } else {
+      iter->second.probed_since_flush = false;
+      ++iter;
+    }
+  }
+
+  pid_net_ns_.clear();
   num_socket_prober_calls_ = 0;
 }
 
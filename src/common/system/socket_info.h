@@ -20,6 +20,7 @@
 
 #include <netinet/in.h>
 
+#include <chrono>
 #include <filesystem>
 #include <map>
 #include <memory>
@@ -27,8 +28,11 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/fs/inode_utils.h"
+#include "src/common/system/clock.h"
 
 #include "src/common/base/base.h"
 
@@ -257,16 +261,20 @@ class SocketProberManager {
  */
 class SocketInfoManager {
  public:
+  static constexpr std::chrono::seconds kDefaultSnapshotTTL{5};
+
   /**
    * Create a new instance of SocketInfoManager.
    *
    * @param proc_path Path to the /proc filesystem
    * @param conn_states The connection states to probe for (established, listening, etc.).
+   * @param snapshot_ttl How long the connections probed in a network namespace are kept.
    * @return unique_ptr to the SocketInfoManager, or error if there were not enough privileges to
    * initialize the SocketInfoManager.
    */
   static StatusOr<std::unique_ptr<SocketInfoManager>> Create(
-      std::filesystem::path proc_path, int conn_states = kTCPEstablishedState);
+      std::filesystem::path proc_path, int conn_states = kTCPEstablishedState,
+      std::chrono::milliseconds snapshot_ttl = kDefaultSnapshotTTL);
 
   /**
    * Return all socket info for a given network namespace.
@@ -280,6 +288,10 @@ class SocketInfoManager {
   /**
    * Search for the socket info of a given inode number.
    *
+   * All lookups into a network namespace are answered from one snapshot of its connections.
+   * If the inode is not in a snapshot taken before the last Flush(), the namespace is probed
+   * again, so a namespace is probed at most once between calls to Flush().
+   *
    * @param pid The PID owning the connection. Used to determine the network namespace.
    * @param inode_num The inode number of the local socket.
    * @return Information for socket, including remote endpoint information. Returns error if
@@ -288,7 +300,8 @@ class SocketInfoManager {
   StatusOr<SocketInfo*> Lookup(uint32_t pid, uint32_t inode_num);
 
   /**
-   * Flushes the cache so new connections can be discovered.
+   * Starts a new iteration: new connections can be discovered again, and snapshots older than
+   * the snapshot TTL are dropped.
    */
   void Flush();
 
@@ -300,8 +313,30 @@ class SocketInfoManager {
   int num_socket_prober_calls() { return num_socket_prober_calls_; }
 
  private:
-  SocketInfoManager(std::filesystem::path proc_path, int conn_states)
-      : cfg_proc_path_(proc_path), cfg_conn_states_(conn_states) {}
+  SocketInfoManager(std::filesystem::path proc_path, int conn_states,
+                    std::chrono::milliseconds snapshot_ttl)
+      : cfg_proc_path_(proc_path), cfg_conn_states_(conn_states), cfg_snapshot_ttl_(snapshot_ttl) {}
+
+  // The connections of a network namespace, keyed by socket inode.
+  struct NamespaceConns {
+    std::map<int, SocketInfo> conns;
+
+    // When the namespace was first probed for this snapshot.
+    px::chrono::coarse_steady_clock::time_point snapshot_time;
+
+    // Whether the namespace was probed since the last Flush().
+    bool probed_since_flush = false;
+  };
+
+  // Returns the network namespace of the PID, cached until the next Flush().
+  StatusOr<uint32_t> PIDNetNamespace(uint32_t pid);
+
+  // Returns the snapshot of the PID's network namespace, probing the namespace if there is none.
+  StatusOr<NamespaceConns*> GetOrProbeNamespace(uint32_t pid, uint32_t net_ns);
+
+  // Probes the connections of the namespace, and adds them to the snapshot.
+  // Entries already in the snapshot are kept, so previously returned pointers stay valid.
+  Status ProbeNamespace(uint32_t pid, uint32_t net_ns, NamespaceConns* ns_conns);
 
   const std::filesystem::path cfg_proc_path_;
 
@@ -310,9 +345,15 @@ class SocketInfoManager {
   // See connection states at the top of this file.
   const int cfg_conn_states_;
 
+  // How long a namespace snapshot is kept, across calls to Flush().
+  const std::chrono::milliseconds cfg_snapshot_ttl_;
+
   // Two-level to socket information:
-  // First key is namespace inode; second key is socket inode.
-  std::map<int, std::map<int, SocketInfo>> connections_;
+  // First key is namespace inode; second key (in NamespaceConns) is socket inode.
+  std::map<int, NamespaceConns> connections_;
+
+  // PID to network namespace inode. Cleared on every Flush().
+  absl::flat_hash_map<uint32_t, uint32_t> pid_net_ns_;
 
   // Portal through which new connection information is gathered,
   // and populated into connections_.
@@ -175,7 +175,14 @@ TEST_F(NetNamespaceTest, SocketInfoManager) {
     ASSERT_NE(socket_info, nullptr);
     EXPECT_EQ(socket_info->family, AF_INET);
 
-    // After flush, we should have made one more call.
+    // The snapshot outlives the flush, so the known inode needs no new call.
+    EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 0);
+
+    // An unknown inode probes the namespace again, but only once per flush.
+    const uint32_t kUnusedInode = 3;
+    ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
+    EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
+    ASSERT_NOT_OK(socket_info_db->Lookup(kPID, kUnusedInode));
     EXPECT_EQ(socket_info_db->num_socket_prober_calls(), 1);
   }
 }
@@ -23,5 +23,6 @@
  * This library is system dependent and only works on Linux.
  */
 
-#include "src/common/system/config.h"       // IWYU pragma: export
-#include "src/common/system/proc_parser.h"  // IWYU pragma: export
+#include "src/common/system/cgroup_stats.h"  // IWYU pragma: export
+#include "src/common/system/config.h"        // IWYU pragma: export
+#include "src/common/system/proc_parser.h"   // IWYU pragma: export
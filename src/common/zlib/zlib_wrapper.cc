@@ -60,5 +60,68 @@ StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
   return out;
 }
 
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_bytes) {
+  z_stream zs = {};
+
+  if (inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
+    return error::Internal("inflateInit2 failed while decompressing.");
+  }
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+
+  // The output buffer is the cap, so inflate stops as soon as it is full.
+  std::string out;
+  out.resize(max_output_bytes);
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+
+  int ret;
+  do {
+    ret = inflate(&zs, Z_SYNC_FLUSH);
+  } while (ret == Z_OK && zs.avail_out > 0 && zs.avail_in > 0);
+
+  out.resize(zs.total_out);
+
+  inflateEnd(&zs);
+
+  // Z_BUF_ERROR means that no progress was possible, because the input or the output ran out.
+  if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+    return error::Internal("Exception during zlib decompression: $0", zs.msg);
+  }
+
+  return out;
+}
+
+StatusOr<std::string> Deflate(std::string_view in, int level) {
+  z_stream zs = {};
+
+  // MAX_WBITS + 16 writes a gzip header, which matches what Inflate expects.
+  if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, /*memLevel*/ 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return error::Internal("deflateInit2 failed while compressing.");
+  }
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+
+  // deflateBound gives an upper bound on the output, so a single call to deflate suffices.
+  std::string out;
+  out.resize(deflateBound(&zs, in.size()));
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+
+  int ret = deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+
+  deflateEnd(&zs);
+
+  if (ret != Z_STREAM_END) {
+    return error::Internal("Exception during zlib compression: $0", zs.msg);
+  }
+
+  return out;
+}
+
 }  // namespace zlib
 }  // namespace px
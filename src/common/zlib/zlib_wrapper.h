@@ -35,5 +35,27 @@ namespace zlib {
  */
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size = 16384);
 
+/**
+ * @brief Inflates (gunzip) at most max_output_bytes of a source buffer, and stops there.
+ *
+ * Only as much of the source as is needed for the output is decompressed. Unlike Inflate(), a
+ * source that ends before its gzip stream does, e.g. a body truncated on capture, is not an error;
+ * the bytes inflated so far are returned.
+ *
+ * @param in A view into the source buffer.
+ * @param max_output_bytes The maximum size of the output.
+ * @return Status or the first max_output_bytes (or fewer) of the decompressed content.
+ */
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_bytes);
+
+/**
+ * @brief Deflates (gzip) a source buffer and returns the compressed content as a string.
+ *
+ * @param in A view into the source buffer.
+ * @param level The zlib compression level, from 1 (fastest) to 9 (smallest).
+ * @return Status or the compressed content as a string, readable by Inflate.
+ */
+StatusOr<std::string> Deflate(std::string_view in, int level = 1);
+
 }  // namespace zlib
 }  // namespace px
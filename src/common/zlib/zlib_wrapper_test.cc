@@ -46,4 +46,32 @@ TEST_F(ZlibTest, inflate_test) {
   EXPECT_OK_AND_EQ(result, GetExpectedResult());
 }
 
+TEST_F(ZlibTest, deflate_inflate_round_trip) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  EXPECT_LT(compressed.size(), input.size());
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(compressed), input);
+}
+
+TEST_F(ZlibTest, inflate_prefix) {
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 4), "This");
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 1024), GetExpectedResult());
+}
+
+TEST_F(ZlibTest, inflate_prefix_truncated_input) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  compressed.resize(compressed.size() / 2);
+
+  EXPECT_NOT_OK(px::zlib::Inflate(compressed));
+  ASSERT_OK_AND_ASSIGN(std::string prefix, px::zlib::InflatePrefix(compressed, 100));
+  EXPECT_EQ(prefix, input.substr(0, 100));
+}
+
 }  // namespace px
@@ -17,6 +17,8 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 
@@ -31,8 +33,15 @@ PL_SUPPRESS_WARNINGS_END()
 namespace px {
 namespace bloomfilter {
 
-StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64_t max_entries,
-                                                                           double error_rate) {
+namespace {
+
+// From Wikipedia: https://en.wikipedia.org/wiki/Bloom_filter
+// bits per entry = ln(error_rate)/ln(2)^2
+double BitsPerEntry(double error_rate) {
+  return -(std::log(error_rate) / std::pow(std::log(2), 2));
+}
+
+Status CheckFilterParams(int64_t max_entries, double error_rate) {
   if (error_rate <= 0.0 || error_rate >= 1.0) {
     return error::Internal(
         "Bloom filter error rate must be greater than 0 and less than 1, received %e", error_rate);
@@ -41,10 +50,25 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64
     return error::Internal("Bloom filter must have a maximum of at least 1 entry, received %d",
                            max_entries);
   }
+  return Status::OK();
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<BloomFilter>> BloomFilter::FromProto(const XXHash64BloomFilterPB& pb) {
+  if (pb.num_hashes() == SplitBlockBloomFilter::kProtoNumHashes) {
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<BloomFilter> bf, SplitBlockBloomFilter::FromProto(pb));
+    return bf;
+  }
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<BloomFilter> bf, XXHash64BloomFilter::FromProto(pb));
+  return bf;
+}
 
-  // From Wikipedia: https://en.wikipedia.org/wiki/Bloom_filter
-  // bits per entry = ln(error_rate)/ln(2)^2
-  double bpe = -(std::log(error_rate) / std::pow(std::log(2), 2));
+StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::Create(int64_t max_entries,
+                                                                           double error_rate) {
+  PL_RETURN_IF_ERROR(CheckFilterParams(max_entries, error_rate));
+
+  double bpe = BitsPerEntry(error_rate);
   int64_t num_bits = static_cast<int64_t>(std::ceil(max_entries * bpe));
   int64_t num_bytes = (num_bits / 8) + ((num_bits % 8) ? 1 : 0);
 
@@ -64,12 +88,16 @@ StatusOr<std::unique_ptr<XXHash64BloomFilter>> XXHash64BloomFilter::FromProto(
   if (!pb.num_hashes()) {
     return error::Internal("Received 0 hash functions in BloomFilter num_hashes field");
   }
+  if (pb.num_hashes() < 0) {
+    return error::Internal("BloomFilter proto has the split block layout, num_hashes=$0",
+                           pb.num_hashes());
+  }
 
   std::vector<uint8_t> data{bytes_str.begin(), bytes_str.end()};
   return std::unique_ptr<XXHash64BloomFilter>(new XXHash64BloomFilter(data, pb.num_hashes()));
 }
 
-XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() {
+XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() const {
   XXHash64BloomFilterPB output;
   output.set_num_hashes(num_hashes_);
   std::string bytes_str{buffer_.begin(), buffer_.end()};
@@ -116,5 +144,80 @@ bool XXHash64BloomFilter::Contains(std::string_view item) const {
   return true;
 }
 
+StatusOr<std::unique_ptr<SplitBlockBloomFilter>> SplitBlockBloomFilter::Create(
+    int64_t max_entries, double error_rate) {
+  PL_RETURN_IF_ERROR(CheckFilterParams(max_entries, error_rate));
+
+  constexpr int64_t kBlockBits = kBlockBytes * 8;
+  int64_t num_bits = static_cast<int64_t>(std::ceil(max_entries * BitsPerEntry(error_rate)));
+  int64_t num_blocks = std::max<int64_t>(1, (num_bits + kBlockBits - 1) / kBlockBits);
+  return std::unique_ptr<SplitBlockBloomFilter>(new SplitBlockBloomFilter(num_blocks));
+}
+
+StatusOr<std::unique_ptr<SplitBlockBloomFilter>> SplitBlockBloomFilter::FromProto(
+    const XXHash64BloomFilterPB& pb) {
+  if (pb.num_hashes() != kProtoNumHashes) {
+    return error::Internal("BloomFilter proto doesn't have the split block layout, num_hashes=$0",
+                           pb.num_hashes());
+  }
+  const std::string& data = pb.data();
+  if (data.empty() || data.size() % kBlockBytes != 0) {
+    return error::Internal("Split block BloomFilter data has $0 bytes, not a multiple of $1",
+                           data.size(), kBlockBytes);
+  }
+  auto bf = std::unique_ptr<SplitBlockBloomFilter>(
+      new SplitBlockBloomFilter(data.size() / kBlockBytes));
+  std::memcpy(bf->blocks_.data(), data.data(), data.size());
+  return bf;
+}
+
+XXHash64BloomFilterPB SplitBlockBloomFilter::ToProto() const {
+  XXHash64BloomFilterPB output;
+  output.set_num_hashes(kProtoNumHashes);
+  output.set_data(reinterpret_cast<const char*>(blocks_.data()), buffer_size_bytes());
+  return output;
+}
+
+size_t SplitBlockBloomFilter::BlockIndex(uint64_t hash) const {
+  // Maps the upper 32 bits of the hash onto [0, num_blocks) without a division.
+  return ((hash >> 32) * blocks_.size()) >> 32;
+}
+
+void SplitBlockBloomFilter::BlockMasks(uint64_t hash, uint64_t masks[kWordsPerBlock]) {
+  // Odd constants that spread the lower 32 bits of the hash into one bit position per word, as
+  // in Parquet's split block bloom filter.
+  static constexpr uint32_t kSalts[kWordsPerBlock] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+                                                      0xa2b7289dU, 0x705495c7U, 0x2df1424bU,
+                                                      0x9efc4947U, 0x5c6bfb31U};
+  const uint32_t key = static_cast<uint32_t>(hash);
+  for (int i = 0; i < kWordsPerBlock; ++i) {
+    // The top 6 bits of the product pick one of the 64 bits of the word.
+    masks[i] = uint64_t{1} << (static_cast<uint32_t>(key * kSalts[i]) >> 26);
+  }
+}
+
+void SplitBlockBloomFilter::Insert(std::string_view item) {
+  uint64_t hash = XXH64(item.data(), item.size(), kSeed);
+  uint64_t masks[kWordsPerBlock];
+  BlockMasks(hash, masks);
+  Block& block = blocks_[BlockIndex(hash)];
+  for (int i = 0; i < kWordsPerBlock; ++i) {
+    block.words[i] |= masks[i];
+  }
+}
+
+bool SplitBlockBloomFilter::Contains(std::string_view item) const {
+  uint64_t hash = XXH64(item.data(), item.size(), kSeed);
+  uint64_t masks[kWordsPerBlock];
+  BlockMasks(hash, masks);
+  const Block& block = blocks_[BlockIndex(hash)];
+  // Accumulate the missing bits of all the words, rather than returning at the first one.
+  uint64_t missing = 0;
+  for (int i = 0; i < kWordsPerBlock; ++i) {
+    missing |= masks[i] & ~block.words[i];
+  }
+  return missing == 0;
+}
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -31,7 +31,25 @@ namespace bloomfilter {
 
 using XXHash64BloomFilterPB = shared::bloomfilterpb::XXHash64BloomFilter;
 
-class XXHash64BloomFilter {
+/**
+ * The interface of the bloom filter layouts that serialize to XXHash64BloomFilterPB.
+ */
+class BloomFilter {
+ public:
+  virtual ~BloomFilter() = default;
+
+  /**
+   * FromProto creates a filter of the layout that the proto was serialized from.
+   */
+  static StatusOr<std::unique_ptr<BloomFilter>> FromProto(const XXHash64BloomFilterPB& pb);
+  virtual XXHash64BloomFilterPB ToProto() const = 0;
+
+  virtual void Insert(std::string_view item) = 0;
+  virtual bool Contains(std::string_view item) const = 0;
+  virtual size_t buffer_size_bytes() const = 0;
+};
+
+class XXHash64BloomFilter : public BloomFilter {
  public:
   /**
    * Create creates a bloom filter which is sized to meet the criteria for maximum number of
@@ -40,25 +58,25 @@ class XXHash64BloomFilter {
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> Create(int64_t max_entries,
                                                                double error_rate);
   static StatusOr<std::unique_ptr<XXHash64BloomFilter>> FromProto(const XXHash64BloomFilterPB& pb);
-  XXHash64BloomFilterPB ToProto();
+  XXHash64BloomFilterPB ToProto() const override;
 
   /**
    * Insert inserts an item into the bloom filter.
    */
-  void Insert(std::string_view item);
+  void Insert(std::string_view item) override;
   void Insert(const std::string& item) { return Insert(std::string_view(item)); }
 
   /**
    * Contains checks for the presence of an item in the bloom filter. May return a false positive,
    * but will not return a false negative.
    */
-  bool Contains(std::string_view item) const;
+  bool Contains(std::string_view item) const override;
   bool Contains(const std::string& item) const { return Contains(std::string_view(item)); }
 
   /**
    * Get the buffer size in bytes of the bloom filter.
    */
-  size_t buffer_size_bytes() const { return buffer_.size(); }
+  size_t buffer_size_bytes() const override { return buffer_.size(); }
 
   /**
    * Get the number of hashes used in the bloom filter.
@@ -81,5 +99,52 @@ class XXHash64BloomFilter {
   const uint64_t seed_ = 3091990;
 };
 
+/**
+ * SplitBlockBloomFilter is a bloom filter where all the bits of an item are in one 64-byte
+ * block, so that Insert() and Contains() touch a single cache line. Each item sets one bit in
+ * each of the 8 words of its block, and Contains() tests the 8 words without branches, which the
+ * compiler vectorizes.
+ *
+ * For the same size, the false positive rate is a little higher than XXHash64BloomFilter's.
+ *
+ * It serializes to XXHash64BloomFilterPB with num_hashes set to kProtoNumHashes. Readers that
+ * predate this layout use no hashes for a negative num_hashes, so they treat the filter as
+ * containing everything, which is safe.
+ */
+class SplitBlockBloomFilter : public BloomFilter {
+ public:
+  static constexpr int kWordsPerBlock = 8;
+  static constexpr int kBlockBytes = kWordsPerBlock * sizeof(uint64_t);
+  static constexpr int32_t kProtoNumHashes = -kWordsPerBlock;
+
+  /**
+   * Create creates a bloom filter which is sized to meet the criteria for maximum number of
+   * entries and the false positive error rate. The false negative error rate is always 0.
+   */
+  static StatusOr<std::unique_ptr<SplitBlockBloomFilter>> Create(int64_t max_entries,
+                                                                 double error_rate);
+  static StatusOr<std::unique_ptr<SplitBlockBloomFilter>> FromProto(
+      const XXHash64BloomFilterPB& pb);
+  XXHash64BloomFilterPB ToProto() const override;
+
+  void Insert(std::string_view item) override;
+  bool Contains(std::string_view item) const override;
+  size_t buffer_size_bytes() const override { return blocks_.size() * kBlockBytes; }
+
+ private:
+  struct alignas(kBlockBytes) Block {
+    uint64_t words[kWordsPerBlock] = {};
+  };
+
+  explicit SplitBlockBloomFilter(size_t num_blocks) : blocks_(num_blocks) {}
+
+  // The block of the item, and the bit of the item in each of the block's words.
+  size_t BlockIndex(uint64_t hash) const;
+  static void BlockMasks(uint64_t hash, uint64_t masks[kWordsPerBlock]);
+
+  std::vector<Block> blocks_;
+  static constexpr uint64_t kSeed = 3091990;
+};
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -20,7 +20,9 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <map>
+#include <memory>
 #include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -30,53 +32,84 @@
 namespace px {
 namespace bloomfilter {
 
-class BloomFilterBenchmark : public benchmark::Fixture {
-  void SetUp(const ::benchmark::State& state) {
+// The inputs of the benchmarks, built the same way for each bloom filter layout so that the
+// layouts can be compared.
+template <typename TFilter>
+struct BloomFilterBenchmarkInputs {
+  explicit BloomFilterBenchmarkInputs(const benchmark::State& state) {
     auto num_items = state.range(0);
     auto error_rate = 1.0 / state.range(1);
     auto strlen = state.range(2);
-    insert_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
-    lookup_bf_ = XXHash64BloomFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
-    random_strs_.reserve(num_items);
+    insert_bf = TFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
+    lookup_bf = TFilter::Create(num_items * 2, error_rate).ConsumeValueOrDie();
+    random_strs.reserve(num_items);
+    miss_strs.reserve(num_items);
     for (auto i = 0; i < num_items; ++i) {
-      random_strs_.push_back(datagen::RandomString(strlen));
-      lookup_bf_->Insert(random_strs_[i]);
+      random_strs.push_back(datagen::RandomString(strlen));
+      miss_strs.push_back(datagen::RandomString(strlen));
+      lookup_bf->Insert(random_strs[i]);
     }
   }
 
- protected:
-  std::vector<std::string> random_strs_;
-  std::unique_ptr<XXHash64BloomFilter> insert_bf_;
-  std::unique_ptr<XXHash64BloomFilter> lookup_bf_;
+  std::vector<std::string> random_strs;
+  // Strings that were not inserted into lookup_bf, so nearly all of them are misses.
+  std::vector<std::string> miss_strs;
+  std::unique_ptr<TFilter> insert_bf;
+  std::unique_ptr<TFilter> lookup_bf;
 };
 
 // NOLINTNEXTLINE : runtime/references.
-BENCHMARK_DEFINE_F(BloomFilterBenchmark, InsertTest)(benchmark::State& state) {
+template <typename TFilter>
+void BM_Insert(benchmark::State& state) {
+  BloomFilterBenchmarkInputs<TFilter> inputs(state);
   for (auto _ : state) {
-    for (const auto& random_str : random_strs_) {
-      insert_bf_->Insert(random_str);
+    for (const auto& random_str : inputs.random_strs) {
+      inputs.insert_bf->Insert(random_str);
     }
   }
-  state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
-  state.SetItemsProcessed(state.iterations() * random_strs_.size());
+  state.SetBytesProcessed(state.iterations() * inputs.random_strs.size() *
+                          inputs.random_strs[0].size());
+  state.SetItemsProcessed(state.iterations() * inputs.random_strs.size());
 }
 
 // NOLINTNEXTLINE : runtime/references.
-BENCHMARK_DEFINE_F(BloomFilterBenchmark, LookupTest)(benchmark::State& state) {
-  bool result = false;
+template <typename TFilter>
+void BM_Lookup(benchmark::State& state) {
+  BloomFilterBenchmarkInputs<TFilter> inputs(state);
   for (auto _ : state) {
-    for (const auto& random_str : random_strs_) {
-      result = lookup_bf_->Contains(random_str);
+    for (const auto& random_str : inputs.random_strs) {
+      benchmark::DoNotOptimize(inputs.lookup_bf->Contains(random_str));
     }
   }
-  PL_UNUSED(result);
-  state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
-  state.SetItemsProcessed(state.iterations() * random_strs_.size());
+  state.SetBytesProcessed(state.iterations() * inputs.random_strs.size() *
+                          inputs.random_strs[0].size());
+  state.SetItemsProcessed(state.iterations() * inputs.random_strs.size());
 }
 
-BENCHMARK_REGISTER_F(BloomFilterBenchmark, InsertTest)
+// Lookups of items that are not in the filter, which is the common case when filtering agents.
+// NOLINTNEXTLINE : runtime/references.
+template <typename TFilter>
+void BM_LookupMiss(benchmark::State& state) {
+  BloomFilterBenchmarkInputs<TFilter> inputs(state);
+  for (auto _ : state) {
+    for (const auto& miss_str : inputs.miss_strs) {
+      benchmark::DoNotOptimize(inputs.lookup_bf->Contains(miss_str));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.miss_strs.size());
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, XXHash64BloomFilter)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_TEMPLATE(BM_Insert, SplitBlockBloomFilter)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_TEMPLATE(BM_Lookup, XXHash64BloomFilter)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_TEMPLATE(BM_Lookup, SplitBlockBloomFilter)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_TEMPLATE(BM_LookupMiss, XXHash64BloomFilter)
     ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
-BENCHMARK_REGISTER_F(BloomFilterBenchmark, LookupTest)
+BENCHMARK_TEMPLATE(BM_LookupMiss, SplitBlockBloomFilter)
     ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
 
 }  // namespace bloomfilter
@@ -18,6 +18,11 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
 #include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
@@ -113,5 +118,81 @@ TEST(XXHash64BloomFilter, test_create_from_proto) {
   }
 }
 
+TEST(SplitBlockBloomFilter, test_create) {
+  auto bf1 = SplitBlockBloomFilter::Create(10, 0.1).ConsumeValueOrDie();
+  EXPECT_EQ(bf1->buffer_size_bytes(), 64);
+
+  auto bf2 = SplitBlockBloomFilter::Create(100000, 0.01).ConsumeValueOrDie();
+  EXPECT_EQ(bf2->buffer_size_bytes(), 119872);
+
+  EXPECT_FALSE(SplitBlockBloomFilter::Create(0, 0.1).ok());
+  EXPECT_FALSE(SplitBlockBloomFilter::Create(10, 1.0).ok());
+}
+
+TEST(SplitBlockBloomFilter, test_contains) {
+  auto bf = SplitBlockBloomFilter::Create(10, 0.1).ConsumeValueOrDie();
+  EXPECT_FALSE(bf->Contains("foo"));
+  EXPECT_FALSE(bf->Contains("bar"));
+  bf->Insert("foo");
+  bf->Insert("bar");
+  EXPECT_TRUE(bf->Contains("foo"));
+  EXPECT_TRUE(bf->Contains("bar"));
+  EXPECT_FALSE(bf->Contains("not_present"));
+  EXPECT_FALSE(bf->Contains(""));
+}
+
+TEST(SplitBlockBloomFilter, test_error_rate) {
+  constexpr int kNumEntries = 10000;
+  auto bf = SplitBlockBloomFilter::Create(kNumEntries, 0.01).ConsumeValueOrDie();
+  for (int i = 0; i < kNumEntries; ++i) {
+    bf->Insert(absl::StrCat("entry", i));
+  }
+  for (int i = 0; i < kNumEntries; ++i) {
+    EXPECT_TRUE(bf->Contains(absl::StrCat("entry", i)));
+  }
+  int false_positives = 0;
+  for (int i = 0; i < kNumEntries; ++i) {
+    false_positives += bf->Contains(absl::StrCat("other", i));
+  }
+  // The layout trades a slightly higher false positive rate for a single cache miss per lookup.
+  EXPECT_LT(false_positives, kNumEntries * 0.02);
+}
+
+TEST(SplitBlockBloomFilter, test_create_from_proto) {
+  std::vector<std::string> matches{"foo", "bar", "abc"};
+  std::vector<std::string> non_matches{"123", "456", "789"};
+
+  auto bf = SplitBlockBloomFilter::Create(100000, 0.01).ConsumeValueOrDie();
+  for (const auto& match : matches) {
+    bf->Insert(match);
+  }
+
+  auto proto = bf->ToProto();
+  EXPECT_EQ(proto.num_hashes(), SplitBlockBloomFilter::kProtoNumHashes);
+  EXPECT_FALSE(XXHash64BloomFilter::FromProto(proto).ok());
+
+  auto reconstructed = BloomFilter::FromProto(proto).ConsumeValueOrDie();
+  EXPECT_EQ(reconstructed->buffer_size_bytes(), 119872);
+  for (const auto& match : matches) {
+    EXPECT_TRUE(reconstructed->Contains(match));
+  }
+  for (const auto& non_match : non_matches) {
+    EXPECT_FALSE(reconstructed->Contains(non_match));
+  }
+}
+
+TEST(BloomFilter, from_proto_reads_both_layouts) {
+  auto xxhash_bf = XXHash64BloomFilter::Create(100, 0.01).ConsumeValueOrDie();
+  xxhash_bf->Insert("foo");
+  auto bf = BloomFilter::FromProto(xxhash_bf->ToProto()).ConsumeValueOrDie();
+  EXPECT_NE(dynamic_cast<XXHash64BloomFilter*>(bf.get()), nullptr);
+  EXPECT_TRUE(bf->Contains("foo"));
+
+  XXHash64BloomFilterPB bad_size;
+  bad_size.set_num_hashes(SplitBlockBloomFilter::kProtoNumHashes);
+  bad_size.set_data("abc");
+  EXPECT_FALSE(BloomFilter::FromProto(bad_size).ok());
+}
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -22,6 +22,9 @@
 #include <string>
 #include <vector>
 
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
 #include "src/common/base/base.h"
 #include "src/common/base/file.h"
 #include "src/common/fs/fs_wrapper.h"
@@ -114,6 +117,7 @@ void CGroupMetadataReader::InitPathTemplates(std::string_view sysfs_path) {
 CGroupMetadataReader::CGroupMetadataReader(const system::Config& cfg)
     : ns_per_kernel_tick_(static_cast<int64_t>(1E9 / cfg.KernelTicksPerSecond())),
       clock_realtime_offset_(cfg.ClockRealTimeOffset()) {
+  proc_path_ = cfg.proc_path().string();
   const std::string sysfs_path_str = cfg.sysfs_path().string();
   InitPathTemplates(sysfs_path_str);
 }
@@ -196,5 +200,49 @@ Status CGroupMetadataReader::ReadPIDs(PodQOSClass qos_class, std::string_view po
   return Status::OK();
 }
 
+std::string_view CGroupMetadataReader::ContainerIDFromCGroupPath(std::string_view cgroup_path) {
+  // Container IDs are 64 hex characters.
+  constexpr size_t kContainerIDLength = 64;
+
+  // The container cgroup is the last path component, and carries the container ID with one of the
+  // decorations from the naming schemes documented above: <id>, <runtime>-<id>.scope or
+  // <pod slice>:<runtime>:<id>.
+  std::string_view dir = cgroup_path.substr(cgroup_path.find_last_of('/') + 1);
+  absl::ConsumeSuffix(&dir, ".scope");
+  size_t pos = dir.find_last_of("-:");
+  if (pos != std::string_view::npos) {
+    dir.remove_prefix(pos + 1);
+  }
+
+  if (dir.size() != kContainerIDLength ||
+      !std::all_of(dir.begin(), dir.end(), [](char c) { return absl::ascii_isxdigit(c); })) {
+    return {};
+  }
+  return dir;
+}
+
+StatusOr<std::string> CGroupMetadataReader::ReadContainerID(uint32_t pid) const {
+  // Each line has the format <hierarchy-id>:<controllers>:<cgroup path>.
+  auto fpath = absl::Substitute("$0/$1/cgroup", proc_path_, pid);
+  std::ifstream ifs(fpath);
+  if (!ifs) {
+    // The process has likely exited.
+    return error::NotFound("Failed to open file $0", fpath);
+  }
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, absl::MaxSplits(':', 2));
+    if (fields.size() != 3) {
+      continue;
+    }
+    std::string_view cid = ContainerIDFromCGroupPath(fields[2]);
+    if (!cid.empty()) {
+      return std::string(cid);
+    }
+  }
+  return error::NotFound("PID $0 does not belong to a container", pid);
+}
+
 }  // namespace md
 }  // namespace px
@@ -53,6 +53,13 @@ class CGroupMetadataReader : public NotCopyable {
                           std::string_view container_id, ContainerType container_type,
                           absl::flat_hash_set<uint32_t>* pid_set) const;
 
+  /**
+   * ReadContainerID resolves the container that a process runs in from /proc/<pid>/cgroup.
+   *
+   * Returns NotFound if the process has exited or does not run in a container cgroup.
+   */
+  virtual StatusOr<std::string> ReadContainerID(uint32_t pid) const;
+
  private:
   void InitPathTemplates(std::string_view sysfs_path);
 
@@ -61,12 +68,15 @@ class CGroupMetadataReader : public NotCopyable {
   std::string CGroupProcFilePath(PodQOSClass qos_class, std::string_view pod_id,
                                  std::string_view container_id, ContainerType container_type) const;
 
+  static std::string_view ContainerIDFromCGroupPath(std::string_view cgroup_path);
+
   std::string cgroup_kubepod_guaranteed_path_template_;
   std::string cgroup_kubepod_besteffort_path_template_;
   std::string cgroup_kubepod_burstable_path_template_;
   std::string container_template_;
   bool cgroup_kubepod_convert_dashes_;
 
+  std::string proc_path_;
   std::string proc_stat_path_template_;
   std::string proc_cmdline_path_template_;
 
@@ -76,6 +86,7 @@ class CGroupMetadataReader : public NotCopyable {
   FRIEND_TEST(CGroupMetadataReaderTest, cgroup_pod_dir_path);
   FRIEND_TEST(CGroupMetadataReaderTest, cgroup_proc_file_path);
   FRIEND_TEST(CGroupMetadataReaderTest, cgroup_proc_file_path_alternate);
+  FRIEND_TEST(CGroupMetadataReaderTest, container_id_from_cgroup_path);
 };
 
 }  // namespace md
@@ -183,5 +183,40 @@ TEST_F(CGroupMetadataReaderTest, read_pid_list_alternate) {
   EXPECT_THAT(pid_set, ::testing::UnorderedElementsAre(123, 456, 789));
 }
 
+TEST_F(CGroupMetadataReaderTest, container_id_from_cgroup_path) {
+  constexpr std::string_view kCID =
+      "2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc392e7c640";
+
+  EXPECT_EQ(kCID, CGroupMetadataReader::ContainerIDFromCGroupPath(
+                      "/kubepods/besteffort/pod15b6301f-94d0-44ac-a2a8-6816c7a3fa32/"
+                      "2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc392e7c640"));
+  EXPECT_EQ(kCID, CGroupMetadataReader::ContainerIDFromCGroupPath(
+                      "/kubepods.slice/kubepods-pod8dbc5577_d0e2_4706_8787_57d52c03ddf2.slice/"
+                      "crio-2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc392e7c640"
+                      ".scope"));
+  EXPECT_EQ(kCID, CGroupMetadataReader::ContainerIDFromCGroupPath(
+                      "/system.slice/containerd.service/"
+                      "kubepods-besteffort-pod1544eb37_e4f7_49eb_8cc4_3d01c41be77b.slice:"
+                      "cri-containerd:"
+                      "2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc392e7c640"));
+
+  EXPECT_EQ("", CGroupMetadataReader::ContainerIDFromCGroupPath("/"));
+  EXPECT_EQ("", CGroupMetadataReader::ContainerIDFromCGroupPath(
+                    "/user.slice/user-1000.slice/session-2.scope"));
+  EXPECT_EQ("", CGroupMetadataReader::ContainerIDFromCGroupPath(
+                    "/kubepods/besteffort/pod15b6301f-94d0-44ac-a2a8-6816c7a3fa32"));
+}
+
+TEST_F(CGroupMetadataReaderTest, read_container_id) {
+  ASSERT_OK_AND_ASSIGN(std::string cid, md_reader_->ReadContainerID(32391));
+  EXPECT_EQ("2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc392e7c640", cid);
+
+  // Not running in a container.
+  EXPECT_NOT_OK(md_reader_->ReadContainerID(79690));
+
+  // No such process.
+  EXPECT_NOT_OK(md_reader_->ReadContainerID(1));
+}
+
 }  // namespace md
 }  // namespace px
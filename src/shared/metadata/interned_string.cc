@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+#include "src/shared/metadata/interned_string.h"
+
+namespace px {
+namespace md {
+
+namespace {
+
+/**
+ * The process-wide pool of interned strings. The pool only holds weak references, so that the
+ * strings are released once no InternedString refers to them anymore.
+ */
+class StringPool : public NotCopyable {
+ public:
+  static StringPool& GetInstance() {
+    static StringPool* pool = new StringPool();
+    return *pool;
+  }
+
+  std::shared_ptr<const std::string> Intern(std::string_view str) {
+    std::lock_guard<std::mutex> lock(strings_lock_);
+    auto it = strings_.find(str);
+    if (it != strings_.end()) {
+      std::shared_ptr<const std::string> interned = it->second.lock();
+      if (interned != nullptr) {
+        return interned;
+      }
+      // The string is being released, but its deleter hasn't removed the entry yet. The key
+      // refers to the released string, so the entry has to be replaced rather than updated.
+      strings_.erase(it);
+    }
+
+    auto* owned = new std::string(str);
+    std::shared_ptr<const std::string> interned(owned,
+                                                [this](const std::string* s) { Release(s); });
+    strings_.try_emplace(*owned, interned);
+    return interned;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(strings_lock_);
+    return strings_.size();
+  }
+
+ private:
+  void Release(const std::string* str) {
+    {
+      std::lock_guard<std::mutex> lock(strings_lock_);
+      auto it = strings_.find(*str);
+      // The entry may already belong to a string that was interned again after this one expired.
+      if (it != strings_.end() && it->first.data() == str->data()) {
+        strings_.erase(it);
+      }
+    }
+    delete str;
+  }
+
+  std::mutex strings_lock_;
+  // Keyed by views into the interned strings.
+  absl::flat_hash_map<std::string_view, std::weak_ptr<const std::string>> strings_;
+};
+
+// The empty string is the most common value, and is shared without going through the pool.
+const std::shared_ptr<const std::string>& EmptyString() {
+  static auto* empty = new std::shared_ptr<const std::string>(std::make_shared<std::string>());
+  return *empty;
+}
+
+}  // namespace
+
+InternedString::InternedString() : str_(EmptyString()) {}
+
+InternedString::InternedString(std::string_view str)
+    : str_(str.empty() ? EmptyString() : StringPool::GetInstance().Intern(str)) {}
+
+size_t InternedString::NumInterned() { return StringPool::GetInstance().size(); }
+
+}  // namespace md
+}  // namespace px
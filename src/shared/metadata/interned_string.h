@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace md {
+
+/**
+ * InternedString is an immutable string that shares its storage with every other InternedString
+ * of the same value.
+ *
+ * K8s metadata repeats a small set of values, such as namespaces, node names and status messages,
+ * across all the objects of a cluster, and is replicated into every agent. Interning these values
+ * keeps a single copy of each of them per process. Copying an InternedString does not copy the
+ * string, and the storage is released with the last InternedString that refers to it.
+ */
+class InternedString {
+ public:
+  InternedString();
+  explicit InternedString(std::string_view str);
+
+  const std::string& str() const { return *str_; }
+
+  bool operator==(const InternedString& other) const { return str_ == other.str_; }
+  bool operator!=(const InternedString& other) const { return str_ != other.str_; }
+
+  /**
+   * Returns the number of distinct non-empty strings that are currently interned.
+   */
+  static size_t NumInterned();
+
+ private:
+  std::shared_ptr<const std::string> str_;
+};
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <optional>
+
+#include "src/shared/metadata/interned_string.h"
+
+namespace px {
+namespace md {
+
+TEST(InternedString, shares_storage) {
+  InternedString a("kube-system");
+  InternedString b(std::string("kube-") + "system");
+  InternedString c("default");
+
+  EXPECT_EQ("kube-system", a.str());
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.str().data(), b.str().data());
+  EXPECT_NE(a, c);
+  EXPECT_EQ("default", c.str());
+}
+
+TEST(InternedString, empty) {
+  size_t num_interned = InternedString::NumInterned();
+  InternedString a;
+  InternedString b("");
+
+  EXPECT_EQ("", a.str());
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(num_interned, InternedString::NumInterned());
+}
+
+TEST(InternedString, released_with_last_reference) {
+  size_t num_interned = InternedString::NumInterned();
+
+  std::optional<InternedString> a(InternedString("node-1"));
+  std::optional<InternedString> b = a;
+  EXPECT_EQ(num_interned + 1, InternedString::NumInterned());
+
+  a.reset();
+  EXPECT_EQ(num_interned + 1, InternedString::NumInterned());
+  EXPECT_EQ("node-1", b->str());
+
+  b.reset();
+  EXPECT_EQ(num_interned, InternedString::NumInterned());
+
+  // Interning the value again after it was released.
+  InternedString c("node-1");
+  EXPECT_EQ("node-1", c.str());
+  EXPECT_EQ(num_interned + 1, InternedString::NumInterned());
+}
+
+}  // namespace md
+}  // namespace px
@@ -26,6 +26,7 @@
 #include <absl/container/flat_hash_set.h>
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/interned_string.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
@@ -58,7 +59,7 @@ class K8sMetadataObject {
   const UID& uid() const { return uid_; }
 
   const std::string& name() const { return name_; }
-  const std::string& ns() const { return ns_; }
+  const std::string& ns() const { return ns_.str(); }
 
   int64_t start_time_ns() const { return start_time_ns_; }
   void set_start_time_ns(int64_t start_time_ns) { start_time_ns_ = start_time_ns; }
@@ -85,10 +86,9 @@ class K8sMetadataObject {
   const UID uid_ = 0;
 
   /**
-   * The namespace for this object.
+   * The namespace for this object. Interned, since it's shared by all objects in the namespace.
    */
-
-  std::string ns_;
+  InternedString ns_;
 
   /**
    * The name which is unique in space but not time.
@@ -272,17 +272,21 @@ class PodInfo : public K8sMetadataObject {
   PodConditions conditions() const { return conditions_; }
   void set_conditions(PodConditions conditions) { conditions_ = conditions; }
 
-  const std::string& phase_message() const { return phase_message_; }
-  void set_phase_message(std::string_view phase_message) { phase_message_ = phase_message; }
+  const std::string& phase_message() const { return phase_message_.str(); }
+  void set_phase_message(std::string_view phase_message) {
+    phase_message_ = InternedString(phase_message);
+  }
 
-  const std::string& phase_reason() const { return phase_reason_; }
-  void set_phase_reason(std::string_view phase_reason) { phase_reason_ = phase_reason; }
+  const std::string& phase_reason() const { return phase_reason_.str(); }
+  void set_phase_reason(std::string_view phase_reason) {
+    phase_reason_ = InternedString(phase_reason);
+  }
 
-  void set_node_name(std::string_view node_name) { node_name_ = node_name; }
-  void set_hostname(std::string_view hostname) { hostname_ = hostname; }
+  void set_node_name(std::string_view node_name) { node_name_ = InternedString(node_name); }
+  void set_hostname(std::string_view hostname) { hostname_ = InternedString(hostname); }
   void set_pod_ip(std::string_view pod_ip) { pod_ip_ = pod_ip; }
-  const std::string& node_name() const { return node_name_; }
-  const std::string& hostname() const { return hostname_; }
+  const std::string& node_name() const { return node_name_.str(); }
+  const std::string& hostname() const { return hostname_.str(); }
   const std::string& pod_ip() const { return pod_ip_; }
 
   const absl::flat_hash_set<std::string>& containers() const { return containers_; }
@@ -303,9 +307,9 @@ class PodInfo : public K8sMetadataObject {
   PodPhase phase_;
   PodConditions conditions_;
   // The message for why the pod is in its current status.
-  std::string phase_message_;
+  InternedString phase_message_;
   // A brief CamelCase message indicating details about why the pod is in this state.
-  std::string phase_reason_;
+  InternedString phase_reason_;
   /**
    * Set of containers that are running on this pod.
    *
@@ -320,8 +324,9 @@ class PodInfo : public K8sMetadataObject {
    */
   absl::flat_hash_set<UID> services_;
 
-  std::string node_name_;
-  std::string hostname_;
+  // The node and host names are shared by all pods on a node.
+  InternedString node_name_;
+  InternedString hostname_;
   std::string pod_ip_;
 };
 
@@ -338,7 +343,7 @@ class ContainerInfo {
                 std::string_view state_message, std::string_view state_reason,
                 int64_t start_time_ns, int64_t stop_time_ns = 0)
       : cid_(std::move(cid)),
-        name_(std::string(name)),
+        name_(name),
         state_(state),
         type_(type),
         state_message_(state_message),
@@ -355,7 +360,7 @@ class ContainerInfo {
                       container_update_info.stop_timestamp_ns()) {}
 
   const CID& cid() const { return cid_; }
-  const std::string& name() const { return name_; }
+  const std::string& name() const { return name_.str(); }
   ContainerType type() const { return type_; }
 
   void set_pod_id(std::string_view pod_id) { pod_id_ = pod_id; }
@@ -372,11 +377,15 @@ class ContainerInfo {
   ContainerState state() const { return state_; }
   void set_state(ContainerState state) { state_ = state; }
 
-  const std::string& state_message() const { return state_message_; }
-  void set_state_message(std::string_view state_message) { state_message_ = state_message; }
+  const std::string& state_message() const { return state_message_.str(); }
+  void set_state_message(std::string_view state_message) {
+    state_message_ = InternedString(state_message);
+  }
 
-  const std::string& state_reason() const { return state_reason_; }
-  void set_state_reason(std::string_view state_reason) { state_reason_ = state_reason; }
+  const std::string& state_reason() const { return state_reason_.str(); }
+  void set_state_reason(std::string_view state_reason) {
+    state_reason_ = InternedString(state_reason);
+  }
 
   std::unique_ptr<ContainerInfo> Clone() const {
     return std::unique_ptr<ContainerInfo>(new ContainerInfo(*this));
@@ -390,7 +399,8 @@ class ContainerInfo {
 
  private:
   const CID cid_;
-  const std::string name_;
+  // Interned, since the same container names are used by all the replicas of a pod.
+  const InternedString name_;
   UID pod_id_ = "";
 
   /**
@@ -407,9 +417,9 @@ class ContainerInfo {
    */
   ContainerType type_;
   // The message for why the container is in its current state.
-  std::string state_message_;
+  InternedString state_message_;
   // A more detailed message for why the container is in its current state.
-  std::string state_reason_;
+  InternedString state_reason_;
 
   /**
    * Start time of this K8s object.
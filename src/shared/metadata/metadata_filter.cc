@@ -47,11 +47,18 @@ std::string ToEntityKeyPair(MetadataType type, std::string_view entity) {
 }
 
 Status AgentMetadataFilter::InsertEntity(MetadataType key, std::string_view value) {
-  epoch_id_++;
   if (!metadata_types_.contains(key)) {
     return error::Internal("Metadata type $0 is not registered in AgentMetadataFilter.", key);
   }
-  Insert(ToEntityKeyPair(key, value));
+  std::string entity = ToEntityKeyPair(key, value);
+  // Entities are re-inserted on every update of the object they belong to. If the filter already
+  // contains the entity, inserting it again doesn't change the filter, so keep the epoch to avoid
+  // resending the filter on the next heartbeat.
+  if (Contains(entity)) {
+    return Status::OK();
+  }
+  epoch_id_++;
+  Insert(entity);
   return Status::OK();
 }
 
@@ -85,7 +92,7 @@ MetadataInfo AgentMetadataFilterImpl::ToProtoImpl() const {
 StatusOr<std::unique_ptr<AgentMetadataFilter>> AgentMetadataFilterImpl::FromProto(
     const MetadataInfo& proto) {
   DCHECK_EQ(proto.filter_case(), MetadataInfo::FilterCase::kXxhash64BloomFilter);
-  PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::FromProto(proto.xxhash64_bloom_filter()));
+  PL_ASSIGN_OR_RETURN(auto bf, BloomFilter::FromProto(proto.xxhash64_bloom_filter()));
   absl::flat_hash_set<MetadataType> types;
   for (auto i = 0; i < proto.metadata_fields_size(); ++i) {
     types.insert(proto.metadata_fields(i));
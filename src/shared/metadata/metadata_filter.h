@@ -33,7 +33,8 @@
 namespace px {
 namespace md {
 
-using bloomfilter::XXHash64BloomFilter;
+using bloomfilter::BloomFilter;
+using bloomfilter::SplitBlockBloomFilter;
 using carnot::planner::distributedpb::MetadataInfo;
 using shared::metadatapb::MetadataType;
 using shared::metadatapb::MetadataType_Name;
@@ -83,7 +84,7 @@ class AgentMetadataFilter {
    * Get the registered metadata keys that are stored in this filter.
    */
   absl::flat_hash_set<MetadataType> metadata_types() const { return metadata_types_; }
-  // Used to track changes in the filter.
+  // Used to track changes in the filter. Only changes when an insertion modifies the filter.
   int64_t epoch_id() const { return epoch_id_; }
 
  protected:
@@ -102,13 +103,16 @@ class AgentMetadataFilter {
 };
 
 /**
- * An implementation of AgentMetadataFilter backed by an XXHASH64-based bloom filter.
+ * An implementation of AgentMetadataFilter backed by an XXHASH64-based bloom filter. New filters
+ * use the split block layout, since the planner probes them for every agent and metadata value
+ * of a query. Filters of the older layout are still read from protos.
  */
 class AgentMetadataFilterImpl : public AgentMetadataFilter {
  public:
   static StatusOr<std::unique_ptr<AgentMetadataFilter>> Create(
       int64_t max_entries, double error_rate, const absl::flat_hash_set<MetadataType>& types) {
-    PL_ASSIGN_OR_RETURN(auto bf, XXHash64BloomFilter::Create(max_entries, error_rate));
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<BloomFilter> bf,
+                        SplitBlockBloomFilter::Create(max_entries, error_rate));
     return std::unique_ptr<AgentMetadataFilter>(new AgentMetadataFilterImpl(std::move(bf), types));
   }
 
@@ -120,11 +124,11 @@ class AgentMetadataFilterImpl : public AgentMetadataFilter {
   MetadataInfo ToProtoImpl() const override;
 
  private:
-  AgentMetadataFilterImpl(std::unique_ptr<XXHash64BloomFilter> bloomfilter,
+  AgentMetadataFilterImpl(std::unique_ptr<BloomFilter> bloomfilter,
                           const absl::flat_hash_set<MetadataType>& types)
       : AgentMetadataFilter(types), bloomfilter_(std::move(bloomfilter)) {}
 
-  std::unique_ptr<XXHash64BloomFilter> bloomfilter_;
+  std::unique_ptr<BloomFilter> bloomfilter_;
 };
 
 }  // namespace md
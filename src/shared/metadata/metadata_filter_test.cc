@@ -43,6 +43,24 @@ TEST(AgentMetadataFilter, test_basic) {
   EXPECT_NOT_OK(filter->InsertEntity(MetadataType::SERVICE_NAME, "abc"));
 }
 
+TEST(AgentMetadataFilter, epoch_id) {
+  auto filter =
+      AgentMetadataFilter::Create(100, 0.01, {MetadataType::POD_NAME}).ConsumeValueOrDie();
+  EXPECT_EQ(0, filter->epoch_id());
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_EQ(1, filter->epoch_id());
+
+  // Re-inserting an entity doesn't change the filter.
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "foo"));
+  EXPECT_EQ(1, filter->epoch_id());
+
+  EXPECT_NOT_OK(filter->InsertEntity(MetadataType::SERVICE_NAME, "abc"));
+  EXPECT_EQ(1, filter->epoch_id());
+
+  EXPECT_OK(filter->InsertEntity(MetadataType::POD_NAME, "bar"));
+  EXPECT_EQ(2, filter->epoch_id());
+}
+
 TEST(AgentMetadataFilter, test_proto) {
   auto filter =
       AgentMetadataFilter::Create(100, 0.01, {MetadataType::POD_NAME, MetadataType::CONTAINER_ID})
@@ -77,6 +77,16 @@ UID K8sMetadataState::PodIDByIP(std::string_view pod_ip) const {
   return (it == pods_by_ip_.end()) ? "" : it->second;
 }
 
+ContainerInfo* K8sMetadataState::MutableContainerInfoByID(CIDView id) {
+  auto it = containers_by_id_.find(id);
+
+  if (it == containers_by_id_.end()) {
+    return nullptr;
+  }
+
+  return MutableObject(&it->second);
+}
+
 CID K8sMetadataState::ContainerIDByName(std::string_view container_name) const {
   auto it = containers_by_name_.find(container_name);
   return (it == containers_by_name_.end()) ? "" : it->second;
@@ -98,15 +108,9 @@ std::unique_ptr<K8sMetadataState> K8sMetadataState::Clone() const {
   other->pod_cidrs_ = pod_cidrs_;
   other->service_cidr_ = service_cidr_;
 
-  other->k8s_objects_by_id_.reserve(k8s_objects_by_id_.size());
-  for (const auto& [k, v] : k8s_objects_by_id_) {
-    other->k8s_objects_by_id_[k] = v->Clone();
-  }
-
-  other->containers_by_id_.reserve(containers_by_id_.size());
-  for (const auto& [k, v] : containers_by_id_) {
-    other->containers_by_id_[k] = v->Clone();
-  }
+  // The objects are shared until they are updated in either state.
+  other->k8s_objects_by_id_ = k8s_objects_by_id_;
+  other->containers_by_id_ = containers_by_id_;
 
   other->pods_by_name_ = pods_by_name_;
   other->services_by_name_ = services_by_name_;
@@ -156,7 +160,7 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     VLOG(1) << "Adding Pod: " << pod->DebugString();
     it = k8s_objects_by_id_.try_emplace(object_uid, std::move(pod)).first;
   }
-  auto pod_info = static_cast<PodInfo*>(it->second.get());
+  auto pod_info = static_cast<PodInfo*>(MutableObject(&it->second));
 
   // We always just add to the container set even if the container is stopped.
   // We expect all cleanup to happen periodically to allow stale objects to be queried for some
@@ -174,7 +178,7 @@ Status K8sMetadataState::HandlePodUpdate(const PodUpdate& update) {
     }
 
     pod_info->AddContainer(cid);
-    containers_by_id_[cid]->set_pod_id(object_uid);
+    MutableContainerInfoByID(cid)->set_pod_id(object_uid);
   }
 
   pod_info->set_start_time_ns(update.start_timestamp_ns());
@@ -207,7 +211,7 @@ Status K8sMetadataState::HandleContainerUpdate(const ContainerUpdate& update) {
   }
   VLOG(1) << "container update: " << update.name();
 
-  auto* container_info = it->second.get();
+  auto* container_info = MutableObject(&it->second);
   container_info->set_stop_time_ns(update.stop_timestamp_ns());
   container_info->set_state(ConvertToContainerState(update.container_state()));
   container_info->set_state_message(update.message());
@@ -229,7 +233,7 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
     VLOG(1) << "Adding Service: " << service->DebugString();
     it = k8s_objects_by_id_.try_emplace(service_uid, std::move(service)).first;
   }
-  auto service_info = static_cast<ServiceInfo*>(it->second.get());
+  auto service_info = static_cast<ServiceInfo*>(MutableObject(&it->second));
 
   for (const auto& uid : update.pod_ids()) {
     if (k8s_objects_by_id_.find(uid) == k8s_objects_by_id_.end()) {
@@ -241,7 +245,7 @@ Status K8sMetadataState::HandleServiceUpdate(const ServiceUpdate& update) {
     }
     ECHECK(k8s_objects_by_id_[uid]->type() == K8sObjectType::kPod);
     // We add the service uid to the pod. Lifetime of service still handled by the service object.
-    PodInfo* pod_info = static_cast<PodInfo*>(k8s_objects_by_id_[uid].get());
+    PodInfo* pod_info = static_cast<PodInfo*>(MutableObject(&k8s_objects_by_id_[uid]));
     pod_info->AddService(service_uid);
   }
   service_info->set_start_time_ns(update.start_timestamp_ns());
@@ -264,7 +268,7 @@ Status K8sMetadataState::HandleNamespaceUpdate(const NamespaceUpdate& update) {
     VLOG(1) << "Adding Namespace: " << ns_obj->DebugString();
     it = k8s_objects_by_id_.try_emplace(namespace_uid, std::move(ns_obj)).first;
   }
-  auto ns_info = static_cast<NamespaceInfo*>(it->second.get());
+  auto ns_info = static_cast<NamespaceInfo*>(MutableObject(&it->second));
 
   ns_info->set_start_time_ns(update.start_timestamp_ns());
   ns_info->set_stop_time_ns(update.stop_timestamp_ns());
@@ -337,10 +341,7 @@ std::shared_ptr<AgentMetadataState> AgentMetadataState::CloneToShared() const {
   state->epoch_id_ = epoch_id_;
   state->asid_ = asid_;
   state->k8s_metadata_state_ = k8s_metadata_state_->Clone();
-  state->pids_by_upid_.reserve(pids_by_upid_.size());
-  for (const auto& [k, v] : pids_by_upid_) {
-    state->pids_by_upid_[k] = v->Clone();
-  }
+  state->pids_by_upid_ = pids_by_upid_;
   state->upids_ = upids_;
   return state;
 }
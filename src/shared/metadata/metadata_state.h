@@ -38,8 +38,29 @@ namespace md {
 using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
 using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
 using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+using K8sMetadataObjectSPtr = std::shared_ptr<K8sMetadataObject>;
+using ContainerInfoSPtr = std::shared_ptr<ContainerInfo>;
+using PIDInfoSPtr = std::shared_ptr<PIDInfo>;
 using AgentID = sole::uuid;
 
+/**
+ * The metadata objects of a state are shared with its clones, and are copied on write, so that
+ * cloning a state doesn't copy every object and an update only copies the objects it changes.
+ * MutableObject returns a mutable pointer to the object, after replacing it with a private copy if
+ * it's still shared with another state.
+ *
+ * This is safe because a state is only mutated before it's published: the count of an object
+ * can only drop concurrently (when an older state is released), which at worst causes an
+ * unnecessary copy.
+ */
+template <typename T>
+T* MutableObject(std::shared_ptr<T>* obj) {
+  if (obj->use_count() > 1) {
+    *obj = std::shared_ptr<T>((*obj)->Clone());
+  }
+  return obj->get();
+}
+
 /**
  * This class contains all kubernetes relate metadata.
  */
@@ -179,6 +200,10 @@ class K8sMetadataState : NotCopyable {
    */
   UID NamespaceIDByName(K8sNameIdentView namespace_name) const;
 
+  /**
+   * Clone returns a copy of this state, which shares the metadata objects with this state until
+   * they are updated. See MutableObject.
+   */
   std::unique_ptr<K8sMetadataState> Clone() const;
 
   Status HandlePodUpdate(const PodUpdate& update);
@@ -188,7 +213,15 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  absl::flat_hash_map<CID, ContainerInfoSPtr>& containers_by_id() { return containers_by_id_; }
+
+  /**
+   * MutableContainerInfoByID returns a mutable pointer to the container, which is first copied if
+   * it's shared with another state.
+   * @param id The ID of the container.
+   * @return ContainerInfo or nullptr if not found.
+   */
+  ContainerInfo* MutableContainerInfoByID(CIDView id);
   std::string DebugString(int indent_level = 0) const;
 
  private:
@@ -201,10 +234,10 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  absl::flat_hash_map<UID, K8sMetadataObjectSPtr> k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  absl::flat_hash_map<CID, ContainerInfoSPtr> containers_by_id_;
 
   /**
    * Mapping of pods by name.
@@ -262,6 +295,10 @@ class AgentMetadataState : NotCopyable {
   K8sMetadataState* k8s_metadata_state() { return k8s_metadata_state_.get(); }
   const K8sMetadataState& k8s_metadata_state() const { return *k8s_metadata_state_; }
 
+  /**
+   * CloneToShared returns a copy of this state, which shares the metadata objects with this state
+   * until they are updated. See MutableObject.
+   */
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
   PIDInfo* GetPIDByUPID(UPID upid) const {
@@ -281,16 +318,16 @@ class AgentMetadataState : NotCopyable {
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
-    if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
+    auto it = pids_by_upid_.find(upid);
+    if (it != pids_by_upid_.end()) {
+      MutableObject(&it->second)->set_stop_time_ns(ts);
       upids_.erase(upid);
     } else {
       DCHECK(!upids_.contains(upid));
     }
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const absl::flat_hash_map<UPID, PIDInfoSPtr>& pids_by_upid() const { return pids_by_upid_; }
 
   const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
 
@@ -320,7 +357,7 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  absl::flat_hash_map<UPID, PIDInfoSPtr> pids_by_upid_;
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
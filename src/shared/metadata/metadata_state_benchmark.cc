@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+#include <absl/strings/substitute.h>
+#include "src/common/benchmark/benchmark.h"
+#include "src/shared/metadata/metadata_state.h"
+
+// Counts the bytes that are currently allocated on the heap, to report the memory used by the
+// metadata state.
+static std::atomic<int64_t> heap_bytes{0};
+
+void* operator new(size_t size) {
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  heap_bytes += malloc_usable_size(p);
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  heap_bytes -= malloc_usable_size(p);
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+namespace px {
+namespace md {
+
+using ::px::shared::k8s::metadatapb::ContainerUpdate;
+using ::px::shared::k8s::metadatapb::PodUpdate;
+
+// Applies the updates of num_pods pods with two containers each, spread over 20 namespaces and
+// 100 nodes, which resembles a large cluster.
+void AddPods(int num_pods, K8sMetadataState* state) {
+  constexpr int kNumNamespaces = 20;
+  constexpr int kNumNodes = 100;
+
+  for (int i = 0; i < num_pods; ++i) {
+    PodUpdate pod_update;
+    pod_update.set_uid(absl::Substitute("5a1d1140-a486-478c-afae-$0", 100000000000 + i));
+    pod_update.set_name(absl::Substitute("frontend-deployment-6f5c9d7b8-$0", i));
+    pod_update.set_namespace_(absl::Substitute("namespace-$0", i % kNumNamespaces));
+    pod_update.set_node_name(absl::Substitute("gke-cluster-default-pool-node-$0", i % kNumNodes));
+    pod_update.set_hostname(absl::Substitute("gke-cluster-default-pool-node-$0", i % kNumNodes));
+    pod_update.set_pod_ip(absl::Substitute("10.$0.$1.$2", i / 65536, i / 256 % 256, i % 256));
+    pod_update.set_qos_class(px::shared::k8s::metadatapb::QOS_CLASS_BURSTABLE);
+    pod_update.set_phase(px::shared::k8s::metadatapb::RUNNING);
+
+    for (std::string_view name : {"server", "istio-proxy"}) {
+      ContainerUpdate container_update;
+      container_update.set_cid(absl::Substitute(
+          "2b41fe4bb7a365960f1e7ed6c09651252b29387b44c9e14ad17e3bc3$0$1", name.size(), i));
+      container_update.set_name(name);
+      container_update.set_container_state(
+          px::shared::k8s::metadatapb::CONTAINER_STATE_RUNNING);
+      container_update.set_container_type(px::shared::k8s::metadatapb::CONTAINER_TYPE_DOCKER);
+      PL_CHECK_OK(state->HandleContainerUpdate(container_update));
+      pod_update.add_container_ids(container_update.cid());
+    }
+    PL_CHECK_OK(state->HandlePodUpdate(pod_update));
+  }
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_K8sMetadataStateMemory(benchmark::State& state) {
+  int num_pods = state.range(0);
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    int64_t start_bytes = heap_bytes;
+    auto md_state = std::make_unique<K8sMetadataState>();
+    AddPods(num_pods, md_state.get());
+    bytes = heap_bytes - start_bytes;
+    benchmark::DoNotOptimize(md_state);
+  }
+  state.counters["bytes_per_pod"] = static_cast<double>(bytes) / num_pods;
+  state.counters["total_bytes"] = static_cast<double>(bytes);
+}
+
+BENCHMARK(BM_K8sMetadataStateMemory)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+}  // namespace md
+}  // namespace px
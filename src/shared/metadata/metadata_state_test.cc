@@ -20,6 +20,8 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
 #include "src/common/base/test_utils.h"
 #include "src/shared/metadata/metadata_state.h"
 
@@ -113,6 +115,38 @@ TEST(K8sMetadataStateTest, CloneCopiedCIDR) {
   EXPECT_EQ(service_cidr.prefix_length, state_copy->service_cidr()->prefix_length);
 }
 
+TEST(K8sMetadataStateTest, CloneSharesObjectsUntilUpdated) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update));
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update));
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  auto state_copy = state.Clone();
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+
+  // Updating the container in the copy copies it, and leaves the original (and the pod) as is.
+  container_update.set_stop_timestamp_ns(200);
+  EXPECT_OK(state_copy->HandleContainerUpdate(container_update));
+  EXPECT_NE(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+  EXPECT_EQ(102, state.ContainerInfoByID("container0_uid")->stop_time_ns());
+  EXPECT_EQ(200, state_copy->ContainerInfoByID("container0_uid")->stop_time_ns());
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+
+  // Objects that aren't shared anymore are updated in place.
+  const ContainerInfo* copied_container = state_copy->ContainerInfoByID("container0_uid");
+  container_update.set_stop_timestamp_ns(300);
+  EXPECT_OK(state_copy->HandleContainerUpdate(container_update));
+  EXPECT_EQ(copied_container, state_copy->ContainerInfoByID("container0_uid"));
+  EXPECT_EQ(300, copied_container->stop_time_ns());
+}
+
 TEST(K8sMetadataStateTest, HandleContainerUpdate) {
   K8sMetadataState state;
 
@@ -313,5 +347,21 @@ TEST(K8sMetadataStateTest, CleanupExpiredMetadata) {
   }
 }
 
+TEST(AgentMetadataStateTest, CloneToSharedCopiesPIDsOnWrite) {
+  AgentMetadataState state(/*asid*/ 1);
+  UPID upid(1, 123, 456);
+  state.AddUPID(upid, std::make_unique<PIDInfo>(upid, "cmdline", "container0_uid"));
+
+  auto state_copy = state.CloneToShared();
+  EXPECT_EQ(state.GetPIDByUPID(upid), state_copy->GetPIDByUPID(upid));
+
+  state_copy->MarkUPIDAsStopped(upid, 10);
+  EXPECT_NE(state.GetPIDByUPID(upid), state_copy->GetPIDByUPID(upid));
+  EXPECT_EQ(0, state.GetPIDByUPID(upid)->stop_time_ns());
+  EXPECT_EQ(10, state_copy->GetPIDByUPID(upid)->stop_time_ns());
+  EXPECT_TRUE(state.upids().contains(upid));
+  EXPECT_FALSE(state_copy->upids().contains(upid));
+}
+
 }  // namespace md
 }  // namespace px
@@ -16,7 +16,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -32,12 +34,33 @@ namespace md {
  */
 constexpr uint64_t kEpochsBetweenObjectDeletion = 100;
 
+/**
+ * kEpochsBetweenPIDReconciliation is the interval between when the cgroups of all containers are
+ * re-read, once PID changes are driven by notifications. This catches any missed notifications.
+ */
+constexpr uint64_t kEpochsBetweenPIDReconciliation = 12;
+
 /**
  * kMinObjectRetentionAfterDeathNS is the time in nanoseconds that the object is retained after
  * being deleted.
  */
 constexpr uint64_t kMinObjectRetentionAfterDeathNS = 24ULL * 3600ULL * 1'000'000'000ULL;
 
+namespace {
+
+template <typename T>
+std::vector<T> DrainQueue(moodycamel::BlockingConcurrentQueue<T>* queue) {
+  std::vector<T> items;
+  T item;
+  // Returns false when no more items.
+  while (queue->try_dequeue(item)) {
+    items.push_back(std::move(item));
+  }
+  return items;
+}
+
+}  // namespace
+
 std::shared_ptr<const AgentMetadataState>
 AgentMetadataStateManagerImpl::CurrentAgentMetadataState() {
   absl::base_internal::SpinLockHolder lock(&agent_metadata_state_lock_);
@@ -57,6 +80,15 @@ Status AgentMetadataStateManagerImpl::AddK8sUpdate(std::unique_ptr<ResourceUpdat
   return Status::OK();
 }
 
+Status AgentMetadataStateManagerImpl::AddK8sUpdates(
+    std::vector<std::unique_ptr<ResourceUpdate>> updates) {
+  // Bulk enqueues aren't atomic with respect to the consumer, so the lock keeps a state update from
+  // draining part of the batch.
+  std::lock_guard<std::mutex> lock(incoming_k8s_updates_lock_);
+  incoming_k8s_updates_.enqueue_bulk(std::make_move_iterator(updates.begin()), updates.size());
+  return Status::OK();
+}
+
 Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   // There should never be more than one update, but this just here for safety.
   std::lock_guard<std::mutex> state_update_lock(metadata_state_update_lock_);
@@ -74,7 +106,8 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   std::shared_ptr<AgentMetadataState> shadow_state;
   {
     absl::base_internal::SpinLockHolder lock(&agent_metadata_state_lock_);
-    // Copy the current state into the shadow state.
+    // Copy the current state into the shadow state. The metadata objects are shared with the
+    // current state, and only the ones that get updated are copied.
     shadow_state = agent_metadata_state_->CloneToShared();
     epoch_id = agent_metadata_state_->epoch_id();
   }
@@ -85,13 +118,29 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   // Get timestamp so all updates happen at the same timestamp.
   // TODO(zasgar): Change this to an injected clock.
   int64_t ts = CurrentTimeNS();
+  std::vector<std::unique_ptr<ResourceUpdate>> k8s_updates;
+  {
+    std::lock_guard<std::mutex> lock(incoming_k8s_updates_lock_);
+    k8s_updates = DrainQueue(&incoming_k8s_updates_);
+  }
   PL_RETURN_IF_ERROR(
-      ApplyK8sUpdates(ts, shadow_state.get(), metadata_filter_, &incoming_k8s_updates_));
+      ApplyK8sUpdates(ts, shadow_state.get(), metadata_filter_, std::move(k8s_updates)));
 
   if (collects_data_) {
-    // Update PID information.
-    PL_RETURN_IF_ERROR(
-        ProcessPIDUpdates(ts, proc_parser_, shadow_state.get(), md_reader_.get(), &pid_updates_));
+    // Update PID information. With PID change notifications, only the containers with reported
+    // changes are re-read, except for the periodic reconciliation of all containers.
+    bool reconcile = !pid_change_notifications_enabled_ ||
+                     epoch_id % kEpochsBetweenPIDReconciliation == 0;
+    std::vector<uint32_t> changed_pids(pid_change_notifications_.size_approx());
+    changed_pids.resize(
+        pid_change_notifications_.try_dequeue_bulk(changed_pids.begin(), changed_pids.size()));
+
+    absl::flat_hash_set<CID> dirty_cids;
+    if (!reconcile) {
+      ContainersForPIDs(*shadow_state, *md_reader_, changed_pids, &dirty_cids);
+    }
+    PL_RETURN_IF_ERROR(ProcessPIDUpdates(ts, proc_parser_, shadow_state.get(), md_reader_.get(),
+                                         &pid_updates_, reconcile ? nullptr : &dirty_cids));
   }
 
   // Update the pod/service CIDRs if they have been updated.
@@ -128,14 +177,114 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   return Status::OK();
 }
 
+namespace {
+
+// Returns the ID of the object that the update is for, or an empty string for updates that
+// aren't applied.
+std::string_view UpdateObjectID(const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      return update.pod_update().uid();
+    case ResourceUpdate::kContainerUpdate:
+      return update.container_update().cid();
+    case ResourceUpdate::kServiceUpdate:
+      return update.service_update().uid();
+    case ResourceUpdate::kNamespaceUpdate:
+      return update.namespace_update().uid();
+    default:
+      return {};
+  }
+}
+
+// Returns the order in which the updates of a type are applied, so that the objects an update
+// refers to already exist: pods refer to containers, and services refer to pods.
+int UpdateOrder(const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kNamespaceUpdate:
+      return 0;
+    case ResourceUpdate::kContainerUpdate:
+      return 1;
+    case ResourceUpdate::kPodUpdate:
+      return 2;
+    case ResourceUpdate::kServiceUpdate:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+// Adds the IDs in prev_ids that are missing from ids.
+void MergeIDs(const google::protobuf::RepeatedPtrField<std::string>& prev_ids,
+              google::protobuf::RepeatedPtrField<std::string>* ids) {
+  absl::flat_hash_set<std::string_view> id_set(ids->begin(), ids->end());
+  for (const auto& id : prev_ids) {
+    if (!id_set.contains(id)) {
+      *ids->Add() = id;
+    }
+  }
+}
+
+// Merges the references of a previous update of the same object into the update.
+void MergeUpdateReferences(const ResourceUpdate& prev, ResourceUpdate* update) {
+  switch (update->update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      MergeIDs(prev.pod_update().container_ids(),
+               update->mutable_pod_update()->mutable_container_ids());
+      break;
+    case ResourceUpdate::kServiceUpdate:
+      MergeIDs(prev.service_update().pod_ids(),
+               update->mutable_service_update()->mutable_pod_ids());
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+void CompactK8sUpdates(std::vector<std::unique_ptr<ResourceUpdate>>* updates) {
+  std::vector<std::unique_ptr<ResourceUpdate>> compacted;
+  compacted.reserve(updates->size());
+  // The index in compacted of the last update of each object, by update type and object ID.
+  absl::flat_hash_map<std::pair<int, std::string>, size_t> last_update_idx;
+
+  for (auto& update : *updates) {
+    std::string_view id = UpdateObjectID(*update);
+    if (!id.empty()) {
+      auto [it, inserted] = last_update_idx.try_emplace(
+          std::make_pair(static_cast<int>(update->update_case()), std::string(id)),
+          compacted.size());
+      if (!inserted) {
+        std::unique_ptr<ResourceUpdate>& prev = compacted[it->second];
+        MergeUpdateReferences(*prev, update.get());
+        prev.reset();
+        it->second = compacted.size();
+      }
+    }
+    compacted.push_back(std::move(update));
+  }
+
+  compacted.erase(std::remove(compacted.begin(), compacted.end(), nullptr), compacted.end());
+  // Within a type, the updates keep the order of the last update of each object.
+  std::stable_sort(compacted.begin(), compacted.end(), [](const auto& a, const auto& b) {
+    return UpdateOrder(*a) < UpdateOrder(*b);
+  });
+  *updates = std::move(compacted);
+}
+
 Status ApplyK8sUpdates(
     int64_t ts, AgentMetadataState* state, AgentMetadataFilter* metadata_filter,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>>* updates) {
-  std::unique_ptr<ResourceUpdate> update(nullptr);
+  return ApplyK8sUpdates(ts, state, metadata_filter, DrainQueue(updates));
+}
+
+Status ApplyK8sUpdates(int64_t ts, AgentMetadataState* state,
+                       AgentMetadataFilter* metadata_filter,
+                       std::vector<std::unique_ptr<ResourceUpdate>> updates) {
   PL_UNUSED(ts);
 
-  // Returns false when no more items.
-  while (updates->try_dequeue(update)) {
+  CompactK8sUpdates(&updates);
+  for (const auto& update : updates) {
     switch (update->update_case()) {
       case ResourceUpdate::kPodUpdate:
         PL_RETURN_IF_ERROR(HandlePodUpdate(update->pod_update(), state, metadata_filter));
@@ -166,6 +315,20 @@ StatusOr<UPID> InitUPID(const system::ProcParser& proc_parser, uint32_t asid, ui
   return UPID(asid, pid, pid_start_time);
 }
 
+// Returns whether the PIDs read from cgroups differ from the container's active UPIDs.
+bool ContainerPIDsChanged(const absl::flat_hash_set<UPID>& upids,
+                          const absl::flat_hash_set<uint32_t>& cgroups_pids) {
+  if (upids.size() != cgroups_pids.size()) {
+    return true;
+  }
+  for (const auto& upid : upids) {
+    if (!cgroups_pids.contains(upid.pid())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 void ProcessContainerPIDUpdates(
@@ -217,10 +380,43 @@ void ProcessContainerPIDUpdates(
   }
 }
 
+void ContainersForPIDs(const AgentMetadataState& md, const CGroupMetadataReader& md_reader,
+                       const std::vector<uint32_t>& pids, absl::flat_hash_set<CID>* cids) {
+  if (pids.empty()) {
+    return;
+  }
+
+  // Exited processes can no longer be resolved from /proc, so look up known pids first.
+  absl::flat_hash_set<uint32_t> unresolved_pids(pids.begin(), pids.end());
+  for (const auto& [cid, cinfo] : md.k8s_metadata_state().containers_by_id()) {
+    if (cinfo->stop_time_ns() != 0) {
+      continue;
+    }
+    for (const auto& upid : cinfo->active_upids()) {
+      if (unresolved_pids.erase(upid.pid()) > 0) {
+        cids->emplace(cid);
+      }
+    }
+  }
+
+  // The remaining pids are new processes.
+  for (uint32_t pid : unresolved_pids) {
+    StatusOr<std::string> cid_status = md_reader.ReadContainerID(pid);
+    if (!cid_status.ok()) {
+      // The process already exited, or does not run in a container.
+      VLOG(2) << absl::Substitute("Could not resolve container of pid=$0 [msg=$1]", pid,
+                                  cid_status.msg());
+      continue;
+    }
+    cids->emplace(cid_status.ConsumeValueOrDie());
+  }
+}
+
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     CGroupMetadataReader* md_reader,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const absl::flat_hash_set<CID>* dirty_cids) {
   const auto& k8s_md_state = md->k8s_metadata_state();
 
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
@@ -249,7 +445,12 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->MutableContainerInfoByID(cid)->set_stop_time_ns(pod_info->stop_time_ns());
+      continue;
+    }
+
+    if (dirty_cids != nullptr && !cinfo->active_upids().empty() && !dirty_cids->contains(cid)) {
+      // No PID changes were reported for this container.
       continue;
     }
 
@@ -267,16 +468,22 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        ContainerInfo* mutable_cinfo = k8s_md_state->MutableContainerInfoByID(cid);
+        mutable_cinfo->set_stop_time_ns(ts);
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
+    if (!ContainerPIDsChanged(cinfo->active_upids(), cgroups_active_pids)) {
+      // Avoid copying the container, which is shared with the previous state.
+      continue;
+    }
+    ProcessContainerPIDUpdates(cid, ts, proc_parser, md,
+                               k8s_md_state->MutableContainerInfoByID(cid)->mutable_active_upids(),
                                &cgroups_active_pids, pid_updates);
   }
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -89,6 +90,13 @@ class AgentMetadataStateManager {
    */
   virtual Status AddK8sUpdate(std::unique_ptr<ResourceUpdate> update) = 0;
 
+  /**
+   * Adds a batch of K8s updates, which are applied together in the same state update.
+   * @param updates the updates, in update version order.
+   * @return Status::OK on success.
+   */
+  virtual Status AddK8sUpdates(std::vector<std::unique_ptr<ResourceUpdate>> updates) = 0;
+
   /**
    * Sets the service CIDR.
    * @param the service CIDR.
@@ -106,6 +114,14 @@ class AgentMetadataStateManager {
    * @return unique_ptr with the PIDStatusEvent or nullptr.
    */
   virtual std::unique_ptr<PIDStatusEvent> GetNextPIDStatusEvent() = 0;
+
+  /**
+   * Notifies that a process has started or exited, for example from the process-lifecycle BPF
+   * probes. Once notifications arrive, only the cgroups of the containers with reported changes
+   * are re-read on each update, with a periodic full reconciliation to catch missed events.
+   * @param pid the pid of the process.
+   */
+  virtual void NotifyPIDChanged(uint32_t pid) = 0;
 };
 
 /**
@@ -136,6 +152,8 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
 
   Status AddK8sUpdate(std::unique_ptr<ResourceUpdate> update) override;
 
+  Status AddK8sUpdates(std::vector<std::unique_ptr<ResourceUpdate>> updates) override;
+
   void SetServiceCIDR(CIDRBlock cidr) override {
     absl::base_internal::SpinLockHolder lock(&cidr_lock_);
     service_cidr_ = std::move(cidr);
@@ -148,6 +166,11 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
 
   std::unique_ptr<PIDStatusEvent> GetNextPIDStatusEvent() override;
 
+  void NotifyPIDChanged(uint32_t pid) override {
+    pid_change_notifications_enabled_ = true;
+    pid_change_notifications_.enqueue(pid);
+  }
+
  private:
   /**
    * The number of PID events to send upstream.
@@ -169,9 +192,16 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
 
   std::mutex metadata_state_update_lock_;
 
+  // Held while adding a batch of updates, and while draining the updates for a state update.
+  std::mutex incoming_k8s_updates_lock_;
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> incoming_k8s_updates_;
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>> pid_updates_;
 
+  // PIDs of processes reported to have started or exited since the last update. Until the first
+  // notification arrives, every container is re-read on each update.
+  moodycamel::BlockingConcurrentQueue<uint32_t> pid_change_notifications_;
+  std::atomic<bool> pid_change_notifications_enabled_{false};
+
   absl::base_internal::SpinLock cidr_lock_;
   std::optional<CIDRBlock> service_cidr_;
   std::optional<std::vector<CIDRBlock>> pod_cidrs_;
@@ -180,23 +210,48 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
 };
 
 /**
- * Applies K8s updates to the current state.
+ * Compacts a sequence of K8s updates into the updates that result in the same state:
+ *   - Repeated updates of the same object are merged into the last one. The references to other
+ *     objects (the containers of a pod, the pods of a service) are merged, since applying an
+ *     update only ever adds references.
+ *   - The updates are ordered so that the objects an update refers to are added first.
+ */
+void CompactK8sUpdates(std::vector<std::unique_ptr<ResourceUpdate>>* updates);
+
+/**
+ * Applies K8s updates to the current state. The queued updates are compacted before they are
+ * applied, which avoids applying every intermediate update of an object after a restart or an
+ * update storm.
  */
 Status ApplyK8sUpdates(
     int64_t ts, AgentMetadataState* state, AgentMetadataFilter* metadata_filter,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>>* updates);
+Status ApplyK8sUpdates(int64_t ts, AgentMetadataState* state,
+                       AgentMetadataFilter* metadata_filter,
+                       std::vector<std::unique_ptr<ResourceUpdate>> updates);
 
 /**
  * Removes dead pods from the current state.
  */
 void RemoveDeadPods(int64_t ts, AgentMetadataState* md, CGroupMetadataReader* md_reader);
 
+/**
+ * Resolves the live containers that the given pids run in. Known pids are looked up in the
+ * metadata state, and the rest are resolved by reading their cgroup.
+ */
+void ContainersForPIDs(const AgentMetadataState& md, const CGroupMetadataReader& md_reader,
+                       const std::vector<uint32_t>& pids, absl::flat_hash_set<CID>* cids);
+
 /**
  * Processes PID updates.
+ *
+ * If dirty_cids is set, only the cgroups of those containers, and of the containers that have no
+ * pids yet, are read. Otherwise, the cgroups of all live containers are read.
  */
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState*, CGroupMetadataReader*,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates);
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const absl::flat_hash_set<CID>* dirty_cids = nullptr);
 
 /**
  * Deletes metadata for dead objects.
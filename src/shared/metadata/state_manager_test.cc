@@ -32,10 +32,13 @@ namespace md {
 
 using ResourceUpdate = px::shared::k8s::metadatapb::ResourceUpdate;
 
+using ::testing::_;
+using ::testing::DoAll;
 using ::testing::ElementsAre;
 using ::testing::Pair;
 using ::testing::Return;
 using ::testing::ReturnRef;
+using ::testing::SetArgPointee;
 using ::testing::UnorderedElementsAre;
 
 constexpr char kUpdate0_0Pbtxt[] = R"(
@@ -278,6 +281,97 @@ TEST_F(AgentMetadataStateTest, pid_created) {
   EXPECT_THAT(pids_started, UnorderedElementsAre(PIDStartedEvent{pid1}, PIDStartedEvent{pid2}));
 }
 
+TEST_F(AgentMetadataStateTest, pid_updates_read_dirty_containers) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  GenerateTestUpdateEvents(&updates);
+
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+
+  std::filesystem::path proc_path = testing::TestFilePath("src/shared/metadata/testdata/proc");
+
+  system::MockConfig sysconfig;
+  EXPECT_CALL(sysconfig, ClockRealTimeOffset()).WillRepeatedly(Return(128));
+  EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+  EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(10000000));
+  EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path));
+  system::ProcParser proc_parser(sysconfig);
+
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>> events;
+  FakePIDData fake_md_reader;
+  EXPECT_OK(ProcessPIDUpdates(1000, proc_parser, &metadata_state_, &fake_md_reader, &events));
+  EXPECT_EQ(2UL, events.size_approx());
+  std::unique_ptr<PIDStatusEvent> event;
+  while (events.try_dequeue(event)) {
+  }
+
+  MockCGroupMetadataReader md_reader;
+
+  // Without reported changes, the container that already has pids is not read.
+  absl::flat_hash_set<CID> dirty_cids;
+  EXPECT_CALL(md_reader, ReadPIDs(_, _, _, _, _)).Times(0);
+  EXPECT_OK(
+      ProcessPIDUpdates(1000, proc_parser, &metadata_state_, &md_reader, &events, &dirty_cids));
+  EXPECT_EQ(0UL, events.size_approx());
+
+  // Known pids are resolved from the metadata state, without reading their cgroups.
+  EXPECT_CALL(md_reader, ReadContainerID(_)).Times(0);
+  ContainersForPIDs(metadata_state_, md_reader, {200}, &dirty_cids);
+  EXPECT_THAT(dirty_cids, UnorderedElementsAre("container_id1"));
+  ::testing::Mock::VerifyAndClearExpectations(&md_reader);
+
+  absl::flat_hash_set<uint32_t> pids = {100};
+  EXPECT_CALL(md_reader, ReadPIDs(PodQOSClass::kBurstable, "pod_id1", "container_id1",
+                                  ContainerType::kDocker, _))
+      .WillOnce(DoAll(SetArgPointee<4>(pids), Return(Status::OK())));
+  EXPECT_OK(
+      ProcessPIDUpdates(3000, proc_parser, &metadata_state_, &md_reader, &events, &dirty_cids));
+
+  ASSERT_TRUE(events.try_dequeue(event));
+  ASSERT_EQ(PIDStatusEventType::kTerminated, event->type);
+  EXPECT_EQ(UPID(kASID, 200 /*pid*/, 2000 /*ts*/),
+            static_cast<PIDTerminatedEvent*>(event.get())->upid);
+  EXPECT_FALSE(events.try_dequeue(event));
+}
+
+TEST_F(AgentMetadataStateTest, compact_k8s_updates) {
+  std::vector<std::string> updates_pbtxt = {
+      // The pod refers to a container that doesn't exist yet.
+      R"(pod_update { name: "pod1" namespace: "pl" uid: "pod_id1" container_ids: "container_id1"
+                      phase: PENDING })",
+      R"(container_update { name: "container_name1" cid: "container_id1"
+                            container_state: CONTAINER_STATE_RUNNING })",
+      R"(service_update { name: "service1" namespace: "pl" uid: "service_id1"
+                          pod_ids: "pod_id1" })",
+      R"(pod_update { name: "pod1" namespace: "pl" uid: "pod_id1" phase: RUNNING })",
+  };
+  std::vector<std::unique_ptr<ResourceUpdate>> updates;
+  for (const auto& pbtxt : updates_pbtxt) {
+    auto update = std::make_unique<ResourceUpdate>();
+    ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(pbtxt, update.get()));
+    updates.push_back(std::move(update));
+  }
+
+  CompactK8sUpdates(&updates);
+  ASSERT_EQ(3UL, updates.size());
+  EXPECT_THAT(*updates[0], testing::proto::EqualsProto(updates_pbtxt[1]));
+  EXPECT_THAT(*updates[1],
+              testing::proto::EqualsProto(R"(pod_update { name: "pod1" namespace: "pl"
+                                                          uid: "pod_id1" phase: RUNNING
+                                                          container_ids: "container_id1" })"));
+  EXPECT_THAT(*updates[2], testing::proto::EqualsProto(updates_pbtxt[2]));
+
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, std::move(updates)));
+
+  K8sMetadataState* state = metadata_state_.k8s_metadata_state();
+  auto* pod_info = state->PodInfoByID("pod_id1");
+  ASSERT_NE(nullptr, pod_info);
+  EXPECT_EQ(PodPhase::kRunning, pod_info->phase());
+  EXPECT_THAT(pod_info->containers(), UnorderedElementsAre("container_id1"));
+  EXPECT_THAT(pod_info->services(), UnorderedElementsAre("service_id1"));
+  EXPECT_EQ("pod_id1", state->ContainerInfoByID("container_id1")->pod_id());
+}
+
 TEST_F(AgentMetadataStateTest, insert_into_filter) {
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
   GenerateTestUpdateEvents(&updates);
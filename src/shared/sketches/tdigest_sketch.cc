@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/sketches/tdigest_sketch.h"
+
+#include <cstring>
+
+namespace px {
+namespace sketches {
+
+namespace {
+
+constexpr uint8_t kTDigestSketchVersion = 1;
+constexpr size_t kTDigestHeaderSize = sizeof(uint8_t) + sizeof(uint32_t);
+constexpr size_t kTDigestCentroidSize = 2 * sizeof(double);
+
+template <typename T>
+void AppendRaw(T val, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <typename T>
+T ReadRaw(const char* pos) {
+  T val;
+  std::memcpy(&val, pos, sizeof(val));
+  return val;
+}
+
+}  // namespace
+
+std::string SerializeTDigest(tdigest::TDigest* digest) {
+  digest->compress();
+  const auto& centroids = digest->processed();
+
+  std::string out;
+  out.reserve(kTDigestHeaderSize + centroids.size() * kTDigestCentroidSize);
+  AppendRaw(kTDigestSketchVersion, &out);
+  AppendRaw(static_cast<uint32_t>(centroids.size()), &out);
+  for (const auto& centroid : centroids) {
+    AppendRaw(static_cast<double>(centroid.mean()), &out);
+    AppendRaw(static_cast<double>(centroid.weight()), &out);
+  }
+  return out;
+}
+
+Status MergeSerializedTDigest(const std::string& data, tdigest::TDigest* digest) {
+  if (data.size() < kTDigestHeaderSize) {
+    return error::InvalidArgument("Quantile sketch is too short: $0 bytes", data.size());
+  }
+  auto version = ReadRaw<uint8_t>(data.data());
+  if (version != kTDigestSketchVersion) {
+    return error::InvalidArgument("Unsupported quantile sketch version $0",
+                                  static_cast<int>(version));
+  }
+  auto num_centroids = ReadRaw<uint32_t>(data.data() + sizeof(uint8_t));
+  if (data.size() != kTDigestHeaderSize + num_centroids * kTDigestCentroidSize) {
+    return error::InvalidArgument("Quantile sketch of $0 bytes does not hold $1 centroids",
+                                  data.size(), num_centroids);
+  }
+
+  const char* pos = data.data() + kTDigestHeaderSize;
+  for (uint32_t i = 0; i < num_centroids; ++i, pos += kTDigestCentroidSize) {
+    digest->add(ReadRaw<double>(pos), ReadRaw<double>(pos + sizeof(double)));
+  }
+  return Status::OK();
+}
+
+}  // namespace sketches
+}  // namespace px
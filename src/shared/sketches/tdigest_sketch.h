@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include "src/common/base/base.h"
+#include "tdigest/tdigest.h"
+
+namespace px {
+namespace sketches {
+
+/**
+ * Serializes the digest into the compact binary sketch format: a version byte and a centroid
+ * count, followed by the (mean, weight) pair of every centroid. The digest is compressed first so
+ * that no unprocessed points are left out. Unlike the quantiles read from a digest, sketches can
+ * be merged, e.g. across time windows or agents.
+ */
+std::string SerializeTDigest(tdigest::TDigest* digest);
+
+/**
+ * Adds the centroids of a sketch produced by SerializeTDigest to the digest.
+ */
+Status MergeSerializedTDigest(const std::string& data, tdigest::TDigest* digest);
+
+}  // namespace sketches
+}  // namespace px
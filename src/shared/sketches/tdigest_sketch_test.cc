@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/sketches/tdigest_sketch.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace sketches {
+
+TEST(TDigestSketchTest, RoundTrip) {
+  tdigest::TDigest digest(100);
+  for (int i = 1; i <= 100; ++i) {
+    digest.add(i);
+  }
+  std::string sketch = SerializeTDigest(&digest);
+
+  tdigest::TDigest restored(100);
+  ASSERT_OK(MergeSerializedTDigest(sketch, &restored));
+  EXPECT_NEAR(restored.quantile(0.5), digest.quantile(0.5), 1);
+  EXPECT_NEAR(restored.quantile(0.99), digest.quantile(0.99), 1);
+}
+
+TEST(TDigestSketchTest, MergesSketches) {
+  tdigest::TDigest low(100);
+  low.add(1);
+  low.add(2);
+  tdigest::TDigest high(100);
+  high.add(3);
+  high.add(10);
+
+  // A sketch can be merged into a digest of another compression.
+  tdigest::TDigest merged(1000);
+  ASSERT_OK(MergeSerializedTDigest(SerializeTDigest(&low), &merged));
+  ASSERT_OK(MergeSerializedTDigest(SerializeTDigest(&high), &merged));
+  EXPECT_DOUBLE_EQ(merged.quantile(0.01), 1);
+  EXPECT_DOUBLE_EQ(merged.quantile(0.99), 10);
+}
+
+TEST(TDigestSketchTest, RejectsBadSketches) {
+  tdigest::TDigest digest(100);
+  EXPECT_NOT_OK(MergeSerializedTDigest("", &digest));
+  EXPECT_NOT_OK(MergeSerializedTDigest(std::string("\x02\0\0\0\0", 5), &digest));
+  EXPECT_NOT_OK(MergeSerializedTDigest(std::string("\x01\x01\0\0\0", 5), &digest));
+}
+
+}  // namespace sketches
+}  // namespace px
@@ -19,12 +19,16 @@
 #pragma once
 
 #include <arrow/array.h>
+#include <arrow/builder.h>
 #include <arrow/memory_pool.h>
 #include <algorithm>
+#include <limits>
 #include <numeric>
 #include <string>
 
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "src/common/base/base.h"
@@ -60,20 +64,55 @@ inline std::shared_ptr<arrow::Array> ToArrow(const std::vector<TUDFValue>& data,
 }
 
 // Specialization of the above for strings.
+// The offsets and data buffers are written directly, each sized once, and wrapped in the array.
+// It is used for the columns without nulls, so unlike with a StringBuilder, no validity bitmap is
+// built.
 template <>
 inline std::shared_ptr<arrow::Array> ToArrow<StringValue>(const std::vector<StringValue>& data,
                                                           arrow::MemoryPool* mem_pool) {
   DCHECK(mem_pool != nullptr);
-  arrow::StringBuilder builder(mem_pool);
   size_t total_size =
       std::accumulate(data.begin(), data.end(), 0ULL,
                       [](uint64_t sum, const std::string& str) { return sum + str.size(); });
-  // This allocates space for null/ptrs/size.
-  PL_CHECK_OK(builder.Reserve(data.size()));
-  // This allocates space for the actual data.
-  PL_CHECK_OK(builder.ReserveData(total_size));
+  DCHECK_LE(total_size, static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+
+  arrow::BufferBuilder offsets_builder(mem_pool);
+  arrow::BufferBuilder data_builder(mem_pool);
+  PL_CHECK_OK(offsets_builder.Resize((data.size() + 1) * sizeof(int32_t)));
+  PL_CHECK_OK(data_builder.Resize(total_size));
+  int32_t offset = 0;
   for (const auto& val : data) {
-    builder.UnsafeAppend(val);
+    offsets_builder.UnsafeAppend(&offset, sizeof(offset));
+    data_builder.UnsafeAppend(val.data(), val.size());
+    offset += static_cast<int32_t>(val.size());
+  }
+  offsets_builder.UnsafeAppend(&offset, sizeof(offset));
+
+  std::shared_ptr<arrow::Buffer> offsets;
+  std::shared_ptr<arrow::Buffer> values;
+  PL_CHECK_OK(offsets_builder.Finish(&offsets));
+  PL_CHECK_OK(data_builder.Finish(&values));
+  return std::make_shared<arrow::StringArray>(data.size(), std::move(offsets), std::move(values));
+}
+
+// Like the above, with the validity of each value (0 for a null), as one byte per value.
+template <typename TUDFValue>
+inline std::shared_ptr<arrow::Array> ToArrow(const std::vector<TUDFValue>& data,
+                                             const std::vector<uint8_t>& valid,
+                                             arrow::MemoryPool* mem_pool) {
+  DCHECK(mem_pool != nullptr);
+  DCHECK_EQ(data.size(), valid.size());
+
+  typename ValueTypeTraits<TUDFValue>::arrow_builder_type builder(mem_pool);
+  PL_CHECK_OK(builder.Reserve(data.size()));
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (valid[i] == 0) {
+      PL_CHECK_OK(builder.AppendNull());
+    } else if constexpr (std::is_same_v<TUDFValue, StringValue>) {
+      PL_CHECK_OK(builder.Append(data[i]));
+    } else {
+      PL_CHECK_OK(builder.Append(data[i].val));
+    }
   }
   std::shared_ptr<arrow::Array> arr;
   PL_CHECK_OK(builder.Finish(&arr));
@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/types.h"
 
@@ -44,5 +47,25 @@ TEST(BinarySearchTest, find_index_lower_or_eq) {
   EXPECT_EQ(3, SearchArrowArrayLessThan<types::DataType::INT64>(col_rb1_arrow.get(), 8));
 }
 
+TEST(ToArrowTest, strings) {
+  std::vector<types::StringValue> data = {"abc", "", "defgh", std::string(1000, 'x')};
+  auto arr = ToArrow(data, arrow::default_memory_pool());
+  ASSERT_EQ(arr->type_id(), arrow::Type::STRING);
+  ASSERT_EQ(arr->length(), data.size());
+  EXPECT_EQ(arr->null_count(), 0);
+
+  auto* str_arr = static_cast<arrow::StringArray*>(arr.get());
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(str_arr->GetString(i), data[i]);
+  }
+  EXPECT_EQ(GetArrowArrayBytes<types::DataType::STRING>(arr.get()), 1008);
+}
+
+TEST(ToArrowTest, empty_strings) {
+  auto arr = ToArrow(std::vector<types::StringValue>{}, arrow::default_memory_pool());
+  ASSERT_EQ(arr->type_id(), arrow::Type::STRING);
+  EXPECT_EQ(arr->length(), 0);
+}
+
 }  // namespace types
 }  // namespace px
@@ -22,6 +22,7 @@
 #include <arrow/buffer.h>
 #include <arrow/builder.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -66,6 +67,13 @@ class ColumnWrapper {
   virtual void ShrinkToFit() = 0;
   virtual std::shared_ptr<arrow::Array> ConvertToArrow(arrow::MemoryPool* mem_pool) = 0;
 
+  // Nulls. A column has no validity until its first null, so columns without nulls carry no
+  // bitmap, and their values are all valid.
+  virtual void AppendNull() = 0;
+  virtual void SetNull(size_t idx) = 0;
+  virtual bool IsNull(size_t idx) const = 0;
+  virtual bool HasNulls() const = 0;
+
   template <class TValueType>
   void Append(TValueType val);
 
@@ -115,22 +123,65 @@ class ColumnWrapperTmpl : public ColumnWrapper {
   bool Empty() const override { return data_.empty(); }
 
   std::shared_ptr<arrow::Array> ConvertToArrow(arrow::MemoryPool* mem_pool) override {
-    return ToArrow(data_, mem_pool);
+    if (valid_.empty()) {
+      return ToArrow(data_, mem_pool);
+    }
+    return ToArrow(data_, valid_, mem_pool);
   }
 
   T operator[](size_t idx) const { return data_[idx]; }
 
   T& operator[](size_t idx) { return data_[idx]; }
 
-  void Append(T val) { data_.push_back(val); }
+  void Append(T val) {
+    data_.push_back(std::move(val));
+    if (!valid_.empty()) {
+      valid_.push_back(1);
+    }
+  }
+
+  // The value of a null is the default value of T.
+  void AppendNull() override {
+    InitValidity();
+    data_.emplace_back();
+    valid_.push_back(0);
+  }
+
+  void SetNull(size_t idx) override {
+    DCHECK_LT(idx, data_.size());
+    InitValidity();
+    valid_[idx] = 0;
+  }
+
+  bool IsNull(size_t idx) const override { return !valid_.empty() && valid_[idx] == 0; }
 
-  void Reserve(size_t size) override { data_.reserve(size); }
+  bool HasNulls() const override {
+    return std::find(valid_.begin(), valid_.end(), 0) != valid_.end();
+  }
 
-  void ShrinkToFit() override { data_.shrink_to_fit(); }
+  void Reserve(size_t size) override {
+    data_.reserve(size);
+    if (!valid_.empty()) {
+      valid_.reserve(size);
+    }
+  }
+
+  void ShrinkToFit() override {
+    data_.shrink_to_fit();
+    valid_.shrink_to_fit();
+  }
 
-  void Resize(size_t size) { data_.resize(size); }
+  void Resize(size_t size) {
+    data_.resize(size);
+    if (!valid_.empty()) {
+      valid_.resize(size, 1);
+    }
+  }
 
-  void Clear() override { data_.clear(); }
+  void Clear() override {
+    data_.clear();
+    valid_.clear();
+  }
 
   int64_t Bytes() const override;
 
@@ -148,6 +199,7 @@ class ColumnWrapperTmpl : public ColumnWrapper {
     for (size_t i = 0; i < indexes.size(); ++i) {
       copy->data_[i] = data_[indexes[i]];
     }
+    CopyValidity(indexes, copy.get());
     return copy;
   }
 
@@ -161,21 +213,41 @@ class ColumnWrapperTmpl : public ColumnWrapper {
     for (size_t i = 0; i < indexes.size(); ++i) {
       col->data_[i] = std::move(data_[indexes[i]]);
     }
+    CopyValidity(indexes, col.get());
     return col;
   }
 
  private:
+  void InitValidity() {
+    if (valid_.empty()) {
+      valid_.assign(data_.size(), 1);
+    }
+  }
+
+  void CopyValidity(const std::vector<size_t>& indexes, ColumnWrapperTmpl<T>* out) const {
+    if (valid_.empty()) {
+      return;
+    }
+    out->valid_.resize(indexes.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+      out->valid_[i] = valid_[indexes[i]];
+    }
+  }
+
   std::vector<T> data_;
+  // The validity of each value, as arrow's valid bytes: 0 for a null. Empty while the column has
+  // had no nulls.
+  std::vector<uint8_t> valid_;
 };
 
 template <typename T>
 int64_t ColumnWrapperTmpl<T>::Bytes() const {
-  return Size() * sizeof(T);
+  return Size() * sizeof(T) + valid_.size();
 }
 
 template <>
 inline int64_t ColumnWrapperTmpl<StringValue>::Bytes() const {
-  int64_t bytes = 0;
+  int64_t bytes = valid_.size();
   for (const auto& data : data_) {
     bytes += data.bytes();
   }
@@ -242,24 +314,38 @@ inline SharedColumnWrapper FromArrowImpl<StringValueColumnWrapper, DataType::STR
  */
 inline SharedColumnWrapper ColumnWrapper::FromArrow(const std::shared_ptr<arrow::Array>& arr) {
   auto type_id = arr->type_id();
+  SharedColumnWrapper wrapper;
   switch (type_id) {
     case arrow::Type::BOOL:
-      return FromArrowImpl<BoolValueColumnWrapper, DataType::BOOLEAN>(arr);
+      wrapper = FromArrowImpl<BoolValueColumnWrapper, DataType::BOOLEAN>(arr);
+      break;
     case arrow::Type::INT64:
-      return FromArrowImpl<Int64ValueColumnWrapper, DataType::INT64>(arr);
+      wrapper = FromArrowImpl<Int64ValueColumnWrapper, DataType::INT64>(arr);
+      break;
     case arrow::Type::UINT128:
-      return FromArrowImpl<UInt128ValueColumnWrapper, DataType::UINT128>(arr);
+      wrapper = FromArrowImpl<UInt128ValueColumnWrapper, DataType::UINT128>(arr);
+      break;
     case arrow::Type::DOUBLE:
-      return FromArrowImpl<Float64ValueColumnWrapper, DataType::FLOAT64>(arr);
+      wrapper = FromArrowImpl<Float64ValueColumnWrapper, DataType::FLOAT64>(arr);
+      break;
     case arrow::Type::STRING:
-      return FromArrowImpl<StringValueColumnWrapper, DataType::STRING>(arr);
+      wrapper = FromArrowImpl<StringValueColumnWrapper, DataType::STRING>(arr);
+      break;
     case arrow::Type::TIME64:
-      return FromArrowImpl<Time64NSValueColumnWrapper, DataType::TIME64NS>(arr);
     case arrow::Type::DURATION:
-      return FromArrowImpl<Time64NSValueColumnWrapper, DataType::TIME64NS>(arr);
+      wrapper = FromArrowImpl<Time64NSValueColumnWrapper, DataType::TIME64NS>(arr);
+      break;
     default:
       CHECK(0) << "Unknown arrow type: " << type_id;
   }
+  if (arr->null_count() != 0) {
+    for (int64_t i = 0; i < arr->length(); ++i) {
+      if (arr->IsNull(i)) {
+        wrapper->SetNull(i);
+      }
+    }
+  }
+  return wrapper;
 }
 
 /**
@@ -293,7 +379,7 @@ inline void ColumnWrapper::Append(TValueType val) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
       << "Expect " << ToString(data_type()) << " got "
       << ToString(ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(std::move(val));
 }
 
 template <class TValueType>
@@ -311,7 +397,7 @@ inline TValueType ColumnWrapper::Get(size_t idx) const {
 template <class TValueType>
 inline void ColumnWrapper::AppendNoTypeCheck(TValueType val) {
   DCHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type);
-  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(val);
+  static_cast<ColumnWrapperTmpl<TValueType>*>(this)->Append(std::move(val));
 }
 
 template <class TValueType>
@@ -238,6 +238,38 @@ TEST(ColumnWrapperTest, CopyIndexes) {
   }
 }
 
+TEST(ColumnWrapperTest, Nulls) {
+  auto col = ColumnWrapper::Make(DataType::STRING, 0);
+  col->Append<StringValue>("a");
+  EXPECT_FALSE(col->HasNulls());
+  col->AppendNull();
+  col->Append<StringValue>("c");
+  EXPECT_TRUE(col->HasNulls());
+  EXPECT_FALSE(col->IsNull(0));
+  EXPECT_TRUE(col->IsNull(1));
+  EXPECT_FALSE(col->IsNull(2));
+
+  auto arr = col->ConvertToArrow(arrow::default_memory_pool());
+  ASSERT_EQ(3, arr->length());
+  EXPECT_EQ(1, arr->null_count());
+  EXPECT_TRUE(arr->IsNull(1));
+  EXPECT_EQ("c", static_cast<arrow::StringArray*>(arr.get())->GetString(2));
+
+  // The nulls survive the round trip through arrow, and the reordering of the values.
+  auto from_arrow = ColumnWrapper::FromArrow(arr);
+  EXPECT_TRUE(from_arrow->IsNull(1));
+  auto copy = from_arrow->CopyIndexes({1, 2});
+  EXPECT_TRUE(copy->IsNull(0));
+  EXPECT_FALSE(copy->IsNull(1));
+  EXPECT_EQ("c", copy->Get<StringValue>(1));
+
+  // Columns without nulls carry no validity.
+  auto ints = ColumnWrapper::Make(DataType::INT64, 2);
+  EXPECT_EQ(0, ints->ConvertToArrow(arrow::default_memory_pool())->null_count());
+  ints->SetNull(0);
+  EXPECT_EQ(1, ints->ConvertToArrow(arrow::default_memory_pool())->null_count());
+}
+
 // Similar to CopyIndexes test, except we make a new source column each time,
 // since MoveIndexes() is destructive on the source.
 TEST(ColumnWrapperTest, MoveIndexes) {
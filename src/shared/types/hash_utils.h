@@ -21,7 +21,9 @@
 #include <farmhash.h>
 
 #include <cstdint>
+#include <iterator>
 
+#include "src/common/base/hash_utils.h"
 #include "src/shared/types/types.h"
 
 namespace px {
@@ -63,6 +65,36 @@ struct hash<Time64NSValue> {
   }
 };
 
+template <>
+struct hash<UInt128Value> {
+  uint64_t operator()(UInt128Value val) { return Hash128(val.Low64(), val.High64()); }
+};
+
+// Keys of up to this many fixed size values are hashed with multiply mixes, longer ones as bytes.
+constexpr size_t kMaxMixedFixedSizeValues = std::size(kHashSecrets);
+
+/**
+ * Hashes a composite key of fixed size values, ie. the group by or join key of a row. The unused
+ * bytes of each value must be zero.
+ *
+ * Each value is mixed with the secret of its position, independently of the others so that the
+ * multiplies can run in parallel, and the mixes are combined with a final multiply as in wyhash.
+ */
+inline uint64_t HashFixedSizeValues(const FixedSizeValueUnion* values, size_t num_values) {
+  if (num_values > kMaxMixedFixedSizeValues) {
+    return ::util::Hash64(reinterpret_cast<const char*>(values),
+                          num_values * sizeof(FixedSizeValueUnion));
+  }
+  uint64_t h = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    const auto& val = values[i].uint128_value;
+    h ^= MultiplyMix(val.Low64() ^ kHashSecrets[i],
+                     val.High64() ^ kHashSecrets[(i + 1) % kMaxMixedFixedSizeValues]);
+  }
+  return MultiplyMix(kHashSecrets[1] ^ (num_values * sizeof(FixedSizeValueUnion)),
+                     h ^ kHashSecrets[0]);
+}
+
 }  // namespace utils
 }  // namespace types
 }  // namespace px
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Benchmarks the hashes of the key shapes that aggregates and joins hash per row: UPIDs, short
+// strings and composite keys of fixed size values.
+//
+// The specialized (Mixed) hashes are compared against hashing the same bytes with farmhash, which
+// they replace. The binary exits with an error if any of them is not at least
+// --min_mixed_hash_speedup times as fast as its farmhash counterpart, so it can gate changes to
+// hash_utils.h:
+//   bazel run -c opt //src/shared/types:hash_utils_benchmark
+
+#include <benchmark/benchmark.h>
+#include <farmhash.h>
+
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <absl/hash/hash.h>
+#include <absl/strings/match.h>
+#include <absl/strings/str_replace.h>
+#include <absl/strings/substitute.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/hash_utils.h"
+#include "src/shared/types/types.h"
+
+DEFINE_double(min_mixed_hash_speedup, 1.0,
+              "The minimum throughput of each Mixed hash benchmark relative to its Farmhash "
+              "counterpart. Set to '0' to only report the results.");
+
+namespace px {
+namespace types {
+namespace utils {
+
+// Enough keys to not fit in registers, few enough to stay in the L1 cache.
+constexpr size_t kNumKeys = 1024;
+
+std::vector<UInt128Value> UPIDs() {
+  std::mt19937_64 rng(37);
+  std::vector<UInt128Value> upids;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    // A few agents with many processes each, started at arbitrary times.
+    uint64_t asid = rng() % 16;
+    uint64_t pid = rng() % (1 << 22);
+    upids.emplace_back((asid << 32) | pid, rng());
+  }
+  return upids;
+}
+
+std::vector<std::string> ShortStrings() {
+  std::mt19937_64 rng(37);
+  std::vector<std::string> strs;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    std::string s(8 + rng() % 24, '\0');
+    for (auto& c : s) {
+      c = 'a' + rng() % 26;
+    }
+    strs.push_back(std::move(s));
+  }
+  return strs;
+}
+
+// kNumKeys composite keys of key_width values each, alternating between int64 and uint128 values.
+std::vector<FixedSizeValueUnion> CompositeKeys(size_t key_width) {
+  std::mt19937_64 rng(37);
+  std::vector<FixedSizeValueUnion> keys(kNumKeys * key_width);
+  memset(keys.data(), 0, keys.size() * sizeof(FixedSizeValueUnion));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i % 2 == 0) {
+      keys[i].int64_value = Int64Value(static_cast<int64_t>(rng() % 1000));
+    } else {
+      keys[i].uint128_value = UInt128Value(rng(), rng());
+    }
+  }
+  return keys;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_UPIDFarmhash(benchmark::State& state) {
+  auto upids = UPIDs();
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (const auto& upid : upids) {
+      h ^= ::util::Hash64(reinterpret_cast<const char*>(&upid.val), sizeof(upid.val));
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * upids.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_UPIDMixed(benchmark::State& state) {
+  auto upids = UPIDs();
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (const auto& upid : upids) {
+      h ^= hash<UInt128Value>{}(upid);
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * upids.size());
+}
+
+// For reference, the hash that the UPID sets and maps in the agents use.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_UPIDAbslHash(benchmark::State& state) {
+  auto upids = UPIDs();
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (const auto& upid : upids) {
+      h ^= absl::Hash<absl::uint128>{}(upid.val);
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * upids.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ShortStringFarmhash(benchmark::State& state) {
+  auto strs = ShortStrings();
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (const auto& s : strs) {
+      h ^= hash<StringValue>{}(s);
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * strs.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CompositeKeyFarmhash(benchmark::State& state) {
+  size_t key_width = state.range(0);
+  auto keys = CompositeKeys(key_width);
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (size_t i = 0; i < keys.size(); i += key_width) {
+      h ^= ::util::Hash64(reinterpret_cast<const char*>(&keys[i]),
+                          key_width * sizeof(FixedSizeValueUnion));
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CompositeKeyMixed(benchmark::State& state) {
+  size_t key_width = state.range(0);
+  auto keys = CompositeKeys(key_width);
+  for (auto _ : state) {
+    uint64_t h = 0;
+    for (size_t i = 0; i < keys.size(); i += key_width) {
+      h ^= HashFixedSizeValues(&keys[i], key_width);
+    }
+    benchmark::DoNotOptimize(h);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+
+BENCHMARK(BM_UPIDFarmhash);
+BENCHMARK(BM_UPIDMixed);
+BENCHMARK(BM_UPIDAbslHash);
+BENCHMARK(BM_ShortStringFarmhash);
+BENCHMARK(BM_CompositeKeyFarmhash)->DenseRange(1, kMaxMixedFixedSizeValues);
+BENCHMARK(BM_CompositeKeyMixed)->DenseRange(1, kMaxMixedFixedSizeValues);
+
+/**
+ * Reports the results to the console, and keeps the throughput of each benchmark to check the
+ * Mixed hashes against their Farmhash counterparts.
+ */
+class ThroughputReporter : public benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run>& runs) override {
+    for (const auto& run : runs) {
+      auto it = run.counters.find("items_per_second");
+      if (!run.error_occurred && it != run.counters.end()) {
+        items_per_second_[run.benchmark_name()] = it->second;
+      }
+    }
+    ConsoleReporter::ReportRuns(runs);
+  }
+
+  // Returns false if any Mixed benchmark is slower than allowed.
+  bool CheckSpeedups(double min_speedup) const {
+    bool ok = true;
+    for (const auto& [name, mixed] : items_per_second_) {
+      if (!absl::StrContains(name, "Mixed")) {
+        continue;
+      }
+      auto baseline = items_per_second_.find(absl::StrReplaceAll(name, {{"Mixed", "Farmhash"}}));
+      if (baseline == items_per_second_.end() || baseline->second <= 0) {
+        continue;
+      }
+      double speedup = mixed / baseline->second;
+      if (speedup < min_speedup) {
+        LOG(ERROR) << absl::Substitute("$0 is $1x as fast as $2, below the minimum of $3x", name,
+                                       speedup, baseline->first, min_speedup);
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+ private:
+  std::map<std::string, double> items_per_second_;
+};
+
+}  // namespace utils
+}  // namespace types
+}  // namespace px
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  px::EnvironmentGuard env_guard(&argc, argv);
+  px::types::utils::ThroughputReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  return reporter.CheckSpeedups(FLAGS_min_mixed_hash_speedup) ? 0 : 1;
+}
@@ -16,6 +16,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <cstring>
+#include <set>
+#include <utility>
+
 #include <gtest/gtest.h>
 
 #include "src/shared/types/hash_utils.h"
@@ -60,6 +64,59 @@ TEST(HashUtils, Time64NSValue) {
   EXPECT_NE(hash<Time64NSValue>{}(v1), hash<Time64NSValue>{}(v2));
 }
 
+TEST(HashUtils, UInt128Value) {
+  UInt128Value v1(0, 1);
+  UInt128Value v2(1, 0);
+  UInt128Value v3(1, 1);
+
+  EXPECT_NE(hash<UInt128Value>{}(v1), hash<UInt128Value>{}(v2));
+  EXPECT_NE(hash<UInt128Value>{}(v1), hash<UInt128Value>{}(v3));
+  EXPECT_NE(hash<UInt128Value>{}(v2), hash<UInt128Value>{}(v3));
+  EXPECT_EQ(hash<UInt128Value>{}(v1), hash<UInt128Value>{}(UInt128Value(0, 1)));
+}
+
+class HashFixedSizeValuesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(values_, 0, sizeof(values_));
+    for (size_t i = 0; i < kNumValues; ++i) {
+      values_[i].int64_value = Int64Value(i + 1);
+    }
+  }
+
+  static constexpr size_t kNumValues = kMaxMixedFixedSizeValues + 2;
+  FixedSizeValueUnion values_[kNumValues];
+};
+
+TEST_F(HashFixedSizeValuesTest, depends_on_width) {
+  for (size_t width = 1; width < kNumValues; ++width) {
+    EXPECT_NE(HashFixedSizeValues(values_, width), HashFixedSizeValues(values_, width + 1));
+  }
+}
+
+TEST_F(HashFixedSizeValuesTest, depends_on_order) {
+  for (size_t width = 2; width <= kNumValues; ++width) {
+    uint64_t h = HashFixedSizeValues(values_, width);
+    std::swap(values_[0], values_[1]);
+    EXPECT_NE(h, HashFixedSizeValues(values_, width));
+    std::swap(values_[0], values_[1]);
+    EXPECT_EQ(h, HashFixedSizeValues(values_, width));
+  }
+}
+
+TEST_F(HashFixedSizeValuesTest, low_bits_spread) {
+  // Open addressing uses the low bits of the hash as the slot, so keys that only differ in an
+  // upper value should still spread over the slots.
+  constexpr uint64_t kSlots = 1024;
+  std::set<uint64_t> slots;
+  for (int64_t i = 0; i < static_cast<int64_t>(kSlots); ++i) {
+    values_[1].int64_value = Int64Value(i << 32);
+    slots.insert(HashFixedSizeValues(values_, 2) & (kSlots - 1));
+  }
+  // A random hash fills about 1 - 1/e of the slots.
+  EXPECT_GT(slots.size(), kSlots / 2);
+}
+
 }  // namespace utils
 }  // namespace types
 }  // namespace px
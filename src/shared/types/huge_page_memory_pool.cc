@@ -0,0 +1,300 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/types/huge_page_memory_pool.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+// Older libc headers don't have the huge page size flags.
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << 26)
+#endif
+
+DEFINE_string(arrow_huge_pages, gflags::StringFromEnv("PL_ARROW_HUGE_PAGES", ""),
+              "Backs the table store and query allocations with 2MB huge pages. 'transparent' "
+              "uses transparent huge pages, 'explicit' uses the pages reserved in hugetlbfs and "
+              "falls back to transparent ones. Disabled if empty.");
+
+namespace px {
+namespace types {
+
+namespace {
+
+// Arrow's buffers are 64-byte aligned.
+constexpr int64_t kAlignment = 64;
+// Allocations bigger than this get an arena of their own.
+constexpr int64_t kMaxArenaAllocation = HugePageMemoryPool::kHugePageSize / 4;
+
+// Zero-size allocations all point here, as in arrow's own pools.
+alignas(kAlignment) uint8_t zero_size_area[1];
+
+int64_t RoundUp(int64_t value, int64_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+HugePageMemoryPool::HugePageMemoryPool(HugePageMode mode, int64_t max_free_arenas)
+    : mode_(mode), max_free_arenas_(max_free_arenas) {}
+
+HugePageMemoryPool::~HugePageMemoryPool() {
+  absl::MutexLock lock(&lock_);
+  DCHECK_EQ(bytes_allocated_, 0) << "HugePageMemoryPool destroyed with live allocations.";
+  for (const auto& [base, arena] : arenas_) {
+    munmap(arena->base, arena->size);
+  }
+}
+
+arrow::Status HugePageMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  if (size < 0) {
+    return arrow::Status::Invalid("Negative allocation size requested.");
+  }
+  if (size == 0) {
+    *out = zero_size_area;
+    return arrow::Status::OK();
+  }
+  absl::MutexLock lock(&lock_);
+  uint8_t* buffer = AllocateLocked(size);
+  if (buffer == nullptr) {
+    return arrow::Status::OutOfMemory("Failed to map huge page arena of ", size, " bytes.");
+  }
+  *out = buffer;
+  return arrow::Status::OK();
+}
+
+arrow::Status HugePageMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (new_size < 0) {
+    return arrow::Status::Invalid("Negative reallocation size requested.");
+  }
+  if (*ptr == zero_size_area) {
+    return Allocate(new_size, ptr);
+  }
+  if (new_size == 0) {
+    Free(*ptr, old_size);
+    *ptr = zero_size_area;
+    return arrow::Status::OK();
+  }
+
+  absl::MutexLock lock(&lock_);
+  Arena* arena = FindArenaLocked(*ptr);
+  const int64_t old_end = (*ptr - arena->base) + RoundUp(old_size, kAlignment);
+  const int64_t new_end = (*ptr - arena->base) + RoundUp(new_size, kAlignment);
+  // The last allocation of an arena grows or shrinks in place.
+  if (old_end == arena->used && new_end <= arena->size) {
+    arena->used = new_end;
+    bytes_allocated_ += new_size - old_size;
+    max_memory_ = std::max(max_memory_, bytes_allocated_);
+    return arrow::Status::OK();
+  }
+
+  uint8_t* buffer = AllocateLocked(new_size);
+  if (buffer == nullptr) {
+    return arrow::Status::OutOfMemory("Failed to map huge page arena of ", new_size, " bytes.");
+  }
+  std::memcpy(buffer, *ptr, std::min(old_size, new_size));
+  FreeLocked(*ptr, old_size);
+  *ptr = buffer;
+  return arrow::Status::OK();
+}
+
+void HugePageMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  if (buffer == zero_size_area) {
+    return;
+  }
+  absl::MutexLock lock(&lock_);
+  FreeLocked(buffer, size);
+}
+
+int64_t HugePageMemoryPool::bytes_allocated() const {
+  absl::MutexLock lock(&lock_);
+  return bytes_allocated_;
+}
+
+int64_t HugePageMemoryPool::max_memory() const {
+  absl::MutexLock lock(&lock_);
+  return max_memory_;
+}
+
+HugePageMemoryPoolStats HugePageMemoryPool::GetStats() const {
+  absl::MutexLock lock(&lock_);
+  HugePageMemoryPoolStats stats;
+  stats.bytes_allocated = bytes_allocated_;
+  stats.bytes_mapped = bytes_mapped_;
+  stats.num_arenas = arenas_.size();
+  stats.num_free_arenas = free_arenas_.size();
+  stats.num_hugetlb_fallbacks = num_hugetlb_fallbacks_;
+  return stats;
+}
+
+uint8_t* HugePageMemoryPool::AllocateLocked(int64_t size) {
+  const int64_t aligned_size = RoundUp(size, kAlignment);
+  Arena* arena;
+  if (aligned_size > kMaxArenaAllocation) {
+    arena = NewArenaLocked(RoundUp(aligned_size, kHugePageSize));
+    if (arena == nullptr) {
+      return nullptr;
+    }
+  } else {
+    if (current_ == nullptr || current_->used + aligned_size > current_->size) {
+      Arena* prev = current_;
+      current_ = NewArenaLocked(kHugePageSize);
+      if (current_ == nullptr) {
+        current_ = prev;
+        return nullptr;
+      }
+      // A full arena is released by its last Free(), unless that already happened.
+      if (prev != nullptr && prev->num_live_allocations == 0) {
+        ReleaseArenaLocked(prev);
+      }
+    }
+    arena = current_;
+  }
+
+  uint8_t* buffer = arena->base + arena->used;
+  arena->used += aligned_size;
+  ++arena->num_live_allocations;
+  bytes_allocated_ += size;
+  max_memory_ = std::max(max_memory_, bytes_allocated_);
+  return buffer;
+}
+
+void HugePageMemoryPool::FreeLocked(uint8_t* buffer, int64_t size) {
+  Arena* arena = FindArenaLocked(buffer);
+  bytes_allocated_ -= size;
+  if (--arena->num_live_allocations > 0) {
+    return;
+  }
+  if (arena == current_) {
+    // Start over at the beginning of the arena rather than switching to another one.
+    arena->used = 0;
+    return;
+  }
+  ReleaseArenaLocked(arena);
+}
+
+HugePageMemoryPool::Arena* HugePageMemoryPool::NewArenaLocked(int64_t size) {
+  if (size == kHugePageSize && !free_arenas_.empty()) {
+    Arena* arena = free_arenas_.back();
+    free_arenas_.pop_back();
+    return arena;
+  }
+  uint8_t* base = MapRegion(size);
+  if (base == nullptr) {
+    return nullptr;
+  }
+  auto arena = std::make_unique<Arena>();
+  arena->base = base;
+  arena->size = size;
+  bytes_mapped_ += size;
+  Arena* arena_ptr = arena.get();
+  arenas_[reinterpret_cast<uintptr_t>(base)] = std::move(arena);
+  return arena_ptr;
+}
+
+void HugePageMemoryPool::ReleaseArenaLocked(Arena* arena) {
+  arena->used = 0;
+  arena->num_live_allocations = 0;
+  if (arena->size == kHugePageSize &&
+      static_cast<int64_t>(free_arenas_.size()) < max_free_arenas_) {
+    free_arenas_.push_back(arena);
+    return;
+  }
+  munmap(arena->base, arena->size);
+  bytes_mapped_ -= arena->size;
+  arenas_.erase(reinterpret_cast<uintptr_t>(arena->base));
+}
+
+HugePageMemoryPool::Arena* HugePageMemoryPool::FindArenaLocked(const uint8_t* buffer) {
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(buffer);
+  auto iter = arenas_.find(addr - addr % kHugePageSize);
+  CHECK(iter != arenas_.end()) << "Buffer was not allocated from this HugePageMemoryPool.";
+  return iter->second.get();
+}
+
+uint8_t* HugePageMemoryPool::MapRegion(int64_t size) {
+  if (mode_ == HugePageMode::kExplicit) {
+    // hugetlb mappings are aligned to their page size.
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+    if (addr != MAP_FAILED) {
+      return static_cast<uint8_t*>(addr);
+    }
+    ++num_hugetlb_fallbacks_;
+    LOG_FIRST_N(WARNING, 1) << absl::Substitute(
+        "No reserved huge pages left, falling back to transparent huge pages. errno=$0", errno);
+  }
+
+  // Map an extra huge page, so that the region can be trimmed to a huge page boundary.
+  const int64_t map_size = size + kHugePageSize;
+  void* addr =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+  const uintptr_t aligned_start = RoundUp(start, kHugePageSize);
+  if (aligned_start > start) {
+    munmap(addr, aligned_start - start);
+  }
+  const uintptr_t end = start + map_size;
+  if (end > aligned_start + size) {
+    munmap(reinterpret_cast<void*>(aligned_start + size), end - aligned_start - size);
+  }
+  uint8_t* base = reinterpret_cast<uint8_t*>(aligned_start);
+  // Fails if transparent huge pages are disabled, in which case the arena has regular pages.
+  madvise(base, size, MADV_HUGEPAGE);
+  return base;
+}
+
+arrow::MemoryPool* DataMemoryPool() {
+  static arrow::MemoryPool* pool = []() -> arrow::MemoryPool* {
+    if (FLAGS_arrow_huge_pages.empty()) {
+      return arrow::default_memory_pool();
+    }
+    HugePageMode mode;
+    if (FLAGS_arrow_huge_pages == "transparent") {
+      mode = HugePageMode::kTransparent;
+    } else if (FLAGS_arrow_huge_pages == "explicit") {
+      mode = HugePageMode::kExplicit;
+    } else {
+      LOG(ERROR) << absl::Substitute(
+          "Unknown --arrow_huge_pages value '$0', using the default memory pool.",
+          FLAGS_arrow_huge_pages);
+      return arrow::default_memory_pool();
+    }
+    // Never destroyed: buffers from the pool may still be freed during exit.
+    return new HugePageMemoryPool(mode);
+  }();
+  return pool;
+}
+
+StatusOr<HugePageMemoryPoolStats> DataMemoryPoolStats() {
+  auto* pool = dynamic_cast<HugePageMemoryPool*>(DataMemoryPool());
+  if (pool == nullptr) {
+    return error::FailedPrecondition("The data memory pool doesn't use huge pages.");
+  }
+  return pool->GetStats();
+}
+
+}  // namespace types
+}  // namespace px
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_string(arrow_huge_pages);
+
+namespace px {
+namespace types {
+
+enum class HugePageMode {
+  // Regular mappings that are madvise()d for transparent huge pages.
+  kTransparent,
+  // Mappings from the reserved hugetlbfs pages, or transparent ones when none are left.
+  kExplicit,
+};
+
+struct HugePageMemoryPoolStats {
+  // The bytes of the live allocations.
+  int64_t bytes_allocated = 0;
+  // The bytes of all the arenas that are mapped, including the empty ones kept for reuse.
+  int64_t bytes_mapped = 0;
+  int64_t num_arenas = 0;
+  int64_t num_free_arenas = 0;
+  // The number of arenas mapped with transparent huge pages in kExplicit mode, because there
+  // were no reserved huge pages left.
+  int64_t num_hugetlb_fallbacks = 0;
+
+  /**
+   * The share of the mapped bytes that don't hold a live allocation: freed space that can't be
+   * reused until the rest of its arena is freed, the unused end of the current arena, the
+   * rounding of large allocations and the free arenas.
+   */
+  double fragmentation() const {
+    return bytes_mapped == 0 ? 0.0 : 1.0 - static_cast<double>(bytes_allocated) / bytes_mapped;
+  }
+};
+
+/**
+ * HugePageMemoryPool is an arrow::MemoryPool that allocates from 2MB arenas backed by huge pages,
+ * so that scans over the table store and the hash tables of joins take far fewer TLB misses.
+ *
+ * Small allocations are bumped out of the current arena, and an arena is reused once all of its
+ * allocations are freed. This suits column batches, which are freed roughly in the order they
+ * were allocated (expiration in the table store, the end of a query in Carnot). Allocations over
+ * a quarter of an arena get arenas of their own, rounded up to the huge page size.
+ *
+ * Thread-safe.
+ */
+class HugePageMemoryPool : public arrow::MemoryPool {
+ public:
+  static constexpr int64_t kHugePageSize = 2 * 1024 * 1024;
+
+  /**
+   * @param max_free_arenas the number of empty arenas to keep mapped for reuse.
+   */
+  explicit HugePageMemoryPool(HugePageMode mode, int64_t max_free_arenas = 4);
+  ~HugePageMemoryPool() override;
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  int64_t bytes_allocated() const override;
+  int64_t max_memory() const override;
+  std::string backend_name() const override { return "huge_pages"; }
+
+  HugePageMemoryPoolStats GetStats() const;
+
+ private:
+  struct Arena {
+    uint8_t* base = nullptr;
+    int64_t size = 0;
+    // The bytes bumped out of the arena so far.
+    int64_t used = 0;
+    int64_t num_live_allocations = 0;
+  };
+
+  uint8_t* AllocateLocked(int64_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void FreeLocked(uint8_t* buffer, int64_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Arena* NewArenaLocked(int64_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void ReleaseArenaLocked(Arena* arena) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Arena* FindArenaLocked(const uint8_t* buffer) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  uint8_t* MapRegion(int64_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const HugePageMode mode_;
+  const int64_t max_free_arenas_;
+
+  mutable absl::Mutex lock_;
+  // All of the mapped arenas, by base address. Arenas are aligned to the huge page size, so the
+  // arena of a buffer is found by rounding its address down.
+  absl::flat_hash_map<uintptr_t, std::unique_ptr<Arena>> arenas_ ABSL_GUARDED_BY(lock_);
+  Arena* current_ ABSL_GUARDED_BY(lock_) = nullptr;
+  std::vector<Arena*> free_arenas_ ABSL_GUARDED_BY(lock_);
+  int64_t bytes_allocated_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t max_memory_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t bytes_mapped_ ABSL_GUARDED_BY(lock_) = 0;
+  int64_t num_hugetlb_fallbacks_ ABSL_GUARDED_BY(lock_) = 0;
+};
+
+/**
+ * The pool that table store batches and query allocations come from: a HugePageMemoryPool if
+ * --arrow_huge_pages is set, or arrow's default pool otherwise.
+ */
+arrow::MemoryPool* DataMemoryPool();
+
+/**
+ * The stats of DataMemoryPool(), or an error if it isn't a HugePageMemoryPool.
+ */
+StatusOr<HugePageMemoryPoolStats> DataMemoryPoolStats();
+
+}  // namespace types
+}  // namespace px
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/types/huge_page_memory_pool.h"
+
+#include <arrow/builder.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace types {
+
+constexpr int64_t kHugePageSize = HugePageMemoryPool::kHugePageSize;
+
+TEST(HugePageMemoryPoolTest, SmallAllocationsShareAnArena) {
+  HugePageMemoryPool pool(HugePageMode::kTransparent);
+  std::vector<uint8_t*> buffers(100);
+  for (auto& buffer : buffers) {
+    ASSERT_TRUE(pool.Allocate(1000, &buffer).ok());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer) % 64, 0);
+    std::memset(buffer, 0xab, 1000);
+  }
+
+  HugePageMemoryPoolStats stats = pool.GetStats();
+  EXPECT_EQ(stats.bytes_allocated, 100 * 1000);
+  EXPECT_EQ(stats.bytes_mapped, kHugePageSize);
+  EXPECT_EQ(stats.num_arenas, 1);
+  EXPECT_GT(stats.fragmentation(), 0.9);
+
+  for (auto& buffer : buffers) {
+    pool.Free(buffer, 1000);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+  EXPECT_EQ(pool.max_memory(), 100 * 1000);
+}
+
+TEST(HugePageMemoryPoolTest, FreedArenasAreReused) {
+  HugePageMemoryPool pool(HugePageMode::kTransparent, /*max_free_arenas*/ 1);
+  // Four of these allocations fill an arena.
+  constexpr int64_t kSize = kHugePageSize / 4;
+  std::vector<uint8_t*> buffers(12);
+  for (auto& buffer : buffers) {
+    ASSERT_TRUE(pool.Allocate(kSize, &buffer).ok());
+  }
+  EXPECT_EQ(pool.GetStats().num_arenas, 3);
+
+  // Freeing the first arena's allocations makes it free, and it's kept for reuse.
+  for (int i = 0; i < 4; ++i) {
+    pool.Free(buffers[i], kSize);
+  }
+  EXPECT_EQ(pool.GetStats().num_free_arenas, 1);
+  // Only one free arena is kept, the next one is unmapped.
+  for (int i = 4; i < 8; ++i) {
+    pool.Free(buffers[i], kSize);
+  }
+  EXPECT_EQ(pool.GetStats().num_arenas, 2);
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(pool.Allocate(kSize, &buffers[i]).ok());
+  }
+  EXPECT_EQ(pool.GetStats().num_arenas, 2);
+  EXPECT_EQ(pool.GetStats().num_free_arenas, 0);
+
+  for (int i = 0; i < 4; ++i) {
+    pool.Free(buffers[i], kSize);
+  }
+  for (int i = 8; i < 12; ++i) {
+    pool.Free(buffers[i], kSize);
+  }
+}
+
+TEST(HugePageMemoryPoolTest, LargeAllocationsGetTheirOwnArena) {
+  HugePageMemoryPool pool(HugePageMode::kTransparent);
+  uint8_t* small;
+  uint8_t* large;
+  ASSERT_TRUE(pool.Allocate(100, &small).ok());
+  ASSERT_TRUE(pool.Allocate(3 * 1024 * 1024, &large).ok());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % kHugePageSize, 0);
+
+  HugePageMemoryPoolStats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_arenas, 2);
+  EXPECT_EQ(stats.bytes_mapped, 3 * kHugePageSize);
+
+  pool.Free(large, 3 * 1024 * 1024);
+  EXPECT_EQ(pool.GetStats().bytes_mapped, kHugePageSize);
+  pool.Free(small, 100);
+}
+
+TEST(HugePageMemoryPoolTest, Reallocate) {
+  HugePageMemoryPool pool(HugePageMode::kTransparent);
+  uint8_t* buffer;
+  ASSERT_TRUE(pool.Allocate(100, &buffer).ok());
+  std::memset(buffer, 7, 100);
+
+  // The last allocation of the arena grows in place.
+  uint8_t* prev = buffer;
+  ASSERT_TRUE(pool.Reallocate(100, 1000, &buffer).ok());
+  EXPECT_EQ(buffer, prev);
+
+  uint8_t* other;
+  ASSERT_TRUE(pool.Allocate(100, &other).ok());
+  // Not the last allocation anymore, so it's copied.
+  ASSERT_TRUE(pool.Reallocate(1000, 2000, &buffer).ok());
+  EXPECT_NE(buffer, prev);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(buffer[i], 7);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 2100);
+
+  pool.Free(buffer, 2000);
+  pool.Free(other, 100);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+TEST(HugePageMemoryPoolTest, ZeroSizeAllocation) {
+  HugePageMemoryPool pool(HugePageMode::kTransparent);
+  uint8_t* buffer;
+  ASSERT_TRUE(pool.Allocate(0, &buffer).ok());
+  EXPECT_EQ(pool.GetStats().num_arenas, 0);
+  ASSERT_TRUE(pool.Reallocate(0, 10, &buffer).ok());
+  ASSERT_TRUE(pool.Reallocate(10, 0, &buffer).ok());
+  pool.Free(buffer, 0);
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+TEST(HugePageMemoryPoolTest, ExplicitModeFallsBack) {
+  // Works whether or not the machine has reserved huge pages.
+  HugePageMemoryPool pool(HugePageMode::kExplicit);
+  {
+    arrow::Int64Builder builder(&pool);
+    for (int64_t i = 0; i < 1000000; ++i) {
+      ASSERT_TRUE(builder.Append(i).ok());
+    }
+    std::shared_ptr<arrow::Array> array;
+    ASSERT_TRUE(builder.Finish(&array).ok());
+    auto int_array = std::static_pointer_cast<arrow::Int64Array>(array);
+    EXPECT_EQ(int_array->Value(999999), 999999);
+    EXPECT_GT(pool.bytes_allocated(), 0);
+  }
+  EXPECT_EQ(pool.bytes_allocated(), 0);
+}
+
+}  // namespace types
+}  // namespace px
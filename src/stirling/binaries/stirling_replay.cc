@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/connector_context.h"
+#include "src/stirling/core/data_table.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_event_replayer.h"
+
+// Replays a capture of socket events, written by the socket tracer with
+// --perf_buffer_events_output_path=<file>.bin, through the socket tracer's parsers and stitchers,
+// and logs the throughput, CPU and memory of the replay. No BPF is deployed.
+//
+// Usage: ./stirling_replay [--recorded_pace] [--repeat=<n>] <file>.bin
+
+DEFINE_bool(recorded_pace, false,
+            "If true, replays the events at the pace they were captured at; otherwise, as fast "
+            "as possible.");
+DEFINE_int32(repeat, 1, "The number of times to replay the capture, each with a new connector.");
+
+using ::px::Status;
+using ::px::stirling::DataTable;
+using ::px::stirling::ReadSocketEvents;
+using ::px::stirling::SocketEventReplayer;
+using ::px::stirling::SocketTraceConnector;
+using ::px::stirling::StandaloneContext;
+
+Status Replay(const std::string& path) {
+  PL_ASSIGN_OR_RETURN(auto events, ReadSocketEvents(path));
+  LOG(INFO) << absl::Substitute("Read $0 events from $1.", events.size(), path);
+
+  // The processes of the capture aren't running here.
+  FLAGS_stirling_check_proc_for_conn_close = false;
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    auto connector = SocketTraceConnector::Create("socket_trace_connector");
+    StandaloneContext ctx;
+    std::vector<std::unique_ptr<DataTable>> tables;
+    std::vector<DataTable*> table_ptrs;
+    for (const auto& schema : SocketTraceConnector::kTables) {
+      tables.push_back(std::make_unique<DataTable>(tables.size(), schema));
+      table_ptrs.push_back(tables.back().get());
+    }
+
+    SocketEventReplayer replayer(static_cast<SocketTraceConnector*>(connector.get()), &ctx,
+                                 table_ptrs);
+    SocketEventReplayer::Stats stats = replayer.Replay(
+        events, FLAGS_recorded_pace ? SocketEventReplayer::Pace::kRecorded
+                                    : SocketEventReplayer::Pace::kMaxSpeed);
+    LOG(INFO) << absl::Substitute("Replay $0:\n$1", i, stats.ToString());
+  }
+  return Status::OK();
+}
+
+int main(int argc, char** argv) {
+  px::EnvironmentGuard env_guard(&argc, argv);
+  if (argc != 2) {
+    LOG(ERROR) << "Usage: ./stirling_replay [--recorded_pace] [--repeat=<n>] <file>.bin";
+    return 1;
+  }
+  PL_EXIT_IF_ERROR(Replay(argv[1]));
+  return 0;
+}
@@ -18,12 +18,29 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <bcc/libbpf.h>
+#include <fcntl.h>
+#include <linux/bpf.h>
 #include <linux/perf_event.h>
 #include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
@@ -35,6 +52,10 @@
 DEFINE_bool(
     stirling_always_infer_task_struct_offsets, false,
     "When true, run the task_struct offset resolver even when local/host headers are found.");
+DEFINE_string(stirling_task_struct_offsets_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_TASK_STRUCT_OFFSETS_CACHE_DIR", ""),
+              "A directory that persists across restarts on the host, in which the resolved "
+              "task_struct offsets are cached per kernel release. Disabled if empty.");
 
 namespace px {
 namespace stirling {
@@ -73,6 +94,42 @@ Status MountDebugFS() {
   return Status::OK();
 }
 
+std::filesystem::path TaskStructOffsetsCacheFile() {
+  if (FLAGS_stirling_task_struct_offsets_cache_dir.empty()) {
+    return {};
+  }
+  StatusOr<std::string> uname = utils::GetUname();
+  if (!uname.ok()) {
+    return {};
+  }
+  return std::filesystem::path(FLAGS_stirling_task_struct_offsets_cache_dir) /
+         absl::StrCat("task_struct_offsets-", uname.ValueOrDie());
+}
+
+// The cache file holds "<group_leader_offset> <real_start_time_offset>".
+StatusOr<utils::TaskStructOffsets> ReadCachedTaskStructOffsets(const std::filesystem::path& file) {
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(file));
+  std::vector<std::string_view> fields = absl::StrSplit(contents, ' ', absl::SkipWhitespace());
+  utils::TaskStructOffsets offsets;
+  if (fields.size() != 2 || !absl::SimpleAtoi(fields[0], &offsets.group_leader_offset) ||
+      !absl::SimpleAtoi(fields[1], &offsets.real_start_time_offset)) {
+    return error::Internal("Malformed task_struct offsets cache file $0", file.string());
+  }
+  return offsets;
+}
+
+Status WriteCachedTaskStructOffsets(const std::filesystem::path& file,
+                                    const utils::TaskStructOffsets& offsets) {
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(file.parent_path()));
+  return WriteFileFromString(file, absl::StrCat(offsets.group_leader_offset, " ",
+                                                offsets.real_start_time_offset));
+}
+
+std::mutex& BPFCompilerMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
 StatusOr<utils::TaskStructOffsets> ResolveTaskStructOffsets() {
   constexpr int kNumAttempts = 3;
 
@@ -102,12 +159,48 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets() {
   // local headers, and for testing purposes.
   bool potentially_mismatched_headers = utils::g_packaged_headers_installed;
   if (potentially_mismatched_headers || FLAGS_stirling_always_infer_task_struct_offsets) {
-    LOG(INFO) << "Resolving task_struct offsets.";
-
-    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsets());
-
-    LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
-                                  offsets.group_leader_offset, offsets.real_start_time_offset);
+    // The resolution compiles and runs a BPF program of its own in a subprocess. The offsets can't
+    // change while the process runs, so they are resolved once and shared by all the BCCWrappers.
+    static std::mutex resolved_offsets_mutex;
+    static std::optional<utils::TaskStructOffsets> resolved_offsets;
+
+    std::lock_guard<std::mutex> lock(resolved_offsets_mutex);
+    if (!resolved_offsets.has_value()) {
+      // The offsets only depend on the kernel, so they are cached per kernel release, and later
+      // starts on the same host skip the resolution.
+      const std::filesystem::path cache_file = TaskStructOffsetsCacheFile();
+      StatusOr<utils::TaskStructOffsets> offsets_status =
+          error::NotFound("No task_struct offsets cache.");
+      if (!cache_file.empty()) {
+        offsets_status = ReadCachedTaskStructOffsets(cache_file);
+      }
+
+      // Kernels built with BTF describe their own types, which is much cheaper than resolving
+      // the offsets with a BPF program.
+      if (!offsets_status.ok()) {
+        offsets_status = utils::ReadTaskStructOffsetsFromBTF(
+            system::Config::GetInstance().sysfs_path() / "kernel/btf/vmlinux");
+        LOG_IF(INFO, !offsets_status.ok()) << absl::Substitute(
+            "Could not read task_struct offsets from BTF: $0", offsets_status.msg());
+      }
+
+      if (!offsets_status.ok()) {
+        LOG(INFO) << "Resolving task_struct offsets.";
+        offsets_status = ResolveTaskStructOffsets();
+      }
+      PL_ASSIGN_OR_RETURN(resolved_offsets, offsets_status);
+
+      if (!cache_file.empty()) {
+        Status s = WriteCachedTaskStructOffsets(cache_file, resolved_offsets.value());
+        LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+            "Failed to cache task_struct offsets: $0", s.msg());
+      }
+
+      LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
+                                    resolved_offsets->group_leader_offset,
+                                    resolved_offsets->real_start_time_offset);
+    }
+    offsets = resolved_offsets.value();
   }
 
   return offsets;
@@ -121,7 +214,14 @@ Status BCCWrapper::InitBPFProgram(std::string_view bpf_program, std::vector<std:
     return error::PermissionDenied("BCC currently only supported as the root user.");
   }
 
+  // The lock covers the set-up of the headers and the task_struct offsets, which are shared by
+  // all the BCCWrappers, as well as the compilation. The task_struct resolver forks while it is
+  // held, so no other thread is compiling at that time. The resolver's own program runs in the
+  // forked child, without Linux headers, and must not take the lock again.
+  std::unique_lock<std::mutex> lock(BPFCompilerMutex(), std::defer_lock);
   if (requires_linux_headers) {
+    lock.lock();
+
     PL_ASSIGN_OR_RETURN(utils::KernelVersion kernel_version, utils::GetKernelVersion());
 
     // This function will setup linux headers for BPF code deployment.
@@ -189,6 +289,16 @@ Status BCCWrapper::AttachTracepoint(const TracepointSpec& probe) {
   return Status::OK();
 }
 
+StatusOr<BCCWrapper::UProbeTarget> BCCWrapper::GetUProbeTarget(const UProbeSpec& probe) {
+  struct stat st;
+  if (stat(probe.binary_path.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0 to attach uprobe, errno: $1",
+                           probe.binary_path.string(), errno);
+  }
+  return UProbeTarget(st.st_dev, st.st_ino, probe.symbol, probe.address, probe.pid,
+                      static_cast<int>(probe.attach_type), probe.probe_fn);
+}
+
 Status BCCWrapper::AttachUProbe(const UProbeSpec& probe) {
   VLOG(1) << "Deploying uprobe: " << probe.ToString();
   // TODO(oazizi): Natively support this attach type in BCCWrapper.
@@ -196,9 +306,22 @@ Status BCCWrapper::AttachUProbe(const UProbeSpec& probe) {
   DCHECK((probe.symbol.empty() && probe.address != 0) ||
          (!probe.symbol.empty() && probe.address == 0))
       << "Exactly one of 'symbol' and 'address' must be specified.";
-  PL_RETURN_IF_ERROR(bpf_.attach_uprobe(
+
+  // The kernel attaches uprobes to the inode, so a binary reached through another path (e.g. from
+  // another container sharing the image layer) is already covered by the earlier attachment.
+  PL_ASSIGN_OR_RETURN(UProbeTarget target, GetUProbeTarget(probe));
+  if (!attached_uprobe_targets_.insert(target).second) {
+    VLOG(1) << "Skipping uprobe already attached to the same inode: " << probe.ToString();
+    return Status::OK();
+  }
+
+  ebpf::StatusTuple attach_status = bpf_.attach_uprobe(
       probe.binary_path, probe.symbol, std::string(probe.probe_fn), probe.address,
-      static_cast<bpf_probe_attach_type>(probe.attach_type), probe.pid));
+      static_cast<bpf_probe_attach_type>(probe.attach_type), probe.pid);
+  if (!attach_status.ok()) {
+    attached_uprobe_targets_.erase(target);
+    return StatusAdapter(attach_status);
+  }
   uprobes_.push_back(probe);
   ++num_attached_uprobes_;
   return Status::OK();
@@ -262,6 +385,59 @@ Status BCCWrapper::AttachXDP(const std::string& dev_name, const std::string& fn_
   return Status::OK();
 }
 
+namespace {
+
+// Attaches or detaches a program to a cgroup with the bpf() syscall, since bcc doesn't wrap it.
+int CGroupProgCommand(int bpf_cmd, int prog_fd, int cgroup_fd, CGroupSKBAttachType attach_type) {
+  union bpf_attr attr = {};
+  attr.target_fd = cgroup_fd;
+  attr.attach_bpf_fd = prog_fd;
+  attr.attach_type = static_cast<uint32_t>(attach_type);
+  // Other tools (ie. systemd, cilium) may have their own programs in the same cgroups.
+  attr.attach_flags = bpf_cmd == BPF_PROG_ATTACH ? BPF_F_ALLOW_MULTI : 0;
+  return syscall(__NR_bpf, bpf_cmd, &attr, sizeof(attr));
+}
+
+}  // namespace
+
+Status BCCWrapper::AttachCGroupSKB(const CGroupSKBSpec& spec) {
+  VLOG(1) << "Attaching cgroup skb program: " << spec.ToString();
+  int prog_fd = -1;
+  PL_RETURN_IF_ERROR(bpf_.load_func(spec.probe_fn, BPF_PROG_TYPE_CGROUP_SKB, prog_fd));
+
+  int cgroup_fd = open(spec.cgroup_path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (cgroup_fd < 0) {
+    return error::Internal("Unable to open cgroup $0, errno: $1", spec.cgroup_path.string(),
+                           errno);
+  }
+  if (CGroupProgCommand(BPF_PROG_ATTACH, prog_fd, cgroup_fd, spec.attach_type) != 0) {
+    int attach_errno = errno;
+    close(cgroup_fd);
+    return error::Internal("Unable to attach $0, errno: $1", spec.ToString(), attach_errno);
+  }
+  cgroup_skbs_.push_back({spec, prog_fd, cgroup_fd});
+  return Status::OK();
+}
+
+Status BCCWrapper::AttachCGroupSKBs(const ArrayView<CGroupSKBSpec>& specs) {
+  for (const CGroupSKBSpec& spec : specs) {
+    PL_RETURN_IF_ERROR(AttachCGroupSKB(spec));
+  }
+  return Status::OK();
+}
+
+void BCCWrapper::DetachCGroupSKBs() {
+  for (const auto& attached : cgroup_skbs_) {
+    if (CGroupProgCommand(BPF_PROG_DETACH, attached.prog_fd, attached.cgroup_fd,
+                          attached.spec.attach_type) != 0) {
+      LOG(ERROR) << absl::Substitute("Unable to detach $0, errno: $1", attached.spec.ToString(),
+                                     errno);
+    }
+    close(attached.cgroup_fd);
+  }
+  cgroup_skbs_.clear();
+}
+
 // TODO(PL-1294): This can fail in rare cases. See the cited issue. Find the root cause.
 Status BCCWrapper::DetachKProbe(const KProbeSpec& probe) {
   VLOG(1) << "Detaching kprobe: " << probe.ToString();
@@ -278,6 +454,11 @@ Status BCCWrapper::DetachUProbe(const UProbeSpec& probe) {
     PL_RETURN_IF_ERROR(bpf_.detach_uprobe(probe.binary_path, probe.symbol, probe.address,
                                           static_cast<bpf_probe_attach_type>(probe.attach_type),
                                           probe.pid));
+    // A deleted binary keeps its inode until the uprobe is gone, so it can't be attached again.
+    StatusOr<UProbeTarget> target = GetUProbeTarget(probe);
+    if (target.ok()) {
+      attached_uprobe_targets_.erase(target.ValueOrDie());
+    }
   }
   --num_attached_uprobes_;
   return Status::OK();
@@ -306,6 +487,7 @@ void BCCWrapper::DetachUProbes() {
     LOG_IF(ERROR, !res.ok()) << res.msg();
   }
   uprobes_.clear();
+  attached_uprobe_targets_.clear();
 }
 
 void BCCWrapper::DetachTracepoints() {
@@ -316,7 +498,51 @@ void BCCWrapper::DetachTracepoints() {
   tracepoints_.clear();
 }
 
+bool BCCWrapper::SupportsRingBuffers() {
+  // BPF_MAP_TYPE_RINGBUF was added in kernel 5.8.
+  constexpr uint32_t kMinRingBufferKernelVersionCode = (5 << 16) | (8 << 8);
+  StatusOr<utils::KernelVersion> kernel_version = utils::GetKernelVersion();
+  if (!kernel_version.ok()) {
+    LOG(WARNING) << absl::Substitute("Could not determine the kernel version: $0",
+                                     kernel_version.msg());
+    return false;
+  }
+  return kernel_version.ValueOrDie().code() >= kMinRingBufferKernelVersionCode;
+}
+
+namespace {
+
+}  // namespace
+
+Status BCCWrapper::OpenRingBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+  VLOG(1) << absl::Substitute("Opening ring buffer: $0", perf_buffer.name);
+  int map_fd = bpf_.get_table(perf_buffer.name).get_fd();
+  if (map_fd < 0) {
+    return error::Internal("Could not find ring buffer $0", perf_buffer.name);
+  }
+
+  auto callback = std::make_unique<PerfBufferCallback>(
+      PerfBufferCallback{this, perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn, cb_cookie});
+  auto sample_fn = &BCCWrapper::HandleRingBufferEvent;
+  if (ring_buffers_ == nullptr) {
+    ring_buffers_ = static_cast<::ring_buffer*>(bpf_new_ringbuf(map_fd, sample_fn, callback.get()));
+    if (ring_buffers_ == nullptr) {
+      return error::Internal("Could not open ring buffer $0", perf_buffer.name);
+    }
+  } else if (bpf_add_ringbuf(ring_buffers_, map_fd, sample_fn, callback.get()) < 0) {
+    return error::Internal("Could not open ring buffer $0", perf_buffer.name);
+  }
+  perf_buffer_callbacks_.push_back(std::move(callback));
+  perf_buffers_.push_back(perf_buffer);
+  ++num_open_perf_buffers_;
+  return Status::OK();
+}
+
 Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+  if (perf_buffer.transport == BPFOutputTransport::kRingBuffer) {
+    return OpenRingBuffer(perf_buffer, cb_cookie);
+  }
+
   const int kPageSizeBytes = system::Config::GetInstance().PageSize();
   int num_pages = IntRoundUpDivide(perf_buffer.size_bytes, kPageSizeBytes);
 
@@ -326,9 +552,14 @@ Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_co
   VLOG(1) << absl::Substitute("Opening perf buffer: $0 [requested_size=$1 num_pages=$2 size=$3]",
                               perf_buffer.name, perf_buffer.size_bytes, num_pages,
                               num_pages * kPageSizeBytes);
+  auto callback = std::make_unique<PerfBufferCallback>(
+      PerfBufferCallback{this, perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn, cb_cookie});
+  callback->capacity_bytes = static_cast<size_t>(num_pages) * kPageSizeBytes;
   PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
-                                           perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn,
-                                           cb_cookie, num_pages));
+                                           &BCCWrapper::HandlePerfBufferEvent,
+                                           &BCCWrapper::HandlePerfBufferLoss, callback.get(),
+                                           num_pages));
+  perf_buffer_callbacks_.push_back(std::move(callback));
   perf_buffers_.push_back(perf_buffer);
   ++num_open_perf_buffers_;
   return Status::OK();
@@ -343,17 +574,28 @@ Status BCCWrapper::OpenPerfBuffers(const ArrayView<PerfBufferSpec>& perf_buffers
 
 Status BCCWrapper::ClosePerfBuffer(const PerfBufferSpec& perf_buffer) {
   VLOG(1) << "Closing perf buffer: " << perf_buffer.name;
-  PL_RETURN_IF_ERROR(bpf_.close_perf_buffer(std::string(perf_buffer.name)));
+  // Ring buffers are all closed together in ClosePerfBuffers().
+  if (perf_buffer.transport == BPFOutputTransport::kPerfBuffer) {
+    PL_RETURN_IF_ERROR(bpf_.close_perf_buffer(std::string(perf_buffer.name)));
+  }
   --num_open_perf_buffers_;
   return Status::OK();
 }
 
 void BCCWrapper::ClosePerfBuffers() {
+  StopPerfBufferDrainThread();
+
   for (const PerfBufferSpec& p : perf_buffers_) {
     auto res = ClosePerfBuffer(p);
     LOG_IF(ERROR, !res.ok()) << res.msg();
   }
   perf_buffers_.clear();
+
+  if (ring_buffers_ != nullptr) {
+    bpf_free_ringbuf(ring_buffers_);
+    ring_buffers_ = nullptr;
+  }
+  perf_buffer_callbacks_.clear();
 }
 
 Status BCCWrapper::AttachPerfEvent(const PerfEventSpec& perf_event) {
@@ -406,12 +648,196 @@ void BCCWrapper::PollPerfBuffer(std::string_view perf_buffer_name, int timeout_m
 }
 
 void BCCWrapper::PollPerfBuffers(int timeout_ms) {
+  if (staging_) {
+    DispatchStagedEvents();
+    return;
+  }
   for (const auto& spec : perf_buffers_) {
-    PollPerfBuffer(spec.name, timeout_ms);
+    if (spec.transport == BPFOutputTransport::kPerfBuffer) {
+      PollPerfBuffer(spec.name, timeout_ms);
+    }
+  }
+  if (ring_buffers_ != nullptr) {
+    bpf_poll_ringbuf(ring_buffers_, timeout_ms);
+  }
+}
+
+namespace {
+
+// Upper bound on the bytes of events staged by the drain thread between two PollPerfBuffers()
+// calls. Beyond it, events are dropped and reported through the loss callbacks.
+constexpr size_t kMaxStagedBytes = 256 * 1024 * 1024;
+
+// The drain thread waits this long in epoll for events, which also bounds how long it takes to
+// stop.
+constexpr int kDrainPollTimeoutMs = 10;
+
+}  // namespace
+
+void BCCWrapper::HandlePerfBufferEvent(void* cb_cookie, void* data, int data_size) {
+  auto* callback = static_cast<PerfBufferCallback*>(cb_cookie);
+  BCCWrapper* bcc = callback->bcc;
+  if (!bcc->staging_) {
+    callback->bytes_since_fill_check += data_size;
+    callback->probe_output_fn(callback->cb_cookie, data, data_size);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(bcc->staged_mutex_);
+  callback->bytes_since_fill_check += data_size;
+  if (bcc->staged_data_.size() + data_size > kMaxStagedBytes) {
+    ++callback->num_staging_lost;
+    return;
+  }
+  const size_t offset = bcc->staged_data_.size();
+  const char* bytes = static_cast<const char*>(data);
+  bcc->staged_data_.insert(bcc->staged_data_.end(), bytes, bytes + data_size);
+  bcc->staged_events_.push_back({callback, offset, data_size, 0});
+}
+
+void BCCWrapper::HandlePerfBufferLoss(void* cb_cookie, uint64_t lost) {
+  auto* callback = static_cast<PerfBufferCallback*>(cb_cookie);
+  BCCWrapper* bcc = callback->bcc;
+  if (!bcc->staging_) {
+    callback->lost_since_fill_check = true;
+    callback->probe_loss_fn(callback->cb_cookie, lost);
+    return;
+  }
+
+  // Staged in order with the events, so the callbacks see the loss where it happened.
+  std::lock_guard<std::mutex> lock(bcc->staged_mutex_);
+  callback->lost_since_fill_check = true;
+  bcc->staged_events_.push_back({callback, 0, 0, lost});
+}
+
+double BCCWrapper::TakePerfBufferFill() {
+  // The drain thread counts under the lock; without it, the counts are only touched by the caller.
+  std::lock_guard<std::mutex> lock(staged_mutex_);
+  double fill = 0;
+  for (auto& callback : perf_buffer_callbacks_) {
+    if (callback->lost_since_fill_check) {
+      fill = 1;
+    } else if (callback->capacity_bytes > 0) {
+      fill = std::max(fill, static_cast<double>(callback->bytes_since_fill_check) /
+                                callback->capacity_bytes);
+    }
+    callback->bytes_since_fill_check = 0;
+    callback->lost_since_fill_check = false;
+  }
+  return std::min(fill, 1.0);
+}
+
+int BCCWrapper::HandleRingBufferEvent(void* ctx, void* data, size_t size) {
+  HandlePerfBufferEvent(ctx, data, static_cast<int>(size));
+  return 0;
+}
+
+Status BCCWrapper::StartPerfBufferDrainThread() {
+  if (drain_thread_.joinable()) {
+    return error::AlreadyExists("The perf buffer drain thread is already running");
+  }
+
+  drain_perf_buffers_.clear();
+  for (const auto& spec : perf_buffers_) {
+    if (spec.transport == BPFOutputTransport::kPerfBuffer) {
+      ebpf::BPFPerfBuffer* perf_buffer = bpf_.get_perf_buffer(spec.name);
+      if (perf_buffer == nullptr) {
+        return error::Internal("Could not find perf buffer $0", spec.name);
+      }
+      drain_perf_buffers_.push_back(perf_buffer);
+    }
+  }
+
+  staging_ = true;
+  drain_thread_ = std::thread(&BCCWrapper::DrainPerfBuffersLoop, this);
+  return Status::OK();
+}
+
+void BCCWrapper::DrainPerfBuffersLoop() {
+  while (staging_) {
+    const size_t num_staged_before = [this] {
+      std::lock_guard<std::mutex> lock(staged_mutex_);
+      return staged_events_.size();
+    }();
+
+    for (ebpf::BPFPerfBuffer* perf_buffer : drain_perf_buffers_) {
+      perf_buffer->poll(0);
+    }
+    if (ring_buffers_ != nullptr) {
+      bpf_poll_ringbuf(ring_buffers_, 0);
+    }
+
+    const bool idle = [this, num_staged_before] {
+      std::lock_guard<std::mutex> lock(staged_mutex_);
+      // PollPerfBuffers() may have taken the events in the meantime, which only means that more
+      // work is coming.
+      return staged_events_.size() == num_staged_before;
+    }();
+    if (!idle) {
+      continue;
+    }
+
+    // Nothing arrived, so block in epoll until something does. Only one of the buffers can be
+    // waited on; the first one is the busiest by convention, and the rest are drained when it
+    // wakes up, or at the latest after the timeout.
+    if (!drain_perf_buffers_.empty()) {
+      drain_perf_buffers_.front()->poll(kDrainPollTimeoutMs);
+    } else if (ring_buffers_ != nullptr) {
+      bpf_poll_ringbuf(ring_buffers_, kDrainPollTimeoutMs);
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(kDrainPollTimeoutMs));
+    }
+  }
+}
+
+void BCCWrapper::StopPerfBufferDrainThread() {
+  if (!drain_thread_.joinable()) {
+    return;
+  }
+  staging_ = false;
+  drain_thread_.join();
+  drain_perf_buffers_.clear();
+
+  // The events that were not handed over yet are dropped, like those still in the buffers, since
+  // this runs on Close(), when the owner of the callbacks may already be gone.
+  std::lock_guard<std::mutex> lock(staged_mutex_);
+  staged_events_.clear();
+  staged_data_.clear();
+}
+
+void BCCWrapper::DispatchStagedEvents() {
+  {
+    std::lock_guard<std::mutex> lock(staged_mutex_);
+    std::swap(staged_events_, dispatch_events_);
+    std::swap(staged_data_, dispatch_data_);
+  }
+
+  for (const StagedEvent& event : dispatch_events_) {
+    PerfBufferCallback* callback = event.callback;
+    if (event.lost > 0) {
+      callback->probe_loss_fn(callback->cb_cookie, event.lost);
+    } else {
+      callback->probe_output_fn(callback->cb_cookie, dispatch_data_.data() + event.offset,
+                                event.size);
+    }
+  }
+  dispatch_events_.clear();
+  dispatch_data_.clear();
+
+  for (auto& callback : perf_buffer_callbacks_) {
+    uint64_t num_lost = 0;
+    {
+      std::lock_guard<std::mutex> lock(staged_mutex_);
+      std::swap(num_lost, callback->num_staging_lost);
+    }
+    if (num_lost > 0 && callback->probe_loss_fn != nullptr) {
+      callback->probe_loss_fn(callback->cb_cookie, num_lost);
+    }
   }
 }
 
 void BCCWrapper::Close() {
+  DetachCGroupSKBs();
   DetachPerfEvents();
   ClosePerfBuffers();
   DetachKProbes();
@@ -30,21 +30,31 @@
 #undef DECLARE_ERROR
 #endif
 
+#include <linux/bpf.h>
 #include <linux/perf_event.h>
 
 #include <gtest/gtest_prod.h>
 
+#include <atomic>
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/base/base.h"
 #include "src/stirling/obj_tools/elf_tools.h"
 
+// libbpf's ring buffer manager, as used through bcc's bpf_*_ringbuf() functions.
+struct ring_buffer;
+
 DECLARE_uint32(stirling_bpf_perf_buffer_page_count);
 DECLARE_bool(stirling_always_infer_task_struct_offsets);
 
@@ -135,6 +145,29 @@ struct TracepointSpec {
   }
 };
 
+/**
+ * Which packets of the processes in a cgroup a BPF_PROG_TYPE_CGROUP_SKB program sees.
+ */
+enum class CGroupSKBAttachType {
+  kIngress = BPF_CGROUP_INET_INGRESS,
+  kEgress = BPF_CGROUP_INET_EGRESS,
+};
+
+/**
+ * Describes a socket buffer program attached to a cgroup (v2), which runs for the packets of the
+ * cgroup and all its descendants.
+ */
+struct CGroupSKBSpec {
+  std::filesystem::path cgroup_path;
+  CGroupSKBAttachType attach_type;
+  std::string probe_fn;
+
+  std::string ToString() const {
+    return absl::Substitute("[cgroup=$0 type=$1 probe=$2]", cgroup_path.string(),
+                            magic_enum::enum_name(attach_type), probe_fn);
+  }
+};
+
 /**
  * Describes a sampling probe that triggers according to a time period.
  * This is in contrast to KProbes and UProbes, which trigger based on
@@ -148,12 +181,24 @@ struct SamplingProbeSpec {
   uint64_t period_millis;
 };
 
+/**
+ * The kind of BPF map through which events are returned to user-space.
+ */
+enum class BPFOutputTransport {
+  // A per-CPU perf buffer, declared in the probe code with BPF_PERF_OUTPUT.
+  kPerfBuffer,
+  // A single ring buffer shared by all CPUs, declared in the probe code with
+  // BPF_RINGBUF_OUTPUT. Requires kernel 5.8+ (see BCCWrapper::SupportsRingBuffers()).
+  kRingBuffer,
+};
+
 /**
  * Describes a BPF perf buffer, through which data is returned to user-space.
  */
 struct PerfBufferSpec {
   // Name of the perf buffer.
-  // Must be the same as the perf buffer name declared in the probe code with BPF_PERF_OUTPUT.
+  // Must be the same as the perf buffer name declared in the probe code with BPF_PERF_OUTPUT
+  // (or BPF_RINGBUF_OUTPUT for ring buffers).
   std::string name;
 
   // Function that will be called for every event in the perf buffer,
@@ -161,10 +206,15 @@ struct PerfBufferSpec {
   perf_reader_raw_cb probe_output_fn;
 
   // Function that will be called if there are lost/clobbered perf events.
+  // For ring buffers, whose events are dropped on the BPF side when the buffer is full, it is only
+  // called for the events dropped by the drain thread (see StartPerfBufferDrainThread()).
   perf_reader_lost_cb probe_loss_fn;
 
   // Size of perf buffer. Will be rounded up to and allocated in a power of 2 number of pages.
+  // Ring buffers are sized in the probe code instead, so this is ignored for them.
   int size_bytes = 1024 * 1024;
+
+  BPFOutputTransport transport = BPFOutputTransport::kPerfBuffer;
 };
 
 /**
@@ -186,6 +236,14 @@ struct PerfEventSpec {
   uint64_t sample_period;
 };
 
+/**
+ * Held while compiling BPF programs. The clang frontends of BCC and bpftrace keep process-wide
+ * state, so programs are compiled one at a time, even when source connectors are initialized
+ * concurrently. Attaching the probes, which takes most of the rest of the start-up, is not
+ * serialized.
+ */
+std::mutex& BPFCompilerMutex();
+
 /**
  * Wrapper around BCC, as a convenience.
  */
@@ -219,7 +277,8 @@ class BCCWrapper {
   Status AttachKProbe(const KProbeSpec& probe);
 
   /**
-   * Attach a single uprobe.
+   * Attach a single uprobe. Does nothing if the same uprobe is already attached to the binary,
+   * including through a different path to the same file.
    * @param probe Specifications of the uprobe (attach point, trace function, etc.).
    * @return Error if probe fails to attach.
    */
@@ -248,6 +307,11 @@ class BCCWrapper {
    */
   Status OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie = nullptr);
 
+  /**
+   * Returns true if the running kernel supports BPF ring buffers (BPF_MAP_TYPE_RINGBUF).
+   */
+  static bool SupportsRingBuffers();
+
   /**
    * Attach a perf event, which runs a probe every time a perf counter reaches a threshold
    * condition.
@@ -282,6 +346,17 @@ class BCCWrapper {
    */
   Status AttachXDP(const std::string& dev_name, const std::string& fn_name);
 
+  /**
+   * Attaches a socket buffer program to a cgroup. It is detached by Close().
+   */
+  Status AttachCGroupSKB(const CGroupSKBSpec& spec);
+
+  /**
+   * Convenience function that attaches multiple cgroup socket buffer programs.
+   * @return Error of first program to fail to attach (remaining programs are not attempted).
+   */
+  Status AttachCGroupSKBs(const ArrayView<CGroupSKBSpec>& specs);
+
   /**
    * Convenience function that opens multiple perf buffers.
    * @param probes Vector of perf buffer descriptors.
@@ -324,6 +399,24 @@ class BCCWrapper {
    */
   void PollPerfBuffers(int timeout_ms = 0);
 
+  /**
+   * Starts a thread that drains the opened perf and ring buffers as events arrive, so they don't
+   * fill up between calls to PollPerfBuffers() under bursts of events. The thread only copies the
+   * events out; PollPerfBuffers() then hands them to the callbacks of the PerfBufferSpecs on the
+   * calling thread, as before. The thread waits in epoll while the buffers are idle.
+   *
+   * Must be called after all the buffers are opened. Close() stops the thread.
+   */
+  Status StartPerfBufferDrainThread();
+
+  /**
+   * Returns how full the perf buffers got since the last call, as the largest fraction of the
+   * capacity of a buffer that its events took up, or 1 if any events were lost. A perf buffer has
+   * one such buffer per CPU, and the events of all CPUs are counted against one of them, since
+   * they can all come from the same CPU. Ring buffers only count their losses.
+   */
+  double TakePerfBufferFill();
+
   /**
    * Detaches all probes, and closes all perf buffers that are open.
    */
@@ -339,6 +432,9 @@ class BCCWrapper {
     return bpf_.get_array_table<TValueType>(table_name);
   }
 
+  // Untyped access, for tables whose key and value types are only known at run-time.
+  ebpf::BPFTable GetTable(const std::string& table_name) { return bpf_.get_table(table_name); }
+
   ebpf::BPFStackTable GetStackTable(const std::string& table_name) {
     return bpf_.get_stack_table(table_name);
   }
@@ -361,6 +457,7 @@ class BCCWrapper {
   Status DetachUProbe(const UProbeSpec& probe);
   Status DetachTracepoint(const TracepointSpec& probe);
   Status ClosePerfBuffer(const PerfBufferSpec& perf_buffer);
+  Status OpenRingBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie);
   Status DetachPerfEvent(const PerfEventSpec& perf_event);
   void PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms);
 
@@ -371,16 +468,80 @@ class BCCWrapper {
   void DetachTracepoints();
   void ClosePerfBuffers();
   void DetachPerfEvents();
+  void DetachCGroupSKBs();
 
   // Returns the name that identifies the target to attach this k-probe.
   std::string GetKProbeTargetName(const KProbeSpec& probe);
 
+  // Identifies what a uprobe is attached to: the device and inode of the binary, and the rest of
+  // the spec except for the path.
+  using UProbeTarget =
+      std::tuple<uint64_t, uint64_t, std::string, uint64_t, pid_t, int, std::string>;
+  static StatusOr<UProbeTarget> GetUProbeTarget(const UProbeSpec& probe);
+
   std::vector<KProbeSpec> kprobes_;
   std::vector<UProbeSpec> uprobes_;
+  absl::flat_hash_set<UProbeTarget> attached_uprobe_targets_;
   std::vector<TracepointSpec> tracepoints_;
   std::vector<PerfBufferSpec> perf_buffers_;
   std::vector<PerfEventSpec> perf_events_;
 
+  struct AttachedCGroupSKB {
+    CGroupSKBSpec spec;
+    int prog_fd;
+    int cgroup_fd;
+  };
+  std::vector<AttachedCGroupSKB> cgroup_skbs_;
+
+  // The callback of each opened ring buffer. Owned here, because libbpf keeps a pointer to it.
+  // The callbacks of each opened perf or ring buffer, which bcc and libbpf call through
+  // HandlePerfBufferEvent() and HandlePerfBufferLoss(). Owned here, because they keep a pointer.
+  struct PerfBufferCallback {
+    BCCWrapper* bcc;
+    perf_reader_raw_cb probe_output_fn;
+    perf_reader_lost_cb probe_loss_fn;
+    void* cb_cookie;
+    // Events dropped because too many were staged by the drain thread.
+    uint64_t num_staging_lost = 0;
+    // The size of each per-CPU buffer of a perf buffer. 0 for ring buffers.
+    size_t capacity_bytes = 0;
+    // For TakePerfBufferFill(). Guarded by staged_mutex_ while the drain thread runs.
+    size_t bytes_since_fill_check = 0;
+    bool lost_since_fill_check = false;
+  };
+  std::vector<std::unique_ptr<PerfBufferCallback>> perf_buffer_callbacks_;
+
+  static void HandlePerfBufferEvent(void* cb_cookie, void* data, int data_size);
+  static void HandlePerfBufferLoss(void* cb_cookie, uint64_t lost);
+  static int HandleRingBufferEvent(void* ctx, void* data, size_t size);
+
+  void DrainPerfBuffersLoop();
+  void StopPerfBufferDrainThread();
+  void DispatchStagedEvents();
+
+  // An event copied out by the drain thread, which is in staged_data_ at [offset, offset+size).
+  struct StagedEvent {
+    PerfBufferCallback* callback;
+    size_t offset;
+    int size;
+    uint64_t lost;
+  };
+
+  // While true, the callbacks stage the events instead of handling them.
+  std::atomic<bool> staging_ = false;
+  std::thread drain_thread_;
+  std::vector<ebpf::BPFPerfBuffer*> drain_perf_buffers_;
+  // Guards staged_events_ and staged_data_, which the drain thread appends to, and
+  // PollPerfBuffers() swaps out.
+  std::mutex staged_mutex_;
+  std::vector<StagedEvent> staged_events_;
+  std::vector<char> staged_data_;
+  // Only used by PollPerfBuffers(), to reuse their memory.
+  std::vector<StagedEvent> dispatch_events_;
+  std::vector<char> dispatch_data_;
+  // All opened ring buffers are polled through this one libbpf ring buffer manager.
+  ::ring_buffer* ring_buffers_ = nullptr;
+
   std::string system_headers_include_dir_;
 
   ebpf::BPF bpf_;
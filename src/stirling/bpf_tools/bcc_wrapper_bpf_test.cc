@@ -18,6 +18,10 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 #include "src/common/testing/testing.h"
@@ -116,6 +120,34 @@ TEST(BCCWrapperTest, DetachUProbe) {
   }
 }
 
+TEST(BCCWrapperTest, UProbeAttachedOncePerInode) {
+  DummyExeWrapper dummy_exe;
+  TempDir temp_dir;
+  const std::filesystem::path link_path = temp_dir.path() / "dummy_exe_link";
+  ASSERT_OK(fs::CreateSymlink(dummy_exe.path(), link_path));
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(kBCCProgram));
+
+  UProbeSpec spec = {
+      .binary_path = dummy_exe.path(),
+      .symbol = "CanYouFindThis",
+      .probe_fn = "foo",
+  };
+  ASSERT_OK(bcc_wrapper.AttachUProbe(spec));
+  EXPECT_EQ(1, bcc_wrapper.num_attached_probes());
+
+  // The same file through another path is not attached again.
+  spec.binary_path = link_path;
+  ASSERT_OK(bcc_wrapper.AttachUProbe(spec));
+  EXPECT_EQ(1, bcc_wrapper.num_attached_probes());
+
+  // A different probe on the same file is.
+  spec.attach_type = BPFProbeAttachType::kReturn;
+  ASSERT_OK(bcc_wrapper.AttachUProbe(spec));
+  EXPECT_EQ(2, bcc_wrapper.num_attached_probes());
+}
+
 TEST(BCCWrapperTest, GetTGIDStartTime) {
   // Force the TaskStructResolver to run,
   // since we're trying to check that it correctly gets the task_struct offsets.
@@ -241,6 +273,58 @@ int on_sched_process_exit(struct tracepoint__sched__sched_process_exit* args) {
   ASSERT_OK(bcc_wrapper.AttachTracepoint(probe_spec));
 }
 
+TEST(BCCWrapperTest, PerfBufferDrainThread) {
+  std::string_view program = R"BCC(
+    BPF_PERF_OUTPUT(events);
+    int emit_event(struct pt_regs* ctx) {
+      uint64_t id = bpf_get_current_pid_tgid();
+      events.perf_submit(ctx, &id, sizeof(id));
+      return 0;
+    }
+  )BCC";
+
+  struct Received {
+    std::vector<std::thread::id> thread_ids;
+    uint64_t num_lost = 0;
+  } received;
+  auto handle_event = [](void* cb_cookie, void* /*data*/, int /*data_size*/) {
+    static_cast<Received*>(cb_cookie)->thread_ids.push_back(std::this_thread::get_id());
+  };
+  auto handle_loss = [](void* cb_cookie, uint64_t lost) {
+    static_cast<Received*>(cb_cookie)->num_lost += lost;
+  };
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program));
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "emit_event"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+  ASSERT_OK(bcc_wrapper.OpenPerfBuffer({"events", handle_event, handle_loss}, &received));
+  ASSERT_OK(bcc_wrapper.StartPerfBufferDrainThread());
+
+  constexpr int kNumEvents = 10000;
+  for (int i = 0; i < kNumEvents; ++i) {
+    BCCWrapperTestProbeTrigger();
+  }
+
+  // The events are drained in the background, but only handed to the callback on this thread.
+  for (int i = 0; i < 100 && received.thread_ids.size() + received.num_lost < kNumEvents; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bcc_wrapper.PollPerfBuffers();
+  }
+  EXPECT_EQ(received.thread_ids.size(), kNumEvents);
+  EXPECT_EQ(received.num_lost, 0);
+  for (std::thread::id thread_id : received.thread_ids) {
+    ASSERT_EQ(thread_id, std::this_thread::get_id());
+  }
+
+  bcc_wrapper.Close();
+}
+
 }  // namespace bpf_tools
 }  // namespace stirling
 }  // namespace px
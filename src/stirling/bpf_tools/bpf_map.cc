@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/bpf_map.h"
+
+#include <linux/bpf.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+namespace {
+
+// The kernel's internal ENOTSUPP, returned for map types without batch operations.
+constexpr int kENOTSUPP = 524;
+
+std::atomic<bool> batch_map_ops_supported{true};
+
+}  // namespace
+
+bool BatchMapOpsSupported() { return batch_map_ops_supported; }
+
+StatusOr<uint32_t> MapLookupBatch(int map_fd, bool delete_entries, void* in_batch,
+                                  void* out_batch, void* keys, void* values, uint32_t count,
+                                  bool* done) {
+  // bcc doesn't wrap the batch commands, so this uses the bpf() syscall directly.
+  union bpf_attr attr = {};
+  attr.batch.map_fd = map_fd;
+  attr.batch.in_batch = reinterpret_cast<uint64_t>(in_batch);
+  attr.batch.out_batch = reinterpret_cast<uint64_t>(out_batch);
+  attr.batch.keys = reinterpret_cast<uint64_t>(keys);
+  attr.batch.values = reinterpret_cast<uint64_t>(values);
+  attr.batch.count = count;
+
+  const int cmd = delete_entries ? BPF_MAP_LOOKUP_AND_DELETE_BATCH : BPF_MAP_LOOKUP_BATCH;
+  if (syscall(__NR_bpf, cmd, &attr, sizeof(attr)) == 0) {
+    *done = false;
+    return attr.batch.count;
+  }
+
+  // ENOENT marks the end of the map. The entries of the last batch are still copied.
+  if (errno == ENOENT) {
+    *done = true;
+    return attr.batch.count;
+  }
+  if (errno == EINVAL || errno == kENOTSUPP || errno == EOPNOTSUPP) {
+    batch_map_ops_supported = false;
+  }
+  return error::Internal("Batch lookup on BPF map failed, errno: $0", errno);
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
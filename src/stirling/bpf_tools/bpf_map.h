@@ -0,0 +1,199 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+/**
+ * Runs one BPF_MAP_LOOKUP_BATCH command on the map, or BPF_MAP_LOOKUP_AND_DELETE_BATCH if
+ * delete_entries is true, which copies up to count entries into keys and values.
+ *
+ * @param in_batch nullptr for the first batch, then the out_batch of the previous batch.
+ * @param out_batch Receives the position of the next batch. Must hold at least 8 bytes.
+ * @param done Set to true once the last entries of the map were copied.
+ * @return The number of entries copied. An error if the kernel doesn't support batch operations
+ *         on the map (5.6+ for hash maps), in which case BatchMapOpsSupported() becomes false.
+ */
+StatusOr<uint32_t> MapLookupBatch(int map_fd, bool delete_entries, void* in_batch,
+                                  void* out_batch, void* keys, void* values, uint32_t count,
+                                  bool* done);
+
+/**
+ * Returns false once the kernel has rejected a batch map operation.
+ */
+bool BatchMapOpsSupported();
+
+/**
+ * Reads all the entries of the hash map, and deletes them if clear_table is true.
+ *
+ * The entries are copied out kBatchSize at a time with batch map operations, rather than with
+ * two syscalls per entry as in BPFHashTable::get_table_offline(), which is only used as the
+ * fallback on older kernels.
+ */
+template <typename TKey, typename TValue>
+std::vector<std::pair<TKey, TValue>> ReadHashTable(ebpf::BPFHashTable<TKey, TValue>* table,
+                                                   bool clear_table = false) {
+  constexpr uint32_t kBatchSize = 4096;
+
+  if (!BatchMapOpsSupported()) {
+    return table->get_table_offline(clear_table);
+  }
+
+  std::vector<std::pair<TKey, TValue>> entries;
+  std::vector<TKey> keys(kBatchSize);
+  std::vector<TValue> values(kBatchSize);
+  uint64_t in_batch = 0;
+  uint64_t out_batch = 0;
+  bool first_batch = true;
+  bool done = false;
+  while (!done) {
+    StatusOr<uint32_t> num_entries =
+        MapLookupBatch(table->get_fd(), clear_table, first_batch ? nullptr : &in_batch, &out_batch,
+                       keys.data(), values.data(), kBatchSize, &done);
+    if (!num_entries.ok()) {
+      VLOG(1) << absl::Substitute("Batch map lookup failed, reading entries one at a time: $0",
+                                  num_entries.msg());
+      // Deleted entries are gone from the map, so only the rest is read. Otherwise, start over.
+      if (!clear_table) {
+        entries.clear();
+      }
+      for (auto& entry : table->get_table_offline(clear_table)) {
+        entries.push_back(std::move(entry));
+      }
+      return entries;
+    }
+    for (uint32_t i = 0; i < num_entries.ValueOrDie(); ++i) {
+      entries.emplace_back(keys[i], values[i]);
+    }
+    in_batch = out_batch;
+    first_batch = false;
+  }
+  return entries;
+}
+
+/**
+ * A copy of the contents of a BPF hash map in user space, which tracks what changed between
+ * reads. Keys and values are compared bytewise, as BPF does.
+ *
+ * Connectors that scan a whole map periodically can use the diff to only handle the entries
+ * that were added or changed (or that did not change) since the previous scan.
+ */
+template <typename TKey, typename TValue>
+class BPFMapMirror {
+ public:
+  static_assert(std::is_trivially_copyable_v<TKey> && std::is_trivially_copyable_v<TValue>);
+
+  struct Diff {
+    std::vector<TKey> added;
+    std::vector<TKey> changed;
+    std::vector<TKey> unchanged;
+    std::vector<TKey> removed;
+
+    void Clear() {
+      added.clear();
+      changed.clear();
+      unchanged.clear();
+      removed.clear();
+    }
+  };
+
+  explicit BPFMapMirror(ebpf::BPFHashTable<TKey, TValue>* table) : table_(table) {}
+
+  /**
+   * Reads the map, and returns how it changed since the previous call.
+   */
+  const Diff& Sync() { return Sync(ReadHashTable(table_)); }
+
+  /**
+   * Replaces the mirror with the snapshot, and returns how it differs from the previous one.
+   */
+  const Diff& Sync(const std::vector<std::pair<TKey, TValue>>& snapshot) {
+    diff_.Clear();
+    next_entries_.clear();
+    for (const auto& [key, value] : snapshot) {
+      auto iter = entries_.find(key);
+      if (iter == entries_.end()) {
+        diff_.added.push_back(key);
+      } else {
+        if (std::memcmp(&iter->second, &value, sizeof(TValue)) == 0) {
+          diff_.unchanged.push_back(key);
+        } else {
+          diff_.changed.push_back(key);
+        }
+        entries_.erase(iter);
+      }
+      next_entries_.emplace(key, value);
+    }
+    for (const auto& [key, value] : entries_) {
+      diff_.removed.push_back(key);
+    }
+    // Keep both maps, to reuse their memory on the next call.
+    std::swap(entries_, next_entries_);
+    return diff_;
+  }
+
+  const Diff& diff() const { return diff_; }
+
+  /**
+   * Returns the value of the key as of the last Sync(), or nullptr if it wasn't in the map.
+   */
+  const TValue* Find(const TKey& key) const {
+    auto iter = entries_.find(key);
+    return iter == entries_.end() ? nullptr : &iter->second;
+  }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct BytesHash {
+    size_t operator()(const TKey& key) const {
+      return absl::Hash<std::string_view>()(
+          std::string_view(reinterpret_cast<const char*>(&key), sizeof(TKey)));
+    }
+  };
+  struct BytesEq {
+    bool operator()(const TKey& a, const TKey& b) const {
+      return std::memcmp(&a, &b, sizeof(TKey)) == 0;
+    }
+  };
+  using EntryMap = absl::flat_hash_map<TKey, TValue, BytesHash, BytesEq>;
+
+  ebpf::BPFHashTable<TKey, TValue>* table_;
+  EntryMap entries_;
+  EntryMap next_entries_;
+  Diff diff_;
+};
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/bpf_map.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace bpf_tools {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+constexpr char kBCCProgram[] = R"BCC(
+  BPF_HASH(test_map, uint64_t, uint64_t, 131072);
+)BCC";
+
+constexpr uint64_t kNumEntries = 100000;
+
+class BPFMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK(bcc_wrapper_.InitBPFProgram(kBCCProgram));
+    test_map_ = std::make_unique<ebpf::BPFHashTable<uint64_t, uint64_t>>(
+        bcc_wrapper_.GetHashTable<uint64_t, uint64_t>("test_map"));
+  }
+
+  void Fill(uint64_t num_entries, uint64_t value_offset) {
+    for (uint64_t i = 0; i < num_entries; ++i) {
+      ASSERT_OK(test_map_->update_value(i, i + value_offset));
+    }
+  }
+
+  BCCWrapper bcc_wrapper_;
+  std::unique_ptr<ebpf::BPFHashTable<uint64_t, uint64_t>> test_map_;
+};
+
+TEST_F(BPFMapTest, ReadHashTable) {
+  Fill(kNumEntries, 1);
+
+  std::vector<std::pair<uint64_t, uint64_t>> entries = ReadHashTable(test_map_.get());
+  ASSERT_EQ(entries.size(), kNumEntries);
+  std::sort(entries.begin(), entries.end());
+  for (uint64_t i = 0; i < kNumEntries; ++i) {
+    EXPECT_EQ(entries[i].first, i);
+    EXPECT_EQ(entries[i].second, i + 1);
+  }
+  // Reading leaves the entries in the map.
+  EXPECT_EQ(ReadHashTable(test_map_.get()).size(), kNumEntries);
+}
+
+TEST_F(BPFMapTest, DrainHashTable) {
+  Fill(kNumEntries, 1);
+
+  EXPECT_EQ(ReadHashTable(test_map_.get(), /*clear_table*/ true).size(), kNumEntries);
+  EXPECT_THAT(ReadHashTable(test_map_.get()), IsEmpty());
+}
+
+TEST_F(BPFMapTest, EmptyHashTable) {
+  EXPECT_THAT(ReadHashTable(test_map_.get()), IsEmpty());
+  EXPECT_THAT(ReadHashTable(test_map_.get(), /*clear_table*/ true), IsEmpty());
+}
+
+TEST_F(BPFMapTest, Mirror) {
+  BPFMapMirror<uint64_t, uint64_t> mirror(test_map_.get());
+
+  ASSERT_OK(test_map_->update_value(1, 10));
+  ASSERT_OK(test_map_->update_value(2, 20));
+  ASSERT_OK(test_map_->update_value(3, 30));
+  {
+    const auto& diff = mirror.Sync();
+    EXPECT_THAT(diff.added, UnorderedElementsAre(1, 2, 3));
+    EXPECT_THAT(diff.changed, IsEmpty());
+    EXPECT_THAT(diff.unchanged, IsEmpty());
+    EXPECT_THAT(diff.removed, IsEmpty());
+  }
+
+  ASSERT_OK(test_map_->update_value(2, 21));
+  ASSERT_OK(test_map_->remove_value(3));
+  ASSERT_OK(test_map_->update_value(4, 40));
+  {
+    const auto& diff = mirror.Sync();
+    EXPECT_THAT(diff.added, ElementsAre(4));
+    EXPECT_THAT(diff.changed, ElementsAre(2));
+    EXPECT_THAT(diff.unchanged, ElementsAre(1));
+    EXPECT_THAT(diff.removed, ElementsAre(3));
+  }
+
+  EXPECT_EQ(mirror.size(), 3);
+  ASSERT_NE(mirror.Find(2), nullptr);
+  EXPECT_EQ(*mirror.Find(2), 21);
+  EXPECT_EQ(mirror.Find(3), nullptr);
+}
+
+TEST(BPFMapMirrorTest, SyncSnapshot) {
+  BPFMapMirror<uint32_t, uint64_t> mirror(nullptr);
+
+  mirror.Sync({{1, 100}, {2, 200}});
+  const auto& diff = mirror.Sync({{2, 200}, {5, 500}});
+  EXPECT_THAT(diff.added, ElementsAre(5));
+  EXPECT_THAT(diff.changed, IsEmpty());
+  EXPECT_THAT(diff.unchanged, ElementsAre(2));
+  EXPECT_THAT(diff.removed, ElementsAre(1));
+}
+
+}  // namespace bpf_tools
+}  // namespace stirling
+}  // namespace px
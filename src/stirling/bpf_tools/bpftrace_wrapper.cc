@@ -26,10 +26,12 @@
 #include <bpftrace/src/procmon.h>
 #include <bpftrace/src/tracepoint_format_parser.h>
 
+#include <mutex>
 #include <sstream>
 
 #include "src/common/base/base.h"
 #include "src/common/system/config.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/utils/linux_headers.h"
 
 namespace px {
@@ -62,6 +64,8 @@ Status BPFTraceWrapper::CompileForMapOutput(std::string_view script,
 }
 
 Status BPFTraceWrapper::Compile(std::string_view script, const std::vector<std::string>& params) {
+  std::lock_guard<std::mutex> lock(BPFCompilerMutex());
+
   int err;
   int success;
   bpftrace::Driver driver(bpftrace_);
@@ -235,6 +239,17 @@ bpftrace::BPFTraceMap BPFTraceWrapper::GetBPFMap(const std::string& name) {
   return bpftrace_.get_map(name);
 }
 
+StatusOr<BPFTraceMapType> BPFTraceWrapper::GetBPFMapType(const std::string& name) const {
+  DCHECK(compiled_) << "Must compile first.";
+
+  auto iter = bpftrace_.maps_.find(name);
+  if (iter == bpftrace_.maps_.end()) {
+    return error::NotFound("The BPFTrace program has no map named $0.", name);
+  }
+  const bpftrace::IMap& map = *iter->second;
+  return BPFTraceMapType{map.key_.args_, map.type_};
+}
+
 }  // namespace bpf_tools
 }  // namespace stirling
 }  // namespace px
@@ -35,6 +35,14 @@ namespace bpf_tools {
 // Dump the bpftrace program's syntax data and other relevant internal process data.
 std::string DumpDriver(const bpftrace::Driver& driver);
 
+/**
+ * The key and value types of a BPFTrace map, as inferred by the semantic analyser.
+ */
+struct BPFTraceMapType {
+  std::vector<bpftrace::SizedType> key_types;
+  bpftrace::SizedType value_type;
+};
+
 /**
  * Wrapper around BPFTrace, as a convenience.
  */
@@ -97,6 +105,11 @@ class BPFTraceWrapper {
    */
   bpftrace::BPFTraceMap GetBPFMap(const std::string& name);
 
+  /**
+   * Returns the types of the specified map, using BPFTrace name. Only valid after compiling.
+   */
+  StatusOr<BPFTraceMapType> GetBPFMapType(const std::string& name) const;
+
  protected:
   bpftrace::BPFtrace bpftrace_;
   std::unique_ptr<bpftrace::BpfOrc> bpforc_;
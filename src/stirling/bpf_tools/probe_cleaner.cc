@@ -17,12 +17,16 @@
  */
 
 #include <fcntl.h>
+#include <unistd.h>
 
-#include <fstream>
-#include <sstream>
+#include <cerrno>
+#include <cstring>
 #include <string>
 #include <utility>
 
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/probe_cleaner.h"
 
@@ -33,36 +37,100 @@ namespace utils {
 const char kAttachedKProbesFile[] = "/sys/kernel/debug/tracing/kprobe_events";
 const char kAttachedUProbesFile[] = "/sys/kernel/debug/tracing/uprobe_events";
 
-Status SearchForAttachedProbes(const char* file_path, std::string_view marker,
-                               std::vector<std::string>* leaked_probes) {
-  std::ifstream infile(file_path);
-  if (!infile.good()) {
-    return error::Internal("Failed to open file for reading: $0", file_path);
+namespace {
+
+// Returns true if the probe was attached by the process with the given PID. BCC names the probe
+// events after the PID of the process that attached them, as one of the '_'-separated tokens.
+bool AttachedByPID(std::string_view probe, std::string_view pid) {
+  for (std::string_view token : absl::StrSplit(probe, absl::ByAnyChar("_/:"))) {
+    if (token == pid) {
+      return true;
+    }
   }
-  std::string line;
-  while (std::getline(infile, line)) {
-    if (absl::StrContains(line, marker)) {
-      std::vector<std::string> split = absl::StrSplit(line, ' ');
-      if (split.size() != 2) {
-        return error::Internal("Unexpected format when reading file: $0", file_path);
-      }
+  return false;
+}
 
-      std::string probe = std::move(split[0]);
+bool MatchesOwner(std::string_view probe, ProbeOwner owner) {
+  if (owner == ProbeOwner::kAny) {
+    return true;
+  }
+  const bool this_process = AttachedByPID(probe, std::to_string(getpid()));
+  return (owner == ProbeOwner::kThisProcess) == this_process;
+}
 
-      // Note that a probe looks like the following:
-      //     [p|r]:kprobes/your_favorite_probe_name_here __x64_sys_connect
-      // Perform a quick (but not thorough) sanity check that we have the right format.
-      // Detailed format: https://www.kernel.org/doc/html/latest/trace/kprobetrace.html.
-      if (probe[0] != 'p' && probe[0] != 'r') {
-        continue;
-      }
+}  // namespace
 
-      leaked_probes->push_back(std::move(probe));
+Status SearchForAttachedProbes(const char* file_path, std::string_view marker,
+                               std::vector<std::string>* leaked_probes, ProbeOwner owner) {
+  // The whole file is read at once, as it may list many thousands of probes.
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(file_path));
+  for (std::string_view line : absl::StrSplit(contents, '\n', absl::SkipEmpty())) {
+    if (!absl::StrContains(line, marker)) {
+      continue;
+    }
+    std::vector<std::string_view> split = absl::StrSplit(line, ' ');
+    if (split.size() != 2) {
+      return error::Internal("Unexpected format when reading file: $0", file_path);
+    }
+
+    std::string_view probe = split[0];
+
+    // Note that a probe looks like the following:
+    //     [p|r]:kprobes/your_favorite_probe_name_here __x64_sys_connect
+    // Perform a quick (but not thorough) sanity check that we have the right format.
+    // Detailed format: https://www.kernel.org/doc/html/latest/trace/kprobetrace.html.
+    if (probe.empty() || (probe[0] != 'p' && probe[0] != 'r')) {
+      continue;
     }
+    if (!MatchesOwner(probe, owner)) {
+      continue;
+    }
+
+    leaked_probes->emplace_back(probe);
   }
   return Status::OK();
 }
 
+std::vector<std::string> BatchProbeRemovals(const std::vector<std::string>& probes,
+                                            size_t max_batch_bytes) {
+  std::vector<std::string> batches;
+  std::string batch;
+  for (const auto& probe : probes) {
+    std::vector<std::string_view> parts = absl::StrSplit(probe, absl::MaxSplits(':', 1));
+    if (parts.size() != 2) {
+      VLOG(1) << "Unexpected probe string format";
+      continue;
+    }
+    std::string delete_probe = absl::StrCat("-:", parts[1], "\n");
+    if (!batch.empty() && batch.size() + delete_probe.size() > max_batch_bytes) {
+      batches.push_back(std::move(batch));
+      batch.clear();
+    }
+    batch.append(delete_probe);
+  }
+  if (!batch.empty()) {
+    batches.push_back(std::move(batch));
+  }
+  return batches;
+}
+
+namespace {
+
+// Writes all of buf, which holds newline-terminated commands. The kernel may consume fewer bytes
+// than written, stopping at the last complete command.
+bool WriteCommands(int fd, std::string_view buf) {
+  while (!buf.empty()) {
+    ssize_t n = write(fd, buf.data(), buf.size());
+    if (n <= 0) {
+      return false;
+    }
+    buf.remove_prefix(n);
+  }
+  return true;
+}
+
+}  // namespace
+
 Status RemoveProbes(const char* file_path, std::vector<std::string> probes) {
   // Unfortunately std::ofstream doesn't properly append to /sys/kernel/debug/tracing/kprobe_events.
   // It appears related to its use of fopen() instead of open().
@@ -72,20 +140,18 @@ Status RemoveProbes(const char* file_path, std::vector<std::string> probes) {
     return error::Internal("Failed to open file for writing: $0", file_path);
   }
 
-  std::vector<std::string> errors;
-  for (auto& probe : probes) {
-    std::vector<std::string_view> parts = absl::StrSplit(probe, absl::MaxSplits(':', 1));
-    if (parts.size() != 2) {
-      VLOG(1) << "Unexpected probe string format";
+  // Many removals are issued with each write, rather than one write per probe. The kernel stops
+  // processing a write at the first command that fails, so a failed batch is retried one probe at
+  // a time, to still remove the others.
+  for (const std::string& batch : BatchProbeRemovals(probes, kMaxProbeRemovalBatchBytes)) {
+    if (WriteCommands(fd, batch)) {
       continue;
     }
-
-    std::string delete_probe = absl::StrCat("-:", parts[1]);
-    VLOG(1) << absl::Substitute("Writing $0", delete_probe);
-
-    if (write(fd, delete_probe.data(), delete_probe.size()) < 0) {
-      VLOG(1) << absl::Substitute("Failed to write '$0' to file: $1 [errno=$2 message=$3]",
-                                  delete_probe, file_path, errno, std::strerror(errno));
+    for (std::string_view delete_probe : absl::StrSplit(batch, '\n', absl::SkipEmpty())) {
+      if (write(fd, delete_probe.data(), delete_probe.size()) < 0) {
+        VLOG(1) << absl::Substitute("Failed to write '$0' to file: $1 [errno=$2 message=$3]",
+                                    delete_probe, file_path, errno, std::strerror(errno));
+      }
     }
     // Note that even if write succeeds, it doesn't confirm that the probe was properly removed.
     // We can only confirm that we wrote to the file.
@@ -98,16 +164,16 @@ Status RemoveProbes(const char* file_path, std::vector<std::string> probes) {
 
 namespace {
 
-Status CleanProbesFromSysFile(const char* file_path, std::string_view marker) {
+Status CleanProbesFromSysFile(const char* file_path, std::string_view marker, ProbeOwner owner) {
   LOG(INFO) << absl::Substitute("Cleaning probes from $0 with the following marker: $1", file_path,
                                 marker);
 
   std::vector<std::string> leaked_probes;
-  PL_RETURN_IF_ERROR(SearchForAttachedProbes(file_path, marker, &leaked_probes));
+  PL_RETURN_IF_ERROR(SearchForAttachedProbes(file_path, marker, &leaked_probes, owner));
   PL_RETURN_IF_ERROR(RemoveProbes(file_path, leaked_probes));
 
   std::vector<std::string> leaked_probes_after;
-  PL_RETURN_IF_ERROR(SearchForAttachedProbes(file_path, marker, &leaked_probes_after));
+  PL_RETURN_IF_ERROR(SearchForAttachedProbes(file_path, marker, &leaked_probes_after, owner));
   if (!leaked_probes_after.empty()) {
     return error::Internal("Wasn't able to remove all probes. Initial count=$0, final count=$1",
                            leaked_probes.size(), leaked_probes_after.size());
@@ -119,9 +185,9 @@ Status CleanProbesFromSysFile(const char* file_path, std::string_view marker) {
 
 }  // namespace
 
-Status CleanProbes(std::string_view marker) {
-  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedKProbesFile, marker));
-  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedUProbesFile, marker));
+Status CleanProbes(std::string_view marker, ProbeOwner owner) {
+  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedKProbesFile, marker, owner));
+  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedUProbesFile, marker, owner));
   return Status::OK();
 }
 
@@ -29,6 +29,20 @@ namespace utils {
 
 static constexpr char kPixieBPFProbeMarker[] = "__pixie__";
 
+// The kernel copies writes to the probe event files in chunks of 4KB (WRITE_BUFSIZE), and drops
+// a command split across two chunks, so batches are kept below that.
+static constexpr size_t kMaxProbeRemovalBatchBytes = 4000;
+
+// Selects probes by the process that attached them.
+enum class ProbeOwner {
+  kAny,
+  // The probes attached by this process. These are only leftovers if a previous instance ran
+  // with the same PID, and would collide with the probes this instance attaches.
+  kThisProcess,
+  // The probes attached by other processes, e.g. leaked by previous instances.
+  kOtherProcesses,
+};
+
 /**
  * Reads sysfs to create a list of currently deployed probes with the specified marker in the name.
  *
@@ -36,11 +50,20 @@ static constexpr char kPixieBPFProbeMarker[] = "__pixie__";
  * so this function is primarily used to search for leaked Stirling probes.
  *
  * @param marker a marker that must be in the probe name for it be returned.
+ * @param owner the process that attached the probes.
  *
  * @return vector of probe names.
  */
 Status SearchForAttachedProbes(const char* file_path, std::string_view marker,
-                               std::vector<std::string>* leaked_probes);
+                               std::vector<std::string>* leaked_probes,
+                               ProbeOwner owner = ProbeOwner::kAny);
+
+/**
+ * Returns the commands to remove the probes, joined into batches of up to max_batch_bytes, each of
+ * which can be written to the probe event file at once.
+ */
+std::vector<std::string> BatchProbeRemovals(const std::vector<std::string>& probes,
+                                            size_t max_batch_bytes);
 
 /**
  * Removes the specified probes using the provided names.
@@ -58,11 +81,13 @@ Status RemoveProbes(const char* file_path, std::vector<std::string> probes);
  * Searches for and removes any kprobe with the specified marker.
  *
  * @param marker a marker that must be in the probe name for it be returned.
+ * @param owner the process that attached the probes.
  *
  * @return error if issues accessing sysfs, or if there are still probes leftover after the cleanup
  * process.
  */
-Status CleanProbes(std::string_view marker = kPixieBPFProbeMarker);
+Status CleanProbes(std::string_view marker = kPixieBPFProbeMarker,
+                   ProbeOwner owner = ProbeOwner::kAny);
 
 }  // namespace utils
 }  // namespace stirling
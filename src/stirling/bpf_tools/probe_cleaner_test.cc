@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/probe_cleaner.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+using ::testing::ElementsAre;
+using ::testing::SizeIs;
+
+class ProbeCleanerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const std::string pid = std::to_string(getpid());
+    events_file_ = (temp_dir_.path() / "kprobe_events").string();
+    ASSERT_OK(WriteFileFromString(
+        events_file_,
+        absl::StrCat("p:kprobes/p_tcp_sendmsg_bcc_", pid, "__pixie__ tcp_sendmsg\n",
+                     "r:kprobes/r_tcp_sendmsg_bcc_1234__pixie__ tcp_sendmsg\n",
+                     "p:kprobes/p_tcp_sendmsg_bcc_1234 tcp_sendmsg\n",
+                     "p:kprobes/p_tcp_sendmsg_bcc_", pid, "4__pixie__ tcp_sendmsg\n")));
+  }
+
+  testing::TempDir temp_dir_;
+  std::string events_file_;
+};
+
+TEST_F(ProbeCleanerTest, SearchForAttachedProbes) {
+  const std::string pid = std::to_string(getpid());
+
+  std::vector<std::string> probes;
+  ASSERT_OK(SearchForAttachedProbes(events_file_.c_str(), kPixieBPFProbeMarker, &probes));
+  EXPECT_THAT(probes, SizeIs(3));
+
+  probes.clear();
+  ASSERT_OK(SearchForAttachedProbes(events_file_.c_str(), kPixieBPFProbeMarker, &probes,
+                                    ProbeOwner::kThisProcess));
+  EXPECT_THAT(probes, ElementsAre(absl::StrCat("p:kprobes/p_tcp_sendmsg_bcc_", pid, "__pixie__")));
+
+  probes.clear();
+  ASSERT_OK(SearchForAttachedProbes(events_file_.c_str(), kPixieBPFProbeMarker, &probes,
+                                    ProbeOwner::kOtherProcesses));
+  EXPECT_THAT(probes, ElementsAre("r:kprobes/r_tcp_sendmsg_bcc_1234__pixie__",
+                                  absl::StrCat("p:kprobes/p_tcp_sendmsg_bcc_", pid, "4__pixie__")));
+}
+
+TEST_F(ProbeCleanerTest, RemoveProbes) {
+  ASSERT_OK(WriteFileFromString(events_file_, ""));
+  ASSERT_OK(RemoveProbes(events_file_.c_str(), {"p:kprobes/foo", "r:kprobes/bar"}));
+  ASSERT_OK_AND_EQ(ReadFileToString(events_file_), "-:kprobes/foo\n-:kprobes/bar\n");
+}
+
+TEST(BatchProbeRemovalsTest, SplitsAtLineBoundaries) {
+  EXPECT_THAT(BatchProbeRemovals({}, 32), ::testing::IsEmpty());
+  EXPECT_THAT(BatchProbeRemovals({"p:kprobes/aaaa", "r:kprobes/bbbb", "p:kprobes/cccc"}, 32),
+              ElementsAre("-:kprobes/aaaa\n-:kprobes/bbbb\n", "-:kprobes/cccc\n"));
+  // A removal longer than the limit gets its own batch, and malformed probes are skipped.
+  EXPECT_THAT(BatchProbeRemovals({"p:kprobes/aaaa", "bad", "p:kprobes/cccc"}, 8),
+              ElementsAre("-:kprobes/aaaa\n", "-:kprobes/cccc\n"));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -28,6 +28,7 @@
 #include "src/common/system/proc_parser.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
+#include "src/stirling/utils/btf.h"
 #include "src/stirling/utils/proc_path_tools.h"
 
 #include "src/stirling/bpf_tools/bcc_bpf_intf/types.h"
@@ -293,6 +294,22 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets() {
   }
 }
 
+StatusOr<TaskStructOffsets> ReadTaskStructOffsetsFromBTF(const std::filesystem::path& vmlinux_btf) {
+  PL_ASSIGN_OR_RETURN(std::string btf, ReadFileToString(vmlinux_btf));
+
+  TaskStructOffsets offsets;
+  PL_ASSIGN_OR_RETURN(offsets.group_leader_offset,
+                      BTFStructMemberOffset(btf, "task_struct", "group_leader"));
+  // The member was renamed from real_start_time to start_boottime in Linux 5.5.
+  StatusOr<uint64_t> start_boottime_offset =
+      BTFStructMemberOffset(btf, "task_struct", "start_boottime");
+  if (!start_boottime_offset.ok()) {
+    start_boottime_offset = BTFStructMemberOffset(btf, "task_struct", "real_start_time");
+  }
+  PL_ASSIGN_OR_RETURN(offsets.real_start_time_offset, start_boottime_offset);
+  return offsets;
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <filesystem>
 #include <string>
 
 #include "src/common/base/base.h"
@@ -67,6 +68,16 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets();
  */
 StatusOr<TaskStructOffsets> ResolveTaskStructOffsetsCore();
 
+/**
+ * Reads the task struct offsets from the kernel's BTF type information, which is available at
+ * /sys/kernel/btf/vmlinux on kernels built with CONFIG_DEBUG_INFO_BTF.
+ *
+ * Unlike ResolveTaskStructOffsets(), this doesn't run any BPF program.
+ *
+ * @param vmlinux_btf Path to the BTF of the kernel.
+ */
+StatusOr<TaskStructOffsets> ReadTaskStructOffsetsFromBTF(const std::filesystem::path& vmlinux_btf);
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
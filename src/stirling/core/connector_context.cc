@@ -21,6 +21,86 @@
 namespace px {
 namespace stirling {
 
+uint64_t UPIDDeltaLog::Update(uint64_t md_epoch, const absl::flat_hash_set<md::UPID>& upids) {
+  absl::MutexLock lock(&mutex_);
+
+  if (last_md_epoch_.has_value()) {
+    if (md_epoch == last_md_epoch_.value()) {
+      return epoch_;
+    }
+    if (md_epoch < last_md_epoch_.value()) {
+      // Another thread already recorded a newer snapshot.
+      return 0;
+    }
+  }
+  last_md_epoch_ = md_epoch;
+
+  Entry entry;
+  entry.epoch = ++epoch_;
+  for (const auto& upid : upids) {
+    if (upids_.erase(upid) == 0) {
+      entry.delta.added.insert(upid);
+    }
+  }
+  // What's left of the previous UPIDs was removed.
+  entry.delta.removed = std::move(upids_);
+  upids_ = upids;
+
+  entries_.push_back(std::move(entry));
+  if (entries_.size() > max_epochs_) {
+    entries_.pop_front();
+  }
+  return epoch_;
+}
+
+std::optional<UPIDDelta> UPIDDeltaLog::GetDelta(uint64_t from, uint64_t to) const {
+  absl::MutexLock lock(&mutex_);
+
+  if (from == 0 || to == 0 || from > to || to > epoch_) {
+    return std::nullopt;
+  }
+  // The entries hold the consecutive epochs up to epoch_.
+  const uint64_t first_epoch = epoch_ - entries_.size() + 1;
+  if (from + 1 < first_epoch) {
+    return std::nullopt;
+  }
+
+  UPIDDelta delta;
+  for (uint64_t epoch = from + 1; epoch <= to; ++epoch) {
+    const UPIDDelta& step = entries_[epoch - first_epoch].delta;
+    for (const auto& upid : step.removed) {
+      if (delta.added.erase(upid) == 0) {
+        delta.removed.insert(upid);
+      }
+    }
+    for (const auto& upid : step.added) {
+      if (delta.removed.erase(upid) == 0) {
+        delta.added.insert(upid);
+      }
+    }
+  }
+  return delta;
+}
+
+void ConnectorContext::UpdateProcTracker(ProcTracker* tracker) const {
+  const uint64_t epoch = GetUPIDsEpoch();
+  if (epoch != 0 && tracker->epoch() != 0) {
+    std::optional<UPIDDelta> delta = GetUPIDsDelta(tracker->epoch());
+    if (delta.has_value()) {
+      tracker->UpdateFromEvents(delta->added, delta->removed, epoch);
+      return;
+    }
+  }
+  tracker->Update(GetUPIDs(), epoch);
+}
+
+std::optional<UPIDDelta> AgentContext::GetUPIDsDelta(uint64_t since_epoch) const {
+  if (upid_delta_log_ == nullptr || upids_epoch_ == 0) {
+    return std::nullopt;
+  }
+  return upid_delta_log_->GetDelta(since_epoch, upids_epoch_);
+}
+
 std::vector<CIDRBlock> AgentContext::GetClusterCIDRs() {
   std::vector<CIDRBlock> cluster_cidrs;
 
@@ -18,11 +18,16 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
 #include "src/shared/types/types.h"
@@ -37,6 +42,62 @@ namespace stirling {
  */
 absl::flat_hash_set<md::UPID> ListUPIDs(const std::filesystem::path& proc_path, uint32_t asid = 0);
 
+/**
+ * The UPIDs added and removed between two epochs of the context's UPIDs.
+ */
+struct UPIDDelta {
+  absl::flat_hash_set<md::UPID> added;
+  absl::flat_hash_set<md::UPID> removed;
+};
+
+/**
+ * UPIDDeltaLog versions the UPIDs of the metadata snapshots given to the contexts, and keeps the
+ * changes between the recent versions. The full sets are diffed once per metadata snapshot here,
+ * rather than by every connector on every iteration, and connectors catch up from the epoch they
+ * last saw by merging the changes since. Thread-safe, since each connector thread makes its own
+ * contexts.
+ */
+class UPIDDeltaLog {
+ public:
+  static constexpr size_t kDefaultMaxEpochs = 64;
+
+  explicit UPIDDeltaLog(size_t max_epochs = kDefaultMaxEpochs) : max_epochs_(max_epochs) {}
+
+  /**
+   * Records the UPIDs of a metadata snapshot, if it is newer than the last one recorded.
+   * @param md_epoch The epoch of the metadata snapshot.
+   * @return the epoch of upids, or 0 if the snapshot is older than the last one recorded, in
+   * which case upids are not versioned.
+   */
+  uint64_t Update(uint64_t md_epoch, const absl::flat_hash_set<md::UPID>& upids);
+
+  /**
+   * Returns the changes from the UPIDs of epoch from to those of epoch to, or nullopt if they are
+   * no longer kept.
+   */
+  std::optional<UPIDDelta> GetDelta(uint64_t from, uint64_t to) const;
+
+ private:
+  struct Entry {
+    uint64_t epoch;
+    // The changes from the previous epoch to this one.
+    UPIDDelta delta;
+  };
+
+  const size_t max_epochs_;
+
+  mutable absl::Mutex mutex_;
+  std::optional<uint64_t> last_md_epoch_ ABSL_GUARDED_BY(mutex_);
+  uint64_t epoch_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::flat_hash_set<md::UPID> upids_ ABSL_GUARDED_BY(mutex_);
+  std::deque<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+/**
+ * Called with the pid of a process that started or exited.
+ */
+using PIDChangedCallback = std::function<void(uint32_t pid)>;
+
 /**
  * ConnectorContext is the information passed on every Transfer call to source connectors.
  */
@@ -54,10 +115,30 @@ class ConnectorContext {
    */
   virtual const absl::flat_hash_set<md::UPID>& GetUPIDs() const = 0;
 
+  /**
+   * Return the epoch of GetUPIDs(), which is different whenever the UPIDs may have changed,
+   * or 0 if the UPIDs are not versioned.
+   */
+  virtual uint64_t GetUPIDsEpoch() const { return 0; }
+
+  /**
+   * Return the UPIDs added and removed from the given epoch to GetUPIDsEpoch(),
+   * or nullopt if they are not known, in which case the caller has to use GetUPIDs().
+   */
+  virtual std::optional<UPIDDelta> GetUPIDsDelta(uint64_t /* since_epoch */) const {
+    return std::nullopt;
+  }
+
+  /**
+   * Brings the tracker up to date with GetUPIDs(). The changes since the epoch of the tracker's
+   * last update are applied when they are known, rather than diffing the full set of UPIDs.
+   */
+  void UpdateProcTracker(ProcTracker* tracker) const;
+
   /**
    * Return detailed information on UPIDs.
    */
-  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const = 0;
+  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const = 0;
 
   /**
    * Return K8s information (Pod and container information)
@@ -72,6 +153,12 @@ class ConnectorContext {
    * tracing.
    */
   virtual std::vector<CIDRBlock> GetClusterCIDRs() = 0;
+
+  /**
+   * Reports a process that started or exited, as seen by a connector, so that the metadata can
+   * be updated without waiting to rediscover it.
+   */
+  virtual void NotifyPIDChanged(uint32_t /* pid */) {}
 };
 
 /**
@@ -83,10 +170,20 @@ class AgentContext : public ConnectorContext {
    * ConnectorContext with metadata state.
    * @param agent_metadata_state A read-only snapshot view of the metadata state. This state
    * should not be held onto for extended periods of time.
+   * @param upid_delta_log Versions the UPIDs of the snapshot, if not null.
+   * @param pid_changed_callback Receives the processes reported by NotifyPIDChanged(), if set.
    */
-  explicit AgentContext(std::shared_ptr<const md::AgentMetadataState> agent_metadata_state)
-      : agent_metadata_state_(std::move(agent_metadata_state)) {
+  explicit AgentContext(std::shared_ptr<const md::AgentMetadataState> agent_metadata_state,
+                        UPIDDeltaLog* upid_delta_log = nullptr,
+                        PIDChangedCallback pid_changed_callback = nullptr)
+      : agent_metadata_state_(std::move(agent_metadata_state)),
+        upid_delta_log_(upid_delta_log),
+        pid_changed_callback_(std::move(pid_changed_callback)) {
     DCHECK(agent_metadata_state_ != nullptr);
+    if (upid_delta_log_ != nullptr) {
+      upids_epoch_ = upid_delta_log_->Update(agent_metadata_state_->epoch_id(),
+                                             agent_metadata_state_->upids());
+    }
   }
 
   uint32_t GetASID() const override { return agent_metadata_state_->asid(); }
@@ -95,7 +192,11 @@ class AgentContext : public ConnectorContext {
     return agent_metadata_state_->upids();
   }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
+  uint64_t GetUPIDsEpoch() const override { return upids_epoch_; }
+
+  std::optional<UPIDDelta> GetUPIDsDelta(uint64_t since_epoch) const override;
+
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const override {
     return agent_metadata_state_->pids_by_upid();
   }
 
@@ -105,8 +206,17 @@ class AgentContext : public ConnectorContext {
 
   std::vector<CIDRBlock> GetClusterCIDRs() override;
 
+  void NotifyPIDChanged(uint32_t pid) override {
+    if (pid_changed_callback_ != nullptr) {
+      pid_changed_callback_(pid);
+    }
+  }
+
  private:
   std::shared_ptr<const md::AgentMetadataState> agent_metadata_state_;
+  UPIDDeltaLog* upid_delta_log_;
+  PIDChangedCallback pid_changed_callback_;
+  uint64_t upids_epoch_ = 0;
 };
 
 /**
@@ -127,8 +237,8 @@ class StandaloneContext : public ConnectorContext {
 
   const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return upids_; }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
-    static const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr> kEmpty;
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const override {
+    static const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr> kEmpty;
     return kEmpty;
   }
 
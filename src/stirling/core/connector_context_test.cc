@@ -23,6 +23,8 @@
 #include "src/common/testing/testing.h"
 
 using ::px::testing::TestFilePath;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
 
 namespace px {
@@ -35,5 +37,92 @@ TEST(ListUPIDs, Basic) {
                                    md::UPID{0, 456, 17594622}, md::UPID{0, 789, 46120203}));
 }
 
+using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+const md::UPID kUPID1 = md::UPID(0, 1, 111);
+const md::UPID kUPID2 = md::UPID(0, 2, 222);
+const md::UPID kUPID3 = md::UPID(0, 3, 333);
+
+TEST(UPIDDeltaLog, MergesDeltas) {
+  UPIDDeltaLog log;
+
+  EXPECT_EQ(log.Update(/* md_epoch */ 10, UPIDSet{kUPID1, kUPID2}), 1UL);
+  // The same snapshot keeps its epoch.
+  EXPECT_EQ(log.Update(10, UPIDSet{kUPID1, kUPID2}), 1UL);
+  EXPECT_EQ(log.Update(11, UPIDSet{kUPID1, kUPID3}), 2UL);
+  EXPECT_EQ(log.Update(12, UPIDSet{kUPID3}), 3UL);
+  // An older snapshot is not versioned.
+  EXPECT_EQ(log.Update(11, UPIDSet{kUPID1, kUPID3}), 0UL);
+
+  std::optional<UPIDDelta> delta = log.GetDelta(1, 2);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_THAT(delta->added, UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(delta->removed, UnorderedElementsAre(kUPID2));
+
+  delta = log.GetDelta(1, 3);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_THAT(delta->added, UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(delta->removed, UnorderedElementsAre(kUPID1, kUPID2));
+
+  delta = log.GetDelta(3, 3);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_THAT(delta->added, IsEmpty());
+  EXPECT_THAT(delta->removed, IsEmpty());
+
+  EXPECT_FALSE(log.GetDelta(0, 3).has_value());
+  EXPECT_FALSE(log.GetDelta(3, 4).has_value());
+}
+
+TEST(UPIDDeltaLog, Eviction) {
+  UPIDDeltaLog log(/* max_epochs */ 2);
+
+  log.Update(1, UPIDSet{kUPID1});
+  log.Update(2, UPIDSet{kUPID1, kUPID2});
+  log.Update(3, UPIDSet{kUPID1, kUPID2, kUPID3});
+
+  // The changes into epoch 2 were evicted.
+  EXPECT_FALSE(log.GetDelta(1, 3).has_value());
+  std::optional<UPIDDelta> delta = log.GetDelta(2, 3);
+  ASSERT_TRUE(delta.has_value());
+  EXPECT_THAT(delta->added, UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(delta->removed, IsEmpty());
+}
+
+TEST(AgentContext, UpdateProcTracker) {
+  UPIDDeltaLog log;
+  ProcTracker tracker;
+
+  auto md_state = std::make_shared<md::AgentMetadataState>(/* asid */ 0);
+  md_state->set_epoch_id(1);
+  md_state->AddUPID(kUPID1, std::make_unique<md::PIDInfo>(kUPID1, "cmdline", "container0_uid"));
+  md_state->AddUPID(kUPID2, std::make_unique<md::PIDInfo>(kUPID2, "cmdline", "container0_uid"));
+  AgentContext(md_state, &log).UpdateProcTracker(&tracker);
+  EXPECT_EQ(tracker.epoch(), 1UL);
+  EXPECT_THAT(tracker.new_upids(), UnorderedElementsAre(kUPID1, kUPID2));
+
+  md_state = std::make_shared<md::AgentMetadataState>(/* asid */ 0);
+  md_state->set_epoch_id(2);
+  md_state->AddUPID(kUPID2, std::make_unique<md::PIDInfo>(kUPID2, "cmdline", "container0_uid"));
+  md_state->AddUPID(kUPID3, std::make_unique<md::PIDInfo>(kUPID3, "cmdline", "container0_uid"));
+  AgentContext(md_state, &log).UpdateProcTracker(&tracker);
+  EXPECT_EQ(tracker.epoch(), 2UL);
+  EXPECT_THAT(tracker.upids(), UnorderedElementsAre(kUPID2, kUPID3));
+  EXPECT_THAT(tracker.new_upids(), UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(tracker.deleted_upids(), UnorderedElementsAre(kUPID1));
+}
+
+TEST(AgentContext, NotifyPIDChanged) {
+  auto md_state = std::make_shared<md::AgentMetadataState>(/* asid */ 0);
+  std::vector<uint32_t> changed_pids;
+  AgentContext ctx(md_state, /* upid_delta_log */ nullptr,
+                   [&changed_pids](uint32_t pid) { changed_pids.push_back(pid); });
+  ctx.NotifyPIDChanged(123);
+  ctx.NotifyPIDChanged(456);
+  EXPECT_THAT(changed_pids, ElementsAre(123, 456));
+
+  // Without a callback, the notifications are dropped.
+  AgentContext(md_state).NotifyPIDChanged(789);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -17,11 +17,13 @@
  */
 
 #include <algorithm>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/base/worker_pool.h"
 #include "src/shared/types/type_utils.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/types.h"
@@ -33,7 +35,36 @@ namespace stirling {
 using types::ColumnWrapper;
 using types::DataType;
 
-DataTable::DataTable(uint64_t id, const DataTableSchema& schema) : id_(id), table_schema_(schema) {}
+namespace {
+
+// Below this many values (rows times columns), handing the columns to the worker pool costs more
+// than gathering them on the calling thread.
+constexpr size_t kMinValuesForParallelGather = 64 * 1024;
+
+// Gathers the given indexes out of every column, one column per worker pool iteration.
+types::ColumnWrapperRecordBatch MoveIndexes(types::ColumnWrapperRecordBatch* records,
+                                            const std::vector<size_t>& indexes) {
+  types::ColumnWrapperRecordBatch out(records->size());
+  auto move_column = [&](size_t i) { out[i] = (*records)[i]->MoveIndexes(indexes); };
+  if (indexes.size() * records->size() < kMinValuesForParallelGather) {
+    for (size_t i = 0; i < records->size(); ++i) {
+      move_column(i);
+    }
+  } else {
+    WorkerPool::Default()->ParallelFor(records->size(), move_column);
+  }
+  return out;
+}
+
+}  // namespace
+
+DataTable::DataTable(uint64_t id, const DataTableSchema& schema)
+    : id_(id),
+      table_schema_(schema),
+      consume_records_probe_(utils::PerfStats::GetInstance().GetProbe(
+          absl::StrCat(schema.name(), ".consume_records"))) {}
+
+DataTable::~DataTable() { utils::PerfStats::GetInstance().ReleaseProbe(consume_records_probe_); }
 
 void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
   DCHECK(record_batch_ptr != nullptr);
@@ -59,14 +90,48 @@ Tablet* DataTable::GetTablet(types::TabletIDView tablet_id) {
   return &tablet;
 }
 
+StatusOr<DataPushHandle*> DataTable::GetPushHandle(const types::TabletID& tablet_id,
+                                                   const DataPushHandleResolver& resolver) {
+  DataPushHandle* handle = tablet_id.empty() ? &default_push_handle_ : &push_handles_[tablet_id];
+  if (*handle == nullptr) {
+    StatusOr<DataPushHandle> resolved = resolver(id_, tablet_id);
+    if (!resolved.ok()) {
+      // Don't leave an empty entry behind, so that the next push retries.
+      push_handles_.erase(tablet_id);
+      return resolved.status();
+    }
+    *handle = std::move(resolved.ValueOrDie());
+  }
+  return handle;
+}
+
 std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
+  utils::ScopedPerfTimer timer(consume_records_probe_);
   std::vector<TaggedRecordBatch> tablets_out;
   absl::flat_hash_map<types::TabletID, Tablet> carryover_tablets;
   uint64_t next_start_time = start_time_;
 
   for (auto& [tablet_id, tablet] : tablets_) {
-    // Sort based on times.
-    std::vector<size_t> sort_indexes = utils::SortedIndexes(tablet.times);
+    // Sort based on times. Records are usually appended in order, in which case the sort is
+    // skipped, and sort_indexes is left empty. Otherwise, the ascending runs are merged.
+    const bool sorted = tablet.sorted();
+    std::vector<size_t> sort_indexes;
+    if (!sorted) {
+      sort_indexes = utils::SortedIndexesFromRuns(tablet.times, tablet.run_starts);
+    }
+
+    // Returns the indexes of the records in [begin, end) in sorted order.
+    auto sorted_range = [&sorted, &sort_indexes](size_t begin, size_t end) {
+      if (!sorted) {
+        return std::vector<size_t>(sort_indexes.begin() + begin, sort_indexes.begin() + end);
+      }
+      std::vector<size_t> indexes(end - begin);
+      std::iota(indexes.begin(), indexes.end(), begin);
+      return indexes;
+    };
+    auto sorted_index = [&sorted, &sort_indexes](size_t i) {
+      return sorted ? i : sort_indexes[i];
+    };
 
     // End time is cutoff time + 1, so call to SplitSortedVector() produces the following
     // classification: which classified according to:
@@ -80,47 +145,48 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
     // 2) Pushable indexes: these are the ones that we return.
     // 3) Carryover indexes: these are too new to return, so hold on to them until the next round.
     auto positions =
-        utils::SplitSortedVector<2>(tablet.times, sort_indexes, {start_time_, end_time});
+        sorted ? utils::SplitSortedVector<2>(tablet.times, {start_time_, end_time})
+               : utils::SplitSortedVector<2>(tablet.times, sort_indexes, {start_time_, end_time});
+    size_t num_records = tablet.times.size();
     int num_expired = positions[0];
     int num_pushable = positions[1] - positions[0];
-    int num_carryover = tablet.times.size() - positions[1];
+    int num_carryover = num_records - positions[1];
 
     // Case 1: Expired records. Just print a message.
     VLOG_IF(1, num_expired > 0) << absl::Substitute(
         "$0 records for table $1 dropped due to late arrival [cutoff time=$2, oldest event "
         "time=$3].",
-        num_expired, table_schema_.name(), end_time, tablet.times[sort_indexes[0]]);
+        num_expired, table_schema_.name(), end_time, tablet.times[sorted_index(0)]);
 
     // Case 2: Pushable records. Copy to output.
     if (num_pushable > 0) {
-      // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
-                                       sort_indexes.end() - num_carryover);
       types::ColumnWrapperRecordBatch pushable_records;
-      for (auto& col : tablet.records) {
-        pushable_records.push_back(col->MoveIndexes(push_indexes));
+      if (sorted && static_cast<size_t>(num_pushable) == num_records) {
+        // All records are pushed, and are already in order, so the columns are pushed as is.
+        pushable_records = std::move(tablet.records);
+      } else {
+        std::vector<size_t> push_indexes = sorted_range(positions[0], positions[1]);
+        pushable_records = MoveIndexes(&tablet.records, push_indexes);
       }
-      uint64_t last_time = tablet.times[push_indexes.back()];
+      uint64_t last_time = tablet.times[sorted_index(positions[1] - 1)];
       next_start_time = std::max(next_start_time, last_time);
       tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
     }
 
     // Case 3: Carryover records.
     if (num_carryover > 0) {
-      // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> carryover_indexes(sort_indexes.begin() + num_pushable,
-                                            sort_indexes.end());
-      types::ColumnWrapperRecordBatch carryover_records;
-      for (auto& col : tablet.records) {
-        carryover_records.push_back(col->MoveIndexes(carryover_indexes));
-      }
-
-      std::vector<uint64_t> times(carryover_indexes.size());
-      for (size_t i = 0; i < times.size(); ++i) {
-        times[i] = tablet.times[carryover_indexes[i]];
+      std::vector<size_t> carryover_indexes = sorted_range(positions[1], num_records);
+      types::ColumnWrapperRecordBatch carryover_records =
+          MoveIndexes(&tablet.records, carryover_indexes);
+
+      // The carryover records are in order, so their tablet starts out sorted.
+      Tablet& carryover_tablet = carryover_tablets[tablet_id];
+      carryover_tablet.tablet_id = tablet_id;
+      carryover_tablet.times.resize(carryover_indexes.size());
+      for (size_t i = 0; i < carryover_indexes.size(); ++i) {
+        carryover_tablet.times[i] = tablet.times[carryover_indexes[i]];
       }
-      carryover_tablets[tablet_id] =
-          Tablet{tablet_id, std::move(times), std::move(carryover_records)};
+      carryover_tablet.records = std::move(carryover_records);
     }
   }
   tablets_ = std::move(carryover_tablets);
@@ -29,6 +29,7 @@
 #include "src/common/base/base.h"
 #include "src/common/base/mixins.h"
 #include "src/stirling/core/types.h"
+#include "src/stirling/utils/perf_stats.h"
 
 namespace px {
 namespace stirling {
@@ -43,16 +44,29 @@ struct TaggedRecordBatch {
 
 struct Tablet {
   types::TabletID tablet_id;
-  // TODO(oazizi): Convert this vector into a heap of {time, index} objects.
   std::vector<uint64_t> times;
   types::ColumnWrapperRecordBatch records;
+
+  // Records are usually appended in time order. To avoid sorting them when they are consumed,
+  // this tracks the positions at which times go backwards, each starting a new ascending run.
+  // Empty if times is sorted.
+  std::vector<size_t> run_starts;
+
+  void AppendTime(uint64_t time) {
+    if (!times.empty() && time < times.back()) {
+      run_starts.push_back(times.size());
+    }
+    times.push_back(time);
+  }
+
+  bool sorted() const { return run_starts.empty(); }
 };
 
 class DataTable : public NotCopyable {
  public:
   // Global unique ID identifies the table store to which this DataTable's data should be pushed.
   DataTable(uint64_t id, const DataTableSchema& schema);
-  virtual ~DataTable() = default;
+  virtual ~DataTable();
 
   /**
    * Consume the data buffered in the data table, up to the specified time.
@@ -171,6 +185,17 @@ class DataTable : public NotCopyable {
       signature_.set(TIndex);
     }
 
+    // Appends a null to the column, for a value that is missing, rather than a placeholder value.
+    template <const size_t TIndex>
+    inline void AppendNull() {
+      static_assert(TIndex != schema->tabletization_key(), "The tablet key can't be null.");
+      tablet_.records[TIndex]->AppendNull();
+      DCHECK(!signature_[TIndex]) << absl::Substitute(
+          "Attempt to Append() to column $0 (name=$1) multiple times", TIndex,
+          schema->ColName(TIndex));
+      signature_.set(TIndex);
+    }
+
     ~RecordBuilder() {
       DCHECK(signature_.all()) << absl::Substitute(
           "Must call Append() on all columns. Table name = $0, Column unfilled = [$1]",
@@ -190,7 +215,7 @@ class DataTable : public NotCopyable {
    private:
     void Init(uint64_t time) {
       DCHECK_EQ(schema->elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      tablet_.AppendTime(time);
     }
 
     Tablet& tablet_;
@@ -237,6 +262,16 @@ class DataTable : public NotCopyable {
       signature_.set(col_index);
     }
 
+    // Appends a null to the column, for a value that is missing, rather than a placeholder value.
+    inline void AppendNull(size_t col_index) {
+      tablet_.records[col_index]->AppendNull();
+
+      DCHECK(!signature_[col_index])
+          << absl::Substitute("Attempt to Append() to column $0 (name=$1) multiple times",
+                              col_index, schema_.ColName(col_index));
+      signature_.set(col_index);
+    }
+
     ~DynamicRecordBuilder() {
       // Check that every column was populated.
       DCHECK_EQ(signature_.count(), schema_.elements().size());
@@ -246,7 +281,7 @@ class DataTable : public NotCopyable {
    private:
     void Init(uint64_t time) {
       DCHECK_EQ(schema_.elements().size(), tablet_.records.size());
-      tablet_.times.push_back(time);
+      tablet_.AppendTime(time);
       LOG_IF(DFATAL, schema_.elements().size() > kMaxSupportedColumns) << absl::Substitute(
           "Tables with more than $0 columns are not supported.", kMaxSupportedColumns);
     }
@@ -260,6 +295,13 @@ class DataTable : public NotCopyable {
 
   uint64_t id() const { return id_; }
 
+  /**
+   * Returns the handle to push the records of the tablet with. The handle is resolved on first
+   * use, and cached for the following pushes.
+   */
+  StatusOr<DataPushHandle*> GetPushHandle(const types::TabletID& tablet_id,
+                                          const DataPushHandleResolver& resolver);
+
  protected:
   // ColumnWrapper specific members
   static constexpr size_t kTargetCapacity = 1024;
@@ -276,9 +318,17 @@ class DataTable : public NotCopyable {
   // Table schema: a DataElement to describe each column.
   const DataTableSchema& table_schema_;
 
+  // Exports the time spent in ConsumeRecords() to the stirling_perf table.
+  utils::PerfProbe* const consume_records_probe_;
+
   // Key is tablet id, value is tablet records.
   absl::flat_hash_map<types::TabletID, Tablet> tablets_;
 
+  // The push handles of the tablets. Most tables are not tabletized, so the handle of the
+  // default tablet ("") is kept apart, which avoids hashing the tablet id on each push.
+  DataPushHandle default_push_handle_;
+  absl::flat_hash_map<types::TabletID, DataPushHandle> push_handles_;
+
   uint64_t start_time_ = 0;
 
   // The cutoff time is an optional field that sets up to which time
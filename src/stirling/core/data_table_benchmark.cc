@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/data_table.h"
+
+using px::stirling::DataElement;
+using px::stirling::DataTable;
+using px::stirling::DataTableSchema;
+
+namespace {
+
+constexpr DataElement kElements[] = {
+    {"time_", "time", px::types::DataType::TIME64NS, px::types::SemanticType::ST_NONE,
+     px::types::PatternType::METRIC_COUNTER},
+    {"x", "an int value", px::types::DataType::INT64, px::types::SemanticType::ST_NONE,
+     px::types::PatternType::GENERAL},
+    {"s", "a string", px::types::DataType::STRING, px::types::SemanticType::ST_NONE,
+     px::types::PatternType::GENERAL},
+};
+constexpr auto kSchema = DataTableSchema("bm_table", "A table for benchmarking", kElements);
+
+std::vector<uint64_t> SortedTimes(size_t n) {
+  std::vector<uint64_t> times(n);
+  for (size_t i = 0; i < n; ++i) {
+    times[i] = i + 1;
+  }
+  return times;
+}
+
+// Like SortedTimes(), with one in every 64 records arriving a little late, as when a few records
+// are buffered a bit longer than the others.
+std::vector<uint64_t> NearlySortedTimes(size_t n) {
+  std::vector<uint64_t> times = SortedTimes(n);
+  for (size_t i = 64; i < n; i += 64) {
+    std::swap(times[i - 8], times[i]);
+  }
+  return times;
+}
+
+std::vector<uint64_t> RandomTimes(size_t n) {
+  std::vector<uint64_t> times = SortedTimes(n);
+  std::mt19937 rng(37);
+  std::shuffle(times.begin(), times.end(), rng);
+  return times;
+}
+
+// Appends records with the given times, then consumes them all.
+void AppendAndConsume(benchmark::State& state, const std::vector<uint64_t>& times) {
+  const std::string s(16, 'x');
+
+  for (auto _ : state) {
+    DataTable data_table(/*id*/ 0, kSchema);
+    for (uint64_t t : times) {
+      DataTable::RecordBuilder<&kSchema> r(&data_table, t);
+      r.Append<r.ColIndex("time_")>(t);
+      r.Append<r.ColIndex("x")>(t);
+      r.Append<r.ColIndex("s")>(s);
+    }
+    benchmark::DoNotOptimize(data_table.ConsumeRecords());
+  }
+  state.SetItemsProcessed(state.iterations() * times.size());
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_Sorted(benchmark::State& state) {
+  AppendAndConsume(state, SortedTimes(state.range(0)));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NearlySorted(benchmark::State& state) {
+  AppendAndConsume(state, NearlySortedTimes(state.range(0)));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_Random(benchmark::State& state) {
+  AppendAndConsume(state, RandomTimes(state.range(0)));
+}
+
+BENCHMARK(BM_Sorted)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_NearlySorted)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(BM_Random)->RangeMultiplier(8)->Range(64, 32768);
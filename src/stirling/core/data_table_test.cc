@@ -16,10 +16,14 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
+#include "src/common/testing/testing.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/source_connectors/seq_gen/sequence_generator.h"
 
@@ -69,6 +73,42 @@ TEST_F(DataTableTest, ResultIsSorted) {
   }
 }
 
+// Sorted appends skip the sort; check that carryover records still merge with later appends.
+TEST_F(DataTableTest, SortedWithCarryover) {
+  auto append = [this](int t) {
+    DataTable::RecordBuilder<&kSchema> r(data_table_.get(), t);
+    r.Append<r.ColIndex("time_")>(t);
+    r.Append<r.ColIndex("x")>(t);
+    r.Append<r.ColIndex("s")>(std::to_string(t));
+  };
+
+  for (int t : {10, 20, 30, 40}) {
+    append(t);
+  }
+  data_table_->SetConsumeRecordsCutoffTime(25);
+
+  std::vector<TaggedRecordBatch> record_batches = data_table_->ConsumeRecords();
+  ASSERT_EQ(record_batches.size(), 1);
+  ASSERT_EQ(record_batches[0].records[0]->Size(), 2);
+  EXPECT_EQ(record_batches[0].records[1]->Get<types::Int64Value>(0), 10);
+  EXPECT_EQ(record_batches[0].records[1]->Get<types::Int64Value>(1), 20);
+
+  for (int t : {35, 50, 45}) {
+    append(t);
+  }
+  data_table_->SetConsumeRecordsCutoffTime(100);
+
+  record_batches = data_table_->ConsumeRecords();
+  ASSERT_EQ(record_batches.size(), 1);
+  const std::vector<int> expected_times = {30, 35, 40, 45, 50};
+  ASSERT_EQ(record_batches[0].records[0]->Size(), expected_times.size());
+  for (size_t i = 0; i < expected_times.size(); ++i) {
+    EXPECT_EQ(record_batches[0].records[1]->Get<types::Int64Value>(i), expected_times[i]);
+    EXPECT_EQ(record_batches[0].records[2]->Get<types::StringValue>(i),
+              std::to_string(expected_times[i]));
+  }
+}
+
 // No time passed to RecordBuilder, so all timestamps should be zero.
 // That means there should never be any expired or carry-over records.
 // Also, nothing should be sorted in any way.
@@ -314,6 +354,36 @@ TEST_F(DataTableTest, Carryover) {
   }
 }
 
+TEST_F(DataTableTest, PushHandleIsResolvedOnce) {
+  std::vector<types::TabletID> resolved;
+  int num_pushes = 0;
+  DataPushHandleResolver resolver = [&](uint32_t table_id, const types::TabletID& tablet_id)
+      -> StatusOr<DataPushHandle> {
+    EXPECT_EQ(table_id, data_table_->id());
+    resolved.push_back(tablet_id);
+    if (tablet_id == "bad") {
+      return error::NotFound("No tablet $0", tablet_id);
+    }
+    return DataPushHandle([&](std::unique_ptr<types::ColumnWrapperRecordBatch>) {
+      ++num_pushes;
+      return Status::OK();
+    });
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(DataPushHandle * handle, data_table_->GetPushHandle("", resolver));
+    EXPECT_OK((*handle)(std::make_unique<types::ColumnWrapperRecordBatch>()));
+    ASSERT_OK(data_table_->GetPushHandle("1", resolver));
+  }
+  EXPECT_EQ(num_pushes, 3);
+  EXPECT_THAT(resolved, ::testing::ElementsAre("", "1"));
+
+  // Failed resolutions are not cached.
+  EXPECT_NOT_OK(data_table_->GetPushHandle("bad", resolver));
+  EXPECT_NOT_OK(data_table_->GetPushHandle("bad", resolver));
+  EXPECT_THAT(resolved, ::testing::ElementsAre("", "1", "bad", "bad"));
+}
+
 class DataTableStressTest : public ::testing::Test {
  private:
   std::default_random_engine rng_;
@@ -38,7 +38,13 @@ class FrequencyManager {
   /**
    * Ends the current cycle, and starts the next one.
    */
-  void Reset();
+  void Reset() { Reset(period_); }
+
+  /**
+   * Ends the current cycle, and starts the next one with the given duration instead of the period.
+   * Used to adapt the cycles to the load, while keeping the configured period as the baseline.
+   */
+  void Reset(std::chrono::milliseconds duration);
 
   void set_period(std::chrono::milliseconds period) { period_ = period; }
   const auto& period() const { return period_; }
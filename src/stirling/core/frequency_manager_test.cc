@@ -49,5 +49,19 @@ TEST(FrequencyManagerTest, SetPeriodEndAndCheck) {
   EXPECT_GE(computed_period, std::chrono::milliseconds{9990});
 }
 
+// Tests that a cycle can be given a duration other than the period.
+TEST(FrequencyManagerTest, ResetWithDuration) {
+  FrequencyManager mgr;
+  mgr.set_period(std::chrono::milliseconds{10000});
+
+  mgr.Reset(std::chrono::milliseconds{20000});
+  EXPECT_FALSE(mgr.Expired());
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{10000});
+  EXPECT_EQ(mgr.count(), static_cast<uint32_t>(1));
+  auto computed_duration = mgr.next() - px::chrono::coarse_steady_clock::now();
+  EXPECT_LE(computed_duration, std::chrono::milliseconds{20000});
+  EXPECT_GE(computed_duration, std::chrono::milliseconds{19990});
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -16,6 +16,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <ctime>
 #include <memory>
@@ -25,9 +27,30 @@
 
 #include "src/stirling/core/source_connector.h"
 
+DEFINE_bool(stirling_adaptive_sampling, true,
+            "If true, connectors sample less often while they find no data, and no more often "
+            "than the time that their transfers take.");
+
 namespace px {
 namespace stirling {
 
+namespace {
+
+// How often each connector logs its transfer statistics.
+constexpr std::chrono::minutes kTransferStatsLoggingPeriod{5};
+
+size_t TotalOccupancy(const std::vector<DataTable*>& data_tables) {
+  size_t occupancy = 0;
+  for (const auto* data_table : data_tables) {
+    if (data_table != nullptr) {
+      occupancy += data_table->Occupancy();
+    }
+  }
+  return occupancy;
+}
+
+}  // namespace
+
 Status SourceConnector::Init() {
   if (state_ != State::kUninitialized) {
     return error::Internal("Cannot re-initialize a connector [current state = $0].",
@@ -50,8 +73,48 @@ void SourceConnector::TransferData(ConnectorContext* ctx,
   DCHECK(ctx != nullptr);
   DCHECK_EQ(data_tables.size(), table_schemas().size())
       << "DataTable objects must all be specified.";
+
+  const size_t occupancy_before = TotalOccupancy(data_tables);
+  const auto start = std::chrono::steady_clock::now();
   TransferDataImpl(ctx, data_tables);
-  sampling_freq_mgr_.Reset();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto transfer_time = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+  const bool idle = TotalOccupancy(data_tables) <= occupancy_before;
+  transfer_probe_->Record(elapsed);
+
+  const auto period = sampling_freq_mgr_.period();
+  transfer_stats_.Increment(TransferStatKey::kTransfers);
+  transfer_stats_.Increment(TransferStatKey::kIdleTransfers, idle);
+  transfer_stats_.Increment(TransferStatKey::kOverrunTransfers, transfer_time > period);
+  transfer_stats_.Increment(TransferStatKey::kTransferTimeUS, transfer_time.count());
+  transfer_stats_.Increment(TransferStatKey::kSamplingPeriodUS,
+                            std::chrono::duration_cast<std::chrono::microseconds>(period).count());
+
+  const auto now = px::chrono::coarse_steady_clock::now();
+  if (now >= transfer_stats_log_time_ + kTransferStatsLoggingPeriod) {
+    LOG(INFO) << absl::Substitute("$0 transfer statistics: $1", name(), transfer_stats_.Print());
+    transfer_stats_ = {};
+    transfer_stats_log_time_ = now;
+  }
+
+  if (!FLAGS_stirling_adaptive_sampling) {
+    sampling_freq_mgr_.Reset();
+    return;
+  }
+
+  // The fill is over the interval that just ended, which was sampling_backoff_ periods long.
+  // A full buffer may have lost events, so the connector goes back to its period.
+  const double fill = OutputBufferFill();
+  const double fill_per_period = fill / sampling_backoff_;
+  int backoff = idle && fill < 1 ? std::min(2 * sampling_backoff_, kMaxIdleSamplingBackoff) : 1;
+  // Don't wait long enough for the output buffers to fill up past kMaxOutputBufferFill.
+  while (backoff > 1 && fill_per_period * backoff > kMaxOutputBufferFill) {
+    backoff /= 2;
+  }
+  sampling_backoff_ = backoff;
+  sampling_freq_mgr_.Reset(
+      std::max(sampling_backoff_ * period,
+               std::chrono::duration_cast<std::chrono::milliseconds>(transfer_time)));
 }
 
 void SourceConnector::PushData(DataPushCallback agent_callback,
@@ -71,6 +134,26 @@ void SourceConnector::PushData(DataPushCallback agent_callback,
   push_freq_mgr_.Reset();
 }
 
+void SourceConnector::PushData(const DataPushHandleResolver& resolver,
+                               const std::vector<DataTable*>& data_tables) {
+  for (auto* data_table : data_tables) {
+    auto record_batches = data_table->ConsumeRecords();
+    for (auto& record_batch : record_batches) {
+      if (record_batch.records.empty()) {
+        continue;
+      }
+      StatusOr<DataPushHandle*> handle =
+          data_table->GetPushHandle(record_batch.tablet_id, resolver);
+      Status s = handle.ok()
+                     ? (*handle.ValueOrDie())(std::make_unique<types::ColumnWrapperRecordBatch>(
+                           std::move(record_batch.records)))
+                     : handle.status();
+      LOG_IF(DFATAL, !s.ok()) << absl::Substitute("Failed to push data. Message = $0", s.msg());
+    }
+  }
+  push_freq_mgr_.Reset();
+}
+
 Status SourceConnector::Stop() {
   if (state_ != State::kActive) {
     return Status::OK();
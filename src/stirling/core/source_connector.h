@@ -27,6 +27,8 @@
 #include "src/stirling/core/connector_context.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/frequency_manager.h"
+#include "src/stirling/utils/perf_stats.h"
+#include "src/stirling/utils/stat_counter.h"
 
 /**
  * These are the steps to follow to add a new data source connector.
@@ -43,7 +45,7 @@ namespace stirling {
 class SourceConnector : public NotCopyable {
  public:
   SourceConnector() = delete;
-  virtual ~SourceConnector() = default;
+  virtual ~SourceConnector() { utils::PerfStats::GetInstance().ReleaseProbe(transfer_probe_); }
 
   /**
    * Initializes the source connector. Can only be called once.
@@ -58,7 +60,14 @@ class SourceConnector : public NotCopyable {
   void InitContext(ConnectorContext* ctx);
 
   /**
-   * Transfers all collected data to data tables.
+   * Transfers all collected data to data tables, and schedules the next transfer.
+   *
+   * With --stirling_adaptive_sampling, the next transfer is delayed while transfers find no data,
+   * up to kMaxIdleSamplingBackoff sampling periods, as long as the connector's output buffers
+   * (see OutputBufferFill()) are not expected to fill past kMaxOutputBufferFill in the meantime.
+   * It is also delayed by at least the time spent in this transfer, so that a connector that
+   * cannot keep up with its period does not starve the others.
+   *
    * @param ctx Shared context, e.g. ASID & tracked PIDs.
    * @param data_tables Map from the table number to DataTable objects.
    */
@@ -69,6 +78,12 @@ class SourceConnector : public NotCopyable {
    */
   void PushData(DataPushCallback agent_callback, const std::vector<DataTable*>& data_tables);
 
+  /**
+   * Pushes data in data tables into table store, through the push handles of their tablets.
+   */
+  void PushData(const DataPushHandleResolver& resolver,
+                const std::vector<DataTable*>& data_tables);
+
   /**
    * Stops the source connector and releases any acquired resources.
    * May only be called after a successful Init().
@@ -110,10 +125,29 @@ class SourceConnector : public NotCopyable {
   const FrequencyManager& sampling_freq_mgr() const { return sampling_freq_mgr_; }
   const FrequencyManager& push_freq_mgr() const { return push_freq_mgr_; }
 
+  static constexpr int kMaxIdleSamplingBackoff = 4;
+  static constexpr double kMaxOutputBufferFill = 0.5;
+
+  // Statistics of the time spent in TransferData(), compared to the sampling period.
+  enum class TransferStatKey {
+    kTransfers,
+    // Transfers that found no new data.
+    kIdleTransfers,
+    // Transfers that took longer than the sampling period.
+    kOverrunTransfers,
+    kTransferTimeUS,
+    kSamplingPeriodUS,
+  };
+
+  const utils::StatCounter<TransferStatKey>& transfer_stats() const { return transfer_stats_; }
+
  protected:
   explicit SourceConnector(std::string_view source_name,
                            const ArrayView<DataTableSchema>& table_schemas)
-      : source_name_(source_name), table_schemas_(table_schemas) {}
+      : source_name_(source_name),
+        table_schemas_(table_schemas),
+        transfer_probe_(utils::PerfStats::GetInstance().GetProbe(
+            absl::StrCat(source_name, ".transfer_data"))) {}
 
   virtual Status InitImpl() = 0;
 
@@ -123,6 +157,11 @@ class SourceConnector : public NotCopyable {
 
   virtual void TransferDataImpl(ConnectorContext*, const std::vector<DataTable*>&) = 0;
 
+  // How full the buffers that the connector drains in TransferDataImpl() (e.g. BPF perf buffers)
+  // got since the last call, as a fraction of their capacity. Caps the idle backoff, so that the
+  // buffers don't overflow while transfers are delayed. Connectors without such buffers keep 0.
+  virtual double OutputBufferFill() { return 0; }
+
   virtual Status StopImpl() = 0;
 
  protected:
@@ -152,6 +191,16 @@ class SourceConnector : public NotCopyable {
 
   // Debug members.
   int debug_level_ = 0;
+
+  // The multiple of the sampling period until the next transfer,
+  // which grows while transfers find no data.
+  int sampling_backoff_ = 1;
+
+  utils::StatCounter<TransferStatKey> transfer_stats_;
+  px::chrono::coarse_steady_clock::time_point transfer_stats_log_time_ = {};
+
+  // Exports the time spent in TransferData() to the stirling_perf table.
+  utils::PerfProbe* const transfer_probe_;
 };
 
 }  // namespace stirling
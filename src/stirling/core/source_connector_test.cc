@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/core/source_connector.h"
+
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/core/canonical_types.h"
+
+namespace px {
+namespace stirling {
+
+// A connector that never finds data, and reports a set fill of its output buffers.
+class IdleConnector : public SourceConnector {
+ public:
+  static constexpr auto kPeriod = std::chrono::milliseconds{1000};
+  static constexpr DataElement kElements[] = {canonical_data_elements::kTime};
+  static constexpr auto kTable =
+      DataTableSchema("idle_table", "A table that stays empty", kElements);
+  static constexpr auto kTables = MakeArray(kTable);
+
+  IdleConnector() : SourceConnector("idle", kTables) {}
+
+  double output_buffer_fill = 0;
+
+ protected:
+  Status InitImpl() override {
+    sampling_freq_mgr_.set_period(kPeriod);
+    return Status::OK();
+  }
+  Status StopImpl() override { return Status::OK(); }
+  void TransferDataImpl(ConnectorContext*, const std::vector<DataTable*>&) override {}
+  double OutputBufferFill() override { return output_buffer_fill; }
+};
+
+class SourceConnectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_OK(connector_.Init()); }
+
+  // Runs a transfer, and returns the time until the next one.
+  std::chrono::milliseconds Transfer() {
+    connector_.TransferData(&ctx_, data_tables_);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        connector_.sampling_freq_mgr().next() - px::chrono::coarse_steady_clock::now());
+  }
+
+  IdleConnector connector_;
+  StandaloneContext ctx_;
+  std::vector<DataTable*> data_tables_{nullptr};
+};
+
+// The coarse clock can be a few milliseconds behind.
+constexpr auto kTolerance = std::chrono::milliseconds{50};
+
+TEST_F(SourceConnectorTest, IdleTransfersBackOff) {
+  EXPECT_GE(Transfer(), 2 * IdleConnector::kPeriod - kTolerance);
+  EXPECT_GE(Transfer(), 4 * IdleConnector::kPeriod - kTolerance);
+  EXPECT_GE(Transfer(), 4 * IdleConnector::kPeriod - kTolerance);
+}
+
+TEST_F(SourceConnectorTest, OutputBufferFillCapsBackOff) {
+  // Doubling the interval would fill the buffers past kMaxOutputBufferFill.
+  connector_.output_buffer_fill = 0.3;
+  EXPECT_LE(Transfer(), IdleConnector::kPeriod + kTolerance);
+  EXPECT_LE(Transfer(), IdleConnector::kPeriod + kTolerance);
+
+  connector_.output_buffer_fill = 0.2;
+  EXPECT_GE(Transfer(), 2 * IdleConnector::kPeriod - kTolerance);
+  // Over the 2 periods, the fill per period halves, so the interval doubles again.
+  EXPECT_GE(Transfer(), 4 * IdleConnector::kPeriod - kTolerance);
+
+  // Lost events reset the interval to the period.
+  connector_.output_buffer_fill = 1;
+  EXPECT_LE(Transfer(), IdleConnector::kPeriod + kTolerance);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -37,6 +37,18 @@ namespace stirling {
 using DataPushCallback = std::function<Status(uint32_t, types::TabletID,
                                               std::unique_ptr<types::ColumnWrapperRecordBatch>)>;
 
+/**
+ * Pushes data to one tablet of one table, which was resolved by a DataPushHandleResolver.
+ */
+using DataPushHandle = std::function<Status(std::unique_ptr<types::ColumnWrapperRecordBatch>)>;
+
+/**
+ * Resolves the table id and tablet id into a DataPushHandle, which stays valid for as long as
+ * the agent runs. Stirling resolves each tablet once, instead of looking it up on every push.
+ */
+using DataPushHandleResolver =
+    std::function<StatusOr<DataPushHandle>(uint32_t, const types::TabletID&)>;
+
 using AgentMetadataType = std::shared_ptr<const px::md::AgentMetadataState>;
 
 /**
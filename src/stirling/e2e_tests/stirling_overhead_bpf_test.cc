@@ -0,0 +1,328 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Measures the overhead that Stirling adds to the applications it traces.
+//
+// Each test runs a standard server and a client that sends it requests, once without Stirling and
+// once with Stirling attached, and reports the p50/p99 request latencies of both runs along with
+// the CPU that Stirling used while the requests were served. Run with an opt build:
+//   bazel test -c opt //src/stirling/e2e_tests:stirling_overhead_bpf_test --test_output=streamed
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+#include "src/common/base/base.h"
+#include "src/common/testing/test_utils/container_runner.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/stirling.h"
+
+DEFINE_int32(overhead_num_requests, 500, "The number of requests sent in each run.");
+DEFINE_string(overhead_source_group, "kProd",
+              "[kAll|kProd|kMetrics|kTracers|kProfiler] The sources of the attached Stirling.");
+DEFINE_int32(overhead_warmup_secs, 10,
+             "How long Stirling runs before the requests are sent, so that its uprobes are "
+             "attached to the server.");
+DEFINE_double(overhead_max_p99_increase_pct, 50,
+              "The largest increase of the p99 latency with Stirling attached that passes.");
+
+namespace px {
+namespace stirling {
+
+using ::px::testing::BazelBinTestFilePath;
+
+// The clients print a line with this prefix and the latency in seconds for each request, and the
+// done message once they have sent all of them.
+constexpr std::string_view kLatencyPrefix = "latency_s ";
+constexpr std::string_view kDoneMessage = "benchmark done";
+
+//-----------------------------------------------------------------------------
+// Servers and clients
+//-----------------------------------------------------------------------------
+
+class NginxContainer : public ContainerRunner {
+ public:
+  NginxContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kInstanceNamePrefix, kReadyMessage) {}
+
+ private:
+  // Serves HTTP on port 80, and HTTPS through OpenSSL on port 443.
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/source_connectors/socket_tracer/testing/containers/"
+      "nginx_openssl_1_1_1_image.tar";
+  static constexpr std::string_view kInstanceNamePrefix = "nginx";
+  static constexpr std::string_view kReadyMessage = "";
+};
+
+class CurlContainer : public ContainerRunner {
+ public:
+  CurlContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kContainerNamePrefix, kDoneMessage) {
+  }
+
+ private:
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/source_connectors/socket_tracer/testing/containers/curl_image.tar";
+  static constexpr std::string_view kContainerNamePrefix = "curl";
+};
+
+class GRPCServerContainer : public ContainerRunner {
+ public:
+  GRPCServerContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kInstanceNamePrefix, kReadyMessage) {}
+
+ private:
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/testing/demo_apps/go_grpc_tls_pl/server/server_image.tar";
+  static constexpr std::string_view kInstanceNamePrefix = "grpc_server";
+  static constexpr std::string_view kReadyMessage = "Starting HTTP/2 server";
+};
+
+class GRPCClientContainer : public ContainerRunner {
+ public:
+  GRPCClientContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kInstanceNamePrefix, kDoneMessage) {}
+
+ private:
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/testing/demo_apps/go_grpc_tls_pl/client/client_image.tar";
+  static constexpr std::string_view kInstanceNamePrefix = "grpc_client";
+};
+
+class MySQLContainer : public ContainerRunner {
+ public:
+  MySQLContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kInstanceNamePrefix, kReadyMessage) {}
+
+ private:
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/source_connectors/socket_tracer/testing/containers/mysql_image.tar";
+  static constexpr std::string_view kInstanceNamePrefix = "mysql_server";
+  static constexpr std::string_view kReadyMessage =
+      "/usr/sbin/mysqld: ready for connections. Version: '8.0.13'  socket: "
+      "'/var/lib/mysql/mysql.sock'  port: 3306";
+};
+
+class PythonMySQLConnectorContainer : public ContainerRunner {
+ public:
+  PythonMySQLConnectorContainer()
+      : ContainerRunner(BazelBinTestFilePath(kBazelImageTar), kInstanceNamePrefix, kDoneMessage) {}
+
+ private:
+  static constexpr std::string_view kBazelImageTar =
+      "src/stirling/source_connectors/socket_tracer/testing/containers/mysql_connector_image.tar";
+  static constexpr std::string_view kInstanceNamePrefix = "mysql_client";
+};
+
+// Sends SELECT 1 over a single connection, as many times as the first argument says.
+constexpr char kMySQLClientScript[] = R"(
+import sys
+import time
+import mysql.connector
+
+conn = mysql.connector.connect(user="root", host="0.0.0.0", port=3306, password="",
+                               ssl_disabled=True)
+cursor = conn.cursor()
+for _ in range(int(sys.argv[1])):
+    start = time.perf_counter()
+    cursor.execute("SELECT 1")
+    cursor.fetchall()
+    print("latency_s", time.perf_counter() - start)
+print("benchmark done")
+)";
+
+//-----------------------------------------------------------------------------
+// Measurements
+//-----------------------------------------------------------------------------
+
+// Returns the request latencies in the output of a client, in microseconds.
+StatusOr<std::vector<double>> ParseLatencies(std::string_view client_out) {
+  std::vector<double> latencies_us;
+  for (std::string_view line : absl::StrSplit(client_out, '\n')) {
+    if (!absl::ConsumePrefix(&line, kLatencyPrefix)) {
+      continue;
+    }
+    double latency_s;
+    if (!absl::SimpleAtod(line, &latency_s)) {
+      return error::Internal("Could not parse the latency of line: $0", line);
+    }
+    latencies_us.push_back(latency_s * 1000 * 1000);
+  }
+  if (latencies_us.empty()) {
+    return error::Internal("The client did not report any latencies. Output:\n$0", client_out);
+  }
+  return latencies_us;
+}
+
+double Percentile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  size_t idx = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+  return values[idx];
+}
+
+std::chrono::microseconds ProcessCPUTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+struct RunStats {
+  double p50_us = 0;
+  double p99_us = 0;
+  // The CPU used by this process while the requests were sent, as a percentage of one core.
+  double cpu_pct = 0;
+};
+
+class StirlingOverheadTest : public ::testing::Test {
+ protected:
+  // Runs the client to completion, and returns its output.
+  using ClientFn = std::function<StatusOr<std::string>()>;
+
+  StatusOr<RunStats> MeasureRun(const ClientFn& run_client) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto start_cpu = ProcessCPUTime();
+
+    PL_ASSIGN_OR_RETURN(std::string client_out, run_client());
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start_time;
+    std::chrono::duration<double> cpu = ProcessCPUTime() - start_cpu;
+
+    PL_ASSIGN_OR_RETURN(std::vector<double> latencies_us, ParseLatencies(client_out));
+    RunStats stats;
+    stats.p50_us = Percentile(latencies_us, 0.50);
+    stats.p99_us = Percentile(latencies_us, 0.99);
+    stats.cpu_pct = 100.0 * cpu.count() / wall.count();
+    return stats;
+  }
+
+  // Runs the client without Stirling and then with Stirling attached, and reports the overhead.
+  void MeasureOverhead(std::string_view protocol, const ClientFn& run_client) {
+    ASSERT_OK_AND_ASSIGN(RunStats baseline, MeasureRun(run_client));
+
+    std::optional<SourceConnectorGroup> group =
+        magic_enum::enum_cast<SourceConnectorGroup>(FLAGS_overhead_source_group);
+    ASSERT_TRUE(group.has_value()) << FLAGS_overhead_source_group;
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<SourceRegistry> registry,
+                         CreateSourceRegistry(GetSourceNamesForGroup(group.value())));
+    std::unique_ptr<Stirling> stirling = Stirling::Create(std::move(registry));
+    stirling->RegisterDataPushCallback(
+        [](uint64_t, types::TabletID, std::unique_ptr<types::ColumnWrapperRecordBatch>) {
+          return Status::OK();
+        });
+    ASSERT_OK(stirling->RunAsThread());
+    ASSERT_OK(stirling->WaitUntilRunning(std::chrono::seconds(30)));
+    sleep(FLAGS_overhead_warmup_secs);
+
+    StatusOr<RunStats> traced_or = MeasureRun(run_client);
+    stirling->Stop();
+    ASSERT_OK(traced_or);
+    const RunStats& traced = traced_or.ValueOrDie();
+
+    double p50_increase_pct = 100.0 * (traced.p50_us - baseline.p50_us) / baseline.p50_us;
+    double p99_increase_pct = 100.0 * (traced.p99_us - baseline.p99_us) / baseline.p99_us;
+    LOG(INFO) << absl::Substitute(
+        "[$0] p50: $1 us -> $2 us ($3%), p99: $4 us -> $5 us ($6%), Stirling CPU: $7%", protocol,
+        baseline.p50_us, traced.p50_us, p50_increase_pct, baseline.p99_us, traced.p99_us,
+        p99_increase_pct, traced.cpu_pct - baseline.cpu_pct);
+
+    EXPECT_LE(p99_increase_pct, FLAGS_overhead_max_p99_increase_pct) << protocol;
+  }
+
+  static constexpr auto kClientTimeout = std::chrono::seconds{300};
+};
+
+//-----------------------------------------------------------------------------
+// Test Cases
+//-----------------------------------------------------------------------------
+
+TEST_F(StirlingOverheadTest, HTTP) {
+  NginxContainer server;
+  ASSERT_OK(server.Run(std::chrono::seconds{60}));
+
+  MeasureOverhead("HTTP", [&server]() {
+    CurlContainer client;
+    return client.Run(
+        kClientTimeout,
+        {"--entrypoint=sh", absl::Substitute("--network=container:$0", server.container_name())},
+        {"-c", absl::Substitute("for i in $$(seq $0); do curl -s -o /dev/null "
+                                "-w '$1%{time_total}\\n' http://localhost:80/index.html; done; "
+                                "echo $2",
+                                FLAGS_overhead_num_requests, kLatencyPrefix, kDoneMessage)});
+  });
+}
+
+TEST_F(StirlingOverheadTest, OpenSSL) {
+  NginxContainer server;
+  ASSERT_OK(server.Run(std::chrono::seconds{60}));
+
+  // The server's certificate is self-signed, so it's accepted with --insecure.
+  MeasureOverhead("OpenSSL", [&server]() {
+    CurlContainer client;
+    return client.Run(
+        kClientTimeout,
+        {"--entrypoint=sh", absl::Substitute("--network=container:$0", server.container_name())},
+        {"-c", absl::Substitute("for i in $$(seq $0); do curl --insecure -s -o /dev/null "
+                                "-w '$1%{time_total}\\n' https://localhost:443/index.html; done; "
+                                "echo $2",
+                                FLAGS_overhead_num_requests, kLatencyPrefix, kDoneMessage)});
+  });
+}
+
+TEST_F(StirlingOverheadTest, GoTLSGRPC) {
+  GRPCServerContainer server;
+  ASSERT_OK(server.Run(std::chrono::seconds{60}));
+
+  MeasureOverhead("Go TLS gRPC", [&server]() {
+    GRPCClientContainer client;
+    return client.Run(kClientTimeout,
+                      {absl::Substitute("--network=container:$0", server.container_name())},
+                      {"--client_tls_cert=/certs/client.crt", "--client_tls_key=/certs/client.key",
+                       "--tls_ca_cert=/certs/ca.crt",
+                       absl::StrCat("--count=", FLAGS_overhead_num_requests), "--interval=0s",
+                       "--print_latency"});
+  });
+}
+
+TEST_F(StirlingOverheadTest, MySQL) {
+  MySQLContainer server;
+  ASSERT_OK(server.Run(std::chrono::seconds{90},
+                       {"--env=MYSQL_ALLOW_EMPTY_PASSWORD=1", "--env=MYSQL_ROOT_HOST=%"}));
+  // Sleep an additional second, just to be safe.
+  sleep(1);
+
+  MeasureOverhead("MySQL", [&server]() {
+    PythonMySQLConnectorContainer client;
+    return client.Run(kClientTimeout,
+                      {absl::Substitute("--network=container:$0", server.container_name())},
+                      {"-c", kMySQLClientScript, absl::StrCat(FLAGS_overhead_num_requests)});
+  });
+}
+
+}  // namespace stirling
+}  // namespace px
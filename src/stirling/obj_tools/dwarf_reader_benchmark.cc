@@ -71,15 +71,17 @@ void GetSymAddrs(DwarfReader* dwarf_reader, SymAddrs* symaddrs) {
               "Fields");
 }
 
+// Measures creating a DwarfReader and then looking up the symbols, as done when a new binary is
+// first probed.
 // NOLINTNEXTLINE : runtime/references.
-static void BM_noindex(benchmark::State& state) {
+static void BM_cold_lookup(benchmark::State& state, DwarfReader::IndexMode index_mode) {
   size_t num_lookup_iterations = state.range(0);
 
   for (auto _ : state) {
     SymAddrs symaddrs;
 
     PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader,
-                      DwarfReader::Create(kBinary, /* index */ false));
+                      DwarfReader::Create(kBinary, index_mode));
 
     for (size_t i = 0; i < num_lookup_iterations; ++i) {
       GetSymAddrs(dwarf_reader.get(), &symaddrs);
@@ -88,21 +90,31 @@ static void BM_noindex(benchmark::State& state) {
   }
 }
 
+// Measures looking up the symbols on an existing DwarfReader, after a first round of lookups.
 // NOLINTNEXTLINE : runtime/references.
-static void BM_indexed(benchmark::State& state) {
-  size_t num_lookup_iterations = state.range(0);
+static void BM_warm_lookup(benchmark::State& state, DwarfReader::IndexMode index_mode) {
+  PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader,
+                    DwarfReader::Create(kBinary, index_mode));
 
-  for (auto _ : state) {
-    SymAddrs symaddrs;
+  SymAddrs symaddrs;
+  GetSymAddrs(dwarf_reader.get(), &symaddrs);
 
-    PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader, DwarfReader::Create(kBinary));
-
-    for (size_t i = 0; i < num_lookup_iterations; ++i) {
-      GetSymAddrs(dwarf_reader.get(), &symaddrs);
-      benchmark::DoNotOptimize(symaddrs);
-    }
+  for (auto _ : state) {
+    GetSymAddrs(dwarf_reader.get(), &symaddrs);
+    benchmark::DoNotOptimize(symaddrs);
   }
 }
 
-BENCHMARK(BM_noindex)->RangeMultiplier(2)->Range(1, 16);
-BENCHMARK(BM_indexed)->RangeMultiplier(2)->Range(1, 16);
+BENCHMARK_CAPTURE(BM_cold_lookup, noindex, DwarfReader::IndexMode::kNone)
+    ->RangeMultiplier(2)
+    ->Range(1, 16);
+BENCHMARK_CAPTURE(BM_cold_lookup, indexed, DwarfReader::IndexMode::kFull)
+    ->RangeMultiplier(2)
+    ->Range(1, 16);
+BENCHMARK_CAPTURE(BM_cold_lookup, lazy, DwarfReader::IndexMode::kLazy)
+    ->RangeMultiplier(2)
+    ->Range(1, 16);
+
+BENCHMARK_CAPTURE(BM_warm_lookup, noindex, DwarfReader::IndexMode::kNone);
+BENCHMARK_CAPTURE(BM_warm_lookup, indexed, DwarfReader::IndexMode::kFull);
+BENCHMARK_CAPTURE(BM_warm_lookup, lazy, DwarfReader::IndexMode::kLazy);
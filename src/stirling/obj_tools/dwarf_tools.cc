@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include <llvm/DebugInfo/DIContext.h>
+#include <llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h>
 #include <llvm/Object/ObjectFile.h>
 
 #include "src/stirling/obj_tools/init.h"
@@ -99,13 +100,16 @@ std::string Dump(const llvm::DWARFDie& die) {
 uint8_t kAddressSize = sizeof(void*);
 
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(std::string_view obj_filename,
-                                                           bool index) {
+                                                           IndexMode index_mode) {
   using llvm::MemoryBuffer;
 
   std::error_code ec;
 
+  // Not requiring a null terminator lets LLVM mmap the file instead of reading it into memory.
+  // With IndexMode::kLazy, most of the debug info of a large binary is then never paged in.
   llvm::ErrorOr<std::unique_ptr<MemoryBuffer>> buff_or_err =
-      MemoryBuffer::getFileOrSTDIN(std::string(obj_filename));
+      MemoryBuffer::getFile(std::string(obj_filename), /* FileSize */ -1,
+                            /* RequiresNullTerminator */ false);
   ec = buff_or_err.getError();
   if (ec) {
     return error::Internal("DwarfReader $0: $1", ec.message(), obj_filename);
@@ -129,9 +133,13 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(std::string_view obj_
 
   PL_RETURN_IF_ERROR(dwarf_reader->DetectSourceLanguage());
 
-  if (index) {
+  dwarf_reader->index_mode_ = index_mode;
+  if (index_mode == IndexMode::kFull) {
     dwarf_reader->IndexDIEs();
   }
+  if (index_mode == IndexMode::kLazy) {
+    dwarf_reader->complete_name_index_ = dwarf_reader->HasCompleteNameIndex();
+  }
 
   return dwarf_reader;
 }
@@ -220,18 +228,30 @@ Status DwarfReader::DetectSourceLanguage() {
   return Status::OK();
 }
 
-void DwarfReader::IndexDIEs() {
-  DWARFContext::unit_iterator_range CUs = dwarf_context_->normal_units();
+std::vector<llvm::DWARFUnit*> DwarfReader::AllUnits() {
+  std::vector<llvm::DWARFUnit*> units;
+  for (const auto& CU : dwarf_context_->normal_units()) {
+    units.push_back(CU.get());
+  }
+  return units;
+}
 
+void DwarfReader::IndexDIEs() { IndexUnits(AllUnits()); }
+
+void DwarfReader::IndexUnits(const std::vector<llvm::DWARFUnit*>& units) {
   absl::flat_hash_map<const llvm::DWARFDebugInfoEntry*, std::string> dwarf_entry_names;
 
   // Map from DW_AT_specification to DIE. Only DW_TAG_subprogram can have this attribute.
   // Also only applies to CPP binaries.
   absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
 
-  for (const auto& CU : CUs) {
+  for (llvm::DWARFUnit* CU : units) {
+    if (!indexed_units_.insert(CU).second) {
+      continue;
+    }
+
     for (const auto& Entry : CU->dies()) {
-      DWARFDie die = {CU.get(), &Entry};
+      DWARFDie die = {CU, &Entry};
 
       if (die.isSubprogramDIE()) {
         auto spec_or =
@@ -288,6 +308,10 @@ void DwarfReader::IndexDIEs() {
     }
   }
 
+  if (fn_spec_offsets.empty()) {
+    return;
+  }
+
   auto& fn_dies = die_map_[llvm::dwarf::DW_TAG_subprogram];
 
   for (auto iter = fn_dies.begin(); iter != fn_dies.end(); ++iter) {
@@ -301,11 +325,175 @@ void DwarfReader::IndexDIEs() {
   }
 }
 
+namespace {
+
+// Returns the name of the DIE, qualified by the names of its enclosing namespaces, classes,
+// structs and functions. This matches the names used as keys by DwarfReader::IndexUnits().
+std::string QualifiedName(const DWARFDie& die, std::string_view short_name) {
+  std::string name(short_name);
+  for (DWARFDie parent = die.getParent(); parent.isValid(); parent = parent.getParent()) {
+    if (!IsIndexedType(parent.getTag()) && !IsNamespace(parent.getTag())) {
+      break;
+    }
+    std::string_view parent_name = GetShortName(parent);
+    if (parent_name.empty()) {
+      break;
+    }
+    name = absl::StrCat(parent_name, "::", name);
+  }
+  return name;
+}
+
+// Returns true if the DIE found through an accelerator table is the one that the index would
+// have recorded under the name.
+bool IsAcceleratorMatch(std::string_view name, llvm::dwarf::Tag tag, const DWARFDie& die) {
+  if (!die.isValid() || die.getTag() != tag) {
+    return false;
+  }
+
+  std::string_view short_name = GetShortName(die);
+  if (QualifiedName(die, short_name) == name) {
+    return true;
+  }
+
+  // Out-of-line function definitions are qualified by the scope of their declaration.
+  DWARFDie spec_die = die.getAttributeValueAsReferencedDie(llvm::dwarf::DW_AT_specification);
+  return spec_die.isValid() && QualifiedName(spec_die, short_name) == name;
+}
+
+// Returns the package of a Golang symbol, e.g. "net/http" for "net/http.(*conn).serve".
+std::string_view GolangPackageName(std::string_view name) {
+  size_t slash_pos = name.rfind('/');
+  size_t dot_pos = name.find('.', slash_pos == std::string_view::npos ? 0 : slash_pos);
+  return name.substr(0, dot_pos);
+}
+
+}  // namespace
+
+llvm::DWARFDie DwarfReader::LookupAcceleratorTables(std::string_view name, llvm::dwarf::Tag tag) {
+  const llvm::DWARFObject& dwarf_obj = dwarf_context_->getDWARFObj();
+
+  // Accelerator tables are keyed by the short name.
+  std::string_view short_name = name;
+  size_t scope_pos = name.rfind("::");
+  if (scope_pos != std::string_view::npos) {
+    short_name = name.substr(scope_pos + 2);
+  }
+  llvm::StringRef key(short_name.data(), short_name.size());
+
+  if (!dwarf_obj.getNamesSection().Data.empty()) {
+    for (const auto& entry : dwarf_context_->getDebugNames().equal_range(key)) {
+      llvm::Optional<uint64_t> cu_offset = entry.getCUOffset();
+      llvm::Optional<uint64_t> die_offset = entry.getDIEUnitOffset();
+      if (entry.tag() != tag || !cu_offset.hasValue() || !die_offset.hasValue()) {
+        continue;
+      }
+      DWARFDie die = dwarf_context_->getDIEForOffset(*cu_offset + *die_offset);
+      if (IsAcceleratorMatch(name, tag, die)) {
+        return die;
+      }
+    }
+  }
+
+  for (const llvm::AppleAcceleratorTable* table :
+       {&dwarf_context_->getAppleTypes(), &dwarf_context_->getAppleNames()}) {
+    for (const auto& entry : table->equal_range(key)) {
+      llvm::Optional<uint64_t> die_offset = entry.getDIESectionOffset();
+      if (!die_offset.hasValue()) {
+        continue;
+      }
+      DWARFDie die = dwarf_context_->getDIEForOffset(*die_offset);
+      if (IsAcceleratorMatch(name, tag, die)) {
+        return die;
+      }
+    }
+  }
+
+  return {};
+}
+
+bool DwarfReader::HasCompleteNameIndex() const {
+  if (dwarf_context_->getDWARFObj().getNamesSection().Data.empty()) {
+    return false;
+  }
+  uint64_t num_indexed_units = 0;
+  for (const auto& name_index : dwarf_context_->getDebugNames()) {
+    num_indexed_units += name_index.getCUCount();
+  }
+  return num_indexed_units == dwarf_context_->getNumCompileUnits();
+}
+
+std::optional<std::vector<llvm::DWARFUnit*>> DwarfReader::CandidateUnits(std::string_view name) {
+  if (source_language_ != llvm::dwarf::DW_LANG_Go) {
+    return std::nullopt;
+  }
+
+  // Golang emits one compilation unit per package, named after the package. Functions live in
+  // the unit of their package, while the linker places all type DIEs in the runtime unit.
+  std::string_view package = GolangPackageName(name);
+  std::vector<llvm::DWARFUnit*> units;
+  bool found_package = false;
+  for (const auto& CU : dwarf_context_->normal_units()) {
+    std::string_view unit_name = GetShortName(CU->getUnitDIE(/* ExtractUnitDIEOnly */ true));
+    if (unit_name == package) {
+      found_package = true;
+      units.push_back(CU.get());
+    } else if (unit_name == "runtime") {
+      units.push_back(CU.get());
+    }
+  }
+
+  // Without a unit for the package, e.g. if the name isn't package qualified, any unit may define
+  // the name.
+  if (!found_package) {
+    return std::nullopt;
+  }
+  return units;
+}
+
+std::vector<DWARFDie> DwarfReader::LazyGetMatchingDIEs(std::string_view name,
+                                                       llvm::dwarf::Tag tag) {
+  auto find_indexed = [this, name, tag]() -> std::vector<DWARFDie> {
+    // Looked up each time, since indexing may rehash die_map_.
+    const auto& die_type_map = die_map_[tag];
+    auto iter = die_type_map.find(name);
+    if (iter != die_type_map.end()) {
+      return {iter->second};
+    }
+    return {};
+  };
+
+  std::vector<DWARFDie> dies = find_indexed();
+  if (!dies.empty()) {
+    return dies;
+  }
+
+  DWARFDie die = LookupAcceleratorTables(name, tag);
+  if (die.isValid()) {
+    die_map_[tag][name] = die;
+    return {die};
+  }
+  if (complete_name_index_) {
+    return {};
+  }
+
+  // Index the units where the name is expected. A miss there means that the name doesn't exist,
+  // so it doesn't index the other units. Only names that can't be narrowed down to some units
+  // index them all.
+  std::optional<std::vector<llvm::DWARFUnit*>> units = CandidateUnits(name);
+  IndexUnits(units.has_value() ? units.value() : AllUnits());
+  return find_indexed();
+}
+
 StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(std::string_view name,
                                                              std::optional<llvm::dwarf::Tag> type) {
   DCHECK(dwarf_context_ != nullptr);
   std::vector<DWARFDie> dies;
 
+  if (index_mode_ == IndexMode::kLazy && type.has_value() && IsIndexedType(type.value())) {
+    return LazyGetMatchingDIEs(name, type.value());
+  }
+
   // Special case for types that are indexed.
   if (type.has_value() && !die_map_.empty()) {
     llvm::dwarf::Tag tag = type.value();
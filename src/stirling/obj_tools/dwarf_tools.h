@@ -22,6 +22,7 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 #include <limits>
 #include <map>
@@ -165,15 +166,36 @@ inline bool operator==(const StructSpecEntry& a, const StructSpecEntry& b) {
 
 class DwarfReader {
  public:
+  // Controls how DIEs of the indexed types (structs, classes and functions) are looked up.
+  enum class IndexMode {
+    // Every lookup scans all compilation units.
+    kNone,
+
+    // All compilation units are indexed when the DwarfReader is created.
+    kFull,
+
+    // Compilation units are indexed on demand, only when a lookup needs them.
+    // Accelerator tables (.debug_names, .apple_names/.apple_types) are consulted first when the
+    // object file has them. Otherwise, for Golang, only the units of the symbol's package (and the
+    // runtime unit, which holds the type DIEs) are indexed. This keeps both the startup latency
+    // and the memory footprint low when only a handful of names are looked up.
+    //
+    // A name that is missing from a .debug_names table that covers every unit, or from the units
+    // of its Golang package, is reported as missing without indexing anything else. Otherwise, for
+    // example a C++ binary without accelerator tables, a lookup indexes all units, like kFull.
+    kLazy,
+  };
+
   /**
    * Creates a DwarfReader that provides access to DWARF Debugging information entries (DIEs).
+   * The object file is memory-mapped, so only the sections (and pages) that are accessed are read.
    * @param obj_filename The object file from which to read DWARF information.
-   * @param index If true, creates an index to speed up accesses when called more than once.
+   * @param index_mode How to index DIEs to speed up accesses when called more than once.
    * @return error if file does not exist or is not a valid object file. Otherwise returns
    * a unique pointer to a DwarfReader.
    */
   static StatusOr<std::unique_ptr<DwarfReader>> Create(std::string_view obj_filename,
-                                                       bool index = true);
+                                                       IndexMode index_mode = IndexMode::kFull);
 
   /**
    * Searches the debug information for Debugging information entries (DIEs)
@@ -289,6 +311,9 @@ class DwarfReader {
 
   const llvm::dwarf::SourceLanguage& source_language() const { return source_language_; }
 
+  // The number of compilation units whose DIEs are indexed.
+  size_t testing_num_indexed_units() const { return indexed_units_.size(); }
+
  private:
   DwarfReader(std::unique_ptr<llvm::MemoryBuffer> buffer,
               std::unique_ptr<llvm::DWARFContext> dwarf_context);
@@ -296,10 +321,32 @@ class DwarfReader {
   // Detects the source language of the dwarf content being read.
   Status DetectSourceLanguage();
 
+  // Returns all the normal (non-DWO) compilation units.
+  std::vector<llvm::DWARFUnit*> AllUnits();
+
   // Builds an index for certain commonly used DIE types (e.g. structs and functions).
   // When making multiple DwarfReader calls, this speeds up the process at the cost of some memory.
   void IndexDIEs();
 
+  // Adds the DIEs of the specified compilation units to the index. Units already indexed are
+  // skipped.
+  void IndexUnits(const std::vector<llvm::DWARFUnit*>& units);
+
+  // Returns the compilation units that define the name if it exists, for IndexMode::kLazy, or
+  // nullopt if they can't be narrowed down, and any unit may define it.
+  std::optional<std::vector<llvm::DWARFUnit*>> CandidateUnits(std::string_view name);
+
+  // Returns true if the .debug_names accelerator tables index every compilation unit, so that a
+  // name that they don't have doesn't exist.
+  bool HasCompleteNameIndex() const;
+
+  // Looks up the name in the accelerator tables, if the object file has any.
+  // Returns an invalid DIE if there was no match.
+  llvm::DWARFDie LookupAcceleratorTables(std::string_view name, llvm::dwarf::Tag tag);
+
+  // Looks up DIEs of an indexed type, indexing the needed compilation units on demand.
+  std::vector<llvm::DWARFDie> LazyGetMatchingDIEs(std::string_view name, llvm::dwarf::Tag tag);
+
   static Status GetMatchingDIEs(llvm::DWARFContext::unit_iterator_range CUs, std::string_view name,
                                 std::optional<llvm::dwarf::Tag> tag,
                                 std::vector<llvm::DWARFDie>* dies_out);
@@ -316,8 +363,16 @@ class DwarfReader {
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer_;
   std::unique_ptr<llvm::DWARFContext> dwarf_context_;
 
+  IndexMode index_mode_ = IndexMode::kNone;
+
   // Nested map: [tag][symbol_name] -> DWARFDie
   absl::flat_hash_map<llvm::dwarf::Tag, absl::flat_hash_map<std::string, llvm::DWARFDie>> die_map_;
+
+  // The compilation units whose DIEs are in die_map_.
+  absl::flat_hash_set<const llvm::DWARFUnit*> indexed_units_;
+
+  // Whether HasCompleteNameIndex(), computed on creation with IndexMode::kLazy.
+  bool complete_name_index_ = false;
 };
 
 //-----------------------------------------------------------------------------
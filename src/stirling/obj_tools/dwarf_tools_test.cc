@@ -42,7 +42,7 @@ using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
 
 struct DwarfReaderTestParam {
-  bool index;
+  DwarfReader::IndexMode index_mode;
 };
 
 class DwarfReaderTest : public ::testing::TestWithParam<DwarfReaderTestParam> {
@@ -66,7 +66,7 @@ TEST_F(DwarfReaderTest, NonExistentPath) {
 
 TEST_F(DwarfReaderTest, SourceLanguage) {
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, /*index*/ true));
+                       DwarfReader::Create(kCppBinaryPath, DwarfReader::IndexMode::kFull));
   // We use C++17, but the dwarf shows 14.
   EXPECT_EQ(dwarf_reader->source_language(), llvm::dwarf::DW_LANG_C_plus_plus_14);
 }
@@ -107,10 +107,62 @@ TEST_F(DwarfReaderTest, GetMatchingDIEs) {
   ASSERT_EQ(dies[0].getTag(), llvm::dwarf::DW_TAG_structure_type);
 }
 
+// Lazy indexing must resolve names to the same DIEs as the full index.
+TEST_F(DwarfReaderTest, LazyIndexMatchesFullIndex) {
+  struct NameAndTag {
+    std::string binary;
+    std::string name;
+    llvm::dwarf::Tag tag;
+  };
+  const std::vector<NameAndTag> kLookups = {
+      {kCppBinaryPath, "ABCStruct32", llvm::dwarf::DW_TAG_structure_type},
+      {kCppBinaryPath, "px::testing::Foo::Bar", llvm::dwarf::DW_TAG_subprogram},
+      {kCppBinaryPath, "non-existent-name", llvm::dwarf::DW_TAG_subprogram},
+      {kGoBinaryPath, "main.Vertex", llvm::dwarf::DW_TAG_structure_type},
+      {kGoBinaryPath, "main.(*Vertex).Scale", llvm::dwarf::DW_TAG_subprogram},
+      {kGoBinaryPath, "runtime.g", llvm::dwarf::DW_TAG_structure_type},
+      {kGoBinaryPath, "main.Bogus", llvm::dwarf::DW_TAG_structure_type},
+  };
+
+  for (const auto& lookup : kLookups) {
+    SCOPED_TRACE(lookup.name);
+
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> full_reader,
+                         DwarfReader::Create(lookup.binary, DwarfReader::IndexMode::kFull));
+    ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> lazy_reader,
+                         DwarfReader::Create(lookup.binary, DwarfReader::IndexMode::kLazy));
+
+    ASSERT_OK_AND_ASSIGN(std::vector<DWARFDie> full_dies,
+                         full_reader->GetMatchingDIEs(lookup.name, lookup.tag));
+    // Look up twice, to cover both the cold and the warm path.
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_OK_AND_ASSIGN(std::vector<DWARFDie> lazy_dies,
+                           lazy_reader->GetMatchingDIEs(lookup.name, lookup.tag));
+      ASSERT_EQ(lazy_dies.size(), full_dies.size());
+      for (size_t j = 0; j < full_dies.size(); ++j) {
+        EXPECT_EQ(lazy_dies[j].getOffset(), full_dies[j].getOffset());
+      }
+    }
+  }
+}
+
+// A Golang name that doesn't exist only indexes the units of its package.
+TEST_F(DwarfReaderTest, LazyIndexMissDoesNotIndexAllUnits) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> full_reader,
+                       DwarfReader::Create(kGoBinaryPath, DwarfReader::IndexMode::kFull));
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> lazy_reader,
+                       DwarfReader::Create(kGoBinaryPath, DwarfReader::IndexMode::kLazy));
+
+  EXPECT_OK_AND_THAT(
+      lazy_reader->GetMatchingDIEs("main.Bogus", llvm::dwarf::DW_TAG_structure_type), IsEmpty());
+  EXPECT_GT(lazy_reader->testing_num_indexed_units(), 0);
+  EXPECT_LT(lazy_reader->testing_num_indexed_units(), full_reader->testing_num_indexed_units());
+}
+
 TEST_P(DwarfReaderTest, CppGetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct32"), 12);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct64"), 24);
@@ -119,7 +171,7 @@ TEST_P(DwarfReaderTest, CppGetStructByteSize) {
 TEST_P(DwarfReaderTest, GolangGetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("main.Vertex"), 16);
 }
@@ -127,7 +179,7 @@ TEST_P(DwarfReaderTest, GolangGetStructByteSize) {
 TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberInfo("ABCStruct32", "b"),
                    (StructMemberInfo{4, TypeInfo{VarType::kBaseType, "int"}}));
@@ -137,7 +189,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
 TEST_P(DwarfReaderTest, GoGetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberInfo("main.Vertex", "Y"),
                    (StructMemberInfo{8, TypeInfo{VarType::kBaseType, "float64"}}));
@@ -147,7 +199,7 @@ TEST_P(DwarfReaderTest, GoGetStructMemberInfo) {
 TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "a"), 0);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "b"), 4);
@@ -157,7 +209,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, GoGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("main.Vertex", "Y"), 8);
   EXPECT_NOT_OK(dwarf_reader->GetStructMemberOffset("main.Vertex", "bogus"));
@@ -167,7 +219,7 @@ TEST_P(DwarfReaderTest, GoGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, GetStructMemberOffsetUnconventional) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryUnconventionalPath, p.index));
+                       DwarfReader::Create(kGoBinaryUnconventionalPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("runtime.g", "goid"), 192);
 }
@@ -175,7 +227,7 @@ TEST_P(DwarfReaderTest, GetStructMemberOffsetUnconventional) {
 TEST_P(DwarfReaderTest, CppGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("OuterStruct"),
@@ -220,7 +272,7 @@ TEST_P(DwarfReaderTest, CppGetStructSpec) {
 TEST_P(DwarfReaderTest, GoGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("main.OuterStruct"),
@@ -265,7 +317,7 @@ TEST_P(DwarfReaderTest, GoGetStructSpec) {
 TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("CanYouFindThis", "a"), 4);
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("ABCSum32", "x"), 12);
@@ -276,7 +328,7 @@ TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, GolangArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   // v is of type *Vertex.
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("main.(*Vertex).Scale", "v"), 8);
@@ -289,7 +341,7 @@ TEST_P(DwarfReaderTest, GolangArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, CppArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("ABCSum32", "x"),
                    (ArgLocation{.loc_type = LocationType::kRegister, .offset = 32}));
@@ -308,7 +360,7 @@ TEST_P(DwarfReaderTest, CppArgumentLocation) {
 TEST_P(DwarfReaderTest, GolangArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("main.(*Vertex).Scale", "v"),
                    (ArgLocation{.loc_type = LocationType::kStack, .offset = 0}));
@@ -330,7 +382,7 @@ TEST_P(DwarfReaderTest, GolangArgumentLocation) {
 TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_THAT(
       dwarf_reader->GetFunctionArgInfo("CanYouFindThis"),
@@ -356,7 +408,7 @@ TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
 TEST_P(DwarfReaderTest, CppFunctionRetValInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetFunctionRetValInfo("CanYouFindThis"),
                    (RetValInfo{TypeInfo{VarType::kBaseType, "int"}, 4}));
@@ -371,7 +423,7 @@ TEST_P(DwarfReaderTest, GoFunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         DwarfReader::Create(kGoBinaryPath, p.index));
+                         DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
     EXPECT_OK_AND_THAT(
         dwarf_reader->GetFunctionArgInfo("main.(*Vertex).Scale"),
@@ -420,7 +472,7 @@ TEST_P(DwarfReaderTest, GoFunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         DwarfReader::Create(kGoServerBinaryPath, p.index));
+                         DwarfReader::Create(kGoServerBinaryPath, p.index_mode));
 
     //   func (f *http2Framer) WriteDataPadded(streamID uint32, endStream bool, data, pad []byte)
     //   error
@@ -447,7 +499,7 @@ TEST_P(DwarfReaderTest, GoFunctionArgLocationConsistency) {
   DwarfReaderTestParam p = GetParam();
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryPath, p.index));
+                       DwarfReader::Create(kGoBinaryPath, p.index_mode));
 
   // First run GetFunctionArgInfo to automatically get all arguments.
   ASSERT_OK_AND_ASSIGN(auto function_arg_locations,
@@ -466,8 +518,9 @@ TEST_P(DwarfReaderTest, GoFunctionArgLocationConsistency) {
 }
 
 INSTANTIATE_TEST_SUITE_P(DwarfReaderParameterizedTest, DwarfReaderTest,
-                         ::testing::Values(DwarfReaderTestParam{true},
-                                           DwarfReaderTestParam{false}));
+                         ::testing::Values(DwarfReaderTestParam{DwarfReader::IndexMode::kFull},
+                                           DwarfReaderTestParam{DwarfReader::IndexMode::kNone},
+                                           DwarfReaderTestParam{DwarfReader::IndexMode::kLazy}));
 
 }  // namespace obj_tools
 }  // namespace stirling
@@ -57,8 +57,9 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
-  PL_ASSIGN_OR_EXIT(auto dwarf_reader, px::stirling::obj_tools::DwarfReader::Create(
-                                           FLAGS_filename, /* index */ false));
+  using px::stirling::obj_tools::DwarfReader;
+  PL_ASSIGN_OR_EXIT(auto dwarf_reader,
+                    DwarfReader::Create(FLAGS_filename, DwarfReader::IndexMode::kNone));
   PL_ASSIGN_OR_EXIT(std::vector<llvm::DWARFDie> dies,
                     dwarf_reader->GetMatchingDIEs(FLAGS_die_name));
 
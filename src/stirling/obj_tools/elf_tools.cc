@@ -23,6 +23,7 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_set.h>
+#include <algorithm>
 #include <set>
 #include <utility>
 
@@ -43,10 +44,30 @@ struct LowercaseHex {
   static inline constexpr int kSizePerByte = 2;
   static inline constexpr bool kKeepPrintableChars = false;
 };
+// Returns the "desc" field of an ELF note section, as a lowercase hex string.
+std::string NoteDesc(ELFIO::section* psec) {
+  // Structure of this section:
+  //    namesz :   32-bit, size of "name" field
+  //    descsz :   32-bit, size of "desc" field
+  //    type   :   32-bit, vendor specific "type"
+  //    name   :   "namesz" bytes, null-terminated string
+  //    desc   :   "descsz" bytes, binary data
+  int32_t name_size =
+      utils::LEndianBytesToInt<int32_t>(std::string_view(psec->get_data(), sizeof(int32_t)));
+  int32_t desc_size = utils::LEndianBytesToInt<int32_t>(
+      std::string_view(psec->get_data() + sizeof(int32_t), sizeof(int32_t)));
+
+  int32_t desc_pos = 3 * sizeof(int32_t) + name_size;
+  std::string_view desc = std::string_view(psec->get_data() + desc_pos, desc_size);
+
+  return BytesToString<LowercaseHex>(desc);
+}
+
 }  // namespace
 
 Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir) {
   std::string build_id;
+  std::string go_build_id;
   std::string debug_link;
   bool found_symtab = false;
 
@@ -65,24 +86,15 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
 
     // Method 1: build-id.
     if (psec->get_name() == ".note.gnu.build-id") {
-      // Structure of this section:
-      //    namesz :   32-bit, size of "name" field
-      //    descsz :   32-bit, size of "desc" field
-      //    type   :   32-bit, vendor specific "type"
-      //    name   :   "namesz" bytes, null-terminated string
-      //    desc   :   "descsz" bytes, binary data
-      int32_t name_size =
-          utils::LEndianBytesToInt<int32_t>(std::string_view(psec->get_data(), sizeof(int32_t)));
-      int32_t desc_size = utils::LEndianBytesToInt<int32_t>(
-          std::string_view(psec->get_data() + sizeof(int32_t), sizeof(int32_t)));
-
-      int32_t desc_pos = 3 * sizeof(int32_t) + name_size;
-      std::string_view desc = std::string_view(psec->get_data() + desc_pos, desc_size);
-
-      build_id = BytesToString<LowercaseHex>(desc);
+      build_id = NoteDesc(psec);
       VLOG(1) << absl::Substitute("Found build-id: $0", build_id);
     }
 
+    // The Go build ID does not locate debug symbols, but still identifies the binary.
+    if (psec->get_name() == ".note.go.buildid") {
+      go_build_id = NoteDesc(psec);
+    }
+
     // Method 2: .gnu_debuglink.
     if (psec->get_name() == ".gnu_debuglink") {
       constexpr int kCRCBytes = 4;
@@ -91,6 +103,8 @@ Status ElfReader::LocateDebugSymbols(const std::filesystem::path& debug_file_dir
     }
   }
 
+  build_id_ = !build_id.empty() ? build_id : go_build_id;
+
   // In priority order, we try:
   //  1) Accessing included symtab section.
   //  2) Finding debug symbols via build-id.
@@ -193,8 +207,11 @@ StatusOr<std::unique_ptr<ElfReader>> ElfReader::Create(
   return elf_reader;
 }
 
-StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
-    std::string_view search_symbol, SymbolMatchType match_type, std::optional<int> symbol_type) {
+Status ElfReader::IndexSymbols() {
+  if (symbols_indexed_) {
+    return Status::OK();
+  }
+
   ELFIO::section* symtab_section = nullptr;
   for (int i = 0; i < elf_reader_.sections.size(); ++i) {
     ELFIO::section* psec = elf_reader_.sections[i];
@@ -211,10 +228,9 @@ StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
     return error::NotFound("Could not find symtab section in binary=$0", binary_path_);
   }
 
-  std::vector<SymbolInfo> symbol_infos;
-
-  // Scan all symbols inside the symbol table.
+  // Read all symbols inside the symbol table.
   const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
+  symbols_.reserve(symbols.get_symbols_num());
   for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
     std::string name;
     ELFIO::Elf64_Addr addr = 0;
@@ -224,31 +240,62 @@ StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
     ELFIO::Elf_Half section_index;
     unsigned char other;
     symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
+    symbols_.push_back({std::move(name), type, addr, size});
+  }
 
-    if (symbol_type.has_value() && type != symbol_type.value()) {
-      continue;
-    }
+  symbols_by_name_.resize(symbols_.size());
+  for (uint32_t k = 0; k < symbols_by_name_.size(); ++k) {
+    symbols_by_name_[k] = k;
+  }
+  std::stable_sort(symbols_by_name_.begin(), symbols_by_name_.end(),
+                   [this](uint32_t a, uint32_t b) { return symbols_[a].name < symbols_[b].name; });
 
-    // Check for symbol match.
-    bool match = false;
-    switch (match_type) {
-      case SymbolMatchType::kExact:
-        match = (name == search_symbol);
-        break;
-      case SymbolMatchType::kPrefix:
-        match = absl::StartsWith(name, search_symbol);
-        break;
-      case SymbolMatchType::kSuffix:
-        match = absl::EndsWith(name, search_symbol);
-        break;
-      case SymbolMatchType::kSubstr:
-        match = (name.find(search_symbol) != std::string::npos);
+  symbols_indexed_ = true;
+  return Status::OK();
+}
+
+StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
+    std::string_view search_symbol, SymbolMatchType match_type, std::optional<int> symbol_type) {
+  PL_RETURN_IF_ERROR(IndexSymbols());
+
+  // Indexes into symbols_ of the candidate symbols, in table order.
+  std::vector<uint32_t> candidates;
+
+  if (match_type == SymbolMatchType::kExact || match_type == SymbolMatchType::kPrefix) {
+    // Exact and prefix matches form a contiguous range of the names in sorted order.
+    auto iter = std::lower_bound(
+        symbols_by_name_.begin(), symbols_by_name_.end(), search_symbol,
+        [this](uint32_t idx, std::string_view name) { return symbols_[idx].name < name; });
+    for (; iter != symbols_by_name_.end(); ++iter) {
+      const std::string& name = symbols_[*iter].name;
+      bool match = (match_type == SymbolMatchType::kExact) ? (name == search_symbol)
+                                                           : absl::StartsWith(name, search_symbol);
+      if (!match) {
         break;
+      }
+      candidates.push_back(*iter);
     }
-    if (!match) {
+    // Return the matches in table order, as a scan of the symbol table would.
+    std::sort(candidates.begin(), candidates.end());
+  } else {
+    for (uint32_t k = 0; k < symbols_.size(); ++k) {
+      const std::string& name = symbols_[k].name;
+      bool match = (match_type == SymbolMatchType::kSuffix)
+                       ? absl::EndsWith(name, search_symbol)
+                       : (name.find(search_symbol) != std::string::npos);
+      if (match) {
+        candidates.push_back(k);
+      }
+    }
+  }
+
+  std::vector<SymbolInfo> symbol_infos;
+  for (uint32_t idx : candidates) {
+    const SymbolInfo& symbol = symbols_[idx];
+    if (symbol_type.has_value() && symbol.type != symbol_type.value()) {
       continue;
     }
-    symbol_infos.push_back({std::move(name), type, addr, size});
+    symbol_infos.push_back(symbol);
   }
   return symbol_infos;
 }
@@ -372,11 +419,18 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
 }  // namespace
 
 StatusOr<std::vector<uint64_t>> ElfReader::FuncRetInstAddrs(const SymbolInfo& func_symbol) {
+  std::pair<uint64_t, uint64_t> key = {func_symbol.address, func_symbol.size};
+  auto iter = ret_inst_addrs_.find(key);
+  if (iter != ret_inst_addrs_.end()) {
+    return iter->second;
+  }
+
   PL_ASSIGN_OR_RETURN(utils::u8string byte_code, FuncByteCode(func_symbol));
   std::vector<uint64_t> addrs = FindRetInsts(byte_code);
   for (auto& offset : addrs) {
     offset += func_symbol.address;
   }
+  ret_inst_addrs_[key] = addrs;
   return addrs;
 }
 
@@ -21,6 +21,7 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
@@ -62,6 +63,12 @@ class ElfReader {
 
   std::filesystem::path& debug_symbols_path() { return debug_symbols_path_; }
 
+  /**
+   * Returns the build-id of the binary as a lowercase hex string, or empty if it has none.
+   * The GNU build-id is used if present; otherwise, the Go build ID.
+   */
+  const std::string& build_id() const { return build_id_; }
+
   struct SymbolInfo {
     std::string name;
     int type = -1;
@@ -97,12 +104,19 @@ class ElfReader {
 
   /**
    * Returns the address of the return instructions of the function.
+   * Results are cached, so repeated calls for the same function do not disassemble it again.
    */
   StatusOr<std::vector<uint64_t>> FuncRetInstAddrs(const SymbolInfo& func_symbol);
 
  private:
   ElfReader() = default;
 
+  /**
+   * Reads the symbol table into symbols_, and sorts symbols_by_name_, if not already done.
+   * Prefers SHT_SYMTAB, and falls back to SHT_DYNSYM.
+   */
+  Status IndexSymbols();
+
   /**
    * Locates the debug symbols for the currently loaded ELF object.
    * External symbols are discovered using either the build-id or the debug-link.
@@ -121,8 +135,23 @@ class ElfReader {
 
   std::filesystem::path debug_symbols_path_;
 
+  std::string build_id_;
+
   // Set up an elf reader, so we can extract debug symbols.
   ELFIO::elfio elf_reader_;
+
+  // The symbols of the symbol table, in table order. Populated on the first search, so that
+  // further searches do not have to decode the symbol table again.
+  std::vector<SymbolInfo> symbols_;
+
+  // Indexes into symbols_, sorted by symbol name, for exact and prefix matches.
+  // Equal names are kept in table order.
+  std::vector<uint32_t> symbols_by_name_;
+
+  bool symbols_indexed_ = false;
+
+  // Caches the results of FuncRetInstAddrs(). Key is the function's {address, size}.
+  absl::flat_hash_map<std::pair<uint64_t, uint64_t>, std::vector<uint64_t>> ret_inst_addrs_;
 };
 
 struct IntfImplTypeInfo {
@@ -31,6 +31,7 @@ const DummyExeFixture kDummyExeFixture;
 
 using ::px::stirling::obj_tools::ElfReader;
 using ::px::stirling::obj_tools::SymbolMatchType;
+using ::testing::Contains;
 using ::testing::ElementsAre;
 using ::testing::Field;
 using ::testing::IsEmpty;
@@ -89,6 +90,33 @@ TEST(ElfReaderTest, ListSymbolsSuffixMatch) {
                      ElementsAre(SymbolNameIs("CanYouFindThis")));
 }
 
+// The exact and prefix searches use a sorted index, while the other searches scan the table.
+// Both must return the same symbols, in the same order.
+TEST(ElfReaderTest, IndexedSearchMatchesScan) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader,
+                       ElfReader::Create(kDummyExeFixture.Path()));
+
+  ASSERT_OK_AND_ASSIGN(std::vector<ElfReader::SymbolInfo> scanned,
+                       elf_reader->SearchSymbols("", SymbolMatchType::kSubstr));
+  ASSERT_OK_AND_ASSIGN(std::vector<ElfReader::SymbolInfo> indexed,
+                       elf_reader->SearchSymbols("", SymbolMatchType::kPrefix));
+  ASSERT_FALSE(scanned.empty());
+  ASSERT_EQ(indexed.size(), scanned.size());
+  for (size_t i = 0; i < scanned.size(); ++i) {
+    EXPECT_EQ(indexed[i].name, scanned[i].name);
+    EXPECT_EQ(indexed[i].address, scanned[i].address);
+  }
+
+  for (const auto& symbol : scanned) {
+    if (symbol.name.empty()) {
+      continue;
+    }
+    ASSERT_OK_AND_ASSIGN(std::vector<ElfReader::SymbolInfo> exact,
+                         elf_reader->SearchSymbols(symbol.name, SymbolMatchType::kExact));
+    EXPECT_THAT(exact, Contains(SymbolNameIs(symbol.name)));
+  }
+}
+
 TEST(ElfReaderTest, SymbolAddress) {
   const std::string path = kDummyExeFixture.Path().string();
   const std::string_view symbol = "CanYouFindThis";
@@ -132,6 +160,7 @@ TEST(ElfReaderTest, ExternalDebugSymbolsBuildID) {
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader,
                        ElfReader::Create(stripped_bin, debug_dir));
 
+  EXPECT_EQ(elf_reader->build_id(), "7deb0e3f89deba61");
   EXPECT_OK_AND_THAT(elf_reader->ListFuncSymbols("CanYouFindThis", SymbolMatchType::kExact),
                      ElementsAre(SymbolNameIs("CanYouFindThis")));
 }
@@ -162,6 +191,8 @@ TEST(ElfReaderTest, FuncByteCode) {
     // objdump -d src/stirling/obj_tools/testdata/prebuilt_dummy_exe | grep CanYouFindThis -A 20
     // 0x201101 is the address of the 'c3' (retq) opcode.
     ASSERT_OK_AND_THAT(elf_reader->FuncRetInstAddrs(symbol_info), ElementsAre(0x4011e1));
+    // The second call is served from the cache.
+    ASSERT_OK_AND_THAT(elf_reader->FuncRetInstAddrs(symbol_info), ElementsAre(0x4011e1));
   }
   {
     const std::string stripped_bin =
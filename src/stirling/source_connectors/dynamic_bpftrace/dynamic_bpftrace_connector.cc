@@ -20,6 +20,7 @@
 
 #include <bpftrace/src/ast/async_event_types.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -133,6 +134,54 @@ StatusOr<BackedDataElements> ConvertFields(const std::vector<bpftrace::Field> fi
   return columns;
 }
 
+// Returns the columns of a program that outputs through a map: the time of the drain, one column
+// per key, and the value.
+StatusOr<BackedDataElements> ConvertMapType(const bpf_tools::BPFTraceMapType& map_type) {
+  switch (map_type.value_type.type) {
+    case bpftrace::Type::count:
+    case bpftrace::Type::sum:
+    case bpftrace::Type::integer:
+      break;
+    default:
+      return error::InvalidArgument(
+          "Aggregate map values must be count(), sum() or integers, not $0.",
+          magic_enum::enum_name(map_type.value_type.type));
+  }
+
+  const std::vector<bpftrace::SizedType>& key_types = map_type.key_types;
+  BackedDataElements columns(key_types.size() + 2);
+  columns.emplace_back("time_", "", types::DataType::TIME64NS);
+  for (size_t i = 0; i < key_types.size(); ++i) {
+    types::DataType col_type;
+    switch (key_types[i].type) {
+      case bpftrace::Type::integer:
+        switch (key_types[i].size) {
+          case 8:
+          case 4:
+          case 2:
+          case 1:
+            break;
+          default:
+            return error::Internal("Map key $0 has invalid integer size: $1.", i,
+                                   key_types[i].size);
+        }
+        col_type = types::DataType::INT64;
+        break;
+      case bpftrace::Type::string:
+        col_type = types::DataType::STRING;
+        break;
+      default:
+        return error::InvalidArgument("Aggregate map keys must be integers or strings, not $0.",
+                                      magic_enum::enum_name(key_types[i].type));
+    }
+    std::string col_name = key_types.size() == 1 ? "key" : absl::StrCat("key_", i);
+    columns.emplace_back(std::move(col_name), "", col_type);
+  }
+  columns.emplace_back("value", "", types::DataType::INT64);
+
+  return columns;
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<SourceConnector>> DynamicBPFTraceConnector::Create(
@@ -144,10 +193,19 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicBPFTraceConnector::Create(
   // TODO(oazizi): Clean this up. No time now since trying to get this out quickly.
   //               Right solution is probably to inject the compiled program into the connector.
   BPFTraceWrapper bpftrace;
-  PL_RETURN_IF_ERROR(bpftrace.CompileForPrintfOutput(tracepoint.bpftrace().program(), {}));
-  const std::vector<bpftrace::Field>& fields = bpftrace.OutputFields();
-  std::string_view format_str = bpftrace.OutputFmtStr();
-  PL_ASSIGN_OR_RETURN(BackedDataElements columns, ConvertFields(fields, format_str));
+  const std::string& aggregate_map = tracepoint.bpftrace().aggregate_map();
+  BackedDataElements columns(0);
+  if (aggregate_map.empty()) {
+    PL_RETURN_IF_ERROR(bpftrace.CompileForPrintfOutput(tracepoint.bpftrace().program(), {}));
+    const std::vector<bpftrace::Field>& fields = bpftrace.OutputFields();
+    std::string_view format_str = bpftrace.OutputFmtStr();
+    PL_ASSIGN_OR_RETURN(columns, ConvertFields(fields, format_str));
+  } else {
+    PL_RETURN_IF_ERROR(bpftrace.CompileForMapOutput(tracepoint.bpftrace().program(), {}));
+    PL_ASSIGN_OR_RETURN(bpf_tools::BPFTraceMapType map_type,
+                        bpftrace.GetBPFMapType(aggregate_map));
+    PL_ASSIGN_OR_RETURN(columns, ConvertMapType(map_type));
+  }
 
   // Could consider making a better description, but may require more user input,
   // so punting on that for now.
@@ -157,15 +215,16 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicBPFTraceConnector::Create(
       DynamicDataTableSchema::Create(tracepoint.table_name(), desc, std::move(columns));
 
   return std::unique_ptr<SourceConnector>(new DynamicBPFTraceConnector(
-      source_name, std::move(table_schema), tracepoint.bpftrace().program()));
+      source_name, std::move(table_schema), tracepoint.bpftrace().program(), aggregate_map));
 }
 
 DynamicBPFTraceConnector::DynamicBPFTraceConnector(
     std::string_view source_name, std::unique_ptr<DynamicDataTableSchema> table_schema,
-    std::string_view script)
+    std::string_view script, std::string_view aggregate_map)
     : SourceConnector(source_name, ArrayView<DataTableSchema>(&table_schema->Get(), 1)),
       table_schema_(std::move(table_schema)),
-      script_(script) {}
+      script_(script),
+      aggregate_map_(aggregate_map) {}
 
 namespace {
 
@@ -225,10 +284,22 @@ Status DynamicBPFTraceConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
 
+  if (!aggregate_map_.empty()) {
+    PL_RETURN_IF_ERROR(CompileForMapOutput(script_, {}));
+    PL_ASSIGN_OR_RETURN(bpf_tools::BPFTraceMapType map_type, GetBPFMapType(aggregate_map_));
+    PL_ASSIGN_OR_RETURN(BackedDataElements columns, ConvertMapType(map_type));
+    if (columns.elements().size() != table_schema_->Get().elements().size()) {
+      return error::Internal("Map $0 does not match the specified schema.", aggregate_map_);
+    }
+    aggregate_key_types_ = std::move(map_type.key_types);
+    return Deploy();
+  }
+
   auto callback_fn = std::bind(&DynamicBPFTraceConnector::HandleEvent, this, std::placeholders::_1);
   PL_RETURN_IF_ERROR(CompileForPrintfOutput(script_, {}));
   output_fields_ = OutputFields();
   PL_RETURN_IF_ERROR(CheckOutputFields(output_fields_, table_schema_->Get().elements()));
+  PL_ASSIGN_OR_RETURN(field_decoders_, CompileFieldDecoders());
   PL_RETURN_IF_ERROR(Deploy(callback_fn));
   return Status::OK();
 }
@@ -245,6 +316,11 @@ void DynamicBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
   if (data_table_ == nullptr) {
     return;
   }
+  if (!aggregate_map_.empty()) {
+    DrainAggregateMap(data_table_);
+    data_table_ = nullptr;
+    return;
+  }
   // This trigger a callbacks for each BPFTrace printf event in the perf buffers.
   // Store data_table_ so the Handle function has the appropriate context.
   PollPerfBuffers();
@@ -270,116 +346,209 @@ std::string ResolveInet(int af, const uint8_t* inet) {
 
 }  // namespace
 
-void DynamicBPFTraceConnector::HandleEvent(uint8_t* data) {
-  DataTable::DynamicRecordBuilder r(data_table_);
+template <typename TInt>
+void DynamicBPFTraceConnector::DecodeInt(const FieldDecoder& decoder, uint8_t* data,
+                                         DataTable::DynamicRecordBuilder* r) {
+  auto val = *reinterpret_cast<TInt*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::Int64Value(val));
+}
 
-  const auto& columns = table_schema_->Get().elements();
+template <typename TInt>
+void DynamicBPFTraceConnector::DecodeTime(const FieldDecoder& decoder, uint8_t* data,
+                                          DataTable::DynamicRecordBuilder* r) {
+  auto val = *reinterpret_cast<TInt*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::Time64NSValue(val + ClockRealTimeOffset()));
+}
 
-  int col = 0;
-  for (size_t i = 0; i < output_fields_.size(); ++i) {
-    const auto& field = output_fields_[i];
-    const auto& column = columns[i];
+void DynamicBPFTraceConnector::DecodeString(const FieldDecoder& decoder, uint8_t* data,
+                                            DataTable::DynamicRecordBuilder* r) {
+  auto p = reinterpret_cast<char*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::StringValue(std::string(p, strnlen(p, decoder.field->type.size))));
+}
 
-    switch (field.type.type) {
-      case bpftrace::Type::integer:
+void DynamicBPFTraceConnector::DecodeInet(const FieldDecoder& decoder, uint8_t* data,
+                                          DataTable::DynamicRecordBuilder* r) {
+  int64_t af = *reinterpret_cast<int64_t*>(data + decoder.field->offset);
+  uint8_t* inet = reinterpret_cast<uint8_t*>(data + decoder.field->offset + 8);
+  r->Append(decoder.col, types::StringValue(ResolveInet(af, inet)));
+}
 
-#define APPEND_INTEGER(int_type, expr)                                  \
-  {                                                                     \
-    auto val = *reinterpret_cast<int_type*>(expr);                      \
-    if (column.type() == types::DataType::TIME64NS) {                   \
-      r.Append(col, types::Time64NSValue(val + ClockRealTimeOffset())); \
-    } else {                                                            \
-      r.Append(col, types::Int64Value(val));                            \
-    }                                                                   \
-  }
+void DynamicBPFTraceConnector::DecodeUsym(const FieldDecoder& decoder, uint8_t* data,
+                                          DataTable::DynamicRecordBuilder* r) {
+  uint64_t addr = *reinterpret_cast<uint64_t*>(data + decoder.field->offset);
+  uint64_t pid = *reinterpret_cast<uint64_t*>(data + decoder.field->offset + 8);
+  r->Append(decoder.col, types::StringValue(bpftrace_.resolve_usym(addr, pid)));
+}
 
-        switch (field.type.size) {
+void DynamicBPFTraceConnector::DecodeKsym(const FieldDecoder& decoder, uint8_t* data,
+                                          DataTable::DynamicRecordBuilder* r) {
+  uint64_t addr = *reinterpret_cast<uint64_t*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::StringValue(bpftrace_.resolve_ksym(addr)));
+}
+
+void DynamicBPFTraceConnector::DecodeUsername(const FieldDecoder& decoder, uint8_t* data,
+                                              DataTable::DynamicRecordBuilder* r) {
+  uint64_t addr = *reinterpret_cast<uint64_t*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::StringValue(bpftrace_.resolve_uid(addr)));
+}
+
+void DynamicBPFTraceConnector::DecodeProbe(const FieldDecoder& decoder, uint8_t* data,
+                                           DataTable::DynamicRecordBuilder* r) {
+  uint64_t probe_id = *reinterpret_cast<uint64_t*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::StringValue(bpftrace_.resolve_probe(probe_id)));
+}
+
+template <bool TUstack>
+void DynamicBPFTraceConnector::DecodeStack(const FieldDecoder& decoder, uint8_t* data,
+                                           DataTable::DynamicRecordBuilder* r) {
+  uint64_t stackidpid = *reinterpret_cast<uint64_t*>(data + decoder.field->offset);
+  auto& stack_type = decoder.field->type.stack_type;
+  r->Append(decoder.col, types::StringValue(bpftrace_.get_stack(stackidpid, TUstack, stack_type)));
+}
+
+void DynamicBPFTraceConnector::DecodeTimestamp(const FieldDecoder& decoder, uint8_t* data,
+                                               DataTable::DynamicRecordBuilder* r) {
+  auto x = reinterpret_cast<bpftrace::AsyncEvent::Strftime*>(data + decoder.field->offset);
+  r->Append(decoder.col, types::StringValue(
+                             bpftrace_.resolve_timestamp(x->strftime_id, x->nsecs_since_boot)));
+}
+
+StatusOr<std::vector<DynamicBPFTraceConnector::FieldDecoder>>
+DynamicBPFTraceConnector::CompileFieldDecoders() const {
+  using C = DynamicBPFTraceConnector;
+
+  const auto& columns = table_schema_->Get().elements();
+
+  std::vector<FieldDecoder> decoders;
+  decoders.reserve(output_fields_.size());
+  for (size_t i = 0; i < output_fields_.size(); ++i) {
+    FieldDecoder decoder;
+    decoder.col = i;
+    decoder.field = &output_fields_[i];
+
+    const bpftrace::SizedType& type = output_fields_[i].type;
+    switch (type.type) {
+      case bpftrace::Type::integer: {
+        bool is_time = columns[i].type() == types::DataType::TIME64NS;
+        switch (type.size) {
           case 8:
-            APPEND_INTEGER(uint64_t, data + field.offset);
+            decoder.fn = is_time ? &C::DecodeTime<uint64_t> : &C::DecodeInt<uint64_t>;
             break;
           case 4:
-            APPEND_INTEGER(uint32_t, data + field.offset);
+            decoder.fn = is_time ? &C::DecodeTime<uint32_t> : &C::DecodeInt<uint32_t>;
             break;
           case 2:
-            APPEND_INTEGER(uint16_t, data + field.offset);
+            decoder.fn = is_time ? &C::DecodeTime<uint16_t> : &C::DecodeInt<uint16_t>;
             break;
           case 1:
-            APPEND_INTEGER(uint8_t, data + field.offset);
+            decoder.fn = is_time ? &C::DecodeTime<uint8_t> : &C::DecodeInt<uint8_t>;
             break;
           default:
-            LOG(DFATAL) << absl::Substitute(
-                "[DataTable: $0, col: $1] Invalid integer size: $2. Table is now inconsistent. "
-                "This is a critical error.",
-                name_, col, field.type.size);
-            break;
+            return error::Internal("Perf event on column $0 contains invalid integer size: $1.", i,
+                                   type.size);
         }
         break;
-#undef APPEND_INTEGER
-      case bpftrace::Type::string: {
-        auto p = reinterpret_cast<char*>(data + field.offset);
-        r.Append(col, types::StringValue(std::string(p, strnlen(p, field.type.size))));
-        break;
       }
-      case bpftrace::Type::inet: {
-        int64_t af = *reinterpret_cast<int64_t*>(data + field.offset);
-        uint8_t* inet = reinterpret_cast<uint8_t*>(data + field.offset + 8);
-        r.Append(col, types::StringValue(ResolveInet(af, inet)));
+      case bpftrace::Type::pointer:
+        decoder.fn = &C::DecodeInt<uint64_t>;
         break;
-      }
-      case bpftrace::Type::usym: {
-        uint64_t addr = *reinterpret_cast<uint64_t*>(data + field.offset);
-        uint64_t pid = *reinterpret_cast<uint64_t*>(data + field.offset + 8);
-        r.Append(col, types::StringValue(bpftrace_.resolve_usym(addr, pid)));
+      case bpftrace::Type::string:
+        decoder.fn = &C::DecodeString;
         break;
-      }
-      case bpftrace::Type::ksym: {
-        uint64_t addr = *reinterpret_cast<uint64_t*>(data + field.offset);
-        r.Append(col, types::StringValue(bpftrace_.resolve_ksym(addr)));
+      case bpftrace::Type::inet:
+        decoder.fn = &C::DecodeInet;
         break;
-      }
-      case bpftrace::Type::username: {
-        uint64_t addr = *reinterpret_cast<uint64_t*>(data + field.offset);
-        r.Append(col, types::StringValue(bpftrace_.resolve_uid(addr)));
+      case bpftrace::Type::usym:
+        decoder.fn = &C::DecodeUsym;
         break;
-      }
-      case bpftrace::Type::probe: {
-        uint64_t probe_id = *reinterpret_cast<uint64_t*>(data + field.offset);
-        r.Append(col, types::StringValue(bpftrace_.resolve_probe(probe_id)));
+      case bpftrace::Type::ksym:
+        decoder.fn = &C::DecodeKsym;
         break;
-      }
-      case bpftrace::Type::kstack: {
-        uint64_t stackidpid = *reinterpret_cast<uint64_t*>(data + field.offset);
-        bool ustack = false;
-        auto& stack_type = field.type.stack_type;
-        r.Append(col, types::StringValue(bpftrace_.get_stack(stackidpid, ustack, stack_type)));
+      case bpftrace::Type::username:
+        decoder.fn = &C::DecodeUsername;
         break;
-      }
-      case bpftrace::Type::ustack: {
-        uint64_t stackidpid = *reinterpret_cast<uint64_t*>(data + field.offset);
-        bool ustack = true;
-        auto& stack_type = field.type.stack_type;
-        r.Append(col, types::StringValue(bpftrace_.get_stack(stackidpid, ustack, stack_type)));
+      case bpftrace::Type::probe:
+        decoder.fn = &C::DecodeProbe;
         break;
-      }
-      case bpftrace::Type::timestamp: {
-        auto x = reinterpret_cast<bpftrace::AsyncEvent::Strftime*>(data + field.offset);
-        r.Append(col, types::StringValue(
-                          bpftrace_.resolve_timestamp(x->strftime_id, x->nsecs_since_boot)));
+      case bpftrace::Type::kstack:
+        decoder.fn = &C::DecodeStack</*TUstack*/ false>;
         break;
-      }
-      case bpftrace::Type::pointer: {
-        uint64_t p = *reinterpret_cast<uint64_t*>(data + field.offset);
-        r.Append(col, types::Int64Value(p));
+      case bpftrace::Type::ustack:
+        decoder.fn = &C::DecodeStack</*TUstack*/ true>;
+        break;
+      case bpftrace::Type::timestamp:
+        decoder.fn = &C::DecodeTimestamp;
         break;
-      }
       default:
-        LOG(DFATAL) << absl::Substitute(
-            "[DataTable: $0, col: $1] Invalid argument type $2. Table is now inconsistent. This is "
-            "a critical error.",
-            name_, col, magic_enum::enum_name(field.type.type));
+        return error::Internal("Column $0 has unhandled type $1.", i,
+                               magic_enum::enum_name(type.type));
     }
+    decoders.push_back(decoder);
+  }
+  return decoders;
+}
+
+void DynamicBPFTraceConnector::HandleEvent(uint8_t* data) {
+  DataTable::DynamicRecordBuilder r(data_table_);
 
-    ++col;
+  // The decoders were checked against the schema at Init, so every column gets its value.
+  for (const FieldDecoder& decoder : field_decoders_) {
+    (this->*decoder.fn)(decoder, data, &r);
+  }
+}
+
+namespace {
+
+int64_t ReadMapKeyInt(const uint8_t* p, size_t size) {
+  switch (size) {
+    case 8:
+      return *reinterpret_cast<const uint64_t*>(p);
+    case 4:
+      return *reinterpret_cast<const uint32_t*>(p);
+    case 2:
+      return *reinterpret_cast<const uint16_t*>(p);
+    case 1:
+      return *p;
+  }
+  // Sizes are checked when the schema is made, so this can't happen.
+  return 0;
+}
+
+}  // namespace
+
+void DynamicBPFTraceConnector::DrainAggregateMap(DataTable* data_table) {
+  const uint64_t time = CurrentTimeNS();
+
+  for (const auto& [key, value] : GetBPFMap(aggregate_map_)) {
+    // The maps of count() and sum() are per-CPU, and hold a value for each CPU.
+    int64_t total = 0;
+    for (size_t i = 0; i + sizeof(int64_t) <= value.size(); i += sizeof(int64_t)) {
+      total += *reinterpret_cast<const int64_t*>(value.data() + i);
+    }
+
+    int64_t& last_value = last_aggregate_values_[std::string(key.begin(), key.end())];
+    if (total == last_value) {
+      continue;
+    }
+    int64_t delta = total - last_value;
+    last_value = total;
+
+    DataTable::DynamicRecordBuilder r(data_table);
+    r.Append(0, types::Time64NSValue(time));
+    size_t offset = 0;
+    for (size_t i = 0; i < aggregate_key_types_.size(); ++i) {
+      const bpftrace::SizedType& key_type = aggregate_key_types_[i];
+      DCHECK_LE(offset + key_type.size, key.size());
+      const uint8_t* p = key.data() + offset;
+      if (key_type.type == bpftrace::Type::string) {
+        auto s = reinterpret_cast<const char*>(p);
+        r.Append(i + 1, types::StringValue(std::string(s, strnlen(s, key_type.size))));
+      } else {
+        r.Append(i + 1, types::Int64Value(ReadMapKeyInt(p, key_type.size)));
+      }
+      offset += key_type.size;
+    }
+    r.Append(aggregate_key_types_.size() + 1, types::Int64Value(delta));
   }
 }
 
@@ -22,6 +22,8 @@
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/stirling/bpf_tools/bpftrace_wrapper.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/logicalpb/logical.pb.h"
@@ -42,15 +44,46 @@ class DynamicBPFTraceConnector : public SourceConnector, public bpf_tools::BPFTr
   ~DynamicBPFTraceConnector() override = default;
 
  protected:
-  explicit DynamicBPFTraceConnector(std::string_view source_name,
-                                    std::unique_ptr<DynamicDataTableSchema> table_schema,
-                                    std::string_view script);
+  DynamicBPFTraceConnector(std::string_view source_name,
+                           std::unique_ptr<DynamicDataTableSchema> table_schema,
+                           std::string_view script, std::string_view aggregate_map);
   Status InitImpl() override;
   Status StopImpl() override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
  private:
+  struct FieldDecoder;
+  using DecodeFn = void (DynamicBPFTraceConnector::*)(const FieldDecoder&, uint8_t*,
+                                                      DataTable::DynamicRecordBuilder*);
+
+  // Copies one printf field into its column. The decode function is picked once from the field's
+  // type and size, so that HandleEvent doesn't check the types for every event.
+  struct FieldDecoder {
+    DecodeFn fn = nullptr;
+    size_t col = 0;
+    const bpftrace::Field* field = nullptr;
+  };
+
+  StatusOr<std::vector<FieldDecoder>> CompileFieldDecoders() const;
+
   void HandleEvent(uint8_t* data);
+  void DrainAggregateMap(DataTable* data_table);
+
+  template <typename TInt>
+  void DecodeInt(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  template <typename TInt>
+  void DecodeTime(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeString(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeInet(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeUsym(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeKsym(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeUsername(const FieldDecoder& decoder, uint8_t* data,
+                      DataTable::DynamicRecordBuilder* r);
+  void DecodeProbe(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  template <bool TUstack>
+  void DecodeStack(const FieldDecoder& decoder, uint8_t* data, DataTable::DynamicRecordBuilder* r);
+  void DecodeTimestamp(const FieldDecoder& decoder, uint8_t* data,
+                       DataTable::DynamicRecordBuilder* r);
 
   std::string name_;
   std::unique_ptr<DynamicDataTableSchema> table_schema_;
@@ -58,6 +91,13 @@ class DynamicBPFTraceConnector : public SourceConnector, public bpf_tools::BPFTr
 
   // The types according to the BPFTrace printf format.
   std::vector<bpftrace::Field> output_fields_;
+  std::vector<FieldDecoder> field_decoders_;
+
+  // The map drained into the table, when the program outputs through a map instead of printfs.
+  std::string aggregate_map_;
+  std::vector<bpftrace::SizedType> aggregate_key_types_;
+  // The values of the map at the previous drain, by key bytes, so that only increases are pushed.
+  absl::flat_hash_map<std::string, int64_t> last_aggregate_values_;
 
   // Used by HandleEvent so that when a callback is triggered, HandleEvent knows the context.
   DataTable* data_table_ = nullptr;
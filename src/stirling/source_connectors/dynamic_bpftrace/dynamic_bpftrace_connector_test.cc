@@ -423,5 +423,77 @@ TEST(DynamicBPFTraceConnectorTest, BPFTraceCheckPrintfsError) {
                HasSubstr("All printf statements must have exactly the same format string")));
 }
 
+TEST(DynamicBPFTraceConnectorTest, AggregateMap) {
+  // Create a BPFTrace program spec
+  TracepointDeployment_Tracepoint tracepoint;
+  tracepoint.set_table_name("pid_count_table");
+
+  constexpr char kScript[] = R"(interval:ms:100 {
+    @counts[pid, comm] = count();
+  })";
+
+  tracepoint.mutable_bpftrace()->set_program(kScript);
+  tracepoint.mutable_bpftrace()->set_aggregate_map("@counts");
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<SourceConnector> connector,
+                       DynamicBPFTraceConnector::Create("test", tracepoint));
+
+  const int kTableNum = 0;
+  const DataTableSchema& table_schema = connector->table_schemas()[kTableNum];
+
+  // Check the inferred table schema.
+  {
+    const ArrayView<DataElement>& elements = table_schema.elements();
+
+    ASSERT_EQ(elements.size(), 4);
+
+    EXPECT_EQ(elements[0].name(), "time_");
+    EXPECT_EQ(elements[0].type(), types::DataType::TIME64NS);
+
+    EXPECT_EQ(elements[1].name(), "key_0");
+    EXPECT_EQ(elements[1].type(), types::DataType::INT64);
+
+    EXPECT_EQ(elements[2].name(), "key_1");
+    EXPECT_EQ(elements[2].type(), types::DataType::STRING);
+
+    EXPECT_EQ(elements[3].name(), "value");
+    EXPECT_EQ(elements[3].type(), types::DataType::INT64);
+  }
+
+  ASSERT_OK(connector->Init());
+
+  // Give some time to collect data.
+  sleep(1);
+
+  StandaloneContext ctx;
+  DataTable data_table(/*id*/ 0, table_schema);
+  connector->TransferData(&ctx, {&data_table});
+  std::vector<TaggedRecordBatch> tablets = data_table.ConsumeRecords();
+
+  ASSERT_FALSE(tablets.empty());
+  types::ColumnWrapperRecordBatch& records = tablets[0].records;
+  ASSERT_GT(records[3]->Size(), 0UL);
+  EXPECT_GT(records[3]->Get<types::Int64Value>(0).val, 0);
+  EXPECT_THAT(std::string(records[2]->Get<types::StringValue>(0)),
+              MatchesRegex(kPrintableRegex));
+
+  ASSERT_OK(connector->Stop());
+}
+
+TEST(DynamicBPFTraceConnectorTest, AggregateMapNotFound) {
+  TracepointDeployment_Tracepoint tracepoint;
+  tracepoint.set_table_name("pid_count_table");
+
+  constexpr char kScript[] = R"(interval:ms:100 {
+    @counts[pid] = count();
+  })";
+
+  tracepoint.mutable_bpftrace()->set_program(kScript);
+  tracepoint.mutable_bpftrace()->set_aggregate_map("@bogus");
+
+  ASSERT_THAT(DynamicBPFTraceConnector::Create("test", tracepoint).status(),
+              StatusIs(statuspb::NOT_FOUND, HasSubstr("no map named @bogus")));
+}
+
 }  // namespace stirling
 }  // namespace px
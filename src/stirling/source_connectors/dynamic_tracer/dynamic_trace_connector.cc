@@ -24,6 +24,10 @@
 #include <rapidjson/writer.h>
 
 #include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
@@ -65,7 +69,10 @@ void GenericHandleEventLoss(void* cb_cookie, uint64_t lost) {
 
 }  // namespace
 
-BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>& repeated_fields) {
+namespace {
+
+void AppendFieldElements(const google::protobuf::RepeatedPtrField<Field>& repeated_fields,
+                         BackedDataElements* elements) {
   using dynamic_tracing::ir::shared::ScalarType;
 
   // clang-format off
@@ -103,11 +110,9 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
   };
   // clang-format on
 
-  BackedDataElements elements(repeated_fields.size());
-
   // Insert the special upid column.
   // TODO(yzhao): Make sure to have a structured way to let the IR to express the upid.
-  elements.emplace_back("upid", "", types::DataType::UINT128);
+  elements->emplace_back("upid", "", types::DataType::UINT128);
 
   for (int i = 0; i < repeated_fields.size(); ++i) {
     const auto& field = repeated_fields[i];
@@ -139,7 +144,38 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
     }
 
     // TODO(oazizi): See if we need to find a way to define SemanticTypes and PatternTypes.
-    elements.emplace_back(field.name(), "", data_type, semantic_type);
+    elements->emplace_back(field.name(), "", data_type, semantic_type);
+  }
+}
+
+}  // namespace
+
+BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>& repeated_fields) {
+  BackedDataElements elements(repeated_fields.size());
+  AppendFieldElements(repeated_fields, &elements);
+  return elements;
+}
+
+BackedDataElements ConvertAggregateFields(
+    const google::protobuf::RepeatedPtrField<Field>& repeated_fields,
+    std::string_view value_field) {
+  // The key columns, followed by the time of the export and the aggregates.
+  BackedDataElements elements(repeated_fields.size() + 4);
+  AppendFieldElements(repeated_fields, &elements);
+
+  elements.emplace_back("time_", "", types::DataType::TIME64NS);
+  elements.emplace_back("count", "Number of probe hits since the previous row",
+                        types::DataType::INT64);
+  if (!value_field.empty()) {
+    types::SemanticType semantic_type = types::SemanticType::ST_NONE;
+    if (value_field == "latency") {
+      semantic_type = types::SemanticType::ST_DURATION_NS;
+    }
+    elements.emplace_back(absl::StrCat(value_field, "_sum"), "", types::DataType::INT64,
+                          semantic_type);
+    elements.emplace_back(absl::StrCat(value_field, "_hist"),
+                          "log2 histogram, as JSON from bucket lower bounds to counts",
+                          types::DataType::STRING);
   }
 
   return elements;
@@ -162,26 +198,39 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
   // so punting on that for now.
   std::string desc = absl::StrCat("Dynamic table for ", output.name);
 
-  std::unique_ptr<DynamicDataTableSchema> table_schema =
-      DynamicDataTableSchema::Create(output.name, desc, ConvertFields(output.output.fields()));
+  std::unique_ptr<DynamicDataTableSchema> table_schema = DynamicDataTableSchema::Create(
+      output.name, desc,
+      output.aggregate
+          ? ConvertAggregateFields(output.output.fields(), output.aggregate_value_field)
+          : ConvertFields(output.output.fields()));
 
   return std::unique_ptr<SourceConnector>(
       new DynamicTraceConnector(name, std::move(table_schema), std::move(bcc_program)));
 }
 
 Status DynamicTraceConnector::InitImpl() {
-  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  const auto& output = bcc_program_.perf_buffer_specs.front();
+
+  // Each sample of an aggregated output exports a row per key, so sample less often.
+  sampling_freq_mgr_.set_period(output.aggregate ? kAggregateSamplingPeriod : kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
 
+  PL_ASSIGN_OR_RETURN(record_decoder_, StructRecordDecoder::Create(output.output));
+
   PL_RETURN_IF_ERROR(InitBPFProgram(bcc_program_.code));
 
   for (const auto& uprobe_spec : bcc_program_.uprobe_specs) {
     PL_RETURN_IF_ERROR(AttachUProbe(uprobe_spec));
   }
 
+  if (output.aggregate) {
+    // Aggregates are read directly from their BPF hash map in TransferDataImpl().
+    return Status::OK();
+  }
+
   // TODO(yzhao/oazizi): Might need to change this if we need to support multiple perf buffers.
   bpf_tools::PerfBufferSpec spec = {
-      .name = bcc_program_.perf_buffer_specs.front().name,
+      .name = output.name,
       .probe_output_fn = &GenericHandleEvent,
       .probe_loss_fn = &GenericHandleEventLoss,
   };
@@ -360,131 +409,258 @@ class StructDecoder {
   std::string_view buf_;
 };
 
-Status FillColumn(StructDecoder* struct_decoder, DataTable::DynamicRecordBuilder* r, size_t col_idx,
-                  ScalarType type, const RepeatedPtrField<StructSpec>& col_decoder) {
-#define WRITE_COLUMN(field_type, column_type)                                        \
-  {                                                                                  \
-    PL_ASSIGN_OR_RETURN(field_type val, struct_decoder->ExtractField<field_type>()); \
-    r->Append(col_idx, column_type(val));                                            \
-    break;                                                                           \
-  }
+using DecodeParams = StructRecordDecoder::DecodeParams;
+using FieldOp = StructRecordDecoder::FieldOp;
+
+template <typename TNativeType, typename TColumnType>
+void DecodeScalar(const FieldOp& op, const DecodeParams& /*params*/, const char* record,
+                  DataTable::DynamicRecordBuilder* r) {
+  r->Append(op.col_idx, TColumnType(MemCpy<TNativeType>(record + op.offset)));
+}
+
+void DecodeTime(const FieldOp& op, const DecodeParams& params, const char* record,
+                DataTable::DynamicRecordBuilder* r) {
+  int64_t time = MemCpy<uint64_t>(record + op.offset) + params.clock_real_time_offset;
+  r->Append(op.col_idx, types::Time64NSValue(time));
+}
+
+void DecodeUPID(const FieldOp& op, const DecodeParams& params, const char* record,
+                DataTable::DynamicRecordBuilder* r) {
+  auto tgid = MemCpy<uint32_t>(record + op.offset);
+  auto tgid_start_time = MemCpy<uint64_t>(record + op.offset + sizeof(uint32_t));
+  md::UPID upid(params.asid, tgid, tgid_start_time);
+  r->Append(op.col_idx, types::UInt128Value(upid.value()));
+}
+
+// The fixed-size fields below can't run out of bytes, since the record size is checked up-front.
+void DecodeString(const FieldOp& op, const DecodeParams& /*params*/, const char* record,
+                  DataTable::DynamicRecordBuilder* r) {
+  StructDecoder struct_decoder(std::string_view(record + op.offset, op.size));
+  r->Append(op.col_idx, types::StringValue(struct_decoder.ExtractString().ValueOrDie()));
+}
+
+void DecodeByteArray(const FieldOp& op, const DecodeParams& /*params*/, const char* record,
+                     DataTable::DynamicRecordBuilder* r) {
+  StructDecoder struct_decoder(std::string_view(record + op.offset, op.size));
+  r->Append(op.col_idx, types::StringValue(struct_decoder.ExtractByteArrayAsHex().ValueOrDie()));
+}
+
+void DecodeStructBlob(const FieldOp& op, const DecodeParams& /*params*/, const char* record,
+                      DataTable::DynamicRecordBuilder* r) {
+  StructDecoder struct_decoder(std::string_view(record + op.offset, op.size));
+  std::string val = struct_decoder.ExtractStructBlobAsJSON(*op.blob_decoders).ValueOrDie();
+  r->Append(op.col_idx, types::StringValue(std::move(val)));
+}
+
+// Returns the size and decode function of a field of the given type.
+StatusOr<std::pair<size_t, FieldOp::DecodeFn>> FieldDecodeFn(ScalarType type) {
+#define SCALAR_FN(field_type, column_type) \
+  std::make_pair(sizeof(field_type), &DecodeScalar<field_type, column_type>)
 
   // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
   // in Struct::Field.
   switch (type) {
     case ScalarType::BOOL:
-      WRITE_COLUMN(bool, types::BoolValue);
+      return SCALAR_FN(bool, types::BoolValue);
     case ScalarType::INT:
-      WRITE_COLUMN(int, types::Int64Value);
+      return SCALAR_FN(int, types::Int64Value);
     case ScalarType::INT8:
-      WRITE_COLUMN(int8_t, types::Int64Value);
+      return SCALAR_FN(int8_t, types::Int64Value);
     case ScalarType::INT16:
-      WRITE_COLUMN(int16_t, types::Int64Value);
+      return SCALAR_FN(int16_t, types::Int64Value);
     case ScalarType::INT32:
-      WRITE_COLUMN(int32_t, types::Int64Value);
+      return SCALAR_FN(int32_t, types::Int64Value);
     case ScalarType::INT64:
-      WRITE_COLUMN(int64_t, types::Int64Value);
+      return SCALAR_FN(int64_t, types::Int64Value);
     case ScalarType::UINT:
-      WRITE_COLUMN(unsigned int, types::Int64Value);
+      return SCALAR_FN(unsigned int, types::Int64Value);
     case ScalarType::UINT8:
-      WRITE_COLUMN(uint8_t, types::Int64Value);
+      return SCALAR_FN(uint8_t, types::Int64Value);
     case ScalarType::UINT16:
-      WRITE_COLUMN(uint16_t, types::Int64Value);
+      return SCALAR_FN(uint16_t, types::Int64Value);
     case ScalarType::UINT32:
-      WRITE_COLUMN(uint32_t, types::Int64Value);
+      return SCALAR_FN(uint32_t, types::Int64Value);
     case ScalarType::UINT64:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
+      return SCALAR_FN(uint64_t, types::Int64Value);
 
     case ScalarType::SHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(short, types::Int64Value);
+      return SCALAR_FN(short, types::Int64Value);
     case ScalarType::USHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned short, types::Int64Value);
+      return SCALAR_FN(unsigned short, types::Int64Value);
     case ScalarType::LONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long, types::Int64Value);
+      return SCALAR_FN(long, types::Int64Value);
     case ScalarType::ULONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long, types::Int64Value);
+      return SCALAR_FN(unsigned long, types::Int64Value);
     case ScalarType::LONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long long, types::Int64Value);
+      return SCALAR_FN(long long, types::Int64Value);
     case ScalarType::ULONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long long, types::Int64Value);
+      return SCALAR_FN(unsigned long long, types::Int64Value);
     case ScalarType::CHAR:
-      WRITE_COLUMN(char, types::Int64Value);
+      return SCALAR_FN(char, types::Int64Value);
     case ScalarType::UCHAR:
-      WRITE_COLUMN(unsigned char, types::Int64Value);
+      return SCALAR_FN(unsigned char, types::Int64Value);
 
     case ScalarType::FLOAT:
-      WRITE_COLUMN(float, types::Float64Value);
+      return SCALAR_FN(float, types::Float64Value);
     case ScalarType::DOUBLE:
-      WRITE_COLUMN(double, types::Float64Value);
+      return SCALAR_FN(double, types::Float64Value);
     case ScalarType::VOID_POINTER:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
-    case ScalarType::STRING: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractString());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::BYTE_ARRAY: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractByteArrayAsHex());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::STRUCT_BLOB: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractStructBlobAsJSON(col_decoder));
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
+      return SCALAR_FN(uint64_t, types::Int64Value);
+    case ScalarType::STRING:
+      return std::make_pair(dynamic_tracing::kStructStringSize, &DecodeString);
+    case ScalarType::BYTE_ARRAY:
+      return std::make_pair(dynamic_tracing::kStructByteArraySize, &DecodeByteArray);
+    case ScalarType::STRUCT_BLOB:
+      return std::make_pair(dynamic_tracing::kStructBlobSize, &DecodeStructBlob);
     case ScalarType::UNKNOWN:
       return error::Internal("Unknown scalar type should not be used.");
     case ScalarType::ScalarType_INT_MIN_SENTINEL_DO_NOT_USE_:
     case ScalarType::ScalarType_INT_MAX_SENTINEL_DO_NOT_USE_:
-      LOG(DFATAL) << "Impossible enum value";
       break;
   }
-#undef WRITE_COLUMN
+#undef SCALAR_FN
 
-  return Status::OK();
+  return error::Internal("Impossible enum value");
 }
 
 }  // namespace
 
-Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std::string_view buf,
-                                           DataTable* data_table) {
-  StructDecoder struct_decoder(buf);
-  DataTable::DynamicRecordBuilder r(data_table);
+StatusOr<std::unique_ptr<StructRecordDecoder>> StructRecordDecoder::Create(const Struct& st) {
+  auto decoder = std::make_unique<StructRecordDecoder>();
 
-  int col_idx = 0;
+  size_t offset = 0;
+  size_t col_idx = 0;
   for (int i = 0; i < st.fields_size(); ++i) {
-    auto& field = st.fields(i);
+    const auto& field = st.fields(i);
+
+    FieldOp op = {};
+    op.offset = offset;
+    op.col_idx = col_idx++;
 
     if (field.name() == "time_") {
-      PL_ASSIGN_OR_RETURN(uint64_t ktime_ns, struct_decoder.ExtractField<uint64_t>());
-      int64_t time = ktime_ns + ClockRealTimeOffset();
-      r.Append(col_idx++, types::Time64NSValue(time));
+      op.decode = &DecodeTime;
+      op.size = sizeof(uint64_t);
     } else if ((field.name() == "tgid_") && (i + 1 < st.fields_size()) &&
                (st.fields(i + 1).name() == "tgid_start_time_")) {
       // If we see "tgid_" and "tgid_start_time_" back-to-back, then we automatically create UPID.
-      PL_ASSIGN_OR_RETURN(uint32_t tgid, struct_decoder.ExtractField<uint32_t>());
-      PL_ASSIGN_OR_RETURN(uint64_t tgid_start_time, struct_decoder.ExtractField<uint64_t>());
-      md::UPID upid(asid, tgid, tgid_start_time);
-      r.Append(col_idx++, types::UInt128Value(upid.value()));
+      op.decode = &DecodeUPID;
+      op.size = sizeof(uint32_t) + sizeof(uint64_t);
 
       // Consume the extra tgid_start_time_ column.
       ++i;
     } else {
-      PL_RETURN_IF_ERROR(
-          FillColumn(&struct_decoder, &r, col_idx++, field.type(), field.blob_decoders()));
+      PL_ASSIGN_OR_RETURN(std::tie(op.size, op.decode), FieldDecodeFn(field.type()));
+      op.blob_decoders = &field.blob_decoders();
     }
+
+    offset += op.size;
+    decoder->ops_.push_back(op);
+  }
+  decoder->record_size_ = offset;
+
+  return decoder;
+}
+
+Status StructRecordDecoder::Decode(const DecodeParams& params, std::string_view buf,
+                                   DataTable* data_table) const {
+  DataTable::DynamicRecordBuilder r(data_table);
+  return Decode(params, buf, &r);
+}
+
+Status StructRecordDecoder::Decode(const DecodeParams& params, std::string_view buf,
+                                   DataTable::DynamicRecordBuilder* r) const {
+  if (buf.size() < record_size_) {
+    return error::ResourceUnavailable("Insufficient number of bytes.");
+  }
+
+  for (const auto& op : ops_) {
+    op.decode(op, params, buf.data(), r);
   }
 
   return Status::OK();
 }
 
+namespace {
+
+// Exposes the untyped accessors of a BPF table, for maps whose key type is only known at run-time.
+class RawBPFTable : public ebpf::BPFTable {
+ public:
+  explicit RawBPFTable(const ebpf::BPFTable& table) : ebpf::BPFTable(table) {}
+
+  size_t key_size() const { return desc.key_size; }
+  size_t leaf_size() const { return desc.leaf_size; }
+
+  using ebpf::BPFTable::first;
+  using ebpf::BPFTable::lookup;
+  using ebpf::BPFTable::next;
+  using ebpf::BPFTable::remove;
+};
+
+}  // namespace
+
+void DynamicTraceConnector::TransferAggregates(const StructRecordDecoder::DecodeParams& params,
+                                               DataTable* data_table) {
+  const auto& output = bcc_program_.perf_buffer_specs.front();
+  RawBPFTable table(GetTable(output.name));
+
+  if (table.leaf_size() != sizeof(dynamic_tracing::AggregateValue) ||
+      table.key_size() != record_decoder_->record_size()) {
+    LOG(DFATAL) << absl::Substitute("Unexpected layout of aggregate map $0", output.name);
+    return;
+  }
+
+  // Collect the keys first, since removing entries while iterating restarts the iteration.
+  std::vector<std::string> keys;
+  std::string key(table.key_size(), '\0');
+  for (bool found = table.first(key.data()); found; found = table.next(key.data(), key.data())) {
+    keys.push_back(key);
+  }
+
+  const uint64_t time = CurrentTimeNS();
+  const size_t value_col_idx = record_decoder_->num_columns();
+  for (auto& k : keys) {
+    dynamic_tracing::AggregateValue value;
+    // Take the value and reset its key together, so the next row only counts new probe hits.
+    // Updates landing between the two are lost.
+    if (!table.lookup(k.data(), &value) || !table.remove(k.data())) {
+      continue;
+    }
+
+    DataTable::DynamicRecordBuilder r(data_table);
+    ECHECK_OK(record_decoder_->Decode(params, k, &r));
+    r.Append(value_col_idx, types::Time64NSValue(time));
+    r.Append(value_col_idx + 1, types::Int64Value(value.count));
+    if (!output.aggregate_value_field.empty()) {
+      r.Append(value_col_idx + 2, types::Int64Value(value.sum));
+      r.Append(value_col_idx + 3, types::StringValue(utils::Log2HistogramToJSON(value.hist)));
+    }
+  }
+
+  // Probe hits that found the map full were not counted in any row.
+  auto drops_table = GetPerCPUArrayTable<uint64_t>(dynamic_tracing::kAggDropsArrayName);
+  std::vector<uint64_t> drops;
+  if (!drops_table.get_value(0, drops).ok()) {
+    return;
+  }
+  uint64_t total_drops = 0;
+  for (uint64_t d : drops) {
+    total_drops += d;
+  }
+  if (total_drops == 0) {
+    return;
+  }
+  ECHECK(drops_table.update_value(0, std::vector<uint64_t>(drops.size(), 0)).ok());
+  aggregate_probe_->RecordEventLoss(total_drops);
+  VLOG(1) << absl::Substitute("Aggregate map $0 was full, dropped $1 probe hits", output.name,
+                              total_drops);
+}
+
 void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1)
@@ -495,13 +671,17 @@ void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     return;
   }
 
+  const StructRecordDecoder::DecodeParams params = {ctx->GetASID(), ClockRealTimeOffset()};
+
+  if (bcc_program_.perf_buffer_specs.front().aggregate) {
+    TransferAggregates(params, data_table);
+    return;
+  }
+
   PollPerfBuffers();
 
   for (const auto& item : data_items_) {
-    // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
-    // in Struct::Field.
-    ECHECK_OK(AppendRecord(bcc_program_.perf_buffer_specs.front().output, ctx->GetASID(), item,
-                           data_table));
+    ECHECK_OK(record_decoder_->Decode(params, item, data_table));
   }
 
   data_items_.clear();
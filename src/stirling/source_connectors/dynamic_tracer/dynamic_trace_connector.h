@@ -28,16 +28,84 @@
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
+#include "src/stirling/utils/perf_stats.h"
 
 namespace px {
 namespace stirling {
 
+/**
+ * Decodes the records of a perf buffer, which are packed structs described by a Struct.
+ * The Struct is compiled once into a flat list of per-field decode steps, with the field offsets,
+ * decode functions and output columns resolved up-front, including the fusion of tgid_ and
+ * tgid_start_time_ into the upid column. Decoding a record then only runs those steps.
+ */
+class StructRecordDecoder {
+ public:
+  /**
+   * Compiles a decoder for records described by st. The decoder refers to st, which must outlive
+   * it.
+   */
+  static StatusOr<std::unique_ptr<StructRecordDecoder>> Create(
+      const ::px::stirling::dynamic_tracing::ir::physical::Struct& st);
+
+  // Values needed for decoding that are not part of the record.
+  struct DecodeParams {
+    uint32_t asid;
+    // Converts BPF timestamps to real time.
+    uint64_t clock_real_time_offset;
+  };
+
+  // A decode step, produced by Create(). Only public to simplify the implementation.
+  struct FieldOp {
+    using DecodeFn = void (*)(const FieldOp& op, const DecodeParams& params, const char* record,
+                              DataTable::DynamicRecordBuilder* r);
+
+    DecodeFn decode;
+    // Location of the field in the record.
+    size_t offset;
+    size_t size;
+    // The output column.
+    size_t col_idx;
+    // Only used for STRUCT_BLOB fields.
+    const google::protobuf::RepeatedPtrField<
+        ::px::stirling::dynamic_tracing::ir::physical::StructSpec>* blob_decoders;
+  };
+
+  /**
+   * Decodes one record, and appends it to data_table.
+   */
+  Status Decode(const DecodeParams& params, std::string_view buf, DataTable* data_table) const;
+
+  /**
+   * Decodes one record into the first num_columns() columns of r.
+   */
+  Status Decode(const DecodeParams& params, std::string_view buf,
+                DataTable::DynamicRecordBuilder* r) const;
+
+  /**
+   * The number of columns produced by decoding a record.
+   */
+  size_t num_columns() const { return ops_.size(); }
+
+  /**
+   * The size of the records described by the Struct, in bytes.
+   */
+  size_t record_size() const { return record_size_; }
+
+ private:
+  std::vector<FieldOp> ops_;
+  size_t record_size_ = 0;
+};
+
 class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{100};
+  static constexpr auto kAggregateSamplingPeriod = std::chrono::milliseconds{1000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
 
-  ~DynamicTraceConnector() override = default;
+  ~DynamicTraceConnector() override {
+    utils::PerfStats::GetInstance().ReleaseProbe(aggregate_probe_);
+  }
 
   static StatusOr<std::unique_ptr<SourceConnector>> Create(
       std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program);
@@ -53,17 +121,20 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
                         dynamic_tracing::BCCProgram bcc_program)
       : SourceConnector(name, ArrayView<DataTableSchema>(&table_schema->Get(), 1)),
         table_schema_(std::move(table_schema)),
-        bcc_program_(std::move(bcc_program)) {}
+        bcc_program_(std::move(bcc_program)),
+        aggregate_probe_(
+            utils::PerfStats::GetInstance().GetProbe(absl::StrCat(name, ".aggregate"))) {}
 
   Status InitImpl() override;
 
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  double OutputBufferFill() override { return TakePerfBufferFill(); }
 
   Status StopImpl() override { return Status::OK(); }
 
  private:
-  Status AppendRecord(const ::px::stirling::dynamic_tracing::ir::physical::Struct& st,
-                      uint32_t asid, std::string_view buf, DataTable* data_table);
+  // Exports and resets the entries of an aggregated output's BPF hash map.
+  void TransferAggregates(const StructRecordDecoder::DecodeParams& params, DataTable* data_table);
 
   // Describes the output table column types.
   std::unique_ptr<DynamicDataTableSchema> table_schema_;
@@ -71,8 +142,14 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   // The actual dynamic trace program.
   dynamic_tracing::BCCProgram bcc_program_;
 
+  // Decodes the items of the perf buffer, compiled from its output Struct in InitImpl().
+  std::unique_ptr<StructRecordDecoder> record_decoder_;
+
   // A buffer to hold raw data items from the perf buffer.
   std::deque<std::string> data_items_;
+
+  // Records the probe hits dropped because the aggregate map was full.
+  utils::PerfProbe* aggregate_probe_;
 };
 
 // Converts proto specification of columns into the form that is used by TableSchema.
@@ -81,5 +158,12 @@ BackedDataElements ConvertFields(
     const google::protobuf::RepeatedPtrField<dynamic_tracing::ir::physical::Field>&
         repeated_fields);
 
+// Like ConvertFields(), for the key fields of an aggregated output, followed by the columns of the
+// aggregates of value_field. Only public for testing purposes.
+BackedDataElements ConvertAggregateFields(
+    const google::protobuf::RepeatedPtrField<dynamic_tracing::ir::physical::Field>&
+        repeated_fields,
+    std::string_view value_field);
+
 }  // namespace stirling
 }  // namespace px
@@ -17,7 +17,9 @@
  */
 
 #include <unistd.h>
+#include <cstring>
 #include <regex>
+#include <string>
 
 #include <gmock/gmock.h>
 
@@ -79,5 +81,116 @@ TEST(DynamicTraceConnectorTest, ConvertFields) {
   EXPECT_EQ(elements.elements()[2].type(), types::TIME64NS);
 }
 
+TEST(DynamicTraceConnectorTest, ConvertAggregateFields) {
+  constexpr std::string_view kOutputStruct = R"(
+      name: "out_table_value_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "method"
+        type: STRING
+      }
+  )";
+
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(std::string(kOutputStruct), &output_struct));
+
+  BackedDataElements elements = ConvertAggregateFields(output_struct.fields(), "latency");
+
+  ASSERT_EQ(elements.elements().size(), 6);
+  EXPECT_EQ(elements.elements()[0].name(), "upid");
+  EXPECT_EQ(elements.elements()[1].name(), "method");
+  EXPECT_EQ(elements.elements()[2].name(), "time_");
+  EXPECT_EQ(elements.elements()[3].name(), "count");
+  EXPECT_EQ(elements.elements()[4].name(), "latency_sum");
+  EXPECT_EQ(elements.elements()[5].name(), "latency_hist");
+
+  EXPECT_EQ(elements.elements()[2].type(), types::TIME64NS);
+  EXPECT_EQ(elements.elements()[4].stype(), types::SemanticType::ST_DURATION_NS);
+  EXPECT_EQ(elements.elements()[5].type(), types::STRING);
+
+  // Without a value field, only counts are kept.
+  EXPECT_EQ(ConvertAggregateFields(output_struct.fields(), "").elements().size(), 4);
+}
+
+TEST(StructRecordDecoderTest, Decode) {
+  constexpr std::string_view kOutputStruct = R"(
+      name: "out_table_value_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "time_"
+        type: UINT64
+      }
+      fields {
+        name: "arg0"
+        type: INT16
+      }
+      fields {
+        name: "arg1"
+        type: STRING
+      }
+      fields {
+        name: "arg2"
+        type: DOUBLE
+      }
+  )";
+
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(std::string(kOutputStruct), &output_struct));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<StructRecordDecoder> decoder,
+                       StructRecordDecoder::Create(output_struct));
+  EXPECT_EQ(decoder->record_size(), 4 + 8 + 8 + 2 + dynamic_tracing::kStructStringSize + 8);
+
+  // Pack a record, as the BPF program would.
+  std::string buf;
+  auto append = [&buf](auto val) { buf.append(reinterpret_cast<const char*>(&val), sizeof(val)); };
+  append(int32_t{123});
+  append(uint64_t{456});
+  append(uint64_t{1000});
+  append(int16_t{-7});
+  std::string str(dynamic_tracing::kStructStringSize, '\0');
+  const uint64_t str_len = 5;
+  std::memcpy(str.data(), &str_len, sizeof(str_len));
+  std::memcpy(str.data() + sizeof(str_len), "hello", str_len);
+  buf.append(str);
+  append(double{1.5});
+
+  std::unique_ptr<DynamicDataTableSchema> table_schema =
+      DynamicDataTableSchema::Create("out_table", "", ConvertFields(output_struct.fields()));
+  DataTable data_table(/*id*/ 0, table_schema->Get());
+
+  const StructRecordDecoder::DecodeParams params = {/*asid*/ 1, /*clock_real_time_offset*/ 10};
+  ASSERT_OK(decoder->Decode(params, buf, &data_table));
+  // A truncated record is rejected as a whole.
+  EXPECT_NOT_OK(decoder->Decode(params, std::string_view(buf).substr(1), &data_table));
+
+  std::vector<TaggedRecordBatch> tablets = data_table.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  const types::ColumnWrapperRecordBatch& records = tablets[0].records;
+  ASSERT_EQ(records.size(), 5);
+  ASSERT_EQ(records[0]->Size(), 1);
+  EXPECT_EQ(md::UPID(records[0]->Get<types::UInt128Value>(0).val), md::UPID(1, 123, 456));
+  EXPECT_EQ(records[1]->Get<types::Time64NSValue>(0).val, 1010);
+  EXPECT_EQ(records[2]->Get<types::Int64Value>(0).val, -7);
+  EXPECT_EQ(records[3]->Get<types::StringValue>(0), "hello");
+  EXPECT_EQ(records[4]->Get<types::Float64Value>(0).val, 1.5);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -80,6 +80,10 @@ const std::string kStructByteArray = absl::StrCat("struct blob", kStructByteArra
 // NOLINTNEXTLINE: runtime/string
 const std::string kStructBlob = absl::StrCat("struct struct_blob", kStructBlobSize);
 
+// The value type of aggregated outputs, and a zero-filled instance to initialize new keys.
+constexpr char kAggValueStruct[] = "struct agg_value_t";
+constexpr char kAggValueZeroArray[] = "agg_value_zero";
+
 // clang-format off
 const absl::flat_hash_map<ScalarType, std::string_view> kScalarTypeToCType = {
     {ScalarType::VOID_POINTER, "void*"},
@@ -182,6 +186,9 @@ class BCCCodeGenerator {
 
   // Map from Struct names to their definition.
   absl::flat_hash_map<std::string_view, const ir::physical::Struct*> structs_;
+
+  // Map from PerfBufferOutput names to their definition.
+  absl::flat_hash_map<std::string_view, const PerfBufferOutput*> outputs_;
 };
 
 // Returns the C type name of the input ScalarType.
@@ -551,13 +558,18 @@ std::string GenMapDeleteAction(const MapDeleteAction& action) {
 }
 
 std::string GenPerfBufferOutput(const PerfBufferOutput& output) {
+  if (output.aggregate()) {
+    return absl::Substitute("BPF_HASH($0, struct $1, $2);", output.name(), output.struct_type(),
+                            kAggValueStruct);
+  }
   return absl::Substitute("BPF_PERF_OUTPUT($0);", output.name());
 }
 
 namespace {
 
 StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
-    const ir::physical::Struct& output_struct, const PerfBufferOutputAction& action) {
+    const PerfBufferOutput& output, const ir::physical::Struct& output_struct,
+    const PerfBufferOutputAction& action) {
   std::string output_var_name = absl::StrCat(action.perf_buffer_name(), "_value");
 
   std::vector<std::string> code_lines;
@@ -576,8 +588,47 @@ StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
                                           output_struct.fields(struct_field_index++).name(), f));
   }
 
-  code_lines.push_back(absl::Substitute("$0.perf_submit(ctx, $1, sizeof(*$1));",
+  if (!output.aggregate()) {
+    code_lines.push_back(absl::Substitute("$0.perf_submit(ctx, $1, sizeof(*$1));",
+                                          action.perf_buffer_name(), output_var_name));
+    return code_lines;
+  }
+
+  // The output struct is the key of the aggregate. A missing key is inserted as zeros copied from
+  // a BPF map, as the aggregate is too large for the BPF stack.
+  std::string agg_var_name = absl::StrCat(action.perf_buffer_name(), "_agg");
+  std::string zero_var_name = absl::StrCat(action.perf_buffer_name(), "_agg_zero");
+  code_lines.push_back(absl::Substitute("$0* $1 = $2.lookup($3);", kAggValueStruct, agg_var_name,
+                                        action.perf_buffer_name(), output_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 == NULL) {", agg_var_name));
+  code_lines.push_back(absl::Substitute("$0* $1 = $2.lookup(&$3);", kAggValueStruct,
+                                        zero_var_name, kAggValueZeroArray, arr_idx_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 == NULL) { return 0; }", zero_var_name));
+  code_lines.push_back(absl::Substitute("$0.insert($1, $2);", action.perf_buffer_name(),
+                                        output_var_name, zero_var_name));
+  code_lines.push_back(absl::Substitute("$0 = $1.lookup($2);", agg_var_name,
                                         action.perf_buffer_name(), output_var_name));
+  // The insert fails when the map is full; count the drop for user space to report.
+  std::string drops_var_name = absl::StrCat(action.perf_buffer_name(), "_agg_drops");
+  code_lines.push_back(absl::Substitute("if ($0 == NULL) {", agg_var_name));
+  code_lines.push_back(absl::Substitute("uint64_t* $0 = $1.lookup(&$2);", drops_var_name,
+                                        kAggDropsArrayName, arr_idx_var_name));
+  code_lines.push_back(absl::Substitute("if ($0 != NULL) { (*$0)++; }", drops_var_name));
+  code_lines.push_back("return 0;");
+  code_lines.push_back("}");
+  code_lines.push_back("}");
+
+  // Other CPUs may update the same key concurrently.
+  code_lines.push_back(absl::Substitute("__sync_fetch_and_add(&$0->count, 1);", agg_var_name));
+  if (!action.aggregate_value_variable_name().empty()) {
+    std::string value_var_name = absl::StrCat(action.perf_buffer_name(), "_agg_value");
+    code_lines.push_back(absl::Substitute("uint64_t $0 = (uint64_t)$1;", value_var_name,
+                                          action.aggregate_value_variable_name()));
+    code_lines.push_back(
+        absl::Substitute("__sync_fetch_and_add(&$0->sum, $1);", agg_var_name, value_var_name));
+    code_lines.push_back(absl::Substitute("__sync_fetch_and_add(&$0->hist[pl_log2_bucket($1)], 1);",
+                                          agg_var_name, value_var_name));
+  }
 
   return code_lines;
 }
@@ -829,7 +880,17 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateProbe(const Probe&
     if (iter == structs_.end()) {
       return error::InvalidArgument("Output struct '$0' is undefined", action.output_struct_name());
     }
-    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action), &code_lines);
+    auto output_iter = outputs_.find(action.perf_buffer_name());
+    if (output_iter == outputs_.end()) {
+      return error::InvalidArgument("Output '$0' is undefined", action.perf_buffer_name());
+    }
+    if (!action.aggregate_value_variable_name().empty()) {
+      PL_RETURN_IF_ERROR(CheckVarExists(
+          vars, action.aggregate_value_variable_name(),
+          absl::Substitute("Output '$0' aggregate value", action.perf_buffer_name())));
+    }
+    MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*output_iter->second, *iter->second, action),
+                      &code_lines);
   }
 
   for (const auto& printk : probe.printks()) {
@@ -962,6 +1023,31 @@ std::vector<std::string> GenTypes() {
   return code_lines;
 }
 
+// Returns the value type of aggregated outputs, and the helpers to update it.
+std::vector<std::string> GenAggregateTypes() {
+  return {
+      absl::Substitute("$0 {", kAggValueStruct),
+      "  uint64_t count;",
+      "  uint64_t sum;",
+      absl::Substitute("  uint64_t hist[$0];", kAggHistBuckets),
+      "};",
+      absl::Substitute("BPF_PERCPU_ARRAY($0, $1, 1);", kAggValueZeroArray, kAggValueStruct),
+      absl::Substitute("BPF_PERCPU_ARRAY($0, uint64_t, 1);", kAggDropsArrayName),
+      // Returns floor(log2(x)) + 1, with 0 for 0, clamped to the last bucket.
+      // Loops are not available to the BPF verifier of older kernels, so this binary searches.
+      "static __inline uint32_t pl_log2_bucket(uint64_t x) {",
+      "uint32_t r = (x > 0xFFFFFFFF) << 5; x >>= r;",
+      "uint32_t shift = (x > 0xFFFF) << 4; x >>= shift; r |= shift;",
+      "shift = (x > 0xFF) << 3; x >>= shift; r |= shift;",
+      "shift = (x > 0xF) << 2; x >>= shift; r |= shift;",
+      "shift = (x > 0x3) << 1; x >>= shift; r |= shift;",
+      "r |= (x >> 1);",
+      "r += (x != 0);",
+      absl::Substitute("return r < $0 ? r : $1;", kAggHistBuckets, kAggHistBuckets - 1),
+      "}",
+  };
+}
+
 StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
   std::vector<std::string> code_lines;
 
@@ -998,8 +1084,15 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
     MoveBackStrVec(GenGOID(), &code_lines);
   }
 
+  const bool has_aggregate = std::any_of(program_.outputs().begin(), program_.outputs().end(),
+                                         [](const auto& output) { return output.aggregate(); });
+  if (has_aggregate) {
+    MoveBackStrVec(GenAggregateTypes(), &code_lines);
+  }
+
   for (const auto& output : program_.outputs()) {
     code_lines.push_back(GenPerfBufferOutput(output));
+    outputs_[output.name()] = &output;
   }
 
   for (const auto& probe : program_.probes()) {
@@ -39,8 +39,12 @@ using ::px::stirling::dynamic_tracing::ir::physical::Struct;
 using ::px::stirling::dynamic_tracing::ir::physical::StructVariable;
 using ::px::stirling::dynamic_tracing::ir::shared::BPFHelper;
 using ::px::stirling::dynamic_tracing::ir::shared::ScalarType;
+using ::testing::Contains;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+using ::testing::IsSupersetOf;
+using ::testing::Not;
 using ::testing::StrEq;
 
 TEST(GenStructTest, Output) {
@@ -477,6 +481,86 @@ TEST(GenProgramTest, SpecsAndCode) {
   EXPECT_THAT(bcc_code_lines, ElementsAreArray(expected_code_lines));
 }
 
+TEST(GenProgramTest, AggregateOutput) {
+  const std::string program_protobuf = R"proto(
+                                       deployment_spec {
+                                         path: "target_binary_path"
+                                       }
+                                       structs {
+                                         name: "latency_key_t"
+                                         fields {
+                                           name: "tgid_"
+                                           type: INT32
+                                         }
+                                       }
+                                       arrays {
+                                         name: "latency_data_buffer_array"
+                                         type { struct_type: "latency_key_t" }
+                                         capacity: 1
+                                       }
+                                       outputs {
+                                          name: "latency"
+                                          struct_type: "latency_key_t"
+                                          aggregate: true
+                                          aggregate_value_field: "latency_ns"
+                                       }
+                                       probes {
+                                         name: "probe_return"
+                                         tracepoint {
+                                           symbol: "target_symbol"
+                                           type: RETURN
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "tgid_"
+                                             type: INT32
+                                             builtin: TGID
+                                           }
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "latency_ns"
+                                             type: UINT64
+                                             reg: RC
+                                           }
+                                         }
+                                         output_actions {
+                                           perf_buffer_name: "latency"
+                                           data_buffer_array_name: "latency_data_buffer_array"
+                                           output_struct_name: "latency_key_t"
+                                           variable_names: "tgid_"
+                                           aggregate_value_variable_name: "latency_ns"
+                                         }
+                                       }
+                                       )proto";
+
+  ir::physical::Program program;
+
+  ASSERT_TRUE(TextFormat::ParseFromString(program_protobuf, &program));
+  program.mutable_deployment_spec()->set_path(px::testing::BazelBinTestFilePath(kBinaryPath));
+
+  ASSERT_OK_AND_ASSIGN(const std::string bcc_code, GenBCCProgram(program));
+
+  std::vector<std::string> bcc_code_lines = absl::StrSplit(bcc_code, "\n");
+  const std::vector<std::string> expected_code_lines = {
+      "struct agg_value_t {",
+      "  uint64_t hist[32];",
+      "BPF_PERCPU_ARRAY(agg_value_zero, struct agg_value_t, 1);",
+      "BPF_PERCPU_ARRAY(agg_drops, uint64_t, 1);",
+      "BPF_HASH(latency, struct latency_key_t, struct agg_value_t);",
+      "latency_value->tgid_ = tgid_;",
+      "struct agg_value_t* latency_agg = latency.lookup(latency_value);",
+      "latency.insert(latency_value, latency_agg_zero);",
+      "uint64_t* latency_agg_drops = agg_drops.lookup(&latency_value_idx);",
+      "if (latency_agg_drops != NULL) { (*latency_agg_drops)++; }",
+      "__sync_fetch_and_add(&latency_agg->count, 1);",
+      "uint64_t latency_agg_value = (uint64_t)latency_ns;",
+      "__sync_fetch_and_add(&latency_agg->sum, latency_agg_value);",
+  };
+  EXPECT_THAT(bcc_code_lines, IsSupersetOf(expected_code_lines));
+  EXPECT_THAT(bcc_code_lines, Not(Contains(HasSubstr("perf_submit"))));
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dwarvifier.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <memory>
@@ -139,6 +140,10 @@ class Dwarvifier {
                               const std::string& struct_type_name,
                               ir::physical::Program* output_program);
 
+  // Returns the implicit columns that prefix the struct of the given output.
+  const std::vector<std::string_view>& ImplicitColumns(
+      const ir::physical::PerfBufferOutput& output) const;
+
   std::map<std::string, ir::shared::Map*> maps_;
   std::map<std::string, ir::physical::PerfBufferOutput*> outputs_;
   std::map<std::string, ir::physical::Struct*> structs_;
@@ -431,6 +436,10 @@ void Dwarvifier::GenerateOutput(const ir::logical::Output& output,
   o->mutable_fields()->CopyFrom(output.fields());
   // Also insert the name of the struct that holds the output variables.
   o->set_struct_type(StructTypeName(output.name()));
+  if (output.has_aggregation()) {
+    o->set_aggregate(true);
+    o->set_aggregate_value_field(output.aggregation().value_field());
+  }
 
   // Record this output (for quick lookup by GenerateProbe).
   outputs_[o->name()] = o;
@@ -1212,26 +1221,42 @@ Status Dwarvifier::ProcessDeleteAction(const ir::logical::MapDeleteAction& delet
   return Status::OK();
 }
 
+namespace {
+
+bool IsIntegerType(ir::shared::ScalarType type) {
+  switch (type) {
+    case ir::shared::ScalarType::BOOL:
+    case ir::shared::ScalarType::SHORT:
+    case ir::shared::ScalarType::USHORT:
+    case ir::shared::ScalarType::INT:
+    case ir::shared::ScalarType::UINT:
+    case ir::shared::ScalarType::LONG:
+    case ir::shared::ScalarType::ULONG:
+    case ir::shared::ScalarType::LONGLONG:
+    case ir::shared::ScalarType::ULONGLONG:
+    case ir::shared::ScalarType::INT8:
+    case ir::shared::ScalarType::INT16:
+    case ir::shared::ScalarType::INT32:
+    case ir::shared::ScalarType::INT64:
+    case ir::shared::ScalarType::UINT8:
+    case ir::shared::ScalarType::UINT16:
+    case ir::shared::ScalarType::UINT32:
+    case ir::shared::ScalarType::UINT64:
+    case ir::shared::ScalarType::CHAR:
+    case ir::shared::ScalarType::UCHAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 Status Dwarvifier::GenerateOutputStruct(const ir::logical::OutputAction& output_action_in,
                                         const std::string& struct_type_name,
                                         ir::physical::Program* output_program) {
   // TODO(oazizi): Check if struct already exists. If it does, make sure it is the same.
 
-  auto* struct_decl = output_program->add_structs();
-  struct_decl->set_name(struct_type_name);
-
-  for (const auto& f : implicit_columns_) {
-    auto iter = variables_.find(f);
-    if (iter == variables_.end()) {
-      return error::Internal("GenerateOutputStruct [output=$0]: Reference to unknown variable $1",
-                             output_action_in.output_name(), f);
-    }
-
-    auto* struct_field = struct_decl->add_fields();
-    struct_field->CopyFrom(iter->second);
-    DCHECK_EQ(struct_field->name(), f);
-  }
-
   auto output_iter = outputs_.find(output_action_in.output_name());
 
   if (output_iter == outputs_.end()) {
@@ -1247,7 +1272,50 @@ Status Dwarvifier::GenerateOutputStruct(const ir::logical::OutputAction& output_
         output->fields_size());
   }
 
+  if (output->aggregate() && !output->aggregate_value_field().empty()) {
+    auto value_field_iter = std::find(output->fields().begin(), output->fields().end(),
+                                      output->aggregate_value_field());
+    if (value_field_iter == output->fields().end()) {
+      return error::InvalidArgument("Aggregation value field '$0' is not a field of Output '$1'",
+                                    output->aggregate_value_field(), output->name());
+    }
+
+    const std::string& value_var_name =
+        output_action_in.variable_names(value_field_iter - output->fields().begin());
+    auto iter = variables_.find(value_var_name);
+    if (iter == variables_.end()) {
+      return error::Internal("GenerateOutputStruct [output=$0]: Reference to unknown variable $1",
+                             output_action_in.output_name(), value_var_name);
+    }
+    // BPF has no floating point, so only integers can be summed and bucketed in the kernel.
+    if (!IsIntegerType(iter->second.type())) {
+      return error::InvalidArgument(
+          "Aggregation value field '$0' of Output '$1' must be an integer",
+          output->aggregate_value_field(), output->name());
+    }
+  }
+
+  auto* struct_decl = output_program->add_structs();
+  struct_decl->set_name(struct_type_name);
+
+  for (const auto& f : ImplicitColumns(*output)) {
+    auto iter = variables_.find(f);
+    if (iter == variables_.end()) {
+      return error::Internal("GenerateOutputStruct [output=$0]: Reference to unknown variable $1",
+                             output_action_in.output_name(), f);
+    }
+
+    auto* struct_field = struct_decl->add_fields();
+    struct_field->CopyFrom(iter->second);
+    DCHECK_EQ(struct_field->name(), f);
+  }
+
   for (int i = 0; i < output_action_in.variable_names_size(); ++i) {
+    // The aggregated value is accumulated by the aggregation, rather than being part of its key.
+    if (output->aggregate() && output->fields(i) == output->aggregate_value_field()) {
+      continue;
+    }
+
     const std::string& var_name = output_action_in.variable_names(i);
 
     auto iter = variables_.find(var_name);
@@ -1324,17 +1392,32 @@ Status Dwarvifier::ProcessOutputAction(const ir::logical::OutputAction& output_a
   output_action_out->set_data_buffer_array_name(data_buffer_array->name());
   output_action_out->set_output_struct_name(output_struct.name());
 
-  for (const auto& f : implicit_columns_) {
+  const ir::physical::PerfBufferOutput& output = *outputs_[output_action_in.output_name()];
+
+  for (const auto& f : ImplicitColumns(output)) {
     output_action_out->add_variable_names(std::string(f));
   }
 
-  for (const auto& f : output_action_in.variable_names()) {
-    output_action_out->add_variable_names(std::string(f));
+  for (int i = 0; i < output_action_in.variable_names_size(); ++i) {
+    const std::string& var_name = output_action_in.variable_names(i);
+    if (output.aggregate() && output.fields(i) == output.aggregate_value_field()) {
+      output_action_out->set_aggregate_value_variable_name(var_name);
+      continue;
+    }
+    output_action_out->add_variable_names(var_name);
   }
 
   return Status::OK();
 }
 
+const std::vector<std::string_view>& Dwarvifier::ImplicitColumns(
+    const ir::physical::PerfBufferOutput& output) const {
+  // Aggregates are only keyed by the process; the time is that of the export.
+  static const std::vector<std::string_view> kAggregateImplicitColumns = {kTGIDVarName,
+                                                                          kTGIDStartTimeVarName};
+  return output.aggregate() ? kAggregateImplicitColumns : implicit_columns_;
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -1461,6 +1461,158 @@ arrays {
 }
 )";
 
+constexpr std::string_view kAggregateProbeIn = R"(
+deployment_spec {
+  path: "$0"
+}
+tracepoints {
+  program {
+    language: GOLANG
+    outputs {
+      name: "agg_table"
+      fields: "arg1"
+      fields: "arg0"
+      aggregation {
+        value_field: "arg0"
+      }
+    }
+    probes: {
+      tracepoint: {
+        symbol: "main.MixedArgTypes"
+        type: ENTRY
+      }
+      args {
+        id: "arg0"
+        expr: "i1"
+      }
+      args {
+        id: "arg1"
+        expr: "b1"
+      }
+      output_actions {
+        output_name: "agg_table"
+        variable_names: "arg1"
+        variable_names: "arg0"
+      }
+    }
+  }
+}
+)";
+
+constexpr std::string_view kAggregateProbeOut = R"(
+deployment_spec {
+  path: "$0"
+}
+structs {
+  name: "agg_table_value_t"
+  fields {
+    name: "tgid_"
+    type: INT32
+  }
+  fields {
+    name: "tgid_start_time_"
+    type: UINT64
+  }
+  fields {
+    name: "arg1"
+    type: BOOL
+  }
+}
+outputs {
+  name: "agg_table"
+  fields: "arg1"
+  fields: "arg0"
+  struct_type: "agg_table_value_t"
+  aggregate: true
+  aggregate_value_field: "arg0"
+}
+probes {
+  tracepoint {
+    symbol: "main.MixedArgTypes"
+    type: ENTRY
+  }
+  vars {
+    scalar_var {
+      name: "sp_"
+      type: VOID_POINTER
+      reg: SP
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_"
+      type: INT32
+      builtin: TGID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_pid_"
+      type: UINT64
+      builtin: TGID_PID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_start_time_"
+      type: UINT64
+      builtin: TGID_START_TIME
+    }
+  }
+  vars {
+    scalar_var {
+      name: "time_"
+      type: UINT64
+      builtin: KTIME
+    }
+  }
+  vars {
+    scalar_var {
+      name: "goid_"
+      type: INT64
+      builtin: GOID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "arg0"
+      type: INT
+      memory {
+        base: "sp_"
+        offset: 8
+      }
+    }
+  }
+  vars {
+    scalar_var {
+      name: "arg1"
+      type: BOOL
+      memory {
+        base: "sp_"
+        offset: 16
+      }
+    }
+  }
+  output_actions {
+    perf_buffer_name: "agg_table"
+    data_buffer_array_name: "agg_table_data_buffer_array"
+    output_struct_name: "agg_table_value_t"
+    variable_names: "tgid_"
+    variable_names: "tgid_start_time_"
+    variable_names: "arg1"
+    aggregate_value_variable_name: "arg0"
+  }
+}
+language: GOLANG
+arrays {
+  name: "agg_table_data_buffer_array"
+  type {
+    struct_type: "agg_table_value_t"
+  }
+  capacity: 1
+}
+)";
+
 struct DwarfInfoTestParam {
   std::string_view input;
   std::string_view expected_output;
@@ -1514,7 +1666,8 @@ INSTANTIATE_TEST_SUITE_P(
                       DwarfInfoTestParam{kActionProbeIn, kActionProbeOut},
                       DwarfInfoTestParam{kStructProbeIn, kStructProbeOut},
                       DwarfInfoTestParam{kGolangErrorInterfaceProbeIn,
-                                         kGolangErrorInterfaceProbeOut}));
+                                         kGolangErrorInterfaceProbeOut},
+                      DwarfInfoTestParam{kAggregateProbeIn, kAggregateProbeOut}));
 
 }  // namespace dynamic_tracing
 }  // namespace stirling
@@ -91,6 +91,8 @@ StatusOr<BCCProgram::PerfBufferSpec> GetPerfBufferSpec(
 
   pf_spec.name = output.name();
   pf_spec.output = *iter->second;
+  pf_spec.aggregate = output.aggregate();
+  pf_spec.aggregate_value_field = output.aggregate_value_field();
 
   return pf_spec;
 }
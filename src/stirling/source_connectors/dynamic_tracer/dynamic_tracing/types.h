@@ -53,13 +53,34 @@ constexpr size_t kStructByteArraySize = 64;
 // generated types.
 constexpr size_t kStructBlobSize = 64;
 
+// Number of log2 buckets in the histogram of an aggregated output.
+// Bucket i counts values in [2^(i-1), 2^i), with bucket 0 counting zeros;
+// values beyond the last bucket are counted in the last one.
+constexpr size_t kAggHistBuckets = 32;
+
+// The value of an aggregated output's BPF hash map, must match the generated agg_value_t.
+struct AggregateValue {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t hist[kAggHistBuckets];
+};
+
+// A per-CPU BPF array counting the probe hits lost because an aggregate map was full.
+constexpr char kAggDropsArrayName[] = "agg_drops";
+
 struct BCCProgram {
   struct PerfBufferSpec {
     std::string name;
     ir::physical::Struct output;
 
+    // If true, the output is a BPF hash map from the output struct to an AggregateValue,
+    // instead of a perf buffer.
+    bool aggregate = false;
+    std::string aggregate_value_field;
+
     std::string ToString() const {
-      return absl::Substitute("[name=$0 Output struct=$1]", name, output.DebugString());
+      return absl::Substitute("[name=$0 aggregate=$1 Output struct=$2]", name, aggregate,
+                              output.DebugString());
     }
   };
 
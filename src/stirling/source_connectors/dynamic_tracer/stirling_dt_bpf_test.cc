@@ -215,6 +215,29 @@ TEST_F(DynamicTraceAPITest, DynamicTraceAPI) {
   // TODO(oazizi): Expand test when RegisterTracepoint produces other states.
 }
 
+TEST_F(DynamicTraceAPITest, QueuedOperationsRunInOrder) {
+  sole::uuid trace_id1 = sole::uuid4();
+  sole::uuid trace_id2 = sole::uuid4();
+
+  // The tracepoints are deployed one at a time, so the second one is still queued when it's
+  // removed, unless the first deployment is already done. Either way, it ends up removed.
+  stirling_->RegisterTracepoint(trace_id1, Prepare(kTracepointDeploymentTxtPB, kBinaryPath));
+  stirling_->RegisterTracepoint(trace_id2, Prepare(kTracepointDeploymentTxtPB, kBinaryPath));
+  ASSERT_OK(stirling_->RemoveTracepoint(trace_id2));
+
+  ASSERT_OK(WaitForStatus(trace_id1));
+  EXPECT_EQ(WaitForStatus(trace_id2).code(), px::statuspb::Code::NOT_FOUND);
+}
+
+TEST_F(DynamicTraceAPITest, RegisterAfterStop) {
+  stirling_->Stop();
+
+  // Once stopped, tracepoints are not deployed anymore.
+  sole::uuid trace_id = sole::uuid4();
+  stirling_->RegisterTracepoint(trace_id, Prepare(kTracepointDeploymentTxtPB, kBinaryPath));
+  EXPECT_EQ(stirling_->GetTracepointInfo(trace_id).code(), px::statuspb::Code::INTERNAL);
+}
+
 TEST_F(DynamicTraceAPITest, NonExistentBinary) {
   StatusOr<stirlingpb::Publish> s;
 
@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/jvm_stats/jvm_stats_connector.h"
 
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -43,7 +44,7 @@ Status JVMStatsConnector::InitImpl() {
 }
 
 void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
-  proc_tracker_.Update(ctx.GetUPIDs());
+  ctx.UpdateProcTracker(&proc_tracker_);
 
   for (const auto& upid : proc_tracker_.new_upids()) {
     // The host PID 1 is not a Java app. However, when later invoking HsperfdataPath(), it could be
@@ -57,21 +58,19 @@ void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   }
 }
 
-Status JVMStatsConnector::ExportStats(const md::UPID& upid,
-                                      const std::filesystem::path& hsperf_data_path,
-                                      DataTable* data_table) const {
-  PL_ASSIGN_OR_RETURN(std::string hsperf_data_str, ReadFileToString(hsperf_data_path));
-
-  if (hsperf_data_str.empty()) {
-    // Assume this is a transient failure.
-    return Status::OK();
+Status JVMStatsConnector::ExportStats(const md::UPID& upid, JavaProcInfo* java_proc,
+                                      DataTable* data_table) {
+  if (java_proc->stats_reader == nullptr) {
+    PL_ASSIGN_OR_RETURN(java_proc->stats_reader,
+                        java::StatsReader::Create(java_proc->hsperf_data_path));
   }
 
-  java::Stats stats(std::move(hsperf_data_str));
-  if (!stats.Parse().ok()) {
-    // Assumes this is a transient failure.
+  PL_ASSIGN_OR_RETURN(std::optional<java::Stats> stats_or_unchanged,
+                      java_proc->stats_reader->ReadIfChanged());
+  if (!stats_or_unchanged.has_value()) {
     return Status::OK();
   }
+  const java::Stats& stats = stats_or_unchanged.value();
 
   uint64_t time = CurrentTimeNS();
 
@@ -103,7 +102,7 @@ void JVMStatsConnector::TransferDataImpl(ConnectorContext* ctx,
     JavaProcInfo& java_proc = iter->second;
 
     md::UPID upid_with_asid(ctx->GetASID(), upid.pid(), upid.start_ts());
-    auto status = ExportStats(upid_with_asid, java_proc.hsperf_data_path, data_table);
+    auto status = ExportStats(upid_with_asid, &java_proc, data_table);
     if (!status.ok()) {
       ++java_proc.export_failure_count;
     }
@@ -37,6 +37,7 @@ using ::px::stirling::testing::ColWrapperSizeIs;
 using ::px::stirling::testing::FindRecordIdxMatchesPID;
 using ::px::testing::TestFilePath;
 using ::testing::Each;
+using ::testing::Le;
 using ::testing::SizeIs;
 
 struct JavaHelloWorld : SubProcess {
@@ -121,8 +122,9 @@ TEST_F(JVMStatsConnectorTest, CaptureData) {
   ASSERT_FALSE(tablets.empty());
   record_batch = tablets[0].records;
   EXPECT_THAT(FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world2.child_pid()), SizeIs(1));
-  // Make sure the previous processes were scanned as well.
-  EXPECT_THAT(FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world1.child_pid()), SizeIs(1));
+  // The previous process is still scanned, but its stats are only exported if they changed.
+  EXPECT_THAT(FindRecordIdxMatchesPID(record_batch, kUPIDIdx, hello_world1.child_pid()),
+              SizeIs(Le(1)));
 }
 
 }  // namespace stirling
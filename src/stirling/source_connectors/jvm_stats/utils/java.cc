@@ -18,8 +18,15 @@
 
 #include "src/stirling/source_connectors/jvm_stats/utils/java.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <absl/strings/match.h>
 
+#include <algorithm>
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
@@ -58,34 +65,47 @@ Status Stats::Parse() {
   return Status::OK();
 }
 
-uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix("gc.collector.0.time"); }
+namespace {
+
+constexpr std::string_view kYoungGCTimeSuffix = "gc.collector.0.time";
+constexpr std::string_view kFullGCTimeSuffix = "gc.collector.1.time";
+constexpr std::array<std::string_view, 4> kUsedHeapSizeSuffixes = {
+    "gc.generation.0.space.0.used",
+    "gc.generation.0.space.1.used",
+    "gc.generation.0.space.2.used",
+    "gc.generation.1.space.0.used",
+};
+constexpr std::array<std::string_view, 4> kTotalHeapSizeSuffixes = {
+    "gc.generation.0.space.0.capacity",
+    "gc.generation.0.space.1.capacity",
+    "gc.generation.0.space.2.capacity",
+    "gc.generation.1.space.0.capacity",
+};
+constexpr std::array<std::string_view, 2> kMaxHeapSizeSuffixes = {
+    "gc.generation.0.maxCapacity",
+    "gc.generation.1.maxCapacity",
+};
+
+// Returns true if the stat is used by any of the Stats accessors.
+bool IsExportedStat(std::string_view name) {
+  auto matches = [name](std::string_view suffix) { return absl::EndsWith(name, suffix); };
+  return matches(kYoungGCTimeSuffix) || matches(kFullGCTimeSuffix) ||
+         std::any_of(kUsedHeapSizeSuffixes.begin(), kUsedHeapSizeSuffixes.end(), matches) ||
+         std::any_of(kTotalHeapSizeSuffixes.begin(), kTotalHeapSizeSuffixes.end(), matches) ||
+         std::any_of(kMaxHeapSizeSuffixes.begin(), kMaxHeapSizeSuffixes.end(), matches);
+}
 
-uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix("gc.collector.1.time"); }
+}  // namespace
 
-uint64_t Stats::UsedHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.used",
-      "gc.generation.0.space.1.used",
-      "gc.generation.0.space.2.used",
-      "gc.generation.1.space.0.used",
-  });
-}
+uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix(kYoungGCTimeSuffix); }
 
-uint64_t Stats::TotalHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.capacity",
-      "gc.generation.0.space.1.capacity",
-      "gc.generation.0.space.2.capacity",
-      "gc.generation.1.space.0.capacity",
-  });
-}
+uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix(kFullGCTimeSuffix); }
 
-uint64_t Stats::MaxHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.maxCapacity",
-      "gc.generation.1.maxCapacity",
-  });
-}
+uint64_t Stats::UsedHeapSizeBytes() const { return SumStatsForSuffixes(kUsedHeapSizeSuffixes); }
+
+uint64_t Stats::TotalHeapSizeBytes() const { return SumStatsForSuffixes(kTotalHeapSizeSuffixes); }
+
+uint64_t Stats::MaxHeapSizeBytes() const { return SumStatsForSuffixes(kMaxHeapSizeSuffixes); }
 
 uint64_t Stats::StatForSuffix(std::string_view suffix) const {
   for (const auto& stat : stats_) {
@@ -96,7 +116,7 @@ uint64_t Stats::StatForSuffix(std::string_view suffix) const {
   return 0;
 }
 
-uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixes) const {
+uint64_t Stats::SumStatsForSuffixes(ArrayView<std::string_view> suffixes) const {
   uint64_t sum = 0;
   for (const auto& suffix : suffixes) {
     sum += StatForSuffix(suffix);
@@ -104,6 +124,79 @@ uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixe
   return sum;
 }
 
+StatusOr<std::unique_ptr<StatsReader>> StatsReader::Create(const std::filesystem::path& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return error::Internal("Failed to open $0, errno=$1", path.string(), errno);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return error::Internal("Failed to stat $0, or file is empty", path.string());
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+
+  // A shared mapping observes the JVM's updates to the counters; the fd is not needed past this.
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to mmap $0, errno=$1", path.string(), errno);
+  }
+
+  std::unique_ptr<StatsReader> reader(new StatsReader(static_cast<const char*>(data), size));
+  PL_RETURN_IF_ERROR(reader->ResolveStats());
+  return reader;
+}
+
+StatsReader::~StatsReader() { munmap(const_cast<char*>(data_), size_); }
+
+Status StatsReader::ResolveStats() {
+  hsperf::HsperfData hsperf_data = {};
+  PL_RETURN_IF_ERROR(ParseHsperfData(std::string_view(data_, size_), &hsperf_data));
+
+  locations_.clear();
+  for (const auto& entry : hsperf_data.data_entries) {
+    if (entry.header->data_type != static_cast<uint8_t>(hsperf::DataType::kLong) ||
+        entry.data.size() != sizeof(uint64_t) || !IsExportedStat(entry.name)) {
+      continue;
+    }
+    locations_.push_back({entry.name, static_cast<size_t>(entry.data.data() - data_)});
+  }
+  resolved_mod_timestamp_ = hsperf_data.prologue->mod_timestamp;
+  resolved_num_entries_ = hsperf_data.prologue->num_entries;
+  last_values_.clear();
+  return Status::OK();
+}
+
+StatusOr<std::optional<Stats>> StatsReader::ReadIfChanged() {
+  // The prologue's mod_timestamp only changes when the JVM adds entries, not when it updates
+  // their values, so it tells when the resolved offsets are stale.
+  const auto* prologue = reinterpret_cast<const hsperf::Prologue*>(data_);
+  if (prologue->mod_timestamp != resolved_mod_timestamp_ ||
+      prologue->num_entries != resolved_num_entries_) {
+    PL_RETURN_IF_ERROR(ResolveStats());
+  }
+
+  std::vector<uint64_t> values;
+  values.reserve(locations_.size());
+  for (const auto& location : locations_) {
+    values.push_back(
+        LEndianBytesToInt<uint64_t>(std::string_view(data_ + location.offset, sizeof(uint64_t))));
+  }
+  if (values == last_values_) {
+    return std::optional<Stats>();
+  }
+
+  std::vector<Stats::Stat> stats;
+  stats.reserve(locations_.size());
+  for (size_t i = 0; i < locations_.size(); ++i) {
+    stats.push_back({locations_[i].name, values[i]});
+  }
+  last_values_ = std::move(values);
+  return std::optional<Stats>(Stats(std::move(stats)));
+}
+
 StatusOr<std::filesystem::path> HsperfdataPath(pid_t pid) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const std::filesystem::path& host_path = sysconfig.host_path();
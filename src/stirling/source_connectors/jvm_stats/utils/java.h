@@ -19,11 +19,14 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "src/common/base/base.h"
 #include "src/common/base/statusor.h"
 
 namespace px {
@@ -58,12 +61,52 @@ class Stats {
 
  private:
   uint64_t StatForSuffix(std::string_view suffix) const;
-  uint64_t SumStatsForSuffixes(const std::vector<std::string_view>& suffixes) const;
+  uint64_t SumStatsForSuffixes(ArrayView<std::string_view> suffixes) const;
 
   std::string hsperf_data_;
   std::vector<Stat> stats_;
 };
 
+/**
+ * Reads the stats of a JVM from its hsperfdata file, which is kept mapped read-only.
+ * The data entries are parsed once, to find the offsets of the stats exported by Stats;
+ * after that, each read only loads those values. The entries are parsed again if the JVM adds
+ * new ones.
+ */
+class StatsReader : public NotCopyMoveable {
+ public:
+  static StatusOr<std::unique_ptr<StatsReader>> Create(const std::filesystem::path& path);
+
+  ~StatsReader();
+
+  /**
+   * Reads the current values of the exported stats.
+   * @return The stats, or nullopt if none of the values changed since the previous call.
+   */
+  StatusOr<std::optional<Stats>> ReadIfChanged();
+
+ private:
+  StatsReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  // Finds the offsets of the exported stats.
+  Status ResolveStats();
+
+  struct StatLocation {
+    std::string_view name;
+    size_t offset;
+  };
+
+  const char* data_;
+  size_t size_;
+
+  // Locations of the exported stats, and the prologue fields they were resolved against.
+  std::vector<StatLocation> locations_;
+  uint64_t resolved_mod_timestamp_ = 0;
+  uint32_t resolved_num_entries_ = 0;
+
+  std::vector<uint64_t> last_values_;
+};
+
 /**
  * Returns the path of the hsperfdata for a JVM process.
  */
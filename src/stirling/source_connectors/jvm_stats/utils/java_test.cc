@@ -21,7 +21,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -29,7 +33,9 @@
 
 #include "src/common/base/test_utils.h"
 #include "src/common/exec/subprocess.h"
+#include "src/common/testing/temp_dir.h"
 #include "src/common/testing/test_environment.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata.h"
 
 namespace px {
 namespace stirling {
@@ -59,6 +65,53 @@ TEST(StatsTest, CommonValues) {
   EXPECT_EQ(2, stats.MaxHeapSizeBytes());
 }
 
+// Tests that StatsReader reads the same stats as parsing the whole file, and only reports them
+// when they change.
+TEST(StatsReaderTest, ReadIfChanged) {
+  ASSERT_OK_AND_ASSIGN(const std::string content,
+                       ReadFileToString(testing::TestFilePath(
+                           "src/stirling/source_connectors/jvm_stats/utils/test_hsperfdata")));
+  Stats expected(content);
+  ASSERT_OK(expected.Parse());
+
+  testing::TempDir temp_dir;
+  const std::filesystem::path path = temp_dir.path() / "hsperfdata";
+  ASSERT_OK(WriteFileFromString(path.string(), content));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<StatsReader> reader, StatsReader::Create(path));
+
+  ASSERT_OK_AND_ASSIGN(std::optional<Stats> stats, reader->ReadIfChanged());
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->YoungGCTimeNanos(), expected.YoungGCTimeNanos());
+  EXPECT_EQ(stats->FullGCTimeNanos(), expected.FullGCTimeNanos());
+  EXPECT_EQ(stats->UsedHeapSizeBytes(), expected.UsedHeapSizeBytes());
+  EXPECT_EQ(stats->TotalHeapSizeBytes(), expected.TotalHeapSizeBytes());
+  EXPECT_EQ(stats->MaxHeapSizeBytes(), expected.MaxHeapSizeBytes());
+
+  ASSERT_OK_AND_ASSIGN(stats, reader->ReadIfChanged());
+  EXPECT_FALSE(stats.has_value());
+
+  // Update the young GC time in place, like the JVM does.
+  hsperf::HsperfData data;
+  ASSERT_OK(hsperf::ParseHsperfData(content, &data));
+  auto iter = std::find_if(data.data_entries.begin(), data.data_entries.end(),
+                           [](const hsperf::DataEntry& entry) {
+                             return absl::EndsWith(entry.name, "gc.collector.0.time");
+                           });
+  ASSERT_NE(iter, data.data_entries.end());
+  const uint64_t young_gc_time = expected.YoungGCTimeNanos() + 1;
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(iter->data.data() - content.data());
+    file.write(reinterpret_cast<const char*>(&young_gc_time), sizeof(young_gc_time));
+  }
+
+  ASSERT_OK_AND_ASSIGN(stats, reader->ReadIfChanged());
+  ASSERT_TRUE(stats.has_value());
+  EXPECT_EQ(stats->YoungGCTimeNanos(), young_gc_time);
+  EXPECT_EQ(stats->UsedHeapSizeBytes(), expected.UsedHeapSizeBytes());
+}
+
 TEST(HsperfdataPathTest, ResultIsAsExpected) {
   const char kClassPath[] = "src/stirling/source_connectors/jvm_stats/testing/HelloWorld.jar";
   const std::string class_path = testing::TestFilePath(kClassPath);
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/schema/utils.h"
+#include "src/stirling/core/info_class_manager.h"
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+#include "src/table_store/table_store.h"
+
+using px::stirling::DataPushCallback;
+using px::stirling::DataTable;
+using px::stirling::InfoClassManager;
+using px::stirling::LoadGenConnector;
+using px::stirling::SourceConnector;
+using px::stirling::StandaloneContext;
+
+namespace {
+
+// The size of http_events in the PEM.
+constexpr int64_t kTableBytes = 512 * 1024 * 1024;
+
+// Pushes records from the load generator into a table store, the way the PEM does, as fast as
+// they can be made. Arguments: the number of tablets, and the number of records per transfer
+// (and push).
+// NOLINTNEXTLINE : runtime/references.
+void BM_Ingest(benchmark::State& state) {
+  std::unique_ptr<SourceConnector> source = LoadGenConnector::Create("load_gen");
+  auto* connector = dynamic_cast<LoadGenConnector*>(source.get());
+  LoadGenConnector::Config config;
+  config.rows_per_sec = 0;
+  config.num_tablets = state.range(0);
+  config.max_rows_per_transfer = state.range(1);
+  connector->set_config(config);
+  PL_CHECK_OK(connector->Init());
+
+  InfoClassManager info_class_mgr(LoadGenConnector::kTable);
+  px::stirling::stirlingpb::Publish publish_pb;
+  *publish_pb.add_published_info_classes() = info_class_mgr.ToProto();
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  for (const auto& relation_info : px::ConvertPublishPBToRelationInfo(publish_pb)) {
+    table_store->AddTable(std::make_shared<px::table_store::Table>(relation_info.relation,
+                                                                   kTableBytes),
+                          relation_info.name, relation_info.id);
+  }
+  DataPushCallback push_callback =
+      std::bind(&px::table_store::TableStore::AppendData, table_store.get(),
+                std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+
+  StandaloneContext ctx;
+  const std::vector<DataTable*> data_tables = {info_class_mgr.data_table()};
+  for (auto _ : state) {
+    connector->TransferData(&ctx, data_tables);
+    connector->PushData(push_callback, data_tables);
+  }
+  state.SetItemsProcessed(connector->num_rows_generated());
+  PL_CHECK_OK(connector->Stop());
+}
+
+BENCHMARK(BM_Ingest)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgNames({"tablets", "rows"})
+    ->Args({1, 100 * 1000})
+    ->Args({64, 100 * 1000})
+    ->Args({64, 1000 * 1000})
+    ->Args({1024, 1000 * 1000});
+
+}  // namespace
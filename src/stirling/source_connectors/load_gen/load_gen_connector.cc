@@ -0,0 +1,215 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+
+DEFINE_int64(stirling_load_gen_rows_per_sec, 1000 * 1000,
+             "The rate of the records of the load_gen source. If 0, every transfer emits "
+             "--stirling_load_gen_max_rows_per_transfer records.");
+DEFINE_int64(stirling_load_gen_max_rows_per_transfer, 1000 * 1000,
+             "The maximum number of records that one transfer of the load_gen source emits.");
+DEFINE_int32(stirling_load_gen_num_tablets, 64,
+             "The number of tablets that the records of the load_gen source are spread over.");
+DEFINE_int32(stirling_load_gen_headers_bytes, 256,
+             "The size of the request and response headers of the load_gen source.");
+DEFINE_int32(stirling_load_gen_body_bytes, 512,
+             "The size of the request and response bodies of the load_gen source.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// The number of distinct values of each string column.
+constexpr int kNumPoolValues = 64;
+constexpr int kNumPaths = 128;
+constexpr int kNumRemoteAddrs = 256;
+
+// The processes that the records belong to when the context has none.
+constexpr int kNumSyntheticPIDs = 100;
+
+constexpr std::string_view kAlphabet =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+std::string RandomText(std::mt19937_64* rng, int length) {
+  std::string text(std::max(length, 0), ' ');
+  for (char& c : text) {
+    c = kAlphabet[(*rng)() % kAlphabet.size()];
+  }
+  return text;
+}
+
+// A JSON object of the given fields, padded with a filler field to about the given size.
+std::string PaddedJSON(std::mt19937_64* rng, std::string_view fields, int bytes) {
+  constexpr std::string_view kFillerField = ",\"x-filler\":\"\"}";
+  int filler_bytes = bytes - static_cast<int>(fields.size() + kFillerField.size() + 1);
+  return absl::StrCat("{", fields, ",\"x-filler\":\"", RandomText(rng, filler_bytes), "\"}");
+}
+
+}  // namespace
+
+LoadGenConnector::Config LoadGenConnector::Config::FromFlags() {
+  Config config;
+  config.rows_per_sec = FLAGS_stirling_load_gen_rows_per_sec;
+  config.max_rows_per_transfer = FLAGS_stirling_load_gen_max_rows_per_transfer;
+  config.num_tablets = FLAGS_stirling_load_gen_num_tablets;
+  config.headers_bytes = FLAGS_stirling_load_gen_headers_bytes;
+  config.body_bytes = FLAGS_stirling_load_gen_body_bytes;
+  return config;
+}
+
+void LoadGenConnector::set_config(const Config& config) {
+  config_ = config;
+  config_.num_tablets = std::max(config_.num_tablets, 1);
+
+  tablet_ids_.clear();
+  for (int i = 0; i < config_.num_tablets; ++i) {
+    tablet_ids_.push_back(std::to_string(kBaseRemotePort + i));
+  }
+  next_tablet_ = 0;
+  row_credit_ = 0;
+
+  pools_ = {};
+  for (int i = 0; i < kNumPoolValues; ++i) {
+    pools_.req_headers.push_back(PaddedJSON(
+        &rng_,
+        absl::Substitute("\"Accept\":\"application/json\",\"Host\":\"svc-$0.default.svc\","
+                         "\"User-Agent\":\"load_gen/1.0\",\"X-Request-Id\":\"$1\"",
+                         i % 8, RandomText(&rng_, 16)),
+        config_.headers_bytes));
+    pools_.resp_headers.push_back(PaddedJSON(
+        &rng_,
+        absl::Substitute("\"Content-Type\":\"application/json\",\"Date\":\"$0\","
+                         "\"Server\":\"envoy\"",
+                         RandomText(&rng_, 29)),
+        config_.headers_bytes));
+    pools_.req_bodies.push_back(
+        PaddedJSON(&rng_, absl::Substitute("\"id\":$0", i), config_.body_bytes));
+    pools_.resp_bodies.push_back(
+        PaddedJSON(&rng_, absl::Substitute("\"id\":$0,\"status\":\"ok\"", i), config_.body_bytes));
+  }
+  for (int i = 0; i < kNumPaths; ++i) {
+    pools_.req_paths.push_back(
+        absl::Substitute("/api/v1/$0/$1", RandomText(&rng_, 8), rng_() % 100000));
+  }
+  for (int i = 0; i < kNumRemoteAddrs; ++i) {
+    pools_.remote_addrs.push_back(absl::Substitute("10.0.$0.$1", i / 254, i % 254 + 1));
+  }
+}
+
+Status LoadGenConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+  last_transfer_time_ = std::chrono::steady_clock::now();
+  return Status::OK();
+}
+
+int64_t LoadGenConnector::RowsDue(std::chrono::nanoseconds elapsed) {
+  const int64_t max_rows = std::max<int64_t>(config_.max_rows_per_transfer, 0);
+  if (config_.rows_per_sec <= 0) {
+    return max_rows;
+  }
+  const double rows = static_cast<double>(elapsed.count()) * config_.rows_per_sec / 1e9;
+  row_credit_ = std::min(row_credit_ + rows, static_cast<double>(max_rows));
+  const auto num_rows = static_cast<int64_t>(row_credit_);
+  row_credit_ -= num_rows;
+  return num_rows;
+}
+
+void LoadGenConnector::TransferDataImpl(ConnectorContext* ctx,
+                                        const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), kTables.size());
+
+  const auto now = std::chrono::steady_clock::now();
+  const int64_t num_rows = RowsDue(now - last_transfer_time_);
+  last_transfer_time_ = now;
+
+  if (data_tables[kTableNum] != nullptr) {
+    GenerateRecords(ctx, num_rows, data_tables[kTableNum]);
+  }
+}
+
+void LoadGenConnector::GenerateRecords(ConnectorContext* ctx, int64_t num_rows,
+                                       DataTable* data_table) {
+  static const std::string kEmptyBody;
+
+  if (num_rows == 0) {
+    return;
+  }
+
+  std::vector<md::UPID> upids(ctx->GetUPIDs().begin(), ctx->GetUPIDs().end());
+  if (upids.empty()) {
+    for (int pid = 1; pid <= kNumSyntheticPIDs; ++pid) {
+      upids.emplace_back(ctx->GetASID(), pid, /* ts */ 0);
+    }
+  }
+
+  // Keep the times increasing across transfers, even when a transfer emits more records than
+  // there are nanoseconds since the previous one.
+  uint64_t time_ns = std::max<uint64_t>(CurrentTimeNS(), last_time_ns_ + 1);
+  for (int64_t i = 0; i < num_rows; ++i, ++time_ns) {
+    const int tablet = next_tablet_;
+    next_tablet_ = (next_tablet_ + 1) % config_.num_tablets;
+
+    const bool is_post = rng_() % 4 == 0;
+    const uint64_t status_draw = rng_() % 100;
+    const int64_t resp_status = status_draw < 97 ? 200 : (status_draw < 99 ? 404 : 500);
+    const std::string& req_body = is_post ? Pick(pools_.req_bodies) : kEmptyBody;
+    const std::string& resp_body = Pick(pools_.resp_bodies);
+
+    DataTable::RecordBuilder<&kTable> r(data_table, tablet_ids_[tablet], time_ns);
+    r.Append<r.ColIndex("time_")>(time_ns);
+    r.Append<r.ColIndex("upid")>(Pick(upids).value());
+    r.Append<r.ColIndex("remote_addr")>(Pick(pools_.remote_addrs));
+    r.Append<r.ColIndex("remote_port")>(kBaseRemotePort + tablet);
+    r.Append<r.ColIndex("trace_role")>(kRoleServer);
+    r.Append<r.ColIndex("major_version")>(1);
+    r.Append<r.ColIndex("minor_version")>(1);
+    r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(HTTPContentType::kJSON));
+    r.Append<r.ColIndex("req_headers"), kMaxStringBytes>(Pick(pools_.req_headers));
+    r.Append<r.ColIndex("req_method")>(is_post ? "POST" : "GET");
+    r.Append<r.ColIndex("req_path")>(Pick(pools_.req_paths));
+    r.Append<r.ColIndex("req_body_size")>(req_body.size());
+    r.Append<r.ColIndex("req_body_bytes_skipped")>(0);
+    r.Append<r.ColIndex("req_body"), kMaxStringBytes>(req_body);
+    r.Append<r.ColIndex("req_body_raw")>("");
+    r.Append<r.ColIndex("resp_headers"), kMaxStringBytes>(Pick(pools_.resp_headers));
+    r.Append<r.ColIndex("resp_status")>(resp_status);
+    r.Append<r.ColIndex("resp_message")>(resp_status == 200   ? "OK"
+                                         : resp_status == 404 ? "Not Found"
+                                                              : "Internal Server Error");
+    r.Append<r.ColIndex("resp_body_size")>(resp_body.size());
+    r.Append<r.ColIndex("resp_body_bytes_skipped")>(0);
+    r.Append<r.ColIndex("resp_body"), kMaxStringBytes>(resp_body);
+    r.Append<r.ColIndex("resp_body_raw")>("");
+    r.Append<r.ColIndex("latency")>(static_cast<int64_t>(latency_dist_(rng_)));
+#ifndef NDEBUG
+    r.Append<r.ColIndex("px_info_")>("");
+#endif
+  }
+  last_time_ns_ = time_ns - 1;
+  num_rows_generated_ += num_rows;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/socket_tracer/http_table.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Emits synthetic records shaped like http_events (with string headers and bodies) at a
+ * configurable rate, spread over many tablets. It exercises the whole ingest path
+ * (DataTable, push callback, TableStore::AppendData) under production-like shapes, to find the
+ * ingest ceiling of a PEM and to measure changes to the ingest pipeline.
+ *
+ * The records go to their own table, so that they never mix with traced traffic. The processes
+ * of the records are those of the context, or made up ones if it has none.
+ */
+class LoadGenConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "load_gen";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{10};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{100};
+
+  // Each tablet is a remote port, starting at this one.
+  static constexpr int64_t kBaseRemotePort = 10000;
+
+  static constexpr auto kTable =
+      DataTableSchema("load_gen_http_events", "Synthetic HTTP events from the load generator",
+                      kHTTPElements, "remote_port");
+  static constexpr auto kTables = MakeArray(kTable);
+  static constexpr uint32_t kTableNum = SourceConnector::TableNum(kTables, kTable);
+
+  struct Config {
+    // If 0, every transfer emits max_rows_per_transfer rows.
+    int64_t rows_per_sec = 1000 * 1000;
+    // Bounds the burst after a stall, and the rows emitted by an unthrottled transfer.
+    int64_t max_rows_per_transfer = 1000 * 1000;
+    int num_tablets = 64;
+    int headers_bytes = 256;
+    // The socket tracer keeps up to 512 bytes of each body.
+    int body_bytes = 512;
+
+    // The configuration set by the --stirling_load_gen_* flags.
+    static Config FromFlags();
+  };
+
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new LoadGenConnector(name, Config::FromFlags()));
+  }
+
+  void set_config(const Config& config);
+  const Config& config() const { return config_; }
+
+  /**
+   * Returns the number of rows that a transfer made elapsed after the previous one emits.
+   * Rows that the rate owes but that exceed max_rows_per_transfer are not made up for later.
+   */
+  int64_t RowsDue(std::chrono::nanoseconds elapsed);
+
+  // The total number of rows emitted.
+  int64_t num_rows_generated() const { return num_rows_generated_; }
+
+ protected:
+  LoadGenConnector(std::string_view name, const Config& config) : SourceConnector(name, kTables) {
+    set_config(config);
+  }
+  ~LoadGenConnector() override = default;
+
+  Status InitImpl() override;
+
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+
+  Status StopImpl() override { return Status::OK(); }
+
+ private:
+  // A fixed set of values for each string column, so that generating a record costs little more
+  // than copying its strings.
+  struct ValuePools {
+    std::vector<std::string> remote_addrs;
+    std::vector<std::string> req_headers;
+    std::vector<std::string> req_paths;
+    std::vector<std::string> req_bodies;
+    std::vector<std::string> resp_headers;
+    std::vector<std::string> resp_bodies;
+  };
+
+  // Strings are generated at their configured sizes, so they are only truncated past this.
+  static constexpr size_t kMaxStringBytes = 64 * 1024;
+
+  void GenerateRecords(ConnectorContext* ctx, int64_t num_rows, DataTable* data_table);
+
+  template <typename T>
+  const T& Pick(const std::vector<T>& values) {
+    return values[rng_() % values.size()];
+  }
+
+  Config config_;
+  ValuePools pools_;
+  std::vector<std::string> tablet_ids_;
+
+  std::mt19937_64 rng_{37};
+  std::exponential_distribution<double> latency_dist_{/* 1/mean_ns */ 1e-6};
+  std::chrono::steady_clock::time_point last_transfer_time_;
+  double row_credit_ = 0;
+  int next_tablet_ = 0;
+  uint64_t last_time_ns_ = 0;
+  int64_t num_rows_generated_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::UnorderedElementsAre;
+
+class LoadGenConnectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    source_ = LoadGenConnector::Create("load_gen");
+    connector_ = dynamic_cast<LoadGenConnector*>(source_.get());
+    ASSERT_NE(connector_, nullptr);
+  }
+
+  std::unique_ptr<SourceConnector> source_;
+  LoadGenConnector* connector_;
+};
+
+TEST_F(LoadGenConnectorTest, rows_due_follows_rate) {
+  LoadGenConnector::Config config;
+  config.rows_per_sec = 1000;
+  config.max_rows_per_transfer = 100;
+  connector_->set_config(config);
+
+  EXPECT_EQ(connector_->RowsDue(std::chrono::milliseconds(10)), 10);
+  // Fractions of a row carry over to the next transfer.
+  EXPECT_EQ(connector_->RowsDue(std::chrono::microseconds(1500)), 1);
+  EXPECT_EQ(connector_->RowsDue(std::chrono::microseconds(500)), 1);
+  // A stall does not cause a burst larger than one transfer.
+  EXPECT_EQ(connector_->RowsDue(std::chrono::seconds(10)), 100);
+  EXPECT_EQ(connector_->RowsDue(std::chrono::milliseconds(10)), 10);
+
+  config.rows_per_sec = 0;
+  connector_->set_config(config);
+  EXPECT_EQ(connector_->RowsDue(std::chrono::nanoseconds(0)), 100);
+}
+
+TEST_F(LoadGenConnectorTest, records_spread_over_tablets) {
+  LoadGenConnector::Config config;
+  config.rows_per_sec = 0;
+  config.max_rows_per_transfer = 40;
+  config.num_tablets = 4;
+  config.headers_bytes = 200;
+  config.body_bytes = 300;
+  connector_->set_config(config);
+  ASSERT_OK(connector_->Init());
+
+  DataTable data_table(/*id*/ 0, LoadGenConnector::kTable);
+  StandaloneContext ctx;
+  connector_->TransferData(&ctx, {&data_table});
+  EXPECT_EQ(connector_->num_rows_generated(), 40);
+
+  constexpr int kPortIdx = LoadGenConnector::kTable.ColIndex("remote_port");
+  constexpr int kReqHeadersIdx = LoadGenConnector::kTable.ColIndex("req_headers");
+  constexpr int kRespBodyIdx = LoadGenConnector::kTable.ColIndex("resp_body");
+  constexpr int kRespBodySizeIdx = LoadGenConnector::kTable.ColIndex("resp_body_size");
+
+  std::vector<std::string> tablet_ids;
+  for (const auto& tablet : data_table.ConsumeRecords()) {
+    tablet_ids.push_back(tablet.tablet_id);
+    ASSERT_EQ(tablet.records[kPortIdx]->Size(), 10);
+    for (size_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(std::to_string(tablet.records[kPortIdx]->Get<types::Int64Value>(i).val),
+                tablet.tablet_id);
+      EXPECT_EQ(tablet.records[kReqHeadersIdx]->Get<types::StringValue>(i).size(), 200);
+      EXPECT_EQ(tablet.records[kRespBodyIdx]->Get<types::StringValue>(i).size(), 300);
+      EXPECT_EQ(tablet.records[kRespBodySizeIdx]->Get<types::Int64Value>(i).val, 300);
+    }
+  }
+  EXPECT_THAT(tablet_ids, UnorderedElementsAre("10000", "10001", "10002", "10003"));
+
+  EXPECT_OK(connector_->Stop());
+}
+
+}  // namespace stirling
+}  // namespace px
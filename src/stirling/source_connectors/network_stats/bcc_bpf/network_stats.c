@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
+
+#include "src/stirling/source_connectors/network_stats/bcc_bpf_intf/network_stats.h"
+
+// The traffic of each cgroup, by cgroup ID, since user space last drained the map.
+// See kNetworkStatsTransferCountIdx for which map BPF writes to.
+BPF_HASH(cgroup_net_stats_a, uint64_t, struct cgroup_net_stats_t, kMaxCGroupNetStatsEntries);
+BPF_HASH(cgroup_net_stats_b, uint64_t, struct cgroup_net_stats_t, kMaxCGroupNetStatsEntries);
+
+BPF_ARRAY(network_stats_state, uint64_t, 1);
+
+// Returns the counters of the cgroup of the socket that the packet belongs to.
+static __inline struct cgroup_net_stats_t* get_cgroup_net_stats(struct __sk_buff* skb) {
+  uint32_t transfer_count_idx = kNetworkStatsTransferCountIdx;
+  uint64_t* transfer_count = network_stats_state.lookup(&transfer_count_idx);
+  if (transfer_count == NULL) {
+    return NULL;
+  }
+
+  uint64_t cgroup_id = bpf_skb_cgroup_id(skb);
+  struct cgroup_net_stats_t new_stats = {};
+  if (*transfer_count % 2 == 0) {
+    return cgroup_net_stats_a.lookup_or_init(&cgroup_id, &new_stats);
+  }
+  return cgroup_net_stats_b.lookup_or_init(&cgroup_id, &new_stats);
+}
+
+// The programs are attached to the root cgroup, so they see the packets of all the sockets on the
+// host. They only count, and always let the packet through.
+
+int probe_cgroup_skb_ingress(struct __sk_buff* skb) {
+  struct cgroup_net_stats_t* stats = get_cgroup_net_stats(skb);
+  if (stats != NULL) {
+    __sync_fetch_and_add(&stats->rx_bytes, skb->len);
+    __sync_fetch_and_add(&stats->rx_packets, 1);
+  }
+  return 1;
+}
+
+int probe_cgroup_skb_egress(struct __sk_buff* skb) {
+  struct cgroup_net_stats_t* stats = get_cgroup_net_stats(skb);
+  if (stats != NULL) {
+    __sync_fetch_and_add(&stats->tx_bytes, skb->len);
+    __sync_fetch_and_add(&stats->tx_packets, 1);
+  }
+  return 1;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+// The index of the transfer count in network_stats_state, which user space increments every time
+// it reads the counters. BPF adds to cgroup_net_stats_a while it is even and to cgroup_net_stats_b
+// while it is odd, so user space drains the map that BPF isn't writing to.
+static const uint32_t kNetworkStatsTransferCountIdx = 0;
+
+// The capacity of each of the counter maps: the cgroups with traffic in one sampling period.
+static const uint32_t kMaxCGroupNetStatsEntries = 16384;
+
+// The traffic of the sockets of a cgroup since user space last read the map.
+struct cgroup_net_stats_t {
+  uint64_t rx_bytes;
+  uint64_t rx_packets;
+  uint64_t tx_bytes;
+  uint64_t tx_packets;
+};
@@ -18,33 +18,114 @@
 
 #include "src/stirling/source_connectors/network_stats/network_stats_connector.h"
 
+#include <sys/stat.h>
+
 #include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <string>
 
 #include "src/common/base/base.h"
+#include "src/common/system/cgroup_stats.h"
 #include "src/common/system/proc_parser.h"
 #include "src/shared/metadata/metadata.h"
+#include "src/stirling/bpf_tools/bpf_map.h"
+#include "src/stirling/bpf_tools/macros.h"
+
+DEFINE_bool(stirling_network_stats_bpf, false,
+            "If true, count the network traffic of pods with BPF when the host has a cgroup v2 "
+            "hierarchy, instead of reading the stats of every pod from /proc. The errors and drops "
+            "columns are then 0.");
+
+BPF_SRC_STRVIEW(network_stats_bcc_script, network_stats);
 
 namespace px {
 namespace stirling {
 
 using system::ProcParser;
 
+namespace {
+
+// Returns the ID of the cgroup v2 of the process, which is the inode of its cgroup directory.
+StatusOr<uint64_t> CGroupIDForPID(const system::Config& sysconfig, uint32_t pid) {
+  PL_ASSIGN_OR_RETURN(std::filesystem::path cgroup_dir,
+                      system::CGroupV2PathForPID(sysconfig, pid));
+  struct stat st;
+  if (stat(cgroup_dir.c_str(), &st) != 0) {
+    return error::Internal("Unable to stat $0, errno: $1", cgroup_dir.string(), errno);
+  }
+  return st.st_ino;
+}
+
+void AppendNetworkStats(int64_t timestamp, std::string_view pod_id,
+                        const ProcParser::NetworkStats& stats, DataTable* data_table) {
+  DataTable::RecordBuilder<&kNetworkStatsTable> r(data_table, timestamp);
+
+  r.Append<r.ColIndex("time_")>(timestamp);
+  r.Append<r.ColIndex("pod_id")>(std::string(pod_id));
+  r.Append<r.ColIndex("rx_bytes")>(stats.rx_bytes);
+  r.Append<r.ColIndex("rx_packets")>(stats.rx_packets);
+  r.Append<r.ColIndex("rx_errors")>(stats.rx_errs);
+  r.Append<r.ColIndex("rx_drops")>(stats.rx_drops);
+  r.Append<r.ColIndex("tx_bytes")>(stats.tx_bytes);
+  r.Append<r.ColIndex("tx_packets")>(stats.tx_packets);
+  r.Append<r.ColIndex("tx_errors")>(stats.tx_errs);
+  r.Append<r.ColIndex("tx_drops")>(stats.tx_drops);
+}
+
+}  // namespace
+
 Status NetworkStatsConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+
+  if (FLAGS_stirling_network_stats_bpf) {
+    Status s = InitBPF();
+    if (s.ok()) {
+      use_bpf_ = true;
+    } else {
+      LOG(WARNING) << absl::Substitute(
+          "Unable to count network stats with BPF, falling back to /proc: $0", s.msg());
+      Close();
+    }
+  }
   return Status::OK();
 }
 
-Status NetworkStatsConnector::StopImpl() { return Status::OK(); }
+Status NetworkStatsConnector::InitBPF() {
+  PL_RETURN_IF_ERROR(InitBPFProgram(network_stats_bcc_script));
+
+  const std::filesystem::path root_cgroup = sysconfig_.sysfs_path() / "fs/cgroup";
+  const auto cgroup_skb_specs = MakeArray<bpf_tools::CGroupSKBSpec>({
+      {root_cgroup, bpf_tools::CGroupSKBAttachType::kIngress, "probe_cgroup_skb_ingress"},
+      {root_cgroup, bpf_tools::CGroupSKBAttachType::kEgress, "probe_cgroup_skb_egress"},
+  });
+  PL_RETURN_IF_ERROR(AttachCGroupSKBs(cgroup_skb_specs));
+
+  cgroup_net_stats_a_ = std::make_unique<ebpf::BPFHashTable<uint64_t, cgroup_net_stats_t>>(
+      GetHashTable<uint64_t, cgroup_net_stats_t>("cgroup_net_stats_a"));
+  cgroup_net_stats_b_ = std::make_unique<ebpf::BPFHashTable<uint64_t, cgroup_net_stats_t>>(
+      GetHashTable<uint64_t, cgroup_net_stats_t>("cgroup_net_stats_b"));
+  network_stats_state_ = std::make_unique<ebpf::BPFArrayTable<uint64_t>>(
+      GetArrayTable<uint64_t>("network_stats_state"));
+  return Status::OK();
+}
+
+Status NetworkStatsConnector::StopImpl() {
+  Close();
+  return Status::OK();
+}
 
 void NetworkStatsConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1) << "NetworkStatsConnector only has one data table.";
 
-  if (data_tables[kNetStatsTableNum] != nullptr) {
+  if (data_tables[kNetStatsTableNum] == nullptr) {
+    return;
+  }
+  if (use_bpf_) {
+    TransferNetworkStatsTableBPF(ctx, data_tables[kNetStatsTableNum]);
+  } else {
     TransferNetworkStatsTable(ctx, data_tables[kNetStatsTableNum]);
   }
 }
@@ -72,18 +153,94 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
       continue;
     }
 
-    DataTable::RecordBuilder<&kNetworkStatsTable> r(data_table, timestamp);
-
-    r.Append<r.ColIndex("time_")>(timestamp);
-    r.Append<r.ColIndex("pod_id")>(std::string(pod_id));
-    r.Append<r.ColIndex("rx_bytes")>(stats.rx_bytes);
-    r.Append<r.ColIndex("rx_packets")>(stats.rx_packets);
-    r.Append<r.ColIndex("rx_errors")>(stats.rx_errs);
-    r.Append<r.ColIndex("rx_drops")>(stats.rx_drops);
-    r.Append<r.ColIndex("tx_bytes")>(stats.tx_bytes);
-    r.Append<r.ColIndex("tx_packets")>(stats.tx_packets);
-    r.Append<r.ColIndex("tx_errors")>(stats.tx_errs);
-    r.Append<r.ColIndex("tx_drops")>(stats.tx_drops);
+    AppendNetworkStats(timestamp, pod_id, stats, data_table);
+  }
+}
+
+void NetworkStatsConnector::UpdateCGroupPods(const md::K8sMetadataState& k8s_md) {
+  for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
+    PL_UNUSED(pod_name);
+
+    auto* pod_info = k8s_md.PodInfoByID(pod_id);
+    if (pod_info == nullptr || pod_info->stop_time_ns() > 0) {
+      continue;
+    }
+
+    for (const auto& container_id : pod_info->containers()) {
+      if (resolved_container_ids_.contains(container_id)) {
+        continue;
+      }
+      auto* container_info = k8s_md.ContainerInfoByID(container_id);
+      if (container_info == nullptr || container_info->stop_time_ns() > 0) {
+        continue;
+      }
+      // All the processes of a container are in its cgroup, so one read is enough.
+      for (const auto& upid : container_info->active_upids()) {
+        StatusOr<uint64_t> cgroup_id = CGroupIDForPID(sysconfig_, upid.pid());
+        if (!cgroup_id.ok()) {
+          VLOG(1) << absl::Substitute("Failed to get the cgroup of upid=$0: $1", upid.String(),
+                                      cgroup_id.msg());
+          continue;
+        }
+        cgroup_pods_[cgroup_id.ValueOrDie()] = std::string(pod_id);
+        resolved_container_ids_.insert(container_id);
+        break;
+      }
+    }
+  }
+
+  // Forget the pods and containers that stopped.
+  auto is_stopped = [](const auto* info) { return info == nullptr || info->stop_time_ns() > 0; };
+  for (auto it = cgroup_pods_.begin(); it != cgroup_pods_.end();) {
+    if (is_stopped(k8s_md.PodInfoByID(it->second))) {
+      pod_stats_.erase(it->second);
+      cgroup_pods_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = resolved_container_ids_.begin(); it != resolved_container_ids_.end();) {
+    if (is_stopped(k8s_md.ContainerInfoByID(*it))) {
+      resolved_container_ids_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void NetworkStatsConnector::TransferNetworkStatsTableBPF(ConnectorContext* ctx,
+                                                         DataTable* data_table) {
+  // Map the containers before draining, so their traffic in this period isn't dropped.
+  UpdateCGroupPods(ctx->GetK8SMetadata());
+
+  // Switch BPF to the other map before draining this one, so the drain doesn't race with BPF.
+  auto& cgroup_net_stats = transfer_count_ % 2 == 0 ? cgroup_net_stats_a_ : cgroup_net_stats_b_;
+  ++transfer_count_;
+  const ebpf::StatusTuple s =
+      network_stats_state_->update_value(kNetworkStatsTransferCountIdx, transfer_count_);
+  LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
+
+  absl::flat_hash_set<std::string> changed_pod_ids;
+  for (const auto& [cgroup_id, delta] :
+       bpf_tools::ReadHashTable(cgroup_net_stats.get(), /*clear_table*/ true)) {
+    auto it = cgroup_pods_.find(cgroup_id);
+    if (it == cgroup_pods_.end()) {
+      // Traffic of a process that isn't in a pod.
+      continue;
+    }
+    ProcParser::NetworkStats& stats = pod_stats_[it->second];
+    stats.rx_bytes += delta.rx_bytes;
+    stats.rx_packets += delta.rx_packets;
+    stats.tx_bytes += delta.tx_bytes;
+    stats.tx_packets += delta.tx_packets;
+    changed_pod_ids.insert(it->second);
+  }
+
+  // Only the pods with new traffic are reported. The errors and drops columns stay 0, since the
+  // cgroup programs don't see the failures of the network devices.
+  int64_t timestamp = CurrentTimeNS();
+  for (const std::string& pod_id : changed_pod_ids) {
+    AppendNetworkStats(timestamp, pod_id, pod_stats_[pod_id], data_table);
   }
 }
 
@@ -24,17 +24,29 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/canonical_types.h"
 #include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/network_stats/bcc_bpf_intf/network_stats.h"
 #include "src/stirling/source_connectors/network_stats/network_stats_table.h"
 
 namespace px {
 namespace stirling {
 
-class NetworkStatsConnector : public SourceConnector {
+/**
+ * Collects the network traffic of each pod.
+ *
+ * When the host has a unified (v2) cgroup hierarchy, BPF counts the traffic of each cgroup in the
+ * kernel, and only the pods with new traffic are reported each sampling period. Otherwise, the
+ * stats of the network namespace of every pod are read from /proc/<pid>/net/dev.
+ */
+class NetworkStatsConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "network_stats";
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{1000};
@@ -57,12 +69,19 @@ class NetworkStatsConnector : public SourceConnector {
 
  protected:
   explicit NetworkStatsConnector(std::string_view source_name)
-      : SourceConnector(source_name, kTables) {
+      : SourceConnector(source_name, kTables), bpf_tools::BCCWrapper() {
     proc_parser_ = std::make_unique<system::ProcParser>(sysconfig_);
   }
 
  private:
+  // Attaches the counting programs to the root cgroup. Fails if it isn't a cgroup2 hierarchy.
+  Status InitBPF();
+
   void TransferNetworkStatsTable(ConnectorContext* ctx, DataTable* data_table);
+  void TransferNetworkStatsTableBPF(ConnectorContext* ctx, DataTable* data_table);
+
+  // Maps the cgroups of the containers that were not seen before to their pods.
+  void UpdateCGroupPods(const md::K8sMetadataState& k8s_md);
 
   static Status GetNetworkStatsForPod(const system::ProcParser& proc_parser,
                                       const md::PodInfo& pod_info,
@@ -70,6 +89,24 @@ class NetworkStatsConnector : public SourceConnector {
                                       system::ProcParser::NetworkStats* stats);
 
   std::unique_ptr<system::ProcParser> proc_parser_;
+
+  // Whether the stats are counted by BPF, rather than read from /proc.
+  bool use_bpf_ = false;
+
+  // data structures shared with BPF:
+  std::unique_ptr<ebpf::BPFHashTable<uint64_t, cgroup_net_stats_t>> cgroup_net_stats_a_;
+  std::unique_ptr<ebpf::BPFHashTable<uint64_t, cgroup_net_stats_t>> cgroup_net_stats_b_;
+  std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> network_stats_state_;
+
+  // Number of iterations, where each iteration drains the counters accumulated in BPF.
+  uint64_t transfer_count_ = 0;
+
+  // The containers whose cgroups are in cgroup_pods_.
+  absl::flat_hash_set<std::string> resolved_container_ids_;
+  // The pod ID of each cgroup ID. Cgroups of other processes on the host are ignored.
+  absl::flat_hash_map<uint64_t, std::string> cgroup_pods_;
+  // The totals since the pod was first seen, since the columns are counters.
+  absl::flat_hash_map<std::string, system::ProcParser::NetworkStats> pod_stats_;
 };
 
 }  // namespace stirling
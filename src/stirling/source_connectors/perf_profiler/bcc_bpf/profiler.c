@@ -93,12 +93,25 @@ BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 // See comments in shared header file "stack_event.h".
 BPF_ARRAY(profiler_state, uint64_t, kProfilerStateVectorSize);
 
+#ifdef FILTER_TARGET_TGIDS
+// target_tgids: the processes to sample, written on user side; all others are ignored.
+// Used by the self profiler, which only samples Pixie's own processes.
+BPF_HASH(target_tgids, uint32_t, uint8_t, kMaxTargetTGIDs);
+#endif
+
 int sample_call_stack(struct bpf_perf_event_data* ctx) {
   int transfer_count_idx = kTransferCountIdx;
   int sample_count_a_idx = kSampleCountAIdx;
-  int sample_count_b_idx = kSampleCountAIdx;
+  int sample_count_b_idx = kSampleCountBIdx;
   int error_status_idx = kErrorStatusIdx;
 
+#ifdef FILTER_TARGET_TGIDS
+  uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
+  if (target_tgids.lookup(&tgid) == NULL) {
+    return 0;
+  }
+#endif
+
   uint64_t* transfer_count_ptr = profiler_state.lookup(&transfer_count_idx);
   uint64_t* sample_count_a_ptr = profiler_state.lookup(&sample_count_a_idx);
   uint64_t* sample_count_b_ptr = profiler_state.lookup(&sample_count_b_idx);
@@ -34,6 +34,9 @@ static const uint32_t kSampleCountBIdx = 2;
 static const uint32_t kErrorStatusIdx = 3;
 static const uint32_t kProfilerStateVectorSize = 4;
 
+// The capacity of the target_tgids map, when the profiler only samples some processes.
+static const uint32_t kMaxTargetTGIDs = 64;
+
 // stack_trace_key_t indexes into the stack-trace histogram.
 // By tying together the user & kernel stack-trace-ids [1],
 // it fully identifies a unique stack trace.
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/heap_sample.h"
+
+#include <cstdlib>
+#include <string>
+
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
+namespace px {
+namespace stirling {
+
+StatusOr<std::vector<HeapSampleStack>> ParseHeapSample(std::string_view text) {
+  std::vector<HeapSampleStack> stacks;
+  for (std::string_view line : absl::StrSplit(text, '\n', absl::SkipWhitespace())) {
+    if (absl::StartsWith(line, "heap profile:")) {
+      continue;
+    }
+    if (absl::StartsWith(line, "MAPPED_LIBRARIES:")) {
+      break;
+    }
+
+    std::vector<std::string_view> parts = absl::StrSplit(line, absl::MaxSplits('@', 1));
+    if (parts.size() != 2) {
+      return error::InvalidArgument("Heap sample line has no stack trace: '$0'", line);
+    }
+
+    // The in-use counts, then the counts of all (also freed) sampled allocations.
+    std::vector<std::string_view> counts =
+        absl::StrSplit(parts[0], absl::ByAnyChar(" :[]"), absl::SkipEmpty());
+    HeapSampleStack stack;
+    if (counts.size() != 4 || !absl::SimpleAtoi(counts[0], &stack.inuse_objects) ||
+        !absl::SimpleAtoi(counts[1], &stack.inuse_bytes)) {
+      return error::InvalidArgument("Heap sample line has invalid counts: '$0'", line);
+    }
+
+    for (std::string_view addr : absl::StrSplit(parts[1], ' ', absl::SkipEmpty())) {
+      const std::string addr_str(addr);
+      char* end = nullptr;
+      const uint64_t value = std::strtoull(addr_str.c_str(), &end, 16);
+      if (end != addr_str.c_str() + addr_str.size()) {
+        return error::InvalidArgument("Heap sample line has an invalid address: '$0'", line);
+      }
+      stack.addrs.push_back(static_cast<uintptr_t>(value));
+    }
+    stacks.push_back(std::move(stack));
+  }
+  return stacks;
+}
+
+}  // namespace stirling
+}  // namespace px
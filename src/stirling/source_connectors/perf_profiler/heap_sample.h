@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+
+// A stack trace of the allocations sampled by tcmalloc, with the sampled memory still in use.
+struct HeapSampleStack {
+  int64_t inuse_objects = 0;
+  int64_t inuse_bytes = 0;
+  // Return addresses, leaf first (like the stacks of BPF).
+  std::vector<uintptr_t> addrs;
+};
+
+/**
+ * Parses the heap profile returned by MallocExtension::GetHeapSample(), i.e. lines like:
+ *   1:   262144 [     1:   262144] @ 0x4006a4 0x4006e8
+ * up to the MAPPED_LIBRARIES section.
+ */
+StatusOr<std::vector<HeapSampleStack>> ParseHeapSample(std::string_view text);
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/heap_sample.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+constexpr std::string_view kHeapSample =
+    "heap profile:    3:   263168 [     5:   264192] @ heap_v2/524288\n"
+    "     1:   262144 [     1:   262144] @ 0x4006a4 0x4006e8 0x7f5a1c0b2b97\n"
+    "     2:     1024 [     4:     2048] @ 0x4006b0\n"
+    "\n"
+    "MAPPED_LIBRARIES:\n"
+    "00400000-00401000 r-xp 00000000 08:01 1234 /app/binary\n";
+
+TEST(ParseHeapSampleTest, stacks_until_mapped_libraries) {
+  ASSERT_OK_AND_ASSIGN(std::vector<HeapSampleStack> stacks, ParseHeapSample(kHeapSample));
+  ASSERT_EQ(stacks.size(), 2);
+
+  EXPECT_EQ(stacks[0].inuse_objects, 1);
+  EXPECT_EQ(stacks[0].inuse_bytes, 262144);
+  EXPECT_THAT(stacks[0].addrs, ElementsAre(0x4006a4, 0x4006e8, 0x7f5a1c0b2b97));
+
+  EXPECT_EQ(stacks[1].inuse_objects, 2);
+  EXPECT_EQ(stacks[1].inuse_bytes, 1024);
+  EXPECT_THAT(stacks[1].addrs, ElementsAre(0x4006b0));
+}
+
+TEST(ParseHeapSampleTest, empty_profile) {
+  ASSERT_OK_AND_ASSIGN(std::vector<HeapSampleStack> stacks,
+                       ParseHeapSample("heap profile:    0:        0 [     0:        0] @\n"));
+  EXPECT_THAT(stacks, IsEmpty());
+}
+
+TEST(ParseHeapSampleTest, rejects_malformed_lines) {
+  EXPECT_NOT_OK(ParseHeapSample("     1:   262144 [     1:   262144]\n"));
+  EXPECT_NOT_OK(ParseHeapSample("     x:   262144 [     1:   262144] @ 0x4006a4\n"));
+  EXPECT_NOT_OK(ParseHeapSample("     1:   262144 [     1:   262144] @ 0x40zz\n"));
+}
+
+}  // namespace stirling
+}  // namespace px
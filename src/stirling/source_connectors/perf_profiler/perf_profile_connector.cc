@@ -18,16 +18,24 @@
 
 #include <sys/sysinfo.h>
 
+#include <farmhash.h>
+
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "src/stirling/bpf_tools/bpf_map.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 
 BPF_SRC_STRVIEW(profiler_bcc_script, profiler);
 
+DEFINE_bool(stirling_profiler_stack_trace_dictionary, false,
+            "If true, the stack_trace column of stack_traces.beta is left empty, and each stack "
+            "trace string is written to stack_trace_strings.beta instead, about once per refresh "
+            "period. Rows of the two tables are matched by stack_trace_id.");
+
 namespace px {
 namespace stirling {
 
@@ -83,29 +91,38 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
   }
 }
 
-uint64_t PerfProfileConnector::StackTraceID(const SymbolicStackTrace& /* stack_trace */) {
+uint64_t PerfProfileConnector::StackTraceID(const SymbolicStackTrace& stack_trace) {
   // Historically, we maintained a map of stack trace IDs for every stack trace observed,
-  // This was meant to help normalize our tables, which we never implemented.
-  // It was also used to accelerate aggregations across time samples by Carnot.
-  //
-  // Unfortunately, the memory cost of maintaining the stack trace ID map was too high.
-  // Since we never really used it for its intended purpose, we have now removed the map.
-  //
-  // Instead, we generate a new id for every stack trace.
-  // This means the same stack trace across two TransferData calls have different IDs.
-  // Fortunately, the UI will aggregate two identical stack traces even if the IDs don't match.
+  // and later generated a new ID for every row. Neither made the ID useful for joining.
   //
-  // TODO(jps): Consider removing stack_trace_id from the stack_traces table schema, since
-  //            the ID is effectively useless now.
-  return next_stack_trace_id_++;
+  // Instead, the ID is a fingerprint of the folded stack trace string. It needs no state, and is
+  // the same across TransferData calls, processes and agents, so it can key a dictionary of
+  // stack trace strings (stack_trace_strings.beta).
+  // The hash must not be seeded per process, which rules out absl::Hash.
+  return ::util::Hash64(stack_trace.stack_trace_str);
+}
+
+void PerfProfileConnector::AppendStackTraceString(uint64_t stack_trace_id,
+                                                  const std::string& stack_trace_str,
+                                                  uint64_t timestamp_ns,
+                                                  DataTable* stack_trace_strings_table) {
+  auto [iter, inserted] = stack_trace_strings_written_ns_.try_emplace(stack_trace_id, timestamp_ns);
+  const uint64_t refresh_period_ns =
+      std::chrono::nanoseconds(kStackTraceStringsRefreshPeriod).count();
+  if (!inserted && timestamp_ns - iter->second < refresh_period_ns) {
+    return;
+  }
+  iter->second = timestamp_ns;
+
+  DataTable::RecordBuilder<&kStackTraceStringsTable> r(stack_trace_strings_table, timestamp_ns);
+  r.Append<r.ColIndex("time_")>(timestamp_ns);
+  r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id);
+  r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(stack_trace_str);
 }
 
 PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces(
     ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces,
     ebpf::BPFHashTable<stack_trace_key_t, uint64_t>* histo) {
-  // TODO(jps): switch from using get_table_offline() to directly stepping through
-  // the histogram data structure. Inline populating our own data structures with this.
-  // Avoid an unnecessary copy of the information in local stack_trace_keys_and_counts.
   StackTraceHisto symbolic_histogram;
   uint64_t cum_sum_count = 0;
 
@@ -113,17 +130,17 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
   const absl::flat_hash_set<md::UPID>& upids_for_symbolization = ctx->GetUPIDs();
 
   // Create a new stringifier for this iteration of the continuous perf profiler.
-  Stringifier stringifier(&symbolizer_, stack_traces);
+  Stringifier stringifier(&symbolizer_, stack_traces, &stack_trace_str_cache_);
 
   // Here we "consume" the table (vs. just "reading" it). Passing "clear_table=true"
-  // into get_table_offline() clears each entry while walking the table and copying
-  // out the data. This shows a significant performance boost vs. using clear_table_non_atomic()
+  // into ReadHashTable() clears the entries while copying them out, a batch at a time.
+  // This shows a significant performance boost vs. using clear_table_non_atomic()
   // after the table has been read.
   constexpr bool kClearTable = true;
 
   absl::flat_hash_set<int> k_stack_ids_to_remove;
 
-  for (const auto& [stack_trace_key, count] : histo->get_table_offline(kClearTable)) {
+  for (const auto& [stack_trace_key, count] : bpf_tools::ReadHashTable(histo, kClearTable)) {
     std::string stack_trace_str;
 
     const md::UPID upid(asid, stack_trace_key.upid.pid, stack_trace_key.upid.start_time_ticks);
@@ -174,16 +191,21 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
     stack_traces->clear_stack_id(k_stack_id);
   }
 
+  // Stack trace strings not used in this iteration nor the previous one are evicted.
+  stack_trace_str_cache_.CreateNewGeneration();
+
   VLOG(1) << "PerfProfileConnector::AggregateStackTraces(): cum_sum_count: " << cum_sum_count;
+  VLOG(1) << "PerfProfileConnector::AggregateStackTraces(): stack_trace_str_cache entries: "
+          << stack_trace_str_cache_.total_entries();
   return symbolic_histogram;
 }
 
 void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces,
                                          ebpf::BPFHashTable<stack_trace_key_t, uint64_t>* histo,
-                                         ConnectorContext* ctx, DataTable* data_table) {
-  constexpr size_t kMaxSymbolSize = 512;
-  constexpr size_t kMaxStackDepth = 64;
-  constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
+                                         ConnectorContext* ctx, DataTable* data_table,
+                                         DataTable* stack_trace_strings_table) {
+  const bool use_dictionary =
+      FLAGS_stirling_profiler_stack_trace_dictionary && stack_trace_strings_table != nullptr;
 
   const uint64_t timestamp_ns = CurrentTimeNS();
 
@@ -200,13 +222,36 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces,
 
     r.Append<r.ColIndex("time_")>(timestamp_ns);
     r.Append<r.ColIndex("upid")>(key.upid.value());
-    r.Append<r.ColIndex("stack_trace_id")>(StackTraceID(key));
-    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    const uint64_t stack_trace_id = StackTraceID(key);
+    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_id);
+    if (use_dictionary) {
+      r.Append<r.ColIndex("stack_trace")>("");
+      AppendStackTraceString(stack_trace_id, key.stack_trace_str, timestamp_ns,
+                             stack_trace_strings_table);
+    } else {
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    }
     r.Append<r.ColIndex("count")>(count);
   }
+
+  if (use_dictionary) {
+    // Stack traces that were not sampled for a refresh period are forgotten; if they come back,
+    // they are written again.
+    const uint64_t refresh_period_ns =
+        std::chrono::nanoseconds(kStackTraceStringsRefreshPeriod).count();
+    for (auto iter = stack_trace_strings_written_ns_.begin();
+         iter != stack_trace_strings_written_ns_.end();) {
+      if (timestamp_ns - iter->second >= refresh_period_ns) {
+        stack_trace_strings_written_ns_.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+  }
 }
 
-void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table) {
+void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                                                 DataTable* stack_trace_strings_table) {
   // Choose the maps to consume.
   auto& histo = transfer_count_ % 2 == 0 ? histogram_a_ : histogram_b_;
   auto& stack_traces = transfer_count_ % 2 == 0 ? stack_traces_a_ : stack_traces_b_;
@@ -219,7 +264,7 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
   LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
   // Read BPF stack traces & histogram, build records, incorporate records to data table.
-  CreateRecords(stack_traces.get(), histo.get(), ctx, data_table);
+  CreateRecords(stack_traces.get(), histo.get(), ctx, data_table, stack_trace_strings_table);
 
   // Now that we've consumed the data, reset the sample count in BPF.
   profiler_state_->update_value(sample_count_idx, 0);
@@ -227,18 +272,18 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
 
 void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
                                             const std::vector<DataTable*>& data_tables) {
-  DCHECK_EQ(data_tables.size(), 1);
+  DCHECK_EQ(data_tables.size(), kTables.size());
 
-  auto* data_table = data_tables[0];
+  auto* data_table = data_tables[kPerfProfileTableNum];
 
   if (data_table == nullptr) {
     return;
   }
 
-  ProcessBPFStackTraces(ctx, data_table);
+  ProcessBPFStackTraces(ctx, data_table, data_tables[kStackTraceStringsTableNum]);
 
   // Cleanup the symbolizer so we don't leak memory.
-  proc_tracker_.Update(ctx->GetUPIDs());
+  ctx->UpdateProcTracker(&proc_tracker_);
   CleanupSymbolizers(proc_tracker_.deleted_upids());
 }
 
@@ -33,6 +33,8 @@
 #include "src/stirling/source_connectors/perf_profiler/stringifier.h"
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
 
+DECLARE_bool(stirling_profiler_stack_trace_dictionary);
+
 namespace px {
 namespace stirling {
 
@@ -43,8 +45,9 @@ static constexpr std::string_view kNotSymbolizedMessage = "<not symbolized>";
 class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "perf_profiler";
-  static constexpr auto kTables = MakeArray(kStackTraceTable);
+  static constexpr auto kTables = MakeArray(kStackTraceTable, kStackTraceStringsTable);
   static constexpr uint32_t kPerfProfileTableNum = TableNum(kTables, kStackTraceTable);
+  static constexpr uint32_t kStackTraceStringsTableNum = TableNum(kTables, kStackTraceStringsTable);
 
   // kBPFSamplingPeriod: the time interval in between stack trace samples.
   static constexpr auto kBPFSamplingPeriod = std::chrono::milliseconds{11};
@@ -55,6 +58,11 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{30000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{15000};
 
+  // With --stirling_profiler_stack_trace_dictionary, a stack trace that keeps being sampled is
+  // written to stack_trace_strings.beta again after this long, so that its string outlives the
+  // older rows of the table in the table store.
+  static constexpr auto kStackTraceStringsRefreshPeriod = std::chrono::minutes{10};
+
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new PerfProfileConnector(name));
   }
@@ -64,6 +72,10 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
  private:
+  static constexpr size_t kMaxSymbolSize = 512;
+  static constexpr size_t kMaxStackDepth = 64;
+  static constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
+
   // SymbolicStackTrace identifies a particular stack trace by:
   // * upid
   // * "folded" stack trace string
@@ -98,14 +110,22 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   explicit PerfProfileConnector(std::string_view source_name);
 
-  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table);
+  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                             DataTable* stack_trace_strings_table);
 
-  // Read BPF data structures, build & incorporate records to the table.
+  // Read BPF data structures, build & incorporate records to the tables.
+  // stack_trace_strings_table may be nullptr, in which case the strings are always written to
+  // data_table.
   void CreateRecords(ebpf::BPFStackTable* stack_traces,
                      ebpf::BPFHashTable<stack_trace_key_t, uint64_t>* histo, ConnectorContext* ctx,
-                     DataTable* data_table);
+                     DataTable* data_table, DataTable* stack_trace_strings_table);
 
-  uint64_t StackTraceID(const SymbolicStackTrace& stack_trace);
+  static uint64_t StackTraceID(const SymbolicStackTrace& stack_trace);
+
+  // Writes the stack trace string to stack_trace_strings_table, unless it was written within the
+  // refresh period.
+  void AppendStackTraceString(uint64_t stack_trace_id, const std::string& stack_trace_str,
+                              uint64_t timestamp_ns, DataTable* stack_trace_strings_table);
 
   StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces,
                                        ebpf::BPFHashTable<stack_trace_key_t, uint64_t>* histo);
@@ -122,9 +142,9 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Number of iterations, where each iteration is drains the information collectid in BPF.
   uint64_t transfer_count_ = 0;
 
-  // Tracks the next stack-trace-id to be assigned;
-  // incremented by 1 for each such assignment.
-  uint64_t next_stack_trace_id_ = 0;
+  // The time each stack trace string was last written to stack_trace_strings.beta, by
+  // stack-trace-id. Entries older than kStackTraceStringsRefreshPeriod are evicted.
+  absl::flat_hash_map<uint64_t, uint64_t> stack_trace_strings_written_ns_;
 
   // The symbolizer has an instance of a BPF stack table (internally),
   // solely to gain access to the BCC symbolization API. Depending on the
@@ -132,6 +152,10 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // to find the symbol in its internally managed symbol cache.
   Symbolizer symbolizer_;
 
+  // Folded stack trace strings, memoized across iterations so that stack traces seen
+  // repeatedly are only symbolized once. See StackTraceStrCache for eviction.
+  StackTraceStrCache stack_trace_str_cache_;
+
   // Keeps track of processes. Used to find destroyed processes on which to perform clean-up.
   // TODO(oazizi): Investigate ways of sharing across source_connectors.
   ProcTracker proc_tracker_;
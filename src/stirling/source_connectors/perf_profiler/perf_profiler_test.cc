@@ -33,7 +33,10 @@ namespace stirling {
 
 using ::px::stirling::testing::FindRecordIdxMatchesPIDs;
 using ::px::testing::BazelBinTestFilePath;
+using ::testing::Contains;
 using ::testing::Gt;
+using ::testing::IsEmpty;
+using ::testing::Not;
 using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 
@@ -56,7 +59,9 @@ class CPUPinnedBinaryRunner {
 
 class PerfProfileBPFTest : public ::testing::Test {
  public:
-  PerfProfileBPFTest() : data_table_(/*id*/ 0, kStackTraceTable) {}
+  PerfProfileBPFTest()
+      : data_table_(/*id*/ 0, kStackTraceTable),
+        stack_trace_strings_table_(/*id*/ 1, kStackTraceStringsTable) {}
 
  protected:
   void SetUp() override {
@@ -230,7 +235,8 @@ class PerfProfileBPFTest : public ::testing::Test {
   std::unique_ptr<SourceConnector> source_;
   std::unique_ptr<StandaloneContext> ctx_;
   DataTable data_table_;
-  const std::vector<DataTable*> data_tables_{&data_table_};
+  DataTable stack_trace_strings_table_;
+  const std::vector<DataTable*> data_tables_{&data_table_, &stack_trace_strings_table_};
 
   bool column_ptrs_populated_ = false;
   std::shared_ptr<types::ColumnWrapper> trace_ids_column_;
@@ -351,5 +357,48 @@ TEST_F(PerfProfileBPFTest, TestOutOfContext) {
   ASSERT_NO_FATAL_FAILURE(PopulateObservedStackTraces(target_row_idxs));
 }
 
+TEST_F(PerfProfileBPFTest, StackTraceDictionary) {
+  // Needs to be unique across test fixtures because we use this to map
+  // into CPU index. If non-unique, two or more different test fixtures
+  // will run their toy apps. on the same CPU.
+  constexpr uint32_t kTestIdx = 3;
+
+  FLAGS_stirling_profiler_stack_trace_dictionary = true;
+
+  const std::filesystem::path bazel_app_path = BazelCCTestAppPath("profiler_test_app_fib");
+  const std::string key2x = "__libc_start_main;main;fib52();fib(unsigned long)";
+
+  auto sub_processes = StartSubProcesses<CPUPinnedBinaryRunner>(bazel_app_path, kTestIdx);
+  ctx_ = std::make_unique<StandaloneContext>();
+  RunTest(std::chrono::seconds(60));
+
+  FLAGS_stirling_profiler_stack_trace_dictionary = false;
+
+  ASSERT_NO_FATAL_FAILURE(ConsumeRecords());
+  const std::vector<size_t> target_row_idxs = GetTargetRowIdxs(sub_processes);
+  ASSERT_THAT(target_row_idxs, Not(IsEmpty()));
+
+  // Each stack trace string is written once, however many rows and push periods it spans.
+  const std::vector<TaggedRecordBatch> tablets = stack_trace_strings_table_.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  const types::ColumnWrapperRecordBatch& strings = tablets[0].records;
+  absl::flat_hash_map<int64_t, std::string> stack_trace_strings;
+  for (size_t i = 0; i < strings[0]->Size(); ++i) {
+    const int64_t id = strings[kStackTraceStringsTable.ColIndex("stack_trace_id")]
+                           ->Get<types::Int64Value>(i)
+                           .val;
+    const std::string str =
+        strings[kStackTraceStringsTable.ColIndex("stack_trace")]->Get<types::StringValue>(i);
+    EXPECT_TRUE(stack_trace_strings.emplace(id, str).second) << str;
+  }
+  EXPECT_THAT(stack_trace_strings, Contains(Pair(::testing::_, key2x)));
+
+  for (const size_t row_idx : target_row_idxs) {
+    EXPECT_EQ(stack_traces_column_->Get<types::StringValue>(row_idx), "");
+    const int64_t id = trace_ids_column_->Get<types::Int64Value>(row_idx).val;
+    EXPECT_TRUE(stack_trace_strings.contains(id));
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
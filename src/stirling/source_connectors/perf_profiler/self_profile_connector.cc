@@ -0,0 +1,228 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/self_profile_connector.h"
+
+#include <sys/sysinfo.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/system/proc_parser.h"
+#include "src/stirling/bpf_tools/bpf_map.h"
+#include "src/stirling/bpf_tools/macros.h"
+#include "src/stirling/source_connectors/perf_profiler/heap_sample.h"
+
+#ifdef TCMALLOC
+#include <gperftools/malloc_extension.h>
+#endif
+
+BPF_SRC_STRVIEW(self_profiler_bcc_script, profiler);
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+constexpr size_t kMaxStackTraceSize = 64 * 512;
+
+constexpr std::string_view kCPUProfileType = "cpu";
+constexpr std::string_view kHeapProfileType = "heap";
+
+bool IsKelvin(std::string_view cmdline) {
+  std::string_view exe = cmdline.substr(0, cmdline.find(' '));
+  return std::filesystem::path(exe).filename() == SelfProfileConnector::kKelvinExecutable;
+}
+
+}  // namespace
+
+Status SelfProfileConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+
+  const std::vector<std::string> defines = {
+      absl::Substitute("-DNCPUS=$0", get_nprocs_conf()),
+      absl::Substitute("-DTRANSFER_PERIOD=$0", kSamplingPeriod.count()),
+      absl::Substitute("-DSAMPLE_PERIOD=$0", kBPFSamplingPeriod.count()),
+      "-DFILTER_TARGET_TGIDS"};
+
+  PL_RETURN_IF_ERROR(InitBPFProgram(self_profiler_bcc_script, defines));
+  PL_RETURN_IF_ERROR(AttachSamplingProbes(kProbeSpecs));
+
+  stack_traces_a_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_a"));
+  stack_traces_b_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_b"));
+  histogram_a_ = std::make_unique<ebpf::BPFHashTable<stack_trace_key_t, uint64_t>>(
+      GetHashTable<stack_trace_key_t, uint64_t>("histogram_a"));
+  histogram_b_ = std::make_unique<ebpf::BPFHashTable<stack_trace_key_t, uint64_t>>(
+      GetHashTable<stack_trace_key_t, uint64_t>("histogram_b"));
+  profiler_state_ =
+      std::make_unique<ebpf::BPFArrayTable<uint64_t>>(GetArrayTable<uint64_t>("profiler_state"));
+  target_tgids_ = std::make_unique<ebpf::BPFHashTable<uint32_t, uint8_t>>(
+      GetHashTable<uint32_t, uint8_t>("target_tgids"));
+
+  self_upid_.pid = getpid();
+  PL_ASSIGN_OR_RETURN(self_upid_.start_time_ticks,
+                      system::GetPIDStartTimeTicks(sysconfig_.proc_path() /
+                                                   std::to_string(self_upid_.pid)));
+
+  return symbolizer_.Init();
+}
+
+void SelfProfileConnector::InitContextImpl(ConnectorContext* ctx) { UpdateTargets(ctx); }
+
+Status SelfProfileConnector::StopImpl() {
+  Close();
+  return Status::OK();
+}
+
+void SelfProfileConnector::UpdateTargets(ConnectorContext* ctx) {
+  absl::flat_hash_set<uint32_t> pids = {self_upid_.pid};
+  for (const auto& [upid, pid_info] : ctx->GetPIDInfoMap()) {
+    if (pid_info != nullptr && pid_info->stop_time_ns() == 0 && IsKelvin(pid_info->cmdline())) {
+      pids.insert(upid.pid());
+    }
+  }
+
+  for (uint32_t pid : target_pids_) {
+    if (!pids.contains(pid)) {
+      target_tgids_->remove_value(pid);
+    }
+  }
+  target_pids_.clear();
+  for (uint32_t pid : pids) {
+    if (target_pids_.size() == kMaxTargetTGIDs) {
+      LOG_FIRST_N(WARNING, 1) << absl::Substitute(
+          "Self profiling at most $0 processes, out of $1.", kMaxTargetTGIDs, pids.size());
+      break;
+    }
+    if (!target_tgids_->update_value(pid, 1).ok()) {
+      LOG(ERROR) << absl::Substitute("Could not add pid $0 to the self profiled processes.", pid);
+      continue;
+    }
+    target_pids_.insert(pid);
+  }
+}
+
+void SelfProfileConnector::TransferCPUProfile(ConnectorContext* ctx, uint64_t timestamp_ns,
+                                              DataTable* data_table) {
+  // Switch the maps that BPF writes to, like PerfProfileConnector::ProcessBPFStackTraces().
+  auto& histo = transfer_count_ % 2 == 0 ? histogram_a_ : histogram_b_;
+  auto& stack_traces = transfer_count_ % 2 == 0 ? stack_traces_a_ : stack_traces_b_;
+  const uint32_t sample_count_idx = transfer_count_ % 2 == 0 ? kSampleCountAIdx : kSampleCountBIdx;
+
+  ++transfer_count_;
+  const ebpf::StatusTuple s = profiler_state_->update_value(kTransferCountIdx, transfer_count_);
+  LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
+
+  // Only target processes are sampled, so every stack trace is symbolized, which also clears
+  // its stack-ids out of the stack traces table.
+  Stringifier stringifier(&symbolizer_, stack_traces.get(), &stack_trace_str_cache_);
+  absl::flat_hash_map<std::pair<md::UPID, std::string>, uint64_t> histogram;
+  constexpr bool kClearTable = true;
+  for (const auto& [key, count] : bpf_tools::ReadHashTable(histo.get(), kClearTable)) {
+    const md::UPID upid(ctx->GetASID(), key.upid.pid, key.upid.start_time_ticks);
+    histogram[{upid, stringifier.FoldedStackTraceString(key)}] += count;
+  }
+  stack_trace_str_cache_.CreateNewGeneration();
+
+  profiler_state_->update_value(sample_count_idx, 0);
+
+  for (const auto& [key, count] : histogram) {
+    DataTable::RecordBuilder<&kSelfProfileTable> r(data_table, timestamp_ns);
+    r.Append<r.ColIndex("time_")>(timestamp_ns);
+    r.Append<r.ColIndex("upid")>(key.first.value());
+    r.Append<r.ColIndex("profile_type")>(std::string(kCPUProfileType));
+    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.second);
+    r.Append<r.ColIndex("count")>(count);
+    r.Append<r.ColIndex("bytes")>(0);
+  }
+}
+
+void SelfProfileConnector::TransferHeapProfile(ConnectorContext* ctx, uint64_t timestamp_ns,
+                                               DataTable* data_table) {
+#ifdef TCMALLOC
+  std::string heap_sample;
+  MallocExtension::instance()->GetHeapSample(&heap_sample);
+  StatusOr<std::vector<HeapSampleStack>> stacks_or = ParseHeapSample(heap_sample);
+  if (!stacks_or.ok()) {
+    LOG_FIRST_N(WARNING, 1) << absl::Substitute("Could not parse the heap sample: $0",
+                                                stacks_or.msg());
+    return;
+  }
+
+  // Distinct stack traces can fold into the same string.
+  auto symbolize_fn = symbolizer_.GetSymbolizerFn(self_upid_);
+  absl::flat_hash_map<std::string, HeapSampleStack> histogram;
+  for (const HeapSampleStack& stack : stacks_or.ValueOrDie()) {
+    HeapSampleStack& total = histogram[Stringifier::FoldStackTrace(stack.addrs, symbolize_fn,
+                                                                   stringifier::kUserSuffix)];
+    total.inuse_objects += stack.inuse_objects;
+    total.inuse_bytes += stack.inuse_bytes;
+  }
+
+  const md::UPID upid(ctx->GetASID(), self_upid_.pid, self_upid_.start_time_ticks);
+  for (const auto& [stack_trace_str, total] : histogram) {
+    if (total.inuse_objects == 0) {
+      continue;
+    }
+    DataTable::RecordBuilder<&kSelfProfileTable> r(data_table, timestamp_ns);
+    r.Append<r.ColIndex("time_")>(timestamp_ns);
+    r.Append<r.ColIndex("upid")>(upid.value());
+    r.Append<r.ColIndex("profile_type")>(std::string(kHeapProfileType));
+    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(stack_trace_str);
+    r.Append<r.ColIndex("count")>(total.inuse_objects);
+    r.Append<r.ColIndex("bytes")>(total.inuse_bytes);
+  }
+#else
+  PL_UNUSED(ctx);
+  PL_UNUSED(timestamp_ns);
+  PL_UNUSED(data_table);
+#endif
+}
+
+void SelfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
+                                            const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1);
+
+  auto* data_table = data_tables[kSelfProfileTableNum];
+  if (data_table == nullptr) {
+    return;
+  }
+
+  const uint64_t timestamp_ns = CurrentTimeNS();
+  TransferCPUProfile(ctx, timestamp_ns, data_table);
+  TransferHeapProfile(ctx, timestamp_ns, data_table);
+
+  // Kelvin processes come and go with their pods.
+  UpdateTargets(ctx);
+  ctx->UpdateProcTracker(&proc_tracker_);
+  for (const auto& md_upid : proc_tracker_.deleted_upids()) {
+    struct upid_t upid;
+    upid.pid = md_upid.pid();
+    upid.start_time_ticks = md_upid.start_ts();
+    symbolizer_.FlushCache(upid);
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
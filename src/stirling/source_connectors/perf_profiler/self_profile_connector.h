@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
+#include "src/stirling/source_connectors/perf_profiler/self_profile_table.h"
+#include "src/stirling/source_connectors/perf_profiler/stringifier.h"
+#include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
+#include "src/stirling/utils/proc_tracker.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * SelfProfileConnector continuously profiles the Pixie agents: this process (the PEM), and the
+ * Kelvin processes that run on the same node. It samples their stack traces with the BPF program
+ * of PerfProfileConnector, restricted to those processes and at a lower rate, and it exports
+ * the allocations sampled by tcmalloc in this process. Both go into px_self_profile as folded
+ * stack traces.
+ *
+ * Allocation samples require tcmalloc's sampling to be on (TCMALLOC_SAMPLE_PARAMETER); without
+ * it, there are only 'cpu' records.
+ */
+class SelfProfileConnector : public SourceConnector, public bpf_tools::BCCWrapper {
+ public:
+  static constexpr std::string_view kName = "self_profiler";
+  static constexpr auto kTables = MakeArray(kSelfProfileTable);
+  static constexpr uint32_t kSelfProfileTableNum = TableNum(kTables, kSelfProfileTable);
+
+  // About 9x less often than PerfProfileConnector, since it is always on, in production.
+  static constexpr auto kBPFSamplingPeriod = std::chrono::milliseconds{97};
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{60000};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{30000};
+
+  // The executable of Kelvin, whose processes are profiled along with this one.
+  static constexpr std::string_view kKelvinExecutable = "kelvin";
+
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new SelfProfileConnector(name));
+  }
+
+  Status InitImpl() override;
+  void InitContextImpl(ConnectorContext* ctx) override;
+  Status StopImpl() override;
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+
+ private:
+  explicit SelfProfileConnector(std::string_view source_name)
+      : SourceConnector(source_name, kTables) {}
+
+  // Points BPF at this process and at the Kelvin processes of the context.
+  void UpdateTargets(ConnectorContext* ctx);
+
+  void TransferCPUProfile(ConnectorContext* ctx, uint64_t timestamp_ns, DataTable* data_table);
+  void TransferHeapProfile(ConnectorContext* ctx, uint64_t timestamp_ns, DataTable* data_table);
+
+  // Data structures shared with BPF; see PerfProfileConnector.
+  std::unique_ptr<ebpf::BPFStackTable> stack_traces_a_;
+  std::unique_ptr<ebpf::BPFStackTable> stack_traces_b_;
+  std::unique_ptr<ebpf::BPFHashTable<stack_trace_key_t, uint64_t>> histogram_a_;
+  std::unique_ptr<ebpf::BPFHashTable<stack_trace_key_t, uint64_t>> histogram_b_;
+  std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> profiler_state_;
+  std::unique_ptr<ebpf::BPFHashTable<uint32_t, uint8_t>> target_tgids_;
+
+  uint64_t transfer_count_ = 0;
+
+  // This process.
+  struct upid_t self_upid_ = {};
+  absl::flat_hash_set<uint32_t> target_pids_;
+
+  Symbolizer symbolizer_;
+  StackTraceStrCache stack_trace_str_cache_;
+  ProcTracker proc_tracker_;
+
+  static constexpr auto kProbeSpecs =
+      MakeArray<bpf_tools::SamplingProbeSpec>({"sample_call_stack", kBPFSamplingPeriod.count()});
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/types.h"
+
+namespace px {
+namespace stirling {
+
+// clang-format off
+static constexpr DataElement kSelfProfileElements[] = {
+    canonical_data_elements::kTime,
+    canonical_data_elements::kUPID,
+    {"profile_type",
+     "The kind of samples: 'cpu' for sampled stack traces of running threads, "
+     "'heap' for allocations sampled by tcmalloc that are still in use.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM},
+    {"stack_trace",
+     "A stack trace within the sampled process, in folded format. "
+     "The call stack symbols are separated by semicolons.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"count",
+     "For 'cpu', the number of times the stack trace has been sampled. "
+     "For 'heap', the number of sampled allocations in use.",
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE},
+    {"bytes",
+     "For 'heap', the bytes of the sampled allocations in use. 0 for 'cpu'.",
+     types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_GAUGE},
+};
+
+constexpr auto kSelfProfileTable = DataTableSchema(
+        "px_self_profile",
+        "Continuous low-rate CPU and allocation profiles of the Pixie agents themselves (PEM and "
+        "Kelvin), for finding agent regressions.",
+        kSelfProfileElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(SelfProfile)
+
+}  // namespace stirling
+}  // namespace px
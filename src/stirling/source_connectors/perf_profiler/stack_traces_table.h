@@ -31,13 +31,16 @@ static constexpr DataElement kElements[] = {
     canonical_data_elements::kTime,
     canonical_data_elements::kUPID,
     {"stack_trace_id",
-     "A unique identifier of the stack trace, for script-writing convenience. "
-     "String representation is in the `stack_trace` column.",
+     "An identifier of the stack trace: a hash of its folded string, so it is the same "
+     "across push periods and processes. "
+     "String representation is in the `stack_trace` column, or in the stack_trace_strings.beta "
+     "table if `stack_trace` is empty.",
      types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"stack_trace",
      "A stack trace within the sampled process, in folded format. "
      "The call stack symbols are separated by semicolons. "
-     "If symbols cannot be resolved, addresses are populated instead.",
+     "If symbols cannot be resolved, addresses are populated instead. "
+     "Empty when the stack trace strings are written to stack_trace_strings.beta instead.",
      types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
     {"count",
      "Number of times the stack trace has been sampled.",
@@ -53,6 +56,27 @@ constexpr auto kStackTraceTable = DataTableSchema(
 // clang-format on
 DEFINE_PRINT_TABLE(StackTrace)
 
+// clang-format off
+static constexpr DataElement kStackTraceStringElements[] = {
+    canonical_data_elements::kTime,
+    {"stack_trace_id",
+     "The stack_trace_id of the stack_traces.beta rows with this stack trace.",
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"stack_trace",
+     "The stack trace, in folded format.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+};
+
+constexpr auto kStackTraceStringsTable = DataTableSchema(
+        "stack_trace_strings.beta",
+        "The folded strings of the stack traces in stack_traces.beta, by stack_trace_id. "
+        "Only populated with --stirling_profiler_stack_trace_dictionary, in which case each stack "
+        "trace is written here about once per refresh period, instead of on every sample row.",
+        kStackTraceStringElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(StackTraceStrings)
+
 constexpr int kStackTraceTimeIdx = kStackTraceTable.ColIndex("time_");
 constexpr int kStackTraceUPIDIdx = kStackTraceTable.ColIndex("upid");
 constexpr int kStackTraceStackTraceIDIdx = kStackTraceTable.ColIndex("stack_trace_id");
@@ -21,36 +21,92 @@
 
 #include <vector>
 
+DEFINE_uint64(stirling_profiler_stack_trace_str_cache_size, 64 * 1024,
+              "The number of folded stack trace strings the profiler keeps per generation, "
+              "to skip symbolizing stack traces that were seen before.");
+
 namespace px {
 namespace stirling {
 
-Stringifier::Stringifier(Symbolizer* symbolizer, ebpf::BPFStackTable* stack_traces)
-    : symbolizer_(symbolizer), stack_traces_(stack_traces) {}
+const std::string* StackTraceStrCache::Lookup(const struct upid_t& upid,
+                                              const std::vector<uintptr_t>& addrs) {
+  const KeyView key(upid, absl::MakeConstSpan(addrs));
+  const auto iter = cache_.find(key);
+  if (iter != cache_.end()) {
+    return &iter->second;
+  }
+
+  // Check old cache, and move result to new cache if we have a hit.
+  auto prev_iter = prev_cache_.find(key);
+  if (prev_iter == prev_cache_.end()) {
+    return nullptr;
+  }
+  auto node = prev_cache_.extract(prev_iter);
+  if (cache_.size() >= max_entries_) {
+    CreateNewGeneration();
+  }
+  const auto result = cache_.insert(std::move(node));
+  DCHECK(result.inserted);
+  return &result.position->second;
+}
+
+void StackTraceStrCache::Insert(const struct upid_t& upid, std::vector<uintptr_t> addrs,
+                                std::string str) {
+  if (cache_.size() >= max_entries_) {
+    CreateNewGeneration();
+  }
+  cache_.try_emplace(Key(upid, std::move(addrs)), std::move(str));
+}
+
+Stringifier::Stringifier(Symbolizer* symbolizer, ebpf::BPFStackTable* stack_traces,
+                         StackTraceStrCache* stack_trace_str_cache)
+    : symbolizer_(symbolizer),
+      stack_traces_(stack_traces),
+      stack_trace_str_cache_(stack_trace_str_cache) {}
 
 std::string Stringifier::BuildStackTraceString(const int stack_id, const struct upid_t& upid,
                                                const std::string_view& suffix) {
-  // TODO(jps): re-evaluate the correct amount to reserve here.
-  std::string stack_trace_str;
-  stack_trace_str.reserve(128);
+  // Clear the stack-traces map as we go along here; this has lower overhead
+  // compared to first reading the stack-traces map, then using clear_table_non_atomic().
+  constexpr bool kClearStackId = true;
+
+  // Get the stack trace (as a vector of addresses) from the shared BPF stack trace table.
+  std::vector<uintptr_t> addrs = stack_traces_->get_stack_addr(stack_id, kClearStackId);
+  VLOG_IF(1, addrs.size() == 0) << absl::Substitute(
+      "[empty_stack_trace] stack_id: $0, upid.pid: $1", stack_id, static_cast<int>(upid.pid));
+
+  if (stack_trace_str_cache_ != nullptr) {
+    const std::string* cached_str = stack_trace_str_cache_->Lookup(upid, addrs);
+    if (cached_str != nullptr) {
+      return *cached_str;
+    }
+  }
 
   // Get a function that returns a symbol based on an address. The upid is
   // used by the symbolizer both to find symbols in the underlying binary,
   // and to track cached symbols (symbols that we have previously looked up).
-  auto symbolize_fn = symbolizer_->GetSymbolizerFn(upid);
+  std::string stack_trace_str =
+      FoldStackTrace(addrs, symbolizer_->GetSymbolizerFn(upid), suffix);
 
-  // Clear the stack-traces map as we go along here; this has lower overhead
-  // compared to first reading the stack-traces map, then using clear_table_non_atomic().
-  constexpr bool kClearStackId = true;
+  if (stack_trace_str_cache_ != nullptr && !addrs.empty()) {
+    stack_trace_str_cache_->Insert(upid, std::move(addrs), stack_trace_str);
+  }
 
+  return stack_trace_str;
+}
+
+std::string Stringifier::FoldStackTrace(
+    const std::vector<uintptr_t>& addrs,
+    const std::function<std::string_view(const uintptr_t addr)>& symbolize_fn,
+    std::string_view suffix) {
   // Some stack-traces have the address 0xcccccccccccccccc where one might
   // otherwise expect to find "main" or "start_thread". Given that this address
   // is not a "real" address, we filter it out below.
   constexpr uint64_t kSentinelAddr = 0xcccccccccccccccc;
 
-  // Get the stack trace (as a vector of addresses) from the shared BPF stack trace table.
-  const std::vector<uintptr_t> addrs = stack_traces_->get_stack_addr(stack_id, kClearStackId);
-  VLOG_IF(1, addrs.size() == 0) << absl::Substitute(
-      "[empty_stack_trace] stack_id: $0, upid.pid: $1", stack_id, static_cast<int>(upid.pid));
+  // TODO(jps): re-evaluate the correct amount to reserve here.
+  std::string stack_trace_str;
+  stack_trace_str.reserve(128);
 
   // Build the folded stack trace string.
   for (auto iter = addrs.rbegin(); iter != addrs.rend(); ++iter) {
@@ -73,8 +129,9 @@ std::string Stringifier::BuildStackTraceString(const int stack_id, const struct
   return stack_trace_str;
 }
 
-std::string Stringifier::FindOrBuildStackTraceString(const int stack_id, const struct upid_t& upid,
-                                                     const std::string_view& suffix) {
+const std::string& Stringifier::FindOrBuildStackTraceString(const int stack_id,
+                                                            const struct upid_t& upid,
+                                                            const std::string_view& suffix) {
   // First try to find the memoized result in the stack_trace_strs_ map,
   // if no memoized result is available, build the folded stack trace string.
   auto [iter, inserted] = stack_trace_strs_.try_emplace(stack_id, "");
@@ -18,12 +18,19 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/types/span.h>
 
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
 
+DECLARE_uint64(stirling_profiler_stack_trace_str_cache_size);
+
 namespace px {
 namespace stirling {
 
@@ -41,6 +48,62 @@ static constexpr std::string_view kKernSuffix = "_[k]";
 static constexpr std::string_view kDropMessage = "<stack trace lost>";
 }  // namespace stringifier
 
+// StackTraceStrCache memoizes folded stack trace strings across iterations of the continuous
+// perf. profiler. Stack-ids are indices into a hash table that is cleared on each iteration
+// (and there are two such tables, used alternately), so they are not a stable key on
+// their own. Instead, the cache is keyed by the upid and the stack trace addresses, which
+// are read from the stack traces table anyway; a hit saves symbolizing every address.
+//
+// Entries that are not looked up for a full generation are evicted. A generation also ends
+// early once it holds max_entries entries, so the cache holds at most twice that many.
+class StackTraceStrCache {
+ public:
+  StackTraceStrCache() : StackTraceStrCache(FLAGS_stirling_profiler_stack_trace_str_cache_size) {}
+  explicit StackTraceStrCache(size_t max_entries) : max_entries_(max_entries) {}
+
+  // Returns the memoized stack trace string, or nullptr if there is none.
+  // The returned pointer is only valid until the next call into the cache.
+  const std::string* Lookup(const struct upid_t& upid, const std::vector<uintptr_t>& addrs);
+
+  void Insert(const struct upid_t& upid, std::vector<uintptr_t> addrs, std::string str);
+
+  void CreateNewGeneration() {
+    prev_cache_ = std::move(cache_);
+    cache_.clear();
+  }
+
+  size_t active_entries() const { return cache_.size(); }
+  size_t total_entries() const { return cache_.size() + prev_cache_.size(); }
+
+ private:
+  using Key = std::pair<struct upid_t, std::vector<uintptr_t>>;
+  // Lookups use a view of the addresses, so they don't copy them into a Key.
+  using KeyView = std::pair<struct upid_t, absl::Span<const uintptr_t>>;
+
+  struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(const KeyView& key) const { return absl::Hash<KeyView>{}(key); }
+    size_t operator()(const Key& key) const {
+      return (*this)(KeyView(key.first, absl::MakeConstSpan(key.second)));
+    }
+  };
+
+  struct KeyEq {
+    using is_transparent = void;
+    template <typename TLhs, typename TRhs>
+    bool operator()(const TLhs& lhs, const TRhs& rhs) const {
+      return lhs.first == rhs.first &&
+             absl::MakeConstSpan(lhs.second) == absl::MakeConstSpan(rhs.second);
+    }
+  };
+
+  using Cache = absl::flat_hash_map<Key, std::string, KeyHash, KeyEq>;
+
+  const size_t max_entries_;
+  Cache cache_;
+  Cache prev_cache_;
+};
+
 // Stringifier serves two purposes:
 // 1. constructs a "folded stack trace string" based on the stack frame addresses.
 // 2. memoizes previous results of (1) above in case a "stack-id" is reused
@@ -61,21 +124,30 @@ static constexpr std::string_view kDropMessage = "<stack trace lost>";
 // a destructive read (it read one stack trace, and clears it, from the table).
 // Because of stack-trace-id reuse and the destructive read, the stringifier memoizes
 // its stringified results. A new stringifier is created (and destroyed) on each iteration
-// of the continuous perf. profiler.
+// of the continuous perf. profiler. Results that should outlive the iteration are kept
+// in the optional StackTraceStrCache.
 class Stringifier {
  public:
-  Stringifier(Symbolizer* symbolizer, ebpf::BPFStackTable* stack_traces);
+  Stringifier(Symbolizer* symbolizer, ebpf::BPFStackTable* stack_traces,
+              StackTraceStrCache* stack_trace_str_cache = nullptr);
 
   // Returns a folded stack trace string based on the stack trace histogram key.
   // The key contains both a user & kernel stack-trace-id, which are subsquently
   // passed into FindOrBuildStackTraceString().
   std::string FoldedStackTraceString(const stack_trace_key_t& key);
 
+  // Folds a stack trace (addresses ordered leaf first, as from BPF) into a string, root first.
+  // Also used for stack traces that do not come from BPF, e.g. the allocation samples of tcmalloc.
+  static std::string FoldStackTrace(
+      const std::vector<uintptr_t>& addrs,
+      const std::function<std::string_view(const uintptr_t addr)>& symbolize_fn,
+      std::string_view suffix);
+
  private:
   std::string BuildStackTraceString(const int stack_id, const struct upid_t& upid,
                                     const std::string_view& suffix);
-  std::string FindOrBuildStackTraceString(const int stack_id, const struct upid_t& upid,
-                                          const std::string_view& suffix);
+  const std::string& FindOrBuildStackTraceString(const int stack_id, const struct upid_t& upid,
+                                                 const std::string_view& suffix);
 
   // Memoized results of previous calls to FindOrBuildStackTraceString():
   // a map from stack-trace-id to folded stack trace string.
@@ -90,6 +162,9 @@ class Stringifier {
   // to be explicitly cleared (by re-iterating the histogram) after an iteration
   // of the continuous perf. profiler is completed.
   ebpf::BPFStackTable* const stack_traces_;
+
+  // Memoized stack trace strings from previous profiler iterations; may be null.
+  StackTraceStrCache* const stack_trace_str_cache_;
 };
 
 }  // namespace stirling
@@ -294,6 +294,55 @@ TEST_F(StringifierTest, MemoizationTest) {
   }
 }
 
+TEST(StackTraceStrCacheTest, LookupAndEvict) {
+  const struct upid_t upid = {.pid = 123, .start_time_ticks = 456};
+  const struct upid_t other_upid = {.pid = 123, .start_time_ticks = 789};
+  const std::vector<uintptr_t> addrs = {0x1000, 0x2000, 0x3000};
+
+  StackTraceStrCache cache;
+  EXPECT_EQ(cache.Lookup(upid, addrs), nullptr);
+
+  cache.Insert(upid, addrs, "main;foo;bar");
+  ASSERT_NE(cache.Lookup(upid, addrs), nullptr);
+  EXPECT_EQ(*cache.Lookup(upid, addrs), "main;foo;bar");
+
+  // The same addresses in a different process are a different stack trace.
+  EXPECT_EQ(cache.Lookup(other_upid, addrs), nullptr);
+  EXPECT_EQ(cache.Lookup(upid, {0x1000, 0x2000}), nullptr);
+
+  // A lookup in the previous generation keeps the entry alive.
+  cache.CreateNewGeneration();
+  EXPECT_EQ(cache.active_entries(), 0);
+  ASSERT_NE(cache.Lookup(upid, addrs), nullptr);
+  EXPECT_EQ(cache.active_entries(), 1);
+
+  // Without lookups, the entry is evicted after two generations.
+  cache.CreateNewGeneration();
+  cache.CreateNewGeneration();
+  EXPECT_EQ(cache.total_entries(), 0);
+  EXPECT_EQ(cache.Lookup(upid, addrs), nullptr);
+}
+
+TEST(StackTraceStrCacheTest, BoundedEntries) {
+  const struct upid_t upid = {.pid = 123, .start_time_ticks = 456};
+
+  StackTraceStrCache cache(2);
+  cache.Insert(upid, {0x1000}, "a");
+  cache.Insert(upid, {0x2000}, "b");
+  EXPECT_EQ(cache.active_entries(), 2);
+
+  // A full generation ends early, and the oldest generation is evicted.
+  cache.Insert(upid, {0x3000}, "c");
+  EXPECT_EQ(cache.active_entries(), 1);
+  EXPECT_EQ(cache.total_entries(), 3);
+  cache.Insert(upid, {0x4000}, "d");
+  cache.Insert(upid, {0x5000}, "e");
+  EXPECT_EQ(cache.total_entries(), 3);
+  EXPECT_EQ(cache.Lookup(upid, {0x1000}), nullptr);
+  ASSERT_NE(cache.Lookup(upid, {0x3000}), nullptr);
+  EXPECT_EQ(*cache.Lookup(upid, {0x3000}), "c");
+}
+
 TEST_F(StringifierTest, KernelDropMessageTest) {
   const pid_t pid = getpid();
 
@@ -16,27 +16,81 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <utility>
 
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
 
 DEFINE_bool(stirling_profiler_symcache, true, "Enable the Stirling managed symbol cache.");
+DEFINE_uint64(stirling_profiler_shared_symcache_bytes, 64 * 1024 * 1024,
+              "Memory budget of the symbol cache shared across processes that map the same "
+              "binary. Set to 0 to disable.");
 
 namespace px {
 namespace stirling {
 
 namespace {
+constexpr std::string_view kUnknown = "[UNKNOWN]";
+
+std::string AddrAsSymbol(const uintptr_t addr) { return absl::StrFormat("0x%016llx", addr); }
+
 std::string SymbolOrAddrIfUnknown(ebpf::BPFStackTable* bcc_symbolizer, const uintptr_t addr,
                                   const int pid) {
-  static constexpr std::string_view kUnknown = "[UNKNOWN]";
   std::string sym_or_addr = bcc_symbolizer->get_addr_symbol(addr, pid);
   if (sym_or_addr == kUnknown) {
-    sym_or_addr = absl::StrFormat("0x%016llx", addr);
+    sym_or_addr = AddrAsSymbol(addr);
   }
   return sym_or_addr;
 }
 }  // namespace
 
+const std::string* SharedSymbolCache::Lookup(const Key& key) {
+  const auto iter = cache_.find(key);
+  if (iter != cache_.end()) {
+    return &iter->second;
+  }
+
+  const auto prev_iter = prev_cache_.find(key);
+  if (prev_iter == prev_cache_.end()) {
+    return nullptr;
+  }
+
+  // Promote to the current generation.
+  Key promoted_key = prev_iter->first;
+  std::string symbol = std::move(prev_iter->second);
+  prev_cache_bytes_ -= EntryBytes(promoted_key, symbol);
+  prev_cache_.erase(prev_iter);
+
+  const size_t entry_bytes = EntryBytes(promoted_key, symbol);
+  MaybeCreateNewGeneration(entry_bytes);
+  cache_bytes_ += entry_bytes;
+  const auto [curr_iter, inserted] = cache_.try_emplace(std::move(promoted_key), std::move(symbol));
+  DCHECK(inserted);
+  return &curr_iter->second;
+}
+
+void SharedSymbolCache::Insert(Key key, std::string symbol) {
+  const size_t entry_bytes = EntryBytes(key, symbol);
+  if (entry_bytes > max_bytes_ / 2) {
+    return;
+  }
+  MaybeCreateNewGeneration(entry_bytes);
+  const auto [iter, inserted] = cache_.try_emplace(std::move(key), std::move(symbol));
+  if (inserted) {
+    cache_bytes_ += entry_bytes;
+  }
+}
+
+void SharedSymbolCache::MaybeCreateNewGeneration(size_t entry_bytes) {
+  if (cache_bytes_ + entry_bytes <= max_bytes_ / 2) {
+    return;
+  }
+  prev_cache_ = std::move(cache_);
+  cache_.clear();
+  prev_cache_bytes_ = cache_bytes_;
+  cache_bytes_ = 0;
+}
+
 SymbolCache::Symbol::Symbol(ebpf::BPFStackTable* bcc_symbolizer, const uintptr_t addr,
                             const int pid)
     : symbol_(SymbolOrAddrIfUnknown(bcc_symbolizer, addr, pid)) {}
@@ -53,9 +107,90 @@ SymbolCache::LookupResult SymbolCache::Lookup(const uintptr_t addr) {
     return SymbolCache::LookupResult{curr_cache_iter->second.symbol_, true};
   }
 
-  // If not in old cache, try the new cache (with automatic insertion if required).
-  const auto [iter, inserted] = cache_.try_emplace(addr, symbolizer_, addr, pid_);
-  return SymbolCache::LookupResult{iter->second.symbol_, !inserted};
+  if (shared_cache_ == nullptr) {
+    // If not in old cache, try the new cache (with automatic insertion if required).
+    const auto [iter, inserted] = cache_.try_emplace(addr, symbolizer_, addr, pid_);
+    return SymbolCache::LookupResult{iter->second.symbol_, !inserted};
+  }
+
+  const auto iter = cache_.find(addr);
+  if (iter != cache_.end()) {
+    return SymbolCache::LookupResult{iter->second.symbol_, true};
+  }
+
+  bool shared_hit = false;
+  std::string symbol = ResolveSymbol(addr, &shared_hit);
+  const auto [new_iter, inserted] = cache_.try_emplace(addr, std::move(symbol));
+  DCHECK(inserted);
+  return SymbolCache::LookupResult{new_iter->second.symbol_, false, shared_hit};
+}
+
+std::string SymbolCache::ResolveSymbol(const uintptr_t addr, bool* shared_hit) {
+  const system::ProcParser::ProcessMap* mapping = FindMapping(addr);
+  if (mapping == nullptr) {
+    return SymbolOrAddrIfUnknown(symbolizer_, addr, pid_);
+  }
+
+  SharedSymbolCache::Key key{mapping->dev, mapping->inode,
+                             addr - mapping->vmem_start + mapping->file_offset};
+  const std::string* shared_symbol = shared_cache_->Lookup(key);
+  if (shared_symbol != nullptr) {
+    *shared_hit = true;
+    return *shared_symbol;
+  }
+
+  std::string symbol = symbolizer_->get_addr_symbol(addr, pid_);
+  if (symbol == kUnknown) {
+    // The address fallback is specific to this process, so it is not shared.
+    return AddrAsSymbol(addr);
+  }
+  shared_cache_->Insert(std::move(key), symbol);
+  return symbol;
+}
+
+void SymbolCache::LoadMappings() {
+  std::vector<system::ProcParser::ProcessMap> process_maps;
+  Status s = proc_parser_->ReadProcessMaps(pid_, &process_maps);
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("Could not read maps of pid $0: $1", pid_, s.msg());
+  }
+
+  mappings_.clear();
+  for (auto& process_map : process_maps) {
+    if (process_map.executable() && process_map.inode != 0) {
+      mappings_.push_back(std::move(process_map));
+    }
+  }
+  mappings_loaded_ = true;
+}
+
+const system::ProcParser::ProcessMap* SymbolCache::FindMapping(const uintptr_t addr) {
+  if (!mappings_loaded_) {
+    LoadMappings();
+  }
+
+  auto find = [this](const uintptr_t target) -> const system::ProcParser::ProcessMap* {
+    // First mapping that starts after target; the candidate is the one before it.
+    auto iter = std::upper_bound(
+        mappings_.begin(), mappings_.end(), target,
+        [](const uintptr_t a, const system::ProcParser::ProcessMap& m) {
+          return a < m.vmem_start;
+        });
+    if (iter == mappings_.begin()) {
+      return nullptr;
+    }
+    --iter;
+    return target < iter->vmem_end ? &*iter : nullptr;
+  };
+
+  const system::ProcParser::ProcessMap* mapping = find(addr);
+  if (mapping == nullptr && !mappings_reloaded_) {
+    // The process may have mapped new code (e.g. dlopen()) since the maps were read.
+    mappings_reloaded_ = true;
+    LoadMappings();
+    mapping = find(addr);
+  }
+  return mapping;
 }
 
 Status Symbolizer::Init() {
@@ -66,6 +201,11 @@ Status Symbolizer::Init() {
   const std::string_view kProgram = "BPF_STACK_TRACE(bcc_symbolizer, 16);";
   PL_RETURN_IF_ERROR(InitBPFProgram(kProgram));
   bcc_symbolizer_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("bcc_symbolizer"));
+  if (FLAGS_stirling_profiler_shared_symcache_bytes > 0) {
+    proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
+    shared_symbol_cache_ =
+        std::make_unique<SharedSymbolCache>(FLAGS_stirling_profiler_shared_symcache_bytes);
+  }
   return Status::OK();
 }
 
@@ -98,6 +238,9 @@ std::string_view Symbolizer::Symbolize(SymbolCache* symbol_cache, const int pid,
   if (result.hit) {
     ++stat_hits_;
   }
+  if (result.shared_hit) {
+    ++stat_shared_hits_;
+  }
   return result.symbol;
 }
 
@@ -106,7 +249,12 @@ std::function<std::string_view(const uintptr_t addr)> Symbolizer::GetSymbolizerF
   using std::placeholders::_1;
   const auto [iter, inserted] = symbol_caches_.try_emplace(upid, nullptr);
   if (inserted) {
-    iter->second = std::make_unique<SymbolCache>(upid.pid, bcc_symbolizer_.get());
+    // Kernel addresses are not file-backed, so the kernel does not use the shared cache.
+    const bool use_shared_cache =
+        shared_symbol_cache_ != nullptr && upid.pid != profiler::kKernelPIDAsU32;
+    iter->second = std::make_unique<SymbolCache>(
+        upid.pid, bcc_symbolizer_.get(), use_shared_cache ? proc_parser_.get() : nullptr,
+        use_shared_cache ? shared_symbol_cache_.get() : nullptr);
   }
   auto& cache = iter->second;
   auto fn = std::bind(&Symbolizer::Symbolize, this, cache.get(), upid.pid, _1);
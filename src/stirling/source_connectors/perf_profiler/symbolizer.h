@@ -21,11 +21,14 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "src/common/system/proc_parser.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
 DECLARE_bool(stirling_profiler_symcache);
+DECLARE_uint64(stirling_profiler_shared_symcache_bytes);
 
 namespace px {
 namespace stirling {
@@ -35,13 +38,83 @@ static constexpr uint32_t kKernelPIDAsU32 = ~0;
 static constexpr upid_t kKernelUPID = {.pid = kKernelPIDAsU32, .start_time_ticks = 0};
 }  // namespace profiler
 
+/**
+ * SharedSymbolCache holds symbols keyed by the mapped file and the offset into that file,
+ * rather than by pid and virtual address. Processes that map the same binary (e.g. replicas
+ * of one container image) therefore share the cost of symbolizing it.
+ *
+ * Memory use is bounded by a byte budget, split across two generations: once the current
+ * generation fills half of the budget, the previous generation is dropped. Entries found in
+ * the previous generation are promoted to the current one.
+ */
+class SharedSymbolCache {
+ public:
+  struct Key {
+    // Device and inode of the mapped file, as listed in /proc/<pid>/maps.
+    std::string dev;
+    uint64_t inode;
+    // Offset of the address into the mapped file.
+    uint64_t file_offset;
+
+    bool operator==(const Key& other) const {
+      return inode == other.inode && file_offset == other.file_offset && dev == other.dev;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.dev, key.inode, key.file_offset);
+    }
+  };
+
+  explicit SharedSymbolCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /**
+   * Returns the cached symbol, or nullptr if there is none.
+   * The returned pointer is only valid until the next call into the cache.
+   */
+  const std::string* Lookup(const Key& key);
+
+  void Insert(Key key, std::string symbol);
+
+  size_t entries() const { return cache_.size() + prev_cache_.size(); }
+  size_t bytes() const { return cache_bytes_ + prev_cache_bytes_; }
+
+ private:
+  static size_t EntryBytes(const Key& key, const std::string& symbol) {
+    return sizeof(Key) + key.dev.size() + sizeof(std::string) + symbol.size();
+  }
+
+  // Moves the current generation to the previous one (dropping the latter),
+  // if adding entry_bytes would exceed the current generation's half of the budget.
+  void MaybeCreateNewGeneration(size_t entry_bytes);
+
+  const size_t max_bytes_;
+  absl::flat_hash_map<Key, std::string> cache_;
+  absl::flat_hash_map<Key, std::string> prev_cache_;
+  size_t cache_bytes_ = 0;
+  size_t prev_cache_bytes_ = 0;
+};
+
 class SymbolCache {
  public:
-  SymbolCache(int pid, ebpf::BPFStackTable* symbolizer) : pid_(pid), symbolizer_(symbolizer) {}
+  /**
+   * If proc_parser and shared_cache are provided, local misses for addresses inside
+   * file-backed executable mappings are resolved through the shared cache.
+   */
+  SymbolCache(int pid, ebpf::BPFStackTable* symbolizer,
+              const system::ProcParser* proc_parser = nullptr,
+              SharedSymbolCache* shared_cache = nullptr)
+      : pid_(pid),
+        symbolizer_(symbolizer),
+        proc_parser_(proc_parser),
+        shared_cache_(shared_cache) {}
 
   struct LookupResult {
     std::string_view symbol;
+    // True if found in this (per-pid) cache.
     bool hit;
+    // True if missed in this cache, but found in the shared cache.
+    bool shared_hit = false;
   };
 
   LookupResult Lookup(const uintptr_t addr);
@@ -52,6 +125,7 @@ class SymbolCache {
   void CreateNewGeneration() {
     prev_cache_ = std::move(cache_);
     cache_.clear();
+    mappings_reloaded_ = false;
   }
 
  private:
@@ -68,10 +142,25 @@ class SymbolCache {
     std::string symbol_;
   };
 
+  // Resolves a local miss through the shared cache, falling back to BCC.
+  std::string ResolveSymbol(const uintptr_t addr, bool* shared_hit);
+
+  // Returns the file-backed executable mapping containing addr, or nullptr if there is none.
+  // The mappings are read lazily, and re-read at most once per generation on a miss.
+  const system::ProcParser::ProcessMap* FindMapping(const uintptr_t addr);
+  void LoadMappings();
+
   int pid_;
   ebpf::BPFStackTable* symbolizer_;
+  const system::ProcParser* proc_parser_;
+  SharedSymbolCache* shared_cache_;
   absl::flat_hash_map<uintptr_t, Symbol> cache_;
   absl::flat_hash_map<uintptr_t, Symbol> prev_cache_;
+
+  // File-backed executable mappings of pid_, sorted by vmem_start.
+  std::vector<system::ProcParser::ProcessMap> mappings_;
+  bool mappings_loaded_ = false;
+  bool mappings_reloaded_ = false;
 };
 
 /**
@@ -83,6 +172,10 @@ class SymbolCache {
  * Symbolizer creates a 'bpf stack table' solely to gain access to the BCC
  * symbolization API (the underlying BPF shared map and BPF program are not used).
  *
+ * Behind the per-pid caches, a SharedSymbolCache (sized by
+ * FLAGS_stirling_profiler_shared_symcache_bytes) is shared by all user space processes,
+ * and is not affected by FlushCache().
+ *
  * A typical use case looks like this:
  *   auto symbolize_fn = symbolizer.GetSymbolizerFn(upid);
  *   const std::string symbol = symbolize_fn(addr);
@@ -97,6 +190,7 @@ class Symbolizer : public bpf_tools::BCCWrapper, public NotCopyMoveable {
 
   int64_t stat_accesses() { return stat_accesses_; }
   int64_t stat_hits() { return stat_hits_; }
+  int64_t stat_shared_hits() { return stat_shared_hits_; }
 
  private:
   std::string_view Symbolize(SymbolCache* symbol_cache, const int pid, const uintptr_t addr);
@@ -107,8 +201,12 @@ class Symbolizer : public bpf_tools::BCCWrapper, public NotCopyMoveable {
 
   absl::flat_hash_map<struct upid_t, std::unique_ptr<SymbolCache>> symbol_caches_;
 
+  std::unique_ptr<system::ProcParser> proc_parser_;
+  std::unique_ptr<SharedSymbolCache> shared_symbol_cache_;
+
   int64_t stat_accesses_ = 0;
   int64_t stat_hits_ = 0;
+  int64_t stat_shared_hits_ = 0;
 };
 
 }  // namespace stirling
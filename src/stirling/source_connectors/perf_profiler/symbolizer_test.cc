@@ -126,6 +126,64 @@ TEST_F(SymbolCacheTest, EvictOldEntries) {
   EXPECT_EQ(sym_cache.active_entries(), 1);
 }
 
+TEST_F(SymbolCacheTest, SharedAcrossCaches) {
+  system::ProcParser proc_parser(system::Config::GetInstance());
+  SharedSymbolCache shared_cache(1024 * 1024);
+
+  // Two caches for the same pid stand in for two processes mapping the same binary.
+  SymbolCache sym_cache_a(getpid(), bcc_symbolizer_.get(), &proc_parser, &shared_cache);
+  SymbolCache sym_cache_b(getpid(), bcc_symbolizer_.get(), &proc_parser, &shared_cache);
+
+  SymbolCache::LookupResult result;
+
+  result = sym_cache_a.Lookup(kFooAddr);
+  EXPECT_EQ(result.hit, false);
+  EXPECT_EQ(result.shared_hit, false);
+  EXPECT_EQ(result.symbol, "test::foo()");
+  EXPECT_EQ(shared_cache.entries(), 1);
+
+  result = sym_cache_b.Lookup(kFooAddr);
+  EXPECT_EQ(result.hit, false);
+  EXPECT_EQ(result.shared_hit, true);
+  EXPECT_EQ(result.symbol, "test::foo()");
+
+  // The shared cache outlives the generations of the per-pid caches.
+  sym_cache_b.CreateNewGeneration();
+  sym_cache_b.CreateNewGeneration();
+  result = sym_cache_b.Lookup(kFooAddr);
+  EXPECT_EQ(result.hit, false);
+  EXPECT_EQ(result.shared_hit, true);
+  EXPECT_EQ(result.symbol, "test::foo()");
+}
+
+TEST(SharedSymbolCacheTest, EvictsByBytes) {
+  const std::string kSymbol(100, 'x');
+  const SharedSymbolCache::Key kKey0{"103:02", 1, 0};
+  const SharedSymbolCache::Key kKey1{"103:02", 1, 16};
+  const SharedSymbolCache::Key kKey2{"103:02", 1, 32};
+
+  // Each generation has room for a single entry.
+  const size_t kEntryBytes =
+      sizeof(SharedSymbolCache::Key) + kKey0.dev.size() + sizeof(std::string) + kSymbol.size();
+  SharedSymbolCache shared_cache(2 * kEntryBytes);
+
+  shared_cache.Insert(kKey0, kSymbol);
+  shared_cache.Insert(kKey1, kSymbol);
+  EXPECT_EQ(shared_cache.entries(), 2);
+  EXPECT_EQ(shared_cache.bytes(), 2 * kEntryBytes);
+
+  // Looking up kKey0 promotes it to the current generation, pushing kKey1 to the previous one.
+  ASSERT_NE(shared_cache.Lookup(kKey0), nullptr);
+  EXPECT_EQ(*shared_cache.Lookup(kKey0), kSymbol);
+
+  // Inserting kKey2 drops the previous generation, and with it kKey1.
+  shared_cache.Insert(kKey2, kSymbol);
+  EXPECT_EQ(shared_cache.entries(), 2);
+  EXPECT_EQ(shared_cache.bytes(), 2 * kEntryBytes);
+  EXPECT_NE(shared_cache.Lookup(kKey2), nullptr);
+  EXPECT_EQ(shared_cache.Lookup(kKey1), nullptr);
+}
+
 // Test the symbolizer with caching enabled and disabled.
 TEST(SymbolizerTest, Basic) {
   // TODO(jps): consider splitting into 3 tests:
@@ -27,23 +27,81 @@
 
 #include "src/stirling/source_connectors/pid_runtime/bcc_bpf_intf/pidruntime.h"
 
-BPF_HASH(pid_cpu_time, uint16_t, struct pidruntime_val_t);
+// When each thread that is on a CPU was switched in, by thread ID.
+BPF_HASH(oncpu_start_ns, uint32_t, uint64_t, kMaxOnCPUThreads);
 
+// The run times of the processes, by TGID, since user space last drained the map.
+// See kPIDRuntimeTransferCountIdx for which map BPF writes to.
+BPF_HASH(pid_cpu_time_a, uint32_t, struct pidruntime_val_t, kMaxPIDRuntimeEntries);
+BPF_HASH(pid_cpu_time_b, uint32_t, struct pidruntime_val_t, kMaxPIDRuntimeEntries);
+
+BPF_ARRAY(pidruntime_state, uint64_t, 1);
+
+// Adds run_time to the process that is on the CPU.
+static __inline void account_run_time(uint64_t now, uint64_t run_time) {
+  uint32_t transfer_count_idx = kPIDRuntimeTransferCountIdx;
+  uint64_t* transfer_count = pidruntime_state.lookup(&transfer_count_idx);
+  if (transfer_count == NULL) {
+    return;
+  }
+
+  uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
+  struct pidruntime_val_t new_val = {};
+  struct pidruntime_val_t* val = NULL;
+  if (*transfer_count % 2 == 0) {
+    val = pid_cpu_time_a.lookup_or_init(&tgid, &new_val);
+  } else {
+    val = pid_cpu_time_b.lookup_or_init(&tgid, &new_val);
+  }
+  if (val == NULL) {
+    return;
+  }
+
+  if (val->timestamp == 0) {
+    bpf_get_current_comm(&val->name, sizeof(val->name));
+  }
+  // Threads of the same process can be accounted on several CPUs at once.
+  __sync_fetch_and_add(&val->run_time, run_time);
+  val->timestamp = now;
+}
+
+// Sampling probe, run on every CPU each kPIDRuntimeSamplingPeriodMillis.
+// Credits the whole period to the process that is on the CPU. This is the default, since it is
+// cheaper than running on every context switch.
 int trace_pid_runtime(struct pt_regs* ctx) {
-  uint16_t cur_pid = bpf_get_current_pid_tgid() >> 32;
+  if ((bpf_get_current_pid_tgid() >> 32) == 0) {
+    // The idle task.
+    return 0;
+  }
+  account_run_time(bpf_ktime_get_ns(), kPIDRuntimeSamplingPeriodMillis * 1000 * 1000);
+  return 0;
+}
 
-  struct pidruntime_val_t* cur_val = pid_cpu_time.lookup(&cur_pid);
-  uint64_t cur_ts = bpf_ktime_get_ns();
+// Tracepoint: sched:sched_switch
+// Accounts the time that the previous task ran to its process, which is exact but runs on every
+// context switch. Used with --stirling_pid_runtime_sched_switch.
+int probe_sched_switch(struct tracepoint__sched__sched_switch* args) {
+  uint64_t now = bpf_ktime_get_ns();
+  uint32_t prev_tid = args->prev_pid;
+  uint32_t next_tid = args->next_pid;
 
-  if (cur_val) {
-    // Only update the timestamp and run_time.
-    cur_val->run_time += cur_ts - cur_val->timestamp;
-    cur_val->timestamp = cur_ts;
+  // The idle tasks of all CPUs have thread ID 0, and are not accounted.
+  if (next_tid != 0) {
+    oncpu_start_ns.update(&next_tid, &now);
+  }
+  if (prev_tid == 0) {
     return 0;
   }
-  // Create a new entry.
-  struct pidruntime_val_t new_val = {.timestamp = cur_ts, .run_time = 0};
-  bpf_get_current_comm(&new_val.name, sizeof(new_val.name));
-  pid_cpu_time.update(&cur_pid, &new_val);
+
+  uint64_t* start_ns = oncpu_start_ns.lookup(&prev_tid);
+  if (start_ns == NULL) {
+    // The thread was switched in before the probe was attached.
+    return 0;
+  }
+  uint64_t run_time = now - *start_ns;
+  oncpu_start_ns.delete(&prev_tid);
+
+  // The tracepoint runs in the context of the previous task.
+  account_run_time(now, run_time);
   return 0;
 }
@@ -18,9 +18,26 @@
 
 #pragma once
 
+// The index of the transfer count in pidruntime_state, which user space increments every time it
+// reads the run times. BPF adds to pid_cpu_time_a while it is even and to pid_cpu_time_b while it
+// is odd, so user space drains the map that BPF isn't writing to.
+static const uint32_t kPIDRuntimeTransferCountIdx = 0;
+
+// How often the sampling probe credits the process on each CPU with the run time.
+static const uint64_t kPIDRuntimeSamplingPeriodMillis = 99;
+
+// The capacity of each of the run time maps: the processes that ran in one sampling period.
+static const uint32_t kMaxPIDRuntimeEntries = 16384;
+
+// The capacity of the map of threads that are on a CPU, which only needs one entry per CPU, but
+// also holds the entries of threads that exited while running.
+static const uint32_t kMaxOnCPUThreads = 4096;
+
 // TASK_COMM_LEN seems to be undefined so hardcoding to 16 for now.
 struct pidruntime_val_t {
+  // When the process was last accounted.
   uint64_t timestamp;
+  // The time the process ran since user space last read the map.
   uint64_t run_time;
   char name[16];
 };
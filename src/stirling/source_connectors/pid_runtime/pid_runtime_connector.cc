@@ -18,11 +18,19 @@
 
 #include "src/stirling/source_connectors/pid_runtime/pid_runtime_connector.h"
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bpf_map.h"
 #include "src/stirling/bpf_tools/macros.h"
 
+DEFINE_bool(stirling_pid_runtime_sched_switch, false,
+            "If true, account the run time of processes on every context switch, which is exact, "
+            "instead of sampling the processes on each CPU.");
+
 BPF_SRC_STRVIEW(pidruntime_bcc_script, pidruntime);
 
 namespace px {
@@ -32,7 +40,18 @@ Status PIDRuntimeConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
   PL_RETURN_IF_ERROR(InitBPFProgram(pidruntime_bcc_script));
-  PL_RETURN_IF_ERROR(AttachSamplingProbes(kSamplingProbes));
+  if (FLAGS_stirling_pid_runtime_sched_switch) {
+    PL_RETURN_IF_ERROR(AttachTracepoints(kTracepointSpecs));
+  } else {
+    PL_RETURN_IF_ERROR(AttachSamplingProbes(kSamplingProbes));
+  }
+
+  pid_cpu_time_a_ = std::make_unique<ebpf::BPFHashTable<uint32_t, pidruntime_val_t>>(
+      GetHashTable<uint32_t, pidruntime_val_t>("pid_cpu_time_a"));
+  pid_cpu_time_b_ = std::make_unique<ebpf::BPFHashTable<uint32_t, pidruntime_val_t>>(
+      GetHashTable<uint32_t, pidruntime_val_t>("pid_cpu_time_b"));
+  pidruntime_state_ = std::make_unique<ebpf::BPFArrayTable<uint64_t>>(
+      GetArrayTable<uint64_t>("pidruntime_state"));
   return Status::OK();
 }
 
@@ -50,30 +69,26 @@ void PIDRuntimeConnector::TransferDataImpl(ConnectorContext* /* ctx */,
     return;
   }
 
-  std::vector<std::pair<uint16_t, pidruntime_val_t>> items =
-      GetHashTable<uint16_t, pidruntime_val_t>("pid_cpu_time").get_table_offline();
+  // Switch BPF to the other map before draining this one, so the drain doesn't race with BPF.
+  auto& pid_cpu_time = transfer_count_ % 2 == 0 ? pid_cpu_time_a_ : pid_cpu_time_b_;
+  ++transfer_count_;
+  const ebpf::StatusTuple s =
+      pidruntime_state_->update_value(kPIDRuntimeTransferCountIdx, transfer_count_);
+  LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
-  for (auto& item : items) {
-    // TODO(kgandhi): PL-460 Consider using other types of BPF tables to avoid a searching through
-    // a map for the previously recorded run-time. Alternatively, calculate delta in the bpf code
-    // if that is more efficient.
-    auto it = prev_run_time_map_.find({item.first});
-    uint64_t prev_run_time = 0;
-    if (it == prev_run_time_map_.end()) {
-      prev_run_time_map_.insert({item.first, item.second.run_time});
-    } else {
-      prev_run_time = it->second;
-    }
+  // The map only holds the processes that ran since the last drain, with their run time over
+  // that interval, so reading it also resets it.
+  std::vector<std::pair<uint32_t, pidruntime_val_t>> items =
+      bpf_tools::ReadHashTable(pid_cpu_time.get(), /*clear_table*/ true);
 
+  for (auto& item : items) {
     uint64_t time = item.second.timestamp + ClockRealTimeOffset();
 
     DataTable::RecordBuilder<&kTable> r(data_table, time);
     r.Append<r.ColIndex("time_")>(time);
     r.Append<r.ColIndex("pid")>(item.first);
-    r.Append<r.ColIndex("runtime_ns")>(item.second.run_time - prev_run_time);
+    r.Append<r.ColIndex("runtime_ns")>(item.second.run_time);
     r.Append<r.ColIndex("cmd")>(item.second.name);
-
-    prev_run_time_map_[item.first] = item.second.run_time;
   }
 }
 
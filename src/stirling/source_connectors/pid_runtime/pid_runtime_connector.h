@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -70,12 +69,21 @@ class PIDRuntimeConnector : public SourceConnector, public bpf_tools::BCCWrapper
       : SourceConnector(name, kTables), bpf_tools::BCCWrapper() {}
 
  private:
-  // Freq. (in Hz) at which to trigger bpf func.
-  static constexpr uint64_t kSamplingFreqHz = 99;
-  static constexpr auto kSamplingProbes =
-      MakeArray<bpf_tools::SamplingProbeSpec>({"trace_pid_runtime", kSamplingFreqHz});
+  static constexpr auto kSamplingProbes = MakeArray<bpf_tools::SamplingProbeSpec>(
+      {"trace_pid_runtime", kPIDRuntimeSamplingPeriodMillis});
 
-  std::map<uint16_t, uint64_t> prev_run_time_map_;
+  // With --stirling_pid_runtime_sched_switch, run time is accounted on every context switch.
+  inline static const auto kTracepointSpecs = MakeArray<bpf_tools::TracepointSpec>({
+      {"sched:sched_switch", "probe_sched_switch"},
+  });
+
+  // data structures shared with BPF:
+  std::unique_ptr<ebpf::BPFHashTable<uint32_t, pidruntime_val_t>> pid_cpu_time_a_;
+  std::unique_ptr<ebpf::BPFHashTable<uint32_t, pidruntime_val_t>> pid_cpu_time_b_;
+  std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> pidruntime_state_;
+
+  // Number of iterations, where each iteration drains the run times accumulated in BPF.
+  uint64_t transfer_count_ = 0;
 };
 
 }  // namespace stirling
@@ -23,10 +23,23 @@
 #include <iostream>
 #include <string>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/common/system/cgroup_stats.h"
 #include "src/common/system/proc_parser.h"
 #include "src/shared/metadata/metadata.h"
 
+DEFINE_bool(stirling_process_stats_cgroup_v2, false,
+            "If true, read the stats of each container from its cgroup v2 into container_stats, "
+            "and only collect the stats of each process every "
+            "--stirling_process_stats_per_process_period sampling periods. Ignored on hosts "
+            "without a cgroup v2 hierarchy.");
+DEFINE_int32(stirling_process_stats_per_process_period, 10,
+             "In cgroup v2 mode, the number of sampling periods between collections of the "
+             "per-process stats. 0 disables the per-process stats.");
+
 namespace px {
 namespace stirling {
 
@@ -35,6 +48,19 @@ using system::ProcParser;
 Status ProcessStatsConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+
+  if (FLAGS_stirling_process_stats_cgroup_v2) {
+    // The root of a cgroup v2 hierarchy lists the available controllers.
+    const std::filesystem::path controllers =
+        sysconfig_.sysfs_path() / "fs/cgroup/cgroup.controllers";
+    if (fs::Exists(controllers).ok()) {
+      use_cgroup_v2_ = true;
+    } else {
+      LOG(WARNING) << absl::Substitute(
+          "$0 not found, reading the stats of every process from /proc instead of cgroup v2.",
+          controllers.string());
+    }
+  }
   return Status::OK();
 }
 
@@ -42,32 +68,32 @@ Status ProcessStatsConnector::StopImpl() { return Status::OK(); }
 
 void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
                                                       DataTable* data_table) {
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
 
   int64_t timestamp = CurrentTimeNS();
 
+  upids_.clear();
+  pids_.clear();
   for (const auto& [upid, pid_info] : pid_info_by_upid) {
     // TODO(zasgar): Fix condition for dead pids after helper function is added.
     if (pid_info == nullptr || pid_info->stop_time_ns() > 0) {
       // PID has been stopped.
       continue;
     }
+    upids_.push_back(upid);
+    pids_.push_back(upid.pid());
+  }
 
-    ProcParser::ProcessStats stats;
-    int32_t pid = upid.pid();
-    // TODO(zasgar): We should double check the process start time to make sure it still the same
-    // PID.
-    auto s1 = proc_parser_->ParseProcPIDStat(pid, &stats);
-    if (!s1.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to fetch cpu stat info for PID ($0). Error=\"$1\" skipping.", pid, s1.msg());
-      continue;
-    }
+  // TODO(zasgar): We should double check the process start time to make sure it still the same
+  // PID.
+  stats_reader_->ReadProcessStatsBatch(pids_, &stats_, &statuses_);
 
-    auto s2 = proc_parser_->ParseProcPIDStatIO(pid, &stats);
-    if (!s2.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to fetch IO stat info for PID ($0). Error=\"$1\" skipping.", pid, s2.msg());
+  for (size_t i = 0; i < upids_.size(); ++i) {
+    const md::UPID& upid = upids_[i];
+    const ProcParser::ProcessStats& stats = stats_[i];
+    if (!statuses_[i].ok()) {
+      VLOG(1) << absl::Substitute("Failed to fetch stats for PID ($0). Error=\"$1\" skipping.",
+                                  pids_[i], statuses_[i].msg());
       continue;
     }
 
@@ -92,17 +118,106 @@ void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
   }
 }
 
+StatusOr<std::filesystem::path> ProcessStatsConnector::CGroupPathForContainer(
+    const md::ContainerInfo& container_info) {
+  auto iter = container_cgroup_paths_.find(container_info.cid());
+  if (iter != container_cgroup_paths_.end()) {
+    return iter->second;
+  }
+  // All the processes of a container are in its cgroup, so one read is enough.
+  for (const auto& upid : container_info.active_upids()) {
+    StatusOr<std::filesystem::path> cgroup_path =
+        system::CGroupV2PathForPID(sysconfig_, upid.pid());
+    if (cgroup_path.ok()) {
+      container_cgroup_paths_[container_info.cid()] = cgroup_path.ValueOrDie();
+      return cgroup_path;
+    }
+  }
+  return error::NotFound("Failed to find the cgroup of container $0", container_info.cid());
+}
+
+void ProcessStatsConnector::TransferContainerStatsTable(ConnectorContext* ctx,
+                                                        DataTable* data_table) {
+  const md::K8sMetadataState& k8s_md = ctx->GetK8SMetadata();
+
+  int64_t timestamp = CurrentTimeNS();
+
+  absl::flat_hash_set<std::string_view> live_container_ids;
+  for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
+    PL_UNUSED(pod_name);
+
+    auto* pod_info = k8s_md.PodInfoByID(pod_id);
+    if (pod_info == nullptr || pod_info->stop_time_ns() > 0) {
+      continue;
+    }
+
+    for (const auto& container_id : pod_info->containers()) {
+      auto* container_info = k8s_md.ContainerInfoByID(container_id);
+      if (container_info == nullptr || container_info->stop_time_ns() > 0) {
+        continue;
+      }
+      live_container_ids.insert(container_info->cid());
+
+      StatusOr<std::filesystem::path> cgroup_path = CGroupPathForContainer(*container_info);
+      if (!cgroup_path.ok()) {
+        VLOG(1) << cgroup_path.msg();
+        continue;
+      }
+      Status s = system::ReadCGroupStats(cgroup_path.ValueOrDie(), &cgroup_stats_);
+      if (!s.ok()) {
+        VLOG(1) << absl::Substitute("Failed to read the cgroup stats of container $0: $1",
+                                    container_id, s.msg());
+        // The container may have been restarted in a new cgroup, so resolve it again.
+        container_cgroup_paths_.erase(container_info->cid());
+        continue;
+      }
+
+      DataTable::RecordBuilder<&kContainerStatsTable> r(data_table, timestamp);
+      r.Append<r.ColIndex("time_")>(timestamp);
+      r.Append<r.ColIndex("container_id")>(std::string(container_info->cid()));
+      r.Append<r.ColIndex("pod_id")>(std::string(pod_id));
+      r.Append<r.ColIndex("major_faults")>(cgroup_stats_.major_faults);
+      r.Append<r.ColIndex("minor_faults")>(cgroup_stats_.minor_faults);
+      r.Append<r.ColIndex("cpu_utime_ns")>(cgroup_stats_.utime_ns);
+      r.Append<r.ColIndex("cpu_ktime_ns")>(cgroup_stats_.ktime_ns);
+      r.Append<r.ColIndex("anon_bytes")>(cgroup_stats_.anon_bytes);
+      r.Append<r.ColIndex("file_bytes")>(cgroup_stats_.file_bytes);
+      r.Append<r.ColIndex("read_bytes")>(cgroup_stats_.read_bytes);
+      r.Append<r.ColIndex("write_bytes")>(cgroup_stats_.write_bytes);
+    }
+  }
+
+  // Forget the containers that stopped.
+  for (auto it = container_cgroup_paths_.begin(); it != container_cgroup_paths_.end();) {
+    if (!live_container_ids.contains(it->first)) {
+      container_cgroup_paths_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void ProcessStatsConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
-  DCHECK_EQ(data_tables.size(), 1);
+  DCHECK_EQ(data_tables.size(), kTables.size());
 
-  auto* data_table = data_tables[0];
+  const uint64_t sample_count = sample_count_++;
 
-  if (data_table == nullptr) {
+  if (!use_cgroup_v2_) {
+    if (data_tables[kProcStatsTableNum] != nullptr) {
+      TransferProcessStatsTable(ctx, data_tables[kProcStatsTableNum]);
+    }
     return;
   }
 
-  TransferProcessStatsTable(ctx, data_table);
+  if (data_tables[kContainerStatsTableNum] != nullptr) {
+    TransferContainerStatsTable(ctx, data_tables[kContainerStatsTableNum]);
+  }
+  const int per_process_period = FLAGS_stirling_process_stats_per_process_period;
+  if (data_tables[kProcStatsTableNum] != nullptr && per_process_period > 0 &&
+      sample_count % per_process_period == 0) {
+    TransferProcessStatsTable(ctx, data_tables[kProcStatsTableNum]);
+  }
 }
 
 }  // namespace stirling
@@ -18,12 +18,15 @@
 
 #pragma once
 
+#include <filesystem>
 #include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
@@ -34,13 +37,23 @@
 namespace px {
 namespace stirling {
 
+/**
+ * Collects the CPU, memory and IO stats of the processes of the node.
+ *
+ * By default, the stat and io files of every process are read each sampling period. In cgroup v2
+ * mode (--stirling_process_stats_cgroup_v2), the totals of each container are read from the
+ * cpu.stat, memory.stat and io.stat files of its cgroup into container_stats instead, and the
+ * per-process rows are only collected every --stirling_process_stats_per_process_period sampling
+ * periods.
+ */
 class ProcessStatsConnector : public SourceConnector {
  public:
   static constexpr std::string_view kName = "process_stats";
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{1000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
-  static constexpr auto kTables = MakeArray(kProcessStatsTable);
+  static constexpr auto kTables = MakeArray(kProcessStatsTable, kContainerStatsTable);
   static constexpr uint32_t kProcStatsTableNum = TableNum(kTables, kProcessStatsTable);
+  static constexpr uint32_t kContainerStatsTableNum = TableNum(kTables, kContainerStatsTable);
 
   ProcessStatsConnector() = delete;
   ~ProcessStatsConnector() override = default;
@@ -58,13 +71,33 @@ class ProcessStatsConnector : public SourceConnector {
  protected:
   explicit ProcessStatsConnector(std::string_view source_name)
       : SourceConnector(source_name, kTables) {
-    proc_parser_ = std::make_unique<system::ProcParser>(sysconfig_);
+    stats_reader_ = std::make_unique<system::ProcessStatsReader>(sysconfig_);
   }
 
  private:
   void TransferProcessStatsTable(ConnectorContext* ctx, DataTable* data_table);
+  void TransferContainerStatsTable(ConnectorContext* ctx, DataTable* data_table);
+
+  // Returns the cgroup directory of the container, which is resolved once per container.
+  StatusOr<std::filesystem::path> CGroupPathForContainer(const md::ContainerInfo& container_info);
+
+  std::unique_ptr<system::ProcessStatsReader> stats_reader_;
+
+  // Whether the container stats are read from cgroup v2, and the per-process stats less often.
+  bool use_cgroup_v2_ = false;
+
+  // Number of sampling periods so far, to pace the per-process rows in cgroup v2 mode.
+  uint64_t sample_count_ = 0;
+
+  // The cgroup directory of each live container that has been read.
+  absl::flat_hash_map<std::string, std::filesystem::path> container_cgroup_paths_;
+  system::CGroupStats cgroup_stats_;
 
-  std::unique_ptr<system::ProcParser> proc_parser_;
+  // Reused across iterations, to avoid reallocating them on every sampling period.
+  std::vector<md::UPID> upids_;
+  std::vector<pid_t> pids_;
+  std::vector<system::ProcParser::ProcessStats> stats_;
+  std::vector<Status> statuses_;
 };
 
 }  // namespace stirling
@@ -71,6 +71,41 @@ constexpr DataTableSchema kProcessStatsTable(
 // clang-format on
 DEFINE_PRINT_TABLE(ProcessStats)
 
+// clang-format off
+static constexpr DataElement kContainerStatsElements[] = {
+        canonical_data_elements::kTime,
+        {"container_id", "The ID of the container",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        {"pod_id", "The ID of the pod of the container",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        {"major_faults", "Number of major page faults of the container",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"minor_faults", "Number of minor page faults of the container",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"cpu_utime_ns", "Time spent on user space by the container",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_COUNTER},
+        {"cpu_ktime_ns", "Time spent on kernel by the container",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_COUNTER},
+        {"anon_bytes", "Anonymous memory in bytes of the container",
+         types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_GAUGE},
+        {"file_bytes", "Page cache memory in bytes of the container",
+         types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_GAUGE},
+        {"read_bytes", "IO reads from block devices in bytes of the container",
+         types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_COUNTER},
+        {"write_bytes", "IO writes to block devices in bytes of the container",
+         types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_COUNTER},
+};
+
+constexpr DataTableSchema kContainerStatsTable(
+    "container_stats",
+    "CPU, memory and IO stats for all K8s containers in your cluster, from their cgroups.",
+    kContainerStatsElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(ContainerStats)
+
 // TODO(oazizi): Enable version below, once rest of the agent supports tabletization.
 //               Can't enable yet because it would result in time-scrambling.
 //  static constexpr std::string_view kProcessStatsTabletizationKey = "upid";
@@ -30,9 +30,8 @@
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/go_grpc_types.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
 
-#define MAX_HEADER_COUNT 64
-
 BPF_PERF_OUTPUT(go_grpc_header_events);
+BPF_PERF_OUTPUT(go_grpc_header_block_events);
 BPF_PERF_OUTPUT(go_grpc_data_events);
 
 // BPF programs are limited to a 512-byte stack. We store this value per CPU
@@ -43,6 +42,12 @@ static __inline struct go_grpc_data_event_t* get_data_event() {
   return data_event_buffer_heap.lookup(&kZero);
 }
 
+BPF_PERCPU_ARRAY(header_block_event_buffer_heap, struct go_grpc_http2_header_block_event_t, 1);
+static __inline struct go_grpc_http2_header_block_event_t* get_header_block_event() {
+  uint32_t kZero = 0;
+  return header_block_event_buffer_heap.lookup(&kZero);
+}
+
 // Maps that communicates the location of symbols within a binary.
 //   Key: TGID
 //   Value: Symbol addresses for the binary with that TGID.
@@ -174,7 +179,8 @@ static __inline void copy_header_field(struct header_field_t* dst, struct gostri
   }
 }
 
-static __inline void fill_header_field(struct go_grpc_http2_header_event_t* event,
+static __inline void fill_header_field(struct header_field_t* name_dst,
+                                       struct header_field_t* value_dst,
                                        const void* header_field_ptr,
                                        const struct go_http2_symaddrs_t* symaddrs) {
   struct gostring name;
@@ -185,8 +191,8 @@ static __inline void fill_header_field(struct go_grpc_http2_header_event_t* even
   bpf_probe_read(&value, sizeof(struct gostring),
                  header_field_ptr + symaddrs->HeaderField_Value_offset);
 
-  copy_header_field(&event->name, &name);
-  copy_header_field(&event->value, &value);
+  copy_header_field(name_dst, &name);
+  copy_header_field(value_dst, &value);
 }
 
 static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t probe_type,
@@ -199,29 +205,42 @@ static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t
     return;
   }
 
-  struct go_grpc_http2_header_event_t event = {};
-  event.attr.probe_type = probe_type;
-  event.attr.type = type;
-  event.attr.timestamp_ns = bpf_ktime_get_ns();
-  event.attr.conn_id = conn_info->conn_id;
-  event.attr.stream_id = stream_id;
+  const uint32_t num_fields = fields.len < MAX_HEADER_BLOCK_FIELDS ? fields.len
+                                                                   : MAX_HEADER_BLOCK_FIELDS;
+  if (num_fields == 0 && !end_stream) {
+    return;
+  }
+
+  // The whole header block is sent as one event, built in a per-CPU buffer since it doesn't fit
+  // on the stack.
+  struct go_grpc_http2_header_block_event_t* event = get_header_block_event();
+  if (event == NULL) {
+    return;
+  }
+
+  event->attr.probe_type = probe_type;
+  event->attr.type = type;
+  event->attr.timestamp_ns = bpf_ktime_get_ns();
+  event->attr.conn_id = conn_info->conn_id;
+  event->attr.stream_id = stream_id;
+  event->attr.end_stream = end_stream;
+  event->num_fields = num_fields;
 
   // TODO(oazizi): Replace this constant with information from DWARF.
   const int kSizeOfHeaderField = 40;
 #pragma unroll
-  for (unsigned int i = 0; i < MAX_HEADER_COUNT; ++i) {
-    if (i < fields.len) {
-      fill_header_field(&event, fields.ptr + i * kSizeOfHeaderField, symaddrs);
-      go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+  for (unsigned int i = 0; i < MAX_HEADER_BLOCK_FIELDS; ++i) {
+    if (i < num_fields) {
+      fill_header_field(&event->fields[i].name, &event->fields[i].value,
+                        fields.ptr + i * kSizeOfHeaderField, symaddrs);
     }
   }
 
-  // If end of stream, send one extra empty header with end-stream flag set.
-  if (end_stream) {
-    event.name.size = 0;
-    event.value.size = 0;
-    event.attr.end_stream = true;
-    go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+  // Only submit the fields that were filled in.
+  const size_t size = offsetof(struct go_grpc_http2_header_block_event_t, fields) +
+                      num_fields * sizeof(struct header_name_value_t);
+  if (size <= sizeof(struct go_grpc_http2_header_block_event_t)) {
+    go_grpc_header_block_events.perf_submit(ctx, event, size);
   }
 }
 
@@ -234,6 +253,9 @@ static __inline void submit_header(struct pt_regs* ctx, enum http2_probe_type_t
     return;
   }
 
+  // The encoder is called once per field, and there is no return probe to mark the end of the
+  // block, so each field is submitted as its own event.
+
   struct go_grpc_http2_header_event_t event = {};
   event.attr.probe_type = probe_type;
   event.attr.type = type;
@@ -241,7 +263,7 @@ static __inline void submit_header(struct pt_regs* ctx, enum http2_probe_type_t
   event.attr.conn_id = attr->conn_id;
   event.attr.stream_id = attr->stream_id;
 
-  fill_header_field(&event, header_field_ptr, symaddrs);
+  fill_header_field(&event.name, &event.value, header_field_ptr, symaddrs);
   go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
 }
 
@@ -165,3 +165,98 @@ int probe_ret_SSL_read(struct pt_regs* ctx) {
   active_ssl_read_args_map.delete(&id);
   return 0;
 }
+
+// Maximum number of pipelines a record-layer write is split into (SSL_MAX_PIPELINES).
+#define kMaxSSLPipelines 32
+// Record type of application data (SSL3_RT_APPLICATION_DATA).
+#define kSSL3RTApplicationData 23
+
+// The arguments of an application data write, and the plaintext size of all of its pipelines.
+struct ssl3_write_args_t {
+  struct data_args_t data_args;
+  ssize_t bytes_count;
+};
+
+BPF_HASH(active_ssl3_write_args_map, uint64_t, struct ssl3_write_args_t);
+
+// Function signature being probed:
+// int do_ssl3_write(SSL *s, int type, const unsigned char *buf, size_t *pipelens,
+//                   size_t numpipes, int create_empty_fragment, size_t *written)
+// In 1.1.0, pipelens is an unsigned int* and numpipes an unsigned int.
+//
+// This is the record-layer alternative to the SSL_write entry/return pair. The record layer
+// encrypts each plaintext buffer exactly once, and the buffer and its length are known at entry.
+// The data is only submitted on return, when the records were written (a positive return value).
+// do_ssl3_write() isn't exported, so this is only attached to libssl builds that keep their
+// symbol table (or have debug symbols installed); see UProbeManager::AttachOpenSSLUProbes().
+int probe_entry_do_ssl3_write(struct pt_regs* ctx) {
+  uint64_t id = bpf_get_current_pid_tgid();
+  uint32_t tgid = id >> 32;
+
+  void* ssl = (void*)PT_REGS_PARM1(ctx);
+  int type = PT_REGS_PARM2(ctx);
+  char* buf = (char*)PT_REGS_PARM3(ctx);
+  const void* pipelens = (const void*)PT_REGS_PARM4(ctx);
+  uint32_t numpipes = PT_REGS_PARM5(ctx);
+  int create_empty_fragment = PT_REGS_PARM6(ctx);
+
+  struct openssl_symaddrs_t* symaddrs = openssl_symaddrs_map.lookup(&tgid);
+  if (symaddrs == NULL) {
+    return 0;
+  }
+  REQUIRE_SYMADDR(symaddrs->do_ssl3_write_pipelen_size, 0);
+
+  int32_t fd = get_fd(tgid, ssl);
+  if (fd == kInvalidFD) {
+    return 0;
+  }
+
+  // Mark connection as SSL right away, so encrypted traffic does not get traced.
+  // Handshake records are written through here too, before any application data.
+  set_conn_as_ssl(tgid, fd);
+
+  if (type != kSSL3RTApplicationData || create_empty_fragment) {
+    return 0;
+  }
+
+  // The pipelines cover consecutive ranges of buf, so the write is the sum of their lengths.
+  struct ssl3_write_args_t write_args = {};
+#pragma unroll
+  for (uint32_t i = 0; i < kMaxSSLPipelines; ++i) {
+    if (i >= numpipes) {
+      break;
+    }
+    if (symaddrs->do_ssl3_write_pipelen_size == sizeof(uint64_t)) {
+      uint64_t len = 0;
+      bpf_probe_read(&len, sizeof(len), pipelens + i * sizeof(uint64_t));
+      write_args.bytes_count += len;
+    } else {
+      uint32_t len = 0;
+      bpf_probe_read(&len, sizeof(len), pipelens + i * sizeof(uint32_t));
+      write_args.bytes_count += len;
+    }
+  }
+
+  write_args.data_args.source_fn = kSSLWrite;
+  write_args.data_args.fd = fd;
+  write_args.data_args.buf = buf;
+  active_ssl3_write_args_map.update(&id, &write_args);
+
+  return 0;
+}
+
+int probe_ret_do_ssl3_write(struct pt_regs* ctx) {
+  uint64_t id = bpf_get_current_pid_tgid();
+
+  // 1.1.1 returns 1 on success, 1.1.0 the number of bytes written. Either way, a write that
+  // failed or is still pending (SSL_ERROR_WANT_WRITE) returns <= 0 and is not captured.
+  int ret = PT_REGS_RC(ctx);
+  const struct ssl3_write_args_t* write_args = active_ssl3_write_args_map.lookup(&id);
+  if (write_args != NULL && ret > 0) {
+    process_data(/* vecs */ false, ctx, id, kEgress, &write_args->data_args,
+                 write_args->bytes_count, /* ssl */ true);
+  }
+
+  active_ssl3_write_args_map.delete(&id);
+  return 0;
+}
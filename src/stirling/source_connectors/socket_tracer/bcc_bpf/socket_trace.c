@@ -61,20 +61,60 @@ const int kTrafficInferenceBias = 5;
 // is reported to user-space. It applies to read and write traffic combined.
 const int kConnStatsDataThreshold = 65536;
 
+// USE_RINGBUF is defined by user-space on kernels with BPF ring buffers (5.8+).
+// Ring buffers are shared by all CPUs, and preserve the order of events across CPUs.
+#ifndef USE_RINGBUF
+#define USE_RINGBUF 0
+#endif
+
 // This is the perf buffer for BPF program to export data from kernel to user space.
+#if USE_RINGBUF
+// The sizes in pages are set by user-space, and must be powers of 2.
+BPF_RINGBUF_OUTPUT(socket_data_events, SOCKET_DATA_EVENTS_RINGBUF_PAGES);
+BPF_RINGBUF_OUTPUT(socket_control_events, SOCKET_CONTROL_EVENTS_RINGBUF_PAGES);
+#else
 BPF_PERF_OUTPUT(socket_data_events);
 BPF_PERF_OUTPUT(socket_control_events);
+#endif
 BPF_PERF_OUTPUT(conn_stats_events);
 
 // This output is used to export notification of processes that have performed an mmap.
 BPF_PERF_OUTPUT(mmap_events);
 
+// These outputs are used to export notification of processes that have forked, exec'ed or exited,
+// so user-space can react to process lifecycle changes without rescanning /proc.
+BPF_PERF_OUTPUT(proc_fork_events);
+BPF_PERF_OUTPUT(proc_exec_events);
+BPF_PERF_OUTPUT(proc_exit_events);
+
 // This control_map is a bit-mask that controls which endpoints are traced in a connection.
 // The bits are defined in EndpointRole enum, kRoleClient or kRoleServer. kRoleUnknown is not
 // really used, but is defined for completeness.
 // There is a control map element for each protocol.
 BPF_PERCPU_ARRAY(control_map, uint64_t, kNumProtocols);
 
+// The number of bytes at the head of each traced syscall's data that are sent to user-space, for
+// each protocol. The rest of the data is only reported by size, so user-space can account for it
+// without receiving it. A limit of 0 sends all of the data.
+BPF_PERCPU_ARRAY(payload_prefix_limit_map, uint64_t, kNumProtocols);
+
+// The rate limits of data events, for each protocol. The data events of a process over the limit
+// are not sent to user-space, and are counted in conn_info_t::suppressed_events instead.
+// This particular map is only written from user-space, and only read from BPF.
+BPF_PERCPU_ARRAY(rate_limit_config_map, struct rate_limit_config_t, kNumProtocols);
+
+// The rate limit token buckets, for each process and protocol.
+// The buckets are shared by all CPUs, and are updated without locks: concurrent updates can let a
+// few more events through than the limit, which is fine for bounding the load on user-space.
+BPF_TABLE("lru_hash", struct rate_limit_key_t, struct rate_limit_bucket_t, rate_limit_buckets_map,
+          16384);
+
+// Map of the remote endpoints for which user-space confirmed the protocol and role, by parsing
+// their traffic. New connections to these endpoints skip protocol inference.
+// This particular map is only written from user-space, and only read from BPF.
+BPF_TABLE("lru_hash", struct known_endpoint_key_t, struct known_endpoint_t, known_endpoints_map,
+          16384);
+
 // Map from user-space file descriptors to the connections obtained from accept() syscall.
 // Tracks connection from accept() -> close().
 // Key is {tgid, fd}.
@@ -218,6 +258,7 @@ static __inline struct conn_stats_event_t* fill_conn_stats_event(
   event->role = conn_info->role;
   event->wr_bytes = conn_info->wr_bytes;
   event->rd_bytes = conn_info->rd_bytes;
+  event->suppressed_events = conn_info->suppressed_events;
   event->conn_events = 0;
   event->timestamp_ns = bpf_ktime_get_ns();
   return event;
@@ -237,7 +278,7 @@ static __inline bool should_trace_sockaddr_family(sa_family_t sa_family) {
 //
 // TODO(yzhao): Remove protocol detection threshold.
 static __inline bool protocol_detection_passes_threshold(const struct conn_info_t* conn_info) {
-  if (conn_info->protocol == kProtocolPGSQL) {
+  if (conn_info->protocol == kProtocolPGSQL && !conn_info->known_endpoint) {
     // Since some protocols are hard to infer from a single event, we track the inference stats over
     // time, and then use the match rate to determine whether we really want to consider it to be of
     // the protocol or not. This helps reduce polluting events to user-space.
@@ -261,6 +302,61 @@ static __inline bool should_trace_protocol_data(const struct conn_info_t* conn_i
   return control & conn_info->role;
 }
 
+// Returns the number of bytes of a syscall's data to send to user-space.
+static __inline size_t payload_prefix_size(const struct conn_info_t* conn_info, size_t size) {
+  uint32_t protocol = conn_info->protocol;
+  uint64_t* limit = payload_prefix_limit_map.lookup(&protocol);
+  if (limit == NULL || *limit == 0 || *limit >= size) {
+    return size;
+  }
+  return *limit;
+}
+
+// Returns true if the rate limit of the connection's protocol allows sending one more data event of
+// the process to user-space, and takes the event's cost from the bucket of the process.
+static __inline bool rate_limit_allows(uint32_t tgid, const struct conn_info_t* conn_info) {
+  uint32_t protocol = conn_info->protocol;
+  struct rate_limit_config_t* config = rate_limit_config_map.lookup(&protocol);
+  if (config == NULL || config->events_per_sec == 0) {
+    return true;
+  }
+
+  const uint64_t kNsPerSec = 1000000000ULL;
+  const uint64_t cost_ns = kNsPerSec / config->events_per_sec;
+  const uint64_t capacity_ns = cost_ns * config->burst;
+  const uint64_t now = bpf_ktime_get_ns();
+
+  struct rate_limit_key_t key = {};
+  key.tgid = tgid;
+  key.protocol = protocol;
+
+  struct rate_limit_bucket_t* bucket = rate_limit_buckets_map.lookup(&key);
+  if (bucket == NULL) {
+    // A new bucket starts full.
+    struct rate_limit_bucket_t new_bucket = {};
+    new_bucket.credit_ns = capacity_ns > cost_ns ? capacity_ns - cost_ns : 0;
+    new_bucket.last_update_ns = now;
+    rate_limit_buckets_map.update(&key, &new_bucket);
+    return true;
+  }
+
+  uint64_t credit_ns = bucket->credit_ns;
+  // Another CPU may have updated the bucket with a later timestamp.
+  if (now > bucket->last_update_ns) {
+    credit_ns += now - bucket->last_update_ns;
+    bucket->last_update_ns = now;
+  }
+  if (credit_ns > capacity_ns) {
+    credit_ns = capacity_ns;
+  }
+  if (credit_ns < cost_ns) {
+    bucket->credit_ns = credit_ns;
+    return false;
+  }
+  bucket->credit_ns = credit_ns - cost_ns;
+  return true;
+}
+
 static __inline bool is_stirling_tgid(const uint32_t tgid) {
   int idx = kStirlingTGIDIndex;
   int64_t* stirling_tgid = control_values.lookup(&idx);
@@ -288,6 +384,9 @@ static __inline void update_traffic_class(struct conn_info_t* conn_info,
   if (conn_info == NULL) {
     return;
   }
+  if (conn_info->known_endpoint) {
+    return;
+  }
   conn_info->protocol_total_count += 1;
 
   // Try to infer connection type (protocol) based on data.
@@ -357,6 +456,77 @@ static __inline void read_sockaddr_kernel(struct conn_info_t* conn_info,
   }
 }
 
+// Returns the memory to compose a control event in: a reservation in the ring buffer,
+// or the given zero-initialized stack event for perf buffers. Returns NULL if the ring buffer is
+// full.
+static __inline struct socket_control_event_t* reserve_control_event(
+    struct socket_control_event_t* stack_event) {
+#if USE_RINGBUF
+  struct socket_control_event_t* event =
+      socket_control_events.ringbuf_reserve(sizeof(struct socket_control_event_t));
+  if (event != NULL) {
+    // Unlike the stack event, a reservation isn't zero-initialized.
+    __builtin_memset(event, 0, sizeof(struct socket_control_event_t));
+  }
+  return event;
+#else
+  return stack_event;
+#endif
+}
+
+// Submits a control event returned by reserve_control_event().
+static __inline void submit_control_event(struct pt_regs* ctx,
+                                          struct socket_control_event_t* event) {
+#if USE_RINGBUF
+  socket_control_events.ringbuf_submit(event, 0);
+#else
+  socket_control_events.perf_submit(ctx, event, sizeof(struct socket_control_event_t));
+#endif
+}
+
+// Sets the protocol and role of the connection, if user-space already confirmed them for the
+// remote endpoint.
+static __inline void apply_known_endpoint(struct conn_info_t* conn_info) {
+  struct known_endpoint_key_t key;
+  __builtin_memset(&key, 0, sizeof(key));
+  key.upid = conn_info->conn_id.upid;
+  key.family = conn_info->addr.sa.sa_family;
+  if (key.family != AF_INET && key.family != AF_INET6) {
+    return;
+  }
+  if (conn_info->role == kRoleServer) {
+    // Servers are keyed by their listening port, since the remote port of each client differs.
+    if (conn_info->local_port == 0) {
+      return;
+    }
+    // To network byte order; x86 is little-endian.
+    key.port = __builtin_bswap16(conn_info->local_port);
+  } else if (key.family == AF_INET) {
+    key.port = conn_info->addr.in4.sin_port;
+    __builtin_memcpy(key.addr, &conn_info->addr.in4.sin_addr, sizeof(struct in_addr));
+  } else {
+    key.port = conn_info->addr.in6.sin6_port;
+    __builtin_memcpy(key.addr, &conn_info->addr.in6.sin6_addr, sizeof(struct in6_addr));
+  }
+
+  struct known_endpoint_t* known_endpoint = known_endpoints_map.lookup(&key);
+  if (known_endpoint == NULL || known_endpoint->role != conn_info->role) {
+    return;
+  }
+  conn_info->protocol = known_endpoint->protocol;
+  conn_info->known_endpoint = true;
+}
+
+// Returns the local port of the socket, in host byte order.
+static __inline uint16_t read_local_port_kernel(const struct socket* socket) {
+  struct sock* sk = NULL;
+  bpf_probe_read_kernel(&sk, sizeof(sk), &socket->sk);
+
+  uint16_t port = 0;
+  bpf_probe_read_kernel(&port, sizeof(port), &sk->__sk_common.skc_num);
+  return port;
+}
+
 static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t fd,
                                      const struct sockaddr* addr, const struct socket* socket,
                                      enum EndpointRole role) {
@@ -368,6 +538,10 @@ static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t
     read_sockaddr_kernel(&conn_info, socket);
   }
   conn_info.role = role;
+  if (role == kRoleServer && socket != NULL) {
+    conn_info.local_port = read_local_port_kernel(socket);
+  }
+  apply_known_endpoint(&conn_info);
 
   uint64_t tgid_fd = gen_tgid_fd(tgid, fd);
   conn_info_map.update(&tgid_fd, &conn_info);
@@ -379,25 +553,34 @@ static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t
     return;
   }
 
-  struct socket_control_event_t control_event = {};
-  control_event.type = kConnOpen;
-  control_event.timestamp_ns = bpf_ktime_get_ns();
-  control_event.conn_id = conn_info.conn_id;
-  control_event.open.addr = conn_info.addr;
-  control_event.open.role = conn_info.role;
+  struct socket_control_event_t stack_event = {};
+  struct socket_control_event_t* control_event = reserve_control_event(&stack_event);
+  if (control_event == NULL) {
+    return;
+  }
+  control_event->type = kConnOpen;
+  control_event->timestamp_ns = bpf_ktime_get_ns();
+  control_event->conn_id = conn_info.conn_id;
+  control_event->open.addr = conn_info.addr;
+  control_event->open.role = conn_info.role;
+  control_event->open.local_port = conn_info.local_port;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  submit_control_event(ctx, control_event);
 }
 
 static __inline void submit_close_event(struct pt_regs* ctx, struct conn_info_t* conn_info) {
-  struct socket_control_event_t control_event = {};
-  control_event.type = kConnClose;
-  control_event.timestamp_ns = bpf_ktime_get_ns();
-  control_event.conn_id = conn_info->conn_id;
-  control_event.close.rd_bytes = conn_info->rd_bytes;
-  control_event.close.wr_bytes = conn_info->wr_bytes;
+  struct socket_control_event_t stack_event = {};
+  struct socket_control_event_t* control_event = reserve_control_event(&stack_event);
+  if (control_event == NULL) {
+    return;
+  }
+  control_event->type = kConnClose;
+  control_event->timestamp_ns = bpf_ktime_get_ns();
+  control_event->conn_id = conn_info->conn_id;
+  control_event->close.rd_bytes = conn_info->rd_bytes;
+  control_event->close.wr_bytes = conn_info->wr_bytes;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  submit_control_event(ctx, control_event);
 }
 
 // TODO(yzhao): We can write a test for this, by define a dummy bpf_probe_read() function. Similar
@@ -406,9 +589,11 @@ static __inline void submit_close_event(struct pt_regs* ctx, struct conn_info_t*
 // Writes the input buf to event, and submits the event to the corresponding perf buffer.
 // Returns the bytes output from the input buf. Note that is not the total bytes submitted to the
 // perf buffer, which includes additional metadata.
+// msg_size is the size of the data that buf is the head of. It is larger than buf_size when the
+// rest of the data is left out by the payload prefix limit.
 static __inline void perf_submit_buf(struct pt_regs* ctx, const enum TrafficDirection direction,
-                                     const char* buf, size_t buf_size, size_t offset,
-                                     struct conn_info_t* conn_info,
+                                     const char* buf, size_t buf_size, size_t msg_size,
+                                     size_t offset, struct conn_info_t* conn_info,
                                      struct socket_data_event_t* event) {
   switch (direction) {
     case kEgress:
@@ -420,7 +605,7 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum TrafficDire
   }
 
   // Record original size of packet. This may get truncated below before submit.
-  event->attr.msg_size = buf_size;
+  event->attr.msg_size = msg_size;
 
   // This rest of this function has been written carefully to keep the BPF verifier happy in older
   // kernels, so please take care when modifying.
@@ -473,13 +658,20 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum TrafficDire
   if (buf_size_minus_1 < MAX_MSG_SIZE) {
     bpf_probe_read(&event->msg, buf_size, buf);
     event->attr.msg_buf_size = buf_size;
+#if USE_RINGBUF
+    // The size of a ring buffer reservation must be known to the verifier, so data events are
+    // still composed in the per-CPU heap, and copied into the ring buffer.
+    socket_data_events.ringbuf_output(event, sizeof(event->attr) + buf_size, 0);
+#else
     socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + buf_size);
+#endif
   }
 }
 
+// Submits the first buf_size bytes of the total_size bytes of buf.
 static __inline void perf_submit_wrapper(struct pt_regs* ctx, const enum TrafficDirection direction,
                                          const char* buf, const size_t buf_size,
-                                         struct conn_info_t* conn_info,
+                                         const size_t total_size, struct conn_info_t* conn_info,
                                          struct socket_data_event_t* event) {
   int bytes_sent = 0;
   unsigned int i;
@@ -488,14 +680,20 @@ static __inline void perf_submit_wrapper(struct pt_regs* ctx, const enum Traffic
   for (i = 0; i < CHUNK_LIMIT; ++i) {
     const int bytes_remaining = buf_size - bytes_sent;
     const size_t current_size = bytes_remaining > MAX_MSG_SIZE ? MAX_MSG_SIZE : bytes_remaining;
-    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, bytes_sent, conn_info, event);
+    // The last chunk also accounts for the bytes left out after it.
+    const size_t msg_size =
+        current_size == bytes_remaining ? total_size - bytes_sent : current_size;
+    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, msg_size, bytes_sent,
+                    conn_info, event);
     bytes_sent += current_size;
   }
 }
 
+// Submits the first buf_size bytes of the total_size bytes of the iovecs.
 static __inline void perf_submit_iovecs(struct pt_regs* ctx, const enum TrafficDirection direction,
                                         const struct iovec* iov, const size_t iovlen,
-                                        const size_t total_size, struct conn_info_t* conn_info,
+                                        const size_t buf_size, const size_t total_size,
+                                        struct conn_info_t* conn_info,
                                         struct socket_data_event_t* event) {
   // NOTE: The loop index 'i' used to be int. BPF verifier somehow conclude that msg_size inside
   // perf_submit_buf(), after a series of assignment, and passed into a function call, can be
@@ -513,16 +711,19 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx, const enum TrafficD
   // buffers and the total size need to be checked. More details can be found on their man pages.
   int bytes_sent = 0;
 #pragma unroll
-  for (unsigned int i = 0; i < LOOP_LIMIT && i < iovlen && bytes_sent < total_size; ++i) {
+  for (unsigned int i = 0; i < LOOP_LIMIT && i < iovlen && bytes_sent < buf_size; ++i) {
     struct iovec iov_cpy;
     bpf_probe_read(&iov_cpy, sizeof(struct iovec), &iov[i]);
 
-    const int bytes_remaining = total_size - bytes_sent;
+    const int bytes_remaining = buf_size - bytes_sent;
     const size_t iov_size = iov_cpy.iov_len < bytes_remaining ? iov_cpy.iov_len : bytes_remaining;
+    // The last iovec also accounts for the bytes left out after it.
+    const size_t msg_size = iov_size == bytes_remaining ? total_size - bytes_sent : iov_size;
 
     // TODO(oazizi/yzhao): Should switch this to go through perf_submit_wrapper.
     //                     We don't have the BPF instruction count to do so right now.
-    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, bytes_sent, conn_info, event);
+    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, msg_size, bytes_sent, conn_info,
+                    event);
     bytes_sent += iov_size;
   }
 }
@@ -752,6 +953,12 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
   bool send_data = !is_stirling_tgid(tgid) && should_trace_protocol_data(conn_info) &&
                    (conn_disabled_tsid == NULL || conn_info->conn_id.tsid > *conn_disabled_tsid);
 
+  // The rate limit only applies to the events that would otherwise be sent.
+  if (send_data && !rate_limit_allows(tgid, conn_info)) {
+    send_data = false;
+    ++conn_info->suppressed_events;
+  }
+
   if (send_data) {
     struct socket_data_event_t* event =
         fill_socket_data_event(args->source_fn, direction, conn_info);
@@ -760,14 +967,17 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
       return;
     }
 
+    const size_t bytes_to_send = payload_prefix_size(conn_info, bytes_count);
+
     // TODO(yzhao): Same TODO for split the interface.
     if (!vecs) {
-      perf_submit_wrapper(ctx, direction, args->buf, bytes_count, conn_info, event);
+      perf_submit_wrapper(ctx, direction, args->buf, bytes_to_send, bytes_count, conn_info, event);
     } else {
       // TODO(yzhao): iov[0] is copied twice, once in calling update_traffic_class(), and here.
       // This happens to the write probes as well, but the calls are placed in the entry and return
       // probes respectively. Consider remove one copy.
-      perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, conn_info, event);
+      perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_to_send, bytes_count,
+                         conn_info, event);
     }
   }
 
@@ -1478,6 +1688,48 @@ int syscall__probe_entry_mmap(struct pt_regs* ctx) {
   return 0;
 }
 
+// Tracepoint: sched:sched_process_fork
+// Runs in the parent. It also fires for new threads, which user space tells apart from new
+// processes, because the child's task_struct is not available here.
+int probe_sched_process_fork(struct tracepoint__sched__sched_process_fork* args) {
+  struct proc_fork_event_t event = {};
+  event.parent_tgid = bpf_get_current_pid_tgid() >> 32;
+  event.child_pid = args->child_pid;
+
+  proc_fork_events.perf_submit(args, &event, sizeof(event));
+
+  return 0;
+}
+
+// Tracepoint: sched:sched_process_exec
+int probe_sched_process_exec(struct tracepoint__sched__sched_process_exec* args) {
+  uint64_t id = bpf_get_current_pid_tgid();
+  struct upid_t upid = {};
+  upid.tgid = id >> 32;
+  upid.start_time_ticks = get_tgid_start_time();
+
+  proc_exec_events.perf_submit(args, &upid, sizeof(upid));
+
+  return 0;
+}
+
+// Tracepoint: sched:sched_process_exit
+int probe_sched_process_exit(struct tracepoint__sched__sched_process_exit* args) {
+  uint64_t id = bpf_get_current_pid_tgid();
+  struct upid_t upid = {};
+  upid.tgid = id >> 32;
+
+  // This tracepoint fires for every exiting thread; only the thread group leader matters.
+  if ((uint32_t)id != upid.tgid) {
+    return 0;
+  }
+  upid.start_time_ticks = get_tgid_start_time();
+
+  proc_exit_events.perf_submit(args, &upid, sizeof(upid));
+
+  return 0;
+}
+
 // Trace kernel function:
 // struct socket *sock_alloc(void)
 // which is called inside accept4() syscall to allocate socket data structure.
@@ -51,20 +51,38 @@ enum http2_probe_type_t {
 
 enum HeaderEventType { kHeaderEventUnknown, kHeaderEventRead, kHeaderEventWrite };
 
+struct header_attr_t {
+  enum http2_probe_type_t probe_type;
+  enum HeaderEventType type;
+  uint64_t timestamp_ns;
+  struct conn_id_t conn_id;
+  uint32_t stream_id;
+  bool end_stream;
+};
+
 struct go_grpc_http2_header_event_t {
-  struct header_attr_t {
-    enum http2_probe_type_t probe_type;
-    enum HeaderEventType type;
-    uint64_t timestamp_ns;
-    struct conn_id_t conn_id;
-    uint32_t stream_id;
-    bool end_stream;
-  } attr;
+  struct header_attr_t attr;
 
   struct header_field_t name;
   struct header_field_t value;
 };
 
+#define MAX_HEADER_BLOCK_FIELDS 64
+
+struct header_name_value_t {
+  struct header_field_t name;
+  struct header_field_t value;
+};
+
+// All the header fields of a HEADERS frame, for probes that see the whole frame at once.
+// Only the first num_fields entries of fields are submitted to the perf buffer.
+// If attr.end_stream is set, the stream ends after these headers.
+struct go_grpc_http2_header_block_event_t {
+  struct header_attr_t attr;
+  uint32_t num_fields;
+  struct header_name_value_t fields[MAX_HEADER_BLOCK_FIELDS];
+};
+
 enum DataFrameEventType { kDataFrameEventUnknown, kDataFrameEventRead, kDataFrameEventWrite };
 
 struct go_grpc_data_event_t {
@@ -20,7 +20,11 @@
 
 #include <algorithm>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include <absl/strings/str_join.h>
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
@@ -53,7 +57,7 @@
 namespace px {
 namespace stirling {
 
-inline std::string ToString(const struct go_grpc_http2_header_event_t::header_attr_t& attr) {
+inline std::string ToString(const struct header_attr_t& attr) {
   return absl::Substitute(
       "[probe_type=$0 type=$1 timestamp_ns=$2 conn_id=$3 stream_id=$4 end_stream=$5] ",
       magic_enum::enum_name(attr.probe_type), magic_enum::enum_name(attr.type), attr.timestamp_ns,
@@ -103,7 +107,7 @@ struct HTTP2HeaderEvent {
     auto value_len_ptr = data_ptr + offsetof(go_grpc_http2_header_event_t, value.size);
 
     // Copy attr sub-struct via memcpy as char -- requires 1-byte alignment.
-    memcpy(&attr, attr_ptr, sizeof(go_grpc_http2_header_event_t::header_attr_t));
+    memcpy(&attr, attr_ptr, sizeof(header_attr_t));
 
     // Copy name length (uint32_t) -- requires 4-byte alignment.
     uint32_t name_len = *reinterpret_cast<const uint32_t*>(name_len_ptr);
@@ -125,10 +129,55 @@ struct HTTP2HeaderEvent {
                             value);
   }
 
-  go_grpc_http2_header_event_t::header_attr_t attr;
+  header_attr_t attr;
   std::string name;
   std::string value;
 };
 
+/**
+ * A view of a go_grpc_http2_header_block_event_t.
+ *
+ * The fields point into the perf buffer, so they are only valid during the perf buffer callback.
+ * A single instance is meant to be reused for all events, so that decoding doesn't allocate.
+ */
+struct HTTP2HeaderBlockEventView {
+  void Decode(const void* data) {
+    auto data_ptr = static_cast<const char*>(data);
+
+    memcpy(&attr, data_ptr + offsetof(go_grpc_http2_header_block_event_t, attr),
+           sizeof(header_attr_t));
+
+    uint32_t num_fields;
+    memcpy(&num_fields, data_ptr + offsetof(go_grpc_http2_header_block_event_t, num_fields),
+           sizeof(uint32_t));
+    num_fields = std::min<uint32_t>(num_fields, MAX_HEADER_BLOCK_FIELDS);
+
+    // Keeps the capacity of the previous events.
+    fields.clear();
+    auto fields_ptr = data_ptr + offsetof(go_grpc_http2_header_block_event_t, fields);
+    for (uint32_t i = 0; i < num_fields; ++i) {
+      auto field_ptr = fields_ptr + i * sizeof(header_name_value_t);
+      fields.emplace_back(HeaderFieldView(field_ptr + offsetof(header_name_value_t, name)),
+                          HeaderFieldView(field_ptr + offsetof(header_name_value_t, value)));
+    }
+  }
+
+  std::string ToString() const {
+    return absl::Substitute("[attr=$0] [fields=$1]", ::px::stirling::ToString(attr),
+                            absl::StrJoin(fields, " ", absl::PairFormatter("=")));
+  }
+
+  header_attr_t attr;
+  std::vector<std::pair<std::string_view, std::string_view>> fields;
+
+ private:
+  static std::string_view HeaderFieldView(const char* field_ptr) {
+    uint32_t size;
+    memcpy(&size, field_ptr + offsetof(header_field_t, size), sizeof(uint32_t));
+    return std::string_view(field_ptr + offsetof(header_field_t, msg),
+                            std::min<uint32_t>(size, HEADER_FIELD_STR_SIZE));
+  }
+};
+
 }  // namespace stirling
 }  // namespace px
@@ -31,6 +31,9 @@ const uint64_t kSocketTraceNothing = 0;
 
 const int64_t kTraceAllTGIDs = -1;
 const char kControlValuesArrayName[] = "control_values";
+const char kPayloadPrefixLimitMapName[] = "payload_prefix_limit_map";
+const char kRateLimitConfigMapName[] = "rate_limit_config_map";
+const char kKnownEndpointsMapName[] = "known_endpoints_map";
 
 // Note: A value of 100 results in >4096 BPF instructions, which is too much for older kernels.
 #define CONN_CLEANUP_ITERS 90
@@ -60,6 +63,14 @@ struct conn_info_t {
   // Whether the connection uses SSL.
   bool ssl;
 
+  // Whether protocol and role were taken from known_endpoints_map, in which case protocol
+  // inference is skipped for the connection.
+  bool known_endpoint;
+
+  // The local port of connections accepted by the process (role server), in host byte order.
+  // 0 if unknown.
+  uint16_t local_port;
+
   // The number of bytes written/read on this connection.
   uint64_t wr_bytes;
   uint64_t rd_bytes;
@@ -85,6 +96,50 @@ struct conn_info_t {
   // Length(3 bytes) + seq_number(1 byte).
   size_t prev_count;
   char prev_buf[4];
+
+  // The number of data events on this connection that were not sent to user-space, because the
+  // process was over the rate limit of the protocol.
+  uint64_t suppressed_events;
+};
+
+// The rate limit of the data events of a protocol, which applies to each process separately.
+struct rate_limit_config_t {
+  // The sustained rate of data events sent to user-space. 0 disables the limit.
+  uint64_t events_per_sec;
+  // The number of data events that can be sent at once, after a quiet period.
+  uint64_t burst;
+};
+
+// Identifies the rate limit bucket of a process and protocol.
+// Users must zero the whole struct (including padding) before filling it, as it is a map key.
+struct rate_limit_key_t {
+  uint32_t tgid;
+  uint32_t protocol;
+};
+
+// A token bucket, with tokens kept as nanoseconds of credit: the bucket refills with the time
+// that passes, up to burst events, and each event costs 1e9 / events_per_sec of credit.
+struct rate_limit_bucket_t {
+  uint64_t credit_ns;
+  uint64_t last_update_ns;
+};
+
+// Identifies an endpoint of a process, for known_endpoints_map. For clients, it is the remote
+// address and port. For servers, whose remote ports are ephemeral, it is the local (listening)
+// port, and the address is zero.
+// The address and port are in network byte order; unused address bytes are zero.
+// Users must zero the whole struct (including padding) before filling it, as it is a map key.
+struct known_endpoint_key_t {
+  struct upid_t upid;
+  uint16_t family;
+  uint16_t port;
+  uint8_t addr[16];
+};
+
+// The protocol and role that user-space confirmed for a known endpoint.
+struct known_endpoint_t {
+  enum TrafficProtocol protocol;
+  enum EndpointRole role;
 };
 
 // This struct is a subset of conn_info_t. It is used to communicate connect/accept events.
@@ -92,6 +147,7 @@ struct conn_info_t {
 struct conn_event_t {
   union sockaddr_t addr;
   enum EndpointRole role;
+  uint16_t local_port;
 };
 
 // This struct is a subset of conn_info_t. It is used to communicate close events.
@@ -221,6 +277,17 @@ struct conn_stats_event_t {
 
   // Bitmask of flags specifying whether conn open or close have been observed.
   uint32_t conn_events;
+
+  // The number of data events on this connection that were not sent to user-space, because of
+  // rate limits.
+  uint64_t suppressed_events;
+};
+
+// A process or thread created by fork/clone. The child's start time is not known when the event
+// is emitted, so it is identified by its pid, and user space resolves the rest.
+struct proc_fork_event_t {
+  uint32_t parent_tgid;
+  uint32_t child_pid;
 };
 
 typedef enum {
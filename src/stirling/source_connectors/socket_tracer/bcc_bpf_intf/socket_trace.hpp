@@ -23,6 +23,7 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include <absl/hash/hash.h>
@@ -70,11 +71,36 @@ struct SocketDataEvent {
   }
 
   socket_data_event_t::attr_t attr;
-  // TODO(oazizi/yzhao): Eventually, we will write the data into a buffer that can be used for later
-  // parsing. By then, msg can be changed to string_view.
   std::string msg;
 };
 
+/**
+ * A data event whose message refers to memory the event doesn't own, typically the perf buffer
+ * the event was read from. This lets the message be copied straight into its DataStreamBuffer,
+ * without an intermediate SocketDataEvent. It is only valid while that memory is, which for perf
+ * buffer memory is the duration of the perf buffer callback.
+ */
+struct SocketDataEventView {
+  explicit SocketDataEventView(const void* data) {
+    // See SocketDataEvent(const void*) for why attr is memcpy'ed.
+    memcpy(&attr, static_cast<const char*>(data) + offsetof(socket_data_event_t, attr),
+           sizeof(socket_data_event_t::attr_t));
+    msg = std::string_view(static_cast<const char*>(data) + offsetof(socket_data_event_t, msg),
+                           attr.msg_buf_size);
+  }
+  explicit SocketDataEventView(const SocketDataEvent& event) : attr(event.attr), msg(event.msg) {}
+  SocketDataEventView(const socket_data_event_t::attr_t& attr, std::string_view msg)
+      : attr(attr), msg(msg) {}
+
+  std::string ToString() const {
+    return absl::Substitute("attr:[$0] msg_size:$1 msg:[$2]", ::ToString(attr), msg.size(),
+                            BytesToString<bytes_format::HexAsciiMix>(msg));
+  }
+
+  socket_data_event_t::attr_t attr;
+  std::string_view msg;
+};
+
 }  // namespace stirling
 }  // namespace px
 
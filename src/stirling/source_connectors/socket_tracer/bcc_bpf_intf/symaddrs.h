@@ -207,4 +207,8 @@ struct openssl_symaddrs_t {
   // Offset of num in struct bio_st.
   // Struct is defined in crypto/bio/bio_lcl.h, crypto/bio/bio_local.h depending on the version.
   int32_t RBIO_num_offset;  // 0x30 (openssl 1.1.1) or 0x28 (openssl 1.1.0)
+
+  // Size of the elements of the pipelens argument of do_ssl3_write().
+  // Defined in ssl/record/rec_layer_s3.c: unsigned int in 1.1.0, size_t in 1.1.1.
+  int32_t do_ssl3_write_pipelen_size;  // 8 (openssl 1.1.1) or 4 (openssl 1.1.0)
 };
@@ -64,16 +64,26 @@ absl::flat_hash_map<ConnStats::AggKey, ConnStats::Stats>& ConnStats::UpdateStats
     int conn_close = conn_stats.CloseSinceLastRead();
     int bytes_recv = conn_stats.BytesRecvSinceLastRead();
     int bytes_sent = conn_stats.BytesSentSinceLastRead();
+    int events_suppressed = conn_stats.EventsSuppressedSinceLastRead();
 
     AggKey key = BuildAggKey(tracker->conn_id().upid, tracker->role(), tracker->remote_endpoint());
     auto& stats = agg_stats_[key];
 
     stats.addr_family = tracker->remote_endpoint().family;
     stats.role = tracker->role();
+
+    // Idle connections (e.g. keep-alive ones) are the common case, and are left unmarked, so
+    // that their unchanged stats are not exported again.
+    if (conn_open == 0 && conn_close == 0 && bytes_recv == 0 && bytes_sent == 0 &&
+        events_suppressed == 0) {
+      continue;
+    }
+
     stats.conn_open += conn_open;
     stats.conn_close += conn_close;
     stats.bytes_recv += bytes_recv;
     stats.bytes_sent += bytes_sent;
+    stats.events_suppressed += events_suppressed;
 
     stats.last_update = update_counter_;
   }
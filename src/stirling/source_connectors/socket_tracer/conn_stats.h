@@ -74,33 +74,41 @@ class ConnStats {
     uint64_t conn_close = 0;
     uint64_t bytes_sent = 0;
     uint64_t bytes_recv = 0;
+    // The number of data events that BPF did not send to user-space, because of rate limits.
+    uint64_t events_suppressed = 0;
 
     // Keep track of whether this stats object has ever been previously reported.
     // Used to determine whether it should be reported in the future, after the connection
     // has closed.
     bool reported = false;
 
-    // Last time this stats object was updated.
-    // Used to indicate whether or not to skip exporting the current record.
+    // Last update in which the counters of this stats object changed.
+    // Used to skip exporting records of idle connections, which have not changed.
     int last_update = 0;
 
+    // Time at which this stats object was last reported, used to report idle connections
+    // periodically nonetheless.
+    uint64_t last_report_time_ns = 0;
+
     std::string ToString() const {
       return absl::Substitute(
-          "[conn_open=$0 conn_close=$1 bytes_sent=$2 bytes_recv=$3 protocol=$4 role=$5]", conn_open,
-          conn_close, bytes_sent, bytes_recv, magic_enum::enum_name(protocol),
-          magic_enum::enum_name(role));
+          "[conn_open=$0 conn_close=$1 bytes_sent=$2 bytes_recv=$3 events_suppressed=$4 "
+          "protocol=$5 role=$6]",
+          conn_open, conn_close, bytes_sent, bytes_recv, events_suppressed,
+          magic_enum::enum_name(protocol), magic_enum::enum_name(role));
     }
   };
 
   /**
    * Iterates through all the trackers and updates the internal state with any newly collected
-   * information that the tracker has received.
+   * information that the tracker has received. Only stats whose counters changed become Active().
    *
    * @return A mutable reference to all the aggregated connection stats. The reference is mutable
    *         for the purposes of removing stats that are no longer needed.
    */
   absl::flat_hash_map<AggKey, Stats>& UpdateStats();
 
+  // Returns true if the stats changed in the latest UpdateStats().
   bool Active(const Stats& stats) { return update_counter_ == stats.last_update; }
 
  private:
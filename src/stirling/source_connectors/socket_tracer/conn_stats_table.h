@@ -47,6 +47,9 @@ constexpr DataElement kConnStatsElements[] = {
          types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_COUNTER},
         {"bytes_recv", "The number of bytes received from the remote endpoint(s).",
          types::DataType::INT64, types::SemanticType::ST_BYTES, types::PatternType::METRIC_COUNTER},
+        {"events_suppressed", "The number of data events not traced, because the process was over "
+         "the rate limit of the protocol (see --stirling_bpf_rate_limits).",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
 #ifndef NDEBUG
         {"px_info_", "Pixie messages regarding the record (e.g. warnings)",
          types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
@@ -76,6 +79,7 @@ constexpr int kConnClose = kConnStatsTable.ColIndex("conn_close");
 constexpr int kConnActive = kConnStatsTable.ColIndex("conn_active");
 constexpr int kBytesSent = kConnStatsTable.ColIndex("bytes_sent");
 constexpr int kBytesRecv = kConnStatsTable.ColIndex("bytes_recv");
+constexpr int kEventsSuppressed = kConnStatsTable.ColIndex("events_suppressed");
 #ifndef NDEBUG
 constexpr int kPxInfo = kConnStatsTable.ColIndex("px_info_");
 #endif
@@ -92,7 +92,7 @@ TEST_F(ConnStatsTest, Basic) {
   };
 
   // The basic conn_stats_event template.
-  struct conn_stats_event_t conn_stats_event;
+  struct conn_stats_event_t conn_stats_event = {};
   conn_stats_event.timestamp_ns = 0;
   conn_stats_event.conn_id = kConnID0;
   conn_stats_event.role = kRoleClient;
@@ -154,6 +154,83 @@ TEST_F(ConnStatsTest, Basic) {
               UnorderedElementsAre(Pair(AggKeyIs(12345, "1.1.1.1", 80), StatsIs(1, 1, 6, 9))));
 }
 
+// Tests that only the stats whose counters changed are active, so that idle connections are
+// not exported again.
+TEST_F(ConnStatsTest, ActiveOnlyOnChange) {
+  constexpr struct conn_id_t kConnID0 = {
+      .upid = {.pid = 12345, .start_time_ticks = 1000},
+      .fd = 3,
+      .tsid = 111110,
+  };
+
+  struct conn_stats_event_t conn_stats_event = {};
+  conn_stats_event.timestamp_ns = 1;
+  conn_stats_event.conn_id = kConnID0;
+  conn_stats_event.role = kRoleClient;
+  conn_stats_event.addr.in4.sin_family = AF_INET;
+  conn_stats_event.addr.in4.sin_port = htons(80);
+  conn_stats_event.addr.in4.sin_addr.s_addr = 0x01010101;  // 1.1.1.1
+  conn_stats_event.conn_events = CONN_OPEN;
+  conn_stats_event.rd_bytes = 0;
+  conn_stats_event.wr_bytes = 3;
+
+  ConnTracker& tracker = conn_trackers_mgr_.GetOrCreateConnTracker(conn_stats_event.conn_id);
+  tracker.AddConnStats(conn_stats_event);
+
+  auto& agg_stats = conn_stats_.UpdateStats();
+  ASSERT_THAT(agg_stats, SizeIs(1));
+  EXPECT_TRUE(conn_stats_.Active(agg_stats.begin()->second));
+
+  // No new traffic: the stats are unchanged, and not active.
+  EXPECT_THAT(conn_stats_.UpdateStats(),
+              UnorderedElementsAre(Pair(AggKeyIs(12345, "1.1.1.1", 80), StatsIs(1, 0, 3, 0))));
+  EXPECT_FALSE(conn_stats_.Active(agg_stats.begin()->second));
+
+  conn_stats_event.timestamp_ns += 1;
+  conn_stats_event.rd_bytes += 5;
+  tracker.AddConnStats(conn_stats_event);
+
+  EXPECT_THAT(conn_stats_.UpdateStats(),
+              UnorderedElementsAre(Pair(AggKeyIs(12345, "1.1.1.1", 80), StatsIs(1, 0, 3, 5))));
+  EXPECT_TRUE(conn_stats_.Active(agg_stats.begin()->second));
+}
+
+// Events suppressed by the BPF rate limits are aggregated, and make the stats active, even without
+// any new traffic.
+TEST_F(ConnStatsTest, EventsSuppressed) {
+  constexpr struct conn_id_t kConnID0 = {
+      .upid = {.pid = 12345, .start_time_ticks = 1000},
+      .fd = 3,
+      .tsid = 111110,
+  };
+
+  struct conn_stats_event_t conn_stats_event = {};
+  conn_stats_event.timestamp_ns = 1;
+  conn_stats_event.conn_id = kConnID0;
+  conn_stats_event.role = kRoleClient;
+  conn_stats_event.addr.in4.sin_family = AF_INET;
+  conn_stats_event.addr.in4.sin_port = htons(80);
+  conn_stats_event.addr.in4.sin_addr.s_addr = 0x01010101;  // 1.1.1.1
+  conn_stats_event.conn_events = CONN_OPEN;
+  conn_stats_event.wr_bytes = 3;
+  conn_stats_event.suppressed_events = 2;
+
+  ConnTracker& tracker = conn_trackers_mgr_.GetOrCreateConnTracker(conn_stats_event.conn_id);
+  tracker.AddConnStats(conn_stats_event);
+
+  auto& agg_stats = conn_stats_.UpdateStats();
+  ASSERT_THAT(agg_stats, SizeIs(1));
+  EXPECT_EQ(agg_stats.begin()->second.events_suppressed, 2);
+
+  conn_stats_event.timestamp_ns += 1;
+  conn_stats_event.suppressed_events += 5;
+  tracker.AddConnStats(conn_stats_event);
+
+  conn_stats_.UpdateStats();
+  EXPECT_TRUE(conn_stats_.Active(agg_stats.begin()->second));
+  EXPECT_EQ(agg_stats.begin()->second.events_suppressed, 7);
+}
+
 // Model various connections from clients to one server.
 // Check that server stats have the right aggregations.
 //   Client0 -> Server (1st connection)
@@ -167,7 +244,7 @@ TEST_F(ConnStatsTest, ServerSide) {
       .tsid = 10000,
   };
 
-  struct conn_stats_event_t conn0_stats_event;
+  struct conn_stats_event_t conn0_stats_event = {};
   conn0_stats_event.timestamp_ns = 0;
   conn0_stats_event.conn_id = kConnID0;
   conn0_stats_event.role = kRoleServer;
@@ -195,7 +272,7 @@ TEST_F(ConnStatsTest, ServerSide) {
       .tsid = 20000,
   };
 
-  struct conn_stats_event_t conn1_stats_event;
+  struct conn_stats_event_t conn1_stats_event = {};
   conn1_stats_event.timestamp_ns = 0;
   conn1_stats_event.conn_id = kConnID1;
   conn1_stats_event.role = kRoleServer;
@@ -223,7 +300,7 @@ TEST_F(ConnStatsTest, ServerSide) {
       .tsid = 30000,
   };
 
-  struct conn_stats_event_t conn2_stats_event;
+  struct conn_stats_event_t conn2_stats_event = {};
   conn2_stats_event.timestamp_ns = 0;
   conn2_stats_event.conn_id = kConnID3;
   conn2_stats_event.role = kRoleServer;
@@ -259,7 +336,7 @@ TEST_F(ConnStatsTest, ClientSide) {
       .tsid = 10000,
   };
 
-  struct conn_stats_event_t conn0_stats_event;
+  struct conn_stats_event_t conn0_stats_event = {};
   conn0_stats_event.timestamp_ns = 0;
   conn0_stats_event.conn_id = kConnID0;
   conn0_stats_event.role = kRoleClient;
@@ -287,7 +364,7 @@ TEST_F(ConnStatsTest, ClientSide) {
       .tsid = 20000,
   };
 
-  struct conn_stats_event_t conn1_stats_event;
+  struct conn_stats_event_t conn1_stats_event = {};
   conn1_stats_event.timestamp_ns = 0;
   conn1_stats_event.conn_id = kConnID1;
   conn1_stats_event.role = kRoleClient;
@@ -315,7 +392,7 @@ TEST_F(ConnStatsTest, ClientSide) {
       .tsid = 30000,
   };
 
-  struct conn_stats_event_t conn2_stats_event;
+  struct conn_stats_event_t conn2_stats_event = {};
   conn2_stats_event.timestamp_ns = 0;
   conn2_stats_event.conn_id = kConnID3;
   conn2_stats_event.role = kRoleClient;
@@ -346,7 +423,7 @@ TEST_F(ConnStatsTest, NoEventsIfNoRemoteAddr) {
       .tsid = 10000,
   };
 
-  struct conn_stats_event_t conn_stats_event;
+  struct conn_stats_event_t conn_stats_event = {};
   conn_stats_event.timestamp_ns = 0;
   conn_stats_event.conn_id = kConnID0;
   conn_stats_event.role = kRoleClient;
@@ -373,7 +450,7 @@ TEST_F(ConnStatsTest, DisabledConnTracker) {
       .tsid = 10000,
   };
 
-  struct conn_stats_event_t conn_stats_event;
+  struct conn_stats_event_t conn_stats_event = {};
   conn_stats_event.timestamp_ns = 0;
   conn_stats_event.conn_id = kConnID0;
   conn_stats_event.role = kRoleClient;
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <deque>
 #include <filesystem>
 #include <numeric>
@@ -50,6 +51,9 @@ DEFINE_int64(stirling_conn_trace_fd, kUnsetPIDFD, "Trace activity on this fd.");
 DEFINE_bool(
     stirling_conn_disable_to_bpf, true,
     "Send information about connection tracking disablement to BPF, so it can stop sending data.");
+DEFINE_bool(stirling_conn_known_endpoints_to_bpf, true,
+            "Send the protocols and roles confirmed by parsing to BPF, so it can skip protocol "
+            "inference on new connections to the same remote endpoints.");
 DEFINE_int64(
     stirling_check_proc_for_conn_close, true,
     "If enabled, Stirling will check Linux /proc on idle connections to see if they are closed.");
@@ -95,6 +99,7 @@ void ConnTracker::AddConnOpenEvent(const conn_event_t& conn_event, uint64_t time
     CONN_TRACE(1) << absl::Substitute("Clobbering existing ConnOpenEvent.");
   }
   open_info_.timestamp_ns = timestamp_ns;
+  open_info_.local_port = conn_event.local_port;
 
   SetRemoteAddr(conn_event.addr, "Inferred from conn_open.");
 
@@ -119,23 +124,24 @@ void ConnTracker::AddConnCloseEvent(const close_event_t& close_event, uint64_t t
   MarkForDeath();
 }
 
-void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
-  SetRole(event->attr.role, "inferred from data_event");
-  SetProtocol(event->attr.protocol, "inferred from data_event");
+void ConnTracker::AddDataEvent(const SocketDataEventView& event) {
+  SetRole(event.attr.role, "inferred from data_event");
+  SetProtocol(event.attr.protocol, "inferred from data_event");
 
   CheckTracker();
-  UpdateTimestamps(event->attr.timestamp_ns);
-  UpdateDataStats(*event);
+  UpdateTimestamps(event.attr.timestamp_ns);
+  UpdateDataStats(event);
+  ssl_ |= event.attr.ssl;
 
-  CONN_TRACE(1) << absl::Substitute("Data event received: $0", event->ToString());
+  CONN_TRACE(1) << absl::Substitute("Data event received: $0", event.ToString());
 
   // TODO(yzhao): Change to let userspace resolve the connection type and signal back to BPF.
   // Then we need at least one data event to let ConnTracker know the field descriptor.
-  if (event->attr.protocol == kProtocolUnknown) {
+  if (event.attr.protocol == kProtocolUnknown) {
     return;
   }
 
-  if (event->attr.protocol != protocol_) {
+  if (event.attr.protocol != protocol_) {
     return;
   }
 
@@ -144,12 +150,12 @@ void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
     return;
   }
 
-  switch (event->attr.direction) {
+  switch (event.attr.direction) {
     case TrafficDirection::kEgress: {
-      send_data_.AddData(std::move(event));
+      send_data_.AddData(event);
     } break;
     case TrafficDirection::kIngress: {
-      recv_data_.AddData(std::move(event));
+      recv_data_.AddData(event);
     } break;
   }
 }
@@ -171,6 +177,7 @@ void ConnTracker::AddConnStats(const conn_stats_event_t& event) {
 
     conn_stats_.set_bytes_recv(event.rd_bytes);
     conn_stats_.set_bytes_sent(event.wr_bytes);
+    conn_stats_.set_events_suppressed(event.suppressed_events);
     conn_stats_.set_closed(event.conn_events & CONN_CLOSE);
 
     last_conn_stats_update_ = event.timestamp_ns;
@@ -190,29 +197,27 @@ protocols::http2::HalfStream* ConnTracker::HalfStreamPtr(uint32_t stream_id, boo
   return streams.HalfStreamPtr(stream_id, write_event);
 }
 
-EndpointRole InferHTTP2Role(bool write_event, const std::unique_ptr<HTTP2HeaderEvent>& hdr) {
+EndpointRole InferHTTP2Role(bool write_event, std::string_view name) {
   // Look for standard headers to infer role.
   // Could look at others (:scheme, :path, :authority), but this seems sufficient.
 
-  if (hdr->name == ":method") {
+  if (name == ":method") {
     return (write_event) ? kRoleClient : kRoleServer;
   }
-  if (hdr->name == ":status") {
+  if (name == ":status") {
     return (write_event) ? kRoleServer : kRoleClient;
   }
 
   return kRoleUnknown;
 }
 
-void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
+bool ConnTracker::AcceptHTTP2HeaderAttr(const header_attr_t& attr, bool* write_event) {
   SetProtocol(kProtocolHTTP2, "inferred from http2 headers");
 
   if (protocol_ != kProtocolHTTP2) {
-    return;
+    return false;
   }
 
-  CONN_TRACE(2) << absl::Substitute("HTTP2 header event received: $0", hdr->ToString());
-
   if (conn_id_.fd == 0) {
     Disable(
         "FD of zero is usually not valid. One reason for could be that net.Conn could not be "
@@ -222,33 +227,59 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
 
   // A disabled tracker doesn't collect data events.
   if (state() == State::kDisabled) {
-    return;
+    return false;
   }
 
   CheckTracker();
 
   // Don't trace any control messages.
-  if (hdr->attr.stream_id == 0) {
-    return;
+  if (attr.stream_id == 0) {
+    return false;
   }
 
-  UpdateTimestamps(hdr->attr.timestamp_ns);
+  UpdateTimestamps(attr.timestamp_ns);
 
-  bool write_event = false;
-  switch (hdr->attr.type) {
+  switch (attr.type) {
     case HeaderEventType::kHeaderEventWrite:
-      write_event = true;
-      break;
+      *write_event = true;
+      return true;
     case HeaderEventType::kHeaderEventRead:
-      write_event = false;
-      break;
+      *write_event = false;
+      return true;
     default:
       LOG(WARNING) << "Unexpected event type";
-      return;
+      return false;
+  }
+}
+
+void ConnTracker::EndHTTP2HalfStream(const header_attr_t& attr,
+                                     protocols::http2::HalfStream* half_stream) {
+  // Only expect one end_stream signal per stream direction.
+  // Note: Duplicate calls to the writeHeaders (calls with same arguments) have been observed.
+  // It happens rarely, and root cause is unknown. It does not appear to be a retransmission due
+  // to dropped packets (as that is handled by the TCP layer).
+  // For now, just print a warning. The only harm is duplicated headers in the tables.
+  // Note that the duplicates are not necessarily restricted to headers which have the end_stream
+  // flag set; the end_stream cases are just the easiest to detect.
+  if (half_stream->end_stream()) {
+    CONN_TRACE(1) << absl::Substitute(
+        "Duplicate end_stream flag in header. stream_id: $0, conn_id: $1", attr.stream_id,
+        ::ToString(attr.conn_id));
+  }
+
+  half_stream->AddEndStream();
+}
+
+void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
+  CONN_TRACE(2) << absl::Substitute("HTTP2 header event received: $0", hdr->ToString());
+
+  bool write_event = false;
+  if (!AcceptHTTP2HeaderAttr(hdr->attr, &write_event)) {
+    return;
   }
 
   if (role_ == kRoleUnknown) {
-    EndpointRole role = InferHTTP2Role(write_event, hdr);
+    EndpointRole role = InferHTTP2Role(write_event, hdr->name);
     SetRole(role, "Inferred from http2 header");
   }
 
@@ -260,27 +291,41 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
     ECHECK(hdr->name.empty());
     ECHECK(hdr->value.empty());
 
-    // Only expect one end_stream signal per stream direction.
-    // Note: Duplicate calls to the writeHeaders (calls with same arguments) have been observed.
-    // It happens rarely, and root cause is unknown. It does not appear to be a retransmission due
-    // to dropped packets (as that is handled by the TCP layer).
-    // For now, just print a warning. The only harm is duplicated headers in the tables.
-    // Note that the duplicates are not necessarily restricted to headers which have the end_stream
-    // flag set; the end_stream cases are just the easiest to detect.
-    if (half_stream_ptr->end_stream()) {
-      CONN_TRACE(1) << absl::Substitute(
-          "Duplicate end_stream flag in header. stream_id: $0, conn_id: $1", hdr->attr.stream_id,
-          ::ToString(hdr->attr.conn_id));
-    }
-
-    half_stream_ptr->AddEndStream();
+    EndHTTP2HalfStream(hdr->attr, half_stream_ptr);
     return;
   }
 
-  half_stream_ptr->AddHeader(std::move(hdr->name), std::move(hdr->value));
+  half_stream_ptr->AddHeader(hdr->name, hdr->value);
   half_stream_ptr->UpdateTimestamp(hdr->attr.timestamp_ns);
 }
 
+void ConnTracker::AddHTTP2HeaderBlock(const HTTP2HeaderBlockEventView& block) {
+  CONN_TRACE(2) << absl::Substitute("HTTP2 header block event received: $0", block.ToString());
+
+  bool write_event = false;
+  if (!AcceptHTTP2HeaderAttr(block.attr, &write_event)) {
+    return;
+  }
+
+  protocols::http2::HalfStream* half_stream_ptr = HalfStreamPtr(block.attr.stream_id, write_event);
+
+  for (const auto& [name, value] : block.fields) {
+    if (role_ == kRoleUnknown) {
+      EndpointRole role = InferHTTP2Role(write_event, name);
+      SetRole(role, "Inferred from http2 header");
+    }
+    half_stream_ptr->AddHeader(name, value);
+  }
+  if (!block.fields.empty()) {
+    half_stream_ptr->UpdateTimestamp(block.attr.timestamp_ns);
+  }
+
+  // Unlike single header events, the end_stream flag applies after the headers of the block.
+  if (block.attr.end_stream) {
+    EndHTTP2HalfStream(block.attr, half_stream_ptr);
+  }
+}
+
 void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
   SetProtocol(kProtocolHTTP2, "inferred from http2 data");
 
@@ -345,11 +390,16 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
 
 template <>
 std::vector<protocols::http2::Record>
-ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>() {
+ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>(ProcessTimes* times) {
   protocols::RecordsWithErrorCount<protocols::http2::Record> result;
 
+  // HTTP2 events arrive already parsed, so all the time goes into stitching the streams.
+  const auto stitch_start = std::chrono::steady_clock::now();
   protocols::http2::ProcessHTTP2Streams(&http2_client_streams_, IsZombie(), &result);
   protocols::http2::ProcessHTTP2Streams(&http2_server_streams_, IsZombie(), &result);
+  if (times != nullptr) {
+    times->stitch += std::chrono::steady_clock::now() - stitch_start;
+  }
 
   UpdateResultStats(result);
 
@@ -363,6 +413,71 @@ void ConnTracker::Reset() {
   protocol_state_.reset();
 }
 
+void ConnTracker::EvictBufferedData() {
+  CONN_TRACE(1) << absl::Substitute("Evicting $0 bytes of buffered data", buffered_bytes());
+  Reset();
+  http2_client_streams_.mutable_streams()->clear();
+  http2_server_streams_.mutable_streams()->clear();
+  frames_bytes_ = 0;
+}
+
+void ConnTracker::ReportKnownEndpoint() {
+  if (known_endpoint_reported_ || conn_info_map_mgr_ == nullptr ||
+      !FLAGS_stirling_conn_known_endpoints_to_bpf) {
+    return;
+  }
+  known_endpoint_reported_ = true;
+
+  std::optional<struct known_endpoint_key_t> key = KnownEndpointKey();
+  if (key.has_value()) {
+    conn_info_map_mgr_->AddKnownEndpoint(*key, {.protocol = protocol_, .role = role_});
+  }
+}
+
+std::optional<struct known_endpoint_key_t> ConnTracker::KnownEndpointKey() const {
+  // Encrypted connections are inferred from the uprobes of their SSL library, and HTTP2 may be
+  // traced by uprobes too, so syscall-level inference must keep running for them.
+  if (ssl_ || protocol_ == kProtocolUnknown || protocol_ == kProtocolHTTP2 ||
+      role_ == kRoleUnknown) {
+    return std::nullopt;
+  }
+
+  // The key is compared bytewise by BPF, so padding must be zeroed as well.
+  struct known_endpoint_key_t key;
+  memset(&key, 0, sizeof(key));
+  key.upid = conn_id_.upid;
+
+  const SockAddr& remote_addr = open_info_.remote_addr;
+  switch (remote_addr.family) {
+    case SockAddrFamily::kIPv4:
+      key.family = AF_INET;
+      break;
+    case SockAddrFamily::kIPv6:
+      key.family = AF_INET6;
+      break;
+    default:
+      return std::nullopt;
+  }
+
+  if (role_ == kRoleServer) {
+    if (open_info_.local_port == 0) {
+      return std::nullopt;
+    }
+    key.port = htons(open_info_.local_port);
+    return key;
+  }
+
+  key.port = htons(remote_addr.port());
+  if (remote_addr.family == SockAddrFamily::kIPv4) {
+    const struct in_addr& addr = std::get<SockAddrIPv4>(remote_addr.addr).addr;
+    memcpy(key.addr, &addr, sizeof(addr));
+  } else {
+    const struct in6_addr& addr = std::get<SockAddrIPv6>(remote_addr.addr).addr;
+    memcpy(key.addr, &addr, sizeof(addr));
+  }
+  return key;
+}
+
 void ConnTracker::Disable(std::string_view reason) {
   if (state_ != State::kDisabled) {
     if (conn_info_map_mgr_ != nullptr && FLAGS_stirling_conn_disable_to_bpf) {
@@ -528,6 +643,9 @@ void ConnTracker::MarkForDeath(int32_t countdown) {
 
   if (death_countdown_ == -1) {
     CONN_TRACE(2) << absl::Substitute("Marked for death, countdown=$0", countdown);
+    if (manager_ != nullptr) {
+      manager_->AddZombie(this);
+    }
   }
 
   // We received the close event.
@@ -638,7 +756,7 @@ void ConnTracker::UpdateState(const std::vector<CIDRBlock>& cluster_cidrs) {
   }
 }
 
-void ConnTracker::UpdateDataStats(const SocketDataEvent& event) {
+void ConnTracker::UpdateDataStats(const SocketDataEventView& event) {
   switch (event.attr.direction) {
     case TrafficDirection::kEgress: {
       stats_.Increment(StatKey::kDataEventSent, 1);
@@ -655,7 +773,7 @@ void ConnTracker::UpdateDataStats(const SocketDataEvent& event) {
 
 void ConnTracker::IterationPreTick(
     const std::chrono::time_point<std::chrono::steady_clock>& iteration_time,
-    const std::vector<CIDRBlock>& cluster_cidrs, system::ProcParser* proc_parser,
+    const std::vector<CIDRBlock>& cluster_cidrs, FDLinkCache* fd_link_cache,
     system::SocketInfoManager* socket_info_mgr) {
   set_current_time(iteration_time);
 
@@ -671,7 +789,7 @@ void ConnTracker::IterationPreTick(
   // If remote_addr is missing, it means the connect/accept was not traced.
   // Attempt to infer the connection information, to populate remote_addr.
   if (open_info_.remote_addr.family == SockAddrFamily::kUnspecified && socket_info_mgr != nullptr) {
-    InferConnInfo(proc_parser, socket_info_mgr);
+    InferConnInfo(fd_link_cache, socket_info_mgr);
 
     // TODO(oazizi): If connection resolves to SockAddr type "Other",
     //               we should mark the state in BPF to Other too, so BPF stops tracing.
@@ -813,9 +931,9 @@ EndpointRole TranslateRole(system::ClientServerRole role) {
 
 }  // namespace
 
-void ConnTracker::InferConnInfo(system::ProcParser* proc_parser,
+void ConnTracker::InferConnInfo(FDLinkCache* fd_link_cache,
                                 system::SocketInfoManager* socket_info_mgr) {
-  DCHECK(proc_parser != nullptr);
+  DCHECK(fd_link_cache != nullptr);
   DCHECK(socket_info_mgr != nullptr);
 
   if (conn_resolution_failed_) {
@@ -827,7 +945,7 @@ void ConnTracker::InferConnInfo(system::ProcParser* proc_parser,
   }
 
   if (conn_resolver_ == nullptr) {
-    conn_resolver_ = std::make_unique<FDResolver>(proc_parser, conn_id_.upid.pid, conn_id_.fd);
+    conn_resolver_ = std::make_unique<FDResolver>(fd_link_cache, conn_id_.upid.pid, conn_id_.fd);
     bool success = conn_resolver_->Setup();
     if (!success) {
       conn_resolver_.reset();
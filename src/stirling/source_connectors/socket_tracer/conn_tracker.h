@@ -19,9 +19,11 @@
 #pragma once
 
 #include <any>
+#include <chrono>
 #include <deque>
 #include <list>
 #include <map>
+#include <optional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -47,6 +49,7 @@ DECLARE_bool(treat_loopback_as_in_cluster);
 DECLARE_int64(stirling_conn_trace_pid);
 DECLARE_int64(stirling_conn_trace_fd);
 DECLARE_bool(stirling_conn_disable_to_bpf);
+DECLARE_bool(stirling_conn_known_endpoints_to_bpf);
 DECLARE_int64(stirling_check_proc_for_conn_close);
 
 #define CONN_TRACE(level) LOG_IF(INFO, level <= debug_trace_level_) << ToString() << " "
@@ -65,6 +68,8 @@ struct SocketOpen {
   uint64_t timestamp_ns = 0;
   // TODO(yzhao): Consider using std::optional to indicate the address has not been initialized.
   SockAddr remote_addr;
+  // The local port of accepted connections, in host byte order. 0 if unknown.
+  uint16_t local_port = 0;
 };
 
 struct SocketClose {
@@ -101,6 +106,12 @@ class ConnTracker : NotCopyMoveable {
     // The number of valid/invalid records.
     kValidRecords,
     kInvalidRecords,
+
+    // The number of incomplete HTTP2 streams evicted to stay within the size limit.
+    kHTTP2StreamsEvicted,
+
+    // The number of MySQL/PgSQL prepared statements evicted to stay within the cache size.
+    kPreparedStatementsEvicted,
   };
 
   // State values change monotonically from lower to higher values; and cannot change reversely.
@@ -124,6 +135,10 @@ class ConnTracker : NotCopyMoveable {
 
     void set_bytes_sent(int64_t bytes_sent) { bytes_sent_ = bytes_sent; }
 
+    void set_events_suppressed(int64_t events_suppressed) {
+      events_suppressed_ = events_suppressed;
+    }
+
     int bytes_recv() { return bytes_recv_; }
     int bytes_sent() { return bytes_sent_; }
     int closed() { return closed_; }
@@ -148,14 +163,21 @@ class ConnTracker : NotCopyMoveable {
       last_reported_bytes_sent_ = bytes_sent_;
       return val;
     }
+    int EventsSuppressedSinceLastRead() {
+      int64_t val = events_suppressed_ - last_reported_events_suppressed_;
+      last_reported_events_suppressed_ = events_suppressed_;
+      return val;
+    }
 
    private:
     int64_t bytes_recv_ = 0;
     int64_t bytes_sent_ = 0;
+    int64_t events_suppressed_ = 0;
     bool closed_ = false;
 
     int64_t last_reported_bytes_recv_ = 0;
     int64_t last_reported_bytes_sent_ = 0;
+    int64_t last_reported_events_suppressed_ = 0;
     bool last_reported_open_ = false;
     bool last_reported_close_ = false;
   };
@@ -194,9 +216,12 @@ class ConnTracker : NotCopyMoveable {
   /**
    * Registers a BPF data event into the tracker.
    *
-   * @param event The data event from BPF.
+   * @param event The data event from BPF. Its message is copied into the tracker's data stream.
    */
-  void AddDataEvent(std::unique_ptr<SocketDataEvent> event);
+  void AddDataEvent(const SocketDataEventView& event);
+  void AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
+    AddDataEvent(SocketDataEventView(*event));
+  }
 
   /**
    * Registers a BPF connection stats event into the tracker.
@@ -214,6 +239,13 @@ class ConnTracker : NotCopyMoveable {
    */
   void AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> data);
 
+  /**
+   * Add all the recorded HTTP2 headers of a HEADERS frame.
+   *
+   * @param block The event from BPF uprobe.
+   */
+  void AddHTTP2HeaderBlock(const HTTP2HeaderBlockEventView& block);
+
   /**
    * Add a recorded HTTP2 data frame.
    * The struct should contain stream ID and other meta-data so it can matched with other HTTP2
@@ -228,25 +260,35 @@ class ConnTracker : NotCopyMoveable {
    *
    * Intended for cases where the accept/connect was not traced.
    *
-   * @param proc_parser Pointer to a proc_parser for access to /proc filesystem.
+   * @param fd_link_cache Pointer to a cache of the FD links of processes, read from /proc.
    * @param connections A map of inodes to endpoint information.
    */
-  void InferConnInfo(system::ProcParser* proc_parser, system::SocketInfoManager* socket_info_mgr);
+  void InferConnInfo(FDLinkCache* fd_link_cache, system::SocketInfoManager* socket_info_mgr);
+
+  // Time spent in each phase of ProcessToRecords().
+  struct ProcessTimes {
+    std::chrono::nanoseconds parse{0};
+    std::chrono::nanoseconds stitch{0};
+  };
 
   /**
    * Processes the connection tracker, parsing raw events into frames,
    * and frames into record.
    *
    * @tparam TRecordType the type of the entries to be parsed.
+   * @param times If not null, the time spent parsing and stitching is added to it.
    * @return Vector of processed entries.
    */
   template <typename TProtocolTraits>
-  std::vector<typename TProtocolTraits::record_type> ProcessToRecords() {
+  std::vector<typename TProtocolTraits::record_type> ProcessToRecords(
+      ProcessTimes* times = nullptr) {
     using TRecordType = typename TProtocolTraits::record_type;
     using TFrameType = typename TProtocolTraits::frame_type;
     using TStateType = typename TProtocolTraits::state_type;
 
+    const auto parse_start = std::chrono::steady_clock::now();
     DataStreamsToFrames<TFrameType>();
+    const auto stitch_start = std::chrono::steady_clock::now();
 
     InitProtocolState<TStateType>();
 
@@ -263,7 +305,16 @@ class ConnTracker : NotCopyMoveable {
 
     CONN_TRACE(1) << absl::Substitute("records=$0", result.records.size());
 
+    if (times != nullptr) {
+      times->parse += stitch_start - parse_start;
+      times->stitch += std::chrono::steady_clock::now() - stitch_start;
+    }
+
     UpdateResultStats(result);
+    if constexpr (std::is_same_v<TStateType, protocols::mysql::StateWrapper> ||
+                  std::is_same_v<TStateType, protocols::pgsql::StateWrapper>) {
+      UpdateStatementCacheStats(state_ptr->global.prepared_statements);
+    }
 
     return result.records;
   }
@@ -311,6 +362,13 @@ class ConnTracker : NotCopyMoveable {
    */
   const SockAddr& remote_endpoint() const { return open_info_.remote_addr; }
 
+  /**
+   * Returns the key of the connection's endpoint in the BPF known_endpoints_map, if its protocol
+   * and role can be reported there: the remote address and port for clients, and the local
+   * (listening) port for servers, since the remote ports of their clients are ephemeral.
+   */
+  std::optional<struct known_endpoint_key_t> KnownEndpointKey() const;
+
   /**
    * Get the connection information (e.g. remote IP, port, PID, etc.) for this connection.
    *
@@ -356,7 +414,7 @@ class ConnTracker : NotCopyMoveable {
    * @return Returns the a timestamp the last time an event was added to this tracker (using
    * steady_clock).
    */
-  std::chrono::time_point<std::chrono::steady_clock> last_update_timestamp() {
+  std::chrono::time_point<std::chrono::steady_clock> last_update_timestamp() const {
     return last_activity_timestamp_;
   }
 
@@ -428,12 +486,11 @@ class ConnTracker : NotCopyMoveable {
    * connection tracker.
    * Should be called once per sampling, before ProcessToRecords().
    *
-   * @param proc_parser Pointer to a proc_parser for access to /proc filesystem.
+   * @param fd_link_cache Pointer to a cache of the FD links of processes, read from /proc.
    * @param connections A map of inodes to endpoint information.
    */
   void IterationPreTick(const std::chrono::time_point<std::chrono::steady_clock>& iteration_time,
-                        const std::vector<CIDRBlock>& cluster_cidrs,
-                        system::ProcParser* proc_parser,
+                        const std::vector<CIDRBlock>& cluster_cidrs, FDLinkCache* fd_link_cache,
                         system::SocketInfoManager* socket_info_mgr);
 
   /**
@@ -512,29 +569,52 @@ class ConnTracker : NotCopyMoveable {
     using TFrameType = typename TProtocolTraits::frame_type;
     using TStateType = typename TProtocolTraits::state_type;
 
+    size_t send_frames_bytes = 0;
+    size_t recv_frames_bytes = 0;
     if constexpr (std::is_same_v<TFrameType, protocols::http2::Stream>) {
-      http2_client_streams_.Cleanup(size_limit_bytes, expiry_timestamp);
-      http2_server_streams_.Cleanup(size_limit_bytes, expiry_timestamp);
+      stats_.Increment(StatKey::kHTTP2StreamsEvicted,
+                       http2_client_streams_.Cleanup(size_limit_bytes, expiry_timestamp));
+      stats_.Increment(StatKey::kHTTP2StreamsEvicted,
+                       http2_server_streams_.Cleanup(size_limit_bytes, expiry_timestamp));
+      send_frames_bytes = http2_client_streams_.StreamsSize();
+      recv_frames_bytes = http2_server_streams_.StreamsSize();
     } else {
-      send_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
-      recv_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
+      send_frames_bytes = send_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
+      recv_frames_bytes = recv_data_.CleanupFrames<TFrameType>(size_limit_bytes, expiry_timestamp);
     }
 
     auto* state = protocol_state<TStateType>();
     if (send_data_.CleanupEvents()) {
+      send_frames_bytes = 0;
       if (state != nullptr) {
         state->global = {};
         state->send = {};
       }
     }
     if (recv_data_.CleanupEvents()) {
+      recv_frames_bytes = 0;
       if (state != nullptr) {
         state->global = {};
         state->recv = {};
       }
     }
+    frames_bytes_ = send_frames_bytes + recv_frames_bytes;
+  }
+
+  /**
+   * The approximate memory held by the data buffered in the tracker: the raw events, and the
+   * frames (or HTTP2 streams) that are parsed but not yet stitched, as of the last Cleanup().
+   */
+  size_t buffered_bytes() const {
+    return send_data_.data_buffer().size() + recv_data_.data_buffer().size() + frames_bytes_;
   }
 
+  /**
+   * Drops all of the data buffered in the tracker, like for stuck streams, to free its memory.
+   * The tracker keeps tracing the connection.
+   */
+  void EvictBufferedData();
+
   static void SetConnInfoMapManager(const std::shared_ptr<ConnInfoMapManager>& conn_info_map_mgr) {
     conn_info_map_mgr_ = conn_info_map_mgr;
   }
@@ -589,7 +669,11 @@ class ConnTracker : NotCopyMoveable {
   bool IsRemoteAddrInCluster(const std::vector<CIDRBlock>& cluster_cidrs);
   void UpdateState(const std::vector<CIDRBlock>& cluster_cidrs);
 
-  void UpdateDataStats(const SocketDataEvent& event);
+  void UpdateDataStats(const SocketDataEventView& event);
+
+  // Reports the protocol and role of the endpoint to BPF, once they are confirmed by records, so
+  // new connections to the endpoint can skip protocol inference.
+  void ReportKnownEndpoint();
 
   template <typename TFrameType>
   void DataStreamsToFrames() {
@@ -602,10 +686,20 @@ class ConnTracker : NotCopyMoveable {
     req_data_ptr->template ProcessBytesToFrames<TFrameType>(MessageType::kRequest);
   }
 
+  template <typename TCache>
+  void UpdateStatementCacheStats(const TCache& cache) {
+    // The cache counts its evictions over the lifetime of the connection.
+    stats_.Increment(StatKey::kPreparedStatementsEvicted,
+                     cache.evictions() - stats_.Get(StatKey::kPreparedStatementsEvicted));
+  }
+
   template <typename TRecordType>
   void UpdateResultStats(const protocols::RecordsWithErrorCount<TRecordType>& result) {
     stats_.Increment(StatKey::kInvalidRecords, result.error_count);
     stats_.Increment(StatKey::kValidRecords, result.records.size());
+    if (!result.records.empty()) {
+      ReportKnownEndpoint();
+    }
   }
 
   int debug_trace_level_ = 0;
@@ -633,9 +727,19 @@ class ConnTracker : NotCopyMoveable {
   HTTP2StreamsContainer http2_client_streams_;
   HTTP2StreamsContainer http2_server_streams_;
 
+  // The size of the parsed frames, or of the HTTP2 streams, as of the last Cleanup().
+  size_t frames_bytes_ = 0;
+
   // Access the appropriate HalfStream object for the given stream ID.
   protocols::http2::HalfStream* HalfStreamPtr(uint32_t stream_id, bool write_event);
 
+  // Runs the checks shared by all HTTP2 header events. Returns false if the headers should be
+  // dropped; otherwise sets write_event from the event type.
+  bool AcceptHTTP2HeaderAttr(const header_attr_t& attr, bool* write_event);
+
+  // Marks the end of the half stream, on an HTTP2 header event with the end_stream flag.
+  void EndHTTP2HalfStream(const header_attr_t& attr, protocols::http2::HalfStream* half_stream);
+
   // The timestamp of the last activity on this connection.
   // Recorded as the latest timestamp on a BPF event.
   uint64_t last_bpf_timestamp_ns_ = 0;
@@ -650,6 +754,11 @@ class ConnTracker : NotCopyMoveable {
   // Filter for less spammy trace logs.
   bool suppress_fd_link_log_ = false;
 
+  // Whether any data event of the connection was from an encrypted channel.
+  bool ssl_ = false;
+
+  bool known_endpoint_reported_ = false;
+
   // Some idleness checks used to trigger checks for closed connections.
   // The threshold undergoes an exponential backoff if connection is not closed.
   bool idle_iteration_ = false;
@@ -684,9 +793,14 @@ class ConnTracker : NotCopyMoveable {
   template <typename TProtocolTraits>
   friend std::string DebugString(const ConnTracker& c, std::string_view prefix);
 
-  // A pointer to the conn trackers manager, used for notifying a protocol change.
+  // A pointer to the conn trackers manager, used for notifying a protocol change,
+  // and for notifying that the tracker was marked for death.
   ConnTrackersManager* manager_ = nullptr;
 
+  // The position of this tracker in the active trackers list of the manager.
+  // Only valid while the tracker is active; owned by the manager.
+  std::list<ConnTracker*>::iterator active_trackers_iter_;
+
   friend class ConnTrackersManager;
   friend class ConnTrackersManagerTest;
   friend class ConnTrackerGenerationsTest;
@@ -696,7 +810,7 @@ class ConnTracker : NotCopyMoveable {
 // See https://en.cppreference.com/w/cpp/language/member_template
 template <>
 std::vector<protocols::http2::Record>
-ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>();
+ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>(ProcessTimes* times);
 
 template <typename TProtocolTraits>
 std::string DebugString(const ConnTracker& c, std::string_view prefix) {
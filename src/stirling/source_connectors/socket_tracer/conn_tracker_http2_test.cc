@@ -21,6 +21,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <string_view>
+
 #include "src/common/base/types.h"
 #include "src/stirling/source_connectors/socket_tracer/testing/http2_stream_generator.h"
 
@@ -103,6 +106,47 @@ TEST_F(ConnTrackerHTTP2Test, BasicHeader) {
   EXPECT_THAT(records[0].recv.headers(), UnorderedElementsAre(Pair(":status", "200")));
 }
 
+void SetHeaderField(std::string_view str, header_field_t* field) {
+  field->size = str.size();
+  str.copy(field->msg, sizeof(field->msg));
+}
+
+TEST_F(ConnTrackerHTTP2Test, HeaderBlock) {
+  const int kStreamID = 7;
+  auto event = std::make_unique<go_grpc_http2_header_block_event_t>();
+  event->attr.conn_id = kConnID;
+  event->attr.stream_id = kStreamID;
+  HTTP2HeaderBlockEventView block;
+
+  event->attr.type = kHeaderEventWrite;
+  event->attr.timestamp_ns = real_clock_.now();
+  event->attr.end_stream = true;
+  event->num_fields = 2;
+  SetHeaderField(":method", &event->fields[0].name);
+  SetHeaderField("post", &event->fields[0].value);
+  SetHeaderField(":path", &event->fields[1].name);
+  SetHeaderField("/magic", &event->fields[1].value);
+  block.Decode(event.get());
+  EXPECT_THAT(block.fields, ElementsAre(Pair(":method", "post"), Pair(":path", "/magic")));
+  tracker_.AddHTTP2HeaderBlock(block);
+
+  event->attr.type = kHeaderEventRead;
+  event->attr.timestamp_ns = real_clock_.now();
+  event->num_fields = 1;
+  SetHeaderField(":status", &event->fields[0].name);
+  SetHeaderField("200", &event->fields[0].value);
+  block.Decode(event.get());
+  tracker_.AddHTTP2HeaderBlock(block);
+
+  std::vector<http2::Record> records = tracker_.ProcessToRecords<http2::ProtocolTraits>();
+
+  ASSERT_EQ(records.size(), 1);
+  EXPECT_EQ(tracker_.role(), kRoleClient);
+  EXPECT_THAT(records[0].send.headers(),
+              UnorderedElementsAre(Pair(":method", "post"), Pair(":path", "/magic")));
+  EXPECT_THAT(records[0].recv.headers(), UnorderedElementsAre(Pair(":status", "200")));
+}
+
 TEST_F(ConnTrackerHTTP2Test, MultipleDataFrames) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
@@ -279,6 +323,24 @@ TEST_F(ConnTrackerHTTP2Test, HTTP2StreamsCleanedUpAfterBreachingSizeLimit) {
   EXPECT_EQ(tracker_.http2_server_streams_size(), 0);
 }
 
+TEST_F(ConnTrackerHTTP2Test, HTTP2OldestStreamsEvictedAfterBreachingSizeLimit) {
+  auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, 1);
+  for (uint32_t stream_id : {3, 1, 5}) {
+    auto header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
+    header_event->attr.stream_id = stream_id;
+    tracker_.AddHTTP2Header(std::move(header_event));
+  }
+
+  // Each stream holds the 11 bytes of its header, so only the 2 newest streams fit.
+  const int size_limit_bytes = 22;
+  auto expiry_timestamp = std::chrono::steady_clock::now() - std::chrono::seconds(10000);
+  tracker_.ProcessToRecords<http2::ProtocolTraits>();
+  tracker_.Cleanup<http2::ProtocolTraits>(size_limit_bytes, expiry_timestamp);
+
+  EXPECT_EQ(tracker_.http2_client_streams_size(), 2);
+  EXPECT_EQ(tracker_.GetStat(ConnTracker::StatKey::kHTTP2StreamsEvicted), 1);
+}
+
 TEST_F(ConnTrackerHTTP2Test, HTTP2StreamsCleanedUpAfterExpiration) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
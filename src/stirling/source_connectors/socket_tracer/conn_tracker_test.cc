@@ -18,6 +18,10 @@
 
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <optional>
 #include <tuple>
 
 #include <gmock/gmock.h>
@@ -434,7 +438,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForIntraClusterRemoteEndpoint) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -453,7 +457,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForLocalhostRemoteEndpoint) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -467,7 +471,7 @@ TEST_F(ConnTrackerTest, TrackerCollectingForClientSideTracingWithNoCIDR) {
   tracker.AddControlEvent(conn);
   tracker.SetProtocol(kProtocolHTTP, "testing");
   tracker.SetRole(kRoleClient, "testing");
-  tracker.IterationPreTick(now_, /*cluster_cidrs*/ {}, /*proc_parser*/ nullptr,
+  tracker.IterationPreTick(now_, /*cluster_cidrs*/ {}, /*fd_link_cache*/ nullptr,
                            /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kCollecting, tracker.state());
 }
@@ -484,7 +488,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForUnixDomainSocket) {
 
   ConnTracker tracker;
   tracker.AddControlEvent(conn);
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -501,7 +505,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledForOtherSockAddrFamily) {
 
   ConnTracker tracker;
   tracker.AddControlEvent(conn);
-  tracker.IterationPreTick(now_, cidrs, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+  tracker.IterationPreTick(now_, cidrs, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
@@ -519,7 +523,7 @@ TEST_F(ConnTrackerTest, TrackerDisabledAfterMapping) {
     tracker.AddControlEvent(conn);
     tracker.SetProtocol(kProtocolHTTP, "testing");
     tracker.SetRole(kRoleClient, "testing");
-    tracker.IterationPreTick(now_, {cidr}, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+    tracker.IterationPreTick(now_, {cidr}, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
     EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state())
         << "Got: " << magic_enum::enum_name(tracker.state());
   }
@@ -535,12 +539,70 @@ TEST_F(ConnTrackerTest, TrackerDisabledAfterMapping) {
     tracker.AddControlEvent(conn);
     tracker.SetProtocol(kProtocolHTTP, "testing");
     tracker.SetRole(kRoleClient, "testing");
-    tracker.IterationPreTick(now_, {cidr}, /*proc_parser*/ nullptr, /*connections*/ nullptr);
+    tracker.IterationPreTick(now_, {cidr}, /*fd_link_cache*/ nullptr, /*connections*/ nullptr);
     EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state())
         << "Got: " << magic_enum::enum_name(tracker.state());
   }
 }
 
+// Tests that clients are reported to BPF by the remote endpoint, and servers by their local port.
+TEST_F(ConnTrackerTest, KnownEndpointKey) {
+  testing::EventGenerator event_gen(&real_clock_);
+  {
+    struct socket_control_event_t conn = event_gen.InitConn(kRoleClient);
+    testing::SetIPv4RemoteAddr(&conn, "1.2.3.4", /*port*/ 8080);
+
+    ConnTracker tracker;
+    tracker.AddControlEvent(conn);
+    // Not reported until the protocol is known.
+    EXPECT_FALSE(tracker.KnownEndpointKey().has_value());
+
+    tracker.SetProtocol(kProtocolHTTP, "testing");
+    std::optional<struct known_endpoint_key_t> key = tracker.KnownEndpointKey();
+    ASSERT_TRUE(key.has_value());
+    EXPECT_EQ(key->upid.pid, conn.conn_id.upid.pid);
+    EXPECT_EQ(key->family, AF_INET);
+    EXPECT_EQ(ntohs(key->port), 8080);
+    EXPECT_EQ(0, memcmp(key->addr, &conn.open.addr.in4.sin_addr, sizeof(struct in_addr)));
+  }
+  {
+    struct socket_control_event_t conn = event_gen.InitConn(kRoleServer);
+    // The remote port of the client is ephemeral.
+    testing::SetIPv4RemoteAddr(&conn, "1.2.3.4", /*port*/ 54321);
+    conn.open.local_port = 8080;
+
+    ConnTracker tracker;
+    tracker.AddControlEvent(conn);
+    tracker.SetProtocol(kProtocolHTTP, "testing");
+    std::optional<struct known_endpoint_key_t> key = tracker.KnownEndpointKey();
+    ASSERT_TRUE(key.has_value());
+    EXPECT_EQ(key->family, AF_INET);
+    EXPECT_EQ(ntohs(key->port), 8080);
+    const uint8_t kZeroAddr[sizeof(key->addr)] = {};
+    EXPECT_EQ(0, memcmp(key->addr, kZeroAddr, sizeof(kZeroAddr)));
+  }
+  {
+    // Without the local port, a server can't be reported.
+    struct socket_control_event_t conn = event_gen.InitConn(kRoleServer);
+    testing::SetIPv4RemoteAddr(&conn, "1.2.3.4", /*port*/ 54321);
+
+    ConnTracker tracker;
+    tracker.AddControlEvent(conn);
+    tracker.SetProtocol(kProtocolHTTP, "testing");
+    EXPECT_FALSE(tracker.KnownEndpointKey().has_value());
+  }
+  {
+    // HTTP2 may be traced by uprobes, so it is never reported.
+    struct socket_control_event_t conn = event_gen.InitConn(kRoleClient);
+    testing::SetIPv4RemoteAddr(&conn, "1.2.3.4", /*port*/ 8080);
+
+    ConnTracker tracker;
+    tracker.AddControlEvent(conn);
+    tracker.SetProtocol(kProtocolHTTP2, "testing");
+    EXPECT_FALSE(tracker.KnownEndpointKey().has_value());
+  }
+}
+
 TEST_F(ConnTrackerTest, DisabledDueToParsingFailureRate) {
   using mysql::testutils::GenErr;
   using mysql::testutils::GenRawPacket;
@@ -683,7 +745,7 @@ TEST_F(ConnTrackerTest, ConnStats) {
       .tsid = 111110,
   };
 
-  struct conn_stats_event_t conn_stats_event;
+  struct conn_stats_event_t conn_stats_event = {};
   conn_stats_event.timestamp_ns = 0;
   conn_stats_event.conn_id = kConnID0;
   conn_stats_event.role = kRoleClient;
@@ -18,6 +18,10 @@
 
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 
+#include <algorithm>
+
+#include <absl/strings/strip.h>
+
 DEFINE_double(
     stirling_conn_tracker_cleanup_threshold, 0.2,
     "Percentage of trackers that are ready for destruction that will trigger a memory cleanup");
@@ -99,6 +103,21 @@ int ConnTrackerGenerations::CleanupGenerations(ConnTrackerPool* tracker_pool) {
   return num_erased;
 }
 
+bool ConnTrackerGenerations::Erase(uint64_t tsid, ConnTrackerPool* tracker_pool) {
+  auto iter = generations_.find(tsid);
+  if (iter == generations_.end()) {
+    return false;
+  }
+
+  if (iter->second.get() == oldest_generation_) {
+    oldest_generation_ = nullptr;
+  }
+
+  tracker_pool->Recycle(std::move(iter->second));
+  generations_.erase(iter);
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 // ConnTrackersManager
 //-----------------------------------------------------------------------------
@@ -139,14 +158,21 @@ ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_i
   const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
   DCHECK_NE(conn_map_key, 0) << "Connection map key cannot be 0, pid must be wrong";
 
-  ConnTrackerGenerations& conn_trackers = conn_id_tracker_generations_[conn_map_key];
+  ConnTrackerGenerations& conn_trackers = GenerationsShard(conn_map_key)[conn_map_key];
   auto [conn_tracker_ptr, created] = conn_trackers.GetOrCreate(conn_id.tsid, &trackers_pool_);
 
   if (created) {
-    active_trackers_.push_back(conn_tracker_ptr);
+    conn_tracker_ptr->active_trackers_iter_ =
+        active_trackers_.insert(active_trackers_.end(), conn_tracker_ptr);
     conn_tracker_ptr->manager_ = this;
     conn_tracker_ptr->SetConnID(conn_id);
 
+    // A new tracker that is not the latest generation is marked for death on creation,
+    // before it knows about the manager.
+    if (conn_tracker_ptr->IsZombie()) {
+      AddZombie(conn_tracker_ptr);
+    }
+
     stats_.Increment(StatKey::kTotal);
     stats_.Increment(StatKey::kCreated);
   }
@@ -157,9 +183,10 @@ ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_i
 
 StatusOr<const ConnTracker*> ConnTrackersManager::GetConnTracker(uint32_t pid, int32_t fd) const {
   const uint64_t conn_map_key = GetConnMapKey(pid, fd);
+  const ConnTrackerGenerationsMap& shard = GenerationsShard(conn_map_key);
 
-  auto tracker_set_it = conn_id_tracker_generations_.find(conn_map_key);
-  if (tracker_set_it == conn_id_tracker_generations_.end()) {
+  auto tracker_set_it = shard.find(conn_map_key);
+  if (tracker_set_it == shard.end()) {
     return error::NotFound("Could not find the tracker with pid=$0 fd=$1.", pid, fd);
   }
 
@@ -175,19 +202,32 @@ StatusOr<const ConnTracker*> ConnTrackersManager::GetConnTracker(uint32_t pid, i
   return tracker_generations.GetActive();
 }
 
+ConnTrackersManager::ConnTrackerGenerationsMap& ConnTrackersManager::GenerationsShard(
+    uint64_t conn_map_key) {
+  return conn_id_tracker_generations_[absl::Hash<uint64_t>{}(conn_map_key) % kNumShards];
+}
+
+const ConnTrackersManager::ConnTrackerGenerationsMap& ConnTrackersManager::GenerationsShard(
+    uint64_t conn_map_key) const {
+  return conn_id_tracker_generations_[absl::Hash<uint64_t>{}(conn_map_key) % kNumShards];
+}
+
+void ConnTrackersManager::AddZombie(ConnTracker* tracker) { zombie_trackers_.push_back(tracker); }
+
 void ConnTrackersManager::CleanupTrackers() {
-  {
-    auto iter = active_trackers_.begin();
-    while (iter != active_trackers_.end()) {
-      const auto& tracker = *iter;
-      if (tracker->ReadyForDestruction()) {
-        active_trackers_.erase(iter++);
-        stats_.Increment(StatKey::kReadyForDestruction);
-      } else {
-        ++iter;
-      }
+  // Only zombies can become ready for destruction, so there is no need to look at the rest of
+  // the active trackers. Zombies that are not ready yet are compacted in place.
+  size_t num_zombies = 0;
+  for (ConnTracker* tracker : zombie_trackers_) {
+    if (tracker->ReadyForDestruction()) {
+      active_trackers_.erase(tracker->active_trackers_iter_);
+      ready_trackers_.push_back(tracker);
+      stats_.Increment(StatKey::kReadyForDestruction);
+    } else {
+      zombie_trackers_[num_zombies++] = tracker;
     }
   }
+  zombie_trackers_.resize(num_zombies);
 
   // As a performance optimization, we only clean up trackers once we reach a certain threshold
   // of trackers that are ready for destruction.
@@ -195,33 +235,45 @@ void ConnTrackersManager::CleanupTrackers() {
   double percent_destroyable =
       1.0 * stats_.Get(StatKey::kReadyForDestruction) / stats_.Get(StatKey::kTotal);
   if (percent_destroyable > FLAGS_stirling_conn_tracker_cleanup_threshold) {
-    // Outer loop iterates through tracker sets (keyed by PID+FD),
-    // while inner loop iterates through generations of trackers for that PID+FD pair.
-    auto iter = conn_id_tracker_generations_.begin();
-    while (iter != conn_id_tracker_generations_.end()) {
-      auto& tracker_generations = iter->second;
+    DestroyReadyTrackers();
+  }
+
+  DebugChecks();
+}
 
-      int num_erased = tracker_generations.CleanupGenerations(&trackers_pool_);
+void ConnTrackersManager::DestroyReadyTrackers() {
+  for (ConnTracker* tracker : ready_trackers_) {
+    // Copy the conn_id, since the tracker is recycled by Erase().
+    const struct conn_id_t conn_id = tracker->conn_id();
+    const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
+    ConnTrackerGenerationsMap& shard = GenerationsShard(conn_map_key);
+
+    auto iter = shard.find(conn_map_key);
+    if (iter == shard.end()) {
+      DCHECK(false) << absl::Substitute("Ready tracker is not in the tracker map: pid=$0 fd=$1",
+                                        conn_id.upid.pid, conn_id.fd);
+      continue;
+    }
 
-      stats_.Decrement(StatKey::kTotal, num_erased);
-      stats_.Decrement(StatKey::kReadyForDestruction, num_erased);
-      stats_.Increment(StatKey::kDestroyed, num_erased);
+    auto& tracker_generations = iter->second;
+    if (tracker_generations.Erase(conn_id.tsid, &trackers_pool_)) {
+      stats_.Decrement(StatKey::kTotal);
+      stats_.Decrement(StatKey::kReadyForDestruction);
+      stats_.Increment(StatKey::kDestroyed);
+    }
 
-      if (tracker_generations.empty()) {
-        conn_id_tracker_generations_.erase(iter++);
-        stats_.Increment(StatKey::kDestroyedGens);
-      } else {
-        ++iter;
-      }
+    if (tracker_generations.empty()) {
+      shard.erase(iter);
+      stats_.Increment(StatKey::kDestroyedGens);
     }
   }
-
-  DebugChecks();
+  ready_trackers_.clear();
 }
 
 void ConnTrackersManager::DebugChecks() const {
   DCHECK_EQ(stats_.Get(StatKey::kTotal),
             active_trackers_.size() + stats_.Get(StatKey::kReadyForDestruction));
+  DCHECK_EQ(stats_.Get(StatKey::kReadyForDestruction), ready_trackers_.size());
 }
 
 std::string ConnTrackersManager::DebugInfo() const {
@@ -239,7 +291,65 @@ std::string ConnTrackersManager::DebugInfo() const {
   return out;
 }
 
-std::string ConnTrackersManager::StatsString() const { return stats_.Print(); }
+int ConnTrackersManager::EnforceMemoryBudget(size_t budget_bytes) {
+  // Evicting down to a bit below the budget keeps it from being exceeded again right away.
+  constexpr double kEvictionTarget = 0.9;
+
+  buffered_bytes_by_protocol_ = {};
+  size_t total_bytes = 0;
+  std::vector<ConnTracker*> buffering_trackers;
+  for (ConnTracker* tracker : active_trackers_) {
+    size_t bytes = tracker->buffered_bytes();
+    if (bytes == 0) {
+      continue;
+    }
+    buffered_bytes_by_protocol_[tracker->protocol()] += bytes;
+    total_bytes += bytes;
+    buffering_trackers.push_back(tracker);
+  }
+
+  if (budget_bytes == 0) {
+    memory_pressure_ = 0.0;
+    return 0;
+  }
+  memory_pressure_ = static_cast<double>(total_bytes) / budget_bytes;
+  if (total_bytes <= budget_bytes) {
+    return 0;
+  }
+
+  std::sort(buffering_trackers.begin(), buffering_trackers.end(),
+            [](const ConnTracker* a, const ConnTracker* b) {
+              return a->last_update_timestamp() < b->last_update_timestamp();
+            });
+  const size_t target_bytes = budget_bytes * kEvictionTarget;
+  int num_evicted = 0;
+  for (ConnTracker* tracker : buffering_trackers) {
+    if (total_bytes <= target_bytes) {
+      break;
+    }
+    size_t bytes = tracker->buffered_bytes();
+    tracker->EvictBufferedData();
+    buffered_bytes_by_protocol_[tracker->protocol()] -= bytes;
+    total_bytes -= bytes;
+    ++num_evicted;
+  }
+  stats_.Increment(StatKey::kBufferedDataEvicted, num_evicted);
+  return num_evicted;
+}
+
+std::string ConnTrackersManager::StatsString() const {
+  std::string out = stats_.Print();
+  for (auto protocol : magic_enum::enum_values<TrafficProtocol>()) {
+    if (protocol == kNumProtocols) {
+      continue;
+    }
+    absl::StrAppend(&out, absl::Substitute("buffered_bytes_$0=$1 ",
+                                           absl::StripPrefix(magic_enum::enum_name(protocol),
+                                                             "kProtocol"),
+                                           buffered_bytes_by_protocol_[protocol]));
+  }
+  return out;
+}
 
 void ConnTrackersManager::ComputeProtocolStats() {
   absl::flat_hash_map<TrafficProtocol, int> protocol_count;
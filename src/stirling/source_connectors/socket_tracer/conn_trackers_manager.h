@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <array>
 #include <list>
 #include <map>
 #include <memory>
@@ -72,6 +73,13 @@ class ConnTrackerGenerations {
    */
   int CleanupGenerations(ConnTrackerPool* tracker_pool);
 
+  /**
+   * Removes the tracker with the specified TSID, and pushes it into the tracker pool for recycling.
+   *
+   * @return true if a tracker was removed.
+   */
+  bool Erase(uint64_t tsid, ConnTrackerPool* tracker_pool);
+
  private:
   // A map of TSID to ConnTrackers.
   absl::flat_hash_map<uint64_t, std::unique_ptr<ConnTracker>> generations_;
@@ -96,6 +104,10 @@ class ConnTrackersManager {
     kDestroyed,
     kDestroyedGens,
 
+    // The number of times the buffered data of a tracker was evicted to stay within the memory
+    // budget.
+    kBufferedDataEvicted,
+
     kProtocolUnknown,
     kProtocolHTTP,
     kProtocolHTTP2,
@@ -126,11 +138,34 @@ class ConnTrackersManager {
 
   /**
    * Deletes trackers that are ReadyForDestruction().
-   * Call this only after accumulating enough trackers to clean-up, to avoid the performance
-   * impact of scanning through all trackers every iteration.
+   * Only trackers that were marked for death are visited, so the cost is proportional to the
+   * number of expiring trackers, rather than to the number of trackers held.
+   * Destruction itself is batched until enough trackers are ready for destruction.
    */
   void CleanupTrackers();
 
+  /**
+   * Keeps the data buffered by the active trackers (see ConnTracker::buffered_bytes()) within
+   * budget_bytes, by evicting the data of the least recently active trackers first. Records the
+   * buffered bytes of each protocol along the way. A budget of 0 disables the eviction.
+   *
+   * @return the number of trackers whose data was evicted.
+   */
+  int EnforceMemoryBudget(size_t budget_bytes);
+
+  /**
+   * The share of the memory budget that the trackers used at the last EnforceMemoryBudget(), before
+   * any eviction. Above 1 if the budget was exceeded; 0 if there is no budget.
+   */
+  double memory_pressure() const { return memory_pressure_; }
+
+  /**
+   * The bytes buffered by the trackers of the protocol, as of the last EnforceMemoryBudget().
+   */
+  size_t buffered_bytes(TrafficProtocol protocol) const {
+    return buffered_bytes_by_protocol_[protocol];
+  }
+
   /**
    * Returns extensive debug information about the connection trackers.
    */
@@ -147,22 +182,55 @@ class ConnTrackersManager {
   std::string StatsString() const;
 
  private:
+  // The number of shards of the conn_id to tracker map.
+  static constexpr size_t kNumShards = 16;
+
+  using ConnTrackerGenerationsMap = absl::flat_hash_map<uint64_t, ConnTrackerGenerations>;
+
+  // Returns the shard of conn_id_tracker_generations_ that holds the specified {PID, FD} key.
+  ConnTrackerGenerationsMap& GenerationsShard(uint64_t conn_map_key);
+  const ConnTrackerGenerationsMap& GenerationsShard(uint64_t conn_map_key) const;
+
+  // Called by a ConnTracker the first time it is marked for death.
+  void AddZombie(ConnTracker* tracker);
+
+  // Removes the trackers in ready_trackers_ from conn_id_tracker_generations_,
+  // and recycles them.
+  void DestroyReadyTrackers();
+
   // Simple consistency DCHECKs meant for enforcing invariants.
   void DebugChecks() const;
 
   // A map from conn_id (PID+FD+TSID) to tracker. This is for easy update on BPF events.
   // Structured as two nested maps to be explicit about "generations" of trackers per PID+FD.
   // Key is {PID, FD} for outer map, and tsid for inner map.
-  absl::flat_hash_map<uint64_t, ConnTrackerGenerations> conn_id_tracker_generations_;
+  // The outer map is sharded by key, so that no single map has to grow (and rehash) with the
+  // total number of connections, and so that shards can be worked on independently.
+  std::array<ConnTrackerGenerationsMap, kNumShards> conn_id_tracker_generations_;
 
+  // Trackers that are not ReadyForDestruction(). Each tracker keeps its own position in this
+  // list, so it can be removed without a search.
   std::list<ConnTracker*> active_trackers_;
 
+  // The subset of active_trackers_ that have been marked for death.
+  // These are the only trackers that can become ReadyForDestruction().
+  std::vector<ConnTracker*> zombie_trackers_;
+
+  // Trackers that are ReadyForDestruction(), and are waiting for DestroyReadyTrackers().
+  std::vector<ConnTracker*> ready_trackers_;
+
   // A pool of unused trackers that can be recycled.
   // This is useful for avoiding memory reallocations.
   ConnTrackerPool trackers_pool_;
 
   // Records statistics of ConnTracker for reporting and consistency check.
   utils::StatCounter<StatKey> stats_;
+
+  // Set by EnforceMemoryBudget().
+  std::array<size_t, kNumProtocols> buffered_bytes_by_protocol_ = {};
+  double memory_pressure_ = 0.0;
+
+  friend class ConnTracker;
 };
 
 }  // namespace stirling
@@ -17,13 +17,17 @@
  */
 
 #include <random>
+#include <string>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
 
 namespace px {
 namespace stirling {
 
+using ::testing::HasSubstr;
 using ::testing::StrEq;
 
 class ConnTrackersManagerTest : public ::testing::Test {
@@ -95,6 +99,75 @@ TEST_F(ConnTrackersManagerTest, Fuzz) {
   }
 }
 
+// Tests that the buffered data of the least recently active trackers is evicted first once the
+// trackers exceed the memory budget.
+TEST_F(ConnTrackersManagerTest, EnforceMemoryBudget) {
+  testing::RealClock clock;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<ConnTracker*> trackers;
+  for (uint32_t pid = 1; pid <= 3; ++pid) {
+    testing::EventGenerator event_gen(&clock, pid);
+    ConnTracker& tracker = trackers_mgr_.GetOrCreateConnTracker({{{pid}, 1}, 1, 1});
+    // The second tracker is the least recently active, then the first one.
+    tracker.set_current_time(start + std::chrono::seconds(pid == 2 ? 0 : pid));
+    tracker.AddDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(std::string(1000, 'a')));
+    trackers.push_back(&tracker);
+  }
+  const size_t tracker_bytes = trackers[0]->buffered_bytes();
+  ASSERT_GE(tracker_bytes, 1000UL);
+
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(10 * tracker_bytes), 0);
+  EXPECT_EQ(trackers_mgr_.buffered_bytes(kProtocolHTTP), 3 * tracker_bytes);
+  EXPECT_DOUBLE_EQ(trackers_mgr_.memory_pressure(), 0.3);
+
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(tracker_bytes * 5 / 2), 1);
+  EXPECT_EQ(trackers[1]->buffered_bytes(), 0UL);
+  EXPECT_EQ(trackers[0]->buffered_bytes(), tracker_bytes);
+  EXPECT_EQ(trackers_mgr_.buffered_bytes(kProtocolHTTP), 2 * tracker_bytes);
+
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(tracker_bytes * 3 / 2), 1);
+  EXPECT_EQ(trackers[0]->buffered_bytes(), 0UL);
+  EXPECT_EQ(trackers[2]->buffered_bytes(), tracker_bytes);
+
+  // Without a budget, nothing is evicted, but the buffered bytes are still recorded.
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(0), 0);
+  EXPECT_EQ(trackers_mgr_.buffered_bytes(kProtocolHTTP), tracker_bytes);
+  EXPECT_EQ(trackers_mgr_.memory_pressure(), 0.0);
+}
+
+// Tests that trackers become ready for destruction only once they are marked for death, and that
+// only the ready trackers are destroyed.
+TEST_F(ConnTrackersManagerTest, CleanupDestroysReadyTrackers) {
+  struct conn_id_t conn_id1 = {{{1}, 1}, 1, 1};
+  struct conn_id_t conn_id2 = {{{2}, 1}, 1, 1};
+
+  ConnTracker& tracker1 = trackers_mgr_.GetOrCreateConnTracker(conn_id1);
+  ConnTracker& tracker2 = trackers_mgr_.GetOrCreateConnTracker(conn_id2);
+  tracker1.MarkFinalConnStatsReported();
+  tracker2.MarkFinalConnStatsReported();
+
+  CleanupTrackers();
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 2);
+
+  tracker1.MarkForDeath(0);
+  CleanupTrackers();
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 1);
+  EXPECT_FALSE(trackers_mgr_.GetConnTracker(1, 1).ok());
+  ASSERT_OK_AND_ASSIGN(const ConnTracker* tracker, trackers_mgr_.GetConnTracker(2, 1));
+  EXPECT_EQ(tracker, &tracker2);
+
+  // A new generation marks the previous one for death.
+  struct conn_id_t conn_id3 = {{{2}, 1}, 1, 2};
+  ConnTracker& tracker3 = trackers_mgr_.GetOrCreateConnTracker(conn_id3);
+  tracker2.MarkForDeath(0);
+  CleanupTrackers();
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 1);
+  ASSERT_OK_AND_ASSIGN(tracker, trackers_mgr_.GetConnTracker(2, 1));
+  EXPECT_EQ(tracker, &tracker3);
+  EXPECT_THAT(trackers_mgr_.StatsString(), HasSubstr("kDestroyed=2 "));
+}
+
 // Tests that the DebugInfo() returns expected text.
 TEST_F(ConnTrackersManagerTest, DebugInfo) {
   struct conn_id_t conn_id = {};
@@ -18,26 +18,35 @@
 
 #include "src/stirling/source_connectors/socket_tracer/data_stream.h"
 
+#include <optional>
 #include <utility>
 
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/parse.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/types.h"
 // TODO(yzhao): Without this line :stirling_wrapper fails to link redis template specializations
 // of FindFrameBoundary() and ParseFrames().
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/parse.h"
 
 DEFINE_uint32(datastream_buffer_size, 1024 * 1024, "The maximum size of a data stream buffer.");
+DEFINE_uint32(datastream_ring_buffer_threshold, 64 * 1024,
+              "The size beyond which a data stream buffer moves its data into a virtual memory "
+              "ring buffer, which makes consuming data O(1) for large payloads.");
 
 namespace px {
 namespace stirling {
 
-void DataStream::AddData(std::unique_ptr<SocketDataEvent> event) {
-  // Note that the BPF code will also generate a missing sequence number when truncation occurs,
-  // so the data stream will naturally reset after processing this event.
-  LOG_IF(ERROR, event->attr.msg_size > event->msg.size() && !event->msg.empty())
-      << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
-                          event->attr.msg_size, event->msg.size());
-
-  data_buffer_.Add(event->attr.pos, event->msg, event->attr.timestamp_ns);
+void DataStream::AddData(const SocketDataEventView& event) {
+  data_buffer_.Add(event.attr.pos, event.msg, event.attr.timestamp_ns);
+
+  // BPF leaves out the data past the payload prefix limit of the protocol, or past MAX_MSG_SIZE,
+  // and only reports its size. Filler takes its place, so that parsers can step over it without
+  // losing sync; the frames that span it are marked truncated, see MarkTruncated().
+  if (event.attr.msg_size > event.msg.size() && !event.msg.empty()) {
+    VLOG(1) << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
+                                event.attr.msg_size, event.msg.size());
+    data_buffer_.AddFiller(event.attr.pos + event.msg.size(),
+                           event.attr.msg_size - event.msg.size(), event.attr.timestamp_ns);
+  }
 
   has_new_events_ = true;
 }
@@ -68,6 +77,27 @@ bool IsSyncRequired(int64_t stuck_count) {
   return true;
 }
 
+// Called for a frame that spans filler, i.e. was not received in full. The frame ends at
+// frame_end, and the first of its bytes that was not received is at filler_pos.
+// Protocols that can tell which part of the frame is missing mark it, the others keep the frame
+// as parsed.
+template <typename TFrameType>
+void MarkTruncated(size_t /* frame_end */, size_t /* filler_pos */, TFrameType* /* frame */) {}
+
+// The body is at the end of an HTTP message, so the bytes from the filler to the end of the
+// message are missing from the body.
+template <>
+void MarkTruncated(size_t frame_end, size_t filler_pos, protocols::http::Message* frame) {
+  const size_t missing = frame_end + 1 - filler_pos;
+  const size_t body_size = frame->body.size() + frame->body_bytes_skipped;
+  const size_t received = body_size > missing ? body_size - missing : 0;
+  if (frame->body.size() > received) {
+    frame->body.resize(received);
+  }
+  frame->body_bytes_skipped = body_size - frame->body.size();
+  frame->body_truncated = true;
+}
+
 }  // namespace
 
 // ProcessBytesToFrames() processes the raw data in the DataStream to extract parsed frames.
@@ -86,6 +116,7 @@ bool IsSyncRequired(int64_t stuck_count) {
 template <typename TFrameType>
 void DataStream::ProcessBytesToFrames(MessageType type) {
   auto& typed_messages = Frames<TFrameType>();
+  auto* parse_state = FrameParseState<TFrameType>();
 
   // TODO(oazizi): Convert to ECHECK once we have more confidence.
   LOG_IF(WARNING, IsEOS()) << "DataStream reaches EOS, no more data to process.";
@@ -112,6 +143,12 @@ void DataStream::ProcessBytesToFrames(MessageType type) {
   //                 new events, because we have hit the threshold to attempt a stream recovery.
   //                 Used for the first iteration only.
 
+  // The records of the previous iteration are gone by now, so an idle stream with no frames left
+  // can give back the memory its frames were allocated from.
+  if (typed_messages.empty() && data_buffer_.empty() && !has_new_events_) {
+    protocols::ReleaseFrameMemory(parse_state);
+  }
+
   // We appear to be stuck with an an unparseable sequence of events blocking the head.
   bool attempt_sync = IsSyncRequired(stuck_count_);
 
@@ -123,10 +160,21 @@ void DataStream::ProcessBytesToFrames(MessageType type) {
 
   while (keep_processing && !data_buffer_.empty()) {
     size_t contiguous_bytes = data_buffer_.Head().size();
+    const size_t head_pos = data_buffer_.position();
 
     // Now parse the raw data.
-    parse_result =
-        protocols::ParseFrames(type, data_buffer_, &typed_messages, IsSyncRequired(stuck_count_));
+    parse_result = protocols::ParseFrames(type, data_buffer_, &typed_messages,
+                                          IsSyncRequired(stuck_count_), parse_state);
+
+    const size_t first_new_frame = typed_messages.size() - parse_result.frame_positions.size();
+    for (size_t i = 0; i < parse_result.frame_positions.size(); ++i) {
+      const protocols::StartEndPos& f = parse_result.frame_positions[i];
+      std::optional<size_t> filler_pos =
+          data_buffer_.FirstFillerPos(head_pos + f.start, head_pos + f.end);
+      if (filler_pos.has_value()) {
+        MarkTruncated(head_pos + f.end, filler_pos.value(), &typed_messages[first_new_frame + i]);
+      }
+    }
 
     if (contiguous_bytes != data_buffer_.size()) {
       // We weren't able to submit all bytes, which means we ran into a missing event.
@@ -191,6 +239,7 @@ template void DataStream::ProcessBytesToFrames<protocols::cass::Frame>(MessageTy
 template void DataStream::ProcessBytesToFrames<protocols::pgsql::RegularMessage>(MessageType type);
 template void DataStream::ProcessBytesToFrames<protocols::dns::Frame>(MessageType type);
 template void DataStream::ProcessBytesToFrames<protocols::redis::Message>(MessageType type);
+template void DataStream::ProcessBytesToFrames<protocols::kafka::Packet>(MessageType type);
 
 void DataStream::Reset() {
   data_buffer_.Reset();
@@ -198,6 +247,7 @@ void DataStream::Reset() {
   stuck_count_ = 0;
 
   frames_ = std::monostate();
+  parse_state_ = protocols::NoFrameParseState();
 }
 
 }  // namespace stirling
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
@@ -29,6 +30,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/types.h"
 
 DECLARE_uint32(datastream_buffer_size);
+DECLARE_uint32(datastream_ring_buffer_threshold);
 
 namespace px {
 namespace stirling {
@@ -45,12 +47,15 @@ namespace stirling {
 class DataStream : NotCopyMoveable {
  public:
   // Make the underlying raw buffer size limit the same as the parsed frames byte limit.
-  DataStream() : data_buffer_(FLAGS_datastream_buffer_size) {}
+  DataStream()
+      : data_buffer_(FLAGS_datastream_buffer_size, FLAGS_datastream_ring_buffer_threshold) {}
 
   /**
    * Adds a raw (unparsed) chunk of data into the stream.
+   * The message is copied into the stream's buffer, so the view need not outlive the call.
    */
-  void AddData(std::unique_ptr<SocketDataEvent> event);
+  void AddData(const SocketDataEventView& event);
+  void AddData(std::unique_ptr<SocketDataEvent> event) { AddData(SocketDataEventView(*event)); }
 
   /**
    * Parses as many messages as it can from the raw events into the messages container.
@@ -169,17 +174,23 @@ class DataStream : NotCopyMoveable {
 
   /**
    * Cleanup frames that are parsed from the BPF events, when the condition is right.
+   *
+   * @return the approximate size of the frames that are left.
    */
   template <typename TFrameType>
-  void CleanupFrames(size_t size_limit_bytes,
-                     std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp) {
+  size_t CleanupFrames(size_t size_limit_bytes,
+                       std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp) {
     size_t size = FramesSize<TFrameType>();
     if (size > size_limit_bytes) {
       VLOG(1) << absl::Substitute("Messages cleared due to size limit ($0 > $1).", size,
                                   size_limit_bytes);
       Frames<TFrameType>().clear();
+      size = 0;
+    }
+    if (EraseExpiredFrames(expiry_timestamp, &Frames<TFrameType>()) > 0) {
+      size = FramesSize<TFrameType>();
     }
-    EraseExpiredFrames(expiry_timestamp, &Frames<TFrameType>());
+    return size;
   }
 
   /**
@@ -199,8 +210,9 @@ class DataStream : NotCopyMoveable {
   const protocols::DataStreamBuffer& data_buffer() const { return data_buffer_; }
 
  private:
+  // Returns the number of frames erased.
   template <typename TFrameType>
-  static void EraseExpiredFrames(
+  static size_t EraseExpiredFrames(
       std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp,
       std::deque<TFrameType>* frames) {
     auto iter = frames->begin();
@@ -214,12 +226,28 @@ class DataStream : NotCopyMoveable {
         break;
       }
     }
+    size_t num_erased = std::distance(frames->begin(), iter);
     frames->erase(frames->begin(), iter);
+    return num_erased;
+  }
+
+  template <typename TFrameType>
+  typename protocols::FrameParseStateTraits<TFrameType>::type* FrameParseState() {
+    using TParseState = typename protocols::FrameParseStateTraits<TFrameType>::type;
+    if (!std::holds_alternative<TParseState>(parse_state_)) {
+      parse_state_ = TParseState();
+    }
+    return &std::get<TParseState>(parse_state_);
   }
 
   // Raw data events from BPF.
   protocols::DataStreamBuffer data_buffer_;
 
+  // The state that the protocol parser keeps between calls to ProcessBytesToFrames(), so that a
+  // frame that was incomplete on one call is resumed on the next (see FrameParseStateTraits).
+  // The state may hold the memory of the frames, so it is declared before frames_ to outlive them.
+  protocols::FrameParseStateVariant parse_state_;
+
   // Vector of parsed HTTP/MySQL messages.
   // Once parsed, the raw data events should be discarded.
   // std::variant adds 8 bytes of overhead (to 80->88 for deque)
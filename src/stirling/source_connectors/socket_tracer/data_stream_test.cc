@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <random>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -342,6 +343,95 @@ TEST_F(DataStreamTest, Stress) {
   }
 }
 
+// Events read from the perf buffer are added through a view of the perf buffer memory.
+TEST_F(DataStreamTest, AddDataFromEventView) {
+  socket_data_event_t raw_event = {};
+  raw_event.attr.direction = TrafficDirection::kEgress;
+  raw_event.attr.protocol = kProtocolHTTP;
+  raw_event.attr.msg_size = kHTTPReq0.size();
+  raw_event.attr.msg_buf_size = kHTTPReq0.size();
+  kHTTPReq0.copy(raw_event.msg, kHTTPReq0.size());
+
+  DataStream stream;
+  stream.AddData(SocketDataEventView(&raw_event));
+
+  // The stream keeps its own copy of the message.
+  raw_event = {};
+  EXPECT_EQ(stream.data_buffer().Head(), kHTTPReq0);
+
+  stream.ProcessBytesToFrames<http::Message>(MessageType::kRequest);
+  EXPECT_THAT(stream.Frames<http::Message>(), SizeIs(1));
+}
+
+// Tests that the data that BPF left out of a truncated event is stepped over.
+TEST_F(DataStreamTest, TruncatedEvent) {
+  const std::string body(1000, 'x');
+  const std::string resp = absl::StrCat(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 1000\r\n"
+      "\r\n",
+      body);
+
+  testing::EventGenerator event_gen(&real_clock_);
+  std::unique_ptr<SocketDataEvent> resp0 = event_gen.InitRecvEvent<kProtocolHTTP>(resp);
+  std::unique_ptr<SocketDataEvent> resp1 = event_gen.InitRecvEvent<kProtocolHTTP>(resp);
+
+  // Only the first 100 bytes of the first response are sent to user-space.
+  resp0->msg.resize(100);
+  resp0->attr.msg_buf_size = 100;
+
+  DataStream stream;
+  stream.AddData(std::move(resp0));
+  stream.AddData(std::move(resp1));
+  stream.ProcessBytesToFrames<http::Message>(MessageType::kResponse);
+
+  // The first response keeps the part of the body that was received, and is marked truncated.
+  const size_t headers_size = resp.size() - body.size();
+  const auto& frames = stream.Frames<http::Message>();
+  ASSERT_THAT(frames, SizeIs(2));
+  EXPECT_EQ(frames[0].body, std::string(100 - headers_size, 'x'));
+  EXPECT_EQ(frames[0].body_bytes_skipped, body.size() - (100 - headers_size));
+  EXPECT_TRUE(frames[0].body_truncated);
+  EXPECT_EQ(frames[1].body, body.substr(0, frames[1].body.size()));
+  EXPECT_FALSE(frames[1].body_truncated);
+  EXPECT_TRUE(stream.data_buffer().empty());
+}
+
+// Tests an event cut short in the middle of a message, e.g. at MAX_MSG_SIZE, whose message
+// continues in the next event.
+TEST_F(DataStreamTest, TruncatedEventInsideMessage) {
+  const std::string body(1000, 'x');
+  const std::string resp = absl::StrCat(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Length: 1000\r\n"
+      "\r\n",
+      body);
+  const size_t headers_size = resp.size() - body.size();
+
+  testing::EventGenerator event_gen(&real_clock_);
+  std::unique_ptr<SocketDataEvent> resp0 =
+      event_gen.InitRecvEvent<kProtocolHTTP>(resp.substr(0, 500));
+  std::unique_ptr<SocketDataEvent> resp1 =
+      event_gen.InitRecvEvent<kProtocolHTTP>(resp.substr(500));
+
+  // Only the first 100 bytes of the first event are sent to user-space.
+  resp0->msg.resize(100);
+  resp0->attr.msg_buf_size = 100;
+
+  DataStream stream;
+  stream.AddData(std::move(resp0));
+  stream.AddData(std::move(resp1));
+  stream.ProcessBytesToFrames<http::Message>(MessageType::kResponse);
+
+  // The body stops at the first byte that wasn't received, rather than holding filler.
+  const auto& frames = stream.Frames<http::Message>();
+  ASSERT_THAT(frames, SizeIs(1));
+  EXPECT_EQ(frames[0].body, std::string(100 - headers_size, 'x'));
+  EXPECT_EQ(frames[0].body_bytes_skipped, body.size() - (100 - headers_size));
+  EXPECT_TRUE(frames[0].body_truncated);
+  EXPECT_TRUE(stream.data_buffer().empty());
+}
+
 TEST_F(DataStreamTest, CannotSwitchType) {
   DataStream stream;
 
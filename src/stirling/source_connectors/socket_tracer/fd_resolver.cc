@@ -19,6 +19,9 @@
 #include "src/stirling/source_connectors/socket_tracer/fd_resolver.h"
 
 #include <chrono>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
 
 #include "src/common/base/base.h"
 #include "src/common/fs/inode_utils.h"
@@ -26,9 +29,50 @@
 namespace px {
 namespace stirling {
 
+void FDLinkCache::NewIteration() {
+  // Only processes with connections still being resolved are looked up every iteration.
+  for (auto iter = pids_.begin(); iter != pids_.end();) {
+    if (iter->second.last_use_iteration != iteration_) {
+      pids_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  ++iteration_;
+}
+
+Status FDLinkCache::ReadFDLink(int pid, int fd, std::string* out) {
+  auto iter = pids_.find(pid);
+  if (iter == pids_.end() ||
+      (!iter->second.links.contains(fd) && iter->second.scan_iteration != iteration_)) {
+    PIDFDLinks fd_links;
+    fd_links.scan_iteration = iteration_;
+    PL_RETURN_IF_ERROR(proc_parser_->ReadProcPIDFDLinks(pid, &fd_links.links));
+    iter = pids_.insert_or_assign(pid, std::move(fd_links)).first;
+  }
+  iter->second.last_use_iteration = iteration_;
+
+  auto link_iter = iter->second.links.find(fd);
+  if (link_iter == iter->second.links.end()) {
+    return error::NotFound("FD $0 of PID $1 is not open.", fd, pid);
+  }
+  *out = link_iter->second;
+  return Status::OK();
+}
+
 FDResolver::FDResolver(system::ProcParser* proc_parser, int pid, int fd)
     : proc_parser_(proc_parser), pid_(pid), fd_(fd) {}
 
+FDResolver::FDResolver(FDLinkCache* fd_link_cache, int pid, int fd)
+    : fd_link_cache_(fd_link_cache), pid_(pid), fd_(fd) {}
+
+Status FDResolver::ReadFDLink(std::string* out) {
+  if (fd_link_cache_ != nullptr) {
+    return fd_link_cache_->ReadFDLink(pid_, fd_, out);
+  }
+  return proc_parser_->ReadProcPIDFDLink(pid_, fd_, out);
+}
+
 bool FDResolver::Setup() {
   // Record some information about the FD.
   // This marks the starting point at which we reliably know the connection.
@@ -36,7 +80,7 @@ bool FDResolver::Setup() {
   // the hope is that we can recover the socket information on the next iteration,
   // if the connection appears to be stable.
 
-  Status s = proc_parser_->ReadProcPIDFDLink(pid_, fd_, &fd_link_);
+  Status s = ReadFDLink(&fd_link_);
   if (!s.ok()) {
     VLOG(2) << absl::Substitute("Can't set-up connection inference [msg=$0].", s.msg());
     active_ = false;
@@ -62,7 +106,7 @@ bool FDResolver::Update() {
   std::chrono::time_point<std::chrono::steady_clock> timestamp = std::chrono::steady_clock::now();
 
   std::string current_fd_link;
-  Status s = proc_parser_->ReadProcPIDFDLink(pid_, fd_, &current_fd_link);
+  Status s = ReadFDLink(&current_fd_link);
   if (!s.ok()) {
     VLOG(2) << "Can't infer remote endpoint. FD is not accessible.";
     active_ = false;
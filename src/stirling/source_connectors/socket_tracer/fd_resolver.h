@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/system/proc_parser.h"
 #include "src/common/system/socket_info.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
@@ -31,6 +33,54 @@
 namespace px {
 namespace stirling {
 
+/**
+ * Caches the FD links of processes, each read with a single scan of /proc/<pid>/fd, so that
+ * resolving many connections of the same process is a lookup rather than a readlink each.
+ *
+ * The links of a process stay valid until Invalidate() is called for it, which the caller does on
+ * every close event of the process. An FD of a traced connection can't be reused without such
+ * an event. A lookup of an FD missing from the snapshot rescans the process, at most once per
+ * iteration, to pick up the FDs opened since the last scan.
+ */
+class FDLinkCache {
+ public:
+  explicit FDLinkCache(system::ProcParser* proc_parser) : proc_parser_(proc_parser) {}
+
+  /**
+   * Starts a new iteration. The processes that were not looked up during the previous iteration
+   * are dropped.
+   */
+  void NewIteration();
+
+  /**
+   * Reads the link of the FD of the process, from the cache if possible.
+   */
+  Status ReadFDLink(int pid, int fd, std::string* out);
+
+  /**
+   * Drops the cached links of the process, e.g. because it closed one of its FDs.
+   */
+  void Invalidate(int pid) { pids_.erase(pid); }
+
+  /**
+   * Drops all cached links, e.g. because close events were lost.
+   */
+  void Clear() { pids_.clear(); }
+
+  size_t size() const { return pids_.size(); }
+
+ private:
+  struct PIDFDLinks {
+    uint64_t scan_iteration = 0;
+    uint64_t last_use_iteration = 0;
+    absl::flat_hash_map<int32_t, std::string> links;
+  };
+
+  system::ProcParser* proc_parser_;
+  uint64_t iteration_ = 0;
+  absl::flat_hash_map<int, PIDFDLinks> pids_;
+};
+
 /**
  * SocketResolver tries to determine the socket inode number of a given a PID and FD.
  *
@@ -52,6 +102,11 @@ class FDResolver {
    */
   FDResolver(system::ProcParser* proc_parser, int pid, int fd);
 
+  /**
+   * Creates a SocketResolver for the PID and FD, which reads the FD info through the cache.
+   */
+  FDResolver(FDLinkCache* fd_link_cache, int pid, int fd);
+
   /**
    * Collects the first sample from Linux, to begin the tracking process.
    */
@@ -86,7 +141,11 @@ class FDResolver {
   }
 
  private:
-  system::ProcParser* proc_parser_;
+  Status ReadFDLink(std::string* out);
+
+  // Exactly one of these is set.
+  system::ProcParser* proc_parser_ = nullptr;
+  FDLinkCache* fd_link_cache_ = nullptr;
   int pid_;
   int fd_;
 
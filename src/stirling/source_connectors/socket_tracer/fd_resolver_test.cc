@@ -23,6 +23,7 @@
 
 #include "src/common/base/types.h"
 #include "src/common/system/tcp_socket.h"
+#include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/fd_resolver.h"
 
 namespace px {
@@ -187,5 +188,40 @@ TEST_F(FDResolverTest, NewSocketSameFD) {
   EXPECT_FALSE(fd_link.has_value());
 }
 
+TEST_F(FDResolverTest, FDLinkCache) {
+  FDLinkCache cache(proc_parser_.get());
+  int pid = getpid();
+
+  auto socket = std::make_unique<system::TCPSocket>();
+  int fd = socket->sockfd();
+
+  std::string link;
+  ASSERT_OK(cache.ReadFDLink(pid, fd, &link));
+  EXPECT_TRUE(absl::StartsWith(link, "socket:["));
+  EXPECT_EQ(cache.size(), 1);
+
+  // The link is served from the cache until the process is invalidated by a close event.
+  socket.reset();
+  std::string cached_link;
+  ASSERT_OK(cache.ReadFDLink(pid, fd, &cached_link));
+  EXPECT_EQ(cached_link, link);
+
+  cache.Invalidate(pid);
+  EXPECT_NOT_OK(cache.ReadFDLink(pid, fd, &link));
+
+  // An FD opened after the scan is found by rescanning, in the next iteration.
+  system::TCPSocket socket2;
+  EXPECT_NOT_OK(cache.ReadFDLink(pid, socket2.sockfd(), &link));
+  cache.NewIteration();
+  ASSERT_OK(cache.ReadFDLink(pid, socket2.sockfd(), &link));
+  EXPECT_TRUE(absl::StartsWith(link, "socket:["));
+
+  // Processes not looked up during an iteration are dropped.
+  cache.NewIteration();
+  EXPECT_EQ(cache.size(), 1);
+  cache.NewIteration();
+  EXPECT_EQ(cache.size(), 0);
+}
+
 }  // namespace stirling
 }  // namespace px
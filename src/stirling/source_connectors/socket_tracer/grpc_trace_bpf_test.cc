@@ -24,6 +24,8 @@
 #include <filesystem>
 #include <thread>
 
+#include <absl/strings/escaping.h>
+
 #include "src/common/exec/subprocess.h"
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
@@ -61,8 +63,9 @@ using ::testing::StrEq;
 
 HelloReply GetHelloReply(const ColumnWrapperRecordBatch& record_batch, const size_t idx) {
   HelloReply received_reply;
-  std::string msg = record_batch[kHTTPRespBodyIdx]->Get<types::StringValue>(idx);
-  if (!msg.empty()) {
+  std::string msg;
+  if (absl::Base64Unescape(record_batch[kHTTPRespBodyRawIdx]->Get<types::StringValue>(idx), &msg) &&
+      !msg.empty()) {
     received_reply.ParseFromString(msg.substr(kGRPCMessageHeaderSizeInBytes));
   }
   return received_reply;
@@ -70,8 +73,9 @@ HelloReply GetHelloReply(const ColumnWrapperRecordBatch& record_batch, const siz
 
 HelloRequest GetHelloRequest(const ColumnWrapperRecordBatch& record_batch, const size_t idx) {
   HelloRequest received_reply;
-  std::string msg = record_batch[kHTTPReqBodyIdx]->Get<types::StringValue>(idx);
-  if (!msg.empty()) {
+  std::string msg;
+  if (absl::Base64Unescape(record_batch[kHTTPReqBodyRawIdx]->Get<types::StringValue>(idx), &msg) &&
+      !msg.empty()) {
     received_reply.ParseFromString(msg.substr(kGRPCMessageHeaderSizeInBytes));
   }
   return received_reply;
@@ -186,6 +190,8 @@ TEST_P(GRPCTraceTest, CaptureRPCTraceRecord) {
             rb[kHTTPContentTypeIdx]->Get<types::Int64Value>(idx).val);
 
   EXPECT_EQ(rb[kHTTPRespBodyIdx]->Get<types::StringValue>(idx).string(), R"(1: "Hello PixieLabs")");
+  EXPECT_EQ(GetHelloRequest(rb, idx).name(), "PixieLabs");
+  EXPECT_EQ(GetHelloReply(rb, idx).message(), "Hello PixieLabs");
 }
 
 INSTANTIATE_TEST_SUITE_P(SecurityModeTest, GRPCTraceTest, ::testing::Values(true, false));
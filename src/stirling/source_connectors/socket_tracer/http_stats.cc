@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/http_stats.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/substitute.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/sketches/tdigest_sketch.h"
+#include "src/stirling/source_connectors/socket_tracer/http_stats_table.h"
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// Same as the centroids bound of px.quantiles, scaled down since there is a digest per key.
+constexpr double kDigestCompression = 100;
+
+// Hex strings of this length or more are taken as IDs, e.g. UUIDs, hashes or object IDs.
+constexpr size_t kMinHexIDLength = 16;
+
+bool IsIDSegment(std::string_view segment) {
+  if (segment.empty()) {
+    return false;
+  }
+  if (std::all_of(segment.begin(), segment.end(), absl::ascii_isdigit)) {
+    return true;
+  }
+  size_t num_hex_digits = 0;
+  for (char c : segment) {
+    if (absl::ascii_isxdigit(c)) {
+      ++num_hex_digits;
+    } else if (c != '-') {
+      return false;
+    }
+  }
+  return num_hex_digits >= kMinHexIDLength;
+}
+
+}  // namespace
+
+std::string NormalizeHTTPPath(std::string_view path) {
+  path = path.substr(0, path.find_first_of("?#"));
+  std::vector<std::string_view> segments = absl::StrSplit(path, '/');
+  for (std::string_view& segment : segments) {
+    if (IsIDSegment(segment)) {
+      segment = "*";
+    }
+  }
+  return absl::StrJoin(segments, "/");
+}
+
+void HTTPStats::Add(const md::UPID& upid, std::string remote_addr, int remote_port,
+                    EndpointRole role, std::string req_method, std::string_view req_path,
+                    int64_t resp_status, int64_t latency_ns) {
+  Key key = {
+      .upid = upid,
+      .remote_addr = std::move(remote_addr),
+      .remote_port = remote_port,
+      .role = role,
+      .req_method = std::move(req_method),
+      .req_path = NormalizeHTTPPath(req_path),
+      // Unparsable statuses (e.g. -1) all land in class 0.
+      .resp_status_class = resp_status > 0 ? static_cast<int>(resp_status / 100) : 0,
+  };
+
+  auto iter = stats_.find(key);
+  if (iter == stats_.end()) {
+    if (stats_.size() >= kMaxKeys) {
+      ++num_dropped_;
+      return;
+    }
+    iter = stats_.emplace(std::move(key), Stats{}).first;
+    iter->second.latency_digest = std::make_unique<tdigest::TDigest>(kDigestCompression);
+  }
+
+  Stats& stats = iter->second;
+  ++stats.count;
+  stats.latency_sum_ns += latency_ns;
+  stats.latency_digest->add(latency_ns);
+}
+
+void HTTPStats::Transfer(uint64_t time, DataTable* data_table) {
+  namespace idx = ::px::stirling::http_stats_idx;
+
+  for (auto& [key, stats] : stats_) {
+    DataTable::RecordBuilder<&kHTTPStatsTable> r(data_table, time);
+    r.Append<idx::kTime>(time);
+    r.Append<idx::kUPID>(key.upid.value());
+    r.Append<idx::kRemoteAddr>(key.remote_addr);
+    r.Append<idx::kRemotePort>(key.remote_port);
+    r.Append<idx::kRole>(key.role);
+    r.Append<idx::kReqMethod>(key.req_method);
+    r.Append<idx::kReqPath>(key.req_path);
+    r.Append<idx::kRespStatusClass>(key.resp_status_class);
+    r.Append<idx::kCount>(stats.count);
+    r.Append<idx::kLatencySum>(stats.latency_sum_ns);
+    r.Append<idx::kLatencySketch>(sketches::SerializeTDigest(stats.latency_digest.get()));
+  }
+
+  LOG_IF(WARNING, num_dropped_ > 0) << absl::Substitute(
+      "http_stats dropped $0 records beyond the limit of $1 keys per window.", num_dropped_,
+      kMaxKeys);
+
+  stats_.clear();
+  num_dropped_ = 0;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include "src/shared/upid/upid.h"
+#include "src/stirling/core/data_table.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/common.h"
+#include "tdigest/tdigest.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Normalizes an HTTP request path for aggregation: drops the query string and the fragment, and
+ * replaces the path segments that look like IDs (numbers, or long hex strings such as UUIDs)
+ * with '*', e.g. "/users/1234?limit=10" becomes "/users/*".
+ */
+std::string NormalizeHTTPPath(std::string_view path);
+
+/**
+ * Aggregates HTTP request-response records into RED metrics (request rate, errors, duration),
+ * which are exported to the http_stats table once per window.
+ */
+class HTTPStats {
+ public:
+  // Bounds the memory of a window; records of further keys are dropped until the next window.
+  static constexpr size_t kMaxKeys = 10000;
+
+  struct Key {
+    md::UPID upid;
+    std::string remote_addr;
+    int remote_port;
+    EndpointRole role;
+    std::string req_method;
+    std::string req_path;
+    int resp_status_class;
+
+    bool operator==(const Key& rhs) const {
+      return upid == rhs.upid && remote_addr == rhs.remote_addr &&
+             remote_port == rhs.remote_port && role == rhs.role && req_method == rhs.req_method &&
+             req_path == rhs.req_path && resp_status_class == rhs.resp_status_class;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.upid, key.remote_addr, key.remote_port, key.role,
+                        key.req_method, key.req_path, key.resp_status_class);
+    }
+  };
+
+  struct Stats {
+    int64_t count = 0;
+    int64_t latency_sum_ns = 0;
+    std::unique_ptr<tdigest::TDigest> latency_digest;
+  };
+
+  /**
+   * Adds a record to the current window. The path is normalized, and the status is reduced to
+   * its class.
+   */
+  void Add(const md::UPID& upid, std::string remote_addr, int remote_port, EndpointRole role,
+           std::string req_method, std::string_view req_path, int64_t resp_status,
+           int64_t latency_ns);
+
+  /**
+   * Appends one record per key of the current window to the data table, and starts a new window.
+   */
+  void Transfer(uint64_t time, DataTable* data_table);
+
+  const absl::flat_hash_map<Key, Stats>& stats() const { return stats_; }
+
+ private:
+  absl::flat_hash_map<Key, Stats> stats_;
+  size_t num_dropped_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "src/stirling/core/types.h"
+#include "src/stirling/source_connectors/socket_tracer/canonical_types.h"
+
+namespace px {
+namespace stirling {
+
+// clang-format off
+constexpr DataElement kHTTPStatsElements[] = {
+        canonical_data_elements::kTime,
+        canonical_data_elements::kUPID,
+        canonical_data_elements::kRemoteAddr,
+        canonical_data_elements::kRemotePort,
+        canonical_data_elements::kTraceRole,
+        {"req_method", "HTTP request method (e.g. GET, POST, ...)",
+         types::DataType::STRING, types::SemanticType::ST_HTTP_REQ_METHOD,
+         types::PatternType::GENERAL_ENUM},
+        {"req_path", "Request path, without the query string, and with ID-like segments "
+         "replaced by '*'",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        {"resp_status_class", "Class of the HTTP response status code (e.g. 2 for 2xx)",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM},
+        {"count", "The number of requests in the window",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"latency_sum", "The sum of the latencies of the requests in the window",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_COUNTER},
+        {"latency_sketch", "Quantile sketch of the latencies in the window. The sketches of "
+         "several windows can be merged with px.merge_quantiles_sketch, and read with px.quantile",
+         types::DataType::STRING, types::SemanticType::ST_DURATION_NS_QUANTILES_SKETCH,
+         types::PatternType::GENERAL},
+};
+// clang-format on
+
+constexpr DataTableSchema kHTTPStatsTable(
+    "http_stats",
+    "HTTP request rate, error and latency (RED) metrics, aggregated in Stirling over fixed "
+    "windows per process, remote endpoint, method, path and status class. Disabled by default, "
+    "see --stirling_enable_http_stats.",
+    kHTTPStatsElements);
+DEFINE_PRINT_TABLE(HTTPStats)
+
+namespace http_stats_idx {
+
+constexpr int kTime = kHTTPStatsTable.ColIndex("time_");
+constexpr int kUPID = kHTTPStatsTable.ColIndex("upid");
+constexpr int kRemoteAddr = kHTTPStatsTable.ColIndex("remote_addr");
+constexpr int kRemotePort = kHTTPStatsTable.ColIndex("remote_port");
+constexpr int kRole = kHTTPStatsTable.ColIndex("trace_role");
+constexpr int kReqMethod = kHTTPStatsTable.ColIndex("req_method");
+constexpr int kReqPath = kHTTPStatsTable.ColIndex("req_path");
+constexpr int kRespStatusClass = kHTTPStatsTable.ColIndex("resp_status_class");
+constexpr int kCount = kHTTPStatsTable.ColIndex("count");
+constexpr int kLatencySum = kHTTPStatsTable.ColIndex("latency_sum");
+constexpr int kLatencySketch = kHTTPStatsTable.ColIndex("latency_sketch");
+
+}  // namespace http_stats_idx
+
+}  // namespace stirling
+}  // namespace px
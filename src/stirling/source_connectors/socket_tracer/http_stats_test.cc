@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/http_stats.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::Field;
+using ::testing::Pair;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
+
+TEST(NormalizeHTTPPathTest, StripsQueryAndFragment) {
+  EXPECT_EQ(NormalizeHTTPPath("/index.html?lang=en"), "/index.html");
+  EXPECT_EQ(NormalizeHTTPPath("/docs#section"), "/docs");
+  EXPECT_EQ(NormalizeHTTPPath("/"), "/");
+  EXPECT_EQ(NormalizeHTTPPath(""), "");
+}
+
+TEST(NormalizeHTTPPathTest, ReplacesIDs) {
+  EXPECT_EQ(NormalizeHTTPPath("/users/1234/orders?limit=10"), "/users/*/orders");
+  EXPECT_EQ(NormalizeHTTPPath("/items/123e4567-e89b-12d3-a456-426614174000"), "/items/*");
+  EXPECT_EQ(NormalizeHTTPPath("/blobs/0123456789abcdef0123"), "/blobs/*");
+  // Short hex-looking words are kept.
+  EXPECT_EQ(NormalizeHTTPPath("/feed/cafe"), "/feed/cafe");
+  EXPECT_EQ(NormalizeHTTPPath("/v1/api"), "/v1/api");
+}
+
+TEST(HTTPStatsTest, AggregatesByKey) {
+  const md::UPID upid(1, 2, 3);
+  HTTPStats stats;
+
+  stats.Add(upid, "1.2.3.4", 80, kRoleServer, "GET", "/users/1?a=b", 200, 100);
+  stats.Add(upid, "1.2.3.4", 80, kRoleServer, "GET", "/users/2", 204, 300);
+  stats.Add(upid, "1.2.3.4", 80, kRoleServer, "GET", "/users/3", 503, 1000);
+  stats.Add(upid, "1.2.3.4", 80, kRoleServer, "POST", "/users", 201, 50);
+
+  const auto key = [&](std::string method, std::string path, int status_class) {
+    return HTTPStats::Key{.upid = upid,
+                          .remote_addr = "1.2.3.4",
+                          .remote_port = 80,
+                          .role = kRoleServer,
+                          .req_method = std::move(method),
+                          .req_path = std::move(path),
+                          .resp_status_class = status_class};
+  };
+
+  EXPECT_THAT(
+      stats.stats(),
+      UnorderedElementsAre(
+          Pair(key("GET", "/users/*", 2), Field(&HTTPStats::Stats::latency_sum_ns, 400)),
+          Pair(key("GET", "/users/*", 5), Field(&HTTPStats::Stats::latency_sum_ns, 1000)),
+          Pair(key("POST", "/users", 2), Field(&HTTPStats::Stats::count, 1))));
+  EXPECT_EQ(stats.stats().at(key("GET", "/users/*", 2)).count, 2);
+}
+
+TEST(HTTPStatsTest, BoundsNumKeys) {
+  const md::UPID upid(1, 2, 3);
+  HTTPStats stats;
+
+  for (size_t i = 0; i < HTTPStats::kMaxKeys + 10; ++i) {
+    stats.Add(upid, "1.2.3.4", static_cast<int>(i), kRoleServer, "GET", "/", 200, 1);
+  }
+  EXPECT_THAT(stats.stats(), SizeIs(HTTPStats::kMaxKeys));
+
+  // Known keys are still updated.
+  stats.Add(upid, "1.2.3.4", 0, kRoleServer, "GET", "/", 200, 1);
+  EXPECT_THAT(stats.stats(), SizeIs(HTTPStats::kMaxKeys));
+}
+
+}  // namespace stirling
+}  // namespace px
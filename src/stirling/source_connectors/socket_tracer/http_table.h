@@ -72,10 +72,18 @@ constexpr DataElement kHTTPElements[] = {
      types::DataType::STRING,
      types::SemanticType::ST_NONE,
      types::PatternType::STRUCTURED},
+    {"req_body_raw", "Base64 of the serialized gRPC request body, see px.grpc_body_to_text()",
+     types::DataType::STRING,
+     types::SemanticType::ST_NONE,
+     types::PatternType::STRUCTURED},
     {"req_body_size", "Request body size (before any truncation)",
      types::DataType::INT64,
      types::SemanticType::ST_BYTES,
      types::PatternType::METRIC_GAUGE},
+    {"req_body_bytes_skipped", "Request body bytes that were skipped by the body capture policy",
+     types::DataType::INT64,
+     types::SemanticType::ST_BYTES,
+     types::PatternType::METRIC_GAUGE},
     {"resp_headers", "Response headers in JSON format",
      types::DataType::STRING,
      types::SemanticType::ST_NONE,
@@ -92,10 +100,18 @@ constexpr DataElement kHTTPElements[] = {
      types::DataType::STRING,
      types::SemanticType::ST_NONE,
      types::PatternType::STRUCTURED},
+    {"resp_body_raw", "Base64 of the serialized gRPC response body, see px.grpc_body_to_text()",
+     types::DataType::STRING,
+     types::SemanticType::ST_NONE,
+     types::PatternType::STRUCTURED},
     {"resp_body_size", "Response body size (before any truncation)",
      types::DataType::INT64,
      types::SemanticType::ST_BYTES,
      types::PatternType::METRIC_GAUGE},
+    {"resp_body_bytes_skipped", "Response body bytes that were skipped by the body capture policy",
+     types::DataType::INT64,
+     types::SemanticType::ST_BYTES,
+     types::PatternType::METRIC_GAUGE},
     canonical_data_elements::kLatencyNS,
 #ifndef NDEBUG
         {"px_info_", "Pixie messages regarding the record (e.g. warnings)",
@@ -122,12 +138,16 @@ constexpr int kHTTPReqHeadersIdx = kHTTPTable.ColIndex("req_headers");
 constexpr int kHTTPReqMethodIdx = kHTTPTable.ColIndex("req_method");
 constexpr int kHTTPReqPathIdx = kHTTPTable.ColIndex("req_path");
 constexpr int kHTTPReqBodyIdx = kHTTPTable.ColIndex("req_body");
+constexpr int kHTTPReqBodyRawIdx = kHTTPTable.ColIndex("req_body_raw");
 constexpr int kHTTPReqBodySizeIdx = kHTTPTable.ColIndex("req_body_size");
+constexpr int kHTTPReqBodyBytesSkippedIdx = kHTTPTable.ColIndex("req_body_bytes_skipped");
 constexpr int kHTTPRespHeadersIdx = kHTTPTable.ColIndex("resp_headers");
 constexpr int kHTTPRespStatusIdx = kHTTPTable.ColIndex("resp_status");
 constexpr int kHTTPRespMessageIdx = kHTTPTable.ColIndex("resp_message");
 constexpr int kHTTPRespBodyIdx = kHTTPTable.ColIndex("resp_body");
+constexpr int kHTTPRespBodyRawIdx = kHTTPTable.ColIndex("resp_body_raw");
 constexpr int kHTTPRespBodySizeIdx = kHTTPTable.ColIndex("resp_body_size");
+constexpr int kHTTPRespBodyBytesSkippedIdx = kHTTPTable.ColIndex("resp_body_bytes_skipped");
 constexpr int kHTTPLatencyIdx = kHTTPTable.ColIndex("latency");
 
 }  // namespace stirling
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+
+#include "src/stirling/core/types.h"
+#include "src/stirling/source_connectors/socket_tracer/canonical_types.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
+
+namespace px {
+namespace stirling {
+
+static const std::map<int64_t, std::string_view> kKafkaReqCmdDecoder =
+    px::EnumDefToMap<protocols::kafka::APIKey>();
+
+// clang-format off
+static constexpr DataElement kKafkaElements[] = {
+        canonical_data_elements::kTime,
+        canonical_data_elements::kUPID,
+        canonical_data_elements::kRemoteAddr,
+        canonical_data_elements::kRemotePort,
+        canonical_data_elements::kTraceRole,
+        {"req_cmd", "Kafka request API key",
+         types::DataType::INT64,
+         types::SemanticType::ST_NONE,
+         types::PatternType::GENERAL_ENUM,
+         &kKafkaReqCmdDecoder},
+        {"client_id", "Kafka client ID of the request",
+         types::DataType::STRING,
+         types::SemanticType::ST_NONE,
+         types::PatternType::GENERAL},
+        {"req_body", "Topics and partitions of produce and fetch requests, as JSON",
+         types::DataType::STRING,
+         types::SemanticType::ST_NONE,
+         types::PatternType::GENERAL},
+        {"req_size", "Size of the request in bytes",
+         types::DataType::INT64,
+         types::SemanticType::ST_BYTES,
+         types::PatternType::METRIC_GAUGE},
+        {"resp_size", "Size of the response in bytes, 0 if the request gets no response",
+         types::DataType::INT64,
+         types::SemanticType::ST_BYTES,
+         types::PatternType::METRIC_GAUGE},
+        canonical_data_elements::kLatencyNS,
+#ifndef NDEBUG
+        {"px_info_", "Pixie messages regarding the record (e.g. warnings)",
+         types::DataType::STRING,
+         types::SemanticType::ST_NONE,
+         types::PatternType::GENERAL},
+#endif
+};
+// clang-format on
+
+static constexpr auto kKafkaTable =
+    DataTableSchema("kafka_events", "Kafka request-response pair events", kKafkaElements);
+DEFINE_PRINT_TABLE(Kafka)
+
+constexpr int kKafkaUPIDIdx = kKafkaTable.ColIndex("upid");
+constexpr int kKafkaReqCmdIdx = kKafkaTable.ColIndex("req_cmd");
+constexpr int kKafkaReqBodyIdx = kKafkaTable.ColIndex("req_body");
+
+}  // namespace stirling
+}  // namespace px
@@ -278,5 +278,49 @@ TYPED_TEST(OpenSSLTraceTest, ssl_capture_ruby_client) {
   }
 }
 
+// Traces the writes with the do_ssl3_write() probes instead of the SSL_write() ones, for the
+// libssl builds that have the symbol; the others fall back to SSL_write().
+template <typename NginxContainer>
+class OpenSSLRecordLayerTraceTest : public OpenSSLTraceTest<NginxContainer> {
+ protected:
+  OpenSSLRecordLayerTraceTest() { FLAGS_stirling_openssl_record_layer_probes = true; }
+  ~OpenSSLRecordLayerTraceTest() override { FLAGS_stirling_openssl_record_layer_probes = false; }
+};
+
+TYPED_TEST_SUITE(OpenSSLRecordLayerTraceTest, NginxImplementations);
+
+TYPED_TEST(OpenSSLRecordLayerTraceTest, ssl_capture_curl_client) {
+  this->StartTransferDataThread();
+
+  CurlContainer client;
+  PL_CHECK_OK(
+      client.Run(std::chrono::seconds{60},
+                 {absl::Substitute("--network=container:$0", this->server_.container_name())},
+                 {"--insecure", "-s", "-S", "https://localhost:443/index.html"}));
+  client.Wait();
+
+  int worker_pid = this->NginxWorkerPID();
+
+  this->StopTransferDataThread();
+
+  std::vector<TaggedRecordBatch> tablets =
+      this->ConsumeRecords(SocketTraceConnector::kHTTPTableNum);
+  ASSERT_FALSE(tablets.empty());
+  types::ColumnWrapperRecordBatch record_batch = tablets[0].records;
+
+  http::Record expected_record;
+  expected_record.req.minor_version = 1;
+  expected_record.req.req_method = "GET";
+  expected_record.req.req_path = "/index.html";
+  expected_record.req.body = "";
+  expected_record.resp.resp_status = 200;
+  expected_record.resp.resp_message = "OK";
+  expected_record.resp.body = kNginxRespBody;
+
+  // The response is written by nginx, so it's what the write probes captured.
+  std::vector<http::Record> records = GetTargetRecords(record_batch, worker_pid);
+  EXPECT_THAT(records, UnorderedElementsAre(EqHTTPRecord(expected_record)));
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/body_capture.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
+
+DEFINE_uint32(stirling_http_body_capture_bytes, px::stirling::protocols::kMaxBodyBytes,
+              "The number of bytes kept from the head of HTTP message bodies. Bodies are never "
+              "recorded past the table's limit, so larger values have no effect.");
+DEFINE_string(stirling_http_body_capture_content_types, "",
+              "Comma-separated substrings of the Content-Types whose HTTP message bodies are "
+              "kept. If empty, bodies of all Content-Types are kept.");
+DEFINE_uint32(stirling_http_body_sample_rate, 1,
+              "Keep the body of one in every N HTTP messages. The rest are only counted.");
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+BodyCapturePolicy::BodyCapturePolicy(size_t max_bytes, std::vector<std::string> content_types,
+                                     uint32_t sample_rate)
+    : max_bytes_(max_bytes),
+      content_types_(std::move(content_types)),
+      sample_rate_(std::max<uint32_t>(sample_rate, 1)) {}
+
+BodyCapturePolicy& BodyCapturePolicy::Get() {
+  static BodyCapturePolicy policy(
+      std::min<size_t>(FLAGS_stirling_http_body_capture_bytes, kMaxBodyBytes),
+      absl::StrSplit(FLAGS_stirling_http_body_capture_content_types, ',', absl::SkipEmpty()),
+      FLAGS_stirling_http_body_sample_rate);
+  return policy;
+}
+
+bool BodyCapturePolicy::ShouldCapture(std::string_view content_type) {
+  if (max_bytes_ == 0) {
+    return false;
+  }
+  if (!content_types_.empty() &&
+      std::none_of(content_types_.begin(), content_types_.end(),
+                   [content_type](const std::string& allowed) {
+                     return absl::StrContains(content_type, allowed);
+                   })) {
+    return false;
+  }
+  return sample_rate_ == 1 ||
+         sample_count_.fetch_add(1, std::memory_order_relaxed) % sample_rate_ == 0;
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+DECLARE_uint32(stirling_http_body_capture_bytes);
+DECLARE_string(stirling_http_body_capture_content_types);
+DECLARE_uint32(stirling_http_body_sample_rate);
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * Decides which part of an HTTP message body the parsers keep. The rest of the body is only
+ * counted, so large bodies are not copied just to be truncated when the record is appended.
+ */
+class BodyCapturePolicy {
+ public:
+  /**
+   * @param max_bytes The number of bytes kept from the head of a body.
+   * @param content_types If not empty, only bodies whose Content-Type contains one of these
+   * substrings are kept.
+   * @param sample_rate The body of one in every sample_rate messages is kept.
+   */
+  BodyCapturePolicy(size_t max_bytes, std::vector<std::string> content_types,
+                    uint32_t sample_rate);
+
+  /**
+   * The policy set by the --stirling_http_body_* flags. The flags are read on the first call.
+   */
+  static BodyCapturePolicy& Get();
+
+  /**
+   * Decides whether the body of the next message is kept. Thread-safe.
+   * @param content_type The Content-Type of the message, empty if it has none.
+   */
+  bool ShouldCapture(std::string_view content_type);
+
+  // The number of bytes kept from the head of a body.
+  size_t max_bytes() const { return max_bytes_; }
+
+ private:
+  const size_t max_bytes_;
+  const std::vector<std::string> content_types_;
+  const uint32_t sample_rate_;
+  std::atomic<uint64_t> sample_count_{0};
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
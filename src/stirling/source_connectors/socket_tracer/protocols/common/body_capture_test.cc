@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/body_capture.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+TEST(BodyCapturePolicyTest, CapturesEverythingByDefault) {
+  BodyCapturePolicy policy(512, {}, 1);
+  EXPECT_EQ(policy.max_bytes(), 512U);
+  EXPECT_TRUE(policy.ShouldCapture(""));
+  EXPECT_TRUE(policy.ShouldCapture("application/json"));
+}
+
+TEST(BodyCapturePolicyTest, ContentTypeAllowlist) {
+  BodyCapturePolicy policy(512, {"json", "text/"}, 1);
+  EXPECT_TRUE(policy.ShouldCapture("application/json; charset=utf-8"));
+  EXPECT_TRUE(policy.ShouldCapture("text/html"));
+  EXPECT_FALSE(policy.ShouldCapture("image/png"));
+  EXPECT_FALSE(policy.ShouldCapture(""));
+}
+
+TEST(BodyCapturePolicyTest, Sampling) {
+  BodyCapturePolicy policy(512, {}, 3);
+  int captured = 0;
+  for (int i = 0; i < 30; ++i) {
+    captured += policy.ShouldCapture("text/plain");
+  }
+  EXPECT_EQ(captured, 10);
+}
+
+TEST(BodyCapturePolicyTest, NoBytes) {
+  BodyCapturePolicy policy(0, {}, 1);
+  EXPECT_FALSE(policy.ShouldCapture("text/plain"));
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -20,7 +20,6 @@
 
 #include <algorithm>
 #include <deque>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,12 +32,24 @@ namespace protocols {
 
 namespace {
 
-// Get element <= key in a map.
-template <typename TMapType>
-typename TMapType::const_iterator MapLE(const TMapType& map, size_t key) {
-  auto iter = map.upper_bound(key);
-  if (iter == map.begin()) {
-    return map.cend();
+// Get the first entry with position >= pos in a position index.
+template <typename TIndex>
+auto IndexGE(TIndex& index, size_t pos) -> decltype(index.begin()) {
+  // Fast path for in-order data, which lands past the last entry.
+  if (index.empty() || index.back().first < pos) {
+    return index.end();
+  }
+  return std::lower_bound(index.begin(), index.end(), pos,
+                          [](const auto& entry, size_t key) { return entry.first < key; });
+}
+
+// Get the last entry with position <= pos in a position index, or end() if there is none.
+template <typename TIndex>
+auto IndexLE(TIndex& index, size_t pos) -> decltype(index.begin()) {
+  auto iter = std::upper_bound(index.begin(), index.end(), pos,
+                               [](size_t key, const auto& entry) { return key < entry.first; });
+  if (iter == index.begin()) {
+    return index.end();
   }
   --iter;
 
@@ -49,8 +60,12 @@ typename TMapType::const_iterator MapLE(const TMapType& map, size_t key) {
 
 void DataStreamBuffer::Reset() {
   buffer_.clear();
+  ring_.Reset();
+  ring_head_ = 0;
+  ring_size_ = 0;
   chunks_.clear();
   timestamps_.clear();
+  fillers_.clear();
   position_ = 0;
 }
 
@@ -58,7 +73,7 @@ void DataStreamBuffer::Reset() {
 //               Return error in such cases.
 void DataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
   // Look for the chunks to the left and right of this new chunk.
-  auto r_iter = chunks_.lower_bound(pos);
+  auto r_iter = IndexGE(chunks_, pos);
   auto l_iter = r_iter;
   if (l_iter != chunks_.begin()) {
     --l_iter;
@@ -91,31 +106,69 @@ void DataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
     l_iter->second += size;
   } else if (right_fuse) {
     // Merge new chunk into the one on its right.
-    // Since its key changes, this requires removing and re-inserting the node.
-    auto node = chunks_.extract(r_iter);
-    node.key() = pos;
-    node.mapped() += size;
-    chunks_.insert(std::move(node));
+    // Its position moves down to pos, which keeps the index sorted.
+    r_iter->first = pos;
+    r_iter->second += size;
+  } else if (r_iter != chunks_.end() && r_iter->first == pos) {
+    // No fusing, but a chunk already starts here; replace it.
+    r_iter->second = size;
   } else {
     // No fusing, so just add the new chunk.
-    chunks_[pos] = size;
+    chunks_.emplace(r_iter, pos, size);
   }
 }
 
 void DataStreamBuffer::AddNewTimestamp(size_t pos, uint64_t timestamp) {
-  timestamps_[pos] = timestamp;
+  auto iter = IndexGE(timestamps_, pos);
+  if (iter != timestamps_.end() && iter->first == pos) {
+    iter->second = timestamp;
+  } else {
+    timestamps_.emplace(iter, pos, timestamp);
+  }
 }
 
 void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp) {
-  if (data.size() > capacity_) {
-    size_t oversize_amount = data.size() - capacity_;
-    data.remove_prefix(oversize_amount);
+  AddImpl(pos, data.data(), data.size(), timestamp);
+}
+
+void DataStreamBuffer::AddFiller(size_t pos, size_t size, uint64_t timestamp) {
+  if (size == 0 || size > capacity_) {
+    return;
+  }
+  // The range is a real gap only if no chunk overlaps it.
+  auto iter = IndexLE(chunks_, pos + size - 1);
+  if (iter != chunks_.end() && iter->first + iter->second > pos) {
+    return;
+  }
+  AddImpl(pos, nullptr, size, timestamp);
+  fillers_.emplace(IndexGE(fillers_, pos), pos, size);
+}
+
+std::optional<size_t> DataStreamBuffer::FirstFillerPos(size_t start, size_t end) const {
+  for (const auto& [pos, size] : fillers_) {
+    if (pos > end) {
+      break;
+    }
+    if (pos + size > start) {
+      return std::max(pos, start);
+    }
+  }
+  return std::nullopt;
+}
+
+void DataStreamBuffer::AddImpl(size_t pos, const char* data, size_t size, uint64_t timestamp) {
+  if (size > capacity_) {
+    size_t oversize_amount = size - capacity_;
+    if (data != nullptr) {
+      data += oversize_amount;
+    }
+    size -= oversize_amount;
     pos += oversize_amount;
   }
 
   // Calculate physical positions (ppos) where the data would live in the physical buffer.
   ssize_t ppos_front = pos - position_;
-  ssize_t ppos_back = pos + data.size() - position_;
+  ssize_t ppos_back = pos + size - position_;
 
   if (ppos_back < 0) {
     // Case 1: Data being added is too far back. Just ignore it.
@@ -134,10 +187,13 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
         "Event is partially too far in the past [event pos=$0, current pos=$1].", pos, position_);
 
     ssize_t prefix = 0 - ppos_front;
-    data.remove_prefix(prefix);
+    if (data != nullptr) {
+      data += prefix;
+    }
+    size -= prefix;
     pos += prefix;
     ppos_front = 0;
-  } else if (ppos_back > static_cast<ssize_t>(buffer_.size())) {
+  } else if (ppos_back > static_cast<ssize_t>(buffer_size())) {
     // Case 3: Data being added extends the buffer. Resize the buffer.
 
     if (pos > position_ + capacity_) {
@@ -148,7 +204,7 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
                                   position_);
     }
 
-    ssize_t logical_size = pos + data.size() - position_;
+    ssize_t logical_size = pos + size - position_;
     if (logical_size > static_cast<ssize_t>(capacity_)) {
       // The movement of the buffer position will cause some bytes to "fall off",
       // remove those now.
@@ -167,13 +223,18 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
     DCHECK_GE(ppos_back, 0);
     DCHECK_LE(ppos_back, capacity_);
 
-    ssize_t extension = ppos_back - buffer_.size();
+    ssize_t extension = ppos_back - buffer_size();
     DCHECK_GE(extension, 0);
     DCHECK_LE(extension, capacity_);
 
-    buffer_.resize(buffer_.size() + extension);
-    DCHECK_GE(buffer_.size(), 0);
-    DCHECK_LE(buffer_.size(), capacity_);
+    Status s = ExtendBuffer(buffer_size() + extension);
+    if (!s.ok()) {
+      LOG(ERROR) << absl::Substitute("Dropping event that could not be buffered [pos=$0]: $1",
+                                     pos, s.msg());
+      return;
+    }
+    DCHECK_GE(buffer_size(), 0);
+    DCHECK_LE(buffer_size(), capacity_);
   } else {
     // Case 4: Data being added is completely within the buffer. Write it directly.
 
@@ -181,16 +242,21 @@ void DataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp
   }
 
   // Now copy the data into the buffer.
-  memcpy(buffer_.data() + ppos_front, data.data(), data.size());
+  if (data != nullptr) {
+    memcpy(BufferData(ppos_front), data, size);
+  } else {
+    memset(BufferData(ppos_front), 0, size);
+  }
 
   // Update the metadata.
-  AddNewChunk(pos, data.size());
+  AddNewChunk(pos, size);
   AddNewTimestamp(pos, timestamp);
 }
 
-std::map<size_t, size_t>::const_iterator DataStreamBuffer::GetChunkForPos(size_t pos) const {
+DataStreamBuffer::PositionIndex<size_t>::const_iterator DataStreamBuffer::GetChunkForPos(
+    size_t pos) const {
   // Get chunk which is <= pos.
-  auto iter = MapLE(chunks_, pos);
+  auto iter = IndexLE(chunks_, pos);
   if (iter == chunks_.cend()) {
     return chunks_.cend();
   }
@@ -220,8 +286,8 @@ std::string_view DataStreamBuffer::Get(size_t pos) const {
 
   DCHECK_GE(pos, position_);
   size_t ppos = pos - position_;
-  DCHECK_LT(ppos, buffer_.size());
-  return std::string_view(buffer_.data() + ppos, bytes_available);
+  DCHECK_LT(ppos, size());
+  return std::string_view(BufferData(ppos), bytes_available);
 }
 
 StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
@@ -231,7 +297,7 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
   }
 
   // Get chunk which is <= pos.
-  auto iter = MapLE(timestamps_, pos);
+  auto iter = IndexLE(timestamps_, pos);
   if (iter == timestamps_.cend()) {
     LOG(DFATAL) << absl::Substitute(
         "Specified position should have been found, since we verified we are not in a chunk gap "
@@ -248,14 +314,21 @@ StatusOr<uint64_t> DataStreamBuffer::GetTimestamp(size_t pos) const {
 void DataStreamBuffer::CleanupMetadata() {
   CleanupChunks();
   CleanupTimestamps();
+  CleanupFillers();
+}
+
+void DataStreamBuffer::CleanupFillers() {
+  while (!fillers_.empty() && fillers_.front().first + fillers_.front().second <= position_) {
+    fillers_.pop_front();
+  }
 }
 
 void DataStreamBuffer::CleanupChunks() {
   // Find and remove irrelevant metadata in `chunks_`.
 
   // Get chunk which is <= position_.
-  auto iter = MapLE(chunks_, position_);
-  if (iter == chunks_.cend()) {
+  auto iter = IndexLE(chunks_, position_);
+  if (iter == chunks_.end()) {
     return;
   }
 
@@ -275,10 +348,8 @@ void DataStreamBuffer::CleanupChunks() {
 
     // Adjust the first chunk's size.
     DCHECK(!chunks_.empty());
-    auto node = chunks_.extract(chunks_.begin());
-    node.key() = position_;
-    node.mapped() = available;
-    chunks_.insert(std::move(node));
+    chunks_.front().first = position_;
+    chunks_.front().second = available;
   }
 }
 
@@ -286,8 +357,8 @@ void DataStreamBuffer::CleanupTimestamps() {
   // Find and remove irrelevant metadata in `timestamps_`.
 
   // Get timestamp which is <= position_.
-  auto iter = MapLE(timestamps_, position_);
-  if (iter == timestamps_.cend()) {
+  auto iter = IndexLE(timestamps_, position_);
+  if (iter == timestamps_.end()) {
     return;
   }
 
@@ -306,7 +377,7 @@ void DataStreamBuffer::RemovePrefix(ssize_t n) {
     return;
   }
 
-  buffer_.erase(0, n);
+  RemoveBufferPrefix(n);
   position_ += n;
 
   CleanupMetadata();
@@ -317,19 +388,63 @@ void DataStreamBuffer::Trim() {
     return;
   }
 
-  auto& chunk_pos = chunks_.begin()->first;
+  size_t chunk_pos = chunks_.front().first;
   DCHECK_GE(chunk_pos, position_);
   size_t trim_size = chunk_pos - position_;
 
-  buffer_.erase(0, trim_size);
+  RemoveBufferPrefix(trim_size);
   position_ += trim_size;
 }
 
+char* DataStreamBuffer::BufferData(size_t ppos) const {
+  if (in_ring()) {
+    return ring_.data(ring_head_ + ppos);
+  }
+  return const_cast<char*>(buffer_.data()) + ppos;
+}
+
+Status DataStreamBuffer::ExtendBuffer(size_t new_size) {
+  if (!in_ring() && new_size <= ring_threshold_) {
+    buffer_.resize(new_size);
+    return Status::OK();
+  }
+
+  if (new_size > ring_.size()) {
+    if (in_ring()) {
+      // Growing copies the data once, which is rare since the ring at least doubles each time.
+      PL_RETURN_IF_ERROR(ring_.Remap(new_size, ring_head_, ring_size_));
+    } else {
+      // The buffer has outgrown the string; move its data to the ring.
+      PL_RETURN_IF_ERROR(ring_.Remap(new_size, 0, 0));
+      memcpy(ring_.data(0), buffer_.data(), buffer_.size());
+      ring_size_ = buffer_.size();
+      std::string().swap(buffer_);
+    }
+    ring_head_ = 0;
+  }
+
+  // Stale bytes from earlier trips around the ring are cleared, to match the string buffer.
+  memset(ring_.data(ring_head_ + ring_size_), 0, new_size - ring_size_);
+  ring_size_ = new_size;
+  return Status::OK();
+}
+
+void DataStreamBuffer::RemoveBufferPrefix(size_t n) {
+  if (!in_ring()) {
+    buffer_.erase(0, n);
+    return;
+  }
+
+  n = std::min(n, ring_size_);
+  ring_head_ = (ring_head_ + n) & (ring_.size() - 1);
+  ring_size_ -= n;
+}
+
 std::string DataStreamBuffer::DebugInfo() const {
   std::string s;
 
   absl::StrAppend(&s, absl::Substitute("Position: $0\n", position_));
-  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", buffer_.size(), capacity_));
+  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", size(), capacity_));
   absl::StrAppend(&s, "Chunks:\n");
   for (const auto& [pos, size] : chunks_) {
     absl::StrAppend(&s, absl::Substitute("  position:$0 size:$1\n", pos, size));
@@ -338,7 +453,7 @@ std::string DataStreamBuffer::DebugInfo() const {
   for (const auto& [pos, timestamp] : timestamps_) {
     absl::StrAppend(&s, absl::Substitute("  position:$0 timestamp:$1\n", pos, timestamp));
   }
-  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", buffer_));
+  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", std::string(BufferData(0), size())));
 
   return s;
 }
@@ -18,10 +18,14 @@
 
 #pragma once
 
-#include <map>
+#include <deque>
+#include <limits>
+#include <optional>
 #include <string>
+#include <utility>
 
 #include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/virtual_ring_buffer.h"
 
 namespace px {
 namespace stirling {
@@ -40,12 +44,16 @@ namespace protocols {
  * DataStreamBuffer supports data arriving out-of-order such that they are slotted into the middle
  * of the buffer.
  *
- * The underlying implementation is currently a simple string buffer, but this could be changed
- * in the future, as long as the data is maintained in a contiguous buffer.
+ * Data is held in a simple string buffer while the buffer is small. Once the buffer grows past
+ * ring_threshold bytes, the data moves to a VirtualRingBuffer, where removing consumed data from
+ * the head is O(1) instead of shifting the remaining bytes down, while all data still stays
+ * contiguous in memory.
  */
 class DataStreamBuffer {
  public:
-  explicit DataStreamBuffer(size_t max_capacity) : capacity_(max_capacity) {}
+  explicit DataStreamBuffer(size_t max_capacity,
+                            size_t ring_threshold = std::numeric_limits<size_t>::max())
+      : capacity_(max_capacity), ring_threshold_(ring_threshold) {}
 
   /**
    * Adds data to the buffer at the specified logical position.
@@ -58,6 +66,26 @@ class DataStreamBuffer {
    */
   void Add(size_t pos, std::string_view data, uint64_t timestamp);
 
+  /**
+   * Adds size bytes of zero-filled data at the specified logical position. It stands in for data
+   * that was traced, but left out of the events sent to user-space, so that the data around it
+   * stays contiguous and parsers can step over it without losing sync.
+   * Filler is only added to a real gap: if any of the range already holds data, or the filler is
+   * larger than the capacity of the buffer, it is not added. The filled ranges are remembered, see
+   * FirstFillerPos().
+   *
+   * @param pos Position at which to insert the filler.
+   * @param size The number of bytes of filler.
+   * @param timestamp Timestamp to associate with the filler.
+   */
+  void AddFiller(size_t pos, size_t size, uint64_t timestamp);
+
+  /**
+   * Returns the position of the first filler byte in the logical range [start, end], if any.
+   * Frames that span filler were not received in full.
+   */
+  std::optional<size_t> FirstFillerPos(size_t start, size_t end) const;
+
   /**
    * Get all the contiguous data at the specified position of the buffer.
    * @param pos The logical position of the requested data.
@@ -95,12 +123,12 @@ class DataStreamBuffer {
   /**
    * Current size of the internal buffer. Not all bytes may be populated.
    */
-  size_t size() const { return buffer_.size(); }
+  size_t size() const { return buffer_size(); }
 
   /**
    * Return true if the buffer is empty.
    */
-  bool empty() const { return buffer_.empty(); }
+  bool empty() const { return size() == 0; }
 
   /**
    * Logical position of the head of the buffer.
@@ -116,35 +144,62 @@ class DataStreamBuffer {
   void Reset();
 
  private:
-  std::map<size_t, size_t>::const_iterator GetChunkForPos(size_t pos) const;
+  // An index of (logical position, value) entries, sorted by position. In-order adds append at
+  // the back, and consumed entries are popped from the front, so both are amortized O(1).
+  template <typename TValue>
+  using PositionIndex = std::deque<std::pair<size_t, TValue>>;
+
+  // Adds size bytes at pos, copied from data, or zero-filled if data is nullptr.
+  void AddImpl(size_t pos, const char* data, size_t size, uint64_t timestamp);
+  PositionIndex<size_t>::const_iterator GetChunkForPos(size_t pos) const;
   void AddNewChunk(size_t pos, size_t size);
   void AddNewTimestamp(size_t pos, uint64_t timestamp);
 
   void CleanupTimestamps();
   void CleanupChunks();
+  void CleanupFillers();
 
-  // Umbrella that calls CleanupTimestamps and CleanupChunks.
+  // Umbrella that calls CleanupTimestamps, CleanupChunks and CleanupFillers.
   void CleanupMetadata();
 
+  // Accessors for the physical buffer, which is either buffer_ or ring_.
+  bool in_ring() const { return ring_.size() > 0; }
+  size_t buffer_size() const { return in_ring() ? ring_size_ : buffer_.size(); }
+  char* BufferData(size_t ppos) const;
+  // Grows the physical buffer to new_size bytes. The new bytes are zero-filled.
+  Status ExtendBuffer(size_t new_size);
+  void RemoveBufferPrefix(size_t n);
+
   const size_t capacity_;
 
+  // Size beyond which data is moved from buffer_ to ring_.
+  const size_t ring_threshold_;
+
   // Logical position of data stream buffer.
   // In other words, the position of buffer_[0].
   size_t position_ = 0;
 
-  // Buffer where all data is stored.
-  // TODO(oazizi): Investigate buffer that is better suited to the rolling buffer (slinky) model.
+  // Buffer where all data is stored while the buffer is no larger than ring_threshold_.
   std::string buffer_;
 
-  // Map of chunk start positions to chunk sizes.
+  // Buffer where all data is stored once the buffer grows beyond ring_threshold_.
+  // Its data occupies ring_size_ bytes, starting at offset ring_head_.
+  VirtualRingBuffer ring_;
+  size_t ring_head_ = 0;
+  size_t ring_size_ = 0;
+
+  // Index of chunk start positions to chunk sizes.
   // A chunk is a contiguous sequence of bytes.
   // Adjacent chunks are always fused, so a chunk either ends at a gap or the end of the buffer.
-  std::map<size_t, size_t> chunks_;
+  PositionIndex<size_t> chunks_;
 
-  // Map of positions to timestamps.
+  // Index of positions to timestamps.
   // Unlike chunks_, which will fuse when adjacent, timestamps never fuse.
   // Also, we don't track gaps in the buffer with timestamps; must use chunks_ for that.
-  std::map<size_t, uint64_t> timestamps_;
+  PositionIndex<uint64_t> timestamps_;
+
+  // Index of filler start positions to filler sizes. Filler is rare, so this is usually empty.
+  PositionIndex<size_t> fillers_;
 };
 
 }  // namespace protocols
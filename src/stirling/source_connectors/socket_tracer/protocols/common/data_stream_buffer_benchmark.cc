@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
+
+using px::stirling::protocols::DataStreamBuffer;
+
+constexpr size_t kBufferCapacity = 1024 * 1024;
+constexpr size_t kNumEvents = 1024;
+
+// Returns the positions of kNumEvents events of the given size, in the order they are added.
+std::vector<size_t> InOrderPositions(size_t event_size) {
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < kNumEvents; ++i) {
+    positions.push_back(i * event_size);
+  }
+  return positions;
+}
+
+// Every pair of adjacent events arrives swapped.
+std::vector<size_t> OutOfOrderPositions(size_t event_size) {
+  std::vector<size_t> positions = InOrderPositions(event_size);
+  for (size_t i = 0; i + 1 < positions.size(); i += 2) {
+    std::swap(positions[i], positions[i + 1]);
+  }
+  return positions;
+}
+
+// Every other event arrives first, leaving gaps that the rest of the events fill in.
+std::vector<size_t> GapFilledPositions(size_t event_size) {
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < kNumEvents; i += 2) {
+    positions.push_back(i * event_size);
+  }
+  for (size_t i = 1; i < kNumEvents; i += 2) {
+    positions.push_back(i * event_size);
+  }
+  return positions;
+}
+
+// Adds the events, then consumes them one event at a time, the way frames are parsed.
+void AddAndConsume(benchmark::State& state, const std::vector<size_t>& positions) {
+  const size_t event_size = state.range(0);
+  const std::string data(event_size, 'x');
+
+  for (auto _ : state) {
+    DataStreamBuffer buffer(kBufferCapacity);
+    uint64_t timestamp = 0;
+    for (size_t pos : positions) {
+      buffer.Add(pos, data, timestamp++);
+    }
+    while (!buffer.Head().empty()) {
+      benchmark::DoNotOptimize(buffer.GetTimestamp(buffer.position()));
+      buffer.RemovePrefix(event_size);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * positions.size() * event_size);
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_InOrder(benchmark::State& state) {
+  AddAndConsume(state, InOrderPositions(state.range(0)));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_OutOfOrder(benchmark::State& state) {
+  AddAndConsume(state, OutOfOrderPositions(state.range(0)));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_GapFilled(benchmark::State& state) {
+  AddAndConsume(state, GapFilledPositions(state.range(0)));
+}
+
+BENCHMARK(BM_InOrder)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OutOfOrder)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_GapFilled)->RangeMultiplier(4)->Range(16, 1024);
@@ -18,6 +18,8 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
 
+#include <string>
+
 #include "src/common/testing/testing.h"
 
 namespace px {
@@ -225,6 +227,37 @@ TEST(DataStreamTest, TimestampWithGap) {
   EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(13), 10);
 }
 
+TEST(DataStreamTest, Filler) {
+  DataStreamBuffer stream_buffer(15);
+
+  // The filler bridges the data around it into one contiguous chunk.
+  stream_buffer.Add(0, "0123", 0);
+  stream_buffer.AddFiller(4, 3, 0);
+  stream_buffer.Add(7, "789", 7);
+  EXPECT_EQ(stream_buffer.Head(), std::string_view("0123\0\0\0" "789", 10));
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(5), 0);
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(8), 7);
+
+  // Filler that doesn't fit in the buffer leaves a gap.
+  stream_buffer.AddFiller(10, 20, 10);
+  EXPECT_EQ(stream_buffer.Head(), std::string_view("0123\0\0\0" "789", 10));
+  EXPECT_EQ(stream_buffer.size(), 10);
+
+  // Filler never overwrites data.
+  stream_buffer.AddFiller(2, 3, 2);
+  EXPECT_EQ(stream_buffer.Head(), std::string_view("0123\0\0\0" "789", 10));
+
+  EXPECT_EQ(stream_buffer.FirstFillerPos(0, 3), std::nullopt);
+  EXPECT_EQ(stream_buffer.FirstFillerPos(0, 9), 4);
+  EXPECT_EQ(stream_buffer.FirstFillerPos(5, 9), 5);
+  EXPECT_EQ(stream_buffer.FirstFillerPos(7, 9), std::nullopt);
+
+  // Consumed filler is forgotten.
+  stream_buffer.RemovePrefix(7);
+  EXPECT_EQ(stream_buffer.FirstFillerPos(7, 9), std::nullopt);
+  EXPECT_EQ(stream_buffer.Head(), "789");
+}
+
 TEST(DataStreamTest, SizeAndGetPos) {
   DataStreamBuffer stream_buffer(15);
 
@@ -291,6 +324,51 @@ TEST(DataStreamTest, SizeAndGetPos) {
   EXPECT_FALSE(stream_buffer.empty());
 }
 
+// Tests that data survives the move into the ring buffer, and wrapping around it.
+TEST(DataStreamTest, RingBuffer) {
+  constexpr size_t kCapacity = 16 * 1024;
+  constexpr size_t kRingThreshold = 1024;
+  DataStreamBuffer stream_buffer(kCapacity, kRingThreshold);
+
+  // Stays in the string buffer.
+  stream_buffer.Add(0, std::string(1000, 'a'), 0);
+  EXPECT_EQ(stream_buffer.Head(), std::string(1000, 'a'));
+
+  // Moves to the ring buffer, leaving a zero-filled gap in between.
+  stream_buffer.Add(1010, std::string(1000, 'b'), 1);
+  EXPECT_EQ(stream_buffer.size(), 2010);
+  EXPECT_EQ(stream_buffer.Head(), std::string(1000, 'a'));
+  EXPECT_EQ(stream_buffer.Get(1010), std::string(1000, 'b'));
+
+  stream_buffer.AddFiller(1000, 10, 2);
+  EXPECT_EQ(stream_buffer.Head(),
+            std::string(1000, 'a') + std::string(10, '\0') + std::string(1000, 'b'));
+  stream_buffer.RemovePrefix(2010);
+  EXPECT_TRUE(stream_buffer.empty());
+
+  // Produce and consume many times the capacity, so the data wraps around the ring.
+  size_t pos = 2010;
+  for (int i = 0; i < 100; ++i) {
+    std::string data(1500, 'c' + i % 20);
+    stream_buffer.Add(pos, data, pos);
+    stream_buffer.Add(pos + data.size(), data, pos + data.size());
+    EXPECT_EQ(stream_buffer.Head(), data + data);
+    EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(pos + data.size()), pos + data.size());
+    stream_buffer.RemovePrefix(2 * data.size());
+    pos += 2 * data.size();
+  }
+  EXPECT_EQ(stream_buffer.position(), pos);
+
+  // Rolling past the capacity still works.
+  stream_buffer.Add(pos, std::string(kCapacity, 'x'), 3);
+  stream_buffer.Add(pos + kCapacity, "yz", 4);
+  EXPECT_EQ(stream_buffer.size(), kCapacity);
+  EXPECT_EQ(stream_buffer.Head(), std::string(kCapacity - 2, 'x') + "yz");
+
+  stream_buffer.Reset();
+  EXPECT_TRUE(stream_buffer.empty());
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
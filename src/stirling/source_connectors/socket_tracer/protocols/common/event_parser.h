@@ -90,12 +90,14 @@ struct ParseResult {
  * @param frames The container to which newly parsed frames are added.
  * @param resync If set to true, Parse will first search for the next frame boundary (even
  * if it is currently at a valid frame boundary).
+ * @param parse_state The state kept by the protocol on the data stream between calls, if any.
  *
  * @return ParseResult with locations where parseable frames were found in the source buffer.
  */
-template <typename TFrameType>
+template <typename TFrameType, typename TParseState = NoFrameParseState>
 ParseResult ParseFrames(MessageType type, const DataStreamBuffer& data_stream_buffer,
-                        std::deque<TFrameType>* frames, bool resync = false) {
+                        std::deque<TFrameType>* frames, bool resync = false,
+                        TParseState* parse_state = nullptr) {
   std::string_view buf = data_stream_buffer.Head();
 
   size_t start_pos = 0;
@@ -120,7 +122,8 @@ ParseResult ParseFrames(MessageType type, const DataStreamBuffer& data_stream_bu
   const size_t prev_size = frames->size();
 
   // Parse and append new frames to the frames vector.
-  ParseResult result = ParseFramesLoop(type, buf, frames);
+  ParseResult result = ParseFramesLoop(type, buf, frames, parse_state,
+                                       data_stream_buffer.position() + start_pos);
 
   VLOG(1) << absl::Substitute("Parsed $0 new frames", frames->size() - prev_size);
 
@@ -150,13 +153,16 @@ ParseResult ParseFrames(MessageType type, const DataStreamBuffer& data_stream_bu
  * @param type The Type of frames to parse.
  * @param buf The raw bytes to parse
  * @param frames The output where the parsed frames will be placed.
+ * @param parse_state The state kept by the protocol on the data stream between calls, if any.
+ * @param buf_pos The position of buf in the data stream.
  *
  * @return ParseResult with locations where parseable frames were found in the source buffer.
  */
 // TODO(oazizi): Convert tests to use ParseFrames() instead of ParseFramesLoop().
-template <typename TFrameType>
+template <typename TFrameType, typename TParseState = NoFrameParseState>
 ParseResult ParseFramesLoop(MessageType type, std::string_view buf,
-                            std::deque<TFrameType>* frames) {
+                            std::deque<TFrameType>* frames, TParseState* parse_state = nullptr,
+                            size_t buf_pos = 0) {
   std::vector<StartEndPos> frame_positions;
   const size_t buf_size = buf.size();
   ParseState s = ParseState::kSuccess;
@@ -164,9 +170,9 @@ ParseResult ParseFramesLoop(MessageType type, std::string_view buf,
   int invalid_count = 0;
 
   while (!buf.empty() && s != ParseState::kEOS) {
-    TFrameType frame;
+    TFrameType frame = MakeFrame<TFrameType>(parse_state);
 
-    s = ParseFrame(type, &buf, &frame);
+    s = ParseFrame(type, buf_pos + (buf_size - buf.size()), &buf, &frame, parse_state);
 
     bool stop = false;
     bool push = false;
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <deque>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -104,6 +105,46 @@ size_t FindFrameBoundary(MessageType type, std::string_view buf, size_t start_po
 template <typename TFrameType>
 ParseState ParseFrame(MessageType type, std::string_view* buf, TFrameType* frame);
 
+/**
+ * The state a protocol keeps on each data stream between calls to ParseFrames(), so that a frame
+ * that was incomplete on one call is resumed on the next, instead of being parsed from its start
+ * again. Protocols opt in by specializing FrameParseStateTraits, and by providing a ParseFrame()
+ * overload that takes their state; see http::StreamParseState.
+ */
+struct NoFrameParseState {};
+
+template <typename TFrameType>
+struct FrameParseStateTraits {
+  using type = NoFrameParseState;
+};
+
+/**
+ * Returns a new frame for ParseFrame() to populate. Protocols whose parse state holds memory for
+ * their frames specialize this, so that the frames are allocated from it.
+ */
+template <typename TFrameType, typename TParseState>
+TFrameType MakeFrame(TParseState* /*state*/) {
+  return TFrameType();
+}
+
+/**
+ * Releases the memory that state holds for the frames of MakeFrame(). Called when the stream is
+ * idle and has no frames left, so that idle streams don't keep the memory of past bursts.
+ */
+template <typename TParseState>
+void ReleaseFrameMemory(TParseState* /*state*/) {}
+
+/**
+ * ParseFrame() for protocols that keep no parse state.
+ *
+ * @param pos The position of buf in the data stream.
+ */
+template <typename TFrameType>
+ParseState ParseFrame(MessageType type, size_t /*pos*/, std::string_view* buf, TFrameType* frame,
+                      NoFrameParseState* /*state*/) {
+  return ParseFrame(type, buf, frame);
+}
+
 /**
  * StitchFrames is the entry point of stitcher for all protocols. It loops through the responses,
  * matches them with the corresponding requests, and returns stitched request & response pairs.
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_uint32(stirling_prepared_statement_cache_size);
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * A map of prepared statements that holds at most capacity entries. When full, inserting a new
+ * statement evicts the least recently used one, so a client that prepares statements without
+ * ever closing them cannot grow the tracker's state without bound.
+ *
+ * Not thread-safe; each connection tracker owns its own cache.
+ */
+template <typename TKey, typename TValue>
+class StatementCache {
+ public:
+  /**
+   * @param capacity The maximum number of statements kept. Zero is treated as one.
+   */
+  explicit StatementCache(size_t capacity = FLAGS_stirling_prepared_statement_cache_size)
+      : capacity_(std::max<size_t>(capacity, 1)) {}
+
+  // Protocol states are held in std::any, so the cache must be copyable. The index points into
+  // entries_, and is rebuilt for the copy.
+  StatementCache(const StatementCache& other)
+      : capacity_(other.capacity_), evictions_(other.evictions_), entries_(other.entries_) {
+    RebuildIndex();
+  }
+  StatementCache& operator=(const StatementCache& other) {
+    if (this != &other) {
+      capacity_ = other.capacity_;
+      evictions_ = other.evictions_;
+      entries_ = other.entries_;
+      RebuildIndex();
+    }
+    return *this;
+  }
+  StatementCache(StatementCache&&) = default;
+  StatementCache& operator=(StatementCache&&) = default;
+
+  /**
+   * Returns the statement with the given key and marks it as the most recently used one,
+   * or nullptr if there is none.
+   */
+  TValue* Find(const TKey& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return &iter->second->second;
+  }
+
+  bool Contains(const TKey& key) const { return index_.contains(key); }
+
+  /**
+   * Inserts or replaces the statement with the given key, evicting the least recently used
+   * statement if the cache is full.
+   */
+  TValue& Insert(TKey key, TValue value) {
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      iter->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, iter->second);
+      return iter->second->second;
+    }
+
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+      ++evictions_;
+    }
+
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(std::move(key), entries_.begin());
+    return entries_.front().second;
+  }
+
+  /**
+   * Removes the statement with the given key. Returns false if there was none.
+   */
+  bool Erase(const TKey& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return false;
+    }
+    entries_.erase(iter->second);
+    index_.erase(iter);
+    return true;
+  }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  size_t capacity() const { return capacity_; }
+
+  // The number of statements dropped to make room for new ones.
+  uint64_t evictions() const { return evictions_; }
+
+ private:
+  using Entry = std::pair<TKey, TValue>;
+
+  void RebuildIndex() {
+    index_.clear();
+    for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+      index_.emplace(iter->first, iter);
+    }
+  }
+
+  size_t capacity_;
+  uint64_t evictions_ = 0;
+
+  // Most recently used first.
+  std::list<Entry> entries_;
+  absl::flat_hash_map<TKey, typename std::list<Entry>::iterator> index_;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
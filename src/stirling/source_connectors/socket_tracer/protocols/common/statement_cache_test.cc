@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+TEST(StatementCacheTest, InsertFindErase) {
+  StatementCache<int, std::string> cache(4);
+  cache.Insert(1, "SELECT 1");
+  cache.Insert(2, "SELECT 2");
+  ASSERT_NE(cache.Find(1), nullptr);
+  EXPECT_EQ(*cache.Find(1), "SELECT 1");
+  EXPECT_EQ(cache.Find(3), nullptr);
+
+  cache.Insert(1, "SELECT 11");
+  EXPECT_EQ(*cache.Find(1), "SELECT 11");
+  EXPECT_EQ(cache.size(), 2);
+
+  EXPECT_TRUE(cache.Erase(1));
+  EXPECT_FALSE(cache.Erase(1));
+  EXPECT_FALSE(cache.Contains(1));
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.evictions(), 0);
+}
+
+TEST(StatementCacheTest, EvictsLeastRecentlyUsed) {
+  StatementCache<std::string, std::string> cache(2);
+  cache.Insert("a", "SELECT a");
+  cache.Insert("b", "SELECT b");
+  // Touching "a" makes "b" the least recently used statement.
+  ASSERT_NE(cache.Find("a"), nullptr);
+  cache.Insert("c", "SELECT c");
+
+  EXPECT_TRUE(cache.Contains("a"));
+  EXPECT_FALSE(cache.Contains("b"));
+  EXPECT_TRUE(cache.Contains("c"));
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.evictions(), 1);
+}
+
+TEST(StatementCacheTest, CopyHasOwnIndex) {
+  StatementCache<int, std::string> cache(2);
+  cache.Insert(1, "SELECT 1");
+
+  StatementCache<int, std::string> copy = cache;
+  cache.Erase(1);
+  ASSERT_NE(copy.Find(1), nullptr);
+  EXPECT_EQ(*copy.Find(1), "SELECT 1");
+  copy.Insert(2, "SELECT 2");
+  copy.Insert(3, "SELECT 3");
+  EXPECT_EQ(copy.evictions(), 1);
+  EXPECT_EQ(cache.evictions(), 0);
+}
+
+TEST(StatementCacheTest, ZeroCapacityKeepsOne) {
+  StatementCache<int, std::string> cache(0);
+  cache.Insert(1, "SELECT 1");
+  cache.Insert(2, "SELECT 2");
+  EXPECT_EQ(cache.capacity(), 1);
+  EXPECT_FALSE(cache.Contains(1));
+  EXPECT_TRUE(cache.Contains(2));
+  EXPECT_EQ(cache.evictions(), 1);
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
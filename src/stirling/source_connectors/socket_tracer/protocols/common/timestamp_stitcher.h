@@ -18,8 +18,8 @@
 
 #pragma once
 
+#include <algorithm>
 #include <deque>
-#include <limits>
 #include <utility>
 #include <vector>
 
@@ -47,40 +47,31 @@ template <typename TRecordType, typename TMessageType>
 RecordsWithErrorCount<TRecordType> StitchMessagesWithTimestampOrder(
     std::deque<TMessageType>* req_messages, std::deque<TMessageType>* resp_messages) {
   std::vector<TRecordType> records;
-
-  TRecordType record;
-  record.req.timestamp_ns = 0;
-  record.resp.timestamp_ns = 0;
-
-  TMessageType dummy_message;
-  dummy_message.timestamp_ns = std::numeric_limits<int64_t>::max();
+  records.reserve(std::min(req_messages->size(), resp_messages->size()));
 
   // Implementation resembles a merge-sort of the two deques.
-  // Each iteration, we pop off either a request or response message.
+  // Each iteration, we consume either a request or response message. Matched messages are moved
+  // straight into the records, and the consumed prefixes of the deques are released in bulk.
   auto req_iter = req_messages->begin();
   auto resp_iter = resp_messages->begin();
+  // The latest request that has not been matched with a response yet.
+  auto pending_req_iter = req_messages->end();
   while (resp_iter != resp_messages->end()) {
-    TMessageType& req = (req_iter == req_messages->end()) ? dummy_message : *req_iter;
-    TMessageType& resp = (resp_iter == resp_messages->end()) ? dummy_message : *resp_iter;
-
     // Process the oldest item, either a request or response.
-    if (req.timestamp_ns < resp.timestamp_ns) {
-      // Requests always go into the record (though not pushed yet).
-      // If the next oldest item is a request too, it will (correctly) clobber this one.
-      record.req = std::move(req);
+    if (req_iter != req_messages->end() && req_iter->timestamp_ns < resp_iter->timestamp_ns) {
+      // Requests always become the pending request.
+      // If the next oldest item is a request too, it will (correctly) replace this one.
+      pending_req_iter = req_iter;
       ++req_iter;
     } else {
       // Two cases for a response:
       // 1) No older request was found: then we ignore the response.
       // 2) An older request was found: then it is considered a match. Push the record, and reset.
-      if (record.req.timestamp_ns != 0) {
-        record.resp = std::move(resp);
-
-        records.push_back(std::move(record));
-
-        // Reset record after pushing.
-        record.req.timestamp_ns = 0;
-        record.resp.timestamp_ns = 0;
+      if (pending_req_iter != req_messages->end()) {
+        TRecordType& record = records.emplace_back();
+        record.req = std::move(*pending_req_iter);
+        record.resp = std::move(*resp_iter);
+        pending_req_iter = req_messages->end();
       }
       ++resp_iter;
     }
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/virtual_ring_buffer.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Maps size bytes of memory twice, back-to-back, and returns the start of the first mapping.
+//
+// The second mapping is created by mremap() with an old size of 0, which duplicates a shared
+// mapping instead of moving it. Unlike the usual memfd-based approach, this needs no file
+// descriptor, which matters because there is a ring per traced data stream.
+StatusOr<char*> MapDoubleRing(size_t size) {
+  // Reserve the full range first, so both halves can be placed at fixed addresses.
+  void* addr = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Failed to reserve ring buffer memory ($0)", std::strerror(errno));
+  }
+  char* base = static_cast<char*>(addr);
+
+  if (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_FIXED, -1, 0) ==
+      MAP_FAILED) {
+    Status s = error::Internal("Failed to map ring buffer memory ($0)", std::strerror(errno));
+    munmap(base, 2 * size);
+    return s;
+  }
+
+  if (mremap(base, 0, size, MREMAP_MAYMOVE | MREMAP_FIXED, base + size) == MAP_FAILED) {
+    Status s = error::Internal("Failed to mirror ring buffer memory ($0)", std::strerror(errno));
+    munmap(base, 2 * size);
+    return s;
+  }
+
+  return base;
+}
+
+}  // namespace
+
+Status VirtualRingBuffer::Remap(size_t min_size, size_t offset, size_t len) {
+  DCHECK_LE(len, size_);
+
+  static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+  size_t new_size = RoundUpToPowerOfTwo(std::max(min_size, kPageSize));
+  DCHECK_GE(new_size, len);
+
+  PL_ASSIGN_OR_RETURN(char* new_base, MapDoubleRing(new_size));
+  if (len > 0) {
+    // A single copy is enough, since the old ring is contiguous across its wrap point.
+    memcpy(new_base, data(offset), len);
+  }
+
+  Reset();
+  base_ = new_base;
+  size_ = new_size;
+  return Status::OK();
+}
+
+void VirtualRingBuffer::Reset() {
+  if (base_ != nullptr) {
+    munmap(base_, 2 * size_);
+  }
+  base_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
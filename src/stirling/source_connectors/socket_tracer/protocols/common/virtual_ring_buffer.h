@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <string>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * VirtualRingBuffer is a ring of memory whose pages are mapped twice, back-to-back, in virtual
+ * memory. Any span of up to size() bytes starting anywhere in the ring is therefore contiguous,
+ * even when it wraps around the end of the ring, so readers can be handed a plain pointer
+ * without first copying the data into place.
+ *
+ * The size of the ring is always a power-of-two number of pages. The ring is empty (size() == 0)
+ * until it is first mapped with Remap().
+ */
+class VirtualRingBuffer : public NotCopyMoveable {
+ public:
+  VirtualRingBuffer() = default;
+  ~VirtualRingBuffer() { Reset(); }
+
+  /**
+   * Replaces the ring with a new one of at least min_size bytes.
+   * The len bytes at the given offset of the old ring are copied to offset 0 of the new ring.
+   * On failure, the old ring is left untouched.
+   */
+  Status Remap(size_t min_size, size_t offset, size_t len);
+
+  /**
+   * Unmaps the ring, leaving it empty.
+   */
+  void Reset();
+
+  /**
+   * Pointer to the byte at the given offset. Offsets wrap around the ring, and there are always
+   * size() contiguous bytes available from the returned pointer.
+   */
+  char* data(size_t offset) const { return base_ + (offset & (size_ - 1)); }
+
+  /**
+   * The number of bytes in the ring.
+   */
+  size_t size() const { return size_; }
+
+ private:
+  char* base_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/virtual_ring_buffer.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+TEST(VirtualRingBufferTest, SizeIsPowerOfTwoPages) {
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+
+  VirtualRingBuffer ring;
+  EXPECT_EQ(ring.size(), 0);
+
+  ASSERT_OK(ring.Remap(1, 0, 0));
+  EXPECT_EQ(ring.size(), page_size);
+
+  ASSERT_OK(ring.Remap(3 * page_size, 0, 0));
+  EXPECT_EQ(ring.size(), 4 * page_size);
+
+  ring.Reset();
+  EXPECT_EQ(ring.size(), 0);
+}
+
+TEST(VirtualRingBufferTest, ContiguousAcrossWrap) {
+  VirtualRingBuffer ring;
+  ASSERT_OK(ring.Remap(1, 0, 0));
+  const size_t size = ring.size();
+
+  // Write across the end of the ring through the mirrored pages.
+  const std::string data = "0123456789";
+  memcpy(ring.data(size - 4), data.data(), data.size());
+
+  EXPECT_EQ(std::string_view(ring.data(size - 4), data.size()), data);
+  EXPECT_EQ(std::string_view(ring.data(0), 6), "456789");
+  EXPECT_EQ(std::string_view(ring.data(2 * size + 1), 3), "567");
+}
+
+TEST(VirtualRingBufferTest, RemapKeepsData) {
+  VirtualRingBuffer ring;
+  ASSERT_OK(ring.Remap(1, 0, 0));
+  const size_t size = ring.size();
+
+  const std::string data = "0123456789";
+  memcpy(ring.data(size - 4), data.data(), data.size());
+
+  ASSERT_OK(ring.Remap(2 * size, size - 4, data.size()));
+  EXPECT_EQ(ring.size(), 2 * size);
+  EXPECT_EQ(std::string_view(ring.data(0), data.size()), data);
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
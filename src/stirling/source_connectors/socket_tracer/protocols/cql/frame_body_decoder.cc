@@ -48,10 +48,8 @@ StatusOr<TFloatType> ExtractFloatCore(std::string_view* buf) {
 }
 
 template <typename TCharType>
-StatusOr<std::basic_string<TCharType>> FrameBodyDecoder::ExtractBytesCore(int64_t len) {
-  PL_ASSIGN_OR_RETURN(std::basic_string_view<TCharType> tbuf,
-                      binary_decoder_.ExtractString<TCharType>(len));
-  return std::basic_string<TCharType>(tbuf);
+StatusOr<std::basic_string_view<TCharType>> FrameBodyDecoder::ExtractBytesCore(int64_t len) {
+  return binary_decoder_.ExtractString<TCharType>(len);
 }
 
 template <typename TCharType, size_t N>
@@ -81,13 +79,13 @@ StatusOr<float> ExtractFloat(std::string_view* buf) { return ExtractFloatCore<fl
 StatusOr<double> ExtractDouble(std::string_view* buf) { return ExtractFloatCore<double>(buf); }
 
 // [string] A [short] n, followed by n bytes representing an UTF-8 string.
-StatusOr<std::string> FrameBodyDecoder::ExtractString() {
+StatusOr<std::string_view> FrameBodyDecoder::ExtractString() {
   PL_ASSIGN_OR_RETURN(uint16_t len, ExtractShort());
   return ExtractBytesCore<char>(len);
 }
 
 // [long string] An [int] n, followed by n bytes representing an UTF-8 string.
-StatusOr<std::string> FrameBodyDecoder::ExtractLongString() {
+StatusOr<std::string_view> FrameBodyDecoder::ExtractLongString() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   len = std::max(len, 0);
   return ExtractBytesCore<char>(len);
@@ -134,9 +132,10 @@ StatusOr<StringList> FrameBodyDecoder::ExtractStringList() {
   PL_ASSIGN_OR_RETURN(uint16_t n, ExtractShort());
 
   StringList string_list;
+  string_list.reserve(n);
   for (int i = 0; i < n; ++i) {
-    PL_ASSIGN_OR_RETURN(std::string s, ExtractString());
-    string_list.push_back(std::move(s));
+    PL_ASSIGN_OR_RETURN(std::string_view s, ExtractString());
+    string_list.push_back(s);
   }
 
   return string_list;
@@ -144,7 +143,7 @@ StatusOr<StringList> FrameBodyDecoder::ExtractStringList() {
 
 // [bytes] A [int] n, followed by n bytes if n >= 0. If n < 0,
 //         no byte should follow and the value represented is `null`.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractBytes() {
+StatusOr<Bytes> FrameBodyDecoder::ExtractBytes() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   len = std::max(len, 0);
   return ExtractBytesCore<uint8_t>(len);
@@ -154,14 +153,14 @@ StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractBytes() {
 //         If n == -1 no byte should follow and the value represented is `null`.
 //         If n == -2 no byte should follow and the value represented is
 //         `not set` not resulting in any change to the existing value.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractValue() {
+StatusOr<Bytes> FrameBodyDecoder::ExtractValue() {
   PL_ASSIGN_OR_RETURN(int32_t len, ExtractInt());
   if (len == -1) {
-    return std::basic_string<uint8_t>();
+    return Bytes();
   }
   if (len == -2) {
     // TODO(oazizi): Need to send back 'not set' instead.
-    return std::basic_string<uint8_t>();
+    return Bytes();
   }
   if (len < 0) {
     return error::Internal("Invalid length for value.");
@@ -170,7 +169,7 @@ StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractValue() {
 }
 
 // [short bytes]  A [short] n, followed by n bytes if n >= 0.
-StatusOr<std::basic_string<uint8_t>> FrameBodyDecoder::ExtractShortBytes() {
+StatusOr<Bytes> FrameBodyDecoder::ExtractShortBytes() {
   PL_ASSIGN_OR_RETURN(uint16_t len, ExtractShort());
   return ExtractBytesCore<uint8_t>(len);
 }
@@ -210,9 +209,9 @@ StatusOr<StringMap> FrameBodyDecoder::ExtractStringMap() {
 
   StringMap string_map;
   for (int i = 0; i < n; ++i) {
-    PL_ASSIGN_OR_RETURN(std::string key, ExtractString());
-    PL_ASSIGN_OR_RETURN(std::string val, ExtractString());
-    string_map.insert({std::move(key), std::move(val)});
+    PL_ASSIGN_OR_RETURN(std::string_view key, ExtractString());
+    PL_ASSIGN_OR_RETURN(std::string_view val, ExtractString());
+    string_map.insert({key, val});
   }
 
   return string_map;
@@ -225,7 +224,7 @@ StatusOr<StringMultiMap> FrameBodyDecoder::ExtractStringMultiMap() {
 
   StringMultiMap string_multimap;
   for (int i = 0; i < n; ++i) {
-    PL_ASSIGN_OR_RETURN(std::string key, ExtractString());
+    PL_ASSIGN_OR_RETURN(std::string_view key, ExtractString());
     PL_ASSIGN_OR_RETURN(StringList val, ExtractStringList());
     string_multimap.insert({std::move(key), std::move(val)});
   }
@@ -272,6 +271,7 @@ StatusOr<std::vector<NameValuePair>> FrameBodyDecoder::ExtractNameValuePairList(
   std::vector<NameValuePair> values;
 
   PL_ASSIGN_OR_RETURN(uint16_t n, ExtractShort());
+  values.reserve(n);
   for (int i = 0; i < n; ++i) {
     PL_ASSIGN_OR_RETURN(NameValuePair v, ExtractNameValuePair(with_names));
     values.push_back(std::move(v));
@@ -348,6 +348,8 @@ StatusOr<ResultMetadata> FrameBodyDecoder::ExtractResultMetadata(bool prepared_r
       PL_ASSIGN_OR_RETURN(r.gts_table_name, ExtractString());
     }
 
+    // Bound the reservation by the remaining bytes, in case columns_count is garbage.
+    r.col_specs.reserve(std::min<size_t>(std::max(r.columns_count, 0), binary_decoder_.BufSize()));
     for (int i = 0; i < r.columns_count; ++i) {
       ColSpec col_spec;
       if (!flag_global_tables_spec) {
@@ -449,6 +451,7 @@ StatusOr<BatchReq> ParseBatchReq(Frame* frame) {
 
   PL_ASSIGN_OR_RETURN(uint16_t n, decoder.ExtractShort());
 
+  r.queries.reserve(n);
   for (uint i = 0; i < n; ++i) {
     BatchQuery q;
     PL_ASSIGN_OR_RETURN(uint8_t kind_raw, decoder.ExtractByte());
@@ -566,8 +569,7 @@ StatusOr<ResultRowsResp> ParseResultRows(FrameBodyDecoder* decoder) {
   ResultRowsResp r;
   PL_ASSIGN_OR_RETURN(r.metadata, decoder->ExtractResultMetadata());
   PL_ASSIGN_OR_RETURN(r.rows_count, decoder->ExtractInt());
-  // Skip grabbing the row content for now.
-  // PL_RETURN_IF_ERROR(decoder->ExpectEOF());
+  // The rows are only counted, so their cells are left undecoded in the frame.
   return r;
 }
 
@@ -21,6 +21,8 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
+#include <variant>
 #include <vector>
 
 #include <sole.hpp>
@@ -39,10 +41,14 @@ namespace cass {
 // https://git-wip-us.apache.org/repos/asf?p=cassandra.git;a=blob_plain;f=doc/native_protocol_v3.spec
 // for a discussion on types.
 
+// Strings and bytes in the types below are views into the body of the frame they were decoded
+// from, and are only valid for as long as that frame is.
+using Bytes = std::basic_string_view<uint8_t>;
+
 // Some complex CQL types defined in the spec.
-using StringList = std::vector<std::string>;
-using StringMap = std::map<std::string, std::string>;
-using StringMultiMap = std::map<std::string, StringList>;
+using StringList = std::vector<std::string_view>;
+using StringMap = std::map<std::string_view, std::string_view>;
+using StringMultiMap = std::map<std::string_view, StringList>;
 
 // See section 4.2.5.2 of
 // https://git-wip-us.apache.org/repos/asf?p=cassandra.git;a=blob_plain;f=doc/native_protocol_v3.spec
@@ -74,7 +80,7 @@ struct Option {
   DataType type;
 
   // Value is only used if DataType is kCustom.
-  std::string value;
+  std::string_view value;
 
   // TODO(oazizi): Store the additional information if DataType is kList/kMap/kSet/kUDT/kTuple.
 };
@@ -82,8 +88,8 @@ struct Option {
 // TODO(oazizi): Consider using std::optional when values are optional in the structs below.
 
 struct NameValuePair {
-  std::string name;
-  std::basic_string<uint8_t> value;
+  std::string_view name;
+  Bytes value;
 };
 
 // QueryParameters is a complex type used in QUERY and EXECUTE requests.
@@ -96,7 +102,7 @@ struct QueryParameters {
   uint16_t flags;
   std::vector<NameValuePair> values;
   int32_t page_size = 0;
-  std::basic_string<uint8_t> paging_state;
+  Bytes paging_state;
   uint16_t serial_consistency = 0;
   int64_t timestamp = 0;
 };
@@ -105,9 +111,9 @@ struct QueryParameters {
 // (<ksname><tablename>)?<name><type>
 // See section 4.2.5.2 of the spec for more details.
 struct ColSpec {
-  std::string ks_name;
-  std::string table_name;
-  std::string name;
+  std::string_view ks_name;
+  std::string_view table_name;
+  std::string_view name;
   Option type;
 };
 
@@ -117,9 +123,9 @@ struct ColSpec {
 struct ResultMetadata {
   int32_t flags;
   int32_t columns_count;
-  std::basic_string<uint8_t> paging_state;
-  std::string gts_keyspace_name;
-  std::string gts_table_name;
+  Bytes paging_state;
+  std::string_view gts_keyspace_name;
+  std::string_view gts_table_name;
   std::vector<ColSpec> col_specs;
 };
 
@@ -127,19 +133,19 @@ struct ResultMetadata {
 // See section 4.2.6 of the spec for details.
 struct SchemaChange {
   // One of "CREATED", "UPDATED" or "DROPPED"
-  std::string change_type;
+  std::string_view change_type;
 
   // One of "KEYSPACE", "TABLE", "TYPE", "FUNCTION" or "AGGREGATE"
-  std::string target;
+  std::string_view target;
 
-  std::string keyspace;
+  std::string_view keyspace;
 
   // If target is KEYSPACE, then name is unused;
   // If target is TABLE, then name is table name.
   // If target is TYPE, then name is user type name.
   // If target is FUNCTION, then name is function name.
   // If target is AGGREGATE, then name is aggregate name.
-  std::string name;
+  std::string_view name;
 
   // Only used for FUNCTION or AGGREGATE.
   StringList arg_types;
@@ -149,13 +155,13 @@ enum class BatchQueryKind : uint8_t { kString = 0, kID = 1 };
 
 struct BatchQuery {
   BatchQueryKind kind;
-  std::variant<std::string, std::basic_string<uint8_t>> query_or_id;
+  std::variant<std::string_view, Bytes> query_or_id;
   std::vector<NameValuePair> values;
 };
 
 struct ErrorResp {
   int32_t error_code;
-  std::string error_msg;
+  std::string_view error_msg;
 };
 
 struct StartupReq {
@@ -167,7 +173,7 @@ struct ReadyResp {
 };
 
 struct AuthenticateResp {
-  std::string authenticator_name;
+  std::string_view authenticator_name;
 };
 
 struct OptionsReq {
@@ -179,7 +185,7 @@ struct SupportedResp {
 };
 
 struct QueryReq {
-  std::string query;
+  std::string_view query;
   QueryParameters qp;
 };
 
@@ -188,15 +194,15 @@ struct ResultVoidResp {};
 struct ResultRowsResp {
   ResultMetadata metadata;
   int32_t rows_count;
-  // Don't actually grab the row content for now.
+  // The row content is not decoded; only the rows and columns are counted.
 };
 
 struct ResultSetKeyspaceResp {
-  std::string keyspace_name;
+  std::string_view keyspace_name;
 };
 
 struct ResultPreparedResp {
-  std::basic_string<uint8_t> id;
+  Bytes id;
   // Note that two metadata are sent back. The first communicates the col specs for the Prepared
   // statement, while the second communicates the metadata for future EXECUTE statements.
   ResultMetadata metadata;
@@ -223,11 +229,11 @@ struct ResultResp {
 };
 
 struct PrepareReq {
-  std::string query;
+  std::string_view query;
 };
 
 struct ExecuteReq {
-  std::basic_string<uint8_t> id;
+  Bytes id;
   QueryParameters qp;
 };
 
@@ -237,10 +243,10 @@ struct RegisterReq {
 
 // TODO(oazizi): Consider switching event_type string into enum for efficiency.
 struct EventResp {
-  std::string event_type;
+  std::string_view event_type;
 
   // Following fields are for (event_type == "TOPOLOGY_CHANGE" || event_type == "STATUS_CHANGE")
-  std::string change_type;
+  std::string_view change_type;
   SockAddr addr;
 
   // Following fields are for (event_type == "SCHEMA_CHANGE")
@@ -268,15 +274,15 @@ struct BatchReq {
 };
 
 struct AuthChallengeResp {
-  std::basic_string<uint8_t> token;
+  Bytes token;
 };
 
 struct AuthResponseReq {
-  std::basic_string<uint8_t> token;
+  Bytes token;
 };
 
 struct AuthSuccessResp {
-  std::basic_string<uint8_t> token;
+  Bytes token;
 };
 
 /**
@@ -285,6 +291,9 @@ struct AuthSuccessResp {
  * After creating the decoder, successive calls to the Extract<Type> functions will process
  * the bytes as the desired type.
  *
+ * Strings and bytes are returned as views into the buffer, so nothing is copied out of the frame.
+ * The buffer must outlive the returned values.
+ *
  * If there are not enough bytes to process the type, an error Status will be returned.
  * The decoder will then be in an undefined state, and the result of any subsequent calls
  * to any Extract functions are also undefined.
@@ -318,10 +327,10 @@ class FrameBodyDecoder {
   StatusOr<uint8_t> ExtractByte();
 
   // [string] A [short] n, followed by n bytes representing an UTF-8 string.
-  StatusOr<std::string> ExtractString();
+  StatusOr<std::string_view> ExtractString();
 
   // [long string] An [int] n, followed by n bytes representing an UTF-8 string.
-  StatusOr<std::string> ExtractLongString();
+  StatusOr<std::string_view> ExtractLongString();
 
   // [uuid] A 16 bytes long uuid.
   StatusOr<sole::uuid> ExtractUUID();
@@ -331,16 +340,16 @@ class FrameBodyDecoder {
 
   // [bytes] A [int] n, followed by n bytes if n >= 0. If n < 0,
   //         no byte should follow and the value represented is `null`.
-  StatusOr<std::basic_string<uint8_t>> ExtractBytes();
+  StatusOr<Bytes> ExtractBytes();
 
   // [value] A [int] n, followed by n bytes if n >= 0.
   //         If n == -1 no byte should follow and the value represented is `null`.
   //         If n == -2 no byte should follow and the value represented is
   //         `not set` not resulting in any change to the existing value.
-  StatusOr<std::basic_string<uint8_t>> ExtractValue();
+  StatusOr<Bytes> ExtractValue();
 
   // [short bytes]  A [short] n, followed by n bytes if n >= 0.
-  StatusOr<std::basic_string<uint8_t>> ExtractShortBytes();
+  StatusOr<Bytes> ExtractShortBytes();
 
   // [option] A pair of <id><value> where <id> is a [short] representing
   //          the option id and <value> depends on that option (and can be
@@ -399,7 +408,7 @@ class FrameBodyDecoder {
   StatusOr<TIntType> ExtractIntCore();
 
   template <typename TCharType>
-  StatusOr<std::basic_string<TCharType>> ExtractBytesCore(int64_t len);
+  StatusOr<std::basic_string_view<TCharType>> ExtractBytesCore(int64_t len);
 
   template <typename TCharType, size_t N>
   Status ExtractBytesCore(TCharType* out);
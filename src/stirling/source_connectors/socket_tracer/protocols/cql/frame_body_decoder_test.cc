@@ -294,6 +294,13 @@ TEST(ExtractString, Oversized) {
   ASSERT_FALSE(decoder.eof());
 }
 
+TEST(ExtractString, ViewsIntoBuffer) {
+  FrameBodyDecoder decoder(kString);
+  ASSERT_OK_AND_ASSIGN(std::string_view s, decoder.ExtractString());
+  // The [short] length precedes the string.
+  EXPECT_EQ(s.data(), kString.data() + sizeof(uint16_t));
+}
+
 TEST(ExtractString, EmptyString) {
   FrameBodyDecoder decoder(kEmptyString);
   ASSERT_OK_AND_THAT(decoder.ExtractString(), IsEmpty());
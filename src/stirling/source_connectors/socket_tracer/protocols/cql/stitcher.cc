@@ -85,6 +85,7 @@ Status ProcessQueryReq(Frame* req_frame, Request* req) {
   // Real implementation should figure out what type each value is, and cast into the appropriate
   // type. This, however, will be hard unless we have observed the preceding Prepare request.
   std::vector<std::string> hex_values;
+  hex_values.reserve(r.qp.values.size());
   for (const auto& value_i : r.qp.values) {
     hex_values.push_back(BytesToString(value_i.value));
   }
@@ -117,6 +118,7 @@ Status ProcessExecuteReq(Frame* req_frame, Request* req) {
   // Real implementation should figure out what type each value is, and cast into the appropriate
   // type. This, however, will be hard unless we have observed the preceding Prepare request.
   std::vector<std::string> hex_values;
+  hex_values.reserve(r.qp.values.size());
   for (const auto& value_i : r.qp.values) {
     hex_values.push_back(BytesToString(value_i.value));
   }
@@ -134,14 +136,15 @@ Status ProcessBatchReq(Frame* req_frame, Request* req) {
 
   // Copy to vector so we can use ToJSONString().
   // TODO(oazizi): Find a cleaner way that avoids the copying.
-  std::vector<std::pair<std::string, std::string>> tmp;
+  std::vector<std::pair<std::string_view, std::string>> tmp;
+  tmp.reserve(r.queries.size());
   for (const auto& q : r.queries) {
     switch (q.kind) {
       case BatchQueryKind::kString:
-        tmp.push_back({"query", std::move(std::get<std::string>(q.query_or_id))});
+        tmp.push_back({"query", std::string(std::get<std::string_view>(q.query_or_id))});
         break;
       case BatchQueryKind::kID:
-        tmp.push_back({"id", BytesToString(std::get<std::basic_string<uint8_t>>(q.query_or_id))});
+        tmp.push_back({"id", BytesToString(std::get<Bytes>(q.query_or_id))});
         break;
       default:
         LOG(DFATAL) << absl::Substitute("Unrecognized BatchQueryKind $0", static_cast<int>(q.kind));
@@ -183,7 +186,7 @@ Status ProcessAuthenticateResp(Frame* resp_frame, Response* resp) {
   PL_ASSIGN_OR_RETURN(AuthenticateResp r, ParseAuthenticateResp(resp_frame));
 
   DCHECK(resp->msg.empty());
-  resp->msg = std::move(r.authenticator_name);
+  resp->msg = r.authenticator_name;
 
   return Status::OK();
 }
@@ -223,12 +226,11 @@ Status ProcessResultResp(Frame* resp_frame, Response* resp) {
     case ResultRespKind::kRows: {
       const auto& r_resp = std::get<ResultRowsResp>(r.resp);
 
-      // Copy to vector so we can use ToJSONString().
-      // TODO(oazizi): Find a cleaner way. This is temporary anyways.
-
-      std::vector<std::string> names;
-      for (auto& c : r_resp.metadata.col_specs) {
-        names.push_back(std::move(c.name));
+      // The names are views into the frame, so collecting them does not copy any strings.
+      std::vector<std::string_view> names;
+      names.reserve(r_resp.metadata.col_specs.size());
+      for (const auto& c : r_resp.metadata.col_specs) {
+        names.push_back(c.name);
       }
 
       resp->msg = absl::StrCat("Response type = ROWS\n",
@@ -375,11 +377,15 @@ StatusOr<Record> ProcessSolitaryResp(Frame* resp_frame) {
 RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
                                            std::deque<Frame>* resp_frames) {
   std::vector<Record> entries;
+  entries.reserve(resp_frames->size());
   int error_count = 0;
 
-  for (auto& resp_frame : *resp_frames) {
-    bool found_match = false;
+  // Consumed frames are released in bulk at the end, rather than popped one at a time.
+  // req_begin skips the consumed requests at the head, to speed up the search for the next
+  // response.
+  auto req_begin = req_frames->begin();
 
+  for (auto& resp_frame : *resp_frames) {
     // Event responses are special: they have no request.
     if (resp_frame.hdr.opcode == Opcode::kEvent) {
       StatusOr<Record> record_status = ProcessSolitaryResp(&resp_frame);
@@ -389,12 +395,17 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
         VLOG(1) << record_status.msg();
         ++error_count;
       }
-      resp_frames->pop_front();
       continue;
     }
 
+    bool found_match = false;
+
     // Search for matching req frame
-    for (auto& req_frame : *req_frames) {
+    for (auto req_iter = req_begin; req_iter != req_frames->end(); ++req_iter) {
+      Frame& req_frame = *req_iter;
+      if (req_frame.consumed) {
+        continue;
+      }
       if (resp_frame.hdr.stream == req_frame.hdr.stream) {
         VLOG(2) << absl::Substitute("req_op=$0 msg=$1", magic_enum::enum_name(req_frame.hdr.opcode),
                                     req_frame.msg);
@@ -407,14 +418,10 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
           ++error_count;
         }
 
-        // Found a match, so remove both request and response.
-        // We don't remove request frames on the fly, however,
-        // because it could otherwise cause unnecessary churn/copying in the deque.
-        // This is due to the fact that responses can come out-of-order.
+        // Found a match, so consume both request and response.
+        // Requests are not removed on the fly, because responses can come out-of-order.
         // Just mark the request as consumed, and clean-up when they reach the head of the queue.
-        // Note that responses are always head-processed, so they don't require this optimization.
         found_match = true;
-        resp_frames->pop_front();
         req_frame.consumed = true;
         break;
       }
@@ -426,14 +433,8 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
       ++error_count;
     }
 
-    // Clean-up consumed frames at the head.
-    // Do this inside the resp loop to aggressively clean-out req_frames whenever a frame consumed.
-    // Should speed up the req_frames search for the next iteration.
-    for (auto& req_frame : *req_frames) {
-      if (!req_frame.consumed) {
-        break;
-      }
-      req_frames->pop_front();
+    while (req_begin != req_frames->end() && req_begin->consumed) {
+      ++req_begin;
     }
 
     // TODO(oazizi): Consider removing requests that are too old, otherwise a lost response can mean
@@ -441,7 +442,12 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
     // tracker clean-up mechanisms kick in.
   }
 
-  return {entries, error_count};
+  // Responses are always head-processed, so all of them are consumed; the ones without a matching
+  // request were counted as errors above.
+  resp_frames->clear();
+  req_frames->erase(req_frames->begin(), req_begin);
+
+  return {std::move(entries), error_count};
 }
 
 }  // namespace cass
@@ -22,6 +22,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <utility>
@@ -178,20 +179,27 @@ StatusOr<Record> ProcessReqRespPair(const Frame& req_frame, const Frame& resp_fr
 RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
                                            std::deque<Frame>* resp_frames) {
   std::vector<Record> entries;
+  entries.reserve(std::min(req_frames->size(), resp_frames->size()));
   int error_count = 0;
 
+  // Consumed frames are released in bulk at the end, rather than popped one at a time.
+  // req_begin skips the consumed requests at the head, to speed up the search for the next
+  // response.
+  auto req_begin = req_frames->begin();
+
   for (auto& resp_frame : *resp_frames) {
     bool found_match = false;
 
     // Search for matching req frame
-    for (auto& req_frame : *req_frames) {
+    for (auto req_iter = req_begin; req_iter != req_frames->end(); ++req_iter) {
+      Frame& req_frame = *req_iter;
       // If the request timestamp is after the response, then it can't be the match.
       // Nor can any subsequent requests either, so stop searching.
       if (req_frame.timestamp_ns > resp_frame.timestamp_ns) {
         break;
       }
 
-      if (resp_frame.header.txid == req_frame.header.txid) {
+      if (!req_frame.consumed && resp_frame.header.txid == req_frame.header.txid) {
         StatusOr<Record> record_status = ProcessReqRespPair(req_frame, resp_frame);
         if (record_status.ok()) {
           entries.push_back(record_status.ConsumeValueOrDie());
@@ -200,14 +208,10 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
           ++error_count;
         }
 
-        // Found a match, so remove both request and response.
-        // We don't remove request frames on the fly, however,
-        // because it could otherwise cause unnecessary churn/copying in the deque.
-        // This is due to the fact that responses can come out-of-order.
+        // Found a match, so consume both request and response.
+        // Requests are not removed on the fly, because responses can come out-of-order.
         // Just mark the request as consumed, and clean-up when they reach the head of the queue.
-        // Note that responses are always head-processed, so they don't require this optimization.
         found_match = true;
-        resp_frames->pop_front();
         req_frame.consumed = true;
         break;
       }
@@ -219,14 +223,8 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
       ++error_count;
     }
 
-    // Clean-up consumed frames at the head.
-    // Do this inside the resp loop to aggressively clean-out req_frames whenever a frame consumed.
-    // Should speed up the req_frames search for the next iteration.
-    for (auto& req_frame : *req_frames) {
-      if (!req_frame.consumed) {
-        break;
-      }
-      req_frames->pop_front();
+    while (req_begin != req_frames->end() && req_begin->consumed) {
+      ++req_begin;
     }
 
     // TODO(oazizi): Consider removing requests that are too old, otherwise a lost response can mean
@@ -234,7 +232,12 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Frame>* req_frames,
     // tracker clean-up mechanisms kick in.
   }
 
-  return {entries, error_count};
+  // Responses are always head-processed, so all of them are consumed; the ones without a matching
+  // request were counted as errors above.
+  resp_frames->clear();
+  req_frames->erase(req_frames->begin(), req_begin);
+
+  return {std::move(entries), error_count};
 }
 
 }  // namespace dns
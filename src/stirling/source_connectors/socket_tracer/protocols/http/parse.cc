@@ -21,9 +21,13 @@
 #include <picohttpparser.h>
 
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/body_capture.h"
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -31,14 +35,13 @@ namespace http {
 
 namespace {
 
-HeadersMap GetHTTPHeadersMap(const phr_header* headers, size_t num_headers) {
-  HeadersMap result;
+// The headers are added in place, so that they are allocated with the allocator of result.
+void SetHTTPHeaders(const phr_header* headers, size_t num_headers, HeadersMap* result) {
+  result->clear();
   for (size_t i = 0; i < num_headers; i++) {
-    std::string name(headers[i].name, headers[i].name_len);
-    std::string value(headers[i].value, headers[i].value_len);
-    result.insert({name, value});
+    result->emplace(std::string_view(headers[i].name, headers[i].name_len),
+                    std::string_view(headers[i].value, headers[i].value_len));
   }
-  return result;
 }
 
 }  // namespace
@@ -51,27 +54,60 @@ namespace pico_wrapper {
 
 namespace {
 
+// The number of bytes kept from the head of the message body. Compressed bodies are kept whole,
+// since PreProcessMessage() can't decompress the head of a body on its own.
+size_t BodyCaptureLimit(const Message& message) {
+  if (message.headers.find(kContentEncoding) != message.headers.end()) {
+    return std::numeric_limits<size_t>::max();
+  }
+  return BodyCapturePolicy::Get().max_bytes();
+}
+
+// Keeps the part of the body that the body capture policy selects, and counts the rest.
+// The body may be just the head of a body of body_size bytes.
+void CaptureBody(std::string_view body, size_t body_size, Message* result) {
+  const auto content_type_iter = result->headers.find(kContentType);
+  std::string_view content_type = content_type_iter != result->headers.end()
+                                     ? std::string_view(content_type_iter->second)
+                                     : std::string_view();
+
+  size_t capture_size = 0;
+  if (BodyCapturePolicy::Get().ShouldCapture(content_type)) {
+    capture_size = std::min(body.size(), BodyCaptureLimit(*result));
+  }
+  result->body = body.substr(0, capture_size);
+  result->body_bytes_skipped = body_size - capture_size;
+}
+
 // TODO(oazizi): ParseChunk makes a copy of the data. Consider finding a way
 //               to mutate the input buffer such that we can avoid this copy.
 //               phr_decode_chunked() already mutates the input buffer, but
 //               this needs to be done in a way that doesn't mess up the rest of
 //               the parsing, since there will be "unused" bytes at the end of the
 //               chunk, but before the rest of the data in the DataStreamBuffer.
-//               Note that the copy is not overhead when a complete message is found,
-//               since the data is std::moved to the result.
-ParseState ParseChunk(std::string_view* data, Message* result) {
-  phr_chunked_decoder chunk_decoder = {};
-  std::string data_copy(*data);
+//               Only the head of the decoded body that the body capture policy keeps
+//               is copied to the result.
+//
+// Only the bytes of data that were not fed to the decoder by a previous call with the same
+// partial message are decoded, so a large body that arrives over many calls is decoded once.
+ParseState ParseChunk(std::string_view* data, Message* result, PartialMessage* partial) {
+  std::string data_copy(data->substr(partial->chunked_bytes_consumed));
   char* buf = data_copy.data();
   size_t buf_size = data_copy.size();
-  ssize_t retval = phr_decode_chunked(&chunk_decoder, buf, &buf_size);
+  ssize_t retval = phr_decode_chunked(&partial->chunk_decoder, buf, &buf_size);
   if (retval == -1) {
     // Parse failed.
     return ParseState::kInvalid;
   } else if (retval >= 0) {
     // Complete message.
     data_copy.resize(buf_size);
-    result->body = std::move(data_copy);
+    partial->decoded_body_size += buf_size;
+    if (partial->decoded_body.empty()) {
+      CaptureBody(data_copy, partial->decoded_body_size, result);
+    } else {
+      partial->decoded_body.append(data_copy);
+      CaptureBody(partial->decoded_body, partial->decoded_body_size, result);
+    }
     // phr_decode_chunked rewrites the buffer in place, removing chunked-encoding headers.
     // So we cannot simply remove the prefix, but rather have to shorten the buffer too.
     // This is done via retval, which specifies how many unprocessed bytes are left.
@@ -82,7 +118,13 @@ ParseState ParseChunk(std::string_view* data, Message* result) {
     }
     return ParseState::kSuccess;
   } else if (retval == -2) {
-    // Incomplete message.
+    // Incomplete message. The decoder has consumed all of the data.
+    size_t limit = BodyCaptureLimit(*result);
+    if (partial->decoded_body.size() < limit) {
+      partial->decoded_body.append(buf, std::min(buf_size, limit - partial->decoded_body.size()));
+    }
+    partial->decoded_body_size += buf_size;
+    partial->chunked_bytes_consumed = data->size();
     return ParseState::kNeedsMoreData;
   }
   LOG(DFATAL) << "Unexpected retval from phr_decode_chunked()";
@@ -91,7 +133,7 @@ ParseState ParseChunk(std::string_view* data, Message* result) {
 
 }  // namespace
 
-ParseState ParseBody(std::string_view* buf, Message* result) {
+ParseState ParseBody(std::string_view* buf, Message* result, PartialMessage* partial) {
   // Try to find boundary of message by looking at Content-Length and Transfer-Encoding.
 
   // From https://tools.ietf.org/html/rfc7230:
@@ -121,7 +163,7 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
       return ParseState::kNeedsMoreData;
     }
 
-    result->body = buf->substr(0, len);
+    CaptureBody(buf->substr(0, len), len, result);
     buf->remove_prefix(std::min(len, buf->size()));
     return ParseState::kSuccess;
   }
@@ -130,7 +172,7 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
   const auto transfer_encoding_iter = result->headers.find(kTransferEncoding);
   if (transfer_encoding_iter != result->headers.end() &&
       transfer_encoding_iter->second == "chunked") {
-    return ParseChunk(buf, result);
+    return ParseChunk(buf, result, partial);
   }
 
   // Case 3: Message has content, but no Content-Length or Transfer-Encoding.
@@ -188,7 +230,7 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
     // Only the body that is present at the time is emitted, since we don't
     // know if the data is actually complete or not without a length.
 
-    result->body = *buf;
+    CaptureBody(*buf, buf->size(), result);
     buf->remove_prefix(buf->size());
     LOG_FIRST_N(WARNING, 10)
         << "HTTP message with no Content-Length or Transfer-Encoding may produce "
@@ -200,7 +242,12 @@ ParseState ParseBody(std::string_view* buf, Message* result) {
   return ParseState::kInvalid;
 }
 
-ParseState ParseRequest(std::string_view* buf, Message* result) {
+ParseState ParseBody(std::string_view* buf, Message* result) {
+  PartialMessage partial;
+  return ParseBody(buf, result, &partial);
+}
+
+ParseState ParseRequestHeaders(std::string_view* buf, Message* result) {
   // Fields populated by phr_parse_response.
   const char* method = nullptr;
   size_t method_len;
@@ -222,12 +269,12 @@ ParseState ParseRequest(std::string_view* buf, Message* result) {
 
     result->type = MessageType::kRequest;
     result->minor_version = minor_version;
-    result->headers = GetHTTPHeadersMap(headers, num_headers);
+    SetHTTPHeaders(headers, num_headers, &result->headers);
     result->req_method = std::string(method, method_len);
     result->req_path = std::string(path, path_len);
     result->headers_byte_size = retval;
 
-    return ParseBody(buf, result);
+    return ParseState::kSuccess;
   }
   if (retval == -2) {
     return ParseState::kNeedsMoreData;
@@ -235,7 +282,7 @@ ParseState ParseRequest(std::string_view* buf, Message* result) {
   return ParseState::kInvalid;
 }
 
-ParseState ParseResponse(std::string_view* buf, Message* result) {
+ParseState ParseResponseHeaders(std::string_view* buf, Message* result) {
   // Fields populated by phr_parse_response.
   const char* msg = nullptr;
   size_t msg_len = 0;
@@ -254,12 +301,12 @@ ParseState ParseResponse(std::string_view* buf, Message* result) {
 
     result->type = MessageType::kResponse;
     result->minor_version = minor_version;
-    result->headers = GetHTTPHeadersMap(headers, num_headers);
+    SetHTTPHeaders(headers, num_headers, &result->headers);
     result->resp_status = status;
     result->resp_message = std::string(msg, msg_len);
     result->headers_byte_size = retval;
 
-    return ParseBody(buf, result);
+    return ParseState::kSuccess;
   }
   if (retval == -2) {
     return ParseState::kNeedsMoreData;
@@ -267,6 +314,17 @@ ParseState ParseResponse(std::string_view* buf, Message* result) {
   return ParseState::kInvalid;
 }
 
+ParseState ParseHeaders(MessageType type, std::string_view* buf, Message* result) {
+  switch (type) {
+    case MessageType::kRequest:
+      return ParseRequestHeaders(buf, result);
+    case MessageType::kResponse:
+      return ParseResponseHeaders(buf, result);
+    default:
+      return ParseState::kInvalid;
+  }
+}
+
 }  // namespace pico_wrapper
 
 /**
@@ -280,14 +338,52 @@ ParseState ParseResponse(std::string_view* buf, Message* result) {
  * @return parse state indicating how the parse progressed.
  */
 ParseState ParseFrame(MessageType type, std::string_view* buf, Message* result) {
-  switch (type) {
-    case MessageType::kRequest:
-      return pico_wrapper::ParseRequest(buf, result);
-    case MessageType::kResponse:
-      return pico_wrapper::ParseResponse(buf, result);
-    default:
-      return ParseState::kInvalid;
+  ParseState s = pico_wrapper::ParseHeaders(type, buf, result);
+  if (s != ParseState::kSuccess) {
+    return s;
   }
+  return pico_wrapper::ParseBody(buf, result);
+}
+
+ParseState ParseFrame(MessageType type, size_t pos, std::string_view* buf, Message* result,
+                      StreamParseState* state) {
+  if (state == nullptr) {
+    return ParseFrame(type, buf, result);
+  }
+
+  // Resume the message that the previous call stopped in the body of.
+  if (state->partial != nullptr && state->pos == pos) {
+    PartialMessage* partial = state->partial.get();
+    std::string_view body = buf->substr(partial->message.headers_byte_size);
+    ParseState s = pico_wrapper::ParseBody(&body, &partial->message, partial);
+    if (s == ParseState::kNeedsMoreData) {
+      return s;
+    }
+    *buf = body;
+    *result = std::move(partial->message);
+    state->partial.reset();
+    return s;
+  }
+
+  // The stream moved past the partial message, e.g. because of a gap in the data.
+  state->partial.reset();
+
+  std::string_view head = *buf;
+  ParseState s = pico_wrapper::ParseHeaders(type, &head, result);
+  if (s != ParseState::kSuccess) {
+    return s;
+  }
+  PartialMessage partial;
+  s = pico_wrapper::ParseBody(&head, result, &partial);
+  if (s == ParseState::kNeedsMoreData) {
+    // Only messages with incomplete bodies are kept, so that small messages don't pay for it.
+    partial.message = std::move(*result);
+    state->partial = std::make_unique<PartialMessage>(std::move(partial));
+    state->pos = pos;
+    return s;
+  }
+  *buf = head;
+  return s;
 }
 
 // TODO(oazizi/yzhao): This function should use is_http_{response,request} inside
@@ -374,6 +470,30 @@ ParseState ParseFrame(MessageType type, std::string_view* buf, http::Message* re
   return http::ParseFrame(type, buf, result);
 }
 
+template <>
+http::Message MakeFrame<http::Message>(http::StreamParseState* state) {
+  if (state == nullptr) {
+    return http::Message();
+  }
+  if (state->frame_memory == nullptr) {
+    // Headers larger than the largest block are allocated from, and freed to, the heap directly,
+    // so that a few large headers don't grow the pool for the lifetime of the stream.
+    constexpr std::pmr::pool_options kFrameMemoryOptions = {.max_blocks_per_chunk = 64,
+                                                            .largest_required_pool_block = 1024};
+    state->frame_memory =
+        std::make_unique<std::pmr::unsynchronized_pool_resource>(kFrameMemoryOptions);
+  }
+  return http::Message(state->frame_memory.get());
+}
+
+template <>
+void ReleaseFrameMemory<http::StreamParseState>(http::StreamParseState* state) {
+  // A partial message has its headers in the frame memory.
+  if (state->partial == nullptr) {
+    state->frame_memory.reset();
+  }
+}
+
 template <>
 size_t FindFrameBoundary<http::Message>(MessageType type, std::string_view buf, size_t start_pos) {
   return http::FindFrameBoundary(type, buf, start_pos);
@@ -28,12 +28,35 @@ namespace px {
 namespace stirling {
 namespace protocols {
 
+namespace http {
+
+/**
+ * Parses a single HTTP message from the input string, keeping the message in state if its body is
+ * incomplete. The next call at the same position resumes the body instead of parsing the message
+ * from its start again.
+ *
+ * @param pos The position of buf in the data stream.
+ */
+ParseState ParseFrame(MessageType type, size_t pos, std::string_view* buf, Message* frame,
+                      StreamParseState* state);
+
+}  // namespace http
+
 /**
  * Parses a single HTTP message from the input string.
  */
 template <>
 ParseState ParseFrame(MessageType type, std::string_view* buf, http::Message* frame);
 
+/**
+ * Returns a new HTTP message, whose headers are allocated from the frame memory of state.
+ */
+template <>
+http::Message MakeFrame<http::Message>(http::StreamParseState* state);
+
+template <>
+void ReleaseFrameMemory<http::StreamParseState>(http::StreamParseState* state);
+
 template <>
 size_t FindFrameBoundary<http::Message>(MessageType type, std::string_view buf, size_t start_pos);
 
@@ -390,6 +390,27 @@ TEST_F(HTTPParserTest, ParseCompleteHTTPResponseWithContentLengthHeader) {
   EXPECT_THAT(parsed_messages, ElementsAre(expected_message1, expected_message2));
 }
 
+TEST_F(HTTPParserTest, CapturesHeadOfLargeBodies) {
+  const std::string body(2 * kMaxBodyBytes, 'x');
+  const std::string sized_msg = HTTPRespWithSizedBody(body);
+  const std::string chunked_msg = absl::StrCat(
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n",
+      absl::StrFormat("%x\r\n", body.size()), body, "\r\n", "0\r\n\r\n");
+  const std::string buf = absl::StrCat(sized_msg, chunked_msg);
+
+  std::deque<Message> parsed_messages;
+  ParseResult result = ParseFramesLoop(MessageType::kResponse, buf, &parsed_messages);
+
+  EXPECT_EQ(ParseState::kSuccess, result.state);
+  ASSERT_EQ(parsed_messages.size(), 2U);
+  for (const Message& message : parsed_messages) {
+    EXPECT_EQ(message.body, body.substr(0, kMaxBodyBytes));
+    EXPECT_EQ(message.body_bytes_skipped, body.size() - kMaxBodyBytes);
+  }
+}
+
 TEST_F(HTTPParserTest, ParseIncompleteHTTPResponseWithContentLengthHeader) {
   const std::string_view msg1 =
       "HTTP/1.1 200 OK\r\n"
@@ -468,6 +489,66 @@ TEST_F(HTTPParserTest, ParseIncompleteChunks) {
   EXPECT_THAT(parsed_messages, IsEmpty());
 }
 
+TEST_F(HTTPParserTest, ResumeIncompleteChunks) {
+  std::string msg =
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n"
+      "9\r\n"
+      "pixielabs\r\n"
+      "C\r\n"
+      " is awesome!\r\n"
+      "0\r\n";
+  Message expected_message = EmptyChunkedHTTPResp();
+  expected_message.body = "pixielabs is awesome!";
+
+  // Feed the message a few bytes at a time, as if it arrived in many events.
+  StreamParseState state;
+  std::deque<Message> parsed_messages;
+  ParseResult result;
+  for (size_t size = 60; size < msg.size(); size += 7) {
+    result = ParseFramesLoop(MessageType::kResponse, std::string_view(msg).substr(0, size),
+                             &parsed_messages, &state);
+    ASSERT_EQ(ParseState::kNeedsMoreData, result.state);
+    ASSERT_THAT(parsed_messages, IsEmpty());
+    ASSERT_NE(state.partial, nullptr);
+  }
+  result = ParseFramesLoop(MessageType::kResponse, msg, &parsed_messages, &state);
+
+  EXPECT_EQ(ParseState::kSuccess, result.state);
+  EXPECT_EQ(msg.size(), result.end_position);
+  EXPECT_THAT(parsed_messages, ElementsAre(expected_message));
+  EXPECT_EQ(state.partial, nullptr);
+}
+
+TEST_F(HTTPParserTest, AllocatesHeadersFromStreamMemory) {
+  StreamParseState state;
+  std::deque<Message> parsed_messages;
+  ParseResult result = ParseFramesLoop(MessageType::kRequest, kHTTPGetReq0, &parsed_messages,
+                                       &state);
+
+  EXPECT_EQ(ParseState::kSuccess, result.state);
+  ASSERT_EQ(parsed_messages.size(), 1);
+  ASSERT_NE(state.frame_memory, nullptr);
+  EXPECT_EQ(parsed_messages[0].headers.get_allocator().resource(), state.frame_memory.get());
+  EXPECT_THAT(parsed_messages[0].headers, Contains(Key("Host")));
+}
+
+TEST_F(HTTPParserTest, ReleasesStreamMemoryWithoutPartialMessage) {
+  StreamParseState state;
+  MakeFrame<Message>(&state);
+  ASSERT_NE(state.frame_memory, nullptr);
+
+  // A partial message still uses the memory.
+  state.partial = std::make_unique<PartialMessage>();
+  ReleaseFrameMemory(&state);
+  EXPECT_NE(state.frame_memory, nullptr);
+
+  state.partial.reset();
+  ReleaseFrameMemory(&state);
+  EXPECT_EQ(state.frame_memory, nullptr);
+}
+
 // Note that many other tests already use requests with no content-length,
 // but keeping this explicitly here in case the other tests change.
 TEST_F(HTTPParserTest, ParseRequestWithoutLengthOrChunking) {
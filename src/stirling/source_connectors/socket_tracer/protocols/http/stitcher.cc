@@ -66,9 +66,11 @@ void PreProcessMessage(Message* message) {
 
   auto content_encoding_iter = message->headers.find(kContentEncoding);
   // Replace body with decompressed version, if required.
+  // Only the head of the body that fits in the table is inflated. This also recovers the head of
+  // bodies whose capture was truncated, which a full inflate would reject.
   if (content_encoding_iter != message->headers.end() && content_encoding_iter->second == "gzip") {
     std::string_view body_strview(message->body);
-    auto bodyOrErr = px::zlib::Inflate(body_strview);
+    auto bodyOrErr = px::zlib::InflatePrefix(body_strview, kMaxBodyBytes);
     if (!bodyOrErr.ok()) {
       LOG(WARNING) << "Unable to gunzip HTTP body.";
       message->body = "<Failed to gunzip body>";
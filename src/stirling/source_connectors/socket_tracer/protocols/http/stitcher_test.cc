@@ -19,6 +19,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "src/common/testing/testing.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
 namespace px {
@@ -44,6 +46,20 @@ TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressed) {
   EXPECT_EQ("This is a test\n", message.body);
 }
 
+TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressedUpToMaxBodyBytes) {
+  const std::string body(4 * kMaxBodyBytes, 'x');
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(body));
+
+  Message message;
+  message.type = MessageType::kResponse;
+  message.headers.insert({kContentEncoding, "gzip"});
+  message.headers.insert({kContentType, "json"});
+  // Only the head of the compressed body was captured.
+  message.body = compressed.substr(0, compressed.size() - 8);
+  PreProcessMessage(&message);
+  EXPECT_EQ(body.substr(0, kMaxBodyBytes), message.body);
+}
+
 TEST(PreProcessRecordTest, ContentHeaderIsNotAdded) {
   Message message;
   message.type = MessageType::kResponse;
@@ -18,7 +18,12 @@
 
 #pragma once
 
+#include <picohttpparser.h>
+
 #include <chrono>
+#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
 
 #include "src/common/base/utils.h"
@@ -38,7 +43,9 @@ using ::px::operator<<;
 
 // HTTP1.x headers can have multiple values for the same name, and field names are case-insensitive:
 // https://www.w3.org/Protocols/rfc2616/rfc2616-sec4.html#sec4.2
-using HeadersMap = std::multimap<std::string, std::string, CaseInsensitiveLess>;
+// The headers of parsed messages are allocated from the memory of their data stream,
+// see StreamParseState.
+using HeadersMap = std::pmr::multimap<std::pmr::string, std::pmr::string, CaseInsensitiveLess>;
 
 inline constexpr char kContentEncoding[] = "Content-Encoding";
 inline constexpr char kContentLength[] = "Content-Length";
@@ -47,6 +54,10 @@ inline constexpr char kTransferEncoding[] = "Transfer-Encoding";
 inline constexpr char kUpgrade[] = "Upgrade";
 
 struct Message : public FrameBase {
+  Message() = default;
+  // Allocates the headers from mr.
+  explicit Message(std::pmr::memory_resource* mr) : headers(mr) {}
+
   MessageType type = MessageType::kUnknown;
 
   int minor_version = -1;
@@ -59,6 +70,11 @@ struct Message : public FrameBase {
   std::string resp_message = "-";
 
   std::string body = "-";
+  // The number of body bytes that were not kept in body, because of the body capture policy.
+  size_t body_bytes_skipped = 0;
+  // Set when part of the body was never received, because it was left out of the BPF events.
+  // body then only holds what was received, and body_bytes_skipped includes the rest.
+  bool body_truncated = false;
 
   // The number of bytes in the HTTP header, used in ByteSize(),
   // as an approximation of the size of the non-body fields.
@@ -78,6 +94,38 @@ struct Message : public FrameBase {
   }
 };
 
+//-----------------------------------------------------------------------------
+// Parse State
+//-----------------------------------------------------------------------------
+
+// A message whose headers have been parsed, but whose body is not complete yet.
+struct PartialMessage {
+  Message message;
+
+  // For chunked bodies: the state of the chunk decoder, the number of encoded body bytes that
+  // were fed to it, and the size of the body decoded so far. Only the head of the decoded body
+  // that the body capture policy keeps is saved.
+  phr_chunked_decoder chunk_decoder = {};
+  size_t chunked_bytes_consumed = 0;
+  size_t decoded_body_size = 0;
+  std::string decoded_body;
+};
+
+// The parse state of an HTTP data stream. When a message body spans several calls to
+// ParseFrames(), it lets the parse resume where the previous call stopped, instead of parsing
+// the headers and decoding the body from the start of the message again.
+struct StreamParseState {
+  // The memory that the headers of the messages parsed from the stream are allocated from.
+  // Messages waiting to be stitched stay in the stream across iterations, so the memory is pooled
+  // and reused, rather than released after every iteration. It must outlive the messages, and is
+  // released once the stream is idle (see ReleaseFrameMemory()).
+  std::unique_ptr<std::pmr::unsynchronized_pool_resource> frame_memory;
+  // The position of the partial message in the data stream.
+  size_t pos = 0;
+  // Null unless the previous parse stopped in the body of the message at pos.
+  std::unique_ptr<PartialMessage> partial;
+};
+
 //-----------------------------------------------------------------------------
 // Table Store Entry Level Structs
 //-----------------------------------------------------------------------------
@@ -106,6 +154,12 @@ struct ProtocolTraits {
 };
 
 }  // namespace http
+
+template <>
+struct FrameParseStateTraits<http::Message> {
+  using type = http::StreamParseState;
+};
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
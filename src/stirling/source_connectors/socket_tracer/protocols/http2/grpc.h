@@ -18,28 +18,16 @@
 
 #pragma once
 
-#include <google/protobuf/message.h>
-
-#include <optional>
-#include <string>
-#include <string_view>
+#include "src/common/grpcutils/pb_text.h"
 
 namespace px {
 namespace stirling {
 namespace grpc {
 
-constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
-
-/**
- * Parses the input str as the provided protobuf message type.
- * Essentially a wrapper around PBWireToText that is easier to use.
- *
- * @param str The raw message as a string.
- * @param str_truncation_len The string length of any string/bytes fields beyond which truncation
- *        applies, if specified.
- * @return The parsed message.
- */
-std::string ParsePB(std::string_view str, std::optional<int> str_truncation_len = std::nullopt);
+// The gRPC payload parsing is shared with the query engine, which converts the raw bodies that
+// are captured here into text format at query time.
+using ::px::grpc::kGRPCMessageHeaderSizeInBytes;
+using ::px::grpc::ParsePB;
 
 }  // namespace grpc
 }  // namespace stirling
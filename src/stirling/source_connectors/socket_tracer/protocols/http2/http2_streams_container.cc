@@ -19,6 +19,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
 
 #include <algorithm>
+#include <vector>
 
 DEFINE_uint32(stirling_http2_stream_id_gap_threshold, 100,
               "If a stream ID jumps by this many spots or more, an error is assumed and the entire "
@@ -31,6 +32,7 @@ namespace {
 
 void EraseExpiredStreams(std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp,
                          absl::flat_hash_map<uint32_t, protocols::http2::Stream>* streams) {
+  // The streams are not ordered by activity, so all of them are checked.
   auto iter = streams->begin();
   while (iter != streams->end()) {
     const auto& stream = iter->second;
@@ -39,11 +41,36 @@ void EraseExpiredStreams(std::chrono::time_point<std::chrono::steady_clock> expi
         std::chrono::time_point<std::chrono::steady_clock>(std::chrono::nanoseconds(timestamp_ns));
 
     if (expiry_timestamp < last_activity) {
+      ++iter;
+    } else {
+      streams->erase(iter++);
+    }
+  }
+}
+
+size_t EraseOldestStreams(size_t size_limit_bytes, size_t size,
+                          absl::flat_hash_map<uint32_t, protocols::http2::Stream>* streams) {
+  // Stream IDs increase monotonically on a connection, so the lowest IDs are the oldest streams.
+  std::vector<uint32_t> stream_ids;
+  stream_ids.reserve(streams->size());
+  for (const auto& [id, stream] : *streams) {
+    stream_ids.push_back(id);
+  }
+  std::sort(stream_ids.begin(), stream_ids.end());
+
+  size_t num_erased = 0;
+  for (uint32_t id : stream_ids) {
+    if (size <= size_limit_bytes) {
       break;
     }
-    streams->erase(iter++);
+    auto iter = streams->find(id);
+    size -= iter->second.ByteSize();
+    streams->erase(iter);
+    ++num_erased;
   }
+  return num_erased;
 }
+
 }  // namespace
 
 size_t HTTP2StreamsContainer::StreamsSize() {
@@ -54,16 +81,18 @@ size_t HTTP2StreamsContainer::StreamsSize() {
   return size;
 }
 
-void HTTP2StreamsContainer::Cleanup(
+size_t HTTP2StreamsContainer::Cleanup(
     size_t size_limit_bytes, std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp) {
+  EraseExpiredStreams(expiry_timestamp, &streams_);
+
   size_t size = StreamsSize();
-  if (size > size_limit_bytes) {
-    VLOG(1) << absl::Substitute("HTTP2 streams cleared due to size limit ($0 > $1).", size,
-                                size_limit_bytes);
-    streams_.clear();
+  if (size <= size_limit_bytes) {
+    return 0;
   }
-
-  EraseExpiredStreams(expiry_timestamp, &streams_);
+  size_t num_evicted = EraseOldestStreams(size_limit_bytes, size, &streams_);
+  VLOG(1) << absl::Substitute("$0 HTTP2 streams evicted due to size limit ($1 > $2).", num_evicted,
+                              size, size_limit_bytes);
+  return num_evicted;
 }
 
 protocols::http2::HalfStream* HTTP2StreamsContainer::HalfStreamPtr(uint32_t stream_id,
@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <deque>
 #include <string>
 
 #include <absl/container/flat_hash_map.h>
@@ -54,16 +53,14 @@ class HTTP2StreamsContainer : NotCopyMoveable {
   size_t StreamsSize();
 
   /**
-   * Cleans up the HTTP2 events from BPF uprobes that are too old,
-   * either because they are too far back in time, or too far back in bytes.
+   * Cleans up the HTTP2 events from BPF uprobes that are too old, i.e. the streams without
+   * activity since expiry_timestamp. Then, while the streams exceed size_limit_bytes, evicts the
+   * oldest streams (lowest stream IDs) first, so the newer streams are kept intact.
+   *
+   * @return The number of streams evicted because of the size limit.
    */
-  void Cleanup(size_t size_limit_bytes,
-               std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp);
-
-  /**
-   * Erase n stream IDs from the head of the streams container.
-   */
-  void EraseHead(size_t n);
+  size_t Cleanup(size_t size_limit_bytes,
+                 std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp);
 
   std::string DebugString(std::string_view prefix) const;
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/nv_map.h"
+
+#include <algorithm>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+
+DEFINE_string(stirling_http2_header_allowlist, "",
+              "Comma-separated names of the HTTP2 headers and trailers to record. Pseudo-headers, "
+              "content-type, grpc-status and grpc-message are always recorded. If empty, all "
+              "headers are recorded.");
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+namespace {
+
+// Names that are common enough to not be worth copying for every stream.
+// The first entries are the headers read by the tracer, which KeepHeader() always keeps.
+constexpr std::string_view kInternedNames[] = {
+    "content-type",    "grpc-status", "grpc-message",   ":authority",           ":method",
+    ":path",           ":scheme",     ":status",        "accept",               "accept-encoding",
+    "content-length",  "te",          "grpc-encoding",  "grpc-accept-encoding", "grpc-timeout",
+    "user-agent",
+};
+constexpr size_t kNumAlwaysKeptNames = 3;
+
+std::string_view InternedName(std::string_view name) {
+  for (std::string_view interned : kInternedNames) {
+    if (interned == name) {
+      return interned;
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+bool KeepHeader(std::string_view name) {
+  static const absl::flat_hash_set<std::string> kAllowlist = [] {
+    absl::flat_hash_set<std::string> allowlist;
+    for (std::string_view allowed :
+         absl::StrSplit(FLAGS_stirling_http2_header_allowlist, ',', absl::SkipWhitespace())) {
+      allowlist.insert(absl::AsciiStrToLower(absl::StripAsciiWhitespace(allowed)));
+    }
+    return allowlist;
+  }();
+
+  if (kAllowlist.empty() || absl::StartsWith(name, ":")) {
+    return true;
+  }
+  for (size_t i = 0; i < kNumAlwaysKeptNames; ++i) {
+    if (kInternedNames[i] == name) {
+      return true;
+    }
+  }
+  return kAllowlist.contains(name);
+}
+
+std::string_view NVMap::Name(const Entry& entry) const {
+  if (entry.interned_name.data() != nullptr) {
+    return entry.interned_name;
+  }
+  return std::string_view(arena_).substr(entry.name_pos, entry.name_size);
+}
+
+std::string_view NVMap::Value(const Entry& entry) const {
+  return std::string_view(arena_).substr(entry.value_pos, entry.value_size);
+}
+
+void NVMap::Add(std::string_view name, std::string_view value) {
+  Entry entry;
+  entry.interned_name = InternedName(name);
+  if (entry.interned_name.data() == nullptr) {
+    entry.name_pos = arena_.size();
+    entry.name_size = name.size();
+    arena_.append(name);
+  }
+  entry.value_pos = arena_.size();
+  entry.value_size = value.size();
+  arena_.append(value);
+
+  // Headers mostly arrive in no particular order, but there are only a handful per stream,
+  // so keeping the entries sorted is cheap. Equal names keep their insertion order.
+  auto iter = std::upper_bound(
+      entries_.begin(), entries_.end(), name,
+      [this](std::string_view key, const Entry& e) { return key < Name(e); });
+  entries_.insert(iter, entry);
+}
+
+std::string NVMap::ValueByKey(std::string_view key, std::string_view default_value) const {
+  auto iter = std::lower_bound(
+      entries_.begin(), entries_.end(), key,
+      [this](const Entry& entry, std::string_view k) { return Name(entry) < k; });
+  if (iter != entries_.end() && Name(*iter) == key) {
+    return std::string(Value(*iter));
+  }
+  return std::string(default_value);
+}
+
+size_t NVMap::ByteSize() const {
+  size_t byte_size = 0;
+  for (const Entry& entry : entries_) {
+    byte_size += Name(entry).size();
+    byte_size += entry.value_size;
+  }
+  return byte_size;
+}
+
+std::string NVMap::ToString() const { return absl::StrJoin(*this, ", ", absl::PairFormatter(":")); }
+
+bool NVMap::operator==(const NVMap& other) const {
+  return std::equal(begin(), end(), other.begin(), other.end());
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+DECLARE_string(stirling_http2_header_allowlist);
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+/**
+ * Returns true if the HTTP2 header with the given name should be kept, as set by
+ * --stirling_http2_header_allowlist. Pseudo-headers and the headers read by the tracer itself
+ * are always kept.
+ */
+bool KeepHeader(std::string_view name);
+
+/**
+ * NVMap holds the name-value pairs of HTTP2 headers or trailers, ordered by name like a
+ * std::multimap, with pairs of equal names kept in insertion order.
+ *
+ * The names and values are copied into a single arena string, instead of allocating a string
+ * per name and value. Well-known names are interned, and not copied at all.
+ *
+ * Note that names (HTTP2 header field names) are assumed to be lowercase to match spec:
+ *
+ * From https://http2.github.io/http2-spec/#HttpHeaders:
+ * ... header field names MUST be converted to lowercase prior to their encoding in HTTP/2.
+ * A request or response containing uppercase header field names MUST be treated as malformed.
+ */
+class NVMap {
+ public:
+  using value_type = std::pair<std::string_view, std::string_view>;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = NVMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = value_type;
+
+    const_iterator(const NVMap* map, size_t i) : map_(map), i_(i) {}
+
+    value_type operator*() const { return map_->Get(i_); }
+    const_iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+    const_iterator operator++(int) { return const_iterator(map_, i_++); }
+    bool operator==(const const_iterator& other) const { return i_ == other.i_; }
+    bool operator!=(const const_iterator& other) const { return i_ != other.i_; }
+
+   private:
+    const NVMap* map_;
+    size_t i_;
+  };
+  using iterator = const_iterator;
+
+  /**
+   * Adds a name-value pair. Both are copied.
+   */
+  void Add(std::string_view name, std::string_view value);
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, entries_.size()); }
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  /**
+   * Returns the value of the first pair with the given name, or default_value if there is none.
+   */
+  std::string ValueByKey(std::string_view key, std::string_view default_value = "") const;
+
+  size_t ByteSize() const;
+
+  std::string ToString() const;
+
+  bool operator==(const NVMap& other) const;
+  bool operator!=(const NVMap& other) const { return !(*this == other); }
+
+ private:
+  struct Entry {
+    // Set for interned names, which point to static storage instead of the arena.
+    std::string_view interned_name;
+    uint32_t name_pos = 0;
+    uint32_t name_size = 0;
+    uint32_t value_pos = 0;
+    uint32_t value_size = 0;
+  };
+
+  std::string_view Name(const Entry& entry) const;
+  std::string_view Value(const Entry& entry) const;
+  value_type Get(size_t i) const { return {Name(entries_[i]), Value(entries_[i])}; }
+
+  // Entries sorted by name. They hold offsets rather than pointers into arena_, so they stay
+  // valid as arena_ grows, and when the NVMap is copied or moved.
+  std::vector<Entry> entries_;
+  std::string arena_;
+};
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
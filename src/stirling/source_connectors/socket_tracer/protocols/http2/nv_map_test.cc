@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/nv_map.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http2 {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+TEST(NVMapTest, AddAndLookup) {
+  NVMap nv_map;
+  EXPECT_THAT(nv_map, IsEmpty());
+  EXPECT_EQ(nv_map.ValueByKey(":path", "none"), "none");
+
+  nv_map.Add(":path", "/magic");
+  nv_map.Add("x-custom", "1");
+  nv_map.Add(":method", "post");
+  nv_map.Add("x-custom", "2");
+
+  // Ordered by name, with equal names in insertion order.
+  EXPECT_THAT(nv_map, ElementsAre(Pair(":method", "post"), Pair(":path", "/magic"),
+                                  Pair("x-custom", "1"), Pair("x-custom", "2")));
+  EXPECT_EQ(nv_map.ValueByKey(":path"), "/magic");
+  EXPECT_EQ(nv_map.ValueByKey("x-custom"), "1");
+  EXPECT_EQ(nv_map.ValueByKey("x-other"), "");
+  EXPECT_EQ(nv_map.ByteSize(), 40);
+  EXPECT_EQ(nv_map.ToString(), ":method:post, :path:/magic, x-custom:1, x-custom:2");
+}
+
+TEST(NVMapTest, CopyAndCompare) {
+  NVMap nv_map;
+  nv_map.Add("content-type", "application/grpc");
+  nv_map.Add("x-custom", std::string(100, 'a'));
+
+  NVMap copy = nv_map;
+  EXPECT_EQ(copy, nv_map);
+  EXPECT_EQ(copy.ValueByKey("x-custom"), std::string(100, 'a'));
+
+  copy.Add(":status", "200");
+  EXPECT_NE(copy, nv_map);
+}
+
+TEST(NVMapTest, KeepAllHeadersByDefault) {
+  EXPECT_TRUE(KeepHeader(":path"));
+  EXPECT_TRUE(KeepHeader("content-type"));
+  EXPECT_TRUE(KeepHeader("x-custom"));
+}
+
+}  // namespace http2
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -20,14 +20,15 @@
 
 #include <algorithm>
 #include <chrono>
-#include <map>
 #include <string>
 #include <utility>
 
-#include <absl/strings/str_join.h>
+#include <absl/strings/match.h>
 
 #include "src/common/base/utils.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/body_capture.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http2/nv_map.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -45,33 +46,6 @@ constexpr char kContentTypeGRPC[] = "application/grpc";
 
 }  // namespace headers
 
-// Note that NVMap keys (HTTP2 header field names) are assumed to be lowercase to match spec:
-//
-// From https://http2.github.io/http2-spec/#HttpHeaders:
-// ... header field names MUST be converted to lowercase prior to their encoding in HTTP/2.
-// A request or response containing uppercase header field names MUST be treated as malformed.
-class NVMap : public std::multimap<std::string, std::string> {
- public:
-  std::string ValueByKey(const std::string& key, const std::string& default_value = "") const {
-    const auto iter = find(key);
-    if (iter != end()) {
-      return iter->second;
-    }
-    return default_value;
-  }
-
-  size_t ByteSize() const {
-    size_t byte_size = 0;
-    for (const auto& [name, value] : *this) {
-      byte_size += name.size();
-      byte_size += value.size();
-    }
-    return byte_size;
-  }
-
-  std::string ToString() const { return absl::StrJoin(*this, ", ", absl::PairFormatter(":")); }
-};
-
 // This struct represents the frames of interest transmitted on an HTTP2 stream.
 // It is called a HalfStream because it captures one direction only.
 // For example, the request is one HalfStream while the response is on another HalfStream,
@@ -97,23 +71,32 @@ struct HalfStream {
     }
   }
 
-  void AddHeader(std::string key, std::string val) {
+  // Headers and trailers that are not allowlisted are dropped, see KeepHeader().
+  void AddHeader(std::string_view key, std::string_view val) {
+    if (!KeepHeader(key)) {
+      return;
+    }
     byte_size_ += key.size() + val.size();
-    headers_.emplace(std::move(key), std::move(val));
+    headers_.Add(key, val);
   }
 
-  void AddTrailer(std::string key, std::string val) {
+  void AddTrailer(std::string_view key, std::string_view val) {
+    if (!KeepHeader(key)) {
+      return;
+    }
     byte_size_ += key.size() + val.size();
-    trailers_.emplace(std::move(key), std::move(val));
+    trailers_.Add(key, val);
   }
 
   void AddData(std::string_view val) {
     original_data_size_ += val.size();
 
+    // Only the head of the data that the body capture policy keeps is copied.
+    const size_t max_bytes = BodyCapturePolicy::Get().max_bytes();
     size_t size_to_add = val.size();
 
-    if (size_to_add + data_.size() > kMaxBodyBytes) {
-      size_to_add = kMaxBodyBytes - data_.size();
+    if (size_to_add + data_.size() > max_bytes) {
+      size_to_add = max_bytes - data_.size();
       data_truncated_ = true;
     }
 
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/parse.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/utils/binary_decoder.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+namespace {
+
+// Every message starts with its size, not including the size itself.
+constexpr size_t kMessageSizeBytes = 4;
+
+// request_api_key (2 bytes) + request_api_version (2 bytes) + correlation_id (4 bytes).
+constexpr int32_t kMinRequestPayloadSize = 8;
+// correlation_id (4 bytes).
+constexpr int32_t kMinResponsePayloadSize = 4;
+
+// The default of the broker's socket.request.max.bytes. Larger sizes come from a misaligned
+// stream, rather than from a real message.
+constexpr int32_t kMaxPayloadSize = 100 * 1024 * 1024;
+
+// Same bounds as the protocol inference in BPF.
+constexpr int16_t kMaxAPIKey = static_cast<int16_t>(APIKey::kBrokerRegistration);
+constexpr int16_t kMaxAPIVersion = 12;
+
+// The number of partitions summarized in the msg of a request. The summary of larger requests
+// is cut short, so that it stays small no matter how many partitions a request touches.
+constexpr int kMaxPartitions = 64;
+
+bool IsValidRequestHeader(int16_t api_key, int16_t api_version, int32_t correlation_id) {
+  return api_key >= 0 && api_key <= kMaxAPIKey && api_version >= 0 &&
+         api_version <= kMaxAPIVersion && correlation_id >= 0;
+}
+
+// Flexible versions use compact strings and arrays, and have tagged fields; see KIP-482.
+// Only the versions of the requests whose bodies are decoded are listed.
+bool IsFlexible(APIKey api_key, int16_t api_version) {
+  switch (api_key) {
+    case APIKey::kProduce:
+      return api_version >= 9;
+    case APIKey::kFetch:
+      return api_version >= 12;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Extracts the types of the Kafka protocol from the body of a message, in either their classic or
+ * their compact encoding. Strings are returned as views into the message; bytes are skipped.
+ */
+class PacketDecoder {
+ public:
+  PacketDecoder(std::string_view buf, bool flexible) : decoder_(buf), flexible_(flexible) {}
+
+  template <typename TIntType>
+  StatusOr<TIntType> ExtractInt() {
+    return decoder_.ExtractInt<TIntType>();
+  }
+
+  StatusOr<uint32_t> ExtractUnsignedVarint() { return decoder_.ExtractUVarint<uint32_t>(); }
+
+  // Returns the length of a string, array or bytes, which is -1 if they are null.
+  // Compact lengths are encoded as length + 1, so that 0 means null.
+  template <typename TLengthType>
+  StatusOr<int64_t> ExtractLength() {
+    if (flexible_) {
+      PL_ASSIGN_OR_RETURN(uint32_t len, ExtractUnsignedVarint());
+      return static_cast<int64_t>(len) - 1;
+    }
+    PL_ASSIGN_OR_RETURN(TLengthType len, ExtractInt<TLengthType>());
+    return len;
+  }
+
+  // [string] and [nullable string]. Null strings are returned as empty.
+  StatusOr<std::string_view> ExtractString() {
+    PL_ASSIGN_OR_RETURN(int64_t len, ExtractLength<int16_t>());
+    if (len < 0) {
+      return std::string_view();
+    }
+    return decoder_.ExtractString(len);
+  }
+
+  StatusOr<int64_t> ExtractArrayLength() { return ExtractLength<int32_t>(); }
+
+  // Steps over [bytes], [nullable bytes] and [records], and returns their size.
+  StatusOr<int64_t> SkipBytes() {
+    PL_ASSIGN_OR_RETURN(int64_t len, ExtractLength<int32_t>());
+    if (len < 0) {
+      return 0;
+    }
+    PL_RETURN_IF_ERROR(decoder_.ExtractString(len));
+    return len;
+  }
+
+  Status SkipTaggedFields() {
+    if (!flexible_) {
+      return Status::OK();
+    }
+    PL_ASSIGN_OR_RETURN(uint32_t num_fields, ExtractUnsignedVarint());
+    for (uint32_t i = 0; i < num_fields; ++i) {
+      PL_ASSIGN_OR_RETURN(uint32_t tag, ExtractUnsignedVarint());
+      PL_UNUSED(tag);
+      PL_ASSIGN_OR_RETURN(uint32_t size, ExtractUnsignedVarint());
+      PL_RETURN_IF_ERROR(decoder_.ExtractString(size));
+    }
+    return Status::OK();
+  }
+
+ private:
+  BinaryDecoder decoder_;
+  const bool flexible_;
+};
+
+struct PartitionSummary {
+  int32_t index;
+  // The size of the records of a produce request, or the fetch offset of a fetch request.
+  int64_t value;
+};
+
+struct TopicSummary {
+  std::string_view name;
+  std::vector<PartitionSummary> partitions;
+};
+
+// Writes the topics as {"<key>": ..., "topics":[{"name":...,"partitions":[{"index":...,
+// "<value_name>":...}]}]}, with the key-value pair only written if key is not empty.
+std::string SummaryToJSON(std::string_view key, int64_t value,
+                          const std::vector<TopicSummary>& topics, std::string_view value_name) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  if (!key.empty()) {
+    writer.Key(key.data(), key.size());
+    writer.Int64(value);
+  }
+  writer.Key("topics");
+  writer.StartArray();
+  for (const auto& topic : topics) {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(topic.name.data(), topic.name.size());
+    writer.Key("partitions");
+    writer.StartArray();
+    for (const auto& partition : topic.partitions) {
+      writer.StartObject();
+      writer.Key("index");
+      writer.Int(partition.index);
+      writer.Key(value_name.data(), value_name.size());
+      writer.Int64(partition.value);
+      writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return std::string(sb.GetString(), sb.GetSize());
+}
+
+// ProduceRequest => [transactional_id] acks timeout_ms [topic_data]
+//   topic_data => name [partition_data]
+//     partition_data => index records
+Status SummarizeProduceRequest(PacketDecoder* decoder, Packet* packet) {
+  if (packet->api_version >= 3) {
+    PL_ASSIGN_OR_RETURN(std::string_view transactional_id, decoder->ExtractString());
+    PL_UNUSED(transactional_id);
+  }
+  PL_ASSIGN_OR_RETURN(int16_t acks, decoder->ExtractInt<int16_t>());
+  PL_ASSIGN_OR_RETURN(int32_t timeout_ms, decoder->ExtractInt<int32_t>());
+  PL_UNUSED(timeout_ms);
+  packet->expects_response = acks != 0;
+
+  std::vector<TopicSummary> topics;
+  int num_partitions = 0;
+  PL_ASSIGN_OR_RETURN(int64_t num_topics, decoder->ExtractArrayLength());
+  for (int64_t i = 0; i < num_topics && num_partitions < kMaxPartitions; ++i) {
+    TopicSummary& topic = topics.emplace_back();
+    PL_ASSIGN_OR_RETURN(topic.name, decoder->ExtractString());
+    PL_ASSIGN_OR_RETURN(int64_t n, decoder->ExtractArrayLength());
+    for (int64_t j = 0; j < n && num_partitions < kMaxPartitions; ++j, ++num_partitions) {
+      PartitionSummary& partition = topic.partitions.emplace_back();
+      PL_ASSIGN_OR_RETURN(partition.index, decoder->ExtractInt<int32_t>());
+      PL_ASSIGN_OR_RETURN(partition.value, decoder->SkipBytes());
+      PL_RETURN_IF_ERROR(decoder->SkipTaggedFields());
+    }
+    PL_RETURN_IF_ERROR(decoder->SkipTaggedFields());
+  }
+
+  packet->msg = SummaryToJSON("acks", acks, topics, "records_size");
+  return Status::OK();
+}
+
+// FetchRequest => replica_id max_wait_ms min_bytes [max_bytes] [isolation_level] [session_id]
+//                 [session_epoch] [topics] ...
+//   topics => topic [partitions]
+//     partitions => partition [current_leader_epoch] fetch_offset [last_fetched_epoch]
+//                   [log_start_offset] partition_max_bytes
+// The fields that follow the topics are not decoded.
+Status SummarizeFetchRequest(PacketDecoder* decoder, Packet* packet) {
+  const int16_t version = packet->api_version;
+
+  PL_ASSIGN_OR_RETURN(int32_t replica_id, decoder->ExtractInt<int32_t>());
+  PL_ASSIGN_OR_RETURN(int32_t max_wait_ms, decoder->ExtractInt<int32_t>());
+  PL_ASSIGN_OR_RETURN(int32_t min_bytes, decoder->ExtractInt<int32_t>());
+  PL_UNUSED(replica_id);
+  PL_UNUSED(max_wait_ms);
+  PL_UNUSED(min_bytes);
+  if (version >= 3) {
+    PL_ASSIGN_OR_RETURN(int32_t max_bytes, decoder->ExtractInt<int32_t>());
+    PL_UNUSED(max_bytes);
+  }
+  if (version >= 4) {
+    PL_ASSIGN_OR_RETURN(int8_t isolation_level, decoder->ExtractInt<int8_t>());
+    PL_UNUSED(isolation_level);
+  }
+  if (version >= 7) {
+    PL_ASSIGN_OR_RETURN(int32_t session_id, decoder->ExtractInt<int32_t>());
+    PL_ASSIGN_OR_RETURN(int32_t session_epoch, decoder->ExtractInt<int32_t>());
+    PL_UNUSED(session_id);
+    PL_UNUSED(session_epoch);
+  }
+
+  std::vector<TopicSummary> topics;
+  int num_partitions = 0;
+  PL_ASSIGN_OR_RETURN(int64_t num_topics, decoder->ExtractArrayLength());
+  for (int64_t i = 0; i < num_topics && num_partitions < kMaxPartitions; ++i) {
+    TopicSummary& topic = topics.emplace_back();
+    PL_ASSIGN_OR_RETURN(topic.name, decoder->ExtractString());
+    PL_ASSIGN_OR_RETURN(int64_t n, decoder->ExtractArrayLength());
+    for (int64_t j = 0; j < n && num_partitions < kMaxPartitions; ++j, ++num_partitions) {
+      PartitionSummary& partition = topic.partitions.emplace_back();
+      PL_ASSIGN_OR_RETURN(partition.index, decoder->ExtractInt<int32_t>());
+      if (version >= 9) {
+        PL_ASSIGN_OR_RETURN(int32_t current_leader_epoch, decoder->ExtractInt<int32_t>());
+        PL_UNUSED(current_leader_epoch);
+      }
+      PL_ASSIGN_OR_RETURN(partition.value, decoder->ExtractInt<int64_t>());
+      if (version >= 12) {
+        PL_ASSIGN_OR_RETURN(int32_t last_fetched_epoch, decoder->ExtractInt<int32_t>());
+        PL_UNUSED(last_fetched_epoch);
+      }
+      if (version >= 5) {
+        PL_ASSIGN_OR_RETURN(int64_t log_start_offset, decoder->ExtractInt<int64_t>());
+        PL_UNUSED(log_start_offset);
+      }
+      PL_ASSIGN_OR_RETURN(int32_t partition_max_bytes, decoder->ExtractInt<int32_t>());
+      PL_UNUSED(partition_max_bytes);
+      PL_RETURN_IF_ERROR(decoder->SkipTaggedFields());
+    }
+    PL_RETURN_IF_ERROR(decoder->SkipTaggedFields());
+  }
+
+  packet->msg = SummaryToJSON("", 0, topics, "fetch_offset");
+  return Status::OK();
+}
+
+// Request Header => request_api_key request_api_version correlation_id client_id [tagged fields]
+Status ParseRequest(std::string_view payload, Packet* packet) {
+  BinaryDecoder decoder(payload);
+  if (!decoder.HasBytes(kMinRequestPayloadSize)) {
+    return error::Internal("Request header is cut short.");
+  }
+  const auto api_key = decoder.ExtractIntUnchecked<int16_t>();
+  packet->api_version = decoder.ExtractIntUnchecked<int16_t>();
+  packet->correlation_id = decoder.ExtractIntUnchecked<int32_t>();
+  if (!IsValidRequestHeader(api_key, packet->api_version, packet->correlation_id)) {
+    return error::Internal("Invalid request header.");
+  }
+  packet->api_key = static_cast<APIKey>(api_key);
+
+  // Only version 0 of ControlledShutdown has no client_id.
+  if (packet->api_key == APIKey::kControlledShutdown && packet->api_version == 0) {
+    return Status::OK();
+  }
+  // client_id is a [nullable string], in the classic encoding even in flexible versions.
+  PL_ASSIGN_OR_RETURN(int16_t client_id_len, decoder.ExtractInt<int16_t>());
+  if (client_id_len > 0) {
+    PL_ASSIGN_OR_RETURN(packet->client_id, decoder.ExtractString(client_id_len));
+  }
+
+  if (packet->api_key != APIKey::kProduce && packet->api_key != APIKey::kFetch) {
+    return Status::OK();
+  }
+
+  // The body only describes the request, so a body that cannot be decoded still leaves a valid
+  // packet, just without its summary.
+  PacketDecoder body_decoder(decoder.Buf(), IsFlexible(packet->api_key, packet->api_version));
+  Status s = body_decoder.SkipTaggedFields();
+  if (s.ok()) {
+    s = packet->api_key == APIKey::kProduce ? SummarizeProduceRequest(&body_decoder, packet)
+                                            : SummarizeFetchRequest(&body_decoder, packet);
+  }
+  VLOG_IF(1, !s.ok()) << absl::Substitute("Could not decode the body of $0 v$1: $2",
+                                          magic_enum::enum_name(packet->api_key),
+                                          packet->api_version, s.msg());
+  return Status::OK();
+}
+
+// Response Header => correlation_id [tagged fields]
+// The tagged fields depend on the version of the request, so they are not decoded.
+Status ParseResponse(std::string_view payload, Packet* packet) {
+  BinaryDecoder decoder(payload);
+  if (!decoder.HasBytes(kMinResponsePayloadSize)) {
+    return error::Internal("Response header is cut short.");
+  }
+  packet->correlation_id = decoder.ExtractIntUnchecked<int32_t>();
+  return Status::OK();
+}
+
+}  // namespace
+
+size_t FindPacketBoundary(MessageType type, std::string_view buf, size_t start_pos) {
+  // Responses do not have enough of a header to tell their starts apart from random bytes.
+  if (type != MessageType::kRequest) {
+    return std::string::npos;
+  }
+
+  constexpr size_t kMinRequestSize = kMessageSizeBytes + kMinRequestPayloadSize;
+  for (size_t pos = start_pos; pos + kMinRequestSize <= buf.size(); ++pos) {
+    std::string_view s = buf.substr(pos);
+    const auto payload_size = utils::BEndianBytesToInt<int32_t>(s);
+    s.remove_prefix(kMessageSizeBytes);
+    const auto api_key = utils::BEndianBytesToInt<int16_t>(s);
+    const auto api_version = utils::BEndianBytesToInt<int16_t>(s.substr(2));
+    const auto correlation_id = utils::BEndianBytesToInt<int32_t>(s.substr(4));
+    if (payload_size >= kMinRequestPayloadSize && payload_size <= kMaxPayloadSize &&
+        IsValidRequestHeader(api_key, api_version, correlation_id)) {
+      return pos;
+    }
+  }
+  return std::string::npos;
+}
+
+ParseState ParsePacket(MessageType type, std::string_view* buf, Packet* packet) {
+  if (type != MessageType::kRequest && type != MessageType::kResponse) {
+    return ParseState::kInvalid;
+  }
+  if (buf->size() < kMessageSizeBytes) {
+    return ParseState::kNeedsMoreData;
+  }
+
+  const auto payload_size = utils::BEndianBytesToInt<int32_t>(*buf);
+  const int32_t min_payload_size =
+      type == MessageType::kRequest ? kMinRequestPayloadSize : kMinResponsePayloadSize;
+  if (payload_size < min_payload_size || payload_size > kMaxPayloadSize) {
+    return ParseState::kInvalid;
+  }
+  if (buf->size() < kMessageSizeBytes + payload_size) {
+    return ParseState::kNeedsMoreData;
+  }
+
+  std::string_view payload = buf->substr(kMessageSizeBytes, payload_size);
+  Status s = type == MessageType::kRequest ? ParseRequest(payload, packet)
+                                           : ParseResponse(payload, packet);
+  if (!s.ok()) {
+    return ParseState::kInvalid;
+  }
+
+  packet->payload_size = payload_size;
+  buf->remove_prefix(kMessageSizeBytes + payload_size);
+  return ParseState::kSuccess;
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+size_t FindPacketBoundary(MessageType type, std::string_view buf, size_t start_pos);
+
+// Kafka protocol specification: https://kafka.apache.org/protocol.html
+ParseState ParsePacket(MessageType type, std::string_view* buf, Packet* packet);
+
+}  // namespace kafka
+
+template <>
+inline size_t FindFrameBoundary<kafka::Packet>(MessageType type, std::string_view buf,
+                                               size_t start_pos) {
+  return kafka::FindPacketBoundary(type, buf, start_pos);
+}
+
+template <>
+inline ParseState ParseFrame(MessageType type, std::string_view* buf, kafka::Packet* packet) {
+  return kafka::ParsePacket(type, buf, packet);
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
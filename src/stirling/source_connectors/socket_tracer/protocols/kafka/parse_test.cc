@@ -0,0 +1,254 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/parse.h"
+
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+namespace {
+
+// Builds the bytes of a message, in big-endian order.
+class MessageBuilder {
+ public:
+  template <typename TIntType>
+  MessageBuilder& Int(TIntType val) {
+    for (int i = sizeof(TIntType) - 1; i >= 0; --i) {
+      buf_.push_back(static_cast<char>((static_cast<uint64_t>(val) >> (8 * i)) & 0xff));
+    }
+    return *this;
+  }
+
+  MessageBuilder& UnsignedVarint(uint32_t val) {
+    while (val >= 0x80) {
+      buf_.push_back(static_cast<char>((val & 0x7f) | 0x80));
+      val >>= 7;
+    }
+    buf_.push_back(static_cast<char>(val));
+    return *this;
+  }
+
+  MessageBuilder& String(std::string_view s) {
+    Int<int16_t>(s.size());
+    buf_.append(s);
+    return *this;
+  }
+
+  MessageBuilder& CompactString(std::string_view s) {
+    UnsignedVarint(s.size() + 1);
+    buf_.append(s);
+    return *this;
+  }
+
+  MessageBuilder& Bytes(size_t size) {
+    Int<int32_t>(size);
+    buf_.append(size, '\0');
+    return *this;
+  }
+
+  MessageBuilder& CompactBytes(size_t size) {
+    UnsignedVarint(size + 1);
+    buf_.append(size, '\0');
+    return *this;
+  }
+
+  // Returns the message, prefixed by its size.
+  std::string Build() const {
+    std::string msg;
+    for (int i = 3; i >= 0; --i) {
+      msg.push_back(static_cast<char>((buf_.size() >> (8 * i)) & 0xff));
+    }
+    msg.append(buf_);
+    return msg;
+  }
+
+ private:
+  std::string buf_;
+};
+
+MessageBuilder RequestHeader(APIKey api_key, int16_t api_version, int32_t correlation_id,
+                             std::string_view client_id) {
+  MessageBuilder builder;
+  builder.Int<int16_t>(static_cast<int16_t>(api_key))
+      .Int<int16_t>(api_version)
+      .Int<int32_t>(correlation_id)
+      .String(client_id);
+  return builder;
+}
+
+}  // namespace
+
+TEST(KafkaParseTest, ApiVersionsRequest) {
+  const std::string msg = RequestHeader(APIKey::kApiVersions, 3, 7, "producer-1")
+                              .UnsignedVarint(0)  // Tagged fields.
+                              .CompactString("apache-kafka-java")
+                              .CompactString("2.8.0")
+                              .UnsignedVarint(0)
+                              .Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kSuccess);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(packet.payload_size, static_cast<int32_t>(msg.size() - 4));
+  EXPECT_EQ(packet.api_key, APIKey::kApiVersions);
+  EXPECT_EQ(packet.api_version, 3);
+  EXPECT_EQ(packet.correlation_id, 7);
+  EXPECT_EQ(packet.client_id, "producer-1");
+  EXPECT_TRUE(packet.expects_response);
+  EXPECT_EQ(packet.msg, "");
+}
+
+TEST(KafkaParseTest, ProduceRequest) {
+  const std::string msg = RequestHeader(APIKey::kProduce, 7, 1, "producer-1")
+                              .String("")  // transactional_id
+                              .Int<int16_t>(1)
+                              .Int<int32_t>(30000)
+                              .Int<int32_t>(1)
+                              .String("orders")
+                              .Int<int32_t>(2)
+                              .Int<int32_t>(0)
+                              .Bytes(1000)
+                              .Int<int32_t>(3)
+                              .Bytes(20)
+                              .Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kSuccess);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(packet.api_key, APIKey::kProduce);
+  EXPECT_TRUE(packet.expects_response);
+  EXPECT_EQ(packet.msg,
+            R"({"acks":1,"topics":[{"name":"orders","partitions":[{"index":0,"records_size":1000},)"
+            R"({"index":3,"records_size":20}]}]})");
+  // The records are not kept.
+  EXPECT_LT(packet.ByteSize(), 1000);
+}
+
+TEST(KafkaParseTest, FlexibleProduceRequestWithoutAcks) {
+  const std::string msg = RequestHeader(APIKey::kProduce, 9, 1, "producer-1")
+                              .UnsignedVarint(0)    // Header tagged fields.
+                              .CompactString("")    // transactional_id
+                              .Int<int16_t>(0)      // acks
+                              .Int<int32_t>(30000)  // timeout_ms
+                              .UnsignedVarint(2)    // 1 topic.
+                              .CompactString("orders")
+                              .UnsignedVarint(2)  // 1 partition.
+                              .Int<int32_t>(5)
+                              .CompactBytes(300)
+                              .UnsignedVarint(0)
+                              .UnsignedVarint(0)
+                              .UnsignedVarint(0)
+                              .Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kSuccess);
+  EXPECT_FALSE(packet.expects_response);
+  EXPECT_EQ(packet.msg,
+            R"({"acks":0,"topics":[{"name":"orders","partitions":)"
+            R"([{"index":5,"records_size":300}]}]})");
+}
+
+TEST(KafkaParseTest, FetchRequest) {
+  const std::string msg = RequestHeader(APIKey::kFetch, 4, 2, "consumer-1")
+                              .Int<int32_t>(-1)       // replica_id
+                              .Int<int32_t>(500)      // max_wait_ms
+                              .Int<int32_t>(1)        // min_bytes
+                              .Int<int32_t>(1 << 20)  // max_bytes
+                              .Int<int8_t>(0)         // isolation_level
+                              .Int<int32_t>(1)
+                              .String("orders")
+                              .Int<int32_t>(1)
+                              .Int<int32_t>(0)
+                              .Int<int64_t>(42)       // fetch_offset
+                              .Int<int32_t>(1 << 20)  // partition_max_bytes
+                              .Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kSuccess);
+  EXPECT_EQ(packet.api_key, APIKey::kFetch);
+  EXPECT_EQ(packet.client_id, "consumer-1");
+  EXPECT_EQ(packet.msg,
+            R"({"topics":[{"name":"orders","partitions":[{"index":0,"fetch_offset":42}]}]})");
+}
+
+TEST(KafkaParseTest, UndecodableBodyKeepsHeader) {
+  // The topic array is cut short.
+  const std::string msg = RequestHeader(APIKey::kProduce, 2, 1, "producer-1")
+                              .Int<int16_t>(1)
+                              .Int<int32_t>(30000)
+                              .Int<int32_t>(1)
+                              .Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kSuccess);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(packet.client_id, "producer-1");
+  EXPECT_EQ(packet.msg, "");
+}
+
+TEST(KafkaParseTest, Response) {
+  const std::string msg = MessageBuilder().Int<int32_t>(7).Bytes(100).Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  ASSERT_EQ(ParsePacket(MessageType::kResponse, &buf, &packet), ParseState::kSuccess);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(packet.correlation_id, 7);
+  EXPECT_EQ(packet.payload_size, 108);
+}
+
+TEST(KafkaParseTest, NeedsMoreData) {
+  const std::string msg = RequestHeader(APIKey::kMetadata, 9, 1, "client").Build();
+  std::string_view buf = std::string_view(msg).substr(0, msg.size() - 1);
+
+  Packet packet;
+  EXPECT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kNeedsMoreData);
+  EXPECT_EQ(buf.size(), msg.size() - 1);
+}
+
+TEST(KafkaParseTest, InvalidRequestHeader) {
+  const std::string msg = RequestHeader(static_cast<APIKey>(1000), 0, 1, "client").Build();
+  std::string_view buf = msg;
+
+  Packet packet;
+  EXPECT_EQ(ParsePacket(MessageType::kRequest, &buf, &packet), ParseState::kInvalid);
+}
+
+TEST(KafkaParseTest, FindPacketBoundary) {
+  const std::string msg = RequestHeader(APIKey::kMetadata, 9, 1, "client").Build();
+  const std::string buf = absl::StrCat(ConstStringView("\xff\xff\xff\xff\x00"), msg);
+
+  EXPECT_EQ(FindFrameBoundary<Packet>(MessageType::kRequest, buf, 0), 5);
+  EXPECT_EQ(FindFrameBoundary<Packet>(MessageType::kResponse, buf, 0), std::string::npos);
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/stitcher.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+RecordsWithErrorCount<Record> StitchFrames(std::deque<Packet>* req_packets,
+                                           std::deque<Packet>* resp_packets) {
+  std::vector<Record> records;
+  records.reserve(std::min(req_packets->size(), resp_packets->size()));
+  int error_count = 0;
+
+  // Requests before req_begin have been consumed.
+  auto req_begin = req_packets->begin();
+
+  // Outputs the requests before req_end, which cannot be matched by any later response.
+  auto consume_requests = [&](std::deque<Packet>::iterator req_end) {
+    for (; req_begin != req_end; ++req_begin) {
+      if (req_begin->expects_response) {
+        VLOG(1) << absl::Substitute("Did not find a response for correlation_id=$0",
+                                    req_begin->correlation_id);
+        ++error_count;
+      } else {
+        records.push_back({std::move(*req_begin), {}});
+      }
+    }
+  };
+
+  for (auto& resp_packet : *resp_packets) {
+    auto req_iter = std::find_if(req_begin, req_packets->end(), [&](const Packet& req) {
+      return req.correlation_id == resp_packet.correlation_id;
+    });
+    if (req_iter == req_packets->end()) {
+      VLOG(1) << absl::Substitute("Did not find a request for correlation_id=$0",
+                                  resp_packet.correlation_id);
+      ++error_count;
+      continue;
+    }
+
+    consume_requests(req_iter);
+    records.push_back({std::move(*req_iter), std::move(resp_packet)});
+    ++req_begin;
+  }
+
+  // The requests that get no response do not need to wait for any.
+  auto req_end = req_begin;
+  while (req_end != req_packets->end() && !req_end->expects_response) {
+    ++req_end;
+  }
+  consume_requests(req_end);
+
+  // Unmatched responses have no request in either this or any later call, and are dropped.
+  resp_packets->clear();
+  req_packets->erase(req_packets->begin(), req_begin);
+
+  return {std::move(records), error_count};
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/stitcher.h"
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::IsEmpty;
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+Packet CreatePacket(uint64_t timestamp_ns, int32_t correlation_id, bool expects_response = true) {
+  Packet packet;
+  packet.timestamp_ns = timestamp_ns;
+  packet.correlation_id = correlation_id;
+  packet.expects_response = expects_response;
+  return packet;
+}
+
+auto ReqCorrelationID(int32_t correlation_id) {
+  return Field(&Record::req, Field(&Packet::correlation_id, correlation_id));
+}
+
+TEST(KafkaStitcherTest, MatchesByCorrelationID) {
+  std::deque<Packet> req_packets = {CreatePacket(0, 1), CreatePacket(1, 2), CreatePacket(2, 3)};
+  std::deque<Packet> resp_packets = {CreatePacket(3, 1), CreatePacket(4, 2)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  EXPECT_THAT(result.records, ElementsAre(ReqCorrelationID(1), ReqCorrelationID(2)));
+  EXPECT_EQ(result.records[0].resp.timestamp_ns, 3);
+  EXPECT_EQ(result.records[1].resp.timestamp_ns, 4);
+  EXPECT_THAT(resp_packets, IsEmpty());
+  ASSERT_EQ(req_packets.size(), 1);
+  EXPECT_EQ(req_packets.front().correlation_id, 3);
+}
+
+TEST(KafkaStitcherTest, MissingResponse) {
+  std::deque<Packet> req_packets = {CreatePacket(0, 1), CreatePacket(1, 2), CreatePacket(2, 3)};
+  std::deque<Packet> resp_packets = {CreatePacket(3, 1), CreatePacket(4, 3)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 1);
+  EXPECT_THAT(result.records, ElementsAre(ReqCorrelationID(1), ReqCorrelationID(3)));
+  EXPECT_THAT(req_packets, IsEmpty());
+  EXPECT_THAT(resp_packets, IsEmpty());
+}
+
+TEST(KafkaStitcherTest, MissingRequest) {
+  std::deque<Packet> req_packets = {CreatePacket(1, 2)};
+  std::deque<Packet> resp_packets = {CreatePacket(2, 1), CreatePacket(3, 2)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 1);
+  EXPECT_THAT(result.records, ElementsAre(ReqCorrelationID(2)));
+  EXPECT_THAT(req_packets, IsEmpty());
+  EXPECT_THAT(resp_packets, IsEmpty());
+}
+
+TEST(KafkaStitcherTest, RequestsWithoutResponse) {
+  // Produce requests with acks=0 get no response.
+  std::deque<Packet> req_packets = {CreatePacket(0, 1, false), CreatePacket(1, 2),
+                                    CreatePacket(2, 3, false), CreatePacket(3, 4)};
+  std::deque<Packet> resp_packets = {CreatePacket(4, 2)};
+
+  RecordsWithErrorCount<Record> result = StitchFrames(&req_packets, &resp_packets);
+  EXPECT_EQ(result.error_count, 0);
+  EXPECT_THAT(result.records,
+              ElementsAre(ReqCorrelationID(1), ReqCorrelationID(2), ReqCorrelationID(3)));
+  EXPECT_EQ(result.records[0].resp.timestamp_ns, 0);
+  EXPECT_EQ(result.records[2].resp.timestamp_ns, 0);
+  ASSERT_EQ(req_packets.size(), 1);
+  EXPECT_EQ(req_packets.front().correlation_id, 4);
+}
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include <magic_enum.hpp>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace kafka {
+
+// The API of a request, which is Kafka's terminology for opcode.
+// See https://kafka.apache.org/protocol.html#protocol_api_keys
+enum class APIKey : int16_t {
+  kProduce = 0,
+  kFetch = 1,
+  kListOffsets = 2,
+  kMetadata = 3,
+  kLeaderAndIsr = 4,
+  kStopReplica = 5,
+  kUpdateMetadata = 6,
+  kControlledShutdown = 7,
+  kOffsetCommit = 8,
+  kOffsetFetch = 9,
+  kFindCoordinator = 10,
+  kJoinGroup = 11,
+  kHeartbeat = 12,
+  kLeaveGroup = 13,
+  kSyncGroup = 14,
+  kDescribeGroups = 15,
+  kListGroups = 16,
+  kSaslHandshake = 17,
+  kApiVersions = 18,
+  kCreateTopics = 19,
+  kDeleteTopics = 20,
+  kDeleteRecords = 21,
+  kInitProducerId = 22,
+  kOffsetForLeaderEpoch = 23,
+  kAddPartitionsToTxn = 24,
+  kAddOffsetsToTxn = 25,
+  kEndTxn = 26,
+  kWriteTxnMarkers = 27,
+  kTxnOffsetCommit = 28,
+  kDescribeAcls = 29,
+  kCreateAcls = 30,
+  kDeleteAcls = 31,
+  kDescribeConfigs = 32,
+  kAlterConfigs = 33,
+  kAlterReplicaLogDirs = 34,
+  kDescribeLogDirs = 35,
+  kSaslAuthenticate = 36,
+  kCreatePartitions = 37,
+  kCreateDelegationToken = 38,
+  kRenewDelegationToken = 39,
+  kExpireDelegationToken = 40,
+  kDescribeDelegationToken = 41,
+  kDeleteGroups = 42,
+  kElectLeaders = 43,
+  kIncrementalAlterConfigs = 44,
+  kAlterPartitionReassignments = 45,
+  kListPartitionReassignments = 46,
+  kOffsetDelete = 47,
+  kDescribeClientQuotas = 48,
+  kAlterClientQuotas = 49,
+  kDescribeUserScramCredentials = 50,
+  kAlterUserScramCredentials = 51,
+  kVote = 52,
+  kBeginQuorumEpoch = 53,
+  kEndQuorumEpoch = 54,
+  kDescribeQuorum = 55,
+  kAlterIsr = 56,
+  kUpdateFeatures = 57,
+  kEnvelope = 58,
+  kFetchSnapshot = 59,
+  kDescribeCluster = 60,
+  kDescribeProducers = 61,
+  kBrokerRegistration = 62,
+};
+
+// A Kafka request or response message.
+// Only the headers and the topics and partitions of produce and fetch requests are decoded.
+// The record batches, which can be megabytes large, are stepped over and never copied.
+struct Packet : public FrameBase {
+  // The size of the message, not including its 4-byte length prefix.
+  int32_t payload_size = 0;
+
+  int32_t correlation_id = 0;
+
+  // The remaining fields are only set for requests; response headers only have correlation_id.
+  APIKey api_key = APIKey::kProduce;
+  int16_t api_version = 0;
+  std::string client_id;
+
+  // False for produce requests with acks=0, to which the broker does not respond.
+  bool expects_response = true;
+
+  // The topics and partitions of produce and fetch requests, in JSON. Empty for other requests.
+  std::string msg;
+
+  size_t ByteSize() const override { return sizeof(Packet) + client_id.size() + msg.size(); }
+
+  std::string ToString() const {
+    return absl::Substitute(
+        "base=[$0] payload_size=$1 correlation_id=$2 api_key=$3 api_version=$4 client_id=$5 "
+        "msg=$6",
+        FrameBase::ToString(), payload_size, correlation_id, magic_enum::enum_name(api_key),
+        api_version, client_id, msg);
+  }
+};
+
+struct Record {
+  Packet req;
+  // Not set if the request gets no response, see Packet::expects_response.
+  Packet resp;
+};
+
+// Required by event parser interface.
+struct ProtocolTraits {
+  using frame_type = Packet;
+  using record_type = Record;
+  using state_type = NoState;
+};
+
+}  // namespace kafka
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
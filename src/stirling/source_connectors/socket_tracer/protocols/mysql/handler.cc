@@ -344,7 +344,7 @@ StatusOr<ParseState> HandleStmtPrepareOKResponse(DequeView<Packet> resp_packets,
   }
 
   // Update state.
-  state->prepared_statements.emplace(
+  state->prepared_statements.Insert(
       stmt_id,
       PreparedStatement{.request = entry->req.msg,
                         .response = StmtPrepareOKResponse{.header = resp_header,
@@ -462,7 +462,7 @@ Status ProcessStmtExecuteParam(std::string_view msg, size_t* type_offset, size_t
 }  // namespace
 
 StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
-                                              std::map<int, PreparedStatement>* prepare_map,
+                                              PreparedStatementMap* prepare_map,
                                               Record* entry) {
   if (req_packet.msg.size() < 1 + kStmtIDBytes) {
     return error::Internal("Insufficient number of bytes for STMT_EXECUTE");
@@ -474,11 +474,12 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
   int stmt_id =
       utils::LEndianBytesToInt<int, kStmtIDBytes>(req_packet.msg.substr(kStmtIDStartOffset));
 
-  auto iter = prepare_map->find(stmt_id);
-  if (iter == prepare_map->end()) {
-    // There can be 2 possibilities in this case:
+  const PreparedStatement* prepared_stmt = prepare_map->Find(stmt_id);
+  if (prepared_stmt == nullptr) {
+    // There can be 3 possibilities in this case:
     // 1. The stitcher is confused/messed up and accidentally deleted wrong prepare event.
     // 2. Client sent a Stmt Exec for a deleted Stmt Prepare
+    // 3. The Stmt Prepare was evicted because the client keeps too many statements open.
     // We return -1 as stmt_id to indicate error and defer decision to the caller.
 
     // We can't determine whether the rest of this packet is valid or not, so just return success.
@@ -491,7 +492,7 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
     return ParseState::kSuccess;
   }
 
-  int num_params = iter->second.response.header.num_params;
+  int num_params = prepared_stmt->response.header.num_params;
 
   size_t offset = kStmtIDStartOffset + kStmtIDBytes + kFlagsBytes + kIterationCountBytes;
 
@@ -520,14 +521,14 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
     }
   }
 
-  std::string_view stmt_prepare_request = iter->second.request;
+  std::string_view stmt_prepare_request = prepared_stmt->request;
   entry->req.msg = CombinePrepareExecute(stmt_prepare_request, params);
 
   return ParseState::kSuccess;
 }
 
 StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
-                                            std::map<int, PreparedStatement>* prepare_map,
+                                            PreparedStatementMap* prepare_map,
                                             Record* entry) {
   if (req_packet.msg.size() < 1 + kStmtIDBytes) {
     return error::Internal("Insufficient number of bytes for STMT_CLOSE");
@@ -539,10 +540,7 @@ StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
 
   int stmt_id =
       utils::LEndianBytesToInt<int, kStmtIDBytes>(req_packet.msg.substr(kStmtIDStartOffset));
-  auto iter = prepare_map->find(stmt_id);
-  if (iter != prepare_map->end()) {
-    prepare_map->erase(iter);
-  } else {
+  if (!prepare_map->Erase(stmt_id)) {
     // We may have missed the prepare statement (e.g. due to the missing start of connection
     // problem), but we can still process the close, and continue on. Just print a warning.
     entry->px_info = absl::Substitute(
@@ -18,7 +18,6 @@
 
 #pragma once
 #include <deque>
-#include <map>
 #include <memory>
 
 #include "src/common/base/statusor.h"
@@ -57,7 +56,7 @@ StatusOr<ParseState> HandleStmtPrepareOKResponse(DequeView<Packet> resp_packets,
  * look up the previously parsed StmtPrepare event based on a stmt_id when parsing the request.
  */
 StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
-                                              std::map<int, PreparedStatement>* prepare_map,
+                                              PreparedStatementMap* prepare_map,
                                               Record* entry);
 
 /**
@@ -65,7 +64,7 @@ StatusOr<ParseState> HandleStmtExecuteRequest(const Packet& req_packet,
  * the prepare stmt from the map (state of ConnTracker).
  */
 StatusOr<ParseState> HandleStmtCloseRequest(const Packet& req_packet,
-                                            std::map<int, PreparedStatement>* prepare_map,
+                                            PreparedStatementMap* prepare_map,
                                             Record* entry);
 
 /**
@@ -20,7 +20,6 @@
 
 #include <chrono>
 #include <deque>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -30,6 +29,7 @@
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"  // For FrameBase
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -348,12 +348,16 @@ struct PreparedStatement {
   StmtPrepareOKResponse response;
 };
 
+using PreparedStatementMap = StatementCache<int, PreparedStatement>;
+
 /**
  * State stores a map of stmt_id to active StmtPrepare event. It's used to be looked up
- * for the StmtPrepare event when a StmtExecute is received.
+ * for the StmtPrepare event when a StmtExecute is received. The map is bounded by
+ * --stirling_prepared_statement_cache_size, so statements that are never closed are
+ * eventually evicted.
  */
 struct State {
-  std::map<int, PreparedStatement> prepared_statements;
+  PreparedStatementMap prepared_statements;
   // To prevent pushing data on mis-classified connections,
   // we start off in inactive state, which means no data will be pushed out.
   // Only on certain conditions, which increase our confidence that the data is indeed MySQL,
@@ -45,12 +45,15 @@ constexpr int kNullValLen = -1;
   PL_ASSIGN_OR(expr, val_or, return ParseState::kInvalid)
 
 ParseState ParseRegularMessage(std::string_view* buf, RegularMessage* msg) {
+  constexpr int kLenFieldLen = 4;
+
   BinaryDecoder decoder(*buf);
-  PL_ASSIGN_OR_RETURN_NEEDS_MORE_DATA(const char char_val, decoder.ExtractChar());
-  msg->tag = static_cast<Tag>(char_val);
-  PL_ASSIGN_OR_RETURN_NEEDS_MORE_DATA(msg->len, decoder.ExtractInt<int32_t>());
+  if (!decoder.HasBytes(sizeof(char) + kLenFieldLen)) {
+    return ParseState::kNeedsMoreData;
+  }
+  msg->tag = static_cast<Tag>(decoder.ExtractCharUnchecked());
+  msg->len = decoder.ExtractIntUnchecked<int32_t>();
 
-  constexpr int kLenFieldLen = 4;
   if (msg->len < kLenFieldLen) {
     // Len includes the len field itself, so its value cannot be less than the length of the field.
     return ParseState::kInvalid;
@@ -66,14 +69,16 @@ ParseState ParseRegularMessage(std::string_view* buf, RegularMessage* msg) {
 }
 
 Status ParseStartupMessage(std::string_view* buf, StartupMessage* msg) {
-  BinaryDecoder decoder(*buf);
-
-  PL_ASSIGN_OR_RETURN(msg->len, decoder.ExtractInt<int32_t>());
-  PL_ASSIGN_OR_RETURN(msg->proto_ver.major, decoder.ExtractInt<int16_t>());
-  PL_ASSIGN_OR_RETURN(msg->proto_ver.minor, decoder.ExtractInt<int16_t>());
-
   const size_t kHeaderSize = 2 * sizeof(int32_t);
 
+  BinaryDecoder decoder(*buf);
+  if (!decoder.HasBytes(kHeaderSize)) {
+    return error::ResourceUnavailable("Insufficient number of bytes.");
+  }
+  msg->len = decoder.ExtractIntUnchecked<int32_t>();
+  msg->proto_ver.major = decoder.ExtractIntUnchecked<int16_t>();
+  msg->proto_ver.minor = decoder.ExtractIntUnchecked<int16_t>();
+
   if (decoder.BufSize() < msg->len - kHeaderSize) {
     return error::InvalidArgument("Not enough data");
   }
@@ -134,13 +139,18 @@ Status ParseRowDesc(const RegularMessage& msg, RowDesc* row_desc) {
     RowDesc::Field field = {};
 
     PL_ASSIGN_OR_RETURN(field.name, decoder.ExtractStringUntil('\0'));
-    PL_ASSIGN_OR_RETURN(field.table_oid, decoder.ExtractInt<int32_t>());
-    PL_ASSIGN_OR_RETURN(field.attr_num, decoder.ExtractInt<int16_t>());
-    PL_ASSIGN_OR_RETURN(field.type_oid, decoder.ExtractInt<int32_t>());
-    PL_ASSIGN_OR_RETURN(field.type_size, decoder.ExtractInt<int16_t>());
-    PL_ASSIGN_OR_RETURN(field.type_modifier, decoder.ExtractInt<int32_t>());
-    PL_ASSIGN_OR_RETURN(const int16_t fmt_code, decoder.ExtractInt<int16_t>());
-    field.fmt_code = static_cast<FmtCode>(fmt_code);
+
+    // The rest of the field description has a fixed size.
+    constexpr size_t kFixedFieldsSize = 3 * sizeof(int32_t) + 3 * sizeof(int16_t);
+    if (!decoder.HasBytes(kFixedFieldsSize)) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    field.table_oid = decoder.ExtractIntUnchecked<int32_t>();
+    field.attr_num = decoder.ExtractIntUnchecked<int16_t>();
+    field.type_oid = decoder.ExtractIntUnchecked<int32_t>();
+    field.type_size = decoder.ExtractIntUnchecked<int16_t>();
+    field.type_modifier = decoder.ExtractIntUnchecked<int32_t>();
+    field.fmt_code = static_cast<FmtCode>(decoder.ExtractIntUnchecked<int16_t>());
 
     row_desc->fields.push_back(std::move(field));
   }
@@ -247,10 +257,13 @@ Status ParseParamDesc(const RegularMessage& msg, ParamDesc* param_desc) {
   BinaryDecoder decoder(msg.payload);
 
   PL_ASSIGN_OR_RETURN(const int16_t param_count, decoder.ExtractInt<int16_t>());
+  if (param_count < 0 || !decoder.HasBytes(param_count * sizeof(int32_t))) {
+    return error::ResourceUnavailable("Insufficient number of bytes.");
+  }
 
+  param_desc->type_oids.reserve(param_count);
   for (int i = 0; i < param_count; ++i) {
-    PL_ASSIGN_OR_RETURN(const int32_t type_oid, decoder.ExtractInt<int32_t>());
-    param_desc->type_oids.push_back(type_oid);
+    param_desc->type_oids.push_back(decoder.ExtractIntUnchecked<int32_t>());
   }
 
   return Status::OK();
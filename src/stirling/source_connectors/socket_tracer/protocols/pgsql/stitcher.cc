@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/stitcher.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <variant>
@@ -220,7 +221,7 @@ Status HandleParse(const RegularMessage& msg, MsgDeqIter* resp_iter, const MsgDe
     if (parse.stmt_name.empty()) {
       state->unnamed_statement = parse.query;
     } else {
-      state->prepared_statements[parse.stmt_name] = parse.query;
+      state->prepared_statements.Insert(parse.stmt_name, parse.query);
     }
     req_resp->resp.msg = CmdCmpl{.timestamp_ns = iter->timestamp_ns, .cmd_tag = kParseCmplText};
   }
@@ -255,13 +256,14 @@ Status HandleBind(const RegularMessage& bind_msg, MsgDeqIter* resp_iter, const M
     if (bind_req.src_prepared_stat_name.empty()) {
       state->bound_statement = state->unnamed_statement;
     } else {
-      if (!state->prepared_statements.contains(bind_req.src_prepared_stat_name)) {
+      const std::string* stmt = state->prepared_statements.Find(bind_req.src_prepared_stat_name);
+      if (stmt == nullptr) {
         // TODO(yzhao): The code should handle the case where the previous Parse message was not
         // seen, i.e., state->prepared_statements does not contain the requested statement name.
         return error::InvalidArgument("Statement [name=$0] is not recorded",
                                       bind_req.src_prepared_stat_name);
       }
-      state->bound_statement = state->prepared_statements[bind_req.src_prepared_stat_name];
+      state->bound_statement = *stmt;
     }
     state->bound_params = bind_req.params;
     req_resp->resp.msg = CmdCmpl{.timestamp_ns = iter->timestamp_ns, .cmd_tag = "BIND COMPLETE"};
@@ -387,6 +389,7 @@ RecordsWithErrorCount<pgsql::Record> StitchFrames(std::deque<pgsql::RegularMessa
                                                   std::deque<pgsql::RegularMessage>* resps,
                                                   State* state) {
   std::vector<pgsql::Record> records;
+  records.reserve(std::min(reqs->size(), resps->size()));
   int error_count = 0;
   auto req_iter = reqs->begin();
   auto resp_iter = resps->begin();
@@ -454,7 +457,7 @@ RecordsWithErrorCount<pgsql::Record> StitchFrames(std::deque<pgsql::RegularMessa
   reqs->erase(reqs->begin(), req_iter);
   resps->erase(resps->begin(), resp_iter);
 
-  return {records, error_count};
+  return {std::move(records), error_count};
 }
 
 }  // namespace pgsql
@@ -203,7 +203,7 @@ class HandleBindTest : public ::testing::TestWithParam<HandleBindTestCase> {
   void SetUp() override {
     constexpr char kStmt[] = "select $1, $2 from t";
     state_.unnamed_statement = kStmt;
-    state_.prepared_statements["foo"] = kStmt;
+    state_.prepared_statements.Insert("foo", kStmt);
   }
 
   State state_;
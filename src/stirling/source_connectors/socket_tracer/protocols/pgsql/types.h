@@ -24,9 +24,8 @@
 #include <utility>
 #include <vector>
 
-#include <absl/container/flat_hash_map.h>
-
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/statement_cache.h"
 #include "src/stirling/utils/utils.h"
 
 namespace px {
@@ -523,7 +522,8 @@ struct Record {
 };
 
 struct State {
-  absl::flat_hash_map<std::string, std::string> prepared_statements;
+  // Named statements by name, bounded by --stirling_prepared_statement_cache_size.
+  StatementCache<std::string, std::string> prepared_statements;
 
   // One postgres session can only have at most one unnamed statement.
   std::string unnamed_statement;
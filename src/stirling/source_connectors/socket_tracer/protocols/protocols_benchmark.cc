@@ -0,0 +1,370 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#ifdef TCMALLOC
+#include <gperftools/malloc_hook.h>
+#endif
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/event_parser.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/cql/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/dns/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/test_data.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/redis/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/stitchers.h"
+
+// Benchmarks of the protocol parsers and stitchers, over small corpora of typical traffic.
+// Reports bytes/s, frames/s and, when tcmalloc is linked in, heap allocations per frame.
+//
+// HTTP/2 is not covered: its frames are traced by uprobes, and don't go through ParseFrames().
+
+using px::stirling::protocols::FrameParseStateTraits;
+using px::stirling::protocols::MessageType;
+using px::stirling::protocols::ParseFramesLoop;
+using px::stirling::protocols::ParseResult;
+using px::stirling::protocols::ParseState;
+using px::stirling::protocols::StitchFrames;
+
+namespace cass = px::stirling::protocols::cass;
+namespace dns = px::stirling::protocols::dns;
+namespace http = px::stirling::protocols::http;
+namespace mysql = px::stirling::protocols::mysql;
+namespace pgsql = px::stirling::protocols::pgsql;
+namespace redis = px::stirling::protocols::redis;
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Allocation counting
+//-----------------------------------------------------------------------------
+
+std::atomic<uint64_t> g_num_allocs = 0;
+
+#ifdef TCMALLOC
+void CountAlloc(const void* /*ptr*/, size_t /*size*/) {
+  g_num_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Corpora
+//-----------------------------------------------------------------------------
+
+// The data of a request and its response, each as it would arrive in a data event.
+struct Exchange {
+  std::string req;
+  std::string resp;
+};
+
+// The number of times a corpus is repeated per benchmark iteration.
+constexpr int kCorpusRepeats = 64;
+
+std::vector<Exchange> HTTPCorpus() {
+  const std::string json_body = R"({"id":1234,"name":"checkout","items":[1,2,3],"total":99.5})";
+  return {
+      {"GET /api/v1/orders/1234 HTTP/1.1\r\n"
+       "Host: orders.default.svc.cluster.local:8080\r\n"
+       "User-Agent: Go-http-client/1.1\r\n"
+       "Accept: application/json\r\n"
+       "Accept-Encoding: identity\r\n"
+       "X-Request-Id: 7f3c1d2e-85a4-4be5-9c1b-2f1d0e6a4b77\r\n"
+       "\r\n",
+       absl::StrCat("HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Date: Tue, 13 Oct 2020 18:21:04 GMT\r\n"
+                    "Content-Length: ",
+                    json_body.size(), "\r\n\r\n", json_body)},
+      {absl::StrCat("POST /api/v1/orders HTTP/1.1\r\n"
+                    "Host: orders.default.svc.cluster.local:8080\r\n"
+                    "User-Agent: python-requests/2.24.0\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Content-Length: ",
+                    json_body.size(), "\r\n\r\n", json_body),
+       "HTTP/1.1 201 Created\r\n"
+       "Content-Type: application/json\r\n"
+       "Transfer-Encoding: chunked\r\n"
+       "\r\n"
+       "b\r\n{\"id\":1235,\r\n"
+       "12\r\n\"status\":\"placed\"}\r\n"
+       "0\r\n\r\n"},
+  };
+}
+
+std::vector<Exchange> MySQLCorpus() {
+  using mysql::testdata::kRawQueryReq;
+  using mysql::testdata::kRawQueryResp;
+  using mysql::testdata::kRawStmtExecuteReq;
+  using mysql::testdata::kRawStmtExecuteResp;
+  using mysql::testdata::kRawStmtPrepareReq;
+  using mysql::testdata::kRawStmtPrepareResp;
+  return {
+      {absl::StrJoin(kRawStmtPrepareReq, ""), absl::StrJoin(kRawStmtPrepareResp, "")},
+      {absl::StrJoin(kRawStmtExecuteReq, ""), absl::StrJoin(kRawStmtExecuteResp, "")},
+      {absl::StrJoin(kRawQueryReq, ""), absl::StrJoin(kRawQueryResp, "")},
+  };
+}
+
+std::vector<Exchange> PgSQLCorpus() {
+  using namespace pgsql;  // NOLINT(build/namespaces) For the test data.
+  return {
+      {absl::StrCat(kParseData1, kDescData, kBindData, kExecData),
+       absl::StrCat(kParseCmplData, kParamDescData, kRowDescData, kBindCmplData, kDataRowData,
+                    kCmdCmplData)},
+      {std::string(kSelectQueryMsg),
+       absl::StrCat(kRowDescTestData, kDataRowTestData, kCmdCmplData)},
+      {std::string(kDropTableQueryMsg), std::string(kDropTableCmplMsg)},
+      {std::string(kRollbackMsg), std::string(kRollbackCmplMsg)},
+  };
+}
+
+// Returns a CQL v4 frame with the given opcode and body.
+std::string CQLFrame(bool response, cass::Opcode op, uint16_t stream, std::string_view body) {
+  std::string frame(9, '\0');
+  frame[0] = static_cast<char>(response ? 0x84 : 0x04);
+  frame[2] = stream >> 8;
+  frame[3] = stream;
+  frame[4] = static_cast<uint8_t>(op);
+  frame[5] = body.size() >> 24;
+  frame[6] = body.size() >> 16;
+  frame[7] = body.size() >> 8;
+  frame[8] = body.size();
+  return absl::StrCat(frame, body);
+}
+
+// Returns the body of a QUERY request with consistency ONE and no flags.
+std::string CQLQueryBody(std::string_view query) {
+  std::string len(4, '\0');
+  len[2] = query.size() >> 8;
+  len[3] = query.size();
+  return absl::StrCat(len, query, std::string_view("\x00\x01\x00", 3));
+}
+
+std::vector<Exchange> CQLCorpus() {
+  // A Void result.
+  constexpr uint8_t kVoidResult[] = {0x00, 0x00, 0x00, 0x01};
+  // A Rows result with one varchar column, cluster_name of system.local, and one row.
+  constexpr uint8_t kRowsResult[] = {
+      0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x73,
+      0x79, 0x73, 0x74, 0x65, 0x6d, 0x00, 0x05, 0x6c, 0x6f, 0x63, 0x61, 0x6c, 0x00, 0x0c, 0x63,
+      0x6c, 0x75, 0x73, 0x74, 0x65, 0x72, 0x5f, 0x6e, 0x61, 0x6d, 0x65, 0x00, 0x0d, 0x00, 0x00,
+      0x00, 0x01, 0x00, 0x00, 0x00, 0x0c, 0x54, 0x65, 0x73, 0x74, 0x20, 0x43, 0x6c, 0x75, 0x73,
+      0x74, 0x65, 0x72};
+  return {
+      {CQLFrame(false, cass::Opcode::kQuery, 1,
+                CQLQueryBody("INSERT INTO shop.orders (id, total) VALUES (1234, 99.5)")),
+       CQLFrame(true, cass::Opcode::kResult, 1, px::CreateCharArrayView<char>(kVoidResult))},
+      {CQLFrame(false, cass::Opcode::kQuery, 2,
+                CQLQueryBody("SELECT cluster_name FROM system.local")),
+       CQLFrame(true, cass::Opcode::kResult, 2, px::CreateCharArrayView<char>(kRowsResult))},
+  };
+}
+
+std::vector<Exchange> RedisCorpus() {
+  return {
+      {"*3\r\n$3\r\nSET\r\n$10\r\nsession:42\r\n$16\r\n{\"user\":\"alice\"}\r\n", "+OK\r\n"},
+      {"*2\r\n$3\r\nGET\r\n$10\r\nsession:42\r\n", "$16\r\n{\"user\":\"alice\"}\r\n"},
+      {"*3\r\n$6\r\nEXPIRE\r\n$10\r\nsession:42\r\n$4\r\n3600\r\n", ":1\r\n"},
+      {"*4\r\n$6\r\nLRANGE\r\n$6\r\nqueue1\r\n$1\r\n0\r\n$1\r\n1\r\n",
+       "*2\r\n$4\r\njob1\r\n$4\r\njob2\r\n"},
+  };
+}
+
+std::vector<Exchange> DNSCorpus() {
+  // A query for intellij-experiments.appspot.com and its response, captured with WireShark.
+  constexpr uint8_t kQueryFrame[] = {
+      0xc6, 0xfa, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x14, 0x69, 0x6e,
+      0x74, 0x65, 0x6c, 0x6c, 0x69, 0x6a, 0x2d, 0x65, 0x78, 0x70, 0x65, 0x72, 0x69, 0x6d, 0x65,
+      0x6e, 0x74, 0x73, 0x07, 0x61, 0x70, 0x70, 0x73, 0x70, 0x6f, 0x74, 0x03, 0x63, 0x6f, 0x6d,
+      0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x29, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00};
+  constexpr uint8_t kRespFrame[] = {
+      0xc6, 0xfa, 0x81, 0x80, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x14, 0x69, 0x6e,
+      0x74, 0x65, 0x6c, 0x6c, 0x69, 0x6a, 0x2d, 0x65, 0x78, 0x70, 0x65, 0x72, 0x69, 0x6d, 0x65,
+      0x6e, 0x74, 0x73, 0x07, 0x61, 0x70, 0x70, 0x73, 0x70, 0x6f, 0x74, 0x03, 0x63, 0x6f, 0x6d,
+      0x00, 0x00, 0x01, 0x00, 0x01, 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x01, 0x24,
+      0x00, 0x04, 0xd8, 0x3a, 0xc2, 0xb4, 0x00, 0x00, 0x29, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00};
+  return {
+      {std::string(px::CreateCharArrayView<char>(kQueryFrame)),
+       std::string(px::CreateCharArrayView<char>(kRespFrame))},
+  };
+}
+
+//-----------------------------------------------------------------------------
+// Benchmarks
+//-----------------------------------------------------------------------------
+
+// Parses the request and response of every exchange, the way a DataStream would parse the data
+// of its events. The frames of each exchange are timestamped after the frames before them.
+// Returns the number of frames parsed, or -1 if any of the data failed to parse.
+template <typename TFrameType, typename TParseState>
+int ParseExchanges(const std::vector<Exchange>& corpus, std::deque<TFrameType>* reqs,
+                   std::deque<TFrameType>* resps, TParseState* req_state,
+                   TParseState* resp_state) {
+  uint64_t timestamp_ns = 0;
+  auto parse = [&timestamp_ns](MessageType type, std::string_view data,
+                               std::deque<TFrameType>* frames, TParseState* parse_state) {
+    const size_t prev_size = frames->size();
+    ParseResult result = ParseFramesLoop(type, data, frames, parse_state);
+    if (result.state != ParseState::kSuccess || result.end_position != data.size()) {
+      return -1;
+    }
+    for (size_t i = prev_size; i < frames->size(); ++i) {
+      (*frames)[i].timestamp_ns = ++timestamp_ns;
+    }
+    return static_cast<int>(frames->size() - prev_size);
+  };
+
+  int num_frames = 0;
+  for (const Exchange& exchange : corpus) {
+    int num_req_frames = parse(MessageType::kRequest, exchange.req, reqs, req_state);
+    int num_resp_frames = parse(MessageType::kResponse, exchange.resp, resps, resp_state);
+    if (num_req_frames < 0 || num_resp_frames < 0) {
+      return -1;
+    }
+    num_frames += num_req_frames + num_resp_frames;
+  }
+  return num_frames;
+}
+
+std::vector<Exchange> RepeatCorpus(const std::vector<Exchange>& corpus) {
+  std::vector<Exchange> result;
+  for (int i = 0; i < kCorpusRepeats; ++i) {
+    result.insert(result.end(), corpus.begin(), corpus.end());
+  }
+  return result;
+}
+
+size_t CorpusBytes(const std::vector<Exchange>& corpus) {
+  size_t bytes = 0;
+  for (const Exchange& exchange : corpus) {
+    bytes += exchange.req.size() + exchange.resp.size();
+  }
+  return bytes;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void SetCounters(benchmark::State& state, int64_t num_frames,
+                 [[maybe_unused]] uint64_t num_allocs) {
+  state.counters["frames"] = benchmark::Counter(num_frames, benchmark::Counter::kIsRate);
+#ifdef TCMALLOC
+  state.counters["allocs_per_frame"] = 1.0 * num_allocs / num_frames;
+#endif
+}
+
+template <typename TProtocolTraits>
+// NOLINTNEXTLINE : runtime/references.
+void BM_ParseFrames(benchmark::State& state, const std::vector<Exchange>& corpus) {
+  using TFrameType = typename TProtocolTraits::frame_type;
+  const std::vector<Exchange> repeated_corpus = RepeatCorpus(corpus);
+
+  // The parse state is kept across iterations, just like it is kept by a DataStream.
+  typename FrameParseStateTraits<TFrameType>::type req_state;
+  typename FrameParseStateTraits<TFrameType>::type resp_state;
+
+  int64_t num_frames = 0;
+  uint64_t num_allocs = 0;
+  for (auto _ : state) {
+    std::deque<TFrameType> reqs;
+    std::deque<TFrameType> resps;
+    const uint64_t allocs_before = g_num_allocs.load(std::memory_order_relaxed);
+    int n = ParseExchanges(repeated_corpus, &reqs, &resps, &req_state, &resp_state);
+    num_allocs += g_num_allocs.load(std::memory_order_relaxed) - allocs_before;
+    if (n <= 0) {
+      state.SkipWithError("Failed to parse the corpus.");
+      return;
+    }
+    num_frames += n;
+    benchmark::DoNotOptimize(reqs);
+    benchmark::DoNotOptimize(resps);
+  }
+  state.SetBytesProcessed(state.iterations() * CorpusBytes(repeated_corpus));
+  SetCounters(state, num_frames, num_allocs);
+}
+
+template <typename TProtocolTraits>
+// NOLINTNEXTLINE : runtime/references.
+void BM_StitchFrames(benchmark::State& state, const std::vector<Exchange>& corpus) {
+  using TFrameType = typename TProtocolTraits::frame_type;
+  const std::vector<Exchange> repeated_corpus = RepeatCorpus(corpus);
+
+  typename FrameParseStateTraits<TFrameType>::type req_state;
+  typename FrameParseStateTraits<TFrameType>::type resp_state;
+  std::deque<TFrameType> parsed_reqs;
+  std::deque<TFrameType> parsed_resps;
+  if (ParseExchanges(repeated_corpus, &parsed_reqs, &parsed_resps, &req_state, &resp_state) <= 0) {
+    state.SkipWithError("Failed to parse the corpus.");
+    return;
+  }
+  const int64_t frames_per_iter = parsed_reqs.size() + parsed_resps.size();
+
+  typename TProtocolTraits::state_type stitch_state = {};
+
+  uint64_t num_allocs = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::deque<TFrameType> reqs = parsed_reqs;
+    std::deque<TFrameType> resps = parsed_resps;
+    state.ResumeTiming();
+
+    const uint64_t allocs_before = g_num_allocs.load(std::memory_order_relaxed);
+    auto result = StitchFrames(&reqs, &resps, &stitch_state);
+    num_allocs += g_num_allocs.load(std::memory_order_relaxed) - allocs_before;
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * CorpusBytes(repeated_corpus));
+  SetCounters(state, state.iterations() * frames_per_iter, num_allocs);
+}
+
+template <typename TProtocolTraits>
+void RegisterProtocolBenchmarks(std::string_view protocol, const std::vector<Exchange>& corpus) {
+  benchmark::RegisterBenchmark(absl::StrCat("BM_ParseFrames/", protocol).c_str(),
+                               BM_ParseFrames<TProtocolTraits>, corpus);
+  benchmark::RegisterBenchmark(absl::StrCat("BM_StitchFrames/", protocol).c_str(),
+                               BM_StitchFrames<TProtocolTraits>, corpus);
+}
+
+[[maybe_unused]] const bool kBenchmarksRegistered = [] {
+#ifdef TCMALLOC
+  MallocHook::AddNewHook(&CountAlloc);
+#endif
+  RegisterProtocolBenchmarks<http::ProtocolTraits>("http", HTTPCorpus());
+  RegisterProtocolBenchmarks<mysql::ProtocolTraits>("mysql", MySQLCorpus());
+  RegisterProtocolBenchmarks<pgsql::ProtocolTraits>("pgsql", PgSQLCorpus());
+  RegisterProtocolBenchmarks<cass::ProtocolTraits>("cql", CQLCorpus());
+  RegisterProtocolBenchmarks<redis::ProtocolTraits>("redis", RedisCorpus());
+  RegisterProtocolBenchmarks<dns::ProtocolTraits>("dns", DNSCorpus());
+  return true;
+}();
+
+}  // namespace
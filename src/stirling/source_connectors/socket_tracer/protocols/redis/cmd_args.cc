@@ -18,9 +18,11 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/cmd_args.h"
 
+#include <algorithm>
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 #include "src/common/json/json.h"
 
@@ -494,24 +496,54 @@ std::optional<const CmdArgs*> GetCmdAndArgs(std::string_view payload) {
   return std::nullopt;
 }
 
+// Summarizes the command names of kCmdList, so that payloads that can't be a command are rejected
+// without building upper-case candidates from them.
+struct CmdNameIndex {
+  // The first words of the double-word commands, e.g. "ACL" of "ACL LOAD".
+  absl::flat_hash_set<std::string_view> double_word_prefixes;
+  size_t max_name_size = 0;
+};
+
+const CmdNameIndex& GetCmdNameIndex() {
+  static const CmdNameIndex* const kIndex = [] {
+    auto* index = new CmdNameIndex;
+    for (const auto& [name, cmd_args] : kCmdList) {
+      index->max_name_size = std::max(index->max_name_size, name.size());
+      size_t pos = name.find(' ');
+      if (pos != std::string_view::npos) {
+        index->double_word_prefixes.insert(name.substr(0, pos));
+      }
+    }
+    return index;
+  }();
+  return *kIndex;
+}
+
 }  // namespace
 
-std::optional<const CmdArgs*> GetCmdAndArgs(VectorView<std::string>* payloads) {
+std::optional<const CmdArgs*> GetCmdAndArgs(VectorView<std::string_view>* payloads) {
   if (payloads->empty()) {
     return std::nullopt;
   }
+  const CmdNameIndex& index = GetCmdNameIndex();
+  // Response arrays go through here too; their first element is usually not a command.
+  if (payloads->front().size() > index.max_name_size) {
+    return std::nullopt;
+  }
+  std::string first_word = absl::AsciiStrToUpper(payloads->front());
+
   // Search the double-words command first.
-  if (payloads->size() >= 2) {
-    std::string candidate_cmd =
-        absl::AsciiStrToUpper(absl::StrCat((*payloads)[0], " ", (*payloads)[1]));
+  if (payloads->size() >= 2 && index.double_word_prefixes.contains(first_word) &&
+      first_word.size() + 1 + (*payloads)[1].size() <= index.max_name_size) {
+    std::string candidate_cmd = absl::StrCat(first_word, " ", (*payloads)[1]);
+    absl::AsciiStrToUpper(&candidate_cmd);
     auto res_opt = GetCmdAndArgs(candidate_cmd);
     if (res_opt.has_value()) {
       payloads->pop_front(2);
       return res_opt;
     }
   }
-  std::string candidate_cmd = absl::AsciiStrToUpper(payloads->front());
-  auto res_opt = GetCmdAndArgs(candidate_cmd);
+  auto res_opt = GetCmdAndArgs(first_word);
   if (res_opt.has_value()) {
     payloads->pop_front(1);
   }
@@ -18,6 +18,8 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/parse.h"
 
+#include <algorithm>
+#include <forward_list>
 #include <initializer_list>
 #include <map>
 #include <optional>
@@ -74,7 +76,8 @@ StatusOr<int> ParseSize(BinaryDecoder* decoder) {
 }
 
 // Bulk string is formatted as <length>\r\n<actual string, up to 512MB>\r\n
-Status ParseBulkString(BinaryDecoder* decoder, Message* msg) {
+// The returned view points into the decoder's buffer.
+StatusOr<std::string_view> ParseBulkString(BinaryDecoder* decoder) {
   PL_ASSIGN_OR_RETURN(int len, ParseSize(decoder));
 
   constexpr int kMaxLen = 512 * 1024 * 1024;
@@ -86,8 +89,7 @@ Status ParseBulkString(BinaryDecoder* decoder, Message* msg) {
     constexpr std::string_view kNullBulkString = "<NULL>";
     // TODO(yzhao): This appears wrong, as Redis has NULL value, here "<NULL>" is presented as
     // a string. ATM don't know how to output NULL value in Rapidjson. Research and update this.
-    msg->payload = kNullBulkString;
-    return Status::OK();
+    return kNullBulkString;
   }
 
   PL_ASSIGN_OR_RETURN(std::string_view payload,
@@ -96,11 +98,10 @@ Status ParseBulkString(BinaryDecoder* decoder, Message* msg) {
     return error::InvalidArgument("Bulk string should be terminated by '$0'", kTerminalSequence);
   }
   payload.remove_suffix(kTerminalSequence.size());
-  msg->payload = payload;
-  return Status::OK();
+  return payload;
 }
 
-bool IsPubMsg(const std::vector<std::string>& payloads) {
+bool IsPubMsg(const std::vector<std::string_view>& payloads) {
   // Published message format is at https://redis.io/topics/pubsub#format-of-pushed-messages
   constexpr size_t kArrayPayloadSize = 3;
   if (payloads.size() < kArrayPayloadSize) {
@@ -113,8 +114,7 @@ bool IsPubMsg(const std::vector<std::string>& payloads) {
   return true;
 }
 
-// This calls ParseMessage(), which eventually calls ParseArray() and are both recursive
-// functions. This is because Array message can include nested array messages.
+// ParseArray() is recursive, because Array message can include nested array messages.
 Status ParseArray(MessageType type, BinaryDecoder* decoder, Message* msg);
 
 Status ParseMessage(MessageType type, BinaryDecoder* decoder, Message* msg) {
@@ -127,7 +127,8 @@ Status ParseMessage(MessageType type, BinaryDecoder* decoder, Message* msg) {
       break;
     }
     case kBulkStringsMarker: {
-      PL_RETURN_IF_ERROR(ParseBulkString(decoder, msg));
+      PL_ASSIGN_OR_RETURN(std::string_view str, ParseBulkString(decoder));
+      msg->payload = str;
       break;
     }
     case kErrorMarker: {
@@ -161,14 +162,42 @@ Status ParseArray(MessageType type, BinaryDecoder* decoder, Message* msg) {
     return Status::OK();
   }
 
-  std::vector<std::string> payloads;
+  // The elements are views into the input buffer, which outlives the formatting below. Only the
+  // formatted payloads of nested arrays need their own storage. Pipelined clients send many
+  // commands per packet, so this avoids copying every argument of every command.
+  std::vector<std::string_view> payloads;
+  // Each element takes at least 3 bytes, which bounds the reservation for bogus sizes.
+  payloads.reserve(std::min<size_t>(len, decoder->BufSize() / 3));
+  std::forward_list<std::string> nested_payloads;
   for (int i = 0; i < len; ++i) {
-    Message tmp;
-    PL_RETURN_IF_ERROR(ParseMessage(type, decoder, &tmp));
-    payloads.push_back(std::move(tmp.payload));
+    PL_ASSIGN_OR_RETURN(const char type_marker, decoder->ExtractChar());
+    switch (type_marker) {
+      case kSimpleStringMarker:
+      case kErrorMarker:
+      case kIntegerMarker: {
+        PL_ASSIGN_OR_RETURN(std::string_view str, decoder->ExtractStringUntil(kTerminalSequence));
+        payloads.push_back(str);
+        break;
+      }
+      case kBulkStringsMarker: {
+        PL_ASSIGN_OR_RETURN(std::string_view str, ParseBulkString(decoder));
+        payloads.push_back(str);
+        break;
+      }
+      case kArrayMarker: {
+        Message tmp;
+        PL_RETURN_IF_ERROR(ParseArray(type, decoder, &tmp));
+        nested_payloads.push_front(std::move(tmp.payload));
+        payloads.push_back(nested_payloads.front());
+        break;
+      }
+      default:
+        return error::InvalidArgument(
+            "Unexpected Redis type marker char (displayed as integer): %d", type_marker);
+    }
   }
 
-  FormatArrayMessage(VectorView<std::string>(payloads), msg);
+  FormatArrayMessage(VectorView<std::string_view>(payloads), msg);
 
   if (type == MessageType::kResponse && IsPubMsg(payloads)) {
     msg->is_published_message = true;
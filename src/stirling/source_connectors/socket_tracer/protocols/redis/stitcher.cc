@@ -0,0 +1,159 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/redis/stitcher.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+DEFINE_uint32(stirling_redis_cmd_sample_rate, 1,
+              "If greater than 1, only record 1 in this many of the pipelined requests of each "
+              "Redis command that are stitched together. The recorded request counts the ones "
+              "that were skipped.");
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace redis {
+
+RecordsWithErrorCount<Record> StitchFrames(std::deque<Message>* req_messages,
+                                           std::deque<Message>* resp_messages) {
+  // NOTE: This cannot handle Redis pipelining if there is any missing message.
+  // See https://redis.io/topics/pipelining for Redis pipelining.
+  //
+  // This is copied from StitchMessagesWithTimestampOrder() in timestamp_stitcher.h.
+  // With additionally always pushing published messages into records with a synthesized request.
+  // See below.
+
+  std::vector<Record> records;
+  records.reserve(std::min(req_messages->size(), resp_messages->size()));
+
+  // Clients that pipeline requests send many of them at once, which are stitched together here.
+  // When sampling, only every Nth request of a command is recorded, and the record counts the
+  // ones in between. Requests that are not pipelined are always recorded.
+  const int64_t sample_rate = FLAGS_stirling_redis_cmd_sample_rate;
+  struct SampledCmd {
+    int64_t count = 0;
+    size_t record_idx = 0;
+  };
+  absl::flat_hash_map<std::string_view, SampledCmd> sampled_cmds;
+
+  Record record;
+  record.req.timestamp_ns = 0;
+  record.resp.timestamp_ns = 0;
+
+  Message dummy_message;
+  dummy_message.timestamp_ns = std::numeric_limits<int64_t>::max();
+
+  auto req_iter = req_messages->begin();
+  auto resp_iter = resp_messages->begin();
+  while (req_iter != req_messages->end() || resp_iter != resp_messages->end()) {
+    Message& req = (req_iter == req_messages->end()) ? dummy_message : *req_iter;
+    Message& resp = (resp_iter == resp_messages->end()) ? dummy_message : *resp_iter;
+
+    // This if block is the added code to StitchMessagesWithTimestampOrder().
+    // For Redis pub/sub, published messages have no corresponding `requests`, therefore we
+    // forcefully turn them into records without requests.
+    if (resp_iter != resp_messages->end() && resp.is_published_message) {
+      // Synthesize the request message.
+      Record unstitched_record = {};
+
+      unstitched_record.req.timestamp_ns = resp.timestamp_ns;
+      constexpr std::string_view kPubPushCmd = "PUSH PUB";
+      unstitched_record.req.command = kPubPushCmd;
+
+      unstitched_record.resp = std::move(resp);
+
+      records.push_back(std::move(unstitched_record));
+      ++resp_iter;
+      continue;
+    }
+
+    // Handle REPLCONF ACK command sent from follower to leader.
+    constexpr std::string_view kReplConfAck = "REPLCONF ACK";
+    if (req_iter != req_messages->end() && req.command == kReplConfAck &&
+        // Ensure the output order based on timestamps.
+        (resp_iter == resp_messages->end() || req.timestamp_ns < resp.timestamp_ns)) {
+      Record unstitched_record = {};
+
+      unstitched_record.req = std::move(req);
+      unstitched_record.resp.timestamp_ns = req.timestamp_ns;
+
+      records.push_back(std::move(unstitched_record));
+      ++req_iter;
+      continue;
+    }
+
+    // Handle commands sent from leader to follower, which are replayed at the follower.
+    if (resp_iter != resp_messages->end() && !resp.command.empty()) {
+      Record unstitched_record = {};
+
+      unstitched_record.req = std::move(resp);
+      unstitched_record.resp.timestamp_ns = resp.timestamp_ns;
+      unstitched_record.role_swapped = true;
+
+      records.push_back(std::move(unstitched_record));
+      ++resp_iter;
+      continue;
+    }
+
+    if (req.timestamp_ns < resp.timestamp_ns) {
+      record.req = std::move(req);
+      ++req_iter;
+    } else {
+      if (record.req.timestamp_ns != 0) {
+        bool keep = true;
+        if (sample_rate > 1 && !record.req.command.empty()) {
+          SampledCmd& sampled = sampled_cmds[record.req.command];
+          if (sampled.count % sample_rate == 0) {
+            sampled.record_idx = records.size();
+          } else {
+            ++records[sampled.record_idx].cmd_count;
+            keep = false;
+          }
+          ++sampled.count;
+        }
+
+        if (keep) {
+          record.resp = std::move(resp);
+          records.push_back(std::move(record));
+        }
+
+        record.req.timestamp_ns = 0;
+        record.resp.timestamp_ns = 0;
+      }
+      ++resp_iter;
+    }
+  }
+
+  req_messages->erase(req_messages->begin(), req_iter);
+  resp_messages->erase(resp_messages->begin(), resp_iter);
+
+  return {std::move(records), 0};
+}
+
+}  // namespace redis
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -100,6 +100,40 @@ TEST(StitchFramesTest, ReplConfAckAndMutationCommands) {
   EXPECT_THAT(resps, IsEmpty());
 }
 
+// Tests that pipelined requests are sampled per command, and that the recorded ones count the
+// skipped ones.
+TEST(StitchFramesTest, SamplePipelinedCommands) {
+  FLAGS_stirling_redis_cmd_sample_rate = 2;
+
+  std::deque<redis::Message> reqs = {
+      CreateMsg(0, "[\"k0\"]", "GET"), CreateMsg(1, "[\"k1\"]", "GET"),
+      CreateMsg(2, "[\"k2\"]", "GET"), CreateMsg(3, "", "PING"),
+  };
+
+  std::deque<redis::Message> resps = {
+      CreateMsg(4, "v0", ""),
+      CreateMsg(5, "v1", ""),
+      CreateMsg(6, "v2", ""),
+      CreateMsg(7, "PONG", ""),
+  };
+
+  NoState no_state;
+
+  RecordsWithErrorCount<redis::Record> res = StitchFrames<redis::Record>(&reqs, &resps, &no_state);
+  EXPECT_EQ(res.error_count, 0);
+  EXPECT_THAT(res.records,
+              ElementsAre(AllOf(EqualsRecord("GET", "[\"k0\"]", "v0"),
+                                Field(&redis::Record::cmd_count, 2)),
+                          AllOf(EqualsRecord("GET", "[\"k2\"]", "v2"),
+                                Field(&redis::Record::cmd_count, 1)),
+                          AllOf(EqualsRecord("PING", "", "PONG"),
+                                Field(&redis::Record::cmd_count, 1))));
+  EXPECT_THAT(reqs, IsEmpty());
+  EXPECT_THAT(resps, IsEmpty());
+
+  FLAGS_stirling_redis_cmd_sample_rate = 1;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -53,6 +53,9 @@ struct Record {
   Message req;
   Message resp;
   bool role_swapped = false;
+  // The number of pipelined requests of this command that this record stands for. Greater than 1
+  // only when commands are sampled, see --stirling_redis_cmd_sample_rate.
+  int64_t cmd_count = 1;
 };
 
 // Required by event parser interface.
@@ -25,6 +25,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/dns/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/types.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/kafka/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/mysql/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/types.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/types.h"
@@ -41,9 +42,13 @@ using FrameDequeVariant = std::variant<std::monostate,
                                        std::deque<mysql::Packet>,
                                        std::deque<pgsql::RegularMessage>,
                                        std::deque<dns::Frame>,
-                                       std::deque<redis::Message>>;
+                                       std::deque<redis::Message>,
+                                       std::deque<kafka::Packet>>;
 // clang-format off
 
+// The protocols with a FrameParseStateTraits specialization.
+using FrameParseStateVariant = std::variant<NoFrameParseState, http::StreamParseState>;
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
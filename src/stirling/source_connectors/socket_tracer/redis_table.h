@@ -46,6 +46,11 @@ static constexpr DataElement kRedisElements[] = {
          types::DataType::STRING,
          types::SemanticType::ST_NONE,
          types::PatternType::GENERAL},
+        {"cmd_count", "Number of requests that this record stands for. Greater than 1 when "
+                      "pipelined requests are sampled.",
+         types::DataType::INT64,
+         types::SemanticType::ST_NONE,
+         types::PatternType::METRIC_GAUGE},
         canonical_data_elements::kLatencyNS,
 #ifndef NDEBUG
         {"px_info_", "Pixie messages regarding the record (e.g. warnings)",
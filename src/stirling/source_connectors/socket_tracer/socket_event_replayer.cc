@@ -0,0 +1,284 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/socket_event_replayer.h"
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <magic_enum.hpp>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+std::chrono::nanoseconds ProcessCPUTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+int64_t PeakRSSBytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in KiB on Linux.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+uint64_t TimestampOf(const sockeventpb::SocketEvent& event) {
+  return event.has_data() ? event.data().attr().timestamp_ns() : event.control().timestamp_ns();
+}
+
+struct conn_id_t ConnIDFromPB(const sockeventpb::ConnID& pb) {
+  struct conn_id_t conn_id = {};
+  conn_id.upid.pid = pb.pid();
+  conn_id.upid.start_time_ticks = pb.start_time_ns();
+  conn_id.fd = pb.fd();
+  conn_id.tsid = pb.generation();
+  return conn_id;
+}
+
+socket_data_event_t::attr_t DataEventAttrFromPB(const sockeventpb::SocketDataEvent& pb,
+                                                uint64_t timestamp_ns) {
+  socket_data_event_t::attr_t attr = {};
+  attr.timestamp_ns = timestamp_ns;
+  attr.conn_id = ConnIDFromPB(pb.attr().conn_id());
+  attr.protocol = static_cast<TrafficProtocol>(pb.attr().protocol());
+  attr.role = static_cast<EndpointRole>(pb.attr().role());
+  attr.direction = static_cast<TrafficDirection>(pb.attr().direction());
+  attr.ssl = pb.attr().ssl();
+  attr.source_fn = static_cast<source_function_t>(pb.attr().source_fn());
+  attr.pos = pb.attr().pos();
+  attr.msg_size = pb.attr().msg_size();
+  attr.msg_buf_size = pb.msg().size();
+  return attr;
+}
+
+socket_control_event_t ControlEventFromPB(const sockeventpb::SocketControlEvent& pb,
+                                          uint64_t timestamp_ns) {
+  socket_control_event_t event = {};
+  event.type = static_cast<ControlEventType>(pb.type());
+  event.timestamp_ns = timestamp_ns;
+  event.conn_id = ConnIDFromPB(pb.conn_id());
+  if (event.type == kConnOpen) {
+    memcpy(&event.open.addr, pb.addr().data(), std::min(pb.addr().size(), sizeof(event.open.addr)));
+    event.open.role = static_cast<EndpointRole>(pb.role());
+  } else {
+    event.close.wr_bytes = pb.wr_bytes();
+    event.close.rd_bytes = pb.rd_bytes();
+  }
+  return event;
+}
+
+double PerSecond(uint64_t count, std::chrono::nanoseconds duration) {
+  return duration.count() > 0 ? count * 1e9 / duration.count() : 0;
+}
+
+}  // namespace
+
+void SocketDataEventToPB(const SocketDataEventView& event, sockeventpb::SocketDataEvent* pb) {
+  pb->mutable_attr()->set_timestamp_ns(event.attr.timestamp_ns);
+  pb->mutable_attr()->mutable_conn_id()->set_pid(event.attr.conn_id.upid.pid);
+  pb->mutable_attr()->mutable_conn_id()->set_start_time_ns(
+      event.attr.conn_id.upid.start_time_ticks);
+  pb->mutable_attr()->mutable_conn_id()->set_fd(event.attr.conn_id.fd);
+  pb->mutable_attr()->mutable_conn_id()->set_generation(event.attr.conn_id.tsid);
+  pb->mutable_attr()->set_protocol(event.attr.protocol);
+  pb->mutable_attr()->set_role(event.attr.role);
+  pb->mutable_attr()->set_direction(event.attr.direction);
+  pb->mutable_attr()->set_pos(event.attr.pos);
+  pb->mutable_attr()->set_msg_size(event.attr.msg_size);
+  pb->mutable_attr()->set_ssl(event.attr.ssl);
+  pb->mutable_attr()->set_source_fn(event.attr.source_fn);
+  pb->set_msg(event.msg.data(), event.msg.size());
+}
+
+void SocketControlEventToPB(const socket_control_event_t& event,
+                            sockeventpb::SocketControlEvent* pb) {
+  pb->set_type(event.type);
+  pb->set_timestamp_ns(event.timestamp_ns);
+  pb->mutable_conn_id()->set_pid(event.conn_id.upid.pid);
+  pb->mutable_conn_id()->set_start_time_ns(event.conn_id.upid.start_time_ticks);
+  pb->mutable_conn_id()->set_fd(event.conn_id.fd);
+  pb->mutable_conn_id()->set_generation(event.conn_id.tsid);
+  if (event.type == kConnOpen) {
+    pb->set_addr(&event.open.addr, sizeof(event.open.addr));
+    pb->set_role(event.open.role);
+  } else {
+    pb->set_wr_bytes(event.close.wr_bytes);
+    pb->set_rd_bytes(event.close.rd_bytes);
+  }
+}
+
+StatusOr<std::vector<sockeventpb::SocketEvent>> ReadSocketEvents(
+    const std::filesystem::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open()) {
+    return error::NotFound("Could not open socket events file $0.", path.string());
+  }
+  google::protobuf::io::IstreamInputStream input_stream(&in);
+
+  std::vector<sockeventpb::SocketEvent> events;
+  while (true) {
+    sockeventpb::SocketEvent event;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(&event, &input_stream,
+                                                                  &clean_eof)) {
+      if (clean_eof) {
+        break;
+      }
+      return error::InvalidArgument("Could not parse event $0 of $1, is it a binary capture?",
+                                    events.size(), path.string());
+    }
+    events.push_back(std::move(event));
+  }
+  return events;
+}
+
+std::string SocketEventReplayer::Stats::ToString() const {
+  std::string out = absl::Substitute(
+      "events=$0 ($1/s) records=$2 ($3/s) transfers=$4 wall_time=$5 cpu_time=$6 "
+      "peak_rss_growth_bytes=$7\n",
+      events, PerSecond(events, wall_time), records, PerSecond(records, wall_time), transfers,
+      PrettyDuration(wall_time.count()), PrettyDuration(cpu_time.count()), peak_rss_growth_bytes);
+  for (const auto& [protocol, protocol_stats] : protocols) {
+    if (protocol_stats.data_events == 0 && protocol_stats.transfer_cpu_time.count() == 0) {
+      continue;
+    }
+    absl::StrAppend(
+        &out, absl::Substitute("  $0: data_events=$1 data_bytes=$2 transfer_cpu=$3\n",
+                               magic_enum::enum_name(protocol), protocol_stats.data_events,
+                               protocol_stats.data_bytes,
+                               PrettyDuration(protocol_stats.transfer_cpu_time.count())));
+  }
+  for (const auto& [table, num_records] : records_by_table) {
+    absl::StrAppend(&out, absl::Substitute("  $0: records=$1\n", table, num_records));
+  }
+  return out;
+}
+
+SocketEventReplayer::SocketEventReplayer(SocketTraceConnector* connector, ConnectorContext* ctx,
+                                         std::vector<DataTable*> data_tables)
+    : connector_(connector), ctx_(ctx), data_tables_(std::move(data_tables)) {}
+
+SocketEventReplayer::Stats SocketEventReplayer::Replay(
+    const std::vector<sockeventpb::SocketEvent>& events, Pace pace) {
+  Stats stats;
+  if (events.empty()) {
+    return stats;
+  }
+
+  // Measure the CPU time of each protocol's transfers, by wrapping them for the duration of the
+  // replay.
+  connector_->transfer_wrapper_ = [&stats](TrafficProtocol protocol,
+                                           const std::function<void()>& transfer) {
+    auto start = ProcessCPUTime();
+    transfer();
+    stats.protocols[protocol].transfer_cpu_time += ProcessCPUTime() - start;
+  };
+  DEFER(connector_->transfer_wrapper_ = nullptr);
+
+  // The capture keeps its relative timing, but is moved to the clock of this process: it ends now
+  // when replayed at max speed, and starts now when replayed at the recorded pace, so that the
+  // events are never ahead of the cutoff times of the tables.
+  uint64_t first_ts = std::numeric_limits<uint64_t>::max();
+  uint64_t last_ts = 0;
+  for (const auto& event : events) {
+    first_ts = std::min(first_ts, TimestampOf(event));
+    last_ts = std::max(last_ts, TimestampOf(event));
+  }
+  uint64_t base_ts = connector_->AdjustedSteadyClockNowNS() - connector_->ClockRealTimeOffset();
+  if (pace == Pace::kMaxSpeed) {
+    base_ts -= last_ts - first_ts;
+  }
+
+  const uint64_t period_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(SocketTraceConnector::kSamplingPeriod)
+          .count();
+  uint64_t next_transfer_ts = first_ts + period_ns;
+
+  const int64_t start_rss = PeakRSSBytes();
+  const auto start_cpu_time = ProcessCPUTime();
+  const auto start_time = std::chrono::steady_clock::now();
+  for (const auto& event : events) {
+    uint64_t ts = TimestampOf(event);
+    if (pace == Pace::kRecorded) {
+      std::this_thread::sleep_until(start_time + std::chrono::nanoseconds(ts - first_ts));
+    }
+    // Idle gaps in the capture collapse into a single transfer.
+    if (ts >= next_transfer_ts) {
+      Transfer(&stats);
+      next_transfer_ts = ts - (ts - first_ts) % period_ns + period_ns;
+    }
+
+    uint64_t replay_ts = base_ts + (ts - first_ts);
+    if (event.has_data()) {
+      const auto& data = event.data();
+      ProtocolStats& protocol_stats =
+          stats.protocols[static_cast<TrafficProtocol>(data.attr().protocol())];
+      ++protocol_stats.data_events;
+      protocol_stats.data_bytes += data.msg().size();
+      connector_->AcceptDataEvent(
+          SocketDataEventView(DataEventAttrFromPB(data, replay_ts), data.msg()));
+    } else if (event.has_control()) {
+      connector_->AcceptControlEvent(ControlEventFromPB(event.control(), replay_ts));
+    }
+    ++stats.events;
+  }
+  Transfer(&stats);
+
+  stats.wall_time = std::chrono::steady_clock::now() - start_time;
+  stats.cpu_time = ProcessCPUTime() - start_cpu_time;
+  stats.peak_rss_growth_bytes = PeakRSSBytes() - start_rss;
+  return stats;
+}
+
+void SocketEventReplayer::Transfer(Stats* stats) {
+  connector_->TransferData(ctx_, data_tables_);
+  ++stats->transfers;
+  for (size_t i = 0; i < data_tables_.size(); ++i) {
+    if (data_tables_[i] == nullptr) {
+      continue;
+    }
+    for (const auto& record_batch : data_tables_[i]->ConsumeRecords()) {
+      uint64_t num_records = record_batch.records.empty() ? 0 : record_batch.records[0]->Size();
+      stats->records += num_records;
+      stats->records_by_table[std::string(SocketTraceConnector::kTables[i].name())] +=
+          num_records;
+      if (record_batch_callback_) {
+        record_batch_callback_(i, record_batch);
+      }
+    }
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
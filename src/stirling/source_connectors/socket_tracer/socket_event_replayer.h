@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/connector_context.h"
+#include "src/stirling/core/data_table.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+
+namespace px {
+namespace stirling {
+
+// The capture format of --perf_buffer_events_output_path.
+void SocketDataEventToPB(const SocketDataEventView& event, sockeventpb::SocketDataEvent* pb);
+void SocketControlEventToPB(const socket_control_event_t& event,
+                            sockeventpb::SocketControlEvent* pb);
+
+/**
+ * Reads the events that the socket tracer wrote to --perf_buffer_events_output_path, which must
+ * have been in binary format (ie. a path ending in '.bin').
+ */
+StatusOr<std::vector<sockeventpb::SocketEvent>> ReadSocketEvents(
+    const std::filesystem::path& path);
+
+/**
+ * SocketEventReplayer feeds captured socket events through a SocketTraceConnector, the way its
+ * BPF callbacks and TransferData() would, so that parsers, stitchers and the connection trackers
+ * can be measured without a kernel or live traffic.
+ *
+ * The connector doesn't need to be initialized (no BPF is deployed). TransferData() is called
+ * every sampling period of recorded time, whatever the pace of the replay, so replays of a capture
+ * are deterministic.
+ */
+class SocketEventReplayer {
+ public:
+  enum class Pace {
+    // Sends the events as fast as the connector takes them.
+    kMaxSpeed,
+    // Sends the events at the times they were captured at.
+    kRecorded,
+  };
+
+  struct ProtocolStats {
+    uint64_t data_events = 0;
+    uint64_t data_bytes = 0;
+    // The CPU time of the process (ie. all parse threads) spent transferring the protocol's
+    // connections to its table.
+    std::chrono::nanoseconds transfer_cpu_time{0};
+  };
+
+  struct Stats {
+    uint64_t events = 0;
+    uint64_t records = 0;
+    uint64_t transfers = 0;
+    std::chrono::nanoseconds wall_time{0};
+    std::chrono::nanoseconds cpu_time{0};
+    // How much the peak RSS of the process grew during the replay.
+    int64_t peak_rss_growth_bytes = 0;
+    std::map<TrafficProtocol, ProtocolStats> protocols;
+    std::map<std::string, uint64_t> records_by_table;
+
+    std::string ToString() const;
+  };
+
+  using RecordBatchCallback =
+      std::function<void(uint32_t table_num, const TaggedRecordBatch& record_batch)>;
+
+  /**
+   * @param data_tables the tables of the connector, indexed like SocketTraceConnector::kTables.
+   * Their records are consumed after every transfer.
+   */
+  SocketEventReplayer(SocketTraceConnector* connector, ConnectorContext* ctx,
+                      std::vector<DataTable*> data_tables);
+
+  // Called with the records that the replay produced, as they are consumed from the tables.
+  void set_record_batch_callback(RecordBatchCallback callback) {
+    record_batch_callback_ = std::move(callback);
+  }
+
+  Stats Replay(const std::vector<sockeventpb::SocketEvent>& events, Pace pace);
+
+ private:
+  void Transfer(Stats* stats);
+
+  SocketTraceConnector* connector_;
+  ConnectorContext* ctx_;
+  std::vector<DataTable*> data_tables_;
+  RecordBatchCallback record_batch_callback_;
+};
+
+}  // namespace stirling
+}  // namespace px
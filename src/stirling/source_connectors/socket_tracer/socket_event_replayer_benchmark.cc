@@ -0,0 +1,146 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <sys/socket.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/connector_context.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_event_replayer.h"
+
+// Replays socket events through the SocketTraceConnector, to measure the parsers, stitchers and
+// ConnTrackersManager together. Replays the capture at $PL_SOCKET_EVENTS_PATH (written with
+// --perf_buffer_events_output_path=<file>.bin) if set, and a synthetic HTTP capture otherwise.
+
+DEFINE_string(socket_events_path, gflags::StringFromEnv("PL_SOCKET_EVENTS_PATH", ""),
+              "The socket events capture to replay.");
+
+using px::stirling::ReadSocketEvents;
+using px::stirling::SocketControlEventToPB;
+using px::stirling::SocketDataEventToPB;
+using px::stirling::SocketDataEventView;
+using px::stirling::SocketEventReplayer;
+using px::stirling::SocketTraceConnector;
+using px::stirling::StandaloneContext;
+using px::stirling::sockeventpb::SocketEvent;
+
+namespace {
+
+constexpr std::string_view kHTTPReq =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.pixielabs.ai\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "\r\n";
+
+constexpr std::string_view kHTTPResp =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Content-Length: 3\r\n"
+    "\r\n"
+    "foo";
+
+// num_conns connections that each send num_reqs requests, one event per millisecond.
+std::vector<SocketEvent> SyntheticHTTPCapture(int num_conns, int num_reqs) {
+  std::vector<SocketEvent> events;
+  uint64_t ts = 1;
+  for (int c = 0; c < num_conns; ++c) {
+    struct conn_id_t conn_id = {};
+    conn_id.upid.pid = 1000 + c;
+    conn_id.upid.start_time_ticks = 1;
+    conn_id.fd = 3;
+    conn_id.tsid = 1;
+
+    socket_control_event_t open = {};
+    open.type = kConnOpen;
+    open.timestamp_ns = ts++ * 1000000;
+    open.conn_id = conn_id;
+    open.open.addr.sa.sa_family = AF_INET;
+    SocketControlEventToPB(open, events.emplace_back().mutable_control());
+
+    uint64_t send_pos = 0;
+    uint64_t recv_pos = 0;
+    for (int r = 0; r < num_reqs; ++r) {
+      for (auto [direction, msg, pos] : {std::make_tuple(kEgress, kHTTPReq, &send_pos),
+                                         std::make_tuple(kIngress, kHTTPResp, &recv_pos)}) {
+        socket_data_event_t::attr_t attr = {};
+        attr.timestamp_ns = ts++ * 1000000;
+        attr.conn_id = conn_id;
+        attr.protocol = kProtocolHTTP;
+        attr.role = kRoleClient;
+        attr.direction = direction;
+        attr.pos = *pos;
+        attr.msg_size = msg.size();
+        attr.msg_buf_size = msg.size();
+        *pos += msg.size();
+        SocketDataEventToPB(SocketDataEventView(attr, msg), events.emplace_back().mutable_data());
+      }
+    }
+
+    socket_control_event_t close = {};
+    close.type = kConnClose;
+    close.timestamp_ns = ts++ * 1000000;
+    close.conn_id = conn_id;
+    close.close.wr_bytes = send_pos;
+    close.close.rd_bytes = recv_pos;
+    SocketControlEventToPB(close, events.emplace_back().mutable_control());
+  }
+  return events;
+}
+
+const std::vector<SocketEvent>& Capture() {
+  static const auto* const kCapture = new std::vector<SocketEvent>(
+      FLAGS_socket_events_path.empty() ? SyntheticHTTPCapture(100, 100)
+                                       : ReadSocketEvents(FLAGS_socket_events_path).ValueOrDie());
+  return *kCapture;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void BM_ReplayMaxSpeed(benchmark::State& state) {
+  FLAGS_stirling_check_proc_for_conn_close = false;
+  const auto& events = Capture();
+  SocketEventReplayer::Stats stats;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto connector = SocketTraceConnector::Create("socket_trace_connector");
+    StandaloneContext ctx;
+    std::vector<std::unique_ptr<px::stirling::DataTable>> tables;
+    std::vector<px::stirling::DataTable*> table_ptrs;
+    for (const auto& schema : SocketTraceConnector::kTables) {
+      tables.push_back(std::make_unique<px::stirling::DataTable>(tables.size(), schema));
+      table_ptrs.push_back(tables.back().get());
+    }
+    SocketEventReplayer replayer(static_cast<SocketTraceConnector*>(connector.get()), &ctx,
+                                 table_ptrs);
+    state.ResumeTiming();
+
+    stats = replayer.Replay(events, SocketEventReplayer::Pace::kMaxSpeed);
+  }
+  state.SetItemsProcessed(state.iterations() * stats.events);
+  state.counters["records"] = stats.records;
+  state.counters["peak_rss_growth_bytes"] = stats.peak_rss_growth_bytes;
+}
+
+BENCHMARK(BM_ReplayMaxSpeed)->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/socket_event_replayer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
+#include "src/stirling/testing/common.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+
+constexpr std::string_view kReq =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.pixielabs.ai\r\n"
+    "\r\n";
+
+constexpr std::string_view kResp =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 3\r\n"
+    "\r\n"
+    "foo";
+
+class SocketEventReplayerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FLAGS_stirling_check_proc_for_conn_close = false;
+    connector_ = SocketTraceConnector::Create("socket_trace_connector");
+    ctx_ = std::make_unique<StandaloneContext>();
+    data_tables_ = std::make_unique<testing::DataTables>(SocketTraceConnector::kTables);
+  }
+
+  // Captures an HTTP request and response, the way --perf_buffer_events_output_path does.
+  std::filesystem::path WriteCapture() {
+    testing::EventGenerator event_gen(&clock_);
+    std::vector<sockeventpb::SocketEvent> events(4);
+    SocketControlEventToPB(event_gen.InitConn(), events[0].mutable_control());
+    SocketDataEventToPB(SocketDataEventView(*event_gen.InitSendEvent<kProtocolHTTP>(kReq)),
+                        events[1].mutable_data());
+    SocketDataEventToPB(SocketDataEventView(*event_gen.InitRecvEvent<kProtocolHTTP>(kResp)),
+                        events[2].mutable_data());
+    SocketControlEventToPB(event_gen.InitClose(), events[3].mutable_control());
+
+    std::filesystem::path path = temp_dir_.path() / "events.bin";
+    std::ofstream out(path, std::ios::binary);
+    for (const auto& event : events) {
+      google::protobuf::util::SerializeDelimitedToOstream(event, &out);
+    }
+    return path;
+  }
+
+  testing::MockClock clock_;
+  px::testing::TempDir temp_dir_;
+  std::unique_ptr<SourceConnector> connector_;
+  std::unique_ptr<StandaloneContext> ctx_;
+  std::unique_ptr<testing::DataTables> data_tables_;
+};
+
+TEST_F(SocketEventReplayerTest, replays_capture_into_records) {
+  ASSERT_OK_AND_ASSIGN(auto events, ReadSocketEvents(WriteCapture()));
+  ASSERT_EQ(4, events.size());
+
+  SocketEventReplayer replayer(static_cast<SocketTraceConnector*>(connector_.get()), ctx_.get(),
+                               data_tables_->tables());
+  std::vector<std::string> resp_bodies;
+  replayer.set_record_batch_callback([&](uint32_t table_num, const TaggedRecordBatch& rb) {
+    if (table_num != SocketTraceConnector::kHTTPTableNum) {
+      return;
+    }
+    for (size_t i = 0; i < rb.records[kHTTPRespBodyIdx]->Size(); ++i) {
+      resp_bodies.push_back(rb.records[kHTTPRespBodyIdx]->Get<types::StringValue>(i));
+    }
+  });
+  SocketEventReplayer::Stats stats =
+      replayer.Replay(events, SocketEventReplayer::Pace::kMaxSpeed);
+
+  EXPECT_THAT(resp_bodies, ElementsAre("foo"));
+  EXPECT_EQ(4, stats.events);
+  EXPECT_EQ(1, stats.records_by_table["http_events"]);
+  EXPECT_EQ(2, stats.protocols[kProtocolHTTP].data_events);
+  EXPECT_EQ(kReq.size() + kResp.size(), stats.protocols[kProtocolHTTP].data_bytes);
+}
+
+TEST_F(SocketEventReplayerTest, rejects_text_capture) {
+  std::filesystem::path path = temp_dir_.path() / "events.txt";
+  std::ofstream(path) << "data { msg: \"GET\" }\n";
+  EXPECT_NOT_OK(ReadSocketEvents(path));
+}
+
+}  // namespace stirling
+}  // namespace px
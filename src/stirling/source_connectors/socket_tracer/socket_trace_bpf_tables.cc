@@ -18,6 +18,8 @@
 
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 
+#include <arpa/inet.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
@@ -45,7 +47,11 @@ namespace stirling {
 ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc)
     : conn_info_map_(bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
       conn_disabled_map_(bcc->GetHashTable<uint64_t, uint64_t>("conn_disabled_map")),
-      open_file_map_(bcc->GetHashTable<uint64_t, uint64_t>("open_file_map")) {
+      open_file_map_(bcc->GetHashTable<uint64_t, uint64_t>("open_file_map")),
+      known_endpoints_map_(
+          bcc->GetHashTable<struct known_endpoint_key_t, struct known_endpoint_t>(
+              kKnownEndpointsMapName)),
+      conn_info_map_mirror_(&conn_info_map_) {
   // Use address instead of symbol to specify this probe,
   // so that even if debug symbols are stripped, the uprobe can still attach.
   uint64_t symbol_addr = reinterpret_cast<uint64_t>(&ConnInfoMapCleanupTrigger);
@@ -78,32 +84,27 @@ void ConnInfoMapManager::Disable(struct conn_id_t conn_id) {
   }
 }
 
+void ConnInfoMapManager::AddKnownEndpoint(const struct known_endpoint_key_t& key,
+                                          const struct known_endpoint_t& value) {
+  if (!known_endpoints_map_.update_value(key, value).ok()) {
+    VLOG(1) << absl::Substitute("Updating known_endpoints_map entry failed: tgid=$0 port=$1",
+                                key.upid.tgid, ntohs(key.port));
+  }
+}
+
 void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
   const auto& sysconfig = system::Config::GetInstance();
 
-  for (const auto& [pid_fd, conn_info] : conn_info_map_.get_table_offline()) {
-    uint32_t pid = pid_fd >> 32;
-    int32_t fd = pid_fd;
-
-    // Check conn trackers to see if it's already tracked.
-    // This is a performance optimization to avoid accessing /proc when not required.
-    if (conn_trackers_mgr->GetConnTracker(pid, fd).ok()) {
-      continue;
-    }
-
-    std::filesystem::path fd_file =
-        sysconfig.proc_path() / std::to_string(pid) / "fd" / std::to_string(fd);
-
-    if (fs::Exists(fd_file).ok()) {
-      continue;
+  // A connection whose entry changed since the last cleanup still has traffic, so only the new
+  // and the unchanged entries can be leaks.
+  const auto& diff = conn_info_map_mirror_.Sync();
+  for (const std::vector<uint64_t>* keys : {&diff.added, &diff.unchanged}) {
+    for (uint64_t pid_fd : *keys) {
+      CheckConnInfoMapLeak(pid_fd, *conn_info_map_mirror_.Find(pid_fd), conn_trackers_mgr);
     }
-
-    ReleaseResources(conn_info.conn_id);
-    VLOG(1) << absl::Substitute("Found conn_info_map leak: pid=$0 fd=$1 af=$2", pid, fd,
-                                conn_info.addr.sa.sa_family);
   }
 
-  for (const auto& [pid_fd, _] : open_file_map_.get_table_offline()) {
+  for (const auto& [pid_fd, _] : bpf_tools::ReadHashTable(&open_file_map_)) {
     uint32_t pid = pid_fd >> 32;
     int32_t fd = pid_fd;
 
@@ -119,5 +120,28 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
   }
 }
 
+void ConnInfoMapManager::CheckConnInfoMapLeak(uint64_t pid_fd, const struct conn_info_t& conn_info,
+                                              ConnTrackersManager* conn_trackers_mgr) {
+  uint32_t pid = pid_fd >> 32;
+  int32_t fd = pid_fd;
+
+  // Check conn trackers to see if it's already tracked.
+  // This is a performance optimization to avoid accessing /proc when not required.
+  if (conn_trackers_mgr->GetConnTracker(pid, fd).ok()) {
+    return;
+  }
+
+  std::filesystem::path fd_file = system::Config::GetInstance().proc_path() /
+                                  std::to_string(pid) / "fd" / std::to_string(fd);
+
+  if (fs::Exists(fd_file).ok()) {
+    return;
+  }
+
+  ReleaseResources(conn_info.conn_id);
+  VLOG(1) << absl::Substitute("Found conn_info_map leak: pid=$0 fd=$1 af=$2", pid, fd,
+                              conn_info.addr.sa.sa_family);
+}
+
 }  // namespace stirling
 }  // namespace px
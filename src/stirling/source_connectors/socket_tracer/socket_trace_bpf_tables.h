@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/bpf_tools/bpf_map.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 
 DECLARE_uint32(stirling_conn_map_cleanup_threshold);
@@ -40,12 +41,25 @@ class ConnInfoMapManager {
 
   void Disable(struct conn_id_t conn_id);
 
+  // Records the protocol and role of the connections of the endpoint (see
+  // ConnTracker::KnownEndpointKey()), so that BPF skips protocol inference on new ones.
+  void AddKnownEndpoint(const struct known_endpoint_key_t& key,
+                        const struct known_endpoint_t& value);
+
   void CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr);
 
  private:
   ebpf::BPFHashTable<uint64_t, struct conn_info_t> conn_info_map_;
   ebpf::BPFHashTable<uint64_t, uint64_t> conn_disabled_map_;
   ebpf::BPFHashTable<uint64_t, uint64_t> open_file_map_;
+  ebpf::BPFHashTable<struct known_endpoint_key_t, struct known_endpoint_t> known_endpoints_map_;
+
+  // The conn_info_map as of the last leak cleanup.
+  bpf_tools::BPFMapMirror<uint64_t, struct conn_info_t> conn_info_map_mirror_;
+
+  // Releases the BPF resources of the connection, if its process has closed it.
+  void CheckConnInfoMapLeak(uint64_t pid_fd, const struct conn_info_t& conn_info,
+                            ConnTrackersManager* conn_trackers_mgr);
 
   std::vector<struct conn_id_t> pending_release_queue_;
 
@@ -21,11 +21,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <optional>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/strings/ascii.h>
+#include <absl/strings/escaping.h>
 #include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/delimited_message_util.h>
 #include <magic_enum.hpp>
@@ -40,8 +48,10 @@
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 #include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/body_capture.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/grpc.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_event_replayer.h"
 #include "src/stirling/utils/proc_path_tools.h"
 
 // 50 X less often than the normal sampling frequency. Based on the conn_stats_table.h's
@@ -49,6 +59,14 @@
 DEFINE_uint32(
     stirling_conn_stats_sampling_ratio, 50,
     "Ratio of how frequently conn_stats_table is populated relative to the base sampling period");
+DEFINE_uint32(stirling_conn_stats_heartbeat_secs, 60,
+              "conn_stats_table records a connection only when its stats change, and at this "
+              "interval while they don't. Set to 0 to never record idle connections again.");
+DEFINE_bool(stirling_enable_http_stats, false,
+            "If true, populates http_stats_table with HTTP request rate, error and latency "
+            "metrics, aggregated per endpoint over each window.");
+DEFINE_uint32(stirling_http_stats_window_secs, 10,
+              "The aggregation window of http_stats_table, in seconds.");
 // The default frequency logs every minute, since each iteration has a cycle period of 200ms.
 DEFINE_uint32(
     stirling_socket_tracer_stats_logging_ratio,
@@ -58,14 +76,23 @@ DEFINE_uint32(
 DEFINE_bool(stirling_enable_periodic_bpf_map_cleanup, true,
             "Disable periodic BPF map cleanup (for testing)");
 
+DEFINE_bool(stirling_enable_proc_events, true,
+            "If true, new and terminated processes are learned from the sched_process_exec/exit "
+            "tracepoints, and the full set of UPIDs is only used for periodic reconciliation.");
+
+DEFINE_bool(stirling_perf_buffer_drain_thread, false,
+            "If true, a dedicated thread drains the perf and ring buffers as events arrive, "
+            "instead of only on each iteration, so bursts of events don't overflow them.");
+
 DEFINE_int32(test_only_socket_trace_target_pid, kTraceAllTGIDs, "The process to trace.");
 // TODO(yzhao): If we ever need to write all events from different perf buffers, then we need either
 // write to different files for individual perf buffers, or create a protobuf message with an oneof
 // field to include all supported message types.
 DEFINE_string(perf_buffer_events_output_path, "",
               "If not empty, specifies the path & format to a file to which the socket tracer "
-              "writes data events. If the filename ends with '.bin', the events are serialized in "
-              "binary format; otherwise, text format.");
+              "writes data and control events. If the filename ends with '.bin', the events are "
+              "serialized in binary format, which stirling_replay can replay; otherwise, text "
+              "format.");
 
 // PROTOCOL_LIST: Requires update on new protocols.
 DEFINE_bool(stirling_enable_http_tracing, true,
@@ -82,6 +109,25 @@ DEFINE_bool(stirling_enable_dns_tracing, true,
             "If true, stirling will trace and process DNS messages.");
 DEFINE_bool(stirling_enable_redis_tracing, true,
             "If true, stirling will trace and process Redis messages.");
+DEFINE_bool(stirling_enable_kafka_tracing, true,
+            "If true, stirling will trace and process Kafka messages.");
+
+DEFINE_bool(stirling_use_bpf_ring_buffers, true,
+            "If true, and the kernel supports them (5.8+), socket data and control events are "
+            "sent to user-space through BPF ring buffers instead of perf buffers.");
+
+DEFINE_string(stirling_bpf_payload_prefix_limits, "",
+              "Comma-separated <protocol>:<bytes> pairs, e.g. 'HTTP:16384,MySQL:4096'. BPF only "
+              "sends the first <bytes> of each traced syscall's data of the protocol to "
+              "user-space, and reports the size of the rest, which parsers step over. "
+              "Protocols without a limit send all of the data.");
+
+DEFINE_string(stirling_bpf_rate_limits, "",
+              "Comma-separated <protocol>:<events_per_sec>[:<burst>] limits, e.g. "
+              "'HTTP:1000,Redis:500:2000'. BPF sends at most <events_per_sec> data events per "
+              "second of each process for the protocol to user-space, with bursts of up to <burst> "
+              "events (by default, <events_per_sec>). The suppressed events are counted in the "
+              "events_suppressed column of conn_stats.");
 
 DEFINE_bool(stirling_disable_self_tracing, true,
             "If true, stirling will not trace and process syscalls made by itself.");
@@ -92,6 +138,22 @@ DEFINE_uint32(messages_size_limit_bytes, 1024 * 1024,
               "The limit of the size of the parsed messages, not the BPF events, "
               "for each direction, of each connection tracker. "
               "All cached messages are erased if this limit is breached.");
+DEFINE_uint64(stirling_conn_trackers_memory_budget_bytes, 512 * 1024 * 1024,
+              "The limit of the memory held by the raw events and the parsed messages buffered "
+              "by all connection trackers together. Past the limit, the buffered data of the "
+              "least recently active connections is erased; as the limit nears, messages expire "
+              "sooner than --messages_expiration_duration_secs. 0 disables the limit.");
+
+DEFINE_uint32(stirling_socket_tracer_parse_threads, 4,
+              "The maximum number of threads that parse and stitch the connections of a protocol "
+              "in each iteration. Only iterations with many connections use more than one. Read "
+              "when the connector is created.");
+
+DEFINE_bool(stirling_grpc_body_to_text, true,
+            "If true, gRPC bodies are converted to text format protobuf in the req_body and "
+            "resp_body columns of http_events. If false, those columns are left empty for gRPC, "
+            "which saves the conversion on gRPC heavy nodes; queries can still convert the "
+            "req_body_raw and resp_body_raw columns with px.grpc_body_to_text().");
 
 BPF_SRC_STRVIEW(socket_trace_bcc_script, socket_trace);
 
@@ -104,12 +166,27 @@ using ::px::utils::ToJSONString;
 SocketTraceConnector::SocketTraceConnector(std::string_view source_name)
     : SourceConnector(source_name, kTables), conn_stats_(&conn_trackers_mgr_), uprobe_mgr_(this) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
+  fd_link_cache_ = std::make_unique<FDLinkCache>(proc_parser_.get());
+  // The thread of TransferData() parses along with the pool's threads.
+  parse_pool_ = std::make_unique<WorkerPool>(
+      std::max<uint32_t>(FLAGS_stirling_socket_tracer_parse_threads, 1) - 1);
   InitProtocolTransferSpecs();
+  poll_perf_buffers_probe_ =
+      utils::PerfStats::GetInstance().GetProbe(absl::StrCat(name(), ".poll_perf_buffers"));
+}
+
+SocketTraceConnector::~SocketTraceConnector() {
+  auto& perf_stats = utils::PerfStats::GetInstance();
+  perf_stats.ReleaseProbe(poll_perf_buffers_probe_);
+  for (const ProtocolProbes& probes : protocol_probes_) {
+    perf_stats.ReleaseProbe(probes.parse);
+    perf_stats.ReleaseProbe(probes.stitch);
+  }
 }
 
 void SocketTraceConnector::InitProtocolTransferSpecs() {
 #define TRANSFER_STREAM_PROTOCOL(protocol_name) \
-  &SocketTraceConnector::TransferStream<protocols::protocol_name::ProtocolTraits>
+  &SocketTraceConnector::TransferStreams<protocols::protocol_name::ProtocolTraits>
 
   // PROTOCOL_LIST: Requires update on new protocols.
 
@@ -152,10 +229,10 @@ void SocketTraceConnector::InitProtocolTransferSpecs() {
       // mongo in the future.
       {kProtocolMongo,
        TransferSpec{false, kHTTPTableNum, {kRoleUnknown, kRoleClient, kRoleServer}, nullptr}},
-      // TODO(chengruizhe): Add Kafka table. nullptr should be replaced by the transfer_fn for
-      // kafka in the future.
-      {kProtocolKafka,
-       TransferSpec{false, kHTTPTableNum, {kRoleUnknown, kRoleClient, kRoleServer}, nullptr}},
+      {kProtocolKafka, TransferSpec{FLAGS_stirling_enable_kafka_tracing,
+                                    kKafkaTableNum,
+                                    {kRoleClient, kRoleServer},
+                                    TRANSFER_STREAM_PROTOCOL(kafka)}},
       {kProtocolUnknown, TransferSpec{false /*enabled*/,
                                       // Unknown protocols attached to HTTP table so that they run
                                       // their cleanup functions, but the use of nullptr transfer_fn
@@ -172,9 +249,32 @@ void SocketTraceConnector::InitProtocolTransferSpecs() {
     DCHECK(transfer_specs_by_protocol.contains(TrafficProtocol(i))) << absl::Substitute(
         "Protocol $0 is not mapped in transfer_specs_by_protocol.", TrafficProtocol(i));
     protocol_transfer_specs_.push_back(transfer_specs_by_protocol[TrafficProtocol(i)]);
+
+    // E.g. socket_tracer.http.parse for kProtocolHTTP.
+    std::string probe_prefix = absl::StrCat(
+        name(), ".",
+        absl::AsciiStrToLower(absl::StripPrefix(
+            magic_enum::enum_name(static_cast<TrafficProtocol>(i)), "kProtocol")));
+    auto& perf_stats = utils::PerfStats::GetInstance();
+    protocol_probes_.push_back({perf_stats.GetProbe(absl::StrCat(probe_prefix, ".parse")),
+                                perf_stats.GetProbe(absl::StrCat(probe_prefix, ".stitch"))});
   }
 }
 
+namespace {
+
+// A ring buffer is shared by all CPUs, so it is sized as a few per-CPU perf buffers,
+// rather than as one perf buffer per CPU.
+constexpr int64_t kRingBufferToPerfBufferSizeRatio = 4;
+
+int64_t RingBufferPages(int64_t perf_buffer_size_bytes) {
+  const int64_t page_size = system::Config::GetInstance().PageSize();
+  return IntRoundUpToPow2(
+      IntRoundUpDivide(kRingBufferToPerfBufferSizeRatio * perf_buffer_size_bytes, page_size));
+}
+
+}  // namespace
+
 Status SocketTraceConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
@@ -186,13 +286,48 @@ Status SocketTraceConnector::InitImpl() {
         "timestamps in a way that matches how /proc/stat does it");
   }
 
-  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script));
+  // Data and control events go through ring buffers where supported, and fall back to perf
+  // buffers otherwise.
+  const bool use_ring_buffers =
+      FLAGS_stirling_use_bpf_ring_buffers && bpf_tools::BCCWrapper::SupportsRingBuffers();
+  auto perf_buffer_specs = kPerfBufferSpecs;
+  std::vector<std::string> cflags = {absl::StrCat("-DUSE_RINGBUF=", use_ring_buffers ? 1 : 0)};
+  if (use_ring_buffers) {
+    for (auto& spec : perf_buffer_specs) {
+      if (spec.name == "socket_data_events" || spec.name == "socket_control_events") {
+        spec.transport = bpf_tools::BPFOutputTransport::kRingBuffer;
+        cflags.push_back(absl::Substitute("-D$0_RINGBUF_PAGES=$1", absl::AsciiStrToUpper(spec.name),
+                                          RingBufferPages(spec.size_bytes)));
+      }
+    }
+  }
+  LOG(INFO) << absl::Substitute("Using BPF $0 for socket data and control events.",
+                                use_ring_buffers ? "ring buffers" : "perf buffers");
+
+  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script, cflags));
   PL_RETURN_IF_ERROR(AttachKProbes(kProbeSpecs));
   LOG(INFO) << absl::Substitute("Number of kprobes deployed = $0", kProbeSpecs.size());
   LOG(INFO) << "Probes successfully deployed.";
 
-  PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
-  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", kPerfBufferSpecs.size());
+  if (FLAGS_stirling_enable_proc_events) {
+    Status s;
+    for (const auto& spec : kTracepointSpecs) {
+      s = AttachTracepoint(spec);
+      if (!s.ok()) {
+        break;
+      }
+    }
+    proc_events_enabled_ = s.ok();
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+        "Process event tracepoints could not be attached, falling back to UPID listings: $0",
+        s.msg());
+  }
+
+  PL_RETURN_IF_ERROR(OpenPerfBuffers(perf_buffer_specs, this));
+  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", perf_buffer_specs.size());
+  if (FLAGS_stirling_perf_buffer_drain_thread) {
+    PL_RETURN_IF_ERROR(StartPerfBufferDrainThread());
+  }
 
   // Set trace role to BPF probes.
   for (const auto& p : TrafficProtocolEnumValues()) {
@@ -205,6 +340,8 @@ Status SocketTraceConnector::InitImpl() {
     }
   }
 
+  PL_RETURN_IF_ERROR(UpdateBPFPayloadPrefixLimits(FLAGS_stirling_bpf_payload_prefix_limits));
+  PL_RETURN_IF_ERROR(UpdateBPFRateLimits(FLAGS_stirling_bpf_rate_limits));
   PL_RETURN_IF_ERROR(TestOnlySetTargetPID(FLAGS_test_only_socket_trace_target_pid));
   if (FLAGS_stirling_disable_self_tracing) {
     PL_RETURN_IF_ERROR(DisableSelfTracing());
@@ -233,7 +370,7 @@ Status SocketTraceConnector::InitImpl() {
 }
 
 void SocketTraceConnector::InitContextImpl(ConnectorContext* ctx) {
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs(), ctx->GetUPIDsEpoch());
 
   // On the first context, we want to make sure all uprobes deploy before returning.
   if (thread.joinable()) {
@@ -258,7 +395,7 @@ Status SocketTraceConnector::StopImpl() {
 }
 
 std::thread SocketTraceConnector::RunDeployUProbesThread(
-    const absl::flat_hash_set<md::UPID>& pids) {
+    const absl::flat_hash_set<md::UPID>& pids, uint64_t epoch) {
   // The check that state is not uninitialized is required for socket_trace_connector_test,
   // which would otherwise try to deploy uprobes (for which it does not have permissions).
   // Also, we check that there is no other previous thread still running.
@@ -269,7 +406,32 @@ std::thread SocketTraceConnector::RunDeployUProbesThread(
   //               deployment will become asynchronous to TransferData(), and this may
   //               lead to non-determinism.
   if (state() != State::kUninitialized && !uprobe_mgr_.ThreadsRunning()) {
-    return uprobe_mgr_.RunDeployUProbesThread(pids);
+    return uprobe_mgr_.RunDeployUProbesThread(pids, epoch);
+  }
+  return {};
+}
+
+std::thread SocketTraceConnector::RunDeployUProbesFromContextThread(ConnectorContext* ctx) {
+  // See RunDeployUProbesThread() for the conditions.
+  if (state() == State::kUninitialized || uprobe_mgr_.ThreadsRunning()) {
+    return {};
+  }
+  std::optional<UPIDDelta> delta = ctx->GetUPIDsDelta(uprobe_mgr_.upids_epoch());
+  if (!delta.has_value()) {
+    return uprobe_mgr_.RunDeployUProbesThread(ctx->GetUPIDs(), ctx->GetUPIDsEpoch());
+  }
+  if (delta->added.empty() && delta->removed.empty()) {
+    return {};
+  }
+  return uprobe_mgr_.RunDeployUProbesFromDeltaThread(std::move(delta->added),
+                                                     std::move(delta->removed),
+                                                     ctx->GetUPIDsEpoch());
+}
+
+std::thread SocketTraceConnector::RunDeployUProbesFromProcEventsThread(uint32_t asid) {
+  // See RunDeployUProbesThread() for the conditions.
+  if (state() != State::kUninitialized && !uprobe_mgr_.ThreadsRunning()) {
+    return uprobe_mgr_.RunDeployUProbesFromProcEventsThread(asid);
   }
   return {};
 }
@@ -319,8 +481,7 @@ std::string DumpBPFMapInfo(bpf_tools::BCCWrapper* bcc) {
   PrintBPFMapInfo(http2_symaddrs_map, "http2_symaddrs_map", &out);
 
   auto active_write_headers_frame_map =
-      bcc->GetHashTable<void*, struct go_grpc_http2_header_event_t::header_attr_t>(
-          "active_write_headers_frame_map");
+      bcc->GetHashTable<void*, struct header_attr_t>("active_write_headers_frame_map");
   PrintBPFMapInfo(active_write_headers_frame_map, "active_write_headers_frame_map", &out);
 
   auto conn_info_map = bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map");
@@ -369,7 +530,16 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // so raw data will be pushed to connection trackers more aggressively.
   // No data is lost, but this is a side-effect of sorts that affects timing of transfers.
   // It may be worth noting during debug.
-  PollPerfBuffers();
+  {
+    utils::ScopedPerfTimer timer(poll_perf_buffers_probe_);
+    PollPerfBuffers();
+  }
+
+  // Pass the process events on, so that the metadata only re-reads the affected containers.
+  for (uint32_t pid : changed_pids_) {
+    ctx->NotifyPIDChanged(pid);
+  }
+  changed_pids_.clear();
 
   // Set-up current state for connection inference purposes.
   if (socket_info_mgr_ != nullptr) {
@@ -377,7 +547,21 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   }
 
   // Deploy uprobes on newly discovered PIDs.
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  // With process events, the new PIDs are known without diffing the context's UPIDs, which are
+  // then only used periodically (or after lost events) to reconcile against missed events.
+  // Without them, the new PIDs come from the changes of the context's UPIDs since the last
+  // deployment, when those are versioned.
+  constexpr auto kProcReconcilePeriod = std::chrono::seconds(10);
+  constexpr int kProcReconcileSamplingRatio = kProcReconcilePeriod / kSamplingPeriod;
+  std::thread thread;
+  if (!proc_events_enabled_) {
+    thread = RunDeployUProbesFromContextThread(ctx);
+  } else if (uprobe_mgr_.TakeProcEventsLost() ||
+             sampling_freq_mgr_.count() % kProcReconcileSamplingRatio == 0) {
+    thread = RunDeployUProbesThread(ctx->GetUPIDs(), ctx->GetUPIDsEpoch());
+  } else {
+    thread = RunDeployUProbesFromProcEventsThread(ctx->GetASID());
+  }
   // Let it run in the background.
   if (thread.joinable()) {
     thread.detach();
@@ -418,6 +602,12 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     TransferConnStats(ctx, conn_stats_table);
   }
 
+  DataTable* http_stats_table = data_tables[kHTTPStatsTableNum];
+  http_stats_enabled_ = FLAGS_stirling_enable_http_stats && http_stats_table != nullptr;
+  if (http_stats_enabled_) {
+    TransferHTTPStats(http_stats_table);
+  }
+
   // This first >0 condition prevents the logging at the beginning, which accesses BPF maps.
   // Accessing BPF maps would require deploying BPF maps, that is not possible in all tests.
   const bool maps_ready = sampling_freq_mgr_.count() > 0;
@@ -428,6 +618,7 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     conn_trackers_mgr_.ComputeProtocolStats();
     LOG(INFO) << "ConnTracker statistics: " << conn_trackers_mgr_.StatsString();
     LOG(INFO) << "SocketTracer statistics: " << stats_.Print();
+    LOG(INFO) << "UProbeManager statistics: " << uprobe_mgr_.StatsString();
     LOG(INFO) << "Context: " << DumpContext(ctx);
     LOG(INFO) << "BPF map info: " << DumpBPFMapInfo(static_cast<BCCWrapper*>(this));
   }
@@ -438,27 +629,49 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     DataTable* data_table = data_tables[i];
 
     // Ensure records are within the time window, in order to ensure the order between record
-    // batches. Exception: conn_stats table does not need cutoff time, because its timestamps
-    // are assigned artificially.
-    if (i != kConnStatsTableNum && data_table != nullptr) {
+    // batches. Exception: conn_stats and http_stats tables do not need cutoff time, because
+    // their timestamps are assigned artificially.
+    if (i != kConnStatsTableNum && i != kHTTPStatsTableNum && data_table != nullptr) {
       data_table->SetConsumeRecordsCutoffTime(perf_buffer_drain_time_);
     }
   }
 
+  // The trackers are grouped by protocol, so the trackers of each protocol can be transferred
+  // together, and parsed in parallel.
+  std::vector<std::vector<ConnTracker*>> trackers_by_protocol(protocol_transfer_specs_.size());
+  fd_link_cache_->NewIteration();
   for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
-    const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
-    DataTable* data_table = data_tables[transfer_spec.table_num];
+    auto& protocol_trackers = trackers_by_protocol[conn_tracker->protocol()];
 
     UpdateTrackerTraceLevel(conn_tracker);
 
-    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
+    conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, fd_link_cache_.get(),
                                    socket_info_mgr_.get());
-    if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
-      transfer_spec.transfer_fn(*this, ctx, conn_tracker, data_table);
+    protocol_trackers.push_back(conn_tracker);
+  }
+
+  for (size_t protocol = 0; protocol < trackers_by_protocol.size(); ++protocol) {
+    const auto& transfer_spec = protocol_transfer_specs_[protocol];
+    DataTable* data_table = data_tables[transfer_spec.table_num];
+    const auto& protocol_trackers = trackers_by_protocol[protocol];
+
+    if (transfer_spec.enabled && transfer_spec.transfer_fn != nullptr && data_table != nullptr &&
+        !protocol_trackers.empty()) {
+      if (transfer_wrapper_) {
+        transfer_wrapper_(static_cast<TrafficProtocol>(protocol), [&]() {
+          (this->*transfer_spec.transfer_fn)(ctx, protocol_trackers, data_table);
+        });
+      } else {
+        (this->*transfer_spec.transfer_fn)(ctx, protocol_trackers, data_table);
+      }
+    }
+    for (ConnTracker* conn_tracker : protocol_trackers) {
+      conn_tracker->IterationPostTick();
     }
-    conn_tracker->IterationPostTick();
   }
 
+  conn_trackers_mgr_.EnforceMemoryBudget(FLAGS_stirling_conn_trackers_memory_budget_bytes);
+
   // Once we've cleared all the debug trace levels for this pid, we can remove it from the list.
   pids_to_trace_disable_.clear();
 }
@@ -480,6 +693,68 @@ Status SocketTraceConnector::UpdateBPFProtocolTraceRole(TrafficProtocol protocol
   return UpdatePerCPUArrayValue(static_cast<int>(protocol), role_mask, &control_map_handle);
 }
 
+Status SocketTraceConnector::UpdateBPFPayloadPrefixLimits(std::string_view limits) {
+  auto limit_map_handle = GetPerCPUArrayTable<uint64_t>(kPayloadPrefixLimitMapName);
+  for (std::string_view limit_spec : absl::StrSplit(limits, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> fields = absl::StrSplit(limit_spec, ':');
+    uint64_t limit = 0;
+    std::optional<TrafficProtocol> protocol;
+    if (fields.size() == 2) {
+      protocol = magic_enum::enum_cast<TrafficProtocol>(
+          absl::StrCat("kProtocol", absl::StripAsciiWhitespace(fields[0])));
+    }
+    if (!protocol.has_value() || protocol.value() == kProtocolUnknown ||
+        protocol.value() == kNumProtocols ||
+        !absl::SimpleAtoi(absl::StripAsciiWhitespace(fields[1]), &limit)) {
+      return error::InvalidArgument(
+          "Invalid payload prefix limit '$0', expected <protocol>:<bytes>", limit_spec);
+    }
+    PL_RETURN_IF_ERROR(UpdatePerCPUArrayValue(static_cast<int>(protocol.value()), limit,
+                                              &limit_map_handle));
+    LOG(INFO) << absl::Substitute("BPF payload prefix limit of $0 is $1 bytes.",
+                                  magic_enum::enum_name(protocol.value()), limit);
+  }
+  return Status::OK();
+}
+
+Status SocketTraceConnector::UpdateBPFProtocolRateLimit(TrafficProtocol protocol,
+                                                        uint64_t events_per_sec, uint64_t burst) {
+  // Keeps the capacity of the bucket, burst * 1e9 / events_per_sec nanoseconds, from overflowing.
+  constexpr uint64_t kMaxBurst = 1'000'000'000;
+  rate_limit_config_t config = {};
+  config.events_per_sec = events_per_sec;
+  config.burst = std::clamp<uint64_t>(burst, 1, kMaxBurst);
+  auto config_map_handle = GetPerCPUArrayTable<rate_limit_config_t>(kRateLimitConfigMapName);
+  return UpdatePerCPUArrayValue(static_cast<int>(protocol), config, &config_map_handle);
+}
+
+Status SocketTraceConnector::UpdateBPFRateLimits(std::string_view limits) {
+  for (std::string_view limit_spec : absl::StrSplit(limits, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> fields = absl::StrSplit(limit_spec, ':');
+    uint64_t events_per_sec = 0;
+    std::optional<TrafficProtocol> protocol;
+    if (fields.size() == 2 || fields.size() == 3) {
+      protocol = magic_enum::enum_cast<TrafficProtocol>(
+          absl::StrCat("kProtocol", absl::StripAsciiWhitespace(fields[0])));
+    }
+    if (!protocol.has_value() || protocol.value() == kProtocolUnknown ||
+        protocol.value() == kNumProtocols ||
+        !absl::SimpleAtoi(absl::StripAsciiWhitespace(fields[1]), &events_per_sec)) {
+      return error::InvalidArgument(
+          "Invalid rate limit '$0', expected <protocol>:<events_per_sec>[:<burst>]", limit_spec);
+    }
+    uint64_t burst = events_per_sec;
+    if (fields.size() == 3 && !absl::SimpleAtoi(absl::StripAsciiWhitespace(fields[2]), &burst)) {
+      return error::InvalidArgument(
+          "Invalid rate limit '$0', expected <protocol>:<events_per_sec>[:<burst>]", limit_spec);
+    }
+    PL_RETURN_IF_ERROR(UpdateBPFProtocolRateLimit(protocol.value(), events_per_sec, burst));
+    LOG(INFO) << absl::Substitute("BPF rate limit of $0 is $1 events/s, with bursts of $2.",
+                                  magic_enum::enum_name(protocol.value()), events_per_sec, burst);
+  }
+  return Status::OK();
+}
+
 Status SocketTraceConnector::TestOnlySetTargetPID(int64_t pid) {
   auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
   return UpdatePerCPUArrayValue(kTargetTGIDIndex, pid, &control_map_handle);
@@ -498,14 +773,15 @@ Status SocketTraceConnector::DisableSelfTracing() {
 void SocketTraceConnector::HandleDataEvent(void* cb_cookie, void* data, int /*data_size*/) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
-  auto data_event_ptr = std::make_unique<SocketDataEvent>(data);
-  connector->AcceptDataEvent(std::move(data_event_ptr));
+  // The view refers to the perf buffer memory, which stays valid until the callback returns.
+  // The message is copied from there straight into its connection's data stream.
+  connector->AcceptDataEvent(SocketDataEventView(data));
 }
 
 void SocketTraceConnector::HandleDataEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossSocketDataEvent,
-                                                                  lost);
+  static_cast<SocketTraceConnector*>(cb_cookie)->RecordEventLoss(StatKey::kLossSocketDataEvent,
+                                                                 lost);
 }
 
 void SocketTraceConnector::HandleControlEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -516,8 +792,10 @@ void SocketTraceConnector::HandleControlEvent(void* cb_cookie, void* data, int /
 
 void SocketTraceConnector::HandleControlEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossSocketControlEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->RecordEventLoss(StatKey::kLossSocketControlEvent, lost);
+  // Lost close events can't invalidate the FD links of their processes.
+  connector->fd_link_cache_->Clear();
 }
 
 void SocketTraceConnector::HandleConnStatsEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -528,8 +806,8 @@ void SocketTraceConnector::HandleConnStatsEvent(void* cb_cookie, void* data, int
 
 void SocketTraceConnector::HandleConnStatsEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossConnStatsEvent,
-                                                                  lost);
+  static_cast<SocketTraceConnector*>(cb_cookie)->RecordEventLoss(StatKey::kLossConnStatsEvent,
+                                                                 lost);
 }
 
 void SocketTraceConnector::HandleMMapEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -540,7 +818,37 @@ void SocketTraceConnector::HandleMMapEvent(void* cb_cookie, void* data, int /*da
 
 void SocketTraceConnector::HandleMMapEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossMMapEvent, lost);
+  static_cast<SocketTraceConnector*>(cb_cookie)->RecordEventLoss(StatKey::kLossMMapEvent, lost);
+}
+
+void SocketTraceConnector::HandleProcForkEvent(void* cb_cookie, void* data, int /*data_size*/) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  const auto& event = *static_cast<proc_fork_event_t*>(data);
+  connector->uprobe_mgr_.NotifyProcForkEvent(event.parent_tgid, event.child_pid);
+}
+
+void SocketTraceConnector::HandleProcExecEvent(void* cb_cookie, void* data, int /*data_size*/) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  const auto& upid = *static_cast<upid_t*>(data);
+  connector->uprobe_mgr_.NotifyProcExecEvent(upid);
+  connector->changed_pids_.push_back(upid.pid);
+}
+
+void SocketTraceConnector::HandleProcExitEvent(void* cb_cookie, void* data, int /*data_size*/) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  const auto& upid = *static_cast<upid_t*>(data);
+  connector->uprobe_mgr_.NotifyProcExitEvent(upid);
+  connector->changed_pids_.push_back(upid.pid);
+}
+
+void SocketTraceConnector::HandleProcEventLoss(void* cb_cookie, uint64_t lost) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->RecordEventLoss(StatKey::kLossProcEvent, lost);
+  connector->uprobe_mgr_.NotifyProcEventLoss();
 }
 
 void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -560,8 +868,25 @@ void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, i
 
 void SocketTraceConnector::HandleHTTP2HeaderEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossGoGRPCHeaderEvent,
-                                                                  lost);
+  static_cast<SocketTraceConnector*>(cb_cookie)->RecordEventLoss(StatKey::kLossGoGRPCHeaderEvent,
+                                                                 lost);
+}
+
+void SocketTraceConnector::HandleHTTP2HeaderBlockEvent(void* cb_cookie, void* data,
+                                                       int /*data_size*/) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+
+  HTTP2HeaderBlockEventView* block = &connector->http2_header_block_;
+  block->Decode(data);
+
+  VLOG(3) << absl::Substitute(
+      "t=$0 pid=$1 type=$2 fd=$3 tsid=$4 stream_id=$5 end_stream=$6 num_fields=$7",
+      block->attr.timestamp_ns, block->attr.conn_id.upid.pid,
+      magic_enum::enum_name(block->attr.type), block->attr.conn_id.fd, block->attr.conn_id.tsid,
+      block->attr.stream_id, block->attr.end_stream, block->fields.size());
+  connector->AcceptHTTP2HeaderBlock(block);
 }
 
 void SocketTraceConnector::HandleHTTP2Data(void* cb_cookie, void* data, int /*data_size*/) {
@@ -582,7 +907,7 @@ void SocketTraceConnector::HandleHTTP2Data(void* cb_cookie, void* data, int /*da
 
 void SocketTraceConnector::HandleHTTP2DataLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossHTTP2Data, lost);
+  static_cast<SocketTraceConnector*>(cb_cookie)->RecordEventLoss(StatKey::kLossHTTP2Data, lost);
 }
 
 //-----------------------------------------------------------------------------
@@ -596,21 +921,30 @@ ConnTracker& SocketTraceConnector::GetOrCreateConnTracker(struct conn_id_t conn_
   return tracker;
 }
 
-void SocketTraceConnector::AcceptDataEvent(std::unique_ptr<SocketDataEvent> event) {
-  event->attr.timestamp_ns += ClockRealTimeOffset();
+void SocketTraceConnector::AcceptDataEvent(SocketDataEventView event) {
+  event.attr.timestamp_ns += ClockRealTimeOffset();
 
   if (perf_buffer_events_output_stream_ != nullptr) {
-    WriteDataEvent(*event);
+    WriteDataEvent(event);
   }
 
-  ConnTracker& tracker = GetOrCreateConnTracker(event->attr.conn_id);
-  tracker.AddDataEvent(std::move(event));
+  ConnTracker& tracker = GetOrCreateConnTracker(event.attr.conn_id);
+  tracker.AddDataEvent(event);
 }
 
 void SocketTraceConnector::AcceptControlEvent(socket_control_event_t event) {
   // timestamp_ns is a common field of open and close fields.
   event.timestamp_ns += ClockRealTimeOffset();
 
+  if (perf_buffer_events_output_stream_ != nullptr) {
+    WriteControlEvent(event);
+  }
+
+  // The FD may be reused from now on, so the cached links of the process are stale.
+  if (event.type == kConnClose) {
+    fd_link_cache_->Invalidate(event.conn_id.upid.pid);
+  }
+
   ConnTracker& tracker = GetOrCreateConnTracker(event.conn_id);
   tracker.AddControlEvent(event);
 }
@@ -629,6 +963,13 @@ void SocketTraceConnector::AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> e
   tracker.AddHTTP2Header(std::move(event));
 }
 
+void SocketTraceConnector::AcceptHTTP2HeaderBlock(HTTP2HeaderBlockEventView* block) {
+  block->attr.timestamp_ns += ClockRealTimeOffset();
+
+  ConnTracker& tracker = GetOrCreateConnTracker(block->attr.conn_id);
+  tracker.AddHTTP2HeaderBlock(*block);
+}
+
 void SocketTraceConnector::AcceptHTTP2Data(std::unique_ptr<HTTP2DataEvent> event) {
   event->attr.timestamp_ns += ClockRealTimeOffset();
 
@@ -653,8 +994,55 @@ int64_t CalculateLatency(int64_t req_timestamp_ns, int64_t resp_timestamp_ns) {
   return latency_ns;
 }
 
+// Writes the headers as a JSON object, in NVMap order, which is sorted by name.
+std::string HTTP2HeadersToJSONString(const protocols::http2::NVMap& headers) {
+  utils::JSONObjectBuilder builder;
+  for (const auto& [name, value] : headers) {
+    builder.WriteKV(name, value);
+  }
+  return builder.GetString();
+}
+
 }  // namespace
 
+template <typename TRecordType>
+void SocketTraceConnector::AddHTTPStats(ConnectorContext* /* ctx */,
+                                        const ConnTracker& /* conn_tracker */,
+                                        const TRecordType& /* record */) {}
+
+template <>
+void SocketTraceConnector::AddHTTPStats(ConnectorContext* ctx, const ConnTracker& conn_tracker,
+                                        const protocols::http::Record& record) {
+  md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
+                conn_tracker.conn_id().upid.start_time_ticks);
+  http_stats_.Add(upid, conn_tracker.remote_endpoint().AddrStr(),
+                  conn_tracker.remote_endpoint().port(), conn_tracker.role(), record.req.req_method,
+                  record.req.req_path, record.resp.resp_status,
+                  CalculateLatency(record.req.timestamp_ns, record.resp.timestamp_ns));
+}
+
+template <>
+void SocketTraceConnector::AddHTTPStats(ConnectorContext* ctx, const ConnTracker& conn_tracker,
+                                        const protocols::http2::Record& record) {
+  // See AppendMessage() for the interpretation of the half-streams.
+  const bool is_client = conn_tracker.role() == kRoleClient;
+  const protocols::http2::HalfStream& req_stream = is_client ? record.send : record.recv;
+  const protocols::http2::HalfStream& resp_stream = is_client ? record.recv : record.send;
+
+  int64_t resp_status = -1;
+  if (!absl::SimpleAtoi(resp_stream.headers().ValueByKey(":status", "-1"), &resp_status)) {
+    resp_status = -1;
+  }
+
+  md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
+                conn_tracker.conn_id().upid.start_time_ticks);
+  http_stats_.Add(upid, conn_tracker.remote_endpoint().AddrStr(),
+                  conn_tracker.remote_endpoint().port(), conn_tracker.role(),
+                  req_stream.headers().ValueByKey(protocols::http2::headers::kMethod),
+                  req_stream.headers().ValueByKey(protocols::http2::headers::kPath), resp_status,
+                  CalculateLatency(req_stream.timestamp_ns, resp_stream.timestamp_ns));
+}
+
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
                                          protocols::http::Record record, DataTable* data_table) {
@@ -672,6 +1060,12 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   if (protocols::http::IsJSONContent(resp_message)) {
     content_type = HTTPContentType::kJSON;
   }
+  if (req_message.body_truncated) {
+    req_message.body.append(DataTable::kTruncatedMsg);
+  }
+  if (resp_message.body_truncated) {
+    resp_message.body.append(DataTable::kTruncatedMsg);
+  }
 
   DataTable::RecordBuilder<&kHTTPTable> r(data_table, resp_message.timestamp_ns);
   r.Append<r.ColIndex("time_")>(resp_message.timestamp_ns);
@@ -687,13 +1081,19 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_message.headers));
   r.Append<r.ColIndex("req_method")>(std::move(req_message.req_method));
   r.Append<r.ColIndex("req_path")>(std::move(req_message.req_path));
-  r.Append<r.ColIndex("req_body_size")>(req_message.body.size());
+  r.Append<r.ColIndex("req_body_size")>(req_message.body.size() +
+                                        req_message.body_bytes_skipped);
+  r.Append<r.ColIndex("req_body_bytes_skipped")>(req_message.body_bytes_skipped);
   r.Append<r.ColIndex("req_body"), kMaxBodyBytes>(std::move(req_message.body));
+  r.Append<r.ColIndex("req_body_raw")>("");
   r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
   r.Append<r.ColIndex("resp_status")>(resp_message.resp_status);
   r.Append<r.ColIndex("resp_message")>(std::move(resp_message.resp_message));
-  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size());
+  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size() +
+                                         resp_message.body_bytes_skipped);
+  r.Append<r.ColIndex("resp_body_bytes_skipped")>(resp_message.body_bytes_skipped);
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(resp_message.body));
+  r.Append<r.ColIndex("resp_body_raw")>("");
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_message.timestamp_ns, resp_message.timestamp_ns));
 #ifndef NDEBUG
@@ -736,15 +1136,40 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   std::string resp_data = resp_stream->ConsumeData();
   size_t req_data_size = req_stream->original_data_size();
   size_t resp_data_size = resp_stream->original_data_size();
+
+  // HalfStream::AddData() already kept only the head of the data. The rest of the body capture
+  // policy applies to the request and response together.
+  const bool capture_body = protocols::BodyCapturePolicy::Get().ShouldCapture(
+      req_stream->headers().ValueByKey(protocols::http2::headers::kContentType));
+  if (!capture_body) {
+    req_data.clear();
+    resp_data.clear();
+  }
+  size_t req_data_skipped = req_data_size - req_data.size();
+  size_t resp_data_skipped = resp_data_size - resp_data.size();
+
   if (record.HasGRPCContentType()) {
     content_type = HTTPContentType::kGRPC;
-    req_data = ParsePB(req_data, kMaxPBStringLen);
-    if (req_stream->data_truncated()) {
-      req_data.append(DataTable::kTruncatedMsg);
-    }
-    resp_data = ParsePB(resp_data, kMaxPBStringLen);
-    if (resp_stream->data_truncated()) {
-      resp_data.append(DataTable::kTruncatedMsg);
+  }
+  // The serialized gRPC bodies are kept as base64, so that the columns stay valid UTF-8. The text
+  // format in req_body and resp_body is what most scripts read.
+  std::string req_data_raw;
+  std::string resp_data_raw;
+  if (content_type == HTTPContentType::kGRPC && capture_body) {
+    req_data_raw = absl::Base64Escape(req_data);
+    resp_data_raw = absl::Base64Escape(resp_data);
+    if (FLAGS_stirling_grpc_body_to_text) {
+      req_data = ParsePB(req_data, kMaxPBStringLen);
+      if (req_stream->data_truncated()) {
+        req_data.append(DataTable::kTruncatedMsg);
+      }
+      resp_data = ParsePB(resp_data, kMaxPBStringLen);
+      if (resp_stream->data_truncated()) {
+        resp_data.append(DataTable::kTruncatedMsg);
+      }
+    } else {
+      req_data.clear();
+      resp_data.clear();
     }
   }
 
@@ -757,9 +1182,11 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("major_version")>(2);
   // HTTP2 does not define minor version.
   r.Append<r.ColIndex("minor_version")>(0);
-  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(ToJSONString(req_stream->headers()));
+  r.Append<r.ColIndex("req_headers"), kMaxHTTPHeadersBytes>(
+      HTTP2HeadersToJSONString(req_stream->headers()));
   r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(content_type));
-  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_stream->headers()));
+  r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(
+      HTTP2HeadersToJSONString(resp_stream->headers()));
   r.Append<r.ColIndex("req_method")>(
       req_stream->headers().ValueByKey(protocols::http2::headers::kMethod));
   r.Append<r.ColIndex("req_path")>(req_stream->headers().ValueByKey(":path"));
@@ -767,12 +1194,16 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   // TODO(yzhao): Populate the following field from headers.
   r.Append<r.ColIndex("resp_message")>("OK");
   r.Append<r.ColIndex("req_body_size")>(req_data_size);
+  r.Append<r.ColIndex("req_body_bytes_skipped")>(req_data_skipped);
   // Do not apply truncation at this point, as the truncation was already done on serialized
   // protobuf message. This might result into longer text format data here, but the increase is
   // minimal.
   r.Append<r.ColIndex("req_body")>(std::move(req_data));
+  r.Append<r.ColIndex("req_body_raw")>(std::move(req_data_raw));
   r.Append<r.ColIndex("resp_body_size")>(resp_data_size);
+  r.Append<r.ColIndex("resp_body_bytes_skipped")>(resp_data_skipped);
   r.Append<r.ColIndex("resp_body")>(std::move(resp_data));
+  r.Append<r.ColIndex("resp_body_raw")>(std::move(resp_data_raw));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_stream->timestamp_ns, resp_stream->timestamp_ns));
 #ifndef NDEBUG
@@ -906,8 +1337,38 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
   r.Append<r.ColIndex("trace_role")>(role);
   r.Append<r.ColIndex("req_cmd")>(std::string(entry.req.command));
-  r.Append<r.ColIndex("req_args")>(std::string(entry.req.payload));
-  r.Append<r.ColIndex("resp")>(std::string(entry.resp.payload));
+  r.Append<r.ColIndex("req_args")>(std::move(entry.req.payload));
+  r.Append<r.ColIndex("resp")>(std::move(entry.resp.payload));
+  r.Append<r.ColIndex("cmd_count")>(entry.cmd_count);
+  r.Append<r.ColIndex("latency")>(
+      CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+#ifndef NDEBUG
+  r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
+#endif
+}
+
+template <>
+void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
+                                         protocols::kafka::Record entry, DataTable* data_table) {
+  md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
+                conn_tracker.conn_id().upid.start_time_ticks);
+
+  // Requests that get no response, such as produce requests with acks=0, are recorded at the time
+  // of the request.
+  const uint64_t time =
+      entry.resp.timestamp_ns > 0 ? entry.resp.timestamp_ns : entry.req.timestamp_ns;
+
+  DataTable::RecordBuilder<&kKafkaTable> r(data_table, time);
+  r.Append<r.ColIndex("time_")>(time);
+  r.Append<r.ColIndex("upid")>(upid.value());
+  r.Append<r.ColIndex("remote_addr")>(conn_tracker.remote_endpoint().AddrStr());
+  r.Append<r.ColIndex("remote_port")>(conn_tracker.remote_endpoint().port());
+  r.Append<r.ColIndex("trace_role")>(conn_tracker.role());
+  r.Append<r.ColIndex("req_cmd")>(static_cast<int64_t>(entry.req.api_key));
+  r.Append<r.ColIndex("client_id")>(std::move(entry.req.client_id));
+  r.Append<r.ColIndex("req_body")>(std::move(entry.req.msg));
+  r.Append<r.ColIndex("req_size")>(entry.req.payload_size);
+  r.Append<r.ColIndex("resp_size")>(entry.resp.payload_size);
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
 #ifndef NDEBUG
@@ -929,31 +1390,24 @@ void SocketTraceConnector::SetupOutput(const std::filesystem::path& path) {
   LOG(INFO) << absl::Substitute("Writing output to: $0 in $1 format.", abs_path.string(), format);
 }
 
-namespace {
-void SocketDataEventToPB(const SocketDataEvent& event, sockeventpb::SocketDataEvent* pb) {
-  pb->mutable_attr()->set_timestamp_ns(event.attr.timestamp_ns);
-  pb->mutable_attr()->mutable_conn_id()->set_pid(event.attr.conn_id.upid.pid);
-  pb->mutable_attr()->mutable_conn_id()->set_start_time_ns(
-      event.attr.conn_id.upid.start_time_ticks);
-  pb->mutable_attr()->mutable_conn_id()->set_fd(event.attr.conn_id.fd);
-  pb->mutable_attr()->mutable_conn_id()->set_generation(event.attr.conn_id.tsid);
-  pb->mutable_attr()->set_protocol(event.attr.protocol);
-  pb->mutable_attr()->set_role(event.attr.role);
-  pb->mutable_attr()->set_direction(event.attr.direction);
-  pb->mutable_attr()->set_pos(event.attr.pos);
-  pb->mutable_attr()->set_msg_size(event.attr.msg_size);
-  pb->set_msg(event.msg);
+void SocketTraceConnector::WriteDataEvent(const SocketDataEventView& event) {
+  sockeventpb::SocketEvent pb;
+  SocketDataEventToPB(event, pb.mutable_data());
+  WriteEvent(pb);
+}
+
+void SocketTraceConnector::WriteControlEvent(const socket_control_event_t& event) {
+  sockeventpb::SocketEvent pb;
+  SocketControlEventToPB(event, pb.mutable_control());
+  WriteEvent(pb);
 }
-}  // namespace
 
-void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
+void SocketTraceConnector::WriteEvent(const sockeventpb::SocketEvent& pb) {
   using ::google::protobuf::TextFormat;
   using ::google::protobuf::util::SerializeDelimitedToOstream;
 
   DCHECK(perf_buffer_events_output_stream_ != nullptr);
 
-  sockeventpb::SocketDataEvent pb;
-  SocketDataEventToPB(event, &pb);
   std::string text;
   switch (perf_buffer_events_output_format_) {
     case OutputFormat::kTxt:
@@ -974,30 +1428,103 @@ void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
 // TransferData Helpers
 //-----------------------------------------------------------------------------
 
+namespace {
+
+// Parsing fewer connections than this isn't worth handing them to the parse threads.
+constexpr size_t kMinTrackersToParseInParallel = 512;
+
+// Under memory pressure, the buffered messages expire sooner: from the full expiration duration at
+// half of the memory budget, down to a tenth of it once the budget is used up.
+std::chrono::steady_clock::duration MessagesExpirationDuration(double memory_pressure) {
+  constexpr double kPressureThreshold = 0.5;
+  constexpr double kMinScale = 0.1;
+  double scale = 1.0;
+  if (memory_pressure > kPressureThreshold) {
+    scale = std::max(kMinScale, (1.0 - memory_pressure) / (1.0 - kPressureThreshold));
+  }
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(FLAGS_messages_expiration_duration_secs * scale));
+}
+
+}  // namespace
+
 template <typename TProtocolTraits>
-void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tracker,
-                                          DataTable* data_table) {
-  VLOG(3) << absl::StrCat("Connection\n", DebugString<TProtocolTraits>(*tracker, ""));
-
-  if (tracker->state() == ConnTracker::State::kTransferring) {
-    // ProcessToRecords() parses raw events and produces messages in format that are expected by
-    // table store. But those messages are not cached inside ConnTracker.
-    auto result = tracker->ProcessToRecords<TProtocolTraits>();
-    for (auto& msg : result) {
-      AppendMessage(ctx, *tracker, std::move(msg), data_table);
+void SocketTraceConnector::TransferStreams(ConnectorContext* ctx,
+                                           const std::vector<ConnTracker*>& trackers,
+                                           DataTable* data_table) {
+  using TRecordType = typename TProtocolTraits::record_type;
+
+  auto expiry_timestamp =
+      iteration_time_ - MessagesExpirationDuration(conn_trackers_mgr_.memory_pressure());
+
+  // Parsing and stitching only touch the tracker being parsed, so trackers are parsed in parallel.
+  std::vector<std::vector<TRecordType>> records(trackers.size());
+  std::vector<ConnTracker::ProcessTimes> times(trackers.size());
+  auto parse_tracker = [&](size_t i) {
+    ConnTracker* tracker = trackers[i];
+    VLOG(3) << absl::StrCat("Connection\n", DebugString<TProtocolTraits>(*tracker, ""));
+
+    if (tracker->state() == ConnTracker::State::kTransferring) {
+      // ProcessToRecords() parses raw events and produces messages in format that are expected by
+      // table store. But those messages are not cached inside ConnTracker.
+      records[i] = tracker->ProcessToRecords<TProtocolTraits>(&times[i]);
+      tracker->Cleanup<TProtocolTraits>(FLAGS_messages_size_limit_bytes, expiry_timestamp);
     }
+  };
+  if (trackers.size() < kMinTrackersToParseInParallel) {
+    for (size_t i = 0; i < trackers.size(); ++i) {
+      parse_tracker(i);
+    }
+  } else {
+    parse_pool_->ParallelFor(trackers.size(), parse_tracker);
+  }
+
+  // The per-iteration times are summed over the trackers, i.e. they are CPU time, not wall time.
+  // All trackers are of the same protocol, and the caller never passes an empty list.
+  ConnTracker::ProcessTimes total_times;
+  for (const auto& t : times) {
+    total_times.parse += t.parse;
+    total_times.stitch += t.stitch;
+  }
+  const ProtocolProbes& probes = protocol_probes_[trackers.front()->protocol()];
+  probes.parse->Record(total_times.parse);
+  probes.stitch->Record(total_times.stitch);
+
+  // The data table is not thread-safe, so the records are appended afterwards, in tracker order.
+  for (size_t i = 0; i < trackers.size(); ++i) {
+    for (auto& record : records[i]) {
+      if (http_stats_enabled_) {
+        AddHTTPStats(ctx, *trackers[i], record);
+      }
+      AppendMessage(ctx, *trackers[i], std::move(record), data_table);
+    }
+  }
+}
 
-    auto expiry_timestamp =
-        iteration_time_ - std::chrono::seconds(FLAGS_messages_expiration_duration_secs);
-    tracker->Cleanup<TProtocolTraits>(FLAGS_messages_size_limit_bytes, expiry_timestamp);
+void SocketTraceConnector::TransferHTTPStats(DataTable* data_table) {
+  const uint64_t time = CurrentTimeNS();
+  const uint64_t window_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::seconds(FLAGS_stirling_http_stats_window_secs))
+                                 .count();
+  if (http_stats_window_start_ns_ == 0) {
+    http_stats_window_start_ns_ = time;
+  }
+  if (time - http_stats_window_start_ns_ < window_ns) {
+    return;
   }
+  http_stats_.Transfer(time, data_table);
+  http_stats_window_start_ns_ = time;
 }
 
 void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* data_table) {
   namespace idx = ::px::stirling::conn_stats_idx;
 
-  absl::flat_hash_set<md::UPID> upids = ctx->GetUPIDs();
+  const absl::flat_hash_set<md::UPID>& upids = ctx->GetUPIDs();
   uint64_t time = CurrentTimeNS();
+  const uint64_t heartbeat_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::seconds(FLAGS_stirling_conn_stats_heartbeat_secs))
+          .count();
 
   auto& agg_stats = conn_stats_.UpdateStats();
 
@@ -1012,12 +1539,16 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
     bool active_upid = upids.contains(upid);
 
     bool activity = conn_stats_.Active(stats);
+    // Stats that were never reported are always due, so each connection gets a first record.
+    bool heartbeat_due = FLAGS_stirling_conn_stats_heartbeat_secs > 0 &&
+                         time >= stats.last_report_time_ns + heartbeat_ns;
 
     VLOG(1) << absl::Substitute("upid=$0 active=$1 previously_active=$2", upid.String(),
                                 active_upid, stats.reported);
 
-    // Only export this record if there are actual changes.
-    if ((active_upid || stats.reported) && activity) {
+    // Only export this record if there are actual changes, or if an idle connection is due for
+    // its periodic record.
+    if ((active_upid || stats.reported) && (activity || heartbeat_due)) {
       DataTable::RecordBuilder<&kConnStatsTable> r(data_table, time);
 
       r.Append<idx::kTime>(time);
@@ -1032,11 +1563,13 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
       r.Append<idx::kConnActive>(stats.conn_open - stats.conn_close);
       r.Append<idx::kBytesSent>(stats.bytes_sent);
       r.Append<idx::kBytesRecv>(stats.bytes_recv);
+      r.Append<idx::kEventsSuppressed>(stats.events_suppressed);
 #ifndef NDEBUG
       r.Append<idx::kPxInfo>("");
 #endif
 
       stats.reported = true;
+      stats.last_report_time_ns = time;
     }
 
     // Check for pids that may have died.
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <fstream>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -30,6 +31,7 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/synchronization/mutex.h>
 
+#include "src/common/base/worker_pool.h"
 #include "src/common/grpcutils/service_descriptor_database.h"
 #include "src/common/system/socket_info.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
@@ -41,6 +43,8 @@
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/http_stats.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
@@ -48,6 +52,8 @@
 #include "src/stirling/utils/proc_tracker.h"
 
 DECLARE_uint32(stirling_conn_stats_sampling_ratio);
+DECLARE_bool(stirling_enable_http_stats);
+DECLARE_uint32(stirling_http_stats_window_secs);
 DECLARE_bool(stirling_enable_periodic_bpf_map_cleanup);
 DECLARE_string(perf_buffer_events_output_path);
 DECLARE_bool(stirling_enable_http_tracing);
@@ -56,11 +62,15 @@ DECLARE_bool(stirling_enable_mysql_tracing);
 DECLARE_bool(stirling_enable_cass_tracing);
 DECLARE_bool(stirling_enable_dns_tracing);
 DECLARE_bool(stirling_enable_redis_tracing);
+DECLARE_bool(stirling_enable_kafka_tracing);
 DECLARE_bool(stirling_disable_self_tracing);
 DECLARE_string(stirling_role_to_trace);
 
 DECLARE_uint32(messages_expiration_duration_secs);
 DECLARE_uint32(messages_size_limit_bytes);
+DECLARE_uint64(stirling_conn_trackers_memory_budget_bytes);
+DECLARE_uint32(stirling_socket_tracer_parse_threads);
+DECLARE_bool(stirling_grpc_body_to_text);
 
 namespace px {
 namespace stirling {
@@ -68,8 +78,9 @@ namespace stirling {
 class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "socket_tracer";
-  static constexpr auto kTables = MakeArray(kConnStatsTable, kHTTPTable, kMySQLTable, kCQLTable,
-                                            kPGSQLTable, kDNSTable, kRedisTable);
+  static constexpr auto kTables =
+      MakeArray(kConnStatsTable, kHTTPTable, kMySQLTable, kCQLTable, kPGSQLTable, kDNSTable,
+                kRedisTable, kKafkaTable, kHTTPStatsTable);
 
   static constexpr uint32_t kConnStatsTableNum = TableNum(kTables, kConnStatsTable);
   static constexpr uint32_t kHTTPTableNum = TableNum(kTables, kHTTPTable);
@@ -78,6 +89,8 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr uint32_t kPGSQLTableNum = TableNum(kTables, kPGSQLTable);
   static constexpr uint32_t kDNSTableNum = TableNum(kTables, kDNSTable);
   static constexpr uint32_t kRedisTableNum = TableNum(kTables, kRedisTable);
+  static constexpr uint32_t kKafkaTableNum = TableNum(kTables, kKafkaTable);
+  static constexpr uint32_t kHTTPStatsTableNum = TableNum(kTables, kHTTPStatsTable);
 
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{200};
   // TODO(yzhao): This is not used right now. Eventually use this to control data push frequency.
@@ -87,10 +100,13 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     return std::unique_ptr<SourceConnector>(new SocketTraceConnector(name));
   }
 
+  ~SocketTraceConnector() override;
+
   Status InitImpl() override;
   Status StopImpl() override;
   void InitContextImpl(ConnectorContext* ctx) override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  double OutputBufferFill() override { return TakePerfBufferFill(); }
 
   // Perform actions that are not specifically targeting a table.
   // For example, drain perf buffers, deploy new uprobes, and update socket info manager.
@@ -105,6 +121,19 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Role_mask a bit mask, and represents the EndpointRole roles that are allowed to transfer
   // data from inside BPF to user-space.
   Status UpdateBPFProtocolTraceRole(TrafficProtocol protocol, uint64_t role_mask);
+
+  // Sets the payload prefix limits of the protocols in BPF, from a list of <protocol>:<bytes>
+  // (see --stirling_bpf_payload_prefix_limits).
+  Status UpdateBPFPayloadPrefixLimits(std::string_view limits);
+
+  // Sets the rate limit of the data events of each process for protocol, in BPF. An
+  // events_per_sec of 0 removes the limit.
+  Status UpdateBPFProtocolRateLimit(TrafficProtocol protocol, uint64_t events_per_sec,
+                                    uint64_t burst);
+
+  // Sets the rate limits of the protocols in BPF, from a list of
+  // <protocol>:<events_per_sec>[:<burst>] (see --stirling_bpf_rate_limits).
+  Status UpdateBPFRateLimits(std::string_view limits);
   Status TestOnlySetTargetPID(int64_t pid);
   Status DisableSelfTracing();
 
@@ -122,6 +151,9 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     return conn_trackers_mgr_.GetConnTracker(pid, fd);
   }
 
+  // The number of threads that parse connections, including the thread that calls TransferData.
+  size_t num_parse_threads() const { return parse_pool_->num_threads() + 1; }
+
  private:
   // ReadPerfBuffers poll callback functions (must be static).
   // These are used by the static variables below, and have to be placed here.
@@ -133,8 +165,13 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static void HandleConnStatsEventLoss(void* cb_cookie, uint64_t lost);
   static void HandleMMapEvent(void* cb_cookie, void* data, int data_size);
   static void HandleMMapEventLoss(void* cb_cookie, uint64_t lost);
+  static void HandleProcForkEvent(void* cb_cookie, void* data, int data_size);
+  static void HandleProcExecEvent(void* cb_cookie, void* data, int data_size);
+  static void HandleProcExitEvent(void* cb_cookie, void* data, int data_size);
+  static void HandleProcEventLoss(void* cb_cookie, uint64_t lost);
   static void HandleHTTP2HeaderEvent(void* cb_cookie, void* data, int data_size);
   static void HandleHTTP2HeaderEventLoss(void* cb_cookie, uint64_t lost);
+  static void HandleHTTP2HeaderBlockEvent(void* cb_cookie, void* data, int data_size);
   static void HandleHTTP2Data(void* cb_cookie, void* data, int data_size);
   static void HandleHTTP2DataLoss(void* cb_cookie, uint64_t lost);
 
@@ -179,6 +216,14 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
        /*is_syscall*/ false},
   });
 
+  // Process lifecycle tracepoints, so new and terminated processes are known within a sampling
+  // period, instead of being inferred from the context's UPIDs.
+  inline static const auto kTracepointSpecs = MakeArray<bpf_tools::TracepointSpec>({
+      {"sched:sched_process_fork", "probe_sched_process_fork"},
+      {"sched:sched_process_exec", "probe_sched_process_exec"},
+      {"sched:sched_process_exit", "probe_sched_process_exit"},
+  });
+
   // TODO(oazizi): Remove send and recv probes once we are confident that they don't trace anything.
   //               Note that send/recv are not in the syscall table
   //               (https://filippo.io/linux-syscall-table/), but are defined as SYSCALL_DEFINE4 in
@@ -203,7 +248,13 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
       {"conn_stats_events", HandleConnStatsEvent, HandleConnStatsEventLoss,
        kTargetControlBufferSize},
       {"mmap_events", HandleMMapEvent, HandleMMapEventLoss, kTargetControlBufferSize},
+      {"proc_fork_events", HandleProcForkEvent, HandleProcEventLoss, kTargetControlBufferSize},
+      {"proc_exec_events", HandleProcExecEvent, HandleProcEventLoss, kTargetControlBufferSize},
+      {"proc_exit_events", HandleProcExitEvent, HandleProcEventLoss, kTargetControlBufferSize},
+      // Only net/http's header writes are traced one header per event.
       {"go_grpc_header_events", HandleHTTP2HeaderEvent, HandleHTTP2HeaderEventLoss,
+       kTargetDataBufferSize / 20},
+      {"go_grpc_header_block_events", HandleHTTP2HeaderBlockEvent, HandleHTTP2HeaderEventLoss,
        kTargetDataBufferSize / 10},
       {"go_grpc_data_events", HandleHTTP2Data, HandleHTTP2DataLoss, kTargetDataBufferSize},
   });
@@ -232,18 +283,24 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   ConnTracker& GetOrCreateConnTracker(struct conn_id_t conn_id);
 
   // Events from BPF.
-  void AcceptDataEvent(std::unique_ptr<SocketDataEvent> event);
+  void AcceptDataEvent(SocketDataEventView event);
+  void AcceptDataEvent(std::unique_ptr<SocketDataEvent> event) {
+    AcceptDataEvent(SocketDataEventView(*event));
+  }
   void AcceptControlEvent(socket_control_event_t event);
   void AcceptConnStatsEvent(conn_stats_event_t event);
   void AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> event);
+  void AcceptHTTP2HeaderBlock(HTTP2HeaderBlockEventView* block);
   void AcceptHTTP2Data(std::unique_ptr<HTTP2DataEvent> event);
 
   // Transfer of messages to the data table.
-  void TransferStreams(ConnectorContext* ctx, uint32_t table_num, DataTable* data_table);
   void TransferConnStats(ConnectorContext* ctx, DataTable* data_table);
+  void TransferHTTPStats(DataTable* data_table);
 
+  // Parses the trackers of one protocol into records, and appends the records to the data table.
   template <typename TProtocolTraits>
-  void TransferStream(ConnectorContext* ctx, ConnTracker* tracker, DataTable* data_table);
+  void TransferStreams(ConnectorContext* ctx, const std::vector<ConnTracker*>& trackers,
+                       DataTable* data_table);
 
   void set_iteration_time(std::chrono::time_point<std::chrono::steady_clock> time) {
     DCHECK(time >= iteration_time_);
@@ -253,32 +310,51 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   void UpdateTrackerTraceLevel(ConnTracker* tracker);
 
+  // Adds the record to http_stats_; a no-op for the records of non-HTTP protocols.
+  template <typename TRecordType>
+  void AddHTTPStats(ConnectorContext* ctx, const ConnTracker& conn_tracker,
+                    const TRecordType& record);
+
   template <typename TRecordType>
   static void AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
                             TRecordType record, DataTable* data_table);
 
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids, uint64_t epoch);
+  std::thread RunDeployUProbesFromProcEventsThread(uint32_t asid);
+  // Deploys on the changes of the context's UPIDs since the last deployment, if they are known,
+  // or else on the full set.
+  std::thread RunDeployUProbesFromContextThread(ConnectorContext* ctx);
 
   // Setups output file stream object writing to the input file path.
   void SetupOutput(const std::filesystem::path& file);
 
-  // Writes data event to the specified output file.
-  void WriteDataEvent(const SocketDataEvent& event);
+  // Writes data and control events to the specified output file.
+  void WriteDataEvent(const SocketDataEventView& event);
+  void WriteControlEvent(const socket_control_event_t& event);
+  void WriteEvent(const sockeventpb::SocketEvent& pb);
 
   ConnTrackersManager conn_trackers_mgr_;
 
   ConnStats conn_stats_;
 
+  // Aggregates the HTTP records of the current window, when the http_stats table is enabled.
+  bool http_stats_enabled_ = false;
+  HTTPStats http_stats_;
+  uint64_t http_stats_window_start_ns_ = 0;
+
   absl::flat_hash_set<int> pids_to_trace_disable_;
 
+  // An instantiation of TransferStreams() for one protocol.
+  using TransferFn = void (SocketTraceConnector::*)(ConnectorContext*,
+                                                    const std::vector<ConnTracker*>&, DataTable*);
+
   struct TransferSpec {
     // TODO(yzhao): Enabling protocol is essentially equivalent to subscribing to DataTable. They
     // could be unified.
     bool enabled = false;
     uint32_t table_num = 0;
     std::vector<EndpointRole> trace_roles;
-    std::function<void(SocketTraceConnector&, ConnectorContext*, ConnTracker*, DataTable*)>
-        transfer_fn = nullptr;
+    TransferFn transfer_fn = nullptr;
   };
 
   // This map controls how each protocol is processed and transferred.
@@ -286,6 +362,10 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // The transfer_fn defines which function is called to process the data for transfer.
   std::vector<TransferSpec> protocol_transfer_specs_;
 
+  // When set, each protocol's transfer is run through this instead of being called directly, so
+  // that SocketEventReplayer can measure the transfers.
+  std::function<void(TrafficProtocol, const std::function<void()>&)> transfer_wrapper_;
+
   // The time at which TransferDataImpl() begin. Used as a universal timestamp for the iteration,
   // to avoid too many calls to std::chrono::steady_clock::now().
   std::chrono::time_point<std::chrono::steady_clock> iteration_time_;
@@ -304,26 +384,60 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   };
   OutputFormat perf_buffer_events_output_format_ = OutputFormat::kTxt;
 
+  // Reused to decode every HTTP2 header block event, which only point into the perf buffer.
+  HTTP2HeaderBlockEventView http2_header_block_;
+
   // Portal to query for connections, by pid and inode.
   std::unique_ptr<system::SocketInfoManager> socket_info_mgr_;
 
   std::unique_ptr<system::ProcParser> proc_parser_;
 
+  // FD links of the processes with connections to infer, invalidated by their close events.
+  std::unique_ptr<FDLinkCache> fd_link_cache_;
+
+  // The threads that parse and stitch the connections of a protocol, in TransferStreams().
+  std::unique_ptr<WorkerPool> parse_pool_;
+
   std::shared_ptr<ConnInfoMapManager> conn_info_map_mgr_;
 
   UProbeManager uprobe_mgr_;
 
+  // Whether the process exec/exit tracepoints are attached, so uprobe deployment can be driven by
+  // process events rather than by the context's full set of UPIDs.
+  bool proc_events_enabled_ = false;
+
+  // The pids of the process exec/exit events read by the last poll of the perf buffers.
+  std::vector<uint32_t> changed_pids_;
+
   enum class StatKey {
     kLossSocketDataEvent,
     kLossSocketControlEvent,
     kLossConnStatsEvent,
     kLossMMapEvent,
+    kLossProcEvent,
     kLossGoGRPCHeaderEvent,
     kLossHTTP2Data,
   };
 
   utils::StatCounter<StatKey> stats_;
 
+  // Probes exported to the stirling_perf table.
+  struct ProtocolProbes {
+    utils::PerfProbe* parse = nullptr;
+    utils::PerfProbe* stitch = nullptr;
+  };
+  // Indexed by TrafficProtocol, like protocol_transfer_specs_.
+  std::vector<ProtocolProbes> protocol_probes_;
+  utils::PerfProbe* poll_perf_buffers_probe_ = nullptr;
+
+  // Counts the lost events of a perf buffer, both in the logged stats and the stirling_perf table.
+  void RecordEventLoss(StatKey key, uint64_t lost) {
+    stats_.Increment(key, lost);
+    poll_perf_buffers_probe_->RecordEventLoss(lost);
+  }
+
+  friend class SocketEventReplayer;
+
   FRIEND_TEST(SocketTraceConnectorTest, AppendNonContiguousEvents);
   FRIEND_TEST(SocketTraceConnectorTest, NoEvents);
   FRIEND_TEST(SocketTraceConnectorTest, SortedByResponseTime);
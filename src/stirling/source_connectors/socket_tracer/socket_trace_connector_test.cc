@@ -258,6 +258,68 @@ TEST_F(SocketTraceConnectorTest, HTTPBasic) {
   EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre("foo"));
 }
 
+TEST_F(SocketTraceConnectorTest, HTTPManyConnectionsParsedInParallel) {
+  FLAGS_stirling_socket_tracer_parse_threads = 4;
+  // The parse threads are started when the connector is created.
+  connector_ = SocketTraceConnector::Create("socket_trace_connector");
+  source_ = dynamic_cast<SocketTraceConnector*>(connector_.get());
+  ASSERT_EQ(source_->num_parse_threads(), 4);
+
+  // Enough connections for every parse thread to be used.
+  constexpr int kNumConns = 1024;
+  for (int fd = 0; fd < kNumConns; ++fd) {
+    testing::EventGenerator event_gen(&mock_clock_, kPID, fd);
+    source_->AcceptControlEvent(event_gen.InitConn());
+    source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+    source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+  }
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(kNumConns)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPReqPathIdx]), Each(std::string("/index.html")));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), Each(std::string("foo")));
+}
+
+// Parsing in parallel produces the same records, in the same order, as parsing serially.
+TEST_F(SocketTraceConnectorTest, HTTPParallelParsingMatchesSerial) {
+  constexpr int kNumConns = 1024;
+  auto transfer = [&](uint32_t parse_threads) {
+    FLAGS_stirling_socket_tracer_parse_threads = parse_threads;
+    std::unique_ptr<SourceConnector> connector =
+        SocketTraceConnector::Create("socket_trace_connector");
+    auto* source = dynamic_cast<SocketTraceConnector*>(connector.get());
+    EXPECT_EQ(source->num_parse_threads(), parse_threads);
+
+    testing::MockClock clock;
+    for (int fd = 0; fd < kNumConns; ++fd) {
+      testing::EventGenerator event_gen(&clock, kPID, fd);
+      source->AcceptControlEvent(event_gen.InitConn());
+      // Every connection has its own path, so that out of order records would be noticed.
+      std::string req = absl::StrCat("GET /", fd, " HTTP/1.1\r\nHost: pixielabs.ai\r\n\r\n");
+      source->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(req));
+      source->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+    }
+
+    testing::DataTables data_tables(SocketTraceConnector::kTables);
+    connector->TransferData(ctx_.get(), data_tables.tables());
+    std::vector<TaggedRecordBatch> tablets =
+        data_tables[SocketTraceConnector::kHTTPTableNum]->ConsumeRecords();
+    EXPECT_EQ(tablets.size(), 1);
+    return tablets.empty() ? std::vector<std::string>{}
+                           : ToStringVector(tablets[0].records[kHTTPReqPathIdx]);
+  };
+
+  std::vector<std::string> serial_paths = transfer(1);
+  std::vector<std::string> parallel_paths = transfer(4);
+  EXPECT_EQ(serial_paths.size(), static_cast<size_t>(kNumConns));
+  EXPECT_EQ(parallel_paths, serial_paths);
+}
+
 TEST_F(SocketTraceConnectorTest, HTTPContentType) {
   testing::EventGenerator event_gen(&mock_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
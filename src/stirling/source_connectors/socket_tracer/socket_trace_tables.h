@@ -19,11 +19,13 @@
 #pragma once
 
 #include "src/stirling/source_connectors/socket_tracer/conn_stats_table.h"
+#include "src/stirling/source_connectors/socket_tracer/http_stats_table.h"
 
 // PROTOCOL_LIST: Requires update on new protocols.
 #include "src/stirling/source_connectors/socket_tracer/cass_table.h"
 #include "src/stirling/source_connectors/socket_tracer/dns_table.h"
 #include "src/stirling/source_connectors/socket_tracer/http_table.h"
+#include "src/stirling/source_connectors/socket_tracer/kafka_table.h"
 #include "src/stirling/source_connectors/socket_tracer/mysql_table.h"
 #include "src/stirling/source_connectors/socket_tracer/pgsql_table.h"
 #include "src/stirling/source_connectors/socket_tracer/redis_table.h"
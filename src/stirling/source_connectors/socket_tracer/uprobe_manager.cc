@@ -18,12 +18,13 @@
 
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <filesystem>
-#include <map>
+#include <thread>
 
 #include "src/common/base/base.h"
 #include "src/common/base/utils.h"
@@ -40,6 +41,18 @@ DEFINE_bool(stirling_rescan_for_dlopen, false,
 DEFINE_double(stirling_rescan_exp_backoff_factor, 2.0,
               "Exponential backoff factor used in decided how often to rescan binaries for "
               "dynamically loaded libraries");
+DEFINE_int32(stirling_uprobe_analysis_threads, 4,
+             "Number of threads used to read the ELF & DWARF info of new binaries, "
+             "during uprobe deployment. Each thread may hold one binary's debug info in memory. "
+             "Read when the uprobe manager is created.");
+DEFINE_uint32(stirling_symaddrs_cache_size, 256,
+              "Maximum number of binaries for which uprobe symbol addresses are cached.");
+DEFINE_string(stirling_symaddrs_cache_dir, "",
+              "If set, the uprobe symbol address caches are saved to, and loaded from, this "
+              "directory, so they survive restarts. Should be on a host mount.");
+DEFINE_bool(stirling_openssl_record_layer_probes, false,
+            "If enabled, OpenSSL writes are traced with probes on the record layer, when libssl "
+            "has the symbols for it, rather than with the SSL_write entry/return pair.");
 
 namespace px {
 namespace stirling {
@@ -47,8 +60,48 @@ namespace stirling {
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 
-UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc) : bcc_(bcc) {
+UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc)
+    : bcc_(bcc),
+      go_symaddrs_cache_(FLAGS_stirling_symaddrs_cache_size),
+      openssl_symaddrs_cache_(FLAGS_stirling_symaddrs_cache_size) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
+  // The deployment thread analyzes binaries along with the pool's threads.
+  analysis_pool_ =
+      std::make_unique<WorkerPool>(std::max(FLAGS_stirling_uprobe_analysis_threads, 1) - 1);
+}
+
+namespace {
+constexpr std::string_view kGoSymAddrsCacheFile = "go_symaddrs.cache";
+constexpr std::string_view kOpenSSLSymAddrsCacheFile = "openssl_symaddrs.cache";
+}  // namespace
+
+void UProbeManager::LoadSymAddrsCaches() {
+  if (FLAGS_stirling_symaddrs_cache_dir.empty()) {
+    return;
+  }
+  const std::filesystem::path dir(FLAGS_stirling_symaddrs_cache_dir);
+  Status s = go_symaddrs_cache_.Load(dir / kGoSymAddrsCacheFile);
+  VLOG_IF(1, !s.ok()) << absl::Substitute("Could not load Go symaddrs cache: $0", s.msg());
+  s = openssl_symaddrs_cache_.Load(dir / kOpenSSLSymAddrsCacheFile);
+  VLOG_IF(1, !s.ok()) << absl::Substitute("Could not load OpenSSL symaddrs cache: $0", s.msg());
+  LOG(INFO) << absl::Substitute("Loaded symaddrs caches: go=$0 openssl=$1 entries",
+                                go_symaddrs_cache_.size(), openssl_symaddrs_cache_.size());
+}
+
+void UProbeManager::SaveSymAddrsCaches() {
+  if (FLAGS_stirling_symaddrs_cache_dir.empty() || !symaddrs_cache_dirty_) {
+    return;
+  }
+  const std::filesystem::path dir(FLAGS_stirling_symaddrs_cache_dir);
+  Status s = fs::CreateDirectories(dir);
+  if (s.ok()) {
+    s = go_symaddrs_cache_.Save(dir / kGoSymAddrsCacheFile);
+  }
+  if (s.ok()) {
+    s = openssl_symaddrs_cache_.Save(dir / kOpenSSLSymAddrsCacheFile);
+  }
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Could not save symaddrs caches: $0", s.msg());
+  symaddrs_cache_dirty_ = false;
 }
 
 void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
@@ -63,16 +116,62 @@ void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
       bcc_, "http2_symaddrs_map");
   go_tls_symaddrs_map_ = UserSpaceManagedBPFMap<uint32_t, struct go_tls_symaddrs_t>::Create(
       bcc_, "go_tls_symaddrs_map");
+
+  LoadSymAddrsCaches();
 }
 
 void UProbeManager::NotifyMMapEvent(upid_t upid) { upids_with_mmap_.insert(upid); }
 
-StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                              const std::string& binary,
-                                              obj_tools::ElfReader* elf_reader) {
+void UProbeManager::NotifyProcExecEvent(upid_t upid) {
+  absl::MutexLock lock(&proc_events_mutex_);
+  exec_upids_.insert(upid);
+}
+
+void UProbeManager::NotifyProcExitEvent(upid_t upid) {
+  absl::MutexLock lock(&proc_events_mutex_);
+  exit_upids_.insert(upid);
+}
+
+void UProbeManager::NotifyProcForkEvent(uint32_t parent_tgid, uint32_t child_pid) {
+  absl::MutexLock lock(&proc_events_mutex_);
+  fork_pids_[child_pid] = parent_tgid;
+}
+
+void UProbeManager::NotifyProcEventLoss() { proc_events_lost_ = true; }
+
+void UProbeManager::ResolveProcForkEvents() {
+  absl::flat_hash_map<uint32_t, uint32_t> fork_pids;
+  {
+    absl::MutexLock lock(&proc_events_mutex_);
+    fork_pids.swap(fork_pids_);
+  }
+
+  // Reading /proc is done without the lock, so that the perf buffer callbacks don't wait on it.
+  const std::filesystem::path proc_path = system::Config::GetInstance().proc_path();
+  std::vector<upid_t> children;
+  for (const auto& [child_pid, parent_tgid] : fork_pids) {
+    // A new thread is listed as a task of the process that created it, a new process isn't.
+    if (fs::Exists(proc_path / std::to_string(parent_tgid) / "task" / std::to_string(child_pid))
+            .ok()) {
+      continue;
+    }
+    PL_ASSIGN_OR(int64_t start_time_ticks, proc_parser_->GetPIDStartTimeTicks(child_pid),
+                 continue);
+    const struct upid_t child = {.pid = child_pid,
+                                 .start_time_ticks = static_cast<uint64_t>(start_time_ticks)};
+    children.push_back(child);
+  }
+
+  absl::MutexLock lock(&proc_events_mutex_);
+  exec_upids_.insert(children.begin(), children.end());
+}
+
+StatusOr<std::vector<bpf_tools::UProbeSpec>> UProbeManager::UProbeSpecsFromTmpl(
+    const ArrayView<UProbeTmpl>& probe_tmpls, const std::string& binary,
+    obj_tools::ElfReader* elf_reader) {
   using bpf_tools::BPFProbeAttachType;
 
-  int uprobe_count = 0;
+  std::vector<bpf_tools::UProbeSpec> specs;
   for (const auto& tmpl : probe_tmpls) {
     bpf_tools::UProbeSpec spec = {binary,
                                   {},
@@ -95,8 +194,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
         case BPFProbeAttachType::kEntry:
         case BPFProbeAttachType::kReturn: {
           spec.symbol = symbol_info.name;
-          PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-          ++uprobe_count;
+          specs.push_back(spec);
           break;
         }
         case BPFProbeAttachType::kReturnInsts: {
@@ -113,8 +211,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
           for (const uint64_t& addr : ret_inst_addrs) {
             spec.attach_type = BPFProbeAttachType::kEntry;
             spec.address = addr;
-            PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-            ++uprobe_count;
+            specs.push_back(spec);
           }
           break;
         }
@@ -123,48 +220,27 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
       }
     }
   }
-  return uprobe_count;
-}
-
-Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
-
-  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
-
-  return Status::OK();
+  return specs;
 }
 
-Status UProbeManager::UpdateGoCommonSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                             const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_common_symaddrs_t symaddrs,
-                      GoCommonSymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_common_symaddrs_map_->UpdateValue(pid, symaddrs);
+StatusOr<int> UProbeManager::AttachUProbeSpecs(const std::vector<bpf_tools::UProbeSpec>& specs) {
+  for (const auto& spec : specs) {
+    PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
   }
-
-  return Status::OK();
+  return specs.size();
 }
 
-Status UProbeManager::UpdateGoHTTP2SymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                            const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_http2_symaddrs_t symaddrs,
-                      GoHTTP2SymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_http2_symaddrs_map_->UpdateValue(pid, symaddrs);
+Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
+  // Detecting the OpenSSL version dlopen()s the library, so cache the result per library.
+  PL_ASSIGN_OR_RETURN(std::string cache_key, BinaryCacheKey(libcrypto_path));
+  std::optional<struct openssl_symaddrs_t> symaddrs = openssl_symaddrs_cache_.Lookup(cache_key);
+  if (!symaddrs.has_value()) {
+    PL_ASSIGN_OR_RETURN(symaddrs, OpenSSLSymAddrs(libcrypto_path));
+    openssl_symaddrs_cache_.Insert(cache_key, symaddrs.value());
+    symaddrs_cache_dirty_ = true;
   }
 
-  return Status::OK();
-}
-
-Status UProbeManager::UpdateGoTLSSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                          const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_tls_symaddrs_t symaddrs, GoTLSSymAddrs(elf_reader, dwarf_reader));
-
-  for (auto& pid : pids) {
-    go_tls_symaddrs_map_->UpdateValue(pid, symaddrs);
-  }
+  openssl_symaddrs_map_->UpdateValue(pid, symaddrs.value());
 
   return Status::OK();
 }
@@ -259,121 +335,312 @@ StatusOr<int> UProbeManager::AttachOpenSSLUProbes(uint32_t pid) {
 
   PL_RETURN_IF_ERROR(UpdateOpenSSLSymAddrs(container_libcrypto, pid));
 
-  // Only try probing .so files that we haven't already set probes on.
-  auto result = openssl_probed_binaries_.insert(container_libssl);
+  // Only try probing .so files that we haven't already set probes on. The library is keyed by its
+  // inode, since containers sharing an image layer reach the same file through different paths.
+  PL_ASSIGN_OR_RETURN(BinaryKey libssl_key, GetBinaryKey(container_libssl));
+  auto result = openssl_probed_binaries_.insert(libssl_key);
   if (!result.second) {
     return 0;
   }
 
-  for (auto spec : kOpenSSLUProbes) {
+  // do_ssl3_write() is internal to libssl, so it's only found in builds that keep their symbol
+  // table, or through installed debug symbols. Fall back to the SSL_write() pair otherwise.
+  std::optional<int64_t> do_ssl3_write_addr;
+  if (FLAGS_stirling_openssl_record_layer_probes) {
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader,
+                        ElfReader::Create(container_libssl.string()));
+    do_ssl3_write_addr = elf_reader->SymbolAddress("do_ssl3_write");
+  }
+
+  if (!do_ssl3_write_addr.has_value()) {
+    for (auto spec : kOpenSSLUProbes) {
+      spec.binary_path = container_libssl.string();
+      PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
+    }
+    return kOpenSSLUProbes.size();
+  }
+
+  for (auto spec : kOpenSSLRecordLayerUProbes) {
     spec.binary_path = container_libssl.string();
+    if (spec.symbol == "do_ssl3_write") {
+      spec.symbol.clear();
+      spec.address = do_ssl3_write_addr.value();
+    }
     PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
   }
-  return kOpenSSLUProbes.size();
+  return kOpenSSLRecordLayerUProbes.size();
 }
 
-StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
-                                                obj_tools::ElfReader* elf_reader,
-                                                obj_tools::DwarfReader* dwarf_reader,
-                                                const std::vector<int32_t>& pids) {
-  // Step 1: Update BPF symbols_map on all new PIDs.
-  Status s = UpdateGoTLSSymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
-    // Doesn't appear to be a binary with the mandatory symbols.
-    // Might not even be a golang binary.
-    // Either way, not of interest to probe.
-    return 0;
+std::optional<GoSymAddrs> UProbeManager::GoSymAddrsFromCacheOrDWARF(const std::string& binary,
+                                                                    ElfReader* elf_reader) {
+  StatusOr<std::string> cache_key_status = BinaryCacheKey(binary, elf_reader);
+  if (cache_key_status.ok()) {
+    std::optional<GoSymAddrs> cached = go_symaddrs_cache_.Lookup(cache_key_status.ValueOrDie());
+    if (cached.has_value()) {
+      return cached;
+    }
   }
 
-  // Step 2: Deploy uprobes on all new binaries.
-  auto result = go_tls_probed_binaries_.insert(binary);
-  if (!result.second) {
-    // This is not a new binary, so nothing more to do.
-    return 0;
+  // Only a few dozen names are looked up, so index lazily rather than the whole binary.
+  StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status =
+      DwarfReader::Create(binary, DwarfReader::IndexMode::kLazy);
+  if (!dwarf_reader_status.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
+        "Message = $1",
+        binary, dwarf_reader_status.msg());
+    return std::nullopt;
+  }
+  std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+
+  // A binary missing the symbols of a probe type is not an error; it is cached as nullopt.
+  GoSymAddrs symaddrs;
+  StatusOr<struct go_common_symaddrs_t> common_status =
+      GoCommonSymAddrs(elf_reader, dwarf_reader.get());
+  if (common_status.ok()) {
+    symaddrs.common = common_status.ConsumeValueOrDie();
+  }
+  StatusOr<struct go_tls_symaddrs_t> tls_status = GoTLSSymAddrs(elf_reader, dwarf_reader.get());
+  if (tls_status.ok()) {
+    symaddrs.tls = tls_status.ConsumeValueOrDie();
+  }
+  StatusOr<struct go_http2_symaddrs_t> http2_status =
+      GoHTTP2SymAddrs(elf_reader, dwarf_reader.get());
+  if (http2_status.ok()) {
+    symaddrs.http2 = http2_status.ConsumeValueOrDie();
+  }
+
+  if (cache_key_status.ok()) {
+    go_symaddrs_cache_.Insert(cache_key_status.ValueOrDie(), symaddrs);
+    symaddrs_cache_dirty_ = true;
   }
-  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader);
+  return symaddrs;
 }
 
-// TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
-// That allows the BPF code and companion user-space code for uprobe & kprobe be separated
-// cleanly. For example, right now, enabling uprobe & kprobe simultaneously can crash Stirling,
-// because of the mixed & duplicate data events from these 2 sources.
-StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
-                                                 obj_tools::ElfReader* elf_reader,
-                                                 obj_tools::DwarfReader* dwarf_reader,
-                                                 const std::vector<int32_t>& pids) {
-  // Step 1: Update BPF symaddrs for this binary.
-  Status s = UpdateGoHTTP2SymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
-    return 0;
+std::optional<UProbeManager::GoBinaryAnalysis> UProbeManager::AnalyzeGoBinary(
+    const std::string& binary) {
+  // Read binary's symbols.
+  StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
+  if (!elf_reader_status.ok()) {
+    LOG(WARNING) << absl::Substitute(
+        "Cannot analyze binary $0 for uprobe deployment. "
+        "If file is under /var/lib, container may have terminated. "
+        "Message = $1",
+        binary, elf_reader_status.msg());
+    return std::nullopt;
+  }
+  std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
+
+  // Avoid going passed this point if not a golang program.
+  // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
+  // TODO(oazizi): Consolidate with similar check in dynamic_tracing/autogen.cc.
+  bool is_golang_binary = elf_reader->SymbolAddress("runtime.buildVersion").has_value();
+  if (!is_golang_binary) {
+    return std::nullopt;
+  }
+
+  std::optional<GoSymAddrs> symaddrs = GoSymAddrsFromCacheOrDWARF(binary, elf_reader.get());
+  if (!symaddrs.has_value()) {
+    return std::nullopt;
+  }
+
+  if (!symaddrs->common.has_value()) {
+    VLOG(1) << absl::Substitute(
+        "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+    return std::nullopt;
+  }
+
+  GoBinaryAnalysis analysis;
+  analysis.common_symaddrs = symaddrs->common.value();
+
+  // GoTLS Probes.
+  // If the binary does not have the symbols required by the probes (it might not use TLS),
+  // it is not of interest to probe.
+  if (symaddrs->tls.has_value()) {
+    StatusOr<std::vector<bpf_tools::UProbeSpec>> specs_status =
+        UProbeSpecsFromTmpl(kGoTLSUProbeTmpls, binary, elf_reader.get());
+    if (!specs_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
+                                                   binary, specs_status.ToString());
+    } else {
+      analysis.tls_symaddrs = symaddrs->tls;
+      analysis.tls_probes = specs_status.ConsumeValueOrDie();
+    }
+  }
+
+  // Go HTTP2 Probes.
+  if (cfg_enable_http2_tracing_ && symaddrs->http2.has_value()) {
+    StatusOr<std::vector<bpf_tools::UProbeSpec>> specs_status =
+        UProbeSpecsFromTmpl(kHTTP2ProbeTmpls, binary, elf_reader.get());
+    if (!specs_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
+                                                   binary, specs_status.ToString());
+    } else {
+      analysis.http2_symaddrs = symaddrs->http2;
+      analysis.http2_probes = specs_status.ConsumeValueOrDie();
+    }
+  }
+
+  return analysis;
+}
+
+int UProbeManager::AttachGoUProbes(const BinaryPIDs& binary, const GoBinaryAnalysis& analysis) {
+  int uprobe_count = 0;
+
+  // Step 1: Update BPF symaddrs maps on all new PIDs.
+  for (const int32_t pid : binary.pids) {
+    go_common_symaddrs_map_->UpdateValue(pid, analysis.common_symaddrs);
+    if (analysis.tls_symaddrs.has_value()) {
+      go_tls_symaddrs_map_->UpdateValue(pid, analysis.tls_symaddrs.value());
+    }
+    if (analysis.http2_symaddrs.has_value()) {
+      go_http2_symaddrs_map_->UpdateValue(pid, analysis.http2_symaddrs.value());
+    }
   }
 
   // Step 2: Deploy uprobes on all new binaries.
-  auto result = go_http2_probed_binaries_.insert(binary);
-  if (!result.second) {
-    // This is not a new binary, so nothing more to do.
-    return 0;
+  if (analysis.tls_symaddrs.has_value() && go_tls_probed_binaries_.insert(binary.key).second) {
+    StatusOr<int> attach_status = AttachUProbeSpecs(analysis.tls_probes);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
+                                                   binary.path, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
+  }
+
+  // TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
+  // That allows the BPF code and companion user-space code for uprobe & kprobe be separated
+  // cleanly. For example, right now, enabling uprobe & kprobe simultaneously can crash Stirling,
+  // because of the mixed & duplicate data events from these 2 sources.
+  if (analysis.http2_symaddrs.has_value() &&
+      go_http2_probed_binaries_.insert(binary.key).second) {
+    StatusOr<int> attach_status = AttachUProbeSpecs(analysis.http2_probes);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
+                                                   binary.path, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
   }
-  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader);
+
+  return uprobe_count;
 }
 
-namespace {
+StatusOr<UProbeManager::BinaryKey> UProbeManager::GetBinaryKey(
+    const std::filesystem::path& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0, errno: $1", path.string(), errno);
+  }
+  constexpr int64_t kNanosPerSec = 1000 * 1000 * 1000;
+  return BinaryKey(st.st_dev, st.st_ino, st.st_mtim.tv_sec * kNanosPerSec + st.st_mtim.tv_nsec,
+                   st.st_ctim.tv_sec * kNanosPerSec + st.st_ctim.tv_nsec);
+}
 
-// Convert PID list from list of UPIDs to a map with key=binary name, value=PIDs
-std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
-    const absl::flat_hash_set<md::UPID>& upids, LazyLoadedFPResolver* fp_resolver) {
+std::vector<UProbeManager::BinaryPIDs> UProbeManager::GroupPIDsByBinary(
+    const absl::flat_hash_set<md::UPID>& upids) {
   const system::Config& sysconfig = system::Config::GetInstance();
 
-  // Convert to a map of binaries, with the upids that are instances of that binary.
-  std::map<std::string, std::vector<int32_t>> pids;
+  // Convert to a list of binaries, with the upids that are instances of that binary.
+  absl::flat_hash_map<BinaryKey, BinaryPIDs> binaries;
 
   for (const auto& upid : upids) {
     PL_ASSIGN_OR(std::filesystem::path proc_exe, ProcExe(upid.pid()), continue);
 
-    Status s = fp_resolver->SetMountNamespace(upid.pid());
+    Status s = fp_resolver_.SetMountNamespace(upid.pid());
     if (!s.ok()) {
       VLOG(1) << absl::Substitute("Could not set pid namespace. Did the pid terminate?");
       continue;
     }
 
-    PL_ASSIGN_OR(std::filesystem::path exe_path, fp_resolver->ResolvePath(proc_exe), continue);
+    PL_ASSIGN_OR(std::filesystem::path exe_path, fp_resolver_.ResolvePath(proc_exe), continue);
 
     std::filesystem::path host_exe_path = sysconfig.ToHostPath(exe_path);
-    if (!fs::Exists(host_exe_path).ok()) {
-      continue;
+    PL_ASSIGN_OR(const BinaryKey key, GetBinaryKey(host_exe_path), continue);
+    BinaryPIDs& binary = binaries[key];
+    if (binary.pids.empty()) {
+      binary.path = host_exe_path.string();
+      binary.key = key;
     }
-    pids[host_exe_path.string()].push_back(upid.pid());
+    binary.pids.push_back(upid.pid());
+    binary.upids.push_back(upid);
+    binary.latest_start_ts = std::max(binary.latest_start_ts, upid.start_ts());
   }
 
-  VLOG(1) << absl::Substitute("New PIDs count = $0", pids.size());
+  VLOG(1) << absl::Substitute("New PIDs count = $0", binaries.size());
 
-  return pids;
+  std::vector<BinaryPIDs> result;
+  result.reserve(binaries.size());
+  for (auto& [key, binary] : binaries) {
+    result.push_back(std::move(binary));
+  }
+  std::sort(result.begin(), result.end(), [](const BinaryPIDs& a, const BinaryPIDs& b) {
+    return a.latest_start_ts > b.latest_start_ts;
+  });
+  return result;
 }
 
-}  // namespace
-
-std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids) {
+std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                                  uint64_t epoch) {
   // Increment before starting thread to avoid race in case thread starts late.
   ++num_deploy_uprobes_threads_;
-  return std::thread([this, pids]() {
-    DeployUProbes(pids);
+  return std::thread([this, pids, epoch]() {
+    DeployUProbes(pids, epoch);
     --num_deploy_uprobes_threads_;
   });
   return {};
 }
 
+std::thread UProbeManager::RunDeployUProbesFromDeltaThread(absl::flat_hash_set<md::UPID> added,
+                                                           absl::flat_hash_set<md::UPID> removed,
+                                                           uint64_t epoch) {
+  // Increment before starting thread to avoid race in case thread starts late.
+  ++num_deploy_uprobes_threads_;
+  return std::thread([this, added = std::move(added), removed = std::move(removed), epoch]() {
+    DeployUProbesFromDelta(added, removed, epoch);
+    --num_deploy_uprobes_threads_;
+  });
+}
+
+std::thread UProbeManager::RunDeployUProbesFromProcEventsThread(uint32_t asid) {
+  // Increment before starting thread to avoid race in case thread starts late.
+  ++num_deploy_uprobes_threads_;
+  return std::thread([this, asid]() {
+    DeployUProbesFromProcEvents(asid);
+    --num_deploy_uprobes_threads_;
+  });
+}
+
 void UProbeManager::CleanupSymaddrMaps(const absl::flat_hash_set<md::UPID>& deleted_upids) {
   for (const auto& pid : deleted_upids) {
     openssl_symaddrs_map_->RemoveValue(pid.pid());
     go_common_symaddrs_map_->RemoveValue(pid.pid());
     go_tls_symaddrs_map_->RemoveValue(pid.pid());
     go_http2_symaddrs_map_->RemoveValue(pid.pid());
+
+    auto upid_iter = go_upid_binaries_.find(pid);
+    if (upid_iter == go_upid_binaries_.end()) {
+      continue;
+    }
+    auto num_upids_iter = go_binary_num_upids_.find(upid_iter->second);
+    if (num_upids_iter != go_binary_num_upids_.end() && --num_upids_iter->second == 0) {
+      go_binary_analyses_.erase(num_upids_iter->first);
+      go_binary_num_upids_.erase(num_upids_iter);
+    }
+    go_upid_binaries_.erase(upid_iter);
   }
 }
 
-int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& upids) {
   int uprobe_count = 0;
 
+  // Deploy on the most recently started processes first.
+  std::vector<md::UPID> pids(upids.begin(), upids.end());
+  std::sort(pids.begin(), pids.end(), [](const md::UPID& a, const md::UPID& b) {
+    return a.start_ts() > b.start_ts();
+  });
+
   for (const auto& pid : pids) {
     if (cfg_disable_self_probing_ && pid.pid() == static_cast<uint32_t>(getpid())) {
       continue;
@@ -398,80 +665,59 @@ int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
 
   static int32_t kPID = getpid();
 
-  for (const auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
-    // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
-    if (!scanned_binaries_.insert(binary).second) {
-      continue;
-    }
+  std::vector<BinaryPIDs> binaries = GroupPIDsByBinary(pids);
 
+  // Find the binaries that have not been analyzed before;
+  // the others only need their new PIDs added to the symaddrs maps.
+  std::vector<const BinaryPIDs*> binaries_to_analyze;
+  for (const auto& binary : binaries) {
     if (cfg_disable_self_probing_) {
       // Don't try to attach uprobes to self.
       // This speeds up stirling_wrapper initialization significantly.
-      if (pid_vec.size() == 1 && pid_vec[0] == kPID) {
+      if (binary.pids.size() == 1 && binary.pids[0] == kPID) {
         continue;
       }
     }
-
-    // Read binary's symbols.
-    StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
-    if (!elf_reader_status.ok()) {
-      LOG(WARNING) << absl::Substitute(
-          "Cannot analyze binary $0 for uprobe deployment. "
-          "If file is under /var/lib, container may have terminated. "
-          "Message = $1",
-          binary, elf_reader_status.msg());
-      continue;
-    }
-    std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
-
-    // Avoid going passed this point if not a golang program.
-    // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
-    // TODO(oazizi): Consolidate with similar check in dynamic_tracing/autogen.cc.
-    bool is_golang_binary = elf_reader->SymbolAddress("runtime.buildVersion").has_value();
-    if (!is_golang_binary) {
-      continue;
+    if (go_binary_analyses_.contains(binary.key)) {
+      absl::MutexLock lock(&stats_mutex_);
+      stats_.Increment(StatKey::kGoBinaryAnalysisCacheHits);
+    } else {
+      binaries_to_analyze.push_back(&binary);
     }
+  }
 
-    StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status = DwarfReader::Create(binary);
-    if (!dwarf_reader_status.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
-          "Message = $1",
-          binary, dwarf_reader_status.msg());
-      continue;
-    }
-    std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+  // Reading ELF & DWARF info dominates deployment time, and does not touch BCC,
+  // so it is done in parallel. Binaries are sorted by most recent process start time,
+  // so the newest processes are analyzed first.
+  std::vector<std::optional<GoBinaryAnalysis>> analyses(binaries_to_analyze.size());
+  analysis_pool_->ParallelFor(binaries_to_analyze.size(),
+                              [this, &binaries_to_analyze, &analyses](size_t i) {
+                                analyses[i] = AnalyzeGoBinary(binaries_to_analyze[i]->path);
+                              });
+  for (size_t i = 0; i < binaries_to_analyze.size(); ++i) {
+    go_binary_analyses_[binaries_to_analyze[i]->key] = std::move(analyses[i]);
+  }
+  {
+    absl::MutexLock lock(&stats_mutex_);
+    stats_.Increment(StatKey::kGoBinariesAnalyzed, static_cast<int>(binaries_to_analyze.size()));
+  }
 
-    Status s = UpdateGoCommonSymAddrs(elf_reader.get(), dwarf_reader.get(), pid_vec);
-    if (!s.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+  // BCC is not thread-safe, so the BPF maps are updated and the probes attached serially.
+  for (const auto& binary : binaries) {
+    const auto iter = go_binary_analyses_.find(binary.key);
+    if (iter == go_binary_analyses_.end()) {
       continue;
     }
-
-    // GoTLS Probes.
-    {
-      StatusOr<int> attach_status =
-          AttachGoTLSUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    // Track the processes of the binary, so its analysis is evicted when they have all exited.
+    for (const auto& upid : binary.upids) {
+      if (go_upid_binaries_.emplace(upid, binary.key).second) {
+        ++go_binary_num_upids_[binary.key];
       }
     }
-
-    // Go HTTP2 Probes.
-    if (cfg_enable_http2_tracing_) {
-      StatusOr<int> attach_status =
-          AttachGoHTTP2Probes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
-      }
+    if (!iter->second.has_value()) {
+      continue;
     }
+    uprobe_count += AttachGoUProbes(binary, iter->second.value());
   }
 
   return uprobe_count;
@@ -523,11 +769,98 @@ absl::flat_hash_set<md::UPID> UProbeManager::PIDsToRescanForUProbes() {
   return upids_to_rescan;
 }
 
-void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+void UProbeManager::RecordDeployLatency(std::chrono::milliseconds latency) {
+  absl::MutexLock lock(&stats_mutex_);
+  stats_.Increment(StatKey::kDeployBatches);
+  stats_.Reset(StatKey::kLastDeployLatencyMillis);
+  const int latency_ms = static_cast<int>(latency.count());
+  stats_.Increment(StatKey::kLastDeployLatencyMillis, latency_ms);
+  stats_.Increment(StatKey::kTotalDeployLatencyMillis, latency_ms);
+  if (latency_ms > stats_.Get(StatKey::kMaxDeployLatencyMillis)) {
+    stats_.Reset(StatKey::kMaxDeployLatencyMillis);
+    stats_.Increment(StatKey::kMaxDeployLatencyMillis, latency_ms);
+  }
+}
+
+std::string UProbeManager::StatsString() const {
+  absl::MutexLock lock(&stats_mutex_);
+  return stats_.Print();
+}
+
+void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids, uint64_t epoch) {
+  const std::lock_guard<std::mutex> lock(deploy_uprobes_mutex_);
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  ResolveProcForkEvents();
+  {
+    absl::MutexLock events_lock(&proc_events_mutex_);
+    // Drop the events that are already reflected in pids. The remaining ones likely happened
+    // after pids was listed, so they are kept for the next deployment, unless the process has
+    // exited since: its exit isn't listed either, and would be dropped below.
+    const uint32_t asid = pids.empty() ? 0 : pids.begin()->asid();
+    for (auto iter = exec_upids_.begin(); iter != exec_upids_.end();) {
+      bool listed = pids.contains(md::UPID(asid, iter->pid, iter->start_time_ticks));
+      if (listed || exit_upids_.contains(*iter)) {
+        exec_upids_.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+    for (auto iter = exit_upids_.begin(); iter != exit_upids_.end();) {
+      bool listed = pids.contains(md::UPID(asid, iter->pid, iter->start_time_ticks));
+      if (!listed) {
+        exit_upids_.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  proc_tracker_.Update(pids, epoch);
+
+  DeployUProbesOnNewUPIDs(start_time);
+}
+
+void UProbeManager::DeployUProbesFromDelta(const absl::flat_hash_set<md::UPID>& added,
+                                           const absl::flat_hash_set<md::UPID>& removed,
+                                           uint64_t epoch) {
+  const std::lock_guard<std::mutex> lock(deploy_uprobes_mutex_);
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  proc_tracker_.UpdateFromEvents(added, removed, epoch);
+
+  DeployUProbesOnNewUPIDs(start_time);
+}
+
+void UProbeManager::DeployUProbesFromProcEvents(uint32_t asid) {
   const std::lock_guard<std::mutex> lock(deploy_uprobes_mutex_);
 
-  proc_tracker_.Update(pids);
+  const auto start_time = std::chrono::steady_clock::now();
+
+  ResolveProcForkEvents();
+
+  absl::flat_hash_set<md::UPID> started;
+  absl::flat_hash_set<md::UPID> terminated;
+  {
+    absl::MutexLock events_lock(&proc_events_mutex_);
+    for (const auto& upid : exec_upids_) {
+      started.emplace(asid, upid.pid, upid.start_time_ticks);
+    }
+    for (const auto& upid : exit_upids_) {
+      terminated.emplace(asid, upid.pid, upid.start_time_ticks);
+    }
+    exec_upids_.clear();
+    exit_upids_.clear();
+  }
 
+  proc_tracker_.UpdateFromEvents(started, terminated);
+
+  DeployUProbesOnNewUPIDs(start_time);
+}
+
+void UProbeManager::DeployUProbesOnNewUPIDs(std::chrono::steady_clock::time_point start_time) {
   // Before deploying new probes, clean-up map entries for old processes that are now dead.
   CleanupSymaddrMaps(proc_tracker_.deleted_upids());
 
@@ -542,8 +875,15 @@ void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
   }
   uprobe_count += DeployGoUProbes(proc_tracker_.new_upids());
 
+  const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  RecordDeployLatency(latency);
+
+  SaveSymAddrsCaches();
+
   if (uprobe_count != 0) {
-    LOG(INFO) << absl::Substitute("Number of uprobes deployed = $0", uprobe_count);
+    LOG(INFO) << absl::Substitute("Number of uprobes deployed = $0 (in $1 ms)", uprobe_count,
+                                  latency.count());
   }
 }
 
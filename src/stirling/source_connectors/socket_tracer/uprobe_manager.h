@@ -18,25 +18,35 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include <absl/synchronization/mutex.h>
 
+#include "src/common/base/worker_pool.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/dwarf_tools.h"
 #include "src/stirling/obj_tools/elf_tools.h"
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/source_connectors/socket_tracer/uprobe_symaddrs.h"
 
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
+#include "src/stirling/utils/stat_counter.h"
 
 DECLARE_bool(stirling_rescan_for_dlopen);
 DECLARE_double(stirling_rescan_exp_backoff_factor);
+DECLARE_int32(stirling_uprobe_analysis_threads);
+DECLARE_uint32(stirling_symaddrs_cache_size);
+DECLARE_string(stirling_symaddrs_cache_dir);
+DECLARE_bool(stirling_openssl_record_layer_probes);
 
 namespace px {
 namespace stirling {
@@ -114,20 +124,122 @@ class UProbeManager {
    */
   void NotifyMMapEvent(upid_t upid);
 
+  /**
+   * Notify uprobe manager of a process exec or exit event. These events are accumulated, and
+   * used to track new and terminated processes between full deployments (see
+   * RunDeployUProbesFromProcEventsThread()).
+   * @param upid UPID of the process that exec'ed or exited.
+   */
+  void NotifyProcExecEvent(upid_t upid);
+  void NotifyProcExitEvent(upid_t upid);
+
+  /**
+   * Notify uprobe manager of a fork/clone. A forked child runs the binary of its parent without
+   * an exec, so it needs the same symaddrs. The child is resolved into a UPID, or skipped if it
+   * is a thread, by the next deployment.
+   * @param parent_tgid The process that forked.
+   * @param child_pid The new process or thread.
+   */
+  void NotifyProcForkEvent(uint32_t parent_tgid, uint32_t child_pid);
+
+  /**
+   * Notify uprobe manager that process exec/exit events were lost. The accumulated events are
+   * then incomplete, and the next deployment should be given the full set of pids.
+   */
+  void NotifyProcEventLoss();
+
+  /**
+   * Returns true if process events were lost since the last call, and resets the flag. The flag
+   * is taken before the UPIDs to reconcile against are listed, so a loss that happens in
+   * between is reported again rather than being cleared by the reconciliation.
+   */
+  bool TakeProcEventsLost() { return proc_events_lost_.exchange(false); }
+
   /**
    * Runs the uprobe deployment code on the provided set of pids, as a thread.
    * @param pids New PIDs to analyze deploy uprobes on. Old PIDs can also be provided,
    *             if they need to be rescanned.
+   * @param epoch The epoch of pids (see ConnectorContext::GetUPIDsEpoch()), or 0 if unversioned.
+   * @return thread that handles the uprobe deployment work.
+   */
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                     uint64_t epoch = 0);
+
+  /**
+   * Runs the uprobe deployment code as a thread, on the processes added and removed since the
+   * last deployment, as versioned by upids_epoch().
+   * @param added The UPIDs added since upids_epoch().
+   * @param removed The UPIDs removed since upids_epoch().
+   * @param epoch The epoch of the UPIDs after the changes.
    * @return thread that handles the uprobe deployment work.
    */
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesFromDeltaThread(absl::flat_hash_set<md::UPID> added,
+                                              absl::flat_hash_set<md::UPID> removed,
+                                              uint64_t epoch);
+
+  /**
+   * The epoch of the UPIDs of the last deployment, or 0 if they are not versioned.
+   * Only meaningful while no deployment thread is running.
+   */
+  uint64_t upids_epoch() const { return proc_tracker_.epoch(); }
+
+  /**
+   * Runs the uprobe deployment code as a thread, on the processes that exec'ed or exited since
+   * the last deployment, as reported via NotifyProcExecEvent() and NotifyProcExitEvent().
+   * Cheaper than RunDeployUProbesThread(), which should still be called periodically with the
+   * full set of pids, to reconcile against any missed events.
+   * @param asid The ASID of the processes.
+   * @return thread that handles the uprobe deployment work.
+   */
+  std::thread RunDeployUProbesFromProcEventsThread(uint32_t asid);
 
   /**
    * Returns true if a previously dispatched thread (via RunDeployUProbesThread is still running).
    */
   bool ThreadsRunning() { return num_deploy_uprobes_threads_ != 0; }
 
+  enum class StatKey {
+    kDeployBatches,
+    // Go binaries whose ELF/DWARF info was read, vs. found in the analysis cache.
+    kGoBinariesAnalyzed,
+    kGoBinaryAnalysisCacheHits,
+    // Wall time of DeployUProbes() calls.
+    kLastDeployLatencyMillis,
+    kMaxDeployLatencyMillis,
+    kTotalDeployLatencyMillis,
+  };
+
+  std::string StatsString() const;
+
  private:
+  // Identifies a binary file by its device and inode, so that the same binary
+  // reached through different (e.g. per-container) paths is only analyzed and probed once.
+  // The modification and change times are part of the key, so that a binary that is replaced in
+  // place, or a new binary that reuses a deleted binary's inode, is analyzed again.
+  using BinaryKey = std::tuple<uint64_t, uint64_t, int64_t, int64_t>;
+  static StatusOr<BinaryKey> GetBinaryKey(const std::filesystem::path& path);
+
+  // A binary and the new PIDs that are instances of it.
+  struct BinaryPIDs {
+    std::string path;
+    BinaryKey key;
+    std::vector<int32_t> pids;
+    std::vector<md::UPID> upids;
+    // The most recent start time among the PIDs; used to deploy on new processes first.
+    int64_t latest_start_ts = 0;
+  };
+
+  // What is needed to deploy Go uprobes on a binary, extracted from its ELF & DWARF info.
+  // Computing this is the expensive part of deployment, and does not touch BCC,
+  // so it is done in parallel across binaries, and at most once per binary.
+  struct GoBinaryAnalysis {
+    struct go_common_symaddrs_t common_symaddrs;
+    std::optional<struct go_tls_symaddrs_t> tls_symaddrs;
+    std::optional<struct go_http2_symaddrs_t> http2_symaddrs;
+    std::vector<bpf_tools::UProbeSpec> tls_probes;
+    std::vector<bpf_tools::UProbeSpec> http2_probes;
+  };
+
   inline static constexpr auto kHTTP2ProbeTmpls = MakeArray<UProbeTmpl>({
       // Probes on Golang net/http2 library.
       UProbeTmpl{
@@ -238,11 +350,62 @@ class UProbeManager {
       },
   });
 
+  // Probes for OpenSSL tracing, on libssl builds where the record layer can be probed.
+  // Writes are captured by the do_ssl3_write() pair (attached by address, see
+  // AttachOpenSSLUProbes()), instead of the SSL_write() pair.
+  inline static const auto kOpenSSLRecordLayerUProbes = MakeArray<bpf_tools::UProbeSpec>({
+      bpf_tools::UProbeSpec{
+          .binary_path = "/usr/lib/x86_64-linux-gnu/libssl.so.1.1",
+          .symbol = "do_ssl3_write",
+          .attach_type = bpf_tools::BPFProbeAttachType::kEntry,
+          .probe_fn = "probe_entry_do_ssl3_write",
+      },
+      bpf_tools::UProbeSpec{
+          .binary_path = "/usr/lib/x86_64-linux-gnu/libssl.so.1.1",
+          .symbol = "do_ssl3_write",
+          .attach_type = bpf_tools::BPFProbeAttachType::kReturn,
+          .probe_fn = "probe_ret_do_ssl3_write",
+      },
+      bpf_tools::UProbeSpec{
+          .binary_path = "/usr/lib/x86_64-linux-gnu/libssl.so.1.1",
+          .symbol = "SSL_read",
+          .attach_type = bpf_tools::BPFProbeAttachType::kEntry,
+          .probe_fn = "probe_entry_SSL_read",
+      },
+      bpf_tools::UProbeSpec{
+          .binary_path = "/usr/lib/x86_64-linux-gnu/libssl.so.1.1",
+          .symbol = "SSL_read",
+          .attach_type = bpf_tools::BPFProbeAttachType::kReturn,
+          .probe_fn = "probe_ret_SSL_read",
+      },
+  });
+
   /**
    * Deploys all available uprobe types (HTTP2, OpenSSL, etc.) on new processes.
    * @param pids The list of pids to analyze and instrument with uprobes, if appropriate.
+   * @param epoch The epoch of pids, or 0 if unversioned.
    */
-  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids);
+  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids, uint64_t epoch);
+
+  /**
+   * Deploys all available uprobe types on the processes added since the last deployment,
+   * and cleans up after the removed ones.
+   */
+  void DeployUProbesFromDelta(const absl::flat_hash_set<md::UPID>& added,
+                              const absl::flat_hash_set<md::UPID>& removed, uint64_t epoch);
+
+  /**
+   * Deploys all available uprobe types on processes that exec'ed since the last deployment,
+   * and cleans up after processes that exited.
+   * @param asid The ASID of the processes.
+   */
+  void DeployUProbesFromProcEvents(uint32_t asid);
+
+  /**
+   * Deploys uprobes on the new processes in proc_tracker_, after it has been updated.
+   * @param start_time Start of the deployment, for latency stats.
+   */
+  void DeployUProbesOnNewUPIDs(std::chrono::steady_clock::time_point start_time);
 
   /**
    * Deploys all OpenSSL uprobes on new processes.
@@ -259,37 +422,28 @@ class UProbeManager {
   int DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids);
 
   /**
-   * Attaches the required probes for Go HTTP2 tracing to the specified binary, if it is a
-   * compatible Go binary.
+   * Reads the ELF & DWARF info of a binary, and extracts what is needed to deploy Go uprobes.
+   * Does not access BCC, so it may be called concurrently for different binaries.
    *
-   * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
-   * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
-   *             addresses.
-   * @return The number of uprobes deployed, or error. It is not considered an error if the binary
-   *         is not a Go binary or doesn't use a Go HTTP2 library; instead the return value will be
-   *         zero.
+   * @param binary The path to the binary to analyze.
+   * @return The analysis, or nullopt if the binary is not a Go binary with the mandatory symbols.
+   */
+  std::optional<GoBinaryAnalysis> AnalyzeGoBinary(const std::string& binary);
+
+  /**
+   * Returns the symaddrs of a Go binary from go_symaddrs_cache_, or computes them from
+   * its DWARF info (and caches them). Returns nullopt if the DWARF info could not be read.
    */
-  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                    obj_tools::DwarfReader* dwarf_reader,
-                                    const std::vector<int32_t>& pids);
+  std::optional<GoSymAddrs> GoSymAddrsFromCacheOrDWARF(const std::string& binary,
+                                                       obj_tools::ElfReader* elf_reader);
 
   /**
-   * Attaches the required probes for GoTLS tracing to the specified binary, if it is a compatible
-   * Go binary.
+   * Populates the Go symaddrs BPF maps for the PIDs of an analyzed binary, and attaches
+   * the Go uprobes to the binary, if not already attached.
    *
-   * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
-   * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
-   *             addresses.
-   * @return The number of uprobes deployed, or error. It is not an error if the binary
-   *         is not a Go binary or doesn't use Go TLS; instead the return value will be zero.
+   * @return The number of uprobes deployed.
    */
-  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                   obj_tools::DwarfReader* dwarf_reader,
-                                   const std::vector<int32_t>& new_pids);
+  int AttachGoUProbes(const BinaryPIDs& binary, const GoBinaryAnalysis& analysis);
 
   /**
    * // Attaches the required probes for OpenSSL tracing to the specified PID, if it uses OpenSSL.
@@ -305,37 +459,50 @@ class UProbeManager {
   StatusOr<int> AttachOpenSSLUProbes(uint32_t pid);
 
   /**
-   * Helper function that calls BCCWrapper.AttachUprobe() from a probe template.
+   * Helper function that expands probe templates into the UProbeSpecs to attach.
    * Among other things, it finds all symbol matches as specified in the template,
-   * and attaches a probe per matching symbol.
+   * and creates a spec per matching symbol (or per return instruction).
    *
    * @param probe_tmpls Array of probe templates to process.
    * @param binary The binary to uprobe.
    * @param elf_reader Pointer to an elf reader for the binary. Used to find symbol matches.
-   * @return Number of uprobes deployed, or error if uprobes failed to deploy. Zero uprobes
-   *         deploying because there are no symbol matches is not considered an error.
+   * @return The specs, or error if the templates could not be expanded. No specs because
+   *         there are no symbol matches is not considered an error.
    */
-  StatusOr<int> AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                 const std::string& binary, obj_tools::ElfReader* elf_reader);
+  static StatusOr<std::vector<bpf_tools::UProbeSpec>> UProbeSpecsFromTmpl(
+      const ArrayView<UProbeTmpl>& probe_tmpls, const std::string& binary,
+      obj_tools::ElfReader* elf_reader);
+
+  /**
+   * Calls BCCWrapper.AttachUprobe() for each of the specs.
+   * @return Number of uprobes deployed, or error if uprobes failed to deploy.
+   */
+  StatusOr<int> AttachUProbeSpecs(const std::vector<bpf_tools::UProbeSpec>& specs);
+
+  // Groups new PIDs by the binary they are an instance of, most recently started first.
+  std::vector<BinaryPIDs> GroupPIDsByBinary(const absl::flat_hash_set<md::UPID>& upids);
+
+  void RecordDeployLatency(std::chrono::milliseconds latency);
 
   // Returns set of PIDs that have had mmap called on them since the last call.
   absl::flat_hash_set<md::UPID> PIDsToRescanForUProbes();
 
   Status UpdateOpenSSLSymAddrs(std::filesystem::path container_lib, uint32_t pid);
-  Status UpdateGoCommonSymAddrs(obj_tools::ElfReader* elf_reader,
-                                obj_tools::DwarfReader* dwarf_reader,
-                                const std::vector<int32_t>& pids);
-  Status UpdateGoHTTP2SymAddrs(obj_tools::ElfReader* elf_reader,
-                               obj_tools::DwarfReader* dwarf_reader,
-                               const std::vector<int32_t>& pids);
-  Status UpdateGoTLSSymAddrs(obj_tools::ElfReader* elf_reader, obj_tools::DwarfReader* dwarf_reader,
-                             const std::vector<int32_t>& pids);
+
+  // Load/save the symaddrs caches from/to FLAGS_stirling_symaddrs_cache_dir, if set.
+  void LoadSymAddrsCaches();
+  void SaveSymAddrsCaches();
 
   // Clean-up various BPF maps used to communicate symbol addresses per PID.
   // Once the PID has terminated, the information is not required anymore.
-  // Note that BPF maps can fill up if this is not done.
+  // Note that BPF maps can fill up if this is not done. Also evicts the Go binary analyses
+  // whose processes have all terminated.
   void CleanupSymaddrMaps(const absl::flat_hash_set<md::UPID>& deleted_upids);
 
+  // Turns the forked children that are processes into exec events, now that their start times
+  // can be read from /proc. Children that are threads, or that already exited, are dropped.
+  void ResolveProcForkEvents() ABSL_LOCKS_EXCLUDED(proc_events_mutex_);
+
   bpf_tools::BCCWrapper* bcc_;
 
   // Whether to try to uprobe ourself (e.g. for OpenSSL). Typically, we don't want to do that.
@@ -350,10 +517,22 @@ class UProbeManager {
 
   std::unique_ptr<system::ProcParser> proc_parser_;
   ProcTracker proc_tracker_;
+
+  // The threads that read the ELF & DWARF info of new binaries during deployment.
+  std::unique_ptr<WorkerPool> analysis_pool_;
   LazyLoadedFPResolver fp_resolver_;
 
   absl::flat_hash_set<upid_t> upids_with_mmap_;
 
+  // Process exec/exit events received since the last deployment.
+  // Written from the perf buffer callbacks, and consumed by the deployment thread.
+  absl::Mutex proc_events_mutex_;
+  absl::flat_hash_set<upid_t> exec_upids_ ABSL_GUARDED_BY(proc_events_mutex_);
+  absl::flat_hash_set<upid_t> exit_upids_ ABSL_GUARDED_BY(proc_events_mutex_);
+  // Forked children that are not resolved into UPIDs yet, with the tgid of their parent.
+  absl::flat_hash_map<uint32_t, uint32_t> fork_pids_ ABSL_GUARDED_BY(proc_events_mutex_);
+  std::atomic<bool> proc_events_lost_ = false;
+
   // Count the number of times PIDsToRescanForUProbes() has been called.
   int rescan_counter_ = 0;
 
@@ -365,10 +544,27 @@ class UProbeManager {
   // Records the binaries that have uprobes attached, so we don't try to probe them again.
   // TODO(oazizi): How should these sets be cleaned up of old binaries, once they are deleted?
   //               Without clean-up, these could consume more-and-more memory.
-  absl::flat_hash_set<std::string> openssl_probed_binaries_;
-  absl::flat_hash_set<std::string> scanned_binaries_;
-  absl::flat_hash_set<std::string> go_http2_probed_binaries_;
-  absl::flat_hash_set<std::string> go_tls_probed_binaries_;
+  absl::flat_hash_set<BinaryKey> openssl_probed_binaries_;
+  absl::flat_hash_set<BinaryKey> go_http2_probed_binaries_;
+  absl::flat_hash_set<BinaryKey> go_tls_probed_binaries_;
+
+  // Results of AnalyzeGoBinary() for every binary with a live process. Binaries that are not
+  // Go binaries are recorded as nullopt, so they are not scanned again. An analysis is evicted
+  // once all of the processes of its binary have exited.
+  absl::flat_hash_map<BinaryKey, std::optional<GoBinaryAnalysis>> go_binary_analyses_;
+  absl::flat_hash_map<md::UPID, BinaryKey> go_upid_binaries_;
+  absl::flat_hash_map<BinaryKey, int> go_binary_num_upids_;
+
+  // Symaddrs by binary content (see BinaryCacheKey()), bounded and optionally persisted.
+  // Unlike go_binary_analyses_, these survive restarts and apply across different files
+  // with the same contents.
+  SymAddrsCache<GoSymAddrs> go_symaddrs_cache_;
+  SymAddrsCache<struct openssl_symaddrs_t> openssl_symaddrs_cache_;
+  std::atomic<bool> symaddrs_cache_dirty_ = false;
+
+  // Written by the deploy thread, read by StatsString().
+  mutable absl::Mutex stats_mutex_;
+  utils::StatCounter<StatKey> stats_ ABSL_GUARDED_BY(stats_mutex_);
 
   // BPF maps through which the addresses of symbols for a given pid are communicated to uprobes.
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct openssl_symaddrs_t> >
@@ -18,8 +18,13 @@
 
 #include "src/stirling/source_connectors/socket_tracer/uprobe_symaddrs.h"
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
@@ -551,6 +556,12 @@ StatusOr<struct openssl_symaddrs_t> OpenSSLSymAddrs(const std::filesystem::path&
   constexpr int32_t kOpenSSL_1_1_0_RBIO_num_offset = 0x28;
   constexpr int32_t kOpenSSL_1_1_1_RBIO_num_offset = 0x30;
 
+  // Size of the elements of the pipelens argument of do_ssl3_write().
+  //  - In 1.1.1, pipelens is a size_t*.
+  //  - In 1.1.0, pipelens is an unsigned int*.
+  constexpr int32_t kOpenSSL_1_1_0_pipelen_size = sizeof(uint32_t);
+  constexpr int32_t kOpenSSL_1_1_1_pipelen_size = sizeof(uint64_t);
+
   struct openssl_symaddrs_t symaddrs;
   symaddrs.SSL_rbio_offset = kSSL_RBIO_offset;
 
@@ -558,9 +569,11 @@ StatusOr<struct openssl_symaddrs_t> OpenSSLSymAddrs(const std::filesystem::path&
   switch (openssl_fix_sub_version) {
     case 0:
       symaddrs.RBIO_num_offset = kOpenSSL_1_1_0_RBIO_num_offset;
+      symaddrs.do_ssl3_write_pipelen_size = kOpenSSL_1_1_0_pipelen_size;
       break;
     case 1:
       symaddrs.RBIO_num_offset = kOpenSSL_1_1_1_RBIO_num_offset;
+      symaddrs.do_ssl3_write_pipelen_size = kOpenSSL_1_1_1_pipelen_size;
       break;
     default:
       // Supported versions are checked in function OpenSSLFixSubversionNum(),
@@ -591,5 +604,77 @@ StatusOr<struct openssl_symaddrs_t> OpenSSLSymAddrs(const std::filesystem::path&
 // $28 = (int *) 0x55ea64698b40
 // (gdb) p s.wbio.num
 
+//-----------------------------------------------------------------------------
+// Symaddrs Cache
+//-----------------------------------------------------------------------------
+
+Status WriteFileAtomically(const std::filesystem::path& path, std::string_view contents) {
+  std::filesystem::path tmp_path = path;
+  tmp_path += absl::StrCat(".tmp.", getpid());
+
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return error::Internal("Could not create $0: $1", tmp_path.string(), std::strerror(errno));
+  }
+  Status s;
+  while (!contents.empty()) {
+    ssize_t n = write(fd, contents.data(), contents.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      s = error::Internal("Could not write $0: $1", tmp_path.string(), std::strerror(errno));
+      break;
+    }
+    contents.remove_prefix(n);
+  }
+  if (s.ok() && fsync(fd) != 0) {
+    s = error::Internal("Could not sync $0: $1", tmp_path.string(), std::strerror(errno));
+  }
+  if (close(fd) != 0 && s.ok()) {
+    s = error::Internal("Could not close $0: $1", tmp_path.string(), std::strerror(errno));
+  }
+  if (s.ok() && rename(tmp_path.c_str(), path.c_str()) != 0) {
+    s = error::Internal("Could not rename $0 to $1: $2", tmp_path.string(), path.string(),
+                        std::strerror(errno));
+  }
+  if (!s.ok()) {
+    unlink(tmp_path.c_str());
+    return s;
+  }
+
+  // Sync the directory too, so that the rename itself survives a crash.
+  int dir_fd = open(path.parent_path().empty() ? "." : path.parent_path().c_str(),
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+  return Status::OK();
+}
+
+uint64_t SymAddrsCacheChecksum(std::string_view contents) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : contents) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+StatusOr<std::string> BinaryCacheKey(const std::filesystem::path& binary,
+                                     const ElfReader* elf_reader) {
+  if (elf_reader != nullptr && !elf_reader->build_id().empty()) {
+    return absl::StrCat("build-id:", elf_reader->build_id());
+  }
+
+  struct stat st;
+  if (stat(binary.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0: $1", binary.string(), std::strerror(errno));
+  }
+  return absl::Substitute("$0:$1.$2:$3", binary.string(), st.st_mtim.tv_sec, st.st_mtim.tv_nsec,
+                          st.st_size);
+}
+
 }  // namespace stirling
 }  // namespace px
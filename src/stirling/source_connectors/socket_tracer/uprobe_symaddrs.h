@@ -18,6 +18,19 @@
 
 #pragma once
 
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
 #include "src/common/base/base.h"
 #include "src/stirling/obj_tools/dwarf_tools.h"
 #include "src/stirling/obj_tools/elf_tools.h"
@@ -53,5 +66,197 @@ StatusOr<struct go_tls_symaddrs_t> GoTLSSymAddrs(obj_tools::ElfReader* elf_reade
  */
 StatusOr<struct openssl_symaddrs_t> OpenSSLSymAddrs(const std::filesystem::path& openssl_lib);
 
+/**
+ * The symaddrs of a Go binary. Each is nullopt if the binary does not have the required symbols.
+ */
+struct GoSymAddrs {
+  std::optional<struct go_common_symaddrs_t> common;
+  std::optional<struct go_tls_symaddrs_t> tls;
+  std::optional<struct go_http2_symaddrs_t> http2;
+};
+
+/**
+ * Returns a key that identifies the contents of a binary, for use with SymAddrsCache:
+ * the build-id, if an ELF reader is provided and the binary has one;
+ * otherwise, the path, modification time and size of the binary.
+ */
+StatusOr<std::string> BinaryCacheKey(const std::filesystem::path& binary,
+                                     const obj_tools::ElfReader* elf_reader = nullptr);
+
+/**
+ * Writes contents to a temporary file next to path, syncs it, and renames it over path, so that
+ * readers see either the old or the new file, even if the process or the node dies mid-write.
+ */
+Status WriteFileAtomically(const std::filesystem::path& path, std::string_view contents);
+
+/**
+ * A 64-bit FNV-1a hash, which is stable across processes, to detect corrupted cache files.
+ */
+uint64_t SymAddrsCacheChecksum(std::string_view contents);
+
+/**
+ * A bounded LRU cache of symaddrs, keyed by BinaryCacheKey(). Symaddrs only depend on the
+ * binary, so all processes running the same binary share one entry, and the expensive
+ * ELF/DWARF analysis is done once.
+ *
+ * The cache can be saved to, and loaded from, a file, so that restarts do not redo the analysis
+ * of every binary. Values are stored as raw bytes, so kFileFormatVersion must be bumped
+ * whenever the layout of a symaddrs struct changes. Files end with a checksum of their contents,
+ * and a file that fails any check is rejected as a whole.
+ *
+ * This class is thread-safe.
+ */
+template <typename TValue>
+class SymAddrsCache {
+ public:
+  static_assert(std::is_trivially_copyable_v<TValue>);
+
+  static constexpr uint32_t kFileFormatVersion = 2;
+
+  explicit SymAddrsCache(size_t capacity) : capacity_(capacity) {}
+
+  std::optional<TValue> Lookup(const std::string& key) {
+    absl::MutexLock lock(&mutex_);
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return std::nullopt;
+    }
+    // Mark as most recently used.
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return iter->second->second;
+  }
+
+  void Insert(const std::string& key, const TValue& value) {
+    absl::MutexLock lock(&mutex_);
+    InsertLocked(key, value);
+  }
+
+  size_t size() const {
+    absl::MutexLock lock(&mutex_);
+    return entries_.size();
+  }
+
+  Status Save(const std::filesystem::path& path) const {
+    std::string contents;
+    {
+      absl::MutexLock lock(&mutex_);
+      AppendInt(&contents, kMagic);
+      AppendInt(&contents, kFileFormatVersion);
+      AppendInt(&contents, static_cast<uint32_t>(sizeof(TValue)));
+      AppendInt(&contents, static_cast<uint32_t>(entries_.size()));
+      // Least recently used first, so that Load() restores the same order.
+      for (auto iter = entries_.rbegin(); iter != entries_.rend(); ++iter) {
+        const auto& [key, value] = *iter;
+        AppendInt(&contents, static_cast<uint32_t>(key.size()));
+        contents.append(key);
+        contents.append(reinterpret_cast<const char*>(&value), sizeof(TValue));
+      }
+    }
+    AppendInt(&contents, SymAddrsCacheChecksum(contents));
+    return WriteFileAtomically(path, contents);
+  }
+
+  Status Load(const std::filesystem::path& path) {
+    PL_ASSIGN_OR_RETURN(std::string contents,
+                        ReadFileToString(path.string(), std::ios_base::in | std::ios_base::binary));
+    std::string_view buf = contents;
+
+    uint64_t checksum = 0;
+    if (buf.size() < sizeof(checksum)) {
+      return error::InvalidArgument("Symaddrs cache file $0 is truncated.", path.string());
+    }
+    std::memcpy(&checksum, buf.data() + buf.size() - sizeof(checksum), sizeof(checksum));
+    buf.remove_suffix(sizeof(checksum));
+    if (checksum != SymAddrsCacheChecksum(buf)) {
+      return error::InvalidArgument("Symaddrs cache file $0 is corrupted.", path.string());
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t value_size = 0;
+    uint32_t num_entries = 0;
+    if (!ExtractInt(&buf, &magic) || !ExtractInt(&buf, &version) ||
+        !ExtractInt(&buf, &value_size) || !ExtractInt(&buf, &num_entries)) {
+      return error::InvalidArgument("Symaddrs cache file $0 is truncated.", path.string());
+    }
+    if (magic != kMagic || version != kFileFormatVersion || value_size != sizeof(TValue)) {
+      return error::InvalidArgument(
+          "Symaddrs cache file $0 is incompatible [version=$1 value_size=$2].", path.string(),
+          version, value_size);
+    }
+
+    // Parse the whole file before inserting anything, so that a bad file leaves the cache as is.
+    std::vector<std::pair<std::string, TValue>> loaded;
+    for (uint32_t i = 0; i < num_entries; ++i) {
+      uint32_t key_size = 0;
+      if (!ExtractInt(&buf, &key_size) || buf.size() < key_size + sizeof(TValue)) {
+        return error::InvalidArgument("Symaddrs cache file $0 is truncated.", path.string());
+      }
+      TValue value;
+      std::memcpy(&value, buf.data() + key_size, sizeof(TValue));
+      loaded.emplace_back(std::string(buf.substr(0, key_size)), value);
+      buf.remove_prefix(key_size + sizeof(TValue));
+    }
+    if (!buf.empty()) {
+      return error::InvalidArgument("Symaddrs cache file $0 has $1 trailing bytes.", path.string(),
+                                    buf.size());
+    }
+
+    absl::MutexLock lock(&mutex_);
+    for (const auto& [key, value] : loaded) {
+      InsertLocked(key, value);
+    }
+    return Status::OK();
+  }
+
+ private:
+  // "PXSA", in little endian.
+  static constexpr uint32_t kMagic = 0x41535850;
+
+  template <typename TIntType>
+  static void AppendInt(std::string* out, TIntType val) {
+    out->append(reinterpret_cast<const char*>(&val), sizeof(TIntType));
+  }
+
+  template <typename TIntType>
+  static bool ExtractInt(std::string_view* buf, TIntType* val) {
+    if (buf->size() < sizeof(TIntType)) {
+      return false;
+    }
+    std::memcpy(val, buf->data(), sizeof(TIntType));
+    buf->remove_prefix(sizeof(TIntType));
+    return true;
+  }
+
+  void InsertLocked(const std::string& key, const TValue& value)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      iter->second->second = value;
+      entries_.splice(entries_.begin(), entries_, iter->second);
+      return;
+    }
+    if (capacity_ == 0) {
+      return;
+    }
+    entries_.emplace_front(key, value);
+    index_.emplace(key, entries_.begin());
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  using EntryList = std::list<std::pair<std::string, TValue>>;
+
+  const size_t capacity_;
+
+  mutable absl::Mutex mutex_;
+
+  // Most recently used first.
+  EntryList entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, typename EntryList::iterator> index_ ABSL_GUARDED_BY(mutex_);
+};
+
 }  // namespace stirling
 }  // namespace px
@@ -19,9 +19,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <filesystem>
 #include <memory>
 #include <string>
 
+#include "src/common/fs/temp_file.h"
 #include "src/common/testing/testing.h"
 #include "src/stirling/obj_tools/dwarf_tools.h"
 #include "src/stirling/obj_tools/elf_tools.h"
@@ -91,5 +93,104 @@ TEST_F(UprobeSymaddrsTest, GoTLSSymAddrs) {
   EXPECT_EQ(symaddrs.Read_b_offset, 16);
 }
 
+TEST_F(UprobeSymaddrsTest, BinaryCacheKey) {
+  const std::filesystem::path p = px::testing::BazelBinTestFilePath(kGoGRPCServer);
+
+  ASSERT_OK_AND_ASSIGN(std::string key, BinaryCacheKey(p));
+  EXPECT_OK_AND_EQ(BinaryCacheKey(p), key);
+
+  ASSERT_OK_AND_ASSIGN(std::string elf_key, BinaryCacheKey(p, elf_reader_.get()));
+  if (!elf_reader_->build_id().empty()) {
+    EXPECT_EQ(elf_key, absl::StrCat("build-id:", elf_reader_->build_id()));
+  } else {
+    EXPECT_EQ(elf_key, key);
+  }
+
+  EXPECT_NOT_OK(BinaryCacheKey("/bogus/path/to/binary"));
+}
+
+TEST(SymAddrsCacheTest, EvictsLeastRecentlyUsed) {
+  SymAddrsCache<struct go_tls_symaddrs_t> cache(2);
+
+  cache.Insert("a", go_tls_symaddrs_t{.Write_c_offset = 1});
+  cache.Insert("b", go_tls_symaddrs_t{.Write_c_offset = 2});
+
+  // Touch "a", so that "b" is the least recently used.
+  ASSERT_TRUE(cache.Lookup("a").has_value());
+  cache.Insert("c", go_tls_symaddrs_t{.Write_c_offset = 3});
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_FALSE(cache.Lookup("b").has_value());
+  ASSERT_TRUE(cache.Lookup("a").has_value());
+  EXPECT_EQ(cache.Lookup("a")->Write_c_offset, 1);
+  ASSERT_TRUE(cache.Lookup("c").has_value());
+  EXPECT_EQ(cache.Lookup("c")->Write_c_offset, 3);
+}
+
+TEST(SymAddrsCacheTest, SaveAndLoad) {
+  SymAddrsCache<GoSymAddrs> cache(2);
+  GoSymAddrs symaddrs;
+  symaddrs.tls = go_tls_symaddrs_t{.Write_c_offset = 8, .Write_b_offset = 16};
+  cache.Insert("build-id:1234", symaddrs);
+  cache.Insert("build-id:5678", GoSymAddrs{});
+
+  std::unique_ptr<fs::TempFile> tmpf = fs::TempFile::Create();
+  ASSERT_OK(cache.Save(tmpf->path()));
+
+  SymAddrsCache<GoSymAddrs> loaded_cache(2);
+  ASSERT_OK(loaded_cache.Load(tmpf->path()));
+  EXPECT_EQ(loaded_cache.size(), 2);
+
+  std::optional<GoSymAddrs> loaded = loaded_cache.Lookup("build-id:1234");
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_FALSE(loaded->common.has_value());
+  EXPECT_FALSE(loaded->http2.has_value());
+  ASSERT_TRUE(loaded->tls.has_value());
+  EXPECT_EQ(loaded->tls->Write_c_offset, 8);
+  EXPECT_EQ(loaded->tls->Write_b_offset, 16);
+
+  // A file holding a different value type is rejected.
+  SymAddrsCache<struct go_tls_symaddrs_t> other_cache(2);
+  EXPECT_NOT_OK(other_cache.Load(tmpf->path()));
+}
+
+TEST(SymAddrsCacheTest, LoadRejectsCorruptedFiles) {
+  SymAddrsCache<GoSymAddrs> cache(2);
+  cache.Insert("build-id:1234", GoSymAddrs{});
+  std::unique_ptr<fs::TempFile> tmpf = fs::TempFile::Create();
+  ASSERT_OK(cache.Save(tmpf->path()));
+  ASSERT_OK_AND_ASSIGN(std::string contents, ReadFileToString(tmpf->path().string()));
+
+  // A flipped byte fails the checksum.
+  std::string corrupted = contents;
+  corrupted[corrupted.size() / 2] ^= 0x1;
+  ASSERT_OK(WriteFileFromString(tmpf->path().string(), corrupted));
+  SymAddrsCache<GoSymAddrs> loaded_cache(2);
+  EXPECT_NOT_OK(loaded_cache.Load(tmpf->path()));
+
+  // So does a truncated file.
+  ASSERT_OK(WriteFileFromString(tmpf->path().string(), contents.substr(0, contents.size() - 3)));
+  EXPECT_NOT_OK(loaded_cache.Load(tmpf->path()));
+  EXPECT_EQ(loaded_cache.size(), 0);
+}
+
+TEST(SymAddrsCacheTest, SaveReplacesFileAtomically) {
+  std::unique_ptr<fs::TempFile> tmpf = fs::TempFile::Create();
+  ASSERT_OK(WriteFileFromString(tmpf->path().string(), "old contents"));
+
+  SymAddrsCache<GoSymAddrs> cache(2);
+  cache.Insert("build-id:1234", GoSymAddrs{});
+  ASSERT_OK(cache.Save(tmpf->path()));
+
+  // No temporary file is left behind.
+  for (const auto& entry : std::filesystem::directory_iterator(tmpf->path().parent_path())) {
+    EXPECT_EQ(entry.path().string().find(tmpf->path().filename().string() + ".tmp"),
+              std::string::npos);
+  }
+  SymAddrsCache<GoSymAddrs> loaded_cache(2);
+  ASSERT_OK(loaded_cache.Load(tmpf->path()));
+  EXPECT_EQ(loaded_cache.size(), 1);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/source_connectors/stirling_perf/stirling_perf_connector.h"
+
+#include <string>
+
+#include "src/stirling/utils/perf_stats.h"
+
+namespace px {
+namespace stirling {
+
+using utils::PerfProbe;
+using utils::PerfStats;
+
+Status StirlingPerfConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+  return Status::OK();
+}
+
+void StirlingPerfConnector::TransferDataImpl(ConnectorContext* /*ctx*/,
+                                             const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1);
+  auto* data_table = data_tables[0];
+
+  if (data_table == nullptr) {
+    return;
+  }
+
+  uint64_t timestamp = CurrentTimeNS();
+  for (const PerfProbe::Snapshot& snapshot : PerfStats::GetInstance().TakeSnapshots()) {
+    DataTable::RecordBuilder<&kTable> r(data_table, timestamp);
+    r.Append<r.ColIndex("time_")>(timestamp);
+    r.Append<r.ColIndex("probe")>(snapshot.name);
+    r.Append<r.ColIndex("count")>(snapshot.count);
+    r.Append<r.ColIndex("total_ns")>(snapshot.total_ns);
+    r.Append<r.ColIndex("max_ns")>(snapshot.max_ns);
+    r.Append<r.ColIndex("event_loss")>(snapshot.event_loss);
+    r.Append<r.ColIndex("latency_histogram")>(utils::Log2HistogramToJSON(snapshot.histogram));
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/source_connector.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Exports Stirling's own hot-path statistics (see utils::PerfStats): the time spent in each
+ * instrumented point, and the events it lost, since the previous sample.
+ */
+class StirlingPerfConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "stirling_perf";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{10000};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{10000};
+  // clang-format off
+  static constexpr DataElement kElements[] = {
+      canonical_data_elements::kTime,
+      {"probe", "The instrumented point of Stirling, e.g. <connector>.transfer_data",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+      {"count", "The number of times the probe was timed since the previous sample",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+      {"total_ns", "The total time spent in the probe since the previous sample",
+       types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+       types::PatternType::METRIC_COUNTER},
+      {"max_ns", "The longest time spent in the probe since the previous sample",
+       types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+       types::PatternType::METRIC_GAUGE},
+      {"event_loss", "The number of events lost by the probe since the previous sample",
+       types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+      {"latency_histogram", "JSON map of the lower bound of each power-of-2 bucket, in "
+       "microseconds, to the number of timings in it",
+       types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+  };
+  // clang-format on
+  static constexpr auto kTable = DataTableSchema(
+      "stirling_perf", "Timings and event losses of Stirling's own hot paths", kElements);
+
+  static constexpr auto kTables = MakeArray(kTable);
+
+  StirlingPerfConnector() = delete;
+  ~StirlingPerfConnector() override = default;
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new StirlingPerfConnector(name));
+  }
+
+ protected:
+  explicit StirlingPerfConnector(std::string_view name) : SourceConnector(name, kTables) {}
+  Status InitImpl() override;
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  Status StopImpl() override { return Status::OK(); }
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -29,12 +30,17 @@
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
+#include "src/common/base/worker_pool.h"
 #include "src/common/perf/elapsed_timer.h"
 #include "src/common/system/system_info.h"
 
 #include "src/stirling/bpf_tools/probe_cleaner.h"
+#include "src/stirling/core/connector_context.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/pub_sub_manager.h"
 #include "src/stirling/core/source_connector.h"
@@ -44,16 +50,29 @@
 #include "src/stirling/source_connectors/dynamic_bpftrace/dynamic_bpftrace_connector.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_trace_connector.h"
 #include "src/stirling/source_connectors/jvm_stats/jvm_stats_connector.h"
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
 #include "src/stirling/source_connectors/network_stats/network_stats_connector.h"
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
+#include "src/stirling/source_connectors/perf_profiler/self_profile_connector.h"
 #include "src/stirling/source_connectors/pid_runtime/pid_runtime_connector.h"
 #include "src/stirling/source_connectors/proc_stat/proc_stat_connector.h"
 #include "src/stirling/source_connectors/process_stats/process_stats_connector.h"
 #include "src/stirling/source_connectors/seq_gen/seq_gen_connector.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+#include "src/stirling/source_connectors/stirling_perf/stirling_perf_connector.h"
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
+DEFINE_string(stirling_dedicated_thread_sources, "",
+              "Comma-separated names of source connectors that run on their own threads, so that "
+              "their transfers don't delay the other connectors. A trailing '*' matches by "
+              "prefix (e.g. 'DT_*' for all dynamic tracepoints).");
+DEFINE_bool(stirling_parallel_source_init, true,
+            "Initialize the source connectors concurrently, rather than one after another.");
+DEFINE_string(stirling_cpus, gflags::StringFromEnv("PL_STIRLING_CPUS", ""),
+              "The CPUs that Stirling's threads run on, in cpulist format (e.g. '0-3,8'), so that "
+              "they don't share cores with query execution. All CPUs if empty.");
+
 namespace px {
 namespace stirling {
 
@@ -66,9 +85,16 @@ const absl::flat_hash_map<std::string_view, SourceRegistry::RegistryElement> kAl
     REGISTRY_PAIR(ProcStatConnector),     REGISTRY_PAIR(SeqGenConnector),
     REGISTRY_PAIR(SocketTraceConnector),  REGISTRY_PAIR(ProcessStatsConnector),
     REGISTRY_PAIR(NetworkStatsConnector), REGISTRY_PAIR(PerfProfileConnector),
+    REGISTRY_PAIR(StirlingPerfConnector), REGISTRY_PAIR(LoadGenConnector),
+    REGISTRY_PAIR(SelfProfileConnector),
 };
 #undef REGISTRY_PAIR
 
+void PinStirlingThread() {
+  Status s = SetCurrentThreadCPUs(FLAGS_stirling_cpus);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to pin Stirling thread: $0", s.msg());
+}
+
 }  // namespace
 
 // clang-format off
@@ -82,7 +108,9 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         NetworkStatsConnector::kName,
         JVMStatsConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingPerfConnector::kName,
+        SelfProfileConnector::kName
       };
     case SourceConnectorGroup::kAll:
       return {
@@ -93,7 +121,9 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         ProcStatConnector::kName,
         SeqGenConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingPerfConnector::kName,
+        SelfProfileConnector::kName
       };
     case SourceConnectorGroup::kTracers:
       return {
@@ -107,7 +137,8 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
       };
     case SourceConnectorGroup::kProfiler:
       return {
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        SelfProfileConnector::kName
       };
     default:
       // To keep GCC happy.
@@ -143,6 +174,15 @@ struct SourceOutput {
   std::vector<DataTable*> data_tables;
 };
 
+// State of a source connector that runs on its own thread, instead of in the main loop.
+struct ConnectorThread {
+  std::thread thread;
+  std::atomic<bool> run_enable = true;
+  // Held by the thread while it works on the source, so that control paths (e.g. debug
+  // signals) don't race with its transfers.
+  absl::Mutex mutex;
+};
+
 class StirlingImpl final : public Stirling {
  public:
   explicit StirlingImpl(std::unique_ptr<SourceRegistry> registry);
@@ -162,10 +202,14 @@ class StirlingImpl final : public Stirling {
   Status RemoveTracepoint(sole::uuid trace_id) override;
   void GetPublishProto(stirlingpb::Publish* publish_pb) override;
   void RegisterDataPushCallback(DataPushCallback f) override { data_push_callback_ = f; }
+  void RegisterDataPushHandleResolver(DataPushHandleResolver f) override {
+    data_push_handle_resolver_ = f;
+  }
   void RegisterAgentMetadataCallback(AgentMetadataCallback f) override {
     DCHECK(f != nullptr);
     agent_metadata_callback_ = f;
   }
+  void RegisterPIDChangedCallback(PIDChangedCallback f) override { pid_changed_callback_ = f; }
   std::unique_ptr<ConnectorContext> GetContext();
 
   void Run() override;
@@ -186,6 +230,9 @@ class StirlingImpl final : public Stirling {
   // Adds a source to Stirling, and updates all state accordingly.
   Status AddSource(std::unique_ptr<SourceConnector> source);
 
+  // Adds a source that was already initialized. See AddSource().
+  Status AddInitializedSource(std::unique_ptr<SourceConnector> source);
+
   // Removes a source and all its info classes from stirling.
   Status RemoveSource(std::string_view source_name);
 
@@ -197,15 +244,64 @@ class StirlingImpl final : public Stirling {
   // Destroys a dynamic tracing source created by DeployDynamicTraceConnector.
   void DestroyDynamicTraceConnector(sole::uuid trace_id);
 
+  // A queued tracepoint deployment, or a removal if there is no program.
+  struct TracepointOp {
+    sole::uuid trace_id;
+    std::unique_ptr<dynamic_tracing::ir::logical::TracepointDeployment> program;
+  };
+
+  // Queues a tracepoint operation for the tracepoint thread, and starts the thread if needed.
+  void QueueTracepointOp(TracepointOp op);
+
+  // Run loop of the tracepoint thread: runs the queued operations in order, one at a time.
+  void RunTracepointThread();
+
+  // Stops the tracepoint thread once its current operation is done. Queued operations are dropped,
+  // and so are the operations queued afterwards: Stirling can't be restarted once stopped.
+  void StopTracepointThread();
+
+  bool TracepointThreadHasWork() const ABSL_SHARED_LOCKS_REQUIRED(tracepoint_ops_lock_) {
+    return stop_tracepoint_thread_ || !tracepoint_ops_.empty();
+  }
+
   // Main run implementation.
   void RunCore();
 
+  // One iteration of sampling and pushing data for a single source.
+  void TransferAndPush(SourceConnector* source, const std::vector<DataTable*>& data_tables,
+                       ConnectorContext* ctx);
+
+  // Moves a source out of the main loop onto its own thread.
+  void StartConnectorThread(SourceConnector* source, std::vector<DataTable*> data_tables)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
+  // Returns sources_.end() if there is no source with the name.
+  std::vector<std::unique_ptr<SourceConnector>>::iterator FindSource(std::string_view name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
+  // Tells the thread of a source, if it has one, to stop. The caller joins the returned thread
+  // after releasing info_class_mgrs_lock_, and then erases it from connector_threads_; until then,
+  // the main loop keeps skipping the source.
+  ConnectorThread* StopConnectorThread(SourceConnector* source)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
+  // Run loop of a source on its own thread.
+  void RunConnectorThread(SourceConnector* source, std::vector<DataTable*> data_tables,
+                          ConnectorThread* connector_thread);
+
+  // Calls fn on each source, while holding the lock of its thread, if it has one.
+  template <typename TFn>
+  void ForEachSource(TFn fn) ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
   // Wait for Stirling to stop its main loop.
   void WaitForStop();
 
   // Main thread used to spawn off RunThread().
   std::thread run_thread_;
 
+  // Removes the probes leaked by previous instances, off the Init() path.
+  std::thread probe_cleaner_thread_;
+
   std::atomic<bool> run_enable_ = false;
   std::atomic<bool> running_ = false;
   std::vector<std::unique_ptr<SourceConnector>> sources_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
@@ -216,6 +312,10 @@ class StirlingImpl final : public Stirling {
 
   InfoClassManagerVec info_class_mgrs_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
+  // Sources that run on their own threads; the main loop skips these.
+  absl::flat_hash_map<SourceConnector*, std::unique_ptr<ConnectorThread>> connector_threads_
+      ABSL_GUARDED_BY(info_class_mgrs_lock_);
+
   // Lock to protect both info_class_mgrs_ and sources_.
   absl::base_internal::SpinLock info_class_mgrs_lock_;
 
@@ -229,12 +329,27 @@ class StirlingImpl final : public Stirling {
    */
   DataPushCallback data_push_callback_ = nullptr;
 
+  // Resolves the handles to push data with. Takes precedence over data_push_callback_.
+  DataPushHandleResolver data_push_handle_resolver_ = nullptr;
+
   AgentMetadataCallback agent_metadata_callback_ = nullptr;
   AgentMetadataType agent_metadata_;
+  PIDChangedCallback pid_changed_callback_ = nullptr;
+
+  // Versions the UPIDs of the agent's metadata for the contexts, see ConnectorContext.
+  UPIDDeltaLog upid_delta_log_;
 
   absl::base_internal::SpinLock dynamic_trace_status_map_lock_;
   absl::flat_hash_map<sole::uuid, StatusOr<stirlingpb::Publish>> dynamic_trace_status_map_
       ABSL_GUARDED_BY(dynamic_trace_status_map_lock_);
+
+  // Deploying a tracepoint compiles its BPF program, which is CPU and memory heavy. Rather than
+  // a thread per request, a single thread deploys and removes the tracepoints one at a time, in
+  // the order they were requested.
+  absl::Mutex tracepoint_ops_lock_;
+  std::deque<TracepointOp> tracepoint_ops_ ABSL_GUARDED_BY(tracepoint_ops_lock_);
+  bool stop_tracepoint_thread_ ABSL_GUARDED_BY(tracepoint_ops_lock_) = false;
+  std::thread tracepoint_thread_ ABSL_GUARDED_BY(tracepoint_ops_lock_);
 };
 
 StirlingImpl* g_stirling_ptr = nullptr;
@@ -335,8 +450,10 @@ void StirlingImpl::RegisterUserDebugSignalHandlers(int signum) {
 Status StirlingImpl::Init() {
   system::LogSystemInfo();
 
-  // Clean up any probes from a previous instance.
-  Status s = utils::CleanProbes();
+  // Clean up any probes from a previous instance. Only the ones named after this PID can collide
+  // with the probes deployed below, so those are removed first; the rest are removed in the
+  // background, as there may be many thousands of them.
+  Status s = utils::CleanProbes(utils::kPixieBPFProbeMarker, utils::ProbeOwner::kThisProcess);
 
   // TODO(yzhao): The below logging cannot be DFATAL. Otherwise, non-OPT built stirling_wrapper
   // deployed along side PEM will always crash as the probes owned by PEM cannot be modified by
@@ -344,22 +461,61 @@ Status StirlingImpl::Init() {
   // in order to skip cleaning up those probes.
   LOG_IF(WARNING, !s.ok()) << absl::Substitute("Kprobe Cleaner failed. Message $0", s.msg());
 
+  probe_cleaner_thread_ = std::thread([]() {
+    PinStirlingThread();
+    Status s = utils::CleanProbes(utils::kPixieBPFProbeMarker, utils::ProbeOwner::kOtherProcesses);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Kprobe Cleaner failed. Message $0", s.msg());
+  });
+
   if (!registry_) {
     return error::NotFound("Source registry doesn't exist");
   }
 
+  std::vector<std::string_view> names;
+  std::vector<std::unique_ptr<SourceConnector>> sources;
   for (const auto& [name, registry_element] : registry_->sources()) {
-    Status s = AddSource(registry_element.create_source_fn(name));
+    names.push_back(name);
+    sources.push_back(registry_element.create_source_fn(name));
+  }
+
+  // Most of the start-up time goes to the BPF-based sources compiling and attaching their probes,
+  // so the sources are initialized concurrently. The state that they share (the Linux headers,
+  // the task_struct offsets and BCC's compiler) is guarded where it is set up.
+  ElapsedTimer timer;
+  timer.Start();
+  std::vector<Status> init_statuses(sources.size());
+  auto init_source = [&](size_t i) {
+    ElapsedTimer source_timer;
+    source_timer.Start();
+    init_statuses[i] = sources[i]->Init();
+    LOG(INFO) << absl::Substitute("Initialized source connector $0 in $1 ms.", names[i],
+                                  source_timer.ElapsedTime_us() / 1000);
+  };
+  if (FLAGS_stirling_parallel_source_init && sources.size() > 1) {
+    WorkerPool pool(sources.size() - 1);
+    pool.ParallelFor(sources.size(), init_source);
+  } else {
+    for (size_t i = 0; i < sources.size(); ++i) {
+      init_source(i);
+    }
+  }
+
+  // Sources are added in registry order, regardless of the order in which they finished.
+  for (size_t i = 0; i < sources.size(); ++i) {
+    Status s = init_statuses[i].ok() ? AddInitializedSource(std::move(sources[i]))
+                                     : init_statuses[i];
     LOG_IF(DFATAL, !s.ok()) << absl::Substitute(
-        "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
+        "Source Connector (registry name=$0) not instantiated, error: $1", names[i], s.ToString());
   }
-  LOG(INFO) << "Stirling successfully initialized.";
+  LOG(INFO) << absl::Substitute("Stirling successfully initialized in $0 ms.",
+                                timer.ElapsedTime_us() / 1000);
   return Status::OK();
 }
 
 std::unique_ptr<ConnectorContext> StirlingImpl::GetContext() {
   if (agent_metadata_callback_ != nullptr) {
-    return std::unique_ptr<ConnectorContext>(new AgentContext(agent_metadata_callback_()));
+    return std::unique_ptr<ConnectorContext>(
+        new AgentContext(agent_metadata_callback_(), &upid_delta_log_, pid_changed_callback_));
   }
   return std::unique_ptr<ConnectorContext>(new StandaloneContext());
 }
@@ -375,12 +531,28 @@ std::vector<DataTable*> GetDataTables(const std::vector<InfoClassManager*>& info
   return data_tables;
 }
 
+// Returns true if the source was selected by --stirling_dedicated_thread_sources.
+bool UsesDedicatedThread(std::string_view source_name) {
+  for (std::string_view entry :
+       absl::StrSplit(FLAGS_stirling_dedicated_thread_sources, ',', absl::SkipWhitespace())) {
+    if (absl::ConsumeSuffix(&entry, "*") ? absl::StartsWith(source_name, entry)
+                                         : source_name == entry) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   // Step 1: Init the source.
   PL_RETURN_IF_ERROR(source->Init());
 
+  return AddInitializedSource(std::move(source));
+}
+
+Status StirlingImpl::AddInitializedSource(std::unique_ptr<SourceConnector> source) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   std::vector<InfoClassManager*> mgrs;
@@ -396,6 +568,12 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
 
   std::vector<DataTable*> data_tables = GetDataTables(mgrs);
 
+  // Sources added while running (e.g. dynamic tracepoints) start on their thread right away;
+  // the others start when RunCore() does.
+  if (running_ && UsesDedicatedThread(source->name())) {
+    StartConnectorThread(source.get(), data_tables);
+  }
+
   source_output_map_[source.get()] = {std::move(mgrs),
                                       // DataTable objects are created after subscribing.
                                       std::move(data_tables)};
@@ -404,18 +582,38 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   return Status::OK();
 }
 
+std::vector<std::unique_ptr<SourceConnector>>::iterator StirlingImpl::FindSource(
+    std::string_view name) {
+  return std::find_if(
+      sources_.begin(), sources_.end(),
+      [&name](const std::unique_ptr<SourceConnector>& s) { return s->name() == name; });
+}
+
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
+  // The thread of the source, if any, uses its data tables, so it must be gone first.
+  // It is joined without holding the spin lock, which the main loop spins on meanwhile.
+  ConnectorThread* connector_thread = nullptr;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    auto source_iter = FindSource(source_name);
+    if (source_iter == sources_.end()) {
+      return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
+    }
+    connector_thread = StopConnectorThread(source_iter->get());
+  }
+  if (connector_thread != nullptr) {
+    connector_thread->thread.join();
+  }
+
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   // Find the source.
-  auto source_iter = std::find_if(sources_.begin(), sources_.end(),
-                                  [&source_name](const std::unique_ptr<SourceConnector>& s) {
-                                    return s->name() == source_name;
-                                  });
+  auto source_iter = FindSource(source_name);
   if (source_iter == sources_.end()) {
     return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
   }
   std::unique_ptr<SourceConnector>& source = *source_iter;
+  connector_threads_.erase(source.get());
 
   // Remove all info class managers that point back to the source.
   info_class_mgrs_.erase(std::remove_if(info_class_mgrs_.begin(), info_class_mgrs_.end(),
@@ -579,9 +777,64 @@ void StirlingImpl::RegisterTracepoint(
         error::ResourceUnavailable("Probe deployment in progress.");
   }
 
-  auto t =
-      std::thread(&StirlingImpl::DeployDynamicTraceConnector, this, trace_id, std::move(program));
-  t.detach();
+  QueueTracepointOp({trace_id, std::move(program)});
+}
+
+void StirlingImpl::QueueTracepointOp(TracepointOp op) {
+  absl::MutexLock lock(&tracepoint_ops_lock_);
+  if (stop_tracepoint_thread_) {
+    absl::base_internal::SpinLockHolder status_lock(&dynamic_trace_status_map_lock_);
+    dynamic_trace_status_map_[op.trace_id] = error::Internal("Stirling is stopping.");
+    return;
+  }
+
+  tracepoint_ops_.push_back(std::move(op));
+  if (!tracepoint_thread_.joinable()) {
+    tracepoint_thread_ = std::thread(&StirlingImpl::RunTracepointThread, this);
+  }
+}
+
+void StirlingImpl::RunTracepointThread() {
+  PinStirlingThread();
+  while (true) {
+    TracepointOp op;
+    {
+      absl::MutexLock lock(&tracepoint_ops_lock_);
+      tracepoint_ops_lock_.Await(absl::Condition(this, &StirlingImpl::TracepointThreadHasWork));
+      if (stop_tracepoint_thread_) {
+        return;
+      }
+      op = std::move(tracepoint_ops_.front());
+      tracepoint_ops_.pop_front();
+    }
+
+    if (op.program != nullptr) {
+      DeployDynamicTraceConnector(op.trace_id, std::move(op.program));
+    } else {
+      DestroyDynamicTraceConnector(op.trace_id);
+    }
+  }
+}
+
+void StirlingImpl::StopTracepointThread() {
+  std::thread thread;
+  std::deque<TracepointOp> dropped_ops;
+  {
+    absl::MutexLock lock(&tracepoint_ops_lock_);
+    stop_tracepoint_thread_ = true;
+    thread = std::move(tracepoint_thread_);
+    dropped_ops.swap(tracepoint_ops_);
+  }
+
+  // A deployment in progress can't be interrupted, so this waits for it to finish.
+  if (thread.joinable()) {
+    thread.join();
+  }
+
+  absl::base_internal::SpinLockHolder lock(&dynamic_trace_status_map_lock_);
+  for (const auto& op : dropped_ops) {
+    dynamic_trace_status_map_[op.trace_id] = error::Internal("Stirling is stopping.");
+  }
 }
 
 StatusOr<stirlingpb::Publish> StirlingImpl::GetTracepointInfo(sole::uuid trace_id) {
@@ -597,14 +850,28 @@ StatusOr<stirlingpb::Publish> StirlingImpl::GetTracepointInfo(sole::uuid trace_i
 }
 
 Status StirlingImpl::RemoveTracepoint(sole::uuid trace_id) {
+  // If the deployment hasn't started yet, there is nothing to remove; just drop it.
+  {
+    absl::MutexLock lock(&tracepoint_ops_lock_);
+    auto iter = std::find_if(tracepoint_ops_.begin(), tracepoint_ops_.end(),
+                             [&trace_id](const TracepointOp& op) {
+                               return op.trace_id == trace_id && op.program != nullptr;
+                             });
+    if (iter != tracepoint_ops_.end()) {
+      tracepoint_ops_.erase(iter);
+      absl::base_internal::SpinLockHolder status_lock(&dynamic_trace_status_map_lock_);
+      dynamic_trace_status_map_.erase(trace_id);
+      return Status::OK();
+    }
+  }
+
   // Change the status of this trace to pending while we delete it.
   {
     absl::base_internal::SpinLockHolder lock(&dynamic_trace_status_map_lock_);
     dynamic_trace_status_map_[trace_id] = error::ResourceUnavailable("Probe removal in progress.");
   }
 
-  auto t = std::thread(&StirlingImpl::DestroyDynamicTraceConnector, this, trace_id);
-  t.detach();
+  QueueTracepointOp({trace_id, nullptr});
 
   return Status::OK();
 }
@@ -672,20 +939,30 @@ namespace {
 static constexpr std::chrono::milliseconds kMinSleepDuration{1};
 static constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
 
-// Helper function: Figure out when to wake up next.
-std::chrono::milliseconds TimeUntilNextTick(
-    const absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map) {
-  // The amount to sleep depends on when the earliest Source needs to be sampled again.
-  // Do this to avoid burning CPU cycles unnecessarily
+bool HasData(const std::vector<DataTable*>& data_tables) {
+  return std::any_of(data_tables.begin(), data_tables.end(), [](const DataTable* data_table) {
+    return data_table != nullptr && data_table->Occupancy() > 0;
+  });
+}
+
+// Helper function: Figure out when a source needs to be woken up next.
+px::chrono::coarse_steady_clock::time_point NextWakeupTime(
+    const SourceConnector* source, const std::vector<DataTable*>& data_tables) {
+  auto wakeup_time = source->sampling_freq_mgr().next();
+  // Nothing to push until the next sample, so don't wake up for the push.
+  if (HasData(data_tables)) {
+    wakeup_time = std::min(wakeup_time, source->push_freq_mgr().next());
+  }
+  return wakeup_time;
+}
+
+// Helper function: Figure out how long to sleep until the wakeup time.
+std::chrono::milliseconds TimeUntil(px::chrono::coarse_steady_clock::time_point wakeup_time) {
   auto now = px::chrono::coarse_steady_clock::now();
 
   // Worst case, wake-up every so often.
   // This is important if there are no subscribed info classes, to avoid sleeping eternally.
-  auto wakeup_time = now + kMaxSleepDuration;
-  for (const auto& [source, output] : source_output_map) {
-    wakeup_time = std::min(wakeup_time, source->sampling_freq_mgr().next());
-    wakeup_time = std::min(wakeup_time, source->push_freq_mgr().next());
-  }
+  wakeup_time = std::min(wakeup_time, now + kMaxSleepDuration);
 
   return std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now);
 }
@@ -717,10 +994,81 @@ bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
 
 }  // namespace
 
+void StirlingImpl::TransferAndPush(SourceConnector* source,
+                                   const std::vector<DataTable*>& data_tables,
+                                   ConnectorContext* ctx) {
+  // Phase 1: Probe the source for its data.
+  if (source->sampling_freq_mgr().Expired()) {
+    source->TransferData(ctx, data_tables);
+  }
+  // Phase 2: Push Data upstream, once enough data is buffered, or once the push period
+  // bounds the latency of the data that is buffered.
+  if (DataExceedsThreshold(data_tables) ||
+      (source->push_freq_mgr().Expired() && HasData(data_tables))) {
+    if (data_push_handle_resolver_ != nullptr) {
+      source->PushData(data_push_handle_resolver_, data_tables);
+    } else {
+      source->PushData(data_push_callback_, data_tables);
+    }
+  }
+}
+
+void StirlingImpl::StartConnectorThread(SourceConnector* source,
+                                        std::vector<DataTable*> data_tables) {
+  auto connector_thread = std::make_unique<ConnectorThread>();
+  connector_thread->thread = std::thread(&StirlingImpl::RunConnectorThread, this, source,
+                                         std::move(data_tables), connector_thread.get());
+  LOG(INFO) << absl::Substitute("Running source connector '$0' on its own thread.",
+                                source->name());
+  connector_threads_[source] = std::move(connector_thread);
+}
+
+ConnectorThread* StirlingImpl::StopConnectorThread(SourceConnector* source) {
+  auto iter = connector_threads_.find(source);
+  if (iter == connector_threads_.end()) {
+    return nullptr;
+  }
+  iter->second->run_enable = false;
+  return iter->second.get();
+}
+
+void StirlingImpl::RunConnectorThread(SourceConnector* source,
+                                      std::vector<DataTable*> data_tables,
+                                      ConnectorThread* connector_thread) {
+  PinStirlingThread();
+  while (run_enable_ && connector_thread->run_enable) {
+    // Each thread takes its own context snapshot, so that it refreshes at its own pace.
+    std::unique_ptr<ConnectorContext> ctx = GetContext();
+
+    std::chrono::milliseconds sleep_duration;
+    {
+      absl::MutexLock lock(&connector_thread->mutex);
+      TransferAndPush(source, data_tables, ctx.get());
+      sleep_duration = TimeUntil(NextWakeupTime(source, data_tables));
+    }
+
+    SleepForDuration(sleep_duration);
+  }
+}
+
+template <typename TFn>
+void StirlingImpl::ForEachSource(TFn fn) {
+  for (auto& s : sources_) {
+    auto iter = connector_threads_.find(s.get());
+    if (iter != connector_threads_.end()) {
+      absl::MutexLock lock(&iter->second->mutex);
+      fn(s.get());
+    } else {
+      fn(s.get());
+    }
+  }
+}
+
 // Main Data Collector loop.
 // Poll on Data Source Through connectors, when appropriate, then go to sleep.
 // Must run as a thread, so only call from Run() as a thread.
 void StirlingImpl::RunCore() {
+  PinStirlingThread();
   running_ = true;
 
   // First initialize each info class manager with context.
@@ -730,6 +1078,12 @@ void StirlingImpl::RunCore() {
     for (const auto& s : sources_) {
       s->InitContext(initial_context.get());
     }
+    for (const auto& [source, output] : source_output_map_) {
+      // AddSource() may have already started the thread, if it raced with the start-up.
+      if (UsesDedicatedThread(source->name()) && !connector_threads_.contains(source)) {
+        StartConnectorThread(source, output.data_tables);
+      }
+    }
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
@@ -748,20 +1102,22 @@ void StirlingImpl::RunCore() {
       // Needed to avoid race with main thread update info_class_mgrs_ on new subscription.
       absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
-      // Run through every SourceConnector and InfoClassManager being managed.
+      // The amount to sleep depends on when the earliest Source needs to be sampled again.
+      // Do this to avoid burning CPU cycles unnecessarily.
+      auto wakeup_time = px::chrono::coarse_steady_clock::time_point::max();
+
+      // Run through every SourceConnector and InfoClassManager being managed,
+      // except for those that run on their own threads.
       for (auto& [source, output] : source_output_map_) {
-        // Phase 1: Probe each source for its data.
-        if (source->sampling_freq_mgr().Expired()) {
-          source->TransferData(ctx.get(), output.data_tables);
-        }
-        // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables)) {
-          source->PushData(data_push_callback_, output.data_tables);
+        if (connector_threads_.contains(source)) {
+          continue;
         }
+        TransferAndPush(source, output.data_tables, ctx.get());
+        wakeup_time = std::min(wakeup_time, NextWakeupTime(source, output.data_tables));
       }
 
       // Figure out how long to sleep.
-      sleep_duration = TimeUntilNextTick(source_output_map_);
+      sleep_duration = TimeUntil(wakeup_time);
     }
 
     SleepForDuration(sleep_duration);
@@ -785,9 +1141,27 @@ Status StirlingImpl::WaitUntilRunning(std::chrono::milliseconds timeout) const {
 }
 
 void StirlingImpl::Stop() {
+  // Tracepoints must not be deployed once the sources are stopped.
+  StopTracepointThread();
+
   run_enable_ = false;
   WaitForStop();
 
+  if (probe_cleaner_thread_.joinable()) {
+    probe_cleaner_thread_.join();
+  }
+
+  // The connector threads exit once run_enable_ is cleared; they must be gone before the sources.
+  // They are joined without holding the spin lock.
+  absl::flat_hash_map<SourceConnector*, std::unique_ptr<ConnectorThread>> connector_threads;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    connector_threads.swap(connector_threads_);
+  }
+  for (auto& [source, connector_thread] : connector_threads) {
+    connector_thread->thread.join();
+  }
+
   // Stop all sources.
   // This is important to release any BPF resources that were acquired.
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
@@ -801,25 +1175,18 @@ void StirlingImpl::Stop() {
 }
 
 void StirlingImpl::SetDebugLevel(int level) {
-  // Lock not really required, but compiler is making sure we're safe.
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->SetDebugLevel(level);
-  }
+  ForEachSource([level](SourceConnector* s) { s->SetDebugLevel(level); });
 }
 
 void StirlingImpl::EnablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->EnablePIDTrace(pid);
-  }
+  ForEachSource([pid](SourceConnector* s) { s->EnablePIDTrace(pid); });
 }
 
 void StirlingImpl::DisablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->DisablePIDTrace(pid);
-  }
+  ForEachSource([pid](SourceConnector* s) { s->DisablePIDTrace(pid); });
 }
 
 std::unique_ptr<Stirling> Stirling::Create(std::unique_ptr<SourceRegistry> registry) {
@@ -141,6 +141,13 @@ class Stirling : public NotCopyable {
    */
   virtual void RegisterDataPushCallback(DataPushCallback f) = 0;
 
+  /**
+   * Register a resolver from Agent, which turns a table id and tablet id into a handle to push
+   * data with. When registered, it is used instead of the data push callback, and each tablet
+   * is only resolved once.
+   */
+  virtual void RegisterDataPushHandleResolver(DataPushHandleResolver f) = 0;
+
   /**
    * Register a callback from the agent to fetch the latest metadata state.
    * This state is returned is constant and valid for the duration of the shared_ptr
@@ -149,6 +156,12 @@ class Stirling : public NotCopyable {
    */
   virtual void RegisterAgentMetadataCallback(AgentMetadataCallback f) = 0;
 
+  /**
+   * Register a callback from the agent that is told about processes that started or exited,
+   * as seen by the process lifecycle probes. Called from the source connector threads.
+   */
+  virtual void RegisterPIDChangedCallback(PIDChangedCallback f) = 0;
+
   /**
    * Main data collection call. This version blocks, so make sure to wrap a thread around it.
    */
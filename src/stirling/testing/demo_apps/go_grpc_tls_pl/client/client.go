@@ -42,6 +42,8 @@ func main() {
 	pflag.String("client_tls_key", "", "Path to client.key")
 	pflag.String("tls_ca_cert", "", "Path to ca.crt")
 	pflag.Int("count", 1000, "Number of requests sent.")
+	pflag.Duration("interval", time.Second, "Time between requests.")
+	pflag.Bool("print_latency", false, "Print the latency of each request, for benchmarks.")
 	pflag.Parse()
 	viper.BindPFlags(pflag.CommandLine)
 
@@ -79,12 +81,19 @@ func main() {
 		defer cancel()
 
 		name := fmt.Sprintf("%d", j)
+		start := time.Now()
 		resp, err := client.SayHello(ctx, &greetpb.HelloRequest{Name: name})
+		latency := time.Since(start)
 		if err != nil {
 			log.Printf("could not greet: %v", err)
+		} else if viper.GetBool("print_latency") {
+			fmt.Printf("latency_s %f\n", latency.Seconds())
 		} else {
 			log.Printf("Greeting: %s", resp.Message)
 		}
-		time.Sleep(time.Second)
+		time.Sleep(viper.GetDuration("interval"))
+	}
+	if viper.GetBool("print_latency") {
+		fmt.Println("benchmark done")
 	}
 }
@@ -42,7 +42,9 @@ class MockStirling : public Stirling {
   MOCK_METHOD(Status, RemoveTracepoint, (sole::uuid trace_id), (override));
   MOCK_METHOD(void, GetPublishProto, (stirlingpb::Publish * publish_pb), (override));
   MOCK_METHOD(void, RegisterDataPushCallback, (DataPushCallback f), (override));
+  MOCK_METHOD(void, RegisterDataPushHandleResolver, (DataPushHandleResolver f), (override));
   MOCK_METHOD(void, RegisterAgentMetadataCallback, (AgentMetadataCallback f), (override));
+  MOCK_METHOD(void, RegisterPIDChangedCallback, (PIDChangedCallback f), (override));
   MOCK_METHOD(void, Run, (), (override));
   MOCK_METHOD(Status, RunAsThread, (), (override));
   MOCK_METHOD(bool, IsRunning, (), (const override));
@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <string_view>
+#include <type_traits>
 
 #include "src/common/base/base.h"
 
@@ -27,6 +29,10 @@ namespace stirling {
 
 /**
  * Provides functions to extract bytes from a bytes buffer.
+ *
+ * Each Extract function checks that the buffer has enough bytes. For fixed-size headers, check
+ * the size of the whole header once with HasBytes(), and extract its fields with the Unchecked
+ * variants, which skip the per-field bounds check and the StatusOr.
  */
 // TODO(yzhao): Merge with code in
 // src/stirling/source_connectors/socket_tracer/protocols/cql/frame_body_decoder.{h,cc}.
@@ -37,6 +43,7 @@ class BinaryDecoder {
   bool eof() const { return buf_.empty(); }
   size_t BufSize() const { return buf_.size(); }
   std::string_view Buf() const { return buf_; }
+  bool HasBytes(size_t len) const { return buf_.size() >= len; }
 
   template <typename TCharType = char>
   StatusOr<TCharType> ExtractChar() {
@@ -44,9 +51,7 @@ class BinaryDecoder {
     if (buf_.size() < sizeof(TCharType)) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
-    TCharType res = buf_.front();
-    buf_.remove_prefix(1);
-    return res;
+    return ExtractCharUnchecked<TCharType>();
   }
 
   template <typename TIntType>
@@ -54,9 +59,7 @@ class BinaryDecoder {
     if (buf_.size() < sizeof(TIntType)) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
-    TIntType val = ::px::utils::BEndianBytesToInt<TIntType>(buf_);
-    buf_.remove_prefix(sizeof(TIntType));
-    return val;
+    return ExtractIntUnchecked<TIntType>();
   }
 
   template <typename TCharType = char>
@@ -65,6 +68,53 @@ class BinaryDecoder {
     if (buf_.size() < len) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
+    return ExtractStringUnchecked<TCharType>(len);
+  }
+
+  // Extracts an unsigned LEB128 varint: 7 bits per byte, least significant group first, with the
+  // high bit set on all bytes but the last.
+  template <typename TIntType = uint64_t>
+  StatusOr<TIntType> ExtractUVarint() {
+    static_assert(std::is_unsigned_v<TIntType>);
+    constexpr size_t kMaxBytes = (8 * sizeof(TIntType) + 6) / 7;
+    const size_t n = std::min(buf_.size(), kMaxBytes);
+    TIntType val = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const auto b = static_cast<uint8_t>(buf_[i]);
+      val |= static_cast<TIntType>(b & 0x7f) << (7 * i);
+      if ((b & 0x80) == 0) {
+        buf_.remove_prefix(i + 1);
+        return val;
+      }
+    }
+    if (n < kMaxBytes) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    return error::Internal("Varint is longer than $0 bytes.", kMaxBytes);
+  }
+
+  // The Unchecked variants require the caller to have checked HasBytes().
+  template <typename TCharType = char>
+  TCharType ExtractCharUnchecked() {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK(!buf_.empty());
+    TCharType res = buf_.front();
+    buf_.remove_prefix(1);
+    return res;
+  }
+
+  template <typename TIntType>
+  TIntType ExtractIntUnchecked() {
+    DCHECK_GE(buf_.size(), sizeof(TIntType));
+    TIntType val = ::px::utils::BEndianBytesToInt<TIntType>(buf_);
+    buf_.remove_prefix(sizeof(TIntType));
+    return val;
+  }
+
+  template <typename TCharType = char>
+  std::basic_string_view<TCharType> ExtractStringUnchecked(size_t len) {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK_GE(buf_.size(), len);
     auto tbuf = CreateStringView<TCharType>(buf_);
     buf_.remove_prefix(len);
     return tbuf.substr(0, len);
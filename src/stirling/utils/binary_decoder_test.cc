@@ -59,6 +59,40 @@ TEST(BinaryDecoderTest, ExtractString) {
   EXPECT_EQ(0, bin_decoder.BufSize());
 }
 
+TEST(BinaryDecoderTest, ExtractUnchecked) {
+  std::string_view data("\x05\x00\x00\x01\x02abc");
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_TRUE(bin_decoder.HasBytes(8));
+  EXPECT_FALSE(bin_decoder.HasBytes(9));
+  EXPECT_EQ(bin_decoder.ExtractCharUnchecked(), 5);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<int32_t>(), 258);
+  EXPECT_EQ(bin_decoder.ExtractStringUnchecked(3), "abc");
+  EXPECT_EQ(0, bin_decoder.BufSize());
+}
+
+TEST(BinaryDecoderTest, ExtractUVarint) {
+  std::string_view data("\x01\xac\x02\xff\xff\xff\xff\x0f");
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUVarint(), 1u);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUVarint(), 300u);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractUVarint<uint32_t>(), 0xffffffff);
+  EXPECT_EQ(0, bin_decoder.BufSize());
+}
+
+TEST(BinaryDecoderTest, ExtractUVarintErrors) {
+  // Cut short.
+  BinaryDecoder bin_decoder(ConstStringView("\x80\x80"));
+  EXPECT_NOT_OK(bin_decoder.ExtractUVarint());
+  EXPECT_EQ(2, bin_decoder.BufSize());
+
+  // Too long for a uint32_t.
+  bin_decoder = BinaryDecoder(ConstStringView("\x80\x80\x80\x80\x80\x01"));
+  EXPECT_NOT_OK(bin_decoder.ExtractUVarint<uint32_t>());
+  EXPECT_EQ(6, bin_decoder.BufSize());
+}
+
 TEST(BinaryDecoderTest, ExtractStringUntil) {
   std::string_view data("name!value!name");
   BinaryDecoder bin_decoder(data);
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/btf.h"
+
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+namespace {
+
+// The layouts below follow include/uapi/linux/btf.h.
+constexpr uint16_t kBTFMagic = 0xeB9F;
+
+struct BTFHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t hdr_len;
+  uint32_t type_off;
+  uint32_t type_len;
+  uint32_t str_off;
+  uint32_t str_len;
+};
+
+struct BTFType {
+  uint32_t name_off;
+  // Bits 0-15: vlen, bits 24-28: kind, bit 31: kind_flag.
+  uint32_t info;
+  uint32_t size_or_type;
+
+  uint32_t vlen() const { return info & 0xffff; }
+  uint32_t kind() const { return (info >> 24) & 0x1f; }
+  bool kind_flag() const { return info >> 31; }
+};
+
+struct BTFMember {
+  uint32_t name_off;
+  uint32_t type;
+  // The offset in bits. With kind_flag, only bits 0-23, and bits 24-31 are the bitfield size.
+  uint32_t offset;
+};
+
+enum BTFKind : uint32_t {
+  kInt = 1,
+  kPtr = 2,
+  kArray = 3,
+  kStruct = 4,
+  kUnion = 5,
+  kEnum = 6,
+  kFwd = 7,
+  kTypedef = 8,
+  kVolatile = 9,
+  kConst = 10,
+  kRestrict = 11,
+  kFunc = 12,
+  kFuncProto = 13,
+  kVar = 14,
+  kDatasec = 15,
+  kFloat = 16,
+  kDeclTag = 17,
+  kTypeTag = 18,
+  kEnum64 = 19,
+};
+
+// Returns the size of the data that follows a type of the given kind in the type section.
+StatusOr<size_t> TrailingBytes(const BTFType& type) {
+  switch (type.kind()) {
+    case kPtr:
+    case kFwd:
+    case kTypedef:
+    case kVolatile:
+    case kConst:
+    case kRestrict:
+    case kFunc:
+    case kFloat:
+    case kTypeTag:
+      return 0;
+    case kInt:
+    case kVar:
+    case kDeclTag:
+      return 4;
+    case kArray:
+      return 12;
+    case kStruct:
+    case kUnion:
+    case kDatasec:
+    case kEnum64:
+      return 12 * type.vlen();
+    case kEnum:
+    case kFuncProto:
+      return 8 * type.vlen();
+    default:
+      return error::Internal("Unknown BTF kind $0.", type.kind());
+  }
+}
+
+template <typename T>
+T Read(const char* p) {
+  T val;
+  std::memcpy(&val, p, sizeof(T));
+  return val;
+}
+
+class BTFTypeSection {
+ public:
+  Status Init(std::string_view btf) {
+    if (btf.size() < sizeof(BTFHeader)) {
+      return error::Internal("BTF data is too short for its header.");
+    }
+    const auto hdr = Read<BTFHeader>(btf.data());
+    if (hdr.magic != kBTFMagic) {
+      return error::Internal("Bad BTF magic $0.", hdr.magic);
+    }
+    if (uint64_t{hdr.hdr_len} + hdr.type_off + hdr.type_len > btf.size() ||
+        uint64_t{hdr.hdr_len} + hdr.str_off + hdr.str_len > btf.size()) {
+      return error::Internal("BTF sections are out of bounds.");
+    }
+    std::string_view types = btf.substr(hdr.hdr_len + hdr.type_off, hdr.type_len);
+    strings_ = btf.substr(hdr.hdr_len + hdr.str_off, hdr.str_len);
+
+    // Type IDs start at 1; 0 is void.
+    types_.push_back(nullptr);
+    while (!types.empty()) {
+      if (types.size() < sizeof(BTFType)) {
+        return error::Internal("Truncated BTF type.");
+      }
+      const auto type = Read<BTFType>(types.data());
+      PL_ASSIGN_OR_RETURN(size_t trailing_bytes, TrailingBytes(type));
+      if (types.size() < sizeof(BTFType) + trailing_bytes) {
+        return error::Internal("Truncated BTF type.");
+      }
+      types_.push_back(types.data());
+      types.remove_prefix(sizeof(BTFType) + trailing_bytes);
+    }
+    return Status::OK();
+  }
+
+  size_t num_types() const { return types_.size(); }
+
+  BTFType Type(uint32_t id) const { return Read<BTFType>(types_[id]); }
+
+  BTFMember Member(uint32_t id, uint32_t i) const {
+    return Read<BTFMember>(types_[id] + sizeof(BTFType) + i * sizeof(BTFMember));
+  }
+
+  std::string_view Name(uint32_t name_off) const {
+    if (name_off >= strings_.size()) {
+      return {};
+    }
+    std::string_view name = strings_.substr(name_off);
+    return name.substr(0, name.find('\0'));
+  }
+
+  // Returns the offset in bits of the member, searching anonymous members recursively.
+  std::optional<uint64_t> MemberBitOffset(uint32_t id, std::string_view member_name,
+                                          int depth = 0) const {
+    constexpr int kMaxDepth = 8;
+    const BTFType type = Type(id);
+    for (uint32_t i = 0; i < type.vlen(); ++i) {
+      const BTFMember member = Member(id, i);
+      const uint64_t bit_offset = type.kind_flag() ? member.offset & 0xffffff : member.offset;
+      if (member.name_off != 0) {
+        if (Name(member.name_off) == member_name) {
+          return bit_offset;
+        }
+        continue;
+      }
+      if (depth == kMaxDepth || member.type == 0 || member.type >= num_types()) {
+        continue;
+      }
+      const uint32_t kind = Type(member.type).kind();
+      if (kind == kStruct || kind == kUnion) {
+        std::optional<uint64_t> nested = MemberBitOffset(member.type, member_name, depth + 1);
+        if (nested.has_value()) {
+          return bit_offset + nested.value();
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  std::vector<const char*> types_;
+  std::string_view strings_;
+};
+
+}  // namespace
+
+StatusOr<uint64_t> BTFStructMemberOffset(std::string_view btf, std::string_view struct_name,
+                                         std::string_view member_name) {
+  BTFTypeSection types;
+  PL_RETURN_IF_ERROR(types.Init(btf));
+
+  for (uint32_t id = 1; id < types.num_types(); ++id) {
+    const BTFType type = types.Type(id);
+    // Skip forward declarations and other types of the same name.
+    if (type.kind() != kStruct || types.Name(type.name_off) != struct_name) {
+      continue;
+    }
+    std::optional<uint64_t> bit_offset = types.MemberBitOffset(id, member_name);
+    if (!bit_offset.has_value()) {
+      return error::NotFound("struct $0 has no member $1.", struct_name, member_name);
+    }
+    if (bit_offset.value() % 8 != 0) {
+      return error::Internal("$0.$1 is a bitfield.", struct_name, member_name);
+    }
+    return bit_offset.value() / 8;
+  }
+  return error::NotFound("struct $0 not found in BTF data.", struct_name);
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * Returns the byte offset of a member of a struct, as described by BTF (BPF Type Format) data,
+ * such as the kernel's own type information at /sys/kernel/btf/vmlinux.
+ *
+ * Members of anonymous structs and unions nested in the struct are found as well, with their
+ * offsets relative to the outer struct.
+ *
+ * @param btf The raw BTF data, with a header, a type section and a string section.
+ * @param struct_name The name of the struct, e.g. "task_struct".
+ * @param member_name The name of the member, e.g. "group_leader".
+ * @return error if the data is malformed, or if the struct or the member are not found.
+ */
+StatusOr<uint64_t> BTFStructMemberOffset(std::string_view btf, std::string_view struct_name,
+                                         std::string_view member_name);
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/btf.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+// Builds BTF data in the layout of include/uapi/linux/btf.h.
+class BTFBuilder {
+ public:
+  struct Member {
+    std::string name;
+    uint32_t type;
+    uint32_t bit_offset;
+  };
+
+  BTFBuilder() { strings_.push_back('\0'); }
+
+  uint32_t AddInt(std::string_view name, uint32_t size) {
+    AppendType(AddString(name), /*kind*/ 1, /*vlen*/ 0, size);
+    Append<uint32_t>(size * 8);
+    return ++num_types_;
+  }
+
+  uint32_t AddPtr(uint32_t type) {
+    AppendType(0, /*kind*/ 2, /*vlen*/ 0, type);
+    return ++num_types_;
+  }
+
+  uint32_t AddStruct(std::string_view name, uint32_t size, const std::vector<Member>& members,
+                     uint32_t kind = 4) {
+    AppendType(AddString(name), kind, members.size(), size);
+    for (const auto& member : members) {
+      Append<uint32_t>(AddString(member.name));
+      Append<uint32_t>(member.type);
+      Append<uint32_t>(member.bit_offset);
+    }
+    return ++num_types_;
+  }
+
+  uint32_t AddFwd(std::string_view name) {
+    AppendType(AddString(name), /*kind*/ 7, /*vlen*/ 0, 0);
+    return ++num_types_;
+  }
+
+  std::string Build() const {
+    std::string btf;
+    auto append_u32 = [&btf](uint32_t v) { btf.append(reinterpret_cast<const char*>(&v), 4); };
+    const uint16_t magic = 0xeB9F;
+    btf.append(reinterpret_cast<const char*>(&magic), 2);
+    btf.push_back(1);  // version
+    btf.push_back(0);  // flags
+    append_u32(24);    // hdr_len
+    append_u32(0);     // type_off
+    append_u32(types_.size());
+    append_u32(types_.size());  // str_off
+    append_u32(strings_.size());
+    btf += types_;
+    btf += strings_;
+    return btf;
+  }
+
+ private:
+  uint32_t AddString(std::string_view s) {
+    if (s.empty()) {
+      return 0;
+    }
+    uint32_t off = strings_.size();
+    strings_.append(s);
+    strings_.push_back('\0');
+    return off;
+  }
+
+  template <typename T>
+  void Append(T val) {
+    types_.append(reinterpret_cast<const char*>(&val), sizeof(T));
+  }
+
+  void AppendType(uint32_t name_off, uint32_t kind, uint32_t vlen, uint32_t size_or_type) {
+    Append<uint32_t>(name_off);
+    Append<uint32_t>((kind << 24) | vlen);
+    Append<uint32_t>(size_or_type);
+  }
+
+  std::string types_;
+  std::string strings_;
+  uint32_t num_types_ = 0;
+};
+
+class BTFTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    uint32_t u64 = builder_.AddInt("u64", 8);
+    builder_.AddFwd("task_struct");
+    uint32_t anon_union = builder_.AddStruct("", 8, {{"a", u64, 0}, {"b", u64, 0}}, /*union*/ 5);
+    uint32_t anon_struct =
+        builder_.AddStruct("", 16, {{"start_time", u64, 0}, {"start_boottime", u64, 64}});
+    uint32_t task_ptr = builder_.AddPtr(/*void*/ 0);
+    builder_.AddStruct("task_struct", 48,
+                       {{"state", u64, 0},
+                        {"", anon_union, 64},
+                        {"group_leader", task_ptr, 128},
+                        {"", anon_struct, 256}});
+    btf_ = builder_.Build();
+  }
+
+  BTFBuilder builder_;
+  std::string btf_;
+};
+
+TEST_F(BTFTest, MemberOffsets) {
+  EXPECT_OK_AND_EQ(BTFStructMemberOffset(btf_, "task_struct", "state"), 0);
+  EXPECT_OK_AND_EQ(BTFStructMemberOffset(btf_, "task_struct", "group_leader"), 16);
+  // Members of anonymous structs and unions.
+  EXPECT_OK_AND_EQ(BTFStructMemberOffset(btf_, "task_struct", "b"), 8);
+  EXPECT_OK_AND_EQ(BTFStructMemberOffset(btf_, "task_struct", "start_boottime"), 40);
+}
+
+TEST_F(BTFTest, NotFound) {
+  EXPECT_NOT_OK(BTFStructMemberOffset(btf_, "task_struct", "real_start_time"));
+  EXPECT_NOT_OK(BTFStructMemberOffset(btf_, "mm_struct", "state"));
+}
+
+TEST_F(BTFTest, Malformed) {
+  EXPECT_NOT_OK(BTFStructMemberOffset("", "task_struct", "state"));
+  EXPECT_NOT_OK(BTFStructMemberOffset(btf_.substr(0, btf_.size() - 10), "task_struct", "state"));
+
+  std::string bad_magic = btf_;
+  bad_magic[0] = 0;
+  EXPECT_NOT_OK(BTFStructMemberOffset(bad_magic, "task_struct", "state"));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
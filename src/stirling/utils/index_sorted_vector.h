@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <utility>
 #include <vector>
 
 namespace px {
@@ -45,6 +48,44 @@ std::vector<size_t> SortedIndexes(const std::vector<T>& v) {
   return idx;
 }
 
+// Same as SortedIndexes(), for a vector made of ascending runs, where run_starts holds the
+// positions at which each run after the first one starts.
+// The runs are merged pairwise, so nearly sorted vectors (few runs) are cheaper than a full sort.
+template <typename T>
+std::vector<size_t> SortedIndexesFromRuns(const std::vector<T>& v,
+                                          const std::vector<size_t>& run_starts) {
+  std::vector<size_t> idx(v.size());
+  for (size_t i = 0; i < idx.size(); ++i) {
+    idx[i] = i;
+  }
+
+  std::vector<size_t> bounds;
+  bounds.reserve(run_starts.size() + 2);
+  bounds.push_back(0);
+  bounds.insert(bounds.end(), run_starts.begin(), run_starts.end());
+  bounds.push_back(v.size());
+
+  // std::inplace_merge is stable, so the result is the same as that of SortedIndexes().
+  auto cmp = [&v](size_t i1, size_t i2) { return v[i1] < v[i2]; };
+  while (bounds.size() > 2) {
+    std::vector<size_t> merged_bounds;
+    merged_bounds.reserve(bounds.size() / 2 + 2);
+    size_t i = 0;
+    for (; i + 2 < bounds.size(); i += 2) {
+      std::inplace_merge(idx.begin() + bounds[i], idx.begin() + bounds[i + 1],
+                         idx.begin() + bounds[i + 2], cmp);
+      merged_bounds.push_back(bounds[i]);
+    }
+    // An odd run out is carried over to the next round as is.
+    for (; i < bounds.size(); ++i) {
+      merged_bounds.push_back(bounds[i]);
+    }
+    bounds = std::move(merged_bounds);
+  }
+
+  return idx;
+}
+
 // An iterator that walks over a vector according to provided indexes.
 // Used in conjunction with SortedIndexes to iterate through an unsorted vector in sorted order.
 template <typename T>
@@ -97,7 +138,7 @@ class IndexedVectorIterator {
 // Uses std::lower_bound, which is a binary search for efficiency.
 template <size_t N, typename T>
 std::array<size_t, N> SplitSortedVector(const std::vector<T>& vec,
-                                        const std::vector<size_t> sort_indexes,
+                                        const std::vector<size_t>& sort_indexes,
                                         std::array<T, N> split_vals) {
   std::array<size_t, N> out;
 
@@ -113,6 +154,20 @@ std::array<size_t, N> SplitSortedVector(const std::vector<T>& vec,
   return out;
 }
 
+// Same as above, for a vector that is already sorted.
+template <size_t N, typename T>
+std::array<size_t, N> SplitSortedVector(const std::vector<T>& vec, std::array<T, N> split_vals) {
+  std::array<size_t, N> out;
+
+  auto iter = vec.begin();
+  for (size_t i = 0; i < N; ++i) {
+    iter = std::lower_bound(iter, vec.end(), split_vals[i]);
+    out[i] = iter - vec.begin();
+  }
+
+  return out;
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
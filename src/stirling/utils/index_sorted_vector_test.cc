@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include <limits>
+#include <vector>
 
 #include "src/stirling/utils/index_sorted_vector.h"
 
@@ -33,6 +34,34 @@ TEST(SortedIndexes, Basic) {
   EXPECT_EQ(sort_indexes, (std::vector<size_t>{1, 0, 2, 5, 4, 3}));
 }
 
+// Returns the positions where each ascending run of data, after the first, starts.
+std::vector<size_t> RunStarts(const std::vector<int>& data) {
+  std::vector<size_t> run_starts;
+  for (size_t i = 1; i < data.size(); ++i) {
+    if (data[i] < data[i - 1]) {
+      run_starts.push_back(i);
+    }
+  }
+  return run_starts;
+}
+
+TEST(SortedIndexesFromRuns, MatchesSortedIndexes) {
+  const std::vector<std::vector<int>> inputs = {
+      {},
+      {1},
+      {0, 1, 2, 3},
+      {2, 0, 4, 10, 8, 6},
+      {3, 2, 1, 0},
+      // Equal values must keep their original order.
+      {5, 5, 1, 5, 1, 0, 5},
+      {0, 10, 40, 20, 30, 50, 90, 70, 60, 80},
+  };
+
+  for (const auto& data : inputs) {
+    EXPECT_EQ(SortedIndexesFromRuns(data, RunStarts(data)), SortedIndexes(data));
+  }
+}
+
 TEST(SplitSortedVector, Basic) {
   // Corresponds to {0, 2, 4, 6, 8, 10} after applying sort_indexes
   std::vector<int> data = {2, 0, 4, 10, 8, 6};
@@ -52,6 +81,15 @@ TEST(SplitSortedVector, Basic) {
             (std::array<size_t, 3>{0, 3, 6}));
 }
 
+TEST(SplitSortedVector, AlreadySorted) {
+  std::vector<int> data = {0, 2, 4, 6, 8, 10};
+
+  EXPECT_EQ(SplitSortedVector<2>(data, {0, 8}), (std::array<size_t, 2>{0, 4}));
+  EXPECT_EQ(SplitSortedVector<2>(data, {3, 7}), (std::array<size_t, 2>{2, 4}));
+  EXPECT_EQ(SplitSortedVector<2>(data, {3, 20}), (std::array<size_t, 2>{2, 6}));
+  EXPECT_EQ(SplitSortedVector<3>(data, {-1, 5, 20}), (std::array<size_t, 3>{0, 3, 6}));
+}
+
 void CheckAgainstReferenceModel(std::vector<int> vec, int t1, int t2,
                                 std::array<size_t, 2> split_positions) {
   int num_left = 0;
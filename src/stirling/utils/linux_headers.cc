@@ -23,6 +23,7 @@
 #include <fstream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -478,6 +479,11 @@ Status InstallPackagedLinuxHeaders(const std::filesystem::path& lib_modules_dir)
 
 StatusOr<std::filesystem::path> FindOrInstallLinuxHeaders(
     const std::vector<LinuxHeaderStrategy>& attempt_order) {
+  // Source connectors may be initialized concurrently, and only one of them should link or
+  // install the headers.
+  static std::mutex install_mutex;
+  std::lock_guard<std::mutex> lock(install_mutex);
+
   PL_ASSIGN_OR_RETURN(std::string uname, GetUname());
   LOG(INFO) << absl::Substitute("Detected kernel release (uname -r): $0", uname);
 
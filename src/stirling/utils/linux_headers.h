@@ -46,6 +46,11 @@ uint64_t KernelHeadersDistance(KernelVersion a, KernelVersion b);
  */
 StatusOr<KernelVersion> ParseKernelVersionString(const std::string& linux_release);
 
+/**
+ * Returns the kernel release reported by uname (e.g. 4.15.0-96-generic).
+ */
+StatusOr<std::string> GetUname();
+
 /**
  * Returns the kernel version from /proc/version_signature.
  * This is required for Ubuntu, which does not report the correct minor version through uname.
@@ -170,6 +175,8 @@ inline const std::vector<LinuxHeaderStrategy> kDefaultHeaderSearchOrder = {
  * @param attempt_order Provides the ordered list of strategies to use to find the Linux headers.
  * See LinuxHeaderStrategy enum.
  *
+ * Concurrent calls are serialized.
+ *
  * @return Status error if no headers (either host headers or installed packaged headers) are
  * available in the end state.
  */
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/utils/perf_stats.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+std::string Log2HistogramToJSON(absl::Span<const uint64_t> hist) {
+  rapidjson::StringBuffer sb;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+  writer.StartObject();
+  for (size_t i = 0; i < hist.size(); ++i) {
+    if (hist[i] == 0) {
+      continue;
+    }
+    uint64_t lower_bound = (i == 0) ? 0 : (1ULL << (i - 1));
+    writer.Key(std::to_string(lower_bound).c_str());
+    writer.Uint64(hist[i]);
+  }
+  writer.EndObject();
+  return sb.GetString();
+}
+
+namespace {
+
+size_t HistogramBucket(std::chrono::nanoseconds duration) {
+  const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  // The bucket is the number of significant bits, i.e. floor(log2(us)) + 1 for us > 0.
+  size_t bucket = 0;
+  for (uint64_t v = us; v != 0; v >>= 1) {
+    ++bucket;
+  }
+  return std::min(bucket, PerfProbe::kNumHistogramBuckets - 1);
+}
+
+}  // namespace
+
+void PerfProbe::Record(std::chrono::nanoseconds duration) {
+  const uint64_t ns = std::max<int64_t>(duration.count(), 0);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_ns_.fetch_add(ns, std::memory_order_relaxed);
+  uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+  while (ns > max_ns && !max_ns_.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed)) {
+  }
+  histogram_[HistogramBucket(duration)].fetch_add(1, std::memory_order_relaxed);
+}
+
+PerfProbe::Snapshot PerfProbe::TakeSnapshot() {
+  // The fields are reset one at a time, so a concurrent sample may be split across two
+  // snapshots; this is fine for statistics that are only ever aggregated.
+  Snapshot snapshot;
+  snapshot.name = name_;
+  snapshot.count = count_.exchange(0, std::memory_order_relaxed);
+  snapshot.total_ns = total_ns_.exchange(0, std::memory_order_relaxed);
+  snapshot.max_ns = max_ns_.exchange(0, std::memory_order_relaxed);
+  snapshot.event_loss = event_loss_.exchange(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < kNumHistogramBuckets; ++i) {
+    snapshot.histogram[i] = histogram_[i].exchange(0, std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+PerfStats& PerfStats::GetInstance() {
+  static PerfStats* perf_stats = new PerfStats();
+  return *perf_stats;
+}
+
+PerfProbe* PerfStats::GetProbe(std::string_view name) {
+  absl::MutexLock lock(&probes_lock_);
+  ProbeEntry& entry = probes_[name];
+  if (entry.probe == nullptr) {
+    entry.probe = std::make_unique<PerfProbe>(std::string(name));
+  }
+  ++entry.num_users;
+  return entry.probe.get();
+}
+
+void PerfStats::ReleaseProbe(PerfProbe* probe) {
+  absl::MutexLock lock(&probes_lock_);
+  auto iter = probes_.find(probe->name());
+  DCHECK(iter != probes_.end() && iter->second.probe.get() == probe)
+      << absl::Substitute("Releasing unknown probe $0", probe->name());
+  if (iter != probes_.end() && --iter->second.num_users == 0) {
+    probes_.erase(iter);
+  }
+}
+
+std::vector<PerfProbe::Snapshot> PerfStats::TakeSnapshots() {
+  absl::MutexLock lock(&probes_lock_);
+  std::vector<PerfProbe::Snapshot> snapshots;
+  for (auto& [name, entry] : probes_) {
+    PerfProbe::Snapshot snapshot = entry.probe->TakeSnapshot();
+    if (snapshot.count > 0 || snapshot.event_loss > 0) {
+      snapshots.push_back(std::move(snapshot));
+    }
+  }
+  return snapshots;
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/types/span.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * Returns the non-empty buckets of a log2 histogram as a JSON object, from the lower bound of each
+ * bucket to its count. Bucket 0 counts zeros, and bucket i counts values in [2^(i-1), 2^i).
+ */
+std::string Log2HistogramToJSON(absl::Span<const uint64_t> hist);
+
+/**
+ * Timing and event-loss statistics of one instrumented point of Stirling, e.g. a connector's
+ * TransferData(). Samples can be recorded from any thread without taking a lock.
+ */
+class PerfProbe : public NotCopyMoveable {
+ public:
+  // Durations are bucketed by powers of 2 in microseconds: bucket 0 holds durations under 1us,
+  // bucket i holds [2^(i-1), 2^i) us, and the last bucket also holds everything above.
+  static constexpr size_t kNumHistogramBuckets = 24;
+
+  struct Snapshot {
+    std::string name;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t event_loss = 0;
+    std::array<uint64_t, kNumHistogramBuckets> histogram = {};
+  };
+
+  explicit PerfProbe(std::string name) : name_(std::move(name)) {}
+
+  const std::string& name() const { return name_; }
+
+  void Record(std::chrono::nanoseconds duration);
+
+  void RecordEventLoss(uint64_t count) { event_loss_.fetch_add(count, std::memory_order_relaxed); }
+
+  /**
+   * Returns the statistics recorded since the previous snapshot, and resets them.
+   */
+  Snapshot TakeSnapshot();
+
+ private:
+  const std::string name_;
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<uint64_t> total_ns_ = 0;
+  std::atomic<uint64_t> max_ns_ = 0;
+  std::atomic<uint64_t> event_loss_ = 0;
+  std::array<std::atomic<uint64_t>, kNumHistogramBuckets> histogram_ = {};
+};
+
+/**
+ * The process-wide set of probes, which the stirling_perf connector exports as a table.
+ */
+class PerfStats : public NotCopyMoveable {
+ public:
+  static PerfStats& GetInstance();
+
+  /**
+   * Returns the probe with the given name, creating it on first use.
+   * Callers should look the probe up once and keep the pointer, and release it with
+   * ReleaseProbe() once done, so that the probes of short-lived sources (e.g. the DT_* dynamic
+   * tracepoint connectors) don't accumulate.
+   */
+  PerfProbe* GetProbe(std::string_view name);
+
+  /**
+   * Releases a probe returned by GetProbe(). The probe is destroyed once all the callers that
+   * got it have released it.
+   */
+  void ReleaseProbe(PerfProbe* probe);
+
+  /**
+   * Returns the snapshots of all the probes that recorded anything since the previous call.
+   */
+  std::vector<PerfProbe::Snapshot> TakeSnapshots();
+
+ private:
+  struct ProbeEntry {
+    std::unique_ptr<PerfProbe> probe;
+    // The number of GetProbe() calls not yet matched by a ReleaseProbe().
+    int num_users = 0;
+  };
+
+  absl::Mutex probes_lock_;
+  absl::flat_hash_map<std::string, ProbeEntry> probes_ ABSL_GUARDED_BY(probes_lock_);
+};
+
+/**
+ * Records the time spent in its scope into a probe.
+ * Unlike px::ScopedTimer, which logs the time, this is cheap enough for hot paths.
+ */
+class ScopedPerfTimer : public NotCopyable {
+ public:
+  explicit ScopedPerfTimer(PerfProbe* probe)
+      : probe_(probe), start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedPerfTimer() { probe_->Record(std::chrono::steady_clock::now() - start_); }
+
+ private:
+  PerfProbe* probe_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
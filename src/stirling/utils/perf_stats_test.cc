@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/utils/perf_stats.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+using ::testing::Field;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+TEST(Log2HistogramToJSONTest, SkipsEmptyBuckets) {
+  std::vector<uint64_t> hist(8, 0);
+  EXPECT_EQ(Log2HistogramToJSON(hist), "{}");
+
+  hist[0] = 3;
+  hist[1] = 1;
+  hist[5] = 2;
+  EXPECT_EQ(Log2HistogramToJSON(hist), R"({"0":3,"1":1,"16":2})");
+}
+
+TEST(PerfProbeTest, RecordAndSnapshot) {
+  PerfProbe probe("probe");
+
+  probe.Record(std::chrono::nanoseconds(500));
+  probe.Record(std::chrono::microseconds(3));
+  probe.Record(std::chrono::microseconds(3));
+  probe.Record(std::chrono::hours(1));
+  probe.RecordEventLoss(7);
+
+  PerfProbe::Snapshot snapshot = probe.TakeSnapshot();
+  EXPECT_EQ(snapshot.name, "probe");
+  EXPECT_EQ(snapshot.count, 4);
+  EXPECT_EQ(snapshot.total_ns, 500 + 6000 + 3600'000'000'000ULL);
+  EXPECT_EQ(snapshot.max_ns, 3600'000'000'000ULL);
+  EXPECT_EQ(snapshot.event_loss, 7);
+  // 500ns is under 1us, 3us is in [2, 4) us, and 1h overflows into the last bucket.
+  EXPECT_EQ(snapshot.histogram[0], 1);
+  EXPECT_EQ(snapshot.histogram[2], 2);
+  EXPECT_EQ(snapshot.histogram[PerfProbe::kNumHistogramBuckets - 1], 1);
+
+  // Taking the snapshot resets the probe.
+  snapshot = probe.TakeSnapshot();
+  EXPECT_EQ(snapshot.count, 0);
+  EXPECT_EQ(snapshot.max_ns, 0);
+  EXPECT_EQ(snapshot.histogram[2], 0);
+}
+
+TEST(PerfStatsTest, SnapshotsOnlyActiveProbes) {
+  PerfStats& perf_stats = PerfStats::GetInstance();
+
+  PerfProbe* active = perf_stats.GetProbe("PerfStatsTest.active");
+  PerfProbe* lossy = perf_stats.GetProbe("PerfStatsTest.lossy");
+  perf_stats.GetProbe("PerfStatsTest.idle");
+  EXPECT_EQ(perf_stats.GetProbe("PerfStatsTest.active"), active);
+
+  {
+    ScopedPerfTimer timer(active);
+  }
+  lossy->RecordEventLoss(1);
+
+  EXPECT_THAT(perf_stats.TakeSnapshots(),
+              UnorderedElementsAre(
+                  Field(&PerfProbe::Snapshot::name, "PerfStatsTest.active"),
+                  Field(&PerfProbe::Snapshot::name, "PerfStatsTest.lossy")));
+  EXPECT_THAT(perf_stats.TakeSnapshots(), IsEmpty());
+}
+
+TEST(PerfStatsTest, ReleasedProbesAreRemoved) {
+  PerfStats& perf_stats = PerfStats::GetInstance();
+
+  PerfProbe* probe = perf_stats.GetProbe("PerfStatsTest.released");
+  EXPECT_EQ(perf_stats.GetProbe("PerfStatsTest.released"), probe);
+
+  // The probe stays while one of its users still holds it.
+  perf_stats.ReleaseProbe(probe);
+  probe->RecordEventLoss(1);
+  EXPECT_THAT(perf_stats.TakeSnapshots(),
+              UnorderedElementsAre(Field(&PerfProbe::Snapshot::name, "PerfStatsTest.released")));
+
+  perf_stats.ReleaseProbe(probe);
+  probe = perf_stats.GetProbe("PerfStatsTest.released");
+  probe->RecordEventLoss(1);
+  perf_stats.ReleaseProbe(probe);
+  EXPECT_THAT(perf_stats.TakeSnapshots(), IsEmpty());
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -25,7 +25,8 @@
 namespace px {
 namespace stirling {
 
-void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids) {
+void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids, uint64_t epoch) {
+  epoch_ = epoch;
   new_upids_.clear();
   for (const auto& upid : upids) {
     auto iter = upids_.find(upid);
@@ -39,5 +40,26 @@ void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids) {
   upids_ = std::move(upids);
 }
 
+void ProcTracker::UpdateFromEvents(const absl::flat_hash_set<md::UPID>& started,
+                                   const absl::flat_hash_set<md::UPID>& terminated,
+                                   uint64_t epoch) {
+  epoch_ = epoch;
+  new_upids_.clear();
+  deleted_upids_.clear();
+  for (const auto& upid : terminated) {
+    if (upids_.erase(upid) != 0) {
+      deleted_upids_.emplace(upid);
+    }
+  }
+  for (const auto& upid : started) {
+    if (terminated.contains(upid)) {
+      // Process was too short-lived to be of interest.
+      continue;
+    }
+    upids_.emplace(upid);
+    new_upids_.emplace(upid);
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -35,8 +35,21 @@ class ProcTracker : NotCopyMoveable {
   /**
    * Takes the current set of upids, and updates the internal state.
    * @param upids Current set of UPIDs.
+   * @param epoch The epoch of upids, if they are versioned (see ConnectorContext::GetUPIDsEpoch()).
    */
-  void Update(absl::flat_hash_set<md::UPID> upids);
+  void Update(absl::flat_hash_set<md::UPID> upids, uint64_t epoch = 0);
+
+  /**
+   * Updates the internal state from process lifecycle events (e.g. exec and exit), instead of a
+   * full listing of the current upids. A upid that appears in both sets is dropped.
+   * A upid that is already tracked, but shows up in started (e.g. a re-exec), is reported as new.
+   * @param started UPIDs that started since the last update.
+   * @param terminated UPIDs that terminated since the last update.
+   * @param epoch The epoch of the UPIDs after the update, if started and terminated are the
+   * changes between two versions of the UPIDs.
+   */
+  void UpdateFromEvents(const absl::flat_hash_set<md::UPID>& started,
+                        const absl::flat_hash_set<md::UPID>& terminated, uint64_t epoch = 0);
 
   /**
    * Returns all current upids, as set by last call to Update().
@@ -53,10 +66,16 @@ class ProcTracker : NotCopyMoveable {
    */
   const auto& deleted_upids() const { return deleted_upids_; }
 
+  /**
+   * Returns the epoch of the UPIDs of the last update, or 0 if they are not versioned.
+   */
+  uint64_t epoch() const { return epoch_; }
+
  private:
   absl::flat_hash_set<md::UPID> upids_;
   absl::flat_hash_set<md::UPID> new_upids_;
   absl::flat_hash_set<md::UPID> deleted_upids_;
+  uint64_t epoch_ = 0;
 };
 
 }  // namespace stirling
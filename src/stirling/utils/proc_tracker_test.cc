@@ -61,5 +61,50 @@ TEST_F(ProcTrackerTest, Basic) {
   EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID3));
 }
 
+TEST_F(ProcTrackerTest, UpdateFromEvents) {
+  using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+  const md::UPID kUPID3 = md::UPID(0, 3, 333);
+  const md::UPID kUPID4 = md::UPID(0, 4, 444);
+
+  proc_tracker_.Update(UPIDSet{kUPID1, kUPID2});
+
+  proc_tracker_.UpdateFromEvents(/* started */ UPIDSet{kUPID3}, /* terminated */ UPIDSet{kUPID2});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1, kUPID3));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID2));
+
+  // kUPID4 started and terminated between updates, and kUPID1 re-exec'ed.
+  proc_tracker_.UpdateFromEvents(UPIDSet{kUPID1, kUPID4}, UPIDSet{kUPID4});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1, kUPID3));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), IsEmpty());
+
+  // A full update reconciles with the events.
+  proc_tracker_.Update(UPIDSet{kUPID3, kUPID4});
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID3, kUPID4));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID4));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+}
+
+TEST_F(ProcTrackerTest, Epoch) {
+  using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+
+  EXPECT_EQ(proc_tracker_.epoch(), 0UL);
+  proc_tracker_.Update(UPIDSet{kUPID1}, /* epoch */ 3);
+  EXPECT_EQ(proc_tracker_.epoch(), 3UL);
+  proc_tracker_.UpdateFromEvents(UPIDSet{kUPID2}, UPIDSet{}, /* epoch */ 4);
+  EXPECT_EQ(proc_tracker_.epoch(), 4UL);
+  // Unversioned updates reset the epoch.
+  proc_tracker_.UpdateFromEvents(UPIDSet{}, UPIDSet{kUPID1});
+  EXPECT_EQ(proc_tracker_.epoch(), 0UL);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID2));
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -78,6 +78,15 @@ int64_t RowBatch::NumBytes() const {
   return total_bytes;
 }
 
+bool RowBatch::HasNulls() const {
+  for (const auto& col : columns_) {
+    if (col->null_count() != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // Serialize/deserialize from protobuf.
 
 // PL_CARNOT_UPDATE_FOR_NEW_TYPES
@@ -158,7 +167,89 @@ Status CopyFromInputPB(std::shared_ptr<arrow::Array>* output_column,
   return Status::OK();
 }
 
-Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
+namespace {
+bool SupportsArrowBuffers(DataType type) {
+  return type == DataType::INT64 || type == DataType::TIME64NS || type == DataType::FLOAT64 ||
+         type == DataType::STRING;
+}
+
+// All of the fixed width types in SupportsArrowBuffers are 8 bytes wide.
+constexpr int64_t kArrowBufferValueBytes = 8;
+
+void CopyIntoArrowColumn(DataType type, arrow::Array* input_column,
+                         table_store::schemapb::ArrowColumn* output_column) {
+  output_column->set_data_type(type);
+  int64_t length = input_column->length();
+  if (length == 0) {
+    return;
+  }
+  if (type != DataType::STRING) {
+    // Sliced arrays share the buffers of the array they were sliced from.
+    const auto* values = static_cast<arrow::PrimitiveArray*>(input_column)->values()->data();
+    output_column->set_values(
+        reinterpret_cast<const char*>(values) + input_column->offset() * kArrowBufferValueBytes,
+        length * kArrowBufferValueBytes);
+    return;
+  }
+
+  auto* string_column = static_cast<arrow::StringArray*>(input_column);
+  // The offsets of a sliced array don't start at 0, so they are rebased.
+  const int32_t* offsets = string_column->raw_value_offsets();
+  int32_t first_offset = offsets[0];
+  std::string* output_offsets = output_column->mutable_offsets();
+  output_offsets->resize((length + 1) * sizeof(int32_t));
+  auto* rebased_offsets = reinterpret_cast<int32_t*>(output_offsets->data());
+  for (int64_t i = 0; i <= length; ++i) {
+    rebased_offsets[i] = offsets[i] - first_offset;
+  }
+  output_column->set_values(
+      reinterpret_cast<const char*>(string_column->value_data()->data()) + first_offset,
+      offsets[length] - first_offset);
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> ArrowColumnToArray(std::string values,
+                                                           std::string offsets, DataType type,
+                                                           int64_t num_rows) {
+  if (type == DataType::STRING) {
+    int64_t expected_offsets_bytes = num_rows == 0 ? 0 : (num_rows + 1) * sizeof(int32_t);
+    if (static_cast<int64_t>(offsets.size()) != expected_offsets_bytes) {
+      return error::Internal("ArrowColumn has $0 offset bytes for $1 rows", offsets.size(),
+                             num_rows);
+    }
+    if (num_rows > 0 &&
+        reinterpret_cast<const int32_t*>(offsets.data())[num_rows] !=
+            static_cast<int32_t>(values.size())) {
+      return error::Internal("ArrowColumn offsets don't match its $0 bytes of values",
+                             values.size());
+    }
+    if (num_rows == 0) {
+      // Arrow requires a single offset even for an empty array.
+      offsets.assign(sizeof(int32_t), '\0');
+    }
+    return std::make_shared<arrow::StringArray>(num_rows,
+                                                arrow::Buffer::FromString(std::move(offsets)),
+                                                arrow::Buffer::FromString(std::move(values)));
+  }
+
+  if (static_cast<int64_t>(values.size()) != num_rows * kArrowBufferValueBytes) {
+    return error::Internal("ArrowColumn has $0 value bytes for $1 rows", values.size(), num_rows);
+  }
+  auto values_buffer = arrow::Buffer::FromString(std::move(values));
+  switch (type) {
+    case DataType::INT64:
+    case DataType::TIME64NS:
+      return std::make_shared<arrow::Int64Array>(num_rows, values_buffer);
+    case DataType::FLOAT64:
+      return std::make_shared<arrow::DoubleArray>(num_rows, values_buffer);
+    default:
+      return error::Internal("ArrowColumn doesn't support data type $0",
+                             magic_enum::enum_name(type));
+  }
+}
+
+}  // namespace
+
+Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto, bool arrow_buffers) const {
   proto->set_num_rows(num_rows_);
   proto->set_eow(eow_);
   proto->set_eos(eos_);
@@ -167,6 +258,10 @@ Status RowBatch::ToProto(table_store::schemapb::RowBatchData* proto) const {
     auto input_col = ColumnAt(col_idx).get();
     auto output_col_data = proto->add_cols();
     auto dt = desc_.type(col_idx);
+    if (arrow_buffers && SupportsArrowBuffers(dt)) {
+      CopyIntoArrowColumn(dt, input_col, output_col_data->mutable_arrow_data());
+      continue;
+    }
 
 #define TYPE_CASE(_dt_) CopyIntoOutputPB<_dt_>(output_col_data, input_col);
     PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
@@ -191,20 +286,40 @@ StatusOr<DataType> ProtoDataType(const table_store::schemapb::Column& proto) {
       return DataType::FLOAT64;
     case table_store::schemapb::Column::kStringData:
       return DataType::STRING;
+    case table_store::schemapb::Column::kArrowData:
+      return proto.arrow_data().data_type();
     default:
       return error::Internal("Received unknown column data type '$0' in ProtoDataType",
                              magic_enum::enum_name(proto.col_data_case()));
   }
 }
 
-StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
-    const table_store::schemapb::RowBatchData& proto) {
+namespace {
+// When mutable_proto is set, it must point to proto and its ArrowColumn buffers are moved into the
+// output arrays instead of being copied.
+StatusOr<std::unique_ptr<RowBatch>> RowBatchFromProto(
+    const table_store::schemapb::RowBatchData& proto,
+    table_store::schemapb::RowBatchData* mutable_proto) {
   std::vector<DataType> types(proto.cols_size());
   std::vector<std::shared_ptr<arrow::Array>> data_columns(proto.cols_size());
 
   for (auto i = 0; i < proto.cols_size(); ++i) {
     PL_ASSIGN_OR_RETURN(types[i], ProtoDataType(proto.cols(i)));
-    std::shared_ptr<arrow::Array> output_array;
+    if (proto.cols(i).has_arrow_data()) {
+      std::string values;
+      std::string offsets;
+      if (mutable_proto != nullptr) {
+        auto* arrow_data = mutable_proto->mutable_cols(i)->mutable_arrow_data();
+        values = std::move(*arrow_data->mutable_values());
+        offsets = std::move(*arrow_data->mutable_offsets());
+      } else {
+        values = proto.cols(i).arrow_data().values();
+        offsets = proto.cols(i).arrow_data().offsets();
+      }
+      PL_ASSIGN_OR_RETURN(data_columns[i], ArrowColumnToArray(std::move(values), std::move(offsets),
+                                                              types[i], proto.num_rows()));
+      continue;
+    }
 
 #define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(CopyFromInputPB<_dt_>(&data_columns[i], proto.cols(i)));
     PL_SWITCH_FOREACH_DATATYPE(types[i], TYPE_CASE);
@@ -222,6 +337,17 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
 
   return output_rb;
 }
+}  // namespace
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
+    const table_store::schemapb::RowBatchData& proto) {
+  return RowBatchFromProto(proto, /* mutable_proto */ nullptr);
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromMutableProto(
+    table_store::schemapb::RowBatchData* proto) {
+  return RowBatchFromProto(*proto, proto);
+}
 
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromColumnBuilders(
     const RowDescriptor& desc, bool eow, bool eos,
@@ -51,9 +51,24 @@ class RowBatch {
 
   ~RowBatch() { DCHECK_EQ(desc_.size(), columns_.size()); }
 
-  Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
+  /**
+   * Serializes the row batch.
+   *
+   * @param row_batch_proto the proto to write to.
+   * @param arrow_buffers whether columns that support it are written as raw arrow buffers
+   * (ArrowColumn) instead of one protobuf value per row. The receiver must support ArrowColumns.
+   */
+  Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto,
+                 bool arrow_buffers = false) const;
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
+  /**
+   * Same as FromProto, but the arrays of ArrowColumns take ownership of the proto's buffers
+   * instead of copying them. The proto's buffers are moved from, so it shouldn't be read
+   * afterwards.
+   */
+  static StatusOr<std::unique_ptr<RowBatch>> FromMutableProto(
+      table_store::schemapb::RowBatchData* row_batch_proto);
 
   static StatusOr<std::unique_ptr<RowBatch>> FromColumnBuilders(
       const RowDescriptor& desc, bool eow, bool eos,
@@ -122,6 +137,11 @@ class RowBatch {
 
   int64_t NumBytes() const;
 
+  /**
+   * @ return whether any of the columns has nulls.
+   */
+  bool HasNulls() const;
+
  private:
   RowDescriptor desc_;
   int64_t num_rows_;
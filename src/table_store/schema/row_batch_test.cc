@@ -179,6 +179,46 @@ TEST_F(RowBatchTest, to_from_proto) {
   EXPECT_TRUE(differ.Compare(input_proto, output_proto));
 }
 
+TEST_F(RowBatchTest, to_from_proto_arrow_buffers) {
+  RowDescriptor rd({types::DataType::BOOLEAN, types::DataType::INT64, types::DataType::FLOAT64,
+                    types::DataType::STRING});
+  RowBatch rb(rd, 3);
+  std::vector<types::BoolValue> in1 = {true, false, true};
+  std::vector<types::Int64Value> in2 = {3, 4, 5};
+  std::vector<types::Float64Value> in3 = {3.3, 4.1, 5.6};
+  std::vector<types::StringValue> in4 = {"hello", "thisIs", "aString"};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in2, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in3, arrow::default_memory_pool())));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in4, arrow::default_memory_pool())));
+
+  // Slice the batch so that the arrays don't start at the beginning of their buffers.
+  ASSERT_OK_AND_ASSIGN(auto sliced_rb, rb.Slice(1, 2));
+  table_store::schemapb::RowBatchData proto;
+  EXPECT_OK(sliced_rb->ToProto(&proto, /* arrow_buffers */ true));
+  EXPECT_TRUE(proto.cols(0).has_boolean_data());
+  EXPECT_TRUE(proto.cols(1).has_arrow_data());
+  EXPECT_TRUE(proto.cols(2).has_arrow_data());
+  EXPECT_TRUE(proto.cols(3).has_arrow_data());
+  EXPECT_EQ("thisIsaString", proto.cols(3).arrow_data().values());
+
+  ASSERT_OK_AND_ASSIGN(auto copied_rb, RowBatch::FromProto(proto));
+  EXPECT_EQ(rd, copied_rb->desc());
+  EXPECT_EQ(sliced_rb->DebugString(), copied_rb->DebugString());
+
+  ASSERT_OK_AND_ASSIGN(auto moved_rb, RowBatch::FromMutableProto(&proto));
+  EXPECT_EQ(sliced_rb->DebugString(), moved_rb->DebugString());
+}
+
+TEST_F(RowBatchTest, arrow_buffers_size_mismatch) {
+  table_store::schemapb::RowBatchData proto;
+  proto.set_num_rows(2);
+  auto* col = proto.add_cols()->mutable_arrow_data();
+  col->set_data_type(types::DataType::INT64);
+  col->set_values(std::string(sizeof(int64_t), '\0'));
+  EXPECT_NOT_OK(RowBatch::FromProto(proto));
+}
+
 TEST_F(RowBatchTest, with_zero_rows) {
   bool eow = true;
   bool eos = false;
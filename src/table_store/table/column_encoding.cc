@@ -0,0 +1,204 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/column_encoding.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const std::string& in, size_t* pos) {
+  uint64_t value = 0;
+  int shift = 0;
+  uint8_t byte;
+  do {
+    byte = static_cast<uint8_t>(in[(*pos)++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+// Maps signed values to unsigned ones so that small negative deltas stay small.
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+}  // namespace
+
+std::unique_ptr<EncodedBatch> EncodedBatch::Encode(types::DataType data_type,
+                                                   const arrow::Array& batch) {
+  if (batch.length() == 0 || batch.null_count() != 0) {
+    return nullptr;
+  }
+  std::unique_ptr<EncodedBatch> encoded;
+  switch (data_type) {
+    case types::DataType::STRING:
+      encoded = EncodeDictionary(static_cast<const arrow::StringArray&>(batch));
+      break;
+    case types::DataType::TIME64NS:
+      encoded =
+          EncodeIntegers(ColumnEncoding::kDelta, static_cast<const arrow::Int64Array&>(batch));
+      break;
+    case types::DataType::INT64:
+      encoded = EncodeIntegers(ColumnEncoding::kFrameOfReference,
+                               static_cast<const arrow::Int64Array&>(batch));
+      break;
+    default:
+      return nullptr;
+  }
+  if (encoded == nullptr || encoded->encoded_bytes() >= encoded->logical_bytes()) {
+    return nullptr;
+  }
+  return encoded;
+}
+
+std::unique_ptr<EncodedBatch> EncodedBatch::EncodeDictionary(const arrow::StringArray& batch) {
+  auto encoded = std::unique_ptr<EncodedBatch>(new EncodedBatch(
+      ColumnEncoding::kDictionary, batch.length(),
+      types::GetArrowArrayBytes<types::DataType::STRING>(&batch)));
+
+  // The views point into the batch, which outlives the map.
+  absl::flat_hash_map<std::string_view, uint32_t> indices;
+  std::vector<uint32_t> row_indices;
+  row_indices.reserve(batch.length());
+  for (int64_t i = 0; i < batch.length(); ++i) {
+    auto value = batch.GetView(i);
+    std::string_view view(value.data(), value.size());
+    auto [it, inserted] = indices.try_emplace(view, encoded->dictionary_.size());
+    if (inserted) {
+      if (encoded->dictionary_.size() == kMaxDictionarySize) {
+        return nullptr;
+      }
+      encoded->dictionary_.emplace_back(view);
+      encoded->dictionary_bytes_ += view.size();
+    }
+    row_indices.push_back(it->second);
+  }
+
+  encoded->index_width_ = encoded->dictionary_.size() <= (1 << 8) ? 1 : 2;
+  encoded->data_.reserve(row_indices.size() * encoded->index_width_);
+  for (uint32_t idx : row_indices) {
+    for (int b = 0; b < encoded->index_width_; ++b) {
+      encoded->data_.push_back(static_cast<char>((idx >> (8 * b)) & 0xff));
+    }
+  }
+  return encoded;
+}
+
+std::unique_ptr<EncodedBatch> EncodedBatch::EncodeIntegers(ColumnEncoding encoding,
+                                                           const arrow::Int64Array& batch) {
+  auto encoded = std::unique_ptr<EncodedBatch>(new EncodedBatch(
+      encoding, batch.length(), types::GetArrowArrayBytes<types::DataType::INT64>(&batch)));
+  const int64_t* values = batch.raw_values();
+
+  // The differences are computed on unsigned values, so they wrap around instead of overflowing.
+  if (encoding == ColumnEncoding::kDelta) {
+    encoded->base_ = values[0];
+    for (int64_t i = 1; i < batch.length(); ++i) {
+      auto delta = static_cast<int64_t>(static_cast<uint64_t>(values[i]) -
+                                        static_cast<uint64_t>(values[i - 1]));
+      AppendVarint(ZigZagEncode(delta), &encoded->data_);
+    }
+  } else {
+    encoded->base_ = *std::min_element(values, values + batch.length());
+    for (int64_t i = 0; i < batch.length(); ++i) {
+      AppendVarint(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(encoded->base_),
+                   &encoded->data_);
+    }
+  }
+  return encoded;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedBatch::Decode(arrow::MemoryPool* mem_pool) const {
+  switch (encoding_) {
+    case ColumnEncoding::kDictionary:
+      return DecodeDictionary(mem_pool);
+    case ColumnEncoding::kDelta:
+    case ColumnEncoding::kFrameOfReference:
+      return DecodeIntegers(mem_pool);
+  }
+  return error::Internal("Unknown column encoding");
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedBatch::DecodeDictionary(
+    arrow::MemoryPool* mem_pool) const {
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  PL_RETURN_IF_ERROR(builder.ReserveData(logical_bytes_));
+  const auto* indices = reinterpret_cast<const uint8_t*>(data_.data());
+  for (int64_t i = 0; i < length_; ++i) {
+    uint32_t idx = 0;
+    for (int b = 0; b < index_width_; ++b) {
+      idx |= static_cast<uint32_t>(indices[i * index_width_ + b]) << (8 * b);
+    }
+    builder.UnsafeAppend(dictionary_[idx]);
+  }
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> EncodedBatch::DecodeIntegers(
+    arrow::MemoryPool* mem_pool) const {
+  arrow::Int64Builder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(length_));
+  size_t pos = 0;
+  if (encoding_ == ColumnEncoding::kDelta) {
+    uint64_t value = static_cast<uint64_t>(base_);
+    builder.UnsafeAppend(static_cast<int64_t>(value));
+    for (int64_t i = 1; i < length_; ++i) {
+      value += static_cast<uint64_t>(ZigZagDecode(ReadVarint(data_, &pos)));
+      builder.UnsafeAppend(static_cast<int64_t>(value));
+    }
+  } else {
+    for (int64_t i = 0; i < length_; ++i) {
+      builder.UnsafeAppend(
+          static_cast<int64_t>(static_cast<uint64_t>(base_) + ReadVarint(data_, &pos)));
+    }
+  }
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder.Finish(&arr));
+  return arr;
+}
+
+}  // namespace table_store
+}  // namespace px
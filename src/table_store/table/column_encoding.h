@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+enum class ColumnEncoding {
+  // Strings, stored as the distinct values of the batch plus the index of every row's value.
+  kDictionary,
+  // Sorted integers (e.g. time_), stored as the first value plus the varint encoded difference
+  // between every row and the row before it.
+  kDelta,
+  // Integers, stored as the minimum value plus the varint encoded offset of every row from it.
+  kFrameOfReference,
+};
+
+/**
+ * An EncodedBatch is one batch of a cold column stored in a compact form. Batches are decoded
+ * back into arrow arrays every time they are read, so only the encoded form stays in memory.
+ */
+class EncodedBatch : public NotCopyable {
+ public:
+  // String batches with more distinct values than this are stored as is.
+  static constexpr size_t kMaxDictionarySize = 1 << 16;
+
+  /**
+   * Encodes the batch with the encoding for its data type.
+   * @param data_type The data type of the column the batch belongs to.
+   * @param batch The batch to encode.
+   * @return the encoded batch, or nullptr if the data type has no encoding, the batch has nulls
+   * or the encoded batch wouldn't be smaller than the original.
+   */
+  static std::unique_ptr<EncodedBatch> Encode(types::DataType data_type,
+                                              const arrow::Array& batch);
+
+  /**
+   * Decodes the batch into a new arrow array.
+   * @param mem_pool The memory pool to allocate the array in.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> Decode(arrow::MemoryPool* mem_pool) const;
+
+  ColumnEncoding encoding() const { return encoding_; }
+  int64_t length() const { return length_; }
+  // The number of bytes of the batch in its encoded form.
+  int64_t encoded_bytes() const {
+    return sizeof(base_) + dictionary_bytes_ + static_cast<int64_t>(data_.size());
+  }
+  // The number of bytes of the batch as an arrow array, as counted by the table.
+  int64_t logical_bytes() const { return logical_bytes_; }
+
+ private:
+  EncodedBatch(ColumnEncoding encoding, int64_t length, int64_t logical_bytes)
+      : encoding_(encoding), length_(length), logical_bytes_(logical_bytes) {}
+
+  static std::unique_ptr<EncodedBatch> EncodeDictionary(const arrow::StringArray& batch);
+  static std::unique_ptr<EncodedBatch> EncodeIntegers(ColumnEncoding encoding,
+                                                      const arrow::Int64Array& batch);
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeDictionary(arrow::MemoryPool* mem_pool) const;
+  StatusOr<std::shared_ptr<arrow::Array>> DecodeIntegers(arrow::MemoryPool* mem_pool) const;
+
+  ColumnEncoding encoding_;
+  int64_t length_;
+  int64_t logical_bytes_;
+
+  // kDictionary: the distinct values, in order of first appearance.
+  std::vector<std::string> dictionary_;
+  int64_t dictionary_bytes_ = 0;
+  // kDictionary: the byte width of the indices in data_ (1 or 2).
+  int index_width_ = 0;
+  // kDelta: the value of the first row. kFrameOfReference: the minimum value.
+  int64_t base_ = 0;
+  // kDictionary: the dictionary index of every row, little endian.
+  // kDelta/kFrameOfReference: the varint of every row.
+  std::string data_;
+};
+
+}  // namespace table_store
+}  // namespace px
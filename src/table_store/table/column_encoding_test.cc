@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/column_encoding.h"
+
+namespace px {
+namespace table_store {
+
+TEST(ColumnEncodingTest, dictionary_round_trip) {
+  std::vector<types::StringValue> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(i % 3 == 0 ? "GET" : (i % 3 == 1 ? "POST" : "DELETE"));
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+
+  auto encoded = EncodedBatch::Encode(types::DataType::STRING, *arr);
+  ASSERT_NE(nullptr, encoded);
+  EXPECT_EQ(ColumnEncoding::kDictionary, encoded->encoding());
+  EXPECT_EQ(100, encoded->length());
+  EXPECT_EQ(types::GetArrowArrayBytes<types::DataType::STRING>(arr.get()),
+            encoded->logical_bytes());
+  EXPECT_LT(encoded->encoded_bytes(), encoded->logical_bytes());
+
+  auto decoded = encoded->Decode(arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(ColumnEncodingTest, dictionary_high_cardinality_not_encoded) {
+  std::vector<types::StringValue> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(absl::StrCat(i));
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  EXPECT_EQ(nullptr, EncodedBatch::Encode(types::DataType::STRING, *arr));
+}
+
+TEST(ColumnEncodingTest, delta_round_trip) {
+  std::vector<types::Time64NSValue> values;
+  int64_t time = 1600000000000000000;
+  for (int i = 0; i < 100; ++i) {
+    // Times are mostly increasing, but may go back a little.
+    time += (i % 10 == 0) ? -5 : 1000;
+    values.push_back(time);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+
+  auto encoded = EncodedBatch::Encode(types::DataType::TIME64NS, *arr);
+  ASSERT_NE(nullptr, encoded);
+  EXPECT_EQ(ColumnEncoding::kDelta, encoded->encoding());
+  EXPECT_LT(encoded->encoded_bytes(), encoded->logical_bytes());
+
+  auto decoded = encoded->Decode(arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(ColumnEncodingTest, frame_of_reference_round_trip) {
+  std::vector<types::Int64Value> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(-1000 + (i * 37) % 200);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+
+  auto encoded = EncodedBatch::Encode(types::DataType::INT64, *arr);
+  ASSERT_NE(nullptr, encoded);
+  EXPECT_EQ(ColumnEncoding::kFrameOfReference, encoded->encoding());
+  EXPECT_LT(encoded->encoded_bytes(), encoded->logical_bytes());
+
+  auto decoded = encoded->Decode(arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_TRUE(decoded->Equals(arr));
+}
+
+TEST(ColumnEncodingTest, integers_full_range_not_encoded) {
+  std::vector<types::Int64Value> values = {std::numeric_limits<int64_t>::min(),
+                                           std::numeric_limits<int64_t>::max(), 0};
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  // The offsets take up more than 8 bytes each as varints.
+  EXPECT_EQ(nullptr, EncodedBatch::Encode(types::DataType::INT64, *arr));
+}
+
+TEST(ColumnEncodingTest, unsupported_types_not_encoded) {
+  std::vector<types::Float64Value> values(100, 1.5);
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  EXPECT_EQ(nullptr, EncodedBatch::Encode(types::DataType::FLOAT64, *arr));
+}
+
+}  // namespace table_store
+}  // namespace px
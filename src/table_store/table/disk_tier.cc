@@ -0,0 +1,185 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/disk_tier.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/schemapb/schema.pb.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+constexpr std::string_view kBatchExtension = ".batch";
+
+// Returns the index of the first row of the time array that is at or after the given time, or the
+// length of the array if there is no such row.
+int64_t FindRow(arrow::Array* times, int64_t time) {
+  int64_t row = types::SearchArrowArrayGreaterThanOrEqual<types::DataType::INT64>(times, time);
+  return row == -1 ? times->length() : row;
+}
+
+}  // namespace
+
+DiskTier::Batch::~Batch() {
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
+
+StatusOr<std::unique_ptr<DiskTier>> DiskTier::Create(const std::filesystem::path& dir,
+                                                     int64_t time_col_idx, int64_t max_bytes) {
+  if (time_col_idx < 0) {
+    return error::InvalidArgument("The disk tier needs a table with a time column");
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return error::Internal("Failed to create disk tier directory $0: $1", dir.string(),
+                           ec.message());
+  }
+  for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == kBatchExtension) {
+      std::filesystem::remove(entry.path(), ec);
+    }
+  }
+  return std::unique_ptr<DiskTier>(new DiskTier(dir, time_col_idx, max_bytes));
+}
+
+Status DiskTier::Spill(const schema::RowBatch& rb, int64_t min_time, int64_t max_time) {
+  // RowBatchData has no validity, so the nulls would read back as values.
+  if (rb.HasNulls()) {
+    return error::FailedPrecondition("Batches with nulls can't be written to the disk tier");
+  }
+  schemapb::RowBatchData rb_pb;
+  PL_RETURN_IF_ERROR(rb.ToProto(&rb_pb, /* arrow_buffers */ true));
+
+  auto batch = std::make_shared<Batch>();
+  batch->path = dir_ / absl::StrCat(next_file_id_++, kBatchExtension);
+  batch->num_rows = rb.num_rows();
+  batch->min_time = min_time;
+  batch->max_time = max_time;
+  {
+    std::ofstream ofs(batch->path, std::ios::binary | std::ios::trunc);
+    if (!ofs || !rb_pb.SerializeToOstream(&ofs)) {
+      return error::Internal("Failed to write disk tier file $0", batch->path.string());
+    }
+    ofs.close();
+    if (!ofs) {
+      return error::Internal("Failed to write disk tier file $0", batch->path.string());
+    }
+  }
+  batch->file_bytes = rb_pb.ByteSizeLong();
+
+  // The files of the dropped batches are removed once the scans that hold them are done, outside
+  // of the lock.
+  std::vector<std::shared_ptr<const Batch>> dropped;
+  {
+    absl::MutexLock lock(&batches_lock_);
+    bytes_ += batch->file_bytes;
+    batches_.push_back(std::move(batch));
+    while (bytes_ > max_bytes_ && !batches_.empty()) {
+      bytes_ -= batches_.front()->file_bytes;
+      dropped.push_back(std::move(batches_.front()));
+      batches_.pop_front();
+    }
+  }
+  return Status::OK();
+}
+
+std::vector<std::shared_ptr<const DiskTier::Batch>> DiskTier::BatchesInRange(
+    int64_t start_time, int64_t stop_time) const {
+  absl::MutexLock lock(&batches_lock_);
+  // The batches are in time order, so the first batch that ends at or after the start time is the
+  // first one with rows in the range.
+  auto it = std::lower_bound(
+      batches_.begin(), batches_.end(), start_time,
+      [](const std::shared_ptr<const Batch>& batch, int64_t t) { return batch->max_time < t; });
+  std::vector<std::shared_ptr<const Batch>> batches;
+  for (; it != batches_.end() && (*it)->min_time < stop_time; ++it) {
+    batches.push_back(*it);
+  }
+  return batches;
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> DiskTier::ReadBatch(const Batch& batch,
+                                                                const std::vector<int64_t>& cols,
+                                                                int64_t start_time,
+                                                                int64_t stop_time) const {
+  int fd = open(batch.path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return error::NotFound("Failed to open disk tier file $0", batch.path.string());
+  }
+  void* data = mmap(nullptr, batch.file_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return error::Internal("Failed to map disk tier file $0", batch.path.string());
+  }
+  schemapb::RowBatchData rb_pb;
+  bool parsed = rb_pb.ParseFromArray(data, batch.file_bytes);
+  munmap(data, batch.file_bytes);
+  if (!parsed) {
+    return error::Internal("Disk tier file $0 is corrupted", batch.path.string());
+  }
+  PL_ASSIGN_OR_RETURN(auto full_rb, schema::RowBatch::FromMutableProto(&rb_pb));
+
+  auto times = full_rb->ColumnAt(time_col_idx_);
+  int64_t offset = start_time > batch.min_time ? FindRow(times.get(), start_time) : 0;
+  int64_t end = stop_time <= batch.max_time ? FindRow(times.get(), stop_time) : batch.num_rows;
+  end = std::max(offset, end);
+
+  std::vector<types::DataType> types;
+  for (int64_t col_idx : cols) {
+    DCHECK_LT(col_idx, static_cast<int64_t>(full_rb->desc().size()));
+    types.push_back(full_rb->desc().type(col_idx));
+  }
+  auto rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(types), end - offset);
+  for (int64_t col_idx : cols) {
+    PL_RETURN_IF_ERROR(rb->AddColumn(full_rb->ColumnAt(col_idx)->Slice(offset, end - offset)));
+  }
+  return rb;
+}
+
+int64_t DiskTier::NumBatches() const {
+  absl::MutexLock lock(&batches_lock_);
+  return batches_.size();
+}
+
+int64_t DiskTier::NumBytes() const {
+  absl::MutexLock lock(&batches_lock_);
+  return bytes_;
+}
+
+int64_t DiskTier::MinTime() const {
+  absl::MutexLock lock(&batches_lock_);
+  return batches_.empty() ? -1 : batches_.front()->min_time;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * DiskTier keeps the batches that a table expires to stay within its size limit in files on
+ * local disk, so that queries can read further back than the table's memory allows.
+ *
+ * Each batch is written to its own file, as a schemapb::RowBatchData with raw arrow buffers (the
+ * same encoding as table checkpoints). The time range of every file is kept in memory, so that
+ * a scan only reads the files that overlap its time range. The oldest files are removed once the
+ * files of the table take up more than the disk budget of the tier.
+ *
+ * The files don't outlive the process: the directory is cleared when the tier is created, and
+ * table checkpoints are responsible for keeping data across restarts.
+ */
+class DiskTier : public NotCopyable {
+ public:
+  /**
+   * A batch stored on disk. The file is removed when the last reference to the batch goes away,
+   * so a batch that is dropped from the tier while a query scans it stays readable.
+   */
+  struct Batch : public NotCopyable {
+    ~Batch();
+
+    std::filesystem::path path;
+    int64_t file_bytes = 0;
+    int64_t num_rows = 0;
+    // The first and last timestamp of the batch.
+    int64_t min_time = 0;
+    int64_t max_time = 0;
+  };
+
+  /**
+   * Creates the tier in the given directory, removing the files a previous run left behind.
+   *
+   * @param dir the directory of the tier. Each table needs its own directory.
+   * @param time_col_idx the index of the time column of the table's batches.
+   * @param max_bytes the number of bytes the files of the tier can take up.
+   */
+  static StatusOr<std::unique_ptr<DiskTier>> Create(const std::filesystem::path& dir,
+                                                    int64_t time_col_idx, int64_t max_bytes);
+
+  /**
+   * Writes the batch to disk, then removes the oldest batches if the tier is over its budget.
+   * Batches must be spilled in time order. Fails for batches with nulls, which the files can't
+   * represent.
+   */
+  Status Spill(const schema::RowBatch& rb, int64_t min_time, int64_t max_time);
+
+  /**
+   * @return the batches with rows in [start_time, stop_time), in time order.
+   */
+  std::vector<std::shared_ptr<const Batch>> BatchesInRange(
+      int64_t start_time, int64_t stop_time = std::numeric_limits<int64_t>::max()) const;
+
+  /**
+   * Reads the given columns of the rows of the batch in [start_time, stop_time). The file is
+   * mapped into memory and the arrow arrays take ownership of the parsed buffers.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> ReadBatch(
+      const Batch& batch, const std::vector<int64_t>& cols, int64_t start_time,
+      int64_t stop_time = std::numeric_limits<int64_t>::max()) const;
+
+  int64_t NumBatches() const;
+  int64_t NumBytes() const;
+  // The first timestamp of the oldest batch, or -1 if the tier is empty.
+  int64_t MinTime() const;
+  int64_t max_bytes() const { return max_bytes_; }
+
+ private:
+  DiskTier(std::filesystem::path dir, int64_t time_col_idx, int64_t max_bytes)
+      : dir_(std::move(dir)), time_col_idx_(time_col_idx), max_bytes_(max_bytes) {}
+
+  const std::filesystem::path dir_;
+  const int64_t time_col_idx_;
+  const int64_t max_bytes_;
+  std::atomic<int64_t> next_file_id_ = 0;
+
+  mutable absl::Mutex batches_lock_;
+  std::deque<std::shared_ptr<const Batch>> batches_ ABSL_GUARDED_BY(batches_lock_);
+  int64_t bytes_ ABSL_GUARDED_BY(batches_lock_) = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
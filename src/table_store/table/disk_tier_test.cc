@@ -0,0 +1,148 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/table/disk_tier.h"
+#include "src/table_store/table/table.h"
+
+namespace px {
+namespace table_store {
+
+class DiskTierTest : public ::testing::Test {
+ protected:
+  // Each batch has 3 rows of 16 bytes, so the table only holds one batch in memory.
+  static constexpr int64_t kMaxTableSize = 48;
+
+  void SetUp() override {
+    rel_ = schema::Relation({types::DataType::TIME64NS, types::DataType::INT64}, {"time_", "col1"});
+    table_ = std::make_shared<Table>(rel_, kMaxTableSize);
+  }
+
+  void WriteBatch(const std::vector<types::Time64NSValue>& col0,
+                  const std::vector<types::Int64Value>& col1) {
+    schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), col0.size());
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col0, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+    ASSERT_OK(table_->WriteRowBatch(rb));
+  }
+
+  int64_t NumFiles() {
+    return std::distance(std::filesystem::directory_iterator(dir()),
+                         std::filesystem::directory_iterator());
+  }
+
+  std::filesystem::path dir() const { return temp_dir_.path() / "table"; }
+
+  schema::Relation rel_;
+  std::shared_ptr<Table> table_;
+  testing::TempDir temp_dir_;
+};
+
+TEST_F(DiskTierTest, expired_batches_are_spilled) {
+  ASSERT_OK(table_->EnableDiskTier(dir(), 1024 * 1024));
+  WriteBatch({1, 2, 3}, {10, 20, 30});
+  WriteBatch({4, 5, 6}, {40, 50, 60});
+  WriteBatch({7, 8, 9}, {70, 80, 90});
+
+  EXPECT_EQ(1, table_->NumBatches());
+  auto disk_tier = table_->disk_tier();
+  ASSERT_NE(nullptr, disk_tier);
+  EXPECT_EQ(2, disk_tier->NumBatches());
+  EXPECT_EQ(2, NumFiles());
+  EXPECT_EQ(2, table_->GetTableStats().disk_batches);
+  EXPECT_EQ(1, table_->GetTableStats().min_time);
+
+  // Only the second spilled batch has rows in [5, 100).
+  auto batches = disk_tier->BatchesInRange(5, 100);
+  ASSERT_EQ(1, batches.size());
+  EXPECT_EQ(4, batches[0]->min_time);
+  EXPECT_EQ(6, batches[0]->max_time);
+
+  ASSERT_OK_AND_ASSIGN(auto rb, disk_tier->ReadBatch(*batches[0], {1}, 5));
+  ASSERT_EQ(2, rb->num_rows());
+  ASSERT_EQ(1, rb->num_columns());
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(std::vector<types::Int64Value>{50, 60},
+                                                     arrow::default_memory_pool())));
+
+  batches = disk_tier->BatchesInRange(0, 5);
+  ASSERT_EQ(2, batches.size());
+  ASSERT_OK_AND_ASSIGN(rb, disk_tier->ReadBatch(*batches[1], {0, 1}, 0, 5));
+  ASSERT_EQ(1, rb->num_rows());
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(std::vector<types::Time64NSValue>{4},
+                                                     arrow::default_memory_pool())));
+}
+
+TEST_F(DiskTierTest, budget_drops_oldest_batches) {
+  ASSERT_OK_AND_ASSIGN(auto disk_tier, DiskTier::Create(dir(), /* time_col_idx */ 0, 0));
+  schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), 1);
+  ASSERT_OK(rb.AddColumn(types::ToArrow(std::vector<types::Time64NSValue>{1},
+                                        arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(
+      types::ToArrow(std::vector<types::Int64Value>{10}, arrow::default_memory_pool())));
+
+  ASSERT_OK(disk_tier->Spill(rb, 1, 1));
+  EXPECT_EQ(0, disk_tier->NumBatches());
+  EXPECT_EQ(0, disk_tier->NumBytes());
+  EXPECT_EQ(0, NumFiles());
+}
+
+TEST_F(DiskTierTest, scanned_batch_outlives_tier) {
+  ASSERT_OK(table_->EnableDiskTier(dir(), 1024 * 1024));
+  WriteBatch({1, 2, 3}, {10, 20, 30});
+  WriteBatch({4, 5, 6}, {40, 50, 60});
+  auto batches = table_->disk_tier()->BatchesInRange(0);
+  ASSERT_EQ(1, batches.size());
+
+  // The table (and its tier) go away while a scan still holds the batch.
+  table_.reset();
+  EXPECT_EQ(1, NumFiles());
+  batches.clear();
+  EXPECT_EQ(0, NumFiles());
+}
+
+TEST_F(DiskTierTest, batches_with_nulls_are_not_spilled) {
+  ASSERT_OK_AND_ASSIGN(auto disk_tier, DiskTier::Create(dir(), /* time_col_idx */ 0, 1024));
+  auto col1 = types::ColumnWrapper::Make(types::DataType::INT64, 2);
+  col1->SetNull(1);
+  schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), 2);
+  ASSERT_OK(rb.AddColumn(types::ToArrow(std::vector<types::Time64NSValue>{1, 2},
+                                        arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(col1->ConvertToArrow(arrow::default_memory_pool())));
+
+  EXPECT_NOT_OK(disk_tier->Spill(rb, 1, 2));
+  EXPECT_EQ(0, disk_tier->NumBatches());
+  EXPECT_EQ(0, NumFiles());
+}
+
+TEST_F(DiskTierTest, requires_time_column) {
+  EXPECT_NOT_OK(DiskTier::Create(dir(), /* time_col_idx */ -1, 1024));
+}
+
+}  // namespace table_store
+}  // namespace px
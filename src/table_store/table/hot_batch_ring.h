@@ -0,0 +1,122 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * HotBatchRing is a fixed capacity, single-producer/single-consumer lock-free ring buffer of
+ * batches. The producer appends at the tail and the consumer removes from the head; neither side
+ * ever waits for the other.
+ *
+ * Only the consumer may access the items, so callers that share the consumer role (e.g. queries
+ * and expiration in a Table) must serialize with each other. Because items are only ever freed
+ * by the consumer, an item stays valid for as long as the consumer holds its position.
+ *
+ * Size() may be called from any thread. It is exact on the consumer and producer sides and a
+ * lower bound on the number of items elsewhere.
+ *
+ * @tparam T The type of the items. Items are stored as unique_ptrs and never copied.
+ */
+template <typename T>
+class HotBatchRing : public NotCopyable {
+ public:
+  /**
+   * @param capacity The maximum number of items in the ring, rounded up to a power of 2.
+   */
+  explicit HotBatchRing(size_t capacity) {
+    size_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+      rounded_capacity <<= 1;
+    }
+    slots_.resize(rounded_capacity);
+    mask_ = rounded_capacity - 1;
+  }
+
+  size_t capacity() const { return slots_.size(); }
+
+  size_t Size() const {
+    // Load head first: the tail never moves behind it.
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  /**
+   * Producer only. The consumer can only make room, so a ring that isn't full stays that way
+   * until the next push.
+   */
+  bool Full() const { return Size() == capacity(); }
+
+  /**
+   * Producer only. Appends an item to the tail of the ring, which must not be full.
+   */
+  void Push(std::unique_ptr<T> item) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    DCHECK_LT(tail - head_.load(std::memory_order_acquire), capacity());
+    slots_[tail & mask_] = std::move(item);
+    // Publishes the slot to the consumer.
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  /**
+   * Consumer only.
+   * @param idx The position of the item from the head, must be less than Size().
+   * @return The item at the given position.
+   */
+  T* At(size_t idx) const {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    DCHECK_LT(idx, tail_.load(std::memory_order_acquire) - head);
+    return slots_[(head + idx) & mask_].get();
+  }
+
+  /**
+   * Consumer only. Removes the item at the head of the ring, which must not be empty.
+   */
+  std::unique_ptr<T> PopFront() {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    DCHECK_LT(head, tail_.load(std::memory_order_acquire));
+    std::unique_ptr<T> item = std::move(slots_[head & mask_]);
+    // Hands the slot back to the producer.
+    head_.store(head + 1, std::memory_order_release);
+    return item;
+  }
+
+ private:
+  std::vector<std::unique_ptr<T>> slots_;
+  uint64_t mask_ = 0;
+  // Positions only ever increase; the slot of a position is position & mask_. They are kept on
+  // separate cache lines so that the producer and the consumer don't contend on them.
+  alignas(64) std::atomic<uint64_t> head_ = 0;
+  alignas(64) std::atomic<uint64_t> tail_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -19,13 +19,16 @@
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <absl/strings/str_format.h>
 #include "src/common/base/base.h"
+#include "src/common/base/worker_pool.h"
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/huge_page_memory_pool.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/table/table.h"
@@ -33,18 +36,38 @@
 DEFINE_int32(table_store_table_size_limit, 128 * 1024 * 1024,
              "The maximal size a table allows. When the size grows beyond this limit, "
              "old data will be discarded. Set to '-1' to remove this limit.");
+DEFINE_bool(table_store_encode_cold_batches, false,
+            "Whether to encode batches when they become cold. Low cardinality strings are "
+            "dictionary encoded, and integers are delta or frame-of-reference encoded. Encoded "
+            "batches are decoded every time they are read, trading CPU for retention.");
+DEFINE_int32(table_store_hot_batch_ring_capacity, 1024,
+             "The number of batches a table can hold before they are converted to arrow. When "
+             "the ring is full, ingestion converts the hot batches instead of waiting for a "
+             "query.");
 
 namespace px {
 namespace table_store {
 
+namespace {
+// Ingestion into a full table expires 1/64th of it at a time, once the table is at least 1MiB.
+constexpr int64_t kExpiryHeadroomDivisor = 64;
+constexpr int64_t kMinTableSizeForExpiryHeadroom = 1024 * 1024;
+}  // namespace
+
 Table::Table(const schema::Relation& relation, int64_t max_table_size)
-    : desc_(relation.col_types()), max_table_size_(max_table_size) {
+    : desc_(relation.col_types()),
+      hot_batches_(FLAGS_table_store_hot_batch_ring_capacity),
+      max_table_size_(max_table_size) {
   uint64_t num_cols = desc_.size();
   columns_.reserve(num_cols);
   for (uint64_t i = 0; i < num_cols; ++i) {
     PL_CHECK_OK(
         AddColumn(std::make_shared<Column>(relation.GetColumnType(i), relation.GetColumnName(i))));
   }
+  time_col_idx_ = FindTimeColumn();
+  if (time_col_idx_ != -1 && desc_.type(time_col_idx_) != types::DataType::TIME64NS) {
+    time_col_idx_ = -1;
+  }
 }
 
 Status Column::AddBatch(const std::shared_ptr<arrow::Array>& batch) {
@@ -54,10 +77,33 @@ Status Column::AddBatch(const std::shared_ptr<arrow::Array>& batch) {
                                   batch->type_id(), data_type_);
   }
 
-  batches_.emplace_back(batch);
+  batches_.push_back({batch, nullptr, ComputeZoneMap(data_type_, *batch)});
   return Status::OK();
 }
 
+void Column::AddEncodedBatch(std::unique_ptr<EncodedBatch> batch, const ZoneMap& zone_map) {
+  batches_.push_back({nullptr, std::move(batch), zone_map});
+}
+
+int64_t Column::BatchBytes(size_t i) const {
+  if (batches_[i].encoded != nullptr) {
+    return batches_[i].encoded->encoded_bytes();
+  }
+  return BatchLogicalBytes(i);
+}
+
+int64_t Column::BatchLogicalBytes(size_t i) const {
+  const auto& batch = batches_[i];
+  if (batch.encoded != nullptr) {
+    return batch.encoded->logical_bytes();
+  }
+  int64_t bytes = 0;
+#define TYPE_CASE(_dt_) bytes = types::GetArrowArrayBytes<_dt_>(batch.array.get());
+  PL_SWITCH_FOREACH_DATATYPE(data_type_, TYPE_CASE);
+#undef TYPE_CASE
+  return bytes;
+}
+
 Status Column::DeleteNextBatch() {
   if (batches_.empty()) {
     return error::InvalidArgument("No batch to delete.");
@@ -86,10 +132,10 @@ Status Table::AddColumn(std::shared_ptr<Column> col) {
     }
     // Check size of batches.
     for (int64_t batch_idx = 0; batch_idx < columns_[0]->numBatches(); batch_idx++) {
-      if (columns_[0]->batch(batch_idx)->length() != col->batch(batch_idx)->length()) {
+      if (columns_[0]->BatchLength(batch_idx) != col->BatchLength(batch_idx)) {
         return error::InvalidArgument("Column has batch of size $0, but should have size $1.",
-                                      col->batch(batch_idx)->length(),
-                                      columns_[0]->batch(batch_idx)->length());
+                                      col->BatchLength(batch_idx),
+                                      columns_[0]->BatchLength(batch_idx));
       }
     }
   }
@@ -141,75 +187,154 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(int64_t row_
     rb_types.push_back(desc_.type(col_idx));
   }
 
-  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
-
-  auto num_cold_batches = !columns_.empty() ? columns_[0]->numBatches() : 0;
-  // If i > num_cold_batches, hot_idx is the index of the batch that we want from the hot columns.
-  auto hot_idx = row_batch_idx - num_cold_batches;
-
-  {
-    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-
+  auto num_cold_batches = [this]() {
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    return !columns_.empty() ? columns_[0]->numBatches() : 0;
+  };
+  // Reads of cold batches don't take the consumer lock, so they never wait on a conversion.
+  if (row_batch_idx >= num_cold_batches()) {
+    // Keeps the batch indices from shifting while the hot batches are converted. Another reader
+    // may have converted some of them before the lock was taken, so the count is read again.
+    absl::MutexLock consumer_lock(&hot_batches_consumer_lock_);
+    // hot_idx is the index of the batch that we want from the hot columns.
+    auto hot_idx = row_batch_idx - num_cold_batches();
     if (hot_idx >= 0) {
-      DCHECK(hot_batches_.size() > static_cast<size_t>(hot_idx));
+      DCHECK(hot_batches_.Size() > static_cast<size_t>(hot_idx));
       // Move hot column batches 0 to hot_idx into cold storage.
-      // TODO(michellenguyen, PL-388): We're currently converting hot data to row batches on a 1:1
-      // basis. This should be updated so that multiple hot column batches are merged into a single
-      // row batch.
-      auto batch_idx = 0;
-      while (batch_idx <= hot_idx) {
-        for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
-          DCHECK(hot_batches_[batch_idx]->size() > col_idx);
-          auto hot_batch_sptr = hot_batches_[batch_idx]->at(col_idx)->ConvertToArrow(mem_pool);
-          PL_RETURN_IF_ERROR(columns_.at(col_idx)->AddBatch(hot_batch_sptr));
-        }
-        batch_idx++;
-      }
-      // Remove hot column batches 0 to hot_idx from hot columns.
-      hot_batches_.erase(hot_batches_.begin(), hot_batches_.begin() + hot_idx + 1);
+      // Encoding would change the table's size, which a const read can't account for, so reads
+      // leave the encoding to the write paths.
+      PL_RETURN_IF_ERROR(MoveHotBatchesToCold(hot_idx + 1, mem_pool, /*encode*/ false).status());
     }
   }
 
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
   DCHECK_GT(columns_.size(), static_cast<size_t>(0));
   DCHECK(columns_[0]->numBatches() > row_batch_idx);
   auto batch_size =
-      (end == -1) ? (columns_[0]->batch(row_batch_idx)->length() - offset) : (end - offset);
+      (end == -1) ? (columns_[0]->BatchLength(row_batch_idx) - offset) : (end - offset);
   auto output_rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(rb_types), batch_size);
   for (auto col_idx : cols) {
-    auto arrow_array_sptr = columns_[col_idx]->batch(row_batch_idx);
+    // Encoded batches are decoded here, so only the columns that are read get decoded.
+    PL_ASSIGN_OR_RETURN(auto arrow_array_sptr,
+                        columns_[col_idx]->ReadBatch(row_batch_idx, mem_pool));
     PL_RETURN_IF_ERROR(output_rb->AddColumn(arrow_array_sptr->Slice(offset, batch_size)));
   }
 
   return output_rb;
 }
 
-Status Table::DeleteNextRowBatch() {
-  // First delete row batches from cold columns.
-  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+StatusOr<int64_t> Table::MoveHotBatchesToCold(int64_t num_batches, arrow::MemoryPool* mem_pool,
+                                               bool encode) const {
+  // TODO(michellenguyen, PL-388): We're currently converting hot data to row batches on a 1:1
+  // basis. This should be updated so that multiple hot column batches are merged into a single
+  // row batch.
+  // Below this many values (rows times columns), converting the columns on the worker pool costs
+  // more than converting them on the calling thread.
+  constexpr size_t kMinValuesForParallelConversion = 64 * 1024;
+
+  struct ConvertedColumn {
+    std::shared_ptr<arrow::Array> array;
+    std::unique_ptr<EncodedBatch> encoded;
+    ZoneMap zone_map;
+  };
+  std::vector<ConvertedColumn> converted(columns_.size());
+  int64_t bytes_saved = 0;
+  for (int64_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+    // Holding the consumer lock keeps the batch in the ring, so it is converted without
+    // cold_batches_lock_, and readers and writers of the table don't wait for the conversion.
+    const HotBatch* hot_batch = hot_batches_.At(0);
+    DCHECK(hot_batch->record_batch->size() >= columns_.size());
+
+    // Conversion and encoding only touch the column being converted, so they can run in parallel.
+    // The columns themselves are appended to serially below.
+    auto convert_column = [&](size_t col_idx) {
+      const auto& col = columns_[col_idx];
+      ConvertedColumn& out = converted[col_idx];
+      out.array = hot_batch->record_batch->at(col_idx)->ConvertToArrow(mem_pool);
+      out.encoded = nullptr;
+      if (encode) {
+        out.encoded = EncodedBatch::Encode(col->data_type(), *out.array);
+      }
+      if (out.encoded != nullptr) {
+        out.zone_map = ComputeZoneMap(col->data_type(), *out.array);
+      }
+    };
+    size_t num_rows = columns_.empty() ? 0 : hot_batch->record_batch->at(0)->Size();
+    if (num_rows * columns_.size() < kMinValuesForParallelConversion) {
+      for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
+        convert_column(col_idx);
+      }
+    } else {
+      WorkerPool::Default()->ParallelFor(columns_.size(), convert_column);
+    }
+
+    // The batch leaves the ring and joins the cold batches at once, so the batch indices stay
+    // the same for the readers. It is freed after the lock is released.
+    std::unique_ptr<HotBatch> moved_batch;
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    SyncColdTimeIndex();
+    moved_batch = hot_batches_.PopFront();
+    for (size_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
+      const auto& col = columns_[col_idx];
+      ConvertedColumn& c = converted[col_idx];
+      if (c.encoded == nullptr) {
+        PL_RETURN_IF_ERROR(col->AddBatch(c.array));
+        continue;
+      }
+      bytes_saved += c.encoded->logical_bytes() - c.encoded->encoded_bytes();
+      col->AddEncodedBatch(std::move(c.encoded), c.zone_map);
+    }
+    if (time_col_idx_ != -1) {
+      cold_time_index_.push_back(moved_batch->time_range);
+    }
+  }
+  return bytes_saved;
+}
+
+Status Table::MoveHotBatchesToColdAndEncode(int64_t num_batches, arrow::MemoryPool* mem_pool) {
+  PL_ASSIGN_OR_RETURN(int64_t bytes_saved,
+                      MoveHotBatchesToCold(num_batches, mem_pool,
+                                           FLAGS_table_store_encode_cold_batches));
+  bytes_ -= bytes_saved;
+  bytes_saved_by_encoding_ += bytes_saved;
+  return Status::OK();
+}
 
+Status Table::DeleteNextRowBatchUnlocked(std::vector<SpilledBatch>* spilled) {
+  // First delete row batches from cold columns.
   if (!columns_.empty() && columns_[0]->numBatches() > 0) {
-    auto rb_size = 0;
+    SyncColdTimeIndex();
+    if (spilled != nullptr && time_col_idx_ != -1) {
+      std::vector<std::shared_ptr<arrow::Array>> arrays;
+      for (auto col : columns_) {
+        PL_ASSIGN_OR_RETURN(auto array, col->ReadBatch(0, arrow::default_memory_pool()));
+        arrays.push_back(std::move(array));
+      }
+      auto rb = std::make_unique<schema::RowBatch>(desc_, arrays[0]->length());
+      for (const auto& array : arrays) {
+        PL_RETURN_IF_ERROR(rb->AddColumn(array));
+      }
+      spilled->push_back({std::move(rb), cold_time_index_.front()});
+    }
+    if (time_col_idx_ != -1) {
+      cold_time_index_.pop_front();
+    }
+    int64_t rb_size = 0;
+    int64_t rb_bytes_saved = 0;
     for (auto col : columns_) {
-      auto batch = col->batch(0);
-#define TYPE_CASE(_dt_) rb_size += types::GetArrowArrayBytes<_dt_>(batch.get());
-      PL_SWITCH_FOREACH_DATATYPE(col->data_type(), TYPE_CASE);
-#undef TYPE_CASE
+      int64_t col_bytes = col->BatchBytes(0);
+      rb_size += col_bytes;
+      rb_bytes_saved += col->BatchLogicalBytes(0) - col_bytes;
       PL_RETURN_IF_ERROR(col->DeleteNextBatch());
     }
     bytes_ -= rb_size;
+    bytes_saved_by_encoding_ -= rb_bytes_saved;
     ++batches_expired_;
-    // Delete row batches from hot columns if cold columns are empty.
-  } else if (!hot_batches_.empty()) {
-    absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-    auto batch = std::move(hot_batches_.front());
-
-    auto rb_size = 0;
-    for (const auto& col : *batch) {
-      rb_size += col->Bytes();
-    }
-
-    hot_batches_.pop_front();
-    bytes_ -= rb_size;
+    // Delete row batches from hot columns if cold columns are empty. These are rare enough that
+    // they aren't converted to arrow just to be written to the disk tier.
+  } else if (!hot_batches_.Empty()) {
+    std::unique_ptr<HotBatch> batch = hot_batches_.PopFront();
+    bytes_ -= batch->bytes;
     ++batches_expired_;
   } else {
     return error::InvalidArgument("No row batches to delete.");
@@ -217,16 +342,83 @@ Status Table::DeleteNextRowBatch() {
   return Status::OK();
 }
 
-Status Table::ExpireRowBatches(int64_t row_batch_size) {
-  if (max_table_size_ != -1) {
-    if (row_batch_size > max_table_size_) {
-      return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
-                                    row_batch_size, max_table_size_);
+int64_t Table::ExpiryHeadroom() const {
+  int64_t max_table_size = max_table_size_;
+  if (max_table_size < kMinTableSizeForExpiryHeadroom) {
+    return 0;
+  }
+  return max_table_size / kExpiryHeadroomDivisor;
+}
+
+Status Table::ExpireRowBatches(int64_t row_batch_size, int64_t headroom) {
+  int64_t max_table_size = max_table_size_;
+  if (max_table_size == -1) {
+    return Status::OK();
+  }
+  if (row_batch_size > max_table_size) {
+    return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
+                                  row_batch_size, max_table_size);
+  }
+  if (bytes_ + row_batch_size <= max_table_size) {
+    return Status::OK();
+  }
+
+  std::vector<SpilledBatch> spilled;
+  {
+    absl::MutexLock consumer_lock(&hot_batches_consumer_lock_);
+    absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+    // The headroom is best effort: the table may not hold that much more than the new batch.
+    while (bytes_ + row_batch_size > max_table_size - headroom && NumBatchesUnlocked() > 0) {
+      PL_RETURN_IF_ERROR(DeleteNextRowBatchUnlocked(disk_tier_ != nullptr ? &spilled : nullptr));
     }
-    while (bytes_ + row_batch_size > max_table_size_) {
-      DCHECK_NE(NumBatches(), 0);
-      PL_RETURN_IF_ERROR(DeleteNextRowBatch());
+  }
+
+  // The batches are written outside of the lock, so that queries and ingestion don't wait on disk.
+  // The disk tier can't keep nulls, so the batches with nulls are dropped as if it weren't there.
+  for (const auto& batch : spilled) {
+    if (batch.rb->HasNulls()) {
+      continue;
+    }
+    Status s =
+        disk_tier_->Spill(*batch.rb, batch.time_range.min_time, batch.time_range.max_time);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+        "Dropping an expired batch that couldn't be written to the disk tier: $0", s.msg());
+  }
+  return Status::OK();
+}
+
+Status Table::EnableDiskTier(const std::filesystem::path& dir, int64_t max_bytes) {
+  PL_ASSIGN_OR_RETURN(disk_tier_, DiskTier::Create(dir, time_col_idx_, max_bytes));
+  return Status::OK();
+}
+
+Status Table::SetMaxTableSize(int64_t max_table_size) {
+  max_table_size_ = max_table_size;
+  return ExpireRowBatches(0);
+}
+
+Status Table::ExpireRowBatchesOlderThan(int64_t now_ns) {
+  int64_t max_age_ns = max_age_ns_;
+  if (time_col_idx_ == -1 || max_age_ns < 0) {
+    return Status::OK();
+  }
+  int64_t min_time = now_ns - max_age_ns;
+
+  absl::MutexLock consumer_lock(&hot_batches_consumer_lock_);
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+  SyncColdTimeIndex();
+  while (true) {
+    const BatchTimeRange* oldest = nullptr;
+    if (!cold_time_index_.empty()) {
+      oldest = &cold_time_index_.front();
+    } else if (!hot_batches_.Empty()) {
+      oldest = &hot_batches_.At(0)->time_range;
+    }
+    // Batches are sorted by time, so the first batch with a recent enough row ends the scan.
+    if (oldest == nullptr || oldest->max_time >= min_time) {
+      break;
     }
+    PL_RETURN_IF_ERROR(DeleteNextRowBatchUnlocked());
   }
   return Status::OK();
 }
@@ -250,18 +442,29 @@ Status Table::WriteRowBatch(schema::RowBatch rb) {
   {
     absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
 
+    SyncColdTimeIndex();
     for (int64_t i = 0; i < rb.num_columns(); i++) {
       auto s = columns_[i]->AddBatch(rb.ColumnAt(i));
       PL_RETURN_IF_ERROR(s);
     }
+    if (time_col_idx_ != -1) {
+      cold_time_index_.push_back(TimeRangeOf(
+          rb.ColumnAt(time_col_idx_).get(),
+          cold_time_index_.empty() ? nullptr : &cold_time_index_.back()));
+    }
   }
   bytes_ += rb_bytes;
+  bytes_added_ += rb_bytes;
   ++batches_added_;
   return Status::OK();
 }
 
 Status Table::TransferRecordBatch(
     std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch) {
+  // Hot batches are pushed without a lock, which is only safe with a single producer.
+  DCHECK(!producing_.exchange(true)) << "TransferRecordBatch called concurrently.";
+  DEFER(producing_ = false;);
+
   // Don't transfer over empty row batches.
   if (record_batch->empty() || record_batch->at(0)->Size() == 0) {
     return Status::OK();
@@ -286,19 +489,46 @@ Status Table::TransferRecordBatch(
     ++i;
   }
 
-  PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
+  PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes, ExpiryHeadroom()));
 
-  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
-  hot_batches_.push_back(std::move(record_batch));
+  auto hot_batch = std::make_unique<HotBatch>();
+  if (time_col_idx_ != -1) {
+    // Hot batches are never empty, so they don't need the previous time range.
+    hot_batch->time_range = TimeRangeOf(*record_batch->at(time_col_idx_), nullptr);
+  }
+  hot_batch->record_batch = std::move(record_batch);
+  hot_batch->bytes = rb_bytes;
+
+  if (hot_batches_.Full()) {
+    // Slow path: no query has read the table in a while, so make room by converting the hot
+    // batches ourselves.
+    absl::MutexLock consumer_lock(&hot_batches_consumer_lock_);
+    PL_RETURN_IF_ERROR(MoveHotBatchesToColdAndEncode(hot_batches_.Size(), types::DataMemoryPool()));
+  }
+  hot_batches_.Push(std::move(hot_batch));
   bytes_ += rb_bytes;
+  bytes_added_ += rb_bytes;
   ++batches_added_;
 
   return Status::OK();
 }
 
+Status Table::CompactHotBatches(arrow::MemoryPool* mem_pool) {
+  // Only the batches that are there now, so that this finishes while data keeps coming in.
+  size_t num_batches = hot_batches_.Size();
+  for (size_t i = 0; i < num_batches; ++i) {
+    absl::MutexLock consumer_lock(&hot_batches_consumer_lock_);
+    // Queries and expiration may have taken the batches in the meantime.
+    if (hot_batches_.Empty()) {
+      break;
+    }
+    PL_RETURN_IF_ERROR(MoveHotBatchesToColdAndEncode(1, mem_pool));
+  }
+  return Status::OK();
+}
+
 int64_t Table::NumBatches() const {
   absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
-  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
 
   return NumBatchesUnlocked();
 }
@@ -309,7 +539,7 @@ int64_t Table::NumBatchesUnlocked() const {
     num_batches += columns_[0]->numBatches();
   }
 
-  num_batches += hot_batches_.size();
+  num_batches += hot_batches_.Size();
 
   return num_batches;
 }
@@ -325,73 +555,122 @@ int64_t Table::FindTimeColumn() {
   return time_col_idx;
 }
 
-std::shared_ptr<arrow::Array> Table::GetColumnBatch(int64_t col, int64_t batch,
-                                                    arrow::MemoryPool* mem_pool) {
-  DCHECK(static_cast<int64_t>(NumBatchesUnlocked()) > batch);
-  DCHECK(static_cast<int64_t>(columns_.size()) > col);
+Table::BatchTimeRange Table::TimeRangeOf(const arrow::Array* time_batch,
+                                         const BatchTimeRange* prev) const {
+  if (time_batch->length() == 0) {
+    // Keep the index sorted: an empty batch ends where the previous one did.
+    int64_t time = prev == nullptr ? std::numeric_limits<int64_t>::min() : prev->max_time;
+    return {time, time};
+  }
+  return {types::GetValueFromArrowArray<types::DataType::INT64>(time_batch, 0),
+          types::GetValueFromArrowArray<types::DataType::INT64>(time_batch,
+                                                                 time_batch->length() - 1)};
+}
 
-  if (batch >= columns_[col]->numBatches()) {
-    auto hot_col_idx = batch - columns_[col]->numBatches();
-    return hot_batches_.at(hot_col_idx)->at(col)->ConvertToArrow(mem_pool);
+Table::BatchTimeRange Table::TimeRangeOf(const types::ColumnWrapper& time_batch,
+                                         const BatchTimeRange* prev) const {
+  if (time_batch.Empty()) {
+    int64_t time = prev == nullptr ? std::numeric_limits<int64_t>::min() : prev->max_time;
+    return {time, time};
   }
-  return columns_[col]->batch(batch);
+  return {time_batch.Get<types::Time64NSValue>(0).val,
+          time_batch.Get<types::Time64NSValue>(time_batch.Size() - 1).val};
 }
 
-int64_t Table::FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
-                                           arrow::MemoryPool* mem_pool) {
-  DCHECK(columns_[time_col_idx]->data_type() == types::DataType::TIME64NS);
+void Table::SyncColdTimeIndex() const {
+  if (time_col_idx_ == -1) {
+    return;
+  }
+  const auto& time_col = columns_[time_col_idx_];
+  for (int64_t batch_idx = cold_time_index_.size(); batch_idx < time_col->numBatches();
+       ++batch_idx) {
+    cold_time_index_.push_back(
+        TimeRangeOf(time_col->batch(batch_idx).get(),
+                    cold_time_index_.empty() ? nullptr : &cold_time_index_.back()));
+  }
+}
 
-  return FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool, 0, NumBatchesUnlocked() - 1);
+int64_t Table::FindBatchGreaterThanOrEqual(int64_t time) {
+  // The max times are non-decreasing, so the first batch that ends at or after the given time
+  // holds the first row with a timestamp greater than or equal to it.
+  auto ends_before = [](const BatchTimeRange& range, int64_t t) { return range.max_time < t; };
+  auto cold_it =
+      std::lower_bound(cold_time_index_.begin(), cold_time_index_.end(), time, ends_before);
+  if (cold_it != cold_time_index_.end()) {
+    return std::distance(cold_time_index_.begin(), cold_it);
+  }
+  // The ring has no iterators, so binary search the hot batches by position.
+  int64_t lo = 0;
+  int64_t hi = hot_batches_.Size();
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (ends_before(hot_batches_.At(mid)->time_range, time)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < static_cast<int64_t>(hot_batches_.Size())) {
+    return cold_time_index_.size() + lo;
+  }
+  return -1;
 }
 
-BatchPosition Table::FindBatchPositionGreaterThanOrEqual(int64_t time,
-                                                         arrow::MemoryPool* mem_pool) {
+int64_t Table::FindRowGreaterThanOrEqual(int64_t batch_idx, int64_t time) {
+  int64_t num_cold_batches = cold_time_index_.size();
+  if (batch_idx < num_cold_batches) {
+    if (time <= cold_time_index_[batch_idx].min_time) {
+      return 0;
+    }
+    auto batch = columns_[time_col_idx_]->batch(batch_idx);
+    return types::SearchArrowArrayGreaterThanOrEqual<types::DataType::INT64>(batch.get(), time);
+  }
+
+  int64_t hot_idx = batch_idx - num_cold_batches;
+  const HotBatch* hot_batch = hot_batches_.At(hot_idx);
+  if (time <= hot_batch->time_range.min_time) {
+    return 0;
+  }
+  // Search the hot column directly rather than converting it to arrow.
+  const auto& time_col = hot_batch->record_batch->at(time_col_idx_);
+  const auto* times = static_cast<const types::Time64NSValue*>(time_col->UnsafeRawData());
+  auto it = std::lower_bound(times, times + time_col->Size(), time,
+                             [](const types::Time64NSValue& val, int64_t t) {
+                               return val.val < t;
+                             });
+  return std::distance(times, it);
+}
+
+BatchPosition Table::FindBatchPositionGreaterThanOrEqual(int64_t time) {
   absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
-  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
 
   BatchPosition batch_pos = {-1, -1};
 
-  int64_t time_col_idx = FindTimeColumn();
-  DCHECK_NE(time_col_idx, -1);
+  DCHECK_NE(time_col_idx_, -1);
+  SyncColdTimeIndex();
 
-  batch_pos.batch_idx = FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool);
+  batch_pos.batch_idx = FindBatchGreaterThanOrEqual(time);
 
   if (batch_pos.FoundValidBatches()) {
     // If batch in range exists, find the specific row in the batch.
-    std::shared_ptr<arrow::Array> batch =
-        GetColumnBatch(time_col_idx, batch_pos.batch_idx, mem_pool);
-    batch_pos.row_idx =
-        types::SearchArrowArrayGreaterThanOrEqual<types::DataType::INT64>(batch.get(), time);
+    batch_pos.row_idx = FindRowGreaterThanOrEqual(batch_pos.batch_idx, time);
   }
   return batch_pos;
 }
 
-int64_t Table::FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
-                                           arrow::MemoryPool* mem_pool, int64_t start,
-                                           int64_t end) {
-  if (start > end) {
-    return -1;
-  }
-
-  int64_t mid = (start + end) / 2;
-  auto batch = GetColumnBatch(time_col_idx, mid, mem_pool);
-  auto start_val = types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), 0);
-  auto stop_val =
-      types::GetValueFromArrowArray<types::DataType::INT64>(batch.get(), batch->length() - 1);
-  if (time > start_val && time <= stop_val) {
-    return mid;
-  }
-  if (time > stop_val) {
-    return FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool, mid + 1, end);
+bool Table::BatchMayMatch(int64_t row_batch_idx,
+                          const std::vector<ZoneMapPredicate>& predicates) const {
+  absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
+  if (columns_.empty() || row_batch_idx >= columns_[0]->numBatches()) {
+    return true;
   }
-  if (time <= start_val) {
-    auto res = FindBatchGreaterThanOrEqual(time_col_idx, time, mem_pool, start, mid - 1);
-    if (res == -1) {
-      return mid;
+  for (const auto& predicate : predicates) {
+    DCHECK_LT(predicate.column_idx, NumColumns());
+    if (!predicate.MayMatch(columns_[predicate.column_idx]->zone_map(row_batch_idx))) {
+      return false;
     }
-    return res;
   }
-  return -1;
+  return true;
 }
 
 schema::Relation Table::GetRelation() const {
@@ -411,13 +690,38 @@ schema::Relation Table::GetRelation() const {
 TableStats Table::GetTableStats() const {
   TableStats info;
   absl::base_internal::SpinLockHolder cold_lock(&cold_batches_lock_);
-  absl::base_internal::SpinLockHolder lock(&hot_batches_lock_);
 
   info.batches_added = batches_added_;
   info.batches_expired = batches_expired_;
+  info.batches_dropped = batches_dropped_;
   info.num_batches = NumBatchesUnlocked();
   info.bytes = bytes_;
+  info.logical_bytes = bytes_ + bytes_saved_by_encoding_;
   info.max_table_size = max_table_size_;
+  if (disk_tier_ != nullptr) {
+    info.disk_batches = disk_tier_->NumBatches();
+    info.disk_bytes = disk_tier_->NumBytes();
+  }
+
+  if (time_col_idx_ != -1) {
+    SyncColdTimeIndex();
+    size_t num_hot_batches = hot_batches_.Size();
+    if (!cold_time_index_.empty()) {
+      info.min_time = cold_time_index_.front().min_time;
+    } else if (num_hot_batches > 0) {
+      info.min_time = hot_batches_.At(0)->time_range.min_time;
+    }
+    if (num_hot_batches > 0) {
+      info.max_time = hot_batches_.At(num_hot_batches - 1)->time_range.max_time;
+    } else if (!cold_time_index_.empty()) {
+      info.max_time = cold_time_index_.back().max_time;
+    }
+    // The spilled batches are older than the ones in memory.
+    int64_t disk_min_time = disk_tier_ != nullptr ? disk_tier_->MinTime() : -1;
+    if (disk_min_time != -1) {
+      info.min_time = disk_min_time;
+    }
+  }
 
   return info;
 }
@@ -20,7 +20,10 @@
 
 #include <arrow/array.h>
 #include <arrow/record_batch.h>
+#include <atomic>
+#include <chrono>
 #include <deque>
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -29,6 +32,7 @@
 
 #include <absl/base/internal/spinlock.h>
 #include <absl/strings/str_format.h>
+#include <absl/synchronization/mutex.h>
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/types.h"
@@ -36,8 +40,14 @@
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/schema/row_descriptor.h"
 #include "src/table_store/schemapb/schema.pb.h"
+#include "src/table_store/table/column_encoding.h"
+#include "src/table_store/table/disk_tier.h"
+#include "src/table_store/table/hot_batch_ring.h"
+#include "src/table_store/table/zone_map.h"
 
 DECLARE_int32(table_store_table_size_limit);
+DECLARE_int32(table_store_hot_batch_ring_capacity);
+DECLARE_bool(table_store_encode_cold_batches);
 
 namespace px {
 namespace table_store {
@@ -51,11 +61,23 @@ struct BatchPosition {
 };
 
 struct TableStats {
+  // The number of bytes the table takes up, which is what is counted against max_table_size.
   int64_t bytes;
+  // The number of bytes the table would take up if none of its cold batches were encoded.
+  int64_t logical_bytes;
   int64_t num_batches;
   int64_t batches_added;
   int64_t batches_expired;
+  // The batches that were dropped before reaching the table, e.g. by a full ingest queue.
+  int64_t batches_dropped = 0;
   int64_t max_table_size;
+  // The time_ of the oldest and newest rows, or -1 if the table has no time column or no rows.
+  // The oldest row includes the rows in the disk tier, which queries also read.
+  int64_t min_time = -1;
+  int64_t max_time = -1;
+  // The batches and bytes in the disk tier of the table, if it has one.
+  int64_t disk_batches = 0;
+  int64_t disk_bytes = 0;
 };
 
 /**
@@ -88,6 +110,14 @@ class Column {
    */
   Status AddBatch(const std::shared_ptr<arrow::Array>& batch);
 
+  /**
+   * Add a new batch to the column in its encoded form. It's decoded every time it is read.
+   *
+   * @ param batch the encoded batch to add to the column.
+   * @ param zone_map the zone map of the batch, computed before it was encoded.
+   */
+  void AddEncodedBatch(std::unique_ptr<EncodedBatch> batch, const ZoneMap& zone_map);
+
   /**
    * Delete the next batch in the column.
    * @return a status of whether deletion was successful.
@@ -96,20 +126,61 @@ class Column {
 
   /**
    * @ param i the index to get the batch from.
+   * @ param mem_pool the arrow memory pool to decode the batch in, if it is encoded.
    */
-  std::shared_ptr<arrow::Array> batch(size_t i) {
+  StatusOr<std::shared_ptr<arrow::Array>> ReadBatch(size_t i, arrow::MemoryPool* mem_pool) {
     DCHECK(i < batches_.size()) << absl::StrFormat(
         "batches_[%d] does not exist, batches_ is size %d", i, batches_.size());
-    return batches_[i];
+    if (batches_[i].encoded != nullptr) {
+      return batches_[i].encoded->Decode(mem_pool);
+    }
+    return batches_[i].array;
+  }
+
+  /**
+   * @ param i the index to get the batch from.
+   */
+  std::shared_ptr<arrow::Array> batch(size_t i) {
+    return ReadBatch(i, arrow::default_memory_pool()).ConsumeValueOrDie();
+  }
+
+  /**
+   * @ return the number of rows in the batch at the given index, without decoding it.
+   */
+  int64_t BatchLength(size_t i) const {
+    const auto& batch = batches_[i];
+    return batch.encoded != nullptr ? batch.encoded->length() : batch.array->length();
   }
 
+  /**
+   * @ return the zone map of the batch at the given index.
+   */
+  const ZoneMap& zone_map(size_t i) const { return batches_[i].zone_map; }
+
+  /**
+   * @ return the number of bytes stored for the batch at the given index.
+   */
+  int64_t BatchBytes(size_t i) const;
+
+  /**
+   * @ return the number of bytes of the batch at the given index as an arrow array.
+   */
+  int64_t BatchLogicalBytes(size_t i) const;
+
   std::string name() { return name_; }
 
  private:
+  // Exactly one of array and encoded is set.
+  struct ColdBatch {
+    std::shared_ptr<arrow::Array> array;
+    std::unique_ptr<EncodedBatch> encoded;
+    ZoneMap zone_map;
+  };
+
   std::string name_;
   types::DataType data_type_;
 
-  std::deque<std::shared_ptr<arrow::Array>> batches_;
+  std::deque<ColdBatch> batches_;
 };
 
 /**
@@ -167,13 +238,62 @@ class Table : public NotCopyable {
   Status WriteRowBatch(schema::RowBatch rb);
 
   /**
-   * Transfers the given record batch (from Stirling) into the Table.
+   * Transfers the given record batch (from Stirling) into the Table. Must not be called
+   * concurrently with itself: the table's hot batches have a single producer.
    *
    * @param record_batch the record batch to be appended to the Table.
    * @return status
    */
   Status TransferRecordBatch(std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch);
 
+  /**
+   * Converts the current hot batches to cold arrow batches, so that queries don't have to. The
+   * batches are converted one at a time, to keep queries and expiration from waiting on the lock.
+   * Batch indices don't change, so this is safe to run while queries read the table.
+   *
+   * @param mem_pool the arrow memory pool to convert the batches in.
+   * @return status
+   */
+  Status CompactHotBatches(arrow::MemoryPool* mem_pool);
+
+  /**
+   * Changes the maximum number of bytes that the table can hold, and expires the oldest batches
+   * if the table is now over the limit.
+   *
+   * @param max_table_size the new limit in bytes, or -1 for no limit.
+   */
+  Status SetMaxTableSize(int64_t max_table_size);
+
+  /**
+   * Sets the maximum age of the rows of the table, see ExpireRowBatchesOlderThan().
+   *
+   * @param max_age the maximum age, or a negative duration for no time based retention.
+   */
+  void SetMaxRetention(std::chrono::nanoseconds max_age) { max_age_ns_ = max_age.count(); }
+
+  /**
+   * Expires the batches whose rows are all older than the maximum retention of the table. Does
+   * nothing if the table has no time column or no maximum retention.
+   *
+   * @param now_ns the current time, in the same clock as the time column.
+   */
+  Status ExpireRowBatchesOlderThan(int64_t now_ns);
+
+  /**
+   * Makes the table write the cold batches it expires to stay within its size limit to a disk
+   * tier, instead of dropping them. Batches expired by the maximum retention are still dropped.
+   * Must be called before data is written to the table.
+   *
+   * @param dir the directory of the disk tier, which must not be shared with other tables.
+   * @param max_bytes the number of bytes the disk tier can take up.
+   */
+  Status EnableDiskTier(const std::filesystem::path& dir, int64_t max_bytes);
+
+  /**
+   * @return the disk tier holding the batches that were expired from memory, or nullptr.
+   */
+  std::shared_ptr<const DiskTier> disk_tier() const { return disk_tier_; }
+
   /**
    * @return number of column batches.
    */
@@ -189,16 +309,30 @@ class Table : public NotCopyable {
    */
   int64_t NumBytes() const { return bytes_; }
 
+  /**
+   * @return the number of bytes ever added to the table, including the expired batches.
+   */
+  int64_t NumBytesAdded() const { return bytes_added_; }
+
   schema::Relation GetRelation() const;
   StatusOr<std::vector<RecordBatchSPtr>> GetTableAsRecordBatches() const;
 
   /**
+   * Uses the per-batch time index, so only the batch that contains the position is read.
    * @param the timestamp to search for.
-   * @param mem_pool the arrow memory pool to use.
    * @return the batch position (batch number and row number in that batch) of the row with the
    * first timestamp greater than or equal to the given time.
    */
-  BatchPosition FindBatchPositionGreaterThanOrEqual(int64_t time, arrow::MemoryPool* mem_pool);
+  BatchPosition FindBatchPositionGreaterThanOrEqual(int64_t time);
+
+  /**
+   * Checks the predicates against the zone maps of the batch. Zone maps are built when batches
+   * become cold, so hot batches always match.
+   * @param row_batch_idx the index of the batch.
+   * @param predicates the predicates that the rows have to satisfy.
+   * @return false if no row of the batch can satisfy all of the predicates.
+   */
+  bool BatchMayMatch(int64_t row_batch_idx, const std::vector<ZoneMapPredicate>& predicates) const;
 
   // TODO(michellenguyen, PL-404): Time should always be column 0.
   int64_t FindTimeColumn();
@@ -212,6 +346,11 @@ class Table : public NotCopyable {
 
   TableStats GetTableStats() const;
 
+  /**
+   * Counts a record batch meant for this table that was dropped before reaching it.
+   */
+  void RecordDroppedBatch() { ++batches_dropped_; }
+
  private:
   /**
    * Adds a column to the table. The column must have the same type as the column expected by the
@@ -219,33 +358,97 @@ class Table : public NotCopyable {
    */
   Status AddColumn(std::shared_ptr<Column> col);
 
-  Status ExpireRowBatches(int64_t row_batch_size);
-  Status DeleteNextRowBatch();
-
-  int64_t FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
-                                      arrow::MemoryPool* mem_pool)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
-  int64_t FindBatchGreaterThanOrEqual(int64_t time_col_idx, int64_t time,
-                                      arrow::MemoryPool* mem_pool, int64_t start, int64_t end)
+  // Expires the oldest batches until there is room for row_batch_size more bytes. The lock is
+  // only taken if something has to be expired, and then once for all of the expired batches.
+  // Expiry frees headroom extra bytes, so that a full table doesn't take the lock on every batch.
+  Status ExpireRowBatches(int64_t row_batch_size, int64_t headroom = 0);
+  // The headroom TransferRecordBatch expires with, so ingestion into a full table only takes the
+  // locks when it rolls over that much data. Small tables expire exactly.
+  int64_t ExpiryHeadroom() const;
+
+  // The first and last timestamp of a batch. Batches are sorted by time, so these are also the
+  // minimum and maximum timestamps.
+  struct BatchTimeRange {
+    int64_t min_time;
+    int64_t max_time;
+  };
+
+  // A cold batch that was expired from memory and has to be written to the disk tier.
+  struct SpilledBatch {
+    std::unique_ptr<schema::RowBatch> rb;
+    BatchTimeRange time_range;
+  };
+
+  // Deletes the oldest batch. If spilled is set and the batch is cold, the batch is appended to it
+  // so that it can be written to the disk tier once the lock is released.
+  Status DeleteNextRowBatchUnlocked(std::vector<SpilledBatch>* spilled = nullptr)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_batches_consumer_lock_, cold_batches_lock_);
+
+  // A batch transferred from Stirling that hasn't been converted to arrow yet. Hot batches are
+  // immutable once they are in the ring.
+  struct HotBatch {
+    std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch;
+    int64_t bytes = 0;
+    BatchTimeRange time_range = {0, 0};
+  };
+
+  // Converts the first num_batches hot batches to arrow and appends them to the columns. Only the
+  // appends take cold_batches_lock_. When encode is set, the batches are encoded where that makes
+  // them smaller, and the number of bytes that saved is returned for the caller to account for.
+  StatusOr<int64_t> MoveHotBatchesToCold(int64_t num_batches, arrow::MemoryPool* mem_pool,
+                                         bool encode) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_batches_consumer_lock_)
+          ABSL_LOCKS_EXCLUDED(cold_batches_lock_);
+  // Moves the batches like MoveHotBatchesToCold, encoding them if
+  // --table_store_encode_cold_batches is set, and takes the bytes saved off the table's size.
+  Status MoveHotBatchesToColdAndEncode(int64_t num_batches, arrow::MemoryPool* mem_pool)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_batches_consumer_lock_)
+          ABSL_LOCKS_EXCLUDED(cold_batches_lock_);
+  int64_t FindBatchGreaterThanOrEqual(int64_t time)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
-  std::shared_ptr<arrow::Array> GetColumnBatch(int64_t col, int64_t batch,
-                                               arrow::MemoryPool* mem_pool)
+  int64_t FindRowGreaterThanOrEqual(int64_t batch_idx, int64_t time)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
+  // Adds the time range of any cold batch that was added to the columns directly.
+  void SyncColdTimeIndex() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
+  BatchTimeRange TimeRangeOf(const arrow::Array* time_batch, const BatchTimeRange* prev) const;
+  BatchTimeRange TimeRangeOf(const types::ColumnWrapper& time_batch,
+                             const BatchTimeRange* prev) const;
   int64_t NumBatchesUnlocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_batches_lock_);
   schema::RowDescriptor desc_;
   std::vector<std::shared_ptr<Column>> columns_;
-  // TODO(michellenguyen, PL-388): Change hot_batches_ to a list-based queue.
   std::unordered_map<std::string, std::shared_ptr<Column>> name_to_column_map_;
 
-  mutable std::deque<std::unique_ptr<px::types::ColumnWrapperRecordBatch>> hot_batches_;
-  mutable absl::base_internal::SpinLock hot_batches_lock_;
-
+  // TransferRecordBatch is the only producer of hot batches, so ingestion never takes a lock
+  // unless it rolls over the expiry headroom or the ring is full. Everything that reads hot
+  // batches holds either lock below, and everything that removes them holds both, which makes
+  // them the single consumer of the ring.
+  mutable HotBatchRing<HotBatch> hot_batches_;
+  // Set while TransferRecordBatch runs, so debug builds catch a second concurrent producer.
+  std::atomic<bool> producing_ = false;
+
+  // Held while hot batches are converted to arrow or removed. Taken before cold_batches_lock_,
+  // which is only held for the short reads and updates of the batches, so that they don't spin
+  // on a conversion.
+  mutable absl::Mutex hot_batches_consumer_lock_;
   mutable absl::base_internal::SpinLock cold_batches_lock_;
 
-  int64_t batches_expired_ = 0;
-  int64_t bytes_ = 0;
-  int64_t batches_added_ = 0;
-  int64_t max_table_size_ = 0;
+  // Index of the time column, or -1 if the table doesn't have a TIME64NS time_ column.
+  int64_t time_col_idx_ = -1;
+  // The time range of every cold batch, in batch order, so time lookups don't have to read the
+  // time column. Hot batches carry their own time range. Empty if the table has no time column.
+  mutable std::deque<BatchTimeRange> cold_time_index_ ABSL_GUARDED_BY(cold_batches_lock_);
+
+  std::atomic<int64_t> batches_expired_ = 0;
+  std::atomic<int64_t> batches_dropped_ = 0;
+  std::atomic<int64_t> bytes_ = 0;
+  // The number of bytes saved by encoding cold batches, so bytes_ plus this is the logical size.
+  std::atomic<int64_t> bytes_saved_by_encoding_ = 0;
+  std::atomic<int64_t> batches_added_ = 0;
+  std::atomic<int64_t> bytes_added_ = 0;
+  std::atomic<int64_t> max_table_size_ = 0;
+  std::atomic<int64_t> max_age_ns_ = -1;
+
+  std::shared_ptr<DiskTier> disk_tier_;
 };
 
 }  // namespace table_store
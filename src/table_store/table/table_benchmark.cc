@@ -17,6 +17,10 @@
  */
 
 #include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+
 #include "src/shared/types/types.h"
 #include "src/table_store/table/table.h"
 
@@ -193,11 +197,42 @@ static void BM_TableWriteFull(benchmark::State& state) {
   state.SetBytesProcessed(state.iterations() * batch_size);
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TableConcurrentWriteRead(benchmark::State& state) {
+  int64_t table_size = 4 * 1024 * 1024;
+  int64_t batch_length = 256;
+  auto table = MakeTable(table_size);
+  FillTableHot(table.get(), table_size, batch_length);
+
+  // Stirling transfers data while queries read the table.
+  std::atomic<bool> done = false;
+  std::atomic<int64_t> batches_written = 0;
+  std::thread writer([&]() {
+    while (!done) {
+      PL_CHECK_OK(table->TransferRecordBatch(MakeHotBatch(batch_length)));
+      ++batches_written;
+    }
+  });
+
+  for (auto _ : state) {
+    // The writer expires a batch before it adds one, so the last batch might briefly not exist.
+    benchmark::DoNotOptimize(
+        table->GetRowBatch(table->NumBatches() / 2, {0, 1}, arrow::default_memory_pool()));
+  }
+  done = true;
+  writer.join();
+
+  int64_t batch_size = batch_length * sizeof(int64_t) + batch_length * sizeof(double);
+  state.SetBytesProcessed(state.iterations() * batch_size);
+  state.counters["batches_written"] = batches_written;
+}
+
 BENCHMARK(BM_TableReadAllHot);
 BENCHMARK(BM_TableReadAllCold);
 BENCHMARK(BM_TableReadLastBatchAllHot);
 BENCHMARK(BM_TableReadLastBatchAllCold);
 BENCHMARK(BM_TableWriteEmpty);
 BENCHMARK(BM_TableWriteFull);
+BENCHMARK(BM_TableConcurrentWriteRead);
 
 }  // namespace px::table_store
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/table_checkpoint.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/schemapb/schema.pb.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+constexpr std::string_view kCheckpointExtension = ".ckpt";
+
+std::filesystem::path CheckpointPath(const std::filesystem::path& dir,
+                                     std::string_view table_name) {
+  return dir / absl::StrCat(table_name, kCheckpointExtension);
+}
+
+// The indexes of the UPID columns of the relation.
+std::vector<int> UPIDColumns(const schema::Relation& relation) {
+  std::vector<int> cols;
+  for (size_t i = 0; i < relation.NumColumns(); ++i) {
+    if (relation.GetColumnType(i) == types::DataType::UINT128 &&
+        relation.GetColumnSemanticType(i) == types::ST_UPID) {
+      cols.push_back(static_cast<int>(i));
+    }
+  }
+  return cols;
+}
+
+// Replaces the ASID, the top 32 bits of each UPID, in the UPID columns of the batch.
+void RemapASID(const std::vector<int>& upid_cols, uint32_t asid, schemapb::RowBatchData* rb_pb) {
+  for (int col : upid_cols) {
+    auto* data = rb_pb->mutable_cols(col)->mutable_uint128_data()->mutable_data();
+    for (auto& upid : *data) {
+      upid.set_high((static_cast<uint64_t>(asid) << 32) | (upid.high() & 0xffffffff));
+    }
+  }
+}
+
+}  // namespace
+
+Status WriteTableCheckpoint(const Table& table, std::string_view table_name,
+                            const std::filesystem::path& path) {
+  using ::google::protobuf::util::SerializeDelimitedToOstream;
+
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+      return error::Internal("Failed to open checkpoint file $0", tmp_path.string());
+    }
+
+    schemapb::Table header;
+    header.set_name(std::string(table_name));
+    PL_RETURN_IF_ERROR(table.GetRelation().ToProto(header.mutable_relation()));
+    if (!SerializeDelimitedToOstream(header, &ofs)) {
+      return error::Internal("Failed to write checkpoint file $0", tmp_path.string());
+    }
+
+    std::vector<int64_t> cols(table.NumColumns());
+    std::iota(cols.begin(), cols.end(), 0);
+    int64_t num_batches = table.NumBatches();
+    int64_t num_skipped = 0;
+    for (int64_t i = 0; i < num_batches; ++i) {
+      PL_ASSIGN_OR_RETURN(auto rb, table.GetRowBatch(i, cols, arrow::default_memory_pool()));
+      // RowBatchData has no validity, so the nulls would be restored as values.
+      if (rb->HasNulls()) {
+        ++num_skipped;
+        continue;
+      }
+      schemapb::RowBatchData rb_pb;
+      PL_RETURN_IF_ERROR(rb->ToProto(&rb_pb, /* arrow_buffers */ true));
+      if (!SerializeDelimitedToOstream(rb_pb, &ofs)) {
+        return error::Internal("Failed to write checkpoint file $0", tmp_path.string());
+      }
+    }
+
+    ofs.close();
+    if (!ofs) {
+      return error::Internal("Failed to write checkpoint file $0", tmp_path.string());
+    }
+    LOG_IF(WARNING, num_skipped != 0) << absl::Substitute(
+        "Left $0 of the $1 batches of table $2 with nulls out of its checkpoint", num_skipped,
+        num_batches, table_name);
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    return error::Internal("Failed to rename checkpoint file $0: $1", tmp_path.string(),
+                           ec.message());
+  }
+  return Status::OK();
+}
+
+Status RestoreTableCheckpoint(const std::filesystem::path& path, uint32_t asid, Table* table) {
+  using ::google::protobuf::util::ParseDelimitedFromZeroCopyStream;
+
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    return error::NotFound("Failed to open checkpoint file $0", path.string());
+  }
+  google::protobuf::io::IstreamInputStream input(&ifs);
+
+  bool clean_eof = false;
+  schemapb::Table header;
+  if (!ParseDelimitedFromZeroCopyStream(&header, &input, &clean_eof)) {
+    return error::Internal("Failed to read checkpoint file $0", path.string());
+  }
+  schema::Relation relation;
+  PL_RETURN_IF_ERROR(relation.FromProto(&header.relation()));
+  if (relation != table->GetRelation()) {
+    return error::InvalidArgument("Checkpoint $0 has relation $1, but the table has relation $2",
+                                  path.string(), relation.DebugString(),
+                                  table->GetRelation().DebugString());
+  }
+
+  const std::vector<int> upid_cols = UPIDColumns(table->GetRelation());
+  while (true) {
+    schemapb::RowBatchData rb_pb;
+    if (!ParseDelimitedFromZeroCopyStream(&rb_pb, &input, &clean_eof)) {
+      if (clean_eof) {
+        break;
+      }
+      return error::Internal("Checkpoint file $0 is truncated", path.string());
+    }
+    RemapASID(upid_cols, asid, &rb_pb);
+    PL_ASSIGN_OR_RETURN(auto rb, schema::RowBatch::FromMutableProto(&rb_pb));
+    PL_RETURN_IF_ERROR(table->WriteRowBatch(std::move(*rb)));
+  }
+  return Status::OK();
+}
+
+Status WriteTableStoreCheckpoint(TableStore* table_store, const std::filesystem::path& dir) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return error::Internal("Failed to create checkpoint directory $0: $1", dir.string(),
+                           ec.message());
+  }
+
+  for (const auto& [table_name, relation] : *table_store->GetRelationMap()) {
+    PL_UNUSED(relation);
+    Table* table = table_store->GetTable(table_name);
+    if (table == nullptr) {
+      continue;
+    }
+    PL_RETURN_IF_ERROR(WriteTableCheckpoint(*table, table_name, CheckpointPath(dir, table_name)));
+  }
+  return Status::OK();
+}
+
+Status RestoreTableStoreCheckpoint(const std::filesystem::path& dir, uint32_t asid,
+                                   TableStore* table_store) {
+  std::error_code ec;
+  if (!std::filesystem::is_directory(dir, ec)) {
+    return Status::OK();
+  }
+
+  for (const auto& [table_name, relation] : *table_store->GetRelationMap()) {
+    PL_UNUSED(relation);
+    Table* table = table_store->GetTable(table_name);
+    std::filesystem::path path = CheckpointPath(dir, table_name);
+    if (table == nullptr || !std::filesystem::exists(path, ec)) {
+      continue;
+    }
+    Status s = RestoreTableCheckpoint(path, asid, table);
+    if (!s.ok()) {
+      // The table keeps whatever was restored before the error.
+      LOG(WARNING) << absl::Substitute("Failed to restore table $0 from checkpoint: $1",
+                                       table_name, s.msg());
+    }
+  }
+
+  // Remove all the checkpoints, including the ones of tables that don't exist anymore.
+  for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == kCheckpointExtension) {
+      std::filesystem::remove(entry.path(), ec);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace table_store
+}  // namespace px
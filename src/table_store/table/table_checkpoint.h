@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table/table.h"
+#include "src/table_store/table/table_store.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * Table checkpoints keep the data of the tables across agent restarts.
+ *
+ * A checkpoint file is a stream of length delimited protos: a schemapb::Table with the name and
+ * relation of the table, followed by one schemapb::RowBatchData per row batch. The columns are
+ * written as raw arrow buffers, so that restoring a batch doesn't decode it value by value.
+ * RowBatchData doesn't keep the validity of the columns, so the batches with nulls are left out.
+ */
+
+/**
+ * Writes the row batches of the table to a checkpoint file. The file is replaced atomically, so
+ * that a failed write leaves the previous checkpoint intact.
+ */
+Status WriteTableCheckpoint(const Table& table, std::string_view table_name,
+                            const std::filesystem::path& path);
+
+/**
+ * Appends the row batches of a checkpoint file to the table. Fails if the checkpoint was written
+ * for a table with a different relation, e.g. because the schema changed across an upgrade.
+ * The UPIDs are given the agent's current ASID, since it can change when the agent re-registers.
+ */
+Status RestoreTableCheckpoint(const std::filesystem::path& path, uint32_t asid, Table* table);
+
+/**
+ * Writes a checkpoint of each table of the table store to the directory, as <table name>.ckpt.
+ */
+Status WriteTableStoreCheckpoint(TableStore* table_store, const std::filesystem::path& dir);
+
+/**
+ * Restores the checkpoints in the directory into the tables of the table store with the same
+ * names. This must happen before any data is written to the tables, to keep them in time order.
+ * The checkpoints are removed afterwards, so that the same data isn't restored twice.
+ */
+Status RestoreTableStoreCheckpoint(const std::filesystem::path& dir, uint32_t asid,
+                                   TableStore* table_store);
+
+}  // namespace table_store
+}  // namespace px
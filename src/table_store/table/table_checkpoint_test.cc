@@ -0,0 +1,161 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <absl/strings/substitute.h>
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/table/table_checkpoint.h"
+
+namespace px {
+namespace table_store {
+
+constexpr uint32_t kASID = 42;
+
+class TableCheckpointTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rel_ = schema::Relation(
+        {types::DataType::TIME64NS, types::DataType::STRING, types::DataType::BOOLEAN},
+        {"time_", "col1", "col2"});
+    table_ = Table::Create(rel_);
+    WriteBatch({1, 2, 3}, {"a", "bb", "ccc"}, {true, false, true});
+    WriteBatch({4, 5}, {"", "dddd"}, {false, false});
+  }
+
+  void WriteBatch(const std::vector<types::Time64NSValue>& col0,
+                  const std::vector<types::StringValue>& col1,
+                  const std::vector<types::BoolValue>& col2) {
+    schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), col0.size());
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col0, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+    ASSERT_OK(rb.AddColumn(types::ToArrow(col2, arrow::default_memory_pool())));
+    ASSERT_OK(table_->WriteRowBatch(rb));
+  }
+
+  void ExpectSameData(const Table& expected, const Table& actual) {
+    ASSERT_EQ(expected.NumBatches(), actual.NumBatches());
+    for (int64_t col = 0; col < expected.NumColumns(); ++col) {
+      for (int64_t i = 0; i < expected.NumBatches(); ++i) {
+        EXPECT_TRUE(expected.GetColumn(col)->batch(i)->Equals(actual.GetColumn(col)->batch(i)))
+            << absl::Substitute("col=$0 batch=$1", col, i);
+      }
+    }
+  }
+
+  testing::TempDir temp_dir_;
+  schema::Relation rel_;
+  std::shared_ptr<Table> table_;
+};
+
+TEST_F(TableCheckpointTest, write_and_restore) {
+  auto path = temp_dir_.path() / "table.ckpt";
+  ASSERT_OK(WriteTableCheckpoint(*table_, "table", path));
+
+  auto restored = Table::Create(rel_);
+  ASSERT_OK(RestoreTableCheckpoint(path, kASID, restored.get()));
+  ExpectSameData(*table_, *restored);
+}
+
+TEST_F(TableCheckpointTest, batches_with_nulls_are_left_out) {
+  auto table = Table::Create(rel_);
+  auto col1 = types::ColumnWrapper::Make(types::DataType::STRING, 2);
+  col1->SetNull(0);
+  schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), 2);
+  ASSERT_OK(rb.AddColumn(types::ToArrow(std::vector<types::Time64NSValue>{1, 2},
+                                        arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(col1->ConvertToArrow(arrow::default_memory_pool())));
+  ASSERT_OK(rb.AddColumn(types::ToArrow(std::vector<types::BoolValue>{true, false},
+                                        arrow::default_memory_pool())));
+  ASSERT_OK(table->WriteRowBatch(rb));
+
+  auto path = temp_dir_.path() / "table.ckpt";
+  ASSERT_OK(WriteTableCheckpoint(*table, "table", path));
+  auto restored = Table::Create(rel_);
+  ASSERT_OK(RestoreTableCheckpoint(path, kASID, restored.get()));
+  EXPECT_EQ(0, restored->NumBatches());
+}
+
+TEST_F(TableCheckpointTest, relation_mismatch) {
+  auto path = temp_dir_.path() / "table.ckpt";
+  ASSERT_OK(WriteTableCheckpoint(*table_, "table", path));
+
+  schema::Relation other_rel({types::DataType::TIME64NS, types::DataType::STRING},
+                             {"time_", "col1"});
+  auto restored = Table::Create(other_rel);
+  EXPECT_NOT_OK(RestoreTableCheckpoint(path, kASID, restored.get()));
+  EXPECT_EQ(0, restored->NumBatches());
+
+  EXPECT_NOT_OK(RestoreTableCheckpoint(temp_dir_.path() / "missing.ckpt", kASID,
+                                       restored.get()));
+}
+
+TEST_F(TableCheckpointTest, upids_get_the_current_asid) {
+  schema::Relation rel({types::DataType::TIME64NS, types::DataType::UINT128},
+                       {"time_", "upid"}, {types::ST_NONE, types::ST_UPID});
+  auto table = Table::Create(rel);
+  schema::RowBatch rb(schema::RowDescriptor(rel.col_types()), 2);
+  ASSERT_OK(rb.AddColumn(types::ToArrow(std::vector<types::Time64NSValue>{1, 2},
+                                        arrow::default_memory_pool())));
+  // The UPIDs of the agent's previous ASID, 7.
+  ASSERT_OK(rb.AddColumn(types::ToArrow(
+      std::vector<types::UInt128Value>{{(7ULL << 32) | 123, 1000}, {(7ULL << 32) | 456, 2000}},
+      arrow::default_memory_pool())));
+  ASSERT_OK(table->WriteRowBatch(rb));
+
+  auto path = temp_dir_.path() / "table.ckpt";
+  ASSERT_OK(WriteTableCheckpoint(*table, "table", path));
+  auto restored = Table::Create(rel);
+  ASSERT_OK(RestoreTableCheckpoint(path, kASID, restored.get()));
+
+  ASSERT_EQ(1, restored->NumBatches());
+  auto upids = restored->GetColumn(1)->batch(0);
+  EXPECT_EQ(absl::MakeUint128((uint64_t{kASID} << 32) | 123, 1000),
+            types::GetValueFromArrowArray<types::DataType::UINT128>(upids.get(), 0));
+  EXPECT_EQ(absl::MakeUint128((uint64_t{kASID} << 32) | 456, 2000),
+            types::GetValueFromArrowArray<types::DataType::UINT128>(upids.get(), 1));
+}
+
+TEST_F(TableCheckpointTest, table_store) {
+  TableStore table_store;
+  table_store.AddTable(table_, "table");
+  ASSERT_OK(WriteTableStoreCheckpoint(&table_store, temp_dir_.path() / "checkpoint"));
+  EXPECT_TRUE(std::filesystem::exists(temp_dir_.path() / "checkpoint" / "table.ckpt"));
+
+  TableStore restored_table_store;
+  restored_table_store.AddTable(Table::Create(rel_), "table");
+  ASSERT_OK(RestoreTableStoreCheckpoint(temp_dir_.path() / "checkpoint", kASID,
+                                        &restored_table_store));
+  ExpectSameData(*table_, *restored_table_store.GetTable("table"));
+
+  // The checkpoint is only restored once.
+  EXPECT_FALSE(std::filesystem::exists(temp_dir_.path() / "checkpoint" / "table.ckpt"));
+}
+
+}  // namespace table_store
+}  // namespace px
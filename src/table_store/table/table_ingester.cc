@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/table_ingester.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <absl/hash/hash.h>
+
+namespace px {
+namespace table_store {
+
+namespace {
+// How long an idle ingest thread waits for a batch before checking whether it was stopped.
+constexpr auto kDequeueTimeout = std::chrono::milliseconds(100);
+}  // namespace
+
+TableIngester::TableIngester(int num_threads, int64_t max_queued_batches)
+    : max_queued_batches_(max_queued_batches) {
+  for (int i = 0; i < std::max(num_threads, 1); ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+TableIngester::~TableIngester() { Stop(); }
+
+void TableIngester::Start(std::string_view cpu_list) {
+  if (running_.exchange(true)) {
+    return;
+  }
+  for (auto& shard : shards_) {
+    shard->thread =
+        std::thread(&TableIngester::RunIngest, this, shard.get(), std::string(cpu_list));
+  }
+}
+
+void TableIngester::Stop() {
+  running_ = false;
+  for (auto& shard : shards_) {
+    if (shard->thread.joinable()) {
+      shard->thread.join();
+    }
+  }
+}
+
+bool TableIngester::Enqueue(Table* table,
+                            std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+  Shard* shard = shards_[absl::Hash<Table*>()(table) % shards_.size()].get();
+  if (shard->depth.fetch_add(1) >= max_queued_batches_) {
+    shard->depth.fetch_sub(1);
+    table->RecordDroppedBatch();
+    int64_t num_dropped = ++num_dropped_;
+    LOG_EVERY_N(WARNING, 1000) << absl::Substitute(
+        "Table store ingest queue is full, dropped $0 record batches so far.", num_dropped);
+    return false;
+  }
+  shard->queue.enqueue(Item{table, std::move(record_batch)});
+  return true;
+}
+
+int64_t TableIngester::queue_depth() const {
+  int64_t depth = 0;
+  for (const auto& shard : shards_) {
+    depth += shard->depth;
+  }
+  return depth;
+}
+
+void TableIngester::RunIngest(Shard* shard, std::string cpu_list) {
+  Status s = SetCurrentThreadCPUs(cpu_list);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to pin ingest thread: $0", s.msg());
+  Item item;
+  while (running_) {
+    if (shard->queue.wait_dequeue_timed(item, kDequeueTimeout)) {
+      Ingest(&item);
+      shard->depth.fetch_sub(1);
+    }
+  }
+  // Producers stop before the ingester does, so whatever is left is the last of their data.
+  while (shard->queue.try_dequeue(item)) {
+    Ingest(&item);
+    shard->depth.fetch_sub(1);
+  }
+}
+
+void TableIngester::Ingest(Item* item) {
+  Status s = item->table->TransferRecordBatch(std::move(item->record_batch));
+  if (!s.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to ingest record batch: $0", s.msg());
+    return;
+  }
+  ++num_ingested_;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/table/table.h"
+
+#include "blockingconcurrentqueue.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * TableIngester moves record batches into their tables on its own threads, so that the
+ * producer (Stirling) never waits on the table store: expiration, compaction of hot batches
+ * and contention with queries all happen on the ingest threads.
+ *
+ * Each table is always ingested by the same thread, which keeps TransferRecordBatch()
+ * single-producer per table and the batches of a table in order. The queues are bounded:
+ * batches pushed while the queue of their thread is full are dropped, and counted in the
+ * batches_dropped stats of their table.
+ */
+class TableIngester {
+ public:
+  /**
+   * @param num_threads the number of ingest threads, each with its own queue.
+   * @param max_queued_batches the number of batches each queue can hold.
+   */
+  TableIngester(int num_threads, int64_t max_queued_batches);
+  ~TableIngester();
+
+  /**
+   * Starts the ingest threads. Batches queued before Start() are ingested once it's called.
+   *
+   * @param cpu_list the CPUs the threads run on (see SetCurrentThreadCPUs()). Batches converted
+   * by the ingest threads land on the NUMA node of these CPUs, which should be that of the queries.
+   */
+  void Start(std::string_view cpu_list = "");
+
+  /**
+   * Ingests the batches that are still queued, and stops the ingest threads.
+   */
+  void Stop();
+
+  /**
+   * Queues the record batch to be transferred into the table. Never blocks.
+   *
+   * @return false if the queue was full and the batch was dropped.
+   */
+  bool Enqueue(Table* table, std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch);
+
+  /**
+   * The number of batches waiting to be ingested, over all the queues.
+   */
+  int64_t queue_depth() const;
+  int64_t num_ingested() const { return num_ingested_; }
+  int64_t num_dropped() const { return num_dropped_; }
+
+ private:
+  struct Item {
+    Table* table = nullptr;
+    std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch;
+  };
+
+  struct Shard {
+    moodycamel::BlockingConcurrentQueue<Item> queue;
+    std::atomic<int64_t> depth = 0;
+    std::thread thread;
+  };
+
+  void RunIngest(Shard* shard, std::string cpu_list);
+  void Ingest(Item* item);
+
+  const int64_t max_queued_batches_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<bool> running_ = false;
+  std::atomic<int64_t> num_ingested_ = 0;
+  std::atomic<int64_t> num_dropped_ = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
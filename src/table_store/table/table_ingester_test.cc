@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/table_ingester.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/schema/relation.h"
+
+namespace px {
+namespace table_store {
+
+std::unique_ptr<types::ColumnWrapperRecordBatch> MakeRecordBatch(int64_t value) {
+  auto record_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto col = std::make_shared<types::Int64ValueColumnWrapper>(1);
+  col->Clear();
+  col->Append(value);
+  record_batch->push_back(col);
+  return record_batch;
+}
+
+class TableIngesterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    schema::Relation rel({types::DataType::INT64}, {"col1"});
+    for (int i = 0; i < 4; ++i) {
+      tables_.push_back(Table::Create(rel));
+    }
+  }
+
+  std::vector<std::shared_ptr<Table>> tables_;
+};
+
+TEST_F(TableIngesterTest, IngestsQueuedBatches) {
+  TableIngester ingester(/*num_threads*/ 2, /*max_queued_batches*/ 1000);
+  ingester.Start();
+  for (int64_t i = 0; i < 100; ++i) {
+    for (auto& table : tables_) {
+      EXPECT_TRUE(ingester.Enqueue(table.get(), MakeRecordBatch(i)));
+    }
+  }
+  ingester.Stop();
+
+  EXPECT_EQ(ingester.queue_depth(), 0);
+  EXPECT_EQ(ingester.num_ingested(), 400);
+  EXPECT_EQ(ingester.num_dropped(), 0);
+  for (auto& table : tables_) {
+    EXPECT_EQ(table->GetTableStats().batches_added, 100);
+  }
+}
+
+TEST_F(TableIngesterTest, DropsWhenFull) {
+  // Nothing is ingested until Start(), so the queue fills up.
+  TableIngester ingester(/*num_threads*/ 1, /*max_queued_batches*/ 3);
+  for (int64_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(ingester.Enqueue(tables_[0].get(), MakeRecordBatch(i)), i < 3);
+  }
+  EXPECT_EQ(ingester.queue_depth(), 3);
+  EXPECT_EQ(ingester.num_dropped(), 2);
+  EXPECT_EQ(tables_[0]->GetTableStats().batches_dropped, 2);
+
+  ingester.Start();
+  ingester.Stop();
+  EXPECT_EQ(ingester.queue_depth(), 0);
+  EXPECT_EQ(ingester.num_ingested(), 3);
+  EXPECT_EQ(tables_[0]->GetTableStats().batches_added, 3);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -17,15 +17,20 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include <absl/strings/substitute.h>
+
+#include "src/shared/types/huge_page_memory_pool.h"
 #include "src/table_store/table/table_store.h"
 
 namespace px {
 namespace table_store {
 
 std::unique_ptr<std::unordered_map<std::string, schema::Relation>> TableStore::GetRelationMap() {
+  absl::ReaderMutexLock lock(&tables_lock_);
   auto map = std::make_unique<RelationMap>();
   map->reserve(name_to_relation_map_.size());
   for (auto& [table_name, relation] : name_to_relation_map_) {
@@ -43,6 +48,7 @@ StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::Tab
   const TableInfo& table_info = id_to_table_info_map_iter->second;
   const schema::Relation& relation = table_info.relation;
   std::shared_ptr<Table> new_tablet = Table::Create(relation);
+  new_tablet->SetMaxRetention(max_retention_);
 
   TableIDTablet id_key = {table_id, tablet_id};
   id_to_table_map_[id_key] = new_tablet;
@@ -54,18 +60,32 @@ StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::Tab
   return new_tablet.get();
 }
 
-Status TableStore::AppendData(uint64_t table_id, types::TabletID tablet_id,
-                              std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch) {
+StatusOr<Table*> TableStore::GetOrCreateTablet(uint64_t table_id,
+                                               const types::TabletID& tablet_id) {
   Table* table = GetTable(table_id, tablet_id);
+  if (table != nullptr) {
+    return table;
+  }
   // We create new tablets only if the table at `table_id` exists, otherwise errors out.
-  if (table == nullptr) {
-    PL_ASSIGN_OR_RETURN(table, CreateNewTablet(table_id, tablet_id));
+  absl::MutexLock lock(&tables_lock_);
+  // Another producer may have created the tablet since the lookup above.
+  table = GetTableUnlocked(table_id, tablet_id);
+  if (table != nullptr) {
+    return table;
   }
+  return CreateNewTablet(table_id, tablet_id);
+}
+
+Status TableStore::AppendData(uint64_t table_id, types::TabletID tablet_id,
+                              std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch) {
+  PL_ASSIGN_OR_RETURN(Table * table, GetOrCreateTablet(table_id, tablet_id));
+  // The append itself happens outside the lock: each table has a single producer.
   return table->TransferRecordBatch(std::move(record_batch));
 }
 
 table_store::Table* TableStore::GetTable(const std::string& table_name,
                                          const types::TabletID& tablet_id) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   auto name_to_table_iter = name_to_table_map_.find(NameTablet{table_name, tablet_id});
   if (name_to_table_iter == name_to_table_map_.end()) {
     return nullptr;
@@ -75,6 +95,12 @@ table_store::Table* TableStore::GetTable(const std::string& table_name,
 
 table_store::Table* TableStore::GetTable(uint64_t table_id,
                                          const types::TabletID& tablet_id) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  return GetTableUnlocked(table_id, tablet_id);
+}
+
+table_store::Table* TableStore::GetTableUnlocked(uint64_t table_id,
+                                                 const types::TabletID& tablet_id) const {
   auto id_to_table_iter = id_to_table_map_.find(TableIDTablet{table_id, tablet_id});
   if (id_to_table_iter == id_to_table_map_.end()) {
     return nullptr;
@@ -92,6 +118,7 @@ void TableStore::RegisterTableName(const std::string& table_name, const types::T
     DCHECK_EQ(name_to_relation_map_iter->second, table_relation);
   }
 
+  table->SetMaxRetention(max_retention_);
   NameTablet key = {table_name, tablet_id};
   name_to_table_map_[key] = table;
 }
@@ -114,6 +141,7 @@ void TableStore::RegisterTableID(uint64_t table_id, TableInfo table_info,
 void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::string& table_name,
                           std::optional<uint64_t> table_id, const types::TabletID& tablet_id) {
   const auto& table_relation = table->GetRelation();
+  absl::MutexLock lock(&tables_lock_);
 
   // Register the table by name.
   RegisterTableName(table_name, tablet_id, table_relation, table);
@@ -125,6 +153,7 @@ void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::
 }
 
 Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_name) {
+  absl::MutexLock lock(&tables_lock_);
   auto table_iter = name_to_table_map_.find({table_name, ""});
   if (table_iter == name_to_table_map_.end()) {
     return error::Internal(
@@ -146,10 +175,12 @@ Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_nam
 }
 
 Status TableStore::SchemaAsProto(schemapb::Schema* schema) const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   return schema::Schema::ToProto(schema, name_to_relation_map_);
 }
 
 std::vector<uint64_t> TableStore::GetTableIDs() const {
+  absl::ReaderMutexLock lock(&tables_lock_);
   std::vector<uint64_t> ids;
   for (const auto& it : id_to_table_map_) {
     ids.emplace_back(it.first.table_id_);
@@ -157,5 +188,136 @@ std::vector<uint64_t> TableStore::GetTableIDs() const {
   return ids;
 }
 
+std::vector<std::shared_ptr<Table>> TableStore::GetAllTables() const {
+  absl::ReaderMutexLock lock(&tables_lock_);
+  std::vector<std::shared_ptr<Table>> tables;
+  tables.reserve(name_to_table_map_.size());
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    tables.push_back(table);
+  }
+  return tables;
+}
+
+void TableStore::CompactHotBatches() {
+  for (const auto& table : GetAllTables()) {
+    Status s = table->CompactHotBatches(types::DataMemoryPool());
+    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to compact hot batches: $0", s.msg());
+  }
+}
+
+void TableStore::SetMemoryBudget(int64_t budget_bytes) {
+  absl::MutexLock lock(&budget_lock_);
+  memory_budget_ = budget_bytes;
+}
+
+void TableStore::RebalanceMemoryBudget() {
+  // How much the latest rebalance weighs in the ingest rate of a table.
+  constexpr double kIngestRateSmoothing = 0.25;
+
+  std::vector<std::shared_ptr<Table>> tables = GetAllTables();
+  if (tables.empty()) {
+    return;
+  }
+
+  std::vector<int64_t> shares;
+  {
+    absl::MutexLock lock(&budget_lock_);
+    if (memory_budget_ == -1) {
+      return;
+    }
+    double total_rate = 0;
+    for (const auto& table : tables) {
+      IngestRate& ingest = ingest_rates_[table.get()];
+      int64_t bytes_added = table->NumBytesAdded();
+      ingest.rate += kIngestRateSmoothing *
+                     (static_cast<double>(bytes_added - ingest.last_bytes_added) - ingest.rate);
+      ingest.last_bytes_added = bytes_added;
+      total_rate += ingest.rate;
+    }
+
+    int64_t num_tables = tables.size();
+    int64_t floor = memory_budget_ / (4 * num_tables);
+    int64_t remainder = memory_budget_ - floor * num_tables;
+    for (const auto& table : tables) {
+      double weight = total_rate > 0 ? ingest_rates_[table.get()].rate / total_rate
+                                     : 1.0 / static_cast<double>(num_tables);
+      shares.push_back(floor + static_cast<int64_t>(weight * static_cast<double>(remainder)));
+    }
+  }
+
+  for (size_t i = 0; i < tables.size(); ++i) {
+    Status s = tables[i]->SetMaxTableSize(shares[i]);
+    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to resize table: $0", s.msg());
+  }
+}
+
+void TableStore::SetMaxRetention(std::chrono::nanoseconds max_age) {
+  absl::MutexLock lock(&tables_lock_);
+  max_retention_ = max_age;
+  for (const auto& [name_tablet, table] : name_to_table_map_) {
+    table->SetMaxRetention(max_age);
+  }
+}
+
+void TableStore::ExpireRowBatchesOlderThan(int64_t now_ns) {
+  for (const auto& table : GetAllTables()) {
+    Status s = table->ExpireRowBatchesOlderThan(now_ns);
+    LOG_IF(ERROR, !s.ok()) << absl::Substitute("Failed to expire old batches: $0", s.msg());
+  }
+}
+
+void TableStore::StartBackgroundMaintenance(std::chrono::milliseconds period,
+                                            std::string_view cpu_list) {
+  absl::MutexLock lock(&maintenance_lock_);
+  if (maintenance_thread_.joinable()) {
+    return;
+  }
+  stop_maintenance_ = false;
+  maintenance_thread_ = std::thread(&TableStore::RunBackgroundMaintenance, this, period,
+                                    std::string(cpu_list));
+}
+
+void TableStore::StopBackgroundMaintenance() {
+  std::thread thread;
+  {
+    absl::MutexLock lock(&maintenance_lock_);
+    stop_maintenance_ = true;
+    thread = std::move(maintenance_thread_);
+  }
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void TableStore::RunBackgroundMaintenance(std::chrono::milliseconds period,
+                                          std::string cpu_list) {
+  Status s = SetCurrentThreadCPUs(cpu_list);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to pin table store maintenance thread: $0",
+                                               s.msg());
+  while (true) {
+    {
+      absl::MutexLock lock(&maintenance_lock_);
+      if (maintenance_lock_.AwaitWithTimeout(absl::Condition(&stop_maintenance_),
+                                             absl::FromChrono(period))) {
+        return;
+      }
+    }
+    // Expire first, so that no time is spent compacting batches that are about to go away.
+    ExpireRowBatchesOlderThan(CurrentTimeNS());
+    RebalanceMemoryBudget();
+    CompactHotBatches();
+
+    StatusOr<types::HugePageMemoryPoolStats> pool_stats = types::DataMemoryPoolStats();
+    if (pool_stats.ok()) {
+      const auto& stats = pool_stats.ValueOrDie();
+      VLOG(1) << absl::Substitute(
+          "Huge page pool: $0 bytes allocated, $1 bytes mapped in $2 arenas ($3 free), "
+          "fragmentation=$4",
+          stats.bytes_allocated, stats.bytes_mapped, stats.num_arenas, stats.num_free_arenas,
+          stats.fragmentation());
+    }
+  }
+}
+
 }  // namespace table_store
 }  // namespace px
@@ -18,13 +18,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
@@ -75,12 +79,18 @@ struct TableInfo {
 
 /**
  * TableStore keeps track of the tables in our system.
+ *
+ * The table maps are guarded by a reader-writer lock, so that data can be appended from
+ * several producer threads (e.g. Stirling connectors that run on their own threads) while
+ * queries look tables up. Tables are never removed, so the returned Table pointers stay valid
+ * after the lock is released.
  */
 class TableStore {
  public:
   using RelationMap = std::unordered_map<std::string, schema::Relation>;
 
   TableStore() = default;
+  ~TableStore() { StopBackgroundMaintenance(); }
 
   /**
    * Get table IDs returns a list of table ids available in the table store.
@@ -152,12 +162,76 @@ class TableStore {
   Status AppendData(uint64_t table_id, types::TabletID tablet_id,
                     std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch);
 
+  /**
+   * Gets the tablet of the table, creating it as in AppendData() if it doesn't exist yet.
+   *
+   * Producers that push to the same tablet repeatedly can resolve it once and append to the
+   * returned table directly, which skips the lookup under tables_lock_. The pointer stays valid
+   * for the lifetime of the table store, since tables are never removed.
+   *
+   * @return error if the table doesn't exist.
+   */
+  StatusOr<Table*> GetOrCreateTablet(uint64_t table_id, const types::TabletID& tablet_id);
+
   Status SchemaAsProto(schemapb::Schema* schema) const;
 
+  /**
+   * Converts the hot batches of all the tables to cold batches. See Table::CompactHotBatches.
+   */
+  void CompactHotBatches();
+
+  /**
+   * Sets the number of bytes that all the tables can hold together. The budget is split between
+   * the tables by RebalanceMemoryBudget().
+   *
+   * @param budget_bytes: the budget, or -1 to leave the size limits of the tables alone.
+   */
+  void SetMemoryBudget(int64_t budget_bytes);
+
+  /**
+   * Splits the memory budget between the tables according to how fast data comes into each of
+   * them, and expires the oldest batches of the tables that are now over their share. Every table
+   * gets at least a quarter of an even split, so that a quiet table keeps some history.
+   */
+  void RebalanceMemoryBudget();
+
+  /**
+   * Sets the maximum age of the rows of all the tables, including the ones added later.
+   *
+   * @param max_age: the maximum age, or a negative duration for no time based retention.
+   */
+  void SetMaxRetention(std::chrono::nanoseconds max_age);
+
+  /**
+   * Expires the batches that are older than the maximum retention. See
+   * Table::ExpireRowBatchesOlderThan.
+   *
+   * @param now_ns: the current time, in the same clock as the time columns.
+   */
+  void ExpireRowBatchesOlderThan(int64_t now_ns);
+
+  /**
+   * Starts a thread that periodically compacts the hot batches, rebalances the memory budget and
+   * expires old batches, so that this work happens off the query and ingest paths. Does nothing
+   * if the thread is already running.
+   *
+   * @param period: the time between two rounds of maintenance.
+   * @param cpu_list: the CPUs the thread runs on (see SetCurrentThreadCPUs()). Batches are
+   * converted on this thread, so on NUMA nodes it should match the CPUs that queries run on.
+   */
+  void StartBackgroundMaintenance(std::chrono::milliseconds period,
+                                  std::string_view cpu_list = "");
+
+  /**
+   * Stops the maintenance thread, if it is running.
+   */
+  void StopBackgroundMaintenance();
+
   /**
    * GetTableName returns the table name if the ID is found, else empty string.
    */
   std::string GetTableName(uint64_t id) const {
+    absl::ReaderMutexLock lock(&tables_lock_);
     const auto& it = id_to_table_info_map_.find(id);
     if (it != id_to_table_info_map_.end()) {
       return it->second.table_name;
@@ -168,10 +242,15 @@ class TableStore {
  private:
   void RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
                          const schema::Relation& table_relation,
-                         std::shared_ptr<table_store::Table> table);
+                         std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
 
   void RegisterTableID(uint64_t table_id, TableInfo table_info, const types::TabletID& tablet_id,
-                       std::shared_ptr<table_store::Table> table);
+                       std::shared_ptr<table_store::Table> table)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
+
+  table_store::Table* GetTableUnlocked(uint64_t table_id, const types::TabletID& tablet_id) const
+      ABSL_SHARED_LOCKS_REQUIRED(tables_lock_);
 
   /**
    * Create a new tablet inside of the table with table_id
@@ -180,21 +259,48 @@ class TableStore {
    * @param tablet_id: the tablet to create for the tablet.
    * @return StatusOr<Table*>: the table object or an error if the table is nonexistant.
    */
-  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id);
+  StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(tables_lock_);
+
+  std::vector<std::shared_ptr<Table>> GetAllTables() const;
+
+  void RunBackgroundMaintenance(std::chrono::milliseconds period, std::string cpu_list);
 
   // The default value for tablets, when tablet is not specified.
   inline static types::TabletID kDefaultTablet = "";
+
+  mutable absl::Mutex tables_lock_;
   // Map a name to a table.
-  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_;
+  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>>
+      name_to_table_map_ ABSL_GUARDED_BY(tables_lock_);
   // Map an id to a table.
-  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_;
+  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>>
+      id_to_table_map_ ABSL_GUARDED_BY(tables_lock_);
   // Mapping from name to relation for adding new tablets.
   // TODO(oazizi): value should likely be shared_ptr<schema::Relation> because the
   //               same information is in id_to_table_info_map_ TableInfo.
   //               Can avoid this copy.
-  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_;
+  absl::flat_hash_map<std::string, schema::Relation>
+      name_to_relation_map_ ABSL_GUARDED_BY(tables_lock_);
   // Mapping from id to name and relation pair for adding new tablets.
-  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_;
+  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_ ABSL_GUARDED_BY(tables_lock_);
+  // The retention that new tables are created with.
+  std::chrono::nanoseconds max_retention_ ABSL_GUARDED_BY(tables_lock_) =
+      std::chrono::nanoseconds(-1);
+
+  // The ingest rate of a table, in bytes per rebalance.
+  struct IngestRate {
+    int64_t last_bytes_added = 0;
+    double rate = 0;
+  };
+  absl::Mutex budget_lock_;
+  int64_t memory_budget_ ABSL_GUARDED_BY(budget_lock_) = -1;
+  // Tables are never removed, so the keys stay valid.
+  absl::flat_hash_map<const Table*, IngestRate> ingest_rates_ ABSL_GUARDED_BY(budget_lock_);
+
+  absl::Mutex maintenance_lock_;
+  bool stop_maintenance_ ABSL_GUARDED_BY(maintenance_lock_) = false;
+  std::thread maintenance_thread_;
 };
 
 }  // namespace table_store
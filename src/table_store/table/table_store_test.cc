@@ -20,6 +20,7 @@
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <thread>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -95,6 +96,53 @@ TEST_F(TableStoreTest, get_table_ids) {
   EXPECT_THAT(table_store.GetTableIDs(), ::testing::UnorderedElementsAre(1, 20));
 }
 
+TEST_F(TableStoreTest, compact_hot_batches) {
+  TableStore table_store;
+  const uint64_t kTableID = 1;
+  table_store.AddTable(table1, "a", kTableID);
+  EXPECT_OK(table_store.AppendData(kTableID, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_OK(table_store.AppendData(kTableID, "", MakeRel1ColumnWrapperBatch()));
+  EXPECT_EQ(0, table1->GetColumn(0)->numBatches());
+
+  table_store.CompactHotBatches();
+  EXPECT_EQ(2, table1->GetColumn(0)->numBatches());
+  EXPECT_EQ(2, table1->NumBatches());
+
+  // The background thread can be started and stopped repeatedly.
+  table_store.StartBackgroundMaintenance(std::chrono::milliseconds(1));
+  table_store.StopBackgroundMaintenance();
+  table_store.StartBackgroundMaintenance(std::chrono::milliseconds(1));
+  table_store.StopBackgroundMaintenance();
+}
+
+TEST_F(TableStoreTest, rebalance_memory_budget) {
+  TableStore table_store;
+  table_store.AddTable(table1, "a", 1);
+  table_store.AddTable(table2, "b", 2);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_OK(table_store.AppendData(1, "", MakeRel1ColumnWrapperBatch()));
+  }
+  EXPECT_EQ(108, table1->NumBytes());
+
+  // No budget, the tables keep their limits.
+  table_store.RebalanceMemoryBudget();
+  EXPECT_EQ(FLAGS_table_store_table_size_limit, table1->GetTableStats().max_table_size);
+
+  // Each table gets 400 / 8 = 50 bytes, and the busy table gets the other 300 on top.
+  table_store.SetMemoryBudget(400);
+  table_store.RebalanceMemoryBudget();
+  EXPECT_EQ(350, table1->GetTableStats().max_table_size);
+  EXPECT_EQ(50, table2->GetTableStats().max_table_size);
+  EXPECT_EQ(108, table1->NumBytes());
+
+  // A smaller budget expires the batches that don't fit anymore.
+  table_store.SetMemoryBudget(100);
+  table_store.RebalanceMemoryBudget();
+  EXPECT_EQ(88, table1->GetTableStats().max_table_size);
+  EXPECT_EQ(12, table2->GetTableStats().max_table_size);
+  EXPECT_EQ(81, table1->NumBytes());
+}
+
 TEST_F(TableStoreTest, table_id_aliasing) {
   auto table_store = TableStore();
 
@@ -277,6 +325,61 @@ TEST_F(TableStoreTabletsTest, add_tablet_on_append_data) {
   EXPECT_EQ(tablet2->NumBatches(), 0);
 }
 
+TEST_F(TableStoreTabletsTest, get_or_create_tablet) {
+  auto table_store = TableStore();
+  uint64_t table_id = 123;
+  types::TabletID tablet1_id = "456";
+  types::TabletID tablet2_id = "789";
+
+  table_store.AddTable(tablet1_1, "a", table_id, tablet1_id);
+
+  ASSERT_OK_AND_ASSIGN(Table * tablet1, table_store.GetOrCreateTablet(table_id, tablet1_id));
+  EXPECT_EQ(tablet1, tablet1_1.get());
+
+  // The tablet is created on first use, and resolves to the same table afterwards.
+  ASSERT_OK_AND_ASSIGN(Table * tablet2, table_store.GetOrCreateTablet(table_id, tablet2_id));
+  EXPECT_NE(tablet2, tablet1);
+  EXPECT_EQ(tablet2, table_store.GetTable("a", tablet2_id));
+  ASSERT_OK_AND_EQ(table_store.GetOrCreateTablet(table_id, tablet2_id), tablet2);
+
+  EXPECT_OK(tablet2->TransferRecordBatch(MakeRel1ColumnWrapperBatch()));
+  EXPECT_EQ(tablet2->NumBatches(), 1);
+  EXPECT_EQ(tablet1->NumBatches(), 0);
+
+  // Unknown tables aren't created.
+  EXPECT_NOT_OK(table_store.GetOrCreateTablet(table_id + 1, tablet1_id));
+}
+
+// Producers on separate threads create tablets in the same store while appending.
+TEST_F(TableStoreTabletsTest, concurrent_append_data) {
+  auto table_store = TableStore();
+  constexpr uint64_t kTableIDs[] = {123, 124};
+  constexpr int kNumTablets = 100;
+
+  table_store.AddTable(tablet1_1, "a", kTableIDs[0]);
+  table_store.AddTable(tablet1_2, "b", kTableIDs[1]);
+
+  std::vector<std::thread> producers;
+  for (uint64_t table_id : kTableIDs) {
+    producers.emplace_back([&, table_id]() {
+      for (int i = 0; i < kNumTablets; ++i) {
+        EXPECT_OK(table_store.AppendData(table_id, absl::StrCat(i), MakeRel1ColumnWrapperBatch()));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  for (const std::string name : {"a", "b"}) {
+    for (int i = 0; i < kNumTablets; ++i) {
+      Table* tablet = table_store.GetTable(name, absl::StrCat(i));
+      ASSERT_NE(tablet, nullptr);
+      EXPECT_EQ(tablet->NumBatches(), 1);
+    }
+  }
+}
+
 using TableStoreTabletsDeathTest = TableStoreTabletsTest;
 TEST_F(TableStoreTabletsDeathTest, tablet_test) {
   auto table_store = TableStore();
@@ -428,39 +428,313 @@ TEST(TableTest, find_batch_position_greater_or_eq) {
 
   EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch_3)));
 
-  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(0, arrow::default_memory_pool());
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(0);
   EXPECT_EQ(0, batch_pos.batch_idx);
   EXPECT_EQ(0, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(5, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(5);
   EXPECT_EQ(0, batch_pos.batch_idx);
   EXPECT_EQ(3, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(6, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(6);
   EXPECT_EQ(0, batch_pos.batch_idx);
   EXPECT_EQ(3, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(8, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(8);
   EXPECT_EQ(1, batch_pos.batch_idx);
   EXPECT_EQ(0, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(10, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(10);
   EXPECT_EQ(2, batch_pos.batch_idx);
   EXPECT_EQ(2, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(13, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(13);
   EXPECT_EQ(3, batch_pos.batch_idx);
   EXPECT_EQ(0, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(21, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(21);
   EXPECT_EQ(4, batch_pos.batch_idx);
   EXPECT_EQ(0, batch_pos.row_idx);
 
-  batch_pos = table.FindBatchPositionGreaterThanOrEqual(24, arrow::default_memory_pool());
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(24);
   EXPECT_EQ(-1, batch_pos.batch_idx);
   EXPECT_EQ(-1, batch_pos.row_idx);
 }
 
+TEST(TableTest, find_batch_position_after_conversion_and_expiry) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  // Each batch is 3 rows of 8 bytes, so the table holds 3 batches.
+  Table table(rel, 72);
+
+  auto transfer_batch = [&table](std::vector<types::Time64NSValue> times) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    for (const auto& time : times) {
+      col_wrapper->Append(time);
+    }
+    wrapper_batch->push_back(col_wrapper);
+    return table.TransferRecordBatch(std::move(wrapper_batch));
+  };
+
+  EXPECT_OK(transfer_batch({1, 2, 3}));
+  EXPECT_OK(transfer_batch({4, 5, 6}));
+  EXPECT_OK(transfer_batch({7, 8, 9}));
+
+  // Moves the first two batches into cold storage.
+  EXPECT_OK(table.GetRowBatch(1, {0}, arrow::default_memory_pool()));
+
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(5);
+  EXPECT_EQ(1, batch_pos.batch_idx);
+  EXPECT_EQ(1, batch_pos.row_idx);
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(8);
+  EXPECT_EQ(2, batch_pos.batch_idx);
+  EXPECT_EQ(1, batch_pos.row_idx);
+
+  // Expires the first batch.
+  EXPECT_OK(transfer_batch({10, 11, 12}));
+  EXPECT_EQ(3, table.NumBatches());
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(0);
+  EXPECT_EQ(0, batch_pos.batch_idx);
+  EXPECT_EQ(0, batch_pos.row_idx);
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(9);
+  EXPECT_EQ(1, batch_pos.batch_idx);
+  EXPECT_EQ(2, batch_pos.row_idx);
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(11);
+  EXPECT_EQ(2, batch_pos.batch_idx);
+  EXPECT_EQ(1, batch_pos.row_idx);
+
+  batch_pos = table.FindBatchPositionGreaterThanOrEqual(13);
+  EXPECT_EQ(-1, batch_pos.batch_idx);
+}
+
+TEST(TableTest, transfer_into_full_hot_batch_ring) {
+  int32_t capacity = FLAGS_table_store_hot_batch_ring_capacity;
+  FLAGS_table_store_hot_batch_ring_capacity = 2;
+
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  Table table(rel, -1);
+  for (int64_t i = 0; i < 5; ++i) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    // Each batch holds the times {10 * i, 10 * i + 1}.
+    col_wrapper->Append(10 * i);
+    col_wrapper->Append(10 * i + 1);
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  }
+  FLAGS_table_store_hot_batch_ring_capacity = capacity;
+
+  // Transfers into a full ring convert the hot batches, so no batches are lost.
+  EXPECT_EQ(5, table.NumBatches());
+  EXPECT_EQ(5, table.GetTableStats().batches_added);
+  EXPECT_EQ(0, table.GetTableStats().min_time);
+  EXPECT_EQ(41, table.GetTableStats().max_time);
+
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(31);
+  EXPECT_EQ(3, batch_pos.batch_idx);
+  EXPECT_EQ(1, batch_pos.row_idx);
+
+  for (int64_t i = 0; i < 5; ++i) {
+    auto rb = table.GetRowBatch(i, {0}, arrow::default_memory_pool()).ConsumeValueOrDie();
+    EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(
+        std::vector<types::Time64NSValue>({10 * i, 10 * i + 1}), arrow::default_memory_pool())));
+  }
+}
+
+TEST(TableTest, compact_hot_batches) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  Table table(rel, -1);
+  for (int64_t i = 0; i < 3; ++i) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    col_wrapper->Append(10 * i);
+    col_wrapper->Append(10 * i + 1);
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  }
+  EXPECT_EQ(0, table.GetColumn(0)->numBatches());
+
+  EXPECT_OK(table.CompactHotBatches(arrow::default_memory_pool()));
+
+  // The batches are all cold now, with the same indices.
+  EXPECT_EQ(3, table.GetColumn(0)->numBatches());
+  EXPECT_EQ(3, table.NumBatches());
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(11);
+  EXPECT_EQ(1, batch_pos.batch_idx);
+  EXPECT_EQ(1, batch_pos.row_idx);
+  for (int64_t i = 0; i < 3; ++i) {
+    auto rb = table.GetRowBatch(i, {0}, arrow::default_memory_pool()).ConsumeValueOrDie();
+    EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(
+        std::vector<types::Time64NSValue>({10 * i, 10 * i + 1}), arrow::default_memory_pool())));
+  }
+
+  // Nothing left to compact.
+  EXPECT_OK(table.CompactHotBatches(arrow::default_memory_pool()));
+  EXPECT_EQ(3, table.GetColumn(0)->numBatches());
+}
+
+TEST(TableTest, expire_row_batches_older_than) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  Table table(rel, -1);
+  auto add_batch = [&table](int64_t time) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    col_wrapper->Append(time);
+    col_wrapper->Append(time + 1);
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  };
+  for (int64_t i = 0; i < 3; ++i) {
+    add_batch(10 * i);
+  }
+  // Mix cold and hot batches.
+  EXPECT_OK(table.CompactHotBatches(arrow::default_memory_pool()));
+  add_batch(30);
+
+  // No retention, nothing expires.
+  EXPECT_OK(table.ExpireRowBatchesOlderThan(100));
+  EXPECT_EQ(4, table.NumBatches());
+
+  table.SetMaxRetention(std::chrono::nanoseconds(10));
+  EXPECT_OK(table.ExpireRowBatchesOlderThan(25));
+  EXPECT_EQ(2, table.NumBatches());
+  EXPECT_EQ(1, table.FindBatchPositionGreaterThanOrEqual(30).batch_idx);
+
+  EXPECT_OK(table.ExpireRowBatchesOlderThan(35));
+  EXPECT_EQ(1, table.NumBatches());
+  EXPECT_OK(table.ExpireRowBatchesOlderThan(100));
+  EXPECT_EQ(0, table.NumBatches());
+  EXPECT_EQ(0, table.NumBytes());
+}
+
+TEST(TableTest, set_max_table_size) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  Table table(rel, -1);
+  for (int64_t i = 0; i < 4; ++i) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    col_wrapper->Append(10 * i);
+    col_wrapper->Append(10 * i + 1);
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  }
+  EXPECT_EQ(64, table.NumBytes());
+  EXPECT_EQ(64, table.NumBytesAdded());
+
+  // Shrinking the table expires the oldest batches at once.
+  EXPECT_OK(table.SetMaxTableSize(40));
+  EXPECT_EQ(2, table.NumBatches());
+  EXPECT_EQ(32, table.NumBytes());
+  EXPECT_EQ(64, table.NumBytesAdded());
+  EXPECT_EQ(40, table.GetTableStats().max_table_size);
+}
+
+TEST(TableTest, transfer_expires_with_headroom) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  // Each batch is 8KiB, so the table holds 128 batches and expires 16KiB of headroom at a time.
+  Table table(rel, 1024 * 1024);
+  auto transfer = [&table](int64_t i) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    for (int64_t j = 0; j < 1024; ++j) {
+      col_wrapper->Append(1024 * i + j);
+    }
+    wrapper_batch->push_back(col_wrapper);
+    return table.TransferRecordBatch(std::move(wrapper_batch));
+  };
+  for (int64_t i = 0; i < 128; ++i) {
+    EXPECT_OK(transfer(i));
+  }
+  EXPECT_EQ(0, table.GetTableStats().batches_expired);
+
+  // The first batch that doesn't fit expires the headroom on top of its own size.
+  EXPECT_OK(transfer(128));
+  EXPECT_EQ(3, table.GetTableStats().batches_expired);
+  EXPECT_EQ(126, table.NumBatches());
+
+  // The next batches fit in the headroom without expiring anything.
+  EXPECT_OK(transfer(129));
+  EXPECT_OK(transfer(130));
+  EXPECT_EQ(3, table.GetTableStats().batches_expired);
+  EXPECT_EQ(128, table.NumBatches());
+  EXPECT_EQ(1024 * 1024, table.NumBytes());
+
+  EXPECT_OK(transfer(131));
+  EXPECT_EQ(6, table.GetTableStats().batches_expired);
+}
+
+TEST(TableTest, encode_cold_batches) {
+  const bool encode_cold_batches = FLAGS_table_store_encode_cold_batches;
+  FLAGS_table_store_encode_cold_batches = true;
+  DEFER(FLAGS_table_store_encode_cold_batches = encode_cold_batches);
+
+  schema::Relation rel(
+      std::vector<types::DataType>({types::DataType::TIME64NS, types::DataType::STRING}),
+      std::vector<std::string>({"time_", "req_method"}));
+  Table table(rel, -1);
+
+  std::vector<types::Time64NSValue> times;
+  std::vector<types::StringValue> methods;
+  auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto time_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+  auto method_wrapper = std::make_shared<types::StringValueColumnWrapper>(0);
+  for (int64_t i = 0; i < 100; ++i) {
+    times.push_back(1000 + i * 10);
+    methods.push_back(i % 2 == 0 ? "GET" : "POST");
+    time_wrapper->Append(times.back());
+    method_wrapper->Append(methods.back());
+  }
+  wrapper_batch->push_back(time_wrapper);
+  wrapper_batch->push_back(method_wrapper);
+  EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(stats.bytes, stats.logical_bytes);
+
+  // Compacting the table makes the batch cold, which encodes both columns.
+  EXPECT_OK(table.CompactHotBatches(arrow::default_memory_pool()));
+  stats = table.GetTableStats();
+  EXPECT_LT(stats.bytes, stats.logical_bytes);
+  // 100 8 byte times, plus 50 "GET"s and 50 "POST"s.
+  EXPECT_EQ(1150, stats.logical_bytes);
+
+  auto rb = table.GetRowBatch(0, {0, 1}, arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(times, arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(methods, arrow::default_memory_pool())));
+
+  // Encoded batches are decoded on every read.
+  rb = table.GetRowBatchSlice(0, {1}, arrow::default_memory_pool(), 1, 3).ConsumeValueOrDie();
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(
+      std::vector<types::StringValue>({"POST", "GET"}), arrow::default_memory_pool())));
+
+  auto batch_pos = table.FindBatchPositionGreaterThanOrEqual(1015);
+  EXPECT_EQ(0, batch_pos.batch_idx);
+  EXPECT_EQ(2, batch_pos.row_idx);
+}
+
+TEST(TableTest, batch_may_match_zone_maps) {
+  auto table = TestTable();
+  // col2 is {1, 2, 3} and {5, 6}.
+  ZoneMapPredicate predicate;
+  predicate.column_idx = 1;
+  predicate.op = ZoneMapPredicate::Op::kGreaterThan;
+  predicate.int_value = 4;
+
+  EXPECT_FALSE(table->BatchMayMatch(0, {predicate}));
+  EXPECT_TRUE(table->BatchMayMatch(1, {predicate}));
+  EXPECT_TRUE(table->BatchMayMatch(0, {}));
+}
+
 TEST(TableTest, ToProto) {
   auto table = TestTable();
   table_store::schemapb::Table table_proto;
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+template <typename TArray, typename TValue>
+bool ComputeMinMax(const arrow::Array& batch, TValue* min, TValue* max) {
+  const auto& arr = static_cast<const TArray&>(batch);
+  bool found = false;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (arr.IsNull(i)) {
+      continue;
+    }
+    TValue value = arr.Value(i);
+    if constexpr (std::is_floating_point_v<TValue>) {
+      // Comparisons with NaN are always false, so NaNs can't make a batch match.
+      if (std::isnan(value)) {
+        continue;
+      }
+    }
+    if (!found || value < *min) {
+      *min = value;
+    }
+    if (!found || value > *max) {
+      *max = value;
+    }
+    found = true;
+  }
+  return found;
+}
+
+// Returns false if there are more than kMaxZoneMapValues distinct values.
+bool ComputeDistinctValues(const arrow::Array& batch, std::vector<absl::uint128>* values) {
+  const auto& arr = static_cast<const arrow::UInt128Array&>(batch);
+  absl::flat_hash_set<absl::uint128> distinct;
+  for (int64_t i = 0; i < arr.length(); ++i) {
+    if (arr.IsNull(i)) {
+      continue;
+    }
+    distinct.insert(arr.Value(i));
+    if (distinct.size() > kMaxZoneMapValues) {
+      return false;
+    }
+  }
+  values->assign(distinct.begin(), distinct.end());
+  std::sort(values->begin(), values->end());
+  return true;
+}
+
+// Whether the two sorted vectors have a value in common.
+bool Intersects(const std::vector<absl::uint128>& a, const std::vector<absl::uint128>& b) {
+  auto a_it = a.begin();
+  auto b_it = b.begin();
+  while (a_it != a.end() && b_it != b.end()) {
+    if (*a_it < *b_it) {
+      ++a_it;
+    } else if (*b_it < *a_it) {
+      ++b_it;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+bool RangeMayMatch(ZoneMapPredicate::Op op, T min, T max, T value) {
+  switch (op) {
+    case ZoneMapPredicate::Op::kEqual:
+      return min <= value && value <= max;
+    case ZoneMapPredicate::Op::kLessThan:
+      return min < value;
+    case ZoneMapPredicate::Op::kLessThanEqual:
+      return min <= value;
+    case ZoneMapPredicate::Op::kGreaterThan:
+      return max > value;
+    case ZoneMapPredicate::Op::kGreaterThanEqual:
+      return max >= value;
+    case ZoneMapPredicate::Op::kIn:
+      break;
+  }
+  return true;
+}
+
+}  // namespace
+
+ZoneMap ComputeZoneMap(types::DataType data_type, const arrow::Array& batch) {
+  ZoneMap zone_map;
+  zone_map.null_count = batch.null_count();
+  zone_map.length = batch.length();
+  switch (data_type) {
+    case types::DataType::INT64:
+    case types::DataType::TIME64NS:
+      zone_map.has_min_max =
+          ComputeMinMax<arrow::Int64Array>(batch, &zone_map.int_min, &zone_map.int_max);
+      break;
+    case types::DataType::FLOAT64:
+      zone_map.is_float = true;
+      zone_map.has_min_max =
+          ComputeMinMax<arrow::DoubleArray>(batch, &zone_map.float_min, &zone_map.float_max);
+      break;
+    case types::DataType::UINT128:
+      zone_map.has_values = ComputeDistinctValues(batch, &zone_map.uint128_values);
+      break;
+    default:
+      break;
+  }
+  return zone_map;
+}
+
+bool ZoneMapPredicate::MayMatch(const ZoneMap& zone_map) const {
+  // Comparisons with null are never true.
+  if (zone_map.length > 0 && zone_map.null_count == zone_map.length) {
+    return false;
+  }
+  if (op == Op::kIn) {
+    return !zone_map.has_values || Intersects(zone_map.uint128_values, uint128_values);
+  }
+  if (!zone_map.has_min_max) {
+    return true;
+  }
+  if (!zone_map.is_float && !is_float) {
+    return RangeMayMatch(op, zone_map.int_min, zone_map.int_max, int_value);
+  }
+  double min = zone_map.is_float ? zone_map.float_min : static_cast<double>(zone_map.int_min);
+  double max = zone_map.is_float ? zone_map.float_max : static_cast<double>(zone_map.int_max);
+  double value = is_float ? float_value : static_cast<double>(int_value);
+  return RangeMayMatch(op, min, max, value);
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <cstdint>
+#include <vector>
+
+#include <absl/numeric/int128.h>
+
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * The stats of one batch of a column, used to skip batches that can't match a predicate.
+ */
+struct ZoneMap {
+  // Whether the min and max are set. Only numeric columns with non-null values have them.
+  bool has_min_max = false;
+  // The min and max of INT64 and TIME64NS columns.
+  int64_t int_min = 0;
+  int64_t int_max = 0;
+  // Whether the column is a FLOAT64 column, which uses the float min and max.
+  bool is_float = false;
+  // The min and max of FLOAT64 columns, ignoring NaNs.
+  double float_min = 0;
+  double float_max = 0;
+  int64_t null_count = 0;
+  int64_t length = 0;
+  // Whether the distinct values are set. Only UINT128 columns (i.e. UPIDs) with at most
+  // kMaxZoneMapValues distinct values have them.
+  bool has_values = false;
+  // The sorted distinct non-null values of UINT128 columns.
+  std::vector<absl::uint128> uint128_values;
+};
+
+// Batches of UINT128 columns with more distinct values than this don't keep them. A batch of a
+// PEM table usually holds the rows of a few dozen processes at most.
+constexpr size_t kMaxZoneMapValues = 64;
+
+/**
+ * Computes the zone map of a batch.
+ * @param data_type The data type of the column the batch belongs to.
+ * @param batch The batch.
+ */
+ZoneMap ComputeZoneMap(types::DataType data_type, const arrow::Array& batch);
+
+/**
+ * A comparison between a column and a constant: `column <op> value`, or, for kIn, a check that
+ * a UINT128 column equals one of the constants in uint128_values.
+ */
+struct ZoneMapPredicate {
+  enum class Op { kEqual, kLessThan, kLessThanEqual, kGreaterThan, kGreaterThanEqual, kIn };
+
+  // The index of the column in the table.
+  int64_t column_idx = 0;
+  Op op = Op::kEqual;
+  // The value is compared as a double if either it or the column is a float.
+  bool is_float = false;
+  int64_t int_value = 0;
+  double float_value = 0;
+  // The sorted values of kIn.
+  std::vector<absl::uint128> uint128_values;
+
+  /**
+   * @return false if no row of the batch with the given zone map can satisfy the predicate.
+   */
+  bool MayMatch(const ZoneMap& zone_map) const;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <cmath>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+ZoneMapPredicate IntPredicate(ZoneMapPredicate::Op op, int64_t value) {
+  ZoneMapPredicate predicate;
+  predicate.op = op;
+  predicate.int_value = value;
+  return predicate;
+}
+
+ZoneMapPredicate FloatPredicate(ZoneMapPredicate::Op op, double value) {
+  ZoneMapPredicate predicate;
+  predicate.op = op;
+  predicate.is_float = true;
+  predicate.float_value = value;
+  return predicate;
+}
+}  // namespace
+
+using Op = ZoneMapPredicate::Op;
+
+TEST(ZoneMapTest, int_column) {
+  auto arr = types::ToArrow(std::vector<types::Int64Value>({5, -3, 10, 7}),
+                            arrow::default_memory_pool());
+  auto zone_map = ComputeZoneMap(types::DataType::INT64, *arr);
+  ASSERT_TRUE(zone_map.has_min_max);
+  EXPECT_EQ(-3, zone_map.int_min);
+  EXPECT_EQ(10, zone_map.int_max);
+
+  EXPECT_TRUE(IntPredicate(Op::kEqual, 10).MayMatch(zone_map));
+  EXPECT_FALSE(IntPredicate(Op::kEqual, 11).MayMatch(zone_map));
+  EXPECT_TRUE(IntPredicate(Op::kLessThan, -2).MayMatch(zone_map));
+  EXPECT_FALSE(IntPredicate(Op::kLessThan, -3).MayMatch(zone_map));
+  EXPECT_TRUE(IntPredicate(Op::kLessThanEqual, -3).MayMatch(zone_map));
+  EXPECT_FALSE(IntPredicate(Op::kGreaterThan, 10).MayMatch(zone_map));
+  EXPECT_TRUE(IntPredicate(Op::kGreaterThanEqual, 10).MayMatch(zone_map));
+  // Comparing an int column to a float compares them as doubles.
+  EXPECT_FALSE(FloatPredicate(Op::kGreaterThan, 1e9).MayMatch(zone_map));
+  EXPECT_TRUE(FloatPredicate(Op::kGreaterThan, 9.5).MayMatch(zone_map));
+}
+
+TEST(ZoneMapTest, float_column_ignores_nan) {
+  auto arr = types::ToArrow(std::vector<types::Float64Value>({1.5, NAN, -0.5}),
+                            arrow::default_memory_pool());
+  auto zone_map = ComputeZoneMap(types::DataType::FLOAT64, *arr);
+  ASSERT_TRUE(zone_map.has_min_max);
+  EXPECT_EQ(-0.5, zone_map.float_min);
+  EXPECT_EQ(1.5, zone_map.float_max);
+
+  EXPECT_FALSE(FloatPredicate(Op::kGreaterThan, 1.5).MayMatch(zone_map));
+  EXPECT_TRUE(IntPredicate(Op::kGreaterThan, 1).MayMatch(zone_map));
+  EXPECT_FALSE(IntPredicate(Op::kLessThan, -1).MayMatch(zone_map));
+}
+
+TEST(ZoneMapTest, non_numeric_column_always_matches) {
+  auto arr = types::ToArrow(std::vector<types::StringValue>({"a", "b"}),
+                            arrow::default_memory_pool());
+  auto zone_map = ComputeZoneMap(types::DataType::STRING, *arr);
+  EXPECT_FALSE(zone_map.has_min_max);
+  EXPECT_TRUE(IntPredicate(Op::kEqual, 0).MayMatch(zone_map));
+}
+
+TEST(ZoneMapTest, uint128_column_keeps_distinct_values) {
+  auto arr = types::ToArrow(std::vector<types::UInt128Value>({{1, 2}, {3, 4}, {1, 2}}),
+                            arrow::default_memory_pool());
+  auto zone_map = ComputeZoneMap(types::DataType::UINT128, *arr);
+  ASSERT_TRUE(zone_map.has_values);
+  EXPECT_EQ(2UL, zone_map.uint128_values.size());
+
+  ZoneMapPredicate predicate;
+  predicate.op = Op::kIn;
+  predicate.uint128_values = {absl::MakeUint128(0, 1), absl::MakeUint128(3, 4)};
+  EXPECT_TRUE(predicate.MayMatch(zone_map));
+  predicate.uint128_values = {absl::MakeUint128(0, 1), absl::MakeUint128(5, 6)};
+  EXPECT_FALSE(predicate.MayMatch(zone_map));
+}
+
+TEST(ZoneMapTest, uint128_column_with_too_many_values_always_matches) {
+  std::vector<types::UInt128Value> values;
+  for (size_t i = 0; i <= kMaxZoneMapValues; ++i) {
+    values.emplace_back(0, i);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  auto zone_map = ComputeZoneMap(types::DataType::UINT128, *arr);
+  EXPECT_FALSE(zone_map.has_values);
+
+  ZoneMapPredicate predicate;
+  predicate.op = Op::kIn;
+  predicate.uint128_values = {absl::MakeUint128(1, 0)};
+  EXPECT_TRUE(predicate.MayMatch(zone_map));
+}
+
+}  // namespace table_store
+}  // namespace px
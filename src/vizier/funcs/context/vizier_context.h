@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
+#include <string>
 
 #include "src/common/base/base.h"
 #include "src/table_store/table_store.h"
@@ -41,18 +43,21 @@ class VizierFuncFactoryContext : public NotCopyable {
  public:
   using MDSStub = services::metadata::MetadataService::Stub;
   using MDTPStub = services::metadata::MetadataTracepointService::Stub;
+  using AgentMetricsFunc = std::function<std::map<std::string, int64_t>()>;
 
   VizierFuncFactoryContext() = default;
   VizierFuncFactoryContext(const agent::Manager* agent_manager,
                            const std::shared_ptr<MDSStub>& mds_stub,
                            const std::shared_ptr<MDTPStub>& mdtp_stub,
                            std::shared_ptr<::px::table_store::TableStore> table_store,
-                           std::function<void(grpc::ClientContext* ctx)> add_grpc_auth)
+                           std::function<void(grpc::ClientContext* ctx)> add_grpc_auth,
+                           AgentMetricsFunc agent_metrics_func = nullptr)
       : agent_manager_(agent_manager),
         mds_stub_(mds_stub),
         mdtp_stub_(mdtp_stub),
         table_store_(table_store),
-        add_auth_to_grpc_context_func_(add_grpc_auth) {}
+        add_auth_to_grpc_context_func_(add_grpc_auth),
+        agent_metrics_func_(std::move(agent_metrics_func)) {}
   virtual ~VizierFuncFactoryContext() = default;
 
   const agent::Manager* agent_manager() const {
@@ -77,12 +82,24 @@ class VizierFuncFactoryContext : public NotCopyable {
     return add_auth_to_grpc_context_func_;
   }
 
+  /**
+   * Returns the agent's internal counters by name, such as the reuse of its GRPC channels. Empty
+   * when the context doesn't belong to an agent.
+   */
+  std::map<std::string, int64_t> AgentMetrics() const {
+    if (!agent_metrics_func_) {
+      return {};
+    }
+    return agent_metrics_func_();
+  }
+
  private:
   const agent::Manager* agent_manager_ = nullptr;
   std::shared_ptr<MDSStub> mds_stub_ = nullptr;
   std::shared_ptr<MDTPStub> mdtp_stub_ = nullptr;
   std::shared_ptr<::px::table_store::TableStore> table_store_ = nullptr;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_context_func_;
+  AgentMetricsFunc agent_metrics_func_;
 };
 
 }  // namespace funcs
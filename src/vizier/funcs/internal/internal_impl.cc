@@ -18,6 +18,7 @@
 
 #include "src/vizier/funcs/internal/internal_impl.h"
 #include "src/vizier/funcs/internal/debug.h"
+#include "src/vizier/funcs/internal/query_trace.h"
 #include "src/vizier/funcs/internal/stack_trace.h"
 
 namespace px {
@@ -31,6 +32,7 @@ void RegisterFuncsOrDie(carnot::udf::Registry* registry) {
   registry->RegisterOrDie<HeapStatsUDTF>("_HeapStats");
   registry->RegisterOrDie<HeapSampleUDTF>("_HeapSample");
   registry->RegisterOrDie<HeapGrowthStacksUDTF>("_HeapGrowthStacks");
+  registry->RegisterOrDie<QuerySpansUDTF>("_QuerySpans");
 }
 
 }  // namespace internal
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_format.h>
+
+#include "src/carnot/trace/query_trace.h"
+#include "src/carnot/udf/registry.h"
+#include "src/carnot/udf/udf.h"
+#include "src/common/base/base.h"
+#include "src/common/json/json.h"
+
+namespace px {
+namespace vizier {
+namespace funcs {
+
+/**
+ * Returns the spans of the recent queries on each agent, to find the stage a slow query spent
+ * its time in. Spans of the same query on different agents share the query_id.
+ */
+class QuerySpansUDTF final : public carnot::udf::UDTF<QuerySpansUDTF> {
+ public:
+  static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(
+        ColInfo("asid", types::DataType::INT64, types::PatternType::GENERAL,
+                "The short ID of the agent"),
+        ColInfo("query_id", types::DataType::STRING, types::PatternType::GENERAL,
+                "The ID of the query"),
+        ColInfo("span_id", types::DataType::STRING, types::PatternType::GENERAL,
+                "The ID of the span"),
+        ColInfo("parent_span_id", types::DataType::STRING, types::PatternType::GENERAL,
+                "The ID of the parent span, empty for the top spans of an agent"),
+        ColInfo("name", types::DataType::STRING, types::PatternType::GENERAL,
+                "The stage of the query, ie. compile, fragment or grpc_sink"),
+        ColInfo("start_time", types::DataType::TIME64NS, types::PatternType::GENERAL,
+                "The time the span started"),
+        ColInfo("duration_ns", types::DataType::INT64, types::PatternType::GENERAL,
+                "The duration of the span"),
+        ColInfo("cpu_time_ns", types::DataType::INT64, types::PatternType::GENERAL,
+                "The CPU time of the span's thread, or -1 if it ended on another thread"),
+        ColInfo("peak_memory_bytes", types::DataType::INT64, types::PatternType::GENERAL,
+                "The peak memory of the query when the span ended, or -1 if not measured"),
+        ColInfo("attributes", types::DataType::STRING, types::PatternType::GENERAL,
+                "The attributes of the span as JSON"));
+  }
+
+  Status Init(FunctionContext*) {
+    spans_ = carnot::trace::QueryTraceStore::Default()->Spans();
+    return Status::OK();
+  }
+
+  bool NextRecord(FunctionContext* ctx, RecordWriter* rw) {
+    if (idx_ >= spans_.size()) {
+      return false;
+    }
+    const auto& span = spans_[idx_];
+    rw->Append<IndexOf("asid")>(ctx->metadata_state()->asid());
+    rw->Append<IndexOf("query_id")>(span.query_id.str());
+    rw->Append<IndexOf("span_id")>(absl::StrFormat("%016x", span.span_id));
+    rw->Append<IndexOf("parent_span_id")>(
+        span.parent_span_id == 0 ? "" : absl::StrFormat("%016x", span.parent_span_id));
+    rw->Append<IndexOf("name")>(span.name);
+    rw->Append<IndexOf("start_time")>(span.start_time_ns);
+    rw->Append<IndexOf("duration_ns")>(span.duration_ns());
+    rw->Append<IndexOf("cpu_time_ns")>(span.cpu_time_ns);
+    rw->Append<IndexOf("peak_memory_bytes")>(span.peak_memory_bytes);
+    rw->Append<IndexOf("attributes")>(utils::ToJSONString(span.attributes));
+
+    ++idx_;
+    return idx_ < spans_.size();
+  }
+
+ private:
+  size_t idx_ = 0;
+  std::vector<carnot::trace::QuerySpan> spans_;
+};
+
+}  // namespace funcs
+}  // namespace vizier
+}  // namespace px
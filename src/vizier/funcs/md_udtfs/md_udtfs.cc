@@ -29,15 +29,21 @@ namespace funcs {
 namespace md {
 
 void RegisterFuncsOrDie(const VizierFuncFactoryContext& ctx, carnot::udf::Registry* registry) {
-  registry->RegisterFactoryOrDie<GetTables, UDTFWithMDFactory<GetTables>>("GetTables", ctx);
-  registry->RegisterFactoryOrDie<GetTableSchemas, UDTFWithMDFactory<GetTableSchemas>>("GetSchemas",
-                                                                                      ctx);
+  // The metadata service responses are shared by all the UDTFs created by this registry.
+  auto response_caches = std::make_shared<MDSResponseCaches>();
+  registry->RegisterFactoryOrDie<GetTables, UDTFWithMDFactory<GetTables>>("GetTables", ctx,
+                                                                          response_caches);
+  registry->RegisterFactoryOrDie<GetTableSchemas, UDTFWithMDFactory<GetTableSchemas>>(
+      "GetSchemas", ctx, response_caches);
   registry->RegisterFactoryOrDie<GetAgentStatus, UDTFWithMDFactory<GetAgentStatus>>(
-      "GetAgentStatus", ctx);
+      "GetAgentStatus", ctx, response_caches);
 
   registry->RegisterOrDie<GetDebugMDState>("_DebugMDState");
   registry->RegisterFactoryOrDie<GetDebugTableInfo, UDTFWithTableStoreFactory<GetDebugTableInfo>>(
       "_DebugTableInfo", ctx.table_store());
+  registry->RegisterFactoryOrDie<GetDebugAgentMetrics,
+                                 UDTFWithAgentMetricsFactory<GetDebugAgentMetrics>>(
+      "_DebugAgentMetrics", ctx);
 
   registry->RegisterFactoryOrDie<GetUDFList, UDTFWithRegistryFactory<GetUDFList>>("GetUDFList",
                                                                                   registry);
@@ -22,6 +22,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -35,6 +36,7 @@
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/base.h"
 #include "src/common/uuid/uuid.h"
+#include "src/vizier/funcs/md_udtfs/mds_response_cache.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
 namespace px {
@@ -45,14 +47,18 @@ template <typename TUDTF>
 class UDTFWithMDFactory : public carnot::udf::UDTFFactory {
  public:
   UDTFWithMDFactory() = delete;
-  explicit UDTFWithMDFactory(const VizierFuncFactoryContext& ctx) : ctx_(ctx) {}
+  UDTFWithMDFactory(const VizierFuncFactoryContext& ctx,
+                    std::shared_ptr<MDSResponseCaches> response_caches)
+      : ctx_(ctx), response_caches_(std::move(response_caches)) {}
 
   std::unique_ptr<carnot::udf::AnyUDTF> Make() override {
-    return std::make_unique<TUDTF>(ctx_.mds_stub(), ctx_.add_auth_to_grpc_context_func());
+    return std::make_unique<TUDTF>(ctx_.mds_stub(), ctx_.add_auth_to_grpc_context_func(),
+                                   response_caches_);
   }
 
  private:
   const VizierFuncFactoryContext& ctx_;
+  std::shared_ptr<MDSResponseCaches> response_caches_;
 };
 
 template <typename TUDTF>
@@ -98,6 +104,20 @@ class UDTFWithTableStoreFactory : public carnot::udf::UDTFFactory {
   const ::px::table_store::TableStore* table_store_;
 };
 
+template <typename TUDTF>
+class UDTFWithAgentMetricsFactory : public carnot::udf::UDTFFactory {
+ public:
+  UDTFWithAgentMetricsFactory() = delete;
+  explicit UDTFWithAgentMetricsFactory(const VizierFuncFactoryContext& ctx) : ctx_(ctx) {}
+
+  std::unique_ptr<carnot::udf::AnyUDTF> Make() override {
+    return std::make_unique<TUDTF>(ctx_.AgentMetrics());
+  }
+
+ private:
+  const VizierFuncFactoryContext& ctx_;
+};
+
 /**
  * This UDTF fetches all the tables that are available to query from the MDS.
  */
@@ -105,10 +125,14 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
  public:
   using MDSStub = vizier::services::metadata::MetadataService::Stub;
   using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using RelationMap = google::protobuf::Map<std::string, table_store::schemapb::Relation>;
   GetTables() = delete;
   GetTables(std::shared_ptr<MDSStub> stub,
-            std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+            std::function<void(grpc::ClientContext*)> add_context_authentication,
+            std::shared_ptr<MDSResponseCaches> response_caches)
+      : stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        response_caches_(std::move(response_caches)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -120,46 +144,32 @@ class GetTables final : public carnot::udf::UDTF<GetTables> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
-
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to metadata service");
-    }
-
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
-      table_info_.emplace_back(table_name, rel.desc());
-    }
+    PL_ASSIGN_OR_RETURN(resp_, response_caches_->schemas.Get(
+                                   [this](grpc::ClientContext* ctx, SchemaResponse* out) {
+                                     px::vizier::services::metadata::SchemaRequest req;
+                                     add_context_authentication_func_(ctx);
+                                     return stub_->GetSchemas(ctx, req, out);
+                                   }));
+    table_it_ = resp_->schema().relation_map().begin();
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!table_info_.size()) {
-      return false;
+  // Streams the tables straight from the cached response.
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    const auto& relation_map = resp_->schema().relation_map();
+    for (int i = 0; i < max_records && table_it_ != relation_map.end(); ++i, ++table_it_) {
+      rw->Append<IndexOf("table_name")>(table_it_->first);
+      rw->Append<IndexOf("table_desc")>(table_it_->second.desc());
     }
-    const auto& r = table_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("table_desc")>(r.table_desc);
-
-    idx_++;
-    return idx_ < static_cast<int>(table_info_.size());
+    return table_it_ != relation_map.end();
   }
 
  private:
-  struct TableInfo {
-    TableInfo(const std::string& table_name, const std::string& table_desc)
-        : table_name(table_name), table_desc(table_desc) {}
-    std::string table_name;
-    std::string table_desc;
-  };
-
-  int idx_ = 0;
-  std::vector<TableInfo> table_info_;
+  std::shared_ptr<const SchemaResponse> resp_;
+  RelationMap::const_iterator table_it_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<MDSResponseCaches> response_caches_;
 };
 
 /**
@@ -169,10 +179,14 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
  public:
   using MDSStub = vizier::services::metadata::MetadataService::Stub;
   using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using RelationMap = google::protobuf::Map<std::string, table_store::schemapb::Relation>;
   GetTableSchemas() = delete;
   GetTableSchemas(std::shared_ptr<MDSStub> stub,
-                  std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+                  std::function<void(grpc::ClientContext*)> add_context_authentication,
+                  std::shared_ptr<MDSResponseCaches> response_caches)
+      : stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        response_caches_(std::move(response_caches)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -188,61 +202,46 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::SchemaRequest req;
-    px::vizier::services::metadata::SchemaResponse resp;
-
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetSchemas(&ctx, req, &resp);
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to metadata service");
-    }
-
-    // TODO(zasgar): We store the data since it's hard to traverse two maps at once. We should
-    // either do that or perhaps have an interface that allows UDTFs to write multiple records in
-    // a single invocation.
-    for (const auto& [table_name, rel] : resp.schema().relation_map()) {
-      for (const auto& col : rel.columns()) {
-        relation_info_.emplace_back(table_name, col.column_name(),
-                                    std::string(magic_enum::enum_name(col.column_type())),
-                                    col.column_desc());
-      }
-    }
+    PL_ASSIGN_OR_RETURN(resp_, response_caches_->schemas.Get(
+                                   [this](grpc::ClientContext* ctx, SchemaResponse* out) {
+                                     px::vizier::services::metadata::SchemaRequest req;
+                                     add_context_authentication_func_(ctx);
+                                     return stub_->GetSchemas(ctx, req, out);
+                                   }));
+    table_it_ = resp_->schema().relation_map().begin();
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    if (!relation_info_.size()) {
-      return false;
+  // Streams the columns straight from the cached response, the cursor is the table and the index
+  // of the next column in it.
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    const auto& relation_map = resp_->schema().relation_map();
+    int num_records = 0;
+    while (num_records < max_records && table_it_ != relation_map.end()) {
+      const auto& [table_name, rel] = *table_it_;
+      if (col_idx_ >= rel.columns_size()) {
+        ++table_it_;
+        col_idx_ = 0;
+        continue;
+      }
+      const auto& col = rel.columns(col_idx_);
+      rw->Append<IndexOf("table_name")>(table_name);
+      rw->Append<IndexOf("column_name")>(col.column_name());
+      rw->Append<IndexOf("column_type")>(std::string(magic_enum::enum_name(col.column_type())));
+      rw->Append<IndexOf("column_desc")>(col.column_desc());
+      ++col_idx_;
+      ++num_records;
     }
-    const auto& r = relation_info_[idx_];
-    rw->Append<IndexOf("table_name")>(r.table_name);
-    rw->Append<IndexOf("column_name")>(r.column_name);
-    rw->Append<IndexOf("column_type")>(r.column_type);
-    rw->Append<IndexOf("column_desc")>(r.column_desc);
-
-    idx_++;
-    return idx_ < static_cast<int>(relation_info_.size());
+    return table_it_ != relation_map.end();
   }
 
  private:
-  struct RelationInfo {
-    RelationInfo(const std::string& table_name, const std::string& column_name,
-                 const std::string& column_type, const std::string& column_desc)
-        : table_name(table_name),
-          column_name(column_name),
-          column_type(column_type),
-          column_desc(column_desc) {}
-    std::string table_name;
-    std::string column_name;
-    std::string column_type;
-    std::string column_desc;
-  };
-
-  int idx_ = 0;
-  std::vector<RelationInfo> relation_info_;
+  std::shared_ptr<const SchemaResponse> resp_;
+  RelationMap::const_iterator table_it_;
+  int col_idx_ = 0;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<MDSResponseCaches> response_caches_;
 };
 
 /**
@@ -251,11 +250,15 @@ class GetTableSchemas final : public carnot::udf::UDTF<GetTableSchemas> {
 class GetAgentStatus final : public carnot::udf::UDTF<GetAgentStatus> {
  public:
   using MDSStub = vizier::services::metadata::MetadataService::Stub;
-  using SchemaResponse = vizier::services::metadata::SchemaResponse;
+  using AgentInfoResponse = vizier::services::metadata::AgentInfoResponse;
   GetAgentStatus() = delete;
   GetAgentStatus(std::shared_ptr<MDSStub> stub,
-                 std::function<void(grpc::ClientContext*)> add_context_authentication)
-      : idx_(0), stub_(stub), add_context_authentication_func_(add_context_authentication) {}
+                 std::function<void(grpc::ClientContext*)> add_context_authentication,
+                 std::shared_ptr<MDSResponseCaches> response_caches)
+      : idx_(0),
+        stub_(stub),
+        add_context_authentication_func_(add_context_authentication),
+        response_caches_(std::move(response_caches)) {}
 
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ONE_KELVIN; }
 
@@ -277,47 +280,46 @@ class GetAgentStatus final : public carnot::udf::UDTF<GetAgentStatus> {
   }
 
   Status Init(FunctionContext*) {
-    px::vizier::services::metadata::AgentInfoRequest req;
-    resp_ = std::make_unique<px::vizier::services::metadata::AgentInfoResponse>();
-
-    grpc::ClientContext ctx;
-    add_context_authentication_func_(&ctx);
-    auto s = stub_->GetAgentInfo(&ctx, req, resp_.get());
-    if (!s.ok()) {
-      return error::Internal("Failed to make RPC call to GetAgentInfo");
-    }
+    PL_ASSIGN_OR_RETURN(resp_, response_caches_->agent_info.Get(
+                                   [this](grpc::ClientContext* ctx, AgentInfoResponse* out) {
+                                     px::vizier::services::metadata::AgentInfoRequest req;
+                                     add_context_authentication_func_(ctx);
+                                     return stub_->GetAgentInfo(ctx, req, out);
+                                   }));
     return Status::OK();
   }
 
-  bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    const auto& agent_metadata = resp_->info(idx_);
-    const auto& agent_info = agent_metadata.agent();
-    const auto& agent_status = agent_metadata.status();
-
-    auto u_or_s = ParseUUID(agent_info.info().agent_id());
-    sole::uuid u;
-    if (u_or_s.ok()) {
-      u = u_or_s.ConsumeValueOrDie();
+  // Streams the agents straight from the cached response, which can hold tens of thousands of them.
+  bool NextBatch(FunctionContext*, int max_records, RecordWriter* rw) {
+    for (int i = 0; i < max_records && idx_ < resp_->info_size(); ++i, ++idx_) {
+      const auto& agent_metadata = resp_->info(idx_);
+      const auto& agent_info = agent_metadata.agent();
+      const auto& agent_status = agent_metadata.status();
+
+      auto u_or_s = ParseUUID(agent_info.info().agent_id());
+      sole::uuid u;
+      if (u_or_s.ok()) {
+        u = u_or_s.ConsumeValueOrDie();
+      }
+      // TODO(zasgar): Figure out abort mechanism;
+
+      rw->Append<IndexOf("agent_id")>(absl::MakeUint128(u.ab, u.cd));
+      rw->Append<IndexOf("asid")>(agent_info.asid());
+      rw->Append<IndexOf("hostname")>(agent_info.info().host_info().hostname());
+      rw->Append<IndexOf("ip_address")>(agent_info.info().ip_address());
+      rw->Append<IndexOf("agent_state")>(StringValue(magic_enum::enum_name(agent_status.state())));
+      rw->Append<IndexOf("create_time")>(agent_info.create_time_ns());
+      rw->Append<IndexOf("last_heartbeat_ns")>(agent_status.ns_since_last_heartbeat());
     }
-    // TODO(zasgar): Figure out abort mechanism;
-
-    rw->Append<IndexOf("agent_id")>(absl::MakeUint128(u.ab, u.cd));
-    rw->Append<IndexOf("asid")>(agent_info.asid());
-    rw->Append<IndexOf("hostname")>(agent_info.info().host_info().hostname());
-    rw->Append<IndexOf("ip_address")>(agent_info.info().ip_address());
-    rw->Append<IndexOf("agent_state")>(StringValue(magic_enum::enum_name(agent_status.state())));
-    rw->Append<IndexOf("create_time")>(agent_info.create_time_ns());
-    rw->Append<IndexOf("last_heartbeat_ns")>(agent_status.ns_since_last_heartbeat());
-
-    ++idx_;
     return idx_ < resp_->info_size();
   }
 
  private:
   int idx_ = 0;
-  std::unique_ptr<px::vizier::services::metadata::AgentInfoResponse> resp_;
+  std::shared_ptr<const AgentInfoResponse> resp_;
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
+  std::shared_ptr<MDSResponseCaches> response_caches_;
 };
 
 namespace internal {
@@ -569,6 +571,8 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
                 "The number of batches added to this table"),
         ColInfo("batches_expired", types::DataType::INT64, types::PatternType::GENERAL,
                 "The number of batches expired from this table"),
+        ColInfo("batches_dropped", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of batches dropped before reaching this table"),
         ColInfo("num_batches", types::DataType::INT64, types::PatternType::GENERAL,
                 "The number of batches active in this table"),
         ColInfo("size", types::DataType::INT64, types::PatternType::GENERAL,
@@ -595,6 +599,7 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
     rw->Append<IndexOf("id")>(selected_id);
     rw->Append<IndexOf("batches_added")>(info.batches_added);
     rw->Append<IndexOf("batches_expired")>(info.batches_expired);
+    rw->Append<IndexOf("batches_dropped")>(info.batches_dropped);
     rw->Append<IndexOf("num_batches")>(info.num_batches);
     rw->Append<IndexOf("size")>(info.bytes);
     rw->Append<IndexOf("max_table_size")>(info.max_table_size);
@@ -609,6 +614,41 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
   std::vector<uint64_t> table_ids_;
 };
 
+/**
+ * This UDTF dumps the internal counters of every agent, such as the reuse of its GRPC channels.
+ */
+class GetDebugAgentMetrics final : public carnot::udf::UDTF<GetDebugAgentMetrics> {
+ public:
+  GetDebugAgentMetrics() = delete;
+  explicit GetDebugAgentMetrics(std::map<std::string, int64_t> metrics)
+      : metrics_(std::move(metrics)), it_(metrics_.begin()) {}
+  static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(ColInfo("asid", types::DataType::INT64, types::PatternType::GENERAL,
+                             "The short ID of the agent"),
+                     ColInfo("name", types::DataType::STRING, types::PatternType::GENERAL,
+                             "The name of the metric"),
+                     ColInfo("value", types::DataType::INT64, types::PatternType::METRIC_COUNTER,
+                             "The value of the metric"));
+  }
+
+  bool NextRecord(FunctionContext* ctx, RecordWriter* rw) {
+    if (it_ == metrics_.end()) {
+      return false;
+    }
+    rw->Append<IndexOf("asid")>(ctx->metadata_state()->asid());
+    rw->Append<IndexOf("name")>(it_->first);
+    rw->Append<IndexOf("value")>(it_->second);
+    ++it_;
+    return it_ != metrics_.end();
+  }
+
+ private:
+  const std::map<std::string, int64_t> metrics_;
+  std::map<std::string, int64_t>::const_iterator it_;
+};
+
 /**
  * This UDTF fetches information about tracepoints from MDS.
  */
@@ -642,7 +682,9 @@ class GetTracepointStatus final : public carnot::udf::UDTF<GetTracepointStatus>
     px::vizier::services::metadata::GetTracepointInfoRequest req;
     resp_ = std::make_unique<px::vizier::services::metadata::GetTracepointInfoResponse>();
 
+    // Tracepoint states change while they are deployed, so this response isn't cached.
     grpc::ClientContext ctx;
+    ctx.set_deadline(std::chrono::system_clock::now() + kMDSRPCTimeout);
     add_context_authentication_func_(&ctx);
     auto s = stub_->GetTracepointInfo(&ctx, req, resp_.get());
     if (!s.ok()) {
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <absl/synchronization/mutex.h>
+#include <grpcpp/grpcpp.h>
+
+#include "src/common/base/base.h"
+#include "src/vizier/services/metadata/metadatapb/service.grpc.pb.h"
+
+namespace px {
+namespace vizier {
+namespace funcs {
+namespace md {
+
+// The deadline of the metadata service RPCs made by the UDTFs.
+constexpr std::chrono::seconds kMDSRPCTimeout{5};
+// How long a metadata service response is reused across UDTF instances.
+constexpr std::chrono::seconds kMDSResponseCacheTTL{2};
+
+/**
+ * MDSResponseCache keeps the response of a metadata service RPC for a short time.
+ *
+ * A UDTF is instantiated for every script execution, and the UI runs several scripts that make
+ * the same RPCs on every page load. The cache lets those share a single response. Concurrent
+ * misses are serialized, so only one of them makes the RPC and the others reuse its response.
+ */
+template <typename TResponse>
+class MDSResponseCache : public NotCopyable {
+ public:
+  using FetchFunc = std::function<grpc::Status(grpc::ClientContext*, TResponse*)>;
+
+  MDSResponseCache(std::string rpc_name, std::chrono::milliseconds ttl)
+      : rpc_name_(std::move(rpc_name)), ttl_(ttl) {}
+
+  /**
+   * Returns the cached response if it is recent enough, otherwise calls fetch to get a new one.
+   * fetch is given a client context that has the RPC deadline set.
+   */
+  StatusOr<std::shared_ptr<const TResponse>> Get(const FetchFunc& fetch) {
+    absl::MutexLock lock(&mu_);
+    auto now = std::chrono::steady_clock::now();
+    if (resp_ != nullptr && now - fetch_time_ < ttl_) {
+      return resp_;
+    }
+
+    grpc::ClientContext ctx;
+    ctx.set_deadline(std::chrono::system_clock::now() + kMDSRPCTimeout);
+    auto resp = std::make_shared<TResponse>();
+    grpc::Status s = fetch(&ctx, resp.get());
+    if (!s.ok()) {
+      return error::Internal("Failed to make RPC call to $0: $1", rpc_name_, s.error_message());
+    }
+    resp_ = std::move(resp);
+    fetch_time_ = now;
+    return resp_;
+  }
+
+ private:
+  const std::string rpc_name_;
+  const std::chrono::milliseconds ttl_;
+
+  absl::Mutex mu_;
+  std::shared_ptr<const TResponse> resp_ ABSL_GUARDED_BY(mu_);
+  std::chrono::steady_clock::time_point fetch_time_ ABSL_GUARDED_BY(mu_);
+};
+
+/**
+ * The response caches shared by the metadata service UDTFs of a registry.
+ */
+struct MDSResponseCaches {
+  MDSResponseCache<services::metadata::SchemaResponse> schemas{"GetSchemas",
+                                                              kMDSResponseCacheTTL};
+  MDSResponseCache<services::metadata::AgentInfoResponse> agent_info{"GetAgentInfo",
+                                                                    kMDSResponseCacheTTL};
+};
+
+}  // namespace md
+}  // namespace funcs
+}  // namespace vizier
+}  // namespace px
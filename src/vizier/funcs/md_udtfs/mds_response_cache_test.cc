@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/funcs/md_udtfs/mds_response_cache.h"
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace vizier {
+namespace funcs {
+namespace md {
+
+using services::metadata::AgentInfoResponse;
+
+class MDSResponseCacheTest : public ::testing::Test {
+ protected:
+  // Returns a response with as many agents as the number of fetches so far.
+  grpc::Status Fetch(grpc::ClientContext*, AgentInfoResponse* resp) {
+    ++num_fetches_;
+    for (int i = 0; i < num_fetches_; ++i) {
+      resp->add_info();
+    }
+    return grpc::Status::OK;
+  }
+
+  MDSResponseCache<AgentInfoResponse>::FetchFunc fetch_ =
+      std::bind(&MDSResponseCacheTest::Fetch, this, std::placeholders::_1, std::placeholders::_2);
+  int num_fetches_ = 0;
+};
+
+TEST_F(MDSResponseCacheTest, ReusesResponseUntilExpired) {
+  MDSResponseCache<AgentInfoResponse> cache("GetAgentInfo", std::chrono::milliseconds(100));
+
+  ASSERT_OK_AND_ASSIGN(auto resp, cache.Get(fetch_));
+  EXPECT_EQ(resp->info_size(), 1);
+  ASSERT_OK_AND_ASSIGN(auto cached_resp, cache.Get(fetch_));
+  EXPECT_EQ(cached_resp, resp);
+  EXPECT_EQ(num_fetches_, 1);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  ASSERT_OK_AND_ASSIGN(auto new_resp, cache.Get(fetch_));
+  EXPECT_EQ(new_resp->info_size(), 2);
+  EXPECT_EQ(num_fetches_, 2);
+  // Responses handed out before stay valid.
+  EXPECT_EQ(resp->info_size(), 1);
+}
+
+TEST_F(MDSResponseCacheTest, DoesNotCacheFailures) {
+  MDSResponseCache<AgentInfoResponse> cache("GetAgentInfo", std::chrono::seconds(10));
+
+  auto failing_fetch = [this](grpc::ClientContext*, AgentInfoResponse*) {
+    ++num_fetches_;
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE, "metadata service is down");
+  };
+  EXPECT_NOT_OK(cache.Get(failing_fetch));
+  EXPECT_NOT_OK(cache.Get(failing_fetch));
+  EXPECT_EQ(num_fetches_, 2);
+
+  ASSERT_OK_AND_ASSIGN(auto resp, cache.Get(fetch_));
+  EXPECT_EQ(resp->info_size(), 3);
+}
+
+TEST_F(MDSResponseCacheTest, SetsRPCDeadline) {
+  MDSResponseCache<AgentInfoResponse> cache("GetAgentInfo", std::chrono::seconds(10));
+
+  std::chrono::system_clock::time_point deadline;
+  auto start = std::chrono::system_clock::now();
+  ASSERT_OK(cache.Get([&deadline](grpc::ClientContext* ctx, AgentInfoResponse*) {
+    deadline = ctx->deadline();
+    return grpc::Status::OK;
+  }));
+
+  EXPECT_GE(deadline, start + kMDSRPCTimeout);
+  EXPECT_LE(deadline, std::chrono::system_clock::now() + kMDSRPCTimeout);
+}
+
+}  // namespace md
+}  // namespace funcs
+}  // namespace vizier
+}  // namespace px
@@ -28,16 +28,35 @@ std::shared_ptr<::grpc::Channel> ChanCache::GetChan(std::string_view remote_addr
   absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
   auto it = chan_cache_.find(remote_addr);
   if (it == chan_cache_.end()) {
+    ++stats_.misses;
     return nullptr;
   }
+  ++stats_.hits;
+  it->second.last_used_time = std::chrono::system_clock::now();
   return it->second.chan;
 }
 
 void ChanCache::Add(std::string remote_addr, std::shared_ptr<::grpc::Channel> chan) {
   absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
+  if (!chan_cache_.contains(remote_addr) && chan_cache_.size() >= max_size_ &&
+      !chan_cache_.empty()) {
+    auto lru = chan_cache_.begin();
+    for (auto it = chan_cache_.begin(); it != chan_cache_.end(); ++it) {
+      if (it->second.last_used_time < lru->second.last_used_time) {
+        lru = it;
+      }
+    }
+    chan_cache_.erase(lru);
+    ++stats_.evictions;
+  }
   chan_cache_[remote_addr] = {chan, std::chrono::system_clock::now()};
 }
 
+ChanCache::Stats ChanCache::stats() {
+  absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
+  return stats_;
+}
+
 Status ChanCache::CleanupChans() {
   absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
   std::vector<std::string> remote_addrs_to_delete;
@@ -50,20 +69,24 @@ Status ChanCache::CleanupChans() {
       remote_addrs_to_delete.push_back(remote_addr);
       continue;
     }
-    std::chrono::nanoseconds age = time_now - chan.start_time;
-    // If the age of the channel is still warming up, we don't kill it for being idle.
-    if (age < warm_up_period_) {
+    if (state != grpc_connectivity_state::GRPC_CHANNEL_IDLE) {
       continue;
     }
-
-    if (state == grpc_connectivity_state::GRPC_CHANNEL_IDLE) {
-      remote_addrs_to_delete.push_back(remote_addr);
+    std::chrono::nanoseconds age = time_now - chan.last_used_time;
+    // If the channel is still warming up or was used recently, we don't kill it for being idle.
+    // Instead we start reconnecting it, so it's ready before its next use.
+    if (age < warm_up_period_) {
+      chan.chan->GetState(/*try_to_connect*/ true);
+      ++stats_.reconnects;
+      continue;
     }
+    remote_addrs_to_delete.push_back(remote_addr);
   }
 
   for (const std::string& remote_addr : remote_addrs_to_delete) {
     chan_cache_.erase(remote_addr);
   }
+  stats_.evictions += remote_addrs_to_delete.size();
   return Status::OK();
 }
 
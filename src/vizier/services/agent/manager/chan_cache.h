@@ -32,21 +32,45 @@ namespace px {
 namespace vizier {
 namespace agent {
 
+// The default maximum number of channels to keep. Beyond it, the least recently used channel is
+// evicted.
+constexpr size_t kDefaultMaxCachedChans = 256;
+
 class ChanCache {
  public:
+  /**
+   * Counters of how the cache has been used, to track the reuse rate of the channels.
+   */
+  struct Stats {
+    // GetChan calls that found a cached channel.
+    int64_t hits = 0;
+    // GetChan calls that didn't.
+    int64_t misses = 0;
+    // Channels removed because the cache was full, or by CleanupChans.
+    int64_t evictions = 0;
+    // Idle channels reconnected by CleanupChans because they were used recently.
+    int64_t reconnects = 0;
+  };
+
   /**
    * @brief Construct a new ChanChache.
    *
-   * @param warm_up_period the period to wait in a Channel's lifetime before we declare an idle
-   * channel to be out of use. This is in place to prevent a race where we add a Chan and
+   * @param warm_up_period the period since a Channel was added or last used before we declare an
+   * idle channel to be out of use. This is in place to prevent a race where we add a Chan and
    * CleanupChans() is called before the Connection can be used, meaning the channel will come up
-   * idle.
+   * idle. Idle channels used within this period are reconnected instead, so that the next query
+   * to their destination doesn't wait on a connection handshake.
+   * @param max_size the maximum number of channels to cache.
    */
-  explicit ChanCache(std::chrono::nanoseconds warm_up_period) : warm_up_period_(warm_up_period) {}
+  explicit ChanCache(std::chrono::nanoseconds warm_up_period,
+                     size_t max_size = kDefaultMaxCachedChans)
+      : warm_up_period_(warm_up_period), max_size_(max_size) {}
   // Template to handle other duration types.
   template <typename T>
-  explicit ChanCache(std::chrono::duration<int64_t, T> warm_up_period)
-      : ChanCache(std::chrono::duration_cast<std::chrono::nanoseconds>(warm_up_period)) {}
+  explicit ChanCache(std::chrono::duration<int64_t, T> warm_up_period,
+                     size_t max_size = kDefaultMaxCachedChans)
+      : ChanCache(std::chrono::duration_cast<std::chrono::nanoseconds>(warm_up_period),
+                  max_size) {}
   /**
    * @brief Gets the Chan at remote_addr. If the cache doesn't contain the channel, it returns a
    * nullptr.
@@ -57,7 +81,8 @@ class ChanCache {
   std::shared_ptr<::grpc::Channel> GetChan(std::string_view remote_addr);
 
   /**
-   * @brief Caches `chan` for the `remote_addr`.
+   * @brief Caches `chan` for the `remote_addr`. If the cache is full, the least recently used
+   * channel is evicted.
    *
    * @param remote_addr the remote address corresponding to the channel.
    * @param chan the channel to cache.
@@ -76,10 +101,13 @@ class ChanCache {
    */
   Status CleanupChans();
 
+  Stats stats();
+
  private:
   struct Channel {
     std::shared_ptr<::grpc::Channel> chan;
-    std::chrono::system_clock::time_point start_time;
+    // When the channel was added or last returned by GetChan.
+    std::chrono::system_clock::time_point last_used_time;
   };
 
   // The cache of channels (grpc conns) made to other agents.
@@ -87,6 +115,8 @@ class ChanCache {
   absl::base_internal::SpinLock chan_cache_lock_;
   // Connections that are alive for shorter than warm_up_period_ won't be cleared.
   std::chrono::nanoseconds warm_up_period_;
+  size_t max_size_;
+  Stats stats_ GUARDED_BY(chan_cache_lock_);
 };
 }  // namespace agent
 }  // namespace vizier
@@ -171,6 +171,32 @@ TEST_F(ChanCacheTest, channel_idleness_triggers_gc) {
   EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), nullptr);
 }
 
+TEST_F(ChanCacheTest, evicts_least_recently_used_and_counts_reuse) {
+  ChanCache chan_cache(std::chrono::minutes(5), /*max_size*/ 2);
+  auto other_address0 = absl::Substitute("$0:$1", hostname, port_ + 1);
+  auto other_address1 = absl::Substitute("$0:$1", hostname, port_ + 2);
+  auto channel = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  auto other_channel0 = grpc::CreateChannel(other_address0, InsecureChannelCredentials());
+  auto other_channel1 = grpc::CreateChannel(other_address1, InsecureChannelCredentials());
+
+  chan_cache.Add(GetServerAddress(), channel);
+  TestSleep(1);
+  chan_cache.Add(other_address0, other_channel0);
+  TestSleep(1);
+  // Using the first channel makes other_channel0 the least recently used one.
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel);
+  chan_cache.Add(other_address1, other_channel1);
+
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel);
+  EXPECT_EQ(chan_cache.GetChan(other_address0), nullptr);
+  EXPECT_EQ(chan_cache.GetChan(other_address1), other_channel1);
+
+  auto stats = chan_cache.stats();
+  EXPECT_EQ(stats.hits, 3);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.evictions, 1);
+}
+
 }  // namespace agent
 }  // namespace vizier
 }  // namespace px
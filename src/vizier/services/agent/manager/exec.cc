@@ -29,11 +29,30 @@
 #include "src/common/perf/perf.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_string(query_exec_cpus, gflags::StringFromEnv("PL_QUERY_EXEC_CPUS", ""),
+              "The CPUs that queries execute on, in cpulist format (e.g. '4-7'). On multi-socket "
+              "nodes, pick the CPUs of one NUMA node. All CPUs if empty.");
+
 namespace px {
 namespace vizier {
 namespace agent {
 
 using ::px::event::AsyncTask;
+using ::px::event::TaskPriority;
+
+namespace {
+// Streaming queries run until they are cancelled, so they shouldn't hold up one-off queries.
+bool IsStreamingPlan(const carnot::planpb::Plan& plan) {
+  for (const auto& fragment : plan.nodes()) {
+    for (const auto& node : fragment.nodes()) {
+      if (node.op().has_mem_source_op() && node.op().mem_source_op().streaming()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+}  // namespace
 
 class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
  public:
@@ -43,11 +62,22 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
         carnot_(carnot),
         msg_(std::move(msg)),
         req_(msg_->execute_query_request()),
-        query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()) {}
+        query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()),
+        priority_(IsStreamingPlan(req_.plan()) ? TaskPriority::kBackground
+                                               : TaskPriority::kInteractive) {}
 
   sole::uuid query_id() { return query_id_; }
 
+  TaskPriority priority() const override { return priority_; }
+
   void Work() override {
+    // The dispatcher's pool threads are shared by all async tasks, so the thread is pinned by
+    // each query rather than once.
+    Status pin_status = SetCurrentThreadCPUs(FLAGS_query_exec_cpus);
+    if (!pin_status.ok()) {
+      LOG_FIRST_N(WARNING, 1) << absl::Substitute("Failed to pin query thread: $0",
+                                                  pin_status.msg());
+    }
     LOG(INFO) << absl::Substitute("Executing query: id=$0", query_id_.str());
     VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
 
@@ -73,6 +103,7 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
   std::unique_ptr<messages::VizierMessage> msg_;
   const messages::ExecuteQueryRequest& req_;
   sole::uuid query_id_;
+  TaskPriority priority_;
 };
 
 ExecuteQueryMessageHandler::ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher,
@@ -86,9 +117,14 @@ Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::Vizie
   auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg));
 
   auto query_id = task->query_id();
+  auto priority = task->priority();
   auto runnable = dispatcher()->CreateAsyncTask(std::move(task));
   auto runnable_ptr = runnable.get();
-  LOG(INFO) << "Queries in flight: " << running_queries_.size();
+  auto queue_time_stats = dispatcher()->GetTaskQueueTimeStats(priority);
+  LOG(INFO) << absl::Substitute(
+      "Queries in flight: $0, queue time of $1 tasks p50=$2us p99=$3us max=$4us",
+      running_queries_.size(), magic_enum::enum_name(priority),
+      queue_time_stats.p50.count(), queue_time_stats.p99.count(), queue_time_stats.max.count());
   running_queries_[query_id] = std::move(runnable);
   runnable_ptr->Run();
 
@@ -34,12 +34,14 @@ using ::px::shared::k8s::metadatapb::ResourceUpdate;
 HeartbeatMessageHandler::HeartbeatMessageHandler(Dispatcher* d,
                                                  px::md::AgentMetadataStateManager* mds_manager,
                                                  RelationInfoManager* relation_info_manager,
+                                                 table_store::TableStore* table_store,
                                                  Info* agent_info,
                                                  Manager::VizierNATSConnector* nats_conn)
     : MessageHandler(d, agent_info, nats_conn),
       time_source_(dispatcher()->GetTimeSource()),
       mds_manager_(mds_manager),
       relation_info_manager_(relation_info_manager),
+      table_store_(table_store),
       heartbeat_send_timer_(
           dispatcher()->CreateTimer(std::bind(&HeartbeatMessageHandler::SendHeartbeat, this))),
       heartbeat_watchdog_timer_(
@@ -50,6 +52,7 @@ HeartbeatMessageHandler::HeartbeatMessageHandler(Dispatcher* d,
 void HeartbeatMessageHandler::DisableHeartbeats() {
   last_metadata_epoch_id_ = 0;
   sent_schema_ = false;
+  last_table_info_time_ = {};
   heartbeat_send_timer_->DisableTimer();
   heartbeat_watchdog_timer_->DisableTimer();
 }
@@ -111,12 +114,36 @@ Status HeartbeatMessageHandler::SendHeartbeatInternal() {
     last_metadata_epoch_id_ = current_epoch;
   }
 
+  auto now = time_source_.MonotonicTime();
+  if (agent_info()->capabilities.collects_data() &&
+      now - last_table_info_time_ >= kTableInfoInterval) {
+    AddTableInfo(update_info->mutable_data());
+    last_table_info_time_ = now;
+  }
+
   VLOG(1) << "Sending heartbeat message: " << req.DebugString();
   heartbeat_info_.last_heartbeat_send_time_ = time_source_.MonotonicTime();
 
   return nats_conn()->Publish(req);
 }
 
+void HeartbeatMessageHandler::AddTableInfo(messages::AgentDataInfo* data_info) {
+  for (const auto& [table_name, relation] : *table_store_->GetRelationMap()) {
+    table_store::Table* table = table_store_->GetTable(table_name);
+    if (table == nullptr) {
+      continue;
+    }
+    auto stats = table->GetTableStats();
+    auto* table_info = data_info->add_table_info();
+    table_info->set_table(table_name);
+    table_info->set_size_bytes(stats.bytes);
+    // A table without rows reports -1, which is left as 0 so that the planner never prunes it.
+    if (stats.min_time > 0) {
+      table_info->set_min_time(stats.min_time);
+    }
+  }
+}
+
 void HeartbeatMessageHandler::HeartbeatWatchdog() {
   if (heartbeat_info_.last_ackd_seq_num < heartbeat_info_.last_sent_seq_num) {
     auto diff = time_source_.MonotonicTime() - heartbeat_info_.last_heartbeat_send_time_;
@@ -130,7 +157,7 @@ void HeartbeatMessageHandler::HeartbeatWatchdog() {
 
 Status HeartbeatMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
   CHECK(msg->has_heartbeat_ack());
-  auto ack = msg->heartbeat_ack();
+  const auto& ack = msg->heartbeat_ack();
   heartbeat_info_.last_ackd_seq_num = ack.sequence_number();
 
   auto time_delta = time_source_.MonotonicTime() - heartbeat_info_.last_heartbeat_send_time_;
@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
+#include "src/table_store/table_store.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
 namespace px {
@@ -31,7 +33,8 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   HeartbeatMessageHandler() = delete;
   HeartbeatMessageHandler(px::event::Dispatcher* dispatcher,
                           px::md::AgentMetadataStateManager* mds_manager,
-                          RelationInfoManager* relation_info_manager, Info* agent_info,
+                          RelationInfoManager* relation_info_manager,
+                          table_store::TableStore* table_store, Info* agent_info,
                           Manager::VizierNATSConnector* nats_conn);
 
   ~HeartbeatMessageHandler() override = default;
@@ -48,6 +51,8 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   void ProcessPIDTerminatedEvent(const px::md::PIDTerminatedEvent& ev,
                                  messages::AgentUpdateInfo* update_info);
 
+  void AddTableInfo(messages::AgentDataInfo* data_info);
+
   void DoHeartbeats();
 
   void SendHeartbeat();
@@ -64,11 +69,13 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   std::unique_ptr<px::vizier::messages::VizierMessage> last_sent_hb_;
   int64_t last_metadata_epoch_id_ = 0;
   bool sent_schema_ = false;
+  std::chrono::steady_clock::time_point last_table_info_time_;
 
   HeartbeatInfo heartbeat_info_;
   const px::event::TimeSource& time_source_;
   px::md::AgentMetadataStateManager* mds_manager_;
   RelationInfoManager* relation_info_manager_;
+  table_store::TableStore* table_store_;
   std::chrono::duration<double> heartbeat_latency_moving_average_{0};
 
   px::event::TimerUPtr heartbeat_send_timer_;
@@ -77,6 +84,8 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   static constexpr double kHbLatencyDecay = 0.25;
 
   static constexpr std::chrono::seconds kAgentHeartbeatInterval{5};
+  // The table stats change with every write, so they are sent less often than the heartbeats.
+  static constexpr std::chrono::seconds kTableInfoInterval{30};
   static constexpr int kHeartbeatRetryCount = 5;
   // The amount of time to wait for a heartbeat ack.
   static constexpr std::chrono::milliseconds kHeartbeatWaitMillis{5000};
@@ -29,6 +29,8 @@
 #include "src/common/testing/event/simulated_time_system.h"
 #include "src/common/testing/testing.h"
 #include "src/shared/metadatapb/metadata.pb.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table_store.h"
 #include "src/vizier/messages/messagespb/messages.pb.h"
 #include "src/vizier/services/agent/manager/heartbeat.h"
 #include "src/vizier/services/agent/manager/manager.h"
@@ -134,12 +136,25 @@ class HeartbeatMessageHandlerTest : public ::testing::Test {
       EXPECT_OK(relation_info_manager_->AddRelationInfo(relation_info));
     }
 
+    table_ = table_store::Table::Create(relation0);
+    table_store_ = std::make_unique<table_store::TableStore>();
+    table_store_->AddTable(table_, "relation0");
+
     agent_info_ = agent::Info{};
     agent_info_.capabilities.set_collects_data(true);
 
     heartbeat_handler_ = std::make_unique<HeartbeatMessageHandler>(
-        dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), &agent_info_,
-        nats_conn_.get());
+        dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), table_store_.get(),
+        &agent_info_, nats_conn_.get());
+  }
+
+  void WriteRows(const std::vector<types::Time64NSValue>& times,
+                 const std::vector<types::Int64Value>& counts) {
+    table_store::schema::RowDescriptor rd({types::TIME64NS, types::INT64});
+    table_store::schema::RowBatch rb(rd, times.size());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(counts, arrow::default_memory_pool())));
+    EXPECT_OK(table_->WriteRowBatch(rb));
   }
 
   void CheckFilterElements(const messages::AgentDataInfo& data_info,
@@ -161,6 +176,8 @@ class HeartbeatMessageHandlerTest : public ::testing::Test {
   std::unique_ptr<event::Dispatcher> dispatcher_;
   std::unique_ptr<FakeAgentMetadataStateManager> mds_manager_;
   std::unique_ptr<RelationInfoManager> relation_info_manager_;
+  std::shared_ptr<table_store::Table> table_;
+  std::unique_ptr<table_store::TableStore> table_store_;
   std::unique_ptr<HeartbeatMessageHandler> heartbeat_handler_;
   std::unique_ptr<FakeNATSConnector<px::vizier::messages::VizierMessage>> nats_conn_;
   agent::Info agent_info_;
@@ -248,6 +265,26 @@ TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatMetadataChange) {
                       {"pl/another_service_2"});
 }
 
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatMetadataReinsert) {
+  // Re-inserting an entity that is already in the filter shouldn't resend the metadata info.
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1, nats_conn_->published_msgs().size());
+
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(0);
+  EXPECT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  EXPECT_OK(md_filter_->InsertEntity(md::MetadataType::SERVICE_NAME, "pl/service"));
+
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(5 * 1000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+
+  EXPECT_EQ(2, nats_conn_->published_msgs().size());
+  auto hb = nats_conn_->published_msgs()[1].heartbeat();
+  EXPECT_EQ(1, hb.sequence_number());
+  EXPECT_FALSE(hb.update_info().data().has_metadata_info());
+}
+
 TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatMetadataAfterDisable) {
   // Even if the metadata info didn't change, if the heartbeat was disabled then re-enabled,
   // the metadata info should be resent.
@@ -310,6 +347,43 @@ TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatRelationUpdates) {
   EXPECT_EQ(3, hb.update_info().schema().size());
 }
 
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatTableInfo) {
+  WriteRows({1, 2, 3}, {10, 20, 30});
+
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1, nats_conn_->published_msgs().size());
+  auto hb = nats_conn_->published_msgs()[0].heartbeat();
+  ASSERT_EQ(1, hb.update_info().data().table_info_size());
+  const auto& table_info = hb.update_info().data().table_info(0);
+  EXPECT_EQ("relation0", table_info.table());
+  EXPECT_EQ(table_->GetTableStats().bytes, table_info.size_bytes());
+  EXPECT_EQ(1, table_info.min_time());
+
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(0);
+  EXPECT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  // The table info isn't resent on the next heartbeat.
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(5 * 1000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(2, nats_conn_->published_msgs().size());
+  hb = nats_conn_->published_msgs()[1].heartbeat();
+  EXPECT_EQ(0, hb.update_info().data().table_info_size());
+
+  hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(1);
+  EXPECT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  // It is resent once the table info interval has passed.
+  WriteRows({4, 5}, {40, 50});
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::milliseconds(30 * 1000 + 1));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(3, nats_conn_->published_msgs().size());
+  hb = nats_conn_->published_msgs()[2].heartbeat();
+  ASSERT_EQ(1, hb.update_info().data().table_info_size());
+  EXPECT_EQ(table_->GetTableStats().bytes, hb.update_info().data().table_info(0).size_bytes());
+}
+
 class HeartbeatNackMessageHandlerTest : public ::testing::Test {
  protected:
   void TearDown() override { dispatcher_->Exit(); }
@@ -18,6 +18,7 @@
 
 #include "src/vizier/services/agent/manager/k8s_update.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -36,65 +37,90 @@ K8sUpdateHandler::K8sUpdateHandler(Dispatcher* d, px::md::AgentMetadataStateMana
       update_selector_(update_selector),
       missing_metadata_request_timer_(
           dispatcher()->CreateTimer(std::bind(&K8sUpdateHandler::RequestMissingMetadata, this))),
-      update_backlog_([](const ResourceUpdate& left, const ResourceUpdate& right) {
-        return left.update_version() > right.update_version();
-      }),
       max_update_queue_size_(max_update_queue_size) {
   // Request the initial backlog of missing metadata.
   missing_metadata_request_timer_->EnableTimer(std::chrono::milliseconds(0));
 }
 
-Status K8sUpdateHandler::AddK8sUpdate(const ResourceUpdate& update) {
-  current_update_version_ = update.update_version();
-  return mds_manager_->AddK8sUpdate(std::make_unique<ResourceUpdate>(update));
+namespace {
+bool LaterUpdate(const std::unique_ptr<ResourceUpdate>& left,
+                 const std::unique_ptr<ResourceUpdate>& right) {
+  return left->update_version() > right->update_version();
 }
+}  // namespace
 
-Status K8sUpdateHandler::HandleMissingK8sMetadataResponse(const MissingK8sMetadataResponse& resp) {
-  if (resp.updates().size() > 0) {
-    auto first_update = resp.updates()[0];
+void K8sUpdateHandler::PushBacklog(std::unique_ptr<ResourceUpdate> update) {
+  update_backlog_.push_back(std::move(update));
+  std::push_heap(update_backlog_.begin(), update_backlog_.end(), LaterUpdate);
+}
+
+std::unique_ptr<ResourceUpdate> K8sUpdateHandler::PopBacklog() {
+  std::pop_heap(update_backlog_.begin(), update_backlog_.end(), LaterUpdate);
+  auto update = std::move(update_backlog_.back());
+  update_backlog_.pop_back();
+  return update;
+}
+
+Status K8sUpdateHandler::AddK8sUpdate(std::unique_ptr<ResourceUpdate> update) {
+  current_update_version_ = update->update_version();
+  pending_updates_.push_back(std::move(update));
+  return Status::OK();
+}
+
+Status K8sUpdateHandler::FlushK8sUpdates() {
+  if (pending_updates_.empty()) {
+    return Status::OK();
+  }
+  std::vector<std::unique_ptr<ResourceUpdate>> updates;
+  updates.swap(pending_updates_);
+  return mds_manager_->AddK8sUpdates(std::move(updates));
+}
+
+Status K8sUpdateHandler::HandleMissingK8sMetadataResponse(MissingK8sMetadataResponse* resp) {
+  if (resp->updates_size() > 0) {
+    const auto& first_update = resp->updates(0);
     // If the metadata service tells us that update N is the earliest update it has,
     // then we should consider that the new starting point, even if we are at an update
     // smaller than N-1.
     if (current_update_version_ < first_update.update_version() &&
-        first_update.update_version() == resp.first_update_available()) {
+        first_update.update_version() == resp->first_update_available()) {
       current_update_version_ = first_update.prev_update_version();
     }
   }
 
-  if (resp.updates().size() == 0 && update_backlog_.size() > 0) {
+  if (resp->updates_size() == 0 && update_backlog_.size() > 0) {
     // If our backlog now predates the earliest updates known by the metadata service,
     // we need to write out the backlog, and stop trying to find missing updates that
     // no longer exist in the metadata service.
-    if (resp.first_update_available() >= update_backlog_.top().update_version()) {
-      current_update_version_ = update_backlog_.top().prev_update_version();
+    if (resp->first_update_available() >= update_backlog_.front()->update_version()) {
+      current_update_version_ = update_backlog_.front()->prev_update_version();
     }
   }
 
-  for (const auto& update : resp.updates()) {
-    PL_RETURN_IF_ERROR(HandleK8sUpdate(update));
+  for (auto& update : *resp->mutable_updates()) {
+    PL_RETURN_IF_ERROR(HandleK8sUpdate(std::make_unique<ResourceUpdate>(std::move(update))));
   }
 
   // Check and flush backlog.
   // if backlog is done, disable timer
   while (update_backlog_.size()) {
-    auto next = update_backlog_.top();
     // Break out of the loop if the backlog is still ahead of the
     // current resource version.
-    if (current_update_version_ < next.prev_update_version()) {
+    if (current_update_version_ < update_backlog_.front()->prev_update_version()) {
       break;
     }
 
+    auto next = PopBacklog();
     // If this is the update that we need, then add it.
-    if (current_update_version_ == next.prev_update_version()) {
-      PL_RETURN_IF_ERROR(AddK8sUpdate(next));
+    if (current_update_version_ == next->prev_update_version()) {
+      PL_RETURN_IF_ERROR(AddK8sUpdate(std::move(next)));
     }
-    update_backlog_.pop();
   }
 
   // Check to see if we have now received the initial batch of metadata, after startup.
   if (!initial_metadata_received_) {
     // Check to see if we have received the full batch of initial metadata.
-    if (current_update_version_ >= resp.last_update_available()) {
+    if (current_update_version_ >= resp->last_update_available()) {
       initial_metadata_received_ = true;
     }
   }
@@ -107,7 +133,7 @@ Status K8sUpdateHandler::HandleMissingK8sMetadataResponse(const MissingK8sMetada
   // empty will suffice.
   // If we are still waiting on data, then the timer will go off eventually and the missing
   // metadata will be re-requested.
-  if (initial_metadata_received_ && !update_backlog_.size()) {
+  if (initial_metadata_received_ && update_backlog_.empty()) {
     missing_metadata_request_timer_->DisableTimer();
   }
 
@@ -136,7 +162,7 @@ void K8sUpdateHandler::RequestMissingMetadata() {
   // Keep this as a 0 if we don't know the upper bound of the range we are asking for.
   // Note: requesting [from: 0, to: 0) is the same as requesting all
   if (update_backlog_.size()) {
-    req->set_to_update_version(update_backlog_.top().update_version());
+    req->set_to_update_version(update_backlog_.front()->update_version());
   }
 
   auto s = nats_conn()->Publish(msg);
@@ -150,22 +176,22 @@ void K8sUpdateHandler::RequestMissingMetadata() {
   missing_metadata_request_timer_->EnableTimer(kMissingMetadataTimeout);
 }
 
-Status K8sUpdateHandler::HandleK8sUpdate(const ResourceUpdate& update) {
-  if (current_update_version_ == update.prev_update_version()) {
-    return AddK8sUpdate(update);
+Status K8sUpdateHandler::HandleK8sUpdate(std::unique_ptr<ResourceUpdate> update) {
+  if (current_update_version_ == update->prev_update_version()) {
+    return AddK8sUpdate(std::move(update));
   }
 
   // This was probably a duplicate, ignore.
-  if (current_update_version_ > update.prev_update_version()) {
+  if (current_update_version_ > update->prev_update_version()) {
     return Status::OK();
   }
 
   // If this update is further along than we expect, add it to the backlog.
-  update_backlog_.push(update);
+  PushBacklog(std::move(update));
   // Keep the most recent updates so that we know how far ahead the mds is.
   // Re-request updates that we dropped once we catch up.
   if (update_backlog_.size() > max_update_queue_size_) {
-    update_backlog_.pop();
+    PopBacklog();
   }
 
   // If we have missing metadata (which we do if we have reached this part of the
@@ -180,17 +206,22 @@ Status K8sUpdateHandler::HandleK8sUpdate(const ResourceUpdate& update) {
 
 Status K8sUpdateHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
   LOG_IF(FATAL, !msg->has_k8s_metadata_message()) << "Expected K8sMetadataMessage";
-  auto k8s_msg = msg->k8s_metadata_message();
-
-  if (k8s_msg.has_k8s_metadata_update()) {
-    return HandleK8sUpdate(k8s_msg.k8s_metadata_update());
-  }
-  if (k8s_msg.has_missing_k8s_metadata_response()) {
-    return HandleMissingK8sMetadataResponse(k8s_msg.missing_k8s_metadata_response());
-  }
-
-  return error::Internal(
-      "Expected either ResourceUpdate or MissingK8sMetadataResponse in K8sMetadataMessage");
+  auto* k8s_msg = msg->mutable_k8s_metadata_message();
+
+  Status s;
+  if (k8s_msg->has_k8s_metadata_update()) {
+    s = HandleK8sUpdate(std::unique_ptr<ResourceUpdate>(k8s_msg->release_k8s_metadata_update()));
+  } else if (k8s_msg->has_missing_k8s_metadata_response()) {
+    s = HandleMissingK8sMetadataResponse(k8s_msg->mutable_missing_k8s_metadata_response());
+  } else {
+    return error::Internal(
+        "Expected either ResourceUpdate or MissingK8sMetadataResponse in K8sMetadataMessage");
+  }
+
+  // Pass on the updates that were accepted, even if handling the rest of the message failed, since
+  // the current update version already includes them.
+  PL_RETURN_IF_ERROR(FlushK8sUpdates());
+  return s;
 }
 
 }  // namespace agent
@@ -18,10 +18,9 @@
 
 #pragma once
 
-#include <deque>
 #include <memory>
-#include <queue>
 #include <string>
+#include <vector>
 
 #include "src/vizier/services/agent/manager/manager.h"
 
@@ -52,9 +51,14 @@ class K8sUpdateHandler : public Manager::MessageHandler {
   Status HandleMessage(std::unique_ptr<messages::VizierMessage> msg) override;
 
  private:
-  Status HandleMissingK8sMetadataResponse(const MissingK8sMetadataResponse& update);
-  Status HandleK8sUpdate(const ResourceUpdate& update);
-  Status AddK8sUpdate(const ResourceUpdate& update);
+  // The handlers take ownership of the updates in the message, so that they can be passed on to the
+  // state manager without being copied.
+  Status HandleMissingK8sMetadataResponse(MissingK8sMetadataResponse* resp);
+  Status HandleK8sUpdate(std::unique_ptr<ResourceUpdate> update);
+  Status AddK8sUpdate(std::unique_ptr<ResourceUpdate> update);
+  Status FlushK8sUpdates();
+  void PushBacklog(std::unique_ptr<ResourceUpdate> update);
+  std::unique_ptr<ResourceUpdate> PopBacklog();
   void RequestMissingMetadata();
 
   px::md::AgentMetadataStateManager* mds_manager_;
@@ -67,14 +71,17 @@ class K8sUpdateHandler : public Manager::MessageHandler {
   bool initial_metadata_received_ = false;
   int64_t current_update_version_ = 0;
 
+  // The in-order updates of the message being handled. They are passed to the state manager as a
+  // single batch, so that all of them are applied in the same state update.
+  std::vector<std::unique_ptr<ResourceUpdate>> pending_updates_;
+
   // Logic for re-requesting missing metadata.
   px::event::TimerUPtr missing_metadata_request_timer_;
   static constexpr std::chrono::seconds kMissingMetadataTimeout{5};
 
-  // logic/variables for the backlog update queue.
-  std::priority_queue<ResourceUpdate, std::deque<ResourceUpdate>,
-                      std::function<bool(ResourceUpdate, ResourceUpdate)>>
-      update_backlog_;
+  // logic/variables for the backlog update queue. This is a min-heap on the update version, kept
+  // as a vector (instead of a std::priority_queue) so that the top update can be moved out.
+  std::vector<std::unique_ptr<ResourceUpdate>> update_backlog_;
   const size_t max_update_queue_size_;
   static constexpr size_t kDefaultMaxUpdateBacklogQueueSize{1000};
 };
@@ -263,6 +263,8 @@ TEST_F(K8sUpdateHandlerTest, RequestMissingK8sUpdates) {
   ASSERT_OK(k8s_update_handler_->HandleMessage(std::move(sent_missing)));
   // Check that backlog is flushed.
   EXPECT_EQ(6, fake_mds_manager_->num_k8s_updates());
+  // The response and the flushed backlog are added as a single batch.
+  EXPECT_EQ(3, fake_mds_manager_->num_k8s_update_batches());
 
   // Update 6 goes through now that we have resolved the backlog.
   sent_update = TestK8sUpdateMsg(updates_[6]);
@@ -21,11 +21,13 @@
 #include <limits.h>
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <jwt/jwt.hpp>
 
@@ -56,6 +58,9 @@ px::StatusOr<std::string> GetHostname() {
 
 DEFINE_string(jwt_signing_key, gflags::StringFromEnv("PL_JWT_SIGNING_KEY", ""),
               "The JWT signing key for outgoing requests");
+DEFINE_string(network_cpus, gflags::StringFromEnv("PL_NETWORK_CPUS", ""),
+              "The CPUs that the agent's event loop (NATS and the metadata updates) runs on, in "
+              "cpulist format (e.g. '8-9'). All CPUs if empty.");
 
 namespace px {
 namespace vizier {
@@ -98,7 +103,8 @@ Manager::Manager(sole::uuid agent_id, std::string_view pod_name, std::string_vie
       relation_info_manager_(std::make_unique<RelationInfoManager>()),
       func_context_(this, CreateMDSStub(mds_url, grpc_channel_creds_),
                     CreateMDTPStub(mds_url, grpc_channel_creds_), table_store_,
-                    [](grpc::ClientContext* ctx) { AddServiceTokenToClientContext(ctx); }) {
+                    [](grpc::ClientContext* ctx) { AddServiceTokenToClientContext(ctx); },
+                    std::bind(&Manager::AgentMetrics, this)) {
   if (!has_nats_connection()) {
     LOG(WARNING) << "--nats_url is empty, skip connecting to NATS.";
   }
@@ -171,6 +177,9 @@ Status Manager::Init() {
 }
 
 Status Manager::Run() {
+  Status pin_status = SetCurrentThreadCPUs(FLAGS_network_cpus);
+  LOG_IF(WARNING, !pin_status.ok())
+      << absl::Substitute("Failed to pin the event loop thread: $0", pin_status.msg());
   running_ = true;
   dispatcher_->Run(px::event::Dispatcher::RunType::Block);
   running_ = false;
@@ -217,8 +226,8 @@ Status Manager::RegisterBackgroundHelpers() {
 
   // Add Heartbeat and execute query handlers.
   heartbeat_handler_ = std::make_shared<HeartbeatMessageHandler>(
-      dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), &info_,
-      agent_nats_connector_.get());
+      dispatcher_.get(), mds_manager_.get(), relation_info_manager_.get(), table_store_.get(),
+      &info_, agent_nats_connector_.get());
 
   auto heartbeat_nack_handler = std::make_shared<HeartbeatNackMessageHandler>(
       dispatcher_.get(), &info_, agent_nats_connector_.get(),
@@ -251,12 +260,30 @@ void Manager::NATSMessageHandler(Manager::VizierNATSConnector::MsgType msg) {
   // NATS returns data to us in an arbritrary thread. We need to handle it in the event
   // loop thread so we post to the event loop.
 
-  // This funny pointer stuff is required because we generate an std::function,
-  // that requires a copy of the lambda. The release allows us to recapture the value
-  // into another unique pointer.
-  messages::VizierMessage* m = msg.release();
-  dispatcher_->Post(
-      [m, this]() mutable { HandleMessage(std::unique_ptr<messages::VizierMessage>(m)); });
+  // The messages are queued instead of being captured by the posted callback, since the
+  // std::function requires a copyable lambda. The callback is only posted when the queue goes from
+  // empty to non-empty; it drains all the messages that arrived before it ran.
+  bool post = false;
+  {
+    absl::MutexLock lock(&incoming_msgs_lock_);
+    post = incoming_msgs_.empty();
+    incoming_msgs_.push_back(std::move(msg));
+  }
+  if (post) {
+    dispatcher_->Post([this]() { HandleIncomingMessages(); });
+  }
+}
+
+void Manager::HandleIncomingMessages() {
+  std::vector<std::unique_ptr<messages::VizierMessage>> msgs;
+  {
+    absl::MutexLock lock(&incoming_msgs_lock_);
+    msgs.swap(incoming_msgs_);
+  }
+  VLOG(1) << absl::Substitute("Manager::Run::GotMessages count=$0", msgs.size());
+  for (auto& msg : msgs) {
+    HandleMessage(std::move(msg));
+  }
 }
 
 void Manager::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
@@ -265,9 +292,9 @@ void Manager::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
   auto c = msg->msg_case();
   auto it = message_handlers_.find(c);
   if (it != message_handlers_.end()) {
+    // The handler takes ownership of the message, so it can't be logged on failure.
     ECHECK_OK(it->second->HandleMessage(std::move(msg)))
-        << "message handler failed... for type: " << c
-        << " ignoring. Message: " << msg->DebugString();
+        << "message handler failed... for type: " << c << " ignoring.";
     // Handler found.
   } else {
     LOG(ERROR) << "Unhandled message type: " << c << " Message: " << msg->DebugString();
@@ -327,6 +354,19 @@ Status Manager::PostReregisterHook(uint32_t asid) {
   return Status::OK();
 }
 
+std::map<std::string, int64_t> Manager::AgentMetrics() {
+  if (chan_cache_ == nullptr) {
+    return {};
+  }
+  auto stats = chan_cache_->stats();
+  return {
+      {"grpc_chan_cache_hits", stats.hits},
+      {"grpc_chan_cache_misses", stats.misses},
+      {"grpc_chan_cache_evictions", stats.evictions},
+      {"grpc_chan_cache_reconnects", stats.reconnects},
+  };
+}
+
 std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
     const std::string& remote_addr, const std::string& ssl_targetname) {
   auto chan = chan_cache_->GetChan(remote_addr);
@@ -20,10 +20,14 @@
 #include <grpcpp/grpcpp.h>
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
 
 #include "src/carnot/carnot.h"
 #include "src/common/base/base.h"
@@ -167,6 +171,8 @@ class Manager : public px::NotCopyable {
   std::unique_ptr<ResultSinkStub> ResultSinkStubGenerator(const std::string& remote_addr,
                                                           const std::string& ssl_targetname);
   void NATSMessageHandler(VizierNATSConnector::MsgType msg);
+  // The agent's internal counters, which the _DebugAgentMetrics UDTF exports.
+  std::map<std::string, int64_t> AgentMetrics();
   Status RegisterBackgroundHelpers();
   Status PostRegisterHook(uint32_t asid);
   Status ReregisterHook();
@@ -182,6 +188,14 @@ class Manager : public px::NotCopyable {
   // same message handler can be used for multiple different types of messages.
   absl::flat_hash_map<MsgCase, std::shared_ptr<MessageHandler>> message_handlers_;
   void HandleMessage(std::unique_ptr<messages::VizierMessage> msg);
+  void HandleIncomingMessages();
+
+  // Messages received on the NATS threads, waiting to be handled on the event loop. Only the
+  // message that makes the queue non-empty posts to the dispatcher, so a burst of messages (e.g.
+  // K8s updates during a rollout) is handled in a single event loop callback.
+  absl::Mutex incoming_msgs_lock_;
+  std::vector<std::unique_ptr<messages::VizierMessage>> incoming_msgs_
+      ABSL_GUARDED_BY(incoming_msgs_lock_);
 
   // The timer to manage metadata updates.
   px::event::TimerUPtr metadata_update_timer_;
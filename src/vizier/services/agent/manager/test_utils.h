@@ -78,8 +78,17 @@ class FakeAgentMetadataStateManager : public md::AgentMetadataStateManager {
     return Status::OK();
   }
 
+  Status AddK8sUpdates(std::vector<std::unique_ptr<md::ResourceUpdate>> updates) override {
+    for (auto& update : updates) {
+      updates_.push_back(std::move(update));
+    }
+    ++num_k8s_update_batches_;
+    return Status::OK();
+  }
+
   int32_t num_k8s_updates() const { return updates_.size(); }
   md::ResourceUpdate* k8s_update(int32_t i) const { return updates_[i].get(); }
+  int32_t num_k8s_update_batches() const { return num_k8s_update_batches_; }
 
   void SetServiceCIDR(CIDRBlock cidr) override { cidr_ = cidr; }
 
@@ -98,14 +107,18 @@ class FakeAgentMetadataStateManager : public md::AgentMetadataStateManager {
     return event;
   }
 
+  void NotifyPIDChanged(uint32_t pid) override { changed_pids_.push_back(pid); }
+
  private:
   md::AgentMetadataFilter* metadata_filter_ = nullptr;
   std::shared_ptr<const md::AgentMetadataState> metadata_state_;
   int32_t state_updated_count_ = 0;
   std::vector<std::unique_ptr<md::ResourceUpdate>> updates_;
+  int32_t num_k8s_update_batches_ = 0;
   CIDRBlock cidr_;
   std::vector<CIDRBlock> pod_cidr_;
   std::queue<std::unique_ptr<md::PIDStatusEvent>> pid_status_events_;
+  std::vector<uint32_t> changed_pids_;
 };
 
 }  // namespace agent
@@ -18,9 +18,54 @@
 
 #include "src/vizier/services/agent/pem/pem_manager.h"
 
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+#include "src/table_store/table/table_checkpoint.h"
 #include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_string(table_store_checkpoint_dir,
+              gflags::StringFromEnv("PL_TABLE_STORE_CHECKPOINT_DIR", ""),
+              "The directory (e.g. a hostPath volume) to checkpoint the table store to "
+              "periodically and on shutdown, and to restore it from on startup. Disabled if "
+              "empty.");
+DEFINE_int32(table_store_checkpoint_period_s,
+             gflags::Int32FromEnv("PL_TABLE_STORE_CHECKPOINT_PERIOD_S", 300),
+             "How often the table store is checkpointed, so that a crash loses at most this much "
+             "data. If 0, it is only checkpointed on shutdown.");
+DEFINE_int32(table_store_compaction_period_ms,
+             gflags::Int32FromEnv("PL_TABLE_STORE_COMPACTION_PERIOD_MS", 1000),
+             "How often the table store converts hot batches to arrow, rebalances its memory "
+             "budget and expires old data in the background. Disabled if 0.");
+DEFINE_int64(table_store_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_TABLE_STORE_MEMORY_BUDGET_BYTES", -1),
+             "The number of bytes that all the tables can hold together, split between the tables "
+             "by ingest rate. If -1, each table keeps its own size limit.");
+DEFINE_int64(table_store_max_retention_s,
+             gflags::Int64FromEnv("PL_TABLE_STORE_MAX_RETENTION_S", 0),
+             "The maximum age of the data in the table store, in seconds. Disabled if 0.");
+DEFINE_string(table_store_disk_tier_dir,
+              gflags::StringFromEnv("PL_TABLE_STORE_DISK_TIER_DIR", ""),
+              "The local directory to write the batches that tables expire to stay within their "
+              "size limits to, so that queries can read further back. Disabled if empty.");
+DEFINE_int64(table_store_disk_tier_bytes_per_table,
+             gflags::Int64FromEnv("PL_TABLE_STORE_DISK_TIER_BYTES_PER_TABLE",
+                                  4LL * 1024 * 1024 * 1024),
+             "The number of bytes of expired batches each table can keep on disk.");
+DEFINE_int32(table_store_ingest_threads, gflags::Int32FromEnv("PL_TABLE_STORE_INGEST_THREADS", 0),
+             "The number of threads that move Stirling's data into the table store, so that "
+             "Stirling doesn't wait on it. Batches are dropped when the threads fall behind, and "
+             "counted in the batches_dropped of _DebugTableInfo. If 0, Stirling writes to the "
+             "tables directly.");
+DEFINE_int64(table_store_ingest_queue_size,
+             gflags::Int64FromEnv("PL_TABLE_STORE_INGEST_QUEUE_SIZE", 4096),
+             "The number of record batches each ingest thread can have queued. Batches pushed "
+             "while the queue is full are dropped.");
+
+DECLARE_string(query_exec_cpus);
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -31,6 +76,30 @@ Status PEMManager::PostRegisterHookImpl() {
   stirling_->RegisterDataPushCallback(std::bind(&table_store::TableStore::AppendData, table_store(),
                                                 std::placeholders::_1, std::placeholders::_2,
                                                 std::placeholders::_3));
+  if (FLAGS_table_store_ingest_threads > 0) {
+    table_ingester_ = std::make_unique<table_store::TableIngester>(
+        FLAGS_table_store_ingest_threads, FLAGS_table_store_ingest_queue_size);
+  }
+  // Each tablet is resolved to its table once, so pushes skip the table store lookup.
+  stirling_->RegisterDataPushHandleResolver(
+      [store = table_store(), ingester = table_ingester_.get()](
+          uint32_t table_id,
+          const types::TabletID& tablet_id) -> StatusOr<stirling::DataPushHandle> {
+        PL_ASSIGN_OR_RETURN(table_store::Table * table,
+                            store->GetOrCreateTablet(table_id, tablet_id));
+        if (ingester != nullptr) {
+          // Dropped batches are counted by the ingester, they are not a push failure.
+          return stirling::DataPushHandle(
+              [table, ingester](std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+                ingester->Enqueue(table, std::move(record_batch));
+                return Status::OK();
+              });
+        }
+        return stirling::DataPushHandle(
+            [table](std::unique_ptr<types::ColumnWrapperRecordBatch> record_batch) {
+              return table->TransferRecordBatch(std::move(record_batch));
+            });
+      });
 
   // Enable use of USR1/USR2 for controlling Stirling debug.
   stirling_->RegisterUserDebugSignalHandlers();
@@ -38,9 +107,24 @@ Status PEMManager::PostRegisterHookImpl() {
   // Register the metadata callback for Stirling.
   stirling_->RegisterAgentMetadataCallback(
       std::bind(&px::md::AgentMetadataStateManager::CurrentAgentMetadataState, mds_manager()));
+  // Process starts and exits seen by Stirling tell the metadata which containers to re-read.
+  stirling_->RegisterPIDChangedCallback(
+      std::bind(&px::md::AgentMetadataStateManager::NotifyPIDChanged, mds_manager(),
+                std::placeholders::_1));
 
   PL_RETURN_IF_ERROR(InitSchemas());
+  if (table_ingester_ != nullptr) {
+    table_ingester_->Start(FLAGS_query_exec_cpus);
+  }
   PL_RETURN_IF_ERROR(stirling_->RunAsThread());
+  if (FLAGS_table_store_compaction_period_ms > 0) {
+    table_store()->StartBackgroundMaintenance(
+        std::chrono::milliseconds(FLAGS_table_store_compaction_period_ms), FLAGS_query_exec_cpus);
+  }
+  if (!FLAGS_table_store_checkpoint_dir.empty() && FLAGS_table_store_checkpoint_period_s > 0) {
+    checkpoint_thread_ = std::thread(&PEMManager::RunPeriodicCheckpoints, this,
+                                     std::chrono::seconds(FLAGS_table_store_checkpoint_period_s));
+  }
 
   auto execute_query_handler = std::make_shared<ExecuteQueryMessageHandler>(
       dispatcher(), info(), agent_nats_connector(), carnot());
@@ -56,10 +140,53 @@ Status PEMManager::PostRegisterHookImpl() {
 }
 
 Status PEMManager::StopImpl(std::chrono::milliseconds) {
+  {
+    absl::MutexLock lock(&checkpoint_lock_);
+    stop_checkpoints_ = true;
+  }
+  if (checkpoint_thread_.joinable()) {
+    checkpoint_thread_.join();
+  }
+
   stirling_->Stop();
+  // Stirling doesn't push anymore, so stopping the ingester ingests the last of its data.
+  if (table_ingester_ != nullptr) {
+    table_ingester_->Stop();
+    LOG(INFO) << absl::Substitute("Table store ingest: $0 record batches ingested, $1 dropped.",
+                                  table_ingester_->num_ingested(),
+                                  table_ingester_->num_dropped());
+  }
+  table_store()->StopBackgroundMaintenance();
+
+  // Stirling is stopped, so the tables don't change anymore while they are written out.
+  if (!FLAGS_table_store_checkpoint_dir.empty()) {
+    WriteCheckpoint();
+  }
   return Status::OK();
 }
 
+void PEMManager::WriteCheckpoint() {
+  Status s =
+      table_store::WriteTableStoreCheckpoint(table_store(), FLAGS_table_store_checkpoint_dir);
+  if (!s.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to checkpoint the table store: $0", s.msg());
+  }
+}
+
+void PEMManager::RunPeriodicCheckpoints(std::chrono::seconds period) {
+  while (true) {
+    {
+      absl::MutexLock lock(&checkpoint_lock_);
+      if (checkpoint_lock_.AwaitWithTimeout(absl::Condition(&stop_checkpoints_),
+                                            absl::FromChrono(period))) {
+        return;
+      }
+    }
+    // Each table file is replaced atomically, so a crash mid-way keeps its previous checkpoint.
+    WriteCheckpoint();
+  }
+}
+
 Status PEMManager::InitSchemas() {
   px::stirling::stirlingpb::Publish publish_pb;
   stirling_->GetPublishProto(&publish_pb);
@@ -73,10 +200,27 @@ Status PEMManager::InitSchemas() {
     } else {
       table_ptr = table_store::Table::Create(relation_info.relation);
     }
+    // Tables without a time column can't be scanned by time, so they don't get a disk tier.
+    if (!FLAGS_table_store_disk_tier_dir.empty() && table_ptr->FindTimeColumn() != -1) {
+      PL_RETURN_IF_ERROR(
+          table_ptr->EnableDiskTier(std::filesystem::path(FLAGS_table_store_disk_tier_dir) /
+                                        relation_info.name,
+                                    FLAGS_table_store_disk_tier_bytes_per_table));
+    }
 
     table_store()->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
     PL_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(relation_info));
   }
+  table_store()->SetMemoryBudget(FLAGS_table_store_memory_budget_bytes);
+  if (FLAGS_table_store_max_retention_s > 0) {
+    table_store()->SetMaxRetention(std::chrono::seconds(FLAGS_table_store_max_retention_s));
+  }
+
+  // Restore the data from before the last restart, before Stirling starts writing to the tables.
+  if (!FLAGS_table_store_checkpoint_dir.empty()) {
+    PL_RETURN_IF_ERROR(table_store::RestoreTableStoreCheckpoint(
+        FLAGS_table_store_checkpoint_dir, info()->asid, table_store()));
+  }
   return Status::OK();
 }
 
@@ -18,11 +18,16 @@
 
 #pragma once
 
+#include <absl/synchronization/mutex.h>
+
+#include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include "src/stirling/stirling.h"
+#include "src/table_store/table/table_ingester.h"
 #include "src/vizier/services/agent/manager/manager.h"
 #include "src/vizier/services/agent/pem/tracepoint_manager.h"
 
@@ -63,14 +68,24 @@ class PEMManager : public Manager {
 
  private:
   Status InitSchemas();
+  // Writes a checkpoint of the table store to --table_store_checkpoint_dir.
+  void WriteCheckpoint();
+  void RunPeriodicCheckpoints(std::chrono::seconds period);
   static services::shared::agent::AgentCapabilities Capabilities() {
     services::shared::agent::AgentCapabilities capabilities;
     capabilities.set_collects_data(true);
     return capabilities;
   }
 
+  // Moves the data that Stirling pushes into the table store off Stirling's threads. Declared
+  // before stirling_, so that it outlives Stirling's push handles.
+  std::unique_ptr<table_store::TableIngester> table_ingester_;
   std::unique_ptr<stirling::Stirling> stirling_;
   std::shared_ptr<TracepointManager> tracepoint_manager_;
+
+  absl::Mutex checkpoint_lock_;
+  bool stop_checkpoints_ ABSL_GUARDED_BY(checkpoint_lock_) = false;
+  std::thread checkpoint_thread_;
 };
 
 }  // namespace agent
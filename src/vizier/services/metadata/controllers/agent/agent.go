@@ -52,6 +52,7 @@ type Store interface {
 	GetASID() (uint32, error)
 	GetAgentIDFromPodName(podName string) (string, error)
 
+	GetAgentDataInfo(agentID uuid.UUID) (*messagespb.AgentDataInfo, error)
 	GetAgentsDataInfo() (map[uuid.UUID]*messagespb.AgentDataInfo, error)
 	UpdateAgentDataInfo(agentID uuid.UUID, dataInfo *messagespb.AgentDataInfo) error
 
@@ -351,6 +352,30 @@ func (m *ManagerImpl) updateAgentDataInfoWrapper(agentID uuid.UUID, agentDataInf
 	return nil
 }
 
+// fillAgentDataInfo fills in the parts of the data info that the agent left out of its update from
+// the data info stored for the agent. Agents only send their metadata info when it changes, and
+// their table info every few heartbeats.
+func (m *ManagerImpl) fillAgentDataInfo(agentID uuid.UUID, dataInfo *messagespb.AgentDataInfo) error {
+	if dataInfo.MetadataInfo != nil && len(dataInfo.TableInfo) > 0 {
+		return nil
+	}
+	prevDataInfo, err := m.agtStore.GetAgentDataInfo(agentID)
+	if err != nil {
+		log.WithError(err).Errorf("Failed to get agent data info for agent %s", agentID.String())
+		return err
+	}
+	if prevDataInfo == nil {
+		return nil
+	}
+	if dataInfo.MetadataInfo == nil {
+		dataInfo.MetadataInfo = prevDataInfo.MetadataInfo
+	}
+	if len(dataInfo.TableInfo) == 0 {
+		dataInfo.TableInfo = prevDataInfo.TableInfo
+	}
+	return nil
+}
+
 // ApplyAgentUpdate updates the metadata store with the information from the agent update.
 func (m *ManagerImpl) ApplyAgentUpdate(update *Update) error {
 	resp, err := m.agtStore.GetAgent(update.AgentID)
@@ -372,6 +397,10 @@ func (m *ManagerImpl) ApplyAgentUpdate(update *Update) error {
 		log.WithError(err).Error("Error when updating terminated processes")
 	}
 	if update.UpdateInfo.Data != nil {
+		err = m.fillAgentDataInfo(update.AgentID, update.UpdateInfo.Data)
+		if err != nil {
+			return err
+		}
 		err = m.updateAgentDataInfoWrapper(update.AgentID, update.UpdateInfo.Data)
 		if err != nil {
 			return err
@@ -423,6 +423,54 @@ func TestApplyUpdates(t *testing.T) {
 	assert.Equal(t, dataInfo, expectedDataInfo)
 }
 
+func TestApplyUpdatesFillsDataInfo(t *testing.T) {
+	ads, agtMgr, _, cleanup := setupManager(t)
+	defer cleanup()
+
+	u, err := uuid.FromString(testutils.ExistingAgentUUID)
+	if err != nil {
+		t.Fatal("Could not parse UUID from string.")
+	}
+
+	metadataInfo := &distributedpb.MetadataInfo{
+		MetadataFields: []metadatapb.MetadataType{
+			metadatapb.CONTAINER_ID,
+		},
+		Filter: &distributedpb.MetadataInfo_XXHash64BloomFilter{
+			XXHash64BloomFilter: &bloomfilterpb.XXHash64BloomFilter{
+				Data:      []byte("1234"),
+				NumHashes: 4,
+			},
+		},
+	}
+	tableInfo := []*distributedpb.TableInfo{
+		{
+			Table:     "a_table",
+			SizeBytes: 1024,
+		},
+	}
+
+	// The agent sends its metadata info and its table info in separate heartbeats.
+	err = agtMgr.ApplyAgentUpdate(&agent.Update{
+		UpdateInfo: &messagespb.AgentUpdateInfo{
+			Data: &messagespb.AgentDataInfo{MetadataInfo: metadataInfo},
+		},
+		AgentID: u,
+	})
+	require.NoError(t, err)
+	err = agtMgr.ApplyAgentUpdate(&agent.Update{
+		UpdateInfo: &messagespb.AgentUpdateInfo{
+			Data: &messagespb.AgentDataInfo{TableInfo: tableInfo},
+		},
+		AgentID: u,
+	})
+	require.NoError(t, err)
+
+	dataInfo, err := ads.GetAgentDataInfo(u)
+	require.NoError(t, err)
+	assert.Equal(t, &messagespb.AgentDataInfo{MetadataInfo: metadataInfo, TableInfo: tableInfo}, dataInfo)
+}
+
 func TestApplyUpdatesDeleted(t *testing.T) {
 	ads, agtMgr, _, cleanup := setupManager(t)
 	defer cleanup()
@@ -315,6 +315,17 @@ func colToVizierCol(col *schemapb.Column) (*vizierpb.Column, error) {
 				},
 			},
 		}, nil
+	case *schemapb.Column_ArrowData:
+		// The buffers are passed through as is, so that they are never decoded on the way.
+		return &vizierpb.Column{
+			ColData: &vizierpb.Column_ArrowData{
+				ArrowData: &vizierpb.ArrowColumn{
+					DataType: dataTypeToVizierDataType[c.ArrowData.DataType],
+					Values:   c.ArrowData.Values,
+					Offsets:  c.ArrowData.Offsets,
+				},
+			},
+		}, nil
 	default:
 		return nil, errors.New("Could not get column type")
 	}
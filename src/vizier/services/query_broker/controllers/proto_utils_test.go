@@ -177,6 +177,25 @@ var rowBatchPb = `
 	}
 `
 
+var arrowRowBatchPb = `
+	eow: true
+	eos: true
+	num_rows: 2
+	cols {
+		arrow_data {
+			data_type: INT64
+			values: "\001\000\000\000\000\000\000\000\002\000\000\000\000\000\000\000"
+		}
+	}
+	cols {
+		arrow_data {
+			data_type: STRING
+			values: "abcdefg"
+			offsets: "\000\000\000\000\004\000\000\000\007\000\000\000"
+		}
+	}
+`
+
 var agentPlanPb = `
 dag: {
 	nodes: {
@@ -381,6 +400,22 @@ func TestRowBatchToVizierRowBatch(t *testing.T) {
 	assert.Equal(t, expectedQd, qm)
 }
 
+func TestRowBatchToVizierRowBatch_ArrowColumns(t *testing.T) {
+	sv := new(schemapb.RowBatchData)
+	if err := proto.UnmarshalText(arrowRowBatchPb, sv); err != nil {
+		t.Fatalf("Cannot unmarshal proto %v", err)
+	}
+
+	expectedQd := new(vizierpb.RowBatchData)
+	if err := proto.UnmarshalText(arrowRowBatchPb, expectedQd); err != nil {
+		t.Fatalf("Cannot unmarshal proto %v", err)
+	}
+
+	qm, err := controllers.RowBatchToVizierRowBatch(sv, "")
+	require.NoError(t, err)
+	assert.Equal(t, expectedQd, qm)
+}
+
 func TestBuildExecuteScriptResponse_RowBatch(t *testing.T) {
 	receivedRB := new(schemapb.RowBatchData)
 	if err := proto.UnmarshalText(rowBatchPb, receivedRB); err != nil {
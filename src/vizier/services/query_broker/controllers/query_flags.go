@@ -25,6 +25,7 @@ import (
 	"strings"
 
 	"github.com/spf13/cast"
+	"github.com/spf13/viper"
 
 	"px.dev/pixie/src/carnot/planpb"
 )
@@ -38,6 +39,8 @@ var defaultQueryFlags = map[string]interface{}{
 	"explain":                   false,
 	"analyze":                   false,
 	"max_output_rows_per_table": 10000,
+	// 0 uses the query broker's --max_parallelism.
+	"max_parallelism": 0,
 }
 
 // QueryFlags represents a set of Pixie configuration flags.
@@ -122,9 +125,19 @@ func (f *QueryFlags) GetPlanOptions() *planpb.PlanOptions {
 		Explain:               f.GetBool("explain"),
 		Analyze:               f.GetBool("analyze"),
 		MaxOutputRowsPerTable: f.GetInt64("max_output_rows_per_table"),
+		MaxParallelism:        int32(f.getMaxParallelism()),
 	}
 }
 
+// getMaxParallelism gets the max number of threads a plan fragment may use, falling back to the
+// query broker's default when the query doesn't set it.
+func (f *QueryFlags) getMaxParallelism() int64 {
+	if val := f.GetInt64("max_parallelism"); val > 0 {
+		return val
+	}
+	return viper.GetInt64("max_parallelism")
+}
+
 // ParseQueryFlags takes a query string containing some config options and generates
 // a QueryFlags object that can be used to retrieve those options.
 func ParseQueryFlags(queryStr string) (*QueryFlags, error) {
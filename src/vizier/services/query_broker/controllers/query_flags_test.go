@@ -21,6 +21,7 @@ package controllers_test
 import (
 	"testing"
 
+	"github.com/spf13/viper"
 	"github.com/stretchr/testify/assert"
 	"github.com/stretchr/testify/require"
 
@@ -110,3 +111,16 @@ func TestParseQueryFlags_PlanOptions(t *testing.T) {
 	assert.Equal(t, options.Explain, false)
 	assert.Equal(t, options.Analyze, true)
 }
+
+func TestParseQueryFlags_MaxParallelism(t *testing.T) {
+	viper.Set("max_parallelism", 4)
+	defer viper.Set("max_parallelism", nil)
+
+	qf, err := controllers.ParseQueryFlags(validQueryWithFlag)
+	require.NoError(t, err)
+	assert.Equal(t, int32(4), qf.GetPlanOptions().MaxParallelism)
+
+	qf, err = controllers.ParseQueryFlags("#px:set max_parallelism=2\n")
+	require.NoError(t, err)
+	assert.Equal(t, int32(2), qf.GetPlanOptions().MaxParallelism)
+}
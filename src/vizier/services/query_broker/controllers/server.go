@@ -60,6 +60,8 @@ const (
 // Planner describes the interface for any planner.
 type Planner interface {
 	Plan(planState *distributedpb.LogicalPlannerState, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
+	SetDistributedState(state *distributedpb.DistributedState) (int64, error)
+	PlanWithStateVersion(stateVersion int64, planState *distributedpb.LogicalPlannerState, req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error)
 	CompileMutations(planState *distributedpb.LogicalPlannerState, request *plannerpb.CompileMutationsRequest) (*plannerpb.CompileMutationsResponse, error)
 	Free()
 }
@@ -93,6 +95,11 @@ type Server struct {
 	resultForwarder QueryResultForwarder
 
 	planner Planner
+	// Guards the distributed state kept by the planner: trackerStateVersion is the version of the
+	// tracker's state that the planner keeps, and plannerStateVersion is its version in the planner.
+	plannerStateMutex   sync.RWMutex
+	trackerStateVersion int64
+	plannerStateVersion int64
 }
 
 // NewServer creates GRPC handlers.
@@ -137,10 +144,39 @@ func (s *Server) Close() {
 	s.planner.Free()
 }
 
+// plan compiles the query. When the tracker versions the distributed state, the planner keeps it
+// across queries and is only handed a new one when it changes, instead of with every query.
+func (s *Server) plan(plannerState *distributedpb.LogicalPlannerState, stateVersion int64,
+	req *plannerpb.QueryRequest) (*distributedpb.LogicalPlannerResult, error) {
+	if stateVersion == 0 {
+		return s.planner.Plan(plannerState, req)
+	}
+
+	s.plannerStateMutex.Lock()
+	if stateVersion > s.trackerStateVersion {
+		plannerStateVersion, err := s.planner.SetDistributedState(plannerState.DistributedState)
+		if err != nil {
+			s.plannerStateMutex.Unlock()
+			return nil, err
+		}
+		s.trackerStateVersion = stateVersion
+		s.plannerStateVersion = plannerStateVersion
+	}
+	s.plannerStateMutex.Unlock()
+
+	s.plannerStateMutex.RLock()
+	defer s.plannerStateMutex.RUnlock()
+	// The planner already moved on to a newer state, so plan against the query's own.
+	if stateVersion != s.trackerStateVersion {
+		return s.planner.Plan(plannerState, req)
+	}
+	return s.planner.PlanWithStateVersion(s.plannerStateVersion, plannerState, req)
+}
+
 // runQuery executes a query and streams the results to the client.
 // returns a bool for whether the query timed out and an error.
 func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, queryID uuid.UUID,
-	planOpts *planpb.PlanOptions, distributedState *distributedpb.DistributedState,
+	planOpts *planpb.PlanOptions, distributedState *distributedpb.DistributedState, stateVersion int64,
 	resultStream chan *vizierpb.ExecuteScriptResponse, doneCh chan bool) error {
 	log.WithField("query_id", queryID).Infof("Running script")
 	start := time.Now()
@@ -167,7 +203,7 @@ func (s *Server) runQuery(ctx context.Context, req *plannerpb.QueryRequest, quer
 	}
 
 	// Compile the query plan.
-	plannerResultPB, err := s.planner.Plan(plannerState, req)
+	plannerResultPB, err := s.plan(plannerState, stateVersion, req)
 
 	if err != nil {
 		// send the compilation error and return nil.
@@ -308,8 +344,8 @@ func (s *Server) CheckHealth(ctx context.Context) error {
 		}
 	}()
 
-	distributedState := s.agentsTracker.GetAgentInfo().DistributedState()
-	err = s.runQuery(ctx, req, queryID, planOpts, &distributedState, resultStream, doneCh)
+	distributedState, stateVersion := s.agentsTracker.GetAgentInfo().DistributedStateWithVersion()
+	err = s.runQuery(ctx, req, queryID, planOpts, &distributedState, stateVersion, resultStream, doneCh)
 	if err != nil {
 		return fmt.Errorf("error running healthcheck query ID %s: %v", queryID.String(), err)
 	}
@@ -390,8 +426,9 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 	}
 
 	planOpts := flags.GetPlanOptions()
+	planOpts.ArrowResults = req.ArrowResults
 
-	distributedState := s.agentsTracker.GetAgentInfo().DistributedState()
+	distributedState, stateVersion := s.agentsTracker.GetAgentInfo().DistributedStateWithVersion()
 
 	if req.Mutation {
 		mutationExec := NewMutationExecutor(s.planner, s.mdtp, s.mdconf, &distributedState)
@@ -447,7 +484,7 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 	}()
 
 	log.Infof("Launching query: %s", queryID)
-	err = s.runQuery(ctx, convertedReq, queryID, planOpts, &distributedState, resultStream, doneCh)
+	err = s.runQuery(ctx, convertedReq, queryID, planOpts, &distributedState, stateVersion, resultStream, doneCh)
 	wg.Wait()
 
 	if err != nil {
@@ -267,6 +267,16 @@ func (f *fakeAgentsTracker) GetAgentInfo() tracker.AgentsInfo {
 	return f.agentsInfo
 }
 
+// versionedAgentsInfo is an AgentsInfo whose distributed state is at a fixed version.
+type versionedAgentsInfo struct {
+	tracker.AgentsInfo
+	version int64
+}
+
+func (a *versionedAgentsInfo) DistributedStateWithVersion() (distributedpb.DistributedState, int64) {
+	return a.DistributedState(), a.version
+}
+
 type fakeResultForwarder struct {
 	// Variables to pass in for ExecuteScript testing.
 	ClientResultsToSend []*vizierpb.ExecuteScriptResponse
@@ -400,6 +410,88 @@ func TestCheckHealth_Success(t *testing.T) {
 	require.NoError(t, err)
 }
 
+func TestCheckHealth_KeptDistributedState(t *testing.T) {
+	// Start NATS.
+	nc, cleanup := testingutils.MustStartTestNATS(t)
+	defer cleanup()
+
+	// Set up mocks.
+	ctrl := gomock.NewController(t)
+	defer ctrl.Finish()
+
+	plannerStatePB := new(distributedpb.LogicalPlannerState)
+	if err := proto.UnmarshalText(singleAgentDistributedState, plannerStatePB); err != nil {
+		t.Fatal("Cannot Unmarshal protobuf.")
+	}
+	agentsInfo := &versionedAgentsInfo{
+		AgentsInfo: tracker.NewTestAgentsInfo(plannerStatePB.DistributedState),
+		version:    3,
+	}
+	at := fakeAgentsTracker{
+		agentsInfo: agentsInfo,
+	}
+
+	// Set up server.
+	env, err := querybrokerenv.New("qb_address", "qb_hostname", "test")
+	if err != nil {
+		t.Fatal("Failed to create api environment.")
+	}
+
+	queryID := uuid.Must(uuid.NewV4())
+	fakeResult := &vizierpb.ExecuteScriptResponse{
+		QueryID: queryID.String(),
+		Result: &vizierpb.ExecuteScriptResponse_Data{
+			Data: &vizierpb.QueryData{
+				Batch: &vizierpb.RowBatchData{
+					TableID: "health_check_unused",
+					Cols: []*vizierpb.Column{
+						{
+							ColData: &vizierpb.Column_StringData{
+								StringData: &vizierpb.StringColumn{
+									Data: []string{
+										"foo",
+									},
+								},
+							},
+						},
+					},
+					NumRows: 1,
+					Eow:     true,
+					Eos:     true,
+				},
+			},
+		},
+	}
+
+	rf := &fakeResultForwarder{
+		ClientResultsToSend: []*vizierpb.ExecuteScriptResponse{
+			fakeResult,
+		},
+	}
+
+	// Not the actual health check query, but that's okay for the test since the planner and
+	// query execution are mocked out.
+	plannerResultPB := new(distributedpb.LogicalPlannerResult)
+	if err := proto.UnmarshalText(expectedPlannerResult, plannerResultPB); err != nil {
+		t.Fatal("Cannot Unmarshal protobuf.")
+	}
+
+	planner := mock_controllers.NewMockPlanner(ctrl)
+	// The planner is handed the versioned state once, and plans against the state it keeps.
+	planner.EXPECT().
+		SetDistributedState(plannerStatePB.DistributedState).
+		Return(int64(1), nil)
+	planner.EXPECT().
+		PlanWithStateVersion(int64(1), plannerStatePB, gomock.Any()).
+		Return(plannerResultPB, nil)
+
+	s, err := controllers.NewServerWithForwarderAndPlanner(env, &at, rf, nil, nil, nc, planner)
+	require.NoError(t, err)
+	err = s.CheckHealth(context.Background())
+	// Should pass.
+	require.NoError(t, err)
+}
+
 func TestCheckHealth_CompilationError(t *testing.T) {
 	// Start NATS.
 	nc, cleanup := testingutils.MustStartTestNATS(t)
@@ -56,6 +56,8 @@ func init() {
 	pflag.String("mds_service", "vizier-metadata", "The metadata service name")
 	pflag.String("mds_port", "50400", "The querybroker service port")
 	pflag.String("pod_namespace", "pl", "The namespace this pod runs in.")
+	pflag.Int("max_parallelism", 4, "The default max number of threads a query may use to execute a pipeline on an agent.")
+	pflag.Bool("compress_kelvin_row_batches", true, "Whether agents compress the row batches they send to Kelvins.")
 }
 
 // NewVizierServiceClient creates a new vz RPC client stub.
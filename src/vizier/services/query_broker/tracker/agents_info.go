@@ -41,12 +41,15 @@ type AgentsInfo interface {
 	ClearPendingState()
 	UpdateAgentsInfo(update *metadatapb.AgentUpdatesResponse) error
 	DistributedState() distributedpb.DistributedState
+	DistributedStateWithVersion() (distributedpb.DistributedState, int64)
 }
 
 // AgentsInfoImpl implements AgentsInfo to track information about the distributed state of the system.
 type AgentsInfoImpl struct {
 	ds distributedpb.DistributedState
-	// Controls access to ds.
+	// Incremented whenever ds is replaced. 0 while ds is the initial state.
+	dsVersion int64
+	// Controls access to ds and dsVersion.
 	dsMutex sync.Mutex
 
 	pendingDs *distributedpb.DistributedState
@@ -120,11 +123,13 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 
 			if agent.Info.Capabilities == nil || agent.Info.Capabilities.CollectsData {
 				var metadataInfo *distributedpb.MetadataInfo
+				var tableInfo []*distributedpb.TableInfo
 				if carnotInfo, present := carnotInfoMap[agentUUID]; present {
 					metadataInfo = carnotInfo.MetadataInfo
+					tableInfo = carnotInfo.TableInfo
 				}
 				// this is a PEM
-				carnotInfoMap[agentUUID] = makeAgentCarnotInfo(agentUUID, agent.ASID, metadataInfo)
+				carnotInfoMap[agentUUID] = makeAgentCarnotInfo(agentUUID, agent.ASID, metadataInfo, tableInfo)
 			} else {
 				// this is a Kelvin
 				kelvinGRPCAddress := agent.Info.IPAddress
@@ -146,6 +151,9 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 			if dataInfo.MetadataInfo != nil {
 				carnotInfo.MetadataInfo = dataInfo.MetadataInfo
 			}
+			if len(dataInfo.TableInfo) > 0 {
+				carnotInfo.TableInfo = dataInfo.TableInfo
+			}
 		}
 		// case 3: agent deleted
 		if agentUpdate.GetDeleted() {
@@ -169,6 +177,7 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 	if update.EndOfVersion {
 		a.dsMutex.Lock()
 		a.ds = *(a.pendingDs)
+		a.dsVersion++
 		a.dsMutex.Unlock()
 	}
 
@@ -184,7 +193,15 @@ func (a *AgentsInfoImpl) DistributedState() distributedpb.DistributedState {
 	return a.ds
 }
 
-func makeAgentCarnotInfo(agentID uuid.UUID, asid uint32, agentMetadata *distributedpb.MetadataInfo) *distributedpb.CarnotInfo {
+// DistributedStateWithVersion returns the current distributed state, and its version. The version
+// changes whenever the state does, and is 0 for a state that isn't versioned.
+func (a *AgentsInfoImpl) DistributedStateWithVersion() (distributedpb.DistributedState, int64) {
+	a.dsMutex.Lock()
+	defer a.dsMutex.Unlock()
+	return a.ds, a.dsVersion
+}
+
+func makeAgentCarnotInfo(agentID uuid.UUID, asid uint32, agentMetadata *distributedpb.MetadataInfo, tableInfo []*distributedpb.TableInfo) *distributedpb.CarnotInfo {
 	return &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   agentID.String(),
 		AgentID:              utils.ProtoFromUUID(agentID),
@@ -194,6 +211,7 @@ func makeAgentCarnotInfo(agentID uuid.UUID, asid uint32, agentMetadata *distribu
 		ProcessesData:        true,
 		AcceptsRemoteSources: false,
 		MetadataInfo:         agentMetadata,
+		TableInfo:            tableInfo,
 	}
 }
 
@@ -207,6 +225,10 @@ func makeKelvinCarnotInfo(agentID uuid.UUID, grpcAddress string, asid uint32) *d
 		HasDataStore:         false,
 		ProcessesData:        true,
 		AcceptsRemoteSources: true,
+		// Kelvins run the same Carnot version as the query broker, so they decode arrow row batches.
+		AcceptsArrowRowBatches: true,
+		// Compression trades CPU on the agents for less network traffic to the Kelvins.
+		AcceptsCompressedRowBatches: viper.GetBool("compress_kelvin_row_batches"),
 		// When we support persistent storage, Kelvins will also have MetadataInfo.
 		MetadataInfo:  nil,
 		SSLTargetName: fmt.Sprintf(KelvinSSLTargetOverride, viper.GetString("pod_namespace")),
@@ -154,6 +154,12 @@ func makeTestAgentDataInfo() []*messagespb.AgentDataInfo {
 					},
 				},
 			},
+			TableInfo: []*distributedpb.TableInfo{
+				{
+					Table:     "table1",
+					SizeBytes: 1024,
+				},
+			},
 		},
 		{
 			MetadataInfo: &distributedpb.MetadataInfo{
@@ -176,6 +182,7 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	// This test tries out various agent state updates together and in a row to make sure
 	// that they all interact with each other properly.
 	viper.Set("pod_namespace", "pl")
+	viper.Set("compress_kelvin_row_batches", true)
 	testSchema := makeTestSchema(t)
 	uuidpbs := makeTestAgentIDs(t)
 	var uuids []uuid.UUID
@@ -226,6 +233,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	// Updates shouldn't have been propagated yet until the end of the version.
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().SchemaInfo))
 	assert.Equal(t, 0, len(agentsInfo.DistributedState().CarnotInfo))
+	_, version := agentsInfo.DistributedStateWithVersion()
+	assert.Equal(t, int64(0), version)
 
 	err = agentsInfo.UpdateAgentsInfo(&metadatapb.AgentUpdatesResponse{
 		AgentUpdates:        updates1,
@@ -235,6 +244,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	})
 	require.NoError(t, err)
 	assert.Equal(t, testSchema, agentsInfo.DistributedState().SchemaInfo)
+	_, version = agentsInfo.DistributedStateWithVersion()
+	assert.Equal(t, int64(1), version)
 
 	expectedPEM1Info := &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   "11285cdd-1de9-4ab1-ae6a-0ba08c8c676c",
@@ -246,18 +257,21 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 		AcceptsRemoteSources: false,
 		ASID:                 123,
 		MetadataInfo:         agentDataInfos[0].MetadataInfo,
+		TableInfo:            agentDataInfos[0].TableInfo,
 	}
 
 	expectedKelvinInfo := &distributedpb.CarnotInfo{
-		QueryBrokerAddress:   "21285cdd-1de9-4ab1-ae6a-0ba08c8c676c",
-		AgentID:              uuidpbs[1],
-		HasGRPCServer:        true,
-		GRPCAddress:          "127.0.1.3",
-		HasDataStore:         false,
-		ProcessesData:        true,
-		AcceptsRemoteSources: true,
-		ASID:                 456,
-		SSLTargetName:        "kelvin.pl.svc",
+		QueryBrokerAddress:          "21285cdd-1de9-4ab1-ae6a-0ba08c8c676c",
+		AgentID:                     uuidpbs[1],
+		HasGRPCServer:               true,
+		GRPCAddress:                 "127.0.1.3",
+		HasDataStore:                false,
+		ProcessesData:               true,
+		AcceptsRemoteSources:        true,
+		AcceptsArrowRowBatches:      true,
+		AcceptsCompressedRowBatches: true,
+		ASID:                        456,
+		SSLTargetName:               "kelvin.pl.svc",
 	}
 
 	agentsMap := make(map[uuid.UUID]*distributedpb.CarnotInfo)
@@ -279,6 +293,7 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 		Info:            agents[0].Info,
 		ASID:            agents[0].ASID,
 	}
+	// The second data info has no table info, so agent 1 keeps the table info of the first.
 	expectedPEM1Info.MetadataInfo = agentDataInfos[1].MetadataInfo
 
 	expectedPEM2Info := &distributedpb.CarnotInfo{
@@ -333,6 +348,8 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 
 	// Schema should be unchanged.
 	assert.Equal(t, testSchema, agentsInfo.DistributedState().SchemaInfo)
+	_, version = agentsInfo.DistributedStateWithVersion()
+	assert.Equal(t, int64(2), version)
 
 	assert.Equal(t, 2, len(agentsMap))
 	// Agent 1 should be updated.
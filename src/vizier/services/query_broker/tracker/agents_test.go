@@ -45,6 +45,11 @@ func (a *fakeAgentsInfo) DistributedState() distributedpb.DistributedState {
 	return distributedpb.DistributedState{}
 }
 
+// DistributedStateWithVersion implementation for fake agents info.
+func (a *fakeAgentsInfo) DistributedStateWithVersion() (distributedpb.DistributedState, int64) {
+	return distributedpb.DistributedState{}, 0
+}
+
 func (a *fakeAgentsInfo) UpdateAgentsInfo(update *metadatapb.AgentUpdatesResponse) error {
 	if len(update.AgentUpdates) > 0 || len(update.AgentSchemas) > 0 {
 		a.wg.Done()